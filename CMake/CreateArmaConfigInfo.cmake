@@ -1,6 +1,6 @@
 # Using the CMake tools to create the file arma_config.hpp, which contains
 # information on the Armadillo configuration when mlpack was compiled.  This
-# assumes ${ARMADILLO_INCLUDE_DIR} is set.  In addition, we must be careful to
+# assumes ${ARMADILLO_INCLUDE_DIR} is set, and uses ${MEMORY_ACCOUNTING}.  In addition, we must be careful to
 # avoid overwriting arma_config.hpp with the exact same information, because
 # this may trigger a new complete rebuild, which is undesired.
 if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/src/mlpack/core/util/arma_config.hpp")
@@ -47,6 +47,15 @@ else()
   set(ARMA_64BIT_WORD_DEFINE "#define MLPACK_ARMA_64BIT_WORD")
 endif()
 
+# With memory accounting, Armadillo allocates through mlpack
+# (ARMA_ALIEN_MEM_ALLOC_FUNCTION, in arma_extend.hpp), so every program which
+# includes mlpack must see the same setting.
+if(MEMORY_ACCOUNTING)
+  set(MEMORY_ACCOUNTING_DEFINE "#define MLPACK_MEMORY_ACCOUNTING")
+else()
+  set(MEMORY_ACCOUNTING_DEFINE "")
+endif()
+
 set(NEW_FILE_CONTENTS
 "/**
  * @file arma_config.hpp
@@ -66,6 +75,7 @@ set(NEW_FILE_CONTENTS
 #define MLPACK_CORE_UTIL_ARMA_CONFIG_HPP
 
 ${ARMA_64BIT_WORD_DEFINE}
+${MEMORY_ACCOUNTING_DEFINE}
 
 #endif
 ")
@@ -0,0 +1,73 @@
+/**
+ * @file ann_benchmarks.cpp
+ *
+ * Benchmarks of feedforward neural network training, for every dataset of the
+ * configuration.
+ */
+#include "benchmark.hpp"
+#include "datasets.hpp"
+
+#include <mlpack/methods/ann/activation_functions/logistic_function.hpp>
+#include <mlpack/methods/ann/init_rules/random_init.hpp>
+#include <mlpack/methods/ann/layer/bias_layer.hpp>
+#include <mlpack/methods/ann/layer/linear_layer.hpp>
+#include <mlpack/methods/ann/layer/base_layer.hpp>
+#include <mlpack/methods/ann/layer/binary_classification_layer.hpp>
+#include <mlpack/methods/ann/ffn.hpp>
+#include <mlpack/methods/ann/performance_functions/mse_function.hpp>
+#include <mlpack/core/optimizers/rmsprop/rmsprop.hpp>
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::ann;
+using namespace mlpack::optimization;
+
+/**
+ * Train a network with one hidden layer of 64 logistic units for 5 epochs of
+ * RMSprop, to predict the cluster of each point (one-hot encoded, with 10
+ * clusters; the labels are all 0 for datasets without clusters).
+ */
+MLPACK_BENCHMARK(ann)
+{
+  const size_t hiddenSize = 64;
+  const size_t classes = 10;
+  const size_t epochs = 5;
+
+  const std::vector<BenchmarkDataset> datasets = Datasets(config);
+  for (size_t i = 0; i < datasets.size(); ++i)
+  {
+    const std::string name = "ann/ffn/" + CaseName({ datasets[i].Name(config),
+        Param("hidden", hiddenSize), Param("epochs", epochs) });
+    if (!runner.Enabled(name))
+      continue;
+
+    arma::Row<size_t> labels;
+    arma::mat dataset = datasets[i].Generate(config, labels);
+    arma::mat responses = arma::zeros<arma::mat>(classes, dataset.n_cols);
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+      responses(labels[j] % classes, j) = 1.0;
+
+    runner.Run(name, epochs * dataset.n_cols, [&]()
+    {
+      // Reseed, so that every run starts from the same weights.
+      math::RandomSeed(config.seed);
+
+      LinearLayer<> inputLayer(dataset.n_rows, hiddenSize);
+      BiasLayer<> inputBiasLayer(hiddenSize);
+      BaseLayer<LogisticFunction> inputBaseLayer;
+      LinearLayer<> hiddenLayer(hiddenSize, classes);
+      BiasLayer<> hiddenBiasLayer(classes);
+      BaseLayer<LogisticFunction> outputLayer;
+      BinaryClassificationLayer classOutputLayer;
+
+      auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+          hiddenLayer, hiddenBiasLayer, outputLayer);
+      FFN<decltype(modules), decltype(classOutputLayer), RandomInitialization,
+          MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+      RMSprop<decltype(net)> optimizer(net, 0.01, 0.88, 1e-8,
+          epochs * dataset.n_cols, 0.0);
+      net.Train(dataset, responses, optimizer);
+    });
+  }
+}
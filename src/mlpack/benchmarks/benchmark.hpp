@@ -0,0 +1,314 @@
+/**
+ * @file benchmark.hpp
+ *
+ * The benchmark framework of mlpack_benchmarks: a registry of benchmarks, the
+ * configuration of their parameter grids, and BenchmarkRunner, which times
+ * each benchmark case with warmup runs and repetitions and writes the results
+ * as CSV or JSON.
+ */
+#ifndef MLPACK_BENCHMARKS_BENCHMARK_HPP
+#define MLPACK_BENCHMARKS_BENCHMARK_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/extension.hpp>
+#include <mlpack/core/util/version.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace benchmark /** Benchmarks of mlpack methods. */ {
+
+/**
+ * The parameter grid of the benchmarks, and the datasets to run them on.  Each
+ * benchmark runs every combination of the lists it uses.
+ */
+struct BenchmarkConfig
+{
+  //! Numbers of points of the synthetic datasets.
+  std::vector<size_t> sizes;
+  //! Dimensionalities of the synthetic datasets.
+  std::vector<size_t> dimensions;
+  //! Leaf sizes of the trees.
+  std::vector<size_t> leafSizes;
+  //! Tree types ("kd", "ball", "cover", "r", "r-star", "x", "vp").
+  std::vector<std::string> trees;
+  //! Kinds of synthetic datasets ("uniform", "clusters", "manifold").
+  std::vector<std::string> datasets;
+  //! A real dataset to run on as well (empty if none was given), with its name.
+  arma::mat realData;
+  std::string realName;
+  //! The random seed of the synthetic datasets.
+  size_t seed;
+};
+
+/**
+ * The timings of one benchmark case.  Times are in seconds.
+ */
+struct BenchmarkResult
+{
+  //! The name of the case, such as
+  //! "knn/search/kd/clusters/d=3/n=10000/leaf=20".
+  std::string name;
+  //! The number of items (points, queries, ...) processed by each run.
+  size_t items;
+  //! The number of timed runs.
+  size_t repetitions;
+  //! The fastest run.
+  double min;
+  //! The median run.
+  double median;
+  //! The mean of the runs.
+  double mean;
+  //! The standard deviation of the runs.
+  double stddev;
+};
+
+/**
+ * BenchmarkRunner times benchmark cases.  Each case is run a number of times
+ * without timing (warmup, so that caches and lazily-allocated memory are warm),
+ * then timed a number of times; the minimum, median, mean and standard
+ * deviation of the timed runs are kept.  Cases whose names don't contain any of
+ * the filter strings are skipped; benchmarks should check Enabled() before
+ * preparing a case, so that skipped cases cost nothing.
+ *
+ * In list mode, no case is run: Enabled() records the names of the cases which
+ * pass the filter and returns false, so that benchmarks skip every case.
+ */
+class BenchmarkRunner
+{
+ public:
+  /**
+   * Create the runner.
+   *
+   * @param filter Comma-separated substrings of the names of the cases to run
+   *     (all cases are run if it is empty).
+   * @param warmup Number of untimed runs of each case.
+   * @param repetitions Number of timed runs of each case.
+   * @param list If true, only record the names of the cases (see Listed()).
+   */
+  BenchmarkRunner(const std::string& filter,
+                  const size_t warmup,
+                  const size_t repetitions,
+                  const bool list = false) :
+      warmup(warmup),
+      repetitions(std::max(repetitions, (size_t) 1)),
+      list(list)
+  {
+    std::istringstream stream(filter);
+    std::string pattern;
+    while (std::getline(stream, pattern, ','))
+      if (!pattern.empty())
+        patterns.push_back(pattern);
+  }
+
+  //! Return whether the case with the given name is run.
+  bool Enabled(const std::string& name)
+  {
+    bool matches = patterns.empty();
+    for (size_t i = 0; i < patterns.size() && !matches; ++i)
+      matches = (name.find(patterns[i]) != std::string::npos);
+
+    if (list)
+    {
+      if (matches && std::find(listed.begin(), listed.end(), name) ==
+          listed.end())
+        listed.push_back(name);
+      return false;
+    }
+
+    return matches;
+  }
+
+  /**
+   * Time the given case, if it is enabled.
+   *
+   * @param name Name of the case.
+   * @param items Number of items processed by each run (for throughput).
+   * @param function Function running the case once.
+   */
+  template<typename FunctionType>
+  void Run(const std::string& name, const size_t items, FunctionType function)
+  {
+    if (!Enabled(name))
+      return;
+
+    for (size_t i = 0; i < warmup; ++i)
+      function();
+
+    std::vector<double> times(repetitions);
+    for (size_t i = 0; i < repetitions; ++i)
+    {
+      const std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      function();
+      times[i] = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.items = items;
+    result.repetitions = repetitions;
+    std::sort(times.begin(), times.end());
+    result.min = times[0];
+    result.median = (repetitions % 2 == 1) ? times[repetitions / 2] :
+        (times[repetitions / 2 - 1] + times[repetitions / 2]) / 2;
+    result.mean = 0.0;
+    for (size_t i = 0; i < repetitions; ++i)
+      result.mean += times[i] / repetitions;
+    result.stddev = 0.0;
+    for (size_t i = 0; i < repetitions; ++i)
+      result.stddev += std::pow(times[i] - result.mean, 2.0) / repetitions;
+    result.stddev = std::sqrt(result.stddev);
+    results.push_back(result);
+
+    Log::Info << name << ": median " << result.median << "s, min "
+        << result.min << "s";
+    if (items > 0 && result.median > 0.0)
+      Log::Info << ", " << (items / result.median) << " items/s";
+    Log::Info << "." << std::endl;
+  }
+
+  //! Get the results of the cases run so far.
+  const std::vector<BenchmarkResult>& Results() const { return results; }
+  //! Get the names of the cases recorded in list mode.
+  const std::vector<std::string>& Listed() const { return listed; }
+
+  /**
+   * Save the results to the given file, as JSON (.json) or CSV (any other
+   * extension).  A std::runtime_error is thrown if the file can't be written.
+   *
+   * @param filename Name of the file to write.
+   */
+  void Save(const std::string& filename) const
+  {
+    std::ofstream stream(filename.c_str());
+    if (!stream.is_open())
+      throw std::runtime_error("cannot open '" + filename + "' for writing");
+
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+#else
+    const int threads = 1;
+#endif
+
+    stream.precision(9);
+    if (data::Extension(filename) == "json")
+    {
+      stream << "{\n  \"version\": \"" << util::GetVersion() << "\",\n"
+          << "  \"threads\": " << threads << ",\n  \"benchmarks\": [";
+      for (size_t i = 0; i < results.size(); ++i)
+      {
+        const BenchmarkResult& r = results[i];
+        stream << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << r.name
+            << "\", \"items\": " << r.items << ", \"repetitions\": "
+            << r.repetitions << ", \"min\": " << r.min << ", \"median\": "
+            << r.median << ", \"mean\": " << r.mean << ", \"stddev\": "
+            << r.stddev << " }";
+      }
+      stream << (results.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    }
+    else
+    {
+      stream << "name,items,repetitions,min,median,mean,stddev,threads\n";
+      for (size_t i = 0; i < results.size(); ++i)
+      {
+        const BenchmarkResult& r = results[i];
+        stream << r.name << "," << r.items << "," << r.repetitions << ","
+            << r.min << "," << r.median << "," << r.mean << "," << r.stddev
+            << "," << threads << "\n";
+      }
+    }
+
+    if (!stream.good())
+      throw std::runtime_error("error writing to '" + filename + "'");
+  }
+
+ private:
+  //! The substrings of the names of the cases to run.
+  std::vector<std::string> patterns;
+  //! The number of untimed runs of each case.
+  size_t warmup;
+  //! The number of timed runs of each case.
+  size_t repetitions;
+  //! Whether only the names of the cases are recorded.
+  bool list;
+  //! The names of the cases recorded in list mode.
+  std::vector<std::string> listed;
+  //! The results of the cases run so far.
+  std::vector<BenchmarkResult> results;
+};
+
+//! The type of a benchmark, which runs its cases with the given runner.
+typedef void (*BenchmarkFunction)(const BenchmarkConfig&, BenchmarkRunner&);
+
+//! Get every registered benchmark, with its name.
+inline std::vector<std::pair<std::string, BenchmarkFunction>>& Benchmarks()
+{
+  static std::vector<std::pair<std::string, BenchmarkFunction>> benchmarks;
+  return benchmarks;
+}
+
+//! Registers a benchmark when constructed; see MLPACK_BENCHMARK().
+struct BenchmarkRegistrar
+{
+  BenchmarkRegistrar(const char* name, BenchmarkFunction function)
+  {
+    Benchmarks().push_back(std::make_pair(std::string(name), function));
+  }
+};
+
+/**
+ * Join the given parts of the name of a benchmark case with slashes.
+ */
+inline std::string CaseName(const std::vector<std::string>& parts)
+{
+  std::string name;
+  for (size_t i = 0; i < parts.size(); ++i)
+    name += (i == 0 ? "" : "/") + parts[i];
+  return name;
+}
+
+//! Return "key=value", for the names of benchmark cases.
+template<typename T>
+std::string Param(const std::string& key, const T& value)
+{
+  std::ostringstream oss;
+  oss << key << "=" << value;
+  return oss.str();
+}
+
+} // namespace benchmark
+} // namespace mlpack
+
+/**
+ * Define and register a benchmark, which runs its cases with the given
+ * BenchmarkRunner ('runner') according to the given BenchmarkConfig
+ * ('config'):
+ *
+ * @code
+ * MLPACK_BENCHMARK(knn)
+ * {
+ *   for (...)
+ *     runner.Run(name, points, [&]() { ... });
+ * }
+ * @endcode
+ */
+#define MLPACK_BENCHMARK(NAME) \
+    static void NAME##Benchmark( \
+        const mlpack::benchmark::BenchmarkConfig& config, \
+        mlpack::benchmark::BenchmarkRunner& runner); \
+    static mlpack::benchmark::BenchmarkRegistrar NAME##Registrar(#NAME, \
+        NAME##Benchmark); \
+    static void NAME##Benchmark( \
+        const mlpack::benchmark::BenchmarkConfig& config, \
+        mlpack::benchmark::BenchmarkRunner& runner)
+
+#endif
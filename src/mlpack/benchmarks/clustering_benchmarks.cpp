@@ -0,0 +1,112 @@
+/**
+ * @file clustering_benchmarks.cpp
+ *
+ * Benchmarks of the k-means Lloyd step implementations and of GMM training with
+ * EM, for every dataset of the configuration.
+ */
+#include "benchmark.hpp"
+#include "datasets.hpp"
+
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/kmeans/elkan_kmeans.hpp>
+#include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
+#include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
+#include <mlpack/methods/kmeans/yinyang_kmeans.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::kmeans;
+using namespace mlpack::gmm;
+
+namespace {
+
+/**
+ * Time 10 iterations of k-means with the given Lloyd step, from the given
+ * initial centroids, so that every implementation does the same work.
+ */
+template<template<class, class> class LloydStepType>
+void RunKMeans(BenchmarkRunner& runner,
+               const std::string& name,
+               const arma::mat& dataset,
+               const arma::mat& initialCentroids)
+{
+  KMeans<metric::EuclideanDistance, SampleInitialization,
+      MaxVarianceNewCluster, LloydStepType> kmeans(10);
+  arma::mat centroids;
+  runner.Run(name, dataset.n_cols, [&]()
+  {
+    centroids = initialCentroids;
+    kmeans.Cluster(dataset, initialCentroids.n_cols, centroids, true);
+  });
+}
+
+} // anonymous namespace
+
+/**
+ * Run 10 iterations of k-means with 10 clusters with each Lloyd step
+ * implementation.
+ */
+MLPACK_BENCHMARK(kmeans)
+{
+  const size_t clusters = 10;
+  const std::vector<BenchmarkDataset> datasets = Datasets(config);
+  for (size_t i = 0; i < datasets.size(); ++i)
+  {
+    const std::string suffix = "/" + CaseName({ datasets[i].Name(config),
+        Param("k", clusters) });
+    const char* variants[] = { "naive", "elkan", "hamerly", "yinyang",
+        "pelleg-moore", "dualtree", "dualtree-covertree" };
+    bool enabled = false;
+    for (size_t v = 0; v < 7; ++v)
+      enabled |= runner.Enabled("kmeans/" + std::string(variants[v]) + suffix);
+    if (!enabled || datasets[i].points < clusters)
+      continue;
+
+    const arma::mat dataset = datasets[i].Generate(config);
+    arma::mat initialCentroids;
+    SampleInitialization().Cluster(dataset, clusters, initialCentroids);
+
+    RunKMeans<NaiveKMeans>(runner, "kmeans/naive" + suffix, dataset,
+        initialCentroids);
+    RunKMeans<ElkanKMeans>(runner, "kmeans/elkan" + suffix, dataset,
+        initialCentroids);
+    RunKMeans<HamerlyKMeans>(runner, "kmeans/hamerly" + suffix, dataset,
+        initialCentroids);
+    RunKMeans<YinyangKMeans>(runner, "kmeans/yinyang" + suffix, dataset,
+        initialCentroids);
+    RunKMeans<PellegMooreKMeans>(runner, "kmeans/pelleg-moore" + suffix,
+        dataset, initialCentroids);
+    RunKMeans<DefaultDualTreeKMeans>(runner, "kmeans/dualtree" + suffix,
+        dataset, initialCentroids);
+    RunKMeans<CoverTreeDualTreeKMeans>(runner,
+        "kmeans/dualtree-covertree" + suffix, dataset, initialCentroids);
+  }
+}
+
+/**
+ * Train a GMM with 5 Gaussians with 20 iterations of EM (after the k-means
+ * initialization).
+ */
+MLPACK_BENCHMARK(gmm)
+{
+  const size_t gaussians = 5;
+  const std::vector<BenchmarkDataset> datasets = Datasets(config);
+  for (size_t i = 0; i < datasets.size(); ++i)
+  {
+    const std::string name = "gmm/em/" + CaseName({ datasets[i].Name(config),
+        Param("g", gaussians) });
+    if (!runner.Enabled(name))
+      continue;
+
+    const arma::mat dataset = datasets[i].Generate(config);
+    runner.Run(name, dataset.n_cols, [&]()
+    {
+      // Reseed, so that every run starts from the same clustering.
+      math::RandomSeed(config.seed);
+      GMM gmm(gaussians, dataset.n_rows);
+      gmm.Train(dataset, 1, false, EMFit<>(20, 0.0));
+    });
+  }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file datasets.hpp
+ *
+ * Dataset generators for mlpack_benchmarks.  The synthetic datasets cover the
+ * cases that matter for trees and clustering: uniform data (the worst case for
+ * space partitioning), Gaussian clusters, and data near a low-dimensional
+ * linear manifold (whose intrinsic dimensionality is lower than its
+ * dimensionality, as is typical of real data).  A real dataset can be
+ * benchmarked as well.
+ */
+#ifndef MLPACK_BENCHMARKS_DATASETS_HPP
+#define MLPACK_BENCHMARKS_DATASETS_HPP
+
+#include "benchmark.hpp"
+
+namespace mlpack {
+namespace benchmark {
+
+/**
+ * Generate points uniformly distributed in [0, 1]^d.
+ *
+ * @param dimensionality Dimensionality of the points.
+ * @param points Number of points.
+ */
+inline arma::mat UniformDataset(const size_t dimensionality,
+                                const size_t points)
+{
+  return arma::randu<arma::mat>(dimensionality, points);
+}
+
+/**
+ * Generate points from a mixture of equally likely spherical Gaussians with
+ * standard deviation 0.05, whose centers are uniformly distributed in
+ * [0, 1]^d.  The labels are the indices of the Gaussians.
+ *
+ * @param dimensionality Dimensionality of the points.
+ * @param points Number of points.
+ * @param clusters Number of Gaussians.
+ * @param labels Set to the Gaussian of each point.
+ */
+inline arma::mat ClusteredDataset(const size_t dimensionality,
+                                  const size_t points,
+                                  const size_t clusters,
+                                  arma::Row<size_t>& labels)
+{
+  const arma::mat centers = arma::randu<arma::mat>(dimensionality, clusters);
+  arma::mat dataset = 0.05 * arma::randn<arma::mat>(dimensionality, points);
+  labels.set_size(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    labels[i] = math::RandInt(clusters);
+    dataset.col(i) += centers.col(labels[i]);
+  }
+
+  return dataset;
+}
+
+/**
+ * Generate points near a random linear manifold of dimensionality
+ * min(d, 3): uniform points of the manifold, mapped to d dimensions by a random
+ * linear map, plus Gaussian noise with standard deviation 0.01.
+ *
+ * @param dimensionality Dimensionality of the points.
+ * @param points Number of points.
+ */
+inline arma::mat ManifoldDataset(const size_t dimensionality,
+                                 const size_t points)
+{
+  const size_t intrinsic = std::min(dimensionality, (size_t) 3);
+  const arma::mat map = arma::randn<arma::mat>(dimensionality, intrinsic);
+  return map * arma::randu<arma::mat>(intrinsic, points) +
+      0.01 * arma::randn<arma::mat>(dimensionality, points);
+}
+
+/**
+ * A dataset that benchmarks are run on: a kind of synthetic dataset with a
+ * dimensionality and a number of points, or a sample of the real dataset.
+ */
+struct BenchmarkDataset
+{
+  //! The kind of dataset ("uniform", "clusters", "manifold" or "real").
+  std::string kind;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points.
+  size_t points;
+
+  //! Get the name of the dataset, for the names of benchmark cases.
+  std::string Name(const BenchmarkConfig& config) const
+  {
+    return CaseName({ kind == "real" ? config.realName : kind,
+        Param("d", dimensionality), Param("n", points) });
+  }
+
+  /**
+   * Generate the dataset (with the seed of the configuration, so that every
+   * benchmark sees the same data), or take the first points of the real
+   * dataset.
+   *
+   * @param config Configuration of the benchmarks.
+   * @param labels Set to the cluster of each point ("clusters" datasets, with
+   *     10 clusters), or to 0.
+   */
+  arma::mat Generate(const BenchmarkConfig& config,
+                     arma::Row<size_t>& labels) const
+  {
+    math::RandomSeed(config.seed);
+    labels.zeros(points);
+    if (kind == "real")
+      return config.realData.cols(0, points - 1);
+    else if (kind == "uniform")
+      return UniformDataset(dimensionality, points);
+    else if (kind == "clusters")
+      return ClusteredDataset(dimensionality, points, 10, labels);
+    else if (kind == "manifold")
+      return ManifoldDataset(dimensionality, points);
+
+    throw std::invalid_argument("unknown dataset kind '" + kind + "'; valid "
+        "choices are 'uniform', 'clusters' and 'manifold'");
+  }
+
+  //! Generate the dataset, without labels.
+  arma::mat Generate(const BenchmarkConfig& config) const
+  {
+    arma::Row<size_t> labels;
+    return Generate(config, labels);
+  }
+};
+
+/**
+ * Get every dataset of the configuration: each kind of synthetic dataset with
+ * each dimensionality and number of points, then the real dataset (if any) with
+ * each number of points it has enough points for (or all of its points).
+ */
+inline std::vector<BenchmarkDataset> Datasets(const BenchmarkConfig& config)
+{
+  std::vector<BenchmarkDataset> datasets;
+  for (size_t k = 0; k < config.datasets.size(); ++k)
+    for (size_t d = 0; d < config.dimensions.size(); ++d)
+      for (size_t n = 0; n < config.sizes.size(); ++n)
+        datasets.push_back({ config.datasets[k], config.dimensions[d],
+            config.sizes[n] });
+
+  if (config.realData.n_cols > 0)
+  {
+    bool all = false;
+    for (size_t n = 0; n < config.sizes.size(); ++n)
+    {
+      const size_t points = std::min(config.sizes[n], config.realData.n_cols);
+      if (points == config.realData.n_cols)
+      {
+        if (all)
+          continue;
+        all = true;
+      }
+      datasets.push_back({ "real", config.realData.n_rows, points });
+    }
+  }
+
+  return datasets;
+}
+
+} // namespace benchmark
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file lsh_benchmarks.cpp
+ *
+ * Benchmarks of building LSH tables and of approximate k-nearest-neighbor
+ * search with them, for every dataset of the configuration.
+ */
+#include "benchmark.hpp"
+#include "datasets.hpp"
+
+#include <mlpack/methods/lsh/lsh_search.hpp>
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::neighbor;
+
+/**
+ * Build LSH models with 10 projections and 30 tables, and find the 10 nearest
+ * neighbors of every point of the dataset.
+ */
+MLPACK_BENCHMARK(lsh)
+{
+  const size_t k = 10;
+  const size_t projections = 10;
+  const size_t tables = 30;
+
+  const std::vector<BenchmarkDataset> datasets = Datasets(config);
+  for (size_t i = 0; i < datasets.size(); ++i)
+  {
+    const std::string suffix = "/" + CaseName({ datasets[i].Name(config),
+        Param("proj", projections), Param("tables", tables) });
+    if (!runner.Enabled("lsh/build" + suffix) &&
+        !runner.Enabled("lsh/search" + suffix))
+      continue;
+
+    const arma::mat dataset = datasets[i].Generate(config);
+    LSHSearch<> lsh;
+    runner.Run("lsh/build" + suffix, dataset.n_cols, [&]()
+    {
+      // Reseed, so that every run builds the same tables.
+      math::RandomSeed(config.seed);
+      lsh.Train(dataset, projections, tables);
+    });
+    if (!runner.Enabled("lsh/build" + suffix))
+    {
+      math::RandomSeed(config.seed);
+      lsh.Train(dataset, projections, tables);
+    }
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    runner.Run("lsh/search" + suffix, dataset.n_cols, [&]()
+    {
+      lsh.Search(dataset, k, neighbors, distances);
+    });
+  }
+}
@@ -0,0 +1,152 @@
+/**
+ * @file mlpack_benchmarks.cpp
+ *
+ * Executable running the benchmarks of mlpack methods (see benchmark.hpp).
+ */
+#include "benchmark.hpp"
+#include "datasets.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace std;
+
+PROGRAM_INFO("mlpack Benchmarks", "This program measures the throughput of "
+    "mlpack methods: tree building, k-nearest-neighbor search and range search "
+    "with each tree type, the k-means Lloyd step implementations, GMM training "
+    "with EM, LSH, and feedforward neural network training.  Each benchmark "
+    "runs a grid of cases: every combination of the given tree types, kinds of "
+    "synthetic datasets, dimensionalities, numbers of points and leaf sizes.  "
+    "A real dataset can be given with --real_file (-i), to be benchmarked as "
+    "well (its first points are used, for each number of points)."
+    "\n\n"
+    "Each case is run --warmup (-w) times without timing, then --repetitions "
+    "(-r) times; the median and minimum times are printed (with --verbose), "
+    "and all the timings are written to the file given with --output_file "
+    "(-o), as CSV or JSON (if its extension is .json).  The names of the "
+    "cases, such as 'knn/search/kd/clusters/d=3/n=10000/leaf=20', can be "
+    "listed with --list (-L), and selected with --filter (-f), which takes "
+    "comma-separated substrings of the names."
+    "\n\n"
+    "The synthetic datasets are 'uniform' (uniform in the unit hypercube), "
+    "'clusters' (10 Gaussian clusters) and 'manifold' (points near a random "
+    "3-dimensional linear subspace); they are generated with the given --seed "
+    "(-s).");
+
+PARAM_STRING("filter", "Comma-separated substrings of the names of the cases "
+    "to run (all cases are run if not given).", "f", "");
+PARAM_FLAG("list", "List the names of the cases, without running them.", "L");
+PARAM_INT("warmup", "Number of untimed runs of each case.", "w", 1);
+PARAM_INT("repetitions", "Number of timed runs of each case.", "r", 5);
+PARAM_STRING("sizes", "Comma-separated numbers of points of the datasets.",
+    "n", "10000");
+PARAM_STRING("dimensions", "Comma-separated dimensionalities of the synthetic "
+    "datasets.", "d", "3,10");
+PARAM_STRING("leaf_sizes", "Comma-separated leaf sizes of the trees.", "l",
+    "20");
+PARAM_STRING("trees", "Comma-separated tree types: 'kd', 'ball', 'cover', "
+    "'r', 'r-star', 'x' and 'vp' (VP trees are only used for k-nearest-neighbor"
+    " search).", "t", "kd,ball,cover");
+PARAM_STRING("datasets", "Comma-separated kinds of synthetic datasets: "
+    "'uniform', 'clusters' and 'manifold'.", "D", "clusters");
+PARAM_STRING("real_file", "File containing a real dataset to benchmark as "
+    "well.", "i", "");
+PARAM_STRING("output_file", "File to write the timings of the cases to, as CSV "
+    "or JSON (.json).", "o", "");
+PARAM_INT("seed", "Random seed of the synthetic datasets.", "s", 42);
+
+namespace {
+
+//! Split the given comma-separated list.
+vector<string> SplitList(const string& list)
+{
+  vector<string> items;
+  istringstream stream(list);
+  string item;
+  while (getline(stream, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+//! Split the given comma-separated list of positive numbers.
+vector<size_t> SplitNumbers(const string& list, const string& parameter)
+{
+  const vector<string> items = SplitList(list);
+  vector<size_t> numbers;
+  for (size_t i = 0; i < items.size(); ++i)
+  {
+    const int number = atoi(items[i].c_str());
+    if (number <= 0)
+      Log::Fatal << "Invalid value '" << items[i] << "' in --" << parameter
+          << "; the values must be positive integers." << endl;
+    numbers.push_back((size_t) number);
+  }
+  return numbers;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  BenchmarkConfig config;
+  config.sizes = SplitNumbers(CLI::GetParam<string>("sizes"), "sizes");
+  config.dimensions = SplitNumbers(CLI::GetParam<string>("dimensions"),
+      "dimensions");
+  config.leafSizes = SplitNumbers(CLI::GetParam<string>("leaf_sizes"),
+      "leaf_sizes");
+  config.trees = SplitList(CLI::GetParam<string>("trees"));
+  config.datasets = SplitList(CLI::GetParam<string>("datasets"));
+  config.seed = (size_t) CLI::GetParam<int>("seed");
+
+  if (CLI::HasParam("real_file"))
+  {
+    const string realFile = CLI::GetParam<string>("real_file");
+    data::Load(realFile, config.realData, true);
+    config.realName = "real:" + realFile.substr(realFile.find_last_of("/\\")
+        + 1);
+  }
+
+  const int warmup = CLI::GetParam<int>("warmup");
+  const int repetitions = CLI::GetParam<int>("repetitions");
+  if (warmup < 0 || repetitions <= 0)
+    Log::Fatal << "--warmup must be nonnegative and --repetitions must be "
+        << "positive." << endl;
+
+  // In list mode, the benchmarks only report the names of their cases.
+  const bool list = CLI::HasParam("list");
+  BenchmarkRunner runner(CLI::GetParam<string>("filter"), (size_t) warmup,
+      (size_t) repetitions, list);
+  vector<pair<string, BenchmarkFunction>>& benchmarks = Benchmarks();
+  for (size_t i = 0; i < benchmarks.size(); ++i)
+  {
+    if (!list)
+      Log::Info << "Running the '" << benchmarks[i].first << "' benchmark."
+          << endl;
+    Timer::Start("benchmark_" + benchmarks[i].first);
+    benchmarks[i].second(config, runner);
+    Timer::Stop("benchmark_" + benchmarks[i].first);
+  }
+
+  if (list)
+  {
+    for (size_t i = 0; i < runner.Listed().size(); ++i)
+      cout << runner.Listed()[i] << endl;
+    return 0;
+  }
+
+  if (CLI::HasParam("output_file"))
+  {
+    try
+    {
+      runner.Save(CLI::GetParam<string>("output_file"));
+    }
+    catch (std::exception& e)
+    {
+      Log::Fatal << "Saving the results failed: " << e.what() << endl;
+    }
+  }
+
+  return 0;
+}
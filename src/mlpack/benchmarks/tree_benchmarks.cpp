@@ -0,0 +1,177 @@
+/**
+ * @file tree_benchmarks.cpp
+ *
+ * Benchmarks of tree building, k-nearest-neighbor search and range search, for
+ * every tree type, dataset and leaf size of the configuration.
+ */
+#include "benchmark.hpp"
+#include "datasets.hpp"
+
+#include <mlpack/methods/neighbor_search/ns_model.hpp>
+#include <mlpack/methods/range_search/rs_model.hpp>
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::neighbor;
+using namespace mlpack::range;
+
+namespace {
+
+//! Get the tree type of the given model type with the given name (VP trees
+//! are handled by the caller, since only neighbor search models have them).
+template<typename ModelType>
+typename ModelType::TreeTypes TreeType(const std::string& name)
+{
+  if (name == "kd")
+    return ModelType::KD_TREE;
+  else if (name == "cover")
+    return ModelType::COVER_TREE;
+  else if (name == "r")
+    return ModelType::R_TREE;
+  else if (name == "r-star")
+    return ModelType::R_STAR_TREE;
+  else if (name == "ball")
+    return ModelType::BALL_TREE;
+  else if (name == "x")
+    return ModelType::X_TREE;
+
+  throw std::invalid_argument("unknown tree type '" + name + "'; valid choices "
+      "are 'kd', 'cover', 'r', 'r-star', 'x' and 'ball'");
+}
+
+//! Get the leaf sizes to run the given tree type with; cover trees have no
+//! leaves, so they are only run once.
+std::vector<size_t> LeafSizes(const BenchmarkConfig& config,
+                              const std::string& tree)
+{
+  if (tree == "cover")
+    return std::vector<size_t>(1, 1);
+  return config.leafSizes;
+}
+
+/**
+ * Estimate the radius holding k neighbors of a point, on average: the mean
+ * distance to the k'th nearest neighbor of up to 100 points, found by brute
+ * force.
+ */
+double NeighborhoodRadius(const arma::mat& dataset, const size_t k)
+{
+  const size_t samples = std::min((size_t) 100, (size_t) dataset.n_cols);
+  double radius = 0.0;
+  for (size_t i = 0; i < samples; ++i)
+  {
+    const size_t point = i * (dataset.n_cols / samples);
+    std::vector<double> distances(dataset.n_cols);
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+    {
+      distances[j] = metric::EuclideanDistance::Evaluate(dataset.col(point),
+          dataset.col(j));
+    }
+    std::nth_element(distances.begin(), distances.begin() + std::min(k,
+        (size_t) dataset.n_cols - 1), distances.end());
+    radius += distances[std::min(k, (size_t) dataset.n_cols - 1)] / samples;
+  }
+
+  return radius;
+}
+
+} // anonymous namespace
+
+/**
+ * Build each tree type, and find the 10 nearest neighbors of every point of the
+ * dataset with the dual-tree algorithm, and with the single-tree algorithm.
+ */
+MLPACK_BENCHMARK(knn)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+  const size_t k = 10;
+
+  const std::vector<BenchmarkDataset> datasets = Datasets(config);
+  for (size_t t = 0; t < config.trees.size(); ++t)
+  {
+    const std::string& tree = config.trees[t];
+    const std::vector<size_t> leafSizes = LeafSizes(config, tree);
+    for (size_t i = 0; i < datasets.size(); ++i)
+    {
+      for (size_t l = 0; l < leafSizes.size(); ++l)
+      {
+        const std::string suffix = CaseName({ tree,
+            datasets[i].Name(config), Param("leaf", leafSizes[l]) });
+        const std::string buildName = "knn/build/" + suffix;
+        const std::string searchName = "knn/search/" + suffix;
+        const std::string singleName = "knn/single/" + suffix;
+        if (!runner.Enabled(buildName) && !runner.Enabled(searchName) &&
+            !runner.Enabled(singleName))
+          continue;
+
+        const arma::mat dataset = datasets[i].Generate(config);
+        KNNModel model;
+        model.TreeType() = (tree == "vp") ? KNNModel::VP_TREE :
+            TreeType<KNNModel>(tree);
+
+        runner.Run(buildName, dataset.n_cols, [&]()
+        {
+          model.BuildModel(arma::mat(dataset), leafSizes[l], false, false);
+        });
+        if (!runner.Enabled(buildName))
+          model.BuildModel(arma::mat(dataset), leafSizes[l], false, false);
+
+        arma::Mat<size_t> neighbors;
+        arma::mat distances;
+        runner.Run(searchName, dataset.n_cols, [&]()
+        {
+          model.Search(k, neighbors, distances);
+        });
+
+        model.SingleMode() = true;
+        runner.Run(singleName, dataset.n_cols, [&]()
+        {
+          model.Search(k, neighbors, distances);
+        });
+      }
+    }
+  }
+}
+
+/**
+ * Build each tree type, and find the neighbors of every point of the dataset
+ * within the radius which holds 10 neighbors on average, with the dual-tree
+ * algorithm.
+ */
+MLPACK_BENCHMARK(range_search)
+{
+  typedef RSModel Model;
+
+  const std::vector<BenchmarkDataset> datasets = Datasets(config);
+  for (size_t t = 0; t < config.trees.size(); ++t)
+  {
+    // Range search models have no VP trees.
+    const std::string& tree = config.trees[t];
+    if (tree == "vp")
+      continue;
+
+    const std::vector<size_t> leafSizes = LeafSizes(config, tree);
+    for (size_t i = 0; i < datasets.size(); ++i)
+    {
+      for (size_t l = 0; l < leafSizes.size(); ++l)
+      {
+        const std::string name = "range_search/" + CaseName({ tree,
+            datasets[i].Name(config), Param("leaf", leafSizes[l]) });
+        if (!runner.Enabled(name))
+          continue;
+
+        const arma::mat dataset = datasets[i].Generate(config);
+        const math::Range range(0.0, NeighborhoodRadius(dataset, 10));
+        Model model(TreeType<Model>(tree));
+        model.BuildModel(arma::mat(dataset), leafSizes[l], false, false);
+
+        std::vector<size_t> offsets, neighbors;
+        std::vector<double> distances;
+        runner.Run(name, dataset.n_cols, [&]()
+        {
+          model.Search(range, offsets, neighbors, distances);
+        });
+      }
+    }
+  }
+}
@@ -0,0 +1,207 @@
+/**
+ * @file mlpack.h
+ *
+ * The C API of mlpack: functions to load models that were trained and saved by
+ * the mlpack command-line programs (or by the C++ library), and to run
+ * predictions with them in the calling process.
+ *
+ * All matrices are arrays of doubles in column-major order, with one point per
+ * column, as mlpack stores them; the caller owns all the arrays.  The input
+ * points are used where they are, without a copy, except by kNN search, which
+ * reorders its query points when it builds a tree on them.  The results are
+ * written directly into the output arrays given by the caller, which must have
+ * the given size.
+ *
+ * Functions that return an int return 0 on success and -1 on failure (for
+ * instance, if the model or an array is NULL, or if the points do not have the
+ * dimensionality of the model), and functions that return a model return NULL
+ * on failure; in both cases, mlpack_last_error() describes the failure.  The
+ * functions that return a size of a model return 0 if the model is NULL.
+ *
+ * A loaded model may be used by several threads at once.  kNN searches with
+ * the same model are serialized (each one is parallelized internally if mlpack
+ * was built with OpenMP); the other predictions run concurrently.
+ */
+#ifndef MLPACK_BINDINGS_C_MLPACK_H
+#define MLPACK_BINDINGS_C_MLPACK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Return a description of the last failure of an mlpack function in the
+ * calling thread, or an empty string if there was none.  The string is valid
+ * until the next call to an mlpack function in the same thread.
+ */
+const char* mlpack_last_error(void);
+
+/*
+ * k-nearest-neighbor search, with a model saved by mlpack_knn
+ * (--output_model_file).
+ */
+
+/** An opaque kNN model. */
+typedef struct mlpack_knn_model mlpack_knn_model;
+
+/** Load a kNN model; returns NULL on failure. */
+mlpack_knn_model* mlpack_knn_load(const char* filename);
+
+/** Free a kNN model (which may be NULL). */
+void mlpack_knn_free(mlpack_knn_model* model);
+
+/** Return the dimensionality of the reference points of a kNN model. */
+size_t mlpack_knn_dimensionality(const mlpack_knn_model* model);
+
+/** Return the number of reference points of a kNN model. */
+size_t mlpack_knn_num_points(const mlpack_knn_model* model);
+
+/**
+ * Find the k nearest reference points of each query point.
+ *
+ * @param model kNN model.
+ * @param queries Query points (dimensionality x num_queries).
+ * @param dimensionality Dimensionality of the query points.
+ * @param num_queries Number of query points.
+ * @param k Number of neighbors to find (at most the number of reference
+ *     points).
+ * @param neighbors Array to store the indices of the neighbors of each query
+ *     point in (k x num_queries), nearest first.
+ * @param distances Array to store the distances to the neighbors in
+ *     (k x num_queries).
+ */
+int mlpack_knn_search(mlpack_knn_model* model,
+                      const double* queries,
+                      size_t dimensionality,
+                      size_t num_queries,
+                      size_t k,
+                      size_t* neighbors,
+                      double* distances);
+
+/*
+ * Logistic regression, with a model saved by mlpack_logistic_regression
+ * (--output_model_file).
+ */
+
+/** An opaque logistic regression model. */
+typedef struct mlpack_logistic_regression_model
+    mlpack_logistic_regression_model;
+
+/** Load a logistic regression model; returns NULL on failure. */
+mlpack_logistic_regression_model* mlpack_logistic_regression_load(
+    const char* filename);
+
+/** Free a logistic regression model (which may be NULL). */
+void mlpack_logistic_regression_free(mlpack_logistic_regression_model* model);
+
+/** Return the dimensionality of the points of a logistic regression model. */
+size_t mlpack_logistic_regression_dimensionality(
+    const mlpack_logistic_regression_model* model);
+
+/**
+ * Classify points with a logistic regression model.
+ *
+ * @param model Logistic regression model.
+ * @param points Points to classify (dimensionality x num_points).
+ * @param dimensionality Dimensionality of the points.
+ * @param num_points Number of points.
+ * @param decision_boundary Probability of class 1 above which a point is
+ *     labeled 1 (0.5 is usual).
+ * @param labels Array to store the label (0 or 1) of each point in.
+ * @param probabilities If not NULL, array to store the probability of class 1
+ *     of each point in.
+ */
+int mlpack_logistic_regression_classify(
+    const mlpack_logistic_regression_model* model,
+    const double* points,
+    size_t dimensionality,
+    size_t num_points,
+    double decision_boundary,
+    size_t* labels,
+    double* probabilities);
+
+/*
+ * Hoeffding trees, with a model saved by mlpack_hoeffding_tree
+ * (--output_model_file).
+ */
+
+/** An opaque Hoeffding tree model. */
+typedef struct mlpack_hoeffding_tree_model mlpack_hoeffding_tree_model;
+
+/**
+ * Load a Hoeffding tree model; returns NULL on failure.  The numeric split
+ * strategy must be the one the tree was trained with: "domingos", "binary" or
+ * "quantile" (as the --numeric_split_strategy option of mlpack_hoeffding_tree).
+ */
+mlpack_hoeffding_tree_model* mlpack_hoeffding_tree_load(
+    const char* filename,
+    const char* numeric_split_strategy);
+
+/** Free a Hoeffding tree model (which may be NULL). */
+void mlpack_hoeffding_tree_free(mlpack_hoeffding_tree_model* model);
+
+/** Return the dimensionality of the points of a Hoeffding tree model. */
+size_t mlpack_hoeffding_tree_dimensionality(
+    const mlpack_hoeffding_tree_model* model);
+
+/**
+ * Classify points with a Hoeffding tree.  Categorical dimensions must hold the
+ * indices of the categories, as mapped when the tree was trained.
+ *
+ * @param model Hoeffding tree model.
+ * @param points Points to classify (dimensionality x num_points).
+ * @param dimensionality Dimensionality of the points.
+ * @param num_points Number of points.
+ * @param labels Array to store the predicted label of each point in.
+ * @param probabilities If not NULL, array to store the probability estimate of
+ *     the label of each point in.
+ */
+int mlpack_hoeffding_tree_classify(const mlpack_hoeffding_tree_model* model,
+                                   const double* points,
+                                   size_t dimensionality,
+                                   size_t num_points,
+                                   size_t* labels,
+                                   double* probabilities);
+
+/*
+ * Gaussian mixture models, with a model saved by mlpack_gmm_train
+ * (--output_model_file).
+ */
+
+/** An opaque GMM. */
+typedef struct mlpack_gmm_model mlpack_gmm_model;
+
+/** Load a GMM; returns NULL on failure. */
+mlpack_gmm_model* mlpack_gmm_load(const char* filename);
+
+/** Free a GMM (which may be NULL). */
+void mlpack_gmm_free(mlpack_gmm_model* model);
+
+/** Return the dimensionality of a GMM. */
+size_t mlpack_gmm_dimensionality(const mlpack_gmm_model* model);
+
+/**
+ * Compute the probability density (or its logarithm) of points under a GMM.
+ *
+ * @param model GMM.
+ * @param points Points (dimensionality x num_points).
+ * @param dimensionality Dimensionality of the points.
+ * @param num_points Number of points.
+ * @param log_probability If nonzero, the logarithms of the densities are
+ *     computed (which do not underflow in high dimensions).
+ * @param probabilities Array to store the density of each point in.
+ */
+int mlpack_gmm_probability(const mlpack_gmm_model* model,
+                           const double* points,
+                           size_t dimensionality,
+                           size_t num_points,
+                           int log_probability,
+                           double* probabilities);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,435 @@
+/**
+ * @file mlpack_c.cpp
+ *
+ * Implementation of the C API of mlpack (see mlpack.h).  Each function catches
+ * all exceptions (including those not derived from std::exception), so that
+ * none crosses the C boundary, and records the failure for mlpack_last_error().
+ * The models given to the functions are checked for NULL.
+ */
+#include "mlpack.h"
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/ns_model.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+#include <mlpack/methods/hoeffding_trees/hoeffding_tree.hpp>
+#include <mlpack/methods/hoeffding_trees/binary_numeric_split.hpp>
+#include <mlpack/methods/hoeffding_trees/quantile_numeric_split.hpp>
+#include <mlpack/methods/hoeffding_trees/flat_hoeffding_tree.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace mlpack;
+
+struct mlpack_knn_model
+{
+  neighbor::NSModel<neighbor::NearestNeighborSort> model;
+  //! NSModel::Search() is not const, so searches are serialized.
+  std::mutex mutex;
+};
+
+struct mlpack_logistic_regression_model
+{
+  mlpack_logistic_regression_model() : model(0, 0) { }
+
+  regression::LogisticRegression<> model;
+};
+
+struct mlpack_hoeffding_tree_model
+{
+  template<typename TreeType>
+  mlpack_hoeffding_tree_model(const TreeType& tree) :
+      model(tree),
+      dimensionality(tree.DatasetInfo().Dimensionality()) { }
+
+  //! The flattened tree, which is faster to classify with.
+  tree::FlatHoeffdingTree model;
+  //! The dimensionality of the points the tree was trained on.
+  size_t dimensionality;
+};
+
+struct mlpack_gmm_model
+{
+  gmm::GMM model;
+};
+
+namespace {
+
+//! The description of the last failure in each thread.
+thread_local std::string lastError;
+
+//! Record a failure, and return -1.
+int Fail(const std::string& message)
+{
+  lastError = message;
+  return -1;
+}
+
+//! Check that the model given to a function is not NULL.
+void CheckModel(const void* model)
+{
+  if (model == NULL)
+    throw std::invalid_argument("the model is NULL");
+}
+
+//! Check the size of the points given to a model.
+void CheckPoints(const double* points,
+                 const size_t dimensionality,
+                 const size_t expectedDimensionality)
+{
+  if (points == NULL)
+    throw std::invalid_argument("the points are NULL");
+  if (dimensionality != expectedDimensionality)
+  {
+    std::ostringstream oss;
+    oss << "the points have " << dimensionality << " dimensions, but the "
+        << "model has " << expectedDimensionality << " dimensions";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+//! Load the given model, and throw if it can't be loaded.
+template<typename ModelType>
+void LoadModel(const char* filename, const std::string& name, ModelType& model)
+{
+  if (filename == NULL)
+    throw std::invalid_argument("the filename is NULL");
+  if (!data::Load(filename, name, model, false))
+    throw std::runtime_error("could not load the model from '" +
+        std::string(filename) + "'");
+}
+
+//! Load a Hoeffding tree of the given type, and flatten it.
+template<typename TreeType>
+mlpack_hoeffding_tree_model* LoadHoeffdingTree(const char* filename)
+{
+  data::DatasetInfo info;
+  TreeType tree(info, 1, 1);
+  LoadModel(filename, "streamingDecisionTree", tree);
+  return new mlpack_hoeffding_tree_model(tree);
+}
+
+} // anonymous namespace
+
+extern "C" {
+
+const char* mlpack_last_error(void)
+{
+  return lastError.c_str();
+}
+
+mlpack_knn_model* mlpack_knn_load(const char* filename)
+{
+  try
+  {
+    lastError.clear();
+    std::unique_ptr<mlpack_knn_model> model(new mlpack_knn_model());
+    LoadModel(filename, "knn_model", model->model);
+    return model.release();
+  }
+  catch (std::exception& e)
+  {
+    Fail(e.what());
+    return NULL;
+  }
+  catch (...)
+  {
+    Fail("unknown exception");
+    return NULL;
+  }
+}
+
+void mlpack_knn_free(mlpack_knn_model* model)
+{
+  delete model;
+}
+
+size_t mlpack_knn_dimensionality(const mlpack_knn_model* model)
+{
+  return (model == NULL) ? 0 : model->model.Dataset().n_rows;
+}
+
+size_t mlpack_knn_num_points(const mlpack_knn_model* model)
+{
+  return (model == NULL) ? 0 : model->model.Dataset().n_cols;
+}
+
+int mlpack_knn_search(mlpack_knn_model* model,
+                      const double* queries,
+                      size_t dimensionality,
+                      size_t num_queries,
+                      size_t k,
+                      size_t* neighbors,
+                      double* distances)
+{
+  try
+  {
+    lastError.clear();
+    CheckModel(model);
+    CheckPoints(queries, dimensionality, model->model.Dataset().n_rows);
+    if (neighbors == NULL || distances == NULL)
+      return Fail("the output arrays are NULL");
+    if (k == 0 || k > model->model.Dataset().n_cols)
+      return Fail("k must be between 1 and the number of reference points");
+
+    // The search reorders the query points when it builds a tree on them, so
+    // they are copied.  The results are written into the caller's arrays.
+    arma::mat querySet(queries, dimensionality, num_queries);
+    arma::Mat<size_t> neighborsAlias(neighbors, k, num_queries, false, true);
+    arma::mat distancesAlias(distances, k, num_queries, false, true);
+
+    std::lock_guard<std::mutex> lock(model->mutex);
+    model->model.Search(std::move(querySet), k, neighborsAlias,
+        distancesAlias);
+    return 0;
+  }
+  catch (std::exception& e)
+  {
+    return Fail(e.what());
+  }
+  catch (...)
+  {
+    return Fail("unknown exception");
+  }
+}
+
+mlpack_logistic_regression_model* mlpack_logistic_regression_load(
+    const char* filename)
+{
+  try
+  {
+    lastError.clear();
+    std::unique_ptr<mlpack_logistic_regression_model> model(
+        new mlpack_logistic_regression_model());
+    LoadModel(filename, "logistic_regression_model", model->model);
+    return model.release();
+  }
+  catch (std::exception& e)
+  {
+    Fail(e.what());
+    return NULL;
+  }
+  catch (...)
+  {
+    Fail("unknown exception");
+    return NULL;
+  }
+}
+
+void mlpack_logistic_regression_free(mlpack_logistic_regression_model* model)
+{
+  delete model;
+}
+
+size_t mlpack_logistic_regression_dimensionality(
+    const mlpack_logistic_regression_model* model)
+{
+  // The first parameter is the intercept.
+  return (model == NULL) ? 0 : model->model.Parameters().n_elem - 1;
+}
+
+int mlpack_logistic_regression_classify(
+    const mlpack_logistic_regression_model* model,
+    const double* points,
+    size_t dimensionality,
+    size_t num_points,
+    double decision_boundary,
+    size_t* labels,
+    double* probabilities)
+{
+  try
+  {
+    lastError.clear();
+    CheckModel(model);
+    CheckPoints(points, dimensionality,
+        mlpack_logistic_regression_dimensionality(model));
+    if (labels == NULL)
+      return Fail("the labels array is NULL");
+
+    // Use the points where they are, without a copy.
+    const arma::mat dataset(const_cast<double*>(points), dimensionality,
+        num_points, false, true);
+    arma::Row<size_t> labelsAlias(labels, num_points, false, true);
+    model->model.Classify(dataset, labelsAlias, decision_boundary);
+
+    if (probabilities != NULL)
+    {
+      arma::mat classProbabilities;
+      model->model.Classify(dataset, classProbabilities);
+      arma::rowvec probabilitiesAlias(probabilities, num_points, false, true);
+      probabilitiesAlias = classProbabilities.row(1);
+    }
+
+    return 0;
+  }
+  catch (std::exception& e)
+  {
+    return Fail(e.what());
+  }
+  catch (...)
+  {
+    return Fail("unknown exception");
+  }
+}
+
+mlpack_hoeffding_tree_model* mlpack_hoeffding_tree_load(
+    const char* filename,
+    const char* numeric_split_strategy)
+{
+  using namespace mlpack::tree;
+
+  try
+  {
+    lastError.clear();
+    const std::string strategy = (numeric_split_strategy == NULL) ? "" :
+        numeric_split_strategy;
+    if (strategy == "domingos")
+      return LoadHoeffdingTree<HoeffdingTree<GiniImpurity,
+          HoeffdingDoubleNumericSplit, HoeffdingCategoricalSplit>>(filename);
+    else if (strategy == "binary")
+      return LoadHoeffdingTree<HoeffdingTree<GiniImpurity,
+          BinaryDoubleNumericSplit, HoeffdingCategoricalSplit>>(filename);
+    else if (strategy == "quantile")
+      return LoadHoeffdingTree<HoeffdingTree<GiniImpurity,
+          QuantileDoubleNumericSplit, HoeffdingCategoricalSplit>>(filename);
+
+    Fail("unknown numeric split strategy '" + strategy + "'; must be "
+        "'domingos', 'binary' or 'quantile'");
+    return NULL;
+  }
+  catch (std::exception& e)
+  {
+    Fail(e.what());
+    return NULL;
+  }
+  catch (...)
+  {
+    Fail("unknown exception");
+    return NULL;
+  }
+}
+
+void mlpack_hoeffding_tree_free(mlpack_hoeffding_tree_model* model)
+{
+  delete model;
+}
+
+size_t mlpack_hoeffding_tree_dimensionality(
+    const mlpack_hoeffding_tree_model* model)
+{
+  return (model == NULL) ? 0 : model->dimensionality;
+}
+
+int mlpack_hoeffding_tree_classify(const mlpack_hoeffding_tree_model* model,
+                                   const double* points,
+                                   size_t dimensionality,
+                                   size_t num_points,
+                                   size_t* labels,
+                                   double* probabilities)
+{
+  try
+  {
+    lastError.clear();
+    CheckModel(model);
+    CheckPoints(points, dimensionality, model->dimensionality);
+    if (labels == NULL)
+      return Fail("the labels array is NULL");
+
+    // Use the points where they are, without a copy.
+    const arma::mat dataset(const_cast<double*>(points), dimensionality,
+        num_points, false, true);
+    arma::Row<size_t> labelsAlias(labels, num_points, false, true);
+    if (probabilities != NULL)
+    {
+      arma::rowvec probabilitiesAlias(probabilities, num_points, false, true);
+      model->model.Classify(dataset, labelsAlias, probabilitiesAlias);
+    }
+    else
+    {
+      model->model.Classify(dataset, labelsAlias);
+    }
+
+    return 0;
+  }
+  catch (std::exception& e)
+  {
+    return Fail(e.what());
+  }
+  catch (...)
+  {
+    return Fail("unknown exception");
+  }
+}
+
+mlpack_gmm_model* mlpack_gmm_load(const char* filename)
+{
+  try
+  {
+    lastError.clear();
+    std::unique_ptr<mlpack_gmm_model> model(new mlpack_gmm_model());
+    LoadModel(filename, "gmm", model->model);
+    return model.release();
+  }
+  catch (std::exception& e)
+  {
+    Fail(e.what());
+    return NULL;
+  }
+  catch (...)
+  {
+    Fail("unknown exception");
+    return NULL;
+  }
+}
+
+void mlpack_gmm_free(mlpack_gmm_model* model)
+{
+  delete model;
+}
+
+size_t mlpack_gmm_dimensionality(const mlpack_gmm_model* model)
+{
+  return (model == NULL) ? 0 : model->model.Dimensionality();
+}
+
+int mlpack_gmm_probability(const mlpack_gmm_model* model,
+                           const double* points,
+                           size_t dimensionality,
+                           size_t num_points,
+                           int log_probability,
+                           double* probabilities)
+{
+  try
+  {
+    lastError.clear();
+    CheckModel(model);
+    CheckPoints(points, dimensionality, model->model.Dimensionality());
+    if (probabilities == NULL)
+      return Fail("the probabilities array is NULL");
+
+    // Use the points where they are, without a copy.
+    const arma::mat dataset(const_cast<double*>(points), dimensionality,
+        num_points, false, true);
+    arma::vec probabilitiesAlias(probabilities, num_points, false, true);
+    if (log_probability)
+      model->model.LogProbability(dataset, probabilitiesAlias);
+    else
+      model->model.Probability(dataset, probabilitiesAlias);
+
+    return 0;
+  }
+  catch (std::exception& e)
+  {
+    return Fail(e.what());
+  }
+  catch (...)
+  {
+    return Fail("unknown exception");
+  }
+}
+
+} // extern "C"
@@ -5,6 +5,7 @@
  * MEX function for MATLAB All-kFN binding.
  */
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
@@ -28,17 +29,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("Two outputs required.");
   }
 
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-
-  // Create the reference matrix.
-  arma::mat referenceData(numDimensions, numPoints);
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+  // Use the reference points where they are, without a copy.
+  const arma::mat referenceData(MexInput(prhs[0], "reference set"),
+      mxGetM(prhs[0]), mxGetN(prhs[0]), false, true);
 
   // getting the leafsize
   int lsInt = (int) mxGetScalar(prhs[3]);
@@ -52,9 +45,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // single mode?
   bool singleMode = (mxGetScalar(prhs[5]) == 1.0);
 
-  // the query matrix
-  double * mexQueryPoints = mxGetPr(prhs[2]);
-  arma::mat queryData;
+  // the query matrix, also used where it is (it is empty if there is none)
+  const arma::mat queryData(MexInput(prhs[2], "query set"), mxGetM(prhs[2]),
+      mxGetN(prhs[2]), false, true);
   bool hasQueryData = ((mxGetM(prhs[2]) != 0) && (mxGetN(prhs[2]) != 0));
 
   // Sanity check on k value: must be greater than 0, must be less than the
@@ -105,16 +98,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   if (hasQueryData)
   {
-    // setting the values.
-    mexDataPoints = mxGetPr(prhs[2]);
-    numPoints = mxGetN(prhs[2]);
-    numDimensions = mxGetM(prhs[2]);
-    queryData = arma::mat(numDimensions, numPoints);
-    for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-    {
-      queryData(i) = mexDataPoints[i];
-    }
-
     if (naive && leafSize < queryData.n_cols)
       leafSize = queryData.n_cols;
 
@@ -135,9 +118,12 @@ void mexFunction(int nlhs, mxArray *plhs[],
   allkfn->Search(k, neighbors, distances);
 
   // We have to map back to the original indices from before the tree
-  // construction.
-  arma::mat distancesOut(distances.n_rows, distances.n_cols);
-  arma::Mat<size_t> neighborsOut(neighbors.n_rows, neighbors.n_cols);
+  // construction.  The results are mapped directly into the output arrays; the
+  // indices of the neighbors are converted to doubles, as MATLAB expects.
+  arma::mat distancesOut(MexOutput(plhs[0], distances.n_rows,
+      distances.n_cols), distances.n_rows, distances.n_cols, false, true);
+  arma::mat neighborsOut(MexOutput(plhs[1], neighbors.n_rows,
+      neighbors.n_cols), neighbors.n_rows, neighbors.n_cols, false, true);
 
   // Do the actual remapping.
   if (hasQueryData)
@@ -173,22 +159,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
   if (queryTree)
     delete queryTree;
 
-  // constructing matrix to return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distances.n_rows, distances.n_cols, mxREAL);
-  plhs[1] = mxCreateDoubleMatrix(neighbors.n_rows, neighbors.n_cols, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = distances.n_rows * distances.n_cols; i < n; ++i)
-  {
-    out[i] = distances(i);
-  }
-  out = mxGetPr(plhs[1]);
-  for (int i = 0, n = neighbors.n_rows * neighbors.n_cols; i < n; ++i)
-  {
-    out[i] = neighbors(i);
-  }
-
   // More clean up.
   delete allkfn;
 }
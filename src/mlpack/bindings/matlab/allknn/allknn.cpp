@@ -5,6 +5,7 @@
  * MEX function for MATLAB All-kNN binding.
  */
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
@@ -30,18 +31,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("Two outputs required.");
   }
 
-  // getting the dimensions of the reference matrix
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-
-  // feeding the referenceData matrix
-  arma::mat referenceData(numDimensions, numPoints);
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+  // Use the reference points where they are, without a copy.
+  const arma::mat referenceData(MexInput(prhs[0], "reference set"),
+      mxGetM(prhs[0]), mxGetN(prhs[0]), false, true);
 
   // getting the leafsize
   int lsInt = (int) mxGetScalar(prhs[3]);
@@ -55,9 +47,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // single mode?
   bool singleMode = (mxGetScalar(prhs[5]) == 1.0);
 
-  // the query matrix
-  double * mexQueryPoints = mxGetPr(prhs[2]);
-  arma::mat queryData;
+  // the query matrix, also used where it is (it is empty if there is none)
+  const arma::mat queryData(MexInput(prhs[2], "query set"), mxGetM(prhs[2]),
+      mxGetN(prhs[2]), false, true);
   bool hasQueryData = ((mxGetM(prhs[2]) != 0) && (mxGetN(prhs[2]) != 0));
 
   // cover-tree?
@@ -93,8 +85,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
   if (naive)
     leafSize = referenceData.n_cols;
 
-  arma::Mat<size_t> neighbors;
-  arma::mat distances;
+  // The results are written directly into the output arrays.  The indices of
+  // the neighbors are converted to doubles, as MATLAB expects.
+  const size_t numQueries = hasQueryData ? queryData.n_cols :
+      referenceData.n_cols;
+  arma::mat distances(MexOutput(plhs[0], k, numQueries), k, numQueries,
+      false, true);
+  arma::mat neighbors(MexOutput(plhs[1], k, numQueries), k, numQueries,
+      false, true);
 
   //if (!CLI::HasParam("cover_tree"))
   if (usesCoverTree)
@@ -117,16 +115,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     if (hasQueryData)
     {
-      // setting the values.
-      mexDataPoints = mxGetPr(prhs[2]);
-      numPoints = mxGetN(prhs[2]);
-      numDimensions = mxGetM(prhs[2]);
-      queryData = arma::mat(numDimensions, numPoints);
-      for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-      {
-        queryData(i) = mexDataPoints[i];
-      }
-
       if (naive && leafSize < queryData.n_cols)
         leafSize = queryData.n_cols;
 
@@ -154,9 +142,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     // We have to map back to the original indices from before the tree
     // construction.
-    neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
-    distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
-
     // Do the actual remapping.
     if ((hasQueryData) && !singleMode)
     {
@@ -220,16 +205,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
     // See if we have query data.
     if (hasQueryData)
     {
-      // setting the values.
-      mexDataPoints = mxGetPr(prhs[2]);
-      numPoints = mxGetN(prhs[2]);
-      numDimensions = mxGetM(prhs[2]);
-      queryData = arma::mat(numDimensions, numPoints);
-      for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-      {
-        queryData(i) = mexDataPoints[i];
-      }
-
       // Build query tree.
       if (!singleMode)
       {
@@ -251,29 +226,13 @@ void mexFunction(int nlhs, mxArray *plhs[],
           singleMode);
     }
 
-    allknn->Search(k, neighbors, distances);
+    arma::Mat<size_t> neighborsOut;
+    allknn->Search(k, neighborsOut, distances);
+    neighbors = arma::conv_to<arma::mat>::from(neighborsOut);
 
     delete allknn;
 
     if (queryTree)
       delete queryTree;
   }
-
-  // writing back to matlab
-  // constructing matrix to return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distances.n_rows, distances.n_cols, mxREAL);
-  plhs[1] = mxCreateDoubleMatrix(neighbors.n_rows, neighbors.n_cols, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = distances.n_rows * distances.n_cols; i < n; ++i)
-  {
-    out[i] = distances(i);
-  }
-  out = mxGetPr(plhs[1]);
-  for (int i = 0, n = neighbors.n_rows * neighbors.n_cols; i < n; ++i)
-  {
-    out[i] = neighbors(i);
-  }
-
 }
@@ -5,6 +5,7 @@
  * MEX function for MATLAB EMST binding.
  */
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/emst/dtb.hpp>
@@ -31,22 +32,17 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
 
   const size_t numPoints = mxGetN(prhs[0]);
-  const size_t numDimensions = mxGetM(prhs[0]);
 
-  // Converting from mxArray to armadillo matrix.
-  arma::mat dataPoints(numDimensions, numPoints);
-
-  // Set the values.
-  double* mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataPoints(i) = mexDataPoints[i];
-  }
+  // Use the mxArray as an Armadillo matrix, without a copy.
+  const arma::mat dataPoints(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]),
+      numPoints, false, true);
 
   const bool isBoruvka = (mxGetScalar(prhs[1]) == 1.0);
 
-  // Run the computation.
-  arma::mat result;
+  // Run the computation; the result is written directly into the matrix
+  // returned to MATLAB.
+  arma::mat result(MexOutput(plhs[0], 3, numPoints - 1), 3, numPoints - 1,
+      false, true);
   if (isBoruvka)
   {
     // Get the number of leaves.
@@ -60,13 +56,4 @@ void mexFunction(int nlhs, mxArray *plhs[],
     DualTreeBoruvka<> naive(dataPoints, true);
     naive.ComputeMST(result);
   }
-
-  // Construct matrix to return to MATLAB.
-  plhs[0] = mxCreateDoubleMatrix(3, numPoints - 1, mxREAL);
-
-  double* out = mxGetPr(plhs[0]);
-  for (int i = 0, n = (numPoints - 1) * 3; i < n; ++i)
-  {
-    out[i] = result(i);
-  }
 }
@@ -5,6 +5,7 @@
  * MEX function for MATLAB GMM binding.
  */
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/gmm/gmm.hpp>
@@ -34,15 +35,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
   else
     math::RandomSeed((size_t) std::time(NULL));
 
-  // loading the data
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataPoints(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataPoints(i) = mexDataPoints[i];
-  }
+  // Use the data where it is, without a copy.
+  const size_t numDimensions = mxGetM(prhs[0]);
+  const arma::mat dataPoints(MexInput(prhs[0], "dataset"), numDimensions,
+      mxGetN(prhs[0]), false, true);
 
   int gaussians = (int) mxGetScalar(prhs[1]);
   if (gaussians <= 0)
@@ -79,12 +75,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   mxSetFieldByNumber(plhs[0], 0, 0, field_value);
 
   // mixture weights
-  field_value = mxCreateDoubleMatrix(gmm.Weights().size(), 1, mxREAL);
-  double * values = mxGetPr(field_value);
-  for (int i=0; i<gmm.Weights().size(); ++i)
-  {
-    values[i] = gmm.Weights()[i];
-  }
+  arma::vec weights(MexOutput(field_value, gmm.Weights().n_elem, 1),
+      gmm.Weights().n_elem, false, true);
+  weights = gmm.Weights();
   mxSetFieldByNumber(plhs[0], 0, 1, field_value);
 
   // gaussian mean/variances
@@ -98,32 +91,21 @@ void mexFunction(int nlhs, mxArray *plhs[],
   field_value = mxCreateStructArray(ndim, dims, 2, gaussianNames);
   for (int i=0; i<gmm.Gaussians(); ++i)
   {
-    mxArray * tmp;
-    double * values;
+    // Each parameter is written directly into a new array, which the structure
+    // takes ownership of.
+    mxArray* tmp;
 
     // setting the mean
-    arma::mat mean = gmm.Means()[i];
-    tmp = mxCreateDoubleMatrix(numDimensions, 1, mxREAL);
-    values = mxGetPr(tmp);
-    for (int j = 0; j < numDimensions; ++j)
-    {
-      values[j] = mean(j);
-    }
-    // note: SetField does not copy the data structure.
-    // mxDuplicateArray does the necessary copying.
-    mxSetFieldByNumber(field_value, i, 0, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    arma::vec mean(MexOutput(tmp, numDimensions, 1), numDimensions, false,
+        true);
+    mean = gmm.Means()[i];
+    mxSetFieldByNumber(field_value, i, 0, tmp);
 
     // setting the covariance matrix
-    arma::mat covariance = gmm.Covariances()[i];
-    tmp = mxCreateDoubleMatrix(numDimensions, numDimensions, mxREAL);
-    values = mxGetPr(tmp);
-    for (int j = 0; j < numDimensions * numDimensions; ++j)
-    {
-      values[j] = covariance(j);
-    }
-    mxSetFieldByNumber(field_value, i, 1, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    arma::mat covariance(MexOutput(tmp, numDimensions, numDimensions),
+        numDimensions, numDimensions, false, true);
+    covariance = gmm.Covariances()[i];
+    mxSetFieldByNumber(field_value, i, 1, tmp);
   }
   mxSetFieldByNumber(plhs[0], 0, 2, field_value);
 }
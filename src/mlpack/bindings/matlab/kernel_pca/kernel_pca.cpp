@@ -1,4 +1,5 @@
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/kernels/linear_kernel.hpp>
@@ -34,10 +35,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
   if (mxDOUBLE_CLASS != mxGetClassID(prhs[0]))
     mexErrMsgTxt("Input dataset must have type mxDOUBLE_CLASS.");
 
-  mat dataset(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    dataset(i) = values[i];
+  // The dataset is copied, because kernel PCA transforms it in place.
+  mat dataset(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]), mxGetN(prhs[0]));
 
   // Get the new dimensionality, if it is necessary.
   size_t newDim = dataset.n_rows;
@@ -126,11 +125,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
 
   // Now returning results to matlab
-  plhs[0] = mxCreateDoubleMatrix(dataset.n_rows, dataset.n_cols, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < dataset.n_rows * dataset.n_cols; ++i)
-  {
-    values[i] = dataset(i);
-  }
-
+  mat out(MexOutput(plhs[0], dataset.n_rows, dataset.n_cols), dataset.n_rows,
+      dataset.n_cols, false, true);
+  out = dataset;
 }
@@ -5,6 +5,7 @@
  * MEX function for MATLAB k-means binding.
  */
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/kmeans/kmeans.hpp>
@@ -82,17 +83,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
   */
 
-  // Load our dataset.
-  const size_t numPoints = mxGetN(prhs[0]);
-  const size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataset(numDimensions, numPoints);
-
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataset(i) = mexDataPoints[i];
-  }
+  // Use our dataset where it is, without a copy.
+  const arma::mat dataset(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]),
+      mxGetN(prhs[0]), false, true);
 
   // Now create the KMeans object.  Because we could be using different types,
   // it gets a little weird...
@@ -161,15 +154,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
   */
 
-  // constructing matrix to return to matlab
-  plhs[0] = mxCreateDoubleMatrix(assignments.n_elem, 1, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = assignments.n_elem; i < n; ++i)
-  {
-    out[i] = assignments(i);
-  }
-
+  // Convert the assignments to doubles directly into the matrix returned to
+  // matlab.
+  arma::vec out(MexOutput(plhs[0], assignments.n_elem, 1), assignments.n_elem,
+      false, true);
+  out = arma::conv_to<arma::vec>::from(assignments);
 }
 
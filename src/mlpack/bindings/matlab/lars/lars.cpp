@@ -1,4 +1,5 @@
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 
@@ -27,17 +28,11 @@ void mexFunction(int nlhs, mxArray *plhs[],
   double lambda2 = mxGetScalar(prhs[3]);
   bool useCholesky = (mxGetScalar(prhs[3]) == 1.0);
 
-  // loading covariates
-  mat matX(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    matX(i) = values[i];
-
-  // loading responses
-  mat matY(mxGetM(prhs[1]), mxGetN(prhs[1]));
-  values = mxGetPr(prhs[1]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[1]); i<num; ++i)
-    matY(i) = values[i];
+  // use the covariates and the responses where they are, without a copy
+  const mat matX(MexInput(prhs[0], "covariates"), mxGetM(prhs[0]),
+      mxGetN(prhs[0]), false, true);
+  const mat matY(MexInput(prhs[1], "responses"), mxGetM(prhs[1]),
+      mxGetN(prhs[1]), false, true);
 
   if (matY.n_cols > 1)
     mexErrMsgTxt("Only one column or row allowed in responses file!");
@@ -51,8 +46,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
   lars.Regress(matX, matY.unsafe_col(0), beta, false /* do not transpose */);
 
   // return to matlab
-  plhs[0] = mxCreateDoubleMatrix(beta.n_elem, 1, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < beta.n_elem; ++i)
-    values[i] = beta(i);
+  vec out(MexOutput(plhs[0], beta.n_elem, 1), beta.n_elem, false, true);
+  out = beta;
 }
@@ -0,0 +1,61 @@
+/**
+ * @file mex_matrix.hpp
+ *
+ * Utility functions to pass matrices between MATLAB and Armadillo without
+ * copying them.  MATLAB stores real double matrices in column-major order, as
+ * Armadillo does, so an Armadillo matrix can use the memory of an mxArray
+ * directly, with the auxiliary memory constructor:
+ *
+ * @code
+ * const arma::mat dataset(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]),
+ *     mxGetN(prhs[0]), false, true);
+ * arma::mat result(MexOutput(plhs[0], rows, cols), rows, cols, false, true);
+ * @endcode
+ *
+ * MATLAB may share the memory of an input array between several variables, so
+ * matrices that use the memory of inputs must never be modified.  Matrices that
+ * use the memory of outputs are strict, so they can't be resized; the results
+ * must be computed with their final size.
+ */
+#ifndef MLPACK_BINDINGS_MATLAB_MEX_MATRIX_HPP
+#define MLPACK_BINDINGS_MATLAB_MEX_MATRIX_HPP
+
+#include "mex.h"
+
+#include <mlpack/core.hpp>
+
+/**
+ * Return the memory of an input array, which must be a real, dense double
+ * matrix; a MATLAB error is raised if it is not.  The memory must not be
+ * modified.
+ *
+ * @param array Input array.
+ * @param name Name of the input (for the error message).
+ */
+inline double* MexInput(const mxArray* array, const char* name)
+{
+  if (!mxIsDouble(array) || mxIsComplex(array) || mxIsSparse(array))
+  {
+    std::stringstream ss;
+    ss << "The " << name << " must be a real, dense matrix of doubles.";
+    mexErrMsgTxt(ss.str().c_str());
+  }
+
+  return mxGetPr(array);
+}
+
+/**
+ * Create a real double output array of the given size, and return its memory,
+ * so that the results can be written directly into it.
+ *
+ * @param array Output array to create.
+ * @param rows Number of rows of the output.
+ * @param cols Number of columns of the output.
+ */
+inline double* MexOutput(mxArray*& array, const size_t rows, const size_t cols)
+{
+  array = mxCreateDoubleMatrix(rows, cols, mxREAL);
+  return mxGetPr(array);
+}
+
+#endif
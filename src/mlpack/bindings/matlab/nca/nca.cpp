@@ -1,4 +1,5 @@
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
@@ -25,15 +26,13 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("Output required.");
   }
 
-  // Load data.
-  mat data(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    data(i) = values[i];
+  // Use the data where it is, without a copy.
+  const mat data(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]),
+      mxGetN(prhs[0]), false, true);
 
-  // load labels
+  // load labels (they are converted to integers)
   umat labels(mxGetNumberOfElements(prhs[1]), 1);
-  values = mxGetPr(prhs[1]);
+  const double* values = MexInput(prhs[1], "labels");
   for (int i=0, num=mxGetNumberOfElements(prhs[1]); i<num; ++i)
     labels(i) = (int) values[i];
 
@@ -48,8 +47,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
   nca.LearnDistance(distance);
 
   // return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distance.n_rows, distance.n_cols, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < distance.n_elem; ++i)
-    values[i] = distance(i);
+  mat out(MexOutput(plhs[0], distance.n_rows, distance.n_cols),
+      distance.n_rows, distance.n_cols, false, true);
+  out = distance;
 }
@@ -1,4 +1,5 @@
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 
@@ -63,14 +64,13 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt(ss.str().c_str());
   }
 
-  // Load input dataset.
-  arma::mat V(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    V(i) = values[i];
+  // Use the input dataset where it is, without a copy.
+  const arma::mat V(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]),
+      mxGetN(prhs[0]), false, true);
 
-  arma::mat W;
-  arma::mat H;
+  // The factors are computed directly in the matrices returned to matlab.
+  arma::mat W(MexOutput(plhs[0], V.n_rows, r), V.n_rows, r, false, true);
+  arma::mat H(MexOutput(plhs[1], r, V.n_cols), r, V.n_cols, false, true);
 
   // Perform NMF with the specified update rules.
   if (updateRules == "multdist")
@@ -92,15 +92,4 @@ void mexFunction(int nlhs, mxArray *plhs[],
         HAlternatingLeastSquaresRule> nmf(maxIterations, minResidue);
     nmf.Apply(V, r, W, H);
   }
-
-  // return to matlab
-  plhs[0] = mxCreateDoubleMatrix(W.n_rows, W.n_cols, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < W.n_elem; ++i)
-    values[i] = W(i);
-
-  plhs[1] = mxCreateDoubleMatrix(H.n_rows, H.n_cols, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < H.n_elem; ++i)
-    values[i] = H(i);
 }
@@ -1,4 +1,5 @@
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 
@@ -22,13 +23,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("Output required.");
   }
 
-  // loading the data
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataset(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-    dataset(i) = mexDataPoints[i];
+  // loading the data; it is copied, because PCA transforms it in place
+  arma::mat dataset(MexInput(prhs[0], "dataset"), mxGetM(prhs[0]),
+      mxGetN(prhs[0]));
 
   // Find out what dimension we want.
   size_t newDimension = dataset.n_rows; // No reduction, by default.
@@ -55,8 +52,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
   p.Apply(dataset, newDimension);
 
   // Now returning results to matlab
-  plhs[0] = mxCreateDoubleMatrix(dataset.n_rows, dataset.n_cols, mxREAL);
-  double * values = mxGetPr(plhs[0]);
-  for (int i = 0; i < dataset.n_rows * dataset.n_cols; ++i)
-    values[i] = dataset(i);
+  arma::mat out(MexOutput(plhs[0], dataset.n_rows, dataset.n_cols),
+      dataset.n_rows, dataset.n_cols, false, true);
+  out = dataset;
 }
@@ -5,6 +5,7 @@
  * MEX function for MATLAB range search binding.
  */
 #include "mex.h"
+#include "../mex_matrix.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
@@ -55,17 +56,13 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // checking for query data
   bool hasQueryData = ((mxGetM(prhs[3]) != 0) && (mxGetN(prhs[3]) != 0));
-  arma::mat queryData;
-
-  // setting the dataset values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat referenceData(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+
+  // Use the reference and query points where they are, without a copy (the
+  // query set is empty if there is none).
+  const arma::mat referenceData(MexInput(prhs[0], "reference set"),
+      mxGetM(prhs[0]), mxGetN(prhs[0]), false, true);
+  const arma::mat queryData(MexInput(prhs[3], "query set"), mxGetM(prhs[3]),
+      mxGetN(prhs[3]), false, true);
 
   //if (!data::Load(referenceFile.c_str(), referenceData))
   //  Log::Fatal << "Reference file " << referenceFile << "not found." << endl;
@@ -131,16 +128,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
     //if (!data::Load(queryFile.c_str(), queryData))
     //  Log::Fatal << "Query file " << queryFile << " not found" << endl;
 
-    // setting the values.
-    mexDataPoints = mxGetPr(prhs[3]);
-    numPoints = mxGetN(prhs[3]);
-    numDimensions = mxGetM(prhs[3]);
-    queryData = arma::mat(numDimensions, numPoints);
-    for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-    {
-      queryData(i) = mexDataPoints[i];
-    }
-
     if (naive && leafSize < queryData.n_cols)
       leafSize = queryData.n_cols;
 
@@ -230,7 +217,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   plhs[0] = mxCreateStructArray(ndim, dims, 2, fieldNames);
 
-  // setting the structure elements
+  // setting the structure elements; each one is written directly into a new
+  // array, which the structure takes ownership of
   for (int i=0; i<distancesOut.size(); ++i)
   {
     mxArray * tmp;
@@ -238,27 +226,18 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     // settings the neighbors
     const size_t numElements = distancesOut[i].size();
-    tmp = mxCreateDoubleMatrix(1, numElements, mxREAL);
-    values = mxGetPr(tmp);
+    values = MexOutput(tmp, 1, numElements);
     for (int j=0; j<numElements; ++j)
     {
       // converting to matlab's index offset
       values[j] = neighborsOut[i][j] + 1;
     }
-    // note: SetField does not copy the data structure.
-    // mxDuplicateArray does the necessary copying.
-    mxSetFieldByNumber(plhs[0], i, 0, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    mxSetFieldByNumber(plhs[0], i, 0, tmp);
 
     // setting the distances
-    tmp = mxCreateDoubleMatrix(1, numElements, mxREAL);
-    values = mxGetPr(tmp);
-    for (int j=0; j<numElements; ++j)
-    {
-      values[j] = distancesOut[i][j];
-    }
-    mxSetFieldByNumber(plhs[0], i, 1, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    values = MexOutput(tmp, 1, numElements);
+    std::copy(distancesOut[i].begin(), distancesOut[i].end(), values);
+    mxSetFieldByNumber(plhs[0], i, 1, tmp);
   }
 
   // Clean up.
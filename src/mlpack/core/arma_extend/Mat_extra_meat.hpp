@@ -40,7 +40,12 @@ void Mat<eT>::serialize(Archive& ar, const unsigned int /* version */)
     init_cold();
   }
 
-  ar & make_array(access::rwp(mem), n_elem);
+  // Archives that store raw blocks get the whole memory at once.
+  raw_block_archive* blocks = as_raw_block_archive(ar);
+  if (blocks != NULL)
+    blocks->raw_block((void*) mem, sizeof(eT) * n_elem);
+  else
+    ar & make_array(access::rwp(mem), n_elem);
 }
 
 #if ARMA_VERSION_MAJOR < 4 || \
@@ -38,9 +38,20 @@ void SpMat<eT>::serialize(Archive& ar, const unsigned int /* version */)
     // column pointers, if necessary, so we don't need to worry about them.
   }
 
-  ar & make_array(access::rwp(values), n_nonzero);
-  ar & make_array(access::rwp(row_indices), n_nonzero);
-  ar & make_array(access::rwp(col_ptrs), n_cols + 1);
+  // Archives that store raw blocks get each array at once.
+  raw_block_archive* blocks = as_raw_block_archive(ar);
+  if (blocks != NULL)
+  {
+    blocks->raw_block((void*) values, sizeof(eT) * n_nonzero);
+    blocks->raw_block((void*) row_indices, sizeof(uword) * n_nonzero);
+    blocks->raw_block((void*) col_ptrs, sizeof(uword) * (n_cols + 1));
+  }
+  else
+  {
+    ar & make_array(access::rwp(values), n_nonzero);
+    ar & make_array(access::rwp(row_indices), n_nonzero);
+    ar & make_array(access::rwp(col_ptrs), n_cols + 1);
+  }
 }
 
 #if ARMA_VERSION_MAJOR < 4 || \
@@ -48,6 +48,19 @@
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/array.hpp>
+#include "raw_block_archive.hpp"
+
+// Count the memory of Armadillo objects, if memory accounting is enabled (for
+// Armadillo versions which support alien memory allocators).  The setting comes
+// from arma_config.hpp, so that programs built against mlpack use it too.
+#include <mlpack/core/util/arma_config.hpp>
+#ifdef MLPACK_MEMORY_ACCOUNTING
+  #include <mlpack/core/util/memory_accounting.hpp>
+  #define ARMA_ALIEN_MEM_ALLOC_FUNCTION \
+      mlpack::MemoryAccounting::AllocateArmadillo
+  #define ARMA_ALIEN_MEM_FREE_FUNCTION \
+      mlpack::MemoryAccounting::FreeArmadillo
+#endif
 
 #include <armadillo>
 
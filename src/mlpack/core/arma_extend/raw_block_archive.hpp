@@ -0,0 +1,56 @@
+/**
+ * @file raw_block_archive.hpp
+ *
+ * An interface for boost::serialization archives that store the memory of
+ * Armadillo objects as raw blocks, instead of element by element.  The
+ * serialize() functions of Mat, SpMat and Cube check for it.
+ */
+#ifndef MLPACK_CORE_ARMA_EXTEND_RAW_BLOCK_ARCHIVE_HPP
+#define MLPACK_CORE_ARMA_EXTEND_RAW_BLOCK_ARCHIVE_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+namespace arma {
+
+/**
+ * An archive that also inherits from this class saves (or loads) the memory
+ * of Armadillo objects with raw_block(), so that it can, for instance, be
+ * aligned in the file.
+ */
+class raw_block_archive
+{
+ public:
+  virtual ~raw_block_archive() { }
+
+  //! Save or load the given number of bytes at the given address.
+  virtual void raw_block(void* address, const std::size_t bytes) = 0;
+};
+
+//! Return the archive as a raw_block_archive, or NULL if it isn't one.
+template<typename Archive>
+inline raw_block_archive* as_raw_block_archive(Archive& ar,
+                                               const std::true_type&)
+{
+  return dynamic_cast<raw_block_archive*>(&ar);
+}
+
+//! Archives which have no virtual functions can't be raw_block_archives.
+template<typename Archive>
+inline raw_block_archive* as_raw_block_archive(Archive& /* ar */,
+                                               const std::false_type&)
+{
+  return NULL;
+}
+
+//! Return the archive as a raw_block_archive, or NULL if it isn't one.
+template<typename Archive>
+inline raw_block_archive* as_raw_block_archive(Archive& ar)
+{
+  return as_raw_block_archive(ar,
+      std::integral_constant<bool, std::is_polymorphic<Archive>::value>());
+}
+
+} // namespace arma
+
+#endif
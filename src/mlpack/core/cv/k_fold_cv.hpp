@@ -0,0 +1,169 @@
+/**
+ * @file k_fold_cv.hpp
+ *
+ * Definition of KFoldCV, which evaluates classifiers with k-fold
+ * cross-validation and searches grids of their hyperparameters, training the
+ * folds (and the grid points) in parallel on one shared dataset.
+ */
+#ifndef MLPACK_CORE_CV_K_FOLD_CV_HPP
+#define MLPACK_CORE_CV_K_FOLD_CV_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace cv /** Cross-validation and hyperparameter search. */ {
+
+/**
+ * KFoldCV splits a labeled dataset into k folds of (almost) equal size, and
+ * evaluates a classifier by training it k times, each time on all of the folds
+ * but one, and classifying the points of the remaining fold.  The folds are
+ * only kept as indices into the dataset (as with data::SplitIndices()), so the
+ * dataset is loaded once and never copied as a whole; the training and test
+ * points of a fold are gathered only while the fold is evaluated.
+ *
+ * The classifier is given as a function which trains a model on the given
+ * points and labels and returns it; the model must have a Classify() (or a
+ * Predict()) method taking a matrix of points and an arma::Row<size_t> of
+ * predictions, as most mlpack classifiers do.  So any classifier can be used,
+ * whatever the arguments of its constructor or Train() method:
+ *
+ * @code
+ * KFoldCV<> cv(data, labels, 10);
+ * const double accuracy = cv.Evaluate(
+ *     [&](const arma::mat& trainData, const arma::Row<size_t>& trainLabels)
+ *     {
+ *       return NaiveBayesClassifier<>(trainData, trainLabels, numClasses);
+ *     });
+ * @endcode
+ *
+ * Search() evaluates every point of a grid of hyperparameters this way, and
+ * returns the best one:
+ *
+ * @code
+ * std::vector<double> lambdas = { 0.0, 0.001, 0.01, 0.1, 1.0 };
+ * arma::vec accuracies;
+ * const size_t best = cv.Search(lambdas,
+ *     [](const arma::mat& trainData, const arma::Row<size_t>& trainLabels,
+ *        const double lambda)
+ *     {
+ *       return LogisticRegression<>(trainData, trainLabels, lambda);
+ *     }, accuracies);
+ * @endcode
+ *
+ * All the (grid point, fold) pairs are trained and evaluated concurrently with
+ * ThreadPool::ParallelFor(), so the training function must be safe to call
+ * from several threads at once (parallel loops inside it run serially).
+ *
+ * @tparam MatType Type of the dataset.
+ */
+template<typename MatType = arma::mat>
+class KFoldCV
+{
+ public:
+  /**
+   * Prepare k-fold cross-validation of the given dataset, which must be kept
+   * alive (and unchanged) while the object is used.  A std::invalid_argument
+   * is thrown if k is less than 2 or greater than the number of points, or if
+   * there is not one label per point.
+   *
+   * @param data Dataset (one point per column).
+   * @param labels Labels of the points.
+   * @param k Number of folds.
+   * @param shuffle Whether the points are shuffled before being split into
+   *     folds (otherwise, each fold is a contiguous range of points).
+   */
+  KFoldCV(const MatType& data,
+          const arma::Row<size_t>& labels,
+          const size_t k,
+          const bool shuffle = true);
+
+  /**
+   * Train a model on each fold with the given function, and return the
+   * accuracy of the predictions of the models: the fraction of the points of
+   * the dataset that are classified correctly by the model which wasn't
+   * trained on them.
+   *
+   * @param train Function taking the training points and labels of a fold,
+   *     and returning a trained model.
+   */
+  template<typename TrainFunctionType>
+  double Evaluate(TrainFunctionType train) const;
+
+  /**
+   * Train a model on each fold with the given function, and store the
+   * accuracy on each fold.
+   *
+   * @param train Function taking the training points and labels of a fold,
+   *     and returning a trained model.
+   * @param accuracies Accuracy on each fold.
+   */
+  template<typename TrainFunctionType>
+  void EvaluateFolds(TrainFunctionType train, arma::vec& accuracies) const;
+
+  /**
+   * Evaluate each point of the given grid of hyperparameters (as Evaluate()
+   * does), and return the index of the best one (the first one, if several
+   * are as good).
+   *
+   * @param grid Hyperparameters to evaluate (any type, such as a double or a
+   *     std::tuple of several hyperparameters).
+   * @param train Function taking the training points and labels of a fold and
+   *     the hyperparameters, and returning a trained model.
+   * @param accuracies Accuracy of each point of the grid.
+   */
+  template<typename ParamType, typename TrainFunctionType>
+  size_t Search(const std::vector<ParamType>& grid,
+                TrainFunctionType train,
+                arma::vec& accuracies) const;
+
+  /**
+   * Get the indices of the training points and of the test points of the
+   * given fold.
+   *
+   * @param fold Index of the fold.
+   * @param trainIndices Indices of the training points.
+   * @param testIndices Indices of the test points.
+   */
+  void Indices(const size_t fold,
+               arma::uvec& trainIndices,
+               arma::uvec& testIndices) const;
+
+  //! Get the number of folds.
+  size_t K() const { return k; }
+
+ private:
+  /**
+   * Train a model on the given fold with the given function (called with the
+   * training points and labels, and the given extra arguments), and return the
+   * number of test points it classifies correctly.
+   */
+  template<typename TrainFunctionType, typename... Args>
+  size_t Correct(const size_t fold,
+                 TrainFunctionType& train,
+                 const Args&... args) const;
+
+  /**
+   * Run the given function for each of the given number of tasks in parallel,
+   * and rethrow the first exception thrown by a task, if any.
+   */
+  template<typename FunctionType>
+  static void ParallelTasks(const size_t tasks, FunctionType function);
+
+  //! The dataset.
+  const MatType& data;
+  //! The labels of the points.
+  const arma::Row<size_t>& labels;
+  //! The number of folds.
+  size_t k;
+  //! The points in the order of the folds: fold f is the range
+  //! [f * n / k, (f + 1) * n / k) of this order.
+  arma::uvec order;
+};
+
+} // namespace cv
+} // namespace mlpack
+
+// Include implementation.
+#include "k_fold_cv_impl.hpp"
+
+#endif
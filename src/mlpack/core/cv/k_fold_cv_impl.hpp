@@ -0,0 +1,206 @@
+/**
+ * @file k_fold_cv_impl.hpp
+ *
+ * Implementation of KFoldCV.
+ */
+#ifndef MLPACK_CORE_CV_K_FOLD_CV_IMPL_HPP
+#define MLPACK_CORE_CV_K_FOLD_CV_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "k_fold_cv.hpp"
+
+#include <exception>
+#include <mutex>
+
+namespace mlpack {
+namespace cv {
+
+//! Classify the given points with a model that has a Classify() method.
+template<typename ModelType, typename MatType>
+auto ClassifyPoints(ModelType& model,
+                    const MatType& points,
+                    arma::Row<size_t>& predictions,
+                    const int /* preferred */)
+    -> decltype(model.Classify(points, predictions), void())
+{
+  model.Classify(points, predictions);
+}
+
+//! Classify the given points with a model that only has a Predict() method.
+template<typename ModelType, typename MatType>
+void ClassifyPoints(ModelType& model,
+                    const MatType& points,
+                    arma::Row<size_t>& predictions,
+                    const long /* fallback */)
+{
+  model.Predict(points, predictions);
+}
+
+template<typename MatType>
+KFoldCV<MatType>::KFoldCV(const MatType& data,
+                          const arma::Row<size_t>& labels,
+                          const size_t k,
+                          const bool shuffle) :
+    data(data),
+    labels(labels),
+    k(k)
+{
+  if (labels.n_elem != data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KFoldCV::KFoldCV(): the dataset has " << data.n_cols << " points "
+        << "but there are " << labels.n_elem << " labels";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (k < 2 || k > data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KFoldCV::KFoldCV(): the number of folds must be between 2 and the "
+        << "number of points (" << data.n_cols << "), not " << k;
+    throw std::invalid_argument(oss.str());
+  }
+
+  order = arma::linspace<arma::uvec>(0, data.n_cols - 1, data.n_cols);
+  if (shuffle)
+    order = arma::shuffle(order);
+}
+
+template<typename MatType>
+template<typename TrainFunctionType>
+double KFoldCV<MatType>::Evaluate(TrainFunctionType train) const
+{
+  std::vector<size_t> correct(k);
+  ParallelTasks(k, [&](const size_t fold)
+  {
+    correct[fold] = Correct(fold, train);
+  });
+
+  size_t total = 0;
+  for (size_t fold = 0; fold < k; ++fold)
+    total += correct[fold];
+
+  return (double) total / (double) data.n_cols;
+}
+
+template<typename MatType>
+template<typename TrainFunctionType>
+void KFoldCV<MatType>::EvaluateFolds(TrainFunctionType train,
+                                     arma::vec& accuracies) const
+{
+  accuracies.set_size(k);
+  ParallelTasks(k, [&](const size_t fold)
+  {
+    const size_t begin = fold * data.n_cols / k;
+    const size_t end = (fold + 1) * data.n_cols / k;
+    accuracies[fold] = (double) Correct(fold, train) / (double) (end - begin);
+  });
+}
+
+template<typename MatType>
+template<typename ParamType, typename TrainFunctionType>
+size_t KFoldCV<MatType>::Search(const std::vector<ParamType>& grid,
+                                TrainFunctionType train,
+                                arma::vec& accuracies) const
+{
+  if (grid.empty())
+    throw std::invalid_argument("KFoldCV::Search(): the grid is empty");
+
+  // Every fold of every grid point is a separate task, so that all of the
+  // threads are busy even when there are fewer folds than threads.
+  arma::Mat<size_t> correct(k, grid.size());
+  ParallelTasks(k * grid.size(), [&](const size_t task)
+  {
+    const size_t fold = task % k;
+    const size_t point = task / k;
+    correct(fold, point) = Correct(fold, train, grid[point]);
+  });
+
+  accuracies.set_size(grid.size());
+  size_t best = 0;
+  for (size_t i = 0; i < grid.size(); ++i)
+  {
+    accuracies[i] = (double) arma::accu(correct.col(i)) / (double) data.n_cols;
+    if (accuracies[i] > accuracies[best])
+      best = i;
+  }
+
+  Log::Info << "KFoldCV::Search(): best accuracy " << accuracies[best]
+      << " with grid point " << best << " of " << grid.size() << "."
+      << std::endl;
+
+  return best;
+}
+
+template<typename MatType>
+void KFoldCV<MatType>::Indices(const size_t fold,
+                               arma::uvec& trainIndices,
+                               arma::uvec& testIndices) const
+{
+  const size_t begin = fold * data.n_cols / k;
+  const size_t end = (fold + 1) * data.n_cols / k;
+
+  testIndices = order.subvec(begin, end - 1);
+  trainIndices.set_size(data.n_cols - (end - begin));
+  if (begin > 0)
+    trainIndices.subvec(0, begin - 1) = order.subvec(0, begin - 1);
+  if (end < data.n_cols)
+    trainIndices.subvec(begin, trainIndices.n_elem - 1) =
+        order.subvec(end, data.n_cols - 1);
+}
+
+template<typename MatType>
+template<typename TrainFunctionType, typename... Args>
+size_t KFoldCV<MatType>::Correct(const size_t fold,
+                                 TrainFunctionType& train,
+                                 const Args&... args) const
+{
+  arma::uvec trainIndices, testIndices;
+  Indices(fold, trainIndices, testIndices);
+
+  // Only the points of this fold are gathered, and the training points are
+  // released before the test points are gathered.
+  MatType trainData = data.cols(trainIndices);
+  arma::Row<size_t> trainLabels = labels.cols(trainIndices);
+  auto model = train(trainData, trainLabels, args...);
+  trainData.reset();
+  trainLabels.reset();
+
+  const MatType testData = data.cols(testIndices);
+  arma::Row<size_t> predictions;
+  ClassifyPoints(model, testData, predictions, 0);
+
+  return (size_t) arma::accu(predictions == labels.cols(testIndices));
+}
+
+template<typename MatType>
+template<typename FunctionType>
+void KFoldCV<MatType>::ParallelTasks(const size_t tasks,
+                                     FunctionType function)
+{
+  // Exceptions can't leave a parallel loop, so the first one is kept and
+  // rethrown afterwards.
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  ThreadPool::ParallelFor(0, tasks, [&](const size_t task)
+  {
+    try
+    {
+      function(task);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error)
+        error = std::current_exception();
+    }
+  });
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+} // namespace cv
+} // namespace mlpack
+
+#endif
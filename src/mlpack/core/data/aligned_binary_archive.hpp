@@ -0,0 +1,110 @@
+/**
+ * @file aligned_binary_archive.hpp
+ *
+ * Definition of the AlignedBinaryOArchive and AlignedBinaryIArchive classes,
+ * Boost binary archives which store the memory of Armadillo matrices, sparse
+ * matrices and cubes as raw blocks aligned to 64 bytes in the file.  Models
+ * saved in this format (.mlmodel) can be loaded at disk speed, and their
+ * matrices could be memory-mapped.
+ */
+#ifndef MLPACK_CORE_DATA_ALIGNED_BINARY_ARCHIVE_HPP
+#define MLPACK_CORE_DATA_ALIGNED_BINARY_ARCHIVE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
+namespace mlpack {
+namespace data {
+
+//! The alignment of the raw blocks of an aligned binary archive, in bytes.
+const size_t rawBlockAlignment = 64;
+
+/**
+ * A boost::archive::binary_oarchive that writes each matrix payload as a raw
+ * block, starting at a multiple of 64 bytes from the start of the stream, with
+ * zero padding in front of it.  The archive is read with an
+ * AlignedBinaryIArchive.  Everything else (and serialization code) is shared
+ * with boost::archive::binary_oarchive.
+ */
+class AlignedBinaryOArchive : public boost::archive::binary_oarchive,
+                              public arma::raw_block_archive
+{
+ public:
+  /**
+   * Create the archive, writing to the given stream, which must support
+   * tellp() (a file or string stream).
+   */
+  AlignedBinaryOArchive(std::ostream& stream) :
+      boost::archive::binary_oarchive(stream),
+      stream(stream)
+  { }
+
+  //! Write the given block, preceded by padding to align it.
+  void raw_block(void* address, const std::size_t bytes)
+  {
+    if (bytes == 0)
+      return;
+
+    const std::streamoff position = stream.rdbuf()->pubseekoff(0,
+        std::ios_base::cur, std::ios_base::out);
+    if (position < 0)
+      throw std::runtime_error("cannot find the position in the stream");
+
+    const char padding[rawBlockAlignment] = { 0 };
+    const size_t paddingSize = (rawBlockAlignment - (size_t) position %
+        rawBlockAlignment) % rawBlockAlignment;
+    save_binary(padding, paddingSize);
+    save_binary(address, bytes);
+  }
+
+ private:
+  //! The stream the archive writes to.
+  std::ostream& stream;
+};
+
+/**
+ * A boost::archive::binary_iarchive that reads the archives written by
+ * AlignedBinaryOArchive, reading each matrix payload directly into the memory
+ * of the matrix.
+ */
+class AlignedBinaryIArchive : public boost::archive::binary_iarchive,
+                              public arma::raw_block_archive
+{
+ public:
+  /**
+   * Create the archive, reading from the given stream, which must support
+   * tellg() (a file or string stream).
+   */
+  AlignedBinaryIArchive(std::istream& stream) :
+      boost::archive::binary_iarchive(stream),
+      stream(stream)
+  { }
+
+  //! Skip the padding in front of the given block, then read it.
+  void raw_block(void* address, const std::size_t bytes)
+  {
+    if (bytes == 0)
+      return;
+
+    const std::streamoff position = stream.rdbuf()->pubseekoff(0,
+        std::ios_base::cur, std::ios_base::in);
+    if (position < 0)
+      throw std::runtime_error("cannot find the position in the stream");
+
+    char padding[rawBlockAlignment];
+    const size_t paddingSize = (rawBlockAlignment - (size_t) position %
+        rawBlockAlignment) % rawBlockAlignment;
+    load_binary(padding, paddingSize);
+    load_binary(address, bytes);
+  }
+
+ private:
+  //! The stream the archive reads from.
+  std::istream& stream;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
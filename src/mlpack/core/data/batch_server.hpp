@@ -0,0 +1,114 @@
+/**
+ * @file batch_server.hpp
+ *
+ * Definition of the BatchServer class, which reads batches of points and
+ * writes the results computed for them over a pair of streams, so that a
+ * program can load its model once and then answer many batches.
+ */
+#ifndef MLPACK_CORE_DATA_BATCH_SERVER_HPP
+#define MLPACK_CORE_DATA_BATCH_SERVER_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <istream>
+#include <ostream>
+
+#include "native_binary.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The BatchServer class implements a simple protocol to answer batches of
+ * points over a pair of streams (usually the standard input and output of a
+ * program).  Each request is one matrix in the native binary format (see
+ * NativeBinaryHeader), whose header gives its size, so no other framing is
+ * needed; each response is one or more matrices in the same format, in an
+ * order that is fixed by the program.  The stream is flushed after each
+ * response, so that a client can wait for the response before it sends the
+ * next request.  The server stops when the input ends between two requests.
+ *
+ * @code
+ * data::BatchServer<double> server(std::cin, std::cout);
+ * arma::mat batch;
+ * while (server.Next(batch))
+ * {
+ *   arma::vec results = ...;
+ *   server.Reply(results);
+ *   server.Flush();
+ * }
+ * @endcode
+ *
+ * @tparam eT Type of element of the request matrices.
+ */
+template<typename eT>
+class BatchServer
+{
+ public:
+  /**
+   * Create the server on the given streams, which should be opened in binary
+   * mode.
+   *
+   * @param in Stream to read the requests from.
+   * @param out Stream to write the responses to.
+   * @param name Name of the input stream (for error messages).
+   */
+  BatchServer(std::istream& in,
+              std::ostream& out,
+              const std::string& name = "standard input") :
+      in(in),
+      out(out),
+      name(name),
+      batches(0)
+  { }
+
+  /**
+   * Read the next request into the given matrix.  Returns false if the input
+   * ended instead; a std::runtime_error is thrown if the request is not a
+   * valid native binary matrix of type eT, or is truncated.
+   *
+   * @param batch Matrix to read the request into.
+   * @return Whether a request was read.
+   */
+  bool Next(arma::Mat<eT>& batch)
+  {
+    if (in.peek() == std::char_traits<char>::eof())
+      return false;
+
+    LoadNativeBinary(in, name, batch);
+    ++batches;
+    return true;
+  }
+
+  /**
+   * Write one matrix of the response to the current request.  A
+   * std::runtime_error is thrown if it can't be written.
+   *
+   * @param matrix Matrix to write.
+   */
+  template<typename ReplyElemType>
+  void Reply(const arma::Mat<ReplyElemType>& matrix)
+  {
+    SaveNativeBinary(out, "the response stream", matrix);
+  }
+
+  //! Finish the response to the current request, and flush it to the client.
+  void Flush() { out.flush(); }
+
+  //! Get the number of requests read so far.
+  size_t Batches() const { return batches; }
+
+ private:
+  //! The stream the requests are read from.
+  std::istream& in;
+  //! The stream the responses are written to.
+  std::ostream& out;
+  //! The name of the input stream.
+  std::string name;
+  //! The number of requests read so far.
+  size_t batches;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,807 @@
+/**
+ * @file chunked_io.hpp
+ *
+ * Definition of the ChunkedLoader and ChunkedSaver classes, which read and
+ * write datasets a fixed number of points at a time, so that datasets that
+ * don't fit in memory can be processed in chunks.
+ */
+#ifndef MLPACK_CORE_DATA_CHUNKED_IO_HPP
+#define MLPACK_CORE_DATA_CHUNKED_IO_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/tokenizer.hpp>
+
+#include "extension.hpp"
+#include "dataset_info.hpp"
+#include "load_arff.hpp"
+#include "load_text.hpp"
+#include "save_text.hpp"
+#include "native_binary.hpp"
+#include "hdf5_dataset.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The ChunkedLoader class reads a dataset a given number of points at a time,
+ * so that datasets larger than memory can be processed in bounded memory.  The
+ * supported formats are:
+ *
+ *  - CSV or whitespace-separated text (.csv, .tsv, .txt), as read by
+ *    data::Load(); each line is one point, and empty lines are skipped;
+ *  - ARFF (.arff), as read by data::Load() with a DatasetInfo (sparse data is
+ *    not supported);
+ *  - Armadillo binary (.bin) files of doubles or floats, as written by
+ *    data::Save(); each row of the matrix in the file is one point;
+ *  - mlpack native binary (.mlbin) files of doubles or floats, whose chunks
+ *    are read with a single contiguous read;
+ *  - HDF5 (.h5, .hdf5, .hdf, .he5) files, if mlpack was built with HDF5
+ *    support; each chunk is read as one hyperslab of a two-dimensional
+ *    dataset (see HDF5Dataset), named "dataset" (as written by data::Save())
+ *    unless the dataset constructor is used, which can also restrict the
+ *    points to a range.  If the dataset is stored in HDF5 chunks and maxPoints
+ *    is at least the number of points per HDF5 chunk, chunks end on HDF5 chunk
+ *    boundaries, so that no HDF5 chunk is read twice; such chunks may hold
+ *    fewer than maxPoints points.
+ *
+ * Each point is one column of the returned matrix.
+ *
+ * Categorical dimensions are mapped with a single DatasetInfo (Info()) for the
+ * whole file, so the mappings are consistent across chunks (and across
+ * Reset()).  The types of the dimensions come from the ARFF header, from the
+ * DatasetInfo stored in a native binary file, or from the DatasetInfo given to
+ * the constructor (for instance, the one of a training set).  Otherwise, for
+ * text files, they are deduced from the first chunk: a dimension is
+ * categorical if any of its values in the first chunk is not a number.  Binary
+ * files without a DatasetInfo are all numeric.
+ *
+ * @code
+ * data::ChunkedLoader<double> loader("queries.csv");
+ * arma::mat chunk;
+ * while (loader.Next(chunk, 10000))
+ * {
+ *   // Process chunk...
+ * }
+ * @endcode
+ *
+ * Reset() starts again from the first point, so a file can be read several
+ * times without keeping it in memory.
+ *
+ * @tparam eT Type of element in the loaded matrix.
+ */
+template<typename eT>
+class ChunkedLoader
+{
+ public:
+  /**
+   * Open the given file.  A std::runtime_error is thrown if the file can't be
+   * opened or has an unsupported format, and a std::invalid_argument if the
+   * given DatasetInfo doesn't have the dimensionality of an ARFF or binary
+   * file.
+   *
+   * @param filename Name of the file to read.
+   * @param info DatasetInfo to map categorical dimensions with; if it is
+   *     empty (the default), the types of the dimensions are found from the
+   *     file.
+   */
+  ChunkedLoader(const std::string& filename,
+                const DatasetInfo& info = DatasetInfo()) :
+      filename(filename),
+      info(info),
+      elementType(0),
+      dimensionality(info.Dimensionality()),
+      numPoints(0),
+      dataStart(0),
+      linesInHeader(0),
+      linesRead(0),
+      pointsRead(0),
+      firstPoint(0)
+  {
+    const std::string extension = Extension(filename);
+    if (IsHDF5Extension(extension))
+    {
+      OpenHDF5("dataset", 0, 0);
+      return;
+    }
+
+    if (extension == "csv" || extension == "tsv" || extension == "txt")
+      format = FileFormat::text;
+    else if (extension == "arff")
+      format = FileFormat::arff;
+    else if (extension == "bin")
+      format = FileFormat::armaBinary;
+    else if (extension == "mlbin")
+      format = FileFormat::nativeBinary;
+    else
+      throw std::runtime_error("ChunkedLoader: '" + filename + "' is not a "
+          "text (.csv, .tsv or .txt), ARFF (.arff), Armadillo binary (.bin), "
+          "mlpack native binary (.mlbin) or HDF5 (.h5, .hdf5, .hdf or .he5) "
+          "file");
+
+    const bool binary = (format == FileFormat::armaBinary ||
+        format == FileFormat::nativeBinary);
+    stream.open(filename.c_str(), binary ? std::fstream::in |
+        std::fstream::binary : std::fstream::in);
+    if (!stream.is_open())
+      throw std::runtime_error("ChunkedLoader: cannot open '" + filename +
+          "'");
+
+    if (format == FileFormat::arff)
+    {
+      std::vector<bool> types;
+      try
+      {
+        ReadARFFHeader(stream, dimensionality, types, linesRead);
+      }
+      catch (std::exception& e)
+      {
+        throw std::runtime_error("ChunkedLoader: cannot read the header of '" +
+            filename + "': " + e.what());
+      }
+
+      linesInHeader = linesRead;
+      SetInfo(dimensionality);
+      for (size_t i = 0; i < types.size(); ++i)
+      {
+        this->info.Type(i) = types[i] ? Datatype::categorical :
+            Datatype::numeric;
+      }
+    }
+    else if (format == FileFormat::armaBinary)
+    {
+      // The header is 'ARMA_MAT_BIN_FN008' (doubles) or 'ARMA_MAT_BIN_FN004'
+      // (floats), then the number of rows (points) and columns (dimensions).
+      std::string header;
+      stream >> header >> numPoints >> dimensionality;
+      if (header == "ARMA_MAT_BIN_FN008")
+        elementType = NativeBinaryElementType<double>();
+      else if (header == "ARMA_MAT_BIN_FN004")
+        elementType = NativeBinaryElementType<float>();
+      else
+        throw std::runtime_error("ChunkedLoader: '" + filename + "' is not an "
+            "Armadillo binary file of doubles or floats");
+
+      if (!stream.good())
+        throw std::runtime_error("ChunkedLoader: cannot read the header of '" +
+            filename + "'");
+
+      stream.get(); // Skip the newline after the header.
+      SetInfo(dimensionality);
+    }
+    else if (format == FileFormat::nativeBinary)
+    {
+      NativeBinaryHeader header;
+      stream.read((char*) &header, sizeof(NativeBinaryHeader));
+      if (!stream.good())
+        throw std::runtime_error("ChunkedLoader: cannot read the header of '" +
+            filename + "'");
+
+      // The points are stored column-major, as in memory.
+      elementType = header.elementType;
+      try
+      {
+        if (elementType == NativeBinaryElementType<float>())
+          CheckNativeBinaryHeader<float>(header, filename);
+        else
+          CheckNativeBinaryHeader<double>(header, filename);
+      }
+      catch (std::runtime_error& e)
+      {
+        throw std::runtime_error(std::string("ChunkedLoader: ") + e.what());
+      }
+
+      dimensionality = header.rows;
+      numPoints = header.cols;
+      if (header.infoSize > 0 && this->info.Dimensionality() == 0)
+      {
+        std::string serializedInfo(header.infoSize, '\0');
+        stream.read(&serializedInfo[0], header.infoSize);
+        ReadNativeBinaryInfo(serializedInfo, this->info);
+      }
+      SetInfo(dimensionality);
+      stream.seekg(header.dataOffset);
+    }
+
+    dataStart = stream.tellg();
+  }
+
+  /**
+   * Open the given dataset of the given HDF5 file, to read the given range of
+   * its points.  A std::runtime_error is thrown if the dataset can't be
+   * opened, if the range is not within the dataset, or if mlpack was not built
+   * with HDF5 support, and a std::invalid_argument if the given DatasetInfo
+   * doesn't have the dimensionality of the dataset.
+   *
+   * @param filename Name of the HDF5 file to read.
+   * @param dataset Name of the two-dimensional dataset to read.
+   * @param firstPoint Index of the first point to read.
+   * @param rangePoints Number of points to read (0, the default, reads every
+   *     point from firstPoint on).
+   * @param info DatasetInfo to map categorical dimensions with; if it is
+   *     empty (the default), every dimension is numeric.
+   */
+  ChunkedLoader(const std::string& filename,
+                const std::string& dataset,
+                const size_t firstPoint = 0,
+                const size_t rangePoints = 0,
+                const DatasetInfo& info = DatasetInfo()) :
+      filename(filename),
+      info(info),
+      elementType(0),
+      dimensionality(info.Dimensionality()),
+      numPoints(0),
+      dataStart(0),
+      linesInHeader(0),
+      linesRead(0),
+      pointsRead(0),
+      firstPoint(0)
+  {
+    OpenHDF5(dataset, firstPoint, rangePoints);
+  }
+
+  /**
+   * Read the next points (at most maxPoints of them) into the given matrix, and
+   * return whether any points were read.  A std::runtime_error is thrown if
+   * a line can't be parsed, has a different number of values than the
+   * previous lines, or has a value which is not a number in a numeric
+   * dimension, or if a binary file is truncated.
+   *
+   * @param chunk Matrix to store the points in.
+   * @param maxPoints Maximum number of points to read.
+   */
+  bool Next(arma::Mat<eT>& chunk, const size_t maxPoints)
+  {
+    if (maxPoints == 0)
+      throw std::invalid_argument("ChunkedLoader::Next(): maxPoints must be "
+          "greater than 0");
+
+    if (format == FileFormat::armaBinary || format == FileFormat::nativeBinary)
+      return NextBinary(chunk, maxPoints);
+    else if (format == FileFormat::hdf5)
+      return NextHDF5(chunk, maxPoints);
+
+    // Split the lines of this chunk into fields.  ARFF data and lines with
+    // commas are comma-separated (with quotes, as in data::Load()); other lines
+    // are whitespace-separated.
+    typedef boost::tokenizer<boost::escaped_list_separator<char>> Tokenizer;
+    const boost::escaped_list_separator<char> separator("\\", ",", "\"");
+    std::vector<std::vector<std::string>> points;
+    std::vector<size_t> lines;
+    std::string line;
+    while (points.size() < maxPoints && std::getline(stream, line))
+    {
+      ++linesRead;
+      boost::trim(line);
+      if (line.empty() || (format == FileFormat::arff && line[0] == '%'))
+        continue;
+
+      if (format == FileFormat::arff && line[0] == '{')
+        throw std::runtime_error("ChunkedLoader: '" + filename + "' holds "
+            "sparse ARFF data, which is not supported");
+
+      std::vector<std::string> fields;
+      if (format == FileFormat::arff || line.find(',') != std::string::npos)
+      {
+        Tokenizer tokenizer(line, separator);
+        for (Tokenizer::iterator it = tokenizer.begin();
+             it != tokenizer.end(); ++it)
+        {
+          fields.push_back(boost::trim_copy(*it));
+        }
+      }
+      else
+      {
+        boost::split(fields, line, boost::is_any_of(" \t"),
+            boost::token_compress_on);
+      }
+
+      points.push_back(std::move(fields));
+      lines.push_back(linesRead);
+    }
+
+    if (points.empty())
+    {
+      chunk.reset();
+      return false;
+    }
+
+    // Deduce the types of the dimensions of a text file from the first chunk.
+    if (dimensionality == 0)
+    {
+      dimensionality = points[0].size();
+      SetInfo(dimensionality);
+      for (size_t d = 0; d < dimensionality; ++d)
+      {
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+          if (points[i].size() == dimensionality && !IsNumber(points[i][d]))
+          {
+            info.Type(d) = Datatype::categorical;
+            break;
+          }
+        }
+      }
+    }
+
+    chunk.set_size(dimensionality, points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      if (points[i].size() != dimensionality)
+      {
+        std::ostringstream oss;
+        oss << "ChunkedLoader: line " << lines[i] << " of '" << filename
+            << "' has " << points[i].size() << " values, but the points have "
+            << "dimensionality " << dimensionality;
+        throw std::runtime_error(oss.str());
+      }
+
+      for (size_t d = 0; d < dimensionality; ++d)
+      {
+        const std::string& field = points[i][d];
+        if (info.Type(d) == Datatype::categorical)
+        {
+          chunk(d, i) = (eT) info.MapString(field, d);
+          continue;
+        }
+
+        // As in data::Load(), empty numeric values are zero.
+        double value = 0.0;
+        if (!field.empty() &&
+            !ParseNumber(field.data(), field.data() + field.size(), value))
+        {
+          std::ostringstream oss;
+          oss << "ChunkedLoader: value '" << field << "' on line " << lines[i]
+              << " of '" << filename << "' is not a number, but dimension "
+              << d << " is numeric";
+          throw std::runtime_error(oss.str());
+        }
+        chunk(d, i) = (eT) value;
+      }
+    }
+
+    pointsRead += points.size();
+    return true;
+  }
+
+  /**
+   * Go back to the first point of the file.  The mappings of Info() are kept.
+   */
+  void Reset()
+  {
+    stream.clear();
+    stream.seekg(dataStart);
+    linesRead = linesInHeader;
+    pointsRead = 0;
+  }
+
+  //! Get the number of points read so far.
+  size_t PointsRead() const { return pointsRead; }
+
+  //! Get the DatasetInfo mapping the categorical dimensions.  For text files
+  //! without a given DatasetInfo, it is only set after the first chunk.
+  const DatasetInfo& Info() const { return info; }
+
+ private:
+  //! The formats that can be read.
+  enum class FileFormat { text, arff, armaBinary, nativeBinary, hdf5 };
+
+  //! Return whether the given extension denotes an HDF5 file.
+  static bool IsHDF5Extension(const std::string& extension)
+  {
+    return (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
+        extension == "he5");
+  }
+
+  /**
+   * Open the given dataset of the HDF5 file, to read rangePoints points from
+   * firstPoint on (or every point from firstPoint on if rangePoints is 0).
+   */
+  void OpenHDF5(const std::string& dataset,
+                const size_t first,
+                const size_t rangePoints)
+  {
+    format = FileFormat::hdf5;
+#ifdef HAS_HDF5
+    try
+    {
+      hdf5.reset(new HDF5Dataset(filename, dataset));
+    }
+    catch (std::runtime_error& e)
+    {
+      throw std::runtime_error(std::string("ChunkedLoader: ") + e.what());
+    }
+
+    if (first > hdf5->Points() ||
+        (rangePoints > 0 && first + rangePoints > hdf5->Points()))
+    {
+      std::ostringstream oss;
+      oss << "ChunkedLoader: cannot read points " << first << " to "
+          << (first + rangePoints) << " of dataset '" << dataset << "' of '"
+          << filename << "', which has " << hdf5->Points() << " points";
+      throw std::runtime_error(oss.str());
+    }
+
+    firstPoint = first;
+    numPoints = (rangePoints > 0) ? rangePoints : hdf5->Points() - first;
+    dimensionality = hdf5->Dimensionality();
+    SetInfo(dimensionality);
+#else
+    (void) dataset;
+    (void) first;
+    (void) rangePoints;
+    throw std::runtime_error("ChunkedLoader: cannot read '" + filename + "': "
+        "mlpack was not compiled with HDF5 support");
+#endif
+  }
+
+  /**
+   * Read the next points of an HDF5 dataset as one hyperslab.  If the dataset
+   * is stored in HDF5 chunks no larger than maxPoints points, the hyperslab is
+   * shortened to end on an HDF5 chunk boundary, so that each HDF5 chunk is read
+   * by a single call.
+   */
+  bool NextHDF5(arma::Mat<eT>& chunk, const size_t maxPoints)
+  {
+    size_t numChunkPoints = std::min(maxPoints, numPoints - pointsRead);
+    if (numChunkPoints == 0)
+    {
+      chunk.reset();
+      return false;
+    }
+
+#ifdef HAS_HDF5
+    const size_t start = firstPoint + pointsRead;
+    const size_t chunkPoints = hdf5->ChunkPoints();
+    if (chunkPoints > 0 && maxPoints >= chunkPoints &&
+        pointsRead + numChunkPoints < numPoints)
+    {
+      const size_t end = (start + numChunkPoints) / chunkPoints * chunkPoints;
+      if (end > start)
+        numChunkPoints = end - start;
+    }
+
+    try
+    {
+      hdf5->Read(chunk, start, numChunkPoints);
+    }
+    catch (std::runtime_error& e)
+    {
+      throw std::runtime_error(std::string("ChunkedLoader: ") + e.what());
+    }
+#endif
+
+    pointsRead += numChunkPoints;
+    return true;
+  }
+
+  //! Return whether the given field of a text file is a number (empty fields
+  //! count as zeros).
+  static bool IsNumber(const std::string& field)
+  {
+    double value;
+    return field.empty() ||
+        ParseNumber(field.data(), field.data() + field.size(), value);
+  }
+
+  /**
+   * Check that the DatasetInfo has the given dimensionality, or make it an
+   * all-numeric DatasetInfo of that dimensionality if it is empty.
+   */
+  void SetInfo(const size_t fileDimensionality)
+  {
+    if (info.Dimensionality() == 0)
+    {
+      info = DatasetInfo(fileDimensionality);
+    }
+    else if (info.Dimensionality() != fileDimensionality)
+    {
+      std::ostringstream oss;
+      oss << "ChunkedLoader: given DatasetInfo has dimensionality "
+          << info.Dimensionality() << ", but '" << filename << "' has "
+          << "dimensionality " << fileDimensionality;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  /**
+   * Read the next points of a binary file.  Armadillo binary files hold a
+   * column-major matrix with one point per row, so each dimension of the chunk
+   * is one contiguous read; native binary files hold one point per column, so
+   * the whole chunk is one contiguous read.
+   */
+  bool NextBinary(arma::Mat<eT>& chunk, const size_t maxPoints)
+  {
+    const size_t numChunkPoints = std::min(maxPoints, numPoints - pointsRead);
+    if (numChunkPoints == 0)
+    {
+      chunk.reset();
+      return false;
+    }
+
+    chunk.set_size(dimensionality, numChunkPoints);
+    const size_t elementSize = elementType % 256;
+    const bool sameType = (elementType == NativeBinaryElementType<eT>());
+    const bool doubleElements = (elementType ==
+        NativeBinaryElementType<double>());
+
+    if (format == FileFormat::nativeBinary)
+    {
+      stream.seekg(dataStart + std::streamoff(pointsRead * dimensionality *
+          elementSize));
+      if (sameType)
+      {
+        // Read straight into the chunk.
+        stream.read((char*) chunk.memptr(),
+            std::streamsize(chunk.n_elem * elementSize));
+      }
+      else
+      {
+        std::vector<char> buffer(chunk.n_elem * elementSize);
+        stream.read(buffer.data(), std::streamsize(buffer.size()));
+        for (size_t i = 0; i < chunk.n_elem; ++i)
+        {
+          if (doubleElements)
+            chunk[i] = (eT) reinterpret_cast<const double*>(buffer.data())[i];
+          else
+            chunk[i] = (eT) reinterpret_cast<const float*>(buffer.data())[i];
+        }
+      }
+
+      if (!stream.good())
+        ThrowTruncated(numChunkPoints);
+
+      pointsRead += numChunkPoints;
+      return true;
+    }
+
+    std::vector<char> buffer(numChunkPoints * elementSize);
+    for (size_t d = 0; d < dimensionality; ++d)
+    {
+      stream.seekg(dataStart + std::streamoff((d * numPoints + pointsRead) *
+          elementSize));
+      stream.read(buffer.data(), std::streamsize(buffer.size()));
+      if (!stream.good())
+        ThrowTruncated(numChunkPoints);
+
+      for (size_t i = 0; i < numChunkPoints; ++i)
+      {
+        if (doubleElements)
+          chunk(d, i) = (eT) reinterpret_cast<const double*>(buffer.data())[i];
+        else
+          chunk(d, i) = (eT) reinterpret_cast<const float*>(buffer.data())[i];
+      }
+    }
+
+    pointsRead += numChunkPoints;
+    return true;
+  }
+
+  //! Throw the error for a binary file which is too short.
+  void ThrowTruncated(const size_t numChunkPoints) const
+  {
+    std::ostringstream oss;
+    oss << "ChunkedLoader: cannot read points " << (pointsRead + 1)
+        << " to " << (pointsRead + numChunkPoints) << " of '" << filename
+        << "'";
+    throw std::runtime_error(oss.str());
+  }
+
+  //! The name of the file.
+  std::string filename;
+  //! The stream to read from.
+  std::ifstream stream;
+  //! The format of the file.
+  FileFormat format;
+  //! The DatasetInfo mapping the categorical dimensions.
+  DatasetInfo info;
+  //! The element type of a binary file (see NativeBinaryElementType()).
+  uint64_t elementType;
+  //! The dimensionality of the points (0 if nothing has been read yet from a
+  //! text file without a given DatasetInfo).
+  size_t dimensionality;
+  //! The number of points in a binary file, or in the range of an HDF5
+  //! dataset.
+  size_t numPoints;
+  //! The position of the first point in the file.
+  std::streampos dataStart;
+  //! The number of lines of the header of an ARFF file.
+  size_t linesInHeader;
+  //! The number of lines of a text file read so far (for error messages).
+  size_t linesRead;
+  //! The number of points read so far.
+  size_t pointsRead;
+  //! The index of the first point of the range of an HDF5 dataset.
+  size_t firstPoint;
+#ifdef HAS_HDF5
+  //! The HDF5 dataset being read (only for HDF5 files).
+  std::unique_ptr<HDF5Dataset> hdf5;
+#endif
+};
+
+/**
+ * The ChunkedSaver class writes a dataset to a file a chunk of points at a
+ * time, in the same format as data::Save(), so the file holds the
+ * concatenation of all the chunks.  The supported formats are:
+ *
+ *  - CSV (.csv) or raw ASCII (.txt) text; each column of each chunk is written
+ *    as one line of the file;
+ *  - mlpack native binary (.mlbin); each chunk is written with a single write,
+ *    without any formatting, and the number of points in the header is
+ *    updated after each chunk, so the file can be loaded or memory-mapped
+ *    (MappedMatrix) even while it is written;
+ *  - HDF5 (.h5, .hdf5, .hdf, .he5), if mlpack was built with HDF5 support;
+ *    each chunk is appended to an extensible dataset named "dataset" (see
+ *    HDF5DatasetWriter).
+ *
+ * The binary formats are much faster to write and much smaller than text for
+ * large outputs.  All the chunks written to a binary file must have the same
+ * number of rows and element type; the file is empty until the first chunk is
+ * written.
+ */
+class ChunkedSaver
+{
+ public:
+  /**
+   * Create (or truncate) the given file.  A std::runtime_error is thrown if the
+   * file can't be opened or is not in one of the supported formats.
+   *
+   * @param filename Name of the file to write.
+   */
+  ChunkedSaver(const std::string& filename) :
+      filename(filename),
+      format(FileFormat::text),
+      elementType(0),
+      rows(0),
+      pointsWritten(0)
+  {
+    const std::string extension = Extension(filename);
+    if (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
+        extension == "he5")
+    {
+#ifdef HAS_HDF5
+      format = FileFormat::hdf5;
+      hdf5Writer.reset(new HDF5DatasetWriter(filename, "dataset"));
+      return;
+#else
+      throw std::runtime_error("ChunkedSaver: cannot write '" + filename +
+          "' in chunks, because mlpack was built without HDF5 support");
+#endif
+    }
+
+    if (extension == "csv")
+      type = arma::csv_ascii;
+    else if (extension == "txt")
+      type = arma::raw_ascii;
+    else if (extension == "mlbin")
+      format = FileFormat::nativeBinary;
+    else
+      throw std::runtime_error("ChunkedSaver: '" + filename + "' is not a "
+          "text file (.csv or .txt), a native binary file (.mlbin) or an HDF5 "
+          "file");
+
+#ifdef  _WIN32 // Always open in binary mode on Windows.
+    stream.open(filename.c_str(), std::fstream::out | std::fstream::binary);
+#else
+    if (format == FileFormat::nativeBinary)
+      stream.open(filename.c_str(), std::fstream::out | std::fstream::binary);
+    else
+      stream.open(filename.c_str(), std::fstream::out);
+#endif
+    if (!stream.is_open())
+      throw std::runtime_error("ChunkedSaver: cannot open '" + filename +
+          "' for writing");
+  }
+
+  /**
+   * Append the given points (one per column) to the file.  A
+   * std::runtime_error is thrown if they can't be written.
+   *
+   * @param chunk Points to write.
+   */
+  template<typename eT>
+  void Write(const arma::Mat<eT>& chunk)
+  {
+#ifdef HAS_HDF5
+    if (format == FileFormat::hdf5)
+    {
+      hdf5Writer->Append(chunk);
+      pointsWritten += chunk.n_cols;
+      return;
+    }
+#endif
+
+    if (format == FileFormat::nativeBinary)
+    {
+      WriteNativeBinary(chunk);
+    }
+    else
+    {
+      try
+      {
+        SaveText(stream, chunk, type == arma::csv_ascii);
+      }
+      catch (std::runtime_error&)
+      {
+        throw std::runtime_error("ChunkedSaver: error writing to '" +
+            filename + "'");
+      }
+    }
+
+    stream.flush();
+    if (!stream.good())
+      throw std::runtime_error("ChunkedSaver: error writing to '" + filename +
+          "'");
+
+    pointsWritten += chunk.n_cols;
+  }
+
+  //! Get the number of points written so far.
+  size_t PointsWritten() const { return pointsWritten; }
+
+ private:
+  //! The formats that can be written.
+  enum class FileFormat { text, nativeBinary, hdf5 };
+
+  /**
+   * Append the given points to the native binary file, writing the header
+   * first if this is the first chunk.
+   */
+  template<typename eT>
+  void WriteNativeBinary(const arma::Mat<eT>& chunk)
+  {
+    if (elementType == 0)
+    {
+      // The header of an empty matrix, whose number of points is updated
+      // after each chunk.
+      elementType = NativeBinaryElementType<eT>();
+      rows = chunk.n_rows;
+      SaveNativeBinary(stream, filename, arma::Mat<eT>(rows, 0));
+    }
+    else if (elementType != NativeBinaryElementType<eT>() ||
+        rows != chunk.n_rows)
+    {
+      std::ostringstream oss;
+      oss << "ChunkedSaver: cannot append points of dimensionality "
+          << chunk.n_rows << " to '" << filename << "', which holds points of "
+          << "dimensionality " << rows << " (or points of another element "
+          << "type)";
+      throw std::runtime_error(oss.str());
+    }
+
+    stream.write((const char*) chunk.memptr(), sizeof(eT) * chunk.n_elem);
+
+    const uint64_t cols = pointsWritten + chunk.n_cols;
+    stream.seekp(offsetof(NativeBinaryHeader, cols));
+    stream.write((const char*) &cols, sizeof(uint64_t));
+    stream.seekp(0, std::ios::end);
+  }
+
+  //! The name of the file.
+  std::string filename;
+  //! The format of the file.
+  FileFormat format;
+  //! The stream to write to (for text and native binary files).
+  std::ofstream stream;
+  //! The Armadillo type of text files.
+  arma::file_type type;
+#ifdef HAS_HDF5
+  //! The dataset to append to (for HDF5 files).
+  std::unique_ptr<HDF5DatasetWriter> hdf5Writer;
+#endif
+  //! The element type of native binary files (0 until the first chunk).
+  uint64_t elementType;
+  //! The number of rows of native binary files.
+  size_t rows;
+  //! The number of points written so far.
+  size_t pointsWritten;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
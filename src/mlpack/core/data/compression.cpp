@@ -0,0 +1,79 @@
+/**
+ * @file compression.cpp
+ *
+ * Implementation of the gzip compression and decompression of files with
+ * Boost.Iostreams.
+ */
+#include "compression.hpp"
+
+#include <fstream>
+
+#ifdef HAS_BOOST_IOSTREAMS
+  #include <boost/iostreams/filtering_stream.hpp>
+  #include <boost/iostreams/filter/gzip.hpp>
+#endif
+
+namespace mlpack {
+namespace data {
+
+bool CompressionSupported()
+{
+#ifdef HAS_BOOST_IOSTREAMS
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Decompress(const std::string& filename, std::string& contents)
+{
+#ifdef HAS_BOOST_IOSTREAMS
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  contents.clear();
+  boost::iostreams::filtering_istream stream;
+  stream.push(boost::iostreams::gzip_decompressor());
+  stream.push(file);
+
+  // Errors of the decompressor set the badbit of the stream.
+  std::vector<char> buffer(1 << 20);
+  while (stream.read(buffer.data(), buffer.size()) || stream.gcount() > 0)
+    contents.append(buffer.data(), stream.gcount());
+
+  if (stream.bad())
+    throw std::runtime_error("'" + filename + "' is not a valid gzip file");
+#else
+  contents.clear();
+  throw std::runtime_error("cannot decompress '" + filename + "': mlpack was "
+      "built without Boost.Iostreams");
+#endif
+}
+
+void Compress(const std::string& filename, const std::string& contents)
+{
+#ifdef HAS_BOOST_IOSTREAMS
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!file.is_open())
+    throw std::runtime_error("cannot open '" + filename + "' for writing");
+
+  {
+    boost::iostreams::filtering_ostream stream;
+    stream.push(boost::iostreams::gzip_compressor());
+    stream.push(file);
+    stream.write(contents.data(), contents.size());
+    // The compressor is flushed when the stream is destroyed.
+  }
+
+  if (!file.good())
+    throw std::runtime_error("writing to '" + filename + "' failed");
+#else
+  (void) contents;
+  throw std::runtime_error("cannot compress '" + filename + "': mlpack was "
+      "built without Boost.Iostreams");
+#endif
+}
+
+} // namespace data
+} // namespace mlpack
@@ -0,0 +1,71 @@
+/**
+ * @file compression.hpp
+ *
+ * Support for gzip-compressed (.gz) files in data::Load() and data::Save().
+ * Compressed files are decompressed into memory (and compressed from memory),
+ * with Boost.Iostreams, so no temporary file is ever written.  If mlpack was
+ * built without Boost.Iostreams, compressed files give an error (see
+ * CompressionSupported()).  Boost.Iostreams is only used in compression.cpp,
+ * so code which includes this file does not depend on it.
+ */
+#ifndef MLPACK_CORE_DATA_COMPRESSION_HPP
+#define MLPACK_CORE_DATA_COMPRESSION_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include "extension.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Return whether the given file is compressed, that is, whether its extension
+ * is .gz.  The format of the file is then given by the extension before that
+ * (see UncompressedName()).
+ */
+inline bool IsCompressed(const std::string& filename)
+{
+  return (Extension(filename) == "gz");
+}
+
+/**
+ * Return the name of the given file without its compression extension, so
+ * that Extension() gives the format of the compressed data ("data.csv.gz"
+ * gives "data.csv").  Other names are returned unchanged.
+ */
+inline std::string UncompressedName(const std::string& filename)
+{
+  if (!IsCompressed(filename))
+    return filename;
+
+  return filename.substr(0, filename.rfind('.'));
+}
+
+/**
+ * Return whether mlpack was built with Boost.Iostreams, that is, whether
+ * Decompress() and Compress() can be used.
+ */
+bool CompressionSupported();
+
+/**
+ * Decompress the given gzip file into memory.  A std::runtime_error is thrown
+ * if the file can't be read or is not a valid gzip file.
+ *
+ * @param filename Name of the file to decompress.
+ * @param contents Set to the decompressed contents of the file.
+ */
+void Decompress(const std::string& filename, std::string& contents);
+
+/**
+ * Compress the given data into a gzip file.  A std::runtime_error is thrown if
+ * the file can't be written.
+ *
+ * @param filename Name of the file to write.
+ * @param contents Data to compress.
+ */
+void Compress(const std::string& filename, const std::string& contents);
+
+} // namespace data
+} // namespace mlpack
+
+#endif
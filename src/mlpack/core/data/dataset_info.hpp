@@ -13,6 +13,8 @@
 #include <unordered_map>
 #include <boost/bimap.hpp>
 
+#include "string_mapping.hpp"
+
 namespace mlpack {
 namespace data {
 
@@ -34,6 +36,11 @@ enum Datatype : bool /* bool is all the precision we need for two types */
  * by data::Load(), and store the type of each dimension (Datatype::numeric or
  * Datatype::categorical) as well as mappings from strings to unsigned integers
  * and vice versa.
+ *
+ * The mapping of each dimension is a StringMapping, which stores the strings
+ * compactly, so that columns with millions of distinct values can be mapped
+ * quickly.  MapStrings() and UnmapStrings() map many values of one dimension
+ * at once.
  */
 class DatasetInfo
 {
@@ -56,16 +63,44 @@ class DatasetInfo
    */
   size_t MapString(const std::string& string, const size_t dimension);
 
+  /**
+   * Map each of the given strings, which all belong to the given dimension, as
+   * MapString() does, and store the mapped values in the given row.
+   *
+   * @param strings Strings to find/create mappings for.
+   * @param dimension Index of the dimension of the strings.
+   * @param values Set to the mapped value of each string.
+   */
+  template<typename eT>
+  void MapStrings(const std::vector<std::string>& strings,
+                  const size_t dimension,
+                  arma::Row<eT>& values);
+
   /**
    * Return the string that corresponds to a given value in a given dimension.
    * If the string is not a valid mapping in the given dimension, a
-   * std::invalid_argument is thrown.
+   * std::invalid_argument is thrown.  The reference stays valid until the
+   * DatasetInfo is destroyed or loaded into.
    *
    * @param value Mapped value for string.
    * @param dimension Dimension to unmap string from.
    */
   const std::string& UnmapString(const size_t value, const size_t dimension);
 
+  /**
+   * Return the strings that correspond to the given values of the given
+   * dimension, as UnmapString() does.  If any value is not a valid mapping in
+   * the given dimension, a std::invalid_argument is thrown.
+   *
+   * @param values Mapped values for the strings.
+   * @param dimension Dimension to unmap the strings from.
+   * @param strings Set to the string of each value.
+   */
+  template<typename eT>
+  void UnmapStrings(const arma::Row<eT>& values,
+                    const size_t dimension,
+                    std::vector<std::string>& strings) const;
+
   //! Return the type of a given dimension (numeric or categorical).
   Datatype Type(const size_t dimension) const;
   //! Modify the type of a given dimension (be careful!).
@@ -86,29 +121,31 @@ class DatasetInfo
   size_t Dimensionality() const;
 
   /**
-   * Serialize the dataset information.
+   * Serialize the dataset information.  DatasetInfo objects saved by older
+   * versions of mlpack (with boost::bimap mappings) can still be loaded.
    */
   template<typename Archive>
-  void Serialize(Archive& ar, const unsigned int /* version */)
-  {
-    ar & data::CreateNVP(types, "types");
-    ar & data::CreateNVP(maps, "maps");
-  }
+  void Serialize(Archive& ar, const unsigned int version);
 
  private:
+  //! Throw a std::invalid_argument if the value is not mapped in the dimension.
+  void CheckMapped(const size_t value, const size_t dimension) const;
+
   //! Types of each dimension.
   std::vector<Datatype> types;
 
-  //! Mappings from strings to integers.  Map entries will only exist for
-  //! dimensions that are categorical.
-  std::unordered_map<size_t, std::pair<boost::bimap<std::string, size_t>,
-      size_t>> maps;
+  //! Mappings from strings to integers, indexed by dimension.  Only the
+  //! mappings of categorical dimensions are nonempty.
+  std::vector<StringMapping> maps;
 
 };
 
 } // namespace data
 } // namespace mlpack
 
+//! Set the serialization version of the DatasetInfo class.
+BOOST_TEMPLATE_CLASS_VERSION(template<>, mlpack::data::DatasetInfo, 1);
+
 #include "dataset_info_impl.hpp"
 
 #endif
@@ -15,7 +15,8 @@ namespace data {
 
 // Default constructor.
 inline DatasetInfo::DatasetInfo(const size_t dimensionality) :
-    types(dimensionality, Datatype::numeric)
+    types(dimensionality, Datatype::numeric),
+    maps(dimensionality)
 {
   // Nothing to initialize.
 }
@@ -24,42 +25,59 @@ inline DatasetInfo::DatasetInfo(const size_t dimensionality) :
 inline size_t DatasetInfo::MapString(const std::string& string,
                                      const size_t dimension)
 {
-  // If this condition is true, either we have no mapping for the given string
-  // or we have no mappings for the given dimension at all.  In either case,
-  // we create a mapping.
-  if (maps.count(dimension) == 0 ||
-      maps[dimension].first.left.count(string) == 0)
+  // The first mapping makes the dimension categorical.
+  if (NumMappings(dimension) == 0)
   {
-    // This string does not exist yet.
-    size_t& numMappings = maps[dimension].second;
-    if (numMappings == 0)
-      types[dimension] = Datatype::categorical;
-    typedef boost::bimap<std::string, size_t>::value_type PairType;
-    maps[dimension].first.insert(PairType(string, numMappings));
-    return numMappings++;
+    Type(dimension) = Datatype::categorical;
+    if (dimension >= maps.size())
+      maps.resize(dimension + 1);
   }
-  else
+
+  return maps[dimension].Map(string);
+}
+
+// Map all the strings of a dimension.
+template<typename eT>
+void DatasetInfo::MapStrings(const std::vector<std::string>& strings,
+                             const size_t dimension,
+                             arma::Row<eT>& values)
+{
+  values.set_size(strings.size());
+  if (strings.empty())
+    return;
+
+  if (NumMappings(dimension) == 0)
   {
-    // This string already exists in the mapping.
-    return maps[dimension].first.left.at(string);
+    Type(dimension) = Datatype::categorical;
+    if (dimension >= maps.size())
+      maps.resize(dimension + 1);
   }
+
+  StringMapping& mapping = maps[dimension];
+  for (size_t i = 0; i < strings.size(); ++i)
+    values[i] = (eT) mapping.Map(strings[i]);
 }
 
 // Return the string corresponding to a value in a given dimension.
-inline const std::string& DatasetInfo::UnmapString(
-    const size_t value,
-    const size_t dimension)
+inline const std::string& DatasetInfo::UnmapString(const size_t value,
+                                                   const size_t dimension)
+{
+  CheckMapped(value, dimension);
+  return maps[dimension].UnmapReference(value);
+}
+
+// Return the strings corresponding to values in a given dimension.
+template<typename eT>
+void DatasetInfo::UnmapStrings(const arma::Row<eT>& values,
+                               const size_t dimension,
+                               std::vector<std::string>& strings) const
 {
-  // Throw an exception if the value doesn't exist.
-  if (maps[dimension].first.right.count(value) == 0)
+  strings.resize(values.n_elem);
+  for (size_t i = 0; i < values.n_elem; ++i)
   {
-    std::ostringstream oss;
-    oss << "DatasetInfo::UnmapString(): value '" << value << "' unknown for "
-        << "dimension " << dimension;
-    throw std::invalid_argument(oss.str());
+    CheckMapped((size_t) values[i], dimension);
+    strings[i] = maps[dimension].Unmap((size_t) values[i]);
   }
-
-  return maps[dimension].first.right.at(value);
 }
 
 // Get the type of a particular dimension.
@@ -86,7 +104,7 @@ inline Datatype& DatasetInfo::Type(const size_t dimension)
 
 inline size_t DatasetInfo::NumMappings(const size_t dimension) const
 {
-  return (maps.count(dimension) == 0) ? 0 : maps.at(dimension).second;
+  return (dimension < maps.size()) ? maps[dimension].Size() : 0;
 }
 
 inline size_t DatasetInfo::Dimensionality() const
@@ -94,6 +112,59 @@ inline size_t DatasetInfo::Dimensionality() const
   return types.size();
 }
 
+inline void DatasetInfo::CheckMapped(const size_t value,
+                                     const size_t dimension) const
+{
+  if (value >= NumMappings(dimension))
+  {
+    std::ostringstream oss;
+    oss << "DatasetInfo::UnmapString(): value '" << value << "' unknown for "
+        << "dimension " << dimension;
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename Archive>
+void DatasetInfo::Serialize(Archive& ar, const unsigned int version)
+{
+  ar & data::CreateNVP(types, "types");
+
+  // Backward compatibility: older versions stored a boost::bimap for each
+  // categorical dimension.
+  if (version == 0)
+  {
+    std::unordered_map<size_t, std::pair<boost::bimap<std::string, size_t>,
+        size_t>> oldMaps;
+    ar & data::CreateNVP(oldMaps, "maps");
+
+    maps.clear();
+    maps.resize(types.size());
+    for (auto it = oldMaps.begin(); it != oldMaps.end(); ++it)
+    {
+      if (it->first >= maps.size())
+        maps.resize(it->first + 1);
+      for (size_t i = 0; i < it->second.second; ++i)
+        maps[it->first].Map(it->second.first.right.at(i));
+    }
+    return;
+  }
+
+  size_t numMaps = maps.size();
+  ar & data::CreateNVP(numMaps, "numMaps");
+  if (Archive::is_loading::value)
+  {
+    maps.clear();
+    maps.resize(numMaps);
+  }
+
+  for (size_t i = 0; i < numMaps; ++i)
+  {
+    std::ostringstream name;
+    name << "map" << i;
+    ar & data::CreateNVP(maps[i], name.str());
+  }
+}
+
 } // namespace data
 } // namespace mlpack
 
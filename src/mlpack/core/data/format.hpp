@@ -17,7 +17,8 @@ enum format
   autodetect,
   text,
   xml,
-  binary
+  binary,
+  aligned_binary //!< Binary, with matrices in aligned raw blocks (.mlmodel).
 };
 
 } // namespace data
@@ -0,0 +1,386 @@
+/**
+ * @file hdf5_dataset.hpp
+ *
+ * Definition of the HDF5Dataset class, which reads ranges of points (columns)
+ * of a two-dimensional HDF5 dataset without reading the rest of it, and of the
+ * HDF5DatasetWriter class, which appends points to a new dataset.  They are
+ * used by data::Load() for partial reads and by ChunkedLoader and
+ * ChunkedSaver, and are only available when mlpack was built with HDF5
+ * (HAS_HDF5 is defined; this requires Armadillo to have HDF5 support).
+ */
+#ifndef MLPACK_CORE_DATA_HDF5_DATASET_HPP
+#define MLPACK_CORE_DATA_HDF5_DATASET_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#ifdef HAS_HDF5
+
+#include <hdf5.h>
+#include <sstream>
+#include <type_traits>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Return the HDF5 memory type of the given element type; HDF5 converts the
+ * elements of the file to it while reading.
+ */
+template<typename eT>
+inline hid_t HDF5MemoryType()
+{
+  if (std::is_floating_point<eT>::value)
+    return (sizeof(eT) == sizeof(float)) ? H5T_NATIVE_FLOAT :
+        H5T_NATIVE_DOUBLE;
+
+  const bool isSigned = std::is_signed<eT>::value;
+  switch (sizeof(eT))
+  {
+    case 1: return isSigned ? H5T_NATIVE_INT8 : H5T_NATIVE_UINT8;
+    case 2: return isSigned ? H5T_NATIVE_INT16 : H5T_NATIVE_UINT16;
+    case 4: return isSigned ? H5T_NATIVE_INT32 : H5T_NATIVE_UINT32;
+    default: return isSigned ? H5T_NATIVE_INT64 : H5T_NATIVE_UINT64;
+  }
+}
+
+/**
+ * A two-dimensional HDF5 dataset, opened for reading ranges of points.  As in
+ * the files written by data::Save() (and by Armadillo, numpy and h5py for
+ * row-major arrays of points), the first (slowest) HDF5 dimension indexes the
+ * points, and the second indexes the dimensions, so a range of points is one
+ * contiguous hyperslab, which is read straight into a column-major matrix with
+ * one point per column.
+ *
+ * If the dataset is stored in chunks, the chunk cache is made large enough to
+ * hold a full row of chunks, so that consecutive ranges which don't start on a
+ * chunk boundary don't read the chunk they share twice; ChunkPoints() gives the
+ * number of points per chunk, so that callers can align their ranges.
+ *
+ * A std::runtime_error is thrown on any failure.
+ */
+class HDF5Dataset
+{
+ public:
+  /**
+   * Open the given dataset of the given file.
+   *
+   * @param filename Name of the HDF5 file.
+   * @param datasetName Name of the dataset ("dataset" for files written by
+   *     data::Save() or Armadillo).
+   */
+  HDF5Dataset(const std::string& filename, const std::string& datasetName) :
+      filename(filename),
+      datasetName(datasetName),
+      file(-1),
+      dataset(-1),
+      space(-1),
+      points(0),
+      dimensionality(0),
+      chunkPoints(0)
+  {
+    // Don't let HDF5 print its error stack; we throw our own errors.
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file < 0)
+      throw std::runtime_error("cannot open '" + filename + "' as an HDF5 "
+          "file");
+
+    // Find the chunk layout first, to size the chunk cache of the dataset.
+    dataset = H5Dopen2(file, datasetName.c_str(), H5P_DEFAULT);
+    if (dataset < 0)
+    {
+      Close();
+      throw std::runtime_error("'" + filename + "' has no dataset '" +
+          datasetName + "'");
+    }
+
+    space = H5Dget_space(dataset);
+    hsize_t dims[2];
+    if (space < 0 || H5Sget_simple_extent_ndims(space) != 2 ||
+        H5Sget_simple_extent_dims(space, dims, NULL) != 2)
+    {
+      Close();
+      throw std::runtime_error("dataset '" + datasetName + "' of '" +
+          filename + "' is not two-dimensional");
+    }
+    points = dims[0];
+    dimensionality = dims[1];
+
+    const hid_t createList = H5Dget_create_plist(dataset);
+    hsize_t chunkDims[2];
+    if (H5Pget_layout(createList) == H5D_CHUNKED &&
+        H5Pget_chunk(createList, 2, chunkDims) == 2)
+    {
+      chunkPoints = chunkDims[0];
+
+      // Reopen the dataset with a cache holding a full row of chunks.
+      const size_t chunkBytes = chunkDims[0] * chunkDims[1] *
+          H5Tget_size(H5Dget_type(dataset));
+      const size_t chunksPerRow = (dimensionality + chunkDims[1] - 1) /
+          chunkDims[1];
+      const size_t cacheBytes = std::max(chunksPerRow * chunkBytes,
+          (size_t) 1024 * 1024);
+      const hid_t accessList = H5Pcreate(H5P_DATASET_ACCESS);
+      H5Pset_chunk_cache(accessList, 100 * chunksPerRow + 1, cacheBytes,
+          H5D_CHUNK_CACHE_W0_DEFAULT);
+      H5Sclose(space);
+      H5Dclose(dataset);
+      dataset = H5Dopen2(file, datasetName.c_str(), accessList);
+      H5Pclose(accessList);
+      space = (dataset < 0) ? -1 : H5Dget_space(dataset);
+    }
+    H5Pclose(createList);
+
+    if (space < 0)
+    {
+      Close();
+      throw std::runtime_error("cannot reopen dataset '" + datasetName +
+          "' of '" + filename + "'");
+    }
+  }
+
+  //! Close the dataset and the file.
+  ~HDF5Dataset() { Close(); }
+
+  /**
+   * Read the given range of points into the given matrix, which will have one
+   * point per column.
+   *
+   * @param matrix Matrix to read into.
+   * @param firstPoint Index of the first point to read.
+   * @param numPoints Number of points to read.
+   */
+  template<typename eT>
+  void Read(arma::Mat<eT>& matrix,
+            const size_t firstPoint,
+            const size_t numPoints) const
+  {
+    if (firstPoint + numPoints > points)
+    {
+      std::ostringstream oss;
+      oss << "cannot read points " << firstPoint << " to "
+          << (firstPoint + numPoints) << " of dataset '" << datasetName
+          << "' of '" << filename << "', which has " << points << " points";
+      throw std::runtime_error(oss.str());
+    }
+
+    matrix.set_size(dimensionality, numPoints);
+    if (matrix.n_elem == 0)
+      return;
+
+    const hsize_t start[2] = { firstPoint, 0 };
+    const hsize_t count[2] = { numPoints, dimensionality };
+    const hid_t memorySpace = H5Screate_simple(2, count, NULL);
+    const bool success = (H5Sselect_hyperslab(space, H5S_SELECT_SET, start,
+        NULL, count, NULL) >= 0) && (H5Dread(dataset, HDF5MemoryType<eT>(),
+        memorySpace, space, H5P_DEFAULT, matrix.memptr()) >= 0);
+    H5Sclose(memorySpace);
+
+    if (!success)
+    {
+      std::ostringstream oss;
+      oss << "reading points " << firstPoint << " to "
+          << (firstPoint + numPoints) << " of dataset '" << datasetName
+          << "' of '" << filename << "' failed";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  //! Get the number of points of the dataset.
+  size_t Points() const { return points; }
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+  //! Get the number of points per chunk (0 if the dataset isn't chunked).
+  size_t ChunkPoints() const { return chunkPoints; }
+
+ private:
+  //! Close every open handle.
+  void Close()
+  {
+    if (space >= 0)
+      H5Sclose(space);
+    if (dataset >= 0)
+      H5Dclose(dataset);
+    if (file >= 0)
+      H5Fclose(file);
+    space = dataset = file = -1;
+  }
+
+  //! The name of the file.
+  std::string filename;
+  //! The name of the dataset.
+  std::string datasetName;
+  //! The file handle.
+  hid_t file;
+  //! The dataset handle.
+  hid_t dataset;
+  //! The dataspace of the dataset.
+  hid_t space;
+  //! The number of points.
+  size_t points;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points per chunk (0 if the dataset isn't chunked).
+  size_t chunkPoints;
+
+  // Handles can't be shared.
+  HDF5Dataset(const HDF5Dataset&);
+  HDF5Dataset& operator=(const HDF5Dataset&);
+};
+
+/**
+ * A two-dimensional HDF5 dataset, created in a new file, to which points are
+ * appended.  The layout is the one HDF5Dataset reads (the first HDF5 dimension
+ * indexes the points), so a column-major matrix of points is written with one
+ * contiguous hyperslab.  The dataset is chunked and extensible along the
+ * points, and is created by the first Append(), which sets its dimensionality
+ * and element type.
+ *
+ * A std::runtime_error is thrown on any failure.
+ */
+class HDF5DatasetWriter
+{
+ public:
+  /**
+   * Create (or truncate) the given HDF5 file.
+   *
+   * @param filename Name of the file to create.
+   * @param datasetName Name of the dataset to create in it ("dataset" for
+   *     data::Load() and ChunkedLoader).
+   */
+  HDF5DatasetWriter(const std::string& filename,
+                    const std::string& datasetName) :
+      filename(filename),
+      datasetName(datasetName),
+      file(-1),
+      dataset(-1),
+      memoryType(-1),
+      points(0),
+      dimensionality(0)
+  {
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    file = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT,
+        H5P_DEFAULT);
+    if (file < 0)
+      throw std::runtime_error("cannot create HDF5 file '" + filename + "'");
+  }
+
+  //! Close the dataset and the file.
+  ~HDF5DatasetWriter() { Close(); }
+
+  /**
+   * Append the given points (one per column) to the dataset.
+   *
+   * @param matrix Points to append.
+   */
+  template<typename eT>
+  void Append(const arma::Mat<eT>& matrix)
+  {
+    if (dataset < 0)
+      Create(matrix.n_rows, HDF5MemoryType<eT>());
+
+    if (matrix.n_rows != dimensionality ||
+        !H5Tequal(memoryType, HDF5MemoryType<eT>()))
+    {
+      std::ostringstream oss;
+      oss << "cannot append points of dimensionality " << matrix.n_rows
+          << " to dataset '" << datasetName << "' of '" << filename
+          << "', which holds points of dimensionality " << dimensionality
+          << " (or points of another element type)";
+      throw std::runtime_error(oss.str());
+    }
+
+    if (matrix.n_cols == 0)
+      return;
+
+    const hsize_t newDims[2] = { points + matrix.n_cols, dimensionality };
+    const hsize_t start[2] = { points, 0 };
+    const hsize_t count[2] = { matrix.n_cols, dimensionality };
+    bool success = (H5Dset_extent(dataset, newDims) >= 0);
+    if (success)
+    {
+      const hid_t space = H5Dget_space(dataset);
+      const hid_t memorySpace = H5Screate_simple(2, count, NULL);
+      success = (space >= 0) && (H5Sselect_hyperslab(space, H5S_SELECT_SET,
+          start, NULL, count, NULL) >= 0) && (H5Dwrite(dataset, memoryType,
+          memorySpace, space, H5P_DEFAULT, matrix.memptr()) >= 0);
+      H5Sclose(memorySpace);
+      if (space >= 0)
+        H5Sclose(space);
+    }
+
+    if (!success)
+      throw std::runtime_error("appending points to dataset '" + datasetName +
+          "' of '" + filename + "' failed");
+
+    points += matrix.n_cols;
+  }
+
+  //! Get the number of points written so far.
+  size_t Points() const { return points; }
+
+ private:
+  //! Create the dataset, for points of the given dimensionality and type.
+  void Create(const size_t dims, const hid_t type)
+  {
+    dimensionality = dims;
+    memoryType = type;
+
+    // Each HDF5 chunk holds whole points, about 1MB of them.
+    const hsize_t initialDims[2] = { 0, dimensionality };
+    const hsize_t maxDims[2] = { H5S_UNLIMITED, dimensionality };
+    const hsize_t chunkDims[2] = { std::max((size_t) 1, (size_t) (1 << 20) /
+        (H5Tget_size(type) * std::max((size_t) 1, dimensionality))),
+        std::max((size_t) 1, dimensionality) };
+
+    const hid_t space = H5Screate_simple(2, initialDims, maxDims);
+    const hid_t createList = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(createList, 2, chunkDims);
+    dataset = H5Dcreate2(file, datasetName.c_str(), type, space, H5P_DEFAULT,
+        createList, H5P_DEFAULT);
+    H5Pclose(createList);
+    H5Sclose(space);
+
+    if (dataset < 0)
+      throw std::runtime_error("cannot create dataset '" + datasetName +
+          "' in '" + filename + "'");
+  }
+
+  //! Close every open handle.
+  void Close()
+  {
+    if (dataset >= 0)
+      H5Dclose(dataset);
+    if (file >= 0)
+      H5Fclose(file);
+    dataset = file = -1;
+  }
+
+  //! The name of the file.
+  std::string filename;
+  //! The name of the dataset.
+  std::string datasetName;
+  //! The file handle.
+  hid_t file;
+  //! The dataset handle (-1 until the first Append()).
+  hid_t dataset;
+  //! The HDF5 type of the elements.
+  hid_t memoryType;
+  //! The number of points written so far.
+  size_t points;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+
+  // Handles can't be shared.
+  HDF5DatasetWriter(const HDF5DatasetWriter&);
+  HDF5DatasetWriter& operator=(const HDF5DatasetWriter&);
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif // HAS_HDF5
+
+#endif
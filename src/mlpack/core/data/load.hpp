@@ -15,6 +15,10 @@
 
 #include "format.hpp"
 #include "dataset_info.hpp"
+#include "native_binary.hpp"
+#include "load_text.hpp"
+#include "sparse_text.hpp"
+#include "hdf5_dataset.hpp"
 
 namespace mlpack {
 namespace data /** Functions to load and save matrices and models. */ {
@@ -35,6 +39,11 @@ namespace data /** Functions to load and save matrices and models. */ {
  *  - Raw binary (raw_binary), denoted by .bin
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5, denoted by .hdf, .hdf5, .h5, or .he5
+ *  - mlpack native binary (see native_binary.hpp), denoted by .mlbin
+ *
+ * Any of these except HDF5 may be gzip-compressed, denoted by an extra .gz
+ * extension (such as .csv.gz); the file is then decompressed into memory (see
+ * compression.hpp).
  *
  * If the file extension is not one of those types, an error will be given.
  * This is preferable to Armadillo's default behavior of loading an unknown
@@ -45,7 +54,8 @@ namespace data /** Functions to load and save matrices and models. */ {
  * 'transpose' controls whether or not the matrix is transposed after loading.
  * In most cases, because data is generally stored in a row-major format and
  * mlpack requires column-major matrices, this should be left at its default
- * value of 'true'.
+ * value of 'true'.  Native binary files are already stored column-major, so
+ * they are never transposed.
  *
  * @param filename Name of file to load.
  * @param matrix Matrix to load contents of file into.
@@ -69,6 +79,8 @@ bool Load(const std::string& filename,
  * - CSV (csv_ascii), denoted by .csv, or optionally .txt
  * - TSV (raw_ascii), denoted by .tsv, .csv, or .txt
  * - ASCII (raw_ascii), denoted by .txt
+ * - mlpack native binary, denoted by .mlbin (the DatasetInfo saved with the
+ *   matrix is loaded; the matrix is never transposed)
  *
  * If the file extension is not one of those types, an error will be given.
  * This is preferable to Armadillo's default behavior of loading an unknown
@@ -98,6 +110,79 @@ bool Load(const std::string& filename,
           const bool fatal = false,
           const bool transpose = true);
 
+/**
+ * Loads a sparse matrix from a sparse text file, guessing the format from the
+ * extension, with one point per column.  The supported formats (see
+ * sparse_text.hpp) are:
+ *
+ *  - LIBSVM / SVMlight, denoted by .svm, .libsvm or .svmlight (the labels are
+ *    discarded; use the overload below to keep them)
+ *  - coordinate lists ("point dimension value" on each line), denoted by .coo
+ *
+ * Either may be gzip-compressed, denoted by an extra .gz extension.  The file
+ * is parsed in parallel, straight into compressed sparse column form, so no
+ * dense matrix is ever formed.
+ *
+ * If the parameter 'fatal' is set to true, a std::runtime_error exception will
+ * be thrown if the matrix does not load successfully.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Sparse matrix to load contents of file into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          const bool fatal = false);
+
+/**
+ * Loads a sparse matrix and the labels of its points from a LIBSVM / SVMlight
+ * file (denoted by .svm, .libsvm or .svmlight, optionally followed by .gz), as
+ * the overload above does.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Sparse matrix to load contents of file into.
+ * @param labels Row to load the label of each point into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT, typename LabelT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          arma::Row<LabelT>& labels,
+          const bool fatal = false);
+
+/**
+ * Loads a range of points from a two-dimensional dataset of an HDF5 file, with
+ * one point per column, without reading the rest of the dataset: only the
+ * hyperslab holding the points is read from disk, straight into the matrix.
+ * As in the files written by Save() (and by numpy and h5py), the first HDF5
+ * dimension of the dataset indexes the points.  The elements are converted to
+ * eT by HDF5 while they are read.  This is only available when mlpack was
+ * built with HDF5 support.
+ *
+ * If the parameter 'fatal' is set to true, a std::runtime_error exception will
+ * be thrown if the points do not load successfully.  Otherwise, the method
+ * will return false and the relevant error information will be printed to
+ * Log::Warn.
+ *
+ * @param filename Name of HDF5 file to load from.
+ * @param matrix Matrix to load the points into.
+ * @param dataset Name of the dataset ("dataset" for files written by Save()).
+ * @param firstPoint Index of the first point to load.
+ * @param numPoints Number of points to load.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          const std::string& dataset,
+          const size_t firstPoint,
+          const size_t numPoints,
+          const bool fatal = false);
+
 /**
  * Load a model from a file, guessing the filetype from the extension, or,
  * optionally, loading the specified format.  If automatic extension detection
@@ -109,9 +194,13 @@ bool Load(const std::string& filename,
  *  - text, denoted by .txt
  *  - xml, denoted by .xml
  *  - binary, denoted by .bin
+ *  - binary with matrices stored as raw blocks aligned to 64 bytes, denoted by
+ *    .mlmodel (see AlignedBinaryOArchive); this is the fastest format for
+ *    models holding large matrices
  *
  * The format parameter can take any of the values in the 'format' enum:
- * 'format::autodetect', 'format::text', 'format::xml', and 'format::binary'.
+ * 'format::autodetect', 'format::text', 'format::xml', 'format::binary', and
+ * 'format::aligned_binary'.
  * The autodetect functionality operates on the file extension (so, "file.txt"
  * would be autodetected as text).
  *
@@ -130,6 +219,25 @@ bool Load(const std::string& filename,
           const bool fatal = false,
           format f = format::autodetect);
 
+/**
+ * Memory-map a matrix from an mlpack native binary (.mlbin) file, which takes
+ * nearly no time regardless of the size of the matrix: the elements are only
+ * read from disk when they are used.  See MappedMatrix for details.
+ *
+ * If the parameter 'fatal' is set to true, a std::runtime_error exception will
+ * be thrown if the file can't be mapped.  Otherwise, the method will return
+ * false and the relevant error information will be printed to Log::Warn.
+ *
+ * @param filename Name of file to map.
+ * @param matrix MappedMatrix to map the file into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          MappedMatrix<eT>& matrix,
+          const bool fatal = false);
+
 } // namespace data
 } // namespace mlpack
 
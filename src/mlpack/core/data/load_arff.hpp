@@ -12,6 +12,23 @@
 namespace mlpack {
 namespace data {
 
+/**
+ * Read the header of an ARFF dataset from the given stream, up to and including
+ * the @data line, so that the stream is left at the first line of data.  A
+ * std::runtime_error is thrown if the header can't be parsed or there is no
+ * @data section.
+ *
+ * @param stream Stream to read from.
+ * @param dimensionality Set to the number of attributes.
+ * @param types Set to whether each (numeric or string) attribute is
+ *     categorical.
+ * @param headerLines Set to the number of lines of the header.
+ */
+inline void ReadARFFHeader(std::istream& stream,
+                           size_t& dimensionality,
+                           std::vector<bool>& types,
+                           size_t& headerLines);
+
 /**
  * A utility function to load an ARFF dataset as numeric features (that is, as
  * an Armadillo matrix without any modification).  An exception will be thrown
@@ -47,6 +64,20 @@ void LoadARFF(const std::string& filename,
               arma::Mat<eT>& matrix,
               DatasetInfo& info);
 
+/**
+ * Load an ARFF dataset from the given stream, as LoadARFF() does from a file;
+ * this is used for files decompressed into memory.
+ *
+ * @param stream Stream to read the ARFF dataset from.
+ * @param matrix Matrix to load data into.
+ * @param info DatasetInfo object; can be default-constructed or pre-existing
+ *     from another call to LoadARFF().
+ */
+template<typename eT>
+void LoadARFF(std::istream& stream,
+              arma::Mat<eT>& matrix,
+              DatasetInfo& info);
+
 } // namespace data
 } // namespace mlpack
 
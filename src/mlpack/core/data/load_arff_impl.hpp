@@ -15,23 +15,19 @@
 namespace mlpack {
 namespace data {
 
-template<typename eT>
-void LoadARFF(const std::string& filename,
-              arma::Mat<eT>& matrix,
-              DatasetInfo& info)
+inline void ReadARFFHeader(std::istream& stream,
+                           size_t& dimensionality,
+                           std::vector<bool>& types,
+                           size_t& headerLines)
 {
-  // First, open the file.
-  std::ifstream ifs;
-  ifs.open(filename);
-
   std::string line;
-  size_t dimensionality = 0;
-  std::vector<bool> types;
-  size_t headerLines = 0;
-  while (!ifs.eof())
+  dimensionality = 0;
+  types.clear();
+  headerLines = 0;
+  while (!stream.eof())
   {
     // Read the next line, then strip whitespace from either side.
-    std::getline(ifs, line, '\n');
+    std::getline(stream, line, '\n');
     boost::trim(line);
     ++headerLines;
 
@@ -92,8 +88,32 @@ void LoadARFF(const std::string& filename,
     }
   }
 
-  if (ifs.eof())
+  if (stream.eof())
     throw std::runtime_error("no @data section found");
+}
+
+template<typename eT>
+void LoadARFF(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              DatasetInfo& info)
+{
+  // First, open the file.
+  std::ifstream ifs;
+  ifs.open(filename);
+
+  LoadARFF(ifs, matrix, info);
+}
+
+template<typename eT>
+void LoadARFF(std::istream& ifs,
+              arma::Mat<eT>& matrix,
+              DatasetInfo& info)
+{
+  std::string line;
+  size_t dimensionality;
+  std::vector<bool> types;
+  size_t headerLines;
+  ReadARFFHeader(ifs, dimensionality, types, headerLines);
 
   // Reset the DatasetInfo object, if needed.
   if (info.Dimensionality() == 0)
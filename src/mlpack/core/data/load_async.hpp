@@ -0,0 +1,58 @@
+/**
+ * @file load_async.hpp
+ *
+ * Definition of LoadAsync(), which loads a matrix on a background thread, so
+ * that the caller can do other work (such as building a tree on another
+ * dataset) while the file is read and parsed.
+ */
+#ifndef MLPACK_CORE_DATA_LOAD_ASYNC_HPP
+#define MLPACK_CORE_DATA_LOAD_ASYNC_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <future>
+
+#include "load.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Start loading a matrix from a file on a background thread, exactly as
+ * data::Load() would.  The matrix must not be used (or destroyed) until the
+ * returned future is ready; calling get() on the future waits for the load and
+ * returns the value that data::Load() returned.  If the load fails and 'fatal'
+ * is true, the std::runtime_error is thrown by get().
+ *
+ * The messages logged by the load are written line by line, so they are not
+ * interleaved with the output of the calling thread.
+ *
+ * @code
+ * arma::mat queries;
+ * std::future<bool> queriesLoaded = data::LoadAsync("queries.csv", queries,
+ *     true);
+ * knn.Train(std::move(references)); // Builds the tree during the load.
+ * queriesLoaded.get();
+ * @endcode
+ *
+ * @param filename Name of file to load.
+ * @param matrix Matrix to load contents of file into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix after loading.
+ * @return Future holding the value returned by data::Load().
+ */
+template<typename eT>
+std::future<bool> LoadAsync(const std::string& filename,
+                            arma::Mat<eT>& matrix,
+                            const bool fatal = false,
+                            const bool transpose = true)
+{
+  return std::async(std::launch::async, [filename, &matrix, fatal, transpose]()
+  {
+    return Load(filename, matrix, fatal, transpose);
+  });
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
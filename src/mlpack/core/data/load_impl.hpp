@@ -10,8 +10,10 @@
 // In case it hasn't already been included.
 #include "load.hpp"
 #include "extension.hpp"
+#include "compression.hpp"
 
 #include <algorithm>
+#include <sstream>
 #include <mlpack/core/util/timers.hpp>
 
 #include <boost/serialization/serialization.hpp>
@@ -23,6 +25,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include "serialization_shim.hpp"
+#include "aligned_binary_archive.hpp"
 
 #include "load_arff.hpp"
 
@@ -78,11 +81,10 @@ void MapToNumerical(const std::vector<std::string> &tokens,
                                       std::end(tokens), notNumber);
   if(notNumeric)
   {
+    arma::Row<eT> values;
+    info.MapStrings(tokens, row, values);
     for(size_t i = 0; i != tokens.size(); ++i)
-    {
-      const eT val = static_cast<eT>(info.MapString(tokens[i], row));
-      matrix.at(row, i) = val;
-    }
+      matrix.at(row, i) = values[i];
   }
   else
   {
@@ -121,6 +123,77 @@ bool inline inplace_transpose(arma::Mat<eT>& X)
   }
 }
 
+// Decompress the given file into the given stream; the "loading_data" timer
+// must be running, and is stopped on failure.
+inline bool DecompressFile(const std::string& filename,
+                           std::istringstream& stream,
+                           const bool fatal)
+{
+  try
+  {
+    std::string contents;
+    Decompress(filename, contents);
+    stream.str(contents);
+  }
+  catch (std::runtime_error& e)
+  {
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << e.what() << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << std::endl;
+
+    return false;
+  }
+
+  return true;
+}
+
+// Load a native binary file; the "loading_data" timer must be running.
+template<typename eT>
+bool LoadNativeBinaryFile(const std::string& filename,
+                          arma::Mat<eT>& matrix,
+                          DatasetInfo* info,
+                          const bool fatal)
+{
+  Log::Info << "Loading '" << filename << "' as mlpack native binary data.  "
+      << std::flush;
+
+  try
+  {
+    if (IsCompressed(filename))
+    {
+      std::string contents;
+      Decompress(filename, contents);
+      std::istringstream stream(contents);
+      LoadNativeBinary(stream, filename, matrix, info);
+    }
+    else
+    {
+      LoadNativeBinary(filename, matrix, info);
+    }
+  }
+  catch (std::runtime_error& e)
+  {
+    Timer::Stop("loading_data");
+    Log::Info << std::endl;
+    if (fatal)
+      Log::Fatal << e.what() << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols << ".\n";
+
+  Timer::Stop("loading_data");
+
+  return true;
+}
+
 template<typename eT>
 bool Load(const std::string& filename,
           arma::Mat<eT>& matrix,
@@ -129,27 +202,44 @@ bool Load(const std::string& filename,
 {
   Timer::Start("loading_data");
 
-  // Get the extension.
-  std::string extension = Extension(filename);
+  // Get the extension (of the data, for compressed files).
+  const bool compressed = IsCompressed(filename);
+  std::string extension = Extension(UncompressedName(filename));
 
-  // Catch nonexistent files by opening the stream ourselves.
-  std::fstream stream;
+  // Native binary files are read directly, and never transposed.
+  if (extension == "mlbin")
+    return LoadNativeBinaryFile(filename, matrix, NULL, fatal);
+
+  // Catch nonexistent files by opening the stream ourselves.  Compressed files
+  // are decompressed into memory, and read from there.
+  std::fstream fileStream;
+  std::istringstream memoryStream;
+  if (compressed)
+  {
+    if (!DecompressFile(filename, memoryStream, fatal))
+      return false;
+  }
+  else
+  {
 #ifdef  _WIN32 // Always open in binary mode on Windows.
-  stream.open(filename.c_str(), std::fstream::in | std::fstream::binary);
+    fileStream.open(filename.c_str(), std::fstream::in | std::fstream::binary);
 #else
-  stream.open(filename.c_str(), std::fstream::in);
+    fileStream.open(filename.c_str(), std::fstream::in);
 #endif
-  if (!stream.is_open())
-  {
-    Timer::Stop("loading_data");
-    if (fatal)
-      Log::Fatal << "Cannot open file '" << filename << "'. " << std::endl;
-    else
-      Log::Warn << "Cannot open file '" << filename << "'; load failed."
-          << std::endl;
+    if (!fileStream.is_open())
+    {
+      Timer::Stop("loading_data");
+      if (fatal)
+        Log::Fatal << "Cannot open file '" << filename << "'. " << std::endl;
+      else
+        Log::Warn << "Cannot open file '" << filename << "'; load failed."
+            << std::endl;
 
-    return false;
+      return false;
+    }
   }
+  std::istream& stream = compressed ? (std::istream&) memoryStream :
+      (std::istream&) fileStream;
 
   bool unknownType = false;
   arma::file_type loadType;
@@ -322,6 +412,20 @@ bool Load(const std::string& filename,
     return false;
   }
 
+  // Armadillo can only load HDF5 files by name.
+  if (compressed && loadType == arma::hdf5_binary)
+  {
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Cannot load '" << filename << "': compressed HDF5 files "
+          << "are not supported." << std::endl;
+    else
+      Log::Warn << "Cannot load '" << filename << "': compressed HDF5 files "
+          << "are not supported." << std::endl;
+
+    return false;
+  }
+
   // Try to load the file; but if it's raw_binary, it could be a problem.
   if (loadType == arma::raw_binary)
     Log::Warn << "Loading '" << filename << "' as " << stringType << "; "
@@ -330,9 +434,40 @@ bool Load(const std::string& filename,
     Log::Info << "Loading '" << filename << "' as " << stringType << ".  "
         << std::flush;
 
+  // Numeric text is parsed in parallel by LoadText(), straight into the final
+  // layout; everything else is loaded by Armadillo, and may need a transpose.
+  // Armadillo loads HDF5 matrices transposed, so we have to work around that.
+  const bool text = (loadType == arma::csv_ascii ||
+      loadType == arma::raw_ascii);
+  const bool needTranspose = !text &&
+      (transpose != (loadType == arma::hdf5_binary));
+
   // We can't use the stream if the type is HDF5.
   bool success;
-  if (loadType != arma::hdf5_binary)
+  std::string error;
+  if (text)
+  {
+    try
+    {
+      if (compressed)
+      {
+        ParseText(memoryStream.str(), filename, matrix,
+            loadType == arma::csv_ascii, transpose);
+      }
+      else
+      {
+        fileStream.close();
+        LoadText(filename, matrix, loadType == arma::csv_ascii, transpose);
+      }
+      success = true;
+    }
+    catch (std::runtime_error& e)
+    {
+      error = std::string(": ") + e.what();
+      success = false;
+    }
+  }
+  else if (loadType != arma::hdf5_binary)
     success = matrix.load(stream, loadType);
   else
     success = matrix.load(filename, loadType);
@@ -342,26 +477,21 @@ bool Load(const std::string& filename,
     Log::Info << std::endl;
     Timer::Stop("loading_data");
     if (fatal)
-      Log::Fatal << "Loading from '" << filename << "' failed." << std::endl;
+      Log::Fatal << "Loading from '" << filename << "' failed" << error << "."
+          << std::endl;
     else
-      Log::Warn << "Loading from '" << filename << "' failed." << std::endl;
+      Log::Warn << "Loading from '" << filename << "' failed" << error << "."
+          << std::endl;
 
     return false;
   }
   else
-    Log::Info << "Size is " << (transpose ? matrix.n_cols : matrix.n_rows)
-        << " x " << (transpose ? matrix.n_rows : matrix.n_cols) << ".\n";
+    Log::Info << "Size is " << (needTranspose ? matrix.n_cols : matrix.n_rows)
+        << " x " << (needTranspose ? matrix.n_rows : matrix.n_cols) << ".\n";
 
-  // Now transpose the matrix, if necessary.  Armadillo loads HDF5 matrices
-  // transposed, so we have to work around that.
-  if (transpose && loadType != arma::hdf5_binary)
-  {
+  // Now transpose the matrix, if necessary.
+  if (needTranspose)
     inplace_transpose(matrix);
-  }
-  else if (!transpose && loadType == arma::hdf5_binary)
-  {
-    inplace_transpose(matrix);
-  }
 
   Timer::Stop("loading_data");
 
@@ -380,24 +510,41 @@ bool Load(const std::string& filename,
   // Get the extension and load as necessary.
   Timer::Start("loading_data");
 
-  // Get the extension.
-  std::string extension = Extension(filename);
+  // Get the extension (of the data, for compressed files).
+  const bool compressed = IsCompressed(filename);
+  std::string extension = Extension(UncompressedName(filename));
 
-  // Catch nonexistent files by opening the stream ourselves.
-  std::fstream stream;
-  stream.open(filename.c_str(), std::fstream::in);
+  // Native binary files hold their own DatasetInfo.
+  if (extension == "mlbin")
+    return LoadNativeBinaryFile(filename, matrix, &info, fatal);
 
-  if (!stream.is_open())
+  // Catch nonexistent files by opening the stream ourselves.  Compressed files
+  // are decompressed into memory, and read from there.
+  std::fstream fileStream;
+  std::istringstream memoryStream;
+  if (compressed)
   {
-    Timer::Stop("loading_data");
-    if (fatal)
-      Log::Fatal << "Cannot open file '" << filename << "'. " << std::endl;
-    else
-      Log::Warn << "Cannot open file '" << filename << "'; load failed."
-          << std::endl;
+    if (!DecompressFile(filename, memoryStream, fatal))
+      return false;
+  }
+  else
+  {
+    fileStream.open(filename.c_str(), std::fstream::in);
 
-    return false;
+    if (!fileStream.is_open())
+    {
+      Timer::Stop("loading_data");
+      if (fatal)
+        Log::Fatal << "Cannot open file '" << filename << "'. " << std::endl;
+      else
+        Log::Warn << "Cannot open file '" << filename << "'; load failed."
+            << std::endl;
+
+      return false;
+    }
   }
+  std::istream& stream = compressed ? (std::istream&) memoryStream :
+      (std::istream&) fileStream;
 
   if (extension == "csv" || extension == "tsv" || extension == "txt")
   {
@@ -454,8 +601,9 @@ bool Load(const std::string& filename,
       info = DatasetInfo(rows);
     }
 
-    stream.close();
-    stream.open(filename, std::fstream::in);    
+    // Go back to the start of the data.
+    stream.clear();
+    stream.seekg(0);
 
     if(transpose)
     {
@@ -499,7 +647,7 @@ bool Load(const std::string& filename,
         << std::flush;
     try
     {
-      LoadARFF(filename, matrix, info);
+      LoadARFF(stream, matrix, info);
 
       // We transpose by default.  So, un-transpose if necessary...
       if (!transpose)
@@ -535,6 +683,127 @@ bool Load(const std::string& filename,
   return true;
 }
 
+// Load a sparse text file; the "loading_data" timer must be running.
+template<typename eT, typename LabelT>
+bool LoadSparseFile(const std::string& filename,
+                    arma::SpMat<eT>& matrix,
+                    arma::Row<LabelT>* labels,
+                    const bool fatal)
+{
+  const std::string extension = Extension(UncompressedName(filename));
+  const bool libsvm = IsLibSVMExtension(extension);
+  std::string error;
+  if (!libsvm && extension != "coo")
+    error = "unknown sparse format; incorrect extension? (allowed: "
+        "svm/libsvm/svmlight/coo)";
+  else if (labels && !libsvm)
+    error = "only LIBSVM / SVMlight files hold labels";
+
+  if (error.empty())
+  {
+    Log::Info << "Loading '" << filename << "' as "
+        << (libsvm ? "LIBSVM" : "coordinate list") << " data.  " << std::flush;
+
+    try
+    {
+      LoadSparseText(filename, matrix, labels);
+    }
+    catch (std::exception& e)
+    {
+      Log::Info << std::endl;
+      error = e.what();
+    }
+  }
+
+  Timer::Stop("loading_data");
+  if (!error.empty())
+  {
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << error
+          << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << error
+          << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols << ", "
+      << "with " << matrix.n_nonzero << " nonzeros.\n";
+
+  return true;
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          const bool fatal)
+{
+  Timer::Start("loading_data");
+  return LoadSparseFile(filename, matrix, (arma::Row<double>*) NULL, fatal);
+}
+
+template<typename eT, typename LabelT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          arma::Row<LabelT>& labels,
+          const bool fatal)
+{
+  Timer::Start("loading_data");
+  return LoadSparseFile(filename, matrix, &labels, fatal);
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          const std::string& dataset,
+          const size_t firstPoint,
+          const size_t numPoints,
+          const bool fatal)
+{
+  Timer::Start("loading_data");
+
+  std::string error;
+#ifdef HAS_HDF5
+  Log::Info << "Loading points " << firstPoint << " to "
+      << (firstPoint + numPoints) << " of dataset '" << dataset << "' of '"
+      << filename << "' as HDF5 data.  " << std::flush;
+
+  try
+  {
+    HDF5Dataset(filename, dataset).Read(matrix, firstPoint, numPoints);
+  }
+  catch (std::exception& e)
+  {
+    Log::Info << std::endl;
+    error = e.what();
+  }
+#else
+  (void) matrix;
+  (void) dataset;
+  (void) firstPoint;
+  (void) numPoints;
+  error = "mlpack was not compiled with HDF5 support";
+#endif
+
+  Timer::Stop("loading_data");
+  if (!error.empty())
+  {
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << error
+          << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << error
+          << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols << ".\n";
+
+  return true;
+}
+
 // Load a model from file.
 template<typename T>
 bool Load(const std::string& filename,
@@ -545,7 +814,7 @@ bool Load(const std::string& filename,
 {
   if (f == format::autodetect)
   {
-    std::string extension = Extension(filename);
+    std::string extension = Extension(UncompressedName(filename));
 
     if (extension == "xml")
       f = format::xml;
@@ -553,6 +822,8 @@ bool Load(const std::string& filename,
       f = format::binary;
     else if (extension == "txt")
       f = format::text;
+    else if (extension == "mlmodel")
+      f = format::aligned_binary;
     else
     {
       if (fatal)
@@ -566,28 +837,55 @@ bool Load(const std::string& filename,
     }
   }
 
-  // Now load the given format.
-  std::ifstream ifs;
-#ifdef _WIN32 // Open non-text in binary mode on Windows.
-  if (f == format::binary)
-    ifs.open(filename, std::ifstream::in | std::ifstream::binary);
+  // Now load the given format.  Compressed files are decompressed into memory.
+  std::ifstream fileStream;
+  std::istringstream memoryStream;
+  const bool compressed = IsCompressed(filename);
+  if (compressed)
+  {
+    try
+    {
+      std::string contents;
+      Decompress(filename, contents);
+      memoryStream.str(contents);
+    }
+    catch (std::runtime_error& e)
+    {
+      if (fatal)
+        Log::Fatal << "Unable to load object '" << name << "': " << e.what()
+            << std::endl;
+      else
+        Log::Warn << "Unable to load object '" << name << "': " << e.what()
+            << std::endl;
+
+      return false;
+    }
+  }
   else
-    ifs.open(filename, std::ifstream::in);
+  {
+#ifdef _WIN32 // Open non-text in binary mode on Windows.
+    if (f == format::binary || f == format::aligned_binary)
+      fileStream.open(filename, std::ifstream::in | std::ifstream::binary);
+    else
+      fileStream.open(filename, std::ifstream::in);
 #else
-  ifs.open(filename, std::ifstream::in);
+    fileStream.open(filename, std::ifstream::in);
 #endif
 
-  if (!ifs.is_open())
-  {
-    if (fatal)
-      Log::Fatal << "Unable to open file '" << filename << "' to load object '"
-          << name << "'." << std::endl;
-    else
-      Log::Warn << "Unable to open file '" << filename << "' to load object '"
-          << name << "'." << std::endl;
+    if (!fileStream.is_open())
+    {
+      if (fatal)
+        Log::Fatal << "Unable to open file '" << filename << "' to load object "
+            << "'" << name << "'." << std::endl;
+      else
+        Log::Warn << "Unable to open file '" << filename << "' to load object "
+            << "'" << name << "'." << std::endl;
 
-    return false;
+      return false;
+    }
   }
+  std::istream& ifs = compressed ? (std::istream&) memoryStream :
+      (std::istream&) fileStream;
 
   try
   {
@@ -606,6 +904,11 @@ bool Load(const std::string& filename,
       boost::archive::binary_iarchive ar(ifs);
       ar >> CreateNVP(t, name);
     }
+    else if (f == format::aligned_binary)
+    {
+      AlignedBinaryIArchive ar(ifs);
+      ar >> CreateNVP(t, name);
+    }
 
     return true;
   }
@@ -618,6 +921,49 @@ bool Load(const std::string& filename,
 
     return false;
   }
+  catch (std::runtime_error& e)
+  {
+    if (fatal)
+      Log::Fatal << "Unable to load object '" << name << "': " << e.what()
+          << std::endl;
+    else
+      Log::Warn << "Unable to load object '" << name << "': " << e.what()
+          << std::endl;
+
+    return false;
+  }
+}
+
+// Memory-map a native binary file.
+template<typename eT>
+bool Load(const std::string& filename,
+          MappedMatrix<eT>& matrix,
+          const bool fatal)
+{
+  Timer::Start("loading_data");
+
+  try
+  {
+    matrix.Open(filename);
+  }
+  catch (std::runtime_error& e)
+  {
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << e.what() << std::endl;
+    else
+      Log::Warn << "Mapping '" << filename << "' failed: " << e.what()
+          << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Mapped '" << filename << "'; size is "
+      << matrix.Matrix().n_rows << " x " << matrix.Matrix().n_cols << ".\n";
+
+  Timer::Stop("loading_data");
+
+  return true;
 }
 
 } // namespace data
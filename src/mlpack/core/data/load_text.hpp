@@ -0,0 +1,83 @@
+/**
+ * @file load_text.hpp
+ *
+ * A parallel parser for numeric CSV and whitespace-separated (raw ASCII) text
+ * files, used by data::Load() instead of Armadillo's serial parser.
+ */
+#ifndef MLPACK_CORE_DATA_LOAD_TEXT_HPP
+#define MLPACK_CORE_DATA_LOAD_TEXT_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Parse the number in [begin, end), which must hold the whole token (without
+ * surrounding whitespace), and return whether it is a valid number.  Decimal
+ * numbers with at most 15 significant digits and a small exponent (almost all
+ * numbers written by hand or by printf()) are converted exactly without
+ * calling std::strtod(); everything else (long mantissas, large exponents,
+ * "inf", "nan", hexadecimal) is handed to std::strtod().  The character at end
+ * must not be a digit (this is true of any separator or line end).
+ *
+ * @param begin Start of the token.
+ * @param end End of the token.
+ * @param value Parsed number.
+ */
+inline bool ParseNumber(const char* begin, const char* end, double& value);
+
+/**
+ * Load a numeric text file, with one point per line, either comma-separated
+ * (as Armadillo's csv_ascii) or whitespace-separated (as Armadillo's
+ * raw_ascii).  The file is read at once, split at line boundaries, and the
+ * lines are parsed in parallel with OpenMP, straight into the final matrix: if
+ * transpose is true (as for data::Load()), each line is written to a column,
+ * so no transpose is needed after parsing.
+ *
+ * Blank lines are skipped.  In comma-separated files, lines with fewer fields
+ * than the longest line, and empty fields, are filled with zeros; in
+ * whitespace-separated files, all lines must have the same number of fields.
+ * A std::runtime_error is thrown if the file can't be read, if a field isn't a
+ * number, or if the number of fields is inconsistent.
+ *
+ * @param filename Name of the file to load.
+ * @param matrix Matrix to load into.
+ * @param commas Whether the fields are comma-separated (otherwise, they are
+ *     whitespace-separated).
+ * @param transpose Whether each line is a column of the matrix (otherwise, it
+ *     is a row).
+ */
+template<typename eT>
+void LoadText(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              const bool commas,
+              const bool transpose = true);
+
+/**
+ * Parse the given contents of a numeric text file, as LoadText() does; this is
+ * used for files decompressed into memory.  A std::runtime_error is thrown on
+ * failure.
+ *
+ * @param buffer Contents of the file.
+ * @param filename Name of the file (for error messages).
+ * @param matrix Matrix to load into.
+ * @param commas Whether the fields are comma-separated (otherwise, they are
+ *     whitespace-separated).
+ * @param transpose Whether each line is a column of the matrix (otherwise, it
+ *     is a row).
+ */
+template<typename eT>
+void ParseText(const std::string& buffer,
+               const std::string& filename,
+               arma::Mat<eT>& matrix,
+               const bool commas,
+               const bool transpose = true);
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "load_text_impl.hpp"
+
+#endif
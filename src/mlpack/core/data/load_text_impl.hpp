@@ -0,0 +1,320 @@
+/**
+ * @file load_text_impl.hpp
+ *
+ * Implementation of the parallel text parser.
+ */
+#ifndef MLPACK_CORE_DATA_LOAD_TEXT_IMPL_HPP
+#define MLPACK_CORE_DATA_LOAD_TEXT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "load_text.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace mlpack {
+namespace data {
+
+inline bool ParseNumber(const char* begin, const char* end, double& value)
+{
+  // Powers of ten which are exactly representable as doubles.
+  static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+      1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+      1e20, 1e21, 1e22 };
+
+  const char* p = begin;
+  const bool negative = (p != end && *p == '-');
+  if (p != end && (*p == '-' || *p == '+'))
+    ++p;
+
+  // Collect up to 19 significant digits (which fit in a uint64_t), and the
+  // decimal exponent of the last one.
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  for (; p != end && *p >= '0' && *p <= '9'; ++p)
+  {
+    anyDigits = true;
+    if (mantissa == 0 && *p == '0')
+      continue;
+    if (digits < 19)
+    {
+      mantissa = 10 * mantissa + (*p - '0');
+      ++digits;
+    }
+    else
+    {
+      ++exponent;
+    }
+  }
+
+  if (p != end && *p == '.')
+  {
+    for (++p; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+      anyDigits = true;
+      if (mantissa == 0 && *p == '0')
+      {
+        --exponent;
+      }
+      else if (digits < 19)
+      {
+        mantissa = 10 * mantissa + (*p - '0');
+        ++digits;
+        --exponent;
+      }
+    }
+  }
+
+  bool fast = anyDigits;
+  if (fast && p != end && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+    const bool negativeExponent = (p != end && *p == '-');
+    if (p != end && (*p == '-' || *p == '+'))
+      ++p;
+
+    int explicitExponent = 0;
+    fast = (p != end && *p >= '0' && *p <= '9');
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+      if (explicitExponent < 10000)
+        explicitExponent = 10 * explicitExponent + (*p - '0');
+
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+  }
+
+  // The conversion is exact when both the mantissa and the power of ten are
+  // exactly representable, since IEEE multiplication and division round
+  // correctly.
+  if (fast && p == end)
+  {
+    if (mantissa == 0)
+    {
+      value = negative ? -0.0 : 0.0;
+      return true;
+    }
+    else if (digits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+      value = (exponent < 0) ? (double) mantissa / powers[-exponent] :
+          (double) mantissa * powers[exponent];
+      if (negative)
+        value = -value;
+      return true;
+    }
+  }
+
+  // Let std::strtod() handle everything else; it stops before end, since the
+  // character there can't be part of a number.
+  char* stop;
+  value = std::strtod(begin, &stop);
+  return (stop == end && begin != end);
+}
+
+//! Return whether the given character separates fields in a text file.
+inline bool IsTextWhitespace(const char c)
+{
+  return (c == ' ' || c == '\t' || c == '\r');
+}
+
+/**
+ * Count the fields of the line [begin, end): the number of comma-separated
+ * fields (ignoring a trailing comma), or the number of whitespace-separated
+ * fields.  Blank lines have no fields.
+ */
+inline size_t CountTextFields(const char* begin,
+                              const char* end,
+                              const bool commas)
+{
+  // Ignore surrounding whitespace.
+  while (begin != end && IsTextWhitespace(*begin))
+    ++begin;
+  while (end != begin && IsTextWhitespace(*(end - 1)))
+    --end;
+  if (begin == end)
+    return 0;
+
+  size_t fields = 1;
+  if (commas)
+  {
+    for (const char* p = begin; p != end - 1; ++p)
+      if (*p == ',')
+        ++fields;
+  }
+  else
+  {
+    for (const char* p = begin + 1; p != end; ++p)
+      if (!IsTextWhitespace(*p) && IsTextWhitespace(*(p - 1)))
+        ++fields;
+  }
+
+  return fields;
+}
+
+/**
+ * Find the start of each line of the given buffer; line i is
+ * [lineStarts[i], lineStarts[i + 1] - 1), so lineStarts holds one more element
+ * than there are lines.  The last line may end at the terminating zero of the
+ * buffer instead of a newline.
+ */
+inline void FindTextLines(const std::string& buffer,
+                          std::vector<size_t>& lineStarts)
+{
+  const size_t size = buffer.size();
+  const char* data = buffer.c_str();
+  lineStarts.clear();
+  size_t position = 0;
+  while (position < size)
+  {
+    lineStarts.push_back(position);
+    const char* newline = (const char*) std::memchr(data + position, '\n',
+        size - position);
+    position = newline ? (newline - data) + 1 : size + 1;
+  }
+  lineStarts.push_back(position);
+}
+
+template<typename eT>
+void LoadText(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              const bool commas,
+              const bool transpose)
+{
+  // Read the whole file at once.
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  stream.seekg(0, std::ios::end);
+  const size_t size = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  std::string buffer(size, '\0');
+  if (size > 0 && !stream.read(&buffer[0], size))
+    throw std::runtime_error("reading '" + filename + "' failed");
+  stream.close();
+
+  ParseText(buffer, filename, matrix, commas, transpose);
+}
+
+template<typename eT>
+void ParseText(const std::string& buffer,
+               const std::string& filename,
+               arma::Mat<eT>& matrix,
+               const bool commas,
+               const bool transpose)
+{
+  // Find the start of each line.  The buffer is terminated by a zero, which
+  // std::strtod() stops at.
+  const char* data = buffer.c_str();
+  std::vector<size_t> lineStarts;
+  FindTextLines(buffer, lineStarts);
+  const size_t numLines = lineStarts.size() - 1;
+
+  std::vector<size_t> fields(numLines);
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) numLines; ++i)
+  {
+    fields[i] = CountTextFields(data + lineStarts[i],
+        data + lineStarts[i + 1] - 1, commas);
+  }
+
+  // Each non-blank line is a point.
+  std::vector<size_t> points;
+  size_t dimensions = 0;
+  for (size_t i = 0; i < numLines; ++i)
+  {
+    if (fields[i] == 0)
+      continue;
+
+    if (!commas && !points.empty() && fields[i] != dimensions)
+    {
+      std::ostringstream oss;
+      oss << "line " << (i + 1) << " of '" << filename << "' has "
+          << fields[i] << " fields, but line " << (points[0] + 1) << " has "
+          << dimensions;
+      throw std::runtime_error(oss.str());
+    }
+
+    points.push_back(i);
+    dimensions = std::max(dimensions, fields[i]);
+  }
+
+  if (transpose)
+    matrix.set_size(dimensions, points.size());
+  else
+    matrix.set_size(points.size(), dimensions);
+
+  // Parse the lines straight into the matrix.  The first line holding a field
+  // that isn't a number is reported.
+  eT* elements = matrix.memptr();
+  const size_t pointStride = transpose ? dimensions : 1;
+  const size_t dimensionStride = transpose ? 1 : points.size();
+  size_t badLine = numLines;
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (omp_size_t i = 0; i < (omp_size_t) points.size(); ++i)
+  {
+    const size_t line = points[i];
+    const char* p = data + lineStarts[line];
+    const char* lineEnd = data + lineStarts[line + 1] - 1;
+    eT* point = elements + i * pointStride;
+    bool valid = true;
+
+    for (size_t d = 0; d < dimensions; ++d)
+    {
+      // Find the field.
+      while (p != lineEnd && IsTextWhitespace(*p))
+        ++p;
+      const char* fieldBegin = p;
+      if (commas)
+      {
+        while (p != lineEnd && *p != ',')
+          ++p;
+      }
+      else
+      {
+        while (p != lineEnd && !IsTextWhitespace(*p))
+          ++p;
+      }
+      const char* fieldEnd = p;
+      while (fieldEnd != fieldBegin && IsTextWhitespace(*(fieldEnd - 1)))
+        --fieldEnd;
+      if (commas && p != lineEnd)
+        ++p; // Skip the comma.
+
+      // As Armadillo does, missing and unparseable fields of comma-separated
+      // files are zero.
+      double value = 0.0;
+      if (!ParseNumber(fieldBegin, fieldEnd, value))
+      {
+        value = 0.0;
+        if (!commas)
+          valid = false;
+      }
+
+      point[d * dimensionStride] = (eT) value;
+    }
+
+    if (!valid)
+    {
+      #pragma omp critical
+      badLine = std::min(badLine, line);
+    }
+  }
+
+  if (badLine < numLines)
+  {
+    std::ostringstream oss;
+    oss << "line " << (badLine + 1) << " of '" << filename << "' holds a "
+        << "field which is not a number";
+    throw std::runtime_error(oss.str());
+  }
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * @file native_binary.hpp
+ *
+ * Definition of mlpack's native binary matrix format (.mlbin), which stores a
+ * matrix in the column-major layout mlpack uses in memory, so that it can be
+ * loaded with a single read (data::Load()) or memory-mapped without any copy
+ * (MappedMatrix).
+ */
+#ifndef MLPACK_CORE_DATA_NATIVE_BINARY_HPP
+#define MLPACK_CORE_DATA_NATIVE_BINARY_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <cstdint>
+#include <memory>
+
+#include "dataset_info.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The header of a native binary (.mlbin) file.  The file holds, in order:
+ *
+ *  - this header;
+ *  - if infoSize is nonzero, a DatasetInfo serialized with a Boost text
+ *    archive, taking infoSize bytes;
+ *  - zero padding, up to dataOffset (a multiple of 64 bytes);
+ *  - the rows * cols elements of the matrix, in column-major order (one point
+ *    per column, as mlpack uses in memory).
+ *
+ * All fields and elements are in the byte order of the machine that wrote the
+ * file; a file written on a machine with a different byte order is rejected
+ * because of its version field.
+ */
+struct NativeBinaryHeader
+{
+  //! The magic string "MLPKMAT" (with its terminating zero).
+  char magic[8];
+  //! The version of the format (1).
+  uint64_t version;
+  //! The element type (see NativeBinaryElementType()).
+  uint64_t elementType;
+  //! The number of rows of the matrix.
+  uint64_t rows;
+  //! The number of columns (points) of the matrix.
+  uint64_t cols;
+  //! The size of the serialized DatasetInfo, in bytes (0 if there is none).
+  uint64_t infoSize;
+  //! The offset of the elements from the start of the file, in bytes.
+  uint64_t dataOffset;
+};
+
+/**
+ * Return the code stored in NativeBinaryHeader::elementType for the given
+ * element type: 'f' (floating point), 'i' (signed integer) or 'u' (unsigned
+ * integer), times 256, plus the size of the type in bytes.
+ */
+template<typename eT>
+inline uint64_t NativeBinaryElementType()
+{
+  const uint64_t kind = std::is_floating_point<eT>::value ? 'f' :
+      (std::is_signed<eT>::value ? 'i' : 'u');
+  return kind * 256 + sizeof(eT);
+}
+
+/**
+ * Save the given matrix, and optionally its DatasetInfo, to the given file in
+ * the native binary format.  The matrix is written as it is in memory (it is
+ * never transposed).  A std::runtime_error is thrown on failure.
+ *
+ * @param filename Name of the file to write.
+ * @param matrix Matrix to save.
+ * @param info DatasetInfo to save with the matrix, or NULL.
+ */
+template<typename eT>
+void SaveNativeBinary(const std::string& filename,
+                      const arma::Mat<eT>& matrix,
+                      const DatasetInfo* info = NULL);
+
+/**
+ * Write the given matrix, and optionally its DatasetInfo, to the given stream
+ * in the native binary format.  A std::runtime_error is thrown on failure.
+ *
+ * @param stream Stream to write to (opened in binary mode).
+ * @param filename Name of the file the stream writes to (for error messages).
+ * @param matrix Matrix to save.
+ * @param info DatasetInfo to save with the matrix, or NULL.
+ */
+template<typename eT>
+void SaveNativeBinary(std::ostream& stream,
+                      const std::string& filename,
+                      const arma::Mat<eT>& matrix,
+                      const DatasetInfo* info = NULL);
+
+/**
+ * Load a matrix, and optionally its DatasetInfo, from the given native binary
+ * file, with a single read into the matrix's memory.  The element type of the
+ * file must be eT.  A std::runtime_error is thrown on failure.
+ *
+ * @param filename Name of the file to read.
+ * @param matrix Matrix to load into.
+ * @param info If not NULL, the DatasetInfo of the file is loaded into it (or
+ *     a DatasetInfo of all numeric dimensions, if the file holds none).
+ * @return Whether the file holds a DatasetInfo.
+ */
+template<typename eT>
+bool LoadNativeBinary(const std::string& filename,
+                      arma::Mat<eT>& matrix,
+                      DatasetInfo* info = NULL);
+
+/**
+ * Read a matrix, and optionally its DatasetInfo, in the native binary format
+ * from the given stream.  A std::runtime_error is thrown on failure.
+ *
+ * @param stream Stream to read from (opened in binary mode).
+ * @param filename Name of the file the stream reads (for error messages).
+ * @param matrix Matrix to load into.
+ * @param info If not NULL, the DatasetInfo of the file is loaded into it (or
+ *     a DatasetInfo of all numeric dimensions, if the file holds none).
+ * @return Whether the file holds a DatasetInfo.
+ */
+template<typename eT>
+bool LoadNativeBinary(std::istream& stream,
+                      const std::string& filename,
+                      arma::Mat<eT>& matrix,
+                      DatasetInfo* info = NULL);
+
+/**
+ * A matrix which is memory-mapped from a native binary (.mlbin) file, so that
+ * opening the file is nearly instant, and the pages of the matrix are only read
+ * from disk when they are used.  Matrix() is an arma::Mat which uses the mapped
+ * memory without owning it, so it can be given to any mlpack method; it is
+ * valid as long as the MappedMatrix exists.
+ *
+ * The mapping is private: the matrix can be modified, but the modifications are
+ * not written to the file.  The matrix can't be resized.  On systems without
+ * mmap() (Windows), the file is read into memory instead.
+ *
+ * @code
+ * data::MappedMatrix<double> dataset("features.mlbin");
+ * neighbor::KNN knn(dataset.Matrix());
+ * @endcode
+ *
+ * @tparam eT Type of element of the matrix; this must match the file.
+ */
+template<typename eT>
+class MappedMatrix
+{
+ public:
+  //! Create an empty matrix, with no file mapped.
+  MappedMatrix();
+
+  /**
+   * Map the given native binary file.  A std::runtime_error is thrown if the
+   * file can't be mapped, is not a native binary file, or does not hold
+   * elements of type eT.
+   *
+   * @param filename Name of the file to map.
+   */
+  MappedMatrix(const std::string& filename);
+
+  //! Unmap the file.
+  ~MappedMatrix();
+
+  // The mapping can't be shared.
+  MappedMatrix(const MappedMatrix&) = delete;
+  MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+  /**
+   * Map the given native binary file, unmapping the current one (if any).  A
+   * std::runtime_error is thrown on failure, in which case no file is mapped.
+   *
+   * @param filename Name of the file to map.
+   */
+  void Open(const std::string& filename);
+
+  //! Unmap the current file (if any), leaving an empty matrix.
+  void Close();
+
+  //! Get the mapped matrix.
+  const arma::Mat<eT>& Matrix() const { return *matrix; }
+  //! Modify the mapped matrix (the file is not modified).
+  arma::Mat<eT>& Matrix() { return *matrix; }
+
+  //! Return whether the file holds a DatasetInfo.
+  bool HasInfo() const { return hasInfo; }
+  //! Get the DatasetInfo of the file (all dimensions are numeric if the file
+  //! holds none).
+  const DatasetInfo& Info() const { return info; }
+
+ private:
+  //! The matrix, using the mapped memory.
+  std::unique_ptr<arma::Mat<eT>> matrix;
+  //! The start of the mapping (NULL if no file is mapped).
+  void* mapping;
+  //! The size of the mapping, in bytes.
+  size_t mappingSize;
+  //! The DatasetInfo of the file.
+  DatasetInfo info;
+  //! Whether the file holds a DatasetInfo.
+  bool hasInfo;
+};
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "native_binary_impl.hpp"
+
+#endif
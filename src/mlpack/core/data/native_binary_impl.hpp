@@ -0,0 +1,281 @@
+/**
+ * @file native_binary_impl.hpp
+ *
+ * Implementation of the native binary matrix format and of MappedMatrix.
+ */
+#ifndef MLPACK_CORE_DATA_NATIVE_BINARY_IMPL_HPP
+#define MLPACK_CORE_DATA_NATIVE_BINARY_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "native_binary.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include "serialization_shim.hpp"
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+//! The magic string at the start of native binary files.
+static const char nativeBinaryMagic[8] = "MLPKMAT";
+
+/**
+ * Check that the given header is that of a native binary file holding elements
+ * of type eT, and throw a std::runtime_error if not.
+ */
+template<typename eT>
+inline void CheckNativeBinaryHeader(const NativeBinaryHeader& header,
+                                    const std::string& filename)
+{
+  if (std::memcmp(header.magic, nativeBinaryMagic, 8) != 0)
+    throw std::runtime_error("'" + filename + "' is not an mlpack native "
+        "binary file");
+
+  if (header.version != 1)
+    throw std::runtime_error("'" + filename + "' has an unknown native binary "
+        "format version (or was written on a machine with another byte "
+        "order)");
+
+  if (header.elementType != NativeBinaryElementType<eT>())
+  {
+    std::ostringstream oss;
+    oss << "'" << filename << "' holds elements of "
+        << (header.elementType % 256) << " bytes of type '"
+        << (char) (header.elementType / 256) << "', not of the requested type";
+    throw std::runtime_error(oss.str());
+  }
+
+  if (header.dataOffset < sizeof(NativeBinaryHeader) + header.infoSize)
+    throw std::runtime_error("'" + filename + "' has an invalid native binary "
+        "header");
+}
+
+//! Deserialize the DatasetInfo stored in a native binary file.
+inline void ReadNativeBinaryInfo(const std::string& serialized,
+                                 DatasetInfo& info)
+{
+  std::istringstream iss(serialized);
+  boost::archive::text_iarchive ar(iss);
+  ar >> CreateNVP(info, "info");
+}
+
+template<typename eT>
+void SaveNativeBinary(const std::string& filename,
+                      const arma::Mat<eT>& matrix,
+                      const DatasetInfo* info)
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("cannot open '" + filename + "' for writing");
+
+  SaveNativeBinary(stream, filename, matrix, info);
+}
+
+template<typename eT>
+void SaveNativeBinary(std::ostream& stream,
+                      const std::string& filename,
+                      const arma::Mat<eT>& matrix,
+                      const DatasetInfo* info)
+{
+  std::string serializedInfo;
+  if (info)
+  {
+    std::ostringstream oss;
+    {
+      boost::archive::text_oarchive ar(oss);
+      ar << CreateNVP(*info, "info");
+    }
+    serializedInfo = oss.str();
+  }
+
+  NativeBinaryHeader header;
+  std::memcpy(header.magic, nativeBinaryMagic, 8);
+  header.version = 1;
+  header.elementType = NativeBinaryElementType<eT>();
+  header.rows = matrix.n_rows;
+  header.cols = matrix.n_cols;
+  header.infoSize = serializedInfo.size();
+  // Align the elements to 64 bytes (a cache line), which is good for any
+  // element type and for SIMD loads.
+  header.dataOffset = ((sizeof(NativeBinaryHeader) + header.infoSize + 63) /
+      64) * 64;
+
+  stream.write((const char*) &header, sizeof(NativeBinaryHeader));
+  stream.write(serializedInfo.data(), serializedInfo.size());
+  const std::string padding(header.dataOffset - sizeof(NativeBinaryHeader) -
+      header.infoSize, '\0');
+  stream.write(padding.data(), padding.size());
+  stream.write((const char*) matrix.memptr(), sizeof(eT) * matrix.n_elem);
+
+  if (!stream.good())
+    throw std::runtime_error("writing to '" + filename + "' failed");
+}
+
+template<typename eT>
+bool LoadNativeBinary(const std::string& filename,
+                      arma::Mat<eT>& matrix,
+                      DatasetInfo* info)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  return LoadNativeBinary(stream, filename, matrix, info);
+}
+
+template<typename eT>
+bool LoadNativeBinary(std::istream& stream,
+                      const std::string& filename,
+                      arma::Mat<eT>& matrix,
+                      DatasetInfo* info)
+{
+  NativeBinaryHeader header;
+  if (!stream.read((char*) &header, sizeof(NativeBinaryHeader)))
+    throw std::runtime_error("'" + filename + "' is not an mlpack native "
+        "binary file");
+  CheckNativeBinaryHeader<eT>(header, filename);
+
+  std::string serializedInfo(header.infoSize, '\0');
+  stream.read(&serializedInfo[0], header.infoSize);
+
+  // Skip the padding, and read the elements straight into the matrix.
+  stream.ignore(header.dataOffset - sizeof(NativeBinaryHeader) -
+      header.infoSize);
+  matrix.set_size(header.rows, header.cols);
+  stream.read((char*) matrix.memptr(), sizeof(eT) * matrix.n_elem);
+  if (!stream.good())
+    throw std::runtime_error("'" + filename + "' is truncated");
+
+  if (info)
+  {
+    if (header.infoSize > 0)
+      ReadNativeBinaryInfo(serializedInfo, *info);
+    else
+      *info = DatasetInfo(matrix.n_rows);
+  }
+
+  return (header.infoSize > 0);
+}
+
+template<typename eT>
+MappedMatrix<eT>::MappedMatrix() :
+    matrix(new arma::Mat<eT>()),
+    mapping(NULL),
+    mappingSize(0),
+    hasInfo(false)
+{ /* Nothing to do. */ }
+
+template<typename eT>
+MappedMatrix<eT>::MappedMatrix(const std::string& filename) :
+    matrix(new arma::Mat<eT>()),
+    mapping(NULL),
+    mappingSize(0),
+    hasInfo(false)
+{
+  Open(filename);
+}
+
+template<typename eT>
+MappedMatrix<eT>::~MappedMatrix()
+{
+  Close();
+}
+
+template<typename eT>
+void MappedMatrix<eT>::Close()
+{
+  // The matrix must not outlive the memory it uses.
+  matrix.reset(new arma::Mat<eT>());
+  info = DatasetInfo();
+  hasInfo = false;
+
+#ifndef _WIN32
+  if (mapping)
+    munmap(mapping, mappingSize);
+#endif
+  mapping = NULL;
+  mappingSize = 0;
+}
+
+template<typename eT>
+void MappedMatrix<eT>::Open(const std::string& filename)
+{
+  Close();
+
+#ifdef _WIN32
+  // There is no mmap(), so read the file instead.
+  hasInfo = LoadNativeBinary(filename, *matrix, &info);
+#else
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      (size_t) status.st_size < sizeof(NativeBinaryHeader))
+  {
+    close(fd);
+    throw std::runtime_error("'" + filename + "' is not an mlpack native "
+        "binary file");
+  }
+
+  // The mapping is private, so the matrix can be modified without writing to
+  // the file.  The file descriptor is not needed once the file is mapped.
+  void* address = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("cannot map '" + filename + "'");
+
+  mapping = address;
+  mappingSize = status.st_size;
+
+  const NativeBinaryHeader& header = *((const NativeBinaryHeader*) mapping);
+  try
+  {
+    CheckNativeBinaryHeader<eT>(header, filename);
+    if (mappingSize < header.dataOffset + sizeof(eT) * header.rows *
+        header.cols)
+      throw std::runtime_error("'" + filename + "' is truncated");
+
+    const char* bytes = (const char*) mapping;
+    if (header.infoSize > 0)
+    {
+      ReadNativeBinaryInfo(std::string(bytes + sizeof(NativeBinaryHeader),
+          header.infoSize), info);
+      hasInfo = true;
+    }
+    else
+    {
+      info = DatasetInfo(header.rows);
+    }
+  }
+  catch (...)
+  {
+    Close();
+    throw;
+  }
+
+  // Use the mapped elements without copying them; the matrix can't be resized
+  // (strict mode).
+  eT* elements = (eT*) ((char*) mapping + header.dataOffset);
+  matrix.reset(new arma::Mat<eT>(elements, header.rows, header.cols, false,
+      true));
+#endif
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,218 @@
+/**
+ * @file prefetching_loader.hpp
+ *
+ * Definition of the PrefetchingLoader class, which reads the next chunk of a
+ * dataset on a background thread while the current chunk is processed.
+ */
+#ifndef MLPACK_CORE_DATA_PREFETCHING_LOADER_HPP
+#define MLPACK_CORE_DATA_PREFETCHING_LOADER_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/math/random.hpp>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <numeric>
+
+#include "chunked_io.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The PrefetchingLoader class reads a dataset in chunks of a fixed number of
+ * points with a ChunkedLoader (so any format it supports may be used), but
+ * reads each chunk on a background thread while the caller processes the
+ * previous one.  Two buffers are used: the caller's chunk, and the chunk being
+ * read, whose memory is swapped with the caller's matrix by Next(), so that
+ * the memory of the chunks is reused.
+ *
+ * The background thread can also prepare each chunk for training:
+ *
+ *  - if shuffle is true, the points of each chunk are put in a random order,
+ *    so that each run of consecutive points is a random mini-batch stored
+ *    contiguously, which can be given directly to the batched Evaluate() and
+ *    Gradient() functions of the FFN class (through its Train() function);
+ *  - if a transform is given, it is applied to each chunk (after shuffling),
+ *    for instance to augment or normalize the points.
+ *
+ * Each chunk is shuffled with its own random stream (see math::RandomStreams),
+ * seeded from the generator of the thread that creates the loader, so the
+ * order of the points does not depend on the timing of the threads.  Each
+ * pass over the file (after Reset()) uses new streams, so the points are
+ * shuffled differently for each epoch.
+ *
+ * For instance, to train a network on a dataset which doesn't fit in memory,
+ * stored with the responses in its last row:
+ *
+ * @code
+ * data::PrefetchingLoader<double> loader("train.csv", 100000, true);
+ * arma::mat chunk;
+ * while (loader.Next(chunk))
+ * {
+ *   // The next chunk is read and shuffled while the network is trained.
+ *   const arma::mat predictors = chunk.rows(0, chunk.n_rows - 2);
+ *   const arma::mat responses = chunk.row(chunk.n_rows - 1);
+ *   net.Train(predictors, responses, optimizer);
+ * }
+ * @endcode
+ *
+ * The memory of a chunk returned by Next() is refilled by the next call after
+ * that, so no alias to it should be kept.
+ *
+ * @tparam eT Type of element in the loaded matrix.
+ */
+template<typename eT>
+class PrefetchingLoader
+{
+ public:
+  //! The type of the functions applied to each chunk.
+  typedef std::function<void(arma::Mat<eT>&)> TransformType;
+
+  /**
+   * Open the given file and start reading its first chunk.  A
+   * std::runtime_error is thrown if the file can't be opened or has an
+   * unsupported format, and a std::invalid_argument if chunkSize is 0.
+   *
+   * @param filename Name of the file to read.
+   * @param chunkSize Number of points of each chunk (except the last).
+   * @param shuffle If true, the points of each chunk are shuffled.
+   * @param transform Function to apply to each chunk on the background thread
+   *     (optional).
+   */
+  PrefetchingLoader(const std::string& filename,
+                    const size_t chunkSize,
+                    const bool shuffle = false,
+                    const TransformType& transform = TransformType()) :
+      loader(filename),
+      chunkSize(chunkSize),
+      shuffle(shuffle),
+      transform(transform),
+      chunksRead(0),
+      pointsRead(0)
+  {
+    if (chunkSize == 0)
+      throw std::invalid_argument("PrefetchingLoader: chunkSize must be "
+          "greater than 0");
+
+    StartRead();
+  }
+
+  //! Wait for the chunk being read, if any.
+  ~PrefetchingLoader()
+  {
+    if (pending.valid())
+      pending.wait();
+  }
+
+  /**
+   * Get the next chunk of the file, waiting for it to be read if necessary,
+   * and start reading the chunk after it.  Returns false (and leaves the
+   * given matrix unchanged) when the end of the file is reached.  The
+   * exceptions thrown while reading the chunk (see ChunkedLoader::Next()) or
+   * by the transform are thrown here.
+   *
+   * @param chunk Matrix to store the points in.
+   */
+  bool Next(arma::Mat<eT>& chunk)
+  {
+    if (!pending.valid())
+      return false;
+    if (!pending.get())
+      return false;
+
+    chunk.swap(buffer);
+    pointsRead += chunk.n_cols;
+    StartRead();
+    return true;
+  }
+
+  /**
+   * Go back to the first point of the file.  The chunk being read, if any, is
+   * discarded.
+   */
+  void Reset()
+  {
+    if (pending.valid())
+      pending.wait();
+    pending = std::future<bool>();
+
+    loader.Reset();
+    pointsRead = 0;
+    StartRead();
+  }
+
+  //! Get the number of points returned by Next() so far.
+  size_t PointsRead() const { return pointsRead; }
+
+  //! Get the number of points of each chunk.
+  size_t ChunkSize() const { return chunkSize; }
+
+ private:
+  //! Start reading the next chunk on the background thread.
+  void StartRead()
+  {
+    const size_t chunkIndex = chunksRead++;
+    pending = std::async(std::launch::async, [this, chunkIndex]()
+    {
+      return Read(chunkIndex);
+    });
+  }
+
+  //! Read and prepare the next chunk into the buffer (on the background
+  //! thread).
+  bool Read(const size_t chunkIndex)
+  {
+    if (!loader.Next(buffer, chunkSize))
+      return false;
+
+    if (shuffle)
+    {
+      std::vector<size_t> order(buffer.n_cols);
+      std::iota(order.begin(), order.end(), 0);
+      std::mt19937 generator = streams.Stream(chunkIndex);
+      std::shuffle(order.begin(), order.end(), generator);
+
+      shuffled.set_size(buffer.n_rows, buffer.n_cols);
+      for (size_t i = 0; i < order.size(); ++i)
+        shuffled.col(i) = buffer.col(order[i]);
+      buffer.swap(shuffled);
+    }
+
+    if (transform)
+      transform(buffer);
+
+    return true;
+  }
+
+  //! The reader of the file (only used by the background thread while a
+  //! chunk is being read).
+  ChunkedLoader<eT> loader;
+  //! The number of points of each chunk.
+  size_t chunkSize;
+  //! If true, the points of each chunk are shuffled.
+  bool shuffle;
+  //! The function applied to each chunk (if any).
+  TransformType transform;
+  //! The random streams the chunks are shuffled with.
+  math::RandomStreams streams;
+  //! The number of chunks whose reading was started (the index of the random
+  //! stream of the next chunk).
+  size_t chunksRead;
+  //! The number of points returned by Next() so far.
+  size_t pointsRead;
+
+  //! The chunk being read.
+  arma::Mat<eT> buffer;
+  //! The memory the points of the chunk being read are shuffled into.
+  arma::Mat<eT> shuffled;
+
+  //! The result of the read of the next chunk (declared last, so that the
+  //! read is finished before the other members are destroyed).
+  std::future<bool> pending;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -14,6 +14,9 @@
 #include <string>
 
 #include "format.hpp"
+#include "dataset_info.hpp"
+#include "native_binary.hpp"
+#include "sparse_text.hpp"
 
 namespace mlpack {
 namespace data /** Functions to load and save matrices. */ {
@@ -33,13 +36,18 @@ namespace data /** Functions to load and save matrices. */ {
  *  - Raw binary (raw_binary), denoted by .bin
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5 (hdf5_binary), denoted by .hdf5, .hdf, .h5, or .he5
+ *  - mlpack native binary (see native_binary.hpp), denoted by .mlbin
+ *
+ * Any of these except HDF5 may be gzip-compressed, denoted by an extra .gz
+ * extension (such as .csv.gz).
  *
  * If the file extension is not one of those types, an error will be given.  If
  * the 'fatal' parameter is set to true, a std::runtime_error exception will be
  * thrown upon failure.  If the 'transpose' parameter is set to true, the matrix
  * will be transposed before saving.  Generally, because mlpack stores matrices
  * in a column-major format and most datasets are stored on disk as row-major,
- * this parameter should be left at its default value of 'true'.
+ * this parameter should be left at its default value of 'true'.  Native binary
+ * files store the matrix column-major, so they are never transposed.
  *
  * @param filename Name of file to save to.
  * @param matrix Matrix to save into file.
@@ -53,6 +61,58 @@ bool Save(const std::string& filename,
           const bool fatal = false,
           bool transpose = true);
 
+/**
+ * Saves a matrix and its DatasetInfo to an mlpack native binary (.mlbin) file,
+ * so that both can be loaded back with data::Load() (or the matrix mapped with
+ * MappedMatrix).  Other extensions give an error, since no other format can
+ * hold the DatasetInfo.  If the 'fatal' parameter is set to true, a
+ * std::runtime_error exception will be thrown upon failure.
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Matrix to save into file.
+ * @param info DatasetInfo to save with the matrix.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of save.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const DatasetInfo& info,
+          const bool fatal = false);
+
+/**
+ * Saves a sparse matrix, with one point per column, to a sparse text file,
+ * guessing the format from the extension: LIBSVM / SVMlight (.svm, .libsvm or
+ * .svmlight; every label is 0) or coordinate lists (.coo), optionally
+ * gzip-compressed (.gz).  See sparse_text.hpp.  If the 'fatal' parameter is set
+ * to true, a std::runtime_error exception will be thrown upon failure.
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Sparse matrix to save into file.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of save.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          const bool fatal = false);
+
+/**
+ * Saves a sparse matrix and the labels of its points to a LIBSVM / SVMlight
+ * file (.svm, .libsvm or .svmlight, optionally followed by .gz).
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Sparse matrix to save into file.
+ * @param labels Label of each point.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of save.
+ */
+template<typename eT, typename LabelT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          const arma::Row<LabelT>& labels,
+          const bool fatal = false);
+
 /**
  * Saves a model to file, guessing the filetype from the extension, or,
  * optionally, saving the specified format.  If automatic extension detection is
@@ -64,9 +124,13 @@ bool Save(const std::string& filename,
  *  - text, denoted by .txt
  *  - xml, denoted by .xml
  *  - binary, denoted by .bin
+ *  - binary with matrices stored as raw blocks aligned to 64 bytes, denoted by
+ *    .mlmodel (see AlignedBinaryOArchive); this is the fastest format for
+ *    models holding large matrices
  *
  * The format parameter can take any of the values in the 'format' enum:
- * 'format::autodetect', 'format::text', 'format::xml', and 'format::binary'.
+ * 'format::autodetect', 'format::text', 'format::xml', 'format::binary', and
+ * 'format::aligned_binary'.
  * The autodetect functionality operates on the file extension (so, "file.txt"
  * would be autodetected as text).
  *
@@ -10,17 +10,62 @@
 // In case it hasn't already been included.
 #include "save.hpp"
 #include "extension.hpp"
+#include "compression.hpp"
+#include "save_text.hpp"
 
+#include <sstream>
 #include <boost/serialization/serialization.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 
 #include "serialization_shim.hpp"
+#include "aligned_binary_archive.hpp"
 
 namespace mlpack {
 namespace data {
 
+// Save a native binary file; the "saving_data" timer must be running.
+template<typename eT>
+bool SaveNativeBinaryFile(const std::string& filename,
+                          const arma::Mat<eT>& matrix,
+                          const DatasetInfo* info,
+                          const bool fatal)
+{
+  Log::Info << "Saving mlpack native binary data to '" << filename << "'."
+      << std::endl;
+
+  try
+  {
+    if (IsCompressed(filename))
+    {
+      std::ostringstream stream;
+      SaveNativeBinary(stream, filename, matrix, info);
+      Compress(filename, stream.str());
+    }
+    else
+    {
+      SaveNativeBinary(filename, matrix, info);
+    }
+  }
+  catch (std::runtime_error& e)
+  {
+    Timer::Stop("saving_data");
+    if (fatal)
+      Log::Fatal << "Save to '" << filename << "' failed: " << e.what()
+          << std::endl;
+    else
+      Log::Warn << "Save to '" << filename << "' failed: " << e.what()
+          << std::endl;
+
+    return false;
+  }
+
+  Timer::Stop("saving_data");
+
+  return true;
+}
+
 template<typename eT>
 bool Save(const std::string& filename,
           const arma::Mat<eT>& matrix,
@@ -29,8 +74,10 @@ bool Save(const std::string& filename,
 {
   Timer::Start("saving_data");
 
-  // First we will try to discriminate by file extension.
-  std::string extension = Extension(filename);
+  // First we will try to discriminate by file extension (of the data, for
+  // compressed files).
+  const bool compressed = IsCompressed(filename);
+  std::string extension = Extension(UncompressedName(filename));
   if (extension == "")
   {
     Timer::Stop("saving_data");
@@ -44,25 +91,36 @@ bool Save(const std::string& filename,
     return false;
   }
 
-  // Catch errors opening the file.
-  std::fstream stream;
+  // Native binary files are written directly, and never transposed.
+  if (extension == "mlbin")
+    return SaveNativeBinaryFile(filename, matrix, NULL, fatal);
+
+  // Catch errors opening the file.  Compressed files are written to memory,
+  // and compressed to the file at the end.
+  std::fstream fileStream;
+  std::ostringstream memoryStream;
+  if (!compressed)
+  {
 #ifdef  _WIN32 // Always open in binary mode on Windows.
-  stream.open(filename.c_str(), std::fstream::out | std::fstream::binary);
+    fileStream.open(filename.c_str(), std::fstream::out | std::fstream::binary);
 #else
-  stream.open(filename.c_str(), std::fstream::out);
+    fileStream.open(filename.c_str(), std::fstream::out);
 #endif
-  if (!stream.is_open())
-  {
-    Timer::Stop("saving_data");
-    if (fatal)
-      Log::Fatal << "Cannot open file '" << filename << "' for writing. "
-          << "Save failed." << std::endl;
-    else
-      Log::Warn << "Cannot open file '" << filename << "' for writing; save "
-          << "failed." << std::endl;
+    if (!fileStream.is_open())
+    {
+      Timer::Stop("saving_data");
+      if (fatal)
+        Log::Fatal << "Cannot open file '" << filename << "' for writing. "
+            << "Save failed." << std::endl;
+      else
+        Log::Warn << "Cannot open file '" << filename << "' for writing; save "
+            << "failed." << std::endl;
 
-    return false;
+      return false;
+    }
   }
+  std::ostream& stream = compressed ? (std::ostream&) memoryStream :
+      (std::ostream&) fileStream;
 
   bool unknownType = false;
   arma::file_type saveType;
@@ -129,13 +187,47 @@ bool Save(const std::string& filename,
     return false;
   }
 
+  // Armadillo can only save HDF5 files by name.
+  if (compressed && saveType == arma::hdf5_binary)
+  {
+    Timer::Stop("saving_data");
+    if (fatal)
+      Log::Fatal << "Cannot save to '" << filename << "': compressed HDF5 "
+          << "files are not supported." << std::endl;
+    else
+      Log::Warn << "Cannot save to '" << filename << "': compressed HDF5 "
+          << "files are not supported." << std::endl;
+
+    return false;
+  }
+
   // Try to save the file.
   Log::Info << "Saving " << stringType << " to '" << filename << "'."
       << std::endl;
 
-  // Transpose the matrix.  If we are saving HDF5, Armadillo already transposes
-  // this on save, so we don't need to.
-  if ((transpose && saveType != arma::hdf5_binary) ||
+  // Numeric text is formatted in parallel by SaveText(), straight from the
+  // matrix.  Otherwise, transpose the matrix.  If we are saving HDF5, Armadillo
+  // already transposes this on save, so we don't need to.
+  if (saveType == arma::csv_ascii || saveType == arma::raw_ascii)
+  {
+    try
+    {
+      SaveText(stream, matrix, saveType == arma::csv_ascii, transpose);
+    }
+    catch (std::runtime_error& e)
+    {
+      Timer::Stop("saving_data");
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed: " << e.what()
+            << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed: " << e.what()
+            << std::endl;
+
+      return false;
+    }
+  }
+  else if ((transpose && saveType != arma::hdf5_binary) ||
       (!transpose && saveType == arma::hdf5_binary))
   {
     arma::Mat<eT> tmp = trans(matrix);
@@ -173,12 +265,124 @@ bool Save(const std::string& filename,
     }
   }
 
+  if (compressed)
+  {
+    try
+    {
+      Compress(filename, memoryStream.str());
+    }
+    catch (std::runtime_error& e)
+    {
+      Timer::Stop("saving_data");
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed: " << e.what()
+            << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed: " << e.what()
+            << std::endl;
+
+      return false;
+    }
+  }
+
   Timer::Stop("saving_data");
 
   // Finally return success.
   return true;
 }
 
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const DatasetInfo& info,
+          const bool fatal)
+{
+  Timer::Start("saving_data");
+
+  if (Extension(UncompressedName(filename)) != "mlbin")
+  {
+    Timer::Stop("saving_data");
+    if (fatal)
+      Log::Fatal << "Cannot save a DatasetInfo to '" << filename << "'; only "
+          << "mlpack native binary (.mlbin) files can hold one." << std::endl;
+    else
+      Log::Warn << "Cannot save a DatasetInfo to '" << filename << "'; only "
+          << "mlpack native binary (.mlbin) files can hold one.  Save failed."
+          << std::endl;
+
+    return false;
+  }
+
+  return SaveNativeBinaryFile(filename, matrix, &info, fatal);
+}
+
+// Save a sparse text file; the "saving_data" timer must be running.
+template<typename eT, typename LabelT>
+bool SaveSparseFile(const std::string& filename,
+                    const arma::SpMat<eT>& matrix,
+                    const arma::Row<LabelT>* labels,
+                    const bool fatal)
+{
+  const std::string extension = Extension(UncompressedName(filename));
+  const bool libsvm = IsLibSVMExtension(extension);
+  std::string error;
+  if (!libsvm && extension != "coo")
+    error = "unknown sparse format; incorrect extension? (allowed: "
+        "svm/libsvm/svmlight/coo)";
+  else if (labels && !libsvm)
+    error = "only LIBSVM / SVMlight files hold labels";
+
+  if (error.empty())
+  {
+    Log::Info << "Saving " << (libsvm ? "LIBSVM" : "coordinate list")
+        << " data to '" << filename << "'." << std::endl;
+
+    try
+    {
+      SaveSparseText(filename, matrix, labels);
+    }
+    catch (std::exception& e)
+    {
+      error = e.what();
+    }
+  }
+
+  Timer::Stop("saving_data");
+  if (!error.empty())
+  {
+    if (fatal)
+      Log::Fatal << "Save to '" << filename << "' failed: " << error
+          << std::endl;
+    else
+      Log::Warn << "Save to '" << filename << "' failed: " << error
+          << std::endl;
+
+    return false;
+  }
+
+  return true;
+}
+
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          const bool fatal)
+{
+  Timer::Start("saving_data");
+  return SaveSparseFile(filename, matrix, (const arma::Row<double>*) NULL,
+      fatal);
+}
+
+template<typename eT, typename LabelT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          const arma::Row<LabelT>& labels,
+          const bool fatal)
+{
+  Timer::Start("saving_data");
+  return SaveSparseFile(filename, matrix, &labels, fatal);
+}
+
 //! Save a model to file.
 template<typename T>
 bool Save(const std::string& filename,
@@ -189,7 +393,7 @@ bool Save(const std::string& filename,
 {
   if (f == format::autodetect)
   {
-    std::string extension = Extension(filename);
+    std::string extension = Extension(UncompressedName(filename));
 
     if (extension == "xml")
       f = format::xml;
@@ -197,42 +401,53 @@ bool Save(const std::string& filename,
       f = format::binary;
     else if (extension == "txt")
       f = format::text;
+    else if (extension == "mlmodel")
+      f = format::aligned_binary;
     else
     {
       if (fatal)
         Log::Fatal << "Unable to detect type of '" << filename << "'; incorrect"
-            << " extension? (allowed: xml/bin/txt)" << std::endl;
+            << " extension? (allowed: xml/bin/txt/mlmodel)" << std::endl;
       else
         Log::Warn << "Unable to detect type of '" << filename << "'; save "
-            << "failed.  Incorrect extension? (allowed: xml/bin/txt)"
+            << "failed.  Incorrect extension? (allowed: xml/bin/txt/mlmodel)"
             << std::endl;
 
       return false;
     }
   }
 
-  // Open the file to save to.
-  std::ofstream ofs;
+  // Open the file to save to.  Compressed files are written to memory, and
+  // compressed to the file at the end.
+  std::ofstream fileStream;
+  std::ostringstream memoryStream;
+  const bool compressed = IsCompressed(filename);
+  if (!compressed)
+  {
 #ifdef _WIN32
-  if (f == format::binary) // Open non-text types in binary mode on Windows.
-    ofs.open(filename, std::ofstream::out | std::ofstream::binary);
-  else
-    ofs.open(filename, std::ofstream::out);
+    // Open non-text types in binary mode on Windows.
+    if (f == format::binary || f == format::aligned_binary)
+      fileStream.open(filename, std::ofstream::out | std::ofstream::binary);
+    else
+      fileStream.open(filename, std::ofstream::out);
 #else
-  ofs.open(filename, std::ofstream::out);
+    fileStream.open(filename, std::ofstream::out);
 #endif
 
-  if (!ofs.is_open())
-  {
-    if (fatal)
-      Log::Fatal << "Unable to open file '" << filename << "' to save object '"
-          << name << "'." << std::endl;
-    else
-      Log::Warn << "Unable to open file '" << filename << "' to save object '"
-          << name << "'." << std::endl;
+    if (!fileStream.is_open())
+    {
+      if (fatal)
+        Log::Fatal << "Unable to open file '" << filename << "' to save object "
+            << "'" << name << "'." << std::endl;
+      else
+        Log::Warn << "Unable to open file '" << filename << "' to save object "
+            << "'" << name << "'." << std::endl;
 
-    return false;
+      return false;
+    }
   }
+  std::ostream& ofs = compressed ? (std::ostream&) memoryStream :
+      (std::ostream&) fileStream;
 
   try
   {
@@ -251,6 +466,15 @@ bool Save(const std::string& filename,
       boost::archive::binary_oarchive ar(ofs);
       ar << CreateNVP(t, name);
     }
+    else if (f == format::aligned_binary)
+    {
+      AlignedBinaryOArchive ar(ofs);
+      ar << CreateNVP(t, name);
+    }
+
+    // The archive is complete once it is destroyed.
+    if (compressed)
+      Compress(filename, memoryStream.str());
 
     return true;
   }
@@ -263,6 +487,17 @@ bool Save(const std::string& filename,
 
     return false;
   }
+  catch (std::runtime_error& e)
+  {
+    if (fatal)
+      Log::Fatal << "Unable to save object '" << name << "': " << e.what()
+          << std::endl;
+    else
+      Log::Warn << "Unable to save object '" << name << "': " << e.what()
+          << std::endl;
+
+    return false;
+  }
 }
 
 } // namespace data
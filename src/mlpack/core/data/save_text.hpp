@@ -0,0 +1,86 @@
+/**
+ * @file save_text.hpp
+ *
+ * A parallel writer for numeric CSV and whitespace-separated (raw ASCII) text
+ * files, used by data::Save() instead of Armadillo's serial writer.
+ */
+#ifndef MLPACK_CORE_DATA_SAVE_TEXT_HPP
+#define MLPACK_CORE_DATA_SAVE_TEXT_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace data {
+
+//! The maximum number of characters written by FormatNumber().
+const size_t MaxFormattedNumberLength = 32;
+
+/**
+ * Write the given number to the buffer, with the fewest significant digits
+ * which read back (with ParseNumber() or std::strtod()) to exactly the same
+ * number, and return the number of characters written (at most
+ * MaxFormattedNumberLength; no terminating zero is counted).  Integral values
+ * below 1e15 are written as integers without calling std::snprintf(); other
+ * values are written as by "%.15g", "%.16g" or "%.17g" (the first which reads
+ * back exactly).
+ *
+ * @param value Number to write.
+ * @param buffer Buffer to write to.
+ */
+inline size_t FormatNumber(const double value, char* buffer);
+
+/**
+ * Write the given single-precision number to the buffer with the fewest
+ * significant digits which read back to the same float, and return the number
+ * of characters written.
+ *
+ * @param value Number to write.
+ * @param buffer Buffer to write to.
+ */
+inline size_t FormatNumber(const float value, char* buffer);
+
+/**
+ * Write the given integer to the buffer, and return the number of characters
+ * written.
+ *
+ * @param value Number to write.
+ * @param buffer Buffer to write to.
+ */
+template<typename eT>
+inline typename std::enable_if<std::is_integral<eT>::value, size_t>::type
+FormatNumber(const eT value, char* buffer);
+
+/**
+ * Write a numeric text file, with one point per line, either comma-separated
+ * (as Armadillo's csv_ascii) or whitespace-separated (as Armadillo's
+ * raw_ascii), and with every number written by FormatNumber() so that it loads
+ * back exactly.  If transpose is true (as for data::Save()), each column of the
+ * matrix is written as a line, straight from the column-major memory, so no
+ * transposed copy is made.
+ *
+ * The lines are split into blocks, which are formatted in parallel with OpenMP
+ * into a buffer each and then written in order, a batch of blocks at a time, so
+ * the memory used doesn't depend on the size of the matrix.  Matrices of
+ * complex numbers are written by Armadillo.  A std::runtime_error is thrown if
+ * the stream can't be written.
+ *
+ * @param stream Stream to write to.
+ * @param matrix Matrix to write.
+ * @param commas Whether the fields are comma-separated (otherwise, they are
+ *     separated by spaces).
+ * @param transpose Whether each column of the matrix is a line (otherwise, each
+ *     row is).
+ */
+template<typename eT>
+void SaveText(std::ostream& stream,
+              const arma::Mat<eT>& matrix,
+              const bool commas,
+              const bool transpose = true);
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "save_text_impl.hpp"
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file save_text_impl.hpp
+ *
+ * Implementation of the parallel text writer.
+ */
+#ifndef MLPACK_CORE_DATA_SAVE_TEXT_IMPL_HPP
+#define MLPACK_CORE_DATA_SAVE_TEXT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "save_text.hpp"
+#include "load_text.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Write the given unsigned integer to the buffer, preceded by a minus sign if
+ * negative is true, and return the number of characters written.
+ */
+inline size_t FormatUnsigned(uint64_t value,
+                             const bool negative,
+                             char* buffer)
+{
+  // Write the digits backwards, then copy them.
+  char digits[20];
+  size_t numDigits = 0;
+  do
+  {
+    digits[numDigits++] = (char) ('0' + (value % 10));
+    value /= 10;
+  } while (value != 0);
+
+  size_t length = 0;
+  if (negative)
+    buffer[length++] = '-';
+  while (numDigits > 0)
+    buffer[length++] = digits[--numDigits];
+
+  return length;
+}
+
+inline size_t FormatNumber(const double value, char* buffer)
+{
+  // Integral values (such as labels and assignments) are written directly.
+  // (This is false for NaN, and infinities are too large.)
+  if (value == std::floor(value) && std::abs(value) < 1e15)
+  {
+    if (value < 0.0 || (value == 0.0 && std::signbit(value)))
+      return FormatUnsigned((uint64_t) -value, true, buffer);
+    else
+      return FormatUnsigned((uint64_t) value, false, buffer);
+  }
+
+  // Any number with at most 15 significant digits reads back to itself, so the
+  // shortest representation has 15 digits or fewer (after "%g" strips trailing
+  // zeros) if there is one; otherwise 16 or 17 digits are needed.
+  int length = 0;
+  for (int precision = 15; precision <= 17; ++precision)
+  {
+    length = std::snprintf(buffer, MaxFormattedNumberLength, "%.*g",
+        precision, value);
+    double parsed;
+    if (value != value || (ParseNumber(buffer, buffer + length, parsed) &&
+        parsed == value))
+      break;
+  }
+
+  return (size_t) length;
+}
+
+inline size_t FormatNumber(const float value, char* buffer)
+{
+  if (value == std::floor(value) && std::abs(value) < 1e7f)
+  {
+    if (value < 0.0f || (value == 0.0f && std::signbit(value)))
+      return FormatUnsigned((uint64_t) -value, true, buffer);
+    else
+      return FormatUnsigned((uint64_t) value, false, buffer);
+  }
+
+  // Any number with at most 6 significant digits reads back to itself as a
+  // float, and 9 digits are always enough.
+  int length = 0;
+  for (int precision = 6; precision <= 9; ++precision)
+  {
+    length = std::snprintf(buffer, MaxFormattedNumberLength, "%.*g",
+        precision, (double) value);
+    if (value != value || std::strtof(buffer, NULL) == value)
+      break;
+  }
+
+  return (size_t) length;
+}
+
+template<typename eT>
+inline typename std::enable_if<std::is_integral<eT>::value, size_t>::type
+FormatNumber(const eT value, char* buffer)
+{
+  // The magnitude of the most negative value is computed without overflow.
+  if (value < 0)
+    return FormatUnsigned(uint64_t(-(value + 1)) + 1, true, buffer);
+  else
+    return FormatUnsigned((uint64_t) value, false, buffer);
+}
+
+/**
+ * Write the given matrix as text with Armadillo (for matrices of complex
+ * numbers, which FormatNumber() doesn't support).
+ */
+template<typename eT>
+void SaveTextMatrix(std::ostream& stream,
+                    const arma::Mat<eT>& matrix,
+                    const bool commas,
+                    const bool transpose,
+                    const std::false_type /* arithmetic */)
+{
+  const arma::file_type type = commas ? arma::csv_ascii : arma::raw_ascii;
+  const bool success = transpose ? arma::Mat<eT>(matrix.t()).save(stream, type)
+      : matrix.save(stream, type);
+  if (!success)
+    throw std::runtime_error("writing the matrix failed");
+}
+
+/**
+ * Write the given matrix of numbers as text, formatting blocks of lines in
+ * parallel.
+ */
+template<typename eT>
+void SaveTextMatrix(std::ostream& stream,
+                    const arma::Mat<eT>& matrix,
+                    const bool commas,
+                    const bool transpose,
+                    const std::true_type /* arithmetic */)
+{
+  const size_t numLines = transpose ? matrix.n_cols : matrix.n_rows;
+  const size_t numFields = transpose ? matrix.n_rows : matrix.n_cols;
+  const size_t lineStride = transpose ? matrix.n_rows : 1;
+  const size_t fieldStride = transpose ? 1 : matrix.n_rows;
+  const char separator = commas ? ',' : ' ';
+
+  // Each block holds about 64k numbers, and each batch a few blocks per
+  // thread, so that the threads are balanced.
+  const size_t linesPerBlock = std::max((size_t) 1,
+      (size_t) 65536 / std::max(numFields, (size_t) 1));
+  const size_t numBlocks = (numLines + linesPerBlock - 1) / linesPerBlock;
+#ifdef _OPENMP
+  const size_t batchSize = 4 * (size_t) omp_get_max_threads();
+#else
+  const size_t batchSize = 1;
+#endif
+  const size_t maxLineLength = numFields * (MaxFormattedNumberLength + 1) + 1;
+
+  const eT* elements = matrix.memptr();
+  std::vector<std::string> buffers(std::min(batchSize, numBlocks));
+  for (size_t batch = 0; batch < numBlocks; batch += batchSize)
+  {
+    const size_t batchEnd = std::min(numBlocks, batch + batchSize);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = (omp_size_t) batch; b < (omp_size_t) batchEnd; ++b)
+    {
+      const size_t begin = b * linesPerBlock;
+      const size_t end = std::min(numLines, begin + linesPerBlock);
+
+      // Make room for the longest possible lines; the buffer keeps its
+      // capacity from one batch to the next.
+      std::string& buffer = buffers[b - batch];
+      buffer.resize((end - begin) * maxLineLength);
+      char* out = &buffer[0];
+      for (size_t line = begin; line < end; ++line)
+      {
+        const eT* point = elements + line * lineStride;
+        for (size_t f = 0; f < numFields; ++f)
+        {
+          if (f > 0)
+            *out++ = separator;
+          out += FormatNumber(point[f * fieldStride], out);
+        }
+        *out++ = '\n';
+      }
+      buffer.resize(out - &buffer[0]);
+    }
+
+    for (size_t b = batch; b < batchEnd; ++b)
+      stream.write(buffers[b - batch].data(), buffers[b - batch].size());
+    if (!stream.good())
+      throw std::runtime_error("writing the matrix failed");
+  }
+}
+
+template<typename eT>
+void SaveText(std::ostream& stream,
+              const arma::Mat<eT>& matrix,
+              const bool commas,
+              const bool transpose)
+{
+  SaveTextMatrix(stream, matrix, commas, transpose,
+      std::integral_constant<bool, std::is_arithmetic<eT>::value>());
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -34,4 +34,13 @@ struct version<mlpack::data::SecondShim<T>> \
 } \
 }
 
+/**
+ * A comma, for the arguments of BOOST_TEMPLATE_CLASS_VERSION() that contain
+ * one (such as templates with more than one parameter):
+ *
+ * BOOST_TEMPLATE_CLASS_VERSION(template<typename A MLPACK_COMMA typename B>,
+ *     Pair<A MLPACK_COMMA B>, 1);
+ */
+#define MLPACK_COMMA ,
+
 #endif
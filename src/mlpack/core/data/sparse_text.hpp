@@ -0,0 +1,100 @@
+/**
+ * @file sparse_text.hpp
+ *
+ * Parallel readers and writers for sparse text formats, which data::Load() and
+ * data::Save() use for sparse matrices:
+ *
+ *  - LIBSVM / SVMlight (.svm, .libsvm, .svmlight): one point per line, written
+ *    as "label index:value index:value ...", with indices starting at 1 and
+ *    in increasing order.  "qid:" fields and comments (from '#' to the end of
+ *    the line) are ignored.
+ *  - coordinate lists (.coo): one nonzero per line, written as
+ *    "point dimension value", with indices starting at 0.
+ *
+ * As for dense data, each point of the file is a column of the loaded matrix.
+ */
+#ifndef MLPACK_CORE_DATA_SPARSE_TEXT_HPP
+#define MLPACK_CORE_DATA_SPARSE_TEXT_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace data {
+
+//! Return whether the given extension denotes a LIBSVM / SVMlight file.
+inline bool IsLibSVMExtension(const std::string& extension)
+{
+  return (extension == "svm" || extension == "libsvm" ||
+      extension == "svmlight");
+}
+
+/**
+ * Parse the given contents of a LIBSVM / SVMlight file in parallel, building
+ * the sparse matrix directly in compressed sparse column form: the nonzeros of
+ * each line are counted first, so that each line is then parsed straight to
+ * its place.  The number of dimensions is the largest index in the file.
+ * Explicit zeros are dropped.  A std::runtime_error is thrown if a line can't
+ * be parsed, or if an index is repeated within a line.
+ *
+ * @param buffer Contents of the file.
+ * @param filename Name of the file (for error messages).
+ * @param matrix Sparse matrix to load into, with one point per column.
+ * @param labels If not NULL, set to the label of each point.
+ */
+template<typename eT, typename LabelT>
+void ParseLibSVM(const std::string& buffer,
+                 const std::string& filename,
+                 arma::SpMat<eT>& matrix,
+                 arma::Row<LabelT>* labels);
+
+/**
+ * Parse the given contents of a coordinate list file in parallel.  The number
+ * of points and dimensions are one more than the largest indices in the file.
+ * A std::runtime_error is thrown if a line can't be parsed.
+ *
+ * @param buffer Contents of the file.
+ * @param filename Name of the file (for error messages).
+ * @param matrix Sparse matrix to load into, with one point per column.
+ */
+template<typename eT>
+void ParseCoordinateList(const std::string& buffer,
+                         const std::string& filename,
+                         arma::SpMat<eT>& matrix);
+
+/**
+ * Load a sparse text file (either format, chosen by the extension), which may
+ * be gzip-compressed.  A std::runtime_error is thrown on failure.
+ *
+ * @param filename Name of the file to load.
+ * @param matrix Sparse matrix to load into, with one point per column.
+ * @param labels If not NULL, set to the label of each point (LIBSVM only).
+ */
+template<typename eT, typename LabelT>
+void LoadSparseText(const std::string& filename,
+                    arma::SpMat<eT>& matrix,
+                    arma::Row<LabelT>* labels);
+
+/**
+ * Save a sparse matrix, with one point per column, to a sparse text file
+ * (either format, chosen by the extension), which may be gzip-compressed.  The
+ * points are formatted in parallel.  A std::invalid_argument is thrown if the
+ * number of labels is not the number of points, and a std::runtime_error is
+ * thrown if the file can't be written.
+ *
+ * @param filename Name of the file to save.
+ * @param matrix Sparse matrix to save.
+ * @param labels If not NULL, the label of each point (LIBSVM only; otherwise
+ *     every label is 0).
+ */
+template<typename eT, typename LabelT>
+void SaveSparseText(const std::string& filename,
+                    const arma::SpMat<eT>& matrix,
+                    const arma::Row<LabelT>* labels);
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "sparse_text_impl.hpp"
+
+#endif
@@ -0,0 +1,455 @@
+/**
+ * @file sparse_text_impl.hpp
+ *
+ * Implementation of the sparse text readers and writers.
+ */
+#ifndef MLPACK_CORE_DATA_SPARSE_TEXT_IMPL_HPP
+#define MLPACK_CORE_DATA_SPARSE_TEXT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sparse_text.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "load_text.hpp"
+#include "compression.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Return the end of the content of the line [begin, end), without a comment
+ * (starting at '#') or trailing whitespace.
+ */
+inline const char* SparseTextLineEnd(const char* begin, const char* end)
+{
+  const char* comment = (const char*) std::memchr(begin, '#', end - begin);
+  if (comment)
+    end = comment;
+  while (end != begin && IsTextWhitespace(*(end - 1)))
+    --end;
+
+  return end;
+}
+
+/**
+ * Find the next whitespace-separated token of [p, end), and move p past it.
+ * Return false if there are no more tokens.
+ */
+inline bool NextSparseTextToken(const char*& p,
+                                const char* end,
+                                const char*& tokenBegin,
+                                const char*& tokenEnd)
+{
+  while (p != end && IsTextWhitespace(*p))
+    ++p;
+  if (p == end)
+    return false;
+
+  tokenBegin = p;
+  while (p != end && !IsTextWhitespace(*p))
+    ++p;
+  tokenEnd = p;
+
+  return true;
+}
+
+//! Parse the nonnegative integer [begin, end); return whether it is valid.
+inline bool ParseIndex(const char* begin, const char* end, size_t& value)
+{
+  value = 0;
+  for (const char* p = begin; p != end; ++p)
+  {
+    if (*p < '0' || *p > '9')
+      return false;
+    value = 10 * value + (*p - '0');
+  }
+
+  return (begin != end);
+}
+
+//! Return whether [begin, end) is a LIBSVM "index:value" field.
+inline bool IsLibSVMField(const char* begin, const char* end)
+{
+  if (end - begin >= 4 && std::strncmp(begin, "qid:", 4) == 0)
+    return false;
+
+  return (std::memchr(begin, ':', end - begin) != NULL);
+}
+
+/**
+ * Build a sparse matrix from the given nonzeros, which are in column-major
+ * order; any zero values are removed first.
+ */
+template<typename eT>
+void BuildSparseMatrix(arma::umat& locations,
+                       arma::Col<eT>& values,
+                       const size_t rows,
+                       const size_t cols,
+                       const bool sorted,
+                       arma::SpMat<eT>& matrix)
+{
+  size_t kept = 0;
+  for (size_t i = 0; i < values.n_elem; ++i)
+  {
+    if (values[i] == eT(0))
+      continue;
+
+    if (kept != i)
+    {
+      locations(0, kept) = locations(0, i);
+      locations(1, kept) = locations(1, i);
+      values[kept] = values[i];
+    }
+    ++kept;
+  }
+
+  if (kept == 0)
+  {
+    matrix.zeros(rows, cols);
+  }
+  else if (kept == values.n_elem)
+  {
+    matrix = arma::SpMat<eT>(locations, values, rows, cols, !sorted);
+  }
+  else
+  {
+    matrix = arma::SpMat<eT>(locations.cols(0, kept - 1),
+        values.subvec(0, kept - 1), rows, cols, !sorted);
+  }
+}
+
+template<typename eT, typename LabelT>
+void ParseLibSVM(const std::string& buffer,
+                 const std::string& filename,
+                 arma::SpMat<eT>& matrix,
+                 arma::Row<LabelT>* labels)
+{
+  const char* data = buffer.c_str();
+  std::vector<size_t> lineStarts;
+  FindTextLines(buffer, lineStarts);
+  const size_t numLines = lineStarts.size() - 1;
+
+  // Count the nonzeros of each line; lines without any token are not points.
+  std::vector<size_t> counts(numLines);
+  std::vector<char> isPoint(numLines);
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) numLines; ++i)
+  {
+    const char* p = data + lineStarts[i];
+    const char* end = SparseTextLineEnd(p, data + lineStarts[i + 1] - 1);
+    const char* tokenBegin;
+    const char* tokenEnd;
+    size_t count = 0;
+    isPoint[i] = 0;
+    while (NextSparseTextToken(p, end, tokenBegin, tokenEnd))
+    {
+      isPoint[i] = 1;
+      if (IsLibSVMField(tokenBegin, tokenEnd))
+        ++count;
+    }
+    counts[i] = count;
+  }
+
+  // The nonzeros of the i'th point start at offsets[i].
+  std::vector<size_t> points;
+  std::vector<size_t> offsets(1, 0);
+  for (size_t i = 0; i < numLines; ++i)
+  {
+    if (!isPoint[i])
+      continue;
+
+    points.push_back(i);
+    offsets.push_back(offsets.back() + counts[i]);
+  }
+
+  const size_t nonzeros = offsets.back();
+  arma::umat locations(2, nonzeros);
+  arma::Col<eT> values(nonzeros);
+  arma::vec pointLabels(points.size());
+  std::vector<size_t> maxIndices(points.size(), 0);
+  size_t badLine = numLines;
+
+  // Parse each point straight to its place.
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (omp_size_t i = 0; i < (omp_size_t) points.size(); ++i)
+  {
+    const size_t line = points[i];
+    const char* p = data + lineStarts[line];
+    const char* end = SparseTextLineEnd(p, data + lineStarts[line + 1] - 1);
+    const char* tokenBegin;
+    const char* tokenEnd;
+    bool valid = true;
+    bool sorted = true;
+
+    // The first token is the label, unless it is already a field.
+    pointLabels[i] = 0.0;
+    const char* labelEnd = p;
+    NextSparseTextToken(labelEnd, end, tokenBegin, tokenEnd);
+    if (!IsLibSVMField(tokenBegin, tokenEnd))
+    {
+      double label;
+      valid = ParseNumber(tokenBegin, tokenEnd, label);
+      pointLabels[i] = label;
+      p = labelEnd;
+    }
+
+    size_t k = offsets[i];
+    while (valid && NextSparseTextToken(p, end, tokenBegin, tokenEnd))
+    {
+      if (!IsLibSVMField(tokenBegin, tokenEnd))
+      {
+        // Only "qid:" fields may be skipped.
+        valid = (std::memchr(tokenBegin, ':', tokenEnd - tokenBegin) != NULL);
+        continue;
+      }
+
+      const char* colon = (const char*) std::memchr(tokenBegin, ':',
+          tokenEnd - tokenBegin);
+      size_t index;
+      double value;
+      if (!ParseIndex(tokenBegin, colon, index) || index == 0 ||
+          !ParseNumber(colon + 1, tokenEnd, value))
+      {
+        valid = false;
+        break;
+      }
+
+      if (k > offsets[i] && index - 1 <= locations(0, k - 1))
+        sorted = false;
+      locations(0, k) = index - 1;
+      locations(1, k) = i;
+      values[k] = (eT) value;
+      maxIndices[i] = std::max(maxIndices[i], index);
+      ++k;
+    }
+
+    // LIBSVM files should list the indices in order, but we accept any order,
+    // as long as no index is repeated.
+    if (valid && !sorted)
+    {
+      std::vector<std::pair<arma::uword, eT>> fields;
+      for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+        fields.push_back(std::make_pair(locations(0, j), values[j]));
+      std::sort(fields.begin(), fields.end(),
+          [](const std::pair<arma::uword, eT>& a,
+             const std::pair<arma::uword, eT>& b) { return a.first < b.first; });
+
+      for (size_t j = 0; j < fields.size(); ++j)
+      {
+        if (j > 0 && fields[j].first == fields[j - 1].first)
+          valid = false;
+        locations(0, offsets[i] + j) = fields[j].first;
+        values[offsets[i] + j] = fields[j].second;
+      }
+    }
+
+    if (!valid)
+    {
+      #pragma omp critical
+      badLine = std::min(badLine, line);
+    }
+  }
+
+  if (badLine < numLines)
+  {
+    std::ostringstream oss;
+    oss << "line " << (badLine + 1) << " of '" << filename << "' is not a "
+        << "valid LIBSVM line (a field can't be parsed, or an index is "
+        << "repeated)";
+    throw std::runtime_error(oss.str());
+  }
+
+  size_t dimensions = 0;
+  for (size_t i = 0; i < maxIndices.size(); ++i)
+    dimensions = std::max(dimensions, maxIndices[i]);
+
+  BuildSparseMatrix(locations, values, dimensions, points.size(), true, matrix);
+  if (labels)
+    *labels = arma::conv_to<arma::Row<LabelT>>::from(pointLabels.t());
+}
+
+template<typename eT>
+void ParseCoordinateList(const std::string& buffer,
+                         const std::string& filename,
+                         arma::SpMat<eT>& matrix)
+{
+  const char* data = buffer.c_str();
+  std::vector<size_t> lineStarts;
+  FindTextLines(buffer, lineStarts);
+  const size_t numLines = lineStarts.size() - 1;
+
+  // Each line that isn't blank holds one nonzero.
+  std::vector<size_t> entries;
+  for (size_t i = 0; i < numLines; ++i)
+  {
+    const char* begin = data + lineStarts[i];
+    if (SparseTextLineEnd(begin, data + lineStarts[i + 1] - 1) != begin)
+      entries.push_back(i);
+  }
+
+  arma::umat locations(2, entries.size());
+  arma::Col<eT> values(entries.size());
+  size_t badLine = numLines;
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) entries.size(); ++i)
+  {
+    const size_t line = entries[i];
+    const char* p = data + lineStarts[line];
+    const char* end = SparseTextLineEnd(p, data + lineStarts[line + 1] - 1);
+    const char* tokenBegin[3];
+    const char* tokenEnd[3];
+    bool valid = true;
+    for (size_t t = 0; t < 3 && valid; ++t)
+      valid = NextSparseTextToken(p, end, tokenBegin[t], tokenEnd[t]);
+
+    const char* extraBegin;
+    const char* extraEnd;
+    size_t point, dimension;
+    double value = 0.0;
+    valid = valid && !NextSparseTextToken(p, end, extraBegin, extraEnd) &&
+        ParseIndex(tokenBegin[0], tokenEnd[0], point) &&
+        ParseIndex(tokenBegin[1], tokenEnd[1], dimension) &&
+        ParseNumber(tokenBegin[2], tokenEnd[2], value);
+
+    if (valid)
+    {
+      locations(0, i) = dimension;
+      locations(1, i) = point;
+      values[i] = (eT) value;
+    }
+    else
+    {
+      #pragma omp critical
+      badLine = std::min(badLine, line);
+    }
+  }
+
+  if (badLine < numLines)
+  {
+    std::ostringstream oss;
+    oss << "line " << (badLine + 1) << " of '" << filename << "' is not a "
+        << "valid coordinate list line (point, dimension and value)";
+    throw std::runtime_error(oss.str());
+  }
+
+  const size_t dimensions = entries.empty() ? 0 : locations.row(0).max() + 1;
+  const size_t points = entries.empty() ? 0 : locations.row(1).max() + 1;
+  BuildSparseMatrix(locations, values, dimensions, points, false, matrix);
+}
+
+template<typename eT, typename LabelT>
+void LoadSparseText(const std::string& filename,
+                    arma::SpMat<eT>& matrix,
+                    arma::Row<LabelT>* labels)
+{
+  // Read the whole file at once.
+  std::string buffer;
+  if (IsCompressed(filename))
+  {
+    Decompress(filename, buffer);
+  }
+  else
+  {
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("cannot open '" + filename + "'");
+
+    stream.seekg(0, std::ios::end);
+    const size_t size = (size_t) stream.tellg();
+    stream.seekg(0, std::ios::beg);
+
+    buffer.resize(size);
+    if (size > 0 && !stream.read(&buffer[0], size))
+      throw std::runtime_error("reading '" + filename + "' failed");
+  }
+
+  if (IsLibSVMExtension(Extension(UncompressedName(filename))))
+  {
+    ParseLibSVM(buffer, filename, matrix, labels);
+  }
+  else
+  {
+    ParseCoordinateList(buffer, filename, matrix);
+    if (labels)
+      labels->reset();
+  }
+}
+
+template<typename eT, typename LabelT>
+void SaveSparseText(const std::string& filename,
+                    const arma::SpMat<eT>& matrix,
+                    const arma::Row<LabelT>* labels)
+{
+  const bool libsvm = IsLibSVMExtension(Extension(UncompressedName(filename)));
+  if (libsvm && labels && labels->n_elem != matrix.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "there are " << labels->n_elem << " labels for " << matrix.n_cols
+        << " points";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Format blocks of points in parallel, then write the blocks in order.
+  typedef typename arma::SpMat<eT>::const_iterator Iterator;
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (matrix.n_cols + blockSize - 1) / blockSize;
+  std::vector<std::string> blocks(numBlocks);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<eT>::max_digits10);
+    const size_t end = std::min((size_t) (b + 1) * blockSize,
+        (size_t) matrix.n_cols);
+    for (size_t c = b * blockSize; c < end; ++c)
+    {
+      if (libsvm)
+      {
+        if (labels)
+          oss << (*labels)[c];
+        else
+          oss << 0;
+        for (Iterator it = matrix.begin_col(c); it != matrix.end_col(c); ++it)
+          oss << ' ' << (it.row() + 1) << ':' << (*it);
+        oss << '\n';
+      }
+      else
+      {
+        for (Iterator it = matrix.begin_col(c); it != matrix.end_col(c); ++it)
+          oss << c << ' ' << it.row() << ' ' << (*it) << '\n';
+      }
+    }
+    blocks[b] = oss.str();
+  }
+
+  if (IsCompressed(filename))
+  {
+    std::string contents;
+    for (size_t b = 0; b < numBlocks; ++b)
+      contents += blocks[b];
+    Compress(filename, contents);
+  }
+  else
+  {
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("cannot open '" + filename + "'");
+
+    for (size_t b = 0; b < numBlocks; ++b)
+      stream.write(blocks[b].data(), blocks[b].size());
+    if (!stream)
+      throw std::runtime_error("writing '" + filename + "' failed");
+  }
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -3,7 +3,8 @@
  * @author Tham Ngap Wei, Keon Kim
  *
  * Defines Split(), a utility function to split a dataset into a
- * training set and a test set.
+ * training set and a test set, and SplitIndices() and SplitInPlace(), which
+ * split a dataset without copying it.
  */
 #ifndef MLPACK_CORE_DATA_SPLIT_DATA_HPP
 #define MLPACK_CORE_DATA_SPLIT_DATA_HPP
@@ -12,6 +13,80 @@
 
 namespace mlpack {
 namespace data {
+
+/**
+ * Randomly split the indices of a dataset with the given number of points into
+ * the indices of a training set and the indices of a test set, without touching
+ * any data.  The subsets can be used as non-contiguous views of the data
+ * (input.cols(trainIndices)), or to split several objects the same way.
+ *
+ * @code
+ * arma::mat input = loadData();
+ * arma::uvec trainIndices, testIndices;
+ * SplitIndices(input.n_cols, 0.3, trainIndices, testIndices);
+ * arma::vec trainMean = arma::mean(input.cols(trainIndices), 1);
+ * @endcode
+ *
+ * @param numPoints Number of points in the dataset.
+ * @param testRatio Percentage of dataset to use for test set (between 0 and 1).
+ * @param trainIndices Vector to store the indices of training points into.
+ * @param testIndices Vector to store the indices of test points into.
+ */
+inline void SplitIndices(const size_t numPoints,
+                         const double testRatio,
+                         arma::uvec& trainIndices,
+                         arma::uvec& testIndices)
+{
+  const size_t testSize = static_cast<size_t>(numPoints * testRatio);
+  const size_t trainSize = numPoints - testSize;
+
+  if (numPoints == 0)
+  {
+    trainIndices.reset();
+    testIndices.reset();
+    return;
+  }
+
+  const arma::uvec order =
+      arma::shuffle(arma::linspace<arma::uvec>(0, numPoints - 1, numPoints));
+
+  trainIndices = (trainSize == 0) ? arma::uvec() :
+      arma::uvec(order.subvec(0, trainSize - 1));
+  testIndices = (testSize == 0) ? arma::uvec() :
+      arma::uvec(order.subvec(trainSize, numPoints - 1));
+}
+
+/**
+ * Reorder the columns of the given matrix in place, so that column i holds
+ * what was column order[i].  Each cycle of the permutation is followed with a
+ * single column of temporary storage.
+ *
+ * @param matrix Matrix to reorder.
+ * @param order Permutation of the column indices of the matrix.
+ */
+template<typename T>
+void PermuteColumns(arma::Mat<T>& matrix, const arma::uvec& order)
+{
+  std::vector<bool> done(order.n_elem, false);
+  arma::Col<T> temp(matrix.n_rows);
+  for (size_t i = 0; i < order.n_elem; ++i)
+  {
+    if (done[i] || order[i] == i)
+      continue;
+
+    temp = matrix.col(i);
+    size_t j = i;
+    while (order[j] != i)
+    {
+      matrix.col(j) = matrix.col(order[j]);
+      done[j] = true;
+      j = order[j];
+    }
+    matrix.col(j) = temp;
+    done[j] = true;
+  }
+}
+
 /**
  * Given an input dataset and labels, split into a training set and test set.
  * Example usage below.  This overload places the split dataset into the four
@@ -49,28 +124,13 @@ void Split(const arma::Mat<T>& input,
            arma::Row<U>& testLabel,
            const double testRatio)
 {
-  const size_t testSize = static_cast<size_t>(input.n_cols * testRatio);
-  const size_t trainSize = input.n_cols - testSize;
-  trainData.set_size(input.n_rows, trainSize);
-  testData.set_size(input.n_rows, testSize);
-  trainLabel.set_size(trainSize);
-  testLabel.set_size(testSize);
-
-  const arma::Col<size_t> order =
-      arma::shuffle(arma::linspace<arma::Col<size_t>>(0, input.n_cols - 1,
-                                                      input.n_cols));
-
-  for (size_t i = 0; i != trainSize; ++i)
-  {
-    trainData.col(i) = input.col(order[i]);
-    trainLabel(i) = inputLabel(order[i]);
-  }
+  arma::uvec trainIndices, testIndices;
+  SplitIndices(input.n_cols, testRatio, trainIndices, testIndices);
 
-  for (size_t i = 0; i != testSize; ++i)
-  {
-    testData.col(i) = input.col(order[i + trainSize]);
-    testLabel(i) = inputLabel(order[i + trainSize]);
-  }
+  trainData = input.cols(trainIndices);
+  testData = input.cols(testIndices);
+  trainLabel = inputLabel.cols(trainIndices);
+  testLabel = inputLabel.cols(testIndices);
 }
 
 /**
@@ -100,23 +160,11 @@ void Split(const arma::Mat<T>& input,
            arma::Mat<T>& testData,
            const double testRatio)
 {
-  const size_t testSize = static_cast<size_t>(input.n_cols * testRatio);
-  const size_t trainSize = input.n_cols - testSize;
-  trainData.set_size(input.n_rows, trainSize);
-  testData.set_size(input.n_rows, testSize);
+  arma::uvec trainIndices, testIndices;
+  SplitIndices(input.n_cols, testRatio, trainIndices, testIndices);
 
-  const arma::Col<size_t> order =
-      arma::shuffle(arma::linspace<arma::Col<size_t>>(0, input.n_cols -1,
-                                                      input.n_cols));
-
-  for (size_t i = 0; i != trainSize; ++i)
-  {
-    trainData.col(i) = input.col(order[i]);
-  }
-  for (size_t i = 0; i != testSize; ++i)
-  {
-    testData.col(i) = input.col(order[i + trainSize]);
-  }
+  trainData = input.cols(trainIndices);
+  testData = input.cols(testIndices);
 }
 
 /**
@@ -187,6 +235,68 @@ Split(const arma::Mat<T>& input,
                          std::move(testData));
 }
 
+/**
+ * Given an input dataset and labels, split them into a training set and test
+ * set in place, without copying: the columns of the dataset (and the labels)
+ * are randomly permuted, so that the first columns are the training set and the
+ * remaining columns are the test set.  The number of training points is
+ * returned.  The sets can then be used as contiguous views (or as matrices
+ * using the memory of the input, with the advanced Armadillo constructor).
+ *
+ * @code
+ * arma::mat input = loadData();
+ * arma::Row<size_t> label = loadLabel();
+ * const size_t trainSize = SplitInPlace(input, label, 0.3);
+ * arma::mat trainData(input.memptr(), input.n_rows, trainSize, false, true);
+ * arma::mat testData(input.colptr(trainSize), input.n_rows,
+ *     input.n_cols - trainSize, false, true);
+ * @endcode
+ *
+ * @param input Input dataset to split; its columns are permuted.
+ * @param inputLabel Input labels to split; they are permuted like the dataset.
+ * @param testRatio Percentage of dataset to use for test set (between 0 and 1).
+ * @return Number of training points (the first columns of input).
+ */
+template<typename T, typename U>
+size_t SplitInPlace(arma::Mat<T>& input,
+                    arma::Row<U>& inputLabel,
+                    const double testRatio)
+{
+  arma::uvec trainIndices, testIndices;
+  SplitIndices(input.n_cols, testRatio, trainIndices, testIndices);
+
+  const arma::uvec order = arma::join_cols(trainIndices, testIndices);
+  PermuteColumns(input, order);
+  PermuteColumns(inputLabel, order);
+
+  return trainIndices.n_elem;
+}
+
+/**
+ * Given an input dataset, split it into a training set and test set in place,
+ * as the overload above does, but without labels.
+ *
+ * @code
+ * arma::mat input = loadData();
+ * const size_t trainSize = SplitInPlace(input, 0.3);
+ * // Train on input.cols(0, trainSize - 1), test on the remaining columns.
+ * @endcode
+ *
+ * @param input Input dataset to split; its columns are permuted.
+ * @param testRatio Percentage of dataset to use for test set (between 0 and 1).
+ * @return Number of training points (the first columns of input).
+ */
+template<typename T>
+size_t SplitInPlace(arma::Mat<T>& input, const double testRatio)
+{
+  arma::uvec trainIndices, testIndices;
+  SplitIndices(input.n_cols, testRatio, trainIndices, testIndices);
+
+  PermuteColumns(input, arma::join_cols(trainIndices, testIndices));
+
+  return trainIndices.n_elem;
+}
+
 } // namespace data
 } // namespace mlpack
 
@@ -0,0 +1,302 @@
+/**
+ * @file split_files.hpp
+ *
+ * Defines SplitFiles(), which splits a dataset file (and optionally a labels
+ * file) into a training set file and a test set file as the points are read, so
+ * that datasets much larger than memory can be split.
+ */
+#ifndef MLPACK_CORE_DATA_SPLIT_FILES_HPP
+#define MLPACK_CORE_DATA_SPLIT_FILES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
+#include <mlpack/core/data/split_data.hpp>
+
+#include <cstdio>
+
+namespace mlpack {
+namespace data {
+
+namespace split_files_detail {
+
+/**
+ * Read exactly as many labels as the given number of points (the labels
+ * loader may return shorter chunks than asked for), and throw if there are not
+ * enough of them.
+ */
+inline void ReadLabels(ChunkedLoader<double>& loader,
+                       const size_t numPoints,
+                       const std::string& labelsFile,
+                       arma::mat& labels)
+{
+  labels.reset();
+  arma::mat part;
+  while (labels.n_cols < numPoints &&
+      loader.Next(part, numPoints - labels.n_cols))
+  {
+    labels = labels.is_empty() ? part : arma::join_rows(labels, part);
+  }
+
+  if (labels.n_cols < numPoints)
+    throw std::runtime_error("SplitFiles(): '" + labelsFile + "' has fewer "
+        "labels than there are points");
+}
+
+/**
+ * Write the first dimensionality rows of the given points to the data saver
+ * and the other rows (the labels, if any) to the labels saver.
+ */
+inline void WritePoints(const arma::mat& points,
+                        const size_t dimensionality,
+                        ChunkedSaver& saver,
+                        ChunkedSaver* labelsSaver)
+{
+  if (points.n_cols == 0)
+    return;
+
+  if (labelsSaver == NULL)
+  {
+    saver.Write(points);
+    return;
+  }
+
+  saver.Write(arma::mat(points.rows(0, dimensionality - 1)));
+  labelsSaver->Write(arma::mat(points.rows(dimensionality,
+      points.n_rows - 1)));
+}
+
+/**
+ * Shuffle the columns of the given buffer in place.
+ */
+inline void ShuffleColumns(arma::mat& buffer)
+{
+  if (buffer.n_cols > 1)
+  {
+    PermuteColumns(buffer, arma::shuffle(arma::linspace<arma::uvec>(0,
+        buffer.n_cols - 1, buffer.n_cols)));
+  }
+}
+
+/**
+ * Shuffle the given run of training points and write it to a new temporary
+ * file, whose name is appended to the given list.
+ */
+inline void WriteRun(arma::mat& run,
+                     const std::string& trainingFile,
+                     std::vector<std::string>& runFiles,
+                     std::vector<size_t>& runSizes)
+{
+  ShuffleColumns(run);
+  std::ostringstream runFile;
+  runFile << trainingFile << ".run" << runFiles.size() << ".mlbin";
+  runFiles.push_back(runFile.str());
+  runSizes.push_back(run.n_cols);
+  ChunkedSaver(runFiles.back()).Write(run);
+}
+
+} // namespace split_files_detail
+
+/**
+ * Split the points of the given dataset file (and the labels of the given
+ * labels file, if it is not empty) into a training set file and a test set
+ * file, reading chunkSize points at a time, so that memory does not depend on
+ * the size of the dataset.  Each point is put in the test set with probability
+ * testRatio (drawn from the random number generator, so the split is
+ * reproducible with math::RandomSeed()), so the size of the test set is only
+ * approximately testRatio times the size of the dataset.  The test set keeps
+ * the order of the dataset.
+ *
+ * The input files can have any format of ChunkedLoader, and the output files
+ * any format of ChunkedSaver: CSV or text, or, much faster and smaller for
+ * large datasets, mlpack native binary (.mlbin) or HDF5.  Each label file holds
+ * one label (or one vector of responses) per point.
+ *
+ * If shuffleBufferSize is not 0, the training set is shuffled in external
+ * memory: the training points are collected into runs of shuffleBufferSize
+ * points, which are shuffled in memory and written to temporary native binary
+ * files next to the training file, and the runs are then merged, taking each
+ * next point from a run chosen with probability proportional to the number of
+ * points left in it.  This gives a uniformly random order of the training set,
+ * with about shuffleBufferSize points (plus a chunk) in memory at any time.
+ * The temporary files are removed afterwards.
+ *
+ * A std::runtime_error is thrown if a file can't be read or written, or if the
+ * labels file has fewer or more labels than there are points.
+ *
+ * @param inputFile File holding the dataset.
+ * @param inputLabelsFile File holding the labels ("" for no labels).
+ * @param trainingFile File to write the training points to.
+ * @param testFile File to write the test points to.
+ * @param trainingLabelsFile File to write the training labels to (if there are
+ *     labels).
+ * @param testLabelsFile File to write the test labels to (if there are
+ *     labels).
+ * @param testRatio Probability of each point to be put in the test set.
+ * @param chunkSize Number of points to read at a time.
+ * @param shuffleBufferSize Number of training points to shuffle in memory at a
+ *     time (0 keeps the order of the dataset).
+ * @return The number of points in the training set and in the test set.
+ */
+inline std::pair<size_t, size_t> SplitFiles(
+    const std::string& inputFile,
+    const std::string& inputLabelsFile,
+    const std::string& trainingFile,
+    const std::string& testFile,
+    const std::string& trainingLabelsFile,
+    const std::string& testLabelsFile,
+    const double testRatio,
+    const size_t chunkSize,
+    const size_t shuffleBufferSize = 0)
+{
+  using namespace split_files_detail;
+
+  if (chunkSize == 0)
+    throw std::invalid_argument("SplitFiles(): chunkSize must be positive");
+
+  ChunkedLoader<double> loader(inputFile);
+  ChunkedSaver trainingSaver(trainingFile);
+  ChunkedSaver testSaver(testFile);
+  std::unique_ptr<ChunkedLoader<double>> labelsLoader;
+  std::unique_ptr<ChunkedSaver> trainingLabelsSaver, testLabelsSaver;
+  if (!inputLabelsFile.empty())
+  {
+    labelsLoader.reset(new ChunkedLoader<double>(inputLabelsFile));
+    trainingLabelsSaver.reset(new ChunkedSaver(trainingLabelsFile));
+    testLabelsSaver.reset(new ChunkedSaver(testLabelsFile));
+  }
+
+  // The labels are carried as extra rows of the points.
+  size_t dimensionality = 0, rows = 0;
+  arma::mat chunk, labels, buffer;
+  size_t buffered = 0;
+  std::vector<std::string> runFiles;
+  std::vector<size_t> runSizes;
+  while (loader.Next(chunk, chunkSize))
+  {
+    dimensionality = chunk.n_rows;
+    if (labelsLoader)
+    {
+      ReadLabels(*labelsLoader, chunk.n_cols, inputLabelsFile, labels);
+      chunk = arma::join_cols(chunk, labels);
+    }
+    rows = chunk.n_rows;
+
+    std::vector<arma::uword> train, test;
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+    {
+      if (math::Random() < testRatio)
+        test.push_back(i);
+      else
+        train.push_back(i);
+    }
+
+    WritePoints(chunk.cols(arma::uvec(test)), dimensionality, testSaver,
+        testLabelsSaver.get());
+
+    if (shuffleBufferSize == 0)
+    {
+      WritePoints(chunk.cols(arma::uvec(train)), dimensionality,
+          trainingSaver, trainingLabelsSaver.get());
+      continue;
+    }
+
+    // Collect the training points into the shuffle buffer, and write it to a
+    // new run whenever it is full.
+    if (buffer.is_empty())
+      buffer.set_size(rows, shuffleBufferSize);
+    for (size_t i = 0; i < train.size(); ++i)
+    {
+      buffer.col(buffered++) = chunk.col(train[i]);
+      if (buffered == shuffleBufferSize)
+      {
+        WriteRun(buffer, trainingFile, runFiles, runSizes);
+        buffered = 0;
+      }
+    }
+  }
+
+  if (labelsLoader)
+  {
+    arma::mat extra;
+    if (labelsLoader->Next(extra, 1))
+      throw std::runtime_error("SplitFiles(): '" + inputLabelsFile + "' has "
+          "more labels than there are points");
+  }
+
+  if (shuffleBufferSize > 0 && buffered > 0)
+  {
+    // The last, partial run.
+    buffer.resize(buffer.n_rows, buffered);
+    if (runFiles.empty())
+    {
+      // All the training points fit in memory.
+      ShuffleColumns(buffer);
+      WritePoints(buffer, dimensionality, trainingSaver,
+          trainingLabelsSaver.get());
+    }
+    else
+    {
+      WriteRun(buffer, trainingFile, runFiles, runSizes);
+    }
+  }
+  buffer.reset();
+
+  if (!runFiles.empty())
+  {
+    // Merge the runs, reading each of them a part of the buffer size at a time.
+    const size_t readSize = std::max(shuffleBufferSize / runFiles.size(),
+        (size_t) 1);
+    std::vector<std::unique_ptr<ChunkedLoader<double>>> runs;
+    std::vector<arma::mat> runChunks(runFiles.size());
+    std::vector<size_t> runPositions(runFiles.size(), 0);
+    size_t remaining = 0;
+    for (size_t r = 0; r < runFiles.size(); ++r)
+    {
+      runs.emplace_back(new ChunkedLoader<double>(runFiles[r]));
+      remaining += runSizes[r];
+    }
+
+    arma::mat output(rows, std::min(chunkSize, remaining));
+    size_t outputPoints = 0;
+    while (remaining > 0)
+    {
+      // Choose a run with probability proportional to its remaining points.
+      size_t pick = std::uniform_int_distribution<size_t>(0, remaining - 1)(
+          math::RandomGenerator());
+      size_t r = 0;
+      while (pick >= runSizes[r])
+        pick -= runSizes[r++];
+
+      if (runPositions[r] == runChunks[r].n_cols)
+      {
+        runs[r]->Next(runChunks[r], readSize);
+        runPositions[r] = 0;
+      }
+
+      output.col(outputPoints++) = runChunks[r].col(runPositions[r]++);
+      --runSizes[r];
+      --remaining;
+
+      if (outputPoints == output.n_cols || remaining == 0)
+      {
+        output.resize(output.n_rows, outputPoints);
+        WritePoints(output, dimensionality, trainingSaver,
+            trainingLabelsSaver.get());
+        output.set_size(output.n_rows, std::min(chunkSize, remaining));
+        outputPoints = 0;
+      }
+    }
+
+    runs.clear();
+    for (size_t r = 0; r < runFiles.size(); ++r)
+      std::remove(runFiles[r].c_str());
+  }
+
+  return std::make_pair(trainingSaver.PointsWritten(),
+      testSaver.PointsWritten());
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
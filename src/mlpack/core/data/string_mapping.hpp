@@ -0,0 +1,117 @@
+/**
+ * @file string_mapping.hpp
+ *
+ * Definition of the StringMapping class, a compact bidirectional mapping
+ * between strings and consecutive integers, used by DatasetInfo to map the
+ * values of categorical dimensions.
+ */
+#ifndef MLPACK_CORE_DATA_STRING_MAPPING_HPP
+#define MLPACK_CORE_DATA_STRING_MAPPING_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <unordered_map>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A mapping between strings and the integers 0, 1, 2, ..., in the order in
+ * which the strings were first mapped.  The characters of all the strings are
+ * stored once, back to back, in a single arena, so the reverse mapping (from an
+ * integer to its string) is a flat array of offsets into the arena; the forward
+ * mapping is an open-addressing hash table (with linear probing) holding the
+ * integers of the strings.  This takes a small fraction of the memory and time
+ * of node-based maps when there are millions of distinct strings.
+ */
+class StringMapping
+{
+ public:
+  //! Create an empty mapping.
+  StringMapping();
+
+  /**
+   * Return the integer of the given string, mapping it to the next integer if
+   * it has no mapping yet.
+   *
+   * @param string String to find or create a mapping for.
+   */
+  size_t Map(const std::string& string);
+
+  /**
+   * Return the integer of the string [data, data + length), mapping it to the
+   * next integer if it has no mapping yet.
+   *
+   * @param data Characters of the string.
+   * @param length Number of characters of the string.
+   */
+  size_t Map(const char* data, const size_t length);
+
+  /**
+   * Find the integer of the given string, without creating a mapping.
+   *
+   * @param string String to find.
+   * @param value Set to the integer of the string, if it has a mapping.
+   * @return Whether the string has a mapping.
+   */
+  bool Find(const std::string& string, size_t& value) const;
+
+  /**
+   * Return the string of the given integer, which must be less than Size().
+   *
+   * @param value Integer to find the string of.
+   */
+  std::string Unmap(const size_t value) const;
+
+  /**
+   * Return a reference to the string of the given integer, which must be less
+   * than Size().  The string is copied out of the arena the first time it is
+   * requested, and the reference stays valid until the mapping is destroyed or
+   * loaded into.
+   *
+   * @param value Integer to find the string of.
+   */
+  const std::string& UnmapReference(const size_t value);
+
+  //! Return the number of mapped strings.
+  size_t Size() const { return offsets.size() - 1; }
+
+  /**
+   * Reserve memory for the given number of strings, with the given total
+   * number of characters, so that mapping them does not reallocate.
+   */
+  void Reserve(const size_t strings, const size_t characters = 0);
+
+  //! Serialize the mapping; the hash table is rebuilt when loading.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
+ private:
+  //! Hash the string [data, data + length).
+  static size_t Hash(const char* data, const size_t length);
+
+  //! Return whether the given mapped string is [data, data + length).
+  bool Equal(const size_t value, const char* data, const size_t length) const;
+
+  //! Rebuild the hash table with the given number of slots (a power of two).
+  void Rehash(const size_t slotCount);
+
+  //! The characters of all the strings, in the order of their integers.
+  std::string arena;
+  //! The string of integer i is [offsets[i], offsets[i + 1]) in the arena.
+  std::vector<size_t> offsets;
+  //! The hash of each string, so that the table can be rebuilt quickly.
+  std::vector<size_t> hashes;
+  //! The hash table: each slot holds an integer plus one, or zero if empty.
+  std::vector<size_t> slots;
+  //! The strings returned by UnmapReference(), by integer.  The elements of an
+  //! unordered_map do not move when it grows.
+  std::unordered_map<size_t, std::string> unmapped;
+};
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "string_mapping_impl.hpp"
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file string_mapping_impl.hpp
+ *
+ * Implementation of the StringMapping class.
+ */
+#ifndef MLPACK_CORE_DATA_STRING_MAPPING_IMPL_HPP
+#define MLPACK_CORE_DATA_STRING_MAPPING_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "string_mapping.hpp"
+
+#include <cstring>
+
+namespace mlpack {
+namespace data {
+
+inline StringMapping::StringMapping() :
+    offsets(1, 0)
+{
+  // Nothing to do.
+}
+
+inline size_t StringMapping::Map(const std::string& string)
+{
+  return Map(string.data(), string.size());
+}
+
+inline size_t StringMapping::Map(const char* data, const size_t length)
+{
+  // Keep the table at most half full, so that probe sequences stay short.
+  if (2 * (Size() + 1) > slots.size())
+    Rehash(std::max(slots.size() * 2, (size_t) 16));
+
+  const size_t hash = Hash(data, length);
+  const size_t mask = slots.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+  {
+    if (slots[slot] == 0)
+    {
+      // The string has no mapping yet, so add it.
+      const size_t value = Size();
+      arena.append(data, length);
+      offsets.push_back(arena.size());
+      hashes.push_back(hash);
+      slots[slot] = value + 1;
+      return value;
+    }
+
+    const size_t value = slots[slot] - 1;
+    if (hashes[value] == hash && Equal(value, data, length))
+      return value;
+  }
+}
+
+inline bool StringMapping::Find(const std::string& string, size_t& value) const
+{
+  if (slots.empty())
+    return false;
+
+  const size_t hash = Hash(string.data(), string.size());
+  const size_t mask = slots.size() - 1;
+  for (size_t slot = hash & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+  {
+    const size_t candidate = slots[slot] - 1;
+    if (hashes[candidate] == hash &&
+        Equal(candidate, string.data(), string.size()))
+    {
+      value = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+inline std::string StringMapping::Unmap(const size_t value) const
+{
+  return arena.substr(offsets[value], offsets[value + 1] - offsets[value]);
+}
+
+inline const std::string& StringMapping::UnmapReference(const size_t value)
+{
+  std::unordered_map<size_t, std::string>::iterator it = unmapped.find(value);
+  if (it == unmapped.end())
+    it = unmapped.insert(std::make_pair(value, Unmap(value))).first;
+
+  return it->second;
+}
+
+inline void StringMapping::Reserve(const size_t strings,
+                                   const size_t characters)
+{
+  arena.reserve(characters);
+  offsets.reserve(strings + 1);
+  hashes.reserve(strings);
+
+  size_t slotCount = std::max(slots.size(), (size_t) 16);
+  while (slotCount < 2 * strings)
+    slotCount *= 2;
+  if (slotCount > slots.size())
+    Rehash(slotCount);
+}
+
+template<typename Archive>
+void StringMapping::Serialize(Archive& ar, const unsigned int /* version */)
+{
+  ar & CreateNVP(arena, "arena");
+  ar & CreateNVP(offsets, "offsets");
+
+  if (Archive::is_loading::value)
+  {
+    unmapped.clear();
+
+    // Recompute the hashes and rebuild the table.
+    hashes.resize(Size());
+    for (size_t i = 0; i < Size(); ++i)
+      hashes[i] = Hash(arena.data() + offsets[i], offsets[i + 1] - offsets[i]);
+
+    size_t slotCount = 16;
+    while (slotCount < 2 * Size())
+      slotCount *= 2;
+    slots.clear();
+    Rehash(slotCount);
+  }
+}
+
+inline size_t StringMapping::Hash(const char* data, const size_t length)
+{
+  // 64-bit FNV-1a, followed by a final mix so that the low bits (which select
+  // the slot) depend on every character.
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; ++i)
+  {
+    hash ^= (unsigned char) data[i];
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 32;
+
+  return (size_t) hash;
+}
+
+inline bool StringMapping::Equal(const size_t value,
+                                 const char* data,
+                                 const size_t length) const
+{
+  return (offsets[value + 1] - offsets[value] == length) &&
+      (std::memcmp(arena.data() + offsets[value], data, length) == 0);
+}
+
+inline void StringMapping::Rehash(const size_t slotCount)
+{
+  slots.assign(slotCount, 0);
+  const size_t mask = slotCount - 1;
+  for (size_t value = 0; value < Size(); ++value)
+  {
+    size_t slot = hashes[value] & mask;
+    while (slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots[slot] = value + 1;
+  }
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
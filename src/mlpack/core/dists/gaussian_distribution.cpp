@@ -85,12 +85,7 @@ arma::vec GaussianDistribution::Random() const
  */
 void GaussianDistribution::Train(const arma::mat& observations)
 {
-  if (observations.n_cols > 0)
-  {
-    mean.zeros(observations.n_rows);
-    covariance.zeros(observations.n_rows, observations.n_rows);
-  }
-  else // This will end up just being empty.
+  if (observations.n_cols == 0) // This will end up just being empty.
   {
     // TODO(stephentu): why do we allow this case? why not throw an error?
     mean.zeros(0);
@@ -98,23 +93,10 @@ void GaussianDistribution::Train(const arma::mat& observations)
     return;
   }
 
-  // Calculate the mean.
-  for (size_t i = 0; i < observations.n_cols; i++)
-    mean += observations.col(i);
-
-  // Normalize the mean.
-  mean /= observations.n_cols;
-
-  // Now calculate the covariance.
-  for (size_t i = 0; i < observations.n_cols; i++)
-  {
-    arma::vec obsNoMean = observations.col(i) - mean;
-    covariance += obsNoMean * trans(obsNoMean);
-  }
-
-  // Finish estimating the covariance by normalizing, with the (1 / (n - 1)) so
-  // that it is the unbiased estimator.
-  covariance /= (observations.n_cols - 1);
+  // Calculate the mean and the covariance in a single pass over the
+  // observations.  The covariance is normalized with (1 / (n - 1)) so that it
+  // is the unbiased estimator.
+  math::Covariance(observations, mean, covariance);
 
   // Ensure that the covariance is positive definite.
   gmm::PositiveDefiniteConstraint::ApplyConstraint(covariance);
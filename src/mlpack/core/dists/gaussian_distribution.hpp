@@ -23,7 +23,8 @@ class GaussianDistribution
   arma::vec mean;
   //! Positive definite covariance of the distribution.
   arma::mat covariance;
-  //! Lower triangular factor of cov (e.g. cov = LL^T).
+  //! Lower triangular factor of cov (e.g. cov = LL^T).  This (and the other
+  //! cached members) is recomputed only when the covariance is set.
   arma::mat covLower;
   //! Cached inverse of covariance.
   arma::mat invCov;
@@ -90,6 +91,16 @@ class GaussianDistribution
     probabilities = arma::exp(logProbabilities);
   }
 
+  /**
+   * Calculates the multivariate Gaussian log probability density function for
+   * each data point (column) in the given matrix.  The Mahalanobis distances of
+   * all the points are computed at once with one triangular solve against the
+   * cached Cholesky factor of the covariance.
+   *
+   * @param x List of observations.
+   * @param logProbabilities Output log probabilities for each input
+   *     observation.
+   */
   void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
 
   /**
@@ -163,33 +174,32 @@ class GaussianDistribution
 };
 
 /**
-* Calculates the multivariate Gaussian log probability density function for each
-* data point (column) in the given matrix
-*
-* @param x List of observations.
-* @param probabilities Output log probabilities for each input observation.
-*/
-inline void GaussianDistribution::LogProbability(const arma::mat& x,
-                                                 arma::vec& logProbabilities) const
+ * Calculates the multivariate Gaussian log probability density function for
+ * each data point (column) in the given matrix.
+ *
+ * @param x List of observations.
+ * @param logProbabilities Output log probabilities for each input observation.
+ */
+inline void GaussianDistribution::LogProbability(
+    const arma::mat& x,
+    arma::vec& logProbabilities) const
 {
   // Column i of 'diffs' is the difference between x.col(i) and the mean.
-  arma::mat diffs = x - (mean * arma::ones<arma::rowvec>(x.n_cols));
+  arma::mat diffs = x;
+  diffs.each_col() -= mean;
 
-  // Now, we only want to calculate the diagonal elements of (diffs' * cov^-1 *
-  // diffs).  We just don't need any of the other elements.  We can calculate
-  // the right hand part of the equation (instead of the left side) so that
-  // later we are referencing columns, not rows -- that is faster.
-  const arma::mat rhs = -0.5 * invCov * diffs;
-  arma::vec logExponents(diffs.n_cols); // We will now fill this.
-  for (size_t i = 0; i < diffs.n_cols; i++)
-    logExponents(i) = accu(diffs.unsafe_col(i) % rhs.unsafe_col(i));
+  // Since cov = LL^T, the squared Mahalanobis distance of column i is the
+  // squared norm of column i of L^-1 * diffs.  One triangular solve for every
+  // column at once takes half the work of multiplying by the inverse
+  // covariance (and is more accurate), and only the diagonal of
+  // diffs' * cov^-1 * diffs is calculated.
+  const arma::mat whitened = arma::solve(arma::trimatl(covLower), diffs);
 
   const size_t k = x.n_rows;
-
-  logProbabilities = -0.5 * k * log2pi - 0.5 * logDetCov + logExponents;
+  logProbabilities = -0.5 * k * log2pi - 0.5 * logDetCov - 0.5 *
+      trans(arma::sum(arma::square(whitened), 0));
 }
 
-
 } // namespace distribution
 } // namespace mlpack
 
@@ -35,6 +35,19 @@ class CosineDistance
   template<typename VecTypeA, typename VecTypeB>
   static double Evaluate(const VecTypeA& a, const VecTypeB& b);
 
+  /**
+   * Computes the cosine distance between every pair of points of two dense
+   * matrices (see KernelMatrix()), with one matrix multiplication.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernelMatrix Matrix to store d(a.col(i), b.col(j)) in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  static void Evaluate(const MatTypeA& a,
+                       const MatTypeB& b,
+                       arma::mat& kernelMatrix);
+
   //! Serialize the class (there's nothing to save).
   template<typename Archive>
   void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -50,6 +63,8 @@ class KernelTraits<CosineDistance>
 
   //! The cosine kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The cosine kernel has a batch Evaluate().
+  static const bool HasBatchEvaluate = true;
 };
 
 } // namespace kernel
@@ -27,6 +27,23 @@ double CosineDistance::Evaluate(const VecTypeA& a, const VecTypeB& b)
     return dot(a, b) / denominator;
 }
 
+template<typename MatTypeA, typename MatTypeB>
+void CosineDistance::Evaluate(const MatTypeA& a,
+                              const MatTypeB& b,
+                              arma::mat& kernelMatrix)
+{
+  // Points with a norm of 0 have a dot product of 0 with every point, so
+  // dividing by 1 instead gives the same result as Evaluate(a, b).
+  arma::rowvec aNorms = arma::sqrt(arma::sum(arma::square(a), 0));
+  arma::rowvec bNorms = arma::sqrt(arma::sum(arma::square(b), 0));
+  aNorms.elem(arma::find(aNorms == 0.0)).ones();
+  bNorms.elem(arma::find(bNorms == 0.0)).ones();
+
+  kernelMatrix = a.t() * b;
+  kernelMatrix.each_col() /= aNorms.t();
+  kernelMatrix.each_row() /= bNorms;
+}
+
 } // namespace kernel
 } // namespace mlpack
 
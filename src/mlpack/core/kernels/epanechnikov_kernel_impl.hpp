@@ -11,6 +11,7 @@
 #include "epanechnikov_kernel.hpp"
 
 #include <mlpack/core/metrics/lmetric.hpp>
+#include "kernel_matrix.hpp"
 
 namespace mlpack {
 namespace kernel {
@@ -23,6 +24,16 @@ inline double EpanechnikovKernel::Evaluate(const VecTypeA& a, const VecTypeB& b)
       * inverseBandwidthSquared);
 }
 
+template<typename MatTypeA, typename MatTypeB>
+void EpanechnikovKernel::Evaluate(const MatTypeA& a,
+                                  const MatTypeB& b,
+                                  arma::mat& kernelMatrix) const
+{
+  SquaredDistances(a, b, kernelMatrix);
+  kernelMatrix = 1.0 - kernelMatrix * inverseBandwidthSquared;
+  kernelMatrix.elem(arma::find(kernelMatrix < 0.0)).zeros();
+}
+
 /**
  * Obtains the convolution integral [integral of K(||x-a||) K(||b-x||) dx]
  * for the two vectors.
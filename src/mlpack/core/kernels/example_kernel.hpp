@@ -97,6 +97,23 @@ class ExampleKernel
   static double Evaluate(const VecTypeA& /* a */, const VecTypeB& /* b */)
   { return 0; }
 
+  /**
+   * Optionally, a kernel can evaluate itself on every pair of points of two
+   * dense matrices at once (for instance, with one matrix multiplication), by
+   * providing this overload and a KernelTraits specialization with
+   * HasBatchEvaluate = true.  KernelMatrix() uses it when it is available, and
+   * otherwise calls the Evaluate() above for each pair.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernelMatrix Matrix to store K(a.col(i), b.col(j)) in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  static void Evaluate(const MatTypeA& a,
+                       const MatTypeB& b,
+                       arma::mat& kernelMatrix)
+  { kernelMatrix.zeros(a.n_cols, b.n_cols); }
+
   /**
    * Serializes the kernel.  In this case, the kernel has no members, so we do
    * not need to do anything at all.
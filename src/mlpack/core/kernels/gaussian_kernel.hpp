@@ -11,6 +11,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include "kernel_matrix.hpp"
 
 namespace mlpack {
 namespace kernel {
@@ -62,6 +63,24 @@ class GaussianKernel
     return exp(gamma * metric::SquaredEuclideanDistance::Evaluate(a, b));
   }
 
+  /**
+   * Evaluate the Gaussian kernel on every pair of points of two dense matrices
+   * (see KernelMatrix()).  The squared distances are computed with one matrix
+   * multiplication (see SquaredDistances()).
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernelMatrix Matrix to store K(a.col(i), b.col(j)) in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  void Evaluate(const MatTypeA& a,
+                const MatTypeB& b,
+                arma::mat& kernelMatrix) const
+  {
+    SquaredDistances(a, b, kernelMatrix);
+    kernelMatrix = arma::exp(gamma * kernelMatrix);
+  }
+
   /**
    * Evaluation of the Gaussian kernel given the distance between two points.
    *
@@ -165,6 +184,8 @@ class KernelTraits<GaussianKernel>
   static const bool IsNormalized = true;
   //! The Gaussian kernel includes a squared distance.
   static const bool UsesSquaredDistance = true;
+  //! The Gaussian kernel has a batch Evaluate().
+  static const bool HasBatchEvaluate = true;
 };
 
 } // namespace kernel
@@ -0,0 +1,169 @@
+/**
+ * @file kernel_cache.hpp
+ *
+ * A memory-bounded cache of the columns of the kernel matrix of a dataset, so
+ * that methods which evaluate the same kernel on the same dataset (or are run
+ * more than once) can share the kernel evaluations.
+ */
+#ifndef MLPACK_CORE_KERNELS_KERNEL_CACHE_HPP
+#define MLPACK_CORE_KERNELS_KERNEL_CACHE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <list>
+#include <unordered_map>
+
+#include "kernel_matrix.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * A cache of the kernel matrix K of a dataset for a given kernel: K(i, j) is
+ * the kernel value of points i and j.  Columns of the kernel matrix are
+ * computed when they are first needed (with the batch evaluation of the
+ * kernel, when it has one), and kept until the cache holds more than the given
+ * number of bytes; then the least recently used columns are evicted.
+ *
+ * The cache is created for one dataset and one kernel, and can then be given
+ * to the methods that work on the kernel matrix of that dataset (KernelPCA,
+ * NystroemMethod, FastMKS), so that they don't recompute kernel values that
+ * are already known.  For instance,
+ *
+ * @code
+ * extern arma::mat data;
+ * GaussianKernel g(2.0);
+ * KernelCache<GaussianKernel> cache(data, g);
+ *
+ * KernelPCA<GaussianKernel> kpca;
+ * kpca.Apply(cache, transformedData, eigval, eigvec, 3);
+ * kpca.Transform(newPoints, transformedPoints); // Uses the cache.
+ * @endcode
+ *
+ * If the dataset or the parameters of the kernel are changed, Clear() must be
+ * called before the cache is used again.
+ *
+ * @tparam KernelType Type of the kernel.
+ * @tparam MatType Type of the dataset.
+ */
+template<typename KernelType, typename MatType = arma::mat>
+class KernelCache
+{
+ public:
+  /**
+   * Create a cache of the kernel matrix of the given dataset.  The dataset is
+   * not copied, so it must remain valid (and unchanged) while the cache is
+   * used.
+   *
+   * @param dataset Dataset (one point per column).
+   * @param kernel Kernel to evaluate.
+   * @param maxBytes Maximum size of the cached columns, in bytes (at least one
+   *     column is always kept).
+   */
+  KernelCache(const MatType& dataset,
+              const KernelType& kernel = KernelType(),
+              const size_t maxBytes = 256 * 1024 * 1024);
+
+  /**
+   * Return column i of the kernel matrix (the kernel values of point i with
+   * every point of the dataset).  The reference is only valid until the next
+   * call which computes a column.
+   *
+   * @param i Index of the point.
+   */
+  const arma::vec& Column(const size_t i);
+
+  /**
+   * Get the columns of the kernel matrix for the given points (the kernel
+   * values of every point of the dataset with the given points).  The columns
+   * which are not cached are computed in one batch.
+   *
+   * @param indices Indices of the points.
+   * @param columns Matrix to store the columns in (of size dataset.n_cols by
+   *     indices.n_elem).
+   */
+  void Columns(const arma::Col<size_t>& indices, arma::mat& columns);
+
+  /**
+   * Get the whole kernel matrix of the dataset.  This also stores the means of
+   * its columns (see ColumnMeans()).
+   *
+   * @param kernelMatrix Matrix to store the kernel matrix in.
+   */
+  void Matrix(arma::mat& kernelMatrix);
+
+  /**
+   * Return the kernel value of points i and j, from the cache if column i or
+   * column j is cached (the kernel matrix is symmetric).  Otherwise, the
+   * kernel is evaluated, but no column is computed.
+   */
+  double Evaluate(const size_t i, const size_t j);
+
+  /**
+   * Return the mean of each column of the kernel matrix (which is also the mean
+   * of each row), as used to center the kernel matrix.  If Matrix() has been
+   * called, these are known already; otherwise they are computed from every
+   * column.
+   */
+  const arma::vec& ColumnMeans();
+
+  //! Remove all the cached columns and column means.
+  void Clear();
+
+  //! Get the dataset.
+  const MatType& Dataset() const { return dataset; }
+
+  //! Get the kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the kernel (call Clear() after changing its parameters).
+  KernelType& Kernel() { return kernel; }
+
+  //! Get the maximum size of the cached columns, in bytes.
+  size_t MaxBytes() const { return maxBytes; }
+  //! Modify the maximum size of the cached columns, in bytes.
+  size_t& MaxBytes() { return maxBytes; }
+
+  //! Get the number of columns in the cache.
+  size_t CachedColumns() const { return columns.size(); }
+  //! Get the number of columns (or kernel values) found in the cache.
+  size_t Hits() const { return hits; }
+  //! Get the number of columns (or kernel values) which had to be computed.
+  size_t Misses() const { return misses; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The kernel.
+  KernelType kernel;
+  //! The maximum size of the cached columns, in bytes.
+  size_t maxBytes;
+
+  //! The cached columns with their indices, the most recently used first.
+  std::list<std::pair<size_t, arma::vec> > columns;
+  //! The position of each cached column in the list.
+  std::unordered_map<size_t,
+      typename std::list<std::pair<size_t, arma::vec> >::iterator> positions;
+
+  //! The means of the columns of the kernel matrix (empty if not known).
+  arma::vec columnMeans;
+
+  //! The number of cache hits.
+  size_t hits;
+  //! The number of cache misses.
+  size_t misses;
+
+  //! Return the cached column i (and mark it as the most recently used), or
+  //! NULL if it is not cached.
+  const arma::vec* Find(const size_t i);
+
+  //! Add column i to the cache, evicting the least recently used columns if
+  //! necessary, and return it.
+  const arma::vec& Insert(const size_t i, const arma::vec& column);
+};
+
+} // namespace kernel
+} // namespace mlpack
+
+// Include implementation.
+#include "kernel_cache_impl.hpp"
+
+#endif
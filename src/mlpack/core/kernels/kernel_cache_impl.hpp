@@ -0,0 +1,175 @@
+/**
+ * @file kernel_cache_impl.hpp
+ *
+ * Implementation of the KernelCache class.
+ */
+#ifndef MLPACK_CORE_KERNELS_KERNEL_CACHE_IMPL_HPP
+#define MLPACK_CORE_KERNELS_KERNEL_CACHE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kernel_cache.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+template<typename KernelType, typename MatType>
+KernelCache<KernelType, MatType>::KernelCache(const MatType& dataset,
+                                              const KernelType& kernel,
+                                              const size_t maxBytes) :
+    dataset(dataset),
+    kernel(kernel),
+    maxBytes(maxBytes),
+    hits(0),
+    misses(0)
+{ }
+
+template<typename KernelType, typename MatType>
+const arma::vec& KernelCache<KernelType, MatType>::Column(const size_t i)
+{
+  const arma::vec* cached = Find(i);
+  if (cached)
+  {
+    ++hits;
+    return *cached;
+  }
+
+  ++misses;
+  arma::mat column;
+  KernelMatrix(kernel, dataset, dataset.cols(i, i), column);
+  return Insert(i, column);
+}
+
+template<typename KernelType, typename MatType>
+void KernelCache<KernelType, MatType>::Columns(
+    const arma::Col<size_t>& indices,
+    arma::mat& output)
+{
+  output.set_size(dataset.n_cols, indices.n_elem);
+
+  // Copy the cached columns, and collect the others.
+  std::vector<size_t> missing;
+  for (size_t j = 0; j < indices.n_elem; ++j)
+  {
+    const arma::vec* cached = Find(indices[j]);
+    if (cached)
+    {
+      ++hits;
+      output.col(j) = *cached;
+    }
+    else
+    {
+      ++misses;
+      missing.push_back(j);
+    }
+  }
+
+  if (missing.empty())
+    return;
+
+  // Compute the missing columns in one batch.
+  arma::uvec missingPoints(missing.size());
+  for (size_t j = 0; j < missing.size(); ++j)
+    missingPoints[j] = indices[missing[j]];
+
+  arma::mat missingColumns;
+  const MatType missingData = dataset.cols(missingPoints);
+  KernelMatrix(kernel, dataset, missingData, missingColumns);
+
+  for (size_t j = 0; j < missing.size(); ++j)
+  {
+    output.col(missing[j]) = missingColumns.col(j);
+    Insert(indices[missing[j]], missingColumns.col(j));
+  }
+}
+
+template<typename KernelType, typename MatType>
+void KernelCache<KernelType, MatType>::Matrix(arma::mat& kernelMatrix)
+{
+  arma::Col<size_t> indices(dataset.n_cols);
+  for (size_t i = 0; i < indices.n_elem; ++i)
+    indices[i] = i;
+  Columns(indices, kernelMatrix);
+
+  columnMeans = arma::trans(arma::mean(kernelMatrix, 0));
+}
+
+template<typename KernelType, typename MatType>
+double KernelCache<KernelType, MatType>::Evaluate(const size_t i,
+                                                  const size_t j)
+{
+  const arma::vec* cached = Find(j);
+  if (cached)
+  {
+    ++hits;
+    return (*cached)[i];
+  }
+
+  cached = Find(i);
+  if (cached)
+  {
+    ++hits;
+    return (*cached)[j];
+  }
+
+  ++misses;
+  return kernel.Evaluate(dataset.col(i), dataset.col(j));
+}
+
+template<typename KernelType, typename MatType>
+const arma::vec& KernelCache<KernelType, MatType>::ColumnMeans()
+{
+  if (columnMeans.n_elem != dataset.n_cols)
+  {
+    columnMeans.set_size(dataset.n_cols);
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      columnMeans[i] = arma::mean(Column(i));
+  }
+
+  return columnMeans;
+}
+
+template<typename KernelType, typename MatType>
+void KernelCache<KernelType, MatType>::Clear()
+{
+  columns.clear();
+  positions.clear();
+  columnMeans.reset();
+}
+
+template<typename KernelType, typename MatType>
+const arma::vec* KernelCache<KernelType, MatType>::Find(const size_t i)
+{
+  typename std::unordered_map<size_t, typename std::list<std::pair<size_t,
+      arma::vec> >::iterator>::iterator it = positions.find(i);
+  if (it == positions.end())
+    return NULL;
+
+  // Move the column to the front of the list.
+  columns.splice(columns.begin(), columns, it->second);
+  return &columns.front().second;
+}
+
+template<typename KernelType, typename MatType>
+const arma::vec& KernelCache<KernelType, MatType>::Insert(
+    const size_t i,
+    const arma::vec& column)
+{
+  // Evict the least recently used columns, so that the new one fits.
+  const size_t columnBytes = std::max((size_t) 1,
+      (size_t) dataset.n_cols * sizeof(double));
+  const size_t maxColumns = std::max((size_t) 1, maxBytes / columnBytes);
+  while (columns.size() >= maxColumns)
+  {
+    positions.erase(columns.back().first);
+    columns.pop_back();
+  }
+
+  columns.push_front(std::make_pair(i, column));
+  positions[i] = columns.begin();
+  return columns.front().second;
+}
+
+} // namespace kernel
+} // namespace mlpack
+
+#endif
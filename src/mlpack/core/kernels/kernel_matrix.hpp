@@ -0,0 +1,124 @@
+/**
+ * @file kernel_matrix.hpp
+ *
+ * Evaluation of a kernel on every pair of points of two datasets (a kernel
+ * matrix), with the batch Evaluate() of the kernel when it has one.
+ */
+#ifndef MLPACK_CORE_KERNELS_KERNEL_MATRIX_HPP
+#define MLPACK_CORE_KERNELS_KERNEL_MATRIX_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/thread_pool.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include "kernel_traits.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Compute the squared Euclidean distances between every column of a and every
+ * column of b, using ||a_i - b_j||^2 = ||a_i||^2 + ||b_j||^2 - 2 a_i^T b_j, so
+ * that most of the work is one matrix multiplication.  The distances of points
+ * which are (nearly) equal are less accurate than when computed one pair at a
+ * time, so negative results of rounding are set to 0.
+ *
+ * @param a First set of points (one per column).
+ * @param b Second set of points (one per column).
+ * @param distances Matrix to store the distances in, of size a.n_cols by
+ *     b.n_cols.
+ */
+template<typename MatTypeA, typename MatTypeB>
+void SquaredDistances(const MatTypeA& a,
+                      const MatTypeB& b,
+                      arma::mat& distances)
+{
+  distances = -2.0 * (a.t() * b);
+  distances.each_col() += arma::trans(arma::sum(arma::square(a), 0));
+  distances.each_row() += arma::sum(arma::square(b), 0);
+  distances.elem(arma::find(distances < 0.0)).zeros();
+}
+
+/**
+ * Evaluate the kernel on every pair of points of a and b: kernelMatrix(i, j) is
+ * the kernel value of a.col(i) and b.col(j).  If the kernel has a batch
+ * Evaluate() (see KernelTraits::HasBatchEvaluate), it is used for dense
+ * matrices; otherwise, the kernel is evaluated one pair at a time.
+ *
+ * @param kernel Kernel to evaluate.
+ * @param a First set of points (one per column).
+ * @param b Second set of points (one per column).
+ * @param kernelMatrix Matrix to store the kernel values in, of size a.n_cols by
+ *     b.n_cols.
+ */
+template<typename KernelType, typename MatTypeA, typename MatTypeB>
+void KernelMatrix(KernelType& kernel,
+                  const MatTypeA& a,
+                  const MatTypeB& b,
+                  arma::mat& kernelMatrix,
+                  const typename boost::enable_if_c<
+                      KernelTraits<KernelType>::HasBatchEvaluate &&
+                      !arma::is_arma_sparse_type<MatTypeA>::value &&
+                      !arma::is_arma_sparse_type<MatTypeB>::value>::type* = 0)
+{
+  kernel.Evaluate(a, b, kernelMatrix);
+}
+
+//! Evaluate the kernel on every pair of points of a and b, one pair at a time
+//! (for kernels without a batch Evaluate(), or for sparse matrices).  The
+//! columns of the kernel matrix are evaluated in parallel.
+template<typename KernelType, typename MatTypeA, typename MatTypeB>
+void KernelMatrix(KernelType& kernel,
+                  const MatTypeA& a,
+                  const MatTypeB& b,
+                  arma::mat& kernelMatrix,
+                  const typename boost::disable_if_c<
+                      KernelTraits<KernelType>::HasBatchEvaluate &&
+                      !arma::is_arma_sparse_type<MatTypeA>::value &&
+                      !arma::is_arma_sparse_type<MatTypeB>::value>::type* = 0)
+{
+  kernelMatrix.set_size(a.n_cols, b.n_cols);
+  ThreadPool::ParallelFor(0, b.n_cols, [&](const size_t j)
+  {
+    for (size_t i = 0; i < a.n_cols; ++i)
+      kernelMatrix(i, j) = kernel.Evaluate(a.col(i), b.col(j));
+  });
+}
+
+/**
+ * Evaluate the kernel on every pair of points of the given dataset.  Without a
+ * batch Evaluate(), only the upper triangle of the (symmetric) kernel matrix
+ * is evaluated.
+ *
+ * @param kernel Kernel to evaluate.
+ * @param data Set of points (one per column).
+ * @param kernelMatrix Matrix to store the kernel values in, of size
+ *     data.n_cols by data.n_cols.
+ */
+template<typename KernelType, typename MatType>
+void KernelMatrix(KernelType& kernel,
+                  const MatType& data,
+                  arma::mat& kernelMatrix)
+{
+  if (KernelTraits<KernelType>::HasBatchEvaluate &&
+      !arma::is_arma_sparse_type<MatType>::value)
+  {
+    KernelMatrix(kernel, data, data, kernelMatrix);
+    return;
+  }
+
+  // The columns of the upper triangle are evaluated in parallel, and then
+  // copied to the lower triangle.
+  kernelMatrix.set_size(data.n_cols, data.n_cols);
+  ThreadPool::ParallelFor(0, data.n_cols, [&](const size_t j)
+  {
+    for (size_t i = 0; i <= j; ++i)
+      kernelMatrix(i, j) = kernel.Evaluate(data.col(i), data.col(j));
+  });
+  kernelMatrix = arma::symmatu(kernelMatrix);
+}
+
+} // namespace kernel
+} // namespace mlpack
+
+#endif
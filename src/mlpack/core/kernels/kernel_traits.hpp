@@ -31,6 +31,13 @@ class KernelTraits
    * If true, then the kernel include a squared distance, ||x - y||^2 .
    */
   static const bool UsesSquaredDistance = false;
+
+  /**
+   * If true, then the kernel has a batch Evaluate(a, b, kernelMatrix), which
+   * evaluates it on every pair of points of two dense matrices (see
+   * KernelMatrix()).
+   */
+  static const bool HasBatchEvaluate = false;
 };
 
 } // namespace kernel
@@ -8,6 +8,7 @@
 #define MLPACK_CORE_KERNELS_LAPLACIAN_KERNEL_HPP
 
 #include <mlpack/core.hpp>
+#include "kernel_matrix.hpp"
 
 namespace mlpack {
 namespace kernel {
@@ -59,6 +60,24 @@ class LaplacianKernel
     return exp(-metric::EuclideanDistance::Evaluate(a, b) / bandwidth);
   }
 
+  /**
+   * Evaluate the Laplacian kernel on every pair of points of two dense
+   * matrices (see KernelMatrix()).  The distances are computed with one matrix
+   * multiplication (see SquaredDistances()).
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernelMatrix Matrix to store K(a.col(i), b.col(j)) in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  void Evaluate(const MatTypeA& a,
+                const MatTypeB& b,
+                arma::mat& kernelMatrix) const
+  {
+    SquaredDistances(a, b, kernelMatrix);
+    kernelMatrix = arma::exp(-arma::sqrt(kernelMatrix) / bandwidth);
+  }
+
   /**
    * Evaluation of the Laplacian kernel given the distance between two points.
    *
@@ -112,6 +131,8 @@ class KernelTraits<LaplacianKernel>
   static const bool IsNormalized = true;
   //! The Laplacian kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The Laplacian kernel has a batch Evaluate().
+  static const bool HasBatchEvaluate = true;
 };
 
 } // namespace kernel
@@ -10,10 +10,34 @@
  */
 #include "pspectrum_string_kernel.hpp"
 
+#include <algorithm>
+
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::kernel;
 
+namespace {
+
+//! The number of symbols substrings are made of (digits and lowercase letters),
+//! plus one; the IDs are numbers in this base.
+const uint64_t base = 37;
+
+//! Return the code (from 1 to 36) of an alphanumeric character, case
+//! insensitively, or 0 if it is not alphanumeric.
+uint64_t SymbolCode(const char c)
+{
+  if (c >= '0' && c <= '9')
+    return uint64_t(c - '0') + 1;
+  else if (c >= 'a' && c <= 'z')
+    return uint64_t(c - 'a') + 11;
+  else if (c >= 'A' && c <= 'Z')
+    return uint64_t(c - 'A') + 11;
+  else
+    return 0;
+}
+
+} // anonymous namespace
+
 /**
  * Initialize the PSpectrumStringKernel with the given string datasets.  For
  * more information on this, see the general class documentation.
@@ -27,57 +51,108 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
     datasets(datasets),
     p(p)
 {
-  // We have to assemble the counts of substrings.  This is not a particularly
-  // fast operation, unfortunately, but it only needs to be done once.
-  Log::Info << "Assembling counts of substrings of length " << p << "."
+  if (p == 0)
+    Log::Fatal << "PSpectrumStringKernel: p must be positive!" << std::endl;
+
+  // We have to assemble the profiles of the strings.  This only needs to be
+  // done once.
+  Log::Info << "Assembling profiles of substrings of length " << p << "."
       << std::endl;
 
+  // The weight of the first character of a substring in its ID (base^(p - 1),
+  // modulo 2^64 like the IDs themselves).
+  uint64_t firstWeight = 1;
+  for (size_t j = 1; j < p; ++j)
+    firstWeight *= base;
+
   // Resize for number of datasets.
-  counts.resize(datasets.size());
+  profiles.resize(datasets.size());
 
+  std::vector<uint64_t> ids;
   for (size_t dataset = 0; dataset < datasets.size(); ++dataset)
   {
     const std::vector<std::string>& set = datasets[dataset];
 
     // Resize for number of strings in dataset.
-    counts[dataset].resize(set.size());
+    profiles[dataset].resize(set.size());
 
     // Inspect each string in the dataset.
     for (size_t index = 0; index < set.size(); ++index)
     {
-      // Convenience references.
+      // Convenience reference.
       const std::string& str = set[index];
-      std::map<std::string, int>& mapping = counts[dataset][index];
 
-      size_t start = 0;
-      while ((start + p) <= str.length())
+      // Roll the ID of the current substring along the string; a character
+      // which is not alphanumeric restarts it (only substrings with
+      // alphanumerics are considered).
+      ids.clear();
+      uint64_t id = 0;
+      size_t length = 0; // Number of valid characters the ID covers.
+      for (size_t i = 0; i < str.length(); ++i)
       {
-        string sub = str.substr(start, p);
-
-        // Convert all characters to lowercase.
-        bool invalid = false;
-        for (size_t j = 0; j < p; ++j)
+        const uint64_t code = SymbolCode(str[i]);
+        if (code == 0)
         {
-          if (!isalnum(sub[j]))
-          {
-            invalid = true;
-            break; // Only consider substrings with alphanumerics.
-          }
-
-          sub[j] = tolower(sub[j]);
+          id = 0;
+          length = 0;
+          continue;
         }
 
-        // Increment position in string.
-        ++start;
+        if (length == p)
+          id -= SymbolCode(str[i - p]) * firstWeight;
+        else
+          ++length;
+        id = id * base + code;
 
-        if (!invalid)
-        {
-          // Add to the map.
-          ++mapping[sub];
-        }
+        if (length == p)
+          ids.push_back(id);
+      }
+
+      // Count each distinct ID.
+      std::sort(ids.begin(), ids.end());
+      Profile& profile = profiles[dataset][index];
+      profile.clear();
+      for (size_t i = 0; i < ids.size(); ++i)
+      {
+        if (profile.empty() || profile.back().first != ids[i])
+          profile.push_back(std::make_pair(ids[i], (size_t) 0));
+        ++profile.back().second;
       }
+      profile.shrink_to_fit();
     }
   }
 
   Log::Info << "Substring extraction complete." << std::endl;
 }
+
+size_t mlpack::kernel::PSpectrumStringKernel::Count(
+    const size_t dataset,
+    const size_t index,
+    const std::string& substring) const
+{
+  if (substring.length() != p)
+    return 0;
+
+  const uint64_t id = SubstringID(substring);
+  const Profile& profile = profiles[dataset][index];
+  Profile::const_iterator it = std::lower_bound(profile.begin(), profile.end(),
+      std::make_pair(id, (size_t) 0));
+
+  return (it != profile.end() && it->first == id) ? it->second : 0;
+}
+
+uint64_t mlpack::kernel::PSpectrumStringKernel::SubstringID(
+    const std::string& substring)
+{
+  uint64_t id = 0;
+  for (size_t i = 0; i < substring.length(); ++i)
+  {
+    const uint64_t code = SymbolCode(substring[i]);
+    if (code == 0)
+      return 0;
+
+    id = id * base + code;
+  }
+
+  return id;
+}
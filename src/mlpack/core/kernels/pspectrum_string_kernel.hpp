@@ -11,11 +11,11 @@
 #ifndef MLPACK_CORE_KERNELS_PSPECTRUM_STRING_KERNEL_HPP
 #define MLPACK_CORE_KERNELS_PSPECTRUM_STRING_KERNEL_HPP
 
-#include <map>
 #include <string>
 #include <vector>
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/kernels/kernel_traits.hpp>
 
 namespace mlpack {
 namespace kernel {
@@ -55,6 +55,14 @@ namespace kernel {
  * the data according to the fake data matrix -- resulting in a meaningless
  * tree.  This kernel was originally written for the FastMKS method; so, at the
  * very least, it will work with that.
+ *
+ * When the kernel is created, the substrings of length p of each string (only
+ * those made of alphanumeric characters, which are converted to lowercase) are
+ * encoded as 64-bit IDs with a rolling hash, and each string is stored as its
+ * profile: the sorted list of the IDs of its substrings with their counts.
+ * Then an evaluation is a merge of two sorted lists.  For p <= 12 the IDs are
+ * unique; for longer substrings, distinct substrings could (very rarely) share
+ * an ID.
  */
 class PSpectrumStringKernel
 {
@@ -69,6 +77,10 @@ class PSpectrumStringKernel
   PSpectrumStringKernel(const std::vector<std::vector<std::string> >& datasets,
                         const size_t p);
 
+  //! The profile of a string: the sorted IDs of its substrings of length p,
+  //! each with the number of times it appears.
+  typedef std::vector<std::pair<uint64_t, size_t> > Profile;
+
   /**
    * Evaluate the kernel for the string indices given.  As mentioned in the
    * class documentation, a and b should be 2-element vectors, where the first
@@ -83,12 +95,44 @@ class PSpectrumStringKernel
   template<typename VecType>
   double Evaluate(const VecType& a, const VecType& b) const;
 
-  //! Access the lists of substrings.
-  const std::vector<std::vector<std::map<std::string, int> > >& Counts() const
-  { return counts; }
-  //! Modify the lists of substrings.
-  std::vector<std::vector<std::map<std::string, int> > >& Counts()
-  { return counts; }
+  /**
+   * Evaluate the kernel on every pair of strings given by the columns of a and
+   * b (see KernelMatrix()).  The substrings of the strings of a are indexed
+   * once, so each string of b is compared with all of them with one lookup
+   * per substring.
+   *
+   * @param a Indices of dataset and string (one string per column).
+   * @param b Indices of dataset and string (one string per column).
+   * @param kernelMatrix Matrix to store K(a.col(i), b.col(j)) in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  void Evaluate(const MatTypeA& a,
+                const MatTypeB& b,
+                arma::mat& kernelMatrix) const;
+
+  /**
+   * Return the number of times the given substring (of length p) appears in
+   * the given string.
+   *
+   * @param dataset Index of the dataset.
+   * @param index Index of the string in the dataset.
+   * @param substring Substring to count.
+   */
+  size_t Count(const size_t dataset,
+               const size_t index,
+               const std::string& substring) const;
+
+  /**
+   * Return the ID of the given substring, or 0 if it contains characters which
+   * are not alphanumeric (no valid substring has the ID 0).
+   */
+  static uint64_t SubstringID(const std::string& substring);
+
+  //! Access the profiles of the strings.
+  const std::vector<std::vector<Profile> >& Profiles() const
+  { return profiles; }
+  //! Modify the profiles of the strings.
+  std::vector<std::vector<Profile> >& Profiles() { return profiles; }
 
   //! Access the value of p.
   size_t P() const { return p; }
@@ -99,14 +143,26 @@ class PSpectrumStringKernel
   //! The datasets.
   const std::vector<std::vector<std::string> >& datasets;
 
-  //! Mappings of the datasets to counts of substrings.  Such a huge structure
-  //! is not wonderful...
-  std::vector<std::vector<std::map<std::string, int> > > counts;
+  //! The profile of each string of each dataset.
+  std::vector<std::vector<Profile> > profiles;
 
   //! The value of p to use in calculation.
   size_t p;
 };
 
+//! Kernel traits for the p-spectrum string kernel.
+template<>
+class KernelTraits<PSpectrumStringKernel>
+{
+ public:
+  //! The p-spectrum string kernel is not normalized.
+  static const bool IsNormalized = false;
+  //! The p-spectrum string kernel does not include a squared distance.
+  static const bool UsesSquaredDistance = false;
+  //! The p-spectrum string kernel has a batch Evaluate().
+  static const bool HasBatchEvaluate = true;
+};
+
 } // namespace kernel
 } // namespace mlpack
 
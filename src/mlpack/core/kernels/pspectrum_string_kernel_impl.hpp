@@ -14,6 +14,8 @@
 // In case it has not been included yet.
 #include "pspectrum_string_kernel.hpp"
 
+#include <algorithm>
+
 namespace mlpack {
 namespace kernel {
 
@@ -31,44 +33,90 @@ template<typename VecType>
 double PSpectrumStringKernel::Evaluate(const VecType& a,
                                        const VecType& b) const
 {
-  // Get the map of substrings for the two strings we are interested in.
-  const std::map<std::string, int>& aMap = counts[a[0]][a[1]];
-  const std::map<std::string, int>& bMap = counts[b[0]][b[1]];
+  // Get the profiles of the two strings we are interested in.
+  const Profile& aProfile = profiles[a[0]][a[1]];
+  const Profile& bProfile = profiles[b[0]][b[1]];
 
   double eval = 0;
 
-  // Loop through the two maps (which, when iterated through, are sorted
-  // alphabetically).
-  std::map<std::string, int>::const_iterator aIt = aMap.begin();
-  std::map<std::string, int>::const_iterator bIt = bMap.begin();
+  // Loop through the two profiles (which are sorted by ID) together.
+  Profile::const_iterator aIt = aProfile.begin();
+  Profile::const_iterator bIt = bProfile.begin();
 
-  while ((aIt != aMap.end()) && (bIt != bMap.end()))
+  while ((aIt != aProfile.end()) && (bIt != bProfile.end()))
   {
-    // Compare alphabetically (this is how std::map is ordered).
-    int result = (*aIt).first.compare((*bIt).first);
-
-    if (result == 0) // The same substring.
+    if (aIt->first == bIt->first) // The same substring.
     {
-      eval += ((*aIt).second * (*bIt).second);
+      eval += double(aIt->second * bIt->second);
 
       // Now increment both.
       ++aIt;
       ++bIt;
     }
-    else if (result > 0)
+    else if (aIt->first > bIt->first)
     {
-      // aIt is "ahead" of bIt (alphabetically); so increment bIt to "catch up".
+      // aIt is "ahead" of bIt; so increment bIt to "catch up".
       ++bIt;
     }
     else
     {
-      // bIt is "ahead" of aIt (alphabetically); so increment aIt to "catch up".
+      // bIt is "ahead" of aIt; so increment aIt to "catch up".
       ++aIt;
     }
   }
 
   return eval;
 }
+
+template<typename MatTypeA, typename MatTypeB>
+void PSpectrumStringKernel::Evaluate(const MatTypeA& a,
+                                     const MatTypeB& b,
+                                     arma::mat& kernelMatrix) const
+{
+  // Index the substrings of the strings of a: each entry holds the ID of a
+  // substring, the column of a string it appears in, and its count there.
+  struct Entry
+  {
+    uint64_t id;
+    size_t column;
+    size_t count;
+  };
+
+  std::vector<Entry> index;
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    const Profile& profile = profiles[(size_t) a(0, i)][(size_t) a(1, i)];
+    for (size_t k = 0; k < profile.size(); ++k)
+    {
+      const Entry entry = { profile[k].first, i, profile[k].second };
+      index.push_back(entry);
+    }
+  }
+
+  std::stable_sort(index.begin(), index.end(),
+      [](const Entry& x, const Entry& y) { return x.id < y.id; });
+
+  // Each string of b looks up its substrings in the index; each thread fills
+  // its own columns of the kernel matrix.
+  kernelMatrix.zeros(a.n_cols, b.n_cols);
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t j = 0; j < (omp_size_t) b.n_cols; ++j)
+  {
+    const Profile& profile = profiles[(size_t) b(0, j)][(size_t) b(1, j)];
+    double* column = kernelMatrix.colptr(j);
+
+    typename std::vector<Entry>::const_iterator it = index.cbegin();
+    for (size_t k = 0; k < profile.size(); ++k)
+    {
+      // The profile is sorted, so the search can start after the last match.
+      it = std::lower_bound(it, index.cend(), profile[k].first,
+          [](const Entry& x, const uint64_t id) { return x.id < id; });
+      for (; it != index.cend() && it->id == profile[k].first; ++it)
+        column[it->column] += double(it->count * profile[k].second);
+    }
+  }
+}
+
 } // namespace kernel
 } // namespace mlpack
 
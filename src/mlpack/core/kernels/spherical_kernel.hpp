@@ -121,6 +121,8 @@ class KernelTraits<SphericalKernel>
   static const bool IsNormalized = true;
   //! The spherical kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The spherical kernel doesn't have a batch Evaluate().
+  static const bool HasBatchEvaluate = false;
 };
 
 } // namespace kernel
@@ -55,7 +55,7 @@ class TriangularKernel
    */
   double Evaluate(const double distance) const
   {
-    return std::max(0.0, (1 - distance) / bandwidth);
+    return std::max(0.0, 1 - distance / bandwidth);
   }
 
   /**
@@ -66,9 +66,9 @@ class TriangularKernel
    * @param distance The distance between the two points.
    */
   double Gradient(const double distance) const {
-    if (distance < 1) {
+    if (distance < bandwidth) {
       return -1.0 / bandwidth;
-    } else if (distance > 1) {
+    } else if (distance > bandwidth) {
       return 0;
     } else {
       return arma::datum::nan;
@@ -101,6 +101,8 @@ class KernelTraits<TriangularKernel>
   static const bool IsNormalized = true;
   //! The triangular kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The triangular kernel doesn't have a batch Evaluate().
+  static const bool HasBatchEvaluate = false;
 };
 
 } // namespace kernel
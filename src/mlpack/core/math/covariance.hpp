@@ -0,0 +1,184 @@
+/**
+ * @file covariance.hpp
+ *
+ * Definition of the CovarianceAccumulator class, which computes the mean and
+ * the covariance of a stream of points in a single pass, and of Covariance(),
+ * which computes them for a dataset with several accumulators in parallel.
+ */
+#ifndef MLPACK_CORE_MATH_COVARIANCE_HPP
+#define MLPACK_CORE_MATH_COVARIANCE_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Accumulate the mean and the scatter matrix (the sum of the outer products of
+ * the centered points) of a stream of points, without storing the points or
+ * building a centered copy of them.  The points are added in blocks; the
+ * statistics of each chunk of a block are computed around the mean of the
+ * chunk, and merged into the running statistics with the update of Chan, Golub
+ * and LeVeque,
+ *
+ *   mean = mean_a + (n_b / n) delta,
+ *   M = M_a + M_b + (n_a n_b / n) delta delta^T,   delta = mean_b - mean_a,
+ *
+ * which is as accurate as centering the data with its mean first.  Two
+ * accumulators (for instance, of two threads) are merged in the same way.
+ *
+ * @code
+ * math::CovarianceAccumulator accumulator;
+ * while (...) // For each block of points.
+ *   accumulator.Add(block);
+ * arma::mat covariance = accumulator.Covariance();
+ * @endcode
+ */
+class CovarianceAccumulator
+{
+ public:
+  //! The number of points centered at a time by Add().
+  static const size_t ChunkSize = 1024;
+
+  //! Create an empty accumulator.
+  CovarianceAccumulator() : count(0) { }
+
+  /**
+   * Add the given points (one per column).  They are processed ChunkSize
+   * points at a time, so only a chunk-size centered copy of them is built.
+   *
+   * @param points Points to add.
+   */
+  void Add(const arma::mat& points)
+  {
+    if (count == 0)
+    {
+      mean.zeros(points.n_rows);
+      scatter.zeros(points.n_rows, points.n_rows);
+    }
+
+    for (size_t begin = 0; begin < points.n_cols; begin += ChunkSize)
+    {
+      const size_t end = std::min(begin + ChunkSize, (size_t) points.n_cols);
+      const arma::vec chunkMean = arma::mean(points.cols(begin, end - 1), 1);
+      arma::mat centered = points.cols(begin, end - 1);
+      centered.each_col() -= chunkMean;
+
+      Merge(end - begin, chunkMean, centered * arma::trans(centered));
+    }
+  }
+
+  /**
+   * Merge the statistics of another accumulator into this one.
+   *
+   * @param other Accumulator to merge.
+   */
+  void Merge(const CovarianceAccumulator& other)
+  {
+    if (count == 0)
+      *this = other;
+    else if (other.count > 0)
+      Merge(other.count, other.mean, other.scatter);
+  }
+
+  //! Get the number of points added.
+  size_t Count() const { return count; }
+  //! Get the mean of the points.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the scatter matrix (the sum of the outer products of the centered
+  //! points).
+  const arma::mat& Scatter() const { return scatter; }
+
+  /**
+   * Return the covariance of the points, normalized by n - 1 (the unbiased
+   * estimate) or, if normType is 1, by n, as with arma::cov().
+   *
+   * @param normType Type of normalization.
+   */
+  arma::mat Covariance(const size_t normType = 0) const
+  {
+    const double norm = (normType == 0 && count > 1) ? (count - 1) :
+        std::max(count, (size_t) 1);
+    return scatter / norm;
+  }
+
+ private:
+  //! Merge the statistics of a set of points into the running statistics.
+  void Merge(const size_t otherCount,
+             const arma::vec& otherMean,
+             const arma::mat& otherScatter)
+  {
+    const double n = count + otherCount;
+    const arma::vec delta = otherMean - mean;
+    mean += (otherCount / n) * delta;
+    scatter += otherScatter + (count * (otherCount / n)) * delta *
+        arma::trans(delta);
+    count += otherCount;
+  }
+
+  //! The number of points added.
+  size_t count;
+  //! The mean of the points.
+  arma::vec mean;
+  //! The sum of the outer products of the centered points.
+  arma::mat scatter;
+};
+
+/**
+ * Compute the mean and the covariance of the columns of x in a single pass,
+ * without building a centered copy of x.  Each thread accumulates a contiguous
+ * block of the columns with a CovarianceAccumulator, and the accumulators are
+ * merged in order, so the result only depends on the number of threads through
+ * rounding.
+ *
+ * @param x Points to compute the covariance of (one per column).
+ * @param mean Vector to store the mean of the points in.
+ * @param covariance Matrix to store the covariance of the points in.
+ * @param normType Normalization of the covariance: 0 for n - 1 (the unbiased
+ *     estimate), 1 for n, as with arma::cov().
+ */
+inline void Covariance(const arma::mat& x,
+                       arma::vec& mean,
+                       arma::mat& covariance,
+                       const size_t normType = 0)
+{
+  size_t blocks = (x.n_cols + CovarianceAccumulator::ChunkSize - 1) /
+      CovarianceAccumulator::ChunkSize;
+#ifdef _OPENMP
+  blocks = std::min(blocks, (size_t) omp_get_max_threads());
+#else
+  blocks = std::min(blocks, (size_t) 1);
+#endif
+
+  std::vector<CovarianceAccumulator> accumulators(std::max(blocks,
+      (size_t) 1));
+  #pragma omp parallel for
+  for (omp_size_t b = 0; b < (omp_size_t) blocks; ++b)
+  {
+    const size_t begin = b * x.n_cols / blocks;
+    const size_t end = (b + 1) * x.n_cols / blocks;
+
+    // Use the columns where they are, without a copy.
+    const arma::mat block(const_cast<double*>(x.colptr(begin)), x.n_rows,
+        end - begin, false, true);
+    accumulators[b].Add(block);
+  }
+
+  for (size_t b = 1; b < blocks; ++b)
+    accumulators[0].Merge(accumulators[b]);
+
+  if (accumulators[0].Count() == 0)
+  {
+    mean.zeros(x.n_rows);
+    covariance.zeros(x.n_rows, x.n_rows);
+    return;
+  }
+
+  mean = accumulators[0].Mean();
+  covariance = accumulators[0].Covariance(normType);
+}
+
+} // namespace math
+} // namespace mlpack
+
+#endif
@@ -5,6 +5,7 @@
  * Linear algebra utilities.
  */
 #include "lin_alg.hpp"
+#include "covariance.hpp"
 #include <mlpack/core.hpp>
 
 using namespace mlpack;
@@ -37,9 +38,12 @@ void mlpack::math::VectorPower(arma::vec& vec, const double power)
 void mlpack::math::Center(const arma::mat& x, arma::mat& xCentered)
 {
   // Get the mean of the elements in each row.
-  arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
+  const arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
 
-  xCentered = x - arma::repmat(rowMean, 1, x.n_cols);
+  // Subtract it in place, without a repmat() temporary (the copy is skipped if
+  // x and xCentered are the same matrix).
+  xCentered = x;
+  xCentered.each_col() -= rowMean;
 }
 
 /**
@@ -52,9 +56,9 @@ void mlpack::math::WhitenUsingSVD(const arma::mat& x,
                                   arma::mat& whiteningMatrix)
 {
   arma::mat covX, u, v, invSMatrix, temp1;
-  arma::vec sVector;
+  arma::vec sVector, mean;
 
-  covX = ccov(x);
+  Covariance(x, mean, covX);
 
   svd(u, sVector, v, covX);
 
@@ -75,11 +79,12 @@ void mlpack::math::WhitenUsingEig(const arma::mat& x,
                                   arma::mat& xWhitened,
                                   arma::mat& whiteningMatrix)
 {
-  arma::mat diag, eigenvectors;
-  arma::vec eigenvalues;
+  arma::mat diag, eigenvectors, covX;
+  arma::vec eigenvalues, mean;
 
   // Get eigenvectors of covariance of input matrix.
-  eig_sym(eigenvalues, eigenvectors, ccov(x));
+  Covariance(x, mean, covX);
+  eig_sym(eigenvalues, eigenvectors, covX);
 
   // Generate diagonal matrix using 1 / sqrt(eigenvalues) for each value.
   VectorPower(eigenvalues, -0.5);
@@ -25,6 +25,8 @@ void VectorPower(arma::vec& vec, const double power);
 /**
  * Creates a centered matrix, where centering is done by subtracting
  * the sum over the columns (a column vector) from each column of the matrix.
+ * x and xCentered may be the same matrix, in which case it is centered in
+ * place.
  *
  * @param x Input matrix
  * @param xCentered Matrix to write centered output into
@@ -34,7 +36,7 @@ void Center(const arma::mat& x, arma::mat& xCentered);
 /**
  * Whitens a matrix using the singular value decomposition of the covariance
  * matrix. Whitening means the covariance matrix of the result is the identity
- * matrix.
+ * matrix.  The covariance is computed in a single pass (see Covariance()).
  */
 void WhitenUsingSVD(const arma::mat& x,
                     arma::mat& xWhitened,
@@ -43,6 +45,7 @@ void WhitenUsingSVD(const arma::mat& x,
 /**
  * Whitens a matrix using the eigendecomposition of the covariance matrix.
  * Whitening means the covariance matrix of the result is the identity matrix.
+ * The covariance is computed in a single pass (see Covariance()).
  */
 void WhitenUsingEig(const arma::mat& x,
                     arma::mat& xWhitened,
@@ -0,0 +1,81 @@
+/**
+ * @file presort.hpp
+ *
+ * Sorting of every dimension of a dataset once, for methods which search for
+ * splits along each dimension (such as decision stumps and density estimation
+ * trees), and stable partitioning of the sorted indices when a node is split,
+ * so that the children don't have to sort their points again.
+ */
+#ifndef MLPACK_CORE_MATH_PRESORT_HPP
+#define MLPACK_CORE_MATH_PRESORT_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/thread_pool.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Sort the points of the given dataset along every dimension.  Column d of
+ * sortedIndices holds the indices of the points in ascending order of their
+ * value in dimension d; points with equal values keep their order in the
+ * dataset (the sort is stable).  The dimensions are sorted in parallel.
+ *
+ * @param data Dataset (one point per column).
+ * @param sortedIndices Matrix to store the sorted indices in, of size
+ *     data.n_cols by data.n_rows.
+ */
+template<typename MatType>
+void Presort(const MatType& data, arma::Mat<size_t>& sortedIndices)
+{
+  sortedIndices.set_size(data.n_cols, data.n_rows);
+  ThreadPool::ParallelFor(0, data.n_rows, [&](const size_t d)
+  {
+    const arma::Row<typename MatType::elem_type> dimension(data.row(d));
+    const arma::uvec order = arma::stable_sort_index(dimension);
+    for (size_t i = 0; i < order.n_elem; ++i)
+      sortedIndices(i, d) = order[i];
+  });
+}
+
+/**
+ * Stably partition rows [begin, end) of every column of presorted indices (see
+ * Presort()): the indices of the points for which goesLeft is nonzero are moved
+ * before the others, and both groups keep their order, so they remain sorted.
+ * This is how the presorted indices of a node are split between its children.
+ *
+ * @param sortedIndices Presorted indices, one column per dimension.
+ * @param begin First row of the range to partition.
+ * @param end One past the last row of the range to partition.
+ * @param goesLeft For each point index, whether the point goes first.
+ */
+inline void PartitionPresorted(arma::Mat<size_t>& sortedIndices,
+                               const size_t begin,
+                               const size_t end,
+                               const std::vector<char>& goesLeft)
+{
+  std::vector<size_t> right;
+  right.reserve(end - begin);
+  for (size_t d = 0; d < sortedIndices.n_cols; ++d)
+  {
+    // The points going left are moved down in place; the others are set aside
+    // and copied after them.
+    size_t* column = sortedIndices.colptr(d);
+    size_t left = begin;
+    right.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (goesLeft[column[i]])
+        column[left++] = column[i];
+      else
+        right.push_back(column[i]);
+    }
+
+    std::copy(right.begin(), right.end(), column + left);
+  }
+}
+
+} // namespace math
+} // namespace mlpack
+
+#endif
@@ -3,8 +3,9 @@
  *
  * Declarations of global random number generators.
  */
-#include <random>
-#include <mlpack/mlpack_export.hpp>
+#include "random.hpp"
+
+#include <atomic>
 
 namespace mlpack {
 namespace math {
@@ -16,5 +17,46 @@ MLPACK_EXPORT std::uniform_real_distribution<> randUniformDist(0.0, 1.0);
 // Global normal distribution.
 MLPACK_EXPORT std::normal_distribution<> randNormalDist(0.0, 1.0);
 
+namespace {
+
+// The seed of the generators of parallel regions, and the number of times it
+// has been set.  The seed is the default seed of std::mt19937 until
+// RandomSeed() is called.
+std::atomic<uint32_t> parallelSeed(std::mt19937::default_seed);
+std::atomic<size_t> parallelSeedCount(0);
+
+} // anonymous namespace
+
+void SetParallelRandomSeed(const uint32_t seed)
+{
+  parallelSeed = seed;
+  ++parallelSeedCount;
+}
+
+ParallelRandomState& ThreadRandomState()
+{
+  static thread_local ParallelRandomState state;
+  static thread_local bool seeded = false;
+
+#ifdef _OPENMP
+  const int thread = omp_get_thread_num();
+#else
+  const int thread = 0;
+#endif
+  const size_t seedCount = parallelSeedCount.load();
+  if (!seeded || state.seedCount != seedCount || state.thread != thread)
+  {
+    std::seed_seq seedSequence = { parallelSeed.load(), (uint32_t) thread };
+    state.generator.seed(seedSequence);
+    state.uniform = std::uniform_real_distribution<>(0.0, 1.0);
+    state.normal = std::normal_distribution<>(0.0, 1.0);
+    state.seedCount = seedCount;
+    state.thread = thread;
+    seeded = true;
+  }
+
+  return state;
+}
+
 } // namespace math
 } // namespace mlpack
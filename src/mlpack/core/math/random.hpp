@@ -25,16 +25,157 @@ extern MLPACK_EXPORT std::uniform_real_distribution<> randUniformDist;
 // Global normal distribution.
 extern MLPACK_EXPORT std::normal_distribution<> randNormalDist;
 
+/**
+ * The random number generator and distributions used by the random functions
+ * on one thread of a parallel region.  Outside of parallel regions, the random
+ * functions use the global objects above (randGen, randUniformDist and
+ * randNormalDist) instead.
+ */
+struct ParallelRandomState
+{
+  //! The generator of the thread.
+  std::mt19937 generator;
+  //! The uniform distribution on [0, 1).
+  std::uniform_real_distribution<> uniform;
+  //! The standard normal distribution.
+  std::normal_distribution<> normal;
+  //! The number of RandomSeed() calls when the generator was seeded.
+  size_t seedCount;
+  //! The OpenMP thread number the generator was seeded for.
+  int thread;
+};
+
+/**
+ * Get the random state of the calling thread in a parallel region.  Its
+ * generator is seeded with the seed given to RandomSeed() and the OpenMP thread
+ * number, so the random numbers drawn by each thread are reproducible for a
+ * given seed and number of threads (as long as the work given to each thread
+ * doesn't depend on the schedule).  It is reseeded when RandomSeed() is called.
+ */
+MLPACK_EXPORT ParallelRandomState& ThreadRandomState();
+
+/**
+ * Record the given seed for the generators of the threads of parallel regions
+ * (this is called by RandomSeed()).
+ *
+ * @param seed Seed for the generators.
+ */
+MLPACK_EXPORT void SetParallelRandomSeed(const uint32_t seed);
+
+/**
+ * Get the random number generator of the calling thread: randGen outside of
+ * parallel regions, and the generator of the thread (see ThreadRandomState())
+ * inside them.  This is the generator to give to the distributions of the
+ * standard library in code which may run in parallel.
+ */
+inline std::mt19937& RandomGenerator()
+{
+#ifdef _OPENMP
+  if (omp_in_parallel())
+    return ThreadRandomState().generator;
+#endif
+  return randGen;
+}
+
+/**
+ * Independent random number streams for the blocks (or tasks) of a parallel
+ * computation.  The streams are seeded with one number drawn from the
+ * generator of the calling thread when the object is created, and the index of
+ * the stream, so the numbers drawn from each stream don't depend on the thread
+ * which draws them, or on the number of threads:
+ *
+ * @code
+ * const RandomStreams streams;
+ * #pragma omp parallel for
+ * for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+ * {
+ *   std::mt19937 generator = streams.Stream(b);
+ *   ...
+ * }
+ * @endcode
+ */
+class RandomStreams
+{
+ public:
+  //! Create the streams, with a seed drawn from RandomGenerator().
+  RandomStreams() : seed((uint32_t) RandomGenerator()()) { }
+
+  //! Get the generator of the stream with the given index.
+  std::mt19937 Stream(const size_t index) const
+  {
+    const uint32_t high = (uint32_t) ((uint64_t) index >> 32);
+    if (high == 0)
+    {
+      std::seed_seq seedSequence = { seed, (uint32_t) index };
+      return std::mt19937(seedSequence);
+    }
+
+    std::seed_seq seedSequence = { seed, (uint32_t) index, high };
+    return std::mt19937(seedSequence);
+  }
+
+ private:
+  //! The seed of the streams.
+  uint32_t seed;
+};
+
+/**
+ * While a RandomGeneratorScope is alive, the random functions called on its
+ * thread (Random(), RandInt(), RandNormal() and RandomGenerator()) draw from
+ * the given generator, for instance the stream of one task of a parallel
+ * computation (see RandomStreams).  The generator of the thread is left as it
+ * was: it is swapped back in when the scope ends, and the given generator then
+ * holds the state the task left it in.
+ *
+ * @code
+ * const RandomStreams streams;
+ * #pragma omp parallel for
+ * for (omp_size_t t = 0; t < (omp_size_t) numTasks; ++t)
+ * {
+ *   std::mt19937 generator = streams.Stream(t);
+ *   const RandomGeneratorScope scope(generator);
+ *   ...
+ * }
+ * @endcode
+ */
+class RandomGeneratorScope
+{
+ public:
+  //! Draw the random numbers of this thread from the given generator.
+  RandomGeneratorScope(std::mt19937& generator) : generator(generator)
+  {
+    std::swap(RandomGenerator(), generator);
+  }
+
+  //! Restore the generator of the thread.
+  ~RandomGeneratorScope()
+  {
+    std::swap(RandomGenerator(), generator);
+  }
+
+  // The scope can't be copied.
+  RandomGeneratorScope(const RandomGeneratorScope& other) = delete;
+  RandomGeneratorScope& operator=(const RandomGeneratorScope& other) = delete;
+
+ private:
+  //! The generator of the scope (the generator of the thread, while the scope
+  //! is alive).
+  std::mt19937& generator;
+};
+
 /**
  * Set the random seed used by the random functions (Random() and RandInt()).
  * The seed is casted to a 32-bit integer before being given to the random
  * number generator, but a size_t is taken as a parameter for API consistency.
+ * The generators of the threads of parallel regions are derived from it as
+ * well (see ThreadRandomState()).
  *
  * @param seed Seed for the random number generator.
  */
 inline void RandomSeed(const size_t seed)
 {
   randGen.seed((uint32_t) seed);
+  SetParallelRandomSeed((uint32_t) seed);
   srand((unsigned int) seed);
 #if ARMA_VERSION_MAJOR > 3 || \
     (ARMA_VERSION_MAJOR == 3 && ARMA_VERSION_MINOR >= 930)
@@ -45,10 +186,19 @@ inline void RandomSeed(const size_t seed)
 }
 
 /**
- * Generates a uniform random number between 0 and 1.
+ * Generates a uniform random number between 0 and 1.  This (like the other
+ * random functions) can be called from parallel regions; each thread draws
+ * from its own generator.
  */
 inline double Random()
 {
+#ifdef _OPENMP
+  if (omp_in_parallel())
+  {
+    ParallelRandomState& state = ThreadRandomState();
+    return state.uniform(state.generator);
+  }
+#endif
   return randUniformDist(randGen);
 }
 
@@ -57,7 +207,7 @@ inline double Random()
  */
 inline double Random(const double lo, const double hi)
 {
-  return lo + (hi - lo) * randUniformDist(randGen);
+  return lo + (hi - lo) * Random();
 }
 
 /**
@@ -65,7 +215,7 @@ inline double Random(const double lo, const double hi)
  */
 inline int RandInt(const int hiExclusive)
 {
-  return (int) std::floor((double) hiExclusive * randUniformDist(randGen));
+  return (int) std::floor((double) hiExclusive * Random());
 }
 
 /**
@@ -73,8 +223,7 @@ inline int RandInt(const int hiExclusive)
  */
 inline int RandInt(const int lo, const int hiExclusive)
 {
-  return lo + (int) std::floor((double) (hiExclusive - lo)
-                               * randUniformDist(randGen));
+  return lo + (int) std::floor((double) (hiExclusive - lo) * Random());
 }
 
 /**
@@ -82,6 +231,13 @@ inline int RandInt(const int lo, const int hiExclusive)
  */
 inline double RandNormal()
 {
+#ifdef _OPENMP
+  if (omp_in_parallel())
+  {
+    ParallelRandomState& state = ThreadRandomState();
+    return state.normal(state.generator);
+  }
+#endif
   return randNormalDist(randGen);
 }
 
@@ -94,7 +250,41 @@ inline double RandNormal()
  */
 inline double RandNormal(const double mean, const double variance)
 {
-  return variance * randNormalDist(randGen) + mean;
+  return variance * RandNormal() + mean;
+}
+
+/**
+ * Fill the given memory with a random mask: each element is 0 with probability
+ * ratio, and value otherwise.  Each element takes 16 bits of a draw of
+ * RandomGenerator() (so there are two elements per draw), compared with an
+ * integer threshold; this is much faster than drawing a uniform double for each
+ * element, and the ratio is only rounded to a multiple of 1 / 65536.
+ *
+ * @param mask Memory to fill.
+ * @param n Number of elements to fill.
+ * @param ratio Probability of an element to be 0.
+ * @param value Value of the other elements.
+ */
+template<typename eT>
+void RandomMask(eT* mask,
+                const size_t n,
+                const double ratio,
+                const double value)
+{
+  const uint32_t threshold = (uint32_t) std::floor(
+      std::min(std::max(ratio, 0.0), 1.0) * 65536.0 + 0.5);
+  const eT keep = (eT) value;
+
+  std::mt19937& generator = RandomGenerator();
+  size_t i = 0;
+  for (; i + 1 < n; i += 2)
+  {
+    const uint32_t bits = (uint32_t) generator();
+    mask[i] = ((bits & 0xFFFF) < threshold) ? eT(0) : keep;
+    mask[i + 1] = ((bits >> 16) < threshold) ? eT(0) : keep;
+  }
+  if (i < n)
+    mask[i] = (((uint32_t) generator() & 0xFFFF) < threshold) ? eT(0) : keep;
 }
 
 } // namespace math
@@ -52,6 +52,15 @@ class RangeType
    */
   inline RangeType(const T lo, const T hi);
 
+  /**
+   * Initialize from a range with a different element type (for instance, to
+   * convert the float distance ranges of a tree built on arma::fmat data).
+   *
+   * @param other Range to convert.
+   */
+  template<typename TT>
+  inline RangeType(const RangeType<TT>& other);
+
   //! Get the lower bound.
   inline T Lo() const { return lo; }
   //! Modify the lower bound.
@@ -35,6 +35,14 @@ template<typename T>
 inline RangeType<T>::RangeType(const T lo, const T hi) :
     lo(lo), hi(hi) { /* nothing else to do */ }
 
+/**
+ * Initializes the range from a range with a different element type.
+ */
+template<typename T>
+template<typename TT>
+inline RangeType<T>::RangeType(const RangeType<TT>& other) :
+    lo(other.Lo()), hi(other.Hi()) { /* nothing else to do */ }
+
 /**
  * Gets the span of the range, hi - lo.  Returns 0 if the range is negative.
  */
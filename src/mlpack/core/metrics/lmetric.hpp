@@ -78,6 +78,28 @@ class LMetric
   static typename VecTypeA::elem_type Evaluate(const VecTypeA& a,
                                                const VecTypeB& b);
 
+  /**
+   * Computes the distance between two points, but stops as soon as it is known
+   * to be greater than the given bound.  In that case the returned value is
+   * not less than the bound, but may be less than the distance (it is the
+   * distance over the dimensions considered so far).  Otherwise, the distance
+   * is returned, exactly as Evaluate() computes it.
+   *
+   * This is useful when points further than a bound are discarded, such as in
+   * the base cases of nearest neighbor search.
+   *
+   * @param a First vector.
+   * @param b Second vector.
+   * @param bound Distance beyond which the evaluation may stop.
+   * @return Distance between vectors a and b, or a value not less than the
+   *     bound if the distance is greater than the bound.
+   */
+  template<typename VecTypeA, typename VecTypeB>
+  static typename VecTypeA::elem_type EvaluateBounded(
+      const VecTypeA& a,
+      const VecTypeB& b,
+      const typename VecTypeA::elem_type bound);
+
   //! Serialize the metric (nothing to do).
   template<typename Archive>
   void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -10,95 +10,300 @@
 // In case it hasn't been included.
 #include "lmetric.hpp"
 
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_same.hpp>
+
 namespace mlpack {
 namespace metric {
+namespace aux {
 
-// Unspecialized implementation.  This should almost never be used...
-template<int Power, bool TakeRoot>
+//! Whether or not the given vector type stores its elements contiguously, so
+//! that the distance can be computed on raw pointers.
+template<typename VecType>
+struct IsDenseColumn
+{
+  static const bool value = false;
+};
+
+template<typename eT>
+struct IsDenseColumn<arma::Col<eT> >
+{
+  static const bool value = true;
+};
+
+template<typename eT>
+struct IsDenseColumn<arma::subview_col<eT> >
+{
+  static const bool value = true;
+};
+
+//! Whether the distance between the two vector types is computed with a raw
+//! loop over dense columns, with a merge of the nonzero elements of sparse
+//! columns, or (if both are false) with an Armadillo expression.
 template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<Power, TakeRoot>::Evaluate(
-    const VecTypeA& a,
-    const VecTypeB& b)
+struct LMetricLoop
 {
-  typename VecTypeA::elem_type sum = 0;
-  for (size_t i = 0; i < a.n_elem; i++)
-    sum += std::pow(fabs(a[i] - b[i]), Power);
+  static const bool sameFloat =
+      boost::is_floating_point<typename VecTypeA::elem_type>::value &&
+      boost::is_same<typename VecTypeA::elem_type,
+                     typename VecTypeB::elem_type>::value;
 
-  if (!TakeRoot) // The compiler should optimize this correctly at compile-time.
-    return sum;
+  static const bool dense = sameFloat && IsDenseColumn<VecTypeA>::value &&
+      IsDenseColumn<VecTypeB>::value;
+  static const bool sparse = sameFloat && IsSparseColumn<VecTypeA>::value &&
+      IsSparseColumn<VecTypeB>::value;
+};
 
-  return std::pow(sum, (1.0 / Power));
-}
+/**
+ * The contribution of one dimension to the Power'th power of the distance,
+ * how the contributions are combined, and the whole computation as an
+ * Armadillo expression (for vector types that are not dense columns).  The
+ * generic version uses std::pow(); the common powers are specialized below.
+ */
+template<int Power>
+struct LMetricTerm
+{
+  template<typename eT>
+  static eT Term(const eT diff) { return eT(std::pow(std::abs(diff), Power)); }
+
+  template<typename eT>
+  static eT Combine(const eT x, const eT y) { return x + y; }
+
+  template<typename VecTypeA, typename VecTypeB>
+  static typename VecTypeA::elem_type Expression(const VecTypeA& a,
+                                                 const VecTypeB& b)
+  {
+    return arma::accu(arma::pow(arma::abs(a - b), (double) Power));
+  }
+};
 
-// L1-metric specializations; the root doesn't matter.
 template<>
-template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<1, true>::Evaluate(
-    const VecTypeA& a,
-    const VecTypeB& b)
+struct LMetricTerm<1>
 {
-  return arma::accu(abs(a - b));
-}
+  template<typename eT>
+  static eT Term(const eT diff) { return std::abs(diff); }
+
+  template<typename eT>
+  static eT Combine(const eT x, const eT y) { return x + y; }
+
+  template<typename VecTypeA, typename VecTypeB>
+  static typename VecTypeA::elem_type Expression(const VecTypeA& a,
+                                                 const VecTypeB& b)
+  {
+    return arma::accu(arma::abs(a - b));
+  }
+};
 
 template<>
-template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<1, false>::Evaluate(
-    const VecTypeA& a,
-    const VecTypeB& b)
+struct LMetricTerm<2>
 {
-  return arma::accu(abs(a - b));
-}
+  template<typename eT>
+  static eT Term(const eT diff) { return diff * diff; }
+
+  template<typename eT>
+  static eT Combine(const eT x, const eT y) { return x + y; }
+
+  template<typename VecTypeA, typename VecTypeB>
+  static typename VecTypeA::elem_type Expression(const VecTypeA& a,
+                                                 const VecTypeB& b)
+  {
+    return arma::accu(arma::square(a - b));
+  }
+};
 
-// L2-metric specializations.
 template<>
-template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<2, true>::Evaluate(
+struct LMetricTerm<INT_MAX>
+{
+  template<typename eT>
+  static eT Term(const eT diff) { return std::abs(diff); }
+
+  template<typename eT>
+  static eT Combine(const eT x, const eT y) { return std::max(x, y); }
+
+  template<typename VecTypeA, typename VecTypeB>
+  static typename VecTypeA::elem_type Expression(const VecTypeA& a,
+                                                 const VecTypeB& b)
+  {
+    return arma::as_scalar(arma::max(arma::abs(a - b)));
+  }
+};
+
+/**
+ * Compute the Power'th power of the distance between the n-element arrays a and
+ * b (or the maximum difference, for INT_MAX).  Elements are processed in
+ * blocks of 16 with four independent accumulators, so that the compiler can
+ * vectorize the loop; after each block the partial result is compared with the
+ * bound, and the computation stops if it is exceeded.
+ */
+template<int Power, typename eT>
+inline eT LMetricSum(const eT* a, const eT* b, const size_t n, const eT bound)
+{
+  typedef LMetricTerm<Power> T;
+
+  eT result = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    eT acc[4] = { 0, 0, 0, 0 };
+    for (size_t j = 0; j < 16; j += 4)
+    {
+      acc[0] = T::Combine(acc[0], T::Term(a[i + j] - b[i + j]));
+      acc[1] = T::Combine(acc[1], T::Term(a[i + j + 1] - b[i + j + 1]));
+      acc[2] = T::Combine(acc[2], T::Term(a[i + j + 2] - b[i + j + 2]));
+      acc[3] = T::Combine(acc[3], T::Term(a[i + j + 3] - b[i + j + 3]));
+    }
+
+    result = T::Combine(result,
+        T::Combine(T::Combine(acc[0], acc[1]), T::Combine(acc[2], acc[3])));
+    if (result > bound)
+      return result;
+  }
+
+  for (; i < n; ++i)
+    result = T::Combine(result, T::Term(a[i] - b[i]));
+
+  return result;
+}
+
+//! Compute the Power'th power of the distance between two dense floating-point
+//! columns of the same element type, with the raw loop above.
+template<int Power, typename VecTypeA, typename VecTypeB>
+inline typename VecTypeA::elem_type LMetricSum(
     const VecTypeA& a,
-    const VecTypeB& b)
+    const VecTypeB& b,
+    const typename VecTypeA::elem_type bound,
+    const typename boost::enable_if_c<
+        LMetricLoop<VecTypeA, VecTypeB>::dense>::type* = 0)
 {
-  return sqrt(arma::accu(square(a - b)));
+  return LMetricSum<Power>(a.colptr(0), b.colptr(0), (size_t) a.n_elem, bound);
 }
 
-template<>
-template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<2, false>::Evaluate(
+//! Compute the Power'th power of the distance between two sparse floating-point
+//! columns of the same element type.  The nonzero elements of both columns are
+//! merged in order of their row, so this takes O(nnz(a) + nnz(b)) time and no
+//! temporary is allocated; the computation stops once the bound is exceeded.
+template<int Power, typename VecTypeA, typename VecTypeB>
+inline typename VecTypeA::elem_type LMetricSum(
     const VecTypeA& a,
-    const VecTypeB& b)
+    const VecTypeB& b,
+    const typename VecTypeA::elem_type bound,
+    const typename boost::enable_if_c<
+        LMetricLoop<VecTypeA, VecTypeB>::sparse>::type* = 0)
 {
-  return accu(arma::square(a - b));
+  typedef typename VecTypeA::elem_type ElemType;
+  typedef LMetricTerm<Power> T;
+
+  typename VecTypeA::const_iterator itA = a.begin();
+  const typename VecTypeA::const_iterator endA = a.end();
+  typename VecTypeB::const_iterator itB = b.begin();
+  const typename VecTypeB::const_iterator endB = b.end();
+
+  ElemType result = 0;
+  while (itA != endA || itB != endB)
+  {
+    ElemType diff;
+    if (itB == endB || (itA != endA && itA.row() < itB.row()))
+    {
+      diff = (*itA);
+      ++itA;
+    }
+    else if (itA == endA || itB.row() < itA.row())
+    {
+      diff = -(*itB);
+      ++itB;
+    }
+    else
+    {
+      diff = (*itA) - (*itB);
+      ++itA;
+      ++itB;
+    }
+
+    result = T::Combine(result, T::Term(diff));
+    if (result > bound)
+      return result;
+  }
+
+  return result;
 }
 
-// L3-metric specialization (not very likely to be used, but just in case).
-template<>
-template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<3, true>::Evaluate(
+//! Compute the Power'th power of the distance between any other vector types
+//! (integer or mixed dense and sparse vectors, expressions, ...) with
+//! Armadillo; the bound is not used.
+template<int Power, typename VecTypeA, typename VecTypeB>
+inline typename VecTypeA::elem_type LMetricSum(
     const VecTypeA& a,
-    const VecTypeB& b)
+    const VecTypeB& b,
+    const typename VecTypeA::elem_type /* bound */,
+    const typename boost::disable_if_c<
+        LMetricLoop<VecTypeA, VecTypeB>::dense ||
+        LMetricLoop<VecTypeA, VecTypeB>::sparse>::type* = 0)
 {
-  typename VecTypeA::elem_type sum = 0;
-  for (size_t i = 0; i < a.n_elem; i++)
-    sum += std::pow(fabs(a[i] - b[i]), 3.0);
+  return LMetricTerm<Power>::Expression(a, b);
+}
 
-  return std::pow(arma::accu(arma::pow(arma::abs(a - b), 3.0)), 1.0 / 3.0);
+//! Take the Power'th root of the given value.
+template<int Power, typename eT>
+inline eT LMetricRoot(const eT sum)
+{
+  if (Power == 1 || Power == INT_MAX)
+    return sum;
+  else if (Power == 2)
+    return std::sqrt(sum);
+  else
+    return std::pow(sum, eT(1.0 / Power));
 }
 
-template<>
+//! Raise the given value to the Power'th power (the inverse of LMetricRoot()).
+template<int Power, typename eT>
+inline eT LMetricPower(const eT value)
+{
+  if (Power == 1 || Power == INT_MAX)
+    return value;
+  else if (Power == 2)
+    return value * value;
+  else
+    return std::pow(value, eT(Power));
+}
+
+} // namespace aux
+
+template<int Power, bool TakeRoot>
 template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<3, false>::Evaluate(
+typename VecTypeA::elem_type LMetric<Power, TakeRoot>::Evaluate(
     const VecTypeA& a,
     const VecTypeB& b)
 {
-  return arma::accu(arma::pow(arma::abs(a - b), 3.0));
+  typedef typename VecTypeA::elem_type ElemType;
+
+  const ElemType sum = aux::LMetricSum<Power>(a, b,
+      std::numeric_limits<ElemType>::max());
+
+  if (!TakeRoot) // The compiler should optimize this correctly at compile-time.
+    return sum;
+
+  return aux::LMetricRoot<Power>(sum);
 }
 
-// L-infinity (Chebyshev distance) specialization
-template<>
+template<int Power, bool TakeRoot>
 template<typename VecTypeA, typename VecTypeB>
-typename VecTypeA::elem_type LMetric<INT_MAX, false>::Evaluate(
+typename VecTypeA::elem_type LMetric<Power, TakeRoot>::EvaluateBounded(
     const VecTypeA& a,
-    const VecTypeB& b)
+    const VecTypeB& b,
+    const typename VecTypeA::elem_type bound)
 {
-  return arma::as_scalar(arma::max(arma::abs(a - b)));
+  typedef typename VecTypeA::elem_type ElemType;
+
+  // The partial sum is compared with the bound, so it must be raised to the
+  // same power.
+  const ElemType sumBound = TakeRoot ? aux::LMetricPower<Power>(bound) : bound;
+  const ElemType sum = aux::LMetricSum<Power>(a, b, sumBound);
+
+  if (!TakeRoot)
+    return sum;
+
+  return aux::LMetricRoot<Power>(sum);
 }
 
 } // namespace metric
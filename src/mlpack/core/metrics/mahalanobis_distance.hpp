@@ -27,8 +27,8 @@ namespace metric {
  *
  * Because each evaluation multiplies (x_1 - x_2) by the covariance matrix, it
  * may be much quicker to use an LMetric and simply stretch the actual dataset
- * itself before performing any evaluations.  However, this class is provided
- * for convenience.
+ * itself before performing any evaluations; Whitening() gives the matrix to
+ * stretch the dataset with.  However, this class is provided for convenience.
  *
  * Similar to the LMetric class, this offers a template parameter TakeRoot
  * which, when set to false, will instead evaluate the distance
@@ -83,6 +83,26 @@ class MahalanobisDistance
   template<typename VecTypeA, typename VecTypeB>
   double Evaluate(const VecTypeA& a, const VecTypeB& b);
 
+  /**
+   * Compute the whitening transformation W of the covariance matrix Q, so that
+   * Q = W^T W.  Then
+   *
+   * @f[
+   * (x - y)^T Q (x - y) = || W x - W y ||^2,
+   * @f]
+   *
+   * so the Mahalanobis distance between two points is the Euclidean distance
+   * between the transformed points (or the squared Euclidean distance, if
+   * TakeRoot is false).  Transforming a dataset once with W costs O(d^2) per
+   * point, and then every evaluation costs only O(d), and any tree can be used.
+   *
+   * W is the upper triangular Cholesky factor of Q.  If Q is only positive
+   * semidefinite, then W is computed from its eigendecomposition instead.
+   *
+   * @param transformation Matrix to store the transformation W in.
+   */
+  void Whitening(arma::mat& transformation) const;
+
   /**
    * Access the covariance matrix.
    *
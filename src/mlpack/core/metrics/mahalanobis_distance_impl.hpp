@@ -42,6 +42,29 @@ double MahalanobisDistance<true>::Evaluate(const VecTypeA& a,
   return sqrt(out[0]);
 }
 
+// Compute the whitening transformation of the covariance matrix.
+template<bool TakeRoot>
+void MahalanobisDistance<TakeRoot>::Whitening(arma::mat& transformation) const
+{
+  // Q = R^T R, so (x - y)^T Q (x - y) = || R (x - y) ||^2.
+  if (arma::chol(transformation, covariance))
+    return;
+
+  // The Cholesky decomposition fails if Q is singular (for instance, Q = A^T A
+  // for a transformation A of lower rank), so use Q = V D V^T and W = D^(1/2)
+  // V^T instead.  Negative eigenvalues can only come from rounding.
+  arma::vec eigenvalues;
+  arma::mat eigenvectors;
+  if (!arma::eig_sym(eigenvalues, eigenvectors, covariance))
+  {
+    Log::Fatal << "MahalanobisDistance::Whitening(): eigendecomposition of "
+        << "the covariance matrix failed!" << std::endl;
+  }
+
+  eigenvalues.elem(arma::find(eigenvalues < 0.0)).zeros();
+  transformation = arma::diagmat(arma::sqrt(eigenvalues)) * eigenvectors.t();
+}
+
 // Serialize the Mahalanobis distance.
 template<bool TakeRoot>
 template<typename Archive>
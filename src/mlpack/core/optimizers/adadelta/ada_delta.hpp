@@ -11,6 +11,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_ADADELTA_ADA_DELTA_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -122,6 +123,11 @@ class AdaDelta
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
   //! The instantiated function.
   DecomposableFunctionType& function;
@@ -141,6 +147,10 @@ class AdaDelta
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The callback which is given the progress of the optimizer (may be
+  //! empty).
+  OptimizerCallback callback;
 };
 
 } // namespace optimization
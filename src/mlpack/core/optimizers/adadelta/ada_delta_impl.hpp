@@ -35,6 +35,9 @@ double AdaDelta<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   // This is used only if shuffle is true.
   arma::Col<size_t> visitationOrder;
   if (shuffle)
@@ -70,6 +73,16 @@ double AdaDelta<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       Log::Info << "AdaDelta: iteration " << i << ", objective "
           << overallObjective << "." << std::endl;
 
+      // AdaDelta has no step size to report.
+      const double nan = std::numeric_limits<double>::quiet_NaN();
+      if (monitor.Active() && monitor.Stop(i, overallObjective,
+          (i == 1) ? nan : arma::norm(gradient, "fro"), nan))
+      {
+        Log::Info << "AdaDelta: stopped by the callback; terminating "
+            << "optimization." << std::endl;
+        return overallObjective;
+      }
+
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
         Log::Warn << "AdaDelta: converged to " << overallObjective
@@ -100,18 +113,22 @@ double AdaDelta<DecomposableFunctionType>::Optimize(arma::mat& iterate)
     else
       function.Gradient(iterate, currentFunction, gradient);
 
-    // Accumulate gradient.
-    meanSquaredGradient *= rho;
-    meanSquaredGradient += (1 - rho) * (gradient % gradient);
-    arma::mat dx = arma::sqrt((meanSquaredGradientDx + eps) /
-        (meanSquaredGradient + eps)) % gradient;
-
-    // Accumulate updates.
-    meanSquaredGradientDx *= rho;
-    meanSquaredGradientDx += (1 - rho) * (dx % dx);
-
-    // Apply update.
-    iterate -= dx;
+    // Accumulate the gradient, compute and accumulate the update, and apply it,
+    // in a single pass without temporaries; only use threads when the iterate
+    // is large.
+    const double* g = gradient.memptr();
+    double* v = meanSquaredGradient.memptr();
+    double* vdx = meanSquaredGradientDx.memptr();
+    double* x = iterate.memptr();
+    const omp_size_t n = (omp_size_t) iterate.n_elem;
+    #pragma omp parallel for schedule(static) if (n >= 100000)
+    for (omp_size_t j = 0; j < n; ++j)
+    {
+      v[j] = rho * v[j] + (1 - rho) * (g[j] * g[j]);
+      const double dx = std::sqrt((vdx[j] + eps) / (v[j] + eps)) * g[j];
+      vdx[j] = rho * vdx[j] + (1 - rho) * (dx * dx);
+      x[j] -= dx;
+    }
 
     // Now add that to the overall objective function.
     if (shuffle)
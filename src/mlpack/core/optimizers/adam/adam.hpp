@@ -12,6 +12,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_ADAM_ADAM_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -136,6 +137,11 @@ class Adam
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
   //! The instantiated function.
   DecomposableFunctionType& function;
@@ -161,6 +167,10 @@ class Adam
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The callback which is given the progress of the optimizer (may be
+  //! empty).
+  OptimizerCallback callback;
 };
 
 } // namespace optimization
@@ -41,6 +41,9 @@ double Adam<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   // This is used only if shuffle is true.
   arma::Col<size_t> visitationOrder;
   if (shuffle)
@@ -74,6 +77,15 @@ double Adam<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       Log::Info << "Adam: iteration " << i << ", objective " << overallObjective
           << "." << std::endl;
 
+      if (monitor.Active() && monitor.Stop(i, overallObjective, (i == 1) ?
+          std::numeric_limits<double>::quiet_NaN() :
+          arma::norm(gradient, "fro"), stepSize))
+      {
+        Log::Info << "Adam: stopped by the callback; terminating "
+            << "optimization." << std::endl;
+        return overallObjective;
+      }
+
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
         Log::Warn << "Adam: converged to " << overallObjective
@@ -105,17 +117,25 @@ double Adam<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       function.Gradient(iterate, currentFunction, gradient);
 
     // And update the iterate.
-    mean *= beta1;
-    mean += (1 - beta1) * gradient;
-
-    variance *= beta2;
-    variance += (1 - beta2) * (gradient % gradient);
-
     const double biasCorrection1 = 1.0 - std::pow(beta1, (double) i);
     const double biasCorrection2 = 1.0 - std::pow(beta2, (double) i);
-
-    iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-        mean / (arma::sqrt(variance) + eps);
+    const double step = stepSize * std::sqrt(biasCorrection2) /
+        biasCorrection1;
+
+    // Update the moment estimates and the iterate in a single pass, without
+    // temporaries; only use threads when the iterate is large.
+    const double* g = gradient.memptr();
+    double* m = mean.memptr();
+    double* v = variance.memptr();
+    double* x = iterate.memptr();
+    const omp_size_t n = (omp_size_t) iterate.n_elem;
+    #pragma omp parallel for schedule(static) if (n >= 100000)
+    for (omp_size_t j = 0; j < n; ++j)
+    {
+      m[j] = beta1 * m[j] + (1 - beta1) * g[j];
+      v[j] = beta2 * v[j] + (1 - beta2) * (g[j] * g[j]);
+      x[j] -= step * m[j] / (std::sqrt(v[j]) + eps);
+    }
 
     // Now add that to the overall objective function.
     if (shuffle)
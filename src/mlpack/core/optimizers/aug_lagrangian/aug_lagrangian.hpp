@@ -12,6 +12,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
 
 #include "aug_lagrangian_function.hpp"
 
@@ -118,6 +119,13 @@ class AugLagrangian
   //! Modify the penalty parameter.
   double& Sigma() { return augfunc.Sigma(); }
 
+  //! Get the callback which is given the progress of the optimizer after each
+  //! outer iteration.  (The inner L-BFGS optimizer has its own callback.)
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer after
+  //! each outer iteration.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
   //! Function to be optimized.
   LagrangianFunction& function;
@@ -132,6 +140,9 @@ class AugLagrangian
 
   //! The L-BFGS optimizer that we will use.
   L_BFGSType& lbfgs;
+
+  //! The callback which is given the progress of the optimizer (may be empty).
+  OptimizerCallback callback;
 };
 
 } // namespace optimization
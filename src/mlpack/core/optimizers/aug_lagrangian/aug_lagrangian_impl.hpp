@@ -53,6 +53,9 @@ template<typename LagrangianFunction>
 bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
                                                  const size_t maxIterations)
 {
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   // Ensure that we update lambda immediately.
   double penaltyThreshold = DBL_MAX;
 
@@ -87,6 +90,13 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
 
     lastObjective = function.Evaluate(coordinates);
 
+    if (monitor.Stop(it, lastObjective,
+        std::numeric_limits<double>::quiet_NaN(), augfunc.Sigma()))
+    {
+      Log::Info << "AugLagrangian stopped by the callback." << std::endl;
+      return true;
+    }
+
     // Assuming that the optimization has converged to a new set of coordinates,
     // we now update either lambda or sigma.  We update sigma if the penalty
     // term is too high, and we update lambda otherwise.
@@ -0,0 +1,66 @@
+/**
+ * @file csv_callback.hpp
+ *
+ * An optimizer callback which writes the progress of the optimizer to a stream
+ * as CSV.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_CALLBACKS_CSV_CALLBACK_HPP
+#define MLPACK_CORE_OPTIMIZERS_CALLBACKS_CSV_CALLBACK_HPP
+
+#include "optimizer_callback.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * Write each OptimizerStatus as a line of CSV to the given stream, after a
+ * header line (iteration,objective,gradient_norm,step_size,elapsed).  The
+ * optimization is never stopped.
+ *
+ * @code
+ * std::ofstream trace("trace.csv");
+ * L_BFGS<LogisticRegressionFunction<>> lbfgs(lrf);
+ * lbfgs.Callback() = CSVCallback(trace);
+ * lbfgs.Optimize(parameters);
+ * @endcode
+ */
+class CSVCallback
+{
+ public:
+  /**
+   * Write the progress to the given stream, which must outlive the callback.
+   *
+   * @param stream Stream to write to.
+   * @param header If true, write the header line before the first status.
+   */
+  CSVCallback(std::ostream& stream, const bool header = true) :
+      stream(stream),
+      header(header)
+  { /* Nothing to do. */ }
+
+  //! Write the given status.
+  bool operator()(const OptimizerStatus& status)
+  {
+    if (header)
+    {
+      stream << "iteration,objective,gradient_norm,step_size,elapsed\n";
+      header = false;
+    }
+
+    stream << status.iteration << "," << status.objective << ","
+        << status.gradientNorm << "," << status.stepSize << ","
+        << status.elapsed << "\n";
+    return false;
+  }
+
+ private:
+  //! The stream to write to.
+  std::ostream& stream;
+  //! Whether the header line still has to be written.
+  bool header;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file optimizer_callback.hpp
+ *
+ * Definition of the callbacks which the optimizers call with their progress,
+ * and of OptimizerMonitor, which the optimizers use to call them.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_CALLBACKS_OPTIMIZER_CALLBACK_HPP
+#define MLPACK_CORE_OPTIMIZERS_CALLBACKS_OPTIMIZER_CALLBACK_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <chrono>
+#include <functional>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * The progress of an optimizer, given to an OptimizerCallback.  Each optimizer
+ * reports its progress at the points where it prints it with Log::Info or
+ * Log::Debug: once per pass over the functions for SGD, MiniBatchSGD,
+ * ParallelSGD, Adam, RMSprop and AdaDelta, once per iteration for L_BFGS and
+ * SA, and once per outer iteration for AugLagrangian (and so LRSDP).
+ */
+struct OptimizerStatus
+{
+  //! The iteration, numbered as in the log output of the optimizer.
+  size_t iteration;
+  //! The objective at the current iterate.  For the stochastic optimizers, this
+  //! is the sum of the objectives of the functions over the last pass.
+  double objective;
+  //! The norm of the last gradient computed by the optimizer (for the
+  //! stochastic optimizers, the gradient of the last function or batch), or
+  //! NaN if there is none.
+  double gradientNorm;
+  //! The step size of the optimizer (NaN for AdaDelta, which has none).  For
+  //! L_BFGS, this is the length of the last step; for SA, the temperature; for
+  //! AugLagrangian, the penalty parameter sigma.
+  double stepSize;
+  //! Time since the start of Optimize(), in seconds.
+  double elapsed;
+};
+
+/**
+ * A callback which is given the progress of an optimizer.  If the callback
+ * returns true, the optimizer stops and returns the objective of the current
+ * iterate, as if it had converged.
+ */
+typedef std::function<bool(const OptimizerStatus&)> OptimizerCallback;
+
+/**
+ * Call an OptimizerCallback with the progress of an optimizer, timed from the
+ * construction of the monitor.  If no callback is set, nothing is done, so the
+ * optimizers should only compute the status (e.g. gradient norms) when
+ * Active() is true.
+ */
+class OptimizerMonitor
+{
+ public:
+  /**
+   * Start timing for the given callback, which may be empty.
+   *
+   * @param callback Callback to call.
+   */
+  OptimizerMonitor(const OptimizerCallback& callback) :
+      callback(callback),
+      start(std::chrono::steady_clock::now())
+  { /* Nothing to do. */ }
+
+  //! Return whether a callback is set.
+  bool Active() const { return (bool) callback; }
+
+  /**
+   * Call the callback with the given progress, if it is set, and return true
+   * if the optimizer should stop.
+   *
+   * @param iteration Current iteration.
+   * @param objective Objective at the current iterate.
+   * @param gradientNorm Norm of the last gradient, or NaN.
+   * @param stepSize Step size of the optimizer.
+   */
+  bool Stop(const size_t iteration,
+            const double objective,
+            const double gradientNorm,
+            const double stepSize) const
+  {
+    if (!callback)
+      return false;
+
+    OptimizerStatus status;
+    status.iteration = iteration;
+    status.objective = objective;
+    status.gradientNorm = gradientNorm;
+    status.stepSize = stepSize;
+    status.elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    return callback(status);
+  }
+
+ private:
+  //! The callback to call.
+  const OptimizerCallback& callback;
+  //! The time the optimization started.
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file timer_callback.hpp
+ *
+ * An optimizer callback which records the time spent by the optimizer in an
+ * mlpack Timer.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_CALLBACKS_TIMER_CALLBACK_HPP
+#define MLPACK_CORE_OPTIMIZERS_CALLBACKS_TIMER_CALLBACK_HPP
+
+#include <mlpack/core.hpp>
+#include "optimizer_callback.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * Record the time spent by an optimizer in the Timer with the given name, and
+ * optionally stop the optimizer once a time limit or an objective threshold is
+ * reached.
+ *
+ * The timer is started at the first status, and stopped and restarted at each
+ * following status, so Timer::Get() gives the time from the first to the last
+ * status reported so far.  The timer is left running; like the other timers,
+ * it is stopped and printed at the end of the program (with --verbose).
+ *
+ * @code
+ * SGD<RegularizedSVDFunction> sgd(f);
+ * sgd.Callback() = TimerCallback("sgd_optimization", 60.0);
+ * sgd.Optimize(parameters);
+ * @endcode
+ */
+class TimerCallback
+{
+ public:
+  /**
+   * Record the time in the given timer, which must not be running already.
+   *
+   * @param name Name of the timer.
+   * @param maxTime Stop once this many seconds have elapsed since the start of
+   *     Optimize() (0 means no limit).
+   * @param targetObjective Stop once the objective is at most this value.
+   */
+  TimerCallback(const std::string& name,
+                const double maxTime = 0.0,
+                const double targetObjective = -DBL_MAX) :
+      name(name),
+      maxTime(maxTime),
+      targetObjective(targetObjective),
+      running(false)
+  { /* Nothing to do. */ }
+
+  //! Update the timer, and return whether the optimizer should stop.
+  bool operator()(const OptimizerStatus& status)
+  {
+    if (running)
+      Timer::Stop(name);
+    Timer::Start(name);
+    running = true;
+
+    return (maxTime > 0.0 && status.elapsed >= maxTime) ||
+        (status.objective <= targetObjective);
+  }
+
+ private:
+  //! The name of the timer.
+  std::string name;
+  //! The time limit, in seconds (0 means no limit).
+  double maxTime;
+  //! The objective to stop at.
+  double targetObjective;
+  //! Whether the timer has been started.
+  bool running;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
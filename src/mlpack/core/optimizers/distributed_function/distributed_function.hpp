@@ -0,0 +1,242 @@
+/**
+ * @file distributed_function.hpp
+ *
+ * A wrapper which evaluates the objective and gradient of a decomposable
+ * function whose points are sharded across the ranks of an MPI communicator.
+ * This is only available when mlpack is built with MPI support (USE_MPI=ON,
+ * which defines HAS_MPI).
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_DISTRIBUTED_FUNCTION_DISTRIBUTED_FUNCTION_HPP
+#define MLPACK_CORE_OPTIMIZERS_DISTRIBUTED_FUNCTION_DISTRIBUTED_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+
+#ifdef HAS_MPI
+
+#include <mpi.h>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * DistributedFunction wraps a decomposable function holding the shard of the
+ * points of one rank of an MPI communicator (for instance, a
+ * LogisticRegressionFunction built on the local points), and gives the
+ * objective and gradient of the function of all the points, as the sums over
+ * the ranks of the objectives and gradients of their shards, computed with
+ * MPI_Allreduce().  Every rank gets the same results, so an optimizer run with
+ * the same settings on every rank keeps the same parameters on every rank,
+ * without the parameters ever being sent.
+ *
+ * The wrapped function must implement
+ *
+ *   size_t NumFunctions();
+ *   double Evaluate(const arma::mat& coordinates);
+ *   void Gradient(const arma::mat& coordinates, arma::mat& gradient);
+ *
+ * for optimizers which use the full objective (such as L-BFGS), and
+ *
+ *   double Evaluate(const arma::mat& coordinates, const size_t i);
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::mat& gradient);
+ *
+ * (or the mini-batch overloads used by MiniBatchSGD) for MiniBatchSGD.  The
+ * full objective and gradient of each shard can be computed with several
+ * threads by wrapping the local function in a ParallelFunction first.
+ *
+ * For MiniBatchSGD, NumFunctions() is the size of the largest shard, and the
+ * mini-batch of the points begin to (begin + batchSize - 1) holds those points
+ * of every shard (shards which are too small give fewer points).  So each
+ * mini-batch holds up to Ranks() times batchSize points, whose gradients are
+ * summed: divide the step size by Ranks() to keep the step per point of a
+ * single process.  MiniBatchSGD must visit the batches in the same order on
+ * every rank, so the constructor sets the random seed of every rank to a seed
+ * drawn on rank 0.
+ *
+ * Terms of the objective which don't depend on the points (such as the
+ * regularization of LogisticRegressionFunction) are added once per rank; the
+ * regularization parameter given to the local functions should be divided by
+ * Ranks().  GetInitialPoint() returns the initial point of rank 0 on every
+ * rank.  Every function of this class which communicates must be called on
+ * every rank of the communicator, in the same order.
+ *
+ * @code
+ * MPI_Init(&argc, &argv);
+ * // Load the shard of the points of this rank...
+ * LogisticRegressionFunction<> lrf(localData, localResponses, lambda / ranks);
+ * DistributedFunction<LogisticRegressionFunction<>> f(lrf);
+ * L_BFGS<DistributedFunction<LogisticRegressionFunction<>>> lbfgs(f);
+ * arma::mat parameters = f.GetInitialPoint();
+ * lbfgs.Optimize(parameters);
+ * MPI_Finalize();
+ * @endcode
+ *
+ * @tparam FunctionType Decomposable function type to wrap.
+ */
+template<typename FunctionType>
+class DistributedFunction
+{
+ public:
+  /**
+   * Wrap the given function, holding the shard of the calling rank.  This
+   * must be called on every rank of the communicator.
+   *
+   * @param function Decomposable function to wrap.
+   * @param communicator Communicator of the ranks which hold the shards.
+   */
+  DistributedFunction(FunctionType& function,
+                      MPI_Comm communicator = MPI_COMM_WORLD);
+
+  /**
+   * Evaluate the sum of the objectives of all the points of all the shards.
+   *
+   * @param coordinates Coordinates to evaluate the objective at.
+   */
+  double Evaluate(const arma::mat& coordinates);
+
+  /**
+   * Evaluate the sum of the gradients of all the points of all the shards.
+   *
+   * @param coordinates Coordinates to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient);
+
+  /**
+   * Evaluate the sum of the objectives of the points begin to (begin +
+   * batchSize - 1) of all the shards.
+   *
+   * @param coordinates Coordinates to evaluate the objective at.
+   * @param begin Index of the first point of the batch in each shard.
+   * @param batchSize Number of points of the batch in each shard.
+   * @param deterministic Passed on to the wrapped function, if it has a
+   *     mini-batch Evaluate().
+   */
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic = true);
+
+  /**
+   * Evaluate the sum of the gradients of the points begin to (begin +
+   * batchSize - 1) of all the shards.
+   *
+   * @param coordinates Coordinates to evaluate the gradient at.
+   * @param begin Index of the first point of the batch in each shard.
+   * @param gradient Matrix to store the gradient in.
+   * @param batchSize Number of points of the batch in each shard.
+   */
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize);
+
+  //! Return the number of points of the largest shard.
+  size_t NumFunctions() const { return numFunctions; }
+
+  //! Return the initial point of the wrapped function of rank 0.
+  arma::mat GetInitialPoint() const;
+
+  //! Get the wrapped function.
+  const FunctionType& Function() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& Function() { return function; }
+
+  //! Get the rank of the calling process in the communicator.
+  int Rank() const { return rank; }
+  //! Get the number of ranks of the communicator.
+  int Ranks() const { return ranks; }
+
+ private:
+  //! Return the sum of the objectives of the local points begin to
+  //! (begin + size - 1), with the mini-batch Evaluate().
+  template<typename T = FunctionType>
+  typename std::enable_if<HasBatchEvaluate<T>::value, double>::type
+  LocalEvaluate(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size,
+                const bool deterministic)
+  {
+    return function.Evaluate(coordinates, begin, size, deterministic);
+  }
+
+  //! Return the sum of the objectives of the local points begin to
+  //! (begin + size - 1), one point at a time.
+  template<typename T = FunctionType>
+  typename std::enable_if<!HasBatchEvaluate<T>::value, double>::type
+  LocalEvaluate(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size,
+                const bool /* deterministic */)
+  {
+    double objective = 0;
+    for (size_t i = begin; i < begin + size; ++i)
+      objective += function.Evaluate(coordinates, i);
+    return objective;
+  }
+
+  //! Store in gradient the sum of the gradients of the local points begin to
+  //! (begin + size - 1), with the mini-batch Gradient().
+  template<typename T = FunctionType>
+  typename std::enable_if<HasBatchGradient<T>::value, void>::type
+  LocalGradient(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size,
+                arma::mat& gradient)
+  {
+    function.Gradient(coordinates, begin, gradient, size);
+  }
+
+  //! Store in gradient the sum of the gradients of the local points begin to
+  //! (begin + size - 1), one point at a time.
+  template<typename T = FunctionType>
+  typename std::enable_if<!HasBatchGradient<T>::value, void>::type
+  LocalGradient(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size,
+                arma::mat& gradient)
+  {
+    function.Gradient(coordinates, begin, gradient);
+    for (size_t i = begin + 1; i < begin + size; ++i)
+    {
+      function.Gradient(coordinates, i, pointGradient);
+      gradient += pointGradient;
+    }
+  }
+
+  //! Replace the given objective with its sum over the ranks.
+  double SumObjective(double objective) const;
+
+  //! Replace the given gradient with its sum over the ranks.
+  void SumGradient(arma::mat& gradient) const;
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The communicator of the ranks.
+  MPI_Comm communicator;
+
+  //! The rank of the calling process.
+  int rank;
+
+  //! The number of ranks.
+  int ranks;
+
+  //! The number of points of the largest shard.
+  size_t numFunctions;
+
+  //! The gradient of one point, kept to avoid reallocations.
+  arma::mat pointGradient;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+// Include implementation.
+#include "distributed_function_impl.hpp"
+
+#endif // HAS_MPI
+
+#endif
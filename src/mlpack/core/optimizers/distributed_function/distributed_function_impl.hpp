@@ -0,0 +1,119 @@
+/**
+ * @file distributed_function_impl.hpp
+ *
+ * Implementation of the DistributedFunction wrapper, which evaluates the
+ * objective and gradient of a decomposable function sharded across MPI ranks.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_DISTRIBUTED_FUNCTION_DISTRIBUTED_FUNCTION_IMPL_HPP
+#define MLPACK_CORE_OPTIMIZERS_DISTRIBUTED_FUNCTION_DISTRIBUTED_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "distributed_function.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<typename FunctionType>
+DistributedFunction<FunctionType>::DistributedFunction(
+    FunctionType& function,
+    MPI_Comm communicator) :
+    function(function),
+    communicator(communicator)
+{
+  MPI_Comm_rank(communicator, &rank);
+  MPI_Comm_size(communicator, &ranks);
+
+  unsigned long long localFunctions = function.NumFunctions();
+  unsigned long long maxFunctions = 0;
+  MPI_Allreduce(&localFunctions, &maxFunctions, 1, MPI_UNSIGNED_LONG_LONG,
+      MPI_MAX, communicator);
+  numFunctions = (size_t) maxFunctions;
+
+  // Optimizers which shuffle the points must draw the same random numbers on
+  // every rank, so that they visit the same batches.
+  unsigned int seed = (unsigned int) math::RandInt(1 << 30);
+  MPI_Bcast(&seed, 1, MPI_UNSIGNED, 0, communicator);
+  math::RandomSeed(seed);
+}
+
+template<typename FunctionType>
+double DistributedFunction<FunctionType>::Evaluate(
+    const arma::mat& coordinates)
+{
+  return SumObjective(function.Evaluate(coordinates));
+}
+
+template<typename FunctionType>
+void DistributedFunction<FunctionType>::Gradient(const arma::mat& coordinates,
+                                                 arma::mat& gradient)
+{
+  function.Gradient(coordinates, gradient);
+  SumGradient(gradient);
+}
+
+template<typename FunctionType>
+double DistributedFunction<FunctionType>::Evaluate(
+    const arma::mat& coordinates,
+    const size_t begin,
+    const size_t batchSize,
+    const bool deterministic)
+{
+  // The shard of this rank may end before the batch does.
+  const size_t localFunctions = function.NumFunctions();
+  const size_t end = std::min(begin + batchSize, localFunctions);
+  const double objective = (begin < end) ?
+      LocalEvaluate(coordinates, begin, end - begin, deterministic) : 0.0;
+
+  return SumObjective(objective);
+}
+
+template<typename FunctionType>
+void DistributedFunction<FunctionType>::Gradient(const arma::mat& coordinates,
+                                                 const size_t begin,
+                                                 arma::mat& gradient,
+                                                 const size_t batchSize)
+{
+  const size_t localFunctions = function.NumFunctions();
+  const size_t end = std::min(begin + batchSize, localFunctions);
+  if (begin < end)
+    LocalGradient(coordinates, begin, end - begin, gradient);
+  else
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+  SumGradient(gradient);
+}
+
+template<typename FunctionType>
+arma::mat DistributedFunction<FunctionType>::GetInitialPoint() const
+{
+  arma::mat initialPoint = function.GetInitialPoint();
+
+  // Every rank must allocate the matrix before it is broadcast.
+  unsigned long long size[2] = { initialPoint.n_rows, initialPoint.n_cols };
+  MPI_Bcast(size, 2, MPI_UNSIGNED_LONG_LONG, 0, communicator);
+  initialPoint.resize((size_t) size[0], (size_t) size[1]);
+
+  MPI_Bcast(initialPoint.memptr(), (int) initialPoint.n_elem, MPI_DOUBLE, 0,
+      communicator);
+  return initialPoint;
+}
+
+template<typename FunctionType>
+double DistributedFunction<FunctionType>::SumObjective(double objective) const
+{
+  MPI_Allreduce(MPI_IN_PLACE, &objective, 1, MPI_DOUBLE, MPI_SUM,
+      communicator);
+  return objective;
+}
+
+template<typename FunctionType>
+void DistributedFunction<FunctionType>::SumGradient(arma::mat& gradient) const
+{
+  MPI_Allreduce(MPI_IN_PLACE, gradient.memptr(), (int) gradient.n_elem,
+      MPI_DOUBLE, MPI_SUM, communicator);
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -9,6 +9,7 @@
 #define MLPACK_CORE_OPTIMIZERS_LBFGS_LBFGS_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -145,6 +146,11 @@ class L_BFGS
   //! Modify the maximum line search step size.
   double& MaxStep() { return maxStep; }
 
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
   //! Internal reference to the function we are optimizing.
   FunctionType& function;
@@ -174,6 +180,8 @@ class L_BFGS
   double minStep;
   //! Maximum step of the line search.
   double maxStep;
+  //! The callback which is given the progress of the optimizer (may be empty).
+  OptimizerCallback callback;
 
   //! Best point found so far.
   std::pair<arma::mat, double> minPointIterate;
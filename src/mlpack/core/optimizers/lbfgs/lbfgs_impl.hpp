@@ -356,6 +356,9 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
   y.set_size(rows, cols, numBasis);
   minPointIterate.second = std::numeric_limits<double>::max();
 
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   // The old iterate to be saved.
   arma::mat oldIterate;
   oldIterate.zeros(iterate.n_rows, iterate.n_cols);
@@ -384,11 +387,20 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
   for (size_t itNum = 0; optimizeUntilConvergence || (itNum != maxIterations);
        ++itNum)
   {
-    Log::Debug << "L-BFGS iteration " << itNum << "; objective " <<
-        function.Evaluate(iterate) << ", gradient norm " <<
-        arma::norm(gradient, 2) << ", " <<
-        ((prevFunctionValue - functionValue) /
-         std::max(std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0)) << "." << std::endl;
+    MLPACK_LOG(Log::Debug) << "L-BFGS iteration " << itNum << "; objective "
+        << functionValue << ", gradient norm " << arma::norm(gradient, 2)
+        << ", " << ((prevFunctionValue - functionValue) / std::max(std::max(
+        fabs(prevFunctionValue), fabs(functionValue)), 1.0)) << "."
+        << std::endl;
+
+    // The step size given to the callback is the length of the last step.
+    if (monitor.Active() && monitor.Stop(itNum, functionValue,
+        arma::norm(gradient, "fro"),
+        (itNum == 0) ? 0.0 : arma::norm(iterate - oldIterate, "fro")))
+    {
+      Log::Debug << "L-BFGS stopped by the callback." << std::endl;
+      break;
+    }
 
     prevFunctionValue = functionValue;
 
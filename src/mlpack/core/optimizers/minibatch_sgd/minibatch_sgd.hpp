@@ -8,10 +8,47 @@
 #define MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_MINIBATCH_SGD_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 namespace mlpack {
 namespace optimization {
 
+HAS_MEM_FUNC(Evaluate, HasBatchEvaluateCheck);
+HAS_MEM_FUNC(Gradient, HasBatchGradientCheck);
+
+/**
+ * This is a template struct that tells whether a decomposable function type
+ * has an Evaluate() function for a mini-batch of functions (either const or
+ * not).
+ */
+template<typename FunctionType>
+struct HasBatchEvaluate
+{
+  static const bool value =
+      HasBatchEvaluateCheck<FunctionType, double(FunctionType::*)(
+          const arma::mat&, const size_t, const size_t, const bool)>::value ||
+      HasBatchEvaluateCheck<FunctionType, double(FunctionType::*)(
+          const arma::mat&, const size_t, const size_t, const bool)
+          const>::value;
+};
+
+/**
+ * This is a template struct that tells whether a decomposable function type
+ * has a Gradient() function for a mini-batch of functions (either const or
+ * not).
+ */
+template<typename FunctionType>
+struct HasBatchGradient
+{
+  static const bool value =
+      HasBatchGradientCheck<FunctionType, void(FunctionType::*)(
+          const arma::mat&, const size_t, arma::mat&, const size_t)>::value ||
+      HasBatchGradientCheck<FunctionType, void(FunctionType::*)(
+          const arma::mat&, const size_t, arma::mat&, const size_t)
+          const>::value;
+};
+
 /**
  * Mini-batch Stochastic Gradient Descent is a technique for minimizing a
  * function which can be expressed as a sum of other functions.  That is,
@@ -62,6 +99,25 @@ namespace optimization {
  * function on the first point in the dataset (presumably, the dataset is held
  * internally in the DecomposableFunctionType).
  *
+ * If the DecomposableFunctionType also implements the following functions,
+ * they are used to evaluate a whole mini-batch of consecutive functions at
+ * once, which can be much faster (for instance, a neural network can then
+ * propagate a matrix of points through each layer instead of one vector at a
+ * time):
+ *
+ *   double Evaluate(const arma::mat& coordinates,
+ *                   const size_t begin,
+ *                   const size_t batchSize,
+ *                   const bool deterministic);
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t begin,
+ *                 arma::mat& gradient,
+ *                 const size_t batchSize);
+ *
+ * They should return the sum of the objectives (or gradients) of the functions
+ * begin to (begin + batchSize - 1).  Otherwise, the gradient of each mini-batch
+ * is summed from the gradients of its functions, one at a time.
+ *
  * @tparam DecomposableFunctionType Decomposable objective function type to be
  *     minimized.
  */
@@ -132,7 +188,66 @@ class MiniBatchSGD
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
+  //! The type of the function, if DecomposableFunctionType is a reference.
+  typedef typename std::remove_reference<DecomposableFunctionType>::type
+      FunctionType;
+
+  //! Return the sum of the objectives of the functions begin to
+  //! (begin + size - 1).
+  template<typename T = FunctionType>
+  typename std::enable_if<HasBatchEvaluate<T>::value, double>::type
+  BatchEvaluate(const arma::mat& iterate,
+                const size_t begin,
+                const size_t size)
+  {
+    return (size == 0) ? 0.0 : function.Evaluate(iterate, begin, size, true);
+  }
+
+  template<typename T = FunctionType>
+  typename std::enable_if<!HasBatchEvaluate<T>::value, double>::type
+  BatchEvaluate(const arma::mat& iterate,
+                const size_t begin,
+                const size_t size)
+  {
+    double objective = 0;
+    for (size_t j = 0; j < size; ++j)
+      objective += function.Evaluate(iterate, begin + j);
+    return objective;
+  }
+
+  //! Store in gradient the sum of the gradients of the functions begin to
+  //! (begin + size - 1).
+  template<typename T = FunctionType>
+  typename std::enable_if<HasBatchGradient<T>::value, void>::type
+  BatchGradient(const arma::mat& iterate,
+                const size_t begin,
+                const size_t size,
+                arma::mat& gradient)
+  {
+    function.Gradient(iterate, begin, gradient, size);
+  }
+
+  template<typename T = FunctionType>
+  typename std::enable_if<!HasBatchGradient<T>::value, void>::type
+  BatchGradient(const arma::mat& iterate,
+                const size_t begin,
+                const size_t size,
+                arma::mat& gradient)
+  {
+    function.Gradient(iterate, begin, gradient);
+    for (size_t j = 1; j < size; ++j)
+    {
+      function.Gradient(iterate, begin + j, funcGradient);
+      gradient += funcGradient;
+    }
+  }
+
   //! The instantiated function.
   DecomposableFunctionType& function;
 
@@ -151,6 +266,14 @@ class MiniBatchSGD
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The callback which is given the progress of the optimizer (may be
+  //! empty).
+  OptimizerCallback callback;
+
+  //! The gradient of a single function, when the gradient of a mini-batch is
+  //! summed one function at a time; kept to avoid reallocations.
+  arma::mat funcGradient;
 };
 
 } // namespace optimization
@@ -35,6 +35,9 @@ double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
 {
   // Find the number of functions.
   const size_t numFunctions = function.NumFunctions();
+
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
   size_t numBatches = numFunctions / batchSize;
   if (numFunctions % batchSize != 0)
     ++numBatches; // Capture last few.
@@ -51,8 +54,9 @@ double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   double lastObjective = DBL_MAX;
 
   // Calculate the first objective function.
-  for (size_t i = 0; i < numFunctions; ++i)
-    overallObjective += function.Evaluate(iterate, i);
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+    overallObjective += BatchEvaluate(iterate, i,
+        std::min(batchSize, numFunctions - i));
 
   // Now iterate!
   arma::mat gradient(iterate.n_rows, iterate.n_cols);
@@ -65,6 +69,15 @@ double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       Log::Info << "Mini-batch SGD: iteration " << i << ", objective "
           << overallObjective << "." << std::endl;
 
+      if (monitor.Active() && monitor.Stop(i, overallObjective, (i == 1) ?
+          std::numeric_limits<double>::quiet_NaN() :
+          arma::norm(gradient, "fro"), stepSize))
+      {
+        Log::Info << "Mini-batch SGD: stopped by the callback; terminating "
+            << "optimization." << std::endl;
+        return overallObjective;
+      }
+
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
         Log::Warn << "Mini-batch SGD: converged to " << overallObjective
@@ -92,33 +105,22 @@ double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
     // Evaluate the gradient for this mini-batch.
     const size_t offset = (shuffle) ? batchSize * visitationOrder[currentBatch]
         : batchSize * currentBatch;
-    function.Gradient(iterate, offset, gradient);
     if (visitationOrder[currentBatch] != numBatches - 1)
     {
-      for (size_t j = 1; j < batchSize; ++j)
-      {
-        arma::mat funcGradient;
-        function.Gradient(iterate, offset + j, funcGradient);
-        gradient += funcGradient;
-      }
+      BatchGradient(iterate, offset, batchSize, gradient);
 
       // Now update the iterate.
       iterate -= (stepSize / batchSize) * gradient;
 
       // Add that to the overall objective function.
-      for (size_t j = 0; j < batchSize; ++j)
-        overallObjective += function.Evaluate(iterate, offset + j);
+      overallObjective += BatchEvaluate(iterate, offset, batchSize);
     }
     else
     {
       // Handle last batch differently: it's not a full-size batch.
       const size_t lastBatchSize = numFunctions - offset - 1;
-      for (size_t j = 1; j < lastBatchSize; ++j)
-      {
-        arma::mat funcGradient;
-        function.Gradient(iterate, offset + j, funcGradient);
-        gradient += funcGradient;
-      }
+      BatchGradient(iterate, offset, std::max(lastBatchSize, (size_t) 1),
+          gradient);
 
       // Ensure the last batch size isn't zero, to avoid division by zero before
       // updating.
@@ -134,8 +136,7 @@ double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       }
 
       // Add that to the overall objective function.
-      for (size_t j = 0; j < lastBatchSize; ++j)
-        overallObjective += function.Evaluate(iterate, offset + j);
+      overallObjective += BatchEvaluate(iterate, offset, lastBatchSize);
     }
   }
 
@@ -144,8 +145,9 @@ double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
 
   // Calculate final objective.
   overallObjective = 0;
-  for (size_t i = 0; i < numFunctions; ++i)
-    overallObjective += function.Evaluate(iterate, i);
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+    overallObjective += BatchEvaluate(iterate, i,
+        std::min(batchSize, numFunctions - i));
 
   return overallObjective;
 }
@@ -0,0 +1,209 @@
+/**
+ * @file parallel_function.hpp
+ *
+ * A wrapper which evaluates the full objective and gradient of a decomposable
+ * function in parallel, for optimizers which use the full objective (such as
+ * L-BFGS, the augmented Lagrangian optimizer and simulated annealing).
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_PARALLEL_FUNCTION_PARALLEL_FUNCTION_HPP
+#define MLPACK_CORE_OPTIMIZERS_PARALLEL_FUNCTION_PARALLEL_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * ParallelFunction wraps a decomposable function, which implements
+ *
+ *   size_t NumFunctions();
+ *   double Evaluate(const arma::mat& coordinates, const size_t i);
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::mat& gradient);
+ *
+ * (or the mini-batch overloads used by MiniBatchSGD instead of the last two),
+ * and gives the full objective and gradient
+ *
+ *   double Evaluate(const arma::mat& coordinates);
+ *   void Gradient(const arma::mat& coordinates, arma::mat& gradient);
+ *
+ * as the sums over all the functions, computed in parallel with OpenMP.  The
+ * functions are split into a fixed number of contiguous chunks, whose results
+ * are added in order at the end, so the results do not depend on the number
+ * of threads or on the scheduling.  When the wrapped function has the
+ * mini-batch overloads, each chunk is computed with one call to them.
+ *
+ * The wrapped Evaluate() and Gradient() functions must be safe to call from
+ * several threads at once; this is the case for LogisticRegressionFunction and
+ * SoftmaxRegressionFunction, for instance.  GetInitialPoint() and, for
+ * constrained problems (AugLagrangian), the constraint functions are passed on
+ * to the wrapped function.
+ *
+ * @code
+ * LogisticRegressionFunction<> lrf(data, responses);
+ * ParallelFunction<LogisticRegressionFunction<>> f(lrf);
+ * L_BFGS<ParallelFunction<LogisticRegressionFunction<>>> lbfgs(f);
+ * lbfgs.Optimize(parameters);
+ * @endcode
+ *
+ * @tparam FunctionType Decomposable function type to wrap.
+ */
+template<typename FunctionType>
+class ParallelFunction
+{
+ public:
+  /**
+   * Wrap the given function.  The results depend on the number of chunks,
+   * which bounds the number of threads that can be used, and the memory used
+   * by Gradient() (one gradient is kept per chunk).
+   *
+   * @param function Decomposable function to wrap.
+   * @param chunks Number of chunks the functions are split into.
+   */
+  ParallelFunction(FunctionType& function, const size_t chunks = 32);
+
+  /**
+   * Evaluate the sum of the objectives of all the functions.
+   *
+   * @param coordinates Coordinates to evaluate the objective at.
+   */
+  double Evaluate(const arma::mat& coordinates);
+
+  /**
+   * Evaluate the sum of the gradients of all the functions.
+   *
+   * @param coordinates Coordinates to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient);
+
+  //! Evaluate the objective of a single function.
+  double Evaluate(const arma::mat& coordinates, const size_t i)
+  {
+    return function.Evaluate(coordinates, i);
+  }
+
+  //! Evaluate the gradient of a single function.
+  void Gradient(const arma::mat& coordinates,
+                const size_t i,
+                arma::mat& gradient)
+  {
+    function.Gradient(coordinates, i, gradient);
+  }
+
+  //! Return the number of functions.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Return the initial point of the wrapped function.
+  arma::mat GetInitialPoint() const { return function.GetInitialPoint(); }
+
+  //! Return the number of constraints of the wrapped function.
+  size_t NumConstraints() const { return function.NumConstraints(); }
+
+  //! Evaluate the given constraint of the wrapped function.
+  double EvaluateConstraint(const size_t index, const arma::mat& coordinates)
+  {
+    return function.EvaluateConstraint(index, coordinates);
+  }
+
+  //! Evaluate the gradient of the given constraint of the wrapped function.
+  void GradientConstraint(const size_t index,
+                          const arma::mat& coordinates,
+                          arma::mat& gradient)
+  {
+    function.GradientConstraint(index, coordinates, gradient);
+  }
+
+  //! Get the wrapped function.
+  const FunctionType& Function() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& Function() { return function; }
+
+  //! Get the number of chunks.
+  size_t Chunks() const { return chunks; }
+  //! Modify the number of chunks.
+  size_t& Chunks() { return chunks; }
+
+ private:
+  //! Return the number of chunks to use for the given number of functions
+  //! (no chunk is empty).
+  size_t NumChunks(const size_t numFunctions) const
+  {
+    return std::max((size_t) 1, std::min(chunks, numFunctions));
+  }
+
+  //! Return the sum of the objectives of the functions begin to
+  //! (begin + size - 1), with the mini-batch Evaluate().
+  template<typename T = FunctionType>
+  typename std::enable_if<HasBatchEvaluate<T>::value, double>::type
+  ChunkEvaluate(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size)
+  {
+    return (size == 0) ? 0.0 :
+        function.Evaluate(coordinates, begin, size, true);
+  }
+
+  //! Return the sum of the objectives of the functions begin to
+  //! (begin + size - 1), one function at a time.
+  template<typename T = FunctionType>
+  typename std::enable_if<!HasBatchEvaluate<T>::value, double>::type
+  ChunkEvaluate(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size)
+  {
+    double objective = 0;
+    for (size_t i = begin; i < begin + size; ++i)
+      objective += function.Evaluate(coordinates, i);
+    return objective;
+  }
+
+  //! Store in gradient the sum of the gradients of the functions begin to
+  //! (begin + size - 1), with the mini-batch Gradient().
+  template<typename T = FunctionType>
+  typename std::enable_if<HasBatchGradient<T>::value, void>::type
+  ChunkGradient(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size,
+                arma::mat& gradient)
+  {
+    function.Gradient(coordinates, begin, gradient, size);
+  }
+
+  //! Store in gradient the sum of the gradients of the functions begin to
+  //! (begin + size - 1), one function at a time.
+  template<typename T = FunctionType>
+  typename std::enable_if<!HasBatchGradient<T>::value, void>::type
+  ChunkGradient(const arma::mat& coordinates,
+                const size_t begin,
+                const size_t size,
+                arma::mat& gradient)
+  {
+    arma::mat funcGradient;
+    function.Gradient(coordinates, begin, gradient);
+    for (size_t i = begin + 1; i < begin + size; ++i)
+    {
+      function.Gradient(coordinates, i, funcGradient);
+      gradient += funcGradient;
+    }
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The number of chunks the functions are split into.
+  size_t chunks;
+
+  //! The gradient of each chunk, kept to avoid reallocations.
+  std::vector<arma::mat> chunkGradients;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+// Include implementation.
+#include "parallel_function_impl.hpp"
+
+#endif
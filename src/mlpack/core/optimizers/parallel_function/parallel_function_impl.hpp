@@ -0,0 +1,86 @@
+/**
+ * @file parallel_function_impl.hpp
+ *
+ * Implementation of the ParallelFunction wrapper, which evaluates the full
+ * objective and gradient of a decomposable function in parallel.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_PARALLEL_FUNCTION_PARALLEL_FUNCTION_IMPL_HPP
+#define MLPACK_CORE_OPTIMIZERS_PARALLEL_FUNCTION_PARALLEL_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_function.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<typename FunctionType>
+ParallelFunction<FunctionType>::ParallelFunction(FunctionType& function,
+                                                 const size_t chunks) :
+    function(function),
+    chunks(chunks)
+{
+  if (chunks == 0)
+    throw std::invalid_argument("ParallelFunction: number of chunks must be "
+        "greater than 0");
+}
+
+template<typename FunctionType>
+double ParallelFunction<FunctionType>::Evaluate(const arma::mat& coordinates)
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numChunks = NumChunks(numFunctions);
+
+  arma::vec objectives(numChunks);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t c = 0; c < (omp_size_t) numChunks; ++c)
+  {
+    const size_t begin = c * numFunctions / numChunks;
+    const size_t end = (c + 1) * numFunctions / numChunks;
+    objectives[c] = ChunkEvaluate(coordinates, begin, end - begin);
+  }
+
+  // Add the chunks in order, so that the result does not depend on the
+  // threads.
+  double objective = 0;
+  for (size_t c = 0; c < numChunks; ++c)
+    objective += objectives[c];
+
+  return objective;
+}
+
+template<typename FunctionType>
+void ParallelFunction<FunctionType>::Gradient(const arma::mat& coordinates,
+                                              arma::mat& gradient)
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numChunks = NumChunks(numFunctions);
+
+  chunkGradients.resize(numChunks);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t c = 0; c < (omp_size_t) numChunks; ++c)
+  {
+    const size_t begin = c * numFunctions / numChunks;
+    const size_t end = (c + 1) * numFunctions / numChunks;
+    ChunkGradient(coordinates, begin, end - begin, chunkGradients[c]);
+  }
+
+  // Add the chunks in order for each element, so that the result does not
+  // depend on the threads.
+  gradient.set_size(chunkGradients[0].n_rows, chunkGradients[0].n_cols);
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) gradient.n_elem; ++i)
+  {
+    double sum = chunkGradients[0][i];
+    for (size_t c = 1; c < numChunks; ++c)
+      sum += chunkGradients[c][i];
+    gradient[i] = sum;
+  }
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file parallel_sgd.hpp
+ *
+ * Parallel, lock-free (Hogwild!) stochastic gradient descent.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_HPP
+#define MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
+#include <mlpack/core/optimizers/sgd/sgd.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * An implementation of parallel stochastic gradient descent without locks
+ * (Hogwild!), for the same decomposable objective functions as SGD:
+ *
+ * @code
+ * @inproceedings{recht2011hogwild,
+ *   title={Hogwild!: A lock-free approach to parallelizing stochastic gradient
+ *       descent},
+ *   author={Recht, B. and Re, C. and Wright, S. and Niu, F.},
+ *   booktitle={Advances in Neural Information Processing Systems 24 (NIPS
+ *       2011)},
+ *   pages={693--701},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * Each pass over the functions splits the visitation order into one
+ * contiguous part per OpenMP thread, and each thread takes SGD steps for the
+ * functions of its part, writing to the shared iterate without any locking.
+ * When the objective is sparse (each function only depends on a few of the
+ * coordinates, as with regularized SVD), the threads rarely touch the same
+ * coordinates, and the speedup is nearly linear in the number of threads.
+ * Because the updates of the threads interleave, the result depends on the
+ * scheduling of the threads; with one thread, this is plain SGD.
+ *
+ * The DecomposableFunctionType template parameter must implement the same
+ * functions as for SGD:
+ *
+ *   size_t NumFunctions();
+ *   double Evaluate(const arma::mat& coordinates, const size_t i);
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::mat& gradient);
+ *
+ * and Evaluate() and Gradient() must be safe to call from several threads at
+ * once.  If the function type also implements
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::sp_mat& gradient);
+ *
+ * then the sparse gradient is used instead, and only the coordinates with a
+ * nonzero gradient are written.  For sparse objectives, this is what keeps the
+ * threads from overwriting each other's updates.  A Gradient() overload which
+ * gives the nonzero columns of the gradient (see ColumnGradient) is preferred
+ * over both, since each step then takes O(rows * nonzero columns) time.
+ *
+ * @tparam DecomposableFunctionType Decomposable objective function type to be
+ *     minimized.
+ */
+template<typename DecomposableFunctionType>
+class ParallelSGD
+{
+ public:
+  /**
+   * Construct the ParallelSGD optimizer with the given function and
+   * parameters.  Unlike SGD, the maximum number of iterations refers to the
+   * maximum number of passes over all the functions.
+   *
+   * @param function Function to be optimized (minimized).
+   * @param stepSize Step size for each iteration.
+   * @param maxIterations Maximum number of passes over all the functions (0
+   *     means no limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled before each pass;
+   *     otherwise, each function is visited in linear order.
+   */
+  ParallelSGD(DecomposableFunctionType& function,
+              const double stepSize = 0.01,
+              const size_t maxIterations = 100,
+              const double tolerance = 1e-5,
+              const bool shuffle = true);
+
+  /**
+   * Optimize the given function using parallel stochastic gradient descent.
+   * The given starting point will be modified to store the finishing point of
+   * the algorithm, and the final objective value is returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate);
+
+  //! Get the instantiated function to be optimized.
+  const DecomposableFunctionType& Function() const { return function; }
+  //! Modify the instantiated function.
+  DecomposableFunctionType& Function() { return function; }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of passes (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of passes (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
+ private:
+  //! The type of the function, if DecomposableFunctionType is a reference.
+  typedef typename std::remove_reference<DecomposableFunctionType>::type
+      FunctionType;
+
+  //! The type of the gradient of a single function.
+  typedef typename std::conditional<HasColumnGradient<FunctionType>::value,
+      ColumnGradient, typename std::conditional<
+      HasSparseGradient<FunctionType>::value, arma::sp_mat,
+      arma::mat>::type>::type GradientType;
+
+  //! Return the sum of the objectives of all the functions.
+  double Evaluate(const arma::mat& iterate);
+
+  //! Take an SGD step for the given function, with a dense gradient.
+  void Step(arma::mat& iterate, const size_t i, arma::mat& gradient);
+
+  //! Take an SGD step for the given function, writing only the coordinates
+  //! with a nonzero gradient.
+  void Step(arma::mat& iterate, const size_t i, arma::sp_mat& gradient);
+
+  //! Take an SGD step for the given function, writing only the columns with a
+  //! nonzero gradient.
+  void Step(arma::mat& iterate, const size_t i, ColumnGradient& gradient);
+
+  //! The instantiated function.
+  DecomposableFunctionType& function;
+
+  //! The step size for each example.
+  double stepSize;
+
+  //! The maximum number of allowed passes.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The callback which is given the progress of the optimizer (may be
+  //! empty).
+  OptimizerCallback callback;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+// Include implementation.
+#include "parallel_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file parallel_sgd_impl.hpp
+ *
+ * Implementation of parallel, lock-free (Hogwild!) stochastic gradient
+ * descent.
+ */
+#ifndef MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_IMPL_HPP
+#define MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_sgd.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<typename DecomposableFunctionType>
+ParallelSGD<DecomposableFunctionType>::ParallelSGD(
+    DecomposableFunctionType& function,
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle) :
+    function(function),
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType>
+double ParallelSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
+{
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
+  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
+      (numFunctions - 1), numFunctions);
+
+  // Calculate the first objective function.
+  double overallObjective = Evaluate(iterate);
+  double lastObjective = DBL_MAX;
+
+  // Now iterate!
+  for (size_t i = 0; i != maxIterations; ++i)
+  {
+    // Output current objective function.
+    Log::Info << "Parallel SGD: pass " << i << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (monitor.Stop(i, overallObjective,
+        std::numeric_limits<double>::quiet_NaN(), stepSize))
+    {
+      Log::Info << "Parallel SGD: stopped by the callback; terminating "
+          << "optimization." << std::endl;
+      return overallObjective;
+    }
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Log::Warn << "Parallel SGD: converged to " << overallObjective
+          << "; terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Log::Info << "Parallel SGD: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    lastObjective = overallObjective;
+    overallObjective = 0;
+
+    if (shuffle) // Determine order of visitation.
+      visitationOrder = arma::shuffle(visitationOrder);
+
+    // Each thread takes a contiguous part of the visitation order, and updates
+    // the iterate without locking.
+    #pragma omp parallel reduction(+:overallObjective)
+    {
+      GradientType gradient;
+
+      #pragma omp for schedule(static)
+      for (omp_size_t j = 0; j < (omp_size_t) numFunctions; ++j)
+      {
+        const size_t f = visitationOrder[j];
+        Step(iterate, f, gradient);
+
+        // Now add that to the overall objective function.
+        overallObjective += function.Evaluate(iterate, f);
+      }
+    }
+  }
+
+  Log::Info << "Parallel SGD: maximum passes (" << maxIterations << ") "
+      << "reached; terminating optimization." << std::endl;
+
+  // Calculate final objective.
+  return Evaluate(iterate);
+}
+
+template<typename DecomposableFunctionType>
+double ParallelSGD<DecomposableFunctionType>::Evaluate(
+    const arma::mat& iterate)
+{
+  const size_t numFunctions = function.NumFunctions();
+
+  double objective = 0;
+  #pragma omp parallel for schedule(static) reduction(+:objective)
+  for (omp_size_t i = 0; i < (omp_size_t) numFunctions; ++i)
+    objective += function.Evaluate(iterate, i);
+
+  return objective;
+}
+
+template<typename DecomposableFunctionType>
+void ParallelSGD<DecomposableFunctionType>::Step(arma::mat& iterate,
+                                                 const size_t i,
+                                                 arma::mat& gradient)
+{
+  function.Gradient(iterate, i, gradient);
+  iterate -= stepSize * gradient;
+}
+
+template<typename DecomposableFunctionType>
+void ParallelSGD<DecomposableFunctionType>::Step(arma::mat& iterate,
+                                                 const size_t i,
+                                                 arma::sp_mat& gradient)
+{
+  function.Gradient(iterate, i, gradient);
+  SyncSparse(gradient);
+
+  // Only write the coordinates with a nonzero gradient.
+  for (size_t c = 0; c < gradient.n_cols; ++c)
+  {
+    for (size_t k = gradient.col_ptrs[c]; k < gradient.col_ptrs[c + 1]; ++k)
+      iterate(gradient.row_indices[k], c) -= stepSize * gradient.values[k];
+  }
+}
+
+template<typename DecomposableFunctionType>
+void ParallelSGD<DecomposableFunctionType>::Step(arma::mat& iterate,
+                                                 const size_t i,
+                                                 ColumnGradient& gradient)
+{
+  function.Gradient(iterate, i, gradient);
+
+  // Only write the columns with a nonzero gradient.
+  for (size_t c = 0; c < gradient.Columns().n_elem; ++c)
+    iterate.col(gradient.Columns()[c]) -= stepSize * gradient.Values().col(c);
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
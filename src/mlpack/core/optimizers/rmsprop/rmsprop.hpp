@@ -10,6 +10,7 @@
 #define MLPACK_CORE_OPTIMIZERS_RMSPROP_RMSPROP_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -131,6 +132,11 @@ class RMSprop
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
   //! The instantiated function.
   DecomposableFunctionType& function;
@@ -153,6 +159,10 @@ class RMSprop
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The callback which is given the progress of the optimizer (may be
+  //! empty).
+  OptimizerCallback callback;
 };
 
 } // namespace optimization
@@ -38,6 +38,9 @@ double RMSprop<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   // This is used only if shuffle is true.
   arma::Col<size_t> visitationOrder;
   if (shuffle)
@@ -69,6 +72,15 @@ double RMSprop<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       Log::Info << "RMSprop: iteration " << i << ", objective "
           << overallObjective << "." << std::endl;
 
+      if (monitor.Active() && monitor.Stop(i, overallObjective, (i == 1) ?
+          std::numeric_limits<double>::quiet_NaN() :
+          arma::norm(gradient, "fro"), stepSize))
+      {
+        Log::Info << "RMSprop: stopped by the callback; terminating "
+            << "optimization." << std::endl;
+        return overallObjective;
+      }
+
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
         Log::Warn << "RMSprop: converged to " << overallObjective
@@ -99,10 +111,19 @@ double RMSprop<DecomposableFunctionType>::Optimize(arma::mat& iterate)
     else
       function.Gradient(iterate, currentFunction, gradient);
 
-    // And update the iterate.
-    meanSquaredGradient *= alpha;
-    meanSquaredGradient += (1 - alpha) * (gradient % gradient);
-    iterate -= stepSize * gradient / (arma::sqrt(meanSquaredGradient) + eps);
+    // And update the iterate.  The mean squared gradient and the iterate are
+    // updated in a single pass, without temporaries; only use threads when the
+    // iterate is large.
+    const double* g = gradient.memptr();
+    double* v = meanSquaredGradient.memptr();
+    double* x = iterate.memptr();
+    const omp_size_t n = (omp_size_t) iterate.n_elem;
+    #pragma omp parallel for schedule(static) if (n >= 100000)
+    for (omp_size_t j = 0; j < n; ++j)
+    {
+      v[j] = alpha * v[j] + (1 - alpha) * (g[j] * g[j]);
+      x[j] -= stepSize * g[j] / (std::sqrt(v[j]) + eps);
+    }
 
     // Now add that to the overall objective function.
     if (shuffle)
@@ -8,6 +8,7 @@
 #define MLPACK_CORE_OPTIMIZERS_SA_SA_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
 
 #include "exponential_schedule.hpp"
 
@@ -36,6 +37,17 @@ namespace optimization {
  * The system is considered "frozen" when its score fails to change more then
  * tolerance for maxToleranceSweep consecutive sweeps.
  *
+ * With more than one chain, several annealing chains run in parallel (with
+ * OpenMP), in the manner of parallel tempering.  Chain c starts at temperature
+ * initT * temperatureRatio^c and has its own copy of the cooling schedule, its
+ * own move sizes and its own random stream.  Every exchangeInterval iterations
+ * the chains stop, and neighbouring chains swap their states according to the
+ * Metropolis criterion, so that good states found by the hot chains move down
+ * to the cold chains.  The best state seen at these exchanges is returned.  The
+ * optimization stops when every chain is frozen or has done maxIterations
+ * iterations.  The result depends only on the random seed, not on the number
+ * of threads.
+ *
  * For SA to work, the FunctionType parameter must implement the following
  * two methods:
  *
@@ -48,7 +60,9 @@ namespace optimization {
  *                          const double currentValue);
  *
  * which returns the next temperature given current temperature and the value
- * of the function being optimized.
+ * of the function being optimized.  When several chains are used, Evaluate()
+ * is called from several threads at once, so it must be thread-safe, and the
+ * cooling schedule must be copyable.
  *
  * @tparam FunctionType objective function type to be minimized.
  * @tparam CoolingScheduleType type for cooling schedule
@@ -75,6 +89,11 @@ class SA
    * @param maxMoveCoef Maximum move size.
    * @param initMoveCoef Initial move size.
    * @param gain Proportional control in feedback move control.
+   * @param chains Number of annealing chains to run in parallel.
+   * @param exchangeInterval Iterations of each chain between exchanges of
+   *      states (only used with more than one chain).
+   * @param temperatureRatio Ratio of the initial temperatures of neighbouring
+   *      chains (only used with more than one chain).
    */
   SA(FunctionType& function,
      CoolingScheduleType& coolingSchedule,
@@ -86,7 +105,10 @@ class SA
      const size_t maxToleranceSweep = 3,
      const double maxMoveCoef = 20,
      const double initMoveCoef = 0.3,
-     const double gain = 0.3);
+     const double gain = 0.3,
+     const size_t chains = 1,
+     const size_t exchangeInterval = 1000,
+     const double temperatureRatio = 0.5);
 
   /**
    * Optimize the given function using simulated annealing. The given starting
@@ -148,6 +170,26 @@ class SA
   //! Modify move size of each parameter.
   arma::mat& MoveSize() { return moveSize; }
 
+  //! Get the number of annealing chains.
+  size_t Chains() const { return chains; }
+  //! Modify the number of annealing chains.
+  size_t& Chains() { return chains; }
+
+  //! Get the number of iterations of each chain between exchanges.
+  size_t ExchangeInterval() const { return exchangeInterval; }
+  //! Modify the number of iterations of each chain between exchanges.
+  size_t& ExchangeInterval() { return exchangeInterval; }
+
+  //! Get the ratio of the initial temperatures of neighbouring chains.
+  double TemperatureRatio() const { return temperatureRatio; }
+  //! Modify the ratio of the initial temperatures of neighbouring chains.
+  double& TemperatureRatio() { return temperatureRatio; }
+
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
   //! The function to be optimized.
   FunctionType& function;
@@ -173,6 +215,16 @@ class SA
   //! Move size of each parameter.
   arma::mat moveSize;
 
+  //! Number of annealing chains.
+  size_t chains;
+  //! Iterations of each chain between exchanges of states.
+  size_t exchangeInterval;
+  //! Ratio of the initial temperatures of neighbouring chains.
+  double temperatureRatio;
+
+  //! The callback which is given the progress of the optimizer (may be empty).
+  OptimizerCallback callback;
+
   /**
    * GenerateMove proposes a move on element iterate(idx), and determines if
    * that move is acceptable or not according to the Metropolis criterion.
@@ -183,14 +235,18 @@ class SA
    *
    * @param iterate Current optimization position.
    * @param accept Matrix representing which parameters have had accepted moves.
+   * @param currentMoveSize Move size of each parameter.
    * @param energy Current energy of the system.
+   * @param currentTemperature Current temperature of the system.
    * @param idx Current parameter to modify.
    * @param sweepCounter Current counter representing how many sweeps have been
    *      completed.
    */
   void GenerateMove(arma::mat& iterate,
                     arma::mat& accept,
+                    arma::mat& currentMoveSize,
                     double& energy,
+                    const double currentTemperature,
                     size_t& idx,
                     size_t& sweepCounter);
 
@@ -211,8 +267,21 @@ class SA
    *
    * @param nMoves Number of moves since last call.
    * @param accept Matrix representing which parameters have had accepted moves.
+   * @param currentMoveSize Move size of each parameter (will be modified).
+   */
+  void MoveControl(const size_t nMoves,
+                   arma::mat& accept,
+                   arma::mat& currentMoveSize);
+
+  /**
+   * Optimize the function with several chains in parallel (see the class
+   * documentation).  The best state found is stored in iterate, and its
+   * objective value is returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the best point.
    */
-  void MoveControl(const size_t nMoves, arma::mat& accept);
+  double OptimizeChains(arma::mat& iterate);
 };
 
 } // namespace optimization
@@ -27,7 +27,10 @@ SA<FunctionType, CoolingScheduleType>::SA(
     const size_t maxToleranceSweep,
     const double maxMoveCoef,
     const double initMoveCoef,
-    const double gain) :
+    const double gain,
+    const size_t chains,
+    const size_t exchangeInterval,
+    const double temperatureRatio) :
     function(function),
     coolingSchedule(coolingSchedule),
     maxIterations(maxIterations),
@@ -36,7 +39,10 @@ SA<FunctionType, CoolingScheduleType>::SA(
     moveCtrlSweep(moveCtrlSweep),
     tolerance(tolerance),
     maxToleranceSweep(maxToleranceSweep),
-    gain(gain)
+    gain(gain),
+    chains(chains),
+    exchangeInterval(exchangeInterval),
+    temperatureRatio(temperatureRatio)
 {
   const size_t rows = function.GetInitialPoint().n_rows;
   const size_t cols = function.GetInitialPoint().n_cols;
@@ -54,13 +60,18 @@ template<
 >
 double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
 {
+  if (chains > 1)
+    return OptimizeChains(iterate);
+
   const size_t rows = function.GetInitialPoint().n_rows;
   const size_t cols = function.GetInitialPoint().n_cols;
 
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   size_t frozenCount = 0;
   double energy = function.Evaluate(iterate);
   double oldEnergy = energy;
-  math::RandomSeed(std::time(NULL));
 
   size_t idx = 0;
   size_t sweepCounter = 0;
@@ -70,15 +81,25 @@ double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
 
   // Initial moves to get rid of dependency of initial states.
   for (size_t i = 0; i < initMoves; ++i)
-    GenerateMove(iterate, accept, energy, idx, sweepCounter);
+    GenerateMove(iterate, accept, moveSize, energy, temperature, idx,
+        sweepCounter);
 
   // Iterating and cooling.
   for (size_t i = 0; i != maxIterations; ++i)
   {
     oldEnergy = energy;
-    GenerateMove(iterate, accept, energy, idx, sweepCounter);
+    GenerateMove(iterate, accept, moveSize, energy, temperature, idx,
+        sweepCounter);
     temperature = coolingSchedule.NextTemperature(temperature, energy);
 
+    if (monitor.Stop(i, energy, std::numeric_limits<double>::quiet_NaN(),
+        temperature))
+    {
+      Log::Debug << "SA: stopped by the callback after " << i << " iterations; "
+          << "terminating optimization." << std::endl;
+      return energy;
+    }
+
     // Determine if the optimization has entered (or continues to be in) a
     // frozen state.
     if (std::abs(energy - oldEnergy) < tolerance)
@@ -101,6 +122,184 @@ double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
   return energy;
 }
 
+//! Optimize the function (minimize) with several chains.
+template<
+    typename FunctionType,
+    typename CoolingScheduleType
+>
+double SA<FunctionType, CoolingScheduleType>::OptimizeChains(
+    arma::mat& iterate)
+{
+  // The state of an annealing chain.
+  struct Chain
+  {
+    arma::mat iterate;
+    arma::mat accept;
+    arma::mat moveSize;
+    double energy;
+    double temperature;
+    size_t idx;
+    size_t sweepCounter;
+    size_t frozenCount;
+    std::mt19937 generator;
+  };
+
+  if (exchangeInterval == 0)
+  {
+    Log::Fatal << "SA::Optimize(): the exchange interval must be positive."
+        << std::endl;
+  }
+
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
+  // The streams of the chains are derived from the current random generator,
+  // so the result only depends on the seed set by the caller.
+  const math::RandomStreams streams;
+
+  std::vector<Chain> chain(chains);
+  std::vector<CoolingScheduleType> schedules(chains, coolingSchedule);
+  const double initialEnergy = function.Evaluate(iterate);
+  for (size_t c = 0; c < chains; ++c)
+  {
+    chain[c].iterate = iterate;
+    chain[c].accept.zeros(iterate.n_rows, iterate.n_cols);
+    chain[c].moveSize = moveSize;
+    chain[c].energy = initialEnergy;
+    chain[c].temperature = temperature * std::pow(temperatureRatio, c);
+    chain[c].idx = 0;
+    chain[c].sweepCounter = 0;
+    chain[c].frozenCount = 0;
+    chain[c].generator = streams.Stream(c);
+  }
+
+  double bestEnergy = initialEnergy;
+  const size_t frozenLimit = maxToleranceSweep * moveCtrlSweep *
+      iterate.n_elem;
+  std::vector<std::exception_ptr> errors(chains);
+  size_t i = 0;
+  while (true)
+  {
+    const size_t steps = (maxIterations == 0) ? exchangeInterval :
+        std::min(exchangeInterval, maxIterations - i);
+
+    // Each chain draws from its own generator, which replaces the generator
+    // of the thread (or, outside of parallel regions, the global generator,
+    // which is restored afterwards).
+    const std::mt19937 outerGenerator = math::randGen;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t c = 0; c < (omp_size_t) chains; ++c)
+    {
+      Chain& current = chain[c];
+      std::mt19937& generator = math::RandomGenerator();
+      generator = current.generator;
+
+      // Exceptions can't leave the parallel loop; the first one is rethrown
+      // afterwards.
+      try
+      {
+        // Initial moves to get rid of dependency of initial states.
+        if (i == 0)
+        {
+          for (size_t j = 0; j < initMoves; ++j)
+            GenerateMove(current.iterate, current.accept, current.moveSize,
+                current.energy, current.temperature, current.idx,
+                current.sweepCounter);
+        }
+
+        for (size_t j = 0; j < steps && current.frozenCount < frozenLimit; ++j)
+        {
+          const double oldEnergy = current.energy;
+          GenerateMove(current.iterate, current.accept, current.moveSize,
+              current.energy, current.temperature, current.idx,
+              current.sweepCounter);
+          current.temperature = schedules[c].NextTemperature(
+              current.temperature, current.energy);
+
+          if (std::abs(current.energy - oldEnergy) < tolerance)
+            ++current.frozenCount;
+          else
+            current.frozenCount = 0;
+        }
+      }
+      catch (...)
+      {
+        errors[c] = std::current_exception();
+      }
+
+      current.generator = generator;
+    }
+
+    math::randGen = outerGenerator;
+    for (size_t c = 0; c < chains; ++c)
+    {
+      if (errors[c])
+        std::rethrow_exception(errors[c]);
+    }
+    i += steps;
+
+    // Keep the best state of all chains.
+    bool frozen = true;
+    for (size_t c = 0; c < chains; ++c)
+    {
+      if (chain[c].energy < bestEnergy)
+      {
+        bestEnergy = chain[c].energy;
+        iterate = chain[c].iterate;
+      }
+
+      frozen &= (chain[c].frozenCount >= frozenLimit);
+    }
+
+    // The first chain starts at the initial temperature, like a single chain.
+    temperature = chain[0].temperature;
+    moveSize = chain[0].moveSize;
+
+    if (monitor.Stop(i, bestEnergy, std::numeric_limits<double>::quiet_NaN(),
+        temperature))
+    {
+      Log::Debug << "SA: stopped by the callback after " << i << " iterations; "
+          << "terminating optimization." << std::endl;
+      return bestEnergy;
+    }
+
+    if (frozen)
+    {
+      Log::Debug << "SA: all " << chains << " chains minimized within "
+          << "tolerance " << tolerance << " for " << maxToleranceSweep
+          << " sweeps after " << i << " iterations; terminating optimization."
+          << std::endl;
+      return bestEnergy;
+    }
+
+    if (i == maxIterations)
+    {
+      Log::Debug << "SA: maximum iterations (" << maxIterations << ") reached; "
+          << "terminating optimization." << std::endl;
+      return bestEnergy;
+    }
+
+    // Swap the states of neighbouring chains, with probability
+    // min{1, exp((E_c - E_{c + 1}) * (1 / T_c - 1 / T_{c + 1}))}, which keeps
+    // each chain at equilibrium at its own temperature.
+    for (size_t c = 0; c + 1 < chains; ++c)
+    {
+      Chain& first = chain[c];
+      Chain& second = chain[c + 1];
+      const double criterion = std::exp((first.energy - second.energy) *
+          (1.0 / first.temperature - 1.0 / second.temperature));
+      if (criterion > math::Random())
+      {
+        first.iterate.swap(second.iterate);
+        std::swap(first.energy, second.energy);
+        first.frozenCount = 0;
+        second.frozenCount = 0;
+      }
+    }
+  }
+}
+
 /**
  * GenerateMove proposes a move on element iterate(idx), and determines
  * it that move is acceptable or not according to the Metropolis criterion.
@@ -116,7 +315,9 @@ template<
 void SA<FunctionType, CoolingScheduleType>::GenerateMove(
     arma::mat& iterate,
     arma::mat& accept,
+    arma::mat& currentMoveSize,
     double& energy,
+    const double currentTemperature,
     size_t& idx,
     size_t& sweepCounter)
 {
@@ -127,10 +328,12 @@ void SA<FunctionType, CoolingScheduleType>::GenerateMove(
   // because the acceptance ratio should be as close to 0.44 as possible, and
   // MoveControl() is derived for the Laplace distribution.
 
-  // Sample from a Laplace distribution with scale parameter moveSize(idx).
+  // Sample from a Laplace distribution with scale parameter
+  // currentMoveSize(idx).
   const double unif = 2.0 * math::Random() - 1.0;
-  const double move = (unif < 0) ? (moveSize(idx) * std::log(1 + unif)) :
-      (-moveSize(idx) * std::log(1 - unif));
+  const double move = (unif < 0) ?
+      (currentMoveSize(idx) * std::log(1 + unif)) :
+      (-currentMoveSize(idx) * std::log(1 - unif));
 
   iterate(idx) += move;
   energy = function.Evaluate(iterate);
@@ -138,7 +341,7 @@ void SA<FunctionType, CoolingScheduleType>::GenerateMove(
   // min{1, exp(-(E_new - E_old) / T)}.
   const double xi = math::Random();
   const double delta = energy - prevEnergy;
-  const double criterion = std::exp(-delta / temperature);
+  const double criterion = std::exp(-delta / currentTemperature);
   if (delta <= 0. || criterion > xi)
   {
     accept(idx) += 1.;
@@ -158,7 +361,7 @@ void SA<FunctionType, CoolingScheduleType>::GenerateMove(
 
   if (sweepCounter == moveCtrlSweep) // Do MoveControl().
   {
-    MoveControl(moveCtrlSweep, accept);
+    MoveControl(moveCtrlSweep, accept, currentMoveSize);
     sweepCounter = 0;
   }
 }
@@ -181,20 +384,25 @@ template<
     typename FunctionType,
     typename CoolingScheduleType
 >
-void SA<FunctionType, CoolingScheduleType>::MoveControl(const size_t nMoves,
-                                                        arma::mat& accept)
+void SA<FunctionType, CoolingScheduleType>::MoveControl(
+    const size_t nMoves,
+    arma::mat& accept,
+    arma::mat& currentMoveSize)
 {
   arma::mat target;
   target.copy_size(accept);
   target.fill(0.44);
-  moveSize = arma::log(moveSize);
-  moveSize += gain * (accept / (double) nMoves - target);
-  moveSize = arma::exp(moveSize);
+  currentMoveSize = arma::log(currentMoveSize);
+  currentMoveSize += gain * (accept / (double) nMoves - target);
+  currentMoveSize = arma::exp(currentMoveSize);
 
   // To avoid the use of element-wise arma::min(), which is only available in
   // Armadillo after v3.930, we use a for loop here instead.
   for (size_t i = 0; i < accept.n_elem; ++i)
-    moveSize(i) = (moveSize(i) > maxMove(i)) ? maxMove(i) : moveSize(i);
+  {
+    currentMoveSize(i) = (currentMoveSize(i) > maxMove(i)) ? maxMove(i) :
+        currentMoveSize(i);
+  }
 
   accept.zeros();
 }
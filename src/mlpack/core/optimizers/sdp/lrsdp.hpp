@@ -51,7 +51,11 @@ class LRSDP
 
   /**
    * Optimize the LRSDP and return the final objective value.  The given
-   * coordinates will be modified to contain the final solution.
+   * coordinates will be modified to contain the final solution.  If the sparse
+   * constraints are given as matrices in SDP().SparseA(), their elements are
+   * first flattened into one list (see
+   * LRSDPFunction::FlattenSparseConstraints()); otherwise, the list given to
+   * Function() is used.
    *
    * @param coordinates Starting coordinates for the optimization.
    */
@@ -72,6 +76,11 @@ class LRSDP
   //! Modify the augmented Lagrangian object.
   AugLagrangian<LRSDPFunction<SDPType>>& AugLag() { return augLag; }
 
+  //! Get the callback of the augmented Lagrangian optimizer.
+  const OptimizerCallback& Callback() const { return augLag.Callback(); }
+  //! Modify the callback of the augmented Lagrangian optimizer.
+  OptimizerCallback& Callback() { return augLag.Callback(); }
+
  private:
   //! Function to optimize, which the AugLagrangian object holds.
   LRSDPFunction<SDPType> function;
@@ -84,11 +84,80 @@ class LRSDPFunction
   //! Modify the SDP object representing the problem.
   SDPType& SDP() { return sdp; }
 
+  /**
+   * Store the nonzero elements of the sparse constraint matrices of the SDP in
+   * one flat list (see SparseOffsets(), SparseLocations() and SparseValues()),
+   * which is how the augmented Lagrangian objective and gradient evaluate the
+   * sparse constraints.  LRSDP::Optimize() calls this when the sparse
+   * constraint matrices are given in SDP().SparseA().
+   */
+  void FlattenSparseConstraints();
+
+  /**
+   * Return whether the nonzero elements of the sparse constraints are in the
+   * flat list (that is, whether the list has one range of elements per sparse
+   * constraint).  If they are not, the sparse constraint matrices are used.
+   */
+  bool SparseConstraintsFlattened() const
+  {
+    return sparseOffsets.n_elem == sdp.NumSparseConstraints() + 1;
+  }
+
+  //! Get the offsets of the elements of each sparse constraint in the flat list
+  //! (the elements of constraint i are sparseOffsets[i] to sparseOffsets[i +
+  //! 1] - 1).
+  const arma::Col<size_t>& SparseOffsets() const { return sparseOffsets; }
+  //! Modify the offsets of the elements of each sparse constraint.  This,
+  //! SparseLocations() and SparseValues() can be set directly instead of
+  //! SDP().SparseA(), when there are too many sparse constraints to store a
+  //! matrix for each.
+  arma::Col<size_t>& SparseOffsets() { return sparseOffsets; }
+
+  //! Get the locations (row and column) of the elements of the flat list.
+  const arma::umat& SparseLocations() const { return sparseLocations; }
+  //! Modify the locations of the elements of the flat list.
+  arma::umat& SparseLocations() { return sparseLocations; }
+
+  //! Get the values of the elements of the flat list.
+  const arma::vec& SparseValues() const { return sparseValues; }
+  //! Modify the values of the elements of the flat list.
+  arma::vec& SparseValues() { return sparseValues; }
+
+  /**
+   * Return whether the dense constraints are given in factored form (that is,
+   * whether DenseFactors() has one column per dense constraint).  The matrix
+   * of dense constraint i is then v v^T, with v = DenseFactors().col(i), and
+   * SDP().DenseA() is not used: Tr(A_i * (R R^T)) = ||v^T R||^2 and A_i R =
+   * v (v^T R) need no n x n matrix.
+   */
+  bool DenseConstraintsFactored() const
+  {
+    return sdp.NumDenseConstraints() > 0 &&
+        denseFactors.n_cols == sdp.NumDenseConstraints();
+  }
+
+  //! Get the factors of the dense constraints.
+  const arma::mat& DenseFactors() const { return denseFactors; }
+  //! Modify the factors of the dense constraints.  These can be set instead of
+  //! SDP().DenseA() for rank-one dense constraints, such as a constraint on
+  //! the sum of all the elements of R R^T.
+  arma::mat& DenseFactors() { return denseFactors; }
+
  private:
 
   //! SDP object representing the problem
   SDPType sdp;
 
+  //! The offsets of the elements of each sparse constraint in the flat list.
+  arma::Col<size_t> sparseOffsets;
+  //! The locations (row and column) of the elements of the flat list.
+  arma::umat sparseLocations;
+  //! The values of the elements of the flat list.
+  arma::vec sparseValues;
+
+  //! The factor v of each rank-one dense constraint A = v v^T.
+  arma::mat denseFactors;
+
   //! Initial point.
   arma::mat initialPoint;
 };
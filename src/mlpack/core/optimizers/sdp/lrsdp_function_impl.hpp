@@ -54,15 +54,77 @@ void LRSDPFunction<SDPType>::Gradient(const arma::mat& /* coordinates */,
       << std::endl;
 }
 
+//! Utility function for calculating Tr(A * (R R^T)) for a sparse constraint
+//! matrix A, without forming R R^T: each nonzero element A_jk only needs the
+//! dot product of rows j and k of R.
+static inline double
+ConstraintTrace(const arma::sp_mat& a, const arma::mat& coordinates)
+{
+  double trace = 0.0;
+  for (arma::sp_mat::const_iterator it = a.begin(); it != a.end(); ++it)
+    trace += (*it) * arma::dot(coordinates.row(it.row()),
+                               coordinates.row(it.col()));
+  return trace;
+}
+
+//! Utility function for calculating Tr(A * (R R^T)) for a dense constraint
+//! matrix A, as the sum of the elements of (A R) % R.
+static inline double
+ConstraintTrace(const arma::mat& a, const arma::mat& coordinates)
+{
+  return accu((a * coordinates) % coordinates);
+}
+
+//! Utility function for calculating Tr(A_i * (R R^T)) for the dense constraint
+//! i, which is ||v^T R||^2 if the constraint is given as A_i = v v^T.
+template <typename SDPType>
+static inline double
+DenseConstraintTrace(const LRSDPFunction<SDPType>& function,
+                     const size_t i,
+                     const arma::mat& coordinates)
+{
+  if (!function.DenseConstraintsFactored())
+    return ConstraintTrace(function.SDP().DenseA()[i], coordinates);
+
+  const arma::rowvec vr = trans(function.DenseFactors().col(i)) * coordinates;
+  return arma::dot(vr, vr);
+}
+
+//! Utility function for calculating A_i R for the dense constraint i, which is
+//! v (v^T R) if the constraint is given as A_i = v v^T.
+template <typename SDPType>
+static inline arma::mat
+DenseConstraintProduct(const LRSDPFunction<SDPType>& function,
+                       const size_t i,
+                       const arma::mat& coordinates)
+{
+  if (!function.DenseConstraintsFactored())
+    return function.SDP().DenseA()[i] * coordinates;
+
+  const arma::vec v = function.DenseFactors().col(i);
+  return v * (trans(v) * coordinates);
+}
+
 template <typename SDPType>
 double LRSDPFunction<SDPType>::EvaluateConstraint(const size_t index,
                                                   const arma::mat& coordinates) const
 {
-  const arma::mat rrt = coordinates * trans(coordinates);
   if (index < SDP().NumSparseConstraints())
-    return accu(SDP().SparseA()[index] % rrt) - SDP().SparseB()[index];
+  {
+    if (!SparseConstraintsFlattened())
+      return ConstraintTrace(SDP().SparseA()[index], coordinates) -
+          SDP().SparseB()[index];
+
+    double trace = 0.0;
+    for (size_t k = sparseOffsets[index]; k < sparseOffsets[index + 1]; ++k)
+      trace += sparseValues[k] * arma::dot(
+          coordinates.row(sparseLocations(0, k)),
+          coordinates.row(sparseLocations(1, k)));
+    return trace - SDP().SparseB()[index];
+  }
   const size_t index1 = index - SDP().NumSparseConstraints();
-  return accu(SDP().DenseA()[index1] % rrt) - SDP().DenseB()[index1];
+  return DenseConstraintTrace(*this, index1, coordinates) -
+      SDP().DenseB()[index1];
 }
 
 template <typename SDPType>
@@ -74,47 +136,105 @@ void LRSDPFunction<SDPType>::GradientConstraint(const size_t /* index */,
       << "optimizers!" << std::endl;
 }
 
-//! Utility function for calculating part of the objective when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
-static inline void
-UpdateObjective(double& objective,
-                const arma::mat& rrt,
-                const std::vector<MatrixType>& ais,
-                const arma::vec& bis,
-                const arma::vec& lambda,
-                const size_t lambdaOffset,
-                const double sigma)
-{
-  for (size_t i = 0; i < ais.size(); ++i)
+template <typename SDPType>
+void LRSDPFunction<SDPType>::FlattenSparseConstraints()
+{
+  // The compressed arrays of the constraints are read directly, so their
+  // pending element writes (and their number of nonzeros) must be synced
+  // first.
+  const size_t numConstraints = sdp.NumSparseConstraints();
+  sparseOffsets.set_size(numConstraints + 1);
+  sparseOffsets[0] = 0;
+  for (size_t i = 0; i < numConstraints; ++i)
   {
-    // Take the trace subtracted by the b_i.
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    objective -= (lambda[lambdaOffset + i] * constraint);
-    objective += (sigma / 2.) * constraint * constraint;
+    SyncSparse(sdp.SparseA()[i]);
+    sparseOffsets[i + 1] = sparseOffsets[i] + sdp.SparseA()[i].n_nonzero;
   }
+
+  sparseLocations.set_size(2, sparseOffsets[numConstraints]);
+  sparseValues.set_size(sparseOffsets[numConstraints]);
+  ThreadPool::ParallelFor(0, numConstraints, [&](const size_t i)
+  {
+    // The column of each element is found with a binary search in the column
+    // pointers, so that the empty columns are not visited.
+    const arma::sp_mat& a = sdp.SparseA()[i];
+    for (size_t k = 0; k < a.n_nonzero; ++k)
+    {
+      const size_t offset = sparseOffsets[i] + k;
+      sparseLocations(0, offset) = a.row_indices[k];
+      sparseLocations(1, offset) = std::upper_bound(a.col_ptrs,
+          a.col_ptrs + a.n_cols + 1, (arma::uword) k) - a.col_ptrs - 1;
+      sparseValues[offset] = a.values[k];
+    }
+  });
 }
 
-//! Utility function for calculating part of the gradient when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
+//! Utility function for calculating Tr(A_i * (R R^T)) for the sparse
+//! constraint i, given R^T (so that the rows of R are contiguous).  Each
+//! element A_jk of the constraint only needs the dot product of rows j and k of
+//! R; the elements are taken from the flat list if there is one.
+template <typename SDPType>
+static inline double
+SparseConstraintTrace(const LRSDPFunction<SDPType>& function,
+                      const size_t i,
+                      const arma::mat& coordinatesT)
+{
+  double trace = 0.0;
+  if (function.SparseConstraintsFlattened())
+  {
+    const arma::Col<size_t>& offsets = function.SparseOffsets();
+    const arma::umat& locations = function.SparseLocations();
+    const arma::vec& values = function.SparseValues();
+    for (size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+      trace += values[k] * arma::dot(coordinatesT.col(locations(0, k)),
+                                     coordinatesT.col(locations(1, k)));
+  }
+  else
+  {
+    const arma::sp_mat& a = function.SDP().SparseA()[i];
+    for (arma::sp_mat::const_iterator it = a.begin(); it != a.end(); ++it)
+      trace += (*it) * arma::dot(coordinatesT.col(it.row()),
+                                 coordinatesT.col(it.col()));
+  }
+  return trace;
+}
+
+//! Utility function for adding y * (A_i R)^T to the given matrix, for the
+//! sparse constraint i, given R^T.
+template <typename SDPType>
 static inline void
-UpdateGradient(arma::mat& s,
-               const arma::mat& rrt,
-               const std::vector<MatrixType>& ais,
-               const arma::vec& bis,
-               const arma::vec& lambda,
-               const size_t lambdaOffset,
-               const double sigma)
-{
-  for (size_t i = 0; i < ais.size(); ++i)
+AddSparseConstraintProduct(const LRSDPFunction<SDPType>& function,
+                           const size_t i,
+                           const double y,
+                           const arma::mat& coordinatesT,
+                           arma::mat& product)
+{
+  if (function.SparseConstraintsFlattened())
+  {
+    const arma::Col<size_t>& offsets = function.SparseOffsets();
+    const arma::umat& locations = function.SparseLocations();
+    const arma::vec& values = function.SparseValues();
+    for (size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+      product.col(locations(0, k)) += (y * values[k]) *
+          coordinatesT.col(locations(1, k));
+  }
+  else
   {
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    const double y = lambda[lambdaOffset + i] - sigma * constraint;
-    s -= y * ais[i];
+    const arma::sp_mat& a = function.SDP().SparseA()[i];
+    for (arma::sp_mat::const_iterator it = a.begin(); it != a.end(); ++it)
+      product.col(it.row()) += (y * (*it)) * coordinatesT.col(it.col());
   }
 }
 
+//! Return the number of ranges that the sparse constraints are split into, to
+//! be evaluated in parallel: one per thread, but with at least 1024 constraints
+//! in each range.
+static inline size_t SparseConstraintRanges(const size_t numConstraints)
+{
+  const size_t blocks = (numConstraints + 1023) / 1024;
+  return std::max((size_t) 1, std::min(ThreadPool::Threads(), blocks));
+}
+
 template <typename SDPType>
 static inline double
 EvaluateImpl(const LRSDPFunction<SDPType>& function,
@@ -126,23 +246,40 @@ EvaluateImpl(const LRSDPFunction<SDPType>& function,
   // L(R, y, s) = Tr(C * (R R^T)) -
   //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
   //     (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
-
-  // Let's start with the objective: Tr(C * (R R^T)).
-  // Simple, possibly slow solution-- see below for optimization opportunity
-  //
-  // TODO: Note that Tr(C^T * (R R^T)) = Tr( (CR)^T * R ), so
-  // multiplying C*R first, and then taking the trace dot should be more memory
-  // efficient
   //
-  // Similarly for the constraints, taking A*R first should be more efficient
-  const arma::mat rrt = coordinates * trans(coordinates);
-  double objective = accu(function.SDP().C() % rrt);
+  // R R^T is never formed: Tr(C * (R R^T)) is the sum of the elements of
+  // (C R) % R, and the trace of each sparse constraint only needs the dot
+  // products of the rows of R at its elements.
+  double objective = accu((function.SDP().C() * coordinates) % coordinates);
 
-  // Now each constraint.
-  UpdateObjective(objective, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateObjective(objective, rrt, function.SDP().DenseA(), function.SDP().DenseB(), lambda,
-      function.SDP().NumSparseConstraints(), sigma);
+  // The sparse constraints are split into ranges, which are evaluated in
+  // parallel.
+  const arma::mat coordinatesT = trans(coordinates);
+  const size_t numSparse = function.SDP().NumSparseConstraints();
+  const size_t ranges = SparseConstraintRanges(numSparse);
+  arma::vec objectives = arma::zeros<arma::vec>(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * numSparse / ranges;
+    const size_t end = (r + 1) * numSparse / ranges;
+    for (size_t i = begin; i < end; ++i)
+    {
+      const double constraint = SparseConstraintTrace(function, i,
+          coordinatesT) - function.SDP().SparseB()[i];
+      objectives[r] += (sigma / 2.) * constraint * constraint -
+          lambda[i] * constraint;
+    }
+  });
+  objective += accu(objectives);
+
+  // Now each dense constraint.
+  for (size_t i = 0; i < function.SDP().NumDenseConstraints(); ++i)
+  {
+    const double constraint = DenseConstraintTrace(function, i, coordinates) -
+        function.SDP().DenseB()[i];
+    objective -= (lambda[numSparse + i] * constraint);
+    objective += (sigma / 2.) * constraint * constraint;
+  }
 
   return objective;
 }
@@ -160,17 +297,42 @@ GradientImpl(const LRSDPFunction<SDPType>& function,
   //   with
   // S' = C - sum_{i = 1}^{m} y'_i A_i
   // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
-  const arma::mat rrt = coordinates * trans(coordinates);
-  arma::mat s(function.SDP().C());
+  //
+  // S' is never formed either: S' R is C R minus the products y'_i A_i R.
+  // Each range of sparse constraints adds its products (transposed, so that
+  // the rows of R are contiguous) into its own matrix.
+  const arma::mat coordinatesT = trans(coordinates);
+  const size_t numSparse = function.SDP().NumSparseConstraints();
+  const size_t ranges = SparseConstraintRanges(numSparse);
+  std::vector<arma::mat> products(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * numSparse / ranges;
+    const size_t end = (r + 1) * numSparse / ranges;
+    products[r].zeros(coordinatesT.n_rows, coordinatesT.n_cols);
+    for (size_t i = begin; i < end; ++i)
+    {
+      const double constraint = SparseConstraintTrace(function, i,
+          coordinatesT) - function.SDP().SparseB()[i];
+      const double y = lambda[i] - sigma * constraint;
+      AddSparseConstraintProduct(function, i, y, coordinatesT, products[r]);
+    }
+  });
 
-  UpdateGradient(
-      s, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateGradient(
-      s, rrt, function.SDP().DenseA(), function.SDP().DenseB(),
-      lambda, function.SDP().NumSparseConstraints(), sigma);
+  for (size_t r = 1; r < ranges; ++r)
+    products[0] += products[r];
+  arma::mat s = function.SDP().C() * coordinates - trans(products[0]);
+
+  for (size_t i = 0; i < function.SDP().NumDenseConstraints(); ++i)
+  {
+    const arma::mat ar = DenseConstraintProduct(function, i, coordinates);
+    const double constraint = accu(ar % coordinates) -
+        function.SDP().DenseB()[i];
+    const double y = lambda[numSparse + i] - sigma * constraint;
+    s -= y * ar;
+  }
 
-  gradient = 2 * s * coordinates;
+  gradient = 2 * s;
 }
 
 // Template specializations for function and gradient evaluation.
@@ -24,6 +24,11 @@ LRSDP<SDPType>::LRSDP(const size_t numSparseConstraints,
 template <typename SDPType>
 double LRSDP<SDPType>::Optimize(arma::mat& coordinates)
 {
+  // The sparse constraints are evaluated from a flat list of their elements;
+  // if they were given as matrices, the list is built from them.
+  if (function.SDP().SparseA().size() == function.SDP().NumSparseConstraints())
+    function.FlattenSparseConstraints();
+
   augLag.Sigma() = 10;
   augLag.Optimize(coordinates, 1000);
 
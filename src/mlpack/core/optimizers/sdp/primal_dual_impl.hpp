@@ -115,10 +115,14 @@ Alpha(const arma::mat& A, const arma::mat& dA, double tau)
 #else
   const arma::mat L = arma::chol(A, "lower");
 #endif
-  const arma::mat Linv = arma::inv(arma::trimatl(L));
+  // Form L^(-1) dA L^(-T) with two triangular solves instead of an explicit
+  // inverse.
+  const arma::mat LinvdA = arma::solve(arma::trimatl(L), dA);
+  const arma::mat LinvdALinvT = arma::solve(arma::trimatl(L), LinvdA.t());
   // TODO(stephentu): We only want the top eigenvalue, we should
   // be able to do better than full eigen-decomposition.
-  const arma::vec evals = arma::eig_sym(-Linv * dA * Linv.t());
+  const arma::vec evals = arma::eig_sym(-0.5 * (LinvdALinvT +
+      LinvdALinvT.t()));
   const double alphahatinv = evals(evals.n_elem - 1);
   double alphahat = 1. / alphahatinv;
   if (alphahat < 0.)
@@ -128,22 +132,73 @@ Alpha(const arma::mat& A, const arma::mat& dA, double tau)
 }
 
 /**
- * Solve the following Lyapunov equation (for X)
- *
- *   AX + XA = H
- *
- * where A, H are symmetric matrices.
- *
- * TODO(stephentu): Note this method current uses arma's builtin arma::syl
- * method, which is overkill for this situation. See Lemma 7.2 of [AHO98] for
- * how to solve this Lyapunov equation using an eigenvalue decomposition of A.
- *
+ * An eigenvalue decomposition A = Q diag(lambda) Q^T of a symmetric positive
+ * definite matrix A, used to solve Lyapunov equations with A; see Lemma 7.2 of
+ * [AHO98].  The decomposition is computed once for all the equations of an
+ * iteration, instead of once per equation.
  */
-static inline void
-SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
+struct LyapunovSolver
 {
-  arma::syl(X, A, A, -H);
-}
+  //! Decompose the given symmetric positive definite matrix.
+  LyapunovSolver(const arma::mat& A)
+  {
+    arma::vec lambda;
+    if (!arma::eig_sym(lambda, Q, A))
+      Log::Fatal << "PrimalDualSolver: could not decompose Z." << std::endl;
+
+    // The denominators lambda_i + lambda_j of the solution.
+    lambdaSums = arma::repmat(lambda, 1, lambda.n_elem) +
+        arma::repmat(lambda.t(), lambda.n_elem, 1);
+  }
+
+  /**
+   * Solve the following Lyapunov equation (for X)
+   *
+   *   AX + XA = H
+   *
+   * where H is a symmetric matrix.  With A = Q diag(lambda) Q^T, the solution
+   * is X = Q ((Q^T H Q) ./ (lambda_i + lambda_j)) Q^T.
+   */
+  void Solve(arma::mat& X, const arma::mat& H) const
+  {
+    X = Q * ((Q.t() * H * Q) / lambdaSums) * Q.t();
+  }
+
+  //! Eigenvectors of A.
+  arma::mat Q;
+  //! Sums of each pair of eigenvalues of A.
+  arma::mat lambdaSums;
+};
+
+/**
+ * An LU decomposition P^T L U = M of the Schur complement M of the KKT system,
+ * which is computed once per iteration and used for both the predictor and the
+ * corrector steps.
+ */
+struct SchurSolver
+{
+  //! Decompose the given Schur complement.
+  SchurSolver(const arma::mat& M)
+  {
+    if (!arma::lu(L, U, P, M))
+      Log::Fatal << "PrimalDualSolver::SolveKKTSystem(): Could not solve KKT "
+          << "system." << std::endl;
+  }
+
+  //! Solve M x = b with two triangular solves.
+  void Solve(arma::vec& x, const arma::vec& b) const
+  {
+    const arma::vec y = arma::solve(arma::trimatl(L), P * b);
+    x = arma::solve(arma::trimatu(U), y);
+  }
+
+  //! Lower triangular factor.
+  arma::mat L;
+  //! Upper triangular factor.
+  arma::mat U;
+  //! Row permutation.
+  arma::mat P;
+};
 
 /**
  * Solve the following KKT system (2.10) of [AHO98]:
@@ -165,8 +220,8 @@ SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
 static inline void
 SolveKKTSystem(const arma::sp_mat& Asparse,
                const arma::mat& Adense,
-               const arma::mat& Z,
-               const arma::mat& M,
+               const LyapunovSolver& Z,
+               const SchurSolver& M,
                const arma::mat& F,
                const arma::vec& rp,
                const arma::vec& rd,
@@ -185,7 +240,7 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
 
   // Compute the RHS of (2.12)
   math::Smat(F * rd - rc, Frd_rc_Mat);
-  SolveLyapunov(Einv_Frd_rc_Mat, Z, 2. * Frd_rc_Mat);
+  Z.Solve(Einv_Frd_rc_Mat, 2. * Frd_rc_Mat);
   math::Svec(Einv_Frd_rc_Mat, Einv_Frd_rc);
 
   arma::vec rhs = rp;
@@ -195,10 +250,7 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
   if (Adense.n_rows)
     rhs(arma::span(Asparse.n_rows, numConstraints - 1)) += Adense * Einv_Frd_rc;
 
-  // TODO(stephentu): use a more efficient method (e.g. LU decomposition)
-  if (!arma::solve(dy, M, rhs))
-    Log::Fatal << "PrimalDualSolver::SolveKKTSystem(): Could not solve KKT "
-        << "system." << std::endl;
+  M.Solve(dy, rhs);
 
   if (Asparse.n_rows)
     dysparse = dy(arma::span(0, Asparse.n_rows - 1));
@@ -208,7 +260,7 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
   // Compute dx from (2.13)
   math::Smat(F * (rd - Asparse.t() * dysparse - Adense.t() * dydense) - rc,
       Frd_ATdy_rc_Mat);
-  SolveLyapunov(Einv_Frd_ATdy_rc_Mat, Z, 2. * Frd_ATdy_rc_Mat);
+  Z.Solve(Einv_Frd_ATdy_rc_Mat, 2. * Frd_ATdy_rc_Mat);
   math::Svec(Einv_Frd_ATdy_rc_Mat, Einv_Frd_ATdy_rc);
   dsx = -Einv_Frd_ATdy_rc;
 
@@ -307,18 +359,23 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
 
     math::SymKronId(X, F);
 
+    // All the Lyapunov equations of this iteration are solved with the same
+    // decomposition of Z.
+    const LyapunovSolver lyapunov(Z);
+
     // We compute E^(-1) F A^T by solving Lyapunov equations.
-    // See (2.16).
+    // See (2.16).  The products with the sparse constraint matrices only touch
+    // their nonzero elements.
     for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
     {
-      SolveLyapunov(Gk, Z, X * sdp.SparseA()[i] + sdp.SparseA()[i] * X);
+      lyapunov.Solve(Gk, X * sdp.SparseA()[i] + sdp.SparseA()[i] * X);
       math::Svec(Gk, gk);
       Einv_F_AsparseT.col(i) = gk;
     }
 
     for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
     {
-      SolveLyapunov(Gk, Z, X * sdp.DenseA()[i] + sdp.DenseA()[i] * X);
+      lyapunov.Solve(Gk, X * sdp.DenseA()[i] + sdp.DenseA()[i] * X);
       math::Svec(Gk, gk);
       Einv_F_AdenseT.col(i) = gk;
     }
@@ -357,6 +414,10 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
           Adense * Einv_F_AdenseT;
     }
 
+    // Both KKT systems of this iteration share the Schur complement M, so it
+    // is only factored once.
+    const SchurSolver schur(M);
+
     const double sxdotsz = arma::dot(sx, sz);
 
     // TODO(stephentu): computing these alphahats should take advantage of
@@ -366,8 +427,8 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     // This solves step (1) of Section 7, the "predictor" step.
     Rc = -0.5*(X*Z + Z*X);
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, lyapunov, schur, F, rp, rd, rc, dsx,
+        dysparse, dydense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
 
@@ -383,8 +444,8 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     // Step (3), the "corrector" step.
     Rc = mu*arma::eye<arma::mat>(n, n) - 0.5*(X*Z + Z*X + dX*dZ + dZ*dX);
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, lyapunov, schur, F, rp, rd, rc, dsx,
+        dysparse, dydense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
     alpha = Alpha(X, dX, tau);
@@ -8,10 +8,107 @@
 #define MLPACK_CORE_OPTIMIZERS_SGD_SGD_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/callbacks/optimizer_callback.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 namespace mlpack {
 namespace optimization {
 
+HAS_MEM_FUNC(Gradient, HasSparseGradientCheck);
+
+/**
+ * This is a template struct that tells whether a decomposable function type
+ * has a Gradient() function for a single function which returns a sparse
+ * gradient:
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::sp_mat& gradient);
+ */
+template<typename FunctionType>
+struct HasSparseGradient
+{
+  static const bool value =
+      HasSparseGradientCheck<FunctionType, void(FunctionType::*)(
+          const arma::mat&, const size_t, arma::sp_mat&)>::value ||
+      HasSparseGradientCheck<FunctionType, void(FunctionType::*)(
+          const arma::mat&, const size_t, arma::sp_mat&) const>::value;
+};
+
+HAS_MEM_FUNC(GradientSupport, HasGradientSupportCheck);
+
+/**
+ * This is a template struct that tells whether a decomposable function type
+ * with a sparse or column gradient can give the coordinates that a single
+ * function depends on, without computing its gradient:
+ *
+ *   void GradientSupport(const size_t i, arma::uvec& support);
+ *
+ * For a sparse gradient, the support holds the (column-major) indices of the
+ * coordinates where the gradient of function i may be nonzero; for a
+ * ColumnGradient, it holds the indices of all the columns of the gradient.
+ */
+template<typename FunctionType>
+struct HasGradientSupport
+{
+  static const bool value =
+      HasGradientSupportCheck<FunctionType, void(FunctionType::*)(
+          const size_t, arma::uvec&)>::value ||
+      HasGradientSupportCheck<FunctionType, void(FunctionType::*)(
+          const size_t, arma::uvec&) const>::value;
+};
+
+/**
+ * The gradient of a single function which is only nonzero in a few columns of
+ * the coordinates, like the gradient of the loss of one rating in regularized
+ * SVD, which only involves the factors of one user and one item.  Only the
+ * nonzero columns (which must be distinct) are stored, so the gradient is
+ * computed and applied in time that does not depend on the number of columns
+ * of the coordinates, unlike an arma::sp_mat, which holds an offset for every
+ * column.
+ */
+class ColumnGradient
+{
+ public:
+  //! Create an empty gradient (the size of the coordinates is not needed).
+  ColumnGradient(const size_t /* rows */ = 0, const size_t /* cols */ = 0) { }
+
+  //! Get the indices of the nonzero columns.
+  const arma::uvec& Columns() const { return columns; }
+  //! Modify the indices of the nonzero columns.
+  arma::uvec& Columns() { return columns; }
+
+  //! Get the values of the nonzero columns (one column per index).
+  const arma::mat& Values() const { return values; }
+  //! Modify the values of the nonzero columns.
+  arma::mat& Values() { return values; }
+
+ private:
+  //! The indices of the nonzero columns.
+  arma::uvec columns;
+  //! The values of the nonzero columns.
+  arma::mat values;
+};
+
+/**
+ * This is a template struct that tells whether a decomposable function type
+ * has a Gradient() function for a single function which returns the nonzero
+ * columns of the gradient:
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 ColumnGradient& gradient);
+ */
+template<typename FunctionType>
+struct HasColumnGradient
+{
+  static const bool value =
+      HasSparseGradientCheck<FunctionType, void(FunctionType::*)(
+          const arma::mat&, const size_t, ColumnGradient&)>::value ||
+      HasSparseGradientCheck<FunctionType, void(FunctionType::*)(
+          const arma::mat&, const size_t, ColumnGradient&) const>::value;
+};
+
 /**
  * Stochastic Gradient Descent is a technique for minimizing a function which
  * can be expressed as a sum of other functions.  That is, suppose we have
@@ -64,6 +161,46 @@ namespace optimization {
  * objective function on the first point in the dataset (presumably, the dataset
  * is held internally in the DecomposableFunctionType).
  *
+ * If the function type also implements
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::sp_mat& gradient);
+ *
+ * then the sparse gradient is used instead, and each step only updates the
+ * coordinates with a nonzero gradient, in O(nnz) time.  With a nonzero decay
+ * parameter, L2 regularization (weight decay) is added to each function:
+ *
+ * \f[
+ * A_{j + 1} = A_j - \alpha (\nabla f_i(A) + \lambda A).
+ * \f]
+ *
+ * For sparse gradients the decay is applied lazily: each coordinate is only
+ * scaled when a gradient next touches it (and at the end of each pass), so the
+ * steps stay O(nnz).  This requires that f_i only depends on the coordinates
+ * where its sparse gradient is nonzero, as for the logistic regression loss on
+ * sparse data.  These coordinates are brought up to date before the gradient is
+ * computed, so the function type should also implement
+ *
+ *   void GradientSupport(const size_t i, arma::uvec& support);
+ *
+ * which gives their indices (see HasGradientSupport); otherwise they are found
+ * by evaluating the gradient a first time.  The decay is not included in the
+ * objective values that SGD reports.
+ *
+ * When only a few columns of the gradient are nonzero, the function type can
+ * instead implement
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 ColumnGradient& gradient);
+ *
+ * which is preferred over the other overloads: then each step only takes time
+ * proportional to the number of rows of the coordinates times the number of
+ * nonzero columns (as for RegularizedSVDFunction, where this is O(rank) per
+ * rating).  The decay is applied lazily, in the same way as for sparse
+ * gradients; GradientSupport() then gives the columns to decay.
+ *
  * @tparam DecomposableFunctionType Decomposable objective function type to be
  *     minimized.
  */
@@ -86,12 +223,14 @@ class SGD
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *     function is visited in linear order.
+   * @param decay L2 regularization (weight decay) applied at each step.
    */
   SGD(DecomposableFunctionType& function,
       const double stepSize = 0.01,
       const size_t maxIterations = 100000,
       const double tolerance = 1e-5,
-      const bool shuffle = true);
+      const bool shuffle = true,
+      const double decay = 0.0);
 
   /**
    * Optimize the given function using stochastic gradient descent.  The given
@@ -128,7 +267,74 @@ class SGD
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the L2 regularization (weight decay).
+  double Decay() const { return decay; }
+  //! Modify the L2 regularization (weight decay).
+  double& Decay() { return decay; }
+
+  //! Get the callback which is given the progress of the optimizer.
+  const OptimizerCallback& Callback() const { return callback; }
+  //! Modify the callback which is given the progress of the optimizer.
+  OptimizerCallback& Callback() { return callback; }
+
  private:
+  //! The type of the function, if DecomposableFunctionType is a reference.
+  typedef typename std::remove_reference<DecomposableFunctionType>::type
+      FunctionType;
+
+  //! The type of the gradient of a single function.
+  typedef typename std::conditional<HasColumnGradient<FunctionType>::value,
+      ColumnGradient, typename std::conditional<
+      HasSparseGradient<FunctionType>::value, arma::sp_mat,
+      arma::mat>::type>::type GradientType;
+
+  //! Whether the decay is applied lazily.
+  static const bool LazyDecay = HasColumnGradient<FunctionType>::value ||
+      HasSparseGradient<FunctionType>::value;
+
+  //! Take an SGD step for the given function, with a dense gradient.
+  void Step(arma::mat& iterate, const size_t i, arma::mat& gradient);
+
+  //! Take an SGD step for the given function, updating only the coordinates
+  //! with a nonzero gradient.
+  void Step(arma::mat& iterate, const size_t i, arma::sp_mat& gradient);
+
+  //! Take an SGD step for the given function, updating only the columns with
+  //! a nonzero gradient.
+  void Step(arma::mat& iterate, const size_t i, ColumnGradient& gradient);
+
+  //! Return the norm of a dense or sparse gradient.
+  template<typename MatType>
+  static double Norm(const MatType& gradient)
+  {
+    return arma::norm(gradient, "fro");
+  }
+
+  //! Return the norm of a gradient given by its nonzero columns.
+  static double Norm(const ColumnGradient& gradient)
+  {
+    return arma::norm(gradient.Values(), "fro");
+  }
+
+  //! Apply the decay which has not been applied yet to each coordinate.
+  void ApplyDecay(arma::mat& iterate);
+
+  //! Get the support of the gradient of function i from the function, and
+  //! return true.
+  bool GradientSupport(const size_t i, arma::uvec& support, std::true_type)
+  {
+    function.GradientSupport(i, support);
+    return true;
+  }
+
+  //! Return false, since the function can't give the support of its gradient.
+  bool GradientSupport(const size_t /* i */,
+                       arma::uvec& /* support */,
+                       std::false_type)
+  {
+    return false;
+  }
+
   //! The instantiated function.
   DecomposableFunctionType& function;
 
@@ -144,6 +350,22 @@ class SGD
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The L2 regularization (weight decay).
+  double decay;
+
+  //! The number of steps taken in the current optimization.
+  size_t steps;
+  //! The number of steps taken when the decay was last applied to each
+  //! coordinate (only used when the decay is applied lazily).
+  arma::Col<size_t> decaySteps;
+  //! The coordinates (or columns) whose pending decay is applied before a
+  //! sparse (or column) gradient is computed.
+  arma::uvec support;
+
+  //! The callback which is given the progress of the optimizer (may be
+  //! empty).
+  OptimizerCallback callback;
 };
 
 } // namespace optimization
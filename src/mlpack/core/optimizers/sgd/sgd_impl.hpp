@@ -7,7 +7,6 @@
 #ifndef MLPACK_CORE_OPTIMIZERS_SGD_SGD_IMPL_HPP
 #define MLPACK_CORE_OPTIMIZERS_SGD_SGD_IMPL_HPP
 
-#include <mlpack/methods/regularized_svd/regularized_svd_function.hpp>
 // In case it hasn't been included yet.
 #include "sgd.hpp"
 
@@ -19,12 +18,15 @@ SGD<DecomposableFunctionType>::SGD(DecomposableFunctionType& function,
                                    const double stepSize,
                                    const size_t maxIterations,
                                    const double tolerance,
-                                   const bool shuffle) :
+                                   const bool shuffle,
+                                   const double decay) :
     function(function),
     stepSize(stepSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
+    shuffle(shuffle),
+    decay(decay),
+    steps(0)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -34,6 +36,9 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
+  // Time the optimization for the callback, if there is one.
+  const OptimizerMonitor monitor(callback);
+
   // This is used only if shuffle is true.
   arma::Col<size_t> visitationOrder;
   if (shuffle)
@@ -49,16 +54,32 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   for (size_t i = 0; i < numFunctions; ++i)
     overallObjective += function.Evaluate(iterate, i);
 
+  // No decay has been deferred yet.
+  steps = 0;
+  if (LazyDecay)
+    decaySteps.zeros(iterate.n_elem);
+
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  GradientType gradient(iterate.n_rows, iterate.n_cols);
   for (size_t i = 1; i != maxIterations; ++i, ++currentFunction)
   {
     // Is this iteration the start of a sequence?
     if ((currentFunction % numFunctions) == 0)
     {
+      ApplyDecay(iterate);
+
       // Output current objective function.
-      Log::Info << "SGD: iteration " << i << ", objective " << overallObjective
-          << "." << std::endl;
+      MLPACK_LOG(Log::Info) << "SGD: iteration " << i << ", objective "
+          << overallObjective << "." << std::endl;
+
+      if (monitor.Active() && monitor.Stop(i, overallObjective, (i == 1) ?
+          std::numeric_limits<double>::quiet_NaN() :
+          Norm(gradient), stepSize))
+      {
+        Log::Info << "SGD: stopped by the callback; terminating "
+            << "optimization." << std::endl;
+        return overallObjective;
+      }
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
@@ -83,25 +104,19 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
         visitationOrder = arma::shuffle(visitationOrder);
     }
 
-    // Evaluate the gradient for this iteration.
-    if (shuffle)
-      function.Gradient(iterate, visitationOrder[currentFunction], gradient);
-    else
-      function.Gradient(iterate, currentFunction, gradient);
-
-    // And update the iterate.
-    iterate -= stepSize * gradient;
+    // Evaluate the gradient for this iteration, and update the iterate.
+    const size_t f = (shuffle) ? visitationOrder[currentFunction] :
+        currentFunction;
+    Step(iterate, f, gradient);
 
     // Now add that to the overall objective function.
-    if (shuffle)
-      overallObjective += function.Evaluate(iterate,
-          visitationOrder[currentFunction]);
-    else
-      overallObjective += function.Evaluate(iterate, currentFunction);
+    overallObjective += function.Evaluate(iterate, f);
   }
 
   Log::Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
+  ApplyDecay(iterate);
+
   // Calculate final objective.
   overallObjective = 0;
   for (size_t i = 0; i < numFunctions; ++i)
@@ -109,6 +124,138 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   return overallObjective;
 }
 
+template<typename DecomposableFunctionType>
+void SGD<DecomposableFunctionType>::Step(arma::mat& iterate,
+                                         const size_t i,
+                                         arma::mat& gradient)
+{
+  function.Gradient(iterate, i, gradient);
+
+  if (decay != 0.0)
+    iterate *= (1.0 - stepSize * decay);
+  iterate -= stepSize * gradient;
+}
+
+template<typename DecomposableFunctionType>
+void SGD<DecomposableFunctionType>::Step(arma::mat& iterate,
+                                         const size_t i,
+                                         arma::sp_mat& gradient)
+{
+  const double shrink = 1.0 - stepSize * decay;
+  if (decay != 0.0)
+  {
+    // The gradient is computed at the decayed coordinates, so the pending
+    // decay of the coordinates the function depends on is applied first.  If
+    // the function can't tell which coordinates those are, the nonzero
+    // elements of a first gradient give them.
+    if (!GradientSupport(i, support, std::integral_constant<bool,
+        HasGradientSupport<FunctionType>::value>()))
+    {
+      function.Gradient(iterate, i, gradient);
+      SyncSparse(gradient);
+      support.set_size(gradient.n_nonzero);
+      for (size_t c = 0; c < gradient.n_cols; ++c)
+        for (size_t k = gradient.col_ptrs[c]; k < gradient.col_ptrs[c + 1]; ++k)
+          support[k] = c * iterate.n_rows + gradient.row_indices[k];
+    }
+
+    for (size_t s = 0; s < support.n_elem; ++s)
+    {
+      const size_t j = support[s];
+      iterate[j] *= std::pow(shrink, (double) (steps - decaySteps[j]));
+      decaySteps[j] = steps;
+    }
+  }
+
+  function.Gradient(iterate, i, gradient);
+  SyncSparse(gradient);
+
+  // Only update the coordinates with a nonzero gradient; any other coordinate
+  // only has to be decayed, which is done lazily.
+  for (size_t c = 0; c < gradient.n_cols; ++c)
+  {
+    for (size_t k = gradient.col_ptrs[c]; k < gradient.col_ptrs[c + 1]; ++k)
+    {
+      const size_t j = c * iterate.n_rows + gradient.row_indices[k];
+      if (decay != 0.0)
+      {
+        iterate[j] *= std::pow(shrink, (double) (steps + 1 - decaySteps[j]));
+        decaySteps[j] = steps + 1;
+      }
+      iterate[j] -= stepSize * gradient.values[k];
+    }
+  }
+
+  ++steps;
+}
+
+template<typename DecomposableFunctionType>
+void SGD<DecomposableFunctionType>::Step(arma::mat& iterate,
+                                         const size_t i,
+                                         ColumnGradient& gradient)
+{
+  const double shrink = 1.0 - stepSize * decay;
+  if (decay != 0.0)
+  {
+    // The gradient is computed at the decayed coordinates, so the pending
+    // decay of the columns the function depends on is applied first.  If the
+    // function can't tell which columns those are, the columns of a first
+    // gradient give them.
+    if (!GradientSupport(i, support, std::integral_constant<bool,
+        HasGradientSupport<FunctionType>::value>()))
+    {
+      function.Gradient(iterate, i, gradient);
+      support = gradient.Columns();
+    }
+
+    for (size_t c = 0; c < support.n_elem; ++c)
+    {
+      for (size_t r = 0; r < iterate.n_rows; ++r)
+      {
+        const size_t j = support[c] * iterate.n_rows + r;
+        iterate[j] *= std::pow(shrink, (double) (steps - decaySteps[j]));
+        decaySteps[j] = steps;
+      }
+    }
+  }
+
+  function.Gradient(iterate, i, gradient);
+
+  // Only update the columns with a nonzero gradient; the decay of the other
+  // columns is done lazily.
+  const arma::uvec& columns = gradient.Columns();
+  for (size_t c = 0; c < columns.n_elem; ++c)
+  {
+    if (decay != 0.0)
+    {
+      iterate.col(columns[c]) *= shrink;
+      decaySteps.subvec(columns[c] * iterate.n_rows,
+          (columns[c] + 1) * iterate.n_rows - 1).fill(steps + 1);
+    }
+    iterate.col(columns[c]) -= stepSize * gradient.Values().col(c);
+  }
+
+  ++steps;
+}
+
+template<typename DecomposableFunctionType>
+void SGD<DecomposableFunctionType>::ApplyDecay(arma::mat& iterate)
+{
+  // The decay is only deferred for sparse gradients.
+  if (decay == 0.0 || !LazyDecay)
+    return;
+
+  const double shrink = 1.0 - stepSize * decay;
+  for (size_t j = 0; j < iterate.n_elem; ++j)
+  {
+    if (decaySteps[j] != steps)
+    {
+      iterate[j] *= std::pow(shrink, (double) (steps - decaySteps[j]));
+      decaySteps[j] = steps;
+    }
+  }
+}
+
 } // namespace optimization
 } // namespace mlpack
 
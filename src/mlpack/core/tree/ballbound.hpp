@@ -127,6 +127,17 @@ class BallBound
    */
   ElemType MinDistance(const BallBound& other) const;
 
+  /**
+   * Calculates the minimum bound-to-bound distance to each of the given bounds,
+   * and stores them in the given vector.  The results are the same as calling
+   * MinDistance() on each bound.
+   *
+   * @param others Bounds to which the minimum distances are requested.
+   * @param distances Vector to store the distances in.
+   */
+  void MinDistance(const std::vector<const BallBound*>& others,
+                   arma::Col<ElemType>& distances) const;
+
   /**
    * Computes maximum distance.
    */
@@ -153,6 +153,19 @@ BallBound<MetricType, VecType>::MinDistance(const BallBound& other)
   }
 }
 
+/**
+ * Calculates minimum bound-to-bound distances to several bounds at once.
+ */
+template<typename MetricType, typename VecType>
+void BallBound<MetricType, VecType>::MinDistance(
+    const std::vector<const BallBound*>& others,
+    arma::Col<ElemType>& distances) const
+{
+  distances.set_size(others.size());
+  for (size_t i = 0; i < others.size(); ++i)
+    distances[i] = MinDistance(*others[i]);
+}
+
 /**
  * Computes maximum distance.
  */
@@ -251,23 +264,29 @@ template<typename MatType>
 const BallBound<MetricType, VecType>&
 BallBound<MetricType, VecType>::operator|=(const MatType& data)
 {
+  // The data may have a different element type than the bound (for instance,
+  // arma::fmat data with the default arma::vec center), so each point is
+  // extracted with its own element type and then converted to VecType.
+  typedef arma::Col<typename MatType::elem_type> DataVecType;
   if (radius < 0)
   {
-    center = data.col(0);
+    center = arma::conv_to<VecType>::from(DataVecType(data.col(0)));
     radius = 0;
   }
 
   // Now iteratively add points.
   for (size_t i = 0; i < data.n_cols; ++i)
   {
-    const ElemType dist = metric->Evaluate(center, (VecType) data.col(i));
+    const VecType point = arma::conv_to<VecType>::from(
+        DataVecType(data.col(i)));
+    const ElemType dist = metric->Evaluate(center, point);
 
     // See if the new point lies outside the bound.
     if (dist > radius)
     {
       // Move towards the new point and increase the radius just enough to
       // accommodate the new point.
-      const VecType diff = data.col(i) - center;
+      const VecType diff = point - center;
       center += ((dist - radius) / (2 * dist)) * diff;
       radius = 0.5 * (dist + radius);
     }
@@ -0,0 +1,95 @@
+/**
+ * @file best_first_single_tree_traverser.hpp
+ *
+ * A nested class of BinarySpaceTree which traverses the tree best-first (in
+ * order of the scores of the nodes) with a given set of rules, and stops when
+ * the budget of the rules is exhausted.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
+
+#include "binary_space_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The best-first single-tree traverser keeps the nodes to visit in a priority
+ * queue ordered by their scores, so the most promising leaves are searched
+ * first wherever they are in the tree.  Before each leaf is searched, the rules
+ * are asked whether their budget is exhausted; if so, the traversal stops, and
+ * Exact() returns false.  This makes the search an anytime search: its results
+ * are the best found within the budget.  The RuleType class must provide, in
+ * addition to BaseCase(), Score() and Rescore(), the functions
+ *
+ * @code
+ * bool BudgetExhausted(const size_t queryBaseCases) const;
+ * static bool IsBetterScore(const double value, const double ref);
+ * @endcode
+ *
+ * where queryBaseCases is the number of base cases performed for the current
+ * query point so far, and IsBetterScore() returns whether the score value is
+ * at least as good as the score ref (so that the rules decide whether lower or
+ * higher scores are searched first).  A leaf is always searched completely, so
+ * the budget may be exceeded by less than the size of a leaf.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
+                      SplitType>::BestFirstSingleTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the best-first single-tree traverser with the given rule set.
+   */
+  BestFirstSingleTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the tree with the given point, until every node is searched or
+   * pruned, or the budget of the rules is exhausted.
+   *
+   * @param queryIndex The index of the point in the query set which is being
+   *     used as the query point.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t queryIndex, BinarySpaceTree& referenceNode);
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Return whether the last traversal searched or pruned every node (that is,
+  //! it was not stopped by the budget).
+  bool Exact() const { return exact; }
+
+ private:
+  //! Reference to the rules with which the tree will be traversed.
+  TraversalRules<RuleType> rule;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+
+  //! Whether the last traversal was not stopped by the budget.
+  bool exact;
+
+  //! The nodes to visit with their scores, as a heap with the best score on
+  //! top.  This is kept between traversals so that it is allocated only once.
+  std::vector<std::pair<double, BinarySpaceTree*>> queue;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "best_first_single_tree_traverser_impl.hpp"
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file best_first_single_tree_traverser_impl.hpp
+ *
+ * Implementation of the best-first single-tree traverser for BinarySpaceTree.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "best_first_single_tree_traverser.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+BestFirstSingleTreeTraverser<RuleType>::BestFirstSingleTreeTraverser(
+    RuleType& rule) :
+    rule(rule),
+    numPrunes(0),
+    exact(true)
+{ /* Nothing to do. */ }
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+BestFirstSingleTreeTraverser<RuleType>::Traverse(
+    const size_t queryIndex,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceNode)
+{
+  typedef std::pair<double, BinarySpaceTree*> QueueEntry;
+  // The heap functions keep the largest element on top, so an entry is less
+  // than another when the other one has a strictly better score; this keeps the
+  // best score on top (the lowest for nearest neighbors, but the highest for
+  // furthest neighbors).
+  auto compare = [](const QueueEntry& a, const QueueEntry& b)
+  {
+    return !RuleType::IsBetterScore(a.first, b.first);
+  };
+
+  // The budget is counted in the base cases of this query point only.
+  const size_t startBaseCases = rule.BaseCases();
+  exact = true;
+
+  queue.clear();
+  const double rootScore = rule.Score(queryIndex, referenceNode);
+  if (rootScore == DBL_MAX)
+  {
+    ++numPrunes;
+    return;
+  }
+  queue.push_back(QueueEntry(rootScore, &referenceNode));
+
+  while (!queue.empty())
+  {
+    std::pop_heap(queue.begin(), queue.end(), compare);
+    const QueueEntry entry = queue.back();
+    queue.pop_back();
+    BinarySpaceTree& node = *entry.second;
+
+    // The bound may have improved since the node was scored.
+    if (rule.Rescore(queryIndex, node, entry.first) == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    if (node.IsLeaf())
+    {
+      if (rule.BudgetExhausted(rule.BaseCases() - startBaseCases))
+      {
+        // This leaf could still hold better candidates.
+        exact = false;
+        break;
+      }
+
+      const size_t refEnd = node.Begin() + node.Count();
+      for (size_t i = node.Begin(); i < refEnd; ++i)
+        rule.BaseCase(queryIndex, i);
+    }
+    else
+    {
+      // If a score is DBL_MAX, we do not recurse into that node.
+      const double leftScore = rule.Score(queryIndex, *node.Left());
+      if (leftScore != DBL_MAX)
+      {
+        queue.push_back(QueueEntry(leftScore, node.Left()));
+        std::push_heap(queue.begin(), queue.end(), compare);
+      }
+      else
+      {
+        ++numPrunes;
+      }
+
+      const double rightScore = rule.Score(queryIndex, *node.Right());
+      if (rightScore != DBL_MAX)
+      {
+        queue.push_back(QueueEntry(rightScore, node.Right()));
+        std::push_heap(queue.begin(), queue.end(), compare);
+      }
+      else
+      {
+        ++numPrunes;
+      }
+    }
+  }
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -8,8 +8,10 @@
 
 #include <mlpack/core.hpp>
 
+#include "../node_arena.hpp"
 #include "../statistic.hpp"
 #include "midpoint_split.hpp"
+#include "parallel_split.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
@@ -27,6 +29,11 @@ namespace tree /** Trees and tree-building procedures. */ {
  * This tree does take one runtime parameter in the constructor, which is the
  * max leaf size to be used.
  *
+ * If OpenMP is available, large trees on dense data are built in parallel: the
+ * top levels are partitioned with all threads, and the subtrees below them are
+ * built concurrently.  The resulting tree (and the point mapping) is exactly
+ * the same as the tree built with a single thread.
+ *
  * @tparam MetricType The metric used for tree-building.  The BoundType may
  *     place restrictions on the metrics that can be used.
  * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
@@ -46,7 +53,8 @@ template<typename MetricType,
             bound::HRectBound,
          template<typename SplitBoundType, typename SplitMatType>
             class SplitType = MidpointSplit>
-class BinarySpaceTree
+class BinarySpaceTree :
+    public NodeAllocation
 {
  public:
   //! So other classes can use TreeType::Mat.
@@ -81,6 +89,11 @@ class BinarySpaceTree
   //! The dataset.  If we are the root of the tree, we own the dataset and must
   //! delete it.
   MatType* dataset;
+  //! If the tree has been compacted (and we are the root), this holds every
+  //! descendant node contiguously, in depth-first order.
+  BinarySpaceTree* compactNodes;
+  //! The number of nodes held in compactNodes.
+  size_t numCompactNodes;
 
  public:
   //! A single-tree traverser for binary space trees; see
@@ -88,6 +101,12 @@ class BinarySpaceTree
   template<typename RuleType>
   class SingleTreeTraverser;
 
+  //! A best-first single-tree traverser for binary space trees, which stops
+  //! when the budget of the rules is exhausted; see
+  //! best_first_single_tree_traverser.hpp.
+  template<typename RuleType>
+  class BestFirstSingleTreeTraverser;
+
   //! A dual-tree traverser for binary space trees; see dual_tree_traverser.hpp.
   template<typename RuleType>
   class DualTreeTraverser;
@@ -95,6 +114,16 @@ class BinarySpaceTree
   template<typename RuleType>
   class BreadthFirstDualTreeTraverser;
 
+  //! A multithreaded dual-tree traverser for binary space trees; see
+  //! parallel_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  class ParallelDualTreeTraverser;
+
+  //! A level-synchronous multithreaded breadth-first dual-tree traverser for
+  //! binary space trees; see parallel_breadth_first_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  class ParallelBreadthFirstDualTreeTraverser;
+
   /**
    * Construct this as the root node of a binary space tree using the given
    * dataset.  This will copy the input matrix; if you don't want this, consider
@@ -456,6 +485,40 @@ class BinarySpaceTree
   //! Store the center of the bounding region in the given vector.
   void Center(arma::vec& center) { bound.Center(center); }
 
+  /**
+   * Compact the tree, so that all of the descendants of this node are stored
+   * contiguously in a single array in depth-first (pre-order) order, instead of
+   * in separate heap allocations.  The structure of the tree does not change,
+   * so all of the traversers can be used exactly as before, but nodes that are
+   * visited one after another during a depth-first traversal are now adjacent
+   * in memory.  The bound and statistic of each node are moved along with it.
+   *
+   * This can only be called on the root of the tree, and the tree structure
+   * should be treated as read-only afterwards: individual compacted nodes must
+   * never be deleted or replaced.  Any pointers or references to nodes other
+   * than the root are invalidated.  Calling this on a tree that has already
+   * been compacted does nothing.  The array is allocated from the current
+   * NodeArena of the thread, if there is one.
+   */
+  void Compact();
+
+  //! Return whether the descendants of this node are stored compactly (this is
+  //! only ever true for the root of a tree that has been compacted).
+  bool IsCompact() const { return compactNodes != NULL; }
+
+  /**
+   * Recompute the bound, the cached distances and the statistic of this node
+   * and all of its descendants, after the points of the dataset have been
+   * modified in place (with Dataset()).  The structure of the tree is kept:
+   * each node holds the same points as before, and its bound is refit to
+   * those points.  The partition is not recomputed, so it is generally not the
+   * one that building a new tree on the moved points would give, and the
+   * bounds of siblings may overlap more; the tree is still valid, but searches
+   * may prune less.  This is much cheaper than building a new tree when the
+   * points have only moved a little.
+   */
+  void RefitBounds();
+
  private:
   /**
    * Splits the current node, assigning its left and right children recursively.
@@ -478,6 +541,52 @@ class BinarySpaceTree
                  const size_t maxLeafSize,
                  SplitType<BoundType<MetricType>, MatType>& splitter);
 
+  /**
+   * Build the subtrees of this node, which has been split at splitCol, in
+   * parallel.  The top levels of the tree are split one level at a time until
+   * there are enough subtrees to keep all threads busy, and those subtrees are
+   * then built in parallel.  The result is exactly the same as the result of
+   * the serial construction.  This is only used by the root, and it requires
+   * that SplitType::SplitNode() and the constructor of StatisticType can be
+   * called for disjoint nodes from several threads at once.
+   *
+   * @param splitCol Column at which this node has been split.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   * @param oldFromNew Vector holding permuted indices, or NULL if the
+   *     permutation is not tracked.
+   */
+  void SplitChildrenInParallel(
+      const size_t splitCol,
+      const size_t maxLeafSize,
+      SplitType<BoundType<MetricType>, MatType>& splitter,
+      std::vector<size_t>* oldFromNew);
+
+  /**
+   * Create the children of this node, which has been split at splitCol,
+   * without splitting the children any further.
+   *
+   * @param splitCol Column at which this node has been split.
+   * @param splitter Instantiated SplitType object.
+   * @param oldFromNew Vector holding permuted indices, or NULL if the
+   *     permutation is not tracked.
+   */
+  void CreateUnsplitChildren(
+      const size_t splitCol,
+      SplitType<BoundType<MetricType>, MatType>& splitter,
+      std::vector<size_t>* oldFromNew);
+
+  /**
+   * Move the children of the given node (and, recursively, their descendants)
+   * into compactNodes, in depth-first order.  This is only called on the root.
+   *
+   * @param node Node whose children should be moved.
+   */
+  void CompactChildren(BinarySpaceTree& node);
+
+  //! Destroy and deallocate the compacted descendants of the root.
+  void DeleteCompactNodes();
+
  protected:
   /**
    * A default constructor.  This is meant to only be used with
@@ -490,6 +599,10 @@ class BinarySpaceTree
   //! Friend access is given for the default constructor.
   friend class boost::serialization::access;
 
+  //! MappedTree builds trees directly from memory-mapped files.
+  template<typename TreeType>
+  friend class MappedTree;
+
  public:
   /**
    * Serialize the tree.
@@ -12,6 +12,7 @@
 #include <mlpack/core/util/cli.hpp>
 #include <mlpack/core/util/log.hpp>
 #include <queue>
+#include <new>
 
 namespace mlpack {
 namespace tree {
@@ -35,7 +36,9 @@ BinarySpaceTree(
     count(data.n_cols), /* and spans all of the dataset. */
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Do the actual splitting of this node.
   SplitType<BoundType<MetricType>, MatType> splitter;
@@ -63,7 +66,9 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(data.n_cols);
@@ -97,7 +102,9 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(data.n_cols);
@@ -132,7 +139,9 @@ BinarySpaceTree(MatType&& data, const size_t maxLeafSize) :
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Do the actual splitting of this node.
   SplitType<BoundType<MetricType>, MatType> splitter;
@@ -160,7 +169,9 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(dataset->n_cols);
@@ -194,7 +205,9 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(dataset->n_cols);
@@ -233,7 +246,9 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset().n_rows),
-    dataset(&parent->Dataset()) // Point to the parent's dataset.
+    dataset(&parent->Dataset()), // Point to the parent's dataset.
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Perform the actual splitting.
   SplitNode(maxLeafSize, splitter);
@@ -262,7 +277,9 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset().n_rows),
-    dataset(&parent->Dataset())
+    dataset(&parent->Dataset()),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -296,7 +313,9 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset()->n_rows),
-    dataset(&parent->Dataset())
+    dataset(&parent->Dataset()),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -337,7 +356,9 @@ BinarySpaceTree(
     parentDistance(other.parentDistance),
     furthestDescendantDistance(other.furthestDescendantDistance),
     // Copy matrix, but only if we are the root.
-    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL)
+    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Create left and right children (if any).
   if (other.Left())
@@ -395,7 +416,9 @@ BinarySpaceTree(BinarySpaceTree&& other) :
     parentDistance(other.parentDistance),
     furthestDescendantDistance(other.furthestDescendantDistance),
     minimumBoundDistance(other.minimumBoundDistance),
-    dataset(other.dataset)
+    dataset(other.dataset),
+    compactNodes(other.compactNodes),
+    numCompactNodes(other.numCompactNodes)
 {
   // Now we are a clone of the other tree.  But we must also clear the other
   // tree's contents, so it doesn't delete anything when it is destructed.
@@ -407,6 +430,8 @@ BinarySpaceTree(BinarySpaceTree&& other) :
   other.furthestDescendantDistance = 0.0;
   other.minimumBoundDistance = 0.0;
   other.dataset = NULL;
+  other.compactNodes = NULL;
+  other.numCompactNodes = 0;
 }
 
 /**
@@ -444,6 +469,11 @@ template<typename MetricType,
 BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
   ~BinarySpaceTree()
 {
+  // If the tree has been compacted, the descendants must not be deleted one by
+  // one.
+  if (compactNodes)
+    DeleteCompactNodes();
+
   delete left;
   delete right;
 
@@ -628,6 +658,153 @@ inline size_t BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   return (begin + index);
 }
 
+/**
+ * Move all of the descendants of the root into one contiguous array.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    Compact()
+{
+  if (parent != NULL)
+    throw std::invalid_argument("BinarySpaceTree::Compact(): can only be "
+        "called on the root of the tree");
+
+  // Nothing to do if we have been compacted already.
+  if (compactNodes)
+    return;
+
+  // Count the number of descendant nodes.
+  size_t numNodes = 0;
+  std::queue<BinarySpaceTree*> queue;
+  queue.push(this);
+  while (!queue.empty())
+  {
+    BinarySpaceTree* node = queue.front();
+    queue.pop();
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+    {
+      ++numNodes;
+      queue.push(&node->Child(i));
+    }
+  }
+
+  // A single leaf has no descendants to move.
+  if (numNodes == 0)
+    return;
+
+  // The nodes are move-constructed into raw memory, because BinarySpaceTree
+  // has no usable default constructor.  The memory comes from the current
+  // NodeArena, if there is one.
+  compactNodes = static_cast<BinarySpaceTree*>(
+      NodeArena::AllocateNode(numNodes * sizeof(BinarySpaceTree)));
+  numCompactNodes = 0;
+
+  CompactChildren(*this);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    CompactChildren(BinarySpaceTree& node)
+{
+  // Place each child directly followed by its own subtree, so that the array
+  // is in depth-first (pre-order) order.
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BinarySpaceTree*& child = node.ChildPtr(i);
+    if (!child)
+      continue;
+
+    // After the move, the old node holds no children and no dataset, so it is
+    // safe to delete.
+    BinarySpaceTree* oldChild = child;
+    child = new (compactNodes + numCompactNodes++)
+        BinarySpaceTree(std::move(*oldChild));
+    child->parent = &node;
+    delete oldChild;
+
+    CompactChildren(*child);
+  }
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    DeleteCompactNodes()
+{
+  // Sever the links between the compacted nodes first, so that their
+  // destructors don't try to delete each other.
+  for (size_t i = 0; i < numCompactNodes; ++i)
+  {
+    compactNodes[i].left = NULL;
+    compactNodes[i].right = NULL;
+  }
+
+  for (size_t i = 0; i < numCompactNodes; ++i)
+    compactNodes[i].~BinarySpaceTree();
+  NodeArena::FreeNode(compactNodes);
+
+  compactNodes = NULL;
+  numCompactNodes = 0;
+  left = NULL;
+  right = NULL;
+}
+
+/**
+ * Recompute the bounds and statistics of the tree without changing its
+ * structure.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    RefitBounds()
+{
+  // The children go first, because the statistic of this node may be built
+  // from the statistics of its children.
+  if (left)
+    left->RefitBounds();
+  if (right)
+    right->RefitBounds();
+
+  // This is the same as what SplitNode() does when the tree is built.
+  bound = BoundType<MetricType>(dataset->n_rows);
+  if (count > 0)
+    bound |= dataset->cols(begin, begin + count - 1);
+
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+
+  if (left && right)
+  {
+    arma::vec center, leftCenter, rightCenter;
+    Center(center);
+    left->Center(leftCenter);
+    right->Center(rightCenter);
+
+    left->ParentDistance() = MetricType::Evaluate(center, leftCenter);
+    right->ParentDistance() = MetricType::Evaluate(center, rightCenter);
+  }
+
+  stat = StatisticType(*this);
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -665,11 +842,19 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     return;
 
   // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, splitter,
-      maxLeafSize);
-  right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      splitter, maxLeafSize);
+  // by calling their constructors (which perform this splitting process).  For
+  // large trees, the root builds its subtrees in parallel instead.
+  if (parent == NULL && UseParallelSplit<MatType>(count))
+  {
+    SplitChildrenInParallel(splitCol, maxLeafSize, splitter, NULL);
+  }
+  else
+  {
+    left = new BinarySpaceTree(this, begin, splitCol - begin, splitter,
+        maxLeafSize);
+    right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
+        splitter, maxLeafSize);
+  }
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -724,11 +909,19 @@ SplitNode(std::vector<size_t>& oldFromNew,
     return;
 
   // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, oldFromNew,
-      splitter, maxLeafSize);
-  right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      oldFromNew, splitter, maxLeafSize);
+  // by calling their constructors (which perform this splitting process).  For
+  // large trees, the root builds its subtrees in parallel instead.
+  if (parent == NULL && UseParallelSplit<MatType>(count))
+  {
+    SplitChildrenInParallel(splitCol, maxLeafSize, splitter, &oldFromNew);
+  }
+  else
+  {
+    left = new BinarySpaceTree(this, begin, splitCol - begin, oldFromNew,
+        splitter, maxLeafSize);
+    right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
+        oldFromNew, splitter, maxLeafSize);
+  }
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -744,6 +937,140 @@ SplitNode(std::vector<size_t>& oldFromNew,
   right->ParentDistance() = rightParentDistance;
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+SplitChildrenInParallel(const size_t splitCol,
+                        const size_t maxLeafSize,
+                        SplitType<BoundType<MetricType>, MatType>& splitter,
+                        std::vector<size_t>* oldFromNew)
+{
+  size_t numThreads = 1;
+  #ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+  #endif
+  // We want several subtrees per thread so that dynamic scheduling can balance
+  // subtrees of different sizes.
+  const size_t targetSubtrees = 8 * numThreads;
+
+  // Split the top of the tree one level at a time, until there are enough
+  // subtrees left to build.  The nodes that are split here are kept in
+  // top-down order, so that their statistics can be built bottom-up later.
+  CreateUnsplitChildren(splitCol, splitter, oldFromNew);
+  std::vector<BinarySpaceTree*> subtrees, splitNodes;
+  subtrees.push_back(left);
+  subtrees.push_back(right);
+
+  bool split = true;
+  while (split && subtrees.size() < targetSubtrees)
+  {
+    split = false;
+    std::vector<BinarySpaceTree*> nextSubtrees;
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      BinarySpaceTree* node = subtrees[i];
+
+      // Nodes which are not split are already complete, so they don't need to
+      // be built again.  This is the same check that SplitNode() does.
+      size_t childSplitCol;
+      if (node->count <= maxLeafSize)
+        continue;
+      const bool nodeSplit = (oldFromNew == NULL) ?
+          splitter.SplitNode(node->bound, *dataset, node->begin, node->count,
+              childSplitCol) :
+          splitter.SplitNode(node->bound, *dataset, node->begin, node->count,
+              childSplitCol, *oldFromNew);
+      if (!nodeSplit)
+        continue;
+
+      node->CreateUnsplitChildren(childSplitCol, splitter, oldFromNew);
+
+      // Calculate parent distances for those two nodes.
+      arma::vec center, leftCenter, rightCenter;
+      node->Center(center);
+      node->left->Center(leftCenter);
+      node->right->Center(rightCenter);
+
+      node->left->ParentDistance() = MetricType::Evaluate(center, leftCenter);
+      node->right->ParentDistance() = MetricType::Evaluate(center,
+          rightCenter);
+
+      splitNodes.push_back(node);
+      nextSubtrees.push_back(node->left);
+      nextSubtrees.push_back(node->right);
+      split = true;
+    }
+
+    subtrees.swap(nextSubtrees);
+  }
+
+  // Now build the remaining subtrees from scratch in parallel, exactly as the
+  // serial construction would.  They cover disjoint sets of points, so the
+  // partitioning steps never touch the same columns.  Siblings write to
+  // different child pointers of their parent, so that is safe too.  The nodes
+  // are allocated from the arena of this thread, if there is one.
+  NodeArena* arena = NodeArena::Current();
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t i = 0; i < (omp_size_t) subtrees.size(); ++i)
+  {
+    NodeArenaScope scope(arena);
+    BinarySpaceTree* oldNode = subtrees[i];
+    BinarySpaceTree* nodeParent = oldNode->parent;
+
+    BinarySpaceTree* node = (oldFromNew == NULL) ?
+        new BinarySpaceTree(nodeParent, oldNode->begin, oldNode->count,
+            splitter, maxLeafSize) :
+        new BinarySpaceTree(nodeParent, oldNode->begin, oldNode->count,
+            *oldFromNew, splitter, maxLeafSize);
+    node->ParentDistance() = oldNode->ParentDistance();
+
+    if (nodeParent->left == oldNode)
+      nodeParent->left = node;
+    else
+      nodeParent->right = node;
+    delete oldNode;
+  }
+
+  // Finally, build the statistics of the nodes that were split above, now that
+  // their subtrees are complete.
+  for (size_t i = splitNodes.size(); i > 0; --i)
+    splitNodes[i - 1]->stat = StatisticType(*splitNodes[i - 1]);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+CreateUnsplitChildren(const size_t splitCol,
+                      SplitType<BoundType<MetricType>, MatType>& splitter,
+                      std::vector<size_t>* oldFromNew)
+{
+  // Using the number of points as the maximum leaf size means that the child
+  // constructors only compute the bounds of the children.
+  const size_t leftCount = splitCol - begin;
+  const size_t rightCount = begin + count - splitCol;
+  if (oldFromNew == NULL)
+  {
+    left = new BinarySpaceTree(this, begin, leftCount, splitter, leftCount);
+    right = new BinarySpaceTree(this, splitCol, rightCount, splitter,
+        rightCount);
+  }
+  else
+  {
+    left = new BinarySpaceTree(this, begin, leftCount, *oldFromNew, splitter,
+        leftCount);
+    right = new BinarySpaceTree(this, splitCol, rightCount, *oldFromNew,
+        splitter, rightCount);
+  }
+}
+
 // Default constructor (private), for boost::serialization.
 template<typename MetricType,
          typename StatisticType,
@@ -761,7 +1088,9 @@ BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     stat(*this),
     parentDistance(0),
     furthestDescendantDistance(0),
-    dataset(NULL)
+    dataset(NULL),
+    compactNodes(NULL),
+    numCompactNodes(0)
 {
   // Nothing to do.
 }
@@ -784,6 +1113,8 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
   // If we're loading, and we have children, they need to be deleted.
   if (Archive::is_loading::value)
   {
+    if (compactNodes)
+      DeleteCompactNodes();
     if (left)
       delete left;
     if (right)
@@ -11,6 +11,7 @@
 #define MLPACK_CORE_TREE_BINARY_SPACE_TREE_BREADTH_FIRST_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
 #include <queue>
 
 #include "../binary_space_tree.hpp"
@@ -81,7 +82,7 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
 
  private:
   //! Reference to the rules with which the trees will be traversed.
-  RuleType& rule;
+  TraversalRules<RuleType> rule;
 
   //! The number of prunes.
   size_t numPrunes;
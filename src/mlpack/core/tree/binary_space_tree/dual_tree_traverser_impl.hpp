@@ -15,6 +15,37 @@
 namespace mlpack {
 namespace tree {
 
+//! This tells whether rules can evaluate the base cases of a pair of leaves at
+//! once (like NeighborSearchRules).
+HAS_MEM_FUNC(LeafBaseCases, HasLeafBaseCasesCheck);
+
+//! Let the rules evaluate the base cases of a pair of leaves at once, and return
+//! whether they did.
+template<typename RuleType, typename TraversalRuleType, typename TreeType>
+bool EvaluateLeafBaseCases(
+    TraversalRuleType& rule,
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    size_t& numBaseCases,
+    const typename boost::enable_if_c<HasLeafBaseCasesCheck<RuleType,
+        bool(RuleType::*)(TreeType&, TreeType&, size_t&)>::value>::type* = 0)
+{
+  return rule.LeafBaseCases(queryNode, referenceNode, numBaseCases);
+}
+
+//! Rules without LeafBaseCases() evaluate each base case on its own.
+template<typename RuleType, typename TraversalRuleType, typename TreeType>
+bool EvaluateLeafBaseCases(
+    TraversalRuleType& /* rule */,
+    TreeType& /* queryNode */,
+    TreeType& /* referenceNode */,
+    size_t& /* numBaseCases */,
+    const typename boost::disable_if_c<HasLeafBaseCasesCheck<RuleType,
+        bool(RuleType::*)(TreeType&, TreeType&, size_t&)>::value>::type* = 0)
+{
+  return false;
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -51,9 +82,14 @@ DualTreeTraverser<RuleType>::Traverse(
   // Store the current traversal info.
   traversalInfo = rule.TraversalInfo();
 
-  // If both are leaves, we must evaluate the base case.
+  // If both are leaves, we must evaluate the base case.  Some rules can do that
+  // for the whole pair at once.
   if (queryNode.IsLeaf() && referenceNode.IsLeaf())
   {
+    if (EvaluateLeafBaseCases<RuleType>(rule, queryNode, referenceNode,
+        numBaseCases))
+      return;
+
     // Loop through each of the points in each node.
     const size_t queryEnd = queryNode.Begin() + queryNode.Count();
     const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
@@ -0,0 +1,168 @@
+/**
+ * @file mapped_tree.hpp
+ *
+ * Definition of MappedTree, which saves a kd-tree (a BinarySpaceTree with
+ * HRectBound) and its dataset to a flat, position-independent file, and loads
+ * it again by memory-mapping the file, so that the dataset does not need to be
+ * copied or parsed.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/hrectbound.hpp>
+
+#include "binary_space_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A MappedTree memory-maps a file written by MappedTree::Save() and recreates
+ * the tree from it.  The dataset of the tree points directly into the mapped
+ * file, so loading does not copy or parse the (potentially very large) dataset,
+ * and several processes that map the same file share the same pages of the
+ * page cache.  Only the nodes themselves are allocated when loading; their
+ * bounds and distances are read from the file, so no distance calculations or
+ * partitioning are done.
+ *
+ * The file is mapped copy-on-write, so modifying the dataset of the tree is
+ * possible but affects only this process and not the file.  The tree is only
+ * valid for the lifetime of the MappedTree object.
+ *
+ * The file format is versioned and stores all offsets relative to the start of
+ * the file.  It is not portable between platforms with different endianness or
+ * size_t widths; this is checked when loading.
+ *
+ * @code
+ * KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+ *     arma::mat> tree(dataset, oldFromNew);
+ * MappedTree<decltype(tree)>::Save(tree, oldFromNew, "tree.bin");
+ *
+ * // Later, maybe in another process...
+ * MappedTree<decltype(tree)> mapped("tree.bin");
+ * KNN knn(&mapped.Tree());
+ * @endcode
+ *
+ * MappedTree is only defined for BinarySpaceTrees with an HRectBound (such as
+ * the KDTree and the MeanSplitKDTree), built on a dense matrix.
+ *
+ * @tparam TreeType Type of tree.
+ */
+template<typename TreeType>
+class MappedTree;
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+class MappedTree<BinarySpaceTree<MetricType, StatisticType, MatType,
+                                 bound::HRectBound, SplitType> >
+{
+ public:
+  //! The type of tree.
+  typedef BinarySpaceTree<MetricType, StatisticType, MatType, bound::HRectBound,
+      SplitType> TreeType;
+  //! The type of element held in the dataset.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Map the given file and build the tree that is stored in it.  A
+   * std::runtime_error is thrown if the file cannot be mapped or if it is not
+   * a valid tree file for this tree type.
+   *
+   * @param filename File to load the tree from.
+   */
+  MappedTree(const std::string& filename);
+
+  //! Delete the tree and unmap the file.
+  ~MappedTree();
+
+  // A MappedTree owns its mapping, so it cannot be copied.
+  MappedTree(const MappedTree& other) = delete;
+  MappedTree& operator=(const MappedTree& other) = delete;
+
+  /**
+   * Save the given tree, its dataset, and the mapping from tree point indices
+   * to original point indices to the given file.  A std::runtime_error is
+   * thrown if the file cannot be written.
+   *
+   * @param tree Root of the tree to save.
+   * @param oldFromNew Mapping of the points as returned by the tree
+   *     constructor; this may be empty if the points were not mapped.
+   * @param filename File to save to.
+   */
+  static void Save(const TreeType& tree,
+                   const std::vector<size_t>& oldFromNew,
+                   const std::string& filename);
+
+  //! Get the tree.
+  const TreeType& Tree() const { return *tree; }
+  //! Modify the tree.
+  TreeType& Tree() { return *tree; }
+
+  //! Get the original index of the point at the given index in the dataset of
+  //! the tree.  If no mapping was saved, this is the identity.
+  size_t OldFromNew(const size_t index) const
+  { return (oldFromNew == NULL) ? index : oldFromNew[index]; }
+
+  //! Return whether a point mapping was saved with the tree.
+  bool HasMapping() const { return oldFromNew != NULL; }
+
+ private:
+  //! The magic number that identifies the file format.
+  static const size_t formatMagic = 0x6d6c7062737474;
+  //! The format version written by Save().
+  static const size_t formatVersion = 1;
+
+  //! The header of the file; every field is a size_t so there is no padding.
+  struct Header
+  {
+    size_t magic;
+    size_t version;
+    size_t elemSize;
+    size_t nRows;
+    size_t nCols;
+    size_t numNodes;
+    size_t hasMapping;
+    size_t dataOffset;
+    size_t mappingOffset;
+    size_t nodesOffset;
+    size_t boundsOffset;
+    size_t fileSize;
+  };
+
+  //! The description of a single node; children are given as node indices.
+  struct NodeRecord
+  {
+    size_t begin;
+    size_t count;
+    size_t left;
+    size_t right;
+    double parentDistance;
+    double furthestDescendantDistance;
+    double minWidth;
+  };
+
+  //! Round the given offset up to a multiple of the cache line size.
+  static size_t Align(const size_t offset)
+  { return (offset + 63) & ~((size_t) 63); }
+
+  //! The memory-mapped file.
+  char* mapping;
+  //! The size of the memory-mapped file.
+  size_t mappingSize;
+  //! The root of the tree.
+  TreeType* tree;
+  //! The point mapping stored in the file, or NULL if there is none.
+  const size_t* oldFromNew;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "mapped_tree_impl.hpp"
+
+#endif
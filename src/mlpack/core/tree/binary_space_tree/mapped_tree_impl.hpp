@@ -0,0 +1,293 @@
+/**
+ * @file mapped_tree_impl.hpp
+ *
+ * Implementation of MappedTree, which saves kd-trees to flat files and loads
+ * them back by memory-mapping the file.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mapped_tree.hpp"
+
+#include <fstream>
+#include <stack>
+#include <unordered_map>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+MappedTree<BinarySpaceTree<MetricType, StatisticType, MatType,
+    bound::HRectBound, SplitType> >::MappedTree(const std::string& filename) :
+    mapping(NULL),
+    mappingSize(0),
+    tree(NULL),
+    oldFromNew(NULL)
+{
+#ifdef _WIN32
+  throw std::runtime_error("MappedTree: memory-mapped trees are not supported "
+      "on Windows");
+#else
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("MappedTree: cannot open '" + filename + "'");
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size < sizeof(Header))
+  {
+    close(fd);
+    throw std::runtime_error("MappedTree: '" + filename + "' is not a valid "
+        "tree file");
+  }
+
+  // The mapping is private, so the pages are shared with other processes until
+  // they are written to.
+  mappingSize = (size_t) fileStat.st_size;
+  void* address = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+      fd, 0);
+  close(fd);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("MappedTree: cannot map '" + filename + "'");
+  mapping = (char*) address;
+
+  // Check that the header matches this tree type and the size of the file.
+  const Header& header = *((const Header*) mapping);
+  const size_t dataSize = header.nRows * header.nCols * sizeof(ElemType);
+  const size_t nodesSize = header.numNodes * sizeof(NodeRecord);
+  const size_t boundsSize = header.numNodes * header.nRows * 2 * sizeof(double);
+  std::string error;
+  if (header.magic != formatMagic)
+    error = "is not a valid tree file";
+  else if (header.version != formatVersion)
+    error = "has an unsupported format version";
+  else if (header.elemSize != sizeof(ElemType))
+    error = "was saved with a different element type";
+  else if (header.numNodes == 0 ||
+           header.dataOffset != Align(sizeof(Header)) ||
+           header.mappingOffset != Align(header.dataOffset + dataSize) ||
+           header.nodesOffset != Align(header.mappingOffset +
+               (header.hasMapping ? header.nCols * sizeof(size_t) : 0)) ||
+           header.boundsOffset != Align(header.nodesOffset + nodesSize) ||
+           header.fileSize != header.boundsOffset + boundsSize ||
+           header.fileSize != mappingSize)
+    error = "is truncated or corrupt";
+
+  // The nodes are stored in depth-first order, so children always come after
+  // their parents, and each node (except the root) has exactly one parent.
+  const NodeRecord* records = (const NodeRecord*)
+      (mapping + header.nodesOffset);
+  if (error.empty())
+  {
+    std::vector<bool> hasParent(header.numNodes, false);
+    for (size_t i = 0; i < header.numNodes && error.empty(); ++i)
+    {
+      const NodeRecord& record = records[i];
+      if (record.begin + record.count > header.nCols ||
+          (record.left == size_t(-1)) != (record.right == size_t(-1)))
+        error = "is corrupt";
+
+      if (record.left != size_t(-1))
+      {
+        if (record.left <= i || record.left >= header.numNodes ||
+            record.right <= i || record.right >= header.numNodes ||
+            hasParent[record.left] || hasParent[record.right] ||
+            record.left == record.right)
+          error = "is corrupt";
+        else
+          hasParent[record.left] = hasParent[record.right] = true;
+      }
+    }
+  }
+
+  if (!error.empty())
+  {
+    munmap(mapping, mappingSize);
+    throw std::runtime_error("MappedTree: '" + filename + "' " + error);
+  }
+
+  // The dataset uses the mapped memory directly.  Deleting the matrix (which
+  // the root of the tree does) does not free that memory.
+  MatType* dataset = new MatType((ElemType*) (mapping + header.dataOffset),
+      header.nRows, header.nCols, false, true);
+  if (header.hasMapping)
+    oldFromNew = (const size_t*) (mapping + header.mappingOffset);
+
+  // Now create the nodes.
+  const double* bounds = (const double*) (mapping + header.boundsOffset);
+  std::vector<TreeType*> nodes(header.numNodes);
+  for (size_t i = 0; i < header.numNodes; ++i)
+    nodes[i] = new TreeType();
+
+  for (size_t i = 0; i < header.numNodes; ++i)
+  {
+    const NodeRecord& record = records[i];
+    TreeType& node = *nodes[i];
+
+    node.begin = record.begin;
+    node.count = record.count;
+    node.parentDistance = record.parentDistance;
+    node.furthestDescendantDistance = record.furthestDescendantDistance;
+    node.dataset = dataset;
+
+    node.bound = bound::HRectBound<MetricType>(header.nRows);
+    const double* nodeBounds = bounds + 2 * header.nRows * i;
+    for (size_t d = 0; d < header.nRows; ++d)
+      node.bound[d] = math::Range(nodeBounds[2 * d], nodeBounds[2 * d + 1]);
+    node.bound.MinWidth() = record.minWidth;
+
+    if (record.left != size_t(-1))
+    {
+      node.left = nodes[record.left];
+      node.right = nodes[record.right];
+      node.left->parent = &node;
+      node.right->parent = &node;
+    }
+  }
+
+  // Build the statistics bottom-up, since children come after their parents.
+  for (size_t i = header.numNodes; i > 0; --i)
+    nodes[i - 1]->stat = StatisticType(*nodes[i - 1]);
+
+  tree = nodes[0];
+#endif
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+MappedTree<BinarySpaceTree<MetricType, StatisticType, MatType,
+    bound::HRectBound, SplitType> >::~MappedTree()
+{
+  // The tree must be deleted before the memory it refers to is unmapped.
+  delete tree;
+
+#ifndef _WIN32
+  if (mapping)
+    munmap(mapping, mappingSize);
+#endif
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void MappedTree<BinarySpaceTree<MetricType, StatisticType, MatType,
+    bound::HRectBound, SplitType> >::Save(const TreeType& tree,
+                                          const std::vector<size_t>& oldFromNew,
+                                          const std::string& filename)
+{
+  const MatType& dataset = tree.Dataset();
+  if (!oldFromNew.empty() && oldFromNew.size() != dataset.n_cols)
+    throw std::invalid_argument("MappedTree::Save(): size of oldFromNew does "
+        "not match the number of points in the dataset");
+
+  // Number the nodes in depth-first order.
+  std::vector<const TreeType*> nodes;
+  std::unordered_map<const TreeType*, size_t> indices;
+  std::stack<const TreeType*> stack;
+  stack.push(&tree);
+  while (!stack.empty())
+  {
+    const TreeType* node = stack.top();
+    stack.pop();
+
+    indices[node] = nodes.size();
+    nodes.push_back(node);
+
+    if (!node->IsLeaf())
+    {
+      stack.push(node->Right());
+      stack.push(node->Left());
+    }
+  }
+
+  Header header;
+  header.magic = formatMagic;
+  header.version = formatVersion;
+  header.elemSize = sizeof(ElemType);
+  header.nRows = dataset.n_rows;
+  header.nCols = dataset.n_cols;
+  header.numNodes = nodes.size();
+  header.hasMapping = oldFromNew.empty() ? 0 : 1;
+  header.dataOffset = Align(sizeof(Header));
+  header.mappingOffset = Align(header.dataOffset + dataset.n_elem *
+      sizeof(ElemType));
+  header.nodesOffset = Align(header.mappingOffset + oldFromNew.size() *
+      sizeof(size_t));
+  header.boundsOffset = Align(header.nodesOffset + nodes.size() *
+      sizeof(NodeRecord));
+  header.fileSize = header.boundsOffset + nodes.size() * dataset.n_rows * 2 *
+      sizeof(double);
+
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("MappedTree::Save(): cannot open '" + filename +
+        "' for writing");
+
+  const char zeros[64] = { 0 };
+  stream.write((const char*) &header, sizeof(Header));
+  stream.write(zeros, header.dataOffset - sizeof(Header));
+
+  stream.write((const char*) dataset.memptr(), dataset.n_elem *
+      sizeof(ElemType));
+  stream.write(zeros, header.mappingOffset - header.dataOffset -
+      dataset.n_elem * sizeof(ElemType));
+
+  if (!oldFromNew.empty())
+    stream.write((const char*) oldFromNew.data(), oldFromNew.size() *
+        sizeof(size_t));
+  stream.write(zeros, header.nodesOffset - header.mappingOffset -
+      oldFromNew.size() * sizeof(size_t));
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const TreeType& node = *nodes[i];
+
+    NodeRecord record;
+    record.begin = node.Begin();
+    record.count = node.Count();
+    record.left = node.IsLeaf() ? size_t(-1) : indices[node.Left()];
+    record.right = node.IsLeaf() ? size_t(-1) : indices[node.Right()];
+    record.parentDistance = node.ParentDistance();
+    record.furthestDescendantDistance = node.FurthestDescendantDistance();
+    record.minWidth = node.Bound().MinWidth();
+
+    stream.write((const char*) &record, sizeof(NodeRecord));
+  }
+  stream.write(zeros, header.boundsOffset - header.nodesOffset -
+      nodes.size() * sizeof(NodeRecord));
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+    {
+      const double range[2] = { nodes[i]->Bound()[d].Lo(),
+                                nodes[i]->Bound()[d].Hi() };
+      stream.write((const char*) range, 2 * sizeof(double));
+    }
+  }
+
+  if (!stream.good())
+    throw std::runtime_error("MappedTree::Save(): error writing to '" +
+        filename + "'");
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -10,6 +10,7 @@
 #define MLPACK_CORE_TREE_BINARY_SPACE_TREE_MEAN_SPLIT_HPP
 
 #include <mlpack/core.hpp>
+#include "parallel_split.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
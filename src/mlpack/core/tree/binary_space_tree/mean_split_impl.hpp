@@ -178,6 +178,10 @@ size_t MeanSplit<BoundType, MatType>::
                  const size_t splitDimension,
                  const double splitVal)
 {
+  // Large partitions are done in parallel, with exactly the same result.
+  if (UseParallelSplit<MatType>(count))
+    return ParallelPerformSplit(data, begin, count, splitDimension, splitVal);
+
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
   // splitVal should be on the left side of the matrix, and the points greater
@@ -225,6 +229,11 @@ size_t MeanSplit<BoundType, MatType>::
                  const double splitVal,
                  std::vector<size_t>& oldFromNew)
 {
+  // Large partitions are done in parallel, with exactly the same result.
+  if (UseParallelSplit<MatType>(count))
+    return ParallelPerformSplit(data, begin, count, splitDimension, splitVal,
+        &oldFromNew);
+
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
   // splitVal should be on the left side of the matrix, and the points greater
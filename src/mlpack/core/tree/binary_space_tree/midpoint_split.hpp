@@ -11,6 +11,7 @@
 #define MLPACK_CORE_TREE_BINARY_SPACE_TREE_MIDPOINT_SPLIT_HPP
 
 #include <mlpack/core.hpp>
+#include "parallel_split.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
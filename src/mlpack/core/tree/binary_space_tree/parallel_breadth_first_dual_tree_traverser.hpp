@@ -0,0 +1,153 @@
+/**
+ * @file parallel_breadth_first_dual_tree_traverser.hpp
+ *
+ * Defines the ParallelBreadthFirstDualTreeTraverser for the BinarySpaceTree
+ * tree type.  This is a nested class of BinarySpaceTree which traverses the
+ * query tree one level at a time, and scores the node combinations of all the
+ * query nodes of a level in parallel.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_BREADTH_FIRST_DUAL_TREE_TRAVERSER_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_BREADTH_FIRST_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
+#include <queue>
+
+#include "binary_space_tree.hpp"
+#include "breadth_first_dual_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A level-synchronous multithreaded version of the BreadthFirstDualTreeTraverser.
+ * Like the serial traverser, each query node has a queue of the reference nodes
+ * it must still be compared with, and the reference nodes of a queue are
+ * descended in order of their score.  But instead of descending the query tree
+ * depth-first, the traverser keeps the frontier of all the query nodes of one
+ * depth with a non-empty queue, and processes the queues of a whole frontier in
+ * parallel; the combinations that are not pruned are then pushed into the
+ * queues of the query children, which form the next frontier.  The query nodes
+ * of a frontier are disjoint subtrees, and their ancestors are never scored at
+ * the same time, so the bounds of a query node are only updated by one thread
+ * and the bounds of its parent are final when it is scored.
+ *
+ * This gives much more parallel work than the ParallelDualTreeTraverser at the
+ * top of shallow, wide trees (for instance, trees with large leaves), and the
+ * work of a frontier is balanced by dynamic scheduling; but the queues of a
+ * whole frontier are kept in memory at once.
+ *
+ * Each thread uses its own copy of the RuleType object, so the same
+ * requirements as for the ParallelDualTreeTraverser hold: the rules must be
+ * copy-constructible, they must expose modifiable BaseCases() and Scores()
+ * counters (which are merged back into the given rules object), and they must
+ * only write to state that belongs to the query points and query nodes they are
+ * given, or update shared state atomically.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
+                      SplitType>::ParallelBreadthFirstDualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the parallel breadth-first dual-tree traverser with the given
+   * rule set.
+   *
+   * @param rule Instantiated rules; each thread works on a copy of this.
+   */
+  ParallelBreadthFirstDualTreeTraverser(RuleType& rule);
+
+  typedef QueueFrame<BinarySpaceTree, typename RuleType::TraversalInfoType>
+      QueueFrameType;
+
+  /**
+   * Traverse the two trees.  This does not reset the number of prunes.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void Traverse(BinarySpaceTree& queryNode,
+                BinarySpaceTree& referenceNode);
+
+  //! Get the number of query levels that were traversed.
+  size_t NumLevels() const { return numLevels; }
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of visited combinations.
+  size_t NumVisited() const { return numVisited; }
+  //! Modify the number of visited combinations.
+  size_t& NumVisited() { return numVisited; }
+
+  //! Get the number of times a node combination was scored.
+  size_t NumScores() const { return numScores; }
+  //! Modify the number of times a node combination was scored.
+  size_t& NumScores() { return numScores; }
+
+  //! Get the number of times a base case was calculated.
+  size_t NumBaseCases() const { return numBaseCases; }
+  //! Modify the number of times a base case was calculated.
+  size_t& NumBaseCases() { return numBaseCases; }
+
+ private:
+  /**
+   * Score all the combinations of the given query node with the reference
+   * nodes of its queue, descending the reference nodes that are not pruned,
+   * and push the combinations with the children of the query node into the
+   * given queues.
+   *
+   * @param threadRule Rules of the calling thread.
+   * @param queryNode Query node of the queue.
+   * @param referenceQueue Queue of combinations with the query node.
+   * @param leftChildQueue Queue to push combinations with the left child into.
+   * @param rightChildQueue Queue to push combinations with the right child
+   *     into.
+   * @param prunes Counter of prunes to increment.
+   * @param scores Counter of scored combinations to increment.
+   * @param baseCases Counter of base cases to increment.
+   */
+  static void TraverseQueue(TraversalRules<RuleType>& threadRule,
+                            BinarySpaceTree& queryNode,
+                            std::priority_queue<QueueFrameType>& referenceQueue,
+                            std::priority_queue<QueueFrameType>& leftChildQueue,
+                            std::priority_queue<QueueFrameType>&
+                                rightChildQueue,
+                            size_t& prunes,
+                            size_t& scores,
+                            size_t& baseCases);
+
+  //! Reference to the rules with which the trees will be traversed.
+  TraversalRules<RuleType> rule;
+
+  //! The number of query levels that were traversed.
+  size_t numLevels;
+
+  //! The number of prunes.
+  size_t numPrunes;
+
+  //! The number of node combinations that have been visited during traversal.
+  size_t numVisited;
+
+  //! The number of times a node combination was scored.
+  size_t numScores;
+
+  //! The number of times a base case was calculated.
+  size_t numBaseCases;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "parallel_breadth_first_dual_tree_traverser_impl.hpp"
+
+#endif // MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_BREADTH_FIRST_DUAL_TREE_TRAVERSER_HPP
@@ -0,0 +1,233 @@
+/**
+ * @file parallel_breadth_first_dual_tree_traverser_impl.hpp
+ *
+ * Implementation of the ParallelBreadthFirstDualTreeTraverser for
+ * BinarySpaceTree.  The queues of the query nodes of each level of the query
+ * tree are processed in parallel, each thread with its own copy of the rules.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_BREADTH_FIRST_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_BREADTH_FIRST_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_breadth_first_dual_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+ParallelBreadthFirstDualTreeTraverser<RuleType>::
+ParallelBreadthFirstDualTreeTraverser(RuleType& rule) :
+    rule(rule),
+    numLevels(0),
+    numPrunes(0),
+    numVisited(0),
+    numScores(0),
+    numBaseCases(0)
+{ /* Nothing to do. */ }
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+ParallelBreadthFirstDualTreeTraverser<RuleType>::Traverse(
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        queryRoot,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceRoot)
+{
+  // Must score the root combination.
+  ++numVisited;
+  const double rootScore = rule.Score(queryRoot, referenceRoot);
+  if (rootScore == DBL_MAX)
+    return; // This probably means something is wrong.
+
+  QueueFrameType rootFrame;
+  rootFrame.queryNode = &queryRoot;
+  rootFrame.referenceNode = &referenceRoot;
+  rootFrame.queryDepth = 0;
+  rootFrame.score = 0.0;
+  rootFrame.traversalInfo = rule.TraversalInfo();
+
+  // The frontier holds the query nodes of the current level, and the queue of
+  // reference combinations of each of them.
+  std::vector<BinarySpaceTree*> frontier(1, &queryRoot);
+  std::vector<std::priority_queue<QueueFrameType>> queues(1);
+  queues[0].push(rootFrame);
+
+  size_t prunes = 0, traverserScores = 0, traverserBaseCases = 0;
+  size_t ruleScores = 0, ruleBaseCases = 0;
+  while (!frontier.empty())
+  {
+    ++numLevels;
+
+    std::vector<std::priority_queue<QueueFrameType>> leftQueues(
+        frontier.size());
+    std::vector<std::priority_queue<QueueFrameType>> rightQueues(
+        frontier.size());
+
+    // The query nodes of the frontier are disjoint, so their queues can be
+    // processed in any order.
+    #pragma omp parallel reduction(+:prunes, traverserScores, \
+        traverserBaseCases, ruleScores, ruleBaseCases)
+    {
+      RuleType threadRule(rule);
+      threadRule.BaseCases() = 0;
+      threadRule.Scores() = 0;
+      // When traversals are traced, each thread traces its own rules, and the
+      // traces are merged into the trace of the traverser.
+      TraversalRules<RuleType> threadTracedRule(threadRule);
+
+      #pragma omp for schedule(dynamic)
+      for (omp_size_t i = 0; i < (omp_size_t) frontier.size(); ++i)
+      {
+        TraverseQueue(threadTracedRule, *frontier[i], queues[i],
+            leftQueues[i], rightQueues[i], prunes, traverserScores,
+            traverserBaseCases);
+      }
+
+      ruleScores += threadRule.Scores();
+      ruleBaseCases += threadRule.BaseCases();
+
+      #pragma omp critical
+      MergeTrace(rule, threadTracedRule);
+    }
+
+    // Assemble the next frontier in a deterministic order.
+    std::vector<BinarySpaceTree*> nextFrontier;
+    std::vector<std::priority_queue<QueueFrameType>> nextQueues;
+    for (size_t i = 0; i < frontier.size(); ++i)
+    {
+      if (!leftQueues[i].empty())
+      {
+        nextFrontier.push_back(frontier[i]->Left());
+        nextQueues.push_back(std::move(leftQueues[i]));
+      }
+      if (!rightQueues[i].empty())
+      {
+        nextFrontier.push_back(frontier[i]->Right());
+        nextQueues.push_back(std::move(rightQueues[i]));
+      }
+    }
+
+    frontier.swap(nextFrontier);
+    queues.swap(nextQueues);
+  }
+
+  numPrunes += prunes;
+  numScores += traverserScores;
+  numBaseCases += traverserBaseCases;
+
+  rule.Scores() += ruleScores;
+  rule.BaseCases() += ruleBaseCases;
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+ParallelBreadthFirstDualTreeTraverser<RuleType>::TraverseQueue(
+    TraversalRules<RuleType>& threadRule,
+    BinarySpaceTree& queryNode,
+    std::priority_queue<QueueFrameType>& referenceQueue,
+    std::priority_queue<QueueFrameType>& leftChildQueue,
+    std::priority_queue<QueueFrameType>& rightChildQueue,
+    size_t& prunes,
+    size_t& scores,
+    size_t& baseCases)
+{
+  // This is the loop of the serial BreadthFirstDualTreeTraverser, except that
+  // the queues of the children are not traversed here.
+  while (!referenceQueue.empty())
+  {
+    QueueFrameType currentFrame = referenceQueue.top();
+    referenceQueue.pop();
+
+    BinarySpaceTree& referenceNode = *currentFrame.referenceNode;
+    typename RuleType::TraversalInfoType ti = currentFrame.traversalInfo;
+    threadRule.TraversalInfo() = ti;
+    const size_t queryDepth = currentFrame.queryDepth;
+
+    const double score = threadRule.Score(queryNode, referenceNode);
+    ++scores;
+
+    if (score == DBL_MAX)
+    {
+      ++prunes;
+      continue;
+    }
+
+    if (queryNode.IsLeaf() && referenceNode.IsLeaf())
+    {
+      const size_t queryEnd = queryNode.Begin() + queryNode.Count();
+      const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
+      for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+      {
+        for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
+          threadRule.BaseCase(query, ref);
+
+        baseCases += referenceNode.Count();
+      }
+    }
+    else if ((!queryNode.IsLeaf()) && referenceNode.IsLeaf())
+    {
+      // Recurse down the query node, at the next level.
+      QueueFrameType fl = { queryNode.Left(), &referenceNode, queryDepth + 1,
+          score, threadRule.TraversalInfo() };
+      leftChildQueue.push(fl);
+
+      QueueFrameType fr = { queryNode.Right(), &referenceNode, queryDepth + 1,
+          score, ti };
+      rightChildQueue.push(fr);
+    }
+    else if (queryNode.IsLeaf() && (!referenceNode.IsLeaf()))
+    {
+      // Recurse down the reference node, at this level.
+      QueueFrameType fl = { &queryNode, referenceNode.Left(), queryDepth,
+          score, threadRule.TraversalInfo() };
+      referenceQueue.push(fl);
+
+      QueueFrameType fr = { &queryNode, referenceNode.Right(), queryDepth,
+          score, ti };
+      referenceQueue.push(fr);
+    }
+    else
+    {
+      // Recurse down both nodes; the query children are at the next level.
+      QueueFrameType fll = { queryNode.Left(), referenceNode.Left(),
+          queryDepth + 1, score, threadRule.TraversalInfo() };
+      leftChildQueue.push(fll);
+
+      QueueFrameType flr = { queryNode.Left(), referenceNode.Right(),
+          queryDepth + 1, score, threadRule.TraversalInfo() };
+      leftChildQueue.push(flr);
+
+      QueueFrameType frl = { queryNode.Right(), referenceNode.Left(),
+          queryDepth + 1, score, threadRule.TraversalInfo() };
+      rightChildQueue.push(frl);
+
+      QueueFrameType frr = { queryNode.Right(), referenceNode.Right(),
+          queryDepth + 1, score, threadRule.TraversalInfo() };
+      rightChildQueue.push(frr);
+    }
+  }
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif // MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_BREADTH_FIRST_DUAL_TREE_TRAVERSER_IMPL_HPP
@@ -0,0 +1,128 @@
+/**
+ * @file parallel_dual_tree_traverser.hpp
+ *
+ * Defines the ParallelDualTreeTraverser for the BinarySpaceTree tree type.
+ * This is a nested class of BinarySpaceTree which splits the query tree into
+ * disjoint subtrees and traverses each of them against the reference tree in a
+ * separate task, using the depth-first DualTreeTraverser for each task.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
+
+#include "binary_space_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A multithreaded dual-tree traverser.  The query tree is split into a set of
+ * disjoint query subtrees (at least a few per available thread), and each of
+ * these subtrees is traversed against the reference node with the depth-first
+ * DualTreeTraverser.  The tasks are scheduled dynamically with OpenMP, so
+ * threads that finish cheap subtrees early pick up the remaining work.  If
+ * OpenMP is not available, the tasks are simply run one after another.
+ *
+ * Each task uses its own copy of the RuleType object, so the rules class must
+ * be copy-constructible, and it must expose modifiable BaseCases() and Scores()
+ * counters, which are merged back into the given rules object when the
+ * traversal is finished.  In addition, the rules must only write to state that
+ * belongs to the query points and query nodes they are given, or update shared
+ * state atomically (this is true for NeighborSearchRules, DTBRules, and
+ * RangeSearchRules with a vector for each query point, but not for rules that
+ * accumulate results across queries, like DualTreeKMeansRules or
+ * RangeSearchRules with one flat vector of results).
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
+                      SplitType>::ParallelDualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the parallel dual-tree traverser with the given rule set.
+   *
+   * @param rule Instantiated rules; each task works on a copy of this.
+   * @param minTaskSize Query subtrees with fewer descendants than this are not
+   *     split into smaller tasks.
+   */
+  ParallelDualTreeTraverser(RuleType& rule, const size_t minTaskSize = 256);
+
+  /**
+   * Traverse the two trees.  This does not reset the number of prunes.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void Traverse(BinarySpaceTree& queryNode,
+                BinarySpaceTree& referenceNode);
+
+  //! Get the minimum number of query descendants for a task to be split.
+  size_t MinTaskSize() const { return minTaskSize; }
+  //! Modify the minimum number of query descendants for a task to be split.
+  size_t& MinTaskSize() { return minTaskSize; }
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of visited combinations.
+  size_t NumVisited() const { return numVisited; }
+  //! Modify the number of visited combinations.
+  size_t& NumVisited() { return numVisited; }
+
+  //! Get the number of times a node combination was scored.
+  size_t NumScores() const { return numScores; }
+  //! Modify the number of times a node combination was scored.
+  size_t& NumScores() { return numScores; }
+
+  //! Get the number of times a base case was calculated.
+  size_t NumBaseCases() const { return numBaseCases; }
+  //! Modify the number of times a base case was calculated.
+  size_t& NumBaseCases() { return numBaseCases; }
+
+ private:
+  /**
+   * Split the query node into disjoint subtrees until there are enough tasks
+   * to keep all threads busy, or until no subtree can be split further.
+   *
+   * @param queryNode Root of the query tree to split.
+   * @param tasks Vector to store the roots of the query subtrees in.
+   */
+  void AssembleTasks(BinarySpaceTree& queryNode,
+                     std::vector<BinarySpaceTree*>& tasks) const;
+
+  //! Reference to the rules with which the trees will be traversed.
+  TraversalRules<RuleType> rule;
+
+  //! The minimum number of query descendants for a task to be split.
+  size_t minTaskSize;
+
+  //! The number of prunes.
+  size_t numPrunes;
+
+  //! The number of node combinations that have been visited during traversal.
+  size_t numVisited;
+
+  //! The number of times a node combination was scored.
+  size_t numScores;
+
+  //! The number of times a base case was calculated.
+  size_t numBaseCases;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "parallel_dual_tree_traverser_impl.hpp"
+
+#endif // MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_HPP
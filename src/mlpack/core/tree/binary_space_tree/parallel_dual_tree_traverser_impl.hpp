@@ -0,0 +1,144 @@
+/**
+ * @file parallel_dual_tree_traverser_impl.hpp
+ *
+ * Implementation of the ParallelDualTreeTraverser for BinarySpaceTree.  The
+ * query tree is split into disjoint subtrees, and each subtree is traversed
+ * against the reference tree with its own copy of the rules.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_dual_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+ParallelDualTreeTraverser<RuleType>::ParallelDualTreeTraverser(
+    RuleType& rule,
+    const size_t minTaskSize) :
+    rule(rule),
+    minTaskSize(minTaskSize),
+    numPrunes(0),
+    numVisited(0),
+    numScores(0),
+    numBaseCases(0)
+{ /* Nothing to do. */ }
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+ParallelDualTreeTraverser<RuleType>::Traverse(
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        queryNode,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceNode)
+{
+  // Find the disjoint query subtrees that will be traversed independently.
+  std::vector<BinarySpaceTree*> tasks;
+  AssembleTasks(queryNode, tasks);
+
+  size_t prunes = 0, visited = 0, traverserScores = 0, traverserBaseCases = 0;
+  size_t ruleScores = 0, ruleBaseCases = 0;
+
+  // Each task traverses one query subtree against the whole reference node.
+  // This is what the serial traversal would do for the query points in that
+  // subtree too, except that the ancestors of the subtree root are never
+  // scored, so their bounds can't be used for pruning.  Because the subtrees
+  // are disjoint, no two tasks ever write to the same query point or query
+  // node.
+  #pragma omp parallel for schedule(dynamic) reduction(+:prunes, visited, \
+      traverserScores, traverserBaseCases, ruleScores, ruleBaseCases)
+  for (omp_size_t i = 0; i < (omp_size_t) tasks.size(); ++i)
+  {
+    RuleType taskRule(rule);
+    taskRule.BaseCases() = 0;
+    taskRule.Scores() = 0;
+
+    DualTreeTraverser<RuleType> traverser(taskRule);
+    traverser.Traverse(*tasks[i], referenceNode);
+
+    prunes += traverser.NumPrunes();
+    visited += traverser.NumVisited();
+    traverserScores += traverser.NumScores();
+    traverserBaseCases += traverser.NumBaseCases();
+    ruleScores += taskRule.Scores();
+    ruleBaseCases += taskRule.BaseCases();
+  }
+
+  numPrunes += prunes;
+  numVisited += visited;
+  numScores += traverserScores;
+  numBaseCases += traverserBaseCases;
+
+  rule.Scores() += ruleScores;
+  rule.BaseCases() += ruleBaseCases;
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+ParallelDualTreeTraverser<RuleType>::AssembleTasks(
+    BinarySpaceTree& queryNode,
+    std::vector<BinarySpaceTree*>& tasks) const
+{
+  // We want several tasks per thread so that dynamic scheduling can balance
+  // subtrees of different cost.
+  size_t numThreads = 1;
+  #ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+  #endif
+  const size_t targetTasks = (numThreads == 1) ? 1 : 8 * numThreads;
+
+  tasks.clear();
+  tasks.push_back(&queryNode);
+
+  // Replace every splittable subtree with its children, one level at a time,
+  // until we have enough tasks.  Splitting level by level keeps the order of
+  // the tasks deterministic.
+  bool split = true;
+  while (split && tasks.size() < targetTasks)
+  {
+    split = false;
+    std::vector<BinarySpaceTree*> nextTasks;
+    nextTasks.reserve(2 * tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+      if (!tasks[i]->IsLeaf() && tasks[i]->NumDescendants() >= minTaskSize)
+      {
+        nextTasks.push_back(tasks[i]->Left());
+        nextTasks.push_back(tasks[i]->Right());
+        split = true;
+      }
+      else
+      {
+        nextTasks.push_back(tasks[i]);
+      }
+    }
+
+    tasks.swap(nextTasks);
+  }
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif // MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_IMPL_HPP
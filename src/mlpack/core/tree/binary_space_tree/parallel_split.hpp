@@ -0,0 +1,156 @@
+/**
+ * @file parallel_split.hpp
+ *
+ * A parallel implementation of the partitioning step used by MidpointSplit and
+ * MeanSplit.  The result (including the order of the points) is exactly the
+ * same as the result of the serial partitioning loop in those classes.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_SPLIT_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_PARALLEL_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Return whether a partition of the given number of columns should be done in
+ * parallel with ParallelPerformSplit().  This is only the case if OpenMP is
+ * available with more than one thread, we are not already inside a parallel
+ * region, the matrix is dense (swapping columns of a sparse matrix modifies
+ * shared storage), and there are enough points to make it worthwhile.
+ *
+ * @param count Number of points to be partitioned.
+ */
+template<typename MatType>
+inline bool UseParallelSplit(const size_t count)
+{
+#ifdef _OPENMP
+  return !arma::is_arma_sparse_type<MatType>::value && (count >= 65536) &&
+      !omp_in_parallel() && (omp_get_max_threads() > 1);
+#else
+  (void) count;
+  return false;
+#endif
+}
+
+/**
+ * Reorder the given points so that all points whose value in dimension
+ * splitDimension is less than splitVal come first, and return the index of the
+ * first point that is not less than splitVal.
+ *
+ * The serial partitioning loop swaps the k'th misplaced point on the left side
+ * with the k'th misplaced point on the right side (counted from the right).
+ * Here the misplaced points are found in parallel and the same pairs are
+ * swapped in parallel, so the resulting order is identical.
+ *
+ * @param data The dataset used by the binary space tree.
+ * @param begin Index of the first point to partition.
+ * @param count Number of points to partition.
+ * @param splitDimension The dimension to split the points on.
+ * @param splitVal The value to split the points at.
+ * @param oldFromNew If not NULL, the mapping which is updated with each swap.
+ */
+template<typename MatType>
+size_t ParallelPerformSplit(MatType& data,
+                            const size_t begin,
+                            const size_t count,
+                            const size_t splitDimension,
+                            const double splitVal,
+                            std::vector<size_t>* oldFromNew = NULL)
+{
+  // First find where the partition will end up.
+  size_t numLess = 0;
+  #pragma omp parallel for reduction(+:numLess)
+  for (omp_size_t i = (omp_size_t) begin; i < (omp_size_t) (begin + count);
+      ++i)
+  {
+    if (data(splitDimension, i) < splitVal)
+      ++numLess;
+  }
+
+  const size_t splitCol = begin + numLess;
+  const size_t end = begin + count;
+
+  // Split each side into chunks, count the misplaced points in each chunk, and
+  // then collect them in order.
+  size_t numChunks = 1;
+  #ifdef _OPENMP
+    numChunks = omp_get_max_threads();
+  #endif
+
+  std::vector<size_t> leftCounts(numChunks, 0), rightCounts(numChunks, 0);
+  #pragma omp parallel for
+  for (omp_size_t c = 0; c < (omp_size_t) numChunks; ++c)
+  {
+    const size_t leftBegin = begin + (c * numLess) / numChunks;
+    const size_t leftEnd = begin + ((c + 1) * numLess) / numChunks;
+    for (size_t i = leftBegin; i < leftEnd; ++i)
+      if (data(splitDimension, i) >= splitVal)
+        ++leftCounts[c];
+
+    const size_t rightBegin = splitCol + (c * (end - splitCol)) / numChunks;
+    const size_t rightEnd = splitCol + ((c + 1) * (end - splitCol)) /
+        numChunks;
+    for (size_t i = rightBegin; i < rightEnd; ++i)
+      if (data(splitDimension, i) < splitVal)
+        ++rightCounts[c];
+  }
+
+  // Turn the counts into offsets.
+  size_t numMisplaced = 0, numRightMisplaced = 0;
+  for (size_t c = 0; c < numChunks; ++c)
+  {
+    const size_t leftCount = leftCounts[c];
+    const size_t rightCount = rightCounts[c];
+    leftCounts[c] = numMisplaced;
+    rightCounts[c] = numRightMisplaced;
+    numMisplaced += leftCount;
+    numRightMisplaced += rightCount;
+  }
+
+  Log::Assert(numMisplaced == numRightMisplaced);
+
+  std::vector<size_t> leftMisplaced(numMisplaced), rightMisplaced(numMisplaced);
+  #pragma omp parallel for
+  for (omp_size_t c = 0; c < (omp_size_t) numChunks; ++c)
+  {
+    size_t leftIndex = leftCounts[c];
+    const size_t leftBegin = begin + (c * numLess) / numChunks;
+    const size_t leftEnd = begin + ((c + 1) * numLess) / numChunks;
+    for (size_t i = leftBegin; i < leftEnd; ++i)
+      if (data(splitDimension, i) >= splitVal)
+        leftMisplaced[leftIndex++] = i;
+
+    size_t rightIndex = rightCounts[c];
+    const size_t rightBegin = splitCol + (c * (end - splitCol)) / numChunks;
+    const size_t rightEnd = splitCol + ((c + 1) * (end - splitCol)) /
+        numChunks;
+    for (size_t i = rightBegin; i < rightEnd; ++i)
+      if (data(splitDimension, i) < splitVal)
+        rightMisplaced[rightIndex++] = i;
+  }
+
+  // Now swap the pairs; each column is touched by exactly one swap.
+  #pragma omp parallel for
+  for (omp_size_t k = 0; k < (omp_size_t) numMisplaced; ++k)
+  {
+    const size_t left = leftMisplaced[k];
+    const size_t right = rightMisplaced[numMisplaced - 1 - k];
+    data.swap_cols(left, right);
+
+    if (oldFromNew)
+    {
+      const size_t t = (*oldFromNew)[left];
+      (*oldFromNew)[left] = (*oldFromNew)[right];
+      (*oldFromNew)[right] = t;
+    }
+  }
+
+  return splitCol;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
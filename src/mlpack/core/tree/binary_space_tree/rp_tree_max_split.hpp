@@ -0,0 +1,110 @@
+/**
+ * @file rp_tree_max_split.hpp
+ *
+ * Definition of RPTreeMaxSplit, a class that splits a binary space partitioning
+ * tree node along a random direction, as done by the RP-tree max rule.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MAX_SPLIT_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MAX_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * by projecting its points on a random unit direction, and splitting them at
+ * the median projection plus a random jitter.  The jitter is drawn uniformly
+ * from [-1, 1] * 6 ||x - y|| / sqrt(d), where y is a random point of the node,
+ * x the point of the node furthest from y, and d the dimensionality.  Unlike
+ * axis-aligned splits, these splits adapt to the intrinsic dimension of the
+ * data: the diameter of the cells decreases at a rate that depends on the
+ * intrinsic dimension, not on the dimensionality of the space.  For more
+ * information, see the following paper:
+ *
+ * @code
+ * @inproceedings{dasgupta2008random,
+ *   title={Random projection trees and low dimensional manifolds},
+ *   author={Dasgupta, S. and Freund, Y.},
+ *   booktitle={Proceedings of the 40th Annual ACM Symposium on Theory of
+ *       Computing (STOC '08)},
+ *   pages={537--546},
+ *   year={2008}
+ * }
+ * @endcode
+ *
+ * The directions and the distances of the split are Euclidean, whatever the
+ * metric of the tree; the nodes of these trees are not boxes, so they should
+ * be bounded with a BallBound, whose distances do use the metric of the tree.
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class RPTreeMaxSplit
+{
+ public:
+  /**
+   * Split the node along a random direction.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol);
+
+  /**
+   * Split the node along a random direction and return a list of changed
+   * indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+ private:
+  /**
+   * Reorder the dataset so that the points whose projection is less than the
+   * split value come first, and return false if the points cannot be split
+   * because they all have the same projection.
+   *
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew If not NULL, the mapping which is updated with each swap.
+   */
+  static bool PerformSplit(MatType& data,
+                           const size_t begin,
+                           const size_t count,
+                           size_t& splitCol,
+                           std::vector<size_t>* oldFromNew);
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "rp_tree_max_split_impl.hpp"
+
+#endif
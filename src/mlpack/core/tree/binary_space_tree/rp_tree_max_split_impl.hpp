@@ -0,0 +1,145 @@
+/**
+ * @file rp_tree_max_split_impl.hpp
+ *
+ * Implementation of RPTreeMaxSplit, which splits a binary space partitioning
+ * tree node along a random direction.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MAX_SPLIT_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MAX_SPLIT_IMPL_HPP
+
+#include "rp_tree_max_split.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+bool RPTreeMaxSplit<BoundType, MatType>::SplitNode(const BoundType& /* bound */,
+                                                   MatType& data,
+                                                   const size_t begin,
+                                                   const size_t count,
+                                                   size_t& splitCol)
+{
+  return PerformSplit(data, begin, count, splitCol, NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool RPTreeMaxSplit<BoundType, MatType>::SplitNode(
+    const BoundType& /* bound */,
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol,
+    std::vector<size_t>& oldFromNew)
+{
+  return PerformSplit(data, begin, count, splitCol, &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+bool RPTreeMaxSplit<BoundType, MatType>::PerformSplit(
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol,
+    std::vector<size_t>* oldFromNew)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Draw a random unit direction, and project the points on it.
+  arma::Col<ElemType> direction(data.n_rows);
+  for (size_t i = 0; i < data.n_rows; ++i)
+    direction[i] = math::RandNormal();
+  direction /= arma::norm(direction);
+
+  const arma::Row<ElemType> projectionRow = direction.t() *
+      data.cols(begin, begin + count - 1);
+  std::vector<double> projections(projectionRow.begin(), projectionRow.end());
+
+  // Find the median projection.
+  std::vector<double> sortedProjections(projections);
+  std::nth_element(sortedProjections.begin(),
+      sortedProjections.begin() + count / 2, sortedProjections.end());
+  const double median = sortedProjections[count / 2];
+
+  // The jitter is proportional to the distance between a random point of the
+  // node and the point furthest from it.
+  const size_t randomPoint = begin + math::RandInt(count);
+  double maxDistance = 0.0;
+  for (size_t i = begin; i < begin + count; ++i)
+  {
+    const double distance = arma::accu(arma::square(data.col(i) -
+        data.col(randomPoint)));
+    maxDistance = std::max(maxDistance, distance);
+  }
+  const double jitter = math::Random(-1.0, 1.0) * 6.0 *
+      std::sqrt(maxDistance / data.n_rows);
+
+  // The points with a projection less than the split value go left.  If that is
+  // none or all of the points, split at the median instead; if no point is
+  // less than the median (because many points have exactly the smallest
+  // projection), the points at the median go left too, and if that is all of
+  // the points, they cannot be split.
+  double splitValue = median + jitter;
+  bool inclusive = false;
+  size_t numLeft = 0;
+  for (size_t i = 0; i < count; ++i)
+    if (projections[i] < splitValue)
+      ++numLeft;
+
+  if (numLeft == 0 || numLeft == count)
+  {
+    splitValue = median;
+    numLeft = 0;
+    for (size_t i = 0; i < count; ++i)
+      if (projections[i] < splitValue)
+        ++numLeft;
+
+    if (numLeft == 0)
+    {
+      inclusive = true;
+      for (size_t i = 0; i < count; ++i)
+        if (projections[i] == splitValue)
+          ++numLeft;
+
+      if (numLeft == count)
+        return false;
+    }
+  }
+
+  // Now partition the points, swapping the misplaced points on each side.
+  size_t left = 0;
+  size_t right = count;
+  while (true)
+  {
+    while (left < right && (inclusive ? (projections[left] <= splitValue) :
+        (projections[left] < splitValue)))
+      ++left;
+    while (left < right && !(inclusive ?
+        (projections[right - 1] <= splitValue) :
+        (projections[right - 1] < splitValue)))
+      --right;
+
+    if (left == right)
+      break;
+
+    // Now projections[left] belongs on the right and projections[right - 1] on
+    // the left, so swap them.
+    --right;
+    data.swap_cols(begin + left, begin + right);
+    std::swap(projections[left], projections[right]);
+    if (oldFromNew)
+      std::swap((*oldFromNew)[begin + left], (*oldFromNew)[begin + right]);
+    ++left;
+  }
+
+  Log::Assert(left == numLeft);
+
+  splitCol = begin + numLeft;
+  return true;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
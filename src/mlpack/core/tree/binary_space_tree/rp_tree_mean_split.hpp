@@ -0,0 +1,124 @@
+/**
+ * @file rp_tree_mean_split.hpp
+ *
+ * Definition of RPTreeMeanSplit, a class that splits a binary space
+ * partitioning tree node along a random direction or by the distance to the
+ * mean of its points, as done by the RP-tree mean rule.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MEAN_SPLIT_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MEAN_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * in one of two ways, depending on how spread out its points are.  If the
+ * squared diameter of the node is at most DiameterRatio times the average
+ * squared distance between its points, the points are projected on a random
+ * unit direction and split at the median projection; otherwise (for instance,
+ * when a few points are far from a dense cluster), the points closer to the
+ * mean of the node than the median distance go left and the others go right.
+ * Both the diameter and the average distance are estimated from a random
+ * sample of at most SampleSize points.  The children hold the same number of
+ * points (give or take the points at the median), and, like the RP-tree max
+ * rule (RPTreeMaxSplit), the splits adapt to the intrinsic dimension of the
+ * data.  For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{dasgupta2008random,
+ *   title={Random projection trees and low dimensional manifolds},
+ *   author={Dasgupta, S. and Freund, Y.},
+ *   booktitle={Proceedings of the 40th Annual ACM Symposium on Theory of
+ *       Computing (STOC '08)},
+ *   pages={537--546},
+ *   year={2008}
+ * }
+ * @endcode
+ *
+ * The directions and the distances of the split are Euclidean, whatever the
+ * metric of the tree; the nodes of these trees are not boxes, so they should
+ * be bounded with a BallBound, whose distances do use the metric of the tree.
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class RPTreeMeanSplit
+{
+ public:
+  /**
+   * Split the node along a random direction or by the distance to its mean.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol);
+
+  /**
+   * Split the node along a random direction or by the distance to its mean,
+   * and return a list of changed indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+  //! The largest ratio of the squared diameter of a node to the average squared
+  //! distance between its points for which the node is split along a random
+  //! direction.
+  static constexpr double DiameterRatio = 10.0;
+
+  //! The number of points sampled to estimate the diameter of a node and the
+  //! average distance between its points.
+  static const size_t SampleSize = 100;
+
+ private:
+  /**
+   * Compute the value of each point to split the node by, and reorder the
+   * dataset so that the points with a value less than the median come first.
+   * Return false if the points cannot be split because they all have the same
+   * value.
+   *
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew If not NULL, the mapping which is updated with each swap.
+   */
+  static bool PerformSplit(MatType& data,
+                           const size_t begin,
+                           const size_t count,
+                           size_t& splitCol,
+                           std::vector<size_t>* oldFromNew);
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "rp_tree_mean_split_impl.hpp"
+
+#endif
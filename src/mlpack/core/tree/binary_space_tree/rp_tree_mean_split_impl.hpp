@@ -0,0 +1,166 @@
+/**
+ * @file rp_tree_mean_split_impl.hpp
+ *
+ * Implementation of RPTreeMeanSplit, which splits a binary space partitioning
+ * tree node along a random direction or by the distance to the mean of its
+ * points.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MEAN_SPLIT_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_MEAN_SPLIT_IMPL_HPP
+
+#include "rp_tree_mean_split.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+constexpr double RPTreeMeanSplit<BoundType, MatType>::DiameterRatio;
+
+template<typename BoundType, typename MatType>
+bool RPTreeMeanSplit<BoundType, MatType>::SplitNode(
+    const BoundType& /* bound */,
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol)
+{
+  return PerformSplit(data, begin, count, splitCol, NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool RPTreeMeanSplit<BoundType, MatType>::SplitNode(
+    const BoundType& /* bound */,
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol,
+    std::vector<size_t>& oldFromNew)
+{
+  return PerformSplit(data, begin, count, splitCol, &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+bool RPTreeMeanSplit<BoundType, MatType>::PerformSplit(
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol,
+    std::vector<size_t>* oldFromNew)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Estimate the squared diameter of the node and the average squared distance
+  // between its points from a sample of the points.
+  std::vector<size_t> sample;
+  if (count <= SampleSize)
+  {
+    for (size_t i = begin; i < begin + count; ++i)
+      sample.push_back(i);
+  }
+  else
+  {
+    for (size_t i = 0; i < SampleSize; ++i)
+      sample.push_back(begin + math::RandInt(count));
+  }
+
+  double maxDistance = 0.0;
+  double sumDistances = 0.0;
+  for (size_t i = 0; i < sample.size(); ++i)
+  {
+    for (size_t j = i + 1; j < sample.size(); ++j)
+    {
+      const double distance = arma::accu(arma::square(data.col(sample[i]) -
+          data.col(sample[j])));
+      maxDistance = std::max(maxDistance, distance);
+      sumDistances += distance;
+    }
+  }
+  const double averageDistance = sumDistances /
+      (sample.size() * (sample.size() - 1) / 2);
+
+  // Compute the value of each point to split by.
+  std::vector<double> values(count);
+  if (maxDistance <= DiameterRatio * averageDistance)
+  {
+    // Project the points on a random unit direction.
+    arma::Col<ElemType> direction(data.n_rows);
+    for (size_t i = 0; i < data.n_rows; ++i)
+      direction[i] = math::RandNormal();
+    direction /= arma::norm(direction);
+
+    const arma::Row<ElemType> projections = direction.t() *
+        data.cols(begin, begin + count - 1);
+    values.assign(projections.begin(), projections.end());
+  }
+  else
+  {
+    // Take the squared distance of the points to the mean of the node.
+    const arma::Col<ElemType> mean = arma::mean(data.cols(begin,
+        begin + count - 1), 1);
+    for (size_t i = 0; i < count; ++i)
+      values[i] = arma::accu(arma::square(data.col(begin + i) - mean));
+  }
+
+  // Find the median value.
+  std::vector<double> sortedValues(values);
+  std::nth_element(sortedValues.begin(), sortedValues.begin() + count / 2,
+      sortedValues.end());
+  const double median = sortedValues[count / 2];
+
+  // The points with a value less than the median go left.  If there are none
+  // (because many points have exactly the smallest value), the points at the
+  // median go left too; if that is all of the points, they cannot be split.
+  bool inclusive = false;
+  size_t numLeft = 0;
+  for (size_t i = 0; i < count; ++i)
+    if (values[i] < median)
+      ++numLeft;
+
+  if (numLeft == 0)
+  {
+    inclusive = true;
+    for (size_t i = 0; i < count; ++i)
+      if (values[i] == median)
+        ++numLeft;
+
+    if (numLeft == count)
+      return false;
+  }
+
+  // Now partition the points, swapping the misplaced points on each side.
+  size_t left = 0;
+  size_t right = count;
+  while (true)
+  {
+    while (left < right && (inclusive ? (values[left] <= median) :
+        (values[left] < median)))
+      ++left;
+    while (left < right && !(inclusive ? (values[right - 1] <= median) :
+        (values[right - 1] < median)))
+      --right;
+
+    if (left == right)
+      break;
+
+    // Now values[left] belongs on the right and values[right - 1] on the left,
+    // so swap them.
+    --right;
+    data.swap_cols(begin + left, begin + right);
+    std::swap(values[left], values[right]);
+    if (oldFromNew)
+      std::swap((*oldFromNew)[begin + left], (*oldFromNew)[begin + right]);
+    ++left;
+  }
+
+  Log::Assert(left == numLeft);
+
+  splitCol = begin + numLeft;
+  return true;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -10,6 +10,7 @@
 #define MLPACK_CORE_TREE_BINARY_SPACE_TREE_SINGLE_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
 
 #include "binary_space_tree.hpp"
 
@@ -48,7 +49,7 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
 
  private:
   //! Reference to the rules with which the tree will be traversed.
-  RuleType& rule;
+  TraversalRules<RuleType> rule;
 
   //! The number of nodes which have been pruned during traversal.
   size_t numPrunes;
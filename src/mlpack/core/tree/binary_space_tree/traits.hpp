@@ -56,6 +56,24 @@ class TreeTraits<BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   static const bool BinaryTree = true;
 };
 
+/**
+ * The BinarySpaceTree has a parallel dual-tree traverser.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+struct ParallelDualTreeTraversal<BinarySpaceTree<MetricType, StatisticType,
+                                                 MatType, BoundType, SplitType>>
+{
+  //! The traverser type for the given rules.
+  template<typename RuleType>
+  using Type = typename BinarySpaceTree<MetricType, StatisticType, MatType,
+      BoundType, SplitType>::template ParallelDualTreeTraverser<RuleType>;
+};
+
 } // namespace tree
 } // namespace mlpack
 
@@ -135,6 +135,77 @@ using MeanSplitBallTree = BinarySpaceTree<MetricType,
                                           bound::BallBound,
                                           MeanSplit>;
 
+/**
+ * A vantage-point tree.  Each node of this tree is split by choosing a vantage
+ * point and putting the points closer to it than the median distance in the
+ * left child and the others in the right child.  Unlike the kd-tree and the
+ * ball tree, the splits only use distances between points and no coordinate
+ * axes, so this tree can work well for high-dimensional data and for metrics
+ * where axis-aligned splits are not useful.  Each node is bounded with a ball,
+ * and the tree is balanced.  Points are only held in the leaves.
+ * @code
+ * @inproceedings{yianilos1993data,
+ *   title={Data structures and algorithms for nearest neighbor search in
+ *       general metric spaces},
+ *   author={Yianilos, P.N.},
+ *   booktitle={Proceedings of the Fourth Annual ACM-SIAM Symposium on Discrete
+ *       Algorithms (SODA '93)},
+ *   pages={311--321},
+ *   year={1993}
+ * }
+ * @endcode
+ * This template typedef satisfies the TreeType policy API.
+ * @see @ref trees, BinarySpaceTree, BallTree, VPTreeSplit
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+using VPTree = BinarySpaceTree<MetricType,
+                               StatisticType,
+                               MatType,
+                               bound::BallBound,
+                               VPTreeSplit>;
+
+/**
+ * A random projection tree.  Each node of this tree is split with the RP-tree
+ * mean rule: along a random direction at the median projection, or, if the
+ * points of the node are very spread out, by the median distance to their
+ * mean.  Unlike the axis-aligned splits of the kd-tree, these splits adapt to
+ * the intrinsic dimension of the data, so this tree can work well for data of
+ * low intrinsic dimension in a high-dimensional space.  Each node is bounded
+ * with a ball, and the tree is balanced.  Points are only held in the leaves.
+ * @code
+ * @inproceedings{dasgupta2008random,
+ *   title={Random projection trees and low dimensional manifolds},
+ *   author={Dasgupta, S. and Freund, Y.},
+ *   booktitle={Proceedings of the 40th Annual ACM Symposium on Theory of
+ *       Computing (STOC '08)},
+ *   pages={537--546},
+ *   year={2008}
+ * }
+ * @endcode
+ * This template typedef satisfies the TreeType policy API.
+ * @see @ref trees, BinarySpaceTree, MaxRPTree, RPTreeMeanSplit
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+using RPTree = BinarySpaceTree<MetricType,
+                               StatisticType,
+                               MatType,
+                               bound::BallBound,
+                               RPTreeMeanSplit>;
+
+/**
+ * A random projection tree built with the RP-tree max rule: each node is split
+ * along a random direction at the median projection plus a random jitter.  See
+ * RPTree for details.
+ * This template typedef satisfies the TreeType policy API.
+ * @see @ref trees, BinarySpaceTree, RPTree, RPTreeMaxSplit
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+using MaxRPTree = BinarySpaceTree<MetricType,
+                                  StatisticType,
+                                  MatType,
+                                  bound::BallBound,
+                                  RPTreeMaxSplit>;
+
 } // namespace tree
 } // namespace mlpack
 
@@ -0,0 +1,118 @@
+/**
+ * @file vp_tree_split.hpp
+ *
+ * Definition of VPTreeSplit, a class that splits a binary space partitioning
+ * tree node by the distance of its points to a vantage point, as done by the
+ * vantage-point tree.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * by choosing a vantage point among the points of the node and computing the
+ * distance of every point to it.  The points closer to the vantage point than
+ * the median distance go to the left child and the rest go to the right child,
+ * so the two children contain the same number of points (give or take the
+ * points at the median distance).  Since only distances between points are
+ * used, the split works the same for any metric and does not depend on the
+ * coordinate axes.
+ *
+ * The vantage point is the point of the node that is furthest from the first
+ * point of the node; this is cheap to find and tends to pick a point near the
+ * boundary of the node, which separates the points well.
+ *
+ * The distances are computed with the metric of the bound, so BoundType must
+ * provide Metric(), as BallBound does.
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class VPTreeSplit
+{
+ public:
+  /**
+   * Split the node by the median distance to a vantage point.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol);
+
+  /**
+   * Split the node by the median distance to a vantage point and return a list
+   * of changed indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+ private:
+  /**
+   * Return the index of the vantage point for the given points.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   */
+  static size_t SelectVantagePoint(const BoundType& bound,
+                                   const MatType& data,
+                                   const size_t begin,
+                                   const size_t count);
+
+  /**
+   * Reorder the dataset so that the points closer to the vantage point than
+   * the median distance come first, and return false if the points cannot be
+   * split because they are all at the same distance.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew If not NULL, the mapping which is updated with each swap.
+   */
+  static bool PerformSplit(const BoundType& bound,
+                           MatType& data,
+                           const size_t begin,
+                           const size_t count,
+                           size_t& splitCol,
+                           std::vector<size_t>* oldFromNew);
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "vp_tree_split_impl.hpp"
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file vp_tree_split_impl.hpp
+ *
+ * Implementation of VPTreeSplit, which splits a binary space partitioning tree
+ * node by the distance of its points to a vantage point.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_IMPL_HPP
+
+#include "vp_tree_split.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitCol)
+{
+  return PerformSplit(bound, data, begin, count, splitCol, NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitCol,
+                                                std::vector<size_t>& oldFromNew)
+{
+  return PerformSplit(bound, data, begin, count, splitCol, &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+size_t VPTreeSplit<BoundType, MatType>::SelectVantagePoint(
+    const BoundType& bound,
+    const MatType& data,
+    const size_t begin,
+    const size_t count)
+{
+  size_t vantagePoint = begin;
+  double maxDistance = -1.0;
+  for (size_t i = begin; i < begin + count; ++i)
+  {
+    const double distance = bound.Metric().Evaluate(data.col(begin),
+        data.col(i));
+    if (distance > maxDistance)
+    {
+      maxDistance = distance;
+      vantagePoint = i;
+    }
+  }
+
+  return vantagePoint;
+}
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::PerformSplit(
+    const BoundType& bound,
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol,
+    std::vector<size_t>* oldFromNew)
+{
+  const size_t vantagePoint = SelectVantagePoint(bound, data, begin, count);
+
+  std::vector<double> distances(count);
+  for (size_t i = 0; i < count; ++i)
+    distances[i] = bound.Metric().Evaluate(data.col(vantagePoint),
+        data.col(begin + i));
+
+  // Find the median distance.
+  std::vector<double> sortedDistances(distances);
+  std::nth_element(sortedDistances.begin(),
+      sortedDistances.begin() + count / 2, sortedDistances.end());
+  const double median = sortedDistances[count / 2];
+
+  // The points closer than the median go left.  If there are none (because
+  // many points are at exactly the smallest distance), the points at the median
+  // go left too; if that is all of the points, they cannot be split.
+  bool inclusive = false;
+  size_t numLeft = 0;
+  for (size_t i = 0; i < count; ++i)
+    if (distances[i] < median)
+      ++numLeft;
+
+  if (numLeft == 0)
+  {
+    inclusive = true;
+    for (size_t i = 0; i < count; ++i)
+      if (distances[i] == median)
+        ++numLeft;
+
+    if (numLeft == count)
+      return false;
+  }
+
+  // Now partition the points, swapping the misplaced points on each side.
+  size_t left = 0;
+  size_t right = count;
+  while (true)
+  {
+    while (left < right && (inclusive ? (distances[left] <= median) :
+        (distances[left] < median)))
+      ++left;
+    while (left < right && !(inclusive ? (distances[right - 1] <= median) :
+        (distances[right - 1] < median)))
+      --right;
+
+    if (left == right)
+      break;
+
+    // Now distances[left] belongs on the right and distances[right - 1] on the
+    // left, so swap them.
+    --right;
+    data.swap_cols(begin + left, begin + right);
+    std::swap(distances[left], distances[right]);
+    if (oldFromNew)
+      std::swap((*oldFromNew)[begin + left], (*oldFromNew)[begin + right]);
+    ++left;
+  }
+
+  Log::Assert(left == numLeft);
+
+  splitCol = begin + numLeft;
+  return true;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
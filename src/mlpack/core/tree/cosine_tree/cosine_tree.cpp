@@ -22,13 +22,18 @@ CosineTree::CosineTree(const arma::mat& dataset) :
   indices.resize(numColumns);
   l2NormsSquared.zeros(numColumns);
 
-  // Set indices and calculate squared norms of the columns.
+  // Set indices and calculate squared norms of the columns, in parallel blocks
+  // of columns.
   for (size_t i = 0; i < numColumns; i++)
-  {
     indices[i] = i;
-    double l2Norm = arma::norm(dataset.col(i), 2);
-    l2NormsSquared(i) = l2Norm * l2Norm;
-  }
+
+  const size_t blocks = (numColumns + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    const size_t end = std::min((b + 1) * BlockSize, numColumns);
+    for (size_t i = b * BlockSize; i < end; i++)
+      l2NormsSquared(i) = arma::dot(dataset.col(i), dataset.col(i));
+  });
 
   // Frobenius norm of columns in the node.
   frobNormSquared = arma::accu(l2NormsSquared);
@@ -85,6 +90,14 @@ CosineTree::CosineTree(const arma::mat& dataset,
   root.BasisVector(tempVector);
   treeQueue.push(&root);
 
+  // The basis vectors of the nodes in the queue are also kept as the first
+  // basisSize columns of queueBasis (whose node is in basisNodes), so that the
+  // orthonormalization and the error estimates are matrix products.
+  arma::mat queueBasis(dataset.n_rows, 16);
+  std::vector<CosineTree*> basisNodes(1, &root);
+  queueBasis.col(0) = tempVector;
+  size_t basisSize = 1;
+
   // Initialize Monte Carlo error estimate for comparison.
   double monteCarloError = root.FrobNormSquared();
 
@@ -95,6 +108,14 @@ CosineTree::CosineTree(const arma::mat& dataset,
     currentNode = treeQueue.top();
     treeQueue.pop();
 
+    // Remove its basis vector from the basis (the last column takes its place).
+    const size_t position = std::find(basisNodes.begin(), basisNodes.end(),
+        currentNode) - basisNodes.begin();
+    queueBasis.col(position) = queueBasis.col(basisSize - 1);
+    basisNodes[position] = basisNodes.back();
+    basisNodes.pop_back();
+    --basisSize;
+
     // Split the node into left and right children.
     currentNode->CosineNodeSplit();
 
@@ -103,27 +124,40 @@ CosineTree::CosineTree(const arma::mat& dataset,
     currentLeft = currentNode->Left();
     currentRight = currentNode->Right();
 
-    // Calculate basis vectors of left and right children.
+    // Make room for the basis vectors of the children.
+    if (basisSize + 2 > queueBasis.n_cols)
+      queueBasis.resize(dataset.n_rows, 2 * (basisSize + 2));
+
+    // Calculate basis vectors of left and right children; the basis vector of
+    // the right child is also orthogonal to the one of the left child.
     arma::vec lBasisVector, rBasisVector;
 
-    ModifiedGramSchmidt(treeQueue, currentLeft->Centroid(), lBasisVector);
-    ModifiedGramSchmidt(treeQueue, currentRight->Centroid(), rBasisVector,
-                        &lBasisVector);
+    ModifiedGramSchmidt(arma::mat(queueBasis.memptr(), dataset.n_rows,
+        basisSize, false, true), currentLeft->Centroid(), lBasisVector);
+    queueBasis.col(basisSize) = lBasisVector;
+    ModifiedGramSchmidt(arma::mat(queueBasis.memptr(), dataset.n_rows,
+        basisSize + 1, false, true), currentRight->Centroid(), rBasisVector);
+    queueBasis.col(basisSize + 1) = rBasisVector;
+    basisNodes.push_back(currentLeft);
+    basisNodes.push_back(currentRight);
+    basisSize += 2;
 
     // Add basis vectors to their respective nodes.
     currentLeft->BasisVector(lBasisVector);
     currentRight->BasisVector(rBasisVector);
 
     // Calculate Monte Carlo error estimates for child nodes.
-    MonteCarloError(currentLeft, treeQueue, &lBasisVector, &rBasisVector);
-    MonteCarloError(currentRight, treeQueue, &lBasisVector, &rBasisVector);
+    const arma::mat currentBasis(queueBasis.memptr(), dataset.n_rows,
+        basisSize, false, true);
+    MonteCarloError(currentLeft, currentBasis);
+    MonteCarloError(currentRight, currentBasis);
 
     // Push child nodes into the priority queue.
     treeQueue.push(currentLeft);
     treeQueue.push(currentRight);
 
     // Calculate Monte Carlo error estimate for the root node.
-    monteCarloError = MonteCarloError(&root, treeQueue);
+    monteCarloError = MonteCarloError(&root, currentBasis);
   }
 
   // Construct the subspace basis from the current priority queue.
@@ -143,28 +177,26 @@ void CosineTree::ModifiedGramSchmidt(CosineNodeQueue& treeQueue,
                                      arma::vec& newBasisVector,
                                      arma::vec* addBasisVector)
 {
-  // Set new basis vector to centroid.
-  newBasisVector = centroid;
-
-  // Variables for iterating throught the priority queue.
-  CosineTree *currentNode;
-  CosineNodeQueue::const_iterator i = treeQueue.begin();
+  arma::mat currentBasis;
+  QueueBasis(treeQueue, currentBasis, addBasisVector);
 
-  // For every vector in the current basis, remove its projection from the
-  // centroid.
-  for ( ; i != treeQueue.end(); i++)
-  {
-    currentNode = *i;
+  ModifiedGramSchmidt(currentBasis, centroid, newBasisVector);
+}
 
-    double projection = arma::dot(currentNode->BasisVector(), centroid);
-    newBasisVector -= projection * currentNode->BasisVector();
-  }
+void CosineTree::ModifiedGramSchmidt(const arma::mat& currentBasis,
+                                     const arma::vec& centroid,
+                                     arma::vec& newBasisVector)
+{
+  // Set new basis vector to centroid.
+  newBasisVector = centroid;
 
-  // If additional basis vector is passed, take it into account.
-  if (addBasisVector)
+  // Remove the projection of the centroid on the current basis, with two
+  // matrix-vector products.  The projection is removed twice, so that the new
+  // basis vector stays orthogonal to the basis despite rounding errors.
+  if (currentBasis.n_cols > 0)
   {
-    double projection = arma::dot(*addBasisVector, centroid);
-    newBasisVector -= *addBasisVector * projection;
+    for (size_t pass = 0; pass < 2; ++pass)
+      newBasisVector -= currentBasis * (trans(currentBasis) * newBasisVector);
   }
 
   // Normalize the modified centroid vector.
@@ -176,6 +208,19 @@ double CosineTree::MonteCarloError(CosineTree* node,
                                    CosineNodeQueue& treeQueue,
                                    arma::vec* addBasisVector1,
                                    arma::vec* addBasisVector2)
+{
+  // The additional basis vectors are only used if both are passed.
+  arma::mat currentBasis;
+  if (addBasisVector1 && addBasisVector2)
+    QueueBasis(treeQueue, currentBasis, addBasisVector1, addBasisVector2);
+  else
+    QueueBasis(treeQueue, currentBasis);
+
+  return MonteCarloError(node, currentBasis);
+}
+
+double CosineTree::MonteCarloError(CosineTree* node,
+                                   const arma::mat& currentBasis)
 {
   std::vector<size_t> sampledIndices;
   arma::vec probabilities;
@@ -185,55 +230,24 @@ double CosineTree::MonteCarloError(CosineTree* node,
   size_t numSamples = log(node->NumColumns()) + 1;
   node->ColumnSamplesLS(sampledIndices, probabilities, numSamples);
 
-  // Get pointer to the original dataset.
-  arma::mat dataset = node->GetDataset();
+  // Get the original dataset.
+  const arma::mat& dataset = node->GetDataset();
 
-  // Initialize weighted projection magnitudes as zeros.
-  arma::vec weightedMagnitudes;
-  weightedMagnitudes.zeros(numSamples);
+  // Project all the samples onto the current basis with one matrix product,
+  // and weight the squared norms of the projections.
+  arma::mat samples(dataset.n_rows, numSamples);
+  for (size_t i = 0; i < numSamples; i++)
+    samples.col(i) = dataset.col(sampledIndices[i]);
 
-  // Set size of projection vector, depending on whether additional basis
-  // vectors are passed.
-  size_t projectionSize;
-  if (addBasisVector1 && addBasisVector2)
-    projectionSize = treeQueue.size() + 2;
+  arma::vec weightedMagnitudes;
+  if (currentBasis.n_cols > 0)
+  {
+    weightedMagnitudes = trans(arma::sum(arma::square(trans(currentBasis) *
+        samples))) / probabilities;
+  }
   else
-    projectionSize = treeQueue.size();
-
-  // For each sample, calculate the weighted projection onto the current basis.
-  for (size_t i = 0; i < numSamples; i++)
   {
-    // Initialize projection as a vector of zeros.
-    arma::vec projection;
-    projection.zeros(projectionSize);
-
-    CosineTree *currentNode;
-    CosineNodeQueue::const_iterator j = treeQueue.begin();
-
-    size_t k = 0;
-    // Compute the projection of the sampled vector onto the existing subspace.
-    for ( ; j != treeQueue.end(); j++, k++)
-    {
-      currentNode = *j;
-
-      projection(k) = arma::dot(dataset.col(sampledIndices[i]),
-                                currentNode->BasisVector());
-    }
-    // If two additional vectors are passed, take their projections.
-    if (addBasisVector1 && addBasisVector2)
-    {
-      projection(k++) = arma::dot(dataset.col(sampledIndices[i]),
-                                  *addBasisVector1);
-      projection(k) = arma::dot(dataset.col(sampledIndices[i]),
-                                *addBasisVector2);
-    }
-
-    // Calculate the Frobenius norm squared of the projected vector.
-    double frobProjection = arma::norm(projection, "frob");
-    double frobProjectionSquared = frobProjection * frobProjection;
-
-    // Calculate the weighted projection magnitude.
-    weightedMagnitudes(i) = frobProjectionSquared / probabilities(i);
+    weightedMagnitudes.zeros(numSamples);
   }
 
   // Compute mean and standard deviation of the weighted samples.
@@ -275,6 +289,26 @@ void CosineTree::ConstructBasis(CosineNodeQueue& treeQueue)
   }
 }
 
+void CosineTree::QueueBasis(const CosineNodeQueue& treeQueue,
+                            arma::mat& currentBasis,
+                            const arma::vec* addBasisVector1,
+                            const arma::vec* addBasisVector2) const
+{
+  const size_t numAdded = (addBasisVector1 ? 1 : 0) +
+      (addBasisVector2 ? 1 : 0);
+  currentBasis.set_size(dataset.n_rows, treeQueue.size() + numAdded);
+
+  size_t j = 0;
+  CosineNodeQueue::const_iterator i = treeQueue.begin();
+  for ( ; i != treeQueue.end(); i++, j++)
+    currentBasis.col(j) = (*i)->BasisVector();
+
+  if (addBasisVector1)
+    currentBasis.col(j++) = *addBasisVector1;
+  if (addBasisVector2)
+    currentBasis.col(j) = *addBasisVector2;
+}
+
 void CosineTree::CosineNodeSplit()
 {
   //! If less than two nodes, splitting does not make sense.
@@ -403,32 +437,42 @@ void CosineTree::CalculateCosines(arma::vec& cosines)
   // Initialize cosine vector as a vector of zeros.
   cosines.zeros(numColumns);
 
-  for (size_t i = 0; i < numColumns; i++)
+  const arma::vec splitPoint = dataset.col(indices[splitPointIndex]);
+
+  // The cosines of blocks of columns are calculated in parallel.
+  const size_t blocks = (numColumns + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
   {
-    // If norm is zero, store cosine value as zero. Else, calculate cosine value
-    // between two vectors.
-    if (l2NormsSquared(i) == 0)
+    const size_t end = std::min((b + 1) * BlockSize, numColumns);
+    for (size_t i = b * BlockSize; i < end; i++)
     {
-      cosines(i) = 0;
+      // If norm is zero, store cosine value as zero. Else, calculate cosine
+      // value between two vectors.
+      if (l2NormsSquared(i) != 0)
+        cosines(i) = arma::norm_dot(splitPoint, dataset.col(indices[i]));
     }
-    else
-    {
-      cosines(i) = arma::norm_dot(dataset.col(indices[splitPointIndex]),
-                                  dataset.col(indices[i]));
-    }
-  }
+  });
 }
 
 void CosineTree::CalculateCentroid()
 {
-  // Initialize centroid as vector of zeros.
-  centroid.zeros(dataset.n_rows);
+  // Each thread sums the columns of its own range, and then the sums of the
+  // ranges are added.
+  const size_t ranges = std::max((size_t) 1, std::min(ThreadPool::Threads(),
+      numColumns / BlockSize));
+  std::vector<arma::vec> sums(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    sums[r].zeros(dataset.n_rows);
+    const size_t end = (r + 1) * numColumns / ranges;
+    for (size_t i = r * numColumns / ranges; i < end; i++)
+      sums[r] += dataset.col(indices[i]);
+  });
 
   // Calculate centroid of columns in the node.
-  for (size_t i = 0; i < numColumns; i++)
-  {
-    centroid += dataset.col(indices[i]);
-  }
+  centroid = sums[0];
+  for (size_t r = 1; r < ranges; r++)
+    centroid += sums[r];
   centroid /= numColumns;
 }
 
@@ -82,6 +82,19 @@ class CosineTree
                            arma::vec& newBasisVector,
                            arma::vec* addBasisVector = NULL);
 
+  /**
+   * Calculates the orthonormalization of the passed centroid, with respect to
+   * the subspace spanned by the given orthonormal basis vectors, with
+   * matrix-vector products.
+   *
+   * @param currentBasis Matrix whose columns are the current basis vectors.
+   * @param centroid Centroid of the node being added to the basis.
+   * @param newBasisVector Orthonormalized centroid of the node.
+   */
+  void ModifiedGramSchmidt(const arma::mat& currentBasis,
+                           const arma::vec& centroid,
+                           arma::vec& newBasisVector);
+
   /**
    * Estimates the squared error of the projection of the input node's matrix
    * onto the current vector subspace. A normal distribution is fit using
@@ -99,6 +112,16 @@ class CosineTree
                          arma::vec* addBasisVector1 = NULL,
                          arma::vec* addBasisVector2 = NULL);
 
+  /**
+   * Estimates the squared error of the projection of the input node's matrix
+   * onto the subspace spanned by the given orthonormal basis vectors.  The
+   * samples are projected onto the basis with one matrix product.
+   *
+   * @param node Node for which Monte Carlo estimate is calculated.
+   * @param currentBasis Matrix whose columns are the current basis vectors.
+   */
+  double MonteCarloError(CosineTree* node, const arma::mat& currentBasis);
+
   /**
    * Constructs the final basis matrix, after the cosine tree construction.
    *
@@ -148,7 +171,8 @@ class CosineTree
   /**
    * Calculate cosines of the columns present in the node, with respect to the
    * sampled splitting point. The calculated cosine values are useful for
-   * splitting the node into its children.
+   * splitting the node into its children.  Blocks of columns are processed in
+   * parallel.
    *
    * @param cosines Vector to store the cosine values in.
    */
@@ -157,6 +181,7 @@ class CosineTree
   /**
    * Calculate centroid of the columns present in the node. The calculated
    * centroid is used as a basis vector for the cosine tree being constructed.
+   * Ranges of columns are summed in parallel.
    */
   void CalculateCentroid();
 
@@ -236,6 +261,16 @@ class CosineTree
   double l2Error;
   //! Frobenius norm squared of columns in the node.
   double frobNormSquared;
+
+  //! The number of columns processed together by a thread.
+  static const size_t BlockSize = 1024;
+
+  //! Store the basis vectors of the nodes in the queue (followed by the given
+  //! additional basis vectors) as the columns of currentBasis.
+  void QueueBasis(const CosineNodeQueue& treeQueue,
+                  arma::mat& currentBasis,
+                  const arma::vec* addBasisVector1 = NULL,
+                  const arma::vec* addBasisVector2 = NULL) const;
 };
 
 class CompareCosineNode
@@ -9,6 +9,7 @@
 
 #include <mlpack/core.hpp>
 
+#include "../node_arena.hpp"
 #include "../statistic.hpp"
 #include "first_point_is_root.hpp"
 
@@ -88,7 +89,8 @@ template<typename MetricType = metric::LMetric<2, true>,
          typename StatisticType = EmptyStatistic,
          typename MatType = arma::mat,
          typename RootPointPolicy = FirstPointIsRoot>
-class CoverTree
+class CoverTree :
+    public NodeAllocation
 {
  public:
   //! So that other classes can access the matrix type.
@@ -222,6 +224,14 @@ class CoverTree
    */
   CoverTree(const CoverTree& other);
 
+  /**
+   * Move constructor for a CoverTree; possess all the members of the given
+   * tree.
+   *
+   * @param other Cover tree to move from.
+   */
+  CoverTree(CoverTree&& other);
+
   /**
    * Create a cover tree from a boost::serialization archive.
    */
@@ -302,11 +312,12 @@ class CoverTree
   ElemType MinDistance(const CoverTree* other, const ElemType distance) const;
 
   //! Return the minimum distance to another point.
-  ElemType MinDistance(const arma::vec& other) const;
+  ElemType MinDistance(const arma::Col<ElemType>& other) const;
 
   //! Return the minimum distance to another point given that the distance from
   //! the center to the point has already been calculated.
-  ElemType MinDistance(const arma::vec& other, const ElemType distance) const;
+  ElemType MinDistance(const arma::Col<ElemType>& other,
+                       const ElemType distance) const;
 
   //! Return the maximum distance to another node.
   ElemType MaxDistance(const CoverTree* other) const;
@@ -316,11 +327,12 @@ class CoverTree
   ElemType MaxDistance(const CoverTree* other, const ElemType distance) const;
 
   //! Return the maximum distance to another point.
-  ElemType MaxDistance(const arma::vec& other) const;
+  ElemType MaxDistance(const arma::Col<ElemType>& other) const;
 
   //! Return the maximum distance to another point given that the distance from
   //! the center to the point has already been calculated.
-  ElemType MaxDistance(const arma::vec& other, const ElemType distance) const;
+  ElemType MaxDistance(const arma::Col<ElemType>& other,
+                       const ElemType distance) const;
 
   //! Return the minimum and maximum distance to another node.
   math::RangeType<ElemType> RangeDistance(const CoverTree* other) const;
@@ -331,11 +343,12 @@ class CoverTree
                                           const ElemType distance) const;
 
   //! Return the minimum and maximum distance to another point.
-  math::RangeType<ElemType> RangeDistance(const arma::vec& other) const;
+  math::RangeType<ElemType> RangeDistance(const arma::Col<ElemType>& other)
+      const;
 
   //! Return the minimum and maximum distance to another point given that the
   //! point-to-point distance has already been calculated.
-  math::RangeType<ElemType> RangeDistance(const arma::vec& other,
+  math::RangeType<ElemType> RangeDistance(const arma::Col<ElemType>& other,
                                           const ElemType distance) const;
 
   //! Returns true: this tree does have self-children.
@@ -366,14 +379,38 @@ class CoverTree
   ElemType MinimumBoundDistance() const { return furthestDescendantDistance; }
 
   //! Get the center of the node and store it in the given vector.
-  void Center(arma::vec& center) const
+  void Center(arma::Col<ElemType>& center) const
   {
-    center = arma::vec(dataset->col(point));
+    center = arma::Col<ElemType>(dataset->col(point));
   }
 
   //! Get the instantiated metric.
   MetricType& Metric() const { return *metric; }
 
+  /**
+   * Compact the tree, so that all of the descendants of this node are stored
+   * contiguously in a single array instead of in separate heap allocations.
+   * The children of each node are placed next to each other, followed by the
+   * (similarly laid out) subtree of each child in turn, so the children a
+   * traversal scores together and then descends into are adjacent in memory.
+   * Implicit nodes (nodes with only a self-child) are already removed when the
+   * tree is built, so only explicit nodes are stored.  The structure of the
+   * tree does not change, so all of the traversers can be used exactly as
+   * before.
+   *
+   * This can only be called on the root of the tree, and the tree structure
+   * should be treated as read-only afterwards: individual compacted nodes must
+   * never be deleted or replaced.  Any pointers or references to nodes other
+   * than the root are invalidated.  Calling this on a tree that has already
+   * been compacted does nothing.  The array is allocated from the current
+   * NodeArena of the thread, if there is one.
+   */
+  void Compact();
+
+  //! Return whether the descendants of this node are stored compactly (this is
+  //! only ever true for the root of a tree that has been compacted).
+  bool IsCompact() const { return compactNodes != NULL; }
+
  private:
   //! Reference to the matrix which this tree is built on.
   const MatType* dataset;
@@ -401,6 +438,11 @@ class CoverTree
   bool localDataset;
   //! The metric used for this tree.
   MetricType* metric;
+  //! If the tree has been compacted (and we are the root), this holds every
+  //! descendant node contiguously.
+  CoverTree* compactNodes;
+  //! The number of nodes held in compactNodes.
+  size_t numCompactNodes;
 
   /**
    * Create the children for this node.
@@ -415,7 +457,9 @@ class CoverTree
    * Fill the vector of distances with the distances between the point specified
    * by pointIndex and each point in the indices array.  The distances of the
    * first pointSetSize points in indices are calculated (so, this does not
-   * necessarily need to use all of the points in the arrays).
+   * necessarily need to use all of the points in the arrays).  Large dense
+   * point sets are computed in parallel with OpenMP, so MetricType::Evaluate()
+   * must be safe to call from several threads at once.
    *
    * @param pointIndex Point to build the distances for.
    * @param indices List of indices to compute distances for.
@@ -490,6 +534,18 @@ class CoverTree
    */
   void RemoveNewImplicitNodes();
 
+  /**
+   * Move the children of the given node next to each other into compactNodes,
+   * and then, recursively, the descendants of each child.  This is only called
+   * on the root.
+   *
+   * @param node Node whose children should be moved.
+   */
+  void CompactChildren(CoverTree& node);
+
+  //! Destroy and deallocate the compacted descendants of the root.
+  void DeleteCompactNodes();
+
  protected:
   /**
    * A default constructor.  This is meant to only be used with
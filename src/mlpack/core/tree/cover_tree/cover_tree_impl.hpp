@@ -11,6 +11,8 @@
 #include "cover_tree.hpp"
 
 #include <string>
+#include <queue>
+#include <new>
 
 namespace mlpack {
 namespace tree {
@@ -37,6 +39,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     localMetric(metric == NULL),
     localDataset(false),
     metric(metric),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // If we need to create a metric, do that.  We'll just do it on the heap.
@@ -126,6 +130,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     localMetric(false),
     localDataset(false),
     metric(&metric),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // If there is only one point or zero points in the dataset... uh, we're done.
@@ -210,6 +216,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(true),
     localDataset(true),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // We need to create a metric.  We'll just do it on the heap.
@@ -298,6 +306,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     localMetric(false),
     localDataset(true),
     metric(&metric),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // If there is only one point or zero points in the dataset... uh, we're done.
@@ -392,6 +402,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     localMetric(false),
     localDataset(false),
     metric(&metric),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // If the size of the near set is 0, this is a leaf.
@@ -437,6 +449,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     localMetric(metric == NULL),
     localDataset(false),
     metric(metric),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // If necessary, create a local metric.
@@ -467,6 +481,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     localMetric(false),
     localDataset(other.parent == NULL),
     metric(other.metric),
+    compactNodes(NULL),
+    numCompactNodes(0),
     distanceComps(0)
 {
   // Copy each child by hand.
@@ -478,6 +494,51 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   }
 }
 
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
+    CoverTree&& other) :
+    dataset(other.dataset),
+    point(other.point),
+    children(std::move(other.children)),
+    scale(other.scale),
+    base(other.base),
+    stat(std::move(other.stat)),
+    numDescendants(other.numDescendants),
+    parent(other.parent),
+    parentDistance(other.parentDistance),
+    furthestDescendantDistance(other.furthestDescendantDistance),
+    localMetric(other.localMetric),
+    localDataset(other.localDataset),
+    metric(other.metric),
+    compactNodes(other.compactNodes),
+    numCompactNodes(other.numCompactNodes),
+    distanceComps(other.distanceComps)
+{
+  // The children now belong to us.
+  for (size_t i = 0; i < children.size(); ++i)
+    children[i]->Parent() = this;
+
+  // Clear the other tree's contents, so it doesn't delete anything when it is
+  // destructed.
+  other.children.clear();
+  other.numDescendants = 0;
+  other.parent = NULL;
+  other.parentDistance = 0.0;
+  other.furthestDescendantDistance = 0.0;
+  other.localMetric = false;
+  other.localDataset = false;
+  other.metric = NULL;
+  other.dataset = NULL;
+  other.compactNodes = NULL;
+  other.numCompactNodes = 0;
+  other.distanceComps = 0;
+}
+
 // Construct from a boost::serialization archive.
 template<
     typename MetricType,
@@ -504,6 +565,11 @@ template<
 >
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::~CoverTree()
 {
+  // If the tree has been compacted, the descendants must not be deleted one by
+  // one.
+  if (compactNodes)
+    DeleteCompactNodes();
+
   // Delete each child.
   for (size_t i = 0; i < children.size(); ++i)
     delete children[i];
@@ -577,7 +643,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   // Every cover tree node will contain points up to base^(scale + 1) away.
   return std::max(metric->Evaluate(dataset->col(point),
       other->Dataset().col(other->Point())) -
-      furthestDescendantDistance - other->FurthestDescendantDistance(), 0.0);
+      furthestDescendantDistance - other->FurthestDescendantDistance(),
+      (ElemType) 0);
 }
 
 template<
@@ -593,7 +660,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
 {
   // We already have the distance as evaluated by the metric.
   return std::max(distance - furthestDescendantDistance -
-      other->FurthestDescendantDistance(), 0.0);
+      other->FurthestDescendantDistance(), (ElemType) 0);
 }
 
 template<
@@ -605,10 +672,10 @@ template<
 typename CoverTree<MetricType, StatisticType, MatType,
     RootPointPolicy>::ElemType
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    MinDistance(const arma::vec& other) const
+    MinDistance(const arma::Col<ElemType>& other) const
 {
   return std::max(metric->Evaluate(dataset->col(point), other) -
-      furthestDescendantDistance, 0.0);
+      furthestDescendantDistance, (ElemType) 0);
 }
 
 template<
@@ -620,9 +687,10 @@ template<
 typename CoverTree<MetricType, StatisticType, MatType,
     RootPointPolicy>::ElemType
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    MinDistance(const arma::vec& /* other */, const ElemType distance) const
+    MinDistance(const arma::Col<ElemType>& /* other */,
+                const ElemType distance) const
 {
-  return std::max(distance - furthestDescendantDistance, 0.0);
+  return std::max(distance - furthestDescendantDistance, (ElemType) 0);
 }
 
 template<
@@ -666,7 +734,7 @@ template<
 typename CoverTree<MetricType, StatisticType, MatType,
     RootPointPolicy>::ElemType
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    MaxDistance(const arma::vec& other) const
+    MaxDistance(const arma::Col<ElemType>& other) const
 {
   return metric->Evaluate(dataset->col(point), other) +
       furthestDescendantDistance;
@@ -681,7 +749,8 @@ template<
 typename CoverTree<MetricType, StatisticType, MatType,
     RootPointPolicy>::ElemType
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    MaxDistance(const arma::vec& /* other */, const ElemType distance) const
+    MaxDistance(const arma::Col<ElemType>& /* other */,
+                const ElemType distance) const
 {
   return distance + furthestDescendantDistance;
 }
@@ -743,7 +812,7 @@ template<
 math::RangeType<typename
     CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::ElemType>
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    RangeDistance(const arma::vec& other) const
+    RangeDistance(const arma::Col<ElemType>& other) const
 {
   const ElemType distance = metric->Evaluate(dataset->col(point), other);
 
@@ -762,7 +831,7 @@ template<
 math::RangeType<typename
     CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::ElemType>
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    RangeDistance(const arma::vec& /* other */,
+    RangeDistance(const arma::Col<ElemType>& /* other */,
                   const ElemType distance) const
 {
   return math::RangeType<ElemType>(distance - furthestDescendantDistance,
@@ -1036,9 +1105,13 @@ void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
                      const size_t pointSetSize)
 {
   // For each point, rebuild the distances.  The indices do not need to be
-  // modified.
+  // modified.  Near the top of the tree the point sets are large, and this is
+  // where most of the construction time is spent, so large sets of dense points
+  // are done in parallel.  (Nested parallel regions run with one thread.)
   distanceComps += pointSetSize;
-  for (size_t i = 0; i < pointSetSize; ++i)
+  #pragma omp parallel for if (!arma::is_arma_sparse_type<MatType>::value && \
+      pointSetSize >= 16384)
+  for (omp_size_t i = 0; i < (omp_size_t) pointSetSize; ++i)
   {
     distances[i] = metric->Evaluate(dataset->col(pointIndex),
         dataset->col(indices[i]));
@@ -1335,6 +1408,105 @@ inline void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   }
 }
 
+/**
+ * Move all of the descendants of the root into one contiguous array.
+ */
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::Compact()
+{
+  if (parent != NULL)
+    throw std::invalid_argument("CoverTree::Compact(): can only be called on "
+        "the root of the tree");
+
+  // Nothing to do if we have been compacted already.
+  if (compactNodes)
+    return;
+
+  // Count the number of descendant nodes.
+  size_t numNodes = 0;
+  std::queue<CoverTree*> queue;
+  queue.push(this);
+  while (!queue.empty())
+  {
+    CoverTree* node = queue.front();
+    queue.pop();
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+    {
+      ++numNodes;
+      queue.push(&node->Child(i));
+    }
+  }
+
+  // A single leaf has no descendants to move.
+  if (numNodes == 0)
+    return;
+
+  // The nodes are move-constructed into raw memory, so that no default
+  // constructed nodes have to be built first.  The memory comes from the
+  // current NodeArena, if there is one.
+  compactNodes = static_cast<CoverTree*>(
+      NodeArena::AllocateNode(numNodes * sizeof(CoverTree)));
+  numCompactNodes = 0;
+
+  CompactChildren(*this);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+    CompactChildren(CoverTree& node)
+{
+  // First place all the children next to each other.  After the move, each old
+  // node holds no children, metric or dataset, so it is safe to delete.  (The
+  // move constructor points the grandchildren at the new node.)
+  CoverTree* first = compactNodes + numCompactNodes;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    CoverTree* oldChild = node.children[i];
+    node.children[i] = new (compactNodes + numCompactNodes++)
+        CoverTree(std::move(*oldChild));
+    node.children[i]->parent = &node;
+    delete oldChild;
+  }
+
+  // Then the subtree of each child.
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    CompactChildren(first[i]);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+    DeleteCompactNodes()
+{
+  // Sever the links between the compacted nodes first, so that their
+  // destructors don't try to delete each other.
+  for (size_t i = 0; i < numCompactNodes; ++i)
+    compactNodes[i].children.clear();
+
+  for (size_t i = 0; i < numCompactNodes; ++i)
+    compactNodes[i].~CoverTree();
+  NodeArena::FreeNode(compactNodes);
+
+  compactNodes = NULL;
+  numCompactNodes = 0;
+  children.clear();
+}
+
 /**
  * Default constructor, only for use with boost::serialization.
  */
@@ -1355,7 +1527,10 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree() :
     furthestDescendantDistance(0.0),
     localMetric(false),
     localDataset(false),
-    metric(NULL)
+    metric(NULL),
+    compactNodes(NULL),
+    numCompactNodes(0),
+    distanceComps(0)
 {
   // Nothing to do.
 }
@@ -1380,6 +1555,8 @@ void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::Serialize(
   // also need to delete the local metric and dataset.
   if (Archive::is_loading::value)
   {
+    if (compactNodes)
+      DeleteCompactNodes();
     for (size_t i = 0; i < children.size(); ++i)
       delete children[i];
 
@@ -8,6 +8,7 @@
 #define MLPACK_CORE_TREE_COVER_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
 #include <queue>
 
 namespace mlpack {
@@ -50,7 +51,7 @@ class CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
 
  private:
   //! The instantiated rule set for pruning branches.
-  RuleType& rule;
+  TraversalRules<RuleType> rule;
 
   //! The number of pruned nodes.
   size_t numPrunes;
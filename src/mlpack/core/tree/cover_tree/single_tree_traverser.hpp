@@ -10,6 +10,7 @@
 #define MLPACK_CORE_TREE_COVER_TREE_SINGLE_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
 
 #include "cover_tree.hpp"
 
@@ -41,6 +42,27 @@ class CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
    */
   void Traverse(const size_t queryIndex, CoverTree& referenceNode);
 
+  /**
+   * Traverse the tree with each of the query points with indices in
+   * [begin, begin + count).  With OpenMP, the query points are split between
+   * the threads, and each thread traverses the tree with its own copy of the
+   * rules; the base case and score counts of the copies are added back to the
+   * rules afterwards.  This requires that RuleType can be copied, that its
+   * BaseCases() and Scores() counters can be modified, and that the results for
+   * different query points do not depend on each other (which is the case for
+   * all of the mlpack single-tree rules that store their results per query
+   * point).  In addition, RuleType::Score() must not keep state for a query
+   * point in the reference tree, because the reference tree is shared between
+   * the threads.
+   *
+   * @param begin Index of the first query point.
+   * @param count Number of query points.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t begin,
+                const size_t count,
+                CoverTree& referenceNode);
+
   //! Get the number of prunes so far.
   size_t NumPrunes() const { return numPrunes; }
   //! Set the number of prunes (good for a reset to 0).
@@ -48,7 +70,7 @@ class CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
 
  private:
   //! Reference to the rules with which the tree will be traversed.
-  RuleType& rule;
+  TraversalRules<RuleType> rule;
 
   //! The number of nodes which have been pruned during traversal.
   size_t numPrunes;
@@ -230,6 +230,59 @@ SingleTreeTraverser<RuleType>::Traverse(
   }
 }
 
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+template<typename RuleType>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+SingleTreeTraverser<RuleType>::Traverse(
+    const size_t begin,
+    const size_t count,
+    CoverTree& referenceNode)
+{
+  // Copying the rules for each thread is only worth it if there are actually
+  // several threads to use.
+  bool parallel = false;
+  #ifdef _OPENMP
+    parallel = (count > 1) && !omp_in_parallel() && (omp_get_max_threads() > 1);
+  #endif
+
+  if (!parallel)
+  {
+    for (size_t i = begin; i < begin + count; ++i)
+      Traverse(i, referenceNode);
+
+    return;
+  }
+
+  size_t prunes = 0, baseCases = 0, scores = 0;
+  #pragma omp parallel reduction(+:prunes, baseCases, scores)
+  {
+    RuleType threadRule(rule);
+    threadRule.BaseCases() = 0;
+    threadRule.Scores() = 0;
+
+    SingleTreeTraverser<RuleType> traverser(threadRule);
+
+    // The cost of each query point varies a lot, so use dynamic scheduling.
+    #pragma omp for schedule(dynamic, 16)
+    for (omp_size_t i = (omp_size_t) begin; i < (omp_size_t) (begin + count);
+        ++i)
+      traverser.Traverse(i, referenceNode);
+
+    prunes += traverser.NumPrunes();
+    baseCases += threadRule.BaseCases();
+    scores += threadRule.Scores();
+  }
+
+  numPrunes += prunes;
+  rule.BaseCases() += baseCases;
+  rule.Scores() += scores;
+}
+
 } // namespace tree
 } // namespace mlpack
 
@@ -13,6 +13,7 @@
 #include <mlpack/core/math/range.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "bound_traits.hpp"
+#include "node_arena.hpp"
 
 namespace mlpack {
 namespace bound {
@@ -34,7 +35,96 @@ struct IsLMetric<metric::LMetric<Power, TakeRoot>>
   static const bool Value = true;
 };
 
-} // namespace util
+/**
+ * Utility struct to raise non-negative values to the power of an LMetric, and
+ * to take the corresponding root.  The specializations for the L1 and L2
+ * metrics avoid calls to pow(), which would otherwise dominate the cost of the
+ * bound distance calculations.
+ */
+template<int Power>
+struct PowerOf
+{
+  //! Return value^Power.
+  template<typename ElemType>
+  static ElemType Raise(const ElemType value)
+  { return (ElemType) pow(value, (ElemType) Power); }
+
+  //! Return the Power'th root of value.
+  template<typename ElemType>
+  static ElemType Root(const ElemType value)
+  { return (ElemType) pow((double) value, 1.0 / (double) Power); }
+};
+
+//! Specialization of PowerOf for the L1 metric.
+template<>
+struct PowerOf<1>
+{
+  template<typename ElemType>
+  static ElemType Raise(const ElemType value) { return value; }
+
+  template<typename ElemType>
+  static ElemType Root(const ElemType value) { return value; }
+};
+
+//! Specialization of PowerOf for the L2 metric.
+template<>
+struct PowerOf<2>
+{
+  template<typename ElemType>
+  static ElemType Raise(const ElemType value) { return value * value; }
+
+  template<typename ElemType>
+  static ElemType Root(const ElemType value)
+  { return (ElemType) sqrt((double) value); }
+};
+
+/**
+ * Utility class to read the elements of a point in increasing order of their
+ * dimension.  For dense points this is simple element access.
+ */
+template<typename VecType, bool Sparse = IsSparseColumn<VecType>::value>
+class PointReader
+{
+ public:
+  PointReader(const VecType& point) : point(point) { }
+
+  //! Return the element of the given dimension.
+  typename VecType::elem_type operator()(const size_t d) const
+  { return point[d]; }
+
+ private:
+  const VecType& point;
+};
+
+/**
+ * For sparse points, looking up each element would take O(log nnz) time, so
+ * the nonzero elements are walked with an iterator instead, and the whole point
+ * is read in O(dim + nnz) time.  The dimensions must be read in increasing
+ * order.
+ */
+template<typename VecType>
+class PointReader<VecType, true>
+{
+ public:
+  PointReader(const VecType& point) : it(point.begin()), end(point.end()) { }
+
+  //! Return the element of the given dimension.
+  typename VecType::elem_type operator()(const size_t d)
+  {
+    if (it == end || it.row() != d)
+      return 0;
+
+    const typename VecType::elem_type value = (*it);
+    ++it;
+    return value;
+  }
+
+ private:
+  typename VecType::const_iterator it;
+  const typename VecType::const_iterator end;
+};
+
+} // namespace meta
 
 /**
  * Hyper-rectangle bound for an L-metric.  This should be used in conjunction
@@ -126,6 +216,19 @@ class HRectBound
    */
   ElemType MinDistance(const HRectBound& other) const;
 
+  /**
+   * Calculates the minimum bound-to-bound distance to each of the given bounds,
+   * for instance the bounds of all the children of a reference node.  The
+   * results are the same as calling MinDistance() on each bound, but each
+   * dimension of this bound is only loaded once, and the inner loop over the
+   * other bounds has no branches.
+   *
+   * @param others Bounds to which the minimum distances are requested.
+   * @param distances Vector to store the distances in.
+   */
+  void MinDistance(const std::vector<const HRectBound*>& others,
+                   arma::Col<ElemType>& distances) const;
+
   /**
    * Calculates maximum bound-to-point squared distance.
    *
@@ -200,6 +303,14 @@ class HRectBound
   math::RangeType<ElemType>* bounds;
   //! Cached minimum width of bound.
   ElemType minWidth;
+
+  //! Allocate the bounds of the given number of dimensions, from the current
+  //! NodeArena of the thread if there is one (so that the bounds of the nodes
+  //! of a tree are allocated with the nodes), and from the heap otherwise.
+  static math::RangeType<ElemType>* AllocateBounds(const size_t dim);
+
+  //! Free bounds allocated with AllocateBounds().
+  static void FreeBounds(math::RangeType<ElemType>* bounds, const size_t dim);
 };
 
 // A specialization of BoundTraits for this class.
@@ -34,7 +34,7 @@ inline HRectBound<MetricType, ElemType>::HRectBound() :
 template<typename MetricType, typename ElemType>
 inline HRectBound<MetricType, ElemType>::HRectBound(const size_t dimension) :
     dim(dimension),
-    bounds(new math::RangeType<ElemType>[dim]),
+    bounds(AllocateBounds(dim)),
     minWidth(0)
 { /* Nothing to do. */ }
 
@@ -45,7 +45,7 @@ template<typename MetricType, typename ElemType>
 inline HRectBound<MetricType, ElemType>::HRectBound(
     const HRectBound<MetricType, ElemType>& other) :
     dim(other.Dim()),
-    bounds(new math::RangeType<ElemType>[dim]),
+    bounds(AllocateBounds(dim)),
     minWidth(other.MinWidth())
 {
   // Copy other bounds over.
@@ -63,11 +63,10 @@ inline HRectBound<MetricType, ElemType>& HRectBound<MetricType, ElemType>::opera
   if (dim != other.Dim())
   {
     // Reallocation is necessary.
-    if (bounds)
-      delete[] bounds;
+    FreeBounds(bounds, dim);
 
     dim = other.Dim();
-    bounds = new math::RangeType<ElemType>[dim];
+    bounds = AllocateBounds(dim);
   }
 
   // Now copy each of the bound values.
@@ -101,8 +100,7 @@ inline HRectBound<MetricType, ElemType>::HRectBound(
 template<typename MetricType, typename ElemType>
 inline HRectBound<MetricType, ElemType>::~HRectBound()
 {
-  if (bounds)
-    delete[] bounds;
+  FreeBounds(bounds, dim);
 }
 
 /**
@@ -159,65 +157,94 @@ inline ElemType HRectBound<MetricType, ElemType>::MinDistance(
 {
   Log::Assert(point.n_elem == dim);
 
-  ElemType sum = 0;
+  typedef meta::PowerOf<MetricType::Power> Power;
 
-  ElemType lower, higher;
+  meta::PointReader<VecType> reader(point);
+  ElemType sum = 0;
   for (size_t d = 0; d < dim; d++)
   {
-    lower = bounds[d].Lo() - point[d];
-    higher = point[d] - bounds[d].Hi();
-
-    // Since only one of 'lower' or 'higher' is negative, if we add each's
-    // absolute value to itself and then sum those two, our result is the
-    // nonnegative half of the equation times two; then we raise to power Power.
-    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)),
-        (ElemType) MetricType::Power);
+    // At most one of these can be positive, so the larger one (if positive) is
+    // the distance from the point to the bound in this dimension.  Using
+    // std::max() instead of comparisons keeps the loop free of branches.
+    const ElemType value = reader(d);
+    const ElemType lower = bounds[d].Lo() - value;
+    const ElemType higher = value - bounds[d].Hi();
+    sum += Power::Raise(std::max(std::max(lower, higher), (ElemType) 0));
   }
 
-  // Now take the Power'th root (but make sure our result is squared if it needs
-  // to be); then cancel out the constant of 2 (which may have been squared now)
-  // that was introduced earlier.  The compiler should optimize out the if
-  // statement entirely.
+  // The compiler should optimize out this if statement entirely.
   if (MetricType::TakeRoot)
-    return (ElemType) pow((double) sum, 1.0 / (double) MetricType::Power) / 2.0;
+    return Power::Root(sum);
   else
-    return sum / pow(2.0, MetricType::Power);
+    return sum;
 }
 
 /**
  * Calculates minimum bound-to-bound squared distance.
  */
 template<typename MetricType, typename ElemType>
-ElemType HRectBound<MetricType, ElemType>::MinDistance(const HRectBound& other)
-    const
+inline ElemType HRectBound<MetricType, ElemType>::MinDistance(
+    const HRectBound& other) const
 {
   Log::Assert(dim == other.dim);
 
-  ElemType sum = 0;
-  const math::RangeType<ElemType>* mbound = bounds;
-  const math::RangeType<ElemType>* obound = other.bounds;
+  typedef meta::PowerOf<MetricType::Power> Power;
 
-  ElemType lower, higher;
+  ElemType sum = 0;
   for (size_t d = 0; d < dim; d++)
   {
-    lower = obound->Lo() - mbound->Hi();
-    higher = mbound->Lo() - obound->Hi();
-    // We invoke the following:
-    //   x + fabs(x) = max(x * 2, 0)
-    //   (x * 2)^2 / 4 = x^2
-    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)),
-        (ElemType) MetricType::Power);
-
-    // Move bound pointers.
-    mbound++;
-    obound++;
+    // At most one of these is positive, unless one of the bounds is empty.
+    const ElemType lower = other.bounds[d].Lo() - bounds[d].Hi();
+    const ElemType higher = bounds[d].Lo() - other.bounds[d].Hi();
+    sum += Power::Raise(std::max(std::max(lower, higher), (ElemType) 0));
   }
 
   // The compiler should optimize out this if statement entirely.
   if (MetricType::TakeRoot)
-    return (ElemType) pow((double) sum, 1.0 / (double) MetricType::Power) / 2.0;
+    return Power::Root(sum);
   else
-    return sum / pow(2.0, MetricType::Power);
+    return sum;
+}
+
+/**
+ * Calculates minimum bound-to-bound distances to several bounds at once.
+ */
+template<typename MetricType, typename ElemType>
+void HRectBound<MetricType, ElemType>::MinDistance(
+    const std::vector<const HRectBound*>& others,
+    arma::Col<ElemType>& distances) const
+{
+  typedef meta::PowerOf<MetricType::Power> Power;
+
+  const size_t numBounds = others.size();
+  distances.zeros(numBounds);
+
+  // Each dimension of this bound is loaded once and compared against that
+  // dimension of every other bound.
+  std::vector<const math::RangeType<ElemType>*> otherBounds(numBounds);
+  for (size_t i = 0; i < numBounds; ++i)
+  {
+    Log::Assert(dim == others[i]->dim);
+    otherBounds[i] = others[i]->bounds;
+  }
+
+  ElemType* sums = distances.memptr();
+  for (size_t d = 0; d < dim; d++)
+  {
+    const ElemType lo = bounds[d].Lo();
+    const ElemType hi = bounds[d].Hi();
+    for (size_t i = 0; i < numBounds; ++i)
+    {
+      const ElemType lower = otherBounds[i][d].Lo() - hi;
+      const ElemType higher = lo - otherBounds[i][d].Hi();
+      sums[i] += Power::Raise(std::max(std::max(lower, higher), (ElemType) 0));
+    }
+  }
+
+  // The compiler should optimize out this if statement entirely.
+  if (MetricType::TakeRoot)
+    for (size_t i = 0; i < numBounds; ++i)
+      sums[i] = Power::Root(sums[i]);
 }
 
 /**
@@ -229,20 +256,23 @@ inline ElemType HRectBound<MetricType, ElemType>::MaxDistance(
     const VecType& point,
     typename boost::enable_if<IsVector<VecType> >* /* junk */) const
 {
-  ElemType sum = 0;
-
   Log::Assert(point.n_elem == dim);
 
+  typedef meta::PowerOf<MetricType::Power> Power;
+
+  meta::PointReader<VecType> reader(point);
+  ElemType sum = 0;
   for (size_t d = 0; d < dim; d++)
   {
-    ElemType v = std::max(fabs(point[d] - bounds[d].Lo()),
-        fabs(bounds[d].Hi() - point[d]));
-    sum += pow(v, (ElemType) MetricType::Power);
+    const ElemType value = reader(d);
+    const ElemType v = std::max(std::abs(value - bounds[d].Lo()),
+        std::abs(bounds[d].Hi() - value));
+    sum += Power::Raise(v);
   }
 
   // The compiler should optimize out this if statement entirely.
   if (MetricType::TakeRoot)
-    return (ElemType) pow((double) sum, 1.0 / (double) MetricType::Power);
+    return Power::Root(sum);
   else
     return sum;
 }
@@ -255,21 +285,21 @@ inline ElemType HRectBound<MetricType, ElemType>::MaxDistance(
     const HRectBound& other)
     const
 {
-  ElemType sum = 0;
-
   Log::Assert(dim == other.dim);
 
-  ElemType v;
+  typedef meta::PowerOf<MetricType::Power> Power;
+
+  ElemType sum = 0;
   for (size_t d = 0; d < dim; d++)
   {
-    v = std::max(fabs(other.bounds[d].Hi() - bounds[d].Lo()),
-        fabs(bounds[d].Hi() - other.bounds[d].Lo()));
-    sum += pow(v, (ElemType) MetricType::Power); // v is non-negative.
+    const ElemType v = std::max(std::abs(other.bounds[d].Hi() -
+        bounds[d].Lo()), std::abs(bounds[d].Hi() - other.bounds[d].Lo()));
+    sum += Power::Raise(v); // v is non-negative.
   }
 
   // The compiler should optimize out this if statement entirely.
   if (MetricType::TakeRoot)
-    return (ElemType) pow((double) sum, 1.0 / (double) MetricType::Power);
+    return Power::Root(sum);
   else
     return sum;
 }
@@ -282,36 +312,25 @@ inline math::RangeType<ElemType>
 HRectBound<MetricType, ElemType>::RangeDistance(
     const HRectBound& other) const
 {
-  ElemType loSum = 0;
-  ElemType hiSum = 0;
-
   Log::Assert(dim == other.dim);
 
-  ElemType v1, v2, vLo, vHi;
+  typedef meta::PowerOf<MetricType::Power> Power;
+
+  ElemType loSum = 0;
+  ElemType hiSum = 0;
   for (size_t d = 0; d < dim; d++)
   {
-    v1 = other.bounds[d].Lo() - bounds[d].Hi();
-    v2 = bounds[d].Lo() - other.bounds[d].Hi();
-    // One of v1 or v2 is negative.
-    if (v1 >= v2)
-    {
-      vHi = -v2; // Make it nonnegative.
-      vLo = (v1 > 0) ? v1 : 0; // Force to be 0 if negative.
-    }
-    else
-    {
-      vHi = -v1; // Make it nonnegative.
-      vLo = (v2 > 0) ? v2 : 0; // Force to be 0 if negative.
-    }
-
-    loSum += pow(vLo, (ElemType) MetricType::Power);
-    hiSum += pow(vHi, (ElemType) MetricType::Power);
+    const ElemType v1 = other.bounds[d].Lo() - bounds[d].Hi();
+    const ElemType v2 = bounds[d].Lo() - other.bounds[d].Hi();
+    // One of v1 or v2 is negative; the smaller one, negated, is the largest
+    // distance in this dimension, and the larger one (if positive) is the
+    // smallest distance.
+    loSum += Power::Raise(std::max(std::max(v1, v2), (ElemType) 0));
+    hiSum += Power::Raise(-std::min(v1, v2));
   }
 
   if (MetricType::TakeRoot)
-    return math::RangeType<ElemType>(
-        (ElemType) pow((double) loSum, 1.0 / (double) MetricType::Power),
-        (ElemType) pow((double) hiSum, 1.0 / (double) MetricType::Power));
+    return math::RangeType<ElemType>(Power::Root(loSum), Power::Root(hiSum));
   else
     return math::RangeType<ElemType>(loSum, hiSum);
 }
@@ -326,44 +345,27 @@ HRectBound<MetricType, ElemType>::RangeDistance(
     const VecType& point,
     typename boost::enable_if<IsVector<VecType>>* /* junk */) const
 {
-  ElemType loSum = 0;
-  ElemType hiSum = 0;
-
   Log::Assert(point.n_elem == dim);
 
-  ElemType v1, v2, vLo, vHi;
+  typedef meta::PowerOf<MetricType::Power> Power;
+
+  meta::PointReader<VecType> reader(point);
+  ElemType loSum = 0;
+  ElemType hiSum = 0;
   for (size_t d = 0; d < dim; d++)
   {
-    v1 = bounds[d].Lo() - point[d]; // Negative if point[d] > lo.
-    v2 = point[d] - bounds[d].Hi(); // Negative if point[d] < hi.
-    // One of v1 or v2 (or both) is negative.
-    if (v1 >= 0) // point[d] <= bounds_[d].Lo().
-    {
-      vHi = -v2; // v2 will be larger but must be negated.
-      vLo = v1;
-    }
-    else // point[d] is between lo and hi, or greater than hi.
-    {
-      if (v2 >= 0)
-      {
-        vHi = -v1; // v1 will be larger, but must be negated.
-        vLo = v2;
-      }
-      else
-      {
-        vHi = -std::min(v1, v2); // Both are negative, but we need the larger.
-        vLo = 0;
-      }
-    }
-
-    loSum += pow(vLo, (ElemType) MetricType::Power);
-    hiSum += pow(vHi, (ElemType) MetricType::Power);
+    const ElemType value = reader(d);
+    const ElemType v1 = bounds[d].Lo() - value; // Negative if value > lo.
+    const ElemType v2 = value - bounds[d].Hi(); // Negative if value < hi.
+    // One of v1 or v2 (or both) is negative.  The distance to the far side is
+    // the larger of -v1 and -v2, and the distance to the bound is the larger of
+    // v1 and v2 if that is positive.
+    loSum += Power::Raise(std::max(std::max(v1, v2), (ElemType) 0));
+    hiSum += Power::Raise(-std::min(v1, v2));
   }
 
   if (MetricType::TakeRoot)
-    return math::RangeType<ElemType>(
-        (ElemType) pow((double) loSum, 1.0 / (double) MetricType::Power),
-        (ElemType) pow((double) hiSum, 1.0 / (double) MetricType::Power));
+    return math::RangeType<ElemType>(Power::Root(loSum), Power::Root(hiSum));
   else
     return math::RangeType<ElemType>(loSum, hiSum);
 }
@@ -378,8 +380,10 @@ inline HRectBound<MetricType, ElemType>& HRectBound<MetricType, ElemType>::opera
 {
   Log::Assert(data.n_rows == dim);
 
-  arma::Col<ElemType> mins(min(data, 1));
-  arma::Col<ElemType> maxs(max(data, 1));
+  // The data may have a different element type than the bound.
+  typedef typename MatType::elem_type DataElemType;
+  arma::Col<DataElemType> mins(min(data, 1));
+  arma::Col<DataElemType> maxs(max(data, 1));
 
   minWidth = std::numeric_limits<ElemType>::max();
   for (size_t i = 0; i < dim; i++)
@@ -421,9 +425,10 @@ template<typename MetricType, typename ElemType>
 template<typename VecType>
 inline bool HRectBound<MetricType, ElemType>::Contains(const VecType& point) const
 {
+  meta::PointReader<VecType> reader(point);
   for (size_t i = 0; i < point.n_elem; i++)
   {
-    if (!bounds[i].Contains(point(i)))
+    if (!bounds[i].Contains(reader(i)))
       return false;
   }
 
@@ -436,13 +441,14 @@ inline bool HRectBound<MetricType, ElemType>::Contains(const VecType& point) con
 template<typename MetricType, typename ElemType>
 inline ElemType HRectBound<MetricType, ElemType>::Diameter() const
 {
+  typedef meta::PowerOf<MetricType::Power> Power;
+
   ElemType d = 0;
   for (size_t i = 0; i < dim; ++i)
-    d += std::pow(bounds[i].Hi() - bounds[i].Lo(),
-        (ElemType) MetricType::Power);
+    d += Power::Raise(bounds[i].Hi() - bounds[i].Lo());
 
   if (MetricType::TakeRoot)
-    return (ElemType) std::pow((double) d, 1.0 / (double) MetricType::Power);
+    return Power::Root(d);
   else
     return d;
 }
@@ -453,20 +459,48 @@ template<typename Archive>
 void HRectBound<MetricType, ElemType>::Serialize(Archive& ar,
                                           const unsigned int /* version */)
 {
+  // Free the old bounds (with their old dimensionality) before loading.
+  if (Archive::is_loading::value)
+  {
+    FreeBounds(bounds, dim);
+    bounds = NULL;
+  }
+
   ar & data::CreateNVP(dim, "dim");
 
   // Allocate memory for the bounds, if necessary.
   if (Archive::is_loading::value)
-  {
-    if (bounds)
-      delete[] bounds;
-    bounds = new math::RangeType<ElemType>[dim];
-  }
+    bounds = AllocateBounds(dim);
 
   ar & data::CreateArrayNVP(bounds, dim, "bounds");
   ar & data::CreateNVP(minWidth, "minWidth");
 }
 
+template<typename MetricType, typename ElemType>
+inline math::RangeType<ElemType>*
+HRectBound<MetricType, ElemType>::AllocateBounds(const size_t dim)
+{
+  math::RangeType<ElemType>* bounds = static_cast<math::RangeType<ElemType>*>(
+      tree::NodeArena::AllocateNode(dim * sizeof(math::RangeType<ElemType>)));
+  for (size_t i = 0; i < dim; ++i)
+    new (bounds + i) math::RangeType<ElemType>();
+
+  return bounds;
+}
+
+template<typename MetricType, typename ElemType>
+inline void HRectBound<MetricType, ElemType>::FreeBounds(
+    math::RangeType<ElemType>* bounds,
+    const size_t dim)
+{
+  if (bounds == NULL)
+    return;
+
+  for (size_t i = 0; i < dim; ++i)
+    bounds[i].~RangeType();
+  tree::NodeArena::FreeNode(bounds);
+}
+
 } // namespace bound
 } // namespace mlpack
 
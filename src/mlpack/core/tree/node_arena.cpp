@@ -0,0 +1,190 @@
+/**
+ * @file node_arena.cpp
+ *
+ * Implementation of NodeArena and NodeArenaScope.
+ */
+#include "node_arena.hpp"
+
+#include <mlpack/core/util/memory_accounting.hpp>
+
+#include <mutex>
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+namespace {
+
+//! The arena that nodes are allocated from on this thread.
+thread_local NodeArena* currentArena = NULL;
+
+//! Every node is preceded by a header of this size, which holds the state of
+//! its arena (or NULL for nodes allocated from the heap).  It keeps the nodes
+//! aligned to 16 bytes.
+const size_t headerSize = 16;
+
+//! Allocate memory from the heap, counted as tree nodes if memory accounting is
+//! enabled.
+void* AllocateHeap(const size_t bytes)
+{
+#ifdef MLPACK_MEMORY_ACCOUNTING
+  return MemoryAccounting::Allocate(bytes, MemoryAccounting::TREE_NODES);
+#else
+  return ::operator new(bytes);
+#endif
+}
+
+//! Free memory allocated with AllocateHeap().
+void FreeHeap(void* memory)
+{
+#ifdef MLPACK_MEMORY_ACCOUNTING
+  MemoryAccounting::Free(memory, MemoryAccounting::TREE_NODES);
+#else
+  ::operator delete(memory);
+#endif
+}
+
+} // anonymous namespace
+
+struct NodeArena::State
+{
+  State(const size_t blockSize) :
+      blockSize(blockSize),
+      next(NULL),
+      available(0),
+      bytes(0),
+      references(1)
+  { }
+
+  //! Free every block.
+  ~State()
+  {
+    for (size_t i = 0; i < blocks.size(); ++i)
+      FreeHeap(blocks[i]);
+  }
+
+  //! Allocate the given number of bytes (a multiple of 16) from the blocks.
+  char* Allocate(const size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size > available)
+    {
+      // The rest of the current block is lost.
+      const size_t newBlockSize = std::max(blockSize, size);
+      next = static_cast<char*>(AllocateHeap(newBlockSize));
+      blocks.push_back(next);
+      available = newBlockSize;
+      bytes += newBlockSize;
+    }
+
+    char* memory = next;
+    next += size;
+    available -= size;
+    references.fetch_add(1, std::memory_order_relaxed);
+    return memory;
+  }
+
+  //! Drop one reference (of the arena or of a node), and delete the state with
+  //! the last one.
+  void Release()
+  {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  //! The size of each block.
+  size_t blockSize;
+  //! Protects the blocks, which may be shared by several threads.
+  std::mutex mutex;
+  //! The blocks allocated so far.
+  std::vector<char*> blocks;
+  //! The next free byte of the current block.
+  char* next;
+  //! The number of free bytes left in the current block.
+  size_t available;
+  //! The total size of the blocks.
+  size_t bytes;
+  //! The number of live nodes, plus one while the arena exists.
+  std::atomic<size_t> references;
+};
+
+NodeArena::NodeArena(const size_t blockSize) :
+    state(new State(std::max(blockSize, headerSize)))
+{ }
+
+NodeArena::~NodeArena()
+{
+  // Make sure no scope keeps pointing at the arena on this thread.
+  if (currentArena == this)
+    currentArena = NULL;
+  state->Release();
+}
+
+size_t NodeArena::Nodes() const
+{
+  return state->references.load(std::memory_order_relaxed) - 1;
+}
+
+size_t NodeArena::Blocks() const
+{
+  std::lock_guard<std::mutex> lock(state->mutex);
+  return state->blocks.size();
+}
+
+size_t NodeArena::Bytes() const
+{
+  std::lock_guard<std::mutex> lock(state->mutex);
+  return state->bytes;
+}
+
+NodeArena* NodeArena::Current()
+{
+  return currentArena;
+}
+
+void* NodeArena::AllocateNode(const size_t bytes)
+{
+  char* memory;
+  State* arenaState = (currentArena == NULL) ? NULL : currentArena->state;
+  if (arenaState == NULL)
+  {
+    memory = static_cast<char*>(AllocateHeap(bytes + headerSize));
+  }
+  else
+  {
+    const size_t size = (bytes + headerSize + 15) & ~size_t(15);
+    memory = arenaState->Allocate(size);
+  }
+
+  *reinterpret_cast<State**>(memory) = arenaState;
+  return memory + headerSize;
+}
+
+void NodeArena::FreeNode(void* memory)
+{
+  if (memory == NULL)
+    return;
+
+  char* base = static_cast<char*>(memory) - headerSize;
+  State* arenaState = *reinterpret_cast<State**>(base);
+  if (arenaState == NULL)
+    FreeHeap(base);
+  else
+    arenaState->Release();
+}
+
+NodeArenaScope::NodeArenaScope(NodeArena& arena) :
+    previous(currentArena)
+{
+  currentArena = &arena;
+}
+
+NodeArenaScope::NodeArenaScope(NodeArena* arena) :
+    previous(currentArena)
+{
+  currentArena = arena;
+}
+
+NodeArenaScope::~NodeArenaScope()
+{
+  currentArena = previous;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file node_arena.hpp
+ *
+ * Definition of NodeArena, which allocates tree nodes from large contiguous
+ * blocks and frees them all at once, and of NodeAllocation, the base class
+ * through which BinarySpaceTree, CoverTree and RectangleTree allocate their
+ * nodes.
+ */
+#ifndef MLPACK_CORE_TREE_NODE_ARENA_HPP
+#define MLPACK_CORE_TREE_NODE_ARENA_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A NodeArena carves tree nodes out of large contiguous blocks of memory,
+ * instead of allocating each node on its own.  While a NodeArenaScope for the
+ * arena is alive, every tree node created on that thread (by BinarySpaceTree,
+ * CoverTree or RectangleTree, including the contiguous array of Compact()) is
+ * allocated from the arena.  Building a tree this way takes a few large
+ * allocations instead of one per node, and places the nodes next to each other
+ * in the order they are created.
+ *
+ * Nodes are never freed individually: deleting a node runs its destructor, but
+ * the memory of the arena is only released, all at once, when the arena has
+ * been destroyed and every node allocated from it has been deleted (whichever
+ * comes last).  So the arena may safely be destroyed before the trees built
+ * with it.
+ *
+ * @code
+ * NodeArena arena;
+ * KDTree<EuclideanDistance, EmptyStatistic, arma::mat>* tree;
+ * {
+ *   NodeArenaScope scope(arena);
+ *   tree = new KDTree<EuclideanDistance, EmptyStatistic, arma::mat>(data);
+ * }
+ * @endcode
+ *
+ * Nodes allocated outside of any scope (for instance, nodes added later to a
+ * RectangleTree) come from the heap as usual, so a tree may mix both.  The
+ * per-dimension ranges of HRectBound are also allocated from the arena, but
+ * the rest of the memory owned by the nodes (such as the children lists of
+ * CoverTree and RectangleTree) is not.  When mlpack is built with
+ * -DMEMORY_ACCOUNTING=ON, the blocks are counted as tree nodes.
+ */
+class NodeArena
+{
+ public:
+  /**
+   * Create an arena that allocates blocks of the given size (larger nodes get a
+   * block of their own).
+   *
+   * @param blockSize Size of each block, in bytes.
+   */
+  NodeArena(const size_t blockSize = 1048576);
+
+  /**
+   * Release the arena.  The blocks are freed now if no node allocated from the
+   * arena is alive, and when the last of them is deleted otherwise.
+   */
+  ~NodeArena();
+
+  // The arena can't be copied.
+  NodeArena(const NodeArena& other) = delete;
+  NodeArena& operator=(const NodeArena& other) = delete;
+
+  //! Get the number of nodes (or compacted node arrays, or HRectBound ranges)
+  //! allocated from the arena which are still alive.
+  size_t Nodes() const;
+  //! Get the number of blocks allocated by the arena.
+  size_t Blocks() const;
+  //! Get the total size of the blocks allocated by the arena, in bytes.
+  size_t Bytes() const;
+
+  //! Get the arena that nodes are allocated from on this thread (NULL if there
+  //! is none).
+  static NodeArena* Current();
+
+  /**
+   * Allocate memory for a node (or an array of nodes): from the current arena
+   * of the thread if there is one, and from the heap otherwise.  A
+   * std::bad_alloc exception is thrown if the memory can't be allocated.
+   *
+   * @param bytes Number of bytes to allocate.
+   */
+  static void* AllocateNode(const size_t bytes);
+
+  /**
+   * Free memory allocated with AllocateNode().  Memory from an arena is only
+   * released with the rest of the arena.
+   *
+   * @param memory Memory to free (it may be NULL).
+   */
+  static void FreeNode(void* memory);
+
+ private:
+  //! The blocks and the counters of the arena, which live until the arena and
+  //! all of its nodes are gone.
+  struct State;
+
+  //! The state of the arena.
+  State* state;
+};
+
+/**
+ * While a NodeArenaScope is alive, the tree nodes created on its thread are
+ * allocated from the given arena, which must outlive the scope.  Scopes nest:
+ * the previous arena (or none) is restored when the scope ends.
+ */
+class NodeArenaScope
+{
+ public:
+  //! Allocate the nodes created on this thread from the given arena.
+  NodeArenaScope(NodeArena& arena);
+
+  //! Allocate the nodes created on this thread from the given arena, or from
+  //! the heap if it is NULL.
+  NodeArenaScope(NodeArena* arena);
+
+  //! Restore the previous arena of the thread.
+  ~NodeArenaScope();
+
+  // The scope can't be copied.
+  NodeArenaScope(const NodeArenaScope& other) = delete;
+  NodeArenaScope& operator=(const NodeArenaScope& other) = delete;
+
+ private:
+  //! The arena of the thread before the scope.
+  NodeArena* previous;
+};
+
+/**
+ * Objects of classes derived from NodeAllocation are allocated with
+ * NodeArena::AllocateNode(), so they come from the current arena of the thread
+ * if there is one (and are counted as tree nodes when mlpack is built with
+ * -DMEMORY_ACCOUNTING=ON).  The base class is empty, so it doesn't change the
+ * size of the derived class.
+ */
+class NodeAllocation
+{
+ public:
+  static void* operator new(const size_t bytes)
+  {
+    return NodeArena::AllocateNode(bytes);
+  }
+
+  static void operator delete(void* memory)
+  {
+    NodeArena::FreeNode(memory);
+  }
+
+  // Placement new (used to construct objects in memory which is already
+  // allocated) must be declared again, since the overloads above hide it.
+  static void* operator new(const size_t /* bytes */, void* memory)
+  {
+    return memory;
+  }
+
+  static void operator delete(void* /* memory */, void* /* place */) { }
+};
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
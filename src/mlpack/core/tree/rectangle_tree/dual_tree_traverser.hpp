@@ -10,6 +10,7 @@
 #define MLPACK_CORE_TREE_RECTANGLE_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
 
 #include "rectangle_tree.hpp"
 
@@ -78,7 +79,7 @@ class RectangleTree<MetricType, StatisticType, MatType, SplitType,
   }
 
   //! Reference to the rules with which the trees will be traversed.
-  RuleType& rule;
+  TraversalRules<RuleType> rule;
 
   //! The number of prunes.
   size_t numPrunes;
@@ -32,7 +32,9 @@ class RStarTreeDescentHeuristic
    * @param point The point that is being inserted.
    */
   template<typename TreeType>
-  static size_t ChooseDescentNode(const TreeType* node, const arma::vec& point);
+  static size_t ChooseDescentNode(
+      const TreeType* node,
+      const arma::Col<typename TreeType::ElemType>& point);
 
   template<typename TreeType>
   static size_t ChooseDescentNode(const TreeType* node,
@@ -16,7 +16,7 @@ namespace tree {
 template<typename TreeType>
 inline size_t RStarTreeDescentHeuristic::ChooseDescentNode(
     const TreeType* node,
-    const arma::vec& point)
+    const arma::Col<typename TreeType::ElemType>& point)
 {
   // Convenience typedef.
   typedef typename TreeType::ElemType ElemType;
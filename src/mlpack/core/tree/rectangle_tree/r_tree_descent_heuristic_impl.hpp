@@ -14,8 +14,9 @@ namespace mlpack {
 namespace tree {
 
 template<typename TreeType>
-inline size_t RTreeDescentHeuristic::ChooseDescentNode(const TreeType* node,
-                                                       const arma::vec& point)
+inline size_t RTreeDescentHeuristic::ChooseDescentNode(
+    const TreeType* node,
+    const arma::Col<typename TreeType::ElemType>& point)
 {
   // Convenience typedef.
   typedef typename TreeType::ElemType ElemType;
@@ -11,6 +11,7 @@
 #include <mlpack/core.hpp>
 
 #include "../hrectbound.hpp"
+#include "../node_arena.hpp"
 #include "../statistic.hpp"
 #include "r_tree_split.hpp"
 #include "r_tree_descent_heuristic.hpp"
@@ -18,6 +19,13 @@
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
 
+/**
+ * Pass an instance of this class to the RectangleTree constructor to build the
+ * tree with Sort-Tile-Recursive bulk loading instead of inserting the points
+ * one at a time.
+ */
+class SortTileRecursive { };
+
 /**
  * A rectangle type tree tree, such as an R-tree or X-tree.  Once the
  * bound and type of dataset is defined, the tree will construct itself.  Call
@@ -41,7 +49,8 @@ template<typename MetricType = metric::EuclideanDistance,
          typename MatType = arma::mat,
          template<typename> class SplitType = RTreeSplit,
          typename DescentType = RTreeDescentHeuristic>
-class RectangleTree
+class RectangleTree :
+    public NodeAllocation
 {
   // The metric *must* be the euclidean distance.
   static_assert(boost::is_same<MetricType, metric::EuclideanDistance>::value,
@@ -145,6 +154,53 @@ class RectangleTree
                 const size_t minNumChildren = 2,
                 const size_t firstDataIndex = 0);
 
+  /**
+   * Construct this as the root node of a rectangle type tree on the given
+   * dataset, using Sort-Tile-Recursive (STR) bulk loading.  The points are
+   * sorted into slabs along the first dimension, each slab is sorted into slabs
+   * along the next dimension, and so on, and the resulting runs of points are
+   * packed into full leaves.  The nodes of each level are then packed into
+   * parent nodes in the same way, using their centers.  This is much faster
+   * than inserting each point, and the nodes are fuller and overlap less.
+   *
+   * The split and descent heuristics are only used if points are inserted or
+   * deleted afterwards, which is still possible.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.
+   */
+  RectangleTree(const MatType& data,
+                const SortTileRecursive /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
+  /**
+   * Construct this as the root node of a rectangle type tree on the given
+   * dataset using Sort-Tile-Recursive bulk loading, taking ownership of the
+   * dataset.  See the constructor above for details.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.
+   */
+  RectangleTree(MatType&& data,
+                const SortTileRecursive /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
   /**
    * Construct this as an empty node with the specified parent.  Copying the
    * parameters (maxLeafSize, minLeafSize, maxNumChildren, minNumChildren,
@@ -213,6 +269,23 @@ class RectangleTree
    */
   void InsertPoint(const size_t point, std::vector<bool>& relevels);
 
+  /**
+   * Inserts a batch of points into the tree; this should be called on the root
+   * node.  Each point is routed to a leaf with the descent heuristic and
+   * buffered there, without changing the tree.  Then each leaf takes all of its
+   * buffered points at once: a leaf that overflows is split into as many leaves
+   * as needed in one step, with the same Sort-Tile-Recursive packing as the
+   * bulk-loading constructors, and the new leaves are given to the parent,
+   * which is split in the same way if it overflows, up to the root.  The bounds
+   * (and statistics) of the nodes that changed are recomputed exactly once, from
+   * the leaves up.  The split policy of the tree (and so the R*-tree forced
+   * reinsertion) is not used.  As with InsertPoint(), the points must already be
+   * in the dataset of the tree.
+   *
+   * @param newPoints Indices of the points to be inserted.
+   */
+  void InsertPoints(const std::vector<size_t>& newPoints);
+
   /**
    * Inserts a node into the tree, tracking which levels have been inserted
    * into.  The node will be inserted so that the tree remains valid.
@@ -343,7 +416,7 @@ class RectangleTree
   MetricType Metric() const { return MetricType(); }
 
   //! Get the centroid of the node and store it in the given vector.
-  void Center(arma::vec& center) { bound.Center(center); }
+  void Center(arma::Col<ElemType>& center) { bound.Center(center); }
 
   //! Return the number of child nodes.  (One level beneath this one only.)
   size_t NumChildren() const { return numChildren; }
@@ -522,6 +595,70 @@ class RectangleTree
     return new RectangleTree(begin, count, bound, stat, maxLeafSize);
   }
 
+  /**
+   * Build the tree on the whole dataset with Sort-Tile-Recursive packing.  This
+   * is used by the bulk-loading constructors, and must only be called on an
+   * empty root node.
+   */
+  void BulkLoad();
+
+  /**
+   * Order the given columns of the coordinate matrix for Sort-Tile-Recursive
+   * packing.  The columns in order are cut into totalGroups equal runs; this
+   * sorts the runs firstGroup to (firstGroup + numGroups - 1) along dimension
+   * dim, splits them into slabs, and recurses into each slab with the next
+   * dimension.
+   *
+   * @param coords Matrix holding one point (or node center) in each column.
+   * @param order Column indices to be reordered.
+   * @param firstGroup The first run to order.
+   * @param numGroups The number of runs to order.
+   * @param totalGroups The total number of runs that order is cut into.
+   * @param dim The dimension to sort along.
+   */
+  template<typename CoordMatType>
+  static void STRSort(const CoordMatType& coords,
+                      std::vector<size_t>& order,
+                      const size_t firstGroup,
+                      const size_t numGroups,
+                      const size_t totalGroups,
+                      const size_t dim);
+
+  /**
+   * Fill this leaf with the given points.  If there are more than
+   * MaxLeafSize() points, they are cut into the fewest leaves that hold them,
+   * with Sort-Tile-Recursive packing; the first of them is this node if
+   * keepNode is true, and the others are new nodes (whose parent is the parent
+   * of this node).  This is used by InsertPoints().
+   *
+   * @param leafPoints Indices of the points (they are reordered).
+   * @param keepNode Whether this node takes the first group of points.
+   * @param newNodes Vector to add the new nodes to.
+   */
+  void PackPoints(std::vector<size_t>& leafPoints,
+                  const bool keepNode,
+                  std::vector<RectangleTree*>& newNodes);
+
+  /**
+   * Make the given nodes the children of this node.  If there are more than
+   * MaxNumChildren() of them, they are cut into the fewest nodes that hold
+   * them, with Sort-Tile-Recursive packing of their centers, as in
+   * PackPoints().  The bounds of the given nodes must be up to date.
+   *
+   * @param nodeChildren The children (they are reordered).
+   * @param keepNode Whether this node takes the first group of children.
+   * @param newNodes Vector to add the new nodes to.
+   */
+  void PackChildren(std::vector<RectangleTree*>& nodeChildren,
+                    const bool keepNode,
+                    std::vector<RectangleTree*>& newNodes);
+
+  /**
+   * Recompute the bound of this node from its points or from the bounds of its
+   * children, and then its statistic.
+   */
+  void RecomputeBound();
+
   /**
    * Splits the current node, recursing up the tree.
    *
@@ -553,7 +690,7 @@ class RectangleTree
    *      is possible when we now what point was deleted.  False otherwise (eg.
    *      if we deleted a node instead of a point).
    */
-  void CondenseTree(const arma::vec& point,
+  void CondenseTree(const arma::Col<ElemType>& point,
                     std::vector<bool>& relevels,
                     const bool usePoint);
 
@@ -564,7 +701,7 @@ class RectangleTree
    *      shrinking.
    * @return true if the bound needed to be changed, false if it did not.
    */
-  bool ShrinkBoundForPoint(const arma::vec& point);
+  bool ShrinkBoundForPoint(const arma::Col<ElemType>& point);
 
   /**
    * Shrink the bound object of this node for the removal of a child node.
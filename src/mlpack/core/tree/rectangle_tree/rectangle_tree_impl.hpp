@@ -13,6 +13,9 @@
 #include <mlpack/core/util/cli.hpp>
 #include <mlpack/core/util/log.hpp>
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace mlpack {
 namespace tree {
 
@@ -96,6 +99,74 @@ RectangleTree(MatType&& data,
     root->InsertPoint(i);
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+RectangleTree(const MatType& data,
+              const SortTileRecursive /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    parentDistance(0),
+    dataset(new MatType(data)),
+    ownsDataset(true),
+    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
+    localDataset(new MatType(arma::zeros<MatType>(data.n_rows,
+                                                  maxLeafSize + 1)))
+{
+  split = SplitType<RectangleTree>(this);
+
+  BulkLoad();
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+RectangleTree(MatType&& data,
+              const SortTileRecursive /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    parentDistance(0),
+    dataset(new MatType(std::move(data))),
+    ownsDataset(true),
+    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
+    localDataset(new MatType(arma::zeros<MatType>(dataset->n_rows,
+                                                  maxLeafSize + 1)))
+{
+  split = SplitType<RectangleTree>(this);
+
+  BulkLoad();
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -174,7 +245,7 @@ RectangleTree(
   else
   {
     children = other.Children();
-    arma::mat& otherData = const_cast<arma::mat&>(other.LocalDataset());
+    MatType& otherData = const_cast<MatType&>(other.LocalDataset());
     localDataset = &otherData;
   }
 }
@@ -323,6 +394,261 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
   children[descentNode]->InsertPoint(point, relevels);
 }
 
+/**
+ * Insert a batch of points: route each point to a leaf and buffer it there, then
+ * empty the buffers, splitting each overflowing node into as many nodes as
+ * needed at once, level by level from the leaves up.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    InsertPoints(const std::vector<size_t>& newPoints)
+{
+  if (newPoints.empty())
+    return;
+
+  // Order the points by tiles of the size of a leaf, so that the points which
+  // are routed to the same leaf arrive together.
+  std::vector<size_t> batch(newPoints);
+  const size_t numTiles = (batch.size() + maxLeafSize - 1) / maxLeafSize;
+  STRSort(*dataset, batch, 0, numTiles, numTiles, 0);
+
+  // Route each point to a leaf.  The tree is not changed (not even the bounds)
+  // until all of the points have been routed.
+  std::vector<RectangleTree*> leaves;
+  std::vector<std::vector<size_t>> buffers;
+  std::unordered_map<RectangleTree*, size_t> leafIndices;
+  for (size_t i = 0; i < batch.size(); ++i)
+  {
+    RectangleTree* node = this;
+    while (!node->IsLeaf())
+    {
+      node = node->children[DescentType::ChooseDescentNode(node,
+          dataset->col(batch[i]))];
+    }
+
+    auto it = leafIndices.find(node);
+    if (it == leafIndices.end())
+    {
+      leafIndices[node] = leaves.size();
+      leaves.push_back(node);
+      buffers.push_back(std::vector<size_t>());
+      buffers.back().push_back(batch[i]);
+    }
+    else
+    {
+      buffers[it->second].push_back(batch[i]);
+    }
+  }
+
+  // Empty each buffer into its leaf.  The new leaves of an overflowing leaf are
+  // given to its parent, and the parents are handled on the next level.
+  std::vector<RectangleTree*> level;
+  std::unordered_map<RectangleTree*, std::vector<RectangleTree*>> newChildren;
+  for (size_t i = 0; i < leaves.size(); ++i)
+  {
+    RectangleTree* leaf = leaves[i];
+    std::vector<size_t> leafPoints(leaf->points.begin(),
+        leaf->points.begin() + leaf->count);
+    leafPoints.insert(leafPoints.end(), buffers[i].begin(), buffers[i].end());
+
+    // If the root is a leaf and overflows, all of its points go to new leaves,
+    // which become its children.
+    if (leaf == this)
+    {
+      if (leafPoints.size() <= maxLeafSize)
+      {
+        PackPoints(leafPoints, true, newChildren[NULL]);
+        RecomputeBound();
+        return;
+      }
+
+      PackPoints(leafPoints, false, newChildren[this]);
+      level.push_back(this);
+      break;
+    }
+
+    // The parent has to be handled on the next level (at least its bound has
+    // to be recomputed), whether or not the leaf overflows.
+    if (newChildren.count(leaf->parent) == 0)
+      level.push_back(leaf->parent);
+
+    leaf->PackPoints(leafPoints, true, newChildren[leaf->parent]);
+    leaf->RecomputeBound();
+  }
+
+  // Now each level of parents, up to the root.  All of the nodes of a level are
+  // at the same depth, so the root is the only node of the last level.
+  while (!level.empty())
+  {
+    std::vector<RectangleTree*> nextLevel;
+    for (size_t i = 0; i < level.size(); ++i)
+    {
+      RectangleTree* node = level[i];
+      std::vector<RectangleTree*> nodeChildren(node->children.begin(),
+          node->children.begin() + node->numChildren);
+      const std::vector<RectangleTree*>& added = newChildren[node];
+      nodeChildren.insert(nodeChildren.end(), added.begin(), added.end());
+
+      if (node == this)
+      {
+        // If the root overflows, its children are packed into new nodes, which
+        // become its children, until they fit; each time the tree gets one
+        // level deeper.
+        while (nodeChildren.size() > maxNumChildren)
+        {
+          std::vector<RectangleTree*> packed;
+          PackChildren(nodeChildren, false, packed);
+          nodeChildren.swap(packed);
+        }
+
+        PackChildren(nodeChildren, true, newChildren[NULL]);
+        RecomputeBound();
+        continue;
+      }
+
+      if (newChildren.count(node->parent) == 0)
+        nextLevel.push_back(node->parent);
+
+      node->PackChildren(nodeChildren, true, newChildren[node->parent]);
+      node->RecomputeBound();
+    }
+
+    level.swap(nextLevel);
+  }
+}
+
+/**
+ * Fill this leaf with the given points, cutting them into several leaves if
+ * they do not fit.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    PackPoints(std::vector<size_t>& leafPoints,
+               const bool keepNode,
+               std::vector<RectangleTree*>& newNodes)
+{
+  const size_t n = leafPoints.size();
+  const size_t numGroups = std::max((size_t) 1,
+      (n + maxLeafSize - 1) / maxLeafSize);
+  STRSort(*dataset, leafPoints, 0, numGroups, numGroups, 0);
+
+  count = 0;
+  for (size_t i = 0; i < numGroups; ++i)
+  {
+    // The new nodes take their parameters from this node.
+    RectangleTree* node = this;
+    if (i > 0 || !keepNode)
+    {
+      node = new RectangleTree(this);
+      node->parent = keepNode ? parent : this;
+      newNodes.push_back(node);
+    }
+
+    for (size_t j = i * n / numGroups; j < (i + 1) * n / numGroups; ++j)
+    {
+      node->localDataset->col(node->count) = dataset->col(leafPoints[j]);
+      node->points[node->count++] = leafPoints[j];
+    }
+
+    // The bound of this node is recomputed by the caller.
+    if (node != this)
+      node->RecomputeBound();
+  }
+}
+
+/**
+ * Make the given nodes the children of this node, cutting them into several
+ * nodes if they do not fit.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    PackChildren(std::vector<RectangleTree*>& nodeChildren,
+                 const bool keepNode,
+                 std::vector<RectangleTree*>& newNodes)
+{
+  const size_t n = nodeChildren.size();
+  const size_t numGroups = std::max((size_t) 1,
+      (n + maxNumChildren - 1) / maxNumChildren);
+
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = i;
+
+  if (numGroups > 1)
+  {
+    arma::Mat<ElemType> centers(dataset->n_rows, n);
+    arma::Col<ElemType> center;
+    for (size_t i = 0; i < n; ++i)
+    {
+      nodeChildren[i]->bound.Center(center);
+      centers.col(i) = center;
+    }
+
+    STRSort(centers, order, 0, numGroups, numGroups, 0);
+  }
+
+  numChildren = 0;
+  for (size_t i = 0; i < numGroups; ++i)
+  {
+    RectangleTree* node = this;
+    if (i > 0 || !keepNode)
+    {
+      node = new RectangleTree(this);
+      node->parent = keepNode ? parent : this;
+      newNodes.push_back(node);
+    }
+
+    for (size_t j = i * n / numGroups; j < (i + 1) * n / numGroups; ++j)
+    {
+      RectangleTree* child = nodeChildren[order[j]];
+      node->children[node->numChildren++] = child;
+      child->parent = node;
+    }
+
+    // The bound of this node is recomputed by the caller.
+    if (node != this)
+      node->RecomputeBound();
+  }
+}
+
+/**
+ * Recompute the bound of this node from its points or its children.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    RecomputeBound()
+{
+  bound.Clear();
+  if (numChildren == 0)
+  {
+    for (size_t i = 0; i < count; ++i)
+      bound |= localDataset->col(i);
+  }
+  else
+  {
+    for (size_t i = 0; i < numChildren; ++i)
+      bound |= children[i]->bound;
+  }
+
+  stat = StatisticType(*this);
+}
+
 /**
  * Inserts a node into the tree, tracking which levels have been inserted into.
  *
@@ -453,7 +779,7 @@ bool RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
     if (children[i] == node)
     {
       children[i] = children[--numChildren]; // Decrement numChildren.
-      CondenseTree(arma::vec(), relevels, false);
+      CondenseTree(arma::Col<ElemType>(), relevels, false);
       return true;
     }
 
@@ -647,6 +973,164 @@ inline size_t RectangleTree<MetricType, StatisticType, MatType, SplitType,
   return points[index];
 }
 
+/**
+ * Build the tree with Sort-Tile-Recursive packing: order the points so that
+ * every run of (about) maxLeafSize consecutive points is spatially compact, cut
+ * them into leaves, and then do the same with the centers of the nodes of each
+ * level until the nodes fit into the root.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    BulkLoad()
+{
+  const size_t n = dataset->n_cols;
+
+  // If all of the points fit in one leaf, the root is that leaf.
+  if (n <= maxLeafSize)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      bound |= dataset->col(i);
+      localDataset->col(i) = dataset->col(i);
+      points[i] = i;
+    }
+    count = n;
+
+    stat = StatisticType(*this);
+    return;
+  }
+
+  // Cut the ordered points into leaves of equal size (give or take one point).
+  // The leaves are filled as much as possible, so they will only have fewer
+  // than minLeafSize points if minLeafSize is larger than maxLeafSize / 2.
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = i;
+
+  const size_t numLeaves = (n + maxLeafSize - 1) / maxLeafSize;
+  STRSort(*dataset, order, 0, numLeaves, numLeaves, 0);
+
+  std::vector<RectangleTree*> nodes(numLeaves);
+  for (size_t i = 0; i < numLeaves; ++i)
+  {
+    // The parent is fixed when the next level is built, but the root gives the
+    // new node its parameters and its dataset.
+    RectangleTree* leaf = new RectangleTree(this);
+    for (size_t j = i * n / numLeaves; j < (i + 1) * n / numLeaves; ++j)
+    {
+      leaf->bound |= dataset->col(order[j]);
+      leaf->localDataset->col(leaf->count) = dataset->col(order[j]);
+      leaf->points[leaf->count++] = order[j];
+    }
+
+    leaf->stat = StatisticType(*leaf);
+    nodes[i] = leaf;
+  }
+
+  // Now pack the nodes of each level into parents in the same way, by their
+  // centers, so that all leaves end up at the same depth.
+  while (nodes.size() > maxNumChildren)
+  {
+    arma::Mat<ElemType> centers(dataset->n_rows, nodes.size());
+    arma::Col<ElemType> center;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+      nodes[i]->bound.Center(center);
+      centers.col(i) = center;
+    }
+
+    order.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+      order[i] = i;
+
+    const size_t numParents = (nodes.size() + maxNumChildren - 1) /
+        maxNumChildren;
+    STRSort(centers, order, 0, numParents, numParents, 0);
+
+    std::vector<RectangleTree*> parents(numParents);
+    for (size_t i = 0; i < numParents; ++i)
+    {
+      RectangleTree* node = new RectangleTree(this);
+      for (size_t j = i * nodes.size() / numParents;
+           j < (i + 1) * nodes.size() / numParents; ++j)
+      {
+        RectangleTree* child = nodes[order[j]];
+        node->bound |= child->bound;
+        node->children[node->numChildren++] = child;
+        child->parent = node;
+      }
+
+      node->stat = StatisticType(*node);
+      parents[i] = node;
+    }
+
+    nodes.swap(parents);
+  }
+
+  // The remaining nodes are the children of the root.
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    bound |= nodes[i]->bound;
+    children[numChildren++] = nodes[i];
+    nodes[i]->parent = this;
+  }
+
+  stat = StatisticType(*this);
+}
+
+/**
+ * Sort the given runs of columns along dimension dim, and then split them into
+ * roughly numGroups^(1 / (remaining dimensions)) slabs of whole runs, each of
+ * which is sorted along the next dimension.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename> class SplitType,
+         typename DescentType>
+template<typename CoordMatType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    STRSort(const CoordMatType& coords,
+            std::vector<size_t>& order,
+            const size_t firstGroup,
+            const size_t numGroups,
+            const size_t totalGroups,
+            const size_t dim)
+{
+  // A single run does not need to be ordered any further.
+  if (numGroups <= 1)
+    return;
+
+  const size_t first = firstGroup * order.size() / totalGroups;
+  const size_t last = (firstGroup + numGroups) * order.size() / totalGroups;
+
+  // Break ties by index, so that the tree does not depend on the sort
+  // implementation.
+  std::sort(order.begin() + first, order.begin() + last,
+      [&coords, dim](const size_t a, const size_t b)
+      {
+        return (coords(dim, a) < coords(dim, b)) ||
+            (coords(dim, a) == coords(dim, b) && a < b);
+      });
+
+  if (dim + 1 == coords.n_rows)
+    return;
+
+  const size_t numSlabs = (size_t) std::ceil(std::pow((double) numGroups,
+      1.0 / (coords.n_rows - dim)));
+  for (size_t i = 0; i < numSlabs; ++i)
+  {
+    const size_t slabFirst = firstGroup + i * numGroups / numSlabs;
+    const size_t slabEnd = firstGroup + (i + 1) * numGroups / numSlabs;
+    STRSort(coords, order, slabFirst, slabEnd - slabFirst, totalGroups,
+        dim + 1);
+  }
+}
+
 /**
  * Split the tree.  This calls the SplitType code to split a node.  This method
  * should only be called on a leaf node.
@@ -715,7 +1199,7 @@ template<typename MetricType,
          template<typename> class SplitType,
          typename DescentType>
 void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
-    CondenseTree(const arma::vec& point,
+    CondenseTree(const arma::Col<ElemType>& point,
                  std::vector<bool>& relevels,
                  const bool usePoint)
 {
@@ -844,7 +1328,7 @@ template<typename MetricType,
          template<typename> class SplitType,
          typename DescentType>
 bool RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
-    ShrinkBoundForPoint(const arma::vec& point)
+    ShrinkBoundForPoint(const arma::Col<ElemType>& point)
 {
   bool shrunk = false;
   if (IsLeaf())
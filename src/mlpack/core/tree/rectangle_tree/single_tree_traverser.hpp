@@ -10,6 +10,7 @@
 #define MLPACK_CORE_TREE_RECTANGLE_TREE_SINGLE_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
 
 #include "rectangle_tree.hpp"
 
@@ -61,7 +62,7 @@ class RectangleTree<MetricType, StatisticType, MatType, SplitType,
   }
 
   //! Reference to the rules with which the tree will be traversed.
-  RuleType& rule;
+  TraversalRules<RuleType> rule;
 
   //! The number of nodes which have been prenud during traversal.
   size_t numPrunes;
@@ -0,0 +1,349 @@
+/**
+ * @file traversal_trace.hpp
+ *
+ * Optional instrumentation of tree traversals: statistics of the node pairs
+ * scored, pruned and rescored, and of the base cases, for each depth of the
+ * tree.  The traversers only wrap their rules in a TracedRules when
+ * MLPACK_TRAVERSAL_TRACE is defined (with the TRAVERSAL_TRACE CMake option);
+ * otherwise they use their rules directly, and there is no overhead at all.
+ * The classes themselves are always defined, so that they can also be used by
+ * hand.
+ */
+#ifndef MLPACK_CORE_TREE_TRAVERSAL_TRACE_HPP
+#define MLPACK_CORE_TREE_TRAVERSAL_TRACE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/timers.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The TraversalTrace class holds the statistics of a traversal for each depth
+ * of the tree.  The depth of a node pair is the larger of the depths of its two
+ * nodes (the depth of the reference node, for single-tree traversals), where
+ * the root has depth 0.  For each depth, the following counters are kept:
+ *
+ *  - scores: the number of node pairs scored;
+ *  - prunes: the number of node pairs pruned by Score();
+ *  - rescores: the number of node pairs rescored;
+ *  - rescore_prunes: the number of node pairs pruned by Rescore(), that is,
+ *    whose bound got tight enough to prune them between the time they were
+ *    scored and the time they were visited (rescore_prunes / rescores measures
+ *    how fast the bounds tighten);
+ *  - base_cases: the number of base cases, attributed to the last pair that
+ *    was scored (or rescored) without being pruned;
+ *  - base_case_pairs: the number of distinct reference nodes those base cases
+ *    were attributed to in a row, so that base_cases / base_case_pairs is the
+ *    number of base cases per leaf pair.
+ *
+ * When the trace is destroyed, the counters are added to the Counter class as
+ * "traversal/depth_<depth>/<counter>", so they are listed with the other
+ * counters in verbose output and in profiles (see --profile_output).
+ */
+class TraversalTrace
+{
+ public:
+  //! Create an empty trace.
+  TraversalTrace() :
+      baseCaseDepth(0),
+      baseCaseNode(NULL),
+      lastBaseCaseNode(NULL)
+  { }
+
+  //! Add the statistics of the trace to the counters.
+  ~TraversalTrace()
+  {
+    for (size_t d = 0; d < stats.size(); ++d)
+    {
+      std::ostringstream prefix;
+      prefix << "traversal/depth_" << d << "/";
+      for (size_t i = 0; i < NumStatistics; ++i)
+        if (stats[d][i] > 0)
+          Counter::Add(prefix.str() + Name(i), stats[d][i]);
+    }
+  }
+
+  //! Record the score of the node pair at the given depth, whose reference
+  //! node is the given node.
+  void Score(const size_t depth, const void* referenceNode, const double score)
+  {
+    Add(depth, Scores);
+    if (score == DBL_MAX)
+      Add(depth, Prunes);
+    else
+      Visit(depth, referenceNode);
+  }
+
+  //! Record the rescore of the node pair at the given depth, whose reference
+  //! node is the given node.
+  void Rescore(const size_t depth,
+               const void* referenceNode,
+               const double oldScore,
+               const double newScore)
+  {
+    Add(depth, Rescores);
+    if (newScore == DBL_MAX && oldScore != DBL_MAX)
+      Add(depth, RescorePrunes);
+    else if (newScore != DBL_MAX)
+      Visit(depth, referenceNode);
+  }
+
+  //! Record a base case.
+  void BaseCase()
+  {
+    Add(baseCaseDepth, BaseCases);
+    if (baseCaseNode != lastBaseCaseNode)
+    {
+      Add(baseCaseDepth, BaseCasePairs);
+      lastBaseCaseNode = baseCaseNode;
+    }
+  }
+
+  //! Get the value of the given statistic (see Name()) at the given depth.
+  size_t Get(const size_t depth, const size_t statistic) const
+  {
+    return (depth < stats.size()) ? stats[depth][statistic] : 0;
+  }
+
+  //! Get the number of depths with statistics.
+  size_t Depths() const { return stats.size(); }
+
+  /**
+   * Add the statistics of the given trace (for instance, the trace of one
+   * thread of a parallel traversal) to this trace, and clear them from the
+   * given trace, so that they are only added to the counters once.
+   */
+  void Merge(TraversalTrace& other)
+  {
+    if (other.stats.size() > stats.size())
+      stats.resize(other.stats.size(), std::vector<size_t>(NumStatistics, 0));
+    for (size_t d = 0; d < other.stats.size(); ++d)
+      for (size_t i = 0; i < NumStatistics; ++i)
+        stats[d][i] += other.stats[d][i];
+
+    other.stats.clear();
+  }
+
+  //! The statistics kept for each depth.
+  enum Statistic
+  {
+    Scores,
+    Prunes,
+    Rescores,
+    RescorePrunes,
+    BaseCases,
+    BaseCasePairs,
+    NumStatistics
+  };
+
+  //! Get the name of the counter of the given statistic.
+  static const char* Name(const size_t statistic)
+  {
+    static const char* names[NumStatistics] = { "scores", "prunes", "rescores",
+        "rescore_prunes", "base_cases", "base_case_pairs" };
+    return names[statistic];
+  }
+
+  //! Compute the depth of the given node (the root has depth 0).
+  template<typename TreeType>
+  static size_t Depth(const TreeType& node)
+  {
+    size_t depth = 0;
+    for (const TreeType* n = node.Parent(); n != NULL; n = n->Parent())
+      ++depth;
+    return depth;
+  }
+
+ private:
+  //! Add one to the given statistic at the given depth.
+  void Add(const size_t depth, const Statistic statistic)
+  {
+    if (depth >= stats.size())
+      stats.resize(depth + 1, std::vector<size_t>(NumStatistics, 0));
+    ++stats[depth][statistic];
+  }
+
+  //! The base cases that follow are attributed to the given pair.
+  void Visit(const size_t depth, const void* referenceNode)
+  {
+    baseCaseDepth = depth;
+    baseCaseNode = referenceNode;
+  }
+
+  //! The statistics of each depth.
+  std::vector<std::vector<size_t>> stats;
+  //! The depth the next base cases are attributed to.
+  size_t baseCaseDepth;
+  //! The reference node the next base cases are attributed to.
+  const void* baseCaseNode;
+  //! The reference node the last base case was attributed to.
+  const void* lastBaseCaseNode;
+};
+
+/**
+ * TracedRules wraps the rules of a traversal (such as NeighborSearchRules,
+ * RangeSearchRules, FastMKSRules, DTBRules or RASearchRules), forwarding every
+ * call to them and recording it in a TraversalTrace.  The traversers hold their
+ * rules as a TraversalRules<RuleType>, which is a TracedRules<RuleType> when
+ * MLPACK_TRAVERSAL_TRACE is defined, so every traversal of every method is
+ * traced without any change to the rules or the methods.
+ *
+ * @tparam RuleType Type of the wrapped rules.
+ */
+template<typename RuleType>
+class TracedRules
+{
+ public:
+  //! Wrap the given rules.
+  TracedRules(RuleType& rule) : rule(rule) { }
+
+  //! Get the wrapped rules (for instance, to copy them for another thread).
+  operator RuleType&() { return rule; }
+
+  //! Compute and record a base case.
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex)
+  {
+    trace.BaseCase();
+    return rule.BaseCase(queryIndex, referenceIndex);
+  }
+
+  //! Let the rules evaluate the base cases of a pair of leaves at once, and
+  //! record them (the scores of the query points are not recorded).
+  template<typename TreeType, typename R = RuleType>
+  auto LeafBaseCases(TreeType& queryNode,
+                     TreeType& referenceNode,
+                     size_t& numBaseCases)
+      -> decltype(std::declval<R&>().LeafBaseCases(queryNode, referenceNode,
+          numBaseCases))
+  {
+    const size_t oldBaseCases = numBaseCases;
+    const bool done = rule.LeafBaseCases(queryNode, referenceNode,
+        numBaseCases);
+    for (size_t i = oldBaseCases; i < numBaseCases; ++i)
+      trace.BaseCase();
+    return done;
+  }
+
+  //! Score and record a query point and a reference node.
+  template<typename TreeType>
+  double Score(const size_t queryIndex, TreeType& referenceNode)
+  {
+    const double score = rule.Score(queryIndex, referenceNode);
+    trace.Score(TraversalTrace::Depth(referenceNode), &referenceNode, score);
+    return score;
+  }
+
+  //! Score and record a query node and a reference node.
+  template<typename TreeType>
+  double Score(TreeType& queryNode, TreeType& referenceNode)
+  {
+    const double score = rule.Score(queryNode, referenceNode);
+    trace.Score(PairDepth(queryNode, referenceNode), &referenceNode, score);
+    return score;
+  }
+
+  //! Rescore and record a query point and a reference node.
+  template<typename TreeType>
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    const double score = rule.Rescore(queryIndex, referenceNode, oldScore);
+    trace.Rescore(TraversalTrace::Depth(referenceNode), &referenceNode,
+        oldScore, score);
+    return score;
+  }
+
+  //! Rescore and record a query node and a reference node.
+  template<typename TreeType>
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    const double score = rule.Rescore(queryNode, referenceNode, oldScore);
+    trace.Rescore(PairDepth(queryNode, referenceNode), &referenceNode,
+        oldScore, score);
+    return score;
+  }
+
+  //! Forward to the traversal information of the rules.
+  template<typename R = RuleType>
+  auto TraversalInfo() -> decltype(std::declval<R&>().TraversalInfo())
+  {
+    return rule.TraversalInfo();
+  }
+
+  //! Forward to the base case count of the rules.
+  template<typename R = RuleType>
+  auto BaseCases() -> decltype(std::declval<R&>().BaseCases())
+  {
+    return rule.BaseCases();
+  }
+
+  //! Forward to the score count of the rules.
+  template<typename R = RuleType>
+  auto Scores() -> decltype(std::declval<R&>().Scores())
+  {
+    return rule.Scores();
+  }
+
+  //! Forward to the base case budget of the rules.
+  bool BudgetExhausted(const size_t baseCases)
+  {
+    return rule.BudgetExhausted(baseCases);
+  }
+
+  //! Get the trace.
+  const TraversalTrace& Trace() const { return trace; }
+  //! Modify the trace.
+  TraversalTrace& Trace() { return trace; }
+
+ private:
+  //! The depth of a pair of nodes.
+  template<typename TreeType>
+  static size_t PairDepth(const TreeType& queryNode,
+                          const TreeType& referenceNode)
+  {
+    return std::max(TraversalTrace::Depth(queryNode),
+        TraversalTrace::Depth(referenceNode));
+  }
+
+  //! The wrapped rules.
+  RuleType& rule;
+  //! The statistics of the traversal.
+  TraversalTrace trace;
+};
+
+/**
+ * Move the trace of the given traced rules (for instance, the rules of one
+ * thread of a parallel traversal) into the trace of the other traced rules.
+ */
+template<typename RuleType>
+void MergeTrace(TracedRules<RuleType>& rule, TracedRules<RuleType>& other)
+{
+  rule.Trace().Merge(other.Trace());
+}
+
+//! Rules that are not traced have no trace to merge.
+template<typename RuleType>
+void MergeTrace(RuleType& /* rule */, RuleType& /* other */) { }
+
+#ifdef MLPACK_TRAVERSAL_TRACE
+
+//! The type the traversers hold their rules as: traced rules.
+template<typename RuleType>
+using TraversalRules = TracedRules<RuleType>;
+
+#else
+
+//! The type the traversers hold their rules as: a plain reference.
+template<typename RuleType>
+using TraversalRules = RuleType&;
+
+#endif
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
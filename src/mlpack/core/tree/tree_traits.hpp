@@ -100,6 +100,28 @@ class TreeTraits
   static const bool BinaryTree = false;
 };
 
+/**
+ * ParallelDualTreeTraversal<TreeType>::Type is the dual-tree traverser to use
+ * for the given tree type when the traversal should run on several threads.
+ * By default this is the tree's DualTreeTraverser, since most trees have no
+ * parallel traverser; the BinarySpaceTree specialization selects its
+ * ParallelDualTreeTraverser.
+ *
+ * @code
+ * typedef tree::KDTree<metric::EuclideanDistance, RangeSearchStat, arma::mat>
+ *     TreeType;
+ * RangeSearch<metric::EuclideanDistance, arma::mat, tree::KDTree,
+ *     tree::ParallelDualTreeTraversal<TreeType>::Type> rs(data);
+ * @endcode
+ */
+template<typename TreeType>
+struct ParallelDualTreeTraversal
+{
+  //! The traverser type for the given rules.
+  template<typename RuleType>
+  using Type = typename TreeType::template DualTreeTraverser<RuleType>;
+};
+
 } // namespace tree
 } // namespace mlpack
 
@@ -7,6 +7,8 @@
 #ifndef MLPACK_CORE_UTIL_ARMA_TRAITS_HPP
 #define MLPACK_CORE_UTIL_ARMA_TRAITS_HPP
 
+#include "sfinae_utility.hpp"
+
 // Structs have public members by default (that's why they are chosen over
 // classes).
 
@@ -86,4 +88,55 @@ struct IsVector<arma::SpSubview<eT> >
   const static bool value = true;
 };
 
+/**
+ * If value == true, then VecType is a sparse Armadillo column (or a subview of
+ * one column of a sparse matrix), whose nonzero elements can be walked in order
+ * of their row with a const_iterator.
+ */
+template<typename VecType>
+struct IsSparseColumn
+{
+  const static bool value = false;
+};
+
+template<typename eT>
+struct IsSparseColumn<arma::SpCol<eT> >
+{
+  const static bool value = true;
+};
+
+template<typename eT>
+struct IsSparseColumn<arma::SpSubview<eT> >
+{
+  const static bool value = true;
+};
+
+HAS_MEM_FUNC(sync, HasSyncCheck);
+
+/**
+ * Write the pending element writes of the given sparse matrix to its
+ * compressed sparse column arrays (values, row_indices and col_ptrs).  This
+ * must be called before these arrays are read directly: versions of Armadillo
+ * that cache element writes (through the element access operators) only update
+ * the arrays in SpMat::sync(), or in the operations which need them.  Older
+ * versions have no such cache, and nothing is done.
+ */
+template<typename eT>
+inline void SyncSparse(const arma::SpMat<eT>& matrix,
+                       const typename boost::enable_if_c<HasSyncCheck<
+                           arma::SpMat<eT>, void(arma::SpMat<eT>::*)() const
+                           >::value>::type* = 0)
+{
+  matrix.sync();
+}
+
+template<typename eT>
+inline void SyncSparse(const arma::SpMat<eT>& /* matrix */,
+                       const typename boost::disable_if_c<HasSyncCheck<
+                           arma::SpMat<eT>, void(arma::SpMat<eT>::*)() const
+                           >::value>::type* = 0)
+{
+  // Nothing to do: the arrays are always up to date.
+}
+
 #endif
@@ -4,6 +4,8 @@
  *
  * Implementation of the CLI module for parsing parameters.
  */
+#include <algorithm>
+#include <fstream>
 #include <list>
 #include <boost/program_options.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -11,6 +13,8 @@
 
 #include "cli.hpp"
 #include "log.hpp"
+#include "thread_pool.hpp"
+#include "version.hpp"
 
 using namespace mlpack;
 using namespace mlpack::util;
@@ -60,6 +64,18 @@ CLI::~CLI()
       Timer::Stop(i);
   }
 
+  // The tracked allocations of each category are counters of the program.
+  if (HasParam("memory_accounting") && MemoryAccounting::Supported())
+  {
+    for (size_t i = 0; i < MemoryAccounting::CATEGORIES; ++i)
+      timer.AddToCounter(std::string("allocations/") +
+          MemoryAccounting::Name(i), MemoryAccounting::Allocations(
+          (MemoryAccounting::Category) i));
+  }
+
+  if (HasParam("profile_output") && !HasParam("help") && !HasParam("info"))
+    WriteProfile(GetParam<std::string>("profile_output"));
+
   // Did the user ask for verbose output?  If so we need to print everything.
   // But only if the user did not ask for help or info.
   if (HasParam("verbose") && !HasParam("help") && !HasParam("info"))
@@ -68,13 +84,65 @@ CLI::~CLI()
     Print();
 
     Log::Info << "Program timers:" << std::endl;
+    const std::map<std::string, HardwareCounters::Counts> hardwareCounts =
+        timer.GetAllHardwareCounts();
+    const std::map<std::string, MemoryUsage> memoryUsage =
+        timer.GetAllMemoryUsage();
     std::map<std::string, std::chrono::microseconds>::iterator it;
     for (it = timer.GetAllTimers().begin(); it != timer.GetAllTimers().end();
         ++it)
     {
-      std::string i = (*it).first;
-      Log::Info << "  " << i << ": ";
-      timer.PrintTimer((*it).first);
+      // Child timers ("parent/child") follow their parents, indented.
+      const std::string& name = (*it).first;
+      const size_t depth = std::count(name.begin(), name.end(), '/');
+      Log::Info << std::string(2 * (depth + 1), ' ')
+          << name.substr(name.rfind('/') + 1) << ": ";
+      timer.PrintTimer(name);
+
+      // The hardware counts of the timer follow it, if they were counted.
+      std::map<std::string, HardwareCounters::Counts>::const_iterator counts =
+          hardwareCounts.find(name);
+      if (counts != hardwareCounts.end())
+      {
+        Log::Info << std::string(2 * (depth + 2), ' ');
+        for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+        {
+          Log::Info << (i == 0 ? "" : ", ") << HardwareCounters::Name(i)
+              << ": " << counts->second[i];
+        }
+        if (counts->second[HardwareCounters::CYCLES] > 0)
+        {
+          Log::Info << " (IPC " << double(counts->second[
+              HardwareCounters::INSTRUCTIONS]) /
+              counts->second[HardwareCounters::CYCLES] << ")";
+        }
+        Log::Info << std::endl;
+      }
+
+      // So does its memory usage, if it was measured.
+      std::map<std::string, MemoryUsage>::const_iterator usage =
+          memoryUsage.find(name);
+      if (usage != memoryUsage.end())
+      {
+        Log::Info << std::string(2 * (depth + 2), ' ') << "peak_rss_increase: "
+            << usage->second.peakRSSIncrease << " bytes";
+        if (MemoryAccounting::Supported())
+        {
+          Log::Info << ", peak_tracked_bytes: "
+              << usage->second.peakTrackedBytes << " bytes, allocations: "
+              << usage->second.allocations;
+        }
+        Log::Info << std::endl;
+      }
+    }
+
+    const std::map<std::string, uint64_t> counters = timer.GetAllCounters();
+    if (!counters.empty())
+    {
+      Log::Info << "Program counters:" << std::endl;
+      for (std::map<std::string, uint64_t>::const_iterator it =
+           counters.begin(); it != counters.end(); ++it)
+        Log::Info << "  " << it->first << ": " << it->second << std::endl;
     }
   }
 
@@ -87,6 +155,140 @@ CLI::~CLI()
   return;
 }
 
+// Escape the given string for a JSON string literal.
+static std::string EscapeJSON(const std::string& str)
+{
+  std::string escaped;
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] == '"' || str[i] == '\\')
+      escaped += '\\';
+    escaped += str[i];
+  }
+  return escaped;
+}
+
+void CLI::WriteProfile(const std::string& filename)
+{
+  std::ofstream stream(filename.c_str());
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open '" << filename << "' to write the profile."
+        << std::endl;
+    return;
+  }
+
+  const size_t threads = ThreadPool::Threads();
+  const uint64_t peakRSS = MemoryAccounting::PeakRSS();
+
+  // Timers are written in seconds.
+  std::map<std::string, double> timers;
+  const std::map<std::string, std::chrono::microseconds>& allTimers =
+      timer.GetAllTimers();
+  for (std::map<std::string, std::chrono::microseconds>::const_iterator it =
+       allTimers.begin(); it != allTimers.end(); ++it)
+    timers[it->first] = it->second.count() / 1e6;
+  const std::map<std::string, uint64_t> counters = timer.GetAllCounters();
+  const std::map<std::string, HardwareCounters::Counts> hardwareCounts =
+      timer.GetAllHardwareCounts();
+  const std::map<std::string, MemoryUsage> memoryUsage =
+      timer.GetAllMemoryUsage();
+
+  std::string extension = filename.substr(filename.rfind('.') + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+      ::tolower);
+
+  stream.precision(9);
+  if (extension == "json")
+  {
+    stream << "{\n  \"program\": \"" << EscapeJSON(programName) << "\",\n"
+        << "  \"version\": \"" << EscapeJSON(util::GetVersion()) << "\",\n"
+        << "  \"threads\": " << threads << ",\n"
+        << "  \"peak_rss_bytes\": " << peakRSS << ",\n"
+        << "  \"timers\": {";
+    for (std::map<std::string, double>::const_iterator it = timers.begin();
+         it != timers.end(); ++it)
+    {
+      stream << (it == timers.begin() ? "\n" : ",\n") << "    \""
+          << EscapeJSON(it->first) << "\": " << std::fixed << it->second;
+    }
+    stream << (timers.empty() ? "},\n" : "\n  },\n") << "  \"counters\": {";
+    for (std::map<std::string, uint64_t>::const_iterator it = counters.begin();
+         it != counters.end(); ++it)
+    {
+      stream << (it == counters.begin() ? "\n" : ",\n") << "    \""
+          << EscapeJSON(it->first) << "\": " << it->second;
+    }
+    stream << (counters.empty() ? "}" : "\n  }");
+    if (!hardwareCounts.empty())
+    {
+      // The hardware counts of each timer, if they were counted.
+      stream << ",\n  \"hardware_counters\": {";
+      for (std::map<std::string, HardwareCounters::Counts>::const_iterator it =
+           hardwareCounts.begin(); it != hardwareCounts.end(); ++it)
+      {
+        stream << (it == hardwareCounts.begin() ? "\n" : ",\n") << "    \""
+            << EscapeJSON(it->first) << "\": {";
+        for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+        {
+          stream << (i == 0 ? " \"" : ", \"") << HardwareCounters::Name(i)
+              << "\": " << it->second[i];
+        }
+        stream << " }";
+      }
+      stream << "\n  }";
+    }
+    if (!memoryUsage.empty())
+    {
+      // The memory usage of each timer, if it was measured.
+      stream << ",\n  \"memory\": {";
+      for (std::map<std::string, MemoryUsage>::const_iterator it =
+           memoryUsage.begin(); it != memoryUsage.end(); ++it)
+      {
+        stream << (it == memoryUsage.begin() ? "\n" : ",\n") << "    \""
+            << EscapeJSON(it->first) << "\": { \"peak_rss_increase\": "
+            << it->second.peakRSSIncrease << ", \"peak_tracked_bytes\": "
+            << it->second.peakTrackedBytes << ", \"allocations\": "
+            << it->second.allocations << " }";
+      }
+      stream << "\n  }";
+    }
+    stream << "\n}\n";
+  }
+  else
+  {
+    // Names never hold commas, so no quoting is needed.
+    stream << "type,name,value\n"
+        << "info,threads," << threads << "\n"
+        << "info,peak_rss_bytes," << peakRSS << "\n";
+    for (std::map<std::string, double>::const_iterator it = timers.begin();
+         it != timers.end(); ++it)
+      stream << "timer," << it->first << "," << std::fixed << it->second
+          << "\n";
+    for (std::map<std::string, uint64_t>::const_iterator it = counters.begin();
+         it != counters.end(); ++it)
+      stream << "counter," << it->first << "," << it->second << "\n";
+    // The type of hardware counts is their event, such as "cycles".
+    for (std::map<std::string, HardwareCounters::Counts>::const_iterator it =
+         hardwareCounts.begin(); it != hardwareCounts.end(); ++it)
+      for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+        stream << HardwareCounters::Name(i) << "," << it->first << ","
+            << it->second[i] << "\n";
+    for (std::map<std::string, MemoryUsage>::const_iterator it =
+         memoryUsage.begin(); it != memoryUsage.end(); ++it)
+      stream << "peak_rss_increase," << it->first << ","
+          << it->second.peakRSSIncrease << "\n"
+          << "peak_tracked_bytes," << it->first << ","
+          << it->second.peakTrackedBytes << "\n"
+          << "allocations," << it->first << "," << it->second.allocations
+          << "\n";
+  }
+
+  if (!stream.good())
+    Log::Warn << "Error writing the profile to '" << filename << "'."
+        << std::endl;
+}
+
 /**
  * Adds a parameter to the hierarchy. Use char* and not std::string since the
  * vast majority of use cases will be literal strings.
@@ -411,6 +613,54 @@ void CLI::ParseCommandLine(int argc, char** line)
   UpdateGmap();
   DefaultMessages();
   RequiredOptions();
+
+  // Set the number of threads of every parallel method.
+  const int threads = GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "non-negative." << std::endl;
+#ifdef _OPENMP
+  ThreadPool::SetThreads((size_t) threads);
+#else
+  if (threads > 1)
+    Log::Warn << "--threads (-j) is ignored because mlpack was compiled "
+        << "without OpenMP." << std::endl;
+#endif
+
+  if (HasParam("hardware_counters"))
+  {
+    if (!HardwareCounters::Supported())
+    {
+      Log::Warn << "mlpack was not compiled with hardware counter support "
+          << "(-DUSE_PERF_EVENTS=ON); ignoring --hardware_counters."
+          << std::endl;
+    }
+    else if (!GetSingleton().timer.EnableHardwareCounters())
+    {
+      Log::Warn << "Cannot open the hardware performance counters (see "
+          << "/proc/sys/kernel/perf_event_paranoid); ignoring "
+          << "--hardware_counters." << std::endl;
+    }
+    else
+    {
+      // Restart the total time, so that it is counted too.
+      Timer::Start("total_time");
+    }
+  }
+
+  if (HasParam("memory_accounting"))
+  {
+    if (!MemoryAccounting::Supported())
+    {
+      Log::Warn << "mlpack was not compiled with memory accounting "
+          << "(-DMEMORY_ACCOUNTING=ON); only the peak resident set size is "
+          << "measured." << std::endl;
+    }
+
+    GetSingleton().timer.EnableMemoryAccounting();
+    // Restart the total time, so that it is measured too.
+    Timer::Start("total_time");
+  }
 }
 
 /*
@@ -722,3 +972,17 @@ PARAM_STRING("info", "Get help on a specific module or option.", "", "");
 PARAM_FLAG("verbose", "Display informational messages and the full list of "
     "parameters and timers at the end of execution.", "v");
 PARAM_FLAG("version", "Display the version of mlpack.", "V");
+PARAM_STRING("profile_output", "If specified, write all timers and counters, "
+    "the number of threads and the peak memory usage to this file, as JSON "
+    "(.json) or CSV (.csv).", "", "");
+PARAM_INT("threads", "Number of threads to use for the parallel parts of the "
+    "program (if 0, the OpenMP default is used).", "j", 0);
+PARAM_FLAG("hardware_counters", "Count the cycles, instructions, last-level "
+    "cache misses and branch misses of each timer, and print them with the "
+    "timers (with --verbose) and in the profile (--profile_output).  This "
+    "requires Linux, and mlpack built with -DUSE_PERF_EVENTS=ON.", "");
+PARAM_FLAG("memory_accounting", "Measure the increase of the peak resident "
+    "set size of each timer and, if mlpack was built with "
+    "-DMEMORY_ACCOUNTING=ON, the peak memory and the number of allocations of "
+    "Armadillo objects and tree nodes; print them with the timers (with "
+    "--verbose) and in the profile (--profile_output).", "");
@@ -691,6 +691,8 @@ class CLI
 
   //! So that Timer::Start() and Timer::Stop() can access the timer variable.
   friend class Timer;
+  //! So that Counter::Add() can access the timer variable.
+  friend class Counter;
 
  public:
   //! Pointer to the ProgramDoc object.
@@ -726,6 +728,15 @@ class CLI
    */
   static void UpdateGmap();
 
+  /**
+   * Writes every timer and counter, the number of threads and the peak
+   * resident set size to the given file, as JSON (.json) or as CSV (any other
+   * extension), for --profile_output.
+   *
+   * @param filename Name of the file to write.
+   */
+  void WriteProfile(const std::string& filename);
+
   /**
    * Make the constructor private, to preclude unauthorized instances.
    */
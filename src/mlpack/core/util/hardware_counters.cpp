@@ -0,0 +1,181 @@
+/**
+ * @file hardware_counters.cpp
+ *
+ * Implementation of HardwareCounters with perf_event_open().
+ */
+#include "hardware_counters.hpp"
+
+#ifdef HAS_PERF_EVENTS
+  #include <cstring>
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #include <thread>
+#endif
+
+using namespace mlpack;
+
+#ifdef HAS_PERF_EVENTS
+
+namespace {
+
+/**
+ * The counters of one thread, opened as one group led by the cycle counter, so
+ * that all of them are scheduled on the processor together.
+ */
+class ThreadCounters
+{
+ public:
+  ThreadCounters() : leader(-1)
+  {
+    const uint64_t configs[HardwareCounters::EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+    size_t opened = 0;
+    bool excludeKernel = false;
+    for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+    {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.disabled = (leader == -1) ? 1 : 0;
+      attr.exclude_kernel = excludeKernel ? 1 : 0;
+      attr.exclude_hv = 1;
+
+      // Count the calling thread, on any processor.
+      fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fds[i] == -1 && i == 0)
+      {
+        // Without kernel events, which may be forbidden.
+        excludeKernel = true;
+        attr.exclude_kernel = 1;
+        fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+      }
+
+      // Without cycles, nothing is counted.
+      if (fds[i] == -1 && i == 0)
+        break;
+      if (i == 0)
+        leader = fds[0];
+      // The values of the group are read in the order the events were opened.
+      position[i] = (fds[i] == -1) ? size_t(-1) : opened++;
+    }
+
+    if (leader != -1)
+    {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+
+  ~ThreadCounters()
+  {
+    if (leader == -1)
+      return;
+    for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+      if (fds[i] != -1)
+        close(fds[i]);
+  }
+
+  bool Read(HardwareCounters::Counts& counts) const
+  {
+    if (leader == -1)
+      return false;
+
+    // The number of values, then the values.
+    uint64_t values[1 + HardwareCounters::EVENTS];
+    if (read(leader, values, sizeof(values)) < (ssize_t) sizeof(uint64_t))
+      return false;
+
+    for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+    {
+      counts[i] = (position[i] < values[0] && position[i] != size_t(-1)) ?
+          values[1 + position[i]] : 0;
+    }
+    return true;
+  }
+
+ private:
+  //! The file descriptor of each event (-1 if it couldn't be opened).
+  int fds[HardwareCounters::EVENTS];
+  //! The position of each event in the values of the group.
+  size_t position[HardwareCounters::EVENTS];
+  //! The file descriptor of the group leader (-1 if nothing is counted).
+  int leader;
+
+  // The file descriptors are closed once.
+  ThreadCounters(const ThreadCounters&);
+  ThreadCounters& operator=(const ThreadCounters&);
+};
+
+//! The main thread (the one which initializes the static objects).
+const std::thread::id mainThread = std::this_thread::get_id();
+
+//! The counters of the calling thread (NULL until they are first read).
+thread_local ThreadCounters* localCounters = NULL;
+
+/**
+ * Closes the counters of a thread when it exits, except those of the main
+ * thread: the CLI singleton stops the program timers after the thread-local
+ * objects of the main thread are destroyed, so its counters are left to be
+ * closed by the system at exit.
+ */
+struct ThreadCountersCloser
+{
+  void Touch() { }
+
+  ~ThreadCountersCloser()
+  {
+    if (std::this_thread::get_id() != mainThread)
+    {
+      delete localCounters;
+      localCounters = NULL;
+    }
+  }
+};
+
+thread_local ThreadCountersCloser closer;
+
+} // anonymous namespace
+
+bool HardwareCounters::Supported()
+{
+  return true;
+}
+
+bool HardwareCounters::Read(Counts& counts)
+{
+  if (localCounters == NULL)
+  {
+    localCounters = new ThreadCounters();
+    closer.Touch();
+  }
+
+  return localCounters->Read(counts);
+}
+
+#else
+
+bool HardwareCounters::Supported()
+{
+  return false;
+}
+
+bool HardwareCounters::Read(Counts& /* counts */)
+{
+  return false;
+}
+
+#endif
+
+const char* HardwareCounters::Name(const size_t event)
+{
+  static const char* names[EVENTS] = { "cycles", "instructions", "llc_misses",
+      "branch_misses" };
+  return (event < EVENTS) ? names[event] : "";
+}
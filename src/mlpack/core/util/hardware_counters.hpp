@@ -0,0 +1,63 @@
+/**
+ * @file hardware_counters.hpp
+ *
+ * Access to the hardware performance counters of the calling thread (cycles,
+ * instructions, last-level cache misses and branch misses), through
+ * perf_event_open() on Linux.  The timers use them to report what each timed
+ * scope spent its time on.
+ */
+#ifndef MLPACK_CORE_UTIL_HARDWARE_COUNTERS_HPP
+#define MLPACK_CORE_UTIL_HARDWARE_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace mlpack {
+
+/**
+ * The hardware performance counters of the calling thread.  Each thread opens
+ * its counters the first time it reads them, and closes them when it exits;
+ * only the events of the calling thread are counted, in user and kernel mode
+ * as allowed by the system.
+ *
+ * The counters are only available if mlpack was built with
+ * -DUSE_PERF_EVENTS=ON on Linux, and if the system allows them (see
+ * /proc/sys/kernel/perf_event_paranoid); otherwise Read() returns false.
+ */
+class HardwareCounters
+{
+ public:
+  //! The counted events.
+  enum Event
+  {
+    CYCLES = 0,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    EVENTS
+  };
+
+  //! The values of every event.
+  typedef std::array<uint64_t, EVENTS> Counts;
+
+  //! Return whether mlpack was built with hardware counter support.
+  static bool Supported();
+
+  /**
+   * Read the counters of the calling thread, opening them the first time.
+   * Events which the processor does not count are read as 0.
+   *
+   * @param counts Output: the values of the counters.
+   * @return false if the counters can't be opened.
+   */
+  static bool Read(Counts& counts);
+
+  //! Get the name of the given event ("cycles", "instructions", "llc_misses"
+  //! or "branch_misses").
+  static const char* Name(const size_t event);
+};
+
+} // namespace mlpack
+
+#endif
@@ -46,6 +46,16 @@ namespace mlpack {
  * mode.  Messages to Log::Info will only be shown when the --verbose flag is
  * given to the program (or rather, the CLI class).
  *
+ * The arguments of messages which are not shown are still evaluated, though.
+ * In loops, or when the arguments are expensive to compute, use MLPACK_LOG(),
+ * which skips the whole message if the stream is disabled (and compiles it out
+ * entirely for Log::Debug in non-debug mode):
+ *
+ * @code
+ * MLPACK_LOG(Log::Debug) << "Gradient norm " << arma::norm(gradient, 2) << "."
+ *     << std::endl;
+ * @endcode
+ *
  * @see PrefixedOutStream, NullOutStream, CLI
  */
 class Log
@@ -90,4 +100,12 @@ class Log
 
 }; //namespace mlpack
 
+/**
+ * Write a message to the given log stream (such as Log::Info) only if the
+ * stream is enabled; otherwise, the arguments of the message are not
+ * evaluated.  This is a single statement, so it can be used as the body of an
+ * if without braces.
+ */
+#define MLPACK_LOG(stream) if (!(stream).Enabled()) { } else (stream)
+
 #endif
@@ -0,0 +1,144 @@
+/**
+ * @file memory_accounting.cpp
+ *
+ * Implementation of MemoryAccounting.
+ */
+#include "memory_accounting.hpp"
+
+#include <cstdlib>
+
+#if defined(_WIN32)
+  #include <malloc.h>
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+using namespace mlpack;
+
+namespace {
+
+//! The tracked bytes currently allocated.
+std::atomic<uint64_t> currentBytes(0);
+//! The peak of the tracked bytes.
+std::atomic<uint64_t> peakBytes(0);
+//! The number of allocations of each category.
+std::atomic<uint64_t> allocations[MemoryAccounting::CATEGORIES];
+
+//! Raise the peak to the given value, if it is higher.
+void RaisePeak(const uint64_t bytes)
+{
+  uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+  while (bytes > peak &&
+      !peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+  { }
+}
+
+} // anonymous namespace
+
+void* MemoryAccounting::Allocate(const size_t bytes,
+                                 const Category category,
+                                 const size_t alignment)
+{
+  // The size and the alignment are stored just before the returned memory, in
+  // a header of one alignment unit.
+  void* base = NULL;
+#if defined(_WIN32)
+  base = _aligned_malloc(bytes + alignment, alignment);
+#else
+  if (posix_memalign(&base, alignment, bytes + alignment) != 0)
+    base = NULL;
+#endif
+  if (base == NULL)
+    throw std::bad_alloc();
+
+  char* memory = static_cast<char*>(base) + alignment;
+  reinterpret_cast<uint64_t*>(memory)[-2] = bytes;
+  reinterpret_cast<uint64_t*>(memory)[-1] = alignment;
+
+  allocations[category].fetch_add(1, std::memory_order_relaxed);
+  RaisePeak(currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+
+  return memory;
+}
+
+void MemoryAccounting::Free(void* memory, const Category /* category */)
+{
+  if (memory == NULL)
+    return;
+
+  const uint64_t bytes = reinterpret_cast<uint64_t*>(memory)[-2];
+  const uint64_t alignment = reinterpret_cast<uint64_t*>(memory)[-1];
+  currentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+
+  void* base = static_cast<char*>(memory) - alignment;
+#if defined(_WIN32)
+  _aligned_free(base);
+#else
+  free(base);
+#endif
+}
+
+uint64_t MemoryAccounting::CurrentBytes()
+{
+  return currentBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryAccounting::PeakBytes()
+{
+  return peakBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryAccounting::Allocations(const Category category)
+{
+  return allocations[category].load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryAccounting::Allocations()
+{
+  uint64_t total = 0;
+  for (size_t i = 0; i < CATEGORIES; ++i)
+    total += Allocations((Category) i);
+  return total;
+}
+
+uint64_t MemoryAccounting::BeginPeak()
+{
+  // The peak of the scope starts at the current usage; the peak before the
+  // scope is restored (if higher) when it ends.
+  return peakBytes.exchange(currentBytes.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+}
+
+uint64_t MemoryAccounting::EndPeak(const uint64_t state)
+{
+  const uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+  RaisePeak(state);
+  return peak;
+}
+
+uint64_t MemoryAccounting::PeakRSS()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return counters.PeakWorkingSetSize;
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  #if defined(__APPLE__)
+  return usage.ru_maxrss; // Already in bytes.
+  #else
+  return uint64_t(usage.ru_maxrss) * 1024;
+  #endif
+#endif
+}
+
+const char* MemoryAccounting::Name(const size_t category)
+{
+  static const char* names[CATEGORIES] = { "armadillo", "tree_nodes" };
+  return (category < CATEGORIES) ? names[category] : "";
+}
@@ -0,0 +1,172 @@
+/**
+ * @file memory_accounting.hpp
+ *
+ * Accounting of the memory used by mlpack: the resident set size of the
+ * process, and (if mlpack is built with -DMEMORY_ACCOUNTING=ON) the memory
+ * allocated for Armadillo objects and tree nodes.  The timers use it to report
+ * the memory used by each timed scope.
+ *
+ * This header is included before Armadillo, so it only depends on the standard
+ * library and on arma_config.hpp (which defines MLPACK_MEMORY_ACCOUNTING).
+ */
+#ifndef MLPACK_CORE_UTIL_MEMORY_ACCOUNTING_HPP
+#define MLPACK_CORE_UTIL_MEMORY_ACCOUNTING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "arma_config.hpp"
+
+namespace mlpack {
+
+/**
+ * The memory usage of a timer: how much it raised the peak resident set size
+ * of the process, the peak of the tracked memory while it ran, and the number
+ * of tracked allocations it made.  Tracked memory is only counted if mlpack
+ * was built with -DMEMORY_ACCOUNTING=ON.
+ */
+struct MemoryUsage
+{
+  MemoryUsage() : peakRSSIncrease(0), peakTrackedBytes(0), allocations(0) { }
+
+  //! The increase of the peak resident set size of the process, in bytes.
+  uint64_t peakRSSIncrease;
+  //! The peak of the tracked memory, in bytes.
+  uint64_t peakTrackedBytes;
+  //! The number of tracked allocations.
+  uint64_t allocations;
+};
+
+/**
+ * MemoryAccounting keeps the totals of the tracked memory: the memory of
+ * Armadillo objects (for Armadillo versions which support
+ * ARMA_ALIEN_MEM_ALLOC_FUNCTION) and of tree nodes, when mlpack is built with
+ * -DMEMORY_ACCOUNTING=ON.  Allocations are counted with atomic operations, so
+ * they may happen on any thread.
+ *
+ * The peak of the tracked memory can be measured for a scope with BeginPeak()
+ * and EndPeak(), which nest; scopes running on several threads at once see the
+ * peak of the whole process.
+ */
+class MemoryAccounting
+{
+ public:
+  //! The kinds of tracked memory.
+  enum Category
+  {
+    ARMADILLO = 0,
+    TREE_NODES,
+    CATEGORIES
+  };
+
+  //! Return whether allocations are tracked (that is, whether mlpack was built
+  //! with -DMEMORY_ACCOUNTING=ON).
+  static bool Supported()
+  {
+#ifdef MLPACK_MEMORY_ACCOUNTING
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Allocate the given number of bytes, aligned to the given alignment (a
+   * power of 2, at least 16), and count them in the given category.  A
+   * std::bad_alloc exception is thrown if the memory can't be allocated.
+   *
+   * @param bytes Number of bytes to allocate.
+   * @param category Category of the memory.
+   * @param alignment Alignment of the memory.
+   */
+  static void* Allocate(const size_t bytes,
+                        const Category category,
+                        const size_t alignment = 16);
+
+  /**
+   * Free memory allocated with Allocate(), and uncount it.
+   *
+   * @param memory Memory to free (it may be NULL).
+   * @param category Category of the memory.
+   */
+  static void Free(void* memory, const Category category);
+
+  //! Allocate memory for Armadillo (see ARMA_ALIEN_MEM_ALLOC_FUNCTION).
+  static void* AllocateArmadillo(const size_t bytes)
+  {
+    return Allocate(bytes, ARMADILLO, 32);
+  }
+
+  //! Free memory allocated for Armadillo.
+  static void FreeArmadillo(void* memory) { Free(memory, ARMADILLO); }
+
+  //! Get the number of tracked bytes currently allocated.
+  static uint64_t CurrentBytes();
+
+  //! Get the peak of the tracked bytes (since the start of the program, or of
+  //! the innermost running scope of BeginPeak()).
+  static uint64_t PeakBytes();
+
+  //! Get the number of allocations of the given category so far.
+  static uint64_t Allocations(const Category category);
+
+  //! Get the number of tracked allocations of all categories so far.
+  static uint64_t Allocations();
+
+  /**
+   * Start measuring the peak of the tracked memory of a scope, and return the
+   * state to give to EndPeak() at the end of the scope.
+   */
+  static uint64_t BeginPeak();
+
+  /**
+   * Finish measuring the peak of the tracked memory of a scope, and return it.
+   *
+   * @param state The value returned by BeginPeak() at the start of the scope.
+   */
+  static uint64_t EndPeak(const uint64_t state);
+
+  //! Get the peak resident set size of the process, in bytes (0 if unknown).
+  static uint64_t PeakRSS();
+
+  //! Get the name of the given category ("armadillo" or "tree_nodes").
+  static const char* Name(const size_t category);
+};
+
+/**
+ * Objects of classes derived from AccountedAllocation<Category> are allocated
+ * with MemoryAccounting (when mlpack is built with -DMEMORY_ACCOUNTING=ON), so
+ * that they are counted in the given category.  The base class is empty, so it
+ * doesn't change the size of the derived class.
+ */
+template<MemoryAccounting::Category Category>
+class AccountedAllocation
+{
+#ifdef MLPACK_MEMORY_ACCOUNTING
+ public:
+  static void* operator new(const size_t bytes)
+  {
+    return MemoryAccounting::Allocate(bytes, Category);
+  }
+
+  static void operator delete(void* memory)
+  {
+    MemoryAccounting::Free(memory, Category);
+  }
+
+  // Placement new (used to construct objects in memory which is already
+  // allocated) must be declared again, since the overloads above hide it.
+  static void* operator new(const size_t /* bytes */, void* memory)
+  {
+    return memory;
+  }
+
+  static void operator delete(void* /* memory */, void* /* place */) { }
+#endif
+};
+
+} // namespace mlpack
+
+#endif
@@ -71,6 +71,10 @@ class NullOutStream
   //! Does nothing.
   template<typename T>
   NullOutStream& operator<<(const T&) { return *this; }
+
+  //! The stream never prints anything, so code guarded by MLPACK_LOG() is
+  //! compiled out.
+  bool Enabled() const { return false; }
 };
 
 } // namespace util
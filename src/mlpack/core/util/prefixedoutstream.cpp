@@ -8,13 +8,72 @@
 #include <string>
 #include <iostream>
 #include <streambuf>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <sstream>
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include "prefixedoutstream.hpp"
 
 using namespace mlpack::util;
 
+namespace {
+
+//! Serializes the lines written to the destinations from parallel regions.
+std::mutex bufferedWriteMutex;
+
+//! The partial lines of the calling thread, for each stream it writes to.
+thread_local std::map<const PrefixedOutStream*, std::string> lineBuffers;
+
+//! The thread that started the program (static initialization runs on it).
+const std::thread::id mainThread = std::this_thread::get_id();
+
+} // anonymous namespace
+
+bool PrefixedOutStream::Buffered() const
+{
+  if (fatal)
+    return false;
+  if (std::this_thread::get_id() != mainThread)
+    return true;
+#ifdef _OPENMP
+  return omp_in_parallel();
+#else
+  return false;
+#endif
+}
+
+void PrefixedOutStream::BufferedWrite(const std::string& output)
+{
+  std::string& buffer = lineBuffers[this];
+  buffer += output;
+
+  const size_t end = buffer.rfind('\n');
+  if (end == std::string::npos)
+    return;
+
+  // Prefix every complete line, and write them all at once.
+  std::string lines;
+  size_t pos = 0;
+  while (pos <= end)
+  {
+    const size_t nl = buffer.find('\n', pos);
+    lines += prefix;
+    lines.append(buffer, pos, nl + 1 - pos);
+    pos = nl + 1;
+  }
+  buffer.erase(0, end + 1);
+
+  std::lock_guard<std::mutex> lock(bufferedWriteMutex);
+  destination << lines << std::flush;
+}
+
 /**
  * These are all necessary because gcc's template mechanism does not seem smart
  * enough to figure out what I want to pass into operator<< without these.  That
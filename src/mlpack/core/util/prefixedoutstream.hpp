@@ -47,6 +47,13 @@ namespace util {
  *
  * These objects are used for the mlpack::Log levels (DEBUG, INFO, WARN, and
  * FATAL).
+ *
+ * Inside OpenMP parallel regions (and on threads other than the one that
+ * started the program, such as the thread of data::LoadAsync()), each thread
+ * collects its output in a buffer of its own, and writes it to the destination
+ * a whole line at a time, so that the lines of different threads are not
+ * interleaved.  A line written on such a thread is therefore only shown once
+ * its newline is written.
  */
 class PrefixedOutStream
 {
@@ -112,6 +119,9 @@ class PrefixedOutStream
   template<typename T>
   PrefixedOutStream& operator<<(const T& s);
 
+  //! Return whether the stream prints its input (see MLPACK_LOG()).
+  bool Enabled() const { return !ignoreInput; }
+
   //! The output stream that all data is to be sent too; example: std::cout.
   std::ostream& destination;
 
@@ -134,6 +144,23 @@ class PrefixedOutStream
    */
   inline void PrefixIfNeeded();
 
+  /**
+   * Return whether output must be buffered for the calling thread, because it
+   * is running in a parallel region or is not the thread that started the
+   * program.  Fatal streams are never buffered, since they must terminate the
+   * program as soon as a newline is written.
+   */
+  bool Buffered() const;
+
+  /**
+   * Add the given converted output to the line buffer of the calling thread,
+   * and write the complete lines of the buffer to the destination, with their
+   * prefixes.
+   *
+   * @param output Converted output.
+   */
+  void BufferedWrite(const std::string& output);
+
   //! Contains the prefix we must prepend to each line.
   std::string prefix;
 
@@ -35,12 +35,26 @@ void PrefixedOutStream::BaseLogic(const T& val)
   bool newlined = false;
   std::string line;
 
-  // If we need to, output the prefix.
-  PrefixIfNeeded();
+  // Discarded output doesn't need to be converted at all (only the fatal stream
+  // must still watch for newlines, and it is never ignored).
+  if (ignoreInput && !fatal)
+    return;
 
   std::ostringstream convert;
   convert << val;
 
+  // Output of threads in a parallel region goes to their line buffers, so that
+  // the lines they write are not interleaved.
+  if (Buffered())
+  {
+    if (!convert.fail())
+      BufferedWrite(convert.str());
+    return;
+  }
+
+  // If we need to, output the prefix.
+  PrefixIfNeeded();
+
   if (convert.fail())
   {
     PrefixIfNeeded();
@@ -0,0 +1,26 @@
+/**
+ * @file thread_pool.cpp
+ *
+ * Implementation of ThreadPool::SetThreads().
+ */
+#include "thread_pool.hpp"
+
+using namespace mlpack;
+
+#ifdef _OPENMP
+namespace {
+
+//! The number of threads of the OpenMP runtime before it is changed.
+const int defaultThreads = omp_get_max_threads();
+
+} // anonymous namespace
+#endif
+
+void ThreadPool::SetThreads(const size_t threads)
+{
+#ifdef _OPENMP
+  omp_set_num_threads((threads == 0) ? defaultThreads : (int) threads);
+#else
+  (void) threads;
+#endif
+}
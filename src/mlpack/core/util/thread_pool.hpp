@@ -0,0 +1,195 @@
+/**
+ * @file thread_pool.hpp
+ *
+ * The mlpack-wide control of parallelism: the number of threads used by every
+ * parallel method, parallel loops, and tasks for recursive algorithms such as
+ * tree traversals.  The threads are those of the OpenMP runtime; without
+ * OpenMP, everything runs serially on the calling thread.
+ */
+#ifndef MLPACK_CORE_UTIL_THREAD_POOL_HPP
+#define MLPACK_CORE_UTIL_THREAD_POOL_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#ifdef _OPENMP
+  // Tasks need OpenMP 3.0; older runtimes (such as that of MSVC) run them
+  // inline.
+  #if _OPENMP >= 200805
+    #define MLPACK_OPENMP_TASKS
+  #endif
+#endif
+
+namespace mlpack {
+
+/**
+ * The pool of threads which mlpack runs its parallel methods on.  The number
+ * of threads is set once for the whole process, with SetThreads() (or with the
+ * --threads (-j) option of the command-line programs), instead of by each
+ * method, so that methods run in one process don't oversubscribe the
+ * processors.  Parallel loops and tasks started while another parallel loop or
+ * task is running are run serially by the thread which started them, for the
+ * same reason.
+ *
+ * Recursive algorithms can spawn tasks from a root function run with Run();
+ * idle threads steal spawned tasks:
+ *
+ * @code
+ * void Visit(Node& node)
+ * {
+ *   if (!node.IsLeaf() && node.NumDescendants() > 1000)
+ *   {
+ *     ThreadPool::Spawn([&node]() { Visit(*node.Left()); });
+ *     Visit(*node.Right());
+ *     ThreadPool::Wait();
+ *   }
+ *   ...
+ * }
+ *
+ * ThreadPool::Run([&root]() { Visit(root); });
+ * @endcode
+ */
+class ThreadPool
+{
+ public:
+  /**
+   * Get the number of threads which parallel loops and tasks run on (1
+   * without OpenMP).
+   */
+  static size_t Threads()
+  {
+#ifdef _OPENMP
+    return (size_t) omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  /**
+   * Set the number of threads which parallel loops and tasks run on, for the
+   * whole process.  0 restores the default of the OpenMP runtime (which can
+   * be set with the OMP_NUM_THREADS environment variable).  Without OpenMP,
+   * this does nothing.
+   *
+   * @param threads Number of threads.
+   */
+  static void SetThreads(const size_t threads);
+
+  //! Return whether the calling thread is running a parallel loop or task, in
+  //! which case new loops and tasks run serially.
+  static bool InParallel()
+  {
+#ifdef _OPENMP
+    return omp_in_parallel() != 0;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Run the given function for every index in [begin, end), in parallel.
+   * Indices are handed out dynamically, in blocks of the given size, so that
+   * iterations of different costs are balanced.
+   *
+   * @param begin First index.
+   * @param end One past the last index.
+   * @param function Function to call with each index.
+   * @param blockSize Number of consecutive indices given to a thread at once.
+   */
+  template<typename FunctionType>
+  static void ParallelFor(const size_t begin,
+                          const size_t end,
+                          FunctionType function,
+                          const size_t blockSize = 1)
+  {
+    if (end <= begin)
+      return;
+
+#ifdef _OPENMP
+    if (Threads() > 1 && !InParallel() && end - begin > 1)
+    {
+      // Iterate over the blocks, since the chunk size of dynamic scheduling
+      // must be given as a constant expression in OpenMP 2.0.
+      const size_t blocks = (end - begin + blockSize - 1) / blockSize;
+      #pragma omp parallel for schedule(dynamic)
+      for (omp_size_t b = 0; b < (omp_size_t) blocks; ++b)
+      {
+        const size_t blockBegin = begin + (size_t) b * blockSize;
+        const size_t blockEnd = std::min(end, blockBegin + blockSize);
+        for (size_t i = blockBegin; i < blockEnd; ++i)
+          function(i);
+      }
+      return;
+    }
+#endif
+
+    for (size_t i = begin; i < end; ++i)
+      function(i);
+  }
+
+  /**
+   * Run the given function on one thread of the pool, while the other threads
+   * of the pool run the tasks it spawns (with Spawn()), and wait for all of
+   * them.  If a parallel loop or task is already running, the function is run
+   * by the calling thread, and the tasks it spawns are run by the threads of
+   * the running loop.
+   *
+   * @param function Root function of the tasks.
+   */
+  template<typename FunctionType>
+  static void Run(FunctionType function)
+  {
+#ifdef MLPACK_OPENMP_TASKS
+    if (Threads() > 1 && !InParallel())
+    {
+      #pragma omp parallel
+      {
+        #pragma omp single
+        function();
+      }
+      return;
+    }
+#endif
+
+    function();
+  }
+
+  /**
+   * Spawn a task running the given function, to be run by any thread of the
+   * pool; wait for it with Wait().  The function is copied, so it should
+   * capture the data it needs by value or by pointer (references to local
+   * variables of the spawning function are valid until it calls Wait()).
+   * Outside of Run(), the task is run immediately.
+   *
+   * @param function Function to run.
+   */
+  template<typename FunctionType>
+  static void Spawn(FunctionType function)
+  {
+#ifdef MLPACK_OPENMP_TASKS
+    if (InParallel())
+    {
+      #pragma omp task firstprivate(function)
+      function();
+      return;
+    }
+#endif
+
+    function();
+  }
+
+  //! Wait for the tasks spawned by the calling task (or by the root function
+  //! of Run()).
+  static void Wait()
+  {
+#ifdef MLPACK_OPENMP_TASKS
+    if (InParallel())
+    {
+      #pragma omp taskwait
+    }
+#endif
+  }
+};
+
+} // namespace mlpack
+
+#endif
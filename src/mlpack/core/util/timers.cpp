@@ -11,10 +11,36 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace mlpack;
 using namespace std::chrono;
 
+namespace {
+
+//! The names of all registered timers, shared by every Timers object, so that
+//! handles stay valid when the CLI singleton is re-created.
+struct TimerRegistry
+{
+  std::mutex mutex;
+  std::vector<std::string> names;
+  std::map<std::string, size_t> indices;
+};
+
+// The registry is never destroyed, since the CLI singleton, which lists the
+// timers in its destructor, may be destroyed after the static objects.
+TimerRegistry& Registry()
+{
+  static TimerRegistry* registry = new TimerRegistry();
+  return *registry;
+}
+
+//! The source of the identifiers of Timers objects (0 is never used).
+std::atomic<uint64_t> nextTimersId(1);
+
+} // anonymous namespace
+
 /**
  * Start the given timer.
  */
@@ -39,24 +65,277 @@ microseconds Timer::Get(const std::string& name)
   return CLI::GetSingleton().timer.GetTimer(name);
 }
 
+TimerHandle Timer::Register(const std::string& name)
+{
+  return Timers::Register(name);
+}
+
+TimerHandle Timer::Register(const std::string& name, const TimerHandle parent)
+{
+  return Timers::Register(Timers::Name(parent) + "/" + name);
+}
+
+void Timer::Start(const TimerHandle handle)
+{
+  CLI::GetSingleton().timer.StartTimer(handle);
+}
+
+void Timer::Stop(const TimerHandle handle)
+{
+  CLI::GetSingleton().timer.StopTimer(handle);
+}
+
+void Counter::Add(const std::string& name, const uint64_t value)
+{
+  CLI::GetSingleton().timer.AddToCounter(name, value);
+}
+
+uint64_t Counter::Get(const std::string& name)
+{
+  return CLI::GetSingleton().timer.GetCounter(name);
+}
+
+Timers::Timers() :
+    id(nextTimersId++),
+    hardwareCounters(false),
+    memoryAccounting(false)
+{
+  // Nothing else to do.
+}
+
+TimerHandle Timers::Register(const std::string& timerName)
+{
+  TimerRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::map<std::string, size_t>::const_iterator it =
+      registry.indices.find(timerName);
+  if (it != registry.indices.end())
+    return TimerHandle(it->second);
+
+  registry.indices[timerName] = registry.names.size();
+  registry.names.push_back(timerName);
+  return TimerHandle(registry.names.size() - 1);
+}
+
+std::string Timers::Name(const TimerHandle handle)
+{
+  TimerRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (handle.Index() >= registry.names.size())
+    throw std::invalid_argument("Timer: invalid timer handle");
+  return registry.names[handle.Index()];
+}
+
+Timers::ThreadTimers& Timers::LocalTimers()
+{
+  // The timers of the calling thread in each Timers object it has used, by the
+  // identifier of the object.  The timers are owned by that object, so they
+  // outlive the thread, and their totals are still counted after it exits.
+  // Identifiers are never reused, so the entries of destroyed objects are
+  // never looked up again.  The last object used is cached, since a thread
+  // usually uses a single one.
+  static thread_local std::unordered_map<uint64_t, ThreadTimers*> locals;
+  static thread_local uint64_t lastId = 0;
+  static thread_local ThreadTimers* last = NULL;
+  if (lastId == id)
+    return *last;
+
+  ThreadTimers*& local = locals[id];
+  if (local == NULL)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.emplace_back(new ThreadTimers());
+    local = threads.back().get();
+  }
+
+  lastId = id;
+  last = local;
+  return *local;
+}
+
+void Timers::Grow(ThreadTimers& local, const TimerHandle handle)
+{
+  if (handle.Index() == size_t(-1))
+    throw std::invalid_argument("Timer: invalid timer handle");
+
+  std::lock_guard<std::mutex> lock(mutex);
+  while (local.size() <= handle.Index())
+    local.emplace_back();
+}
+
+void Timers::ThrowNotRunning(const TimerHandle handle)
+{
+  std::ostringstream error;
+  error << "Timer::Stop(): timer '" << Name(handle) << "' is not running";
+  throw std::runtime_error(error.str());
+}
+
+microseconds Timers::Total(const size_t index)
+{
+  int64_t total = 0;
+  for (std::list<std::unique_ptr<ThreadTimers>>::const_iterator it =
+       threads.begin(); it != threads.end(); ++it)
+  {
+    if ((*it)->size() > index)
+      total += (**it)[index].total.load(std::memory_order_relaxed);
+  }
+
+  return duration_cast<microseconds>(nanoseconds(total));
+}
+
 std::map<std::string, microseconds>& Timers::GetAllTimers()
 {
+  std::vector<std::string> names;
+  {
+    TimerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    names = registry.names;
+  }
+
+  // Only the timers which have been started with this object are listed.
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    bool used = false;
+    for (std::list<std::unique_ptr<ThreadTimers>>::const_iterator it =
+         threads.begin(); it != threads.end() && !used; ++it)
+    {
+      used = ((*it)->size() > i &&
+          (**it)[i].used.load(std::memory_order_relaxed));
+    }
+
+    if (used)
+      timers[names[i]] = Total(i);
+  }
+
   return timers;
 }
 
+bool Timers::EnableHardwareCounters()
+{
+  // Make sure that the counters of this thread can be opened.
+  HardwareCounters::Counts counts;
+  if (!HardwareCounters::Read(counts))
+    return false;
+
+  hardwareCounters.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+std::map<std::string, HardwareCounters::Counts> Timers::GetAllHardwareCounts()
+{
+  std::vector<std::string> names;
+  {
+    TimerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    names = registry.names;
+  }
+
+  std::map<std::string, HardwareCounters::Counts> allCounts;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    bool counted = false;
+    HardwareCounters::Counts counts;
+    counts.fill(0);
+    for (std::list<std::unique_ptr<ThreadTimers>>::const_iterator it =
+         threads.begin(); it != threads.end(); ++it)
+    {
+      if ((*it)->size() <= i ||
+          !(**it)[i].counted.load(std::memory_order_relaxed))
+        continue;
+
+      counted = true;
+      for (size_t j = 0; j < HardwareCounters::EVENTS; ++j)
+        counts[j] += (**it)[i].counts[j].load(std::memory_order_relaxed);
+    }
+
+    if (counted)
+      allCounts[names[i]] = counts;
+  }
+
+  return allCounts;
+}
+
+void Timers::EnableMemoryAccounting()
+{
+  memoryAccounting.store(true, std::memory_order_relaxed);
+}
+
+std::map<std::string, MemoryUsage> Timers::GetAllMemoryUsage()
+{
+  std::vector<std::string> names;
+  {
+    TimerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    names = registry.names;
+  }
+
+  std::map<std::string, MemoryUsage> allUsage;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    bool measured = false;
+    MemoryUsage usage;
+    for (std::list<std::unique_ptr<ThreadTimers>>::const_iterator it =
+         threads.begin(); it != threads.end(); ++it)
+    {
+      if ((*it)->size() <= i ||
+          !(**it)[i].measured.load(std::memory_order_relaxed))
+        continue;
+
+      const ThreadTimer& timer = (**it)[i];
+      measured = true;
+      usage.peakRSSIncrease +=
+          timer.peakRSSIncrease.load(std::memory_order_relaxed);
+      usage.peakTrackedBytes = std::max(usage.peakTrackedBytes,
+          timer.peakTrackedBytes.load(std::memory_order_relaxed));
+      usage.allocations += timer.allocations.load(std::memory_order_relaxed);
+    }
+
+    if (measured)
+      allUsage[names[i]] = usage;
+  }
+
+  return allUsage;
+}
+
+void Timers::AddToCounter(const std::string& counterName,
+                          const uint64_t value)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  counters[counterName] += value;
+}
+
+std::map<std::string, uint64_t> Timers::GetAllCounters()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+uint64_t Timers::GetCounter(const std::string& counterName)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::map<std::string, uint64_t>::const_iterator it =
+      counters.find(counterName);
+  return (it == counters.end()) ? 0 : it->second;
+}
+
 microseconds Timers::GetTimer(const std::string& timerName)
 {
-  return timers[timerName];
+  const TimerHandle handle = Register(timerName);
+  std::lock_guard<std::mutex> lock(mutex);
+  return Total(handle.Index());
 }
 
 bool Timers::GetState(std::string timerName)
 {
-  return timerState[timerName];
+  return LocalTimer(Register(timerName)).depth > 0;
 }
 
 void Timers::PrintTimer(const std::string& timerName)
 {
-  microseconds totalDuration = timers[timerName];
+  microseconds totalDuration = GetTimer(timerName);
   // Convert microseconds to seconds.
   seconds totalDurationSec = duration_cast<seconds>(totalDuration);
   microseconds totalDurationMicroSec =
@@ -115,49 +394,54 @@ void Timers::PrintTimer(const std::string& timerName)
   Log::Info << std::endl;
 }
 
-high_resolution_clock::time_point Timers::GetTime()
-{
-  return high_resolution_clock::now();
-}
-
 void Timers::StartTimer(const std::string& timerName)
 {
-  if ((timerState[timerName] == 1) && (timerName != "total_time"))
+  ThreadTimer& timer = LocalTimer(Register(timerName));
+  if (timer.depth > 0)
   {
-    std::ostringstream error;
-    error << "Timer::Start(): timer '" << timerName
-        << "' has already been started";
-    throw std::runtime_error(error.str());
-  }
-
-  timerState[timerName] = true;
-
-  high_resolution_clock::time_point currTime = GetTime();
+    if (timerName != "total_time")
+    {
+      std::ostringstream error;
+      error << "Timer::Start(): timer '" << timerName
+          << "' has already been started";
+      throw std::runtime_error(error.str());
+    }
 
-  // If the timer is added first time
-  if (timers.count(timerName) == 0)
-  {
-    timers[timerName] = (microseconds) 0;
+    // Restarting the total time discards the running part.
+    StartCounting(timer);
+    if (!timer.measuring)
+      StartMemory(timer);
+    timer.start = GetTime();
+    return;
   }
 
-  timerStartTime[timerName] = currTime;
+  timer.depth = 1;
+  timer.used.store(true, std::memory_order_relaxed);
+  StartCounting(timer);
+  StartMemory(timer);
+  timer.start = GetTime();
 }
 
 void Timers::StopTimer(const std::string& timerName)
 {
-  if ((timerState[timerName] == 0) && (timerName != "total_time"))
+  ThreadTimer& timer = LocalTimer(Register(timerName));
+  if (timer.depth == 0)
   {
-    std::ostringstream error;
-    error << "Timer::Stop(): timer '" << timerName
-        << "' has already been stopped";
-    throw std::runtime_error(error.str());
-  }
-
-  timerState[timerName] = false;
+    if (timerName != "total_time")
+    {
+      std::ostringstream error;
+      error << "Timer::Stop(): timer '" << timerName
+          << "' has already been stopped";
+      throw std::runtime_error(error.str());
+    }
 
-  high_resolution_clock::time_point currTime = GetTime();
+    return;
+  }
 
-  // Calculate the delta time.
-  timers[timerName] += duration_cast<microseconds>(currTime -
-      timerStartTime[timerName]);
+  if (--timer.depth == 0)
+  {
+    timer.Add(GetTime() - timer.start);
+    StopCounting(timer);
+    StopMemory(timer);
+  }
 }
@@ -8,10 +8,20 @@
 #ifndef MLPACK_CORE_UTILITIES_TIMERS_HPP
 #define MLPACK_CORE_UTILITIES_TIMERS_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <cstdint>
 #include <chrono> // chrono library for cross platform timer calculation
 
+#include "hardware_counters.hpp"
+#include "memory_accounting.hpp"
+
 #if defined(_WIN32)
  // uint64_t isn't defined on every windows.
   #if !defined(HAVE_UINT64_T)
@@ -26,9 +36,55 @@
 namespace mlpack {
 
 /**
- * The timer class provides a way for mlpack methods to be timed.  The three
- * methods contained in this class allow a named timer to be started and
- * stopped, and its value to be obtained.
+ * A handle to a registered timer (see Timer::Register()), which starts and
+ * stops the timer without looking up its name.  Handles stay valid for the
+ * whole program, so they can be kept in static variables.
+ */
+class TimerHandle
+{
+ public:
+  //! Create an invalid handle.
+  TimerHandle() : index(size_t(-1)) { }
+  //! Create the handle of the timer with the given index.
+  explicit TimerHandle(const size_t index) : index(index) { }
+
+  //! Get the index of the timer.
+  size_t Index() const { return index; }
+
+ private:
+  //! The index of the timer.
+  size_t index;
+};
+
+/**
+ * The timer class provides a way for mlpack methods to be timed.  A named timer
+ * can be started and stopped, and its value obtained.
+ *
+ * Timers are thread-safe: each thread keeps its own running state and totals
+ * for every timer, and the value of a timer is the sum over all threads.
+ * Starting and stopping by name looks the name up under a lock, so code which
+ * is run many times (such as the inner phases of a tree traversal, or an
+ * iteration of EM) should register the timer once and use its handle, which
+ * only touches the data of the calling thread:
+ *
+ * @code
+ * static const TimerHandle baseCases = Timer::Register("base_cases");
+ * {
+ *   ScopedTimer timer(baseCases);
+ *   // ...
+ * }
+ * @endcode
+ *
+ * Timers started through handles may be nested, even within themselves (such as
+ * in a recursion); only the outermost start and stop of each thread are timed.
+ * A timer may be registered as the child of another, giving hierarchical names
+ * such as "tree_building/split" which are printed under their parents.
+ *
+ * If hardware counters are enabled (with --hardware_counters, when mlpack is
+ * built with -DUSE_PERF_EVENTS=ON), the cycles, instructions, last-level cache
+ * misses and branch misses of each timed scope are counted as well.  If memory
+ * accounting is enabled (with --memory_accounting), the memory used by each
+ * timed scope is measured too (see MemoryUsage).
  */
 class Timer
 {
@@ -62,21 +118,112 @@ class Timer
    * @param name Name of timer to return value of.
    */
   static std::chrono::microseconds Get(const std::string& name);
+
+  /**
+   * Register the given timer (if it hasn't been registered yet), and return
+   * its handle.  This takes a lock, so it should be done once, outside of any
+   * loop.
+   *
+   * @param name Name of the timer.
+   */
+  static TimerHandle Register(const std::string& name);
+
+  /**
+   * Register the given timer as a child of the given timer, so that its name is
+   * "parent/name", and return its handle.
+   *
+   * @param name Name of the timer, within its parent.
+   * @param parent Handle of the parent timer.
+   */
+  static TimerHandle Register(const std::string& name,
+                              const TimerHandle parent);
+
+  /**
+   * Start the given timer on the calling thread.  If it is already running on
+   * this thread, it keeps running until the matching call to Stop().
+   *
+   * @param handle Handle of timer to be started.
+   */
+  static void Start(const TimerHandle handle);
+
+  /**
+   * Stop the given timer on the calling thread, adding the time since the
+   * outermost Start() to its value.
+   *
+   * @note A std::runtime_error exception will be thrown if the timer is not
+   * running on this thread.
+   *
+   * @param handle Handle of timer to be stopped.
+   */
+  static void Stop(const TimerHandle handle);
+};
+
+/**
+ * The Counter class counts events of mlpack methods (such as base cases, scores
+ * or iterations) by name, alongside the timers; the counts are listed with the
+ * timers in verbose output and in profiles (see --profile_output).  Counters
+ * are thread-safe, but take a lock, so they should be added to once per call
+ * of a method, not in its inner loops.
+ */
+class Counter
+{
+ public:
+  /**
+   * Add the given value to the given counter (which starts at 0).
+   *
+   * @param name Name of the counter.
+   * @param value Value to add.
+   */
+  static void Add(const std::string& name, const uint64_t value);
+
+  /**
+   * Get the value of the given counter.
+   *
+   * @param name Name of the counter.
+   */
+  static uint64_t Get(const std::string& name);
+};
+
+/**
+ * Start the given timer when constructed, and stop it when destroyed, so that a
+ * scope is timed even if it is left by an exception.
+ */
+class ScopedTimer
+{
+ public:
+  //! Start the given timer.
+  explicit ScopedTimer(const TimerHandle handle) : handle(handle)
+  {
+    Timer::Start(handle);
+  }
+
+  //! Stop the timer.
+  ~ScopedTimer() { Timer::Stop(handle); }
+
+ private:
+  //! The handle of the timer.
+  TimerHandle handle;
+
+  // Copies would stop the timer twice.
+  ScopedTimer(const ScopedTimer&);
+  ScopedTimer& operator=(const ScopedTimer&);
 };
 
 class Timers
 {
  public:
-  //! Nothing to do for the constructor.
-  Timers() { }
+  //! Create a set of timers, with nothing timed yet.
+  Timers();
 
   /**
-   * Returns a copy of all the timers used via this interface.
+   * Returns the value of every registered timer, summed over all threads.
+   * Entries are only ever added to the map, so iterators stay valid while
+   * timers are stopped.
    */
   std::map<std::string, std::chrono::microseconds>& GetAllTimers();
 
   /**
-   * Returns a copy of the timer specified.
+   * Returns the value of the timer specified, summed over all threads.
    *
    * @param timerName The name of the timer in question.
    */
@@ -109,22 +256,263 @@ class Timers
   void StopTimer(const std::string& timerName);
 
   /**
-   * Returns state of the given timer.
+   * Starts the given timer on the calling thread, without any lookup or lock
+   * (except the first time the thread uses the timer).
+   *
+   * @param handle The handle of the timer in question.
+   */
+  void StartTimer(const TimerHandle handle)
+  {
+    ThreadTimer& timer = LocalTimer(handle);
+    if (timer.depth++ == 0)
+    {
+      timer.used.store(true, std::memory_order_relaxed);
+      StartCounting(timer);
+      StartMemory(timer);
+      timer.start = GetTime();
+    }
+  }
+
+  /**
+   * Stops the given timer on the calling thread, if this matches its
+   * outermost start.
+   *
+   * @param handle The handle of the timer in question.
+   */
+  void StopTimer(const TimerHandle handle)
+  {
+    ThreadTimer& timer = LocalTimer(handle);
+    if (timer.depth == 0)
+      ThrowNotRunning(handle);
+    if (--timer.depth == 0)
+    {
+      timer.Add(GetTime() - timer.start);
+      StopCounting(timer);
+      StopMemory(timer);
+    }
+  }
+
+  /**
+   * Enables hardware counters for the timers started from now on, if mlpack
+   * was built with them and the system allows them.
+   *
+   * @return Whether the hardware counters are enabled.
+   */
+  bool EnableHardwareCounters();
+
+  /**
+   * Returns the hardware counts of every timer which was run with hardware
+   * counters enabled, summed over all threads.
+   */
+  std::map<std::string, HardwareCounters::Counts> GetAllHardwareCounts();
+
+  //! Enables memory accounting for the timers started from now on.
+  void EnableMemoryAccounting();
+
+  /**
+   * Returns the memory usage of every timer which was run with memory
+   * accounting enabled.  The peak increases of the resident set size and the
+   * allocations are summed over the runs of each timer, and the peaks of the
+   * tracked memory are the maximum over the runs.
+   */
+  std::map<std::string, MemoryUsage> GetAllMemoryUsage();
+
+  /**
+   * Adds the given value to the given counter.
+   *
+   * @param counterName The name of the counter in question.
+   * @param value The value to add.
+   */
+  void AddToCounter(const std::string& counterName, const uint64_t value);
+
+  /**
+   * Returns the value of every counter.
+   */
+  std::map<std::string, uint64_t> GetAllCounters();
+
+  /**
+   * Returns the value of the given counter.
+   *
+   * @param counterName The name of the counter in question.
+   */
+  uint64_t GetCounter(const std::string& counterName);
+
+  /**
+   * Returns whether the given timer is running on the calling thread.
    *
    * @param timerName The name of the timer in question.
    */
   bool GetState(std::string timerName);
 
+  /**
+   * Registers the given timer, if it hasn't been registered yet, and returns
+   * its handle.  Names are shared by all Timers objects.
+   *
+   * @param timerName The name of the timer in question.
+   */
+  static TimerHandle Register(const std::string& timerName);
+
+  //! Returns the name of the given timer.
+  static std::string Name(const TimerHandle handle);
+
  private:
-  //! A map of all the timers that are being tracked.
+  //! The state of one timer on one thread.
+  struct ThreadTimer
+  {
+    ThreadTimer() : total(0), used(false), depth(0), counting(false),
+        counted(false), measuring(false), startPeakRSS(0), startAllocations(0),
+        peakState(0), measured(false), peakRSSIncrease(0), peakTrackedBytes(0),
+        allocations(0)
+    {
+      for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    //! Add the given duration to the total.  Only the owning thread writes it,
+    //! so no atomic read-modify-write is needed.
+    void Add(const std::chrono::high_resolution_clock::duration duration)
+    {
+      total.store(total.load(std::memory_order_relaxed) +
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+          duration).count(), std::memory_order_relaxed);
+    }
+
+    //! The total time of the finished runs, in nanoseconds; it can be read by
+    //! other threads.
+    std::atomic<int64_t> total;
+    //! Whether the timer has been started on this thread.
+    std::atomic<bool> used;
+    //! The start of the outermost running start.
+    std::chrono::high_resolution_clock::time_point start;
+    //! The number of running starts.
+    size_t depth;
+    //! Whether the hardware counters were read at the outermost start.
+    bool counting;
+    //! The hardware counters at the outermost start.
+    HardwareCounters::Counts startCounts;
+    //! Whether any hardware counts were added on this thread.
+    std::atomic<bool> counted;
+    //! The total hardware counts of the finished runs (like total).
+    std::atomic<uint64_t> counts[HardwareCounters::EVENTS];
+    //! Whether memory is measured since the outermost start.
+    bool measuring;
+    //! The peak resident set size, the number of tracked allocations and the
+    //! state of MemoryAccounting::BeginPeak() at the outermost start.
+    uint64_t startPeakRSS;
+    uint64_t startAllocations;
+    uint64_t peakState;
+    //! Whether any memory usage was added on this thread.
+    std::atomic<bool> measured;
+    //! The memory usage of the finished runs (see MemoryUsage).
+    std::atomic<uint64_t> peakRSSIncrease;
+    std::atomic<uint64_t> peakTrackedBytes;
+    std::atomic<uint64_t> allocations;
+  };
+
+  //! The timers of one thread, indexed by handle.  The deque only grows, under
+  //! the lock, so elements never move.
+  typedef std::deque<ThreadTimer> ThreadTimers;
+
+  //! Get the given timer of the calling thread.
+  ThreadTimer& LocalTimer(const TimerHandle handle)
+  {
+    ThreadTimers& local = LocalTimers();
+    if (handle.Index() >= local.size())
+      Grow(local, handle);
+    return local[handle.Index()];
+  }
+
+  //! Read the hardware counters at the outermost start of the given timer, if
+  //! they are enabled.
+  void StartCounting(ThreadTimer& timer)
+  {
+    timer.counting = hardwareCounters.load(std::memory_order_relaxed) &&
+        HardwareCounters::Read(timer.startCounts);
+  }
+
+  //! Add the hardware counts since the outermost start of the given timer.
+  static void StopCounting(ThreadTimer& timer)
+  {
+    HardwareCounters::Counts stopCounts;
+    if (!timer.counting || !HardwareCounters::Read(stopCounts))
+      return;
+
+    for (size_t i = 0; i < HardwareCounters::EVENTS; ++i)
+    {
+      timer.counts[i].store(timer.counts[i].load(std::memory_order_relaxed) +
+          (stopCounts[i] - timer.startCounts[i]), std::memory_order_relaxed);
+    }
+    timer.counted.store(true, std::memory_order_relaxed);
+    timer.counting = false;
+  }
+
+  //! Start measuring the memory used since the outermost start of the given
+  //! timer, if memory accounting is enabled.
+  void StartMemory(ThreadTimer& timer)
+  {
+    timer.measuring = memoryAccounting.load(std::memory_order_relaxed);
+    if (!timer.measuring)
+      return;
+
+    timer.startPeakRSS = MemoryAccounting::PeakRSS();
+    timer.startAllocations = MemoryAccounting::Allocations();
+    timer.peakState = MemoryAccounting::BeginPeak();
+  }
+
+  //! Add the memory used since the outermost start of the given timer.
+  static void StopMemory(ThreadTimer& timer)
+  {
+    if (!timer.measuring)
+      return;
+
+    const uint64_t peak = MemoryAccounting::EndPeak(timer.peakState);
+    timer.peakTrackedBytes.store(std::max(peak,
+        timer.peakTrackedBytes.load(std::memory_order_relaxed)),
+        std::memory_order_relaxed);
+    timer.peakRSSIncrease.store(timer.peakRSSIncrease.load(
+        std::memory_order_relaxed) + (MemoryAccounting::PeakRSS() -
+        timer.startPeakRSS), std::memory_order_relaxed);
+    timer.allocations.store(timer.allocations.load(std::memory_order_relaxed) +
+        (MemoryAccounting::Allocations() - timer.startAllocations),
+        std::memory_order_relaxed);
+    timer.measured.store(true, std::memory_order_relaxed);
+    timer.measuring = false;
+  }
+
+  //! Get the timers of the calling thread, creating them the first time the
+  //! thread uses this object.
+  ThreadTimers& LocalTimers();
+
+  //! Make the given timers of this thread hold the given timer.
+  void Grow(ThreadTimers& local, const TimerHandle handle);
+
+  //! Throw the error of stopping a timer which is not running.
+  static void ThrowNotRunning(const TimerHandle handle);
+
+  //! Get the total of the given timer over all threads (the lock must be
+  //! held).
+  std::chrono::microseconds Total(const size_t index);
+
+  //! The unique identifier of this object, under which each thread keeps a
+  //! pointer to its timers in this object.
+  uint64_t id;
+  //! The timers of every thread which has used this object.
+  std::list<std::unique_ptr<ThreadTimers>> threads;
+  //! The lock protecting threads (and the growth of each thread's timers).
+  std::mutex mutex;
+  //! The value of every timer, as returned by GetAllTimers().
   std::map<std::string, std::chrono::microseconds> timers;
-  //! A map that contains whether or not each timer is currently running.
-  std::map<std::string, bool> timerState;
-  //! A map for the starting values of the timers.
-  std::map<std::string, std::chrono::high_resolution_clock::time_point>
-      timerStartTime;
+  //! The value of every counter (protected by the lock).
+  std::map<std::string, uint64_t> counters;
+  //! Whether hardware counters are read when timers are started and stopped.
+  std::atomic<bool> hardwareCounters;
+  //! Whether memory is measured when timers are started and stopped.
+  std::atomic<bool> memoryAccounting;
 
-  std::chrono::high_resolution_clock::time_point GetTime();
+  static std::chrono::high_resolution_clock::time_point GetTime()
+  {
+    return std::chrono::high_resolution_clock::now();
+  }
 };
 
 } // namespace mlpack
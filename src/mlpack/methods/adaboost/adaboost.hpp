@@ -142,7 +142,8 @@ class AdaBoost
              const double tolerance = 1e-6);
 
   /**
-   * Classify the given test points.
+   * Classify the given test points.  Blocks of test points are classified in
+   * parallel.
    *
    * @param test Testing data.
    * @param predictedLabels Vector in which to the predicted labels of the test
@@ -170,6 +171,53 @@ private:
   //! To check for the bound for the Hamming loss.
   double ztProduct;
 
+  //! The number of test points classified together.
+  static const size_t BlockSize = 1024;
+
+  /**
+   * Prepare the data for the training of the weak learners of every boosting
+   * round.  Generic weak learners need nothing.
+   */
+  template<typename LearnerType>
+  static void PrepareData(const LearnerType& /* learner */,
+                          const MatType& /* data */,
+                          arma::Mat<size_t>& /* sortedIndices */) { }
+
+  /**
+   * Prepare the data for the training of the decision stumps of every boosting
+   * round: the data is sorted once, since only the weights change.
+   */
+  static void PrepareData(
+      const decision_stump::DecisionStump<MatType>& /* learner */,
+      const MatType& data,
+      arma::Mat<size_t>& sortedIndices)
+  {
+    math::Presort(data, sortedIndices);
+  }
+
+  //! Train a generic weak learner for a boosting round.
+  template<typename LearnerType>
+  static LearnerType TrainWeakLearner(
+      const LearnerType& other,
+      const MatType& data,
+      const arma::Mat<size_t>& /* sortedIndices */,
+      const arma::Row<size_t>& labels,
+      const arma::rowvec& weights)
+  {
+    return LearnerType(other, data, labels, weights);
+  }
+
+  //! Train a decision stump for a boosting round, with the presorted data.
+  static decision_stump::DecisionStump<MatType> TrainWeakLearner(
+      const decision_stump::DecisionStump<MatType>& other,
+      const MatType& data,
+      const arma::Mat<size_t>& sortedIndices,
+      const arma::Row<size_t>& labels,
+      const arma::rowvec& weights)
+  {
+    return decision_stump::DecisionStump<MatType>(other, data, sortedIndices,
+        labels, weights);
+  }
 }; // class AdaBoost
 
 } // namespace adaboost
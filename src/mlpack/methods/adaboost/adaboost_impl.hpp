@@ -94,6 +94,11 @@ void AdaBoost<WeakLearnerType, MatType>::Train(
   // Weights are stored in this row vector.
   arma::rowvec weights(predictedLabels.n_cols);
 
+  // Weak learners which can reuse work done on the data across rounds (like
+  // sorting it) prepare it once.
+  arma::Mat<size_t> sortedIndices;
+  PrepareData(other, tempData, sortedIndices);
+
   // This is the final hypothesis.
   arma::Row<size_t> finalH(predictedLabels.n_cols);
 
@@ -112,7 +117,8 @@ void AdaBoost<WeakLearnerType, MatType>::Train(
     weights = arma::sum(D);
 
     // Use the existing weak learner to train a new one with new weights.
-    WeakLearnerType w(other, tempData, labels, weights);
+    WeakLearnerType w = TrainWeakLearner(other, tempData, sortedIndices,
+        labels, weights);
     w.Classify(tempData, predictedLabels);
 
     // Now from predictedLabels, build ht, the weak hypothesis
@@ -193,29 +199,36 @@ void AdaBoost<WeakLearnerType, MatType>::Classify(
     const MatType& test,
     arma::Row<size_t>& predictedLabels)
 {
-  arma::Row<size_t> tempPredictedLabels(test.n_cols);
-  arma::mat cMatrix(classes, test.n_cols);
-
-  cMatrix.zeros();
   predictedLabels.set_size(test.n_cols);
 
-  for (size_t i = 0; i < wl.size(); i++)
+  // Each block of test points is classified by every weak learner, and the
+  // votes for the block are accumulated in a small matrix.
+  const size_t blocks = (test.n_cols + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
   {
-    wl[i].Classify(test, tempPredictedLabels);
+    const size_t begin = b * BlockSize;
+    const size_t end = std::min((size_t) test.n_cols, begin + BlockSize);
+    const MatType block = test.cols(begin, end - 1);
 
-    for (size_t j = 0; j < tempPredictedLabels.n_cols; j++)
-      cMatrix(tempPredictedLabels(j), j) += alpha[i];
-  }
+    arma::Row<size_t> tempPredictedLabels(block.n_cols);
+    arma::mat cMatrix(classes, block.n_cols);
+    cMatrix.zeros();
 
-  arma::colvec cMRow;
-  arma::uword maxIndex;
+    for (size_t i = 0; i < wl.size(); i++)
+    {
+      wl[i].Classify(block, tempPredictedLabels);
 
-  for (size_t i = 0; i < predictedLabels.n_cols; i++)
-  {
-    cMRow = cMatrix.unsafe_col(i);
-    cMRow.max(maxIndex);
-    predictedLabels(i) = maxIndex;
-  }
+      for (size_t j = 0; j < tempPredictedLabels.n_cols; j++)
+        cMatrix(tempPredictedLabels(j), j) += alpha[i];
+    }
+
+    arma::uword maxIndex;
+    for (size_t j = 0; j < block.n_cols; j++)
+    {
+      cMatrix.unsafe_col(j).max(maxIndex);
+      predictedLabels(begin + j) = maxIndex;
+    }
+  });
 }
 
 /**
@@ -21,6 +21,13 @@ namespace amf {
  * IsConverged() will return true.  This class is meant for use with the AMF
  * (alternating matrix factorization) class.
  *
+ * The norm of WH is the sum of the norms of its columns, and the squared norm
+ * of the column W h_j is h_j^T (W^T W) h_j, so it is computed from the small
+ * r x r matrix W^T W, without forming WH; this takes O((m + n) r^2) time
+ * instead of O(m n r).  The residue can also be checked only every few
+ * iterations, in which case it is the relative change of the norm since the
+ * last check.
+ *
  * @see AMF
  */
 class SimpleResidueTermination
@@ -33,10 +40,22 @@ class SimpleResidueTermination
    *
    * @param minResidue Minimum residue for termination.
    * @param maxIterations Maximum number of iterations.
+   * @param checkInterval Number of iterations between residue checks (at
+   *     least 1).
    */
   SimpleResidueTermination(const double minResidue = 1e-5,
-                           const size_t maxIterations = 10000)
-      : minResidue(minResidue), maxIterations(maxIterations) { }
+                           const size_t maxIterations = 10000,
+                           const size_t checkInterval = 1)
+      : minResidue(minResidue),
+        maxIterations(maxIterations),
+        checkInterval(checkInterval)
+  {
+    if (checkInterval == 0)
+    {
+      throw std::invalid_argument("SimpleResidueTermination: checkInterval "
+          "must be at least 1");
+    }
+  }
 
   /**
    * Initializes the termination policy before stating the factorization.
@@ -62,18 +81,26 @@ class SimpleResidueTermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    // Calculate the norm and compute the residue, but do it by hand, so as to
-    // avoid calculating (W*H), which may be very large.
+    // Increment iteration count
+    iteration++;
+
+    // Only check the residue every checkInterval iterations.
+    if ((iteration - 1) % checkInterval != 0)
+      return (iteration > maxIterations);
+
+    // Calculate the norm and compute the residue, but use the Gram matrix of
+    // W, so as to avoid calculating (W*H), which may be very large.  Rounding
+    // may make a squared norm of a column slightly negative.
+    const arma::mat gram = W.t() * W;
+    const arma::rowvec squaredNorms = arma::sum(H % (gram * H), 0);
     double norm = 0.0;
-    for (size_t j = 0; j < H.n_cols; ++j)
-      norm += arma::norm(W * H.col(j), "fro");
+    for (size_t j = 0; j < squaredNorms.n_elem; ++j)
+      norm += std::sqrt(std::max(squaredNorms[j], 0.0));
     residue = fabs(normOld - norm) / normOld;
 
     // Store the norm.
     normOld = norm;
 
-    // Increment iteration count
-    iteration++;
     Log::Info << "Iteration " << iteration << "; residue " << residue << ".\n";
 
     // Check if termination criterion is met.
@@ -94,11 +121,16 @@ class SimpleResidueTermination
   const double& MinResidue() const { return minResidue; }
   double& MinResidue() { return minResidue; }
 
+  //! Get the number of iterations between residue checks.
+  size_t CheckInterval() const { return checkInterval; }
+
 public:
   //! residue threshold
   double minResidue;
   //! iteration threshold
   size_t maxIterations;
+  //! number of iterations between residue checks
+  size_t checkInterval;
 
   //! current value of residue
   double residue;
@@ -63,32 +63,9 @@ class SimpleToleranceTermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    arma::mat WH;
-
-    WH = W * H;
-
     // compute residue
     residueOld = residue;
-    size_t n = V->n_rows;
-    size_t m = V->n_cols;
-    double sum = 0;
-    size_t count = 0;
-    for(size_t i = 0;i < n;i++)
-    {
-        for(size_t j = 0;j < m;j++)
-        {
-            double temp = 0;
-            if((temp = (*V)(i,j)) != 0)
-            {
-                temp = (temp - WH(i, j));
-                temp = temp * temp;
-                sum += temp;
-                count++;
-            }
-        }
-    }
-    residue = sum / count;
-    residue = sqrt(residue);
+    residue = Residue(*V, W, H);
 
     // increment iteration count
     iteration++;
@@ -163,6 +140,42 @@ class SimpleToleranceTermination
   //! pointer to matrix being factorized
   const MatType* V;
 
+  //! compute the RMSE of WH on the nonzero entries of a dense V
+  static double Residue(const arma::mat& V,
+                        const arma::mat& W,
+                        const arma::mat& H)
+  {
+    const arma::mat WH = W * H;
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < V.n_elem; ++i)
+    {
+      if (V[i] != 0)
+      {
+        const double temp = V[i] - WH[i];
+        sum += temp * temp;
+        count++;
+      }
+    }
+    return sqrt(sum / count);
+  }
+
+  //! compute the RMSE of WH on the nonzero entries of a sparse V; only these
+  //! entries of WH are computed, with the rows of W stored as columns
+  static double Residue(const arma::sp_mat& V,
+                        const arma::mat& W,
+                        const arma::mat& H)
+  {
+    const arma::mat Wt = W.t();
+    double sum = 0;
+    for (arma::sp_mat::const_iterator it = V.begin(); it != V.end(); ++it)
+    {
+      const double temp = (*it) - arma::dot(Wt.col(it.row()), H.col(it.col()));
+      sum += temp * temp;
+    }
+    return sqrt(sum / V.n_nonzero);
+  }
+
   //! current iteration count
   size_t iteration;
 
@@ -108,13 +108,11 @@ class ValidationRMSETermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    arma::mat WH;
-
-    WH = W * H;
-
-    // compute validation RMSE
+    // compute validation RMSE; only the validation entries of WH are
+    // predicted, with the rows of W stored as columns so they are contiguous
     if (iteration != 0)
     {
+      const arma::mat Wt = W.t();
       rmseOld = rmse;
       rmse = 0;
       for(size_t i = 0; i < num_test_points; i++)
@@ -122,7 +120,7 @@ class ValidationRMSETermination
         size_t t_row = test_points(i, 0);
         size_t t_col = test_points(i, 1);
         double t_val = test_points(i, 2);
-        double temp = (t_val - WH(t_row, t_col));
+        double temp = (t_val - arma::dot(Wt.col(t_row), H.col(t_col)));
         temp *= temp;
         rmse += temp;
       }
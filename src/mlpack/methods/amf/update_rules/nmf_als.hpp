@@ -9,6 +9,8 @@
 
 #include <mlpack/core.hpp>
 
+#include "nmf_blocks.hpp"
+
 namespace mlpack {
 namespace amf {
 
@@ -57,7 +59,7 @@ class NMFALSUpdate
    * \f]
    *
    * The function takes in all the matrices and only changes the value of the W
-   * matrix.
+   * matrix.  The rows of W are updated in parallel blocks.
    *
    * @param V Input matrix to be factorized.
    * @param W Basis matrix to be updated.
@@ -70,15 +72,21 @@ class NMFALSUpdate
   {
     // The call to inv() sometimes fails; so we are using the psuedoinverse.
     // W = (inv(H * H.t()) * H * V.t()).t();
-    W = V * H.t() * pinv(H * H.t());
+    const arma::mat hhtInv = pinv(H * H.t());
+    const NMFRowBlocks<MatType> rows(V);
 
-    // Set all negative numbers to machine epsilon.
-    for (size_t i = 0; i < W.n_elem; i++)
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) NMFNumBlocks(V.n_rows); ++b)
     {
-      if (W(i) < 0.0)
-      {
-        W(i) = 0.0;
-      }
+      const size_t begin = b * nmfBlockSize;
+      const size_t end = std::min(begin + nmfBlockSize, (size_t) V.n_rows) - 1;
+      W.rows(begin, end) = rows.Rows(begin, end) * H.t() * hhtInv;
+
+      // Set all negative numbers to 0.
+      for (size_t j = 0; j < W.n_cols; j++)
+        for (size_t i = begin; i <= end; i++)
+          if (W(i, j) < 0.0)
+            W(i, j) = 0.0;
     }
   }
 
@@ -90,7 +98,7 @@ class NMFALSUpdate
    * \f]
    *
    * The function takes in all the matrices and only changes the value of the H
-   * matrix.
+   * matrix.  The columns of H are updated in parallel blocks.
    *
    * @param V Input matrix to be factorized.
    * @param W Basis matrix.
@@ -101,15 +109,21 @@ class NMFALSUpdate
                              const arma::mat& W,
                              arma::mat& H)
   {
-    H = pinv(W.t() * W) * W.t() * V;
+    const arma::mat wtwInvWt = pinv(W.t() * W) * W.t();
+    H.set_size(W.n_cols, V.n_cols);
 
-    // Set all negative numbers to 0.
-    for (size_t i = 0; i < H.n_elem; i++)
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) NMFNumBlocks(V.n_cols); ++b)
     {
-      if (H(i) < 0.0)
-      {
-        H(i) = 0.0;
-      }
+      const size_t begin = b * nmfBlockSize;
+      const size_t end = std::min(begin + nmfBlockSize, (size_t) V.n_cols) - 1;
+      H.cols(begin, end) = wtwInvWt * NMFColumns(V, begin, end);
+
+      // Set all negative numbers to 0.
+      double* h = H.colptr(begin);
+      for (size_t i = 0; i < H.n_rows * (end - begin + 1); i++)
+        if (h[i] < 0.0)
+          h[i] = 0.0;
     }
   }
 
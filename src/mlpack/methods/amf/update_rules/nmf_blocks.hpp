@@ -0,0 +1,104 @@
+/**
+ * @file nmf_blocks.hpp
+ *
+ * Access to blocks of rows and blocks of columns of the input matrix of the
+ * NMF update rules, for dense and sparse matrices.  The update rules update W
+ * one block of rows and H one block of columns at a time, in parallel, so that
+ * the temporaries they need are only as large as one block.
+ */
+#ifndef MLPACK_METHODS_AMF_UPDATE_RULES_NMF_BLOCKS_HPP
+#define MLPACK_METHODS_AMF_UPDATE_RULES_NMF_BLOCKS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace amf {
+
+//! The number of rows or columns in each block of the NMF update rules.  The
+//! blocks do not depend on the number of threads, so neither do the results.
+const size_t nmfBlockSize = 256;
+
+//! Return the number of blocks needed to hold the given number of rows or
+//! columns.
+inline size_t NMFNumBlocks(const size_t n)
+{
+  return (n + nmfBlockSize - 1) / nmfBlockSize;
+}
+
+/**
+ * Blocks of rows of a dense matrix.  Each block is a copy of the rows.
+ */
+template<typename MatType>
+class NMFRowBlocks
+{
+ public:
+  //! The type of a block of rows.
+  typedef arma::mat BlockType;
+
+  //! Prepare to take blocks of rows of the given matrix.
+  NMFRowBlocks(const MatType& V) : V(V) { }
+
+  //! Return the rows from begin to end (inclusive).
+  BlockType Rows(const size_t begin, const size_t end) const
+  {
+    return V.rows(begin, end);
+  }
+
+ private:
+  //! The matrix to take the blocks of.
+  const MatType& V;
+};
+
+/**
+ * Blocks of rows of a sparse matrix.  Taking rows of a matrix in compressed
+ * sparse column format is slow, so the matrix is transposed once and the blocks
+ * are taken as columns of the transpose.
+ */
+template<>
+class NMFRowBlocks<arma::sp_mat>
+{
+ public:
+  //! The type of a block of rows.
+  typedef arma::sp_mat BlockType;
+
+  //! Prepare to take blocks of rows of the given matrix.
+  NMFRowBlocks(const arma::sp_mat& V) : Vt(trans(V)) { }
+
+  //! Return the rows from begin to end (inclusive).
+  BlockType Rows(const size_t begin, const size_t end) const
+  {
+    return trans(Vt.cols(begin, end));
+  }
+
+ private:
+  //! The transpose of the matrix to take the blocks of.
+  arma::sp_mat Vt;
+};
+
+/**
+ * Return the columns from begin to end (inclusive) of the given dense matrix.
+ * The block is an alias of the memory of the matrix, since its columns are
+ * contiguous.
+ */
+template<typename MatType>
+inline const arma::mat NMFColumns(const MatType& V,
+                                  const size_t begin,
+                                  const size_t end)
+{
+  return arma::mat(const_cast<double*>(V.colptr(begin)), V.n_rows,
+      end - begin + 1, false, true);
+}
+
+//! Return the columns from begin to end (inclusive) of the given sparse
+//! matrix.
+inline arma::sp_mat NMFColumns(const arma::sp_mat& V,
+                               const size_t begin,
+                               const size_t end)
+{
+  return V.cols(begin, end);
+}
+
+} // namespace amf
+} // namespace mlpack
+
+#endif
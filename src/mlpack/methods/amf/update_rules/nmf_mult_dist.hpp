@@ -9,6 +9,8 @@
 
 #include <mlpack/core.hpp>
 
+#include "nmf_blocks.hpp"
+
 namespace mlpack {
 namespace amf {
 
@@ -55,7 +57,7 @@ class NMFMultiplicativeDistanceUpdate
    * \f]
    *
    * The function takes in all the matrices and only changes the value of the W
-   * matrix.
+   * matrix.  The rows of W are updated in parallel blocks.
    *
    * @param V Input matrix to be factorized.
    * @param W Basis matrix to be updated.
@@ -66,7 +68,18 @@ class NMFMultiplicativeDistanceUpdate
                              arma::mat& W,
                              const arma::mat& H)
   {
-    W = (W % (V * H.t())) / (W * H * H.t());
+    const arma::mat hht = H * H.t();
+    const NMFRowBlocks<MatType> rows(V);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) NMFNumBlocks(V.n_rows); ++b)
+    {
+      const size_t begin = b * nmfBlockSize;
+      const size_t end = std::min(begin + nmfBlockSize, (size_t) V.n_rows) - 1;
+      const arma::mat numerator = rows.Rows(begin, end) * H.t();
+      const arma::mat denominator = W.rows(begin, end) * hht;
+      W.rows(begin, end) = (W.rows(begin, end) % numerator) / denominator;
+    }
   }
 
   /**
@@ -77,7 +90,7 @@ class NMFMultiplicativeDistanceUpdate
    * \f]
    *
    * The function takes in all the matrices and only changes the value of the H
-   * matrix.
+   * matrix.  The columns of H are updated in parallel blocks.
    *
    * @param V Input matrix to be factorized.
    * @param W Basis matrix.
@@ -88,7 +101,17 @@ class NMFMultiplicativeDistanceUpdate
                              const arma::mat& W,
                              arma::mat& H)
   {
-    H = (H % (W.t() * V)) / (W.t() * W * H);
+    const arma::mat wtw = W.t() * W;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) NMFNumBlocks(V.n_cols); ++b)
+    {
+      const size_t begin = b * nmfBlockSize;
+      const size_t end = std::min(begin + nmfBlockSize, (size_t) V.n_cols) - 1;
+      const arma::mat numerator = W.t() * NMFColumns(V, begin, end);
+      const arma::mat denominator = wtw * H.cols(begin, end);
+      H.cols(begin, end) = (H.cols(begin, end) % numerator) / denominator;
+    }
   }
 
   //! Serialize the object (in this case, there is nothing to serialize).
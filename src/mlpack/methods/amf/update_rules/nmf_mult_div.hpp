@@ -9,6 +9,8 @@
 
 #include <mlpack/core.hpp>
 
+#include "nmf_blocks.hpp"
+
 namespace mlpack {
 namespace amf {
 
@@ -76,27 +78,23 @@ class NMFMultiplicativeDivergenceUpdate
                              arma::mat& W,
                              const arma::mat& H)
   {
-    // Simple implementation left in the header file.
-    arma::mat t1;
-    arma::rowvec t2;
+    // The rows of W are updated in parallel blocks, so that only one block of
+    // rows of W * H is held at a time by each thread.
+    const arma::rowvec hSums = trans(arma::sum(H, 1));
+    const NMFRowBlocks<MatType> rows(V);
 
-    t1 = W * H;
-    for (size_t i = 0; i < W.n_rows; ++i)
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) NMFNumBlocks(V.n_rows); ++b)
     {
-      for (size_t j = 0; j < W.n_cols; ++j)
-      {
-        // Writing this as a single expression does not work as of Armadillo
-        // 3.920.  This should be fixed in a future release, and then the code
-        // below can be fixed.
-        //t2 = H.row(j) % V.row(i) / t1.row(i);
-        t2.set_size(H.n_cols);
-        for (size_t k = 0; k < t2.n_elem; ++k)
-        {
-          t2(k) = H(j, k) * V(i, k) / t1(i, k);
-        }
+      const size_t begin = b * nmfBlockSize;
+      const size_t end = std::min(begin + nmfBlockSize, (size_t) V.n_rows) - 1;
 
-        W(i, j) = W(i, j) * sum(t2) / sum(H.row(j));
-      }
+      // Each element is V_{i\mu} / (W H)_{i\mu}.
+      const arma::mat ratio = arma::mat(rows.Rows(begin, end)) /
+          (W.rows(begin, end) * H);
+      arma::mat factor = ratio * H.t();
+      factor.each_row() /= hSums;
+      W.rows(begin, end) %= factor;
     }
   }
 
@@ -117,30 +115,25 @@ class NMFMultiplicativeDivergenceUpdate
    */
   template<typename MatType>
   inline static void HUpdate(const MatType& V,
-                            const arma::mat& W,
-                            arma::mat& H)
+                             const arma::mat& W,
+                             arma::mat& H)
   {
-    // Simple implementation left in the header file.
-    arma::mat t1;
-    arma::colvec t2;
+    // The columns of H are updated in parallel blocks, so that only one block
+    // of columns of W * H is held at a time by each thread.
+    const arma::vec wSums = trans(arma::sum(W, 0));
 
-    t1 = W * H;
-    for (size_t i = 0; i < H.n_rows; i++)
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) NMFNumBlocks(V.n_cols); ++b)
     {
-      for (size_t j = 0; j < H.n_cols; j++)
-      {
-        // Writing this as a single expression does not work as of Armadillo
-        // 3.920.  This should be fixed in a future release, and then the code
-        // below can be fixed.
-        //t2 = W.col(i) % V.col(j) / t1.col(j);
-        t2.set_size(W.n_rows);
-        for (size_t k = 0; k < t2.n_elem; ++k)
-        {
-          t2(k) = W(k, i) * V(k, j) / t1(k, j);
-        }
+      const size_t begin = b * nmfBlockSize;
+      const size_t end = std::min(begin + nmfBlockSize, (size_t) V.n_cols) - 1;
 
-        H(i,j) = H(i,j) * sum(t2) / sum(W.col(i));
-      }
+      // Each element is V_{i\mu} / (W H)_{i\mu}.
+      const arma::mat ratio = arma::mat(NMFColumns(V, begin, end)) /
+          (W * H.cols(begin, end));
+      arma::mat factor = W.t() * ratio;
+      factor.each_col() /= wSums;
+      H.cols(begin, end) %= factor;
     }
   }
 
@@ -0,0 +1,243 @@
+/**
+ * @file svd_parallel_incremental_learning.hpp
+ *
+ * SVD factorizer used in AMF (Alternating Matrix Factorization), which runs
+ * complete incremental learning in parallel with stratified blocks.
+ */
+#ifndef MLPACK_METHODS_AMF_SVD_PARALLEL_INCREMENTAL_LEARNING_HPP
+#define MLPACK_METHODS_AMF_SVD_PARALLEL_INCREMENTAL_LEARNING_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This class computes SVD with complete incremental learning (as in
+ * SVDCompleteIncrementalLearning, where both feature vectors are updated after
+ * each single nonzero element of V), but processes the elements of V in
+ * parallel, with the stratified scheduling of distributed SGD (DSGD):
+ *
+ * @code
+ * @inproceedings{gemulla2011large,
+ *   title={Large-scale matrix factorization with distributed stochastic
+ *       gradient descent},
+ *   author={Gemulla, R. and Nijkamp, E. and Haas, P.J. and Sismanis, Y.},
+ *   booktitle={Proceedings of the 17th ACM SIGKDD International Conference on
+ *       Knowledge Discovery and Data Mining (KDD '11)},
+ *   pages={69--77},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * The rows and the columns of V are split into the same number of blocks.  One
+ * iteration (a call to WUpdate() and HUpdate()) is one pass over all the
+ * nonzero elements of V, in as many sub-epochs as there are blocks; in each
+ * sub-epoch, the blocks of a stratum (a set of blocks which share no rows and
+ * no columns) are processed in parallel.  The blocks of a stratum touch
+ * disjoint rows of W and columns of H, so no locks are needed and no update is
+ * lost, unlike with Hogwild-style updates.  The elements of each block are
+ * visited in a fixed order, so the result does not depend on the number of
+ * threads, only on the number of blocks, which should be at least the number
+ * of threads.
+ *
+ * The whole pass is made by WUpdate(), which updates W and a copy of H, and
+ * HUpdate() then takes the new H.
+ *
+ * @see SVDCompleteIncrementalLearning
+ */
+class SVDParallelIncrementalLearning
+{
+ public:
+  /**
+   * Initialize the parameters of SVDParallelIncrementalLearning.
+   *
+   * @param u Step value used in batch learning.
+   * @param kw Regularization constant for W matrix.
+   * @param kh Regularization constant for H matrix.
+   * @param blocks Number of blocks of rows and of columns of V.
+   */
+  SVDParallelIncrementalLearning(const double u = 0.001,
+                                 const double kw = 0,
+                                 const double kh = 0,
+                                 const size_t blocks = 16) :
+      u(u), kw(kw), kh(kh), blocks(blocks)
+  {
+    if (blocks == 0)
+      throw std::invalid_argument("SVDParallelIncrementalLearning: number of "
+          "blocks must be greater than 0");
+  }
+
+  /**
+   * Initialize parameters before factorization.  Nothing needs to be done, so
+   * the input matrix and rank are not used.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank rank of factorization
+   */
+  template<typename MatType>
+  void Initialize(const MatType& /* dataset */, const size_t /* rank */)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Make one pass over all the nonzero elements of V, updating W and a copy of
+   * H, which is given to H by HUpdate().
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  template<typename MatType>
+  inline void WUpdate(const MatType& V,
+                      arma::mat& W,
+                      const arma::mat& H)
+  {
+    // The rows of W are transposed, so that each feature vector is contiguous.
+    arma::mat wt = trans(W);
+    newH = H;
+
+    // There can't be more blocks than rows or columns.
+    const size_t numBlocks = std::max((size_t) 1, std::min(blocks,
+        (size_t) std::min(V.n_rows, V.n_cols)));
+    for (size_t stratum = 0; stratum < numBlocks; ++stratum)
+    {
+      #pragma omp parallel for schedule(dynamic)
+      for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+      {
+        const size_t c = (b + stratum) % numBlocks;
+        UpdateBlock(V, b * V.n_rows / numBlocks,
+            (b + 1) * V.n_rows / numBlocks, c * V.n_cols / numBlocks,
+            (c + 1) * V.n_cols / numBlocks, wt, newH);
+      }
+    }
+
+    W = trans(wt);
+  }
+
+  /**
+   * Set H to the matrix computed by the last call to WUpdate().
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  template<typename MatType>
+  inline void HUpdate(const MatType& /* V */,
+                      const arma::mat& /* W */,
+                      arma::mat& H)
+  {
+    H = std::move(newH);
+  }
+
+  //! Get the step size.
+  double U() const { return u; }
+  //! Modify the step size.
+  double& U() { return u; }
+
+  //! Get the number of blocks of rows and of columns.
+  size_t Blocks() const { return blocks; }
+  //! Modify the number of blocks of rows and of columns.
+  size_t& Blocks() { return blocks; }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    ar & CreateNVP(u, "u");
+    ar & CreateNVP(kw, "kw");
+    ar & CreateNVP(kh, "kh");
+    ar & CreateNVP(blocks, "blocks");
+  }
+
+ private:
+  /**
+   * Take an SGD step for the given element of V, updating the feature vectors
+   * of its row (in the transposed W) and of its column (in H).
+   */
+  void Step(const size_t row,
+            const size_t col,
+            const double value,
+            arma::mat& wt,
+            arma::mat& h) const
+  {
+    double* w = wt.colptr(row);
+    double* hc = h.colptr(col);
+
+    double prediction = 0.0;
+    for (size_t k = 0; k < wt.n_rows; ++k)
+      prediction += w[k] * hc[k];
+    const double error = value - prediction;
+
+    for (size_t k = 0; k < wt.n_rows; ++k)
+    {
+      const double oldW = w[k];
+      w[k] += u * (error * hc[k] - kw * oldW);
+      hc[k] += u * (error * oldW - kh * hc[k]);
+    }
+  }
+
+  /**
+   * Take an SGD step for each nonzero element of the given block of the dense
+   * matrix V, column by column.  The block holds the rows [rowBegin, rowEnd)
+   * and the columns [colBegin, colEnd).
+   */
+  template<typename MatType>
+  void UpdateBlock(const MatType& V,
+                   const size_t rowBegin,
+                   const size_t rowEnd,
+                   const size_t colBegin,
+                   const size_t colEnd,
+                   arma::mat& wt,
+                   arma::mat& h) const
+  {
+    for (size_t col = colBegin; col < colEnd; ++col)
+      for (size_t row = rowBegin; row < rowEnd; ++row)
+        if (V(row, col) != 0)
+          Step(row, col, V(row, col), wt, h);
+  }
+
+  /**
+   * Take an SGD step for each nonzero element of the given block of the sparse
+   * matrix V, column by column.  The row indices of each column are sorted, so
+   * the elements of the block are found by binary search.
+   */
+  void UpdateBlock(const arma::sp_mat& V,
+                   const size_t rowBegin,
+                   const size_t rowEnd,
+                   const size_t colBegin,
+                   const size_t colEnd,
+                   arma::mat& wt,
+                   arma::mat& h) const
+  {
+    for (size_t col = colBegin; col < colEnd; ++col)
+    {
+      const arma::uword* first = V.row_indices + V.col_ptrs[col];
+      const arma::uword* last = V.row_indices + V.col_ptrs[col + 1];
+      const arma::uword* it = std::lower_bound(first, last,
+          (arma::uword) rowBegin);
+      for (; it != last && *it < rowEnd; ++it)
+        Step(*it, col, V.values[it - V.row_indices], wt, h);
+    }
+  }
+
+  //! Step size of the updates.
+  double u;
+  //! Regularization parameter for matrix W.
+  double kw;
+  //! Regularization parameter for matrix H.
+  double kh;
+  //! Number of blocks of rows and of columns.
+  size_t blocks;
+
+  //! The matrix H computed by WUpdate().
+  arma::mat newH;
+};
+
+} // namespace amf
+} // namespace mlpack
+
+#endif
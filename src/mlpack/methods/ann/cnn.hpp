@@ -308,12 +308,38 @@ class CNN
                      ErrorType& error,
                      const std::tuple<Tp...>& network)
   {
-    // Calculate and store the output error.
+    // Output layers which compute their own loss along with the error (like
+    // the SoftmaxCrossEntropyLayer) return it; otherwise the network's
+    // performance is measured with the specified performance function.
+    typedef decltype(outputLayer.CalculateError(std::get<sizeof...(Tp) - 1>(
+        network).OutputParameter(), target, error)) ErrorReturnType;
+    return OutputError(target, error, network,
+        std::is_same<ErrorReturnType, double>());
+  }
+
+  //! Calculate and store the output error, and return the loss computed by
+  //! the output layer.
+  template<typename DataType, typename ErrorType, typename... Tp>
+  double OutputError(const DataType& target,
+                     ErrorType& error,
+                     const std::tuple<Tp...>& network,
+                     std::true_type /* outputLayerLoss */)
+  {
+    return outputLayer.CalculateError(
+        std::get<sizeof...(Tp) - 1>(network).OutputParameter(), target, error);
+  }
+
+  //! Calculate and store the output error, and return the error given by the
+  //! performance function.
+  template<typename DataType, typename ErrorType, typename... Tp>
+  double OutputError(const DataType& target,
+                     ErrorType& error,
+                     const std::tuple<Tp...>& network,
+                     std::false_type /* outputLayerLoss */)
+  {
     outputLayer.CalculateError(
         std::get<sizeof...(Tp) - 1>(network).OutputParameter(), target, error);
 
-    // Masures the network's performance with the specified performance
-    // function.
     return performanceFunc.Error(network, target, error);
   }
 
@@ -33,86 +33,32 @@ class FFTConvolution
 {
  public:
   /*
-   * Perform a convolution through fft (valid mode). This method only supports
-   * input which is even on the last dimension. In case of an odd input width, a
-   * user can manually pad the imput or specify the padLastDim parameter which
-   * takes care of the padding. The filter instead can have any size. When using
-   * the valid mode the filters has to be smaller than the input.
-   *
-   * @param input Input used to perform the convolution.
-   * @param filter Filter used to perform the conolution.
-   * @param output Output data that contains the results of the convolution.
-   */
-  template<typename eT, typename Border = BorderMode>
-  static typename std::enable_if<
-      std::is_same<Border, ValidConvolution>::value, void>::type
-  Convolution(const arma::Mat<eT>& input,
-              const arma::Mat<eT>& filter,
-              arma::Mat<eT>& output)
-  {
-    arma::Mat<eT> inputPadded = input;
-    arma::Mat<eT> filterPadded = filter;
-
-    if (padLastDim)
-      inputPadded.resize(inputPadded.n_rows, inputPadded.n_cols + 1);
-
-    // Pad filter and input to the output shape.
-    filterPadded.resize(inputPadded.n_rows, inputPadded.n_cols);
-
-    output = arma::real(ifft2(arma::fft2(inputPadded) % arma::fft2(
-        filterPadded)));
-
-    // Extract the region of interest. We don't need to handle the padLastDim in
-    // a special way we just cut it out from the output matrix.
-    output = output.submat(filter.n_rows - 1, filter.n_cols - 1,
-        input.n_rows - 1, input.n_cols - 1);
-  }
-
-  /*
-   * Perform a convolution through fft (full mode). This method only supports
-   * input which is even on the last dimension. In case of an odd input width, a
-   * user can manually pad the imput or specify the padLastDim parameter which
-   * takes care of the padding. The filter instead can have any size.
+   * Perform a convolution through fft. This method only supports input which is
+   * even on the last dimension. In case of an odd input width, a user can
+   * manually pad the imput or specify the padLastDim parameter which takes care
+   * of the padding. The filter instead can have any size. When using the valid
+   * mode the filters has to be smaller than the input.
    *
    * @param input Input used to perform the convolution.
    * @param filter Filter used to perform the conolution.
    * @param output Output data that contains the results of the convolution.
    */
-  template<typename eT, typename Border = BorderMode>
-  static typename std::enable_if<
-      std::is_same<Border, FullConvolution>::value, void>::type
-  Convolution(const arma::Mat<eT>& input,
-              const arma::Mat<eT>& filter,
-              arma::Mat<eT>& output)
+  template<typename eT>
+  static void Convolution(const arma::Mat<eT>& input,
+                          const arma::Mat<eT>& filter,
+                          arma::Mat<eT>& output)
   {
-    // In case of the full convolution outputRows and outputCols doesn't
-    // represent the true output size when the padLastDim parameter is set,
-    // instead it's the working size.
-    const size_t outputRows = input.n_rows + 2 * (filter.n_rows - 1);
-    size_t outputCols = input.n_cols + 2 * (filter.n_cols - 1);
-
-    if (padLastDim)
-        outputCols++;
-
-    // Pad filter and input to the working output shape.
-    arma::Mat<eT> inputPadded = arma::zeros<arma::Mat<eT> >(outputRows,
-        outputCols);
-    inputPadded.submat(filter.n_rows - 1, filter.n_cols - 1,
-          filter.n_rows - 1 + input.n_rows - 1,
-          filter.n_cols - 1 + input.n_cols - 1) = input;
+    size_t workingRows, workingCols;
+    WorkingSize(input.n_rows, input.n_cols, filter.n_rows, filter.n_cols,
+        workingRows, workingCols);
 
-    arma::Mat<eT> filterPadded = filter;
-    filterPadded.resize(outputRows, outputCols);
-
-    // Perform FFT and IFFT
-    output = arma::real(ifft2(arma::fft2(inputPadded) % arma::fft2(
-        filterPadded)));
+    arma::Mat<std::complex<eT> > inputSpectrum, filterSpectrum;
+    InputSpectrum(input, filter.n_rows, filter.n_cols, inputSpectrum);
+    FilterSpectrum(filter, workingRows, workingCols, filterSpectrum);
 
-    // Extract the region of interest. We don't need to handle the padLastDim
-    // parameter in a special way we just cut it out from the output matrix.
-    output = output.submat(filter.n_rows - 1, filter.n_cols - 1,
-        2 * (filter.n_rows - 1) + input.n_rows - 1,
-        2 * (filter.n_cols - 1) + input.n_cols - 1);
+    inputSpectrum %= filterSpectrum;
+    SpectrumOutput(inputSpectrum, input.n_rows, input.n_cols, filter.n_rows,
+        filter.n_cols, output);
   }
 
   /*
@@ -132,8 +78,8 @@ class FFTConvolution
                           arma::Cube<eT>& output)
   {
     arma::Mat<eT> convOutput;
-    FFTConvolution<BorderMode>::Convolution(input.slice(0), filter.slice(0),
-        convOutput);
+    FFTConvolution<BorderMode, padLastDim>::Convolution(input.slice(0),
+        filter.slice(0), convOutput);
 
     output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
         input.n_slices);
@@ -141,8 +87,8 @@ class FFTConvolution
 
     for (size_t i = 1; i < input.n_slices; i++)
     {
-      FFTConvolution<BorderMode>::Convolution(input.slice(i), filter.slice(i),
-          convOutput);
+      FFTConvolution<BorderMode, padLastDim>::Convolution(input.slice(i),
+          filter.slice(i), convOutput);
       output.slice(i) = convOutput;
     }
   }
@@ -152,7 +98,8 @@ class FFTConvolution
    * order tensors as filter and output. This method only supports input which
    * is even on the last dimension. In case of an odd input width, a user can
    * manually pad the imput or specify the padLastDim parameter which takes care
-   * of the padding. The filter instead can have any size.
+   * of the padding. The filter instead can have any size.  The input is
+   * transformed only once for all the filters.
    *
    * @param input Input used to perform the convolution.
    * @param filter Filter used to perform the conolution.
@@ -163,25 +110,35 @@ class FFTConvolution
                           const arma::Cube<eT>& filter,
                           arma::Cube<eT>& output)
   {
-    arma::Mat<eT> convOutput;
-    FFTConvolution<BorderMode>::Convolution(input, filter.slice(0),
-        convOutput);
+    size_t workingRows, workingCols;
+    WorkingSize(input.n_rows, input.n_cols, filter.n_rows, filter.n_cols,
+        workingRows, workingCols);
 
-    output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
-        filter.n_slices);
-    output.slice(0) = convOutput;
+    arma::Mat<std::complex<eT> > inputSpectrum, filterSpectrum;
+    InputSpectrum(input, filter.n_rows, filter.n_cols, inputSpectrum);
 
-    for (size_t i = 1; i < filter.n_slices; i++)
+    arma::Mat<eT> convOutput;
+    for (size_t i = 0; i < filter.n_slices; i++)
     {
-      FFTConvolution<BorderMode>::Convolution(input, filter.slice(i),
-          convOutput);
+      FilterSpectrum(filter.slice(i), workingRows, workingCols,
+          filterSpectrum);
+      filterSpectrum %= inputSpectrum;
+      SpectrumOutput(filterSpectrum, input.n_rows, input.n_cols,
+          filter.n_rows, filter.n_cols, convOutput);
+
+      if (i == 0)
+      {
+        output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
+            filter.n_slices);
+      }
       output.slice(i) = convOutput;
     }
   }
 
   /*
    * Perform a convolution using a 3rd order tensors as input and output and a
-   * dense matrix as filter.
+   * dense matrix as filter.  The filter is transformed only once for all the
+   * slices of the input.
    *
    * @param input Input used to perform the convolution.
    * @param filter Filter used to perform the conolution.
@@ -192,24 +149,174 @@ class FFTConvolution
                           const arma::Mat<eT>& filter,
                           arma::Cube<eT>& output)
   {
-    arma::Mat<eT> convOutput;
-    FFTConvolution<BorderMode>::Convolution(input.slice(0), filter,
-        convOutput);
+    size_t workingRows, workingCols;
+    WorkingSize(input.n_rows, input.n_cols, filter.n_rows, filter.n_cols,
+        workingRows, workingCols);
 
-    output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
-        input.n_slices);
-    output.slice(0) = convOutput;
+    arma::Mat<std::complex<eT> > inputSpectrum, filterSpectrum;
+    FilterSpectrum(filter, workingRows, workingCols, filterSpectrum);
 
-    for (size_t i = 1; i < input.n_slices; i++)
+    arma::Mat<eT> convOutput;
+    for (size_t i = 0; i < input.n_slices; i++)
     {
-      FFTConvolution<BorderMode>::Convolution(input.slice(i), filter,
-          convOutput);
+      InputSpectrum(input.slice(i), filter.n_rows, filter.n_cols,
+          inputSpectrum);
+      inputSpectrum %= filterSpectrum;
+      SpectrumOutput(inputSpectrum, input.n_rows, input.n_cols,
+          filter.n_rows, filter.n_cols, convOutput);
+
+      if (i == 0)
+      {
+        output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
+            input.n_slices);
+      }
       output.slice(i) = convOutput;
     }
   }
 
+  /*
+   * Get the size of the zero-padded input and filter whose spectra are
+   * multiplied to convolve an input and a filter of the given sizes.  In case
+   * of the full convolution, this is not the true output size, but the working
+   * size.
+   *
+   * @param inputRows Number of rows of the input.
+   * @param inputCols Number of columns of the input.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param workingRows Number of rows of the spectra.
+   * @param workingCols Number of columns of the spectra.
+   */
+  static void WorkingSize(const size_t inputRows,
+                          const size_t inputCols,
+                          const size_t filterRows,
+                          const size_t filterCols,
+                          size_t& workingRows,
+                          size_t& workingCols)
+  {
+    workingRows = inputRows;
+    workingCols = inputCols;
+
+    if (IsFull())
+    {
+      workingRows += 2 * (filterRows - 1);
+      workingCols += 2 * (filterCols - 1);
+    }
+
+    if (padLastDim)
+      workingCols++;
+  }
+
+  /*
+   * Compute the spectrum of the input, padded to the working size (see
+   * WorkingSize()) for a convolution with a filter of the given size.
+   *
+   * @param input Input to be transformed.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param spectrum Matrix to store the spectrum in.
+   */
+  template<typename eT>
+  static void InputSpectrum(const arma::Mat<eT>& input,
+                            const size_t filterRows,
+                            const size_t filterCols,
+                            arma::Mat<std::complex<eT> >& spectrum)
+  {
+    size_t workingRows, workingCols;
+    WorkingSize(input.n_rows, input.n_cols, filterRows, filterCols,
+        workingRows, workingCols);
+
+    // In full mode, the input is placed in the middle of the working shape.
+    const size_t rowOffset = IsFull() ? filterRows - 1 : 0;
+    const size_t colOffset = IsFull() ? filterCols - 1 : 0;
+
+    arma::Mat<eT> inputPadded = arma::zeros<arma::Mat<eT> >(workingRows,
+        workingCols);
+    inputPadded.submat(rowOffset, colOffset, rowOffset + input.n_rows - 1,
+        colOffset + input.n_cols - 1) = input;
+
+    spectrum = arma::fft2(inputPadded);
+  }
+
+  /*
+   * Compute the spectrum of the filter, padded to the given working size.  The
+   * spectrum does not depend on the input, apart from its size, so it can be
+   * reused for every input of that size.
+   *
+   * @param filter Filter to be transformed.
+   * @param workingRows Number of rows of the spectrum.
+   * @param workingCols Number of columns of the spectrum.
+   * @param spectrum Matrix to store the spectrum in.
+   */
+  template<typename eT>
+  static void FilterSpectrum(const arma::Mat<eT>& filter,
+                             const size_t workingRows,
+                             const size_t workingCols,
+                             arma::Mat<std::complex<eT> >& spectrum)
+  {
+    arma::Mat<eT> filterPadded = filter;
+    filterPadded.resize(workingRows, workingCols);
+
+    spectrum = arma::fft2(filterPadded);
+  }
+
+  /*
+   * Compute the result of the convolution from the product of the spectra of
+   * the input and the filter (or from a sum of such products, which gives the
+   * sum of the convolutions).
+   *
+   * @param spectrum Product of the spectra.
+   * @param inputRows Number of rows of the input.
+   * @param inputCols Number of columns of the input.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void SpectrumOutput(const arma::Mat<std::complex<eT> >& spectrum,
+                             const size_t inputRows,
+                             const size_t inputCols,
+                             const size_t filterRows,
+                             const size_t filterCols,
+                             arma::Mat<eT>& output)
+  {
+    const size_t outputRows = IsFull() ? inputRows + filterRows - 1 :
+        inputRows - filterRows + 1;
+    const size_t outputCols = IsFull() ? inputCols + filterCols - 1 :
+        inputCols - filterCols + 1;
+
+    // Extract the region of interest. We don't need to handle the padLastDim
+    // parameter in a special way we just cut it out from the output matrix.
+    const arma::Mat<eT> workingOutput = arma::real(arma::ifft2(spectrum));
+    output = workingOutput.submat(filterRows - 1, filterCols - 1,
+        filterRows - 1 + outputRows - 1, filterCols - 1 + outputCols - 1);
+  }
+
+ private:
+  //! Return whether the border mode is the full convolution.
+  static bool IsFull()
+  {
+    return std::is_same<BorderMode, FullConvolution>::value;
+  }
 };  // class FFTConvolution
 
+/**
+ * This is a template struct that tells whether a convolution rule is an
+ * FFTConvolution, whose filter spectra are kept and reused by ConvLayer.
+ */
+template<typename ConvolutionRule>
+struct IsFFTConvolution
+{
+  static const bool value = false;
+};
+
+//! FFTConvolution can reuse the spectra of the filters.
+template<typename BorderMode, const bool padLastDim>
+struct IsFFTConvolution<FFTConvolution<BorderMode, padLastDim> >
+{
+  static const bool value = true;
+};
+
 } // namespace ann
 } // namespace mlpack
 
@@ -0,0 +1,330 @@
+/**
+ * @file im2col_convolution.hpp
+ *
+ * Implementation of the convolution through im2col and matrix multiplication.
+ */
+#ifndef MLPACK_METHODS_ANN_CONVOLUTION_RULES_IM2COL_CONVOLUTION_HPP
+#define MLPACK_METHODS_ANN_CONVOLUTION_RULES_IM2COL_CONVOLUTION_HPP
+
+#include <mlpack/core.hpp>
+#include "border_modes.hpp"
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * Computes the two-dimensional convolution by lowering the input into a matrix
+ * (im2col) and multiplying it with the filters, so that the work is done by a
+ * single GEMM (or GEMV) call of the BLAS library Armadillo uses.  Row p of the
+ * lowered matrix holds the window of the input which is multiplied with the
+ * filter to give output element p; for an input with several maps (slices),
+ * the windows of all the maps are placed next to each other.
+ *
+ * Besides the usual Convolution() overloads, which compute the same results as
+ * NaiveConvolution, this class can convolve all the maps of an input with the
+ * filters of all the output maps at once, and compute the gradient of the
+ * filters in one multiplication.  ConvLayer uses these when this class is
+ * given as a convolution rule.
+ *
+ * FullConvolution: returns the full two-dimensional convolution.
+ * ValidConvolution: returns only those parts of the convolution that are
+ * computed without the zero-padded edges.
+ *
+ * @tparam BorderMode Type of the border mode (FullConvolution or
+ * ValidConvolution).
+ */
+template<typename BorderMode = FullConvolution>
+class Im2ColConvolution
+{
+ public:
+  /*
+   * Lower all the maps of the input with the given filter size: row p of the
+   * lowered matrix holds the filterRows x filterCols window (in column-major
+   * order) of output element p, for each map in turn.  In full mode, the
+   * input is zero-padded first.
+   *
+   * @param input Input to be lowered.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param patches Matrix to store the lowered input in.
+   * @param outputRows Number of rows of the output of the convolution.
+   * @param outputCols Number of columns of the output of the convolution.
+   */
+  template<typename eT, typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, ValidConvolution>::value, void>::type
+  Im2Col(const arma::Cube<eT>& input,
+         const size_t filterRows,
+         const size_t filterCols,
+         arma::Mat<eT>& patches,
+         size_t& outputRows,
+         size_t& outputCols)
+  {
+    Lower(input, filterRows, filterCols, patches, outputRows, outputCols);
+  }
+
+  /*
+   * Lower all the maps of the input with the given filter size (full mode).
+   *
+   * @param input Input to be lowered.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param patches Matrix to store the lowered input in.
+   * @param outputRows Number of rows of the output of the convolution.
+   * @param outputCols Number of columns of the output of the convolution.
+   */
+  template<typename eT, typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, FullConvolution>::value, void>::type
+  Im2Col(const arma::Cube<eT>& input,
+         const size_t filterRows,
+         const size_t filterCols,
+         arma::Mat<eT>& patches,
+         size_t& outputRows,
+         size_t& outputCols)
+  {
+    // Pad the input to the working output shape.
+    arma::Cube<eT> inputPadded = arma::zeros<arma::Cube<eT> >(
+        input.n_rows + 2 * (filterRows - 1),
+        input.n_cols + 2 * (filterCols - 1), input.n_slices);
+    inputPadded.subcube(filterRows - 1, filterCols - 1, 0,
+        filterRows - 1 + input.n_rows - 1,
+        filterCols - 1 + input.n_cols - 1, input.n_slices - 1) = input;
+
+    Lower(inputPadded, filterRows, filterCols, patches, outputRows,
+        outputCols);
+  }
+
+  /*
+   * Perform a convolution of all the maps of the input with the filters of
+   * several output maps: output.slice(j) is the sum over the input maps i of
+   * the convolution of input.slice(i) with filter i of output map j.  The
+   * filters of output map j are stored in column j of filters, one after the
+   * other (each in column-major order), so filters has filterRows *
+   * filterCols * input.n_slices rows.  This takes one matrix multiplication.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filters Filters used to perform the convolution.
+   * @param filterRows Number of rows of each filter.
+   * @param filterCols Number of columns of each filter.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Cube<eT>& input,
+                          const arma::Mat<eT>& filters,
+                          const size_t filterRows,
+                          const size_t filterCols,
+                          arma::Cube<eT>& output)
+  {
+    arma::Mat<eT> patches;
+    size_t outputRows, outputCols;
+    Im2Col(input, filterRows, filterCols, patches, outputRows, outputCols);
+
+    const arma::Mat<eT> convOutput = patches * filters;
+    output = arma::Cube<eT>(convOutput.memptr(), outputRows, outputCols,
+        filters.n_cols);
+  }
+
+  /*
+   * Compute the gradient of the filters of the multiple map convolution above,
+   * given the input and the error of each output map: column j of gradient
+   * holds, for each input map i, the convolution of input.slice(i) with
+   * delta.slice(j), which has the size of a filter.  This takes one matrix
+   * multiplication.
+   *
+   * @param input Input the convolution was performed on.
+   * @param delta Error of each map of the output of the convolution.
+   * @param filterRows Number of rows of each filter.
+   * @param filterCols Number of columns of each filter.
+   * @param gradient Matrix to store the gradient of the filters in, with the
+   *     same layout as the filters.
+   */
+  template<typename eT>
+  static void FilterGradient(const arma::Cube<eT>& input,
+                             const arma::Cube<eT>& delta,
+                             const size_t filterRows,
+                             const size_t filterCols,
+                             arma::Mat<eT>& gradient)
+  {
+    arma::Mat<eT> patches;
+    size_t outputRows, outputCols;
+    Im2Col(input, filterRows, filterCols, patches, outputRows, outputCols);
+
+    if (outputRows != delta.n_rows || outputCols != delta.n_cols)
+    {
+      std::ostringstream oss;
+      oss << "Im2ColConvolution::FilterGradient(): delta has size "
+          << delta.n_rows << "x" << delta.n_cols << ", but the output of the "
+          << "convolution has size " << outputRows << "x" << outputCols << "!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    // Each slice of delta becomes one column.
+    const arma::Mat<eT> deltaMat(const_cast<eT*>(delta.memptr()),
+        delta.n_rows * delta.n_cols, delta.n_slices, false, true);
+    gradient = trans(patches) * deltaMat;
+  }
+
+  /*
+   * Perform a convolution.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Mat<eT>& input,
+                          const arma::Mat<eT>& filter,
+                          arma::Mat<eT>& output)
+  {
+    const arma::Cube<eT> inputCube(const_cast<eT*>(input.memptr()),
+        input.n_rows, input.n_cols, 1, false, true);
+
+    arma::Mat<eT> patches;
+    size_t outputRows, outputCols;
+    Im2Col(inputCube, filter.n_rows, filter.n_cols, patches, outputRows,
+        outputCols);
+
+    output = patches * arma::vectorise(filter);
+    output.reshape(outputRows, outputCols);
+  }
+
+  /*
+   * Perform a convolution using 3rd order tensors.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Cube<eT>& input,
+                          const arma::Cube<eT>& filter,
+                          arma::Cube<eT>& output)
+  {
+    arma::Mat<eT> convOutput;
+    Im2ColConvolution<BorderMode>::Convolution(input.slice(0),
+        filter.slice(0), convOutput);
+
+    output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
+        input.n_slices);
+    output.slice(0) = convOutput;
+
+    for (size_t i = 1; i < input.n_slices; i++)
+    {
+      Im2ColConvolution<BorderMode>::Convolution(input.slice(i),
+          filter.slice(i), convOutput);
+      output.slice(i) = convOutput;
+    }
+  }
+
+  /*
+   * Perform a convolution using dense matrix as input and a 3rd order tensors
+   * as filter and output.  The input is lowered once, and all the filters are
+   * applied in one matrix multiplication.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Mat<eT>& input,
+                          const arma::Cube<eT>& filter,
+                          arma::Cube<eT>& output)
+  {
+    const arma::Cube<eT> inputCube(const_cast<eT*>(input.memptr()),
+        input.n_rows, input.n_cols, 1, false, true);
+
+    // Each slice of the filter becomes one column.
+    const arma::Mat<eT> filters(const_cast<eT*>(filter.memptr()),
+        filter.n_rows * filter.n_cols, filter.n_slices, false, true);
+
+    Convolution(inputCube, filters, filter.n_rows, filter.n_cols, output);
+  }
+
+  /*
+   * Perform a convolution using a 3rd order tensors as input and output and a
+   * dense matrix as filter.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Cube<eT>& input,
+                          const arma::Mat<eT>& filter,
+                          arma::Cube<eT>& output)
+  {
+    arma::Mat<eT> convOutput;
+    Im2ColConvolution<BorderMode>::Convolution(input.slice(0), filter,
+        convOutput);
+
+    output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
+        input.n_slices);
+    output.slice(0) = convOutput;
+
+    for (size_t i = 1; i < input.n_slices; i++)
+    {
+      Im2ColConvolution<BorderMode>::Convolution(input.slice(i), filter,
+          convOutput);
+      output.slice(i) = convOutput;
+    }
+  }
+
+ private:
+  /*
+   * Lower all the maps of the (already padded) input; see Im2Col().  Each
+   * column of the lowered matrix is filled with contiguous copies of the
+   * columns of the input.
+   */
+  template<typename eT>
+  static void Lower(const arma::Cube<eT>& input,
+                    const size_t filterRows,
+                    const size_t filterCols,
+                    arma::Mat<eT>& patches,
+                    size_t& outputRows,
+                    size_t& outputCols)
+  {
+    outputRows = input.n_rows - filterRows + 1;
+    outputCols = input.n_cols - filterCols + 1;
+    patches.set_size(outputRows * outputCols,
+        filterRows * filterCols * input.n_slices);
+
+    for (size_t s = 0, c = 0; s < input.n_slices; ++s)
+    {
+      for (size_t kj = 0; kj < filterCols; ++kj)
+      {
+        for (size_t ki = 0; ki < filterRows; ++ki, ++c)
+        {
+          eT* patchesPtr = patches.colptr(c);
+          for (size_t j = 0; j < outputCols; ++j, patchesPtr += outputRows)
+          {
+            const eT* inputPtr = input.slice_colptr(s, j + kj) + ki;
+            std::copy(inputPtr, inputPtr + outputRows, patchesPtr);
+          }
+        }
+      }
+    }
+  }
+};  // class Im2ColConvolution
+
+/**
+ * This is a template struct that tells whether a convolution rule is an
+ * Im2ColConvolution, whose multiple map convolution is used by ConvLayer.
+ */
+template<typename ConvolutionRule>
+struct IsIm2ColConvolution
+{
+  static const bool value = false;
+};
+
+//! Im2ColConvolution can convolve all the maps at once.
+template<typename BorderMode>
+struct IsIm2ColConvolution<Im2ColConvolution<BorderMode> >
+{
+  static const bool value = true;
+};
+
+} // namespace ann
+} // namespace mlpack
+
+#endif
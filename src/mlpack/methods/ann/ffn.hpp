@@ -25,12 +25,20 @@ namespace ann /** Artificial Neural Network. */ {
  * @tparam OutputLayerType The output layer type used to evaluate the network.
  * @tparam InitializationRuleType Rule used to initialize the weight matrix.
  * @tparam PerformanceFunction Performance strategy used to calculate the error.
+ * @tparam InputMatType Type of the matrix of predictors (arma::mat, arma::fmat
+ *         or arma::sp_mat).  With sparse predictors, the first layer should
+ *         take sparse input, like SparseInputLayer<arma::sp_mat>.  With
+ *         arma::fmat predictors, the layers should use arma::fmat too; the
+ *         network is then evaluated in single precision, while the parameters
+ *         seen by the optimizer (Parameters()) are kept in double precision as
+ *         master weights, and copied into the layers before each evaluation.
  */
 template <
   typename LayerTypes,
   typename OutputLayerType,
   typename InitializationRuleType = NguyenWidrowInitialization,
-  class PerformanceFunction = CrossEntropyErrorFunction<>
+  class PerformanceFunction = CrossEntropyErrorFunction<>,
+  typename InputMatType = arma::mat
 >
 class FFN
 {
@@ -39,7 +47,11 @@ class FFN
   using NetworkType = FFN<LayerTypes,
                           OutputLayerType,
                           InitializationRuleType,
-                          PerformanceFunction>;
+                          PerformanceFunction,
+                          InputMatType>;
+
+  //! The type of the elements of the predictors, the responses and the layers.
+  typedef typename InputMatType::elem_type ElemType;
 
   /**
    * Create the FFN object with the given predictors and responses set (this is
@@ -62,8 +74,8 @@ class FFN
            template<typename> class OptimizerType>
   FFN(LayerType &&network,
       OutputType &&outputLayer,
-      const arma::mat& predictors,
-      const arma::mat& responses,
+      const InputMatType& predictors,
+      const arma::Mat<ElemType>& responses,
       OptimizerType<NetworkType>& optimizer,
       InitializationRuleType initializeRule = InitializationRuleType(),
       PerformanceFunction performanceFunction = PerformanceFunction());
@@ -85,8 +97,8 @@ class FFN
   template<typename LayerType, typename OutputType>
   FFN(LayerType &&network,
       OutputType &&outputLayer,
-      const arma::mat& predictors,
-      const arma::mat& responses,
+      const InputMatType& predictors,
+      const arma::Mat<ElemType>& responses,
       InitializationRuleType initializeRule = InitializationRuleType(),
       PerformanceFunction performanceFunction = PerformanceFunction());
 
@@ -124,7 +136,8 @@ class FFN
   template<
       template<typename> class OptimizerType = mlpack::optimization::RMSprop
   >
-  void Train(const arma::mat& predictors, const arma::mat& responses);
+  void Train(const InputMatType& predictors,
+             const arma::Mat<ElemType>& responses);
 
   /**
    * Train the feedforward network with the given instantiated optimizer.
@@ -158,8 +171,8 @@ class FFN
   template<
       template<typename> class OptimizerType = mlpack::optimization::RMSprop
   >
-  void Train(const arma::mat& predictors,
-             const arma::mat& responses,
+  void Train(const InputMatType& predictors,
+             const arma::Mat<ElemType>& responses,
              OptimizerType<NetworkType>& optimizer);
 
   /**
@@ -170,7 +183,7 @@ class FFN
    * @param predictors Input predictors.
    * @param responses Matrix to put output predictions of responses into.
    */
-  void Predict(arma::mat& predictors, arma::mat& responses);
+  void Predict(InputMatType& predictors, arma::Mat<ElemType>& responses);
 
   /**
    * Evaluate the feedforward network with the given parameters. This function
@@ -198,14 +211,74 @@ class FFN
                 const size_t i,
                 arma::mat& gradient);
 
+  /**
+   * Evaluate the feedforward network with the given parameters on a batch of
+   * consecutive points, which are propagated through the network together (one
+   * column per point), so that each layer works on a matrix instead of a
+   * vector.  The result is the sum of the objectives of the points.
+   *
+   * @param parameters Matrix model parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param deterministic Whether or not to train or test the model. Note some
+   * layer act differently in training or testing mode.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic = true);
+
+  /**
+   * Evaluate the gradient of the feedforward network with the given
+   * parameters, summed over a batch of consecutive points, which are
+   * propagated through the network together.  This is used by optimizers such
+   * as mini-batch SGD.
+   *
+   * A batch of more than ShardSize() points is split into shards of
+   * ShardSize() points, whose gradients are computed in parallel with OpenMP
+   * and then summed in order, so the result does not depend on the number of
+   * threads.  Each thread but the calling one propagates its shards through
+   * its own copy of the layers (made the first time it is needed, and again
+   * after the layers are modified through Network(), trained or loaded), which
+   * shares the parameters of the network.  The layers must therefore give the
+   * gradient of a batch as the sum of the gradients of its points (which is
+   * not the case for the layers of the sparse autoencoder).
+   *
+   * @param parameters Matrix of the model parameters to be optimized.
+   * @param begin Index of the first point of the batch.
+   * @param gradient Matrix to output gradient into.
+   * @param batchSize Number of points in the batch.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize);
+
   //! Return the number of separable functions (the number of predictor points).
   size_t NumFunctions() const { return numFunctions; }
 
+  //! Get the number of points of each shard of a batch whose gradient is
+  //! computed in parallel (0 means that batches are not split).
+  size_t ShardSize() const { return shardSize; }
+  //! Modify the number of points of each shard of a batch whose gradient is
+  //! computed in parallel (0 means that batches are not split).
+  size_t& ShardSize() { return shardSize; }
+
   //! Return the initial point for the optimization.
   const arma::mat& Parameters() const { return parameter; }
   //! Modify the initial point for the optimization.
   arma::mat& Parameters() { return parameter; }
 
+  //! Get the layers of the network.
+  const LayerTypes& Network() const { return network; }
+  //! Modify the layers of the network.  The copies of the layers used by the
+  //! other threads in Gradient() are dropped, and made again from the modified
+  //! layers when they are next needed.
+  LayerTypes& Network() { ResetReplicas(); return network; }
+
+  //! Get the output layer of the network.
+  const OutputLayerType& OutputLayer() const { return outputLayer; }
+
   //! Serialize the model.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
@@ -310,12 +383,38 @@ private:
                      ErrorType& error,
                      const std::tuple<Tp...>& network)
   {
-    // Calculate and store the output error.
+    // Output layers which compute their own loss along with the error (like
+    // the SoftmaxCrossEntropyLayer) return it; otherwise the network's
+    // performance is measured with the specified performance function.
+    typedef decltype(outputLayer.CalculateError(std::get<sizeof...(Tp) - 1>(
+        network).OutputParameter(), target, error)) ErrorReturnType;
+    return OutputError(target, error, network,
+        std::is_same<ErrorReturnType, double>());
+  }
+
+  //! Calculate and store the output error, and return the loss computed by
+  //! the output layer.
+  template<typename DataType, typename ErrorType, typename... Tp>
+  double OutputError(const DataType& target,
+                     ErrorType& error,
+                     const std::tuple<Tp...>& network,
+                     std::true_type /* outputLayerLoss */)
+  {
+    return outputLayer.CalculateError(
+        std::get<sizeof...(Tp) - 1>(network).OutputParameter(), target, error);
+  }
+
+  //! Calculate and store the output error, and return the error given by the
+  //! performance function.
+  template<typename DataType, typename ErrorType, typename... Tp>
+  double OutputError(const DataType& target,
+                     ErrorType& error,
+                     const std::tuple<Tp...>& network,
+                     std::false_type /* outputLayerLoss */)
+  {
     outputLayer.CalculateError(
         std::get<sizeof...(Tp) - 1>(network).OutputParameter(), target, error);
 
-    // Measures the network's performance with the specified performance
-    // function.
     return performanceFunc.Error(network, target, error);
   }
 
@@ -394,6 +493,133 @@ private:
     /* Nothing to do here */
   }
 
+  //! Return the given columns of dense predictors or responses, as an alias.
+  template<typename eT>
+  static const arma::Mat<eT> Columns(const arma::Mat<eT>& predictors,
+                                     const size_t begin,
+                                     const size_t count)
+  {
+    return arma::Mat<eT>(const_cast<eT*>(predictors.colptr(begin)),
+        predictors.n_rows, count, false, true);
+  }
+
+  //! Return the given columns of sparse predictors.
+  static arma::sp_mat Columns(const arma::sp_mat& predictors,
+                              const size_t begin,
+                              const size_t count)
+  {
+    return predictors.cols(begin, begin + count - 1);
+  }
+
+  /**
+   * Compute the gradient of the given copy of the network, summed over the
+   * given points, and store it in gradient; the output error is stored in
+   * outputError.  Return the objective of the points.
+   */
+  template<typename... Tp>
+  double ShardGradient(std::tuple<Tp...>& network,
+                       const size_t begin,
+                       const size_t batchSize,
+                       arma::Mat<ElemType>& gradient,
+                       arma::Mat<ElemType>& outputError)
+  {
+    ResetParameter(network);
+
+    Forward(Columns(predictors, begin, batchSize), network);
+    const double objective = OutputError(Columns(responses, begin, batchSize),
+        outputError, network);
+
+    NetworkGradients(gradient, network);
+
+    Backward<>(outputError, network);
+    UpdateGradients<>(network);
+
+    return objective;
+  }
+
+  //! Return the matrix whose memory the layers use as their weights: the
+  //! parameters themselves.
+  template<typename eT = ElemType>
+  typename std::enable_if<std::is_same<eT, double>::value, arma::mat&>::type
+  LayerParameters() { return parameter; }
+
+  //! Return the matrix whose memory the layers use as their weights: a single
+  //! precision copy of the parameters (see SyncParameters()).
+  template<typename eT = ElemType>
+  typename std::enable_if<!std::is_same<eT, double>::value,
+      arma::Mat<eT>&>::type
+  LayerParameters()
+  {
+    if (layerParameter.n_elem != parameter.n_elem)
+      layerParameter.set_size(parameter.n_rows, parameter.n_cols);
+
+    return layerParameter;
+  }
+
+  //! Update the weights of the layers from the parameters (nothing to do for
+  //! double precision layers).
+  template<typename eT = ElemType>
+  typename std::enable_if<std::is_same<eT, double>::value, void>::type
+  SyncParameters() { }
+
+  //! Update the weights of the layers from the parameters, by converting them
+  //! into the single precision copy.
+  template<typename eT = ElemType>
+  typename std::enable_if<!std::is_same<eT, double>::value, void>::type
+  SyncParameters()
+  {
+    std::copy(parameter.begin(), parameter.end(), layerParameter.begin());
+  }
+
+  //! Return the matrix whose memory the layers store their gradients in: the
+  //! given gradient itself.
+  template<typename eT = ElemType>
+  typename std::enable_if<std::is_same<eT, double>::value, arma::mat&>::type
+  GradientStorage(arma::mat& gradient) { return gradient; }
+
+  //! Return the matrix whose memory the layers store their gradients in: a
+  //! single precision gradient, which StoreGradient() converts.
+  template<typename eT = ElemType>
+  typename std::enable_if<!std::is_same<eT, double>::value,
+      arma::Mat<eT>&>::type
+  GradientStorage(arma::mat& gradient)
+  {
+    layerGradient.zeros(gradient.n_rows, gradient.n_cols);
+    return layerGradient;
+  }
+
+  //! Store the gradient computed by the layers in the given gradient (nothing
+  //! to do for double precision layers).
+  template<typename eT = ElemType>
+  typename std::enable_if<std::is_same<eT, double>::value, void>::type
+  StoreGradient(arma::mat& /* gradient */) { }
+
+  //! Store the single precision gradient computed by the layers in the given
+  //! gradient.
+  template<typename eT = ElemType>
+  typename std::enable_if<!std::is_same<eT, double>::value, void>::type
+  StoreGradient(arma::mat& gradient)
+  {
+    std::copy(layerGradient.begin(), layerGradient.end(), gradient.begin());
+  }
+
+  //! Return a tuple which holds the layers of the given tuple by value
+  //! (declaration only; used to get the type of the network replicas).
+  template<typename... Tp>
+  static std::tuple<typename std::decay<Tp>::type...> OwnedLayers(
+      const std::tuple<Tp...>& network);
+
+  //! The type of a copy of the network which owns its layers.
+  typedef decltype(OwnedLayers(std::declval<LayerTypes>())) ReplicaType;
+
+  //! Drop the copies of the layers used by the other threads, so that they are
+  //! copied again from the current layers when they are next needed.
+  void ResetReplicas()
+  {
+    replicas.clear();
+    replicaErrors.clear();
+  }
+
   /*
    * Calculate and store the output activation.
    */
@@ -421,16 +647,37 @@ private:
   arma::mat parameter;
 
   //! The matrix of data points (predictors).
-  arma::mat predictors;
+  InputMatType predictors;
 
   //! The matrix of responses to the input data points.
-  arma::mat responses;
+  arma::Mat<ElemType> responses;
 
   //! The number of separable functions (the number of predictor points).
   size_t numFunctions;
 
   //! Locally stored backward error.
-  arma::mat error;
+  arma::Mat<ElemType> error;
+
+  //! The number of points of each shard of a batch whose gradient is computed
+  //! in parallel.
+  size_t shardSize;
+
+  //! Copies of the network used by the other threads to compute gradients.
+  std::vector<ReplicaType> replicas;
+
+  //! The output error of each replica.
+  std::vector<arma::Mat<ElemType> > replicaErrors;
+
+  //! The gradient of each shard of the current batch.
+  std::vector<arma::Mat<ElemType> > shardGradients;
+
+  //! The single precision copy of the parameters used by the layers (empty
+  //! for double precision layers, which use the parameters directly).
+  arma::Mat<ElemType> layerParameter;
+
+  //! The single precision gradient computed by the layers (empty for double
+  //! precision layers).
+  arma::Mat<ElemType> layerGradient;
 }; // class FFN
 
 } // namespace ann
@@ -17,17 +17,19 @@ namespace ann /** Artificial Neural Network. */ {
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<typename LayerType,
          typename OutputType,
          template<typename> class OptimizerType
 >
-FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::FFN(LayerType &&network,
        OutputType &&outputLayer,
-       const arma::mat& predictors,
-       const arma::mat& responses,
+       const InputMatType& predictors,
+       const arma::Mat<ElemType>& responses,
        OptimizerType<NetworkType>& optimizer,
        InitializationRuleType initializeRule,
        PerformanceFunction performanceFunction) :
@@ -36,7 +38,8 @@ FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     performanceFunc(std::move(performanceFunction)),
     predictors(predictors),
     responses(responses),
-    numFunctions(predictors.n_cols)
+    numFunctions(predictors.n_cols),
+    shardSize(32)
 {
   static_assert(std::is_same<typename std::decay<LayerType>::type,
                   LayerTypes>::value,
@@ -47,7 +50,8 @@ FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
                 "The type of outputLayer must be OutputLayerType.");
 
   initializeRule.Initialize(parameter, NetworkSize(this->network), 1);
-  NetworkWeights(parameter, this->network);
+  NetworkWeights(LayerParameters(), this->network);
+  SyncParameters();
 
   // Train the model.
   Timer::Start("ffn_optimization");
@@ -61,19 +65,22 @@ FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<typename LayerType, typename OutputType>
-FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::FFN(LayerType &&network,
        OutputType &&outputLayer,
-       const arma::mat& predictors,
-       const arma::mat& responses,
+       const InputMatType& predictors,
+       const arma::Mat<ElemType>& responses,
        InitializationRuleType initializeRule,
        PerformanceFunction performanceFunction) :
     network(std::forward<LayerType>(network)),
     outputLayer(std::forward<OutputType>(outputLayer)),
-    performanceFunc(std::move(performanceFunction))
+    performanceFunc(std::move(performanceFunction)),
+    shardSize(32)
 {
   static_assert(std::is_same<typename std::decay<LayerType>::type,
                   LayerTypes>::value,
@@ -84,7 +91,8 @@ FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
                 "The type of outputLayer must be OutputLayerType.");
 
   initializeRule.Initialize(parameter, NetworkSize(this->network), 1);
-  NetworkWeights(parameter, this->network);
+  NetworkWeights(LayerParameters(), this->network);
+  SyncParameters();
 
   Train(predictors, responses);
 }
@@ -92,17 +100,20 @@ FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<typename LayerType, typename OutputType>
-FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::FFN(LayerType &&network,
        OutputType &&outputLayer,
        InitializationRuleType initializeRule,
        PerformanceFunction performanceFunction) :
     network(std::forward<LayerType>(network)),
     outputLayer(std::forward<OutputType>(outputLayer)),
-    performanceFunc(std::move(performanceFunction))
+    performanceFunc(std::move(performanceFunction)),
+    shardSize(32)
 {
   static_assert(std::is_same<typename std::decay<LayerType>::type,
                   LayerTypes>::value,
@@ -113,18 +124,22 @@ FFN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
                 "The type of outputLayer must be OutputLayerType.");
 
   initializeRule.Initialize(parameter, NetworkSize(this->network), 1);
-  NetworkWeights(parameter, this->network);
+  NetworkWeights(LayerParameters(), this->network);
+  SyncParameters();
 }
 
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<template<typename> class OptimizerType>
 void FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
->::Train(const arma::mat& predictors, const arma::mat& responses)
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
+>::Train(const InputMatType& predictors,
+         const arma::Mat<ElemType>& responses)
 {
   numFunctions = predictors.n_cols;
   this->predictors = predictors;
@@ -132,6 +147,10 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 
   OptimizerType<decltype(*this)> optimizer(*this);
 
+  // The layers may have changed since the copies used by the other threads
+  // were made.
+  ResetReplicas();
+
   // Train the model.
   Timer::Start("ffn_optimization");
   const double out = optimizer.Optimize(parameter);
@@ -144,19 +163,25 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<template<typename> class OptimizerType>
 void FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
->::Train(const arma::mat& predictors,
-         const arma::mat& responses,
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
+>::Train(const InputMatType& predictors,
+         const arma::Mat<ElemType>& responses,
          OptimizerType<NetworkType>& optimizer)
 {
   numFunctions = predictors.n_cols;
   this->predictors = predictors;
   this->responses = responses;
 
+  // The layers may have changed since the copies used by the other threads
+  // were made.
+  ResetReplicas();
+
   // Train the model.
   Timer::Start("ffn_optimization");
   const double out = optimizer.Optimize(parameter);
@@ -169,15 +194,21 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<
     template<typename> class OptimizerType
 >
 void FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::Train(OptimizerType<NetworkType>& optimizer)
 {
+  // The layers may have changed since the copies used by the other threads
+  // were made.
+  ResetReplicas();
+
   // Train the model.
   Timer::Start("ffn_optimization");
   const double out = optimizer.Optimize(parameter);
@@ -190,64 +221,56 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 void FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
->::Predict(arma::mat& predictors, arma::mat& responses)
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
+>::Predict(InputMatType& predictors, arma::Mat<ElemType>& responses)
 {
   deterministic = true;
-
-  arma::mat responsesTemp;
+  SyncParameters();
   ResetParameter(network);
-  Forward(arma::mat(predictors.colptr(0), predictors.n_rows, 1, false, true),
-      network);
-  OutputPrediction(responsesTemp, network);
 
-  responses = arma::mat(responsesTemp.n_elem, predictors.n_cols);
-  responses.col(0) = responsesTemp.col(0);
-
-  for (size_t i = 1; i < predictors.n_cols; i++)
-  {
-    Forward(arma::mat(predictors.colptr(i), predictors.n_rows, 1, false, true),
-        network);
-
-    responsesTemp = arma::mat(responses.colptr(i), responses.n_rows, 1, false,
-        true);
-    OutputPrediction(responsesTemp, network);
-    responses.col(i) = responsesTemp.col(0);
-  }
+  // All the points are propagated through the network together, one per
+  // column.
+  Forward(predictors, network);
+  OutputPrediction(responses, network);
 }
 
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 double FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::Evaluate(const arma::mat& /* unused */,
             const size_t i,
             const bool deterministic)
 {
   this->deterministic = deterministic;
 
+  SyncParameters();
   ResetParameter(network);
 
-  Forward(arma::mat(predictors.colptr(i), predictors.n_rows, 1, false, true),
-      network);
+  Forward(Columns(predictors, i, 1), network);
 
-  return OutputError(arma::mat(responses.colptr(i), responses.n_rows, 1, false,
-      true), error, network);
+  return OutputError(Columns(responses, i, 1), error, network);
 }
 
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 void FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::Gradient(const arma::mat& /* unused */,
             const size_t i,
             arma::mat& gradient)
@@ -260,20 +283,130 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 
   Evaluate(parameter, i, false);
 
-  NetworkGradients(gradient, network);
+  NetworkGradients(GradientStorage(gradient), network);
 
   Backward<>(error, network);
   UpdateGradients<>(network);
+  StoreGradient(gradient);
+}
+
+template<typename LayerTypes,
+         typename OutputLayerType,
+         typename InitializationRuleType,
+         typename PerformanceFunction,
+         typename InputMatType
+>
+double FFN<
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
+>::Evaluate(const arma::mat& /* unused */,
+            const size_t begin,
+            const size_t batchSize,
+            const bool deterministic)
+{
+  this->deterministic = deterministic;
+
+  SyncParameters();
+  ResetParameter(network);
+
+  Forward(Columns(predictors, begin, batchSize), network);
+
+  return OutputError(Columns(responses, begin, batchSize), error, network);
+}
+
+template<typename LayerTypes,
+         typename OutputLayerType,
+         typename InitializationRuleType,
+         typename PerformanceFunction,
+         typename InputMatType
+>
+void FFN<
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
+>::Gradient(const arma::mat& /* unused */,
+            const size_t begin,
+            arma::mat& gradient,
+            const size_t batchSize)
+{
+  if (gradient.is_empty())
+  {
+    gradient = arma::zeros<arma::mat>(parameter.n_rows, parameter.n_cols);
+  }
+
+  // The layers sum the gradients of the points of the batch.
+  deterministic = false;
+  SyncParameters();
+  if (shardSize == 0 || batchSize <= shardSize)
+  {
+    ShardGradient(network, begin, batchSize, GradientStorage(gradient), error);
+    StoreGradient(gradient);
+    return;
+  }
+
+  // The calling thread uses this network, and each other thread a copy of it,
+  // which shares the parameters.
+  const size_t numShards = (batchSize + shardSize - 1) / shardSize;
+  #ifdef _OPENMP
+    const size_t numThreads = omp_get_max_threads();
+  #else
+    const size_t numThreads = 1;
+  #endif
+
+  while (replicas.size() + 1 < numThreads)
+    replicas.push_back(ReplicaType(network));
+  replicaErrors.resize(replicas.size());
+  for (size_t i = 0; i < replicas.size(); ++i)
+    NetworkWeights(LayerParameters(), replicas[i]);
+
+  shardGradients.resize(numShards);
+
+  // With static scheduling, the calling thread always computes the first
+  // shard, so no layer of this network is left assuming that it was the last
+  // to write the gradient which the sum below overwrites (see
+  // SparseInputLayer::Gradient()).
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t s = 0; s < (omp_size_t) numShards; ++s)
+  {
+    const size_t shardBegin = begin + s * shardSize;
+    const size_t shardPoints = std::min(shardSize,
+        begin + batchSize - shardBegin);
+
+    size_t thread = 0;
+    #ifdef _OPENMP
+      thread = omp_get_thread_num();
+    #endif
+
+    arma::Mat<ElemType>& shardGradient = shardGradients[s];
+    shardGradient.zeros(parameter.n_rows, parameter.n_cols);
+    if (thread == 0)
+    {
+      ShardGradient(network, shardBegin, shardPoints, shardGradient, error);
+    }
+    else
+    {
+      ShardGradient(replicas[thread - 1], shardBegin, shardPoints,
+          shardGradient, replicaErrors[thread - 1]);
+    }
+  }
+
+  // Add up the gradients of the shards in order.
+  arma::Mat<ElemType>& totalGradient = GradientStorage(gradient);
+  totalGradient = shardGradients[0];
+  for (size_t s = 1; s < numShards; ++s)
+    totalGradient += shardGradients[s];
+  StoreGradient(gradient);
 }
 
 template<typename LayerTypes,
          typename OutputLayerType,
          typename InitializationRuleType,
-         typename PerformanceFunction
+         typename PerformanceFunction,
+         typename InputMatType
 >
 template<typename Archive>
 void FFN<
-LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction,
+    InputMatType
 >::Serialize(Archive& ar, const unsigned int /* version */)
 {
   ar & data::CreateNVP(parameter, "parameter");
@@ -281,7 +414,9 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
   // If we are loading, we need to initialize the weights.
   if (Archive::is_loading::value)
   {
-    NetworkWeights(parameter, network);
+    NetworkWeights(LayerParameters(), network);
+    SyncParameters();
+    ResetReplicas();
   }
 }
 
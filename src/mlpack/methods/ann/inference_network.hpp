@@ -0,0 +1,184 @@
+/**
+ * @file inference_network.hpp
+ *
+ * Definition of the InferenceNetwork class, which holds a trained feed forward
+ * network in a form that can only be used for prediction.
+ */
+#ifndef MLPACK_METHODS_ANN_INFERENCE_NETWORK_HPP
+#define MLPACK_METHODS_ANN_INFERENCE_NETWORK_HPP
+
+#include <mlpack/core.hpp>
+
+#include <mlpack/methods/ann/layer/layer_traits.hpp>
+#include <mlpack/methods/ann/layer/linear_layer.hpp>
+#include <mlpack/methods/ann/layer/bias_layer.hpp>
+#include <mlpack/methods/ann/layer/base_layer.hpp>
+#include <mlpack/methods/ann/layer/dropout_layer.hpp>
+
+#include <functional>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * An inference-only copy of a trained feed forward network (FFN), for fast
+ * prediction.  The layers of the network are turned into a list of stages:
+ *
+ *  - a LinearLayer, the BiasLayer and the BaseLayer (activation) that follow
+ *    it are fused into one stage, which computes f(W * x + b) in place;
+ *  - a DropoutLayer is removed (its deterministic scaling, if any, is folded
+ *    into the stage before it or after it);
+ *  - any other layer is copied, in deterministic mode, and its Forward()
+ *    function is called.
+ *
+ * No delta, gradient or input storage is kept, and the network no longer
+ * depends on the FFN it was made from.  The predictions are the same as the
+ * ones of FFN::Predict(), up to floating-point rounding.
+ *
+ * @code
+ * FFN<decltype(modules), decltype(outputLayer)> net(modules, outputLayer);
+ * net.Train(predictors, responses);
+ *
+ * InferenceNetwork inference(net);
+ * inference.Predict(points, predictions);
+ * @endcode
+ */
+class InferenceNetwork
+{
+ public:
+  /**
+   * Create the inference network from the layers and the output layer of the
+   * given trained feed forward network.
+   *
+   * @param network Trained network to copy.
+   */
+  template<typename NetworkType>
+  explicit InferenceNetwork(const NetworkType& network);
+
+  /**
+   * Predict the responses to the given set of predictors (one point per
+   * column), as FFN::Predict() does.
+   *
+   * @param predictors Input predictors.
+   * @param responses Matrix to put output predictions of responses into.
+   */
+  void Predict(const arma::mat& predictors, arma::mat& responses);
+
+  //! Get the number of stages of the network.
+  size_t NumStages() const { return stages.size(); }
+
+ private:
+  //! Type of an in-place activation function.
+  typedef void (*ActivationType)(const arma::mat&, arma::mat&);
+
+  //! Type of the forward pass of a layer which is not fused.
+  typedef std::function<void(const arma::mat&, arma::mat&)> ForwardType;
+
+  /**
+   * A stage of the network: either the fused f(W * x + b) (where each of W, b
+   * and f may be missing, and W may be replaced by a scale), or the forward
+   * pass of a copied layer.
+   */
+  struct Stage
+  {
+    Stage() : scale(1.0), activation(NULL) { }
+
+    //! The weights (empty if there are none).
+    arma::mat weights;
+    //! The scale used without weights (1 if there is none).
+    double scale;
+    //! The bias (empty if there is none).
+    arma::vec bias;
+    //! The activation function (NULL if there is none).
+    ActivationType activation;
+    //! The forward pass of a copied layer (empty for a fused stage).
+    ForwardType forward;
+  };
+
+  //! Add the layers of the given network from the given one on.
+  template<size_t I = 0, typename... Tp>
+  typename std::enable_if<I == sizeof...(Tp), void>::type
+  AddLayers(const std::tuple<Tp...>& /* network */) { }
+
+  template<size_t I = 0, typename... Tp>
+  typename std::enable_if<I < sizeof...(Tp), void>::type
+  AddLayers(const std::tuple<Tp...>& network)
+  {
+    AddLayer(std::get<I>(network));
+    AddLayers<I + 1, Tp...>(network);
+  }
+
+  //! Start a fused stage with the weights of a linear layer.
+  template<typename InputDataType, typename OutputDataType>
+  void AddLayer(const LinearLayer<InputDataType, OutputDataType>& layer);
+
+  //! Add the bias of a bias layer to the current fused stage.
+  template<typename InputDataType, typename OutputDataType>
+  void AddLayer(const BiasLayer<InputDataType, OutputDataType>& layer);
+
+  //! Add the activation of a base layer to the current fused stage.
+  template<typename ActivationFunction,
+           typename InputDataType,
+           typename OutputDataType>
+  void AddLayer(const BaseLayer<ActivationFunction, InputDataType,
+                                OutputDataType>& layer);
+
+  //! Remove a dropout layer.
+  template<typename InputDataType, typename OutputDataType>
+  void AddLayer(const DropoutLayer<InputDataType, OutputDataType>& layer);
+
+  //! Copy any other layer.
+  template<typename LayerType>
+  void AddLayer(const LayerType& layer);
+
+  //! Return whether the last stage is a fused stage without an activation,
+  //! so that operations which come before the activation can be added to it.
+  bool LastStageFusable() const;
+
+  //! Add a stage for the scale of the removed dropout layers, if any, which
+  //! could not be folded into a stage.
+  void FlushScale();
+
+  //! Put the given layer in deterministic mode, if it has a Deterministic()
+  //! function.
+  template<typename T>
+  static typename std::enable_if<
+      HasDeterministicCheck<T, bool&(T::*)(void)>::value, void>::type
+  SetDeterministic(T& layer) { layer.Deterministic() = true; }
+
+  template<typename T>
+  static typename std::enable_if<
+      !HasDeterministicCheck<T, bool&(T::*)(void)>::value, void>::type
+  SetDeterministic(T& /* layer */) { }
+
+  //! Apply the given activation function in place.
+  template<typename ActivationFunction>
+  static void Activate(const arma::mat& input, arma::mat& output)
+  {
+    ActivationFunction::fn(input, output);
+  }
+
+  //! Apply the given stage to the input.
+  static void Apply(Stage& stage, const arma::mat& input, arma::mat& output);
+
+  //! The stages of the network.
+  std::vector<Stage> stages;
+
+  //! The scale of the input of the next stage, from the removed dropout
+  //! layers after the last activation.
+  double pendingScale;
+
+  //! Compute the output class from the output of the last stage.
+  ForwardType outputClass;
+
+  //! The outputs of the stages, used alternately.
+  arma::mat buffers[2];
+};
+
+} // namespace ann
+} // namespace mlpack
+
+// Include implementation.
+#include "inference_network_impl.hpp"
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * @file inference_network_impl.hpp
+ *
+ * Implementation of the InferenceNetwork class, which holds a trained feed
+ * forward network in a form that can only be used for prediction.
+ */
+#ifndef MLPACK_METHODS_ANN_INFERENCE_NETWORK_IMPL_HPP
+#define MLPACK_METHODS_ANN_INFERENCE_NETWORK_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "inference_network.hpp"
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+template<typename NetworkType>
+InferenceNetwork::InferenceNetwork(const NetworkType& network) :
+    pendingScale(1.0)
+{
+  AddLayers(network.Network());
+  FlushScale();
+
+  typename std::decay<decltype(network.OutputLayer())>::type outputLayer =
+      network.OutputLayer();
+  outputClass = [outputLayer](const arma::mat& input,
+                              arma::mat& output) mutable
+  {
+    outputLayer.OutputClass(input, output);
+  };
+}
+
+inline void InferenceNetwork::Predict(const arma::mat& predictors,
+                                      arma::mat& responses)
+{
+  const arma::mat* input = &predictors;
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    Apply(stages[i], *input, buffers[i % 2]);
+    input = &buffers[i % 2];
+  }
+
+  outputClass(*input, responses);
+}
+
+template<typename InputDataType, typename OutputDataType>
+void InferenceNetwork::AddLayer(
+    const LinearLayer<InputDataType, OutputDataType>& layer)
+{
+  // The scale of the input can be folded into the weights.
+  Stage stage;
+  stage.weights = layer.Weights() * pendingScale;
+  pendingScale = 1.0;
+
+  stages.push_back(std::move(stage));
+}
+
+template<typename InputDataType, typename OutputDataType>
+void InferenceNetwork::AddLayer(
+    const BiasLayer<InputDataType, OutputDataType>& layer)
+{
+  FlushScale();
+
+  const arma::vec bias = layer.Weights() * layer.Bias();
+  if (LastStageFusable())
+  {
+    Stage& stage = stages.back();
+    if (stage.bias.is_empty())
+      stage.bias = bias;
+    else
+      stage.bias += bias;
+  }
+  else
+  {
+    Stage stage;
+    stage.bias = bias;
+    stages.push_back(std::move(stage));
+  }
+}
+
+template<typename ActivationFunction,
+         typename InputDataType,
+         typename OutputDataType>
+void InferenceNetwork::AddLayer(
+    const BaseLayer<ActivationFunction, InputDataType,
+                    OutputDataType>& /* layer */)
+{
+  FlushScale();
+
+  if (!LastStageFusable())
+    stages.push_back(Stage());
+
+  stages.back().activation = &Activate<ActivationFunction>;
+}
+
+template<typename InputDataType, typename OutputDataType>
+void InferenceNetwork::AddLayer(
+    const DropoutLayer<InputDataType, OutputDataType>& layer)
+{
+  // In deterministic mode, the dropout layer only scales its input, if at all.
+  if (!layer.Rescale())
+    return;
+
+  const double scale = 1.0 / (1.0 - layer.Ratio());
+  if (LastStageFusable())
+  {
+    // s * (W * x + b) = (s * W) * x + s * b.
+    Stage& stage = stages.back();
+    if (stage.weights.is_empty())
+      stage.scale *= scale;
+    else
+      stage.weights *= scale;
+    stage.bias *= scale;
+  }
+  else
+  {
+    pendingScale *= scale;
+  }
+}
+
+template<typename LayerType>
+void InferenceNetwork::AddLayer(const LayerType& layer)
+{
+  FlushScale();
+
+  LayerType copy = layer;
+  SetDeterministic(copy);
+
+  Stage stage;
+  stage.forward = [copy](const arma::mat& input, arma::mat& output) mutable
+  {
+    copy.Forward(input, output);
+  };
+  stages.push_back(std::move(stage));
+}
+
+inline bool InferenceNetwork::LastStageFusable() const
+{
+  return !stages.empty() && !stages.back().forward &&
+      stages.back().activation == NULL;
+}
+
+inline void InferenceNetwork::FlushScale()
+{
+  if (pendingScale == 1.0)
+    return;
+
+  Stage stage;
+  stage.scale = pendingScale;
+  pendingScale = 1.0;
+  stages.push_back(std::move(stage));
+}
+
+inline void InferenceNetwork::Apply(Stage& stage,
+                                    const arma::mat& input,
+                                    arma::mat& output)
+{
+  if (stage.forward)
+  {
+    stage.forward(input, output);
+    return;
+  }
+
+  if (!stage.weights.is_empty())
+    output = stage.weights * input;
+  else if (stage.scale != 1.0)
+    output = stage.scale * input;
+  else
+    output = input;
+
+  if (!stage.bias.is_empty())
+    output.each_col() += stage.bias;
+
+  if (stage.activation != NULL)
+    stage.activation(output, output);
+}
+
+} // namespace ann
+} // namespace mlpack
+
+#endif
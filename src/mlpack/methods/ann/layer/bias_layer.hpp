@@ -57,7 +57,9 @@ class BiasLayer
   template<typename eT>
   void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
   {
-    output = input + (weights * bias);
+    // Each column of the input is a separate sample.
+    output = input;
+    output.each_col() += weights * bias;
   }
 
   /**
@@ -109,11 +111,32 @@ class BiasLayer
     gradient = error * bias;
   }
 
+  /*
+   * Calculate the gradient using the output delta of a batch of samples (one
+   * per column) and the bias.  The gradients of the samples are summed.
+   *
+   * @param input The propagated input.
+   * @param error The calculated error.
+   * @param gradient The calculated gradient.
+   */
+  template<typename eT, typename GradientType>
+  void Gradient(const arma::Mat<eT>& /* input */,
+                const arma::Mat<eT>& error,
+                GradientType& gradient)
+  {
+    gradient = arma::sum(error, 1) * bias;
+  }
+
   //! Get the weights.
   InputDataType const& Weights() const { return weights; }
   //! Modify the weights.
   InputDataType& Weights() { return weights; }
 
+  //! Get the bias value, by which the weights are multiplied.
+  double Bias() const { return bias; }
+  //! Modify the bias value, by which the weights are multiplied.
+  double& Bias() { return bias; }
+
   //! Get the input parameter.
   InputDataType const& InputParameter() const { return inputParameter; }
   //! Modify the input parameter.
@@ -11,6 +11,8 @@
 #include <mlpack/methods/ann/layer/layer_traits.hpp>
 #include <mlpack/methods/ann/convolution_rules/border_modes.hpp>
 #include <mlpack/methods/ann/convolution_rules/naive_convolution.hpp>
+#include <mlpack/methods/ann/convolution_rules/im2col_convolution.hpp>
+#include <mlpack/methods/ann/convolution_rules/fft_convolution.hpp>
 
 namespace mlpack {
 namespace ann /** Artificial Neural Network. */ {
@@ -19,6 +21,14 @@ namespace ann /** Artificial Neural Network. */ {
  * Implementation of the ConvLayer class. The ConvLayer class represents a
  * single layer of a neural network.
  *
+ * The filter connecting input map i to output map o is weights.slice(i *
+ * outMaps + o).  With an Im2ColConvolution rule, all the input maps are
+ * convolved with all the filters in a single matrix multiplication.  With an
+ * FFTConvolution rule, each map is transformed once, the convolutions are
+ * summed in the frequency domain, and the spectra of the filters are kept until
+ * the weights or the input size change.  The other rules are applied to each
+ * pair of input and output maps.
+ *
  * @tparam ForwardConvolutionRule Convolution to perform forward process.
  * @tparam BackwardConvolutionRule Convolution to perform backward process.
  * @tparam GradientConvolutionRule Convolution to calculate gradient.
@@ -80,21 +90,7 @@ class ConvLayer
   template<typename eT>
   void Forward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
   {
-    const size_t wConv = ConvOutSize(input.n_rows, wfilter, xStride, wPad);
-    const size_t hConv = ConvOutSize(input.n_cols, hfilter, yStride, hPad);
-
-    output = arma::zeros<arma::Cube<eT> >(wConv, hConv, outMaps);
-    for (size_t outMap = 0, outMapIdx = 0; outMap < outMaps; outMap++)
-    {
-      for (size_t inMap = 0; inMap < inMaps; inMap++, outMapIdx++)
-      {
-        arma::Mat<eT> convOutput;
-        ForwardConvolutionRule::Convolution(input.slice(inMap),
-            weights.slice(outMap), convOutput);
-
-        output.slice(outMap) += convOutput;
-      }
-    }
+    ConvForward<ForwardConvolutionRule>(input, output);
   }
 
   /**
@@ -111,24 +107,7 @@ class ConvLayer
                 const arma::Cube<eT>& gy,
                 arma::Cube<eT>& g)
   {
-    g = arma::zeros<arma::Cube<eT> >(inputParameter.n_rows,
-                                     inputParameter.n_cols,
-                                     inputParameter.n_slices);
-
-    for (size_t outMap = 0, outMapIdx = 0; outMap < inMaps; outMap++)
-    {
-      for (size_t inMap = 0; inMap < outMaps; inMap++, outMapIdx++)
-      {
-        arma::Mat<eT> rotatedFilter;
-        Rotate180(weights.slice(outMap * outMaps + inMap), rotatedFilter);
-
-        arma::Mat<eT> output;
-        BackwardConvolutionRule::Convolution(gy.slice(inMap), rotatedFilter,
-            output);
-
-        g.slice(outMap) += output;
-      }
-    }
+    ConvBackward<BackwardConvolutionRule>(gy, g);
   }
 
   /*
@@ -143,23 +122,7 @@ class ConvLayer
                 const arma::Cube<eT>& d,
                 arma::Cube<eT>& g)
   {
-    g = arma::zeros<arma::Cube<eT> >(weights.n_rows, weights.n_cols,
-        weights.n_slices);
-
-    for (size_t outMap = 0; outMap < outMaps; outMap++)
-    {
-      for (size_t inMap = 0, s = outMap; inMap < inMaps; inMap++, s += outMaps)
-      {
-        arma::Cube<eT> inputSlices = input.slices(inMap, inMap);
-        arma::Cube<eT> deltaSlices = d.slices(outMap, outMap);
-
-        arma::Cube<eT> output;
-        GradientConvolutionRule::Convolution(inputSlices, deltaSlices, output);
-
-        for (size_t i = 0; i < output.n_slices; i++)
-          g.slice(s) += output.slice(i);
-      }
-    }
+    ConvGradient<GradientConvolutionRule>(input, d, g);
   }
 
   //! Get the weights.
@@ -205,6 +168,334 @@ class ConvLayer
   }
 
  private:
+  //! The type of the elements of the spectra of the FFTConvolution rules.
+  typedef std::complex<typename OutputDataType::elem_type> ComplexType;
+
+  /*
+   * Perform the forward pass with a rule which convolves one pair of maps at a
+   * time.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<!IsIm2ColConvolution<Rule>::value &&
+      !IsFFTConvolution<Rule>::value, void>::type
+  ConvForward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
+  {
+    const size_t wConv = ConvOutSize(input.n_rows, wfilter, xStride, wPad);
+    const size_t hConv = ConvOutSize(input.n_cols, hfilter, yStride, hPad);
+
+    output = arma::zeros<arma::Cube<eT> >(wConv, hConv, outMaps);
+    arma::Mat<eT> convOutput;
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      for (size_t inMap = 0, s = outMap; inMap < inMaps; inMap++, s += outMaps)
+      {
+        Rule::Convolution(input.slice(inMap), weights.slice(s), convOutput);
+
+        output.slice(outMap) += convOutput;
+      }
+    }
+  }
+
+  /*
+   * Perform the forward pass with an Im2ColConvolution rule, in one matrix
+   * multiplication.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<IsIm2ColConvolution<Rule>::value, void>::type
+  ConvForward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
+  {
+    // Column o holds the filters of output map o for each input map in turn.
+    const size_t filterSize = wfilter * hfilter;
+    filters.set_size(filterSize * inMaps, outMaps);
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      for (size_t inMap = 0, s = outMap; inMap < inMaps; inMap++, s += outMaps)
+      {
+        std::copy(weights.slice_memptr(s), weights.slice_memptr(s) +
+            filterSize, filters.colptr(outMap) + inMap * filterSize);
+      }
+    }
+
+    Rule::Convolution(input, filters, wfilter, hfilter, output);
+  }
+
+  /*
+   * Perform the backward pass with a rule which convolves one pair of maps at a
+   * time.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<!IsIm2ColConvolution<Rule>::value &&
+      !IsFFTConvolution<Rule>::value, void>::type
+  ConvBackward(const arma::Cube<eT>& gy, arma::Cube<eT>& g)
+  {
+    g = arma::zeros<arma::Cube<eT> >(inputParameter.n_rows,
+                                     inputParameter.n_cols,
+                                     inputParameter.n_slices);
+
+    arma::Mat<eT> rotatedFilter, output;
+    for (size_t outMap = 0, outMapIdx = 0; outMap < inMaps; outMap++)
+    {
+      for (size_t inMap = 0; inMap < outMaps; inMap++, outMapIdx++)
+      {
+        Rotate180(weights.slice(outMap * outMaps + inMap), rotatedFilter);
+
+        Rule::Convolution(gy.slice(inMap), rotatedFilter, output);
+
+        g.slice(outMap) += output;
+      }
+    }
+  }
+
+  /*
+   * Perform the backward pass with an Im2ColConvolution rule, in one matrix
+   * multiplication.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<IsIm2ColConvolution<Rule>::value, void>::type
+  ConvBackward(const arma::Cube<eT>& gy, arma::Cube<eT>& g)
+  {
+    // Column i holds the rotated filters of input map i for each output map in
+    // turn.  Rotating a matrix by 180 degrees reverses its elements.
+    const size_t filterSize = wfilter * hfilter;
+    filters.set_size(filterSize * outMaps, inMaps);
+    for (size_t inMap = 0, s = 0; inMap < inMaps; inMap++)
+    {
+      for (size_t outMap = 0; outMap < outMaps; outMap++, s++)
+      {
+        std::reverse_copy(weights.slice_memptr(s), weights.slice_memptr(s) +
+            filterSize, filters.colptr(inMap) + outMap * filterSize);
+      }
+    }
+
+    Rule::Convolution(gy, filters, wfilter, hfilter, g);
+  }
+
+  /*
+   * Calculate the gradient with a rule which convolves one pair of maps at a
+   * time.
+   */
+  template<typename Rule, typename InputType, typename eT>
+  typename std::enable_if<!IsIm2ColConvolution<Rule>::value &&
+      !IsFFTConvolution<Rule>::value, void>::type
+  ConvGradient(const InputType& input,
+               const arma::Cube<eT>& d,
+               arma::Cube<eT>& g)
+  {
+    g = arma::zeros<arma::Cube<eT> >(weights.n_rows, weights.n_cols,
+        weights.n_slices);
+
+    arma::Cube<eT> inputSlices, deltaSlices, output;
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      for (size_t inMap = 0, s = outMap; inMap < inMaps; inMap++, s += outMaps)
+      {
+        inputSlices = input.slices(inMap, inMap);
+        deltaSlices = d.slices(outMap, outMap);
+
+        Rule::Convolution(inputSlices, deltaSlices, output);
+
+        for (size_t i = 0; i < output.n_slices; i++)
+          g.slice(s) += output.slice(i);
+      }
+    }
+  }
+
+  /*
+   * Calculate the gradient with an Im2ColConvolution rule, in one matrix
+   * multiplication.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<IsIm2ColConvolution<Rule>::value, void>::type
+  ConvGradient(const arma::Cube<eT>& input,
+               const arma::Cube<eT>& d,
+               arma::Cube<eT>& g)
+  {
+    // Column o holds the gradient of the filters of output map o for each
+    // input map in turn, as in ConvForward().
+    Rule::FilterGradient(input, d, wfilter, hfilter, filterGradient);
+
+    const size_t filterSize = wfilter * hfilter;
+    g.set_size(weights.n_rows, weights.n_cols, weights.n_slices);
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      for (size_t inMap = 0, s = outMap; inMap < inMaps; inMap++, s += outMaps)
+      {
+        const eT* gradientPtr = filterGradient.colptr(outMap) +
+            inMap * filterSize;
+        std::copy(gradientPtr, gradientPtr + filterSize, g.slice_memptr(s));
+      }
+    }
+  }
+
+  /*
+   * Perform the forward pass with an FFTConvolution rule, reusing the spectra
+   * of the rotated filters.  The rule computes a true convolution, which
+   * flips the filter, so convolving with the rotated filters gives the same
+   * result as the other rules.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<IsFFTConvolution<Rule>::value, void>::type
+  ConvForward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
+  {
+    UpdateSpectra<Rule>(input.n_rows, input.n_cols, false, forwardSpectra,
+        forwardSpectraWeights);
+    SpectralConvolution<Rule>(input, forwardSpectra, outMaps, output);
+  }
+
+  /*
+   * Perform the backward pass with an FFTConvolution rule, reusing the spectra
+   * of the filters.  The other rules convolve with the rotated filters here,
+   * which the flip of the true convolution undoes.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<IsFFTConvolution<Rule>::value, void>::type
+  ConvBackward(const arma::Cube<eT>& gy, arma::Cube<eT>& g)
+  {
+    UpdateSpectra<Rule>(gy.n_rows, gy.n_cols, true, backwardSpectra,
+        backwardSpectraWeights);
+    SpectralConvolution<Rule>(gy, backwardSpectra, inMaps, g);
+  }
+
+  /*
+   * Calculate the gradient with an FFTConvolution rule, transforming each map
+   * of the input and of the delta only once.  The maps of the delta are
+   * rotated first, so that the true convolution gives the same result as the
+   * other rules.
+   */
+  template<typename Rule, typename eT>
+  typename std::enable_if<IsFFTConvolution<Rule>::value, void>::type
+  ConvGradient(const arma::Cube<eT>& input,
+               const arma::Cube<eT>& d,
+               arma::Cube<eT>& g)
+  {
+    size_t workingRows, workingCols;
+    Rule::WorkingSize(input.n_rows, input.n_cols, d.n_rows, d.n_cols,
+        workingRows, workingCols);
+
+    deltaSpectra.set_size(workingRows, workingCols, outMaps);
+    arma::Mat<eT> rotatedDelta;
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      Rotate180(d.slice(outMap), rotatedDelta);
+      Rule::FilterSpectrum(rotatedDelta, workingRows, workingCols, spectrum);
+      deltaSpectra.slice(outMap) = spectrum;
+    }
+
+    g.set_size(weights.n_rows, weights.n_cols, weights.n_slices);
+    arma::Mat<eT> convOutput;
+    for (size_t inMap = 0, s = 0; inMap < inMaps; inMap++)
+    {
+      Rule::InputSpectrum(input.slice(inMap), d.n_rows, d.n_cols,
+          inputSpectrum);
+
+      for (size_t outMap = 0; outMap < outMaps; outMap++, s++)
+      {
+        spectrum = inputSpectrum % deltaSpectra.slice(outMap);
+        Rule::SpectrumOutput(spectrum, input.n_rows, input.n_cols, d.n_rows,
+            d.n_cols, convOutput);
+        g.slice(s) = convOutput;
+      }
+    }
+  }
+
+  /*
+   * Recompute the given spectra of the rotated filters (for the forward pass)
+   * or of the filters (for the backward pass), if the weights or the size of
+   * the input have changed since they were computed.  Slice n * m + j of the
+   * spectra holds the filter from map n of the input to map j of the output of
+   * the convolution, which is m maps.
+   *
+   * @param inputRows Number of rows of the input of the convolution.
+   * @param inputCols Number of columns of the input of the convolution.
+   * @param backward Whether to compute the spectra for the backward pass.
+   * @param spectra The spectra of the filters.
+   * @param spectraWeights The weights the spectra were computed from.
+   */
+  template<typename Rule>
+  void UpdateSpectra(const size_t inputRows,
+                     const size_t inputCols,
+                     const bool backward,
+                     arma::Cube<ComplexType>& spectra,
+                     OutputDataType& spectraWeights)
+  {
+    size_t workingRows, workingCols;
+    Rule::WorkingSize(inputRows, inputCols, weights.n_rows, weights.n_cols,
+        workingRows, workingCols);
+
+    if (spectra.n_rows == workingRows && spectra.n_cols == workingCols &&
+        spectraWeights.n_elem == weights.n_elem && std::equal(
+        weights.memptr(), weights.memptr() + weights.n_elem,
+        spectraWeights.memptr()))
+    {
+      return;
+    }
+
+    spectra.set_size(workingRows, workingCols, weights.n_slices);
+    arma::Mat<typename OutputDataType::elem_type> rotatedFilter;
+    for (size_t inMap = 0, s = 0; inMap < inMaps; inMap++)
+    {
+      for (size_t outMap = 0; outMap < outMaps; outMap++, s++)
+      {
+        if (backward)
+        {
+          Rule::FilterSpectrum(weights.slice(s), workingRows, workingCols,
+              spectrum);
+          spectra.slice(outMap * inMaps + inMap) = spectrum;
+        }
+        else
+        {
+          Rotate180(weights.slice(s), rotatedFilter);
+          Rule::FilterSpectrum(rotatedFilter, workingRows, workingCols,
+              spectrum);
+          spectra.slice(s) = spectrum;
+        }
+      }
+    }
+
+    spectraWeights = weights;
+  }
+
+  /*
+   * Convolve the maps of the input with the filters whose spectra are given,
+   * and sum the convolutions which go to each map of the output in the
+   * frequency domain, so that each map of the input is transformed once and
+   * each map of the output is transformed back once.
+   *
+   * @param input Input of the convolution, with n maps.
+   * @param spectra Spectra of the filters (see UpdateSpectra()).
+   * @param outputMaps Number of maps m of the output.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename Rule, typename eT>
+  void SpectralConvolution(const arma::Cube<eT>& input,
+                           const arma::Cube<ComplexType>& spectra,
+                           const size_t outputMaps,
+                           arma::Cube<eT>& output)
+  {
+    spectrumSum.zeros(spectra.n_rows, spectra.n_cols, outputMaps);
+    for (size_t inMap = 0, s = 0; inMap < input.n_slices; inMap++)
+    {
+      Rule::InputSpectrum(input.slice(inMap), weights.n_rows, weights.n_cols,
+          inputSpectrum);
+
+      for (size_t outMap = 0; outMap < outputMaps; outMap++, s++)
+        spectrumSum.slice(outMap) += inputSpectrum % spectra.slice(s);
+    }
+
+    arma::Mat<eT> convOutput;
+    for (size_t outMap = 0; outMap < outputMaps; outMap++)
+    {
+      Rule::SpectrumOutput(spectrumSum.slice(outMap), input.n_rows,
+          input.n_cols, weights.n_rows, weights.n_cols, convOutput);
+
+      if (outMap == 0)
+      {
+        output.set_size(convOutput.n_rows, convOutput.n_cols, outputMaps);
+      }
+      output.slice(outMap) = convOutput;
+    }
+  }
+
   /*
    * Rotates a 3rd-order tesor counterclockwise by 180 degrees.
    *
@@ -289,6 +580,38 @@ class ConvLayer
 
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
+
+  //! Locally-stored filters, lowered for the Im2ColConvolution rules.
+  arma::Mat<typename OutputDataType::elem_type> filters;
+
+  //! Locally-stored gradient of the lowered filters.
+  arma::Mat<typename OutputDataType::elem_type> filterGradient;
+
+  //! Locally-stored spectra of the rotated filters, for the forward pass with
+  //! the FFTConvolution rules.
+  arma::Cube<ComplexType> forwardSpectra;
+
+  //! Locally-stored weights which forwardSpectra was computed from.
+  OutputDataType forwardSpectraWeights;
+
+  //! Locally-stored spectra of the filters, for the backward pass with the
+  //! FFTConvolution rules.
+  arma::Cube<ComplexType> backwardSpectra;
+
+  //! Locally-stored weights which backwardSpectra was computed from.
+  OutputDataType backwardSpectraWeights;
+
+  //! Locally-stored spectra of the maps of the delta.
+  arma::Cube<ComplexType> deltaSpectra;
+
+  //! Locally-stored sums of the spectra of the convolutions.
+  arma::Cube<ComplexType> spectrumSum;
+
+  //! Locally-stored spectrum of a map of the input.
+  arma::Mat<ComplexType> inputSpectrum;
+
+  //! Locally-stored spectrum.
+  arma::Mat<ComplexType> spectrum;
 }; // class ConvLayer
 
 //! Layer traits for the convolution layer.
@@ -122,33 +122,32 @@ class DropConnectLayer
       if(uselayer)
       {
         // Scale with input / (1 - ratio) and set values to zero with
-        // probability ratio.
-        mask = arma::randu<arma::Mat<eT> >(baseLayer.Weights().n_rows,
-            baseLayer.Weights().n_cols);
-        mask.transform([&](double val) { return (val > ratio); });
+        // probability ratio; the mask holds 0 or the scale, so the weights
+        // are scaled along with the masking.
+        mask.set_size(baseLayer.Weights().n_rows, baseLayer.Weights().n_cols);
+        math::RandomMask(mask.memptr(), mask.n_elem, ratio, scale);
 
         // Save weights for denoising.
         denoise = baseLayer.Weights();
 
-        baseLayer.Weights() = baseLayer.Weights() % mask;
+        baseLayer.Weights() %= mask;
 
         baseLayer.Forward(input, output);
       }
       else
       {
         // Scale the input / ( 1 - ratio) and set values to zero with
-        // probability ratio.
-        mask = arma::randu<arma::Mat<eT> >(weights.n_rows, weights.n_cols);
-        mask.transform([&](double val) { return (val > ratio); });
+        // probability ratio; the mask holds 0 or the scale, so the weights
+        // are scaled along with the masking.
+        mask.set_size(weights.n_rows, weights.n_cols);
+        math::RandomMask(mask.memptr(), mask.n_elem, ratio, scale);
 
         // Save weights for denoising.
         denoise = weights;
 
-        weights = weights % mask;
+        weights %= mask;
         output = weights * input;
       }
-
-      output = output * scale;
     }
   }
 
@@ -340,7 +339,8 @@ private:
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
-  //! Locally-stored mast object.
+  //! Locally-stored mask object (0 or the scale for each weight), which is
+  //! reused by each pass.
   OutputDataType mask;
 
   //! If true dropout and scaling is disabled, see notes above.
@@ -91,10 +91,11 @@ class DropoutLayer
     else
     {
       // Scale with input / (1 - ratio) and set values to zero with probability
-      // ratio.
-      mask = arma::randu<arma::Mat<eT> >(input.n_rows, input.n_cols);
-      mask.transform( [&](double val) { return (val > ratio); } );
-      output = input % mask * scale;
+      // ratio; the mask holds 0 or the scale, so only one multiplication is
+      // needed.
+      mask.set_size(input.n_rows, input.n_cols);
+      math::RandomMask(mask.memptr(), mask.n_elem, ratio, scale);
+      output = input % mask;
     }
   }
 
@@ -123,11 +124,11 @@ class DropoutLayer
     else
     {
       // Scale with input / (1 - ratio) and set values to zero with probability
-      // ratio.
-      mask = arma::randu<arma::Cube<eT> >(input.n_rows, input.n_cols,
-          input.n_slices);
-      mask.transform( [&](double val) { return (val > ratio); } );
-      output = input % mask * scale;
+      // ratio; the mask holds 0 or the scale, so only one multiplication is
+      // needed.
+      mask.set_size(input.n_rows, input.n_cols, input.n_slices);
+      math::RandomMask(mask.memptr(), mask.n_elem, ratio, scale);
+      output = input % mask;
     }
   }
 
@@ -143,7 +144,8 @@ class DropoutLayer
                 const DataType& gy,
                 DataType& g)
   {
-    g = gy % mask * scale;
+    // The mask already holds the scale.
+    g = gy % mask;
   }
 
   //! Get the input parameter.
@@ -201,7 +203,8 @@ class DropoutLayer
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
-  //! Locally-stored mast object.
+  //! Locally-stored mask object (0 or the scale for each element), which is
+  //! reused by each pass.
   OutputDataType mask;
 
   //! The probability of setting a value to zero.
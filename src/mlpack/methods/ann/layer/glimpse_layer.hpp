@@ -22,7 +22,6 @@
 #define MLPACK_METHODS_ANN_LAYER_GLIMPSE_LAYER_HPP
 
 #include <mlpack/core.hpp>
-#include <mlpack/methods/ann/pooling_rules/mean_pooling.hpp>
 #include <algorithm>
 
 namespace mlpack {
@@ -63,9 +62,19 @@ class GlimpseLayer
       inSize(inSize),
       size(size),
       depth(depth),
-      scale(scale)
+      scale(scale),
+      scaling(depth)
   {
-    // Nothing to do here.
+    // The patch of each depth is scaled down to the glimpse size by
+    // multiplying it by the same matrix on both sides.
+    for (size_t depthIdx = 1, glimpseSize = size * scale;
+        depthIdx < depth; depthIdx++, glimpseSize *= scale)
+    {
+      if (scale == 2)
+        PoolingMatrix(glimpseSize, scaling[depthIdx]);
+      else
+        ReSamplingMatrix(glimpseSize, scaling[depthIdx]);
+    }
   }
 
   /**
@@ -77,7 +86,7 @@ class GlimpseLayer
   template<typename eT>
   void Forward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
   {
-    output = arma::Cube<eT>(size, size, depth * input.n_slices);
+    output.set_size(size, size, depth * input.n_slices);
 
     inputDepth = input.n_slices / inSize;
 
@@ -86,53 +95,29 @@ class GlimpseLayer
       for (size_t depthIdx = 0, glimpseSize = size;
           depthIdx < depth; depthIdx++, glimpseSize *= scale)
       {
-        size_t padSize = std::floor((glimpseSize - 1) / 2);
-
-        arma::Cube<eT> inputPadded = arma::zeros<arma::Cube<eT> >(
-            input.n_rows + padSize * 2, input.n_cols + padSize * 2,
-            input.n_slices / inSize);
-
-        inputPadded.tube(padSize, padSize, padSize + input.n_rows - 1,
-            padSize + input.n_cols - 1) = input.subcube(0, 0,
-            inputIdx * inputDepth, input.n_rows - 1, input.n_cols - 1,
-            (inputIdx + 1) * inputDepth - 1);
-
-        size_t h = inputPadded.n_rows - glimpseSize;
-        size_t w = inputPadded.n_cols - glimpseSize;
-
-        size_t x = std::min(h, (size_t) std::max(0.0,
-            (location(0, inputIdx) + 1) / 2.0 * h));
-        size_t y = std::min(w, (size_t) std::max(0.0,
-            (location(1, inputIdx) + 1) / 2.0 * w));
-
-        if (depthIdx == 0)
+        ptrdiff_t x, y;
+        Offset(input.n_rows, input.n_cols, inputIdx, glimpseSize, x, y);
+        arma::span rows, cols, patchRows, patchCols;
+        const bool overlap = Overlap(input.n_rows, input.n_cols, x, y,
+            glimpseSize, rows, cols, patchRows, patchCols);
+
+        // The patch and the scaling matrix are reused for each slice.
+        arma::Mat<eT> patch(glimpseSize, glimpseSize);
+        const arma::Mat<eT> a = arma::conv_to<arma::Mat<eT> >::from(
+            scaling[depthIdx]);
+        for (size_t j = FirstSlice(inputIdx, depthIdx),
+            inputSlice = inputIdx * inputDepth; j < output.n_slices;
+            j += (inSize * depth), inputSlice++)
         {
-          for (size_t j = (inputIdx + depthIdx), paddedSlice = 0;
-              j < output.n_slices; j += (inSize * depth), paddedSlice++)
-          {
-            output.slice(j) = inputPadded.subcube(x, y,
-                paddedSlice, x + glimpseSize - 1, y + glimpseSize - 1,
-                paddedSlice);
-          }
-        }
-        else
-        {
-          for (size_t j = (inputIdx + depthIdx * (depth - 1)), paddedSlice = 0;
-              j < output.n_slices; j += (inSize * depth), paddedSlice++)
-          {
-            arma::Mat<eT> poolingInput = inputPadded.subcube(x, y,
-                paddedSlice, x + glimpseSize - 1, y + glimpseSize - 1,
-                paddedSlice);
-
-            if (scale == 2)
-            {
-              Pooling(glimpseSize / size, poolingInput, output.slice(j));
-            }
-            else
-            {
-              ReSampling(poolingInput, output.slice(j));
-            }
-          }
+          // Crop the patch; the parts outside of the image are zero.
+          patch.zeros(glimpseSize, glimpseSize);
+          if (overlap)
+            patch(patchRows, patchCols) = input.slice(inputSlice)(rows, cols);
+
+          if (depthIdx == 0)
+            output.slice(j) = patch;
+          else
+            output.slice(j) = a * patch * a.t();
         }
       }
     }
@@ -150,24 +135,7 @@ class GlimpseLayer
                 const ErrorType& gy,
                 arma::Cube<eT>& g)
   {
-    // Generate a cube using the backpropagated error matrix.
-    arma::Cube<eT> mappedError = arma::zeros<arma::cube>(input.n_rows,
-        input.n_cols, input.n_slices);
-
-    for (size_t s = 0, j = 0; s < mappedError.n_slices; s+= gy.n_cols, j++)
-    {
-      for (size_t i = 0; i < gy.n_cols; i++)
-      {
-        arma::Col<eT> temp = gy.col(i).subvec(
-            j * input.n_rows * input.n_cols,
-            (j + 1) * input.n_rows * input.n_cols - 1);
-
-        mappedError.slice(s + i) = arma::Mat<eT>(temp.memptr(),
-            input.n_rows, input.n_cols);
-      }
-    }
-
-    g = arma::zeros<arma::cube>(inputParameter.n_rows, inputParameter.n_cols,
+    g.zeros(inputParameter.n_rows, inputParameter.n_cols,
         inputParameter.n_slices);
 
     for (size_t inputIdx = 0; inputIdx < inSize; inputIdx++)
@@ -175,58 +143,35 @@ class GlimpseLayer
       for (size_t depthIdx = 0, glimpseSize = size;
           depthIdx < depth; depthIdx++, glimpseSize *= scale)
       {
-        size_t padSize = std::floor((glimpseSize - 1) / 2);
-
-        arma::Cube<eT> inputPadded = arma::zeros<arma::Cube<eT> >(
-            inputParameter.n_rows + padSize * 2, inputParameter.n_cols +
-            padSize * 2, inputParameter.n_slices / inSize);
-
-        size_t h = inputPadded.n_rows - glimpseSize;
-        size_t w = inputPadded.n_cols - glimpseSize;
-
-        size_t x = std::min(h, (size_t) std::max(0.0,
-            (location(0, inputIdx) + 1) / 2.0 * h));
-        size_t y = std::min(w, (size_t) std::max(0.0,
-            (location(1, inputIdx) + 1) / 2.0 * w));
-
-        if (depthIdx == 0)
-        {
-          for (size_t j = (inputIdx + depthIdx), paddedSlice = 0;
-              j < mappedError.n_slices; j += (inSize * depth), paddedSlice++)
-          {
-            inputPadded.subcube(x, y,
-            paddedSlice, x + glimpseSize - 1, y + glimpseSize - 1,
-            paddedSlice) = mappedError.slice(j);
-          }
-        }
-        else
+        ptrdiff_t x, y;
+        Offset(inputParameter.n_rows, inputParameter.n_cols, inputIdx,
+            glimpseSize, x, y);
+        arma::span rows, cols, patchRows, patchCols;
+        if (!Overlap(inputParameter.n_rows, inputParameter.n_cols, x, y,
+            glimpseSize, rows, cols, patchRows, patchCols))
+          continue;
+
+        // The patch and the scaling matrix are reused for each slice.
+        arma::Mat<eT> patch;
+        const arma::Mat<eT> a = arma::conv_to<arma::Mat<eT> >::from(
+            scaling[depthIdx]);
+        for (size_t j = FirstSlice(inputIdx, depthIdx),
+            inputSlice = inputIdx * inputDepth; j < input.n_slices;
+            j += (inSize * depth), inputSlice++)
         {
-          for (size_t j = (inputIdx + depthIdx * (depth - 1)), paddedSlice = 0;
-              j < mappedError.n_slices; j += (inSize * depth), paddedSlice++)
-          {
-            arma::Mat<eT> poolingOutput = inputPadded.subcube(x, y,
-                 paddedSlice, x + glimpseSize - 1, y + glimpseSize - 1,
-                 paddedSlice);
-
-            if (scale == 2)
-            {
-              Unpooling(inputParameter.slice(paddedSlice), mappedError.slice(j),
-                  poolingOutput);
-            }
-            else
-            {
-              DownwardReSampling(inputParameter.slice(paddedSlice),
-                  mappedError.slice(j), poolingOutput);
-            }
-
-            inputPadded.subcube(x, y,
-                paddedSlice, x + glimpseSize - 1, y + glimpseSize - 1,
-                paddedSlice) = poolingOutput;
-          }
+          // Each column of the backpropagated error holds a glimpse slice of
+          // each block of slices.
+          const arma::Mat<eT> error(const_cast<eT*>(gy.colptr(j % gy.n_cols)) +
+              (j / gy.n_cols) * input.n_rows * input.n_cols, input.n_rows,
+              input.n_cols, false, true);
+
+          if (depthIdx == 0)
+            patch = error;
+          else
+            patch = a.t() * error * a;
+
+          g.slice(inputSlice)(rows, cols) += patch(patchRows, patchCols);
         }
-
-        g += inputPadded.tube(padSize, padSize, padSize +
-            inputParameter.n_rows - 1, padSize + inputParameter.n_cols - 1);
       }
     }
 
@@ -261,9 +206,10 @@ class GlimpseLayer
    *
    * @param w The input matrix used to perform the transformation.
    */
-  void Transform(arma::mat& w)
+  template<typename eT>
+  void Transform(arma::Mat<eT>& w)
   {
-    arma::mat t = w;
+    arma::Mat<eT> t = w;
 
     for (size_t i = 0, k = 0; i < w.n_elem; k++)
     {
@@ -279,166 +225,132 @@ class GlimpseLayer
    *
    * @param w The input matrix used to perform the transformation.
    */
-  void Transform(arma::cube& w)
+  template<typename eT>
+  void Transform(arma::Cube<eT>& w)
   {
     for (size_t i = 0; i < w.n_slices; i++)
     {
-      arma::mat t = w.slice(i);
+      arma::Mat<eT> t = w.slice(i);
       Transform(t);
       w.slice(i) = t;
     }
   }
 
   /**
-   * Apply pooling to the input and store the results to the output parameter.
-   *
-   * @param kSize the kernel size used to perform the pooling operation.
-   * @param input The input to be apply the pooling rule.
-   * @param output The pooled result.
+   * Get the first output slice of the given input and depth.
    */
-  template<typename eT>
-  void Pooling(const size_t kSize,
-               const arma::Mat<eT>& input,
-               arma::Mat<eT>& output)
+  size_t FirstSlice(const size_t inputIdx, const size_t depthIdx) const
   {
-
-    const size_t rStep = kSize;
-    const size_t cStep = kSize;
-
-    for (size_t j = 0; j < input.n_cols; j += cStep)
-    {
-      for (size_t i = 0; i < input.n_rows; i += rStep)
-      {
-        output(i / rStep, j / cStep) += pooling.Pooling(
-            input(arma::span(i, i + rStep - 1), arma::span(j, j + cStep - 1)));
-      }
-    }
+    return (depthIdx == 0) ? inputIdx : inputIdx + depthIdx * (depth - 1);
   }
 
   /**
-   * Apply unpooling to the input and store the results.
+   * Compute the position of the top left corner of the patch of the given size
+   * in the image (which is negative if the patch starts in the zero padding
+   * around the image).
    *
-   * @param input The input to be apply the unpooling rule.
-   * @param error The error used to perform the unpooling operation.
-   * @param output The pooled result.
+   * @param rows Number of rows of the image.
+   * @param cols Number of columns of the image.
+   * @param inputIdx Index of the input, whose location is used.
+   * @param glimpseSize Size of the patch.
+   * @param x Row of the top left corner of the patch.
+   * @param y Column of the top left corner of the patch.
    */
-  template<typename eT>
-  void Unpooling(const arma::Mat<eT>& input,
-                 const arma::Mat<eT>& error,
-                 arma::Mat<eT>& output)
+  void Offset(const size_t rows,
+              const size_t cols,
+              const size_t inputIdx,
+              const size_t glimpseSize,
+              ptrdiff_t& x,
+              ptrdiff_t& y) const
   {
-    const size_t rStep = input.n_rows / error.n_rows;
-    const size_t cStep = input.n_cols / error.n_cols;
-
-    arma::Mat<eT> unpooledError;
-    for (size_t j = 0; j < input.n_cols; j += cStep)
-    {
-      for (size_t i = 0; i < input.n_rows; i += rStep)
-      {
-        const arma::Mat<eT>& inputArea = input(arma::span(i, i + rStep - 1),
-                                               arma::span(j, j + cStep - 1));
+    const size_t padSize = (glimpseSize - 1) / 2;
 
-        pooling.Unpooling(inputArea, error(i / rStep, j / cStep),
-            unpooledError);
+    const size_t h = rows + padSize * 2 - glimpseSize;
+    const size_t w = cols + padSize * 2 - glimpseSize;
 
-        output(arma::span(i, i + rStep - 1),
-            arma::span(j, j + cStep - 1)) += unpooledError;
-      }
-    }
+    x = (ptrdiff_t) std::min(h, (size_t) std::max(0.0,
+        (location(0, inputIdx) + 1) / 2.0 * h)) - (ptrdiff_t) padSize;
+    y = (ptrdiff_t) std::min(w, (size_t) std::max(0.0,
+        (location(1, inputIdx) + 1) / 2.0 * w)) - (ptrdiff_t) padSize;
   }
 
   /**
-   * Apply ReSampling to the input and store the results in the output
-   * parameter.
+   * Compute the part of the image that the patch at the given position covers,
+   * and the corresponding part of the patch.  Returns false if the patch lies
+   * entirely in the zero padding.
    *
-   * @param input The input to be apply the ReSampling rule.
-   * @param output The pooled result.
+   * @param rows Number of rows of the image.
+   * @param cols Number of columns of the image.
+   * @param x Row of the top left corner of the patch.
+   * @param y Column of the top left corner of the patch.
+   * @param glimpseSize Size of the patch.
+   * @param imageRows Rows of the image covered by the patch.
+   * @param imageCols Columns of the image covered by the patch.
+   * @param patchRows Rows of the patch that cover the image.
+   * @param patchCols Columns of the patch that cover the image.
    */
-  template<typename eT>
-  void ReSampling(const arma::Mat<eT>& input, arma::Mat<eT>& output)
+  static bool Overlap(const size_t rows,
+                      const size_t cols,
+                      const ptrdiff_t x,
+                      const ptrdiff_t y,
+                      const size_t glimpseSize,
+                      arma::span& imageRows,
+                      arma::span& imageCols,
+                      arma::span& patchRows,
+                      arma::span& patchCols)
   {
-    double wRatio = (double) (input.n_rows - 1) / (size - 1);
-    double hRatio = (double) (input.n_cols - 1) / (size - 1);
+    const ptrdiff_t rowBegin = std::max(x, (ptrdiff_t) 0);
+    const ptrdiff_t rowEnd = std::min(x + (ptrdiff_t) glimpseSize,
+        (ptrdiff_t) rows);
+    const ptrdiff_t colBegin = std::max(y, (ptrdiff_t) 0);
+    const ptrdiff_t colEnd = std::min(y + (ptrdiff_t) glimpseSize,
+        (ptrdiff_t) cols);
+    if (rowBegin >= rowEnd || colBegin >= colEnd)
+      return false;
+
+    imageRows = arma::span(rowBegin, rowEnd - 1);
+    imageCols = arma::span(colBegin, colEnd - 1);
+    patchRows = arma::span(rowBegin - x, rowEnd - x - 1);
+    patchCols = arma::span(colBegin - y, colEnd - y - 1);
+    return true;
+  }
 
-    double iWidth = input.n_rows - 1;
-    double iHeight = input.n_cols - 1;
+  /**
+   * Build the matrix A such that A * P * A^T is the mean pooling of the patch
+   * P of the given size down to the glimpse size.
+   *
+   * @param glimpseSize Size of the patch.
+   * @param a The pooling matrix.
+   */
+  void PoolingMatrix(const size_t glimpseSize, arma::mat& a) const
+  {
+    const size_t kSize = glimpseSize / size;
 
-    for (size_t y = 0; y < size; y++)
-    {
-      for (size_t x = 0; x < size; x++)
-      {
-        double ix = wRatio * x;
-        double iy = hRatio * y;
-
-        // Get the 4 nearest neighbors.
-        double ixNw = std::floor(ix);
-        double iyNw = std::floor(iy);
-        double ixNe = ixNw + 1;
-        double iySw = iyNw + 1;
-
-        // Get surfaces to each neighbor.
-        double se = (ix - ixNw) * (iy - iyNw);
-        double sw = (ixNe - ix) * (iy - iyNw);
-        double ne = (ix - ixNw) * (iySw - iy);
-        double nw = (ixNe - ix) * (iySw - iy);
-
-        // Calculate the weighted sum.
-        output(y, x) = input(iyNw, ixNw) * nw +
-            input(iyNw, std::min(ixNe,  iWidth)) * ne +
-            input(std::min(iySw, iHeight), ixNw) * sw +
-            input(std::min(iySw, iHeight), std::min(ixNe, iWidth)) * se;
-      }
-    }
+    a.zeros(size, glimpseSize);
+    for (size_t i = 0; i < size; i++)
+      a.row(i).cols(i * kSize, (i + 1) * kSize - 1).fill(1.0 / kSize);
   }
 
   /**
-   * Apply DownwardReSampling to the input and store the results into the output
-   * parameter.
+   * Build the matrix A such that A * P * A^T is the bilinear resampling of the
+   * patch P of the given size down to the glimpse size.
    *
-   * @param input The input to be apply the DownwardReSampling rule.
-   * @param error The error used to perform the DownwardReSampling operation.
-   * @param output The DownwardReSampled result.
+   * @param glimpseSize Size of the patch.
+   * @param a The resampling matrix.
    */
-  template<typename eT>
-  void DownwardReSampling(const arma::Mat<eT>& input,
-                          const arma::Mat<eT>& error,
-                          arma::Mat<eT>& output)
+  void ReSamplingMatrix(const size_t glimpseSize, arma::mat& a) const
   {
-    double iWidth = input.n_rows - 1;
-    double iHeight = input.n_cols - 1;
+    const double ratio = (double) (glimpseSize - 1) / (size - 1);
+    const size_t last = glimpseSize - 1;
 
-    double wRatio = iWidth / (size - 1);
-    double hRatio = iHeight / (size - 1);
-
-    for (size_t y = 0; y < size; y++)
+    a.zeros(size, glimpseSize);
+    for (size_t i = 0; i < size; i++)
     {
-      for (size_t x = 0; x < size; x++)
-      {
-        double ix = wRatio * x;
-        double iy = hRatio * y;
-
-        // Get the 4 nearest neighbors.
-        double ixNw = std::floor(ix);
-        double iyNw = std::floor(iy);
-        double ixNe = ixNw + 1;
-        double iySw = iyNw + 1;
-
-        // Get surfaces to each neighbor.
-        double se = (ix - ixNw) * (iy - iyNw);
-        double sw = (ixNe - ix) * (iy - iyNw);
-        double ne = (ix - ixNw) * (iySw - iy);
-        double nw = (ixNe - ix) * (iySw - iy);
-
-        double ograd = error(y, x);
-
-        output(iyNw, ixNw) = output(iyNw, ixNw) + nw * ograd;
-        output(iyNw, std::min(ixNe, iWidth)) = output(iyNw,
-            std::min(ixNe, iWidth)) + ne * ograd;
-        output(std::min(iySw, iHeight), ixNw) = output(std::min(iySw, iHeight),
-            ixNw) + sw * ograd;
-        output(std::min(iySw, iHeight), std::min(ixNe, iWidth)) = output(
-            std::min(iySw, iHeight), std::min(ixNe, iWidth)) + se * ograd;
-      }
+      // Weight the two nearest neighbors.
+      const double position = ratio * i;
+      const size_t nearest = (size_t) std::floor(position);
+      a(i, nearest) += (nearest + 1) - position;
+      a(i, std::min(nearest + 1, last)) += position - nearest;
     }
   }
 
@@ -469,8 +381,9 @@ class GlimpseLayer
   //! The x and y coordinate of the center of the output glimpse.
   arma::mat location;
 
-  //! Locally-stored object to perform the mean pooling operation.
-  MeanPooling pooling;
+  //! The matrix that scales the patch of each depth down to the glimpse size
+  //! (empty for the first depth, which isn't scaled).
+  std::vector<arma::mat> scaling;
 }; // class GlimpseLayer
 
 }; // namespace ann
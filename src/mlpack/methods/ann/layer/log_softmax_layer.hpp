@@ -74,7 +74,9 @@ class LogSoftmaxLayer
       return 0.0;
     } );
 
-    output = input - (maxInput + std::log(arma::accu(output)));
+    // Each column of the input is a separate sample.
+    output = input - (maxInput + arma::repmat(arma::log(arma::sum(output)),
+        input.n_rows, 1));
   }
 
   /**
@@ -91,7 +93,7 @@ class LogSoftmaxLayer
                 const arma::Mat<eT>& gy,
                 arma::Mat<eT>& g)
   {
-    g = gy - arma::exp(input) * arma::accu(gy);
+    g = gy - arma::exp(input) % arma::repmat(arma::sum(gy), input.n_rows, 1);
   }
 
   //! Get the input parameter.
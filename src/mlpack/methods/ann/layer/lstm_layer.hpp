@@ -75,6 +75,7 @@ class LSTMLayer
   template<typename eT>
   void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
   {
+    // The buffers of the whole sequence are allocated once.
     if (inGate.n_cols < seqLen)
     {
       inGate = arma::zeros<InputDataType>(outSize, seqLen);
@@ -91,44 +92,48 @@ class LSTMLayer
       cellAct = arma::zeros<InputDataType>(outSize, seqLen);
     }
 
-    // Split up the inputactivation into the 3 parts (inGate, forgetGate,
-    // outGate).
-    inGate.col(offset) = input.submat(0, 0, outSize - 1, 0);
+    // The input activation holds the stacked pre-activations of the 4 parts
+    // (inGate, forgetGate, cell, outGate), which are computed by a single
+    // matrix multiplication in the layer before.  The gates and the cell
+    // update of each unit only depend on that unit, so they are computed in
+    // one pass over the units, without temporaries.
+    const eT* inputPtr = input.memptr();
+    const eT* prevState = (offset > 0) ? state.colptr(offset - 1) : NULL;
+    output.set_size(outSize, 1);
 
-    forgetGate.col(offset) = input.submat(outSize, 0, (outSize * 2) - 1, 0);
-    outGate.col(offset) = input.submat(outSize * 3, 0, (outSize * 4) - 1, 0);
-
-    if (peepholes && offset > 0)
+    for (size_t i = 0; i < outSize; ++i)
     {
-      inGate.col(offset) += peepholeWeights.col(0) % state.col(offset - 1);
-      forgetGate.col(offset) += peepholeWeights.col(1) %
-          state.col(offset - 1);
-    }
-
-    arma::Col<eT> inGateActivation = inGateAct.unsafe_col(offset);
-    GateActivationFunction::fn(inGate.unsafe_col(offset), inGateActivation);
-
-    arma::Col<eT> forgetGateActivation = forgetGateAct.unsafe_col(offset);
-    GateActivationFunction::fn(forgetGate.unsafe_col(offset),
-        forgetGateActivation);
+      eT inGateValue = inputPtr[i];
+      eT forgetGateValue = inputPtr[outSize + i];
+      eT outGateValue = inputPtr[outSize * 3 + i];
 
-    arma::Col<eT> cellActivation = cellAct.unsafe_col(offset);
-    StateActivationFunction::fn(input.submat(outSize * 2, 0,
-        (outSize * 3) - 1, 0), cellActivation);
+      if (peepholes && offset > 0)
+      {
+        inGateValue += peepholeWeights(i, 0) * prevState[i];
+        forgetGateValue += peepholeWeights(i, 1) * prevState[i];
+      }
 
-    state.col(offset) = inGateAct.col(offset) % cellActivation;
+      inGate(i, offset) = inGateValue;
+      forgetGate(i, offset) = forgetGateValue;
+      inGateAct(i, offset) = GateActivationFunction::fn(inGateValue);
+      forgetGateAct(i, offset) = GateActivationFunction::fn(forgetGateValue);
+      cellAct(i, offset) = StateActivationFunction::fn(
+          inputPtr[outSize * 2 + i]);
 
-    if (offset > 0)
-      state.col(offset) += forgetGateAct.col(offset) % state.col(offset - 1);
+      eT stateValue = inGateAct(i, offset) * cellAct(i, offset);
+      if (offset > 0)
+        stateValue += forgetGateAct(i, offset) * prevState[i];
+      state(i, offset) = stateValue;
 
-    if (peepholes)
-      outGate.col(offset) += peepholeWeights.col(2) % state.col(offset);
+      if (peepholes)
+        outGateValue += peepholeWeights(i, 2) * stateValue;
 
-    arma::Col<eT> outGateActivation = outGateAct.unsafe_col(offset);
-    GateActivationFunction::fn(outGate.unsafe_col(offset), outGateActivation);
+      outGate(i, offset) = outGateValue;
+      outGateAct(i, offset) = GateActivationFunction::fn(outGateValue);
 
-    OutputActivationFunction::fn(state.unsafe_col(offset), output);
-    output = outGateAct.col(offset) % output;
+      output[i] = outGateAct(i, offset) *
+          OutputActivationFunction::fn(stateValue);
+    }
 
     offset = (offset + 1) % seqLen;
   }
@@ -149,84 +154,77 @@ class LSTMLayer
   {
     queryOffset = seqLen - offset - 1;
 
-    arma::Col<eT> outGateDerivative;
-    GateActivationFunction::deriv(outGateAct.unsafe_col(queryOffset),
-        outGateDerivative);
-
-    arma::Col<eT> stateActivation;
-    StateActivationFunction::fn(state.unsafe_col(queryOffset), stateActivation);
+    // As in the forward pass, the errors of each unit only depend on that
+    // unit, so they are computed in one pass over the units and stored
+    // straight into the stacked error of the 4 parts.
+    const bool hasNext = (queryOffset < (seqLen - 1));
+    const bool hasPrev = (queryOffset > 0);
+    g.set_size(outSize * 4, 1);
 
-    outGateError.col(queryOffset) = outGateDerivative % gy % stateActivation;
-
-    arma::Col<eT> stateDerivative;
-    StateActivationFunction::deriv(stateActivation, stateDerivative);
+    for (size_t i = 0; i < outSize; ++i)
+    {
+      const eT stateActivation = StateActivationFunction::fn(
+          state(i, queryOffset));
 
-    stateError.col(queryOffset) = gy % outGateAct.col(queryOffset) %
-        stateDerivative;
+      outGateError(i, queryOffset) = GateActivationFunction::deriv(
+          outGateAct(i, queryOffset)) * gy[i] * stateActivation;
 
-    if (queryOffset < (seqLen - 1))
-    {
-      stateError.col(queryOffset) += stateError.col(queryOffset + 1) %
-          forgetGateAct.col(queryOffset + 1);
+      eT stateErrorValue = gy[i] * outGateAct(i, queryOffset) *
+          StateActivationFunction::deriv(stateActivation);
 
-      if (peepholes)
+      if (hasNext)
       {
-        stateError.col(queryOffset) += inGateError.col(queryOffset + 1) %
-            peepholeWeights.col(0);
-        stateError.col(queryOffset) += forgetGateError.col(queryOffset + 1) %
-            peepholeWeights.col(1);
+        stateErrorValue += stateError(i, queryOffset + 1) *
+            forgetGateAct(i, queryOffset + 1);
+
+        if (peepholes)
+        {
+          stateErrorValue += inGateError(i, queryOffset + 1) *
+              peepholeWeights(i, 0);
+          stateErrorValue += forgetGateError(i, queryOffset + 1) *
+              peepholeWeights(i, 1);
+        }
       }
-    }
 
-    if (peepholes)
-    {
-      stateError.col(queryOffset) += outGateError.col(queryOffset) %
-          peepholeWeights.col(2);
-    }
-
-    arma::Col<eT> cellDerivative;
-    StateActivationFunction::deriv(cellAct.col(queryOffset), cellDerivative);
-
-    arma::Col<eT> cellError = inGateAct.col(queryOffset) % cellDerivative %
-        stateError.col(queryOffset);
-
-    if (queryOffset > 0)
-    {
-      arma::Col<eT> forgetGateDerivative;
-      GateActivationFunction::deriv(forgetGateAct.col(queryOffset),
-          forgetGateDerivative);
+      if (peepholes)
+        stateErrorValue += outGateError(i, queryOffset) * peepholeWeights(i, 2);
 
-      forgetGateError.col(queryOffset) = forgetGateDerivative %
-          stateError.col(queryOffset) % state.col(queryOffset - 1);
-    }
+      stateError(i, queryOffset) = stateErrorValue;
 
-    arma::Col<eT> inGateDerivative;
-    GateActivationFunction::deriv(inGateAct.col(queryOffset), inGateDerivative);
+      const eT cellError = inGateAct(i, queryOffset) *
+          StateActivationFunction::deriv(cellAct(i, queryOffset)) *
+          stateErrorValue;
 
-    inGateError.col(queryOffset) = inGateDerivative %
-        stateError.col(queryOffset) % cellAct.col(queryOffset);
+      if (hasPrev)
+      {
+        forgetGateError(i, queryOffset) = GateActivationFunction::deriv(
+            forgetGateAct(i, queryOffset)) * stateErrorValue *
+            state(i, queryOffset - 1);
+      }
 
-    if (peepholes)
-    {
-      peepholeDerivatives.col(2) += outGateError.col(queryOffset) %
-          state.col(queryOffset);
+      inGateError(i, queryOffset) = GateActivationFunction::deriv(
+          inGateAct(i, queryOffset)) * stateErrorValue *
+          cellAct(i, queryOffset);
 
-      if (queryOffset > 0)
+      if (peepholes)
       {
-        peepholeDerivatives.col(0) += inGateError.col(queryOffset) %
-            state.col(queryOffset - 1);
-        peepholeDerivatives.col(1) += forgetGateError.col(queryOffset) %
-            state.col(queryOffset - 1);
+        peepholeDerivatives(i, 2) += outGateError(i, queryOffset) *
+            state(i, queryOffset);
+
+        if (hasPrev)
+        {
+          peepholeDerivatives(i, 0) += inGateError(i, queryOffset) *
+              state(i, queryOffset - 1);
+          peepholeDerivatives(i, 1) += forgetGateError(i, queryOffset) *
+              state(i, queryOffset - 1);
+        }
       }
-    }
 
-    g = arma::zeros<arma::Mat<eT> >(outSize * 4, 1);
-    g.submat(0, 0, outSize - 1, 0) = inGateError.col(queryOffset);
-    g.submat(outSize, 0, (outSize * 2) - 1, 0) =
-        forgetGateError.col(queryOffset);
-    g.submat(outSize * 2, 0, (outSize * 3) - 1, 0) = cellError;
-    g.submat(outSize * 3, 0, (outSize * 4) - 1, 0) =
-        outGateError.col(queryOffset);
+      g[i] = inGateError(i, queryOffset);
+      g[outSize + i] = forgetGateError(i, queryOffset);
+      g[outSize * 2 + i] = cellError;
+      g[outSize * 3 + i] = outGateError(i, queryOffset);
+    }
 
     offset = (offset + 1) % seqLen;
   }
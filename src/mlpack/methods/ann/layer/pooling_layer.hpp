@@ -17,7 +17,9 @@ namespace ann /** Artificial Neural Network. */ {
 
 /**
  * Implementation of the pooling layer. The pooling layer works as a metaclass
- * which attaches various functions to the embedding layer.
+ * which attaches various functions to the embedding layer.  All the maps of
+ * the input are pooled and unpooled at once by the whole-map functions of the
+ * pooling rule (see MaxPooling and MeanPooling).
  *
  * @tparam PoolingRule Pooling function used for the embedding layer.
  * @tparam InputDataType Type of the input data (arma::colvec, arma::mat,
@@ -55,7 +57,14 @@ class PoolingLayer
   template<typename eT>
   void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
   {
-    Pooling(input, output);
+    // The matrices are pooled as cubes with a single map.
+    const arma::Cube<eT> inputCube(const_cast<eT*>(input.memptr()),
+        input.n_rows, input.n_cols, 1, false, true);
+    output.set_size(input.n_rows / kSize, input.n_cols / kSize);
+    arma::Cube<eT> outputCube(output.memptr(), output.n_rows, output.n_cols,
+        1, false, true);
+
+    pooling.Pooling(inputCube, kSize, outputCube);
   }
 
   /**
@@ -68,11 +77,7 @@ class PoolingLayer
   template<typename eT>
   void Forward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
   {
-    output = arma::zeros<arma::Cube<eT> >(input.n_rows / kSize,
-                            input.n_cols / kSize, input.n_slices);
-
-    for (size_t s = 0; s < input.n_slices; s++)
-      Pooling(input.slice(s), output.slice(s));
+    pooling.Pooling(input, kSize, output);
   }
 
   /**
@@ -89,13 +94,9 @@ class PoolingLayer
                 const arma::Cube<eT>& gy,
                 arma::Cube<eT>& g)
   {
-    g = arma::zeros<arma::Cube<eT> >(inputParameter.n_rows,
-        inputParameter.n_cols, inputParameter.n_slices);
-
-    for (size_t s = 0; s < gy.n_slices; s++)
-    {
-      Unpooling(inputParameter.slice(s), gy.slice(s), g.slice(s));
-    }
+    g.zeros(inputParameter.n_rows, inputParameter.n_cols,
+        inputParameter.n_slices);
+    pooling.Unpooling(gy, kSize, g);
   }
 
   /**
@@ -112,20 +113,28 @@ class PoolingLayer
                 const arma::Mat<eT>& gy,
                 arma::Cube<eT>& g)
   {
-    // Generate a cube from the error matrix.
-    arma::Cube<eT> mappedError = arma::zeros<arma::cube>(outputParameter.n_rows,
-        outputParameter.n_cols, outputParameter.n_slices);
+    // Generate a cube from the error matrix.  An error with a single column
+    // holds the slices one after the other, so its memory is used directly.
+    if (gy.n_cols == 1)
+    {
+      const arma::Cube<eT> mappedError(const_cast<eT*>(gy.memptr()),
+          outputParameter.n_rows, outputParameter.n_cols,
+          outputParameter.n_slices, false, true);
+      Backward(inputParameter, mappedError, g);
+      return;
+    }
+
+    const size_t sliceSize = outputParameter.n_rows * outputParameter.n_cols;
+    mappedError.set_size(outputParameter.n_rows, outputParameter.n_cols,
+        outputParameter.n_slices);
 
     for (size_t s = 0, j = 0; s < mappedError.n_slices; s+= gy.n_cols, j++)
     {
       for (size_t i = 0; i < gy.n_cols; i++)
       {
-        arma::Col<eT> temp = gy.col(i).subvec(
-            j * outputParameter.n_rows * outputParameter.n_cols,
-            (j + 1) * outputParameter.n_rows * outputParameter.n_cols - 1);
-
-        mappedError.slice(s + i) = arma::Mat<eT>(temp.memptr(),
-            outputParameter.n_rows, outputParameter.n_cols);
+        mappedError.slice(s + i) = arma::Mat<eT>(const_cast<eT*>(
+            gy.colptr(i)) + j * sliceSize, outputParameter.n_rows,
+            outputParameter.n_cols, false, true);
       }
     }
 
@@ -158,60 +167,6 @@ class PoolingLayer
   }
 
  private:
-  /**
-   * Apply pooling to the input and store the results.
-   *
-   * @param input The input to be apply the pooling rule.
-   * @param output The pooled result.
-   */
-  template<typename eT>
-  void Pooling(const arma::Mat<eT>& input, arma::Mat<eT>& output)
-  {
-
-    const size_t rStep = kSize;
-    const size_t cStep = kSize;
-
-    for (size_t j = 0; j < input.n_cols; j += cStep)
-    {
-      for (size_t i = 0; i < input.n_rows; i += rStep)
-      {
-        output(i / rStep, j / cStep) += pooling.Pooling(
-            input(arma::span(i, i + rStep - 1), arma::span(j, j + cStep - 1)));
-      }
-    }
-  }
-
-  /**
-   * Apply unpooling to the input and store the results.
-   *
-   * @param input The input to be apply the unpooling rule.
-   * @param output The pooled result.
-   */
-  template<typename eT>
-  void Unpooling(const arma::Mat<eT>& input,
-                 const arma::Mat<eT>& error,
-                 arma::Mat<eT>& output)
-  {
-    const size_t rStep = input.n_rows / error.n_rows;
-    const size_t cStep = input.n_cols / error.n_cols;
-
-    arma::Mat<eT> unpooledError;
-    for (size_t j = 0; j < input.n_cols; j += cStep)
-    {
-      for (size_t i = 0; i < input.n_rows; i += rStep)
-      {
-        const arma::Mat<eT>& inputArea = input(arma::span(i, i + rStep - 1),
-                                               arma::span(j, j + cStep - 1));
-
-        pooling.Unpooling(inputArea, error(i / rStep, j / cStep),
-            unpooledError);
-
-        output(arma::span(i, i + rStep - 1),
-            arma::span(j, j + cStep - 1)) += unpooledError;
-      }
-    }
-  }
-
   //! Locally-stored size of the pooling window.
   size_t kSize;
 
@@ -224,6 +179,9 @@ class PoolingLayer
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
+  //! Locally-stored backpropagated error, mapped onto the output slices.
+  arma::Cube<typename OutputDataType::elem_type> mappedError;
+
   //! Locally-stored pooling strategy.
   PoolingRule pooling;
 }; // class PoolingLayer
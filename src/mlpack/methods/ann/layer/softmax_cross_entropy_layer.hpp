@@ -0,0 +1,151 @@
+/**
+ * @file softmax_cross_entropy_layer.hpp
+ *
+ * Definition of the SoftmaxCrossEntropyLayer class, which implements an output
+ * layer that computes the softmax of its input and its cross-entropy with the
+ * targets in one pass.
+ */
+#ifndef MLPACK_METHODS_ANN_LAYER_SOFTMAX_CROSS_ENTROPY_LAYER_HPP
+#define MLPACK_METHODS_ANN_LAYER_SOFTMAX_CROSS_ENTROPY_LAYER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/ann/layer/layer_traits.hpp>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * An output layer that replaces a SoftmaxLayer followed by a
+ * MulticlassClassificationLayer (or a LogSoftmaxLayer followed by a
+ * NegativeLogLikelihoodLayer).  The last layer of the network should output
+ * the unnormalized log-probabilities (e.g. a LinearLayer or a BiasLayer); for
+ * each column, this layer computes the softmax p of the input and the cross
+ * entropy with the target in a single pass over the column, shifting the input
+ * by its maximum so that the exponentials can't overflow.  The error is the
+ * gradient of the cross entropy with respect to the input, p - y.
+ *
+ * The target of each point is either its class index, in the range between 1
+ * and the number of classes (as for the NegativeLogLikelihoodLayer), in a
+ * target matrix with a single row, or a column of class probabilities (e.g. a
+ * one-hot column), in a target matrix with one row per class.
+ *
+ * CalculateError() returns the cross entropy of the batch, which the FFN and
+ * CNN classes use as the error of the network in place of the performance
+ * function.
+ */
+class SoftmaxCrossEntropyLayer
+{
+ public:
+  /**
+   * Create the SoftmaxCrossEntropyLayer object.
+   */
+  SoftmaxCrossEntropyLayer()
+  {
+    // Nothing to do here.
+  }
+
+  /*
+   * Calculate the error using the specified input activation and the target,
+   * and return the cross entropy.  The error is stored into the given error
+   * parameter.
+   *
+   * @param inputActivations Unnormalized log-probabilities of each class.
+   * @param target Class index (in a single row) or class probabilities (one
+   *     row per class) of each point.
+   * @param error The gradient of the cross entropy with respect to the input
+   *     activation, p - y.
+   * @return The cross entropy, summed over the points.
+   */
+  template<typename eT>
+  double CalculateError(const arma::Mat<eT>& inputActivations,
+                        const arma::Mat<eT>& target,
+                        arma::Mat<eT>& error) const
+  {
+    const size_t classes = inputActivations.n_rows;
+    const bool classIndices = (target.n_rows == 1 && classes > 1);
+    Log::Assert(classIndices || target.n_rows == classes,
+        "The target must hold a class index or one row per class.");
+
+    error.set_size(classes, inputActivations.n_cols);
+    double loss = 0;
+    for (size_t i = 0; i < inputActivations.n_cols; ++i)
+    {
+      const eT* input = inputActivations.colptr(i);
+      eT* p = error.colptr(i);
+
+      const eT maxInput = *std::max_element(input, input + classes);
+      eT sum = 0;
+      for (size_t j = 0; j < classes; ++j)
+      {
+        p[j] = std::exp(input[j] - maxInput);
+        sum += p[j];
+      }
+
+      // log p_j = input_j - logNorm.
+      const double logNorm = maxInput + std::log(sum);
+      const eT invSum = 1 / sum;
+      for (size_t j = 0; j < classes; ++j)
+        p[j] *= invSum;
+
+      if (classIndices)
+      {
+        const size_t currentTarget = (size_t) target(i) - 1;
+        Log::Assert(currentTarget < classes, "Target class out of range.");
+
+        loss += logNorm - input[currentTarget];
+        p[currentTarget] -= 1;
+      }
+      else
+      {
+        const eT* y = target.colptr(i);
+        for (size_t j = 0; j < classes; ++j)
+        {
+          if (y[j] != 0)
+            loss -= y[j] * (input[j] - logNorm);
+          p[j] -= y[j];
+        }
+      }
+    }
+
+    return loss;
+  }
+
+  /*
+   * Calculate the class probabilities (the softmax of the input activation).
+   *
+   * @param inputActivations Input data used to calculate the output class.
+   * @param output Probability of each class.
+   */
+  template<typename eT>
+  void OutputClass(const arma::Mat<eT>& inputActivations,
+                   arma::Mat<eT>& output) const
+  {
+    output = arma::exp(inputActivations.each_row() -
+        arma::max(inputActivations));
+    output.each_row() /= arma::sum(output);
+  }
+
+  /**
+   * Serialize the layer
+   */
+  template<typename Archive>
+  void Serialize(Archive& /* ar */, const unsigned int /* version */)
+  {
+  }
+}; // class SoftmaxCrossEntropyLayer
+
+//! Layer traits for the softmax cross-entropy layer.
+template <>
+class LayerTraits<SoftmaxCrossEntropyLayer>
+{
+ public:
+  static const bool IsBinary = false;
+  static const bool IsOutputLayer = true;
+  static const bool IsBiasLayer = false;
+  static const bool IsConnection = false;
+};
+
+} // namespace ann
+} // namespace mlpack
+
+#endif
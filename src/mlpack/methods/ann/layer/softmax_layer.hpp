@@ -48,7 +48,8 @@ class SoftmaxLayer
   {
     output = arma::trunc_exp(input -
         arma::repmat(arma::max(input), input.n_rows, 1));
-    output /= arma::accu(output);
+    // Each column of the input is a separate sample.
+    output.each_row() /= arma::sum(output);
   }
 
   /**
@@ -44,7 +44,8 @@ class SparseInputLayer
                    const double lambda = 0.0001) :
     inSize(inSize),
     outSize(outSize),
-    lambda(lambda)
+    lambda(lambda),
+    touchedGradient(NULL)
   {
     weights.set_size(outSize, inSize);
   }
@@ -62,6 +63,29 @@ class SparseInputLayer
     output = weights * input;
   }
 
+  /**
+   * Ordinary feed forward pass of a neural network, evaluating the function
+   * f(x) by propagating the activity forward through f, for sparse input.  Only
+   * the columns of the weights of the nonzero features of each point are used.
+   *
+   * @param input Input data used for evaluating the specified function.
+   * @param output Resulting output activation.
+   */
+  template<typename eT>
+  void Forward(const arma::SpMat<eT>& input, arma::Mat<eT>& output)
+  {
+    SyncSparse(input);
+    output.zeros(weights.n_rows, input.n_cols);
+    for (size_t i = 0; i < input.n_cols; ++i)
+    {
+      for (size_t j = input.col_ptrs[i]; j < input.col_ptrs[i + 1]; ++j)
+      {
+        output.col(i) += input.values[j] *
+            weights.col(input.row_indices[j]);
+      }
+    }
+  }
+
   /**
    * Ordinary feed backward pass of a neural network, calculating the function
    * f(x) by propagating x backwards trough f. Using the results from the feed
@@ -95,6 +119,60 @@ class SparseInputLayer
         input.n_cols) + lambda * weights;
   }
 
+  /*
+   * Calculate the gradient using the output delta and the sparse input
+   * activation.  Apart from the regularization, only the columns of the
+   * gradient of the nonzero features are touched.  Without regularization, if
+   * g is the memory that the last call wrote to (as it is when the network
+   * passes the same gradient each time), g must still hold that gradient: only
+   * the columns of the features of the last batch are then cleared, instead of
+   * the whole of g.
+   *
+   * @param input The propagated input.
+   * @param d The calculated error.
+   * @param g The calculated gradient.
+   */
+  template<typename eT, typename GradientDataType>
+  void Gradient(const arma::SpMat<eT>& input,
+                const arma::Mat<eT>& d,
+                GradientDataType& g)
+  {
+    SyncSparse(input);
+    if (lambda != 0.0)
+    {
+      // The regularization term is dense.
+      g = lambda * weights;
+    }
+    else if (g.n_rows != weights.n_rows || g.n_cols != weights.n_cols ||
+        (const void*) g.memptr() != touchedGradient)
+    {
+      g.zeros(weights.n_rows, weights.n_cols);
+    }
+    else
+    {
+      for (size_t i = 0; i < touchedColumns.n_elem; ++i)
+        g.col(touchedColumns[i]).zeros();
+    }
+
+    const eT scale = 1.0 / static_cast<eT>(input.n_cols);
+    for (size_t i = 0; i < input.n_cols; ++i)
+    {
+      for (size_t j = input.col_ptrs[i]; j < input.col_ptrs[i + 1]; ++j)
+      {
+        g.col(input.row_indices[j]) += (scale * input.values[j]) *
+            d.col(i);
+      }
+    }
+
+    // Remember the columns which are now nonzero.
+    touchedGradient = (lambda == 0.0) ? (const void*) g.memptr() : NULL;
+    if (lambda == 0.0 && input.n_nonzero > 0)
+      touchedColumns = arma::unique(arma::uvec(input.row_indices,
+          input.n_nonzero));
+    else
+      touchedColumns.reset();
+  }
+
   //! Get the weights.
   OutputDataType const& Weights() const { return weights; }
   //! Modify the weights.
@@ -154,6 +232,13 @@ class SparseInputLayer
 
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
+
+  //! The memory of the gradient written by the last sparse Gradient() call
+  //! without regularization (NULL if there is none).
+  const void* touchedGradient;
+
+  //! The columns of that gradient which may be nonzero.
+  arma::uvec touchedColumns;
 }; // class SparseInputLayer
 
 //! Layer traits for the SparseInputLayer.
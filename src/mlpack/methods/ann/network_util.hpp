@@ -55,15 +55,15 @@ LayerSize(T& layer, P& output);
  * @param network The network used to set the weights.
  * @param offset The memory offset of the weights.
  */
-template<size_t I = 0, typename... Tp>
+template<size_t I = 0, typename eT, typename... Tp>
 typename std::enable_if<I < sizeof...(Tp), void>::type
-NetworkWeights(arma::mat& weights,
+NetworkWeights(arma::Mat<eT>& weights,
                std::tuple<Tp...>& network,
                size_t offset = 0);
 
-template<size_t I, typename... Tp>
+template<size_t I, typename eT, typename... Tp>
 typename std::enable_if<I == sizeof...(Tp), void>::type
-NetworkWeights(arma::mat& weights,
+NetworkWeights(arma::Mat<eT>& weights,
                std::tuple<Tp...>& network,
                size_t offset = 0);
 
@@ -76,20 +76,26 @@ NetworkWeights(arma::mat& weights,
  * @param output The output parameter of the layer.
  * @return The number of weights.
  */
-template<typename T>
+template<typename T, typename eT>
 typename std::enable_if<
-    HasWeightsCheck<T, arma::mat&(T::*)()>::value, size_t>::type
-LayerWeights(T& layer, arma::mat& weights, size_t offset, arma::mat& output);
+    HasWeightsCheck<T, arma::Mat<eT>&(T::*)()>::value, size_t>::type
+LayerWeights(T& layer,
+             arma::Mat<eT>& weights,
+             size_t offset,
+             arma::Mat<eT>& output);
 
-template<typename T>
+template<typename T, typename eT>
 typename std::enable_if<
-    HasWeightsCheck<T, arma::cube&(T::*)()>::value, size_t>::type
-LayerWeights(T& layer, arma::mat& weights, size_t offset, arma::cube& output);
+    HasWeightsCheck<T, arma::Cube<eT>&(T::*)()>::value, size_t>::type
+LayerWeights(T& layer,
+             arma::Mat<eT>& weights,
+             size_t offset,
+             arma::Cube<eT>& output);
 
-template<typename T, typename P>
+template<typename T, typename P, typename eT>
 typename std::enable_if<
     !HasWeightsCheck<T, P&(T::*)()>::value, size_t>::type
-LayerWeights(T& layer, arma::mat& weights, size_t offset, P& output);
+LayerWeights(T& layer, arma::Mat<eT>& weights, size_t offset, P& output);
 
 /**
  * Auxiliary function to set the gradients of the specified network.
@@ -99,15 +105,15 @@ LayerWeights(T& layer, arma::mat& weights, size_t offset, P& output);
  * @param offset The memory offset of the gradients.
  * return The number of gradients.
  */
-template<size_t I = 0, typename... Tp>
+template<size_t I = 0, typename eT, typename... Tp>
 typename std::enable_if<I < sizeof...(Tp), void>::type
-NetworkGradients(arma::mat& gradients,
+NetworkGradients(arma::Mat<eT>& gradients,
                std::tuple<Tp...>& network,
                size_t offset = 0);
 
-template<size_t I, typename... Tp>
+template<size_t I, typename eT, typename... Tp>
 typename std::enable_if<I == sizeof...(Tp), void>::type
-NetworkGradients(arma::mat& gradients,
+NetworkGradients(arma::Mat<eT>& gradients,
                std::tuple<Tp...>& network,
                size_t offset = 0);
 
@@ -120,26 +126,26 @@ NetworkGradients(arma::mat& gradients,
  * @param output The output parameter of the layer.
  * @return The number of gradients.
  */
-template<typename T>
+template<typename T, typename eT>
 typename std::enable_if<
-    HasGradientCheck<T, arma::mat&(T::*)()>::value, size_t>::type
+    HasGradientCheck<T, arma::Mat<eT>&(T::*)()>::value, size_t>::type
 LayerGradients(T& layer,
-               arma::mat& gradients,
+               arma::Mat<eT>& gradients,
                size_t offset,
-               arma::mat& output);
+               arma::Mat<eT>& output);
 
-template<typename T>
+template<typename T, typename eT>
 typename std::enable_if<
-    HasGradientCheck<T, arma::cube&(T::*)()>::value, size_t>::type
+    HasGradientCheck<T, arma::Cube<eT>&(T::*)()>::value, size_t>::type
 LayerGradients(T& layer,
-               arma::mat& gradients,
+               arma::Mat<eT>& gradients,
                size_t offset,
-               arma::cube& output);
+               arma::Cube<eT>& output);
 
-template<typename T, typename P>
+template<typename T, typename P, typename eT>
 typename std::enable_if<
     !HasGradientCheck<T, P&(T::*)()>::value, size_t>::type
-LayerGradients(T& layer, arma::mat& gradients, size_t offset, P& output);
+LayerGradients(T& layer, arma::Mat<eT>& gradients, size_t offset, P& output);
 
 /**
  * Auxiliary function to get the input size of the specified network.
@@ -45,7 +45,9 @@ class MeanSquaredErrorFunction
   template<typename DataType>
   static double Error(const DataType& input, const DataType& target, const DataType&)
   {
-    return arma::mean(arma::mean(arma::square(target - input)));
+    // The mean is taken over the outputs of each sample (column), and the
+    // errors of the samples are summed.
+    return arma::accu(arma::square(target - input)) / target.n_rows;
   }
 
 }; // class MeanSquaredErrorFunction
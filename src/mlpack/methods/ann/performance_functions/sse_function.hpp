@@ -48,7 +48,7 @@ class SumSquaredErrorFunction
                       const DataType& target,
                       const DataType&)
   {
-    return arma::sum(arma::square(target - input));
+    return arma::accu(arma::square(target - input));
   }
 
 }; // class SumSquaredErrorFunction
@@ -15,6 +15,10 @@ namespace ann /** Artificial Neural Network. */ {
 /*
  * The max pooling rule for convolution neural networks. Take the maximum value
  * within the receptive block.
+ *
+ * The whole-map Pooling() function stores the position of the maximum of each
+ * block, so that Unpooling() can pass the error of each block on to that
+ * position without looking at the input again.
  */
 class MaxPooling
 {
@@ -43,6 +47,77 @@ class MaxPooling
     output = MatType(input.n_rows, input.n_cols);
     output.fill(value / input.n_elem);
   }
+
+  /*
+   * Take the maximum value of each kSize x kSize block of each map (slice) of
+   * the input, and store its position.  Rows and columns which do not fill a
+   * whole block are ignored.
+   *
+   * @param input Input used to perform the pooling operation.
+   * @param kSize Size of the pooling window.
+   * @param output The pooled output data.
+   */
+  template<typename eT>
+  void Pooling(const arma::Cube<eT>& input,
+               const size_t kSize,
+               arma::Cube<eT>& output)
+  {
+    output.set_size(input.n_rows / kSize, input.n_cols / kSize,
+        input.n_slices);
+    indices.set_size(output.n_elem);
+
+    const eT* in = input.memptr();
+    eT* out = output.memptr();
+    arma::uword* index = indices.memptr();
+    for (size_t s = 0; s < output.n_slices; ++s)
+    {
+      for (size_t j = 0; j < output.n_cols; ++j)
+      {
+        for (size_t i = 0; i < output.n_rows; ++i, ++out, ++index)
+        {
+          const size_t first = s * input.n_elem_slice +
+              j * kSize * input.n_rows + i * kSize;
+
+          size_t best = first;
+          for (size_t kj = 0, col = first; kj < kSize;
+              ++kj, col += input.n_rows)
+          {
+            for (size_t ki = col; ki < col + kSize; ++ki)
+            {
+              if (in[ki] > in[best])
+                best = ki;
+            }
+          }
+
+          *out = in[best];
+          *index = best;
+        }
+      }
+    }
+  }
+
+  /*
+   * Add the error of each block to the position of the maximum of the block,
+   * as found by the last call to the whole-map Pooling() function.
+   *
+   * @param error The error of the pooled output data.
+   * @param kSize Size of the pooling window.
+   * @param output The unpooled output data; it must already have the size of
+   *     the pooled input.
+   */
+  template<typename eT>
+  void Unpooling(const arma::Cube<eT>& error,
+                 const size_t /* kSize */,
+                 arma::Cube<eT>& output)
+  {
+    for (size_t i = 0; i < error.n_elem; ++i)
+      output[indices[i]] += error[i];
+  }
+
+ private:
+  //! The position (in the input) of the maximum of each block, from the last
+  //! call to the whole-map Pooling() function.
+  arma::uvec indices;
 };
 
 } // namespace ann
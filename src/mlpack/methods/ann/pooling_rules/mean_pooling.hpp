@@ -43,6 +43,75 @@ class MeanPooling
     output = MatType(input.n_rows, input.n_cols);
     output.fill(value / input.n_elem);
   }
+
+  /*
+   * Take the average value of each kSize x kSize block of each map (slice) of
+   * the input.  Rows and columns which do not fill a whole block are ignored.
+   *
+   * @param input Input used to perform the pooling operation.
+   * @param kSize Size of the pooling window.
+   * @param output The pooled output data.
+   */
+  template<typename eT>
+  void Pooling(const arma::Cube<eT>& input,
+               const size_t kSize,
+               arma::Cube<eT>& output)
+  {
+    output.zeros(input.n_rows / kSize, input.n_cols / kSize, input.n_slices);
+
+    const eT scale = eT(1) / (kSize * kSize);
+    for (size_t s = 0; s < output.n_slices; ++s)
+    {
+      for (size_t j = 0; j < output.n_cols; ++j)
+      {
+        eT* out = output.slice_colptr(s, j);
+        for (size_t kj = 0; kj < kSize; ++kj)
+        {
+          const eT* in = input.slice_colptr(s, j * kSize + kj);
+          for (size_t i = 0; i < output.n_rows; ++i, in += kSize)
+            for (size_t ki = 0; ki < kSize; ++ki)
+              out[i] += in[ki];
+        }
+
+        for (size_t i = 0; i < output.n_rows; ++i)
+          out[i] *= scale;
+      }
+    }
+  }
+
+  /*
+   * Add the error of each block, divided by the size of the block, to each
+   * element of the block.
+   *
+   * @param error The error of the pooled output data.
+   * @param kSize Size of the pooling window.
+   * @param output The unpooled output data; it must already have the size of
+   *     the pooled input.
+   */
+  template<typename eT>
+  void Unpooling(const arma::Cube<eT>& error,
+                 const size_t kSize,
+                 arma::Cube<eT>& output)
+  {
+    const eT scale = eT(1) / (kSize * kSize);
+    for (size_t s = 0; s < error.n_slices; ++s)
+    {
+      for (size_t j = 0; j < error.n_cols; ++j)
+      {
+        const eT* err = error.slice_colptr(s, j);
+        for (size_t kj = 0; kj < kSize; ++kj)
+        {
+          eT* out = output.slice_colptr(s, j * kSize + kj);
+          for (size_t i = 0; i < error.n_rows; ++i, out += kSize)
+          {
+            const eT value = err[i] * scale;
+            for (size_t ki = 0; ki < kSize; ++ki)
+              out[ki] += value;
+          }
+        }
+      }
+    }
+  }
 };
 
 } // namespace ann
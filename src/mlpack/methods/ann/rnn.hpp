@@ -23,6 +23,22 @@ namespace ann /** Artificial Neural Network. */ {
 /**
  * Implementation of a standard recurrent neural network.
  *
+ * Each column of the predictors is a sequence (the inputs of all time steps
+ * stacked), and each column of the responses holds its target (or the targets
+ * of all time steps stacked, if the network has an output at each step).  The
+ * batch overloads of Evaluate() and Gradient(), which are used by optimizers
+ * like mini-batch SGD, propagate several sequences through the network in
+ * lockstep, so that the input of each time step is a matrix with one column per
+ * sequence.  With BPTTSteps() set, the gradient is computed with truncated
+ * backpropagation through time: the sequences are processed in windows of that
+ * many steps, the recurrent state is carried from one window to the next, but
+ * the error is only propagated backward within each window, so that only the
+ * activations of one window are stored.
+ *
+ * Networks with LSTM layers, which keep the state of a single complete sequence
+ * themselves, always process one sequence at a time and backpropagate through
+ * the whole sequence.
+ *
  * @tparam LayerTypes Contains all layer modules used to construct the network.
  * @tparam OutputLayerType The output layer type used to evaluate the network.
  * @tparam InitializationRuleType Rule used to initialize the weight matrix.
@@ -201,6 +217,39 @@ class RNN
                 const size_t i,
                 arma::mat& gradient);
 
+  /**
+   * Evaluate the recurrent neural network with the given parameters on a batch
+   * of consecutive sequences, which are propagated through the network
+   * together, one time step at a time.  The sequences must have the same
+   * length.  The result is the sum of the errors of the sequences.
+   *
+   * @param parameters Matrix model parameters.
+   * @param begin Index of the first sequence of the batch.
+   * @param batchSize Number of sequences in the batch.
+   * @param deterministic Whether or not to train or test the model. Note some
+   * layer act differently in training or testing mode.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic = true);
+
+  /**
+   * Evaluate the gradient of the recurrent neural network with the given
+   * parameters, summed over a batch of consecutive sequences, which are
+   * propagated through the network together.  This is used by optimizers such
+   * as mini-batch SGD.
+   *
+   * @param parameters Matrix of the model parameters to be optimized.
+   * @param begin Index of the first sequence of the batch.
+   * @param gradient Matrix to output gradient into.
+   * @param batchSize Number of sequences in the batch.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize);
+
   //! Return the number of separable functions (the number of predictor points).
   size_t NumFunctions() const { return numFunctions; }
 
@@ -209,6 +258,13 @@ class RNN
   //! Modify the initial point for the optimization.
   arma::mat& Parameters() { return parameter; }
 
+  //! Get the number of time steps of truncated backpropagation through time
+  //! (0 backpropagates through the whole sequence).
+  size_t BPTTSteps() const { return bpttSteps; }
+  //! Modify the number of time steps of truncated backpropagation through time
+  //! (0 backpropagates through the whole sequence).
+  size_t& BPTTSteps() { return bpttSteps; }
+
   //! Serialize the model.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
@@ -221,13 +277,19 @@ class RNN
   void SinglePredict(const DataType& input, DataType& output)
   {
     deterministic = true;
+    batchSize = input.n_cols;
     seqLen = input.n_rows / inputSize;
     ResetParameter(network);
 
+    // Nothing is propagated backward, so only the current step is stored.
+    windowSize = 1;
+    output.reset();
+
     // Iterate through the input sequence and perform the feed forward pass.
     for (seqNum = 0; seqNum < seqLen; seqNum++)
     {
       // Perform the forward pass and save the activations.
+      windowStart = seqNum;
       Forward(input.rows(seqNum * inputSize, (seqNum + 1) * inputSize - 1),
           network);
       SaveActivations(network);
@@ -235,9 +297,9 @@ class RNN
       // Retrieve output of the subsequence.
       if (seqOutput)
       {
-        DataType seqOutput;
-        OutputPrediction(seqOutput, network);
-        output = arma::join_cols(output, seqOutput);
+        DataType stepOutput;
+        OutputPrediction(stepOutput, network);
+        output = arma::join_cols(output, stepOutput);
       }
     }
 
@@ -247,16 +309,50 @@ class RNN
   }
 
   /**
-   * Reset the network by clearing the layer activations and by setting the
-   * layer status.
+   * Propagate the given batch of sequences through the network and return the
+   * sum of their errors.  If gradient is not NULL, the gradient of the batch
+   * is added to it.
    */
-  template<size_t I = 0, typename... Tp>
-  typename std::enable_if<I == sizeof...(Tp), void>::type
-  ResetParameter(std::tuple<Tp...>& /* unused */)
+  double Sequences(const size_t begin,
+                   const size_t batchSize,
+                   arma::mat* gradient);
+
+  /**
+   * Propagate the error of the current window (which ends before windowEnd)
+   * backward, and add the gradient to the given gradient.  The gradients of
+   * the layers are stored in layerGradient at each step.
+   */
+  void BackwardWindow(const arma::mat& input,
+                      const size_t windowEnd,
+                      const arma::mat& layerGradient,
+                      arma::mat& gradient);
+
+  /**
+   * Return whether the network has a layer that keeps the state of a complete
+   * sequence itself (a layer with a SeqLen() function, like the LSTM layer).
+   */
+  template<size_t I = 0>
+  typename std::enable_if<I == std::tuple_size<LayerTypes>::value, bool>::type
+  HasSequenceLayer() const { return false; }
+
+  template<size_t I = 0>
+  typename std::enable_if<I < std::tuple_size<LayerTypes>::value, bool>::type
+  HasSequenceLayer() const
   {
-    activations.clear();
+    typedef typename std::remove_reference<
+        typename std::tuple_element<I, LayerTypes>::type>::type T;
+
+    return HasSeqLenCheck<T, size_t&(T::*)(void)>::value ||
+        HasSequenceLayer<I + 1>();
   }
 
+  /**
+   * Reset the network by setting the layer status.
+   */
+  template<size_t I = 0, typename... Tp>
+  typename std::enable_if<I == sizeof...(Tp), void>::type
+  ResetParameter(std::tuple<Tp...>& /* unused */) { /* Nothing to do here */ }
+
   template<size_t I = 0, typename... Tp>
   typename std::enable_if<I < sizeof...(Tp), void>::type
   ResetParameter(std::tuple<Tp...>& network)
@@ -269,6 +365,22 @@ class RNN
     ResetParameter<I + 1, Tp...>(network);
   }
 
+  /**
+   * Clear the deltas of the layers, so that no error is propagated backward
+   * from a later time step.
+   */
+  template<size_t I = 0, typename... Tp>
+  typename std::enable_if<I == sizeof...(Tp), void>::type
+  ResetDelta(std::tuple<Tp...>& /* unused */) { /* Nothing to do here */ }
+
+  template<size_t I = 0, typename... Tp>
+  typename std::enable_if<I < sizeof...(Tp), void>::type
+  ResetDelta(std::tuple<Tp...>& network)
+  {
+    std::get<I>(network).Delta().reset();
+    ResetDelta<I + 1, Tp...>(network);
+  }
+
   /**
    * Reset the layer status by setting the current deterministic parameter
    * for all layer that implement the Deterministic function.
@@ -312,7 +424,9 @@ class RNN
       HasRecurrentParameterCheck<T, P&(T::*)()>::value, void>::type
   ResetRecurrent(T& layer, P& /* unused */)
   {
-    layer.RecurrentParameter().zeros();
+    // Each sequence of the batch has its own state.
+    layer.RecurrentParameter().zeros(layer.RecurrentParameter().n_rows,
+        batchSize);
   }
 
   template<typename T, typename P>
@@ -333,7 +447,7 @@ class RNN
             const TargetDataType& target,
             std::tuple<Tp...>& /* unused */)
   {
-    seqOutput = outputSize < target.n_elem ? true : false;
+    seqOutput = outputSize < target.n_rows ? true : false;
   }
 
   template<size_t I = 0, typename InputDataType, typename TargetDataType,
@@ -411,12 +525,10 @@ class RNN
   Save(const size_t layerNumber, T& layer, P& /* unused */)
   {
     if (activations.size() == layerNumber)
-    {
-      activations.push_back(new arma::mat(layer.RecurrentParameter().n_rows,
-          seqLen));
-    }
+      activations.push_back(new arma::mat());
 
-    activations[layerNumber].unsafe_col(seqNum) = layer.RecurrentParameter();
+    StepActivations(layerNumber, layer.RecurrentParameter().n_rows) =
+        layer.RecurrentParameter();
   }
 
   template<typename T, typename P>
@@ -425,12 +537,27 @@ class RNN
   Save(const size_t layerNumber, T& layer, P& /* unused */)
   {
     if (activations.size() == layerNumber)
-    {
-      activations.push_back(new arma::mat(layer.OutputParameter().n_rows,
-          seqLen));
-    }
+      activations.push_back(new arma::mat());
 
-    activations[layerNumber].unsafe_col(seqNum) = layer.OutputParameter();
+    StepActivations(layerNumber, layer.OutputParameter().n_rows) =
+        layer.OutputParameter();
+  }
+
+  /**
+   * Return the stored activations of the given layer at the current time step
+   * (one column per sequence of the batch).  The activations of the steps of
+   * the current window are stored; if rows is given, the storage is resized
+   * for the current window and batch if needed.
+   */
+  arma::mat StepActivations(const size_t layerNumber, const size_t rows = 0)
+  {
+    arma::mat& storage = activations[layerNumber];
+    if (rows != 0 && (storage.n_rows != rows ||
+        storage.n_cols != windowSize * batchSize))
+      storage.set_size(rows, windowSize * batchSize);
+
+    return arma::mat(storage.colptr((seqNum - windowStart) * batchSize),
+        storage.n_rows, batchSize, false, true);
   }
 
   /**
@@ -469,7 +596,7 @@ class RNN
       HasRecurrentParameterCheck<T, P&(T::*)()>::value, void>::type
   Load(const size_t layerNumber, T& layer, P& /* unused */)
   {
-    layer.RecurrentParameter() = activations[layerNumber].unsafe_col(seqNum);
+    layer.RecurrentParameter() = StepActivations(layerNumber);
   }
 
   template<typename T, typename P>
@@ -477,7 +604,7 @@ class RNN
       !HasRecurrentParameterCheck<T, P&(T::*)()>::value, void>::type
   Load(const size_t layerNumber, T& layer, P& /* unused */)
   {
-    layer.OutputParameter() = activations[layerNumber].unsafe_col(seqNum);
+    layer.OutputParameter() = StepActivations(layerNumber);
   }
 
   /**
@@ -783,6 +910,18 @@ class RNN
 
   //! Locally stored backward error.
   arma::mat error;
+
+  //! The number of time steps of truncated backpropagation through time.
+  size_t bpttSteps;
+
+  //! The number of sequences propagated together.
+  size_t batchSize;
+
+  //! The first time step of the current window.
+  size_t windowStart;
+
+  //! The number of time steps of the windows whose activations are stored.
+  size_t windowSize;
 }; // class RNN
 
 } // namespace ann
@@ -38,7 +38,9 @@ RNN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     responses(responses),
     numFunctions(predictors.n_cols),
     inputSize(0),
-    outputSize(0)
+    outputSize(0),
+    bpttSteps(0),
+    batchSize(1)
 {
   static_assert(std::is_same<typename std::decay<LayerType>::type,
                   LayerTypes>::value,
@@ -77,7 +79,9 @@ RNN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     outputLayer(std::forward<OutputType>(outputLayer)),
     performanceFunc(std::move(performanceFunction)),
     inputSize(0),
-    outputSize(0)
+    outputSize(0),
+    bpttSteps(0),
+    batchSize(1)
 {
   static_assert(std::is_same<typename std::decay<LayerType>::type,
                   LayerTypes>::value,
@@ -108,7 +112,9 @@ RNN<LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     outputLayer(std::forward<OutputType>(outputLayer)),
     performanceFunc(std::move(performanceFunction)),
     inputSize(0),
-    outputSize(0)
+    outputSize(0),
+    bpttSteps(0),
+    batchSize(1)
 {
   static_assert(std::is_same<typename std::decay<LayerType>::type,
                   LayerTypes>::value,
@@ -202,6 +208,13 @@ void RNN<
 LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 >::Predict(arma::mat& predictors, arma::mat& responses)
 {
+  // Without LSTM layers, all the sequences are propagated together.
+  if (!HasSequenceLayer())
+  {
+    SinglePredict(predictors, responses);
+    return;
+  }
+
   arma::mat responsesTemp;
   SinglePredict(arma::mat(predictors.colptr(0), predictors.n_rows,
       1, false, true), responsesTemp);
@@ -230,44 +243,48 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 {
   this->deterministic = deterministic;
 
-  arma::mat input = arma::mat(predictors.colptr(i), predictors.n_rows,
-      1, false, true);
-  arma::mat target = arma::mat(responses.colptr(i), responses.n_rows,
-      1, false, true);
-
-  // Initialize the activation storage only once.
-  if (activations.empty())
-    InitLayer(input, target, network);
-
-  double networkError = 0;
-  seqLen = input.n_rows / inputSize;
-  ResetParameter(network);
-
-  error = arma::mat(outputSize, outputSize < target.n_elem ? seqLen : 1);
+  return Sequences(i, 1, NULL);
+}
 
-  // Iterate through the input sequence and perform the feed forward pass.
-  for (seqNum = 0; seqNum < seqLen; seqNum++)
+template<typename LayerTypes,
+         typename OutputLayerType,
+         typename InitializationRuleType,
+         typename PerformanceFunction
+>
+void RNN<
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+>::Gradient(const arma::mat& /* unused */,
+            const size_t i,
+            arma::mat& gradient)
+{
+  if (gradient.is_empty())
   {
-    // Perform the forward pass and save the activations.
-    Forward(input.rows(seqNum * inputSize, (seqNum + 1) * inputSize - 1),
-        network);
-    SaveActivations(network);
-
-    // Retrieve output error of the subsequence.
-    if (seqOutput)
-    {
-      arma::mat seqError = error.unsafe_col(seqNum);
-      arma::mat seqTarget = target.submat(seqNum * outputSize, 0,
-          (seqNum + 1) * outputSize - 1, 0);
-      networkError += OutputError(seqTarget, seqError, network);
-    }
+    gradient = arma::zeros<arma::mat>(parameter.n_rows, parameter.n_cols);
+  }
+  else
+  {
+    gradient.zeros();
   }
 
-  // Retrieve output error of the complete sequence.
-  if (!seqOutput)
-    return OutputError(target, error, network);
+  deterministic = false;
+  Sequences(i, 1, &gradient);
+}
 
-  return networkError;
+template<typename LayerTypes,
+         typename OutputLayerType,
+         typename InitializationRuleType,
+         typename PerformanceFunction
+>
+double RNN<
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+>::Evaluate(const arma::mat& /* unused */,
+            const size_t begin,
+            const size_t batchSize,
+            const bool deterministic)
+{
+  this->deterministic = deterministic;
+
+  return Sequences(begin, batchSize, NULL);
 }
 
 template<typename LayerTypes,
@@ -278,8 +295,9 @@ template<typename LayerTypes,
 void RNN<
 LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
 >::Gradient(const arma::mat& /* unused */,
-            const size_t i,
-            arma::mat& gradient)
+            const size_t begin,
+            arma::mat& gradient,
+            const size_t batchSize)
 {
   if (gradient.is_empty())
   {
@@ -290,16 +308,118 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     gradient.zeros();
   }
 
-  Evaluate(parameter, i, false);
+  deterministic = false;
+  Sequences(begin, batchSize, &gradient);
+}
 
-  arma::mat currentGradient = arma::mat(gradient.n_rows, gradient.n_cols);
-  NetworkGradients(currentGradient, network);
+template<typename LayerTypes,
+         typename OutputLayerType,
+         typename InitializationRuleType,
+         typename PerformanceFunction
+>
+double RNN<
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+>::Sequences(const size_t begin,
+                     const size_t batchSize,
+                     arma::mat* gradient)
+{
+  // LSTM layers keep the state of a single sequence, so the sequences are
+  // propagated one at a time.
+  if (batchSize > 1 && HasSequenceLayer())
+  {
+    double networkError = 0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      networkError += Sequences(i, 1, gradient);
+
+    return networkError;
+  }
+
+  const arma::mat input(const_cast<double*>(predictors.colptr(begin)),
+      predictors.n_rows, batchSize, false, true);
+  const arma::mat target(const_cast<double*>(responses.colptr(begin)),
+      responses.n_rows, batchSize, false, true);
+
+  // Initialize the activation storage only once.
+  if (activations.empty())
+    InitLayer(input, target, network);
+
+  this->batchSize = batchSize;
+  seqLen = input.n_rows / inputSize;
+  ResetParameter(network);
+
+  // Without a gradient, nothing is propagated backward, so only the current
+  // step is stored.  LSTM layers always backpropagate through the whole
+  // sequence.
+  if (gradient == NULL)
+    windowSize = 1;
+  else if (bpttSteps == 0 || bpttSteps > seqLen || HasSequenceLayer())
+    windowSize = seqLen;
+  else
+    windowSize = bpttSteps;
+
+  error.set_size(outputSize, seqOutput ? windowSize * batchSize : batchSize);
+
+  arma::mat layerGradient;
+  if (gradient != NULL)
+  {
+    layerGradient.set_size(gradient->n_rows, gradient->n_cols);
+    NetworkGradients(layerGradient, network);
+  }
 
-  const arma::mat input = arma::mat(predictors.colptr(i), predictors.n_rows,
-      1, false, true);
+  double networkError = 0;
+  for (windowStart = 0; windowStart < seqLen; windowStart += windowSize)
+  {
+    const size_t windowEnd = std::min(windowStart + windowSize, seqLen);
 
-  // Iterate through the input sequence and perform the feed backward pass.
-  for (seqNum = seqLen - 1; seqNum >= 0; seqNum--)
+    // Iterate through the window and perform the feed forward pass.
+    for (seqNum = windowStart; seqNum < windowEnd; seqNum++)
+    {
+      // Perform the forward pass and save the activations.
+      Forward(input.rows(seqNum * inputSize, (seqNum + 1) * inputSize - 1),
+          network);
+      SaveActivations(network);
+
+      // Retrieve output error of the subsequence.
+      if (seqOutput)
+      {
+        arma::mat seqError(error.colptr((seqNum - windowStart) * batchSize),
+            outputSize, batchSize, false, true);
+        const arma::mat seqTarget = target.rows(seqNum * outputSize,
+            (seqNum + 1) * outputSize - 1);
+        networkError += OutputError(seqTarget, seqError, network);
+      }
+    }
+
+    // Retrieve output error of the complete sequence.
+    if (!seqOutput && windowEnd == seqLen)
+      networkError = OutputError(target, error, network);
+
+    // Without an output at each step, only the last window has an error to
+    // propagate backward.
+    if (gradient != NULL && (seqOutput || windowEnd == seqLen))
+      BackwardWindow(input, windowEnd, layerGradient, *gradient);
+  }
+
+  return networkError;
+}
+
+template<typename LayerTypes,
+         typename OutputLayerType,
+         typename InitializationRuleType,
+         typename PerformanceFunction
+>
+void RNN<
+LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
+>::BackwardWindow(const arma::mat& input,
+                          const size_t windowEnd,
+                          const arma::mat& layerGradient,
+                          arma::mat& gradient)
+{
+  // The error of the later windows isn't propagated into this one.
+  ResetDelta(network);
+
+  // Iterate through the window and perform the feed backward pass.
+  for (seqNum = windowEnd - 1; ; seqNum--)
   {
     // Load the network activation for the upcoming backward pass.
     LoadActivations(input.rows(seqNum * inputSize, (seqNum + 1) *
@@ -308,7 +428,8 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     // Perform the backward pass.
     if (seqOutput)
     {
-      arma::mat seqError = error.unsafe_col(seqNum);
+      arma::mat seqError(error.colptr((seqNum - windowStart) * batchSize),
+          outputSize, batchSize, false, true);
       Backward(seqError, network);
     }
     else
@@ -321,9 +442,19 @@ LayerTypes, OutputLayerType, InitializationRuleType, PerformanceFunction
     UpdateGradients<>(network);
 
     // Update the overall gradient.
-    gradient += currentGradient;
+    gradient += layerGradient;
+
+    if (seqNum == windowStart) break;
+  }
 
-    if (seqNum == 0) break;
+  // Restore the recurrent state at the end of the window, which the next
+  // window starts from.
+  if (windowEnd < seqLen)
+  {
+    seqNum = windowEnd - 1;
+    LoadActivations(input.rows(seqNum * inputSize, (seqNum + 1) *
+        inputSize - 1), network);
+    LinkRecurrent(network);
   }
 }
 
@@ -47,122 +47,155 @@ void CF::GetRecommendations(const size_t numRecs,
                             arma::Mat<size_t>& recommendations,
                             arma::Col<size_t>& users)
 {
-  // We want to avoid calculating the full rating matrix, so we will do nearest
-  // neighbor search only on the H matrix, using the observation that if the
-  // rating matrix X = W*H, then d(X.col(i), X.col(j)) = d(W H.col(i), W
-  // H.col(j)).  This can be seen as nearest neighbor search on the H matrix
-  // with the Mahalanobis distance where M^{-1} = W^T W.  So, we'll decompose
-  // M^{-1} = L L^T (the Cholesky decomposition), and then multiply H by L^T.
-  // Then we can perform nearest neighbor search.
-  arma::mat l = arma::chol(w.t() * w);
-  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
-
-  // Now, we will use the decomposed w and h matrices to estimate what the user
-  // would have rated items as, and then pick the best items.
-
-  // Temporarily store feature vector of queried users.
-  arma::mat query(stretchedH.n_rows, users.n_elem);
-
-  // Select feature vectors of queried users.
-  for (size_t i = 0; i < users.n_elem; i++)
-    query.col(i) = stretchedH.col(users(i));
-
-  // Temporary storage for neighborhood of the queried users.
-  arma::Mat<size_t> neighborhood;
-
-  // Calculate the neighborhood of the queried users.
-  // This should be a templatized option.
-  neighbor::KNN a(stretchedH);
-  arma::mat resultingDistances; // Temporary storage.
-  a.Search(query, numUsersForSimilarity, neighborhood, resultingDistances);
+  // The neighborhoods of the users were computed when the model was trained
+  // (see CalculateNeighborhood()), so no nearest neighbor search is needed.
 
   // Generate recommendations for each query user by finding the maximum numRecs
-  // elements in the averages matrix.
+  // elements in the averages matrix.  Each user is independent of the others,
+  // so the users are processed in parallel, with one averages vector for each
+  // thread.
   recommendations.set_size(numRecs, users.n_elem);
   recommendations.fill(cleanedData.n_rows); // Invalid item number.
   arma::mat values(numRecs, users.n_elem);
   values.fill(-DBL_MAX); // The smallest possible value.
-  for (size_t i = 0; i < users.n_elem; i++)
-  {
-    // First, calculate average of neighborhood values.
-    arma::vec averages;
-    averages.zeros(cleanedData.n_rows);
 
-    for (size_t j = 0; j < neighborhood.n_rows; ++j)
-      averages += w * h.col(neighborhood(j, i));
-    averages /= neighborhood.n_rows;
+  #pragma omp parallel
+  {
+    arma::vec averages(cleanedData.n_rows);
+    arma::vec neighborhoodH(h.n_rows);
 
-    // Look through the averages column corresponding to the current user.
-    for (size_t j = 0; j < averages.n_rows; ++j)
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t i = 0; i < (omp_size_t) users.n_elem; i++)
     {
-      // Ensure that the user hasn't already rated the item.
-      if (cleanedData(j, users(i)) != 0.0)
-        continue; // The user already rated the item.
-
-      // Is the estimated value better than the worst candidate?
-      const double value = averages[j];
-      if (value > values(values.n_rows - 1, i))
+      // First, calculate average of neighborhood values.  The average of the
+      // neighbors' ratings W * h.col(j) is W times the average of their
+      // columns of H.
+      neighborhoodH.zeros();
+      for (size_t j = 0; j < neighborhood.n_rows; ++j)
+        neighborhoodH += h.col(neighborhood(j, users(i)));
+      neighborhoodH /= neighborhood.n_rows;
+      averages = w * neighborhoodH;
+
+      // Ensure that the user hasn't already rated the item: those items can
+      // never be better than the worst candidate.
+      for (size_t k = cleanedData.col_ptrs[users(i)];
+           k < cleanedData.col_ptrs[users(i) + 1]; ++k)
+        averages[cleanedData.row_indices[k]] =
+            -std::numeric_limits<double>::infinity();
+
+      // Look through the averages column corresponding to the current user.
+      for (size_t j = 0; j < averages.n_rows; ++j)
       {
-        // It should be inserted.  Which position?
-        size_t insertPosition = values.n_rows - 1;
-        while (insertPosition > 0)
+        // Is the estimated value better than the worst candidate?
+        const double value = averages[j];
+        if (value > values(values.n_rows - 1, i))
         {
-          if (value <= values(insertPosition - 1, i))
-            break; // The current value is the right one.
-          insertPosition--;
+          // It should be inserted.  Which position?
+          size_t insertPosition = values.n_rows - 1;
+          while (insertPosition > 0)
+          {
+            if (value <= values(insertPosition - 1, i))
+              break; // The current value is the right one.
+            insertPosition--;
+          }
+
+          // Now insert it into the list.
+          InsertNeighbor(i, insertPosition, j, value, recommendations,
+              values);
         }
-
-        // Now insert it into the list.
-        InsertNeighbor(i, insertPosition, j, value, recommendations,
-            values);
       }
     }
+  }
 
-    // If we were not able to come up with enough recommendations, issue a
-    // warning.
-    if (recommendations(values.n_rows - 1, i) == cleanedData.n_rows + 1)
+  // If we were not able to come up with enough recommendations, issue a
+  // warning.
+  for (size_t i = 0; i < users.n_elem; i++)
+    if (recommendations(values.n_rows - 1, i) == cleanedData.n_rows)
       Log::Warn << "Could not provide " << values.n_rows << " recommendations "
           << "for user " << users(i) << " (not enough un-rated items)!"
           << std::endl;
-  }
 }
 
-// Predict the rating for a single user/item combination.
-double CF::Predict(const size_t user, const size_t item) const
+void CF::GetMaxInnerProductRecommendations(const size_t numRecs,
+                                           arma::Mat<size_t>& recommendations)
 {
-  // First, we need to find the nearest neighbors of the given user.
-  // We'll use the same technique as for GetRecommendations().
+  // Generate list of users.
+  arma::Col<size_t> users = arma::linspace<arma::Col<size_t> >(0,
+      cleanedData.n_cols - 1, cleanedData.n_cols);
 
-  // We want to avoid calculating the full rating matrix, so we will do nearest
-  // neighbor search only on the H matrix, using the observation that if the
-  // rating matrix X = W*H, then d(X.col(i), X.col(j)) = d(W H.col(i), W
-  // H.col(j)).  This can be seen as nearest neighbor search on the H matrix
-  // with the Mahalanobis distance where M^{-1} = W^T W.  So, we'll decompose
-  // M^{-1} = L L^T (the Cholesky decomposition), and then multiply H by L^T.
-  // Then we can perform nearest neighbor search.
-  arma::mat l = arma::chol(w.t() * w);
-  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
+  // Call the main overload for recommendations.
+  GetMaxInnerProductRecommendations(numRecs, recommendations, users);
+}
 
-  // Now, we will use the decomposed w and h matrices to estimate what the user
-  // would have rated items as, and then pick the best items.
+void CF::GetMaxInnerProductRecommendations(const size_t numRecs,
+                                           arma::Mat<size_t>& recommendations,
+                                           arma::Col<size_t>& users)
+{
+  if (!itemIndex)
+  {
+    throw std::invalid_argument("CF::GetMaxInnerProductRecommendations(): the "
+        "model has not been trained");
+  }
 
-  // Temporarily store feature vector of queried users.
-  arma::mat query = stretchedH.col(user);
+  // The estimated rating of item j by user i is the average of w.row(j) *
+  // h.col(n) over the users n in the neighborhood of i, which is the inner
+  // product of w.row(j) with the average of those columns of h.  So we build
+  // one query vector for each user.  Items the user has already rated must be
+  // skipped, so we search for enough items to still have numRecs left.
+  arma::mat queries(h.n_rows, users.n_elem);
+  size_t maxRated = 0;
+  for (size_t i = 0; i < users.n_elem; ++i)
+  {
+    queries.col(i).zeros();
+    for (size_t j = 0; j < neighborhood.n_rows; ++j)
+      queries.col(i) += h.col(neighborhood(j, users(i)));
+    queries.col(i) /= neighborhood.n_rows;
 
-  // Temporary storage for neighborhood of the queried users.
-  arma::Mat<size_t> neighborhood;
+    const size_t rated = cleanedData.col_ptrs[users(i) + 1] -
+        cleanedData.col_ptrs[users(i)];
+    maxRated = std::max(maxRated, rated);
+  }
 
-  // Calculate the neighborhood of the queried users.
-  // This should be a templatized option.
-  neighbor::KNN a(stretchedH, false, true /* single-tree mode */);
-  arma::mat resultingDistances; // Temporary storage.
+  const size_t k = std::min(numRecs + maxRated, (size_t) cleanedData.n_rows);
 
-  a.Search(query, numUsersForSimilarity, neighborhood, resultingDistances);
+  // The index of the items was built when W was computed.
+  Timer::Start("cf_fastmks");
+  arma::Mat<size_t> indices;
+  arma::mat products; // Temporary storage.
+  itemIndex->Search(queries, k, indices, products);
+  Timer::Stop("cf_fastmks");
 
+  recommendations.set_size(numRecs, users.n_elem);
+  recommendations.fill(cleanedData.n_rows); // Invalid item number.
+  for (size_t i = 0; i < users.n_elem; ++i)
+  {
+    size_t found = 0;
+    for (size_t j = 0; j < k && found < numRecs; ++j)
+    {
+      // Ensure that the user hasn't already rated the item.
+      if (cleanedData(indices(j, i), users(i)) != 0.0)
+        continue;
+
+      recommendations(found++, i) = indices(j, i);
+    }
+
+    // If we were not able to come up with enough recommendations, issue a
+    // warning.
+    if (found < numRecs)
+      Log::Warn << "Could not provide " << numRecs << " recommendations "
+          << "for user " << users(i) << " (not enough un-rated items)!"
+          << std::endl;
+  }
+}
+
+// Predict the rating for a single user/item combination.
+double CF::Predict(const size_t user, const size_t item) const
+{
+  // The neighborhood of the user was computed when the model was trained.
   double rating = 0; // We'll take the average of neighborhood values.
 
   for (size_t j = 0; j < neighborhood.n_rows; ++j)
-    rating += arma::as_scalar(w.row(item) * h.col(neighborhood(j, 0)));
+    rating += arma::as_scalar(w.row(item) * h.col(neighborhood(j, user)));
   rating /= neighborhood.n_rows;
 
   return rating;
@@ -172,54 +205,13 @@ double CF::Predict(const size_t user, const size_t item) const
 void CF::Predict(const arma::Mat<size_t>& combinations,
                  arma::vec& predictions) const
 {
-  // First, for nearest neighbor search, stretch the H matrix.
-  arma::mat l = arma::chol(w.t() * w);
-  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
-
-  // Now, we must determine those query indices we need to find the nearest
-  // neighbors for.  This is easiest if we just sort the combinations matrix.
-  arma::Mat<size_t> sortedCombinations(combinations.n_rows,
-                                       combinations.n_cols);
-  arma::uvec ordering = arma::sort_index(combinations.row(0).t());
-  for (size_t i = 0; i < ordering.n_elem; ++i)
-    sortedCombinations.col(i) = combinations.col(ordering[i]);
-
-  // Now, we have to get the list of unique users we will be searching for.
-  arma::Col<size_t> users = arma::unique(combinations.row(0).t());
-
-  // Assemble our query matrix from the stretchedH matrix.
-  arma::mat queries(stretchedH.n_rows, users.n_elem);
-  for (size_t i = 0; i < queries.n_cols; ++i)
-    queries.col(i) = stretchedH.col(users[i]);
-
-  // Now calculate the neighborhood of these users.
-  neighbor::KNN a(stretchedH);
-  arma::mat distances;
-  arma::Mat<size_t> neighborhood;
-
-  a.Search(queries, numUsersForSimilarity, neighborhood, distances);
-
-  // Now that we have the neighborhoods we need, calculate the predictions.
+  // The neighborhoods of the users were computed when the model was trained,
+  // so each prediction is just an average over the neighborhood.
   predictions.set_size(combinations.n_cols);
 
-  size_t user = 0; // Cumulative user count, because we are doing it in order.
-  for (size_t i = 0; i < sortedCombinations.n_cols; ++i)
-  {
-    // Could this be made faster by calculating dot products for multiple items
-    // at once?
-    double rating = 0.0;
-
-    // Map the combination's user to the user ID used for kNN.
-    while (users[user] < sortedCombinations(0, i))
-      ++user;
-
-    for (size_t j = 0; j < neighborhood.n_rows; ++j)
-      rating += arma::as_scalar(w.row(sortedCombinations(1, i)) *
-          h.col(neighborhood(j, user)));
-    rating /= neighborhood.n_rows;
-
-    predictions(ordering[i]) = rating;
-  }
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) combinations.n_cols; ++i)
+    predictions[i] = Predict(combinations(0, i), combinations(1, i));
 }
 
 void CF::CleanData(const arma::mat& data, arma::sp_mat& cleanedData)
@@ -247,6 +239,197 @@ void CF::CleanData(const arma::mat& data, arma::sp_mat& cleanedData)
   cleanedData = arma::sp_mat(locations, values, maxItemID, maxUserID);
 }
 
+void CF::CalculateNeighborhood()
+{
+  // We want to avoid calculating the full rating matrix, so we will do nearest
+  // neighbor search only on the H matrix, using the observation that if the
+  // rating matrix X = W*H, then d(X.col(i), X.col(j)) = d(W H.col(i), W
+  // H.col(j)).  This can be seen as nearest neighbor search on the H matrix
+  // with the Mahalanobis distance where M^{-1} = W^T W.  So, we'll decompose
+  // M^{-1} = L L^T (the Cholesky decomposition), and then multiply H by L^T.
+  // Then we can perform nearest neighbor search.
+  arma::mat l = arma::chol(w.t() * w);
+  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
+
+  // Calculate the neighborhood of every user at once.  The users are given as a
+  // separate query set, so that each user is part of its own neighborhood.
+  // A neighborhood can't be larger than the number of users.
+  // This should be a templatized option.
+  const size_t k = std::min(numUsersForSimilarity, (size_t) h.n_cols);
+  if (k < numUsersForSimilarity)
+  {
+    Log::Warn << "CF: there are only " << h.n_cols << " users, so the "
+        << "neighborhoods have " << k << " users instead of "
+        << numUsersForSimilarity << "." << std::endl;
+  }
+
+  Timer::Start("cf_neighborhood");
+  neighbor::KNN a(stretchedH);
+  arma::mat resultingDistances; // Temporary storage.
+  a.Search(stretchedH, k, neighborhood, resultingDistances);
+  Timer::Stop("cf_neighborhood");
+}
+
+void CF::BuildItemIndex()
+{
+  if (w.is_empty())
+  {
+    itemIndex.reset();
+    return;
+  }
+
+  // Each item is a column of the reference set, which the index owns.
+  Timer::Start("cf_fastmks_index");
+  std::shared_ptr<const arma::mat> items(new arma::mat(trans(w)));
+  itemIndex.reset(new fastmks::FastMKS<kernel::LinearKernel>(items));
+  Timer::Stop("cf_fastmks_index");
+}
+
+void CF::AddRatings(const arma::mat& ratings,
+                    const double lambda,
+                    const size_t sgdIterations,
+                    const double stepSize)
+{
+  if (ratings.n_rows != 3)
+  {
+    std::ostringstream oss;
+    oss << "CF::AddRatings(): ratings must have 3 rows (user, item, rating), "
+        << "but " << ratings.n_rows << " were given!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (ratings.n_cols == 0)
+    return;
+
+  // Collect the new ratings, in the same (item, user) form as cleanedData.
+  size_t numUsers = cleanedData.n_cols;
+  arma::umat locations(2, ratings.n_cols);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    locations(0, i) = (arma::uword) ratings(1, i);
+    locations(1, i) = (arma::uword) ratings(0, i);
+
+    if (locations(0, i) >= cleanedData.n_rows)
+    {
+      std::ostringstream oss;
+      oss << "CF::AddRatings(): item " << locations(0, i) << " is not known "
+          << "to the model (there are " << cleanedData.n_rows << " items)!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    numUsers = std::max(numUsers, (size_t) locations(1, i) + 1);
+  }
+
+  // A (user, item) pair may be rated more than once in the batch; as for a
+  // pair the model already has, the last rating replaces the others.
+  std::vector<size_t> order(ratings.n_cols);
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+      [&locations](const size_t a, const size_t b)
+      {
+        return (locations(1, a) < locations(1, b)) ||
+            (locations(1, a) == locations(1, b) &&
+             locations(0, a) < locations(0, b));
+      });
+
+  arma::umat uniqueLocations(2, ratings.n_cols);
+  arma::vec uniqueValues(ratings.n_cols);
+  size_t numUnique = 0;
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    if (i + 1 < order.size() &&
+        locations(0, order[i]) == locations(0, order[i + 1]) &&
+        locations(1, order[i]) == locations(1, order[i + 1]))
+      continue;
+
+    uniqueLocations.col(numUnique) = locations.col(order[i]);
+    uniqueValues[numUnique++] = ratings(2, order[i]);
+  }
+  const arma::sp_mat newRatings(uniqueLocations.cols(0, numUnique - 1),
+      uniqueValues.subvec(0, numUnique - 1), cleanedData.n_rows, numUsers);
+
+  // Merge the old ratings which are not replaced with the new ones.
+  arma::umat mergedLocations(2, cleanedData.n_nonzero + newRatings.n_nonzero);
+  arma::vec mergedValues(cleanedData.n_nonzero + newRatings.n_nonzero);
+  size_t n = 0;
+  for (arma::sp_mat::const_iterator it = cleanedData.begin();
+       it != cleanedData.end(); ++it)
+  {
+    if (newRatings(it.row(), it.col()) != 0.0)
+      continue;
+
+    mergedLocations(0, n) = it.row();
+    mergedLocations(1, n) = it.col();
+    mergedValues[n++] = *it;
+  }
+  for (arma::sp_mat::const_iterator it = newRatings.begin();
+       it != newRatings.end(); ++it)
+  {
+    mergedLocations(0, n) = it.row();
+    mergedLocations(1, n) = it.col();
+    mergedValues[n++] = *it;
+  }
+  cleanedData = arma::sp_mat(mergedLocations.cols(0, n - 1),
+      mergedValues.subvec(0, n - 1), cleanedData.n_rows, numUsers);
+
+  // The users with new ratings are the nonempty columns of newRatings.
+  std::vector<size_t> users;
+  for (size_t u = 0; u < newRatings.n_cols; ++u)
+    if (newRatings.col_ptrs[u + 1] > newRatings.col_ptrs[u])
+      users.push_back(u);
+
+  // Fold in each of those users by solving the regularized least-squares
+  // problem min ||r - W_I h||^2 + lambda ||h||^2 over the items I the user has
+  // rated.
+  h.resize(h.n_rows, numUsers);
+  const arma::mat regularization = lambda * arma::eye<arma::mat>(h.n_rows,
+      h.n_rows);
+  for (size_t i = 0; i < users.size(); ++i)
+  {
+    const size_t u = users[i];
+    const size_t begin = cleanedData.col_ptrs[u];
+    const size_t end = cleanedData.col_ptrs[u + 1];
+
+    arma::mat wRated(end - begin, w.n_cols);
+    arma::vec rated(end - begin);
+    for (size_t k = begin; k < end; ++k)
+    {
+      wRated.row(k - begin) = w.row(cleanedData.row_indices[k]);
+      rated[k - begin] = cleanedData.values[k];
+    }
+
+    h.col(u) = arma::solve(wRated.t() * wRated + regularization,
+        wRated.t() * rated);
+  }
+
+  // Refine the factors of those users and of the items they rated with SGD.
+  for (size_t iteration = 0; iteration < sgdIterations; ++iteration)
+  {
+    for (size_t i = 0; i < users.size(); ++i)
+    {
+      const size_t u = users[i];
+      for (size_t k = cleanedData.col_ptrs[u]; k < cleanedData.col_ptrs[u + 1];
+          ++k)
+      {
+        const size_t item = cleanedData.row_indices[k];
+        const double error = cleanedData.values[k] -
+            arma::as_scalar(w.row(item) * h.col(u));
+
+        const arma::rowvec oldW = w.row(item);
+        w.row(item) += stepSize * (error * h.col(u).t() - lambda * oldW);
+        h.col(u) += stepSize * (error * oldW.t() - lambda * h.col(u));
+      }
+    }
+  }
+
+  // New users may be in the neighborhoods of existing users, so all the
+  // neighborhoods are computed again, and the items have changed, so their
+  // index is built again.
+  CalculateNeighborhood();
+  BuildItemIndex();
+}
+
 /**
  * Helper function to insert a point into the recommendation matrices.
  *
@@ -13,6 +13,8 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_als.hpp>
 #include <mlpack/methods/amf/termination_policies/simple_residue_termination.hpp>
@@ -157,6 +159,33 @@ class CF
                  FactorizerTraits<FactorizerType>::UsesCoordinateList>::type*
                  = 0);
 
+  /**
+   * Add new ratings to the trained model without factorizing the data again.
+   * The ratings are given as a coordinate list, like the data given to
+   * Train(); they may be for new users (whose indices are past the last known
+   * user) or for existing users, and a new rating for an item a user has
+   * already rated replaces the old one (if a pair is rated several times in
+   * the batch, the last rating is kept).  The items must already be known to
+   * the model; a std::invalid_argument is thrown otherwise.
+   *
+   * The factors of the items (W) are kept fixed, and the factors of each user
+   * with new ratings (the columns of H) are set to the solution of the
+   * regularized least-squares problem over all of the user's ratings (fold-in).
+   * Optionally, a few sweeps of SGD over those users' ratings can then refine
+   * both their factors and the factors of the items they rated.  Finally, the
+   * neighborhoods of all users are computed again.
+   *
+   * @param ratings Coordinate list of (user, item, rating) columns.
+   * @param lambda Regularization parameter for the least-squares fold-in and
+   *     the SGD sweeps.
+   * @param sgdIterations Number of SGD sweeps over the new users' ratings.
+   * @param stepSize Step size of the SGD sweeps.
+   */
+  void AddRatings(const arma::mat& ratings,
+                  const double lambda = 0.01,
+                  const size_t sgdIterations = 0,
+                  const double stepSize = 0.001);
+
   //! Sets number of users for calculating similarity.
   void NumUsersForSimilarity(const size_t num)
   {
@@ -167,6 +196,11 @@ class CF
       return;
     }
     this->numUsersForSimilarity = num;
+
+    // The cached neighborhoods are for the old size, so compute them again if
+    // the model has been trained.
+    if (!h.is_empty())
+      CalculateNeighborhood();
   }
 
   //! Gets number of users for calculating similarity.
@@ -193,6 +227,12 @@ class CF
   const arma::mat& H() const { return h; }
   //! Get the cleaned data matrix.
   const arma::sp_mat& CleanedData() const { return cleanedData; }
+  /**
+   * Get the neighborhood of each user: column i holds the indices of the
+   * NumUsersForSimilarity() users closest to user i (including user i itself),
+   * as computed when the model was trained.
+   */
+  const arma::Mat<size_t>& Neighborhood() const { return neighborhood; }
 
   /**
    * Generates the given number of recommendations for all users.
@@ -214,6 +254,35 @@ class CF
                           arma::Mat<size_t>& recommendations,
                           arma::Col<size_t>& users);
 
+  /**
+   * Generates the given number of recommendations for all users, using fast
+   * max-kernel search over the item factors.  See the other overload of
+   * GetMaxInnerProductRecommendations() for details.
+   *
+   * @param numRecs Number of Recommendations
+   * @param recommendations Matrix to save recommendations into.
+   */
+  void GetMaxInnerProductRecommendations(const size_t numRecs,
+                                         arma::Mat<size_t>& recommendations);
+
+  /**
+   * Generates the given number of recommendations for the specified users,
+   * using fast max-kernel search over the item factors.  The estimated rating
+   * of an item by a user is the inner product of the item's row of W with the
+   * average of the columns of H of the user's neighborhood, so the best items
+   * for every user are found with one FastMKS search (with the linear kernel)
+   * of a tree built on the items when the model was trained.  The recommendations are the same as those
+   * given by GetRecommendations(), but the estimated ratings of all the items
+   * are never computed, which is much faster when there are many items.
+   *
+   * @param numRecs Number of Recommendations
+   * @param recommendations Matrix to save recommendations
+   * @param users Users for which recommendations are to be generated
+   */
+  void GetMaxInnerProductRecommendations(const size_t numRecs,
+                                         arma::Mat<size_t>& recommendations,
+                                         arma::Col<size_t>& users);
+
   //! Converts the User, Item, Value Matrix to User-Item Table
   static void CleanData(const arma::mat& data, arma::sp_mat& cleanedData);
 
@@ -257,6 +326,27 @@ class CF
   arma::mat h;
   //! Cleaned data matrix.
   arma::sp_mat cleanedData;
+  //! Neighborhood of each user (one column per user).
+  arma::Mat<size_t> neighborhood;
+  //! FastMKS index of the items (the rows of W), for
+  //! GetMaxInnerProductRecommendations().  It is never modified once built, so
+  //! copies of the model share it.
+  std::shared_ptr<fastmks::FastMKS<kernel::LinearKernel>> itemIndex;
+
+  /**
+   * Compute the neighborhood of every user, with one nearest neighbor search
+   * over all the users, and store it in the neighborhood member.  This is done
+   * once after the model is trained, so that GetRecommendations() and
+   * Predict() don't have to build a tree every time they are called.
+   */
+  void CalculateNeighborhood();
+
+  /**
+   * Build the FastMKS index of the items (the rows of W) and store it in the
+   * itemIndex member.  This is done whenever W changes, so that
+   * GetMaxInnerProductRecommendations() only has to search it.
+   */
+  void BuildItemIndex();
 
   /**
    * Helper function to insert a point into the recommendation matrices.
@@ -279,6 +369,9 @@ class CF
 } // namespace cf
 } // namespace mlpack
 
+//! Set the serialization version of the CF class.
+BOOST_TEMPLATE_CLASS_VERSION(template<>, mlpack::cf::CF, 1);
+
 // Include implementation of templated functions.
 #include "cf_impl.hpp"
 
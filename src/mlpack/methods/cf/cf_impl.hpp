@@ -118,6 +118,9 @@ void CF::Train(const arma::mat& data, FactorizerType factorizer)
   Timer::Start("cf_factorization");
   ApplyFactorizer(factorizer, data, cleanedData, this->rank, w, h);
   Timer::Stop("cf_factorization");
+
+  CalculateNeighborhood();
+  BuildItemIndex();
 }
 
 template<typename FactorizerType>
@@ -146,11 +149,14 @@ void CF::Train(const arma::sp_mat& data,
   Timer::Start("cf_factorization");
   factorizer.Apply(cleanedData, this->rank, w, h);
   Timer::Stop("cf_factorization");
+
+  CalculateNeighborhood();
+  BuildItemIndex();
 }
 
 //! Serialize the model.
 template<typename Archive>
-void CF::Serialize(Archive& ar, const unsigned int /* version */)
+void CF::Serialize(Archive& ar, const unsigned int version)
 {
   // This model is simple; just serialize all the members.  No special handling
   // required.
@@ -161,6 +167,18 @@ void CF::Serialize(Archive& ar, const unsigned int /* version */)
   ar & CreateNVP(w, "w");
   ar & CreateNVP(h, "h");
   ar & CreateNVP(cleanedData, "cleanedData");
+
+  // Models before version 1 didn't store the neighborhoods of the users, so
+  // they are computed when such a model is loaded.
+  if (version >= 1)
+    ar & CreateNVP(neighborhood, "neighborhood");
+  else if (Archive::is_loading::value && !h.is_empty())
+    CalculateNeighborhood();
+
+  // The FastMKS index of the items is not serialized; it is built again from
+  // W.
+  if (Archive::is_loading::value)
+    BuildItemIndex();
 }
 
 } // namespace mlpack
@@ -46,11 +46,15 @@ PROGRAM_INFO("Collaborating Filtering", "This program performs collaborative "
     "algorithms can be specified via the --algorithm (-a) parameter: "
     "\n"
     "'RegSVD' -- Regularized SVD using a SGD optimizer\n"
+    "'RegSVDParallel' -- Regularized SVD using a lock-free parallel SGD "
+    "optimizer\n"
     "'NMF' -- Non-negative matrix factorization with alternating least squares "
     "update rules\n"
     "'BatchSVD' -- SVD batch learning\n"
     "'SVDIncompleteIncremental' -- SVD incomplete incremental learning\n"
     "'SVDCompleteIncremental' -- SVD complete incremental learning\n"
+    "'SVDParallelIncremental' -- SVD complete incremental learning, run in "
+    "parallel on blocks of the data\n"
     "\n"
     "A trained model may be saved to a file with the --output_model_file (-M) "
     "parameter.");
@@ -86,6 +90,9 @@ PARAM_FLAG("all_user_recommendations", "Generate recommendations for all "
 PARAM_STRING("output_file","File to save output recommendations to.", "o", "");
 PARAM_INT("recommendations", "Number of recommendations to generate for each "
     "query user.", "c", 5);
+PARAM_FLAG("fastmks", "Generate recommendations with fast max-kernel search on "
+    "the item factors, instead of computing the estimated rating of every "
+    "item.", "F");
 
 PARAM_INT("seed", "Set the random seed (0 uses std::time(NULL)).", "s", 0);
 
@@ -105,12 +112,18 @@ void ComputeRecommendations(CF& cf,
 
     Log::Info << "Generating recommendations for " << users.n_elem << " users "
         << "in '" << queryFile << "'." << endl;
-    cf.GetRecommendations(numRecs, recommendations, users);
+    if (CLI::HasParam("fastmks"))
+      cf.GetMaxInnerProductRecommendations(numRecs, recommendations, users);
+    else
+      cf.GetRecommendations(numRecs, recommendations, users);
   }
   else
   {
     Log::Info << "Generating recommendations for all users." << endl;
-    cf.GetRecommendations(numRecs, recommendations);
+    if (CLI::HasParam("fastmks"))
+      cf.GetMaxInnerProductRecommendations(numRecs, recommendations);
+    else
+      cf.GetRecommendations(numRecs, recommendations);
   }
 }
 
@@ -212,10 +225,16 @@ void AssembleFactorizerType(const std::string& algorithm,
           SVDCompleteIncrementalLearning<arma::sp_mat>> FactorizerType;
       PerformAction(FactorizerType(mit), dataset, rank);
     }
-    else if (algorithm == "RegSVD")
+    else if (algorithm == "SVDParallelIncremental")
+    {
+      typedef AMF<MaxIterationTermination, RandomInitialization,
+          SVDParallelIncrementalLearning> FactorizerType;
+      PerformAction(FactorizerType(mit), dataset, rank);
+    }
+    else if (algorithm == "RegSVD" || algorithm == "RegSVDParallel")
     {
-      Log::Fatal << "--iteration_only_termination not supported with 'RegSVD' "
-          << "algorithm!" << endl;
+      Log::Fatal << "--iteration_only_termination not supported with '"
+          << algorithm << "' algorithm!" << endl;
     }
   }
   else
@@ -233,8 +252,13 @@ void AssembleFactorizerType(const std::string& algorithm,
           rank);
     else if (algorithm == "SVDCompleteIncremental")
       PerformAction(SparseSVDCompleteIncrementalFactorizer(srt), dataset, rank);
+    else if (algorithm == "SVDParallelIncremental")
+      PerformAction(SVDParallelIncrementalFactorizer(srt), dataset, rank);
     else if (algorithm == "RegSVD")
       PerformAction(RegularizedSVD<>(maxIterations), dataset, rank);
+    else if (algorithm == "RegSVDParallel")
+      PerformAction(RegularizedSVD<optimization::ParallelSGD>(maxIterations),
+          dataset, rank);
   }
 }
 
@@ -286,10 +310,13 @@ int main(int argc, char** argv)
         algo != "SVDBatch" &&
         algo != "SVDIncompleteIncremental" &&
         algo != "SVDCompleteIncremental" &&
-        algo != "RegSVD")
+        algo != "SVDParallelIncremental" &&
+        algo != "RegSVD" &&
+        algo != "RegSVDParallel")
       Log::Fatal << "Invalid decomposition algorithm.  Choices are 'NMF', "
           << "'SVDBatch', 'SVDIncompleteIncremental', 'SVDCompleteIncremental',"
-          << " and 'RegSVD'." << endl;
+          << " 'SVDParallelIncremental', 'RegSVD', and 'RegSVDParallel'."
+          << endl;
 
     // Issue a warning if the user provided a minimum residue but it will be
     // ignored.
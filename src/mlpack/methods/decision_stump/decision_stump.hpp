@@ -59,6 +59,26 @@ class DecisionStump
                 const arma::Row<size_t>& labels,
                 const arma::rowvec& weights);
 
+  /**
+   * Alternate constructor like the one above, but which uses the given
+   * presorted indices of the data instead of sorting it.  Since the data does
+   * not change between boosting rounds (only the weights do), the data can be
+   * sorted once and given to the stump of each round.
+   *
+   * @param other The other initiated Decision Stump object from
+   *      which we copy the values.
+   * @param data The data on which to train this object on.
+   * @param sortedIndices The indices of the points, sorted along each
+   *      dimension, as given by math::Presort(data, sortedIndices).
+   * @param labels The labels of data.
+   * @param weights Weight vector to use while training. For boosting purposes.
+   */
+  DecisionStump(const DecisionStump<>& other,
+                const MatType& data,
+                const arma::Mat<size_t>& sortedIndices,
+                const arma::Row<size_t>& labels,
+                const arma::rowvec& weights);
+
   /**
    * Create a decision stump without training.  This stump will not be useful
    * and will always return a class of 0 for anything that is to be classified,
@@ -127,12 +147,13 @@ class DecisionStump
    * Sets up dimension as if it were splitting on it and finds entropy when
    * splitting on dimension.
    *
-   * @param dimension A row from the training data, which might be a
-   *     candidate for the splitting dimension.
+   * @param sortedIndexDim The indices of the points, sorted (stably) along a
+   *     dimension which might be a candidate for the splitting dimension (see
+   *     math::Presort()).
    * @tparam UseWeights Whether we need to run a weighted Decision Stump.
    */
   template<bool UseWeights>
-  double SetupSplitDimension(const arma::rowvec& dimension,
+  double SetupSplitDimension(const arma::Col<size_t>& sortedIndexDim,
                              const arma::Row<size_t>& labels,
                              const arma::rowvec& weightD);
 
@@ -142,9 +163,12 @@ class DecisionStump
    *
    * @tparam dimension dimension is the dimension decided by the constructor
    *      on which we now train the decision stump.
+   * @param sortedSplitIndexDim The indices of the points, sorted (stably)
+   *      along the dimension.
    */
   template<typename VecType>
   void TrainOnDim(const VecType& dimension,
+                  const arma::Col<size_t>& sortedSplitIndexDim,
                   const arma::Row<size_t>& labels);
 
   /**
@@ -196,6 +220,24 @@ class DecisionStump
   void Train(const MatType& data,
              const arma::Row<size_t>& labels,
              const arma::rowvec& weights);
+
+  /**
+   * Train the decision stump on the given data and labels, using the given
+   * presorted indices of the data.  The dimensions are evaluated in parallel.
+   *
+   * @param data Dataset to train on.
+   * @param sortedIndices The indices of the points, sorted along each
+   *      dimension (see math::Presort()).
+   * @param labels Labels for dataset.
+   * @param weights Weights for this set of labels.
+   * @tparam UseWeights If true, the weights in the weight vector will be used
+   *      (otherwise they are ignored).
+   */
+  template<bool UseWeights>
+  void Train(const MatType& data,
+             const arma::Mat<size_t>& sortedIndices,
+             const arma::Row<size_t>& labels,
+             const arma::rowvec& weights);
 };
 
 } // namespace decision_stump
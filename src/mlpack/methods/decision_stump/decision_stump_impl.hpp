@@ -78,23 +78,52 @@ template<bool UseWeights>
 void DecisionStump<MatType>::Train(const MatType& data,
                                    const arma::Row<size_t>& labels,
                                    const arma::rowvec& weights)
+{
+  // Sort every dimension once; the sorted indices are used both to evaluate
+  // each dimension and to train on the best one.
+  arma::Mat<size_t> sortedIndices;
+  math::Presort(data, sortedIndices);
+
+  Train<UseWeights>(data, sortedIndices, labels, weights);
+}
+
+/**
+ * Train the decision stump on the given data and labels, using the presorted
+ * indices of the data.
+ */
+template<typename MatType>
+template<bool UseWeights>
+void DecisionStump<MatType>::Train(const MatType& data,
+                                   const arma::Mat<size_t>& sortedIndices,
+                                   const arma::Row<size_t>& labels,
+                                   const arma::rowvec& weights)
 {
   // If classLabels are not all identical, proceed with training.
   size_t bestDim = 0;
-  double entropy;
   const double rootEntropy = CalculateEntropy<UseWeights>(labels, weights);
 
+  // For each dimension with non-identical values, treat it as a potential
+  // splitting dimension and calculate entropy if split on it.  The dimensions
+  // are independent, so they are evaluated in parallel.
+  arma::vec entropies(data.n_rows);
+  std::vector<char> distinct(data.n_rows);
+  ThreadPool::ParallelFor(0, data.n_rows, [&](const size_t i)
+  {
+    distinct[i] = IsDistinct(data.row(i));
+    if (distinct[i])
+    {
+      entropies[i] = SetupSplitDimension<UseWeights>(
+          sortedIndices.unsafe_col(i), labels, weights);
+    }
+  });
+
   double gain, bestGain = 0.0;
   for (size_t i = 0; i < data.n_rows; i++)
   {
     // Go through each dimension of the data.
-    if (IsDistinct(data.row(i)))
+    if (distinct[i])
     {
-      // For each dimension with non-identical values, treat it as a potential
-      // splitting dimension and calculate entropy if split on it.
-      entropy = SetupSplitDimension<UseWeights>(data.row(i), labels, weights);
-
-      gain = rootEntropy - entropy;
+      gain = rootEntropy - entropies[i];
       // Find the dimension with the best entropy so that the gain is
       // maximized.
 
@@ -110,7 +139,8 @@ void DecisionStump<MatType>::Train(const MatType& data,
   splitDimension = bestDim;
 
   // Once the splitting column/dimension has been decided, train on it.
-  TrainOnDim(data.row(splitDimension), labels);
+  TrainOnDim(data.row(splitDimension), sortedIndices.unsafe_col(splitDimension),
+      labels);
 }
 
 /**
@@ -169,6 +199,23 @@ DecisionStump<MatType>::DecisionStump(const DecisionStump<>& other,
   Train<true>(data, labels, weights);
 }
 
+/**
+ * Alternate constructor which copies parameters bucketSize and numClasses
+ * from an already initiated decision stump, other, and trains with the given
+ * presorted indices of the data.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const DecisionStump<>& other,
+                                      const MatType& data,
+                                      const arma::Mat<size_t>& sortedIndices,
+                                      const arma::Row<size_t>& labels,
+                                      const arma::rowvec& weights) :
+    classes(other.classes),
+    bucketSize(other.bucketSize)
+{
+  Train<true>(data, sortedIndices, labels, weights);
+}
+
 /**
  * Serialize the decision stump.
  */
@@ -192,31 +239,25 @@ void DecisionStump<MatType>::Serialize(Archive& ar,
  * Sets up dimension as if it were splitting on it and finds entropy when
  * splitting on dimension.
  *
- * @param dimension A row from the training data, which might be a candidate for
- *      the splitting dimension.
+ * @param sortedIndexDim The indices of the points, sorted (stably) along a
+ *      dimension which might be a candidate for the splitting dimension.
  * @param UseWeights Whether we need to run a weighted Decision Stump.
  */
 template<typename MatType>
 template<bool UseWeights>
 double DecisionStump<MatType>::SetupSplitDimension(
-    const arma::rowvec& dimension,
+    const arma::Col<size_t>& sortedIndexDim,
     const arma::Row<size_t>& labels,
     const arma::rowvec& weights)
 {
   size_t i, count, begin, end;
   double entropy = 0.0;
 
-  // Sort the dimension in order to calculate splitting ranges.
-  arma::rowvec sortedDim = arma::sort(dimension);
-
-  // Store the indices of the sorted dimension to build a vector of sorted
-  // labels.  This sort is stable.
-  arma::uvec sortedIndexDim = arma::stable_sort_index(dimension.t());
-
-  arma::Row<size_t> sortedLabels(dimension.n_elem);
-  arma::rowvec sortedWeights(dimension.n_elem);
+  // Build a vector of sorted labels with the sorted indices of the dimension.
+  arma::Row<size_t> sortedLabels(sortedIndexDim.n_elem);
+  arma::rowvec sortedWeights(sortedIndexDim.n_elem);
 
-  for (i = 0; i < dimension.n_elem; i++)
+  for (i = 0; i < sortedIndexDim.n_elem; i++)
   {
     sortedLabels(i) = labels(sortedIndexDim(i));
 
@@ -288,21 +329,26 @@ double DecisionStump<MatType>::SetupSplitDimension(
  *
  * @param dimension Dimension is the dimension decided by the constructor on
  *      which we now train the decision stump.
+ * @param sortedSplitIndexDim The indices of the points, sorted (stably) along
+ *      the dimension.
  */
 template<typename MatType>
 template<typename VecType>
-void DecisionStump<MatType>::TrainOnDim(const VecType& dimension,
-                                        const arma::Row<size_t>& labels)
+void DecisionStump<MatType>::TrainOnDim(
+    const VecType& dimension,
+    const arma::Col<size_t>& sortedSplitIndexDim,
+    const arma::Row<size_t>& labels)
 {
   size_t i, count, begin, end;
 
-  arma::rowvec sortedSplitDim = arma::sort(dimension);
-  arma::uvec sortedSplitIndexDim = arma::stable_sort_index(dimension.t());
+  arma::rowvec sortedSplitDim(dimension.n_elem);
   arma::Row<size_t> sortedLabels(dimension.n_elem);
-  sortedLabels.fill(0);
 
   for (i = 0; i < dimension.n_elem; i++)
+  {
+    sortedSplitDim(i) = dimension(sortedSplitIndexDim(i));
     sortedLabels(i) = labels(sortedSplitIndexDim(i));
+  }
 
   arma::rowvec subCols;
   double mostFreq;
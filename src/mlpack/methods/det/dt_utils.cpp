@@ -170,7 +170,6 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   Log::Info << prunedSequence.size() << " trees in the sequence; maximum alpha:"
       << " " << oldAlpha << "." << std::endl;
 
-  arma::mat cvData(dataset);
   size_t testSize = dataset.n_cols / folds;
 
   arma::vec regularizationConstants(prunedSequence.size());
@@ -182,34 +181,30 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   // implementation.
 #ifdef _WIN32
   #pragma omp parallel for default(none) \
-      shared(testSize, cvData, prunedSequence, regularizationConstants, dataset)
+      shared(testSize, prunedSequence, regularizationConstants, dataset)
   for (intmax_t fold = 0; fold < (intmax_t) folds; fold++)
 #else
   #pragma omp parallel for default(none) \
-      shared(testSize, cvData, prunedSequence, regularizationConstants, dataset)
+      shared(testSize, prunedSequence, regularizationConstants, dataset)
   for (size_t fold = 0; fold < folds; fold++)
 #endif
   {
-    // Break up data into train and test sets.
+    // Break up data into train and test sets.  The test set is a view of the
+    // dataset; only the training set is copied, because growing the tree
+    // reorders it.
     size_t start = fold * testSize;
-    size_t end = std::min((size_t) (fold + 1) * testSize, (size_t) cvData.n_cols);
-
-    arma::mat test = cvData.cols(start, end - 1);
-    arma::mat train(cvData.n_rows, cvData.n_cols - test.n_cols);
-
-    if (start == 0 && end < cvData.n_cols)
-    {
-      train.cols(0, train.n_cols - 1) = cvData.cols(end, cvData.n_cols - 1);
-    }
-    else if (start > 0 && end == cvData.n_cols)
-    {
-      train.cols(0, train.n_cols - 1) = cvData.cols(0, start - 1);
-    }
-    else
-    {
-      train.cols(0, start - 1) = cvData.cols(0, start - 1);
-      train.cols(start, train.n_cols - 1) = cvData.cols(end, cvData.n_cols - 1);
-    }
+    size_t end = std::min((size_t) (fold + 1) * testSize,
+        (size_t) dataset.n_cols);
+
+    const arma::mat test(dataset.colptr(start), dataset.n_rows, end - start,
+        false, true);
+    arma::mat train(dataset.n_rows, dataset.n_cols - test.n_cols);
+
+    if (start > 0)
+      train.cols(0, start - 1) = dataset.cols(0, start - 1);
+    if (end < dataset.n_cols)
+      train.cols(start, train.n_cols - 1) = dataset.cols(end,
+          dataset.n_cols - 1);
 
     // Initialize the tree.
     DTree cvDTree(train);
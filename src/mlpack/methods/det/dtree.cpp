@@ -167,7 +167,9 @@ bool DTree::FindSplit(const arma::mat& data,
                       double& splitValue,
                       double& leftError,
                       double& rightError,
-                      const size_t minLeafSize) const
+                      const size_t minLeafSize,
+                      const arma::mat* values,
+                      const arma::Mat<size_t>* sortedIndices) const
 {
   // Ensure the dimensionality of the data is the same as the dimensionality of
   // the bounding rectangle.
@@ -176,11 +178,15 @@ bool DTree::FindSplit(const arma::mat& data,
 
   const size_t points = end - start;
 
-  double minError = logNegError;
-  bool splitFound = false;
+  // The best split of each dimension is found independently (and in parallel,
+  // for large nodes); a dimension with no split keeps an error of -DBL_MAX.
+  arma::vec dimErrors(maxVals.n_elem);
+  dimErrors.fill(-DBL_MAX);
+  arma::vec dimSplitValues(maxVals.n_elem);
+  arma::vec dimLeftErrors(maxVals.n_elem);
+  arma::vec dimRightErrors(maxVals.n_elem);
 
-  // Loop through each dimension.
-  for (size_t dim = 0; dim < maxVals.n_elem; dim++)
+  auto findDimSplit = [&](const size_t dim)
   {
     // Have to deal with REAL, INTEGER, NOMINAL data differently, so we have to
     // think of how to do that...
@@ -189,7 +195,7 @@ bool DTree::FindSplit(const arma::mat& data,
 
     // If there is nothing to split in this dimension, move on.
     if (max - min == 0.0)
-      continue; // Skip to next dimension.
+      return; // Skip to next dimension.
 
     // Initializing all the stuff for this dimension.
     bool dimSplitFound = false;
@@ -202,11 +208,20 @@ bool DTree::FindSplit(const arma::mat& data,
     // Find the log volume of all the other dimensions.
     double volumeWithoutDim = logVolume - std::log(max - min);
 
-    // Get the values for the dimension.
-    arma::rowvec dimVec = data.row(dim).subvec(start, end - 1);
-
-    // Sort the values in ascending order.
-    dimVec = arma::sort(dimVec);
+    // Get the values for the dimension, in ascending order.  With presorted
+    // indices, they are already in order.
+    arma::rowvec dimVec;
+    if (sortedIndices)
+    {
+      dimVec.set_size(points);
+      const size_t* indices = sortedIndices->colptr(dim) + start;
+      for (size_t i = 0; i < points; ++i)
+        dimVec[i] = (*values)(dim, indices[i]);
+    }
+    else
+    {
+      dimVec = arma::sort(data.row(dim).subvec(start, end - 1));
+    }
 
     // Find the best split for this dimension.  We need to figure out why
     // there are spikes if this minLeafSize is enforced here...
@@ -248,20 +263,56 @@ bool DTree::FindSplit(const arma::mat& data,
       }
     }
 
-    double actualMinDimError = std::log(minDimError)
+    if (!dimSplitFound)
+      return;
+
+    // Calculate actual error (in logspace) by adding terms back to our
+    // estimate.
+    dimErrors[dim] = std::log(minDimError)
         - 2 * std::log((double) data.n_cols) - volumeWithoutDim;
+    dimSplitValues[dim] = dimSplitValue;
+    dimLeftErrors[dim] = std::log(dimLeftError)
+        - 2 * std::log((double) data.n_cols) - volumeWithoutDim;
+    dimRightErrors[dim] = std::log(dimRightError)
+        - 2 * std::log((double) data.n_cols) - volumeWithoutDim;
+  };
+
+  // Each task sorts about ParallelWork() values.
+  const size_t dimsPerTask = std::max((size_t) 1,
+      ParallelWork() / std::max(points, (size_t) 1));
+  if (dimsPerTask >= maxVals.n_elem)
+  {
+    for (size_t dim = 0; dim < maxVals.n_elem; ++dim)
+      findDimSplit(dim);
+  }
+  else
+  {
+    for (size_t first = 0; first < maxVals.n_elem; first += dimsPerTask)
+    {
+      const size_t last = std::min(first + dimsPerTask,
+          (size_t) maxVals.n_elem);
+      ThreadPool::Spawn([first, last, &findDimSplit]()
+      {
+        for (size_t dim = first; dim < last; ++dim)
+          findDimSplit(dim);
+      });
+    }
+    ThreadPool::Wait();
+  }
 
-    if ((actualMinDimError > minError) && dimSplitFound)
+  // Take the best dimension (the first one, in case of ties, as a serial search
+  // would).
+  double minError = logNegError;
+  bool splitFound = false;
+  for (size_t dim = 0; dim < maxVals.n_elem; ++dim)
+  {
+    if (dimErrors[dim] > minError)
     {
-      // Calculate actual error (in logspace) by adding terms back to our
-      // estimate.
-      minError = actualMinDimError;
+      minError = dimErrors[dim];
       splitDim = dim;
-      splitValue = dimSplitValue;
-      leftError = std::log(dimLeftError) - 2 * std::log((double) data.n_cols)
-          - volumeWithoutDim;
-      rightError = std::log(dimRightError) - 2 * std::log((double) data.n_cols)
-          - volumeWithoutDim;
+      splitValue = dimSplitValues[dim];
+      leftError = dimLeftErrors[dim];
+      rightError = dimRightErrors[dim];
       splitFound = true;
     } // end if better split found in this dimension.
   }
@@ -308,6 +359,39 @@ double DTree::Grow(arma::mat& data,
                    const bool useVolReg,
                    const size_t maxLeafSize,
                    const size_t minLeafSize)
+{
+  // Sort the points along each dimension once; the sorted indices are then
+  // partitioned between the children of each node, so that nodes don't sort
+  // their points again.  The points are identified by their index before
+  // growing, and their values are taken from a copy of the data, since the
+  // data is reordered as the tree grows.
+  const arma::mat values(data);
+  arma::Mat<size_t> nodeIndices;
+  math::Presort(values.cols(start, end - 1), nodeIndices);
+  arma::Mat<size_t> sortedIndices(data.n_cols, data.n_rows);
+  sortedIndices.rows(start, end - 1) = nodeIndices + start;
+  std::vector<char> goesLeft(data.n_cols);
+
+  // The subtrees (and the split search of large nodes) are run as tasks of the
+  // thread pool.
+  double alpha = 0.0;
+  ThreadPool::Run([&]()
+  {
+    alpha = GrowSubtree(data, oldFromNew, values, sortedIndices, goesLeft,
+        useVolReg, maxLeafSize, minLeafSize);
+  });
+
+  return alpha;
+}
+
+double DTree::GrowSubtree(arma::mat& data,
+                          arma::Col<size_t>& oldFromNew,
+                          const arma::mat& values,
+                          arma::Mat<size_t>& sortedIndices,
+                          std::vector<char>& goesLeft,
+                          const bool useVolReg,
+                          const size_t maxLeafSize,
+                          const size_t minLeafSize)
 {
   Log::Assert(data.n_rows == maxVals.n_elem);
   Log::Assert(data.n_rows == minVals.n_elem);
@@ -330,12 +414,20 @@ double DTree::Grow(arma::mat& data,
     size_t dim;
     double splitValueTmp;
     double leftError, rightError;
-    if (FindSplit(data, dim, splitValueTmp, leftError, rightError, minLeafSize))
+    if (FindSplit(data, dim, splitValueTmp, leftError, rightError, minLeafSize,
+        &values, &sortedIndices))
     {
       // Move the data around for the children to have points in a node lie
       // contiguously (to increase efficiency during the training).
       const size_t splitIndex = SplitData(data, dim, splitValueTmp, oldFromNew);
 
+      // The points of the left child are the first ones along the split
+      // dimension; keep the sorted indices of each child together.
+      const size_t* splitIndices = sortedIndices.colptr(dim);
+      for (size_t i = start; i < end; ++i)
+        goesLeft[splitIndices[i]] = (i < splitIndex);
+      math::PartitionPresorted(sortedIndices, start, end, goesLeft);
+
       // Make max and min vals for the children.
       arma::vec maxValsL(maxVals);
       arma::vec maxValsR(maxVals);
@@ -353,10 +445,29 @@ double DTree::Grow(arma::mat& data,
       left = new DTree(maxValsL, minValsL, start, splitIndex, leftError);
       right = new DTree(maxValsR, minValsR, splitIndex, end, rightError);
 
-      leftG = left->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
-      rightG = right->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
+      // The children hold disjoint ranges of the points, so they can be grown
+      // in parallel, if they are large enough.
+      if ((end - start) * data.n_rows >= ParallelWork())
+      {
+        ThreadPool::Spawn([&]()
+        {
+          leftG = left->GrowSubtree(data, oldFromNew, values,
+              sortedIndices, goesLeft, useVolReg, maxLeafSize, minLeafSize);
+        });
+        ThreadPool::Spawn([&]()
+        {
+          rightG = right->GrowSubtree(data, oldFromNew, values,
+              sortedIndices, goesLeft, useVolReg, maxLeafSize, minLeafSize);
+        });
+        ThreadPool::Wait();
+      }
+      else
+      {
+        leftG = left->GrowSubtree(data, oldFromNew, values, sortedIndices,
+            goesLeft, useVolReg, maxLeafSize, minLeafSize);
+        rightG = right->GrowSubtree(data, oldFromNew, values, sortedIndices,
+            goesLeft, useVolReg, maxLeafSize, minLeafSize);
+      }
 
       // Store values of R(T~) and |T~|.
       subtreeLeaves = left->SubtreeLeaves() + right->SubtreeLeaves();
@@ -318,14 +318,38 @@ class DTree
   // Utility methods.
 
   /**
-   * Find the dimension to split on.
+   * Find the dimension to split on.  If presorted indices of the points (see
+   * math::Presort()) are given, the values of the points are taken in sorted
+   * order from the given values instead of being sorted.
    */
   bool FindSplit(const arma::mat& data,
                  size_t& splitDim,
                  double& splitValue,
                  double& leftError,
                  double& rightError,
-                 const size_t minLeafSize = 5) const;
+                 const size_t minLeafSize = 5,
+                 const arma::mat* values = NULL,
+                 const arma::Mat<size_t>* sortedIndices = NULL) const;
+
+  /**
+   * Grow the subtree of this node (the recursive part of Grow(), run as tasks
+   * of the thread pool).  Rows [start, end) of sortedIndices hold the points
+   * of this node sorted along each dimension, as indices into values; they are
+   * partitioned between the children, marking the points of the left child in
+   * goesLeft.
+   */
+  double GrowSubtree(arma::mat& data,
+                     arma::Col<size_t>& oldFromNew,
+                     const arma::mat& values,
+                     arma::Mat<size_t>& sortedIndices,
+                     std::vector<char>& goesLeft,
+                     const bool useVolReg,
+                     const size_t maxLeafSize,
+                     const size_t minLeafSize);
+
+  //! Return the amount of work (number of values to sort) below which a split
+  //! search or a subtree is not worth running as a separate task.
+  static size_t ParallelWork() { return (size_t) 1 << 16; }
 
   /**
    * Split the data, returning the number of points left of the split.
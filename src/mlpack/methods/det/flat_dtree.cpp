@@ -0,0 +1,118 @@
+/**
+ * @file flat_dtree.cpp
+ *
+ * Implementation of the FlatDTree class.
+ */
+#include "flat_dtree.hpp"
+
+using namespace mlpack;
+using namespace det;
+
+FlatDTree::FlatDTree(const DTree& tree) :
+    checkRange(tree.Root()),
+    maxVals(tree.MaxVals()),
+    minVals(tree.MinVals())
+{
+  // Number the nodes in breadth-first order, so that the two children of each
+  // node are consecutive.
+  std::vector<const DTree*> nodes(1, &tree);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    if (nodes[i]->SubtreeLeaves() > 1)
+    {
+      nodes.push_back(nodes[i]->Left());
+      nodes.push_back(nodes[i]->Right());
+    }
+  }
+
+  splitDims.zeros(nodes.size());
+  splitValues.zeros(nodes.size());
+  leftChildren.zeros(nodes.size());
+  values.zeros(nodes.size());
+
+  size_t nextChild = 1;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const DTree& node = *nodes[i];
+    if (node.SubtreeLeaves() == 1)
+    {
+      values[i] = std::exp(std::log(node.Ratio()) - node.LogVolume());
+      continue;
+    }
+
+    splitDims[i] = node.SplitDim();
+    splitValues[i] = node.SplitValue();
+    leftChildren[i] = nextChild;
+    nextChild += 2;
+  }
+}
+
+double FlatDTree::ComputeValue(const arma::vec& query) const
+{
+  Log::Assert(query.n_elem == maxVals.n_elem);
+
+  if (checkRange && !WithinRange(query.memptr()))
+    return 0.0;
+
+  size_t node = 0;
+  while (leftChildren[node] != 0)
+  {
+    node = leftChildren[node] +
+        (query[splitDims[node]] <= splitValues[node] ? 0 : 1);
+  }
+
+  return values[node];
+}
+
+void FlatDTree::ComputeValues(const arma::mat& queries,
+                              arma::rowvec& estimates) const
+{
+  Log::Assert(queries.n_rows == maxVals.n_elem);
+
+  estimates.set_size(queries.n_cols);
+
+  const size_t blocks = (queries.n_cols + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    const size_t begin = b * BlockSize;
+    const size_t count = std::min((size_t) BlockSize,
+        (size_t) queries.n_cols - begin);
+
+    // Move every point of the block down one level at a time, so that the
+    // lookups of different points don't wait for each other.
+    size_t leaves[BlockSize];
+    for (size_t i = 0; i < count; ++i)
+      leaves[i] = 0;
+
+    bool moved = true;
+    while (moved)
+    {
+      moved = false;
+      for (size_t i = 0; i < count; ++i)
+      {
+        const size_t node = leaves[i];
+        if (leftChildren[node] == 0)
+          continue;
+
+        leaves[i] = leftChildren[node] +
+            (queries(splitDims[node], begin + i) <= splitValues[node] ? 0 : 1);
+        moved = true;
+      }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      estimates[begin + i] = (checkRange &&
+          !WithinRange(queries.colptr(begin + i))) ? 0.0 : values[leaves[i]];
+    }
+  });
+}
+
+bool FlatDTree::WithinRange(const double* query) const
+{
+  for (size_t i = 0; i < maxVals.n_elem; ++i)
+    if ((query[i] < minVals[i]) || (query[i] > maxVals[i]))
+      return false;
+
+  return true;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file flat_dtree.hpp
+ *
+ * A read-only, flattened form of a density estimation tree for fast density
+ * estimates: the nodes are stored in contiguous arrays instead of being linked
+ * by pointers, and points are estimated in blocks.
+ */
+#ifndef MLPACK_METHODS_DET_FLAT_DTREE_HPP
+#define MLPACK_METHODS_DET_FLAT_DTREE_HPP
+
+#include <mlpack/core.hpp>
+#include "dtree.hpp"
+
+namespace mlpack {
+namespace det {
+
+/**
+ * A flattened copy of a density estimation tree (DTree), which can only compute
+ * density estimates.  Each node of the tree is an entry in a few contiguous
+ * arrays: its split dimension and split value, the index of its left child
+ * (the right child is stored just after it), and, for leaves, the density
+ * estimate of the leaf.
+ *
+ * Batches of points are estimated in blocks of points which go down the tree
+ * one level at a time, so that the lookups of the points of a block are
+ * independent of each other, and the blocks are estimated in parallel.
+ *
+ * The flattened tree is a copy: it does not change when the DTree is pruned,
+ * so it must be built again afterwards.
+ */
+class FlatDTree
+{
+ public:
+  /**
+   * Flatten the given density estimation tree (or subtree).
+   *
+   * @param tree Trained tree to flatten.
+   */
+  FlatDTree(const DTree& tree);
+
+  /**
+   * Compute the density estimate of the given point.  As with
+   * DTree::ComputeValue(), if the tree is a root, the estimate is 0 outside of
+   * its bounding box.
+   *
+   * @param query Point to estimate the density of.
+   */
+  double ComputeValue(const arma::vec& query) const;
+
+  /**
+   * Compute the density estimates of the given points.
+   *
+   * @param queries Points to estimate the density of.
+   * @param estimates Vector to store the density estimates in.
+   */
+  void ComputeValues(const arma::mat& queries, arma::rowvec& estimates) const;
+
+  //! Get the number of nodes.
+  size_t NumNodes() const { return leftChildren.n_elem; }
+
+ private:
+  //! The split dimension of each node.
+  arma::Col<size_t> splitDims;
+  //! The split value of each node.
+  arma::vec splitValues;
+  //! The index of the left child of each node (0 for leaves).
+  arma::Col<size_t> leftChildren;
+  //! The density estimate of each node (only used for leaves).
+  arma::vec values;
+  //! Whether points outside of the bounding box get an estimate of 0.
+  bool checkRange;
+  //! The upper bound of the bounding box of the tree.
+  arma::vec maxVals;
+  //! The lower bound of the bounding box of the tree.
+  arma::vec minVals;
+
+  //! The number of points estimated together.
+  static const size_t BlockSize = 64;
+
+  //! Return whether the point is within the bounding box of the tree.
+  bool WithinRange(const double* query) const;
+};
+
+} // namespace det
+} // namespace mlpack
+
+#endif
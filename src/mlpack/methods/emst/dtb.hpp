@@ -28,6 +28,8 @@
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
 
+#include <atomic>
+
 namespace mlpack {
 namespace emst /** Euclidean Minimum Spanning Trees. */ {
 
@@ -63,17 +65,33 @@ namespace emst /** Euclidean Minimum Spanning Trees. */ {
  * More advanced usage of the class can use different types of trees, pass in an
  * already-built tree, or compute the MST using the O(n^2) naive algorithm.
  *
+ * The dual-tree traversal of each iteration can be done in parallel by using a
+ * parallel traverser, such as the ParallelDualTreeTraverser of the
+ * BinarySpaceTree; the naive computation is always done in parallel.  The
+ * edges of each iteration are then added with a lock-free union-find
+ * structure.
+ *
+ * @code
+ * typedef tree::KDTree<metric::EuclideanDistance, DTBStat, arma::mat> TreeType;
+ * DualTreeBoruvka<metric::EuclideanDistance, arma::mat, tree::KDTree,
+ *     TreeType::ParallelDualTreeTraverser> dtb(data);
+ * @endcode
+ *
  * @tparam MetricType The metric to use.
  * @tparam MatType The type of data matrix to use.
  * @tparam TreeType Type of tree to use.  This should follow the TreeType policy
  *      API.
+ * @tparam TraversalType The type of dual-tree traversal to use (defaults to the
+ *      tree's DualTreeTraverser).
  */
 template<
     typename MetricType = metric::EuclideanDistance,
     typename MatType = arma::mat,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType = tree::KDTree
+             typename TreeMatType> class TreeType = tree::KDTree,
+    template<typename RuleType> class TraversalType =
+        TreeType<MetricType, DTBStat, MatType>::template DualTreeTraverser
 >
 class DualTreeBoruvka
 {
@@ -98,14 +116,18 @@ class DualTreeBoruvka
   std::vector<EdgePair> edges; // We must use vector with non-numerical types.
 
   //! Connections.
-  UnionFind connections;
-
-  //! List of edge nodes.
-  arma::Col<size_t> neighborsInComponent;
-  //! List of edge nodes.
-  arma::Col<size_t> neighborsOutComponent;
-  //! List of edge distances.
-  arma::vec neighborsDistances;
+  ConcurrentUnionFind connections;
+
+  //! The component of each point in this iteration.
+  arma::Col<size_t> components;
+  //! The distance of the candidate edge of each component.
+  std::vector<std::atomic<double> > componentDistances;
+  //! The point of each component that is an endpoint of its candidate edge.
+  std::vector<std::atomic<size_t> > componentPoints;
+  //! The distance of the candidate edge of each point.
+  arma::vec pointDistances;
+  //! The other endpoint of the candidate edge of each point.
+  arma::Col<size_t> pointNeighbors;
 
   //! Total distance of the tree.
   double totalDist;
@@ -198,6 +220,9 @@ class DualTreeBoruvka
    */
   void Cleanup();
 
+  //! The number of points (or components) handled together by a thread.
+  static const size_t BlockSize = 1024;
+
 }; // class DualTreeBoruvka
 
 } // namespace emst
@@ -45,8 +45,9 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::DualTreeBoruvka(
     const MatType& dataset,
     const bool naive,
     const MetricType metric) :
@@ -56,15 +57,15 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     ownTree(!naive),
     naive(naive),
     connections(dataset.n_cols),
+    componentDistances(dataset.n_cols),
+    componentPoints(dataset.n_cols),
     totalDist(0.0),
     metric(metric)
 {
   edges.reserve(data.n_cols - 1); // Set size.
 
-  neighborsInComponent.set_size(data.n_cols);
-  neighborsOutComponent.set_size(data.n_cols);
-  neighborsDistances.set_size(data.n_cols);
-  neighborsDistances.fill(DBL_MAX);
+  pointNeighbors.set_size(data.n_cols);
+  Cleanup();
 }
 
 template<
@@ -72,8 +73,9 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::DualTreeBoruvka(
     Tree* tree,
     const MetricType metric) :
     tree(tree),
@@ -81,15 +83,15 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     ownTree(false),
     naive(false),
     connections(data.n_cols),
+    componentDistances(data.n_cols),
+    componentPoints(data.n_cols),
     totalDist(0.0),
     metric(metric)
 {
   edges.reserve(data.n_cols - 1); // Fill with EdgePairs.
 
-  neighborsInComponent.set_size(data.n_cols);
-  neighborsOutComponent.set_size(data.n_cols);
-  neighborsDistances.set_size(data.n_cols);
-  neighborsDistances.fill(DBL_MAX);
+  pointNeighbors.set_size(data.n_cols);
+  Cleanup();
 }
 
 template<
@@ -97,8 +99,10 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-DualTreeBoruvka<MetricType, MatType, TreeType>::~DualTreeBoruvka()
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::
+~DualTreeBoruvka()
 {
   if (ownTree)
     delete tree;
@@ -113,8 +117,9 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+void DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::ComputeMST(
     arma::mat& results)
 {
   Timer::Start("emst/mst_computation");
@@ -122,20 +127,35 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
   totalDist = 0; // Reset distance.
 
   typedef DTBRules<MetricType, Tree> RuleType;
-  RuleType rules(data, connections, neighborsDistances, neighborsInComponent,
-                 neighborsOutComponent, metric);
+  RuleType rules(data, components, componentDistances, pointDistances,
+                 pointNeighbors, metric);
   while (edges.size() < (data.n_cols - 1))
   {
     if (naive)
     {
-      // Full O(N^2) traversal.
-      for (size_t i = 0; i < data.n_cols; ++i)
-        for (size_t j = 0; j < data.n_cols; ++j)
-          rules.BaseCase(i, j);
+      // Full O(N^2) traversal; each block of query points is handled by a
+      // thread with its own copy of the rules, whose base cases are then added
+      // to the cumulative count.
+      const size_t blocks = (data.n_cols + BlockSize - 1) / BlockSize;
+      std::vector<size_t> blockBaseCases(blocks);
+      ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+      {
+        RuleType blockRules(rules);
+        blockRules.BaseCases() = 0;
+        const size_t end = std::min((size_t) data.n_cols, (b + 1) * BlockSize);
+        for (size_t i = b * BlockSize; i < end; ++i)
+          for (size_t j = 0; j < data.n_cols; ++j)
+            blockRules.BaseCase(i, j);
+
+        blockBaseCases[b] = blockRules.BaseCases();
+      });
+
+      for (size_t b = 0; b < blocks; ++b)
+        rules.BaseCases() += blockBaseCases[b];
     }
     else
     {
-      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+      TraversalType<RuleType> traverser(rules);
       traverser.Traverse(*tree, *tree);
     }
 
@@ -144,9 +164,9 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
     Cleanup();
 
     Log::Info << edges.size() << " edges found so far." << std::endl;
+    Log::Info << rules.BaseCases() << " cumulative base cases." << std::endl;
     if (!naive)
     {
-      Log::Info << rules.BaseCases() << " cumulative base cases." << std::endl;
       Log::Info << rules.Scores() << " cumulative node combinations scored."
           << std::endl;
     }
@@ -167,8 +187,9 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-void DualTreeBoruvka<MetricType, MatType, TreeType>::AddEdge(
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+void DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::AddEdge(
     const size_t e1,
     const size_t e2,
     const double distance)
@@ -190,22 +211,50 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-void DualTreeBoruvka<MetricType, MatType, TreeType>::AddAllEdges()
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+void DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::
+AddAllEdges()
 {
-  for (size_t i = 0; i < data.n_cols; i++)
+  // The endpoint of the edge of each component is the point with the closest
+  // neighbor outside of the component (the one with the smallest index, if
+  // there are ties), so the edges do not depend on the order of the base cases.
+  ThreadPool::ParallelFor(0, data.n_cols, [&](const size_t i)
   {
-    size_t component = connections.Find(i);
-    size_t inEdge = neighborsInComponent[component];
-    size_t outEdge = neighborsOutComponent[component];
-    if (connections.Find(inEdge) != connections.Find(outEdge))
-    {
-      //totalDist = totalDist + dist;
-      // changed to make this agree with the cover tree code
-      totalDist += neighborsDistances[component];
-      AddEdge(inEdge, outEdge, neighborsDistances[component]);
-      connections.Union(inEdge, outEdge);
-    }
+    const size_t component = components[i];
+    if (pointDistances[i] != componentDistances[component].load())
+      return;
+
+    std::atomic<size_t>& point = componentPoints[component];
+    size_t oldPoint = point.load();
+    while (i < oldPoint && !point.compare_exchange_weak(oldPoint, i)) { }
+  }, BlockSize);
+
+  // Join each component with the component its edge leads to.  An edge that
+  // was found from both of its components (or that would close a cycle of edges
+  // with equal distances) is only added by the first successful union.
+  std::vector<char> added(data.n_cols, 0);
+  ThreadPool::ParallelFor(0, data.n_cols, [&](const size_t component)
+  {
+    if (components[component] != component ||
+        componentDistances[component].load() == DBL_MAX)
+      return;
+
+    const size_t inEdge = componentPoints[component].load();
+    if (connections.Union(inEdge, pointNeighbors[inEdge]))
+      added[component] = 1;
+  }, BlockSize);
+
+  // The edges are added in the order of their components.
+  for (size_t component = 0; component < data.n_cols; ++component)
+  {
+    if (!added[component])
+      continue;
+
+    const size_t inEdge = componentPoints[component].load();
+    const double distance = componentDistances[component].load();
+    totalDist += distance;
+    AddEdge(inEdge, pointNeighbors[inEdge], distance);
   }
 }
 
@@ -217,8 +266,9 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-void DualTreeBoruvka<MetricType, MatType, TreeType>::EmitResults(
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+void DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::EmitResults(
     arma::mat& results)
 {
   // Sort the edges.
@@ -273,8 +323,10 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-void DualTreeBoruvka<MetricType, MatType, TreeType>::CleanupHelper(Tree* tree)
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+void DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::
+CleanupHelper(Tree* tree)
 {
   // Reset the statistic information.
   tree->Stat().MaxNeighborDistance() = DBL_MAX;
@@ -289,7 +341,7 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::CleanupHelper(Tree* tree)
   // if all other components of children and points are the same.
   const int component = (tree->NumChildren() != 0) ?
       tree->Child(0).Stat().ComponentMembership() :
-      connections.Find(tree->Point(0));
+      components[tree->Point(0)];
 
   // Check components of children.
   for (size_t i = 0; i < tree->NumChildren(); ++i)
@@ -298,7 +350,7 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::CleanupHelper(Tree* tree)
 
   // Check components of points.
   for (size_t i = 0; i < tree->NumPoints(); ++i)
-    if (connections.Find(tree->Point(i)) != size_t(component))
+    if (components[tree->Point(i)] != size_t(component))
       return;
 
   // If we made it this far, all components are the same.
@@ -313,11 +365,19 @@ template<
     typename MatType,
     template<typename TreeMetricType,
              typename TreeStatType,
-             typename TreeMatType> class TreeType>
-void DualTreeBoruvka<MetricType, MatType, TreeType>::Cleanup()
+             typename TreeMatType> class TreeType,
+    template<typename RuleType> class TraversalType>
+void DualTreeBoruvka<MetricType, MatType, TreeType, TraversalType>::Cleanup()
 {
-  for (size_t i = 0; i < data.n_cols; i++)
-    neighborsDistances[i] = DBL_MAX;
+  pointDistances.set_size(data.n_cols);
+  pointDistances.fill(DBL_MAX);
+  components.set_size(data.n_cols);
+  ThreadPool::ParallelFor(0, data.n_cols, [&](const size_t i)
+  {
+    componentDistances[i].store(DBL_MAX);
+    componentPoints[i].store(data.n_cols);
+    components[i] = connections.Find(i);
+  }, BlockSize);
 
   if (!naive)
     CleanupHelper(tree);
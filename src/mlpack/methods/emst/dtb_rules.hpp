@@ -11,6 +11,8 @@
 
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include <atomic>
+
 namespace mlpack {
 namespace emst {
 
@@ -18,11 +20,26 @@ template<typename MetricType, typename TreeType>
 class DTBRules
 {
  public:
+  /**
+   * Construct the rules.  The candidate edges are found for each point; the
+   * bounds of the components are only lowered with atomic operations, so that
+   * copies of the rules can be used by several threads at once, as long as
+   * each thread works on its own query points.
+   *
+   * @param dataSet The data points.
+   * @param components The component of each point in this iteration.
+   * @param componentDistances The distance of the candidate edge of each
+   *     component.
+   * @param pointDistances The distance of the candidate edge of each point.
+   * @param pointNeighbors The other endpoint of the candidate edge of each
+   *     point.
+   * @param metric The instantiated metric.
+   */
   DTBRules(const arma::mat& dataSet,
-           UnionFind& connections,
-           arma::vec& neighborsDistances,
-           arma::Col<size_t>& neighborsInComponent,
-           arma::Col<size_t>& neighborsOutComponent,
+           const arma::Col<size_t>& components,
+           std::vector<std::atomic<double> >& componentDistances,
+           arma::vec& pointDistances,
+           arma::Col<size_t>& pointNeighbors,
            MetricType& metric);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
@@ -96,19 +113,19 @@ class DTBRules
   //! The data points.
   const arma::mat& dataSet;
 
-  //! Stores the tree structure so far
-  UnionFind& connections;
+  //! The component of each point in this iteration.
+  const arma::Col<size_t>& components;
 
   //! The distance to the candidate nearest neighbor for each component.
-  arma::vec& neighborsDistances;
+  std::vector<std::atomic<double> >& componentDistances;
 
-  //! The index of the point in the component that is an endpoint of the
-  //! candidate edge.
-  arma::Col<size_t>& neighborsInComponent;
+  //! The distance to the candidate nearest neighbor outside of its component
+  //! for each point.
+  arma::vec& pointDistances;
 
-  //! The index of the point outside of the component that is an endpoint
-  //! of the candidate edge.
-  arma::Col<size_t>& neighborsOutComponent;
+  //! The index of the candidate nearest neighbor outside of its component for
+  //! each point.
+  arma::Col<size_t>& pointNeighbors;
 
   //! The instantiated metric.
   MetricType& metric;
@@ -26,7 +26,8 @@
 
 PROGRAM_INFO("Fast Euclidean Minimum Spanning Tree", "This program can compute "
     "the Euclidean minimum spanning tree of a set of input points using the "
-    "dual-tree Boruvka algorithm."
+    "dual-tree Boruvka algorithm.  Each iteration of the algorithm is run with "
+    "as many threads as specified by the --threads (-j) option."
     "\n\n"
     "The output is saved in a three-column matrix, where each row indicates an "
     "edge.  The first column corresponds to the lesser index of the edge; the "
@@ -92,12 +93,14 @@ int main(int argc, char* argv[])
 
     Timer::Start("tree_building");
     std::vector<size_t> oldFromNew;
-    KDTree<EuclideanDistance, DTBStat, arma::mat> tree(dataPoints, oldFromNew,
-        leafSize);
+    typedef KDTree<EuclideanDistance, DTBStat, arma::mat> TreeType;
+    TreeType tree(dataPoints, oldFromNew, leafSize);
     metric::LMetric<2, true> metric;
     Timer::Stop("tree_building");
 
-    DualTreeBoruvka<> dtb(&tree, metric);
+    // The traversal of each iteration is split over the available threads.
+    DualTreeBoruvka<EuclideanDistance, arma::mat, KDTree,
+        TreeType::ParallelDualTreeTraverser> dtb(&tree, metric);
 
     // Run the DTB algorithm.
     Log::Info << "Calculating minimum spanning tree." << endl;
@@ -11,6 +11,7 @@
 #define MLPACK_METHODS_EMST_UNION_FIND_HPP
 
 #include <mlpack/core.hpp>
+#include <atomic>
 
 namespace mlpack {
 namespace emst {
@@ -93,6 +94,84 @@ class UnionFind
   }
 }; // class UnionFind
 
+/**
+ * A lock-free union-find data structure, which several threads can use at
+ * once.  Find() shortens the paths it follows by path halving, and Union()
+ * links the root with the larger index under the root with the smaller index;
+ * both use atomic compare-and-swap operations, and Union() retries if another
+ * thread changed one of the roots in the meantime.  Since roots are only ever
+ * linked under roots with smaller indices, no cycles can form.
+ */
+class ConcurrentUnionFind
+{
+ private:
+  std::vector<std::atomic<size_t> > parent;
+
+ public:
+  //! Construct the object with the given size.
+  ConcurrentUnionFind(const size_t size) : parent(size)
+  {
+    for (size_t i = 0; i < size; ++i)
+      parent[i].store(i, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the component containing an element.
+   *
+   * @param x the component to be found
+   * @return The index of the component containing x
+   */
+  size_t Find(size_t x)
+  {
+    while (true)
+    {
+      size_t p = parent[x].load(std::memory_order_acquire);
+      if (p == x)
+        return x;
+
+      // Point x to its grandparent.  If another thread changed the parent of x
+      // in the meantime, the grandparent is still an ancestor of x.
+      const size_t grandparent = parent[p].load(std::memory_order_acquire);
+      if (grandparent != p)
+      {
+        parent[x].compare_exchange_weak(p, grandparent,
+            std::memory_order_release, std::memory_order_relaxed);
+      }
+      x = grandparent;
+    }
+  }
+
+  /**
+   * Union the components containing x and y.
+   *
+   * @param x one component
+   * @param y the other component
+   * @return Whether the components were different (and were united by this
+   *     call).
+   */
+  bool Union(const size_t x, const size_t y)
+  {
+    size_t xRoot = x;
+    size_t yRoot = y;
+    while (true)
+    {
+      xRoot = Find(xRoot);
+      yRoot = Find(yRoot);
+      if (xRoot == yRoot)
+        return false;
+
+      if (xRoot < yRoot)
+        std::swap(xRoot, yRoot);
+
+      // Link the root with the larger index, if it is still a root.
+      size_t expected = xRoot;
+      if (parent[xRoot].compare_exchange_strong(expected, yRoot,
+          std::memory_order_acq_rel))
+        return true;
+    }
+  }
+}; // class ConcurrentUnionFind
+
 } // namespace emst
 } // namespace mlpack
 
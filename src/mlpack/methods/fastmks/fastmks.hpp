@@ -98,6 +98,35 @@ class FastMKS
           const bool singleMode = false,
           const bool naive = false);
 
+  /**
+   * Create the FastMKS object with a reference set that may be shared with
+   * other objects (for instance, with other search models on the same points).
+   * The reference set is never copied or modified, and the object holds on to
+   * it for as long as it uses it, so it is only freed when the last object
+   * sharing it is done with it.
+   *
+   * @param referenceSet Shared set of reference data (must not be NULL).
+   * @param singleMode Whether or not to run single-tree search.
+   * @param naive Whether or not to run brute-force (naive) search.
+   */
+  FastMKS(std::shared_ptr<const MatType> referenceSet,
+          const bool singleMode = false,
+          const bool naive = false);
+
+  /**
+   * Create the FastMKS object with a reference set that may be shared with
+   * other objects and an initialized kernel.  See the constructor above.
+   *
+   * @param referenceSet Shared set of reference data (must not be NULL).
+   * @param kernel Initialized kernel.
+   * @param singleMode Whether or not to run single-tree search.
+   * @param naive Whether or not to run brute-force (naive) search.
+   */
+  FastMKS(std::shared_ptr<const MatType> referenceSet,
+          KernelType& kernel,
+          const bool singleMode = false,
+          const bool naive = false);
+
   /**
    * Create the FastMKS object with an already-initialized tree built on the
    * reference points.  Be sure that the tree is built with the metric type
@@ -133,6 +162,24 @@ class FastMKS
    */
   void Train(const MatType& referenceSet, KernelType& kernel);
 
+  /**
+   * "Train" the FastMKS model on the given reference set, which may be shared
+   * with other objects; the object holds on to the set for as long as it uses
+   * it.
+   *
+   * @param referenceSet Shared set of reference points (must not be NULL).
+   */
+  void Train(std::shared_ptr<const MatType> referenceSet);
+
+  /**
+   * "Train" the FastMKS model on the given reference set, which may be shared
+   * with other objects, and use the given kernel.
+   *
+   * @param referenceSet Shared set of reference points (must not be NULL).
+   * @param kernel Kernel to use for search.
+   */
+  void Train(std::shared_ptr<const MatType> referenceSet, KernelType& kernel);
+
   /**
    * Train the FastMKS model on the given reference tree.  This takes ownership
    * of the tree, so you do not need to delete it!  This will throw an exception
@@ -212,6 +259,23 @@ class FastMKS
               arma::Mat<size_t>& indices,
               arma::mat& products);
 
+  /**
+   * Search for the maximum kernels of the points of the reference set with
+   * each other by brute force, with the kernel values of the given kernel
+   * cache (so that the kernel values which are already cached, for instance by
+   * KernelPCA, are not computed again).  The cache must have been built on the
+   * reference set of this object.
+   *
+   * @param cache Kernel cache of the reference set.
+   * @param k The number of maximum kernels to find.
+   * @param indices Matrix to store resulting indices of max-kernel search in.
+   * @param kernels Matrix to store resulting max-kernel values in.
+   */
+  void Search(kernel::KernelCache<KernelType, MatType>& cache,
+              const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& kernels);
+
   //! Get the inner-product metric induced by the given kernel.
   const metric::IPMetric<KernelType>& Metric() const { return metric; }
   //! Modify the inner-product metric induced by the given kernel.
@@ -222,6 +286,9 @@ class FastMKS
   //! Modify whether or not single-tree search is used.
   bool& SingleMode() { return singleMode; }
 
+  //! Get the reference dataset.
+  const MatType& ReferenceSet() const { return *referenceSet; }
+
   //! Get whether or not brute-force (naive) search is used.
   bool Naive() const { return naive; }
   //! Modify whether or not brute-force (naive) search is used.
@@ -235,6 +302,9 @@ class FastMKS
   //! The reference dataset.  We never own this; only the tree or a higher level
   //! does.
   const MatType* referenceSet;
+  //! The shared reference set, if we were given one; this keeps it alive for as
+  //! long as we (and the tree) refer to it.
+  std::shared_ptr<const MatType> sharedReferenceSet;
   //! The tree built on the reference dataset.
   Tree* referenceTree;
   //! If true, this object created the tree and is responsible for it.
@@ -257,6 +327,21 @@ class FastMKS
                       const size_t pos,
                       const size_t neighbor,
                       const double distance);
+
+  //! Return the number of query points whose kernel values with every
+  //! reference point are computed at once in naive mode (so that the blocks of
+  //! kernel values of all threads take at most about 32MB).
+  size_t NaiveBlockSize() const
+  {
+    const size_t referencePoints = std::max((size_t) 1,
+        (size_t) referenceSet->n_cols);
+    return std::max((size_t) 1, (size_t) (1 << 22) /
+        (referencePoints * ThreadPool::Threads()));
+  }
+
+  //! The minimum number of query points in each block of a parallel dual-tree
+  //! search.
+  static const size_t QueryBlockSize = 1024;
 };
 
 } // namespace fastmks
@@ -89,6 +89,37 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(const MatType& referenceSet,
   Timer::Stop("tree_building");
 }
 
+// Shared dataset, no instantiated kernel.
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+FastMKS<KernelType, MatType, TreeType>::FastMKS(
+    std::shared_ptr<const MatType> referenceSetIn,
+    const bool singleMode,
+    const bool naive) :
+    FastMKS(*referenceSetIn, singleMode, naive)
+{
+  sharedReferenceSet = std::move(referenceSetIn);
+}
+
+// Shared dataset, instantiated kernel.
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+FastMKS<KernelType, MatType, TreeType>::FastMKS(
+    std::shared_ptr<const MatType> referenceSetIn,
+    KernelType& kernel,
+    const bool singleMode,
+    const bool naive) :
+    FastMKS(*referenceSetIn, kernel, singleMode, naive)
+{
+  sharedReferenceSet = std::move(referenceSetIn);
+}
+
 // One dataset, pre-built tree.
 template<typename KernelType,
          typename MatType,
@@ -142,6 +173,9 @@ void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet)
     referenceTree = new Tree(referenceSet, metric);
     treeOwner = true;
   }
+
+  // Let go of the old shared set, if we had one.
+  sharedReferenceSet.reset();
 }
 
 template<typename KernelType,
@@ -166,6 +200,33 @@ void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet,
     referenceTree = new Tree(referenceSet, metric);
     treeOwner = true;
   }
+
+  sharedReferenceSet.reset();
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::Train(
+    std::shared_ptr<const MatType> referenceSetIn)
+{
+  Train(*referenceSetIn);
+  sharedReferenceSet = std::move(referenceSetIn);
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::Train(
+    std::shared_ptr<const MatType> referenceSetIn,
+    KernelType& kernel)
+{
+  Train(*referenceSetIn, kernel);
+  sharedReferenceSet = std::move(referenceSetIn);
 }
 
 template<typename KernelType,
@@ -191,6 +252,7 @@ void FastMKS<KernelType, MatType, TreeType>::Train(Tree* tree)
 
   this->referenceTree = tree;
   this->treeOwner = true;
+  sharedReferenceSet.reset();
 }
 
 template<typename KernelType,
@@ -224,24 +286,38 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     // Fill kernels.
     kernels.fill(-DBL_MAX);
 
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
+    // Simple double loop.  Stupid, slow, but a good benchmark.  The kernel
+    // values are computed for a block of query points at a time, with the
+    // batch evaluation of the kernel if it has one, and the blocks are
+    // searched in parallel.
+    const size_t blockSize = NaiveBlockSize();
+    const size_t blocks = (querySet.n_cols + blockSize - 1) / blockSize;
+    ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
     {
-      for (size_t r = 0; r < referenceSet->n_cols; ++r)
-      {
-        const double eval = metric.Kernel().Evaluate(querySet.col(q),
-                                                     referenceSet->col(r));
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) querySet.n_cols);
 
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > kernels(insertPosition, q))
-            break;
+      arma::mat blockKernels;
+      kernel::KernelMatrix(metric.Kernel(), *referenceSet,
+          querySet.cols(begin, end - 1), blockKernels);
 
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+      for (size_t q = begin; q < end; ++q)
+      {
+        for (size_t r = 0; r < referenceSet->n_cols; ++r)
+        {
+          const double eval = blockKernels(r, q - begin);
+
+          size_t insertPosition;
+          for (insertPosition = 0; insertPosition < indices.n_rows;
+              ++insertPosition)
+            if (eval > kernels(insertPosition, q))
+              break;
+
+          if (insertPosition < indices.n_rows)
+            InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+        }
       }
-    }
+    });
 
     Timer::Stop("computing_products");
 
@@ -259,10 +335,9 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     typedef FastMKSRules<KernelType, Tree> RuleType;
     RuleType rules(*referenceSet, querySet, indices, kernels, metric.Kernel());
 
+    // The query points are independent, so they are searched in parallel.
     typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    traverser.Traverse(0, querySet.n_cols, *referenceTree);
 
     Log::Info << rules.BaseCases() << " base cases." << std::endl;
     Log::Info << rules.Scores() << " scores." << std::endl;
@@ -271,8 +346,56 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     return;
   }
 
-  // Dual-tree implementation.  First, we need to build the query tree.  We are
-  // assuming it doesn't map anything...
+  // Dual-tree implementation.  The cover tree traversal is sequential, so with
+  // several threads the query set is split into one block for each thread,
+  // and a query tree is built and traversed for each block in parallel.
+  const size_t blocks = std::min(ThreadPool::Threads(),
+      (size_t) querySet.n_cols / QueryBlockSize);
+  if (blocks > 1)
+  {
+    kernels.fill(-DBL_MAX);
+    size_t baseCases = 0, scores = 0;
+    std::vector<size_t> blockBaseCases(blocks), blockScores(blocks);
+    ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+    {
+      const size_t begin = b * querySet.n_cols / blocks;
+      const size_t end = (b + 1) * querySet.n_cols / blocks;
+
+      // The tree only keeps a reference to the block.
+      const MatType blockSet = querySet.cols(begin, end - 1);
+      Tree queryTree(blockSet);
+
+      arma::Mat<size_t> blockIndices(k, end - begin);
+      arma::mat blockKernels(k, end - begin);
+      blockKernels.fill(-DBL_MAX);
+
+      typedef FastMKSRules<KernelType, Tree> RuleType;
+      RuleType rules(*referenceSet, blockSet, blockIndices, blockKernels,
+          metric.Kernel());
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+      traverser.Traverse(queryTree, *referenceTree);
+
+      indices.cols(begin, end - 1) = blockIndices;
+      kernels.cols(begin, end - 1) = blockKernels;
+      blockBaseCases[b] = rules.BaseCases();
+      blockScores[b] = rules.Scores();
+    });
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+      baseCases += blockBaseCases[b];
+      scores += blockScores[b];
+    }
+
+    Log::Info << baseCases << " base cases." << std::endl;
+    Log::Info << scores << " scores." << std::endl;
+
+    Timer::Stop("computing_products");
+    return;
+  }
+
+  // First, we need to build the query tree.  We are assuming it doesn't map
+  // anything...
   Timer::Stop("computing_products");
   Timer::Start("tree_building");
   Tree queryTree(querySet);
@@ -346,27 +469,42 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < referenceSet->n_cols; ++q)
+    // Simple double loop.  Stupid, slow, but a good benchmark.  The kernel
+    // values are computed for a block of query points at a time, with the
+    // batch evaluation of the kernel if it has one, and the blocks are
+    // searched in parallel.
+    const size_t blockSize = NaiveBlockSize();
+    const size_t blocks = (referenceSet->n_cols + blockSize - 1) / blockSize;
+    ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
     {
-      for (size_t r = 0; r < referenceSet->n_cols; ++r)
-      {
-        if (q == r)
-          continue; // Don't return the point as its own candidate.
-
-        const double eval = metric.Kernel().Evaluate(referenceSet->col(q),
-                                                     referenceSet->col(r));
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize,
+          (size_t) referenceSet->n_cols);
 
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > kernels(insertPosition, q))
-            break;
+      arma::mat blockKernels;
+      kernel::KernelMatrix(metric.Kernel(), *referenceSet,
+          referenceSet->cols(begin, end - 1), blockKernels);
 
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+      for (size_t q = begin; q < end; ++q)
+      {
+        for (size_t r = 0; r < referenceSet->n_cols; ++r)
+        {
+          if (q == r)
+            continue; // Don't return the point as its own candidate.
+
+          const double eval = blockKernels(r, q - begin);
+
+          size_t insertPosition;
+          for (insertPosition = 0; insertPosition < indices.n_rows;
+              ++insertPosition)
+            if (eval > kernels(insertPosition, q))
+              break;
+
+          if (insertPosition < indices.n_rows)
+            InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+        }
       }
-    }
+    });
 
     Timer::Stop("computing_products");
 
@@ -382,10 +520,9 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     RuleType rules(*referenceSet, *referenceSet, indices, kernels,
         metric.Kernel());
 
+    // The query points are independent, so they are searched in parallel.
     typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    traverser.Traverse(0, referenceSet->n_cols, *referenceTree);
 
     // Save the number of pruned nodes.
     const size_t numPrunes = traverser.NumPrunes();
@@ -405,6 +542,52 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   Search(referenceTree, k, indices, kernels);
 }
 
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::Search(
+    kernel::KernelCache<KernelType, MatType>& cache,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  if (&cache.Dataset() != referenceSet)
+  {
+    Log::Fatal << "FastMKS::Search(): the kernel cache must be built on the "
+        << "reference set!" << std::endl;
+  }
+
+  Timer::Start("computing_products");
+  indices.set_size(k, referenceSet->n_cols);
+  kernels.set_size(k, referenceSet->n_cols);
+  kernels.fill(-DBL_MAX);
+
+  for (size_t q = 0; q < referenceSet->n_cols; ++q)
+  {
+    const arma::vec& column = cache.Column(q);
+    for (size_t r = 0; r < referenceSet->n_cols; ++r)
+    {
+      if (q == r)
+        continue; // Don't return the point as its own candidate.
+
+      const double eval = column[r];
+
+      size_t insertPosition;
+      for (insertPosition = 0; insertPosition < indices.n_rows;
+          ++insertPosition)
+        if (eval > kernels(insertPosition, q))
+          break;
+
+      if (insertPosition < indices.n_rows)
+        InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+    }
+  }
+
+  Timer::Stop("computing_products");
+}
+
 /**
  * Helper function to insert a point into the neighbors and distances matrices.
  *
@@ -498,6 +681,10 @@ void FastMKS<KernelType, MatType, TreeType>::Serialize(
       setOwner = false;
     }
   }
+
+  // A loaded model owns its data, so it does not share a reference set.
+  if (Archive::is_loading::value)
+    sharedReferenceSet.reset();
 }
 
 } // namespace fastmks
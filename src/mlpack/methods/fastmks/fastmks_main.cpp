@@ -38,7 +38,9 @@ PROGRAM_INFO("FastMKS (Fast Max-Kernel Search)",
     "to the kernel evaluation between those two points."
     "\n\n"
     "This executable performs FastMKS using a cover tree.  The base used to "
-    "build the cover tree can be specified with the --base option.");
+    "build the cover tree can be specified with the --base option.  Searches "
+    "with a query set are run with as many threads as specified by the "
+    "--threads (-j) option.");
 
 // Model-building parameters.
 PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
@@ -11,6 +11,8 @@
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include <unordered_map>
+
 namespace mlpack {
 namespace fastmks {
 
@@ -121,9 +123,46 @@ class FastMKSRules
   //! The last kernel evaluation resulting from BaseCase().
   double lastKernel;
 
+  //! The query index of the last single-tree Score() call.
+  size_t lastScoreQueryIndex;
+  //! The kernel values between the current query point and the reference nodes
+  //! scored so far.  These are kept here and not in the statistics of the
+  //! reference nodes, so that several query points can be searched at once with
+  //! copies of the rules.
+  std::unordered_map<const TreeType*, double> nodeKernels;
+  //! The kernel values between the current query point and the reference leaves
+  //! that were evaluated together with the leaves under the same parent.
+  std::unordered_map<const TreeType*, double> leafKernels;
+
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
+  /**
+   * Bound the kernel value between a query point and any point within the
+   * given distance of a reference point, from the kernel value between the
+   * query point and that reference point.
+   */
+  double MaxKernel(const size_t queryIndex,
+                   const double kernelEval,
+                   const double distance) const;
+
+  /**
+   * Compute the base case between a query point and the point of a reference
+   * leaf.  The kernel values of the query point with all the leaves under the
+   * same parent that can't be pruned yet are evaluated together, with the batch
+   * evaluation of the kernel, the first time one of them is scored.
+   */
+  double LeafBaseCase(const size_t queryIndex,
+                      TreeType& leaf,
+                      const double parentKernel,
+                      const double bestKernel);
+
+  //! Record the base case with the given kernel value, and insert the
+  //! reference point into the results if it is a better candidate.
+  double InsertBaseCase(const size_t queryIndex,
+                        const size_t referenceIndex,
+                        const double kernelEval);
+
   //! Utility function to insert neighbor into list of results.
   void InsertNeighbor(const size_t queryIndex,
                       const size_t pos,
@@ -28,6 +28,7 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
+    lastScoreQueryIndex(-1),
     baseCases(0),
     scores(0)
 {
@@ -69,9 +70,19 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
     lastReferenceIndex = referenceIndex;
   }
 
+  return InsertBaseCase(queryIndex, referenceIndex,
+      kernel.Evaluate(querySet.col(queryIndex),
+                      referenceSet.col(referenceIndex)));
+}
+
+template<typename KernelType, typename TreeType>
+inline force_inline
+double FastMKSRules<KernelType, TreeType>::InsertBaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double kernelEval)
+{
   ++baseCases;
-  double kernelEval = kernel.Evaluate(querySet.col(queryIndex),
-                                      referenceSet.col(referenceIndex));
 
   // Update the last kernel value, if we need to.
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
@@ -101,39 +112,32 @@ template<typename KernelType, typename TreeType>
 double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
                                                  TreeType& referenceNode)
 {
+  // The kernel values of the reference nodes are only kept for the current
+  // query point.
+  if (queryIndex != lastScoreQueryIndex)
+  {
+    nodeKernels.clear();
+    leafKernels.clear();
+    lastScoreQueryIndex = queryIndex;
+  }
+
   // Compare with the current best.
   const double bestKernel = products(products.n_rows - 1, queryIndex);
 
+  // Find the kernel value of the parent, if it has been scored for this query
+  // point already (which is the case for the cover tree traversers).
+  const typename std::unordered_map<const TreeType*, double>::const_iterator
+      parentKernel = (referenceNode.Parent() == NULL) ? nodeKernels.end() :
+      nodeKernels.find(referenceNode.Parent());
+
   // See if we can perform a parent-child prune.
   const double furthestDist = referenceNode.FurthestDescendantDistance();
-  if (referenceNode.Parent() != NULL)
+  if (parentKernel != nodeKernels.end())
   {
-    double maxKernelBound;
-    const double parentDist = referenceNode.ParentDistance();
-    const double combinedDistBound = parentDist + furthestDist;
-    const double lastKernel = referenceNode.Parent()->Stat().LastKernel();
-    if (kernel::KernelTraits<KernelType>::IsNormalized)
-    {
-      const double squaredDist = std::pow(combinedDistBound, 2.0);
-      const double delta = (1 - 0.5 * squaredDist);
-      if (lastKernel <= delta)
-      {
-        const double gamma = combinedDistBound * sqrt(1 - 0.25 * squaredDist);
-        maxKernelBound = lastKernel * delta +
-             gamma * sqrt(1 - std::pow(lastKernel, 2.0));
-      }
-      else
-      {
-        maxKernelBound = 1.0;
-      }
-    }
-    else
-    {
-      maxKernelBound = lastKernel +
-          combinedDistBound * queryKernels[queryIndex];
-    }
-
-    if (maxKernelBound < bestKernel)
+    const double combinedDistBound = referenceNode.ParentDistance() +
+        furthestDist;
+    if (MaxKernel(queryIndex, parentKernel->second, combinedDistBound) <
+        bestKernel)
       return DBL_MAX;
   }
 
@@ -145,10 +149,16 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
   {
     // Could it be that this kernel evaluation has already been calculated?
     if (tree::TreeTraits<TreeType>::HasSelfChildren &&
-        referenceNode.Parent() != NULL &&
+        parentKernel != nodeKernels.end() &&
         referenceNode.Point(0) == referenceNode.Parent()->Point(0))
     {
-      kernelEval = referenceNode.Parent()->Stat().LastKernel();
+      kernelEval = parentKernel->second;
+    }
+    else if (kernel::KernelTraits<KernelType>::HasBatchEvaluate &&
+        referenceNode.NumChildren() == 0 && parentKernel != nodeKernels.end())
+    {
+      kernelEval = LeafBaseCase(queryIndex, referenceNode,
+          parentKernel->second, bestKernel);
     }
     else
     {
@@ -163,28 +173,9 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     kernelEval = kernel.Evaluate(querySet.col(queryIndex), refCenter);
   }
 
-  referenceNode.Stat().LastKernel() = kernelEval;
+  nodeKernels[&referenceNode] = kernelEval;
 
-  double maxKernel;
-  if (kernel::KernelTraits<KernelType>::IsNormalized)
-  {
-    const double squaredDist = std::pow(furthestDist, 2.0);
-    const double delta = (1 - 0.5 * squaredDist);
-    if (kernelEval <= delta)
-    {
-      const double gamma = furthestDist * sqrt(1 - 0.25 * squaredDist);
-      maxKernel = kernelEval * delta +
-          gamma * sqrt(1 - std::pow(kernelEval, 2.0));
-    }
-    else
-    {
-      maxKernel = 1.0;
-    }
-  }
-  else
-  {
-    maxKernel = kernelEval + furthestDist * queryKernels[queryIndex];
-  }
+  const double maxKernel = MaxKernel(queryIndex, kernelEval, furthestDist);
 
   // We return the inverse of the maximum kernel so that larger kernels are
   // recursed into first.
@@ -487,6 +478,79 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   return (interA > interB) ? interA : interB;
 }
 
+template<typename KernelType, typename TreeType>
+inline double FastMKSRules<KernelType, TreeType>::MaxKernel(
+    const size_t queryIndex,
+    const double kernelEval,
+    const double distance) const
+{
+  if (kernel::KernelTraits<KernelType>::IsNormalized)
+  {
+    const double squaredDist = std::pow(distance, 2.0);
+    const double delta = (1 - 0.5 * squaredDist);
+    if (kernelEval <= delta)
+    {
+      const double gamma = distance * sqrt(1 - 0.25 * squaredDist);
+      return kernelEval * delta + gamma * sqrt(1 - std::pow(kernelEval, 2.0));
+    }
+
+    return 1.0;
+  }
+
+  return kernelEval + distance * queryKernels[queryIndex];
+}
+
+template<typename KernelType, typename TreeType>
+double FastMKSRules<KernelType, TreeType>::LeafBaseCase(
+    const size_t queryIndex,
+    TreeType& leaf,
+    const double parentKernel,
+    const double bestKernel)
+{
+  typename std::unordered_map<const TreeType*, double>::const_iterator it =
+      leafKernels.find(&leaf);
+  if (it == leafKernels.end())
+  {
+    // Collect the leaves under the same parent that can't be pruned with the
+    // kernel value of the parent (the others will never be scored, since the
+    // best kernel value only grows).  The self-leaf has the kernel value of
+    // the parent already.
+    const TreeType& parent = *leaf.Parent();
+    std::vector<const TreeType*> leaves;
+    for (size_t i = 0; i < parent.NumChildren(); ++i)
+    {
+      const TreeType& child = parent.Child(i);
+      if (child.NumChildren() == 0 && child.Point(0) != parent.Point(0) &&
+          MaxKernel(queryIndex, parentKernel, child.ParentDistance()) >=
+          bestKernel)
+        leaves.push_back(&child);
+    }
+
+    // The leaf being scored always passes, since it was not pruned.
+    if (leaves.size() <= 1)
+      return BaseCase(queryIndex, leaf.Point(0));
+
+    // The points are gathered into dense matrices (also for sparse datasets).
+    arma::mat leafPoints(referenceSet.n_rows, leaves.size());
+    for (size_t i = 0; i < leaves.size(); ++i)
+      leafPoints.col(i) = arma::mat(referenceSet.col(leaves[i]->Point(0)));
+    const arma::mat queryPoint(querySet.col(queryIndex));
+
+    arma::mat kernels;
+    kernel::KernelMatrix(kernel, leafPoints, queryPoint, kernels);
+    for (size_t i = 0; i < leaves.size(); ++i)
+      leafKernels[leaves[i]] = kernels[i];
+
+    it = leafKernels.find(&leaf);
+  }
+
+  // The traverser calls BaseCase() for the leaf next, which must not evaluate
+  // the kernel again.
+  lastQueryIndex = queryIndex;
+  lastReferenceIndex = leaf.Point(0);
+  return InsertBaseCase(queryIndex, leaf.Point(0), it->second);
+}
+
 /**
  * Helper function to insert a point into the neighbors and distances matrices.
  *
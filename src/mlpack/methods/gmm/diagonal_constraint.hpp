@@ -26,6 +26,10 @@ class DiagonalConstraint
     covariance = arma::diagmat(diagonal);
   }
 
+  //! A diagonal covariance matrix (given as the vector of its diagonal
+  //! elements) is already diagonal, so do nothing.
+  static void ApplyConstraint(const arma::vec& /* diagCovariance */) { }
+
   //! Serialize the constraint (which holds nothing, so, nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -0,0 +1,249 @@
+/**
+ * @file diagonal_gmm.cpp
+ *
+ * Implementation of the non-template DiagonalGMM methods.
+ */
+#include "diagonal_gmm.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * Create a GMM with the given number of Gaussians, each of which have the
+ * specified dimensionality.  The means and covariances will be set to 0.
+ *
+ * @param gaussians Number of Gaussians in this GMM.
+ * @param dimensionality Dimensionality of each Gaussian.
+ */
+DiagonalGMM::DiagonalGMM(const size_t gaussians,
+                         const size_t dimensionality) :
+    gaussians(gaussians),
+    dimensionality(dimensionality),
+    dists(gaussians,
+        distribution::DiagonalGaussianDistribution(dimensionality)),
+    weights(gaussians)
+{
+  // Set equal weights.  Technically this model is still valid, but only barely.
+  weights.fill(1.0 / gaussians);
+}
+
+// Copy constructor for when the other GMM uses the same fitting type.
+DiagonalGMM::DiagonalGMM(const DiagonalGMM& other) :
+    gaussians(other.Gaussians()),
+    dimensionality(other.dimensionality),
+    dists(other.dists),
+    weights(other.weights) { /* Nothing to do. */ }
+
+DiagonalGMM& DiagonalGMM::operator=(const DiagonalGMM& other)
+{
+  gaussians = other.gaussians;
+  dimensionality = other.dimensionality;
+  dists = other.dists;
+  weights = other.weights;
+
+  return *this;
+}
+
+/**
+ * Return the probability of the given observation being from this GMM.
+ */
+double DiagonalGMM::Probability(const arma::vec& observation) const
+{
+  // Sum the probability for each Gaussian in our mixture (and we have to
+  // multiply by the prior for each Gaussian too).
+  double sum = 0;
+  for (size_t i = 0; i < gaussians; i++)
+    sum += weights[i] * dists[i].Probability(observation);
+
+  return sum;
+}
+
+/**
+ * Return the probability of the given observation being from the given
+ * component in the mixture.
+ */
+double DiagonalGMM::Probability(const arma::vec& observation,
+                        const size_t component) const
+{
+  // We are only considering one Gaussian component -- so we only need to call
+  // Probability() once.  We do consider the prior probability!
+  return weights[component] * dists[component].Probability(observation);
+}
+
+/**
+ * Return the probability of each of the given observations being from this
+ * GMM.
+ */
+void DiagonalGMM::Probability(const arma::mat& observations,
+                              arma::vec& probabilities) const
+{
+  probabilities.zeros(observations.n_cols);
+
+  // Each thread takes a block of points at a time.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
+    arma::vec phis;
+    for (size_t i = 0; i < gaussians; i++)
+    {
+      dists[i].Probability(block, phis);
+      probabilities.subvec(begin, end - 1) += weights[i] * phis;
+    }
+  }
+}
+
+/**
+ * Return the log-probability of each of the given observations being from this
+ * GMM.
+ */
+void DiagonalGMM::LogProbability(const arma::mat& observations,
+                                 arma::vec& logProbabilities) const
+{
+  logProbabilities.set_size(observations.n_cols);
+
+  // Each thread takes a block of points at a time.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
+    arma::mat componentLogProbs(gaussians, block.n_cols);
+    arma::vec logProbs;
+    for (size_t i = 0; i < gaussians; i++)
+    {
+      dists[i].LogProbability(block, logProbs);
+      componentLogProbs.row(i) = trans(logProbs) + std::log(weights[i]);
+    }
+
+    // Sum the probabilities of the components relative to the largest one.
+    for (size_t j = 0; j < block.n_cols; ++j)
+    {
+      const double maxLogProb = componentLogProbs.col(j).max();
+      if (maxLogProb == -std::numeric_limits<double>::infinity())
+        logProbabilities[begin + j] = maxLogProb;
+      else
+        logProbabilities[begin + j] = maxLogProb + std::log(arma::accu(
+            arma::exp(componentLogProbs.col(j) - maxLogProb)));
+    }
+  }
+}
+
+/**
+ * Return a randomly generated observation according to the probability
+ * distribution defined by this object.
+ */
+arma::vec DiagonalGMM::Random() const
+{
+  // Determine which Gaussian it will be coming from.
+  double gaussRand = math::Random();
+  size_t gaussian = 0;
+
+  double sumProb = 0;
+  for (size_t g = 0; g < gaussians; g++)
+  {
+    sumProb += weights(g);
+    if (gaussRand <= sumProb)
+    {
+      gaussian = g;
+      break;
+    }
+  }
+
+  return dists[gaussian].Random();
+}
+
+/**
+ * Classify the given observations as being from an individual component in this
+ * GMM.
+ */
+void DiagonalGMM::Classify(const arma::mat& observations,
+                   arma::Row<size_t>& labels) const
+{
+  labels.set_size(observations.n_cols);
+
+  // Each thread takes a block of points at a time, and calculates the log
+  // probability of every component for all of those points at once.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
+    // Find maximum probability component.
+    arma::vec bestLogProbs(end - begin);
+    bestLogProbs.fill(-std::numeric_limits<double>::infinity());
+    arma::vec logProbs;
+    for (size_t j = 0; j < gaussians; ++j)
+    {
+      dists[j].LogProbability(block, logProbs);
+      logProbs += std::log(weights[j]);
+      for (size_t i = 0; i < block.n_cols; ++i)
+      {
+        if (logProbs[i] >= bestLogProbs[i])
+        {
+          bestLogProbs[i] = logProbs[i];
+          labels[begin + i] = j;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Get the log-likelihood of this data's fit to the model.
+ */
+double DiagonalGMM::LogLikelihood(
+    const arma::mat& data,
+    const std::vector<distribution::DiagonalGaussianDistribution>& distsL,
+    const arma::vec& weightsL) const
+{
+  arma::mat likelihoods(gaussians, data.n_cols);
+
+  // Each thread takes a block of points at a time.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize, (size_t) data.n_cols);
+    const arma::mat block = data.cols(begin, end - 1);
+
+    arma::vec phis;
+    for (size_t i = 0; i < gaussians; i++)
+    {
+      distsL[i].Probability(block, phis);
+      likelihoods.submat(i, begin, i, end - 1) = weightsL(i) * trans(phis);
+    }
+  }
+
+  // Now sum over every point, in order, so the result does not depend on the
+  // number of threads.
+  double loglikelihood = 0;
+  for (size_t j = 0; j < data.n_cols; j++)
+    loglikelihood += log(accu(likelihoods.col(j)));
+  return loglikelihood;
+}
+
+} // namespace gmm
+} // namespace mlpack
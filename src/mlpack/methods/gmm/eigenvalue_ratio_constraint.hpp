@@ -71,6 +71,21 @@ class EigenvalueRatioConstraint
     covariance = eigenvectors * arma::diagmat(eigenvalues) * eigenvectors.t();
   }
 
+  /**
+   * Apply the eigenvalue ratio constraint to the given diagonal covariance
+   * matrix, given as the vector of its diagonal elements (which are also its
+   * eigenvalues).
+   */
+  void ApplyConstraint(arma::vec& diagCovariance) const
+  {
+    // Sort the eigenvalues in the same order as eig_sym() gives them, then
+    // change them to what we are forcing them to be.
+    const arma::uvec order = arma::sort_index(diagCovariance);
+    const double first = diagCovariance[order[0]];
+    for (size_t i = 0; i < order.n_elem; ++i)
+      diagCovariance[order[i]] = first * ratios[i];
+  }
+
   //! Serialize the constraint.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
@@ -31,9 +31,18 @@ namespace gmm {
  *
  * This method should create 'clusters' clusters, and return the assignment of
  * each point to a cluster.
+ *
+ * The components of the model are of type DistributionType, which may be
+ * distribution::GaussianDistribution (full covariance matrices) or
+ * distribution::DiagonalGaussianDistribution (only the variance of each
+ * dimension is stored and estimated, which is O(d) per point instead of
+ * O(d^2)).  The covariance constraint must accept the same covariance type as
+ * the distribution: an arma::mat, or for diagonal Gaussians, the arma::vec of
+ * the variances.
  */
 template<typename InitialClusteringType = kmeans::KMeans<>,
-         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename DistributionType = distribution::GaussianDistribution>
 class EMFit
 {
  public:
@@ -75,7 +84,7 @@ class EMFit
    *      clustering.
    */
   void Estimate(const arma::mat& observations,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<DistributionType>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -98,7 +107,7 @@ class EMFit
    */
   void Estimate(const arma::mat& observations,
                 const arma::vec& probabilities,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<DistributionType>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -138,23 +147,49 @@ class EMFit
    * @param weights Vector to store a priori weights in.
    */
   void InitialClustering(const arma::mat& observations,
-                         std::vector<distribution::GaussianDistribution>& dists,
+                         std::vector<DistributionType>& dists,
                          arma::vec& weights);
 
   /**
-   * Calculate the log-likelihood of a model.  Yes, this is reimplemented in the
-   * GMM code.  Intuition suggests that the log-likelihood is not the best way
-   * to determine if the EM algorithm has converged.
+   * Calculate the conditional probability of each Gaussian given each
+   * observation (the E-step), and the log-likelihood of the model.  Yes, the
+   * log-likelihood is reimplemented in the GMM code.  Intuition suggests that
+   * the log-likelihood is not the best way to determine if the EM algorithm
+   * has converged.  The points are processed in parallel with OpenMP, and the
+   * results do not depend on the number of threads.
    *
-   * @param data Data matrix.
-   * @param means Vector of means.
-   * @param covariances Vector of covariance matrices.
+   * @param observations List of observations.
+   * @param dists Vector of Gaussians.
    * @param weights Vector of a priori weights.
+   * @param condProb Matrix to store the conditional probabilities in (one row
+   *      per observation, one column per Gaussian).
+   * @return The log-likelihood of the model.
+   */
+  double ConditionalProbabilities(
+      const arma::mat& observations,
+      const std::vector<DistributionType>& dists,
+      const arma::vec& weights,
+      arma::mat& condProb) const;
+
+  /**
+   * Calculate the new means and covariances of the Gaussians from the
+   * (possibly weighted) conditional probabilities (the M-step), and apply the
+   * covariance constraint.  Gaussians with no probability of having points are
+   * not changed.  The sums are calculated in parallel with OpenMP, and the
+   * results do not depend on the number of threads.
+   *
+   * @param observations List of observations.
+   * @param condProb Conditional probabilities (one row per observation, one
+   *      column per Gaussian).
+   * @param dists Vector of Gaussians to update.
+   * @param probRowSums Vector to store the sum of the conditional probabilities
+   *      of each Gaussian in.
    */
-  double LogLikelihood(const arma::mat& data,
-                       const std::vector<distribution::GaussianDistribution>&
-                           dists,
-                       const arma::vec& weights) const;
+  void UpdateDistributions(
+      const arma::mat& observations,
+      const arma::mat& condProb,
+      std::vector<DistributionType>& dists,
+      arma::vec& probRowSums);
 
   //! Maximum iterations of EM algorithm.
   size_t maxIterations;
@@ -14,9 +14,31 @@
 namespace mlpack {
 namespace gmm {
 
+//! Add the outer products of the columns of a and b to the given covariance
+//! matrix.
+inline void AddCovariance(const arma::mat& a,
+                          const arma::mat& b,
+                          arma::mat& covariance)
+{
+  covariance += a * trans(b);
+}
+
+//! Add the outer products of the columns of a and b to the given diagonal
+//! covariance matrix (the vector of its diagonal elements).  Only the diagonal
+//! of the outer products is calculated.
+inline void AddCovariance(const arma::mat& a,
+                          const arma::mat& b,
+                          arma::vec& covariance)
+{
+  covariance += arma::sum(a % b, 1);
+}
+
 //! Constructor.
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::EMFit(
     const size_t maxIterations,
     const double tolerance,
     InitialClusteringType clusterer,
@@ -27,10 +49,13 @@ EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
     constraint(constraint)
 { /* Nothing to do. */ }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
     const arma::mat& observations,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<DistributionType>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
@@ -38,69 +63,28 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
   if (!useInitialModel)
     InitialClustering(observations, dists, weights);
 
-  double l = LogLikelihood(observations, dists, weights);
+  // The conditional probabilities of the current model are computed along with
+  // its log-likelihood, so they are ready for the next iteration.
+  arma::mat condProb(observations.n_cols, dists.size());
+  double l = ConditionalProbabilities(observations, dists, weights, condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
-    Log::Info << "EMFit::Estimate(): iteration " << iteration << ", "
-        << "log-likelihood " << l << "." << std::endl;
+    MLPACK_LOG(Log::Info) << "EMFit::Estimate(): iteration " << iteration
+        << ", log-likelihood " << l << "." << std::endl;
 
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
-    // Store the sum of the probability of each state over all the observations.
-    arma::vec probRowSums = trans(arma::sum(condProb, 0 /* columnwise */));
-
-    // Calculate the new value of the means using the updated conditional
-    // probabilities.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0)
-        dists[i].Mean() = (observations * condProb.col(i)) / probRowSums[i];
-
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i)));
-
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0.0)
-      {
-        arma::mat covariance = (tmp * trans(tmpB)) / probRowSums[i];
-        // Apply covariance constraint.
-        constraint.ApplyConstraint(covariance);
-        dists[i].Covariance(std::move(covariance));
-      }
-    }
+    // Calculate the new means and covariances using the conditional
+    // probabilities of choosing a particular Gaussian given the observations
+    // and the present theta value.
+    arma::vec probRowSums;
+    UpdateDistributions(observations, condProb, dists, probRowSums);
 
     // Calculate the new values for omega using the updated conditional
     // probabilities.
@@ -108,87 +92,46 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
 
     // Update values of l; calculate new log-likelihood.
     lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+    l = ConditionalProbabilities(observations, dists, weights, condProb);
 
     iteration++;
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
     const arma::mat& observations,
     const arma::vec& probabilities,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<DistributionType>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
   if (!useInitialModel)
     InitialClustering(observations, dists, weights);
 
-  double l = LogLikelihood(observations, dists, weights);
+  arma::mat condProb(observations.n_cols, dists.size());
+  double l = ConditionalProbabilities(observations, dists, weights, condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
+    // Multiply the conditional probability of each point being from each
+    // Gaussian by the probability of the point being from this mixture model.
+    condProb.each_col() %= probabilities;
 
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
-    // This will store the sum of probabilities of each state over all the
-    // observations.
-    arma::vec probRowSums(dists.size());
-
-    // Calculate the new value of the means using the updated conditional
+    // Calculate the new means and covariances using the updated conditional
     // probabilities.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Calculate the sum of probabilities of points, which is the
-      // conditional probability of each point being from Gaussian i
-      // multiplied by the probability of the point being from this mixture
-      // model.
-      probRowSums[i] = accu(condProb.col(i) % probabilities);
-
-      dists[i].Mean() = (observations * (condProb.col(i) % probabilities)) /
-        probRowSums[i];
-
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i) % probabilities));
-
-      arma::mat cov = (tmp * trans(tmpB)) / probRowSums[i];
-
-      // Apply covariance constraint.
-      constraint.ApplyConstraint(cov);
-
-      dists[i].Covariance(std::move(cov));
-    }
+    arma::vec probRowSums;
+    UpdateDistributions(observations, condProb, dists, probRowSums);
 
     // Calculate the new values for omega using the updated conditional
     // probabilities.
@@ -196,16 +139,19 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
 
     // Update values of l; calculate new log-likelihood.
     lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+    l = ConditionalProbabilities(observations, dists, weights, condProb);
 
     iteration++;
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::
 InitialClustering(const arma::mat& observations,
-                  std::vector<distribution::GaussianDistribution>& dists,
+                  std::vector<DistributionType>& dists,
                   arma::vec& weights)
 {
   // Assignments from clustering.
@@ -214,8 +160,10 @@ InitialClustering(const arma::mat& observations,
   // Run clustering algorithm.
   clusterer.Cluster(observations, dists.size(), assignments);
 
+  typedef typename std::decay<decltype(dists[0].Covariance())>::type
+      CovarianceType;
   std::vector<arma::vec> means(dists.size());
-  std::vector<arma::mat> covs(dists.size());
+  std::vector<CovarianceType> covs(dists.size());
 
   // Now calculate the means, covariances, and weights.
   weights.zeros();
@@ -235,7 +183,7 @@ InitialClustering(const arma::mat& observations,
     means[cluster] += observations.col(i);
 
     // Add this to the relevant covariance.
-    covs[cluster] += observations.col(i) * trans(observations.col(i));
+    AddCovariance(observations.col(i), observations.col(i), covs[cluster]);
 
     // Now add one to the weights (we will normalize).
     weights[cluster]++;
@@ -251,7 +199,7 @@ InitialClustering(const arma::mat& observations,
   {
     const size_t cluster = assignments[i];
     const arma::vec normObs = observations.col(i) - means[cluster];
-    covs[cluster] += normObs * normObs.t();
+    AddCovariance(normObs, normObs, covs[cluster]);
   }
 
   for (size_t i = 0; i < dists.size(); ++i)
@@ -269,37 +217,183 @@ InitialClustering(const arma::mat& observations,
   weights /= accu(weights);
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::LogLikelihood(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::
+ConditionalProbabilities(
     const arma::mat& observations,
-    const std::vector<distribution::GaussianDistribution>& dists,
-    const arma::vec& weights) const
+    const std::vector<DistributionType>& dists,
+    const arma::vec& weights,
+    arma::mat& condProb) const
 {
-  double logLikelihood = 0;
+  condProb.set_size(observations.n_cols, dists.size());
+  arma::vec likelihoods(observations.n_cols);
 
-  arma::vec phis;
-  arma::mat likelihoods(dists.size(), observations.n_cols);
+  // Each thread takes a block of points at a time, and calculates the
+  // likelihood of each Gaussian for all of those points at once.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
 
-  for (size_t i = 0; i < dists.size(); ++i)
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
   {
-    dists[i].Probability(observations, phis);
-    likelihoods.row(i) = weights(i) * trans(phis);
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
+    arma::vec phis;
+    for (size_t i = 0; i < dists.size(); ++i)
+    {
+      dists[i].Probability(block, phis);
+      condProb.submat(begin, i, end - 1, i) = weights[i] * phis;
+    }
+
+    // Normalize row-wise.
+    for (size_t j = begin; j < end; ++j)
+    {
+      // Avoid dividing by zero; if the probability for everything is 0, we
+      // don't want to make it NaN.
+      likelihoods[j] = accu(condProb.row(j));
+      if (likelihoods[j] != 0.0)
+        condProb.row(j) /= likelihoods[j];
+    }
   }
-  // Now sum over every point.
+
+  // Now sum over every point, in order, so the result does not depend on the
+  // number of threads.
+  double logLikelihood = 0;
   for (size_t j = 0; j < observations.n_cols; ++j)
   {
-    if (accu(likelihoods.col(j)) == 0)
-      Log::Info << "Likelihood of point " << j << " is 0!  It is probably an "
-          << "outlier." << std::endl;
-    logLikelihood += log(accu(likelihoods.col(j)));
+    if (likelihoods[j] == 0)
+      MLPACK_LOG(Log::Info) << "Likelihood of point " << j << " is 0!  It is "
+          << "probably an outlier." << std::endl;
+    logLikelihood += log(likelihoods[j]);
   }
 
   return logLikelihood;
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::
+UpdateDistributions(
+    const arma::mat& observations,
+    const arma::mat& condProb,
+    std::vector<DistributionType>& dists,
+    arma::vec& probRowSums)
+{
+  // The points are split into groups of consecutive points, and the sums of
+  // each Gaussian over each group are calculated in parallel.  The number of
+  // groups only depends on the number of Gaussians and points (not on the
+  // number of threads), and the sums of the groups are added up in order, so
+  // the results do not depend on the number of threads.  There are enough
+  // groups to keep 64 threads busy, even with only a few Gaussians.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+  const size_t numGroups = std::max((size_t) 1,
+      std::min(numBlocks, 64 / std::max(dists.size(), (size_t) 1)));
+  const size_t numTasks = dists.size() * numGroups;
+
+  // The first point of each group; group g holds the points groupBegins[g] to
+  // groupBegins[g + 1] - 1.
+  arma::Col<size_t> groupBegins(numGroups + 1);
+  for (size_t g = 0; g <= numGroups; ++g)
+    groupBegins[g] = std::min(g * numBlocks / numGroups * blockSize,
+        (size_t) observations.n_cols);
+
+  // Calculate the weighted sum of the points of each group for each Gaussian.
+  arma::mat meanSums(observations.n_rows, numTasks, arma::fill::zeros);
+  arma::vec probSums(numTasks, arma::fill::zeros);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t t = 0; t < (omp_size_t) numTasks; ++t)
+  {
+    const size_t i = t / numGroups;
+    const size_t begin = groupBegins[t % numGroups];
+    const size_t end = groupBegins[t % numGroups + 1];
+    if (begin == end)
+      continue;
+
+    meanSums.col(t) = observations.cols(begin, end - 1) *
+        condProb.submat(begin, i, end - 1, i);
+    probSums[t] = accu(condProb.submat(begin, i, end - 1, i));
+  }
+
+  // Calculate the new value of the means using the updated conditional
+  // probabilities.
+  probRowSums.zeros(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    arma::vec mean(observations.n_rows, arma::fill::zeros);
+    for (size_t g = 0; g < numGroups; ++g)
+    {
+      mean += meanSums.col(i * numGroups + g);
+      probRowSums[i] += probSums[i * numGroups + g];
+    }
+
+    // Don't update if there's no probability of the Gaussian having points.
+    if (probRowSums[i] != 0)
+      dists[i].Mean() = mean / probRowSums[i];
+  }
+
+  // Calculate the new value of the covariances using the updated conditional
+  // probabilities and the updated means.  Each group is handled one block at a
+  // time, so there is no need for a copy of the whole dataset.
+  typedef typename std::decay<decltype(dists[0].Covariance())>::type
+      CovarianceType;
+  std::vector<CovarianceType> covSums(numTasks);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t t = 0; t < (omp_size_t) numTasks; ++t)
+  {
+    const size_t i = t / numGroups;
+    covSums[t].zeros(dists[i].Covariance().n_rows,
+        dists[i].Covariance().n_cols);
+    if (probRowSums[i] == 0.0)
+      continue;
+
+    const size_t groupEnd = groupBegins[t % numGroups + 1];
+    for (size_t begin = groupBegins[t % numGroups]; begin < groupEnd;
+        begin += blockSize)
+    {
+      const size_t end = std::min(begin + blockSize, groupEnd);
+      arma::mat tmp = observations.cols(begin, end - 1);
+      tmp.each_col() -= dists[i].Mean();
+      arma::mat tmpB = tmp;
+      tmpB.each_row() %= trans(condProb.submat(begin, i, end - 1, i));
+
+      AddCovariance(tmp, tmpB, covSums[t]);
+    }
+  }
+
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // Don't update if there's no probability of the Gaussian having points.
+    if (probRowSums[i] == 0.0)
+      continue;
+
+    CovarianceType covariance = covSums[i * numGroups];
+    for (size_t g = 1; g < numGroups; ++g)
+      covariance += covSums[i * numGroups + g];
+    covariance /= probRowSums[i];
+
+    // Apply covariance constraint.
+    constraint.ApplyConstraint(covariance);
+    dists[i].Covariance(std::move(covariance));
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
 template<typename Archive>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Serialize(
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Serialize(
     Archive& ar,
     const unsigned int /* version */)
 {
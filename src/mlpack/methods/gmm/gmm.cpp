@@ -71,6 +71,78 @@ double GMM::Probability(const arma::vec& observation,
   return weights[component] * dists[component].Probability(observation);
 }
 
+/**
+ * Return the probability of each of the given observations being from this
+ * GMM.
+ */
+void GMM::Probability(const arma::mat& observations,
+                      arma::vec& probabilities) const
+{
+  probabilities.zeros(observations.n_cols);
+
+  // Each thread takes a block of points at a time.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
+    arma::vec phis;
+    for (size_t i = 0; i < gaussians; i++)
+    {
+      dists[i].Probability(block, phis);
+      probabilities.subvec(begin, end - 1) += weights[i] * phis;
+    }
+  }
+}
+
+/**
+ * Return the log-probability of each of the given observations being from this
+ * GMM.
+ */
+void GMM::LogProbability(const arma::mat& observations,
+                         arma::vec& logProbabilities) const
+{
+  logProbabilities.set_size(observations.n_cols);
+
+  // Each thread takes a block of points at a time.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
+    arma::mat componentLogProbs(gaussians, block.n_cols);
+    arma::vec logProbs;
+    for (size_t i = 0; i < gaussians; i++)
+    {
+      dists[i].LogProbability(block, logProbs);
+      componentLogProbs.row(i) = trans(logProbs) + std::log(weights[i]);
+    }
+
+    // Sum the probabilities of the components relative to the largest one.
+    for (size_t j = 0; j < block.n_cols; ++j)
+    {
+      const double maxLogProb = componentLogProbs.col(j).max();
+      if (maxLogProb == -std::numeric_limits<double>::infinity())
+        logProbabilities[begin + j] = maxLogProb;
+      else
+        logProbabilities[begin + j] = maxLogProb + std::log(arma::accu(
+            arma::exp(componentLogProbs.col(j) - maxLogProb)));
+    }
+  }
+}
+
 /**
  * Return a randomly generated observation according to the probability
  * distribution defined by this object.
@@ -103,22 +175,36 @@ arma::vec GMM::Random() const
 void GMM::Classify(const arma::mat& observations,
                    arma::Row<size_t>& labels) const
 {
-  // This is not the best way to do this!
-
-  // We should not have to fill this with values, because each one should be
-  // overwritten.
   labels.set_size(observations.n_cols);
-  for (size_t i = 0; i < observations.n_cols; ++i)
+
+  // Each thread takes a block of points at a time, and calculates the log
+  // probability of every component for all of those points at once.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
   {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize,
+        (size_t) observations.n_cols);
+    const arma::mat block = observations.cols(begin, end - 1);
+
     // Find maximum probability component.
-    double probability = 0;
+    arma::vec bestLogProbs(end - begin);
+    bestLogProbs.fill(-std::numeric_limits<double>::infinity());
+    arma::vec logProbs;
     for (size_t j = 0; j < gaussians; ++j)
     {
-      double newProb = Probability(observations.unsafe_col(i), j);
-      if (newProb >= probability)
+      dists[j].LogProbability(block, logProbs);
+      logProbs += std::log(weights[j]);
+      for (size_t i = 0; i < block.n_cols; ++i)
       {
-        probability = newProb;
-        labels[i] = j;
+        if (logProbs[i] >= bestLogProbs[i])
+        {
+          bestLogProbs[i] = logProbs[i];
+          labels[begin + i] = j;
+        }
       }
     }
   }
@@ -132,17 +218,30 @@ double GMM::LogLikelihood(
     const std::vector<distribution::GaussianDistribution>& distsL,
     const arma::vec& weightsL) const
 {
-  double loglikelihood = 0;
-  arma::vec phis;
   arma::mat likelihoods(gaussians, data.n_cols);
 
-  for (size_t i = 0; i < gaussians; i++)
+  // Each thread takes a block of points at a time.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
   {
-    distsL[i].Probability(data, phis);
-    likelihoods.row(i) = weightsL(i) * trans(phis);
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize, (size_t) data.n_cols);
+    const arma::mat block = data.cols(begin, end - 1);
+
+    arma::vec phis;
+    for (size_t i = 0; i < gaussians; i++)
+    {
+      distsL[i].Probability(block, phis);
+      likelihoods.submat(i, begin, i, end - 1) = weightsL(i) * trans(phis);
+    }
   }
 
-  // Now sum over every point.
+  // Now sum over every point, in order, so the result does not depend on the
+  // number of threads.
+  double loglikelihood = 0;
   for (size_t j = 0; j < data.n_cols; j++)
     loglikelihood += log(accu(likelihoods.col(j)));
   return loglikelihood;
@@ -13,6 +13,8 @@
 
 // This is the default fitting method class.
 #include "em_fit.hpp"
+// Online fitting method class, which can also update a trained model.
+#include "online_em_fit.hpp"
 
 namespace mlpack {
 namespace gmm /** Gaussian Mixture Models. */ {
@@ -170,6 +172,30 @@ class GMM
   double Probability(const arma::vec& observation,
                      const size_t component) const;
 
+  /**
+   * Calculate the probability that each of the given observations (one per
+   * column) came from this distribution.  The observations are handled in
+   * blocks, in parallel, with the batch probability functions of the
+   * components.
+   *
+   * @param observations Observations to evaluate the probability of.
+   * @param probabilities Output probability of each observation.
+   */
+  void Probability(const arma::mat& observations,
+                   arma::vec& probabilities) const;
+
+  /**
+   * Calculate the log-probability that each of the given observations (one
+   * per column) came from this distribution, like the batch Probability(), but
+   * with the log-probabilities of the components (summed with the log-sum-exp
+   * trick), so observations far from every component don't underflow to 0.
+   *
+   * @param observations Observations to evaluate the log-probability of.
+   * @param logProbabilities Output log-probability of each observation.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities) const;
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -191,6 +217,12 @@ class GMM
    * is deterministic after the initial position is given, then 'trials' should
    * be set to 1.
    *
+   * The trials are independent, so several of them run at once, each with its
+   * own copy of the fitter and its own random number stream (so the result
+   * doesn't depend on the number of threads); the threads (see ThreadPool) are
+   * split between the trials that run at once and the parallel loops of each
+   * trial.  By default, as many trials as there are threads run at once.
+   *
    * @tparam FittingType The type of fitting method which should be used
    *     (EMFit<> is suggested).
    * @param observations Observations of the model.
@@ -198,13 +230,17 @@ class GMM
    *      the greatest log-likelihood will be selected.
    * @param useExistingModel If true, the existing model is used as an initial
    *      model for the estimation.
+   * @param fitter The fitter to use (each trial uses a copy).
+   * @param trialThreads Number of trials to run at once (0 means as many as
+   *      there are threads).
    * @return The log-likelihood of the best fit.
    */
   template<typename FittingType = EMFit<>>
   double Train(const arma::mat& observations,
                const size_t trials = 1,
                const bool useExistingModel = false,
-               FittingType fitter = FittingType());
+               FittingType fitter = FittingType(),
+               const size_t trialThreads = 0);
 
   /**
    * Estimate the probability distribution directly from the given observations,
@@ -221,6 +257,12 @@ class GMM
    * is deterministic after the initial position is given, then 'trials' should
    * be set to 1.
    *
+   * The trials are independent, so several of them run at once, each with its
+   * own copy of the fitter and its own random number stream (so the result
+   * doesn't depend on the number of threads); the threads (see ThreadPool) are
+   * split between the trials that run at once and the parallel loops of each
+   * trial.  By default, as many trials as there are threads run at once.
+   *
    * @param observations Observations of the model.
    * @param probabilities Probability of each observation being from this
    *     distribution.
@@ -228,6 +270,9 @@ class GMM
    *     the greatest log-likelihood will be selected.
    * @param useExistingModel If true, the existing model is used as an initial
    *     model for the estimation.
+   * @param fitter The fitter to use (each trial uses a copy).
+   * @param trialThreads Number of trials to run at once (0 means as many as
+   *     there are threads).
    * @return The log-likelihood of the best fit.
    */
   template<typename FittingType = EMFit<>>
@@ -235,7 +280,22 @@ class GMM
                const arma::vec& probabilities,
                const size_t trials = 1,
                const bool useExistingModel = false,
-               FittingType fitter = FittingType());
+               FittingType fitter = FittingType(),
+               const size_t trialThreads = 0);
+
+  /**
+   * Update the trained model with the given batch of observations, using the
+   * given online fitter (OnlineEMFit<> is suggested).  Only the batch is used,
+   * so a model can be refreshed continuously from a stream of observations
+   * without holding the older ones.  The fitter keeps the step count (and so
+   * the step size), and must be kept between calls to Update().
+   *
+   * @tparam UpdaterType The type of online fitting method which should be used.
+   * @param batch Batch of new observations.
+   * @param updater Online fitter to update the model with.
+   */
+  template<typename UpdaterType>
+  void Update(const arma::mat& batch, UpdaterType& updater);
 
   /**
    * Classify the given observations as being from an individual component in
@@ -276,6 +336,28 @@ class GMM
       const arma::mat& dataPoints,
       const std::vector<distribution::GaussianDistribution>& distsL,
       const arma::vec& weights) const;
+
+  /**
+   * Run the trials of Train() and keep the model with the greatest
+   * log-likelihood.
+   *
+   * @param observations Observations of the model.
+   * @param trials Number of trials to perform.
+   * @param fitter The fitter to use (each trial uses a copy).
+   * @param trialThreads Number of trials to run at once (0 means as many as
+   *     there are threads).
+   * @param estimate Function which fits a model with the given fitter.
+   * @param useExistingModel If true, each trial starts from the existing
+   *     model.
+   * @return The log-likelihood of the best fit.
+   */
+  template<typename FittingType, typename EstimateFunctionType>
+  double TrainTrials(const arma::mat& observations,
+                     const size_t trials,
+                     FittingType& fitter,
+                     const size_t trialThreads,
+                     EstimateFunctionType estimate,
+                     const bool useExistingModel);
 };
 
 } // namespace gmm
@@ -22,77 +22,17 @@ template<typename FittingType>
 double GMM::Train(const arma::mat& observations,
                   const size_t trials,
                   const bool useExistingModel,
-                  FittingType fitter)
+                  FittingType fitter,
+                  const size_t trialThreads)
 {
-  double bestLikelihood; // This will be reported later.
-
-  // We don't need to store temporary models if we are only doing one trial.
-  if (trials == 1)
-  {
-    // Train the model.  The user will have been warned earlier if the GMM was
-    // initialized with no parameters (0 gaussians, dimensionality of 0).
-    fitter.Estimate(observations, dists, weights, useExistingModel);
-    bestLikelihood = LogLikelihood(observations, dists, weights);
-  }
-  else
-  {
-    if (trials == 0)
-      return -DBL_MAX; // It's what they asked for...
-
-    // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
-    arma::vec weightsOrig;
-    if (useExistingModel)
-    {
-      distsOrig = dists;
-      weightsOrig = weights;
-    }
-
-    // We need to keep temporary copies.  We'll do the first training into the
-    // actual model position, so that if it's the best we don't need to copy it.
-    fitter.Estimate(observations, dists, weights, useExistingModel);
-
-    bestLikelihood = LogLikelihood(observations, dists, weights);
-
-    Log::Info << "GMM::Train(): Log-likelihood of trial 0 is " << bestLikelihood        << "." << std::endl;
-
-    // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
-    arma::vec weightsTrial(gaussians);
-
-    for (size_t trial = 1; trial < trials; ++trial)
-    {
-      if (useExistingModel)
-      {
-        distsTrial = distsOrig;
-        weightsTrial = weightsOrig;
-      }
-
-      fitter.Estimate(observations, distsTrial, weightsTrial, useExistingModel);
-
-      // Check to see if the log-likelihood of this one is better.
-      double newLikelihood = LogLikelihood(observations, distsTrial,
-          weightsTrial);
-
-      Log::Info << "GMM::Train(): Log-likelihood of trial " << trial << " is "
-          << newLikelihood << "." << std::endl;
-
-      if (newLikelihood > bestLikelihood)
+  return TrainTrials(observations, trials, fitter, trialThreads,
+      [&observations, useExistingModel](FittingType& trialFitter,
+          std::vector<distribution::GaussianDistribution>& trialDists,
+          arma::vec& trialWeights)
       {
-        // Save new likelihood and copy new model.
-        bestLikelihood = newLikelihood;
-
-        dists = distsTrial;
-        weights = weightsTrial;
-      }
-    }
-  }
-
-  // Report final log-likelihood and return it.
-  Log::Info << "GMM::Train(): log-likelihood of trained GMM is "
-      << bestLikelihood << "." << std::endl;
-  return bestLikelihood;
+        trialFitter.Estimate(observations, trialDists, trialWeights,
+            useExistingModel);
+      }, useExistingModel);
 }
 
 /**
@@ -104,7 +44,31 @@ double GMM::Train(const arma::mat& observations,
                   const arma::vec& probabilities,
                   const size_t trials,
                   const bool useExistingModel,
-                  FittingType fitter)
+                  FittingType fitter,
+                  const size_t trialThreads)
+{
+  return TrainTrials(observations, trials, fitter, trialThreads,
+      [&observations, &probabilities, useExistingModel](
+          FittingType& trialFitter,
+          std::vector<distribution::GaussianDistribution>& trialDists,
+          arma::vec& trialWeights)
+      {
+        trialFitter.Estimate(observations, probabilities, trialDists,
+            trialWeights, useExistingModel);
+      }, useExistingModel);
+}
+
+/**
+ * Run the trials of Train(), concurrently if there are several, and keep the
+ * model with the greatest log-likelihood.
+ */
+template<typename FittingType, typename EstimateFunctionType>
+double GMM::TrainTrials(const arma::mat& observations,
+                        const size_t trials,
+                        FittingType& fitter,
+                        const size_t trialThreads,
+                        EstimateFunctionType estimate,
+                        const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -113,8 +77,7 @@ double GMM::Train(const arma::mat& observations,
   {
     // Train the model.  The user will have been warned earlier if the GMM was
     // initialized with no parameters (0 gaussians, dimensionality of 0).
-    fitter.Estimate(observations, probabilities, dists, weights,
-        useExistingModel);
+    estimate(fitter, dists, weights);
     bestLikelihood = LogLikelihood(observations, dists, weights);
   }
   else
@@ -122,56 +85,83 @@ double GMM::Train(const arma::mat& observations,
     if (trials == 0)
       return -DBL_MAX; // It's what they asked for...
 
-    // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
-    arma::vec weightsOrig;
-    if (useExistingModel)
-    {
-      distsOrig = dists;
-      weightsOrig = weights;
-    }
-
-    // We need to keep temporary copies.  We'll do the first training into the
-    // actual model position, so that if it's the best we don't need to copy it.
-    fitter.Estimate(observations, probabilities, dists, weights,
-        useExistingModel);
-
-    bestLikelihood = LogLikelihood(observations, dists, weights);
-
-    Log::Debug << "GMM::Train(): Log-likelihood of trial 0 is "
-        << bestLikelihood << "." << std::endl;
-
-    // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
-    arma::vec weightsTrial(gaussians);
-
-    for (size_t trial = 1; trial < trials; ++trial)
+    // Each trial starts from the existing model, if we should use it, and
+    // trains its own copy of the model.
+    std::vector<std::vector<distribution::GaussianDistribution>> trialDists(
+        trials, useExistingModel ? dists :
+        std::vector<distribution::GaussianDistribution>(gaussians,
+        distribution::GaussianDistribution(dimensionality)));
+    std::vector<arma::vec> trialWeights(trials, useExistingModel ? weights :
+        arma::vec(gaussians));
+    std::vector<double> likelihoods(trials);
+    std::vector<std::exception_ptr> errors(trials);
+
+    // Split the threads between the trials that run at once and the parallel
+    // loops of each trial (which need nested parallelism).
+    const size_t threads = ThreadPool::Threads();
+    const size_t concurrentTrials = std::min(trials,
+        (trialThreads == 0) ? threads : trialThreads);
+    const size_t innerThreads = std::max((size_t) 1,
+        threads / concurrentTrials);
+    #if defined(_OPENMP) && (_OPENMP >= 200805)
+      const int oldLevels = omp_get_max_active_levels();
+      if (concurrentTrials > 1 && innerThreads > 1)
+        omp_set_max_active_levels(std::max(oldLevels, 2));
+    #endif
+
+    const math::RandomStreams streams;
+    #pragma omp parallel for schedule(dynamic) \
+        num_threads((int) concurrentTrials)
+    for (omp_size_t t = 0; t < (omp_size_t) trials; ++t)
     {
-      if (useExistingModel)
+      #ifdef _OPENMP
+        if (omp_in_parallel())
+          omp_set_num_threads((int) innerThreads);
+      #endif
+
+      // Each trial draws its random numbers from its own stream, so they don't
+      // depend on the thread that runs it, or on the number of threads; the
+      // generator of the thread is left alone.
+      std::mt19937 generator = streams.Stream(t);
+      const math::RandomGeneratorScope randomScope(generator);
+
+      // Exceptions can't leave the parallel loop; the first one is rethrown
+      // afterwards.
+      try
       {
-        distsTrial = distsOrig;
-        weightsTrial = weightsOrig;
+        FittingType trialFitter(fitter);
+        estimate(trialFitter, trialDists[t], trialWeights[t]);
+        likelihoods[t] = LogLikelihood(observations, trialDists[t],
+            trialWeights[t]);
       }
+      catch (...)
+      {
+        errors[t] = std::current_exception();
+      }
+    }
 
-      fitter.Estimate(observations, distsTrial, weightsTrial, useExistingModel);
-
-      // Check to see if the log-likelihood of this one is better.
-      double newLikelihood = LogLikelihood(observations, distsTrial,
-          weightsTrial);
+    #if defined(_OPENMP) && (_OPENMP >= 200805)
+      omp_set_max_active_levels(oldLevels);
+    #endif
 
-      Log::Debug << "GMM::Train(): Log-likelihood of trial " << trial << " is "
-          << newLikelihood << "." << std::endl;
+    // Keep the trial with the greatest log-likelihood (the first one, if there
+    // are ties).
+    size_t best = 0;
+    for (size_t t = 0; t < trials; ++t)
+    {
+      if (errors[t])
+        std::rethrow_exception(errors[t]);
 
-      if (newLikelihood > bestLikelihood)
-      {
-        // Save new likelihood and copy new model.
-        bestLikelihood = newLikelihood;
+      Log::Info << "GMM::Train(): Log-likelihood of trial " << t << " is "
+          << likelihoods[t] << "." << std::endl;
 
-        dists = distsTrial;
-        weights = weightsTrial;
-      }
+      if (likelihoods[t] > likelihoods[best])
+        best = t;
     }
+
+    bestLikelihood = likelihoods[best];
+    dists = std::move(trialDists[best]);
+    weights = std::move(trialWeights[best]);
   }
 
   // Report final log-likelihood and return it.
@@ -180,6 +170,15 @@ double GMM::Train(const arma::mat& observations,
   return bestLikelihood;
 }
 
+/**
+ * Update the model with a batch of observations.
+ */
+template<typename UpdaterType>
+void GMM::Update(const arma::mat& batch, UpdaterType& updater)
+{
+  updater.Step(batch, dists, weights);
+}
+
 /**
  * Serialize the object.
  */
@@ -5,6 +5,7 @@
  * Given a GMM, calculate the probability of points coming from it.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/batch_server.hpp>
 #include "gmm.hpp"
 
 using namespace std;
@@ -16,13 +17,21 @@ PROGRAM_INFO("GMM Probability Calculator",
     "given GMM (that is, P(X | gmm)).  The GMM is specified with the "
     "--input_model_file option, and the points are specified with the "
     "--input_file option.  The output probabilities are stored in the file "
-    "specified by the --output_file option.");
+    "specified by the --output_file option."
+    "\n\n"
+    "With --serve, the GMM is loaded once, and then batches of points are read "
+    "from the standard input until it ends, and the probabilities of each "
+    "batch are written to the standard output (one probability per column).  "
+    "The batches and the responses are matrices in the native binary (.mlbin) "
+    "format, and the output is flushed after each response.");
 
 PARAM_STRING_REQ("input_model_file", "File containing input GMM.", "m");
-PARAM_STRING_REQ("input_file", "File containing points.", "i");
+PARAM_STRING("input_file", "File containing points.", "i", "");
 
 PARAM_STRING("output_file", "File to save calculated probabilities to.", "o",
     "");
+PARAM_FLAG("serve", "If set, answer batches of points read from the standard "
+    "input, and write their probabilities to the standard output.", "");
 
 int main(int argc, char** argv)
 {
@@ -30,25 +39,67 @@ int main(int argc, char** argv)
 
   const string inputFile = CLI::GetParam<string>("input_file");
   const string inputModelFile = CLI::GetParam<string>("input_model_file");
-  const string outputFile = CLI::GetParam<string>("input_model_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
 
-  if (CLI::HasParam("output_file"))
-    Log::Warn << "--output_file (-o) is not specified;"
-        << "no results will be saved!" << endl;
+  if (CLI::HasParam("serve"))
+  {
+    if (CLI::HasParam("input_file") || CLI::HasParam("output_file"))
+      Log::Warn << "--input_file (-i) and --output_file (-o) will be ignored "
+          << "because --serve is specified." << endl;
+  }
+  else
+  {
+    if (!CLI::HasParam("input_file"))
+      Log::Fatal << "--input_file (-i) must be specified unless --serve is "
+          << "given!" << endl;
+    if (!CLI::HasParam("output_file"))
+      Log::Warn << "--output_file (-o) is not specified; "
+          << "no results will be saved!" << endl;
+  }
 
-  // Get the GMM and the points.
+  // Get the GMM.
   GMM gmm;
-  data::Load(inputFile, "gmm", gmm);
+  data::Load(inputModelFile, "gmm", gmm);
+
+  if (CLI::HasParam("serve"))
+  {
+    // The responses go to the standard output, so the messages that would be
+    // printed there are sent to the standard error for the rest of the
+    // program.
+    std::ostream responses(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    data::BatchServer<double> server(std::cin, responses);
+    arma::mat batch;
+    arma::vec probabilities;
+    while (server.Next(batch))
+    {
+      if (batch.n_rows != gmm.Dimensionality())
+      {
+        Log::Fatal << "Batch " << server.Batches() << " has " << batch.n_rows
+            << " dimensions, but the GMM has " << gmm.Dimensionality()
+            << " dimensions!" << endl;
+      }
+
+      gmm.Probability(batch, probabilities);
+      server.Reply(arma::mat(trans(probabilities)));
+      server.Flush();
+    }
+
+    return 0;
+  }
 
   arma::mat dataset;
-  data::Load(inputModelFile, dataset);
+  data::Load(inputFile, dataset);
 
   // Now calculate the probabilities.
-  arma::rowvec probabilities(dataset.n_cols);
-  for (size_t i = 0; i < dataset.n_cols; ++i)
-    probabilities[i] = gmm.Probability(dataset.unsafe_col(i));
+  arma::vec probabilities;
+  gmm.Probability(dataset, probabilities);
 
-  // And save the result.
+  // And save the result (one probability per column).
   if (CLI::HasParam("output_file"))
-    data::Save(outputFile, probabilities);
+  {
+    const arma::rowvec output = trans(probabilities);
+    data::Save(outputFile, output);
+  }
 }
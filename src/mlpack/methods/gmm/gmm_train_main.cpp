@@ -37,7 +37,10 @@ PROGRAM_INFO("Gaussian Mixture Model (GMM) Training",
     "cause the program to crash."
     "\n\n"
     "Optionally, multiple trials may be performed, by specifying the --trials "
-    "option.  The model with greatest log-likelihood will be taken.");
+    "option.  The model with greatest log-likelihood will be taken.  The "
+    "trials are run in parallel; --trial_threads sets how many of them run at "
+    "once (by default, as many as there are threads), and the other threads "
+    "are used within each trial.");
 
 // Parameters for training.
 PARAM_STRING_REQ("input_file", "File containing the data on which the model "
@@ -46,6 +49,8 @@ PARAM_INT_REQ("gaussians", "Number of Gaussians in the GMM.", "g");
 
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_INT("trials", "Number of trials to perform in training GMM.", "t", 1);
+PARAM_INT("trial_threads", "Number of trials to run at once (0 means as many "
+    "as there are threads).", "R", 0);
 
 // Parameters for EM algorithm.
 PARAM_DOUBLE("tolerance", "Tolerance for convergence of EM.", "T", 1e-10);
@@ -90,6 +95,14 @@ int main(int argc, char* argv[])
         "be greater than or equal to 1." << std::endl;
   }
 
+  if (CLI::GetParam<int>("trial_threads") < 0)
+  {
+    Log::Fatal << "Invalid number of trial threads ("
+        << CLI::GetParam<int>("trial_threads") << "); must be greater than or "
+        << "equal to 0." << std::endl;
+  }
+  const size_t trialThreads = (size_t) CLI::GetParam<int>("trial_threads");
+
   if (!CLI::HasParam("output_model_file"))
     Log::Warn << "--output_model_file is not specified, so no model will be "
         << "saved!" << endl;
@@ -157,7 +170,7 @@ int main(int argc, char* argv[])
       Timer::Start("em");
       EMFit<KMeansType> em(maxIterations, tolerance, k);
       likelihood = gmm.Train(dataPoints, CLI::GetParam<int>("trials"), false,
-          em);
+          em, trialThreads);
       Timer::Stop("em");
     }
     else
@@ -166,7 +179,7 @@ int main(int argc, char* argv[])
       Timer::Start("em");
       EMFit<KMeansType, NoConstraint> em(maxIterations, tolerance, k);
       likelihood = gmm.Train(dataPoints, CLI::GetParam<int>("trials"), false,
-          em);
+          em, trialThreads);
       Timer::Stop("em");
     }
   }
@@ -179,7 +192,7 @@ int main(int argc, char* argv[])
       Timer::Start("em");
       EMFit<> em(maxIterations, tolerance);
       likelihood = gmm.Train(dataPoints, CLI::GetParam<int>("trials"), false,
-          em);
+          em, trialThreads);
       Timer::Stop("em");
     }
     else
@@ -188,7 +201,7 @@ int main(int argc, char* argv[])
       Timer::Start("em");
       EMFit<KMeans<>, NoConstraint> em(maxIterations, tolerance);
       likelihood = gmm.Train(dataPoints, CLI::GetParam<int>("trials"), false,
-          em);
+          em, trialThreads);
       Timer::Stop("em");
     }
   }
@@ -0,0 +1,233 @@
+/**
+ * @file kd_tree_em_fit.hpp
+ *
+ * Utility class to fit a GMM using the EM algorithm accelerated by a kd-tree
+ * (an mrkd-tree).  Used by GMM::Train<>().
+ *
+ * The method is described in the following paper:
+ *
+ * @inproceedings{moore1999very,
+ *   title={Very fast {EM}-based mixture model clustering using
+ *       multiresolution kd-trees},
+ *   author={Moore, A.W.},
+ *   booktitle={Advances in Neural Information Processing Systems 11 (NIPS
+ *       1998)},
+ *   pages={543--549},
+ *   year={1999}
+ * }
+ */
+#ifndef MLPACK_METHODS_GMM_KD_TREE_EM_FIT_HPP
+#define MLPACK_METHODS_GMM_KD_TREE_EM_FIT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+
+// The initial model is fitted with EMFit.
+#include "em_fit.hpp"
+#include "mrkd_statistic.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class fits a GMM to observations with the EM algorithm, like EMFit, but
+ * the E-step is accelerated with a kd-tree whose nodes hold the sufficient
+ * statistics of their points (see MRKDStatistic).  For each node, the bounding
+ * box of the node gives bounds on the responsibility of each component for any
+ * point of the node; if no responsibility can change by more than the given
+ * responsibility tolerance within the node, every point of the node is given
+ * the responsibilities of the centroid of the node, and the whole node is added
+ * to the M-step at once.  Otherwise, the children of the node are visited, and
+ * the points of the leaves are handled one by one.
+ *
+ * This is much faster than EMFit for large low-dimensional datasets, where only
+ * the nodes near the boundaries between components need to be opened.  The
+ * bounds become loose in high dimensions, so EMFit should be preferred there.
+ * With a responsibility tolerance of 0, a node is only pruned when the
+ * responsibilities of its points are all the same (up to rounding), so the
+ * result is the same as with EMFit.  The log-likelihood used to check for
+ * convergence is approximated in the same way as the responsibilities.
+ *
+ * The InitialClusteringType and CovarianceConstraintPolicy template parameters
+ * are the same as for EMFit.  The components must be GaussianDistributions.
+ *
+ * @code
+ * GMM gmm(20, 3);
+ * KDTreeEMFit<> fitter;
+ * gmm.Train(data, 1, false, fitter);
+ * @endcode
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+class KDTreeEMFit
+{
+ public:
+  //! The type of tree used to accelerate the E-step.
+  typedef tree::KDTree<metric::EuclideanDistance, MRKDStatistic, arma::mat>
+      Tree;
+
+  /**
+   * Construct the KDTreeEMFit object.  Setting the maximum number of iterations
+   * to 0 means that the EM algorithm will iterate until convergence (with the
+   * given tolerance).
+   *
+   * @param maxIterations Maximum number of iterations for EM.
+   * @param tolerance Log-likelihood tolerance required for convergence.
+   * @param responsibilityTolerance Maximum range of the responsibility of any
+   *     component within a node for the node to be handled at once.
+   * @param leafSize Maximum number of points in a leaf of the kd-tree.
+   * @param clusterer Object which will perform the initial clustering.
+   * @param constraint Object which applies constraints to the covariances.
+   */
+  KDTreeEMFit(const size_t maxIterations = 300,
+              const double tolerance = 1e-10,
+              const double responsibilityTolerance = 0.01,
+              const size_t leafSize = 20,
+              InitialClusteringType clusterer = InitialClusteringType(),
+              CovarianceConstraintPolicy constraint =
+                  CovarianceConstraintPolicy());
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using the
+   * tree-accelerated EM algorithm.  The size of the vectors (indicating the
+   * number of components) must already be set.  Optionally, if useInitialModel
+   * is set to true, then the model given in the dists and weights parameters is
+   * used as the initial model, instead of using the
+   * InitialClusteringType::Cluster() option.
+   *
+   * @param observations List of observations to train on.
+   * @param dists Vector of Gaussians to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                std::vector<distribution::GaussianDistribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using the
+   * tree-accelerated EM algorithm, taking into account the probabilities of
+   * each point being from this mixture.  See the other overload for details.
+   *
+   * @param observations List of observations to train on.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector of Gaussians to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities,
+                std::vector<distribution::GaussianDistribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  //! Get the clusterer.
+  const InitialClusteringType& Clusterer() const { return clusterer; }
+  //! Modify the clusterer.
+  InitialClusteringType& Clusterer() { return clusterer; }
+
+  //! Get the covariance constraint policy class.
+  const CovarianceConstraintPolicy& Constraint() const { return constraint; }
+  //! Modify the covariance constraint policy class.
+  CovarianceConstraintPolicy& Constraint() { return constraint; }
+
+  //! Get the maximum number of iterations of the EM algorithm.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations of the EM algorithm.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for the convergence of the EM algorithm.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for the convergence of the EM algorithm.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the maximum range of responsibilities for a node to be pruned.
+  double ResponsibilityTolerance() const { return responsibilityTolerance; }
+  //! Modify the maximum range of responsibilities for a node to be pruned.
+  double& ResponsibilityTolerance() { return responsibilityTolerance; }
+
+  //! Get the maximum number of points in a leaf of the kd-tree.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the maximum number of points in a leaf of the kd-tree.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the number of nodes pruned during the last call to Estimate().
+  size_t NumPrunes() const { return numPrunes; }
+
+  //! Serialize the fitter.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+ private:
+  /**
+   * Run EM with the given tree (whose statistics are already computed).  This
+   * is a helper function for both overloads of Estimate().
+   */
+  void EstimateTree(const arma::mat& observations,
+                    Tree& tree,
+                    const arma::vec& pointWeights,
+                    std::vector<distribution::GaussianDistribution>& dists,
+                    arma::vec& weights,
+                    const bool useInitialModel);
+
+  /**
+   * Cache the inverse covariance, the extreme eigenvalues of the covariance and
+   * the log of the weight and normalizing constant of each component.
+   */
+  void CacheComponents(
+      const std::vector<distribution::GaussianDistribution>& dists,
+      const arma::vec& weights);
+
+  /**
+   * Accumulate the sufficient statistics of each component over the points of
+   * the given node (the E-step), and return the (approximate) log-likelihood of
+   * the points of the node.
+   */
+  double ExpectationStep(const Tree& node,
+                         const arma::vec& pointWeights,
+                         const std::vector<distribution::GaussianDistribution>&
+                             dists);
+
+  //! Sufficient statistics of each component, accumulated by
+  //! ExpectationStep().
+  arma::vec weightSums;
+  //! Weighted sum of the points of each component.
+  arma::mat meanSums;
+  //! Weighted sum of the outer products of the points of each component.
+  std::vector<arma::mat> momentSums;
+
+  //! Cached inverse covariance of each component.
+  std::vector<arma::mat> invCovs;
+  //! Cached log of the weight and normalizing constant of each component.
+  arma::vec logNorms;
+  //! Cached smallest eigenvalue of the covariance of each component.
+  arma::vec minEigvals;
+  //! Cached largest eigenvalue of the covariance of each component.
+  arma::vec maxEigvals;
+
+  //! Maximum iterations of EM algorithm.
+  size_t maxIterations;
+  //! Tolerance for convergence of EM.
+  double tolerance;
+  //! Maximum range of responsibilities for a node to be pruned.
+  double responsibilityTolerance;
+  //! Maximum number of points in a leaf of the kd-tree.
+  size_t leafSize;
+  //! Number of nodes pruned during the last call to Estimate().
+  size_t numPrunes;
+  //! Object which will perform the clustering.
+  InitialClusteringType clusterer;
+  //! Object which applies constraints to the covariance matrix.
+  CovarianceConstraintPolicy constraint;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "kd_tree_em_fit_impl.hpp"
+
+#endif
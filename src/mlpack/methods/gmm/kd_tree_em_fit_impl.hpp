@@ -0,0 +1,321 @@
+/**
+ * @file kd_tree_em_fit_impl.hpp
+ *
+ * Implementation of the kd-tree accelerated EM algorithm for fitting GMMs.
+ */
+#ifndef MLPACK_METHODS_GMM_KD_TREE_EM_FIT_IMPL_HPP
+#define MLPACK_METHODS_GMM_KD_TREE_EM_FIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kd_tree_em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+//! Constructor.
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::KDTreeEMFit(
+    const size_t maxIterations,
+    const double tolerance,
+    const double responsibilityTolerance,
+    const size_t leafSize,
+    InitialClusteringType clusterer,
+    CovarianceConstraintPolicy constraint) :
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    responsibilityTolerance(responsibilityTolerance),
+    leafSize(leafSize),
+    numPrunes(0),
+    clusterer(clusterer),
+    constraint(constraint)
+{ /* Nothing to do. */ }
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+    const arma::mat& observations,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  numPrunes = 0;
+  if (observations.n_cols == 0)
+    return;
+
+  // The statistics of the tree are computed when it is built.
+  Tree tree(observations, leafSize);
+  EstimateTree(observations, tree, arma::vec(), dists, weights,
+      useInitialModel);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  numPrunes = 0;
+  if (observations.n_cols == 0)
+    return;
+
+  // The tree reorders the points, so the probabilities must be reordered the
+  // same way before the statistics are computed again with them.
+  std::vector<size_t> oldFromNew;
+  Tree tree(observations, oldFromNew, leafSize);
+
+  arma::vec pointWeights(observations.n_cols);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+    pointWeights[i] = probabilities[oldFromNew[i]];
+  MRKDStatistic::Compute(tree, pointWeights);
+
+  EstimateTree(observations, tree, pointWeights, dists, weights,
+      useInitialModel);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+EstimateTree(const arma::mat& observations,
+             Tree& tree,
+             const arma::vec& pointWeights,
+             std::vector<distribution::GaussianDistribution>& dists,
+             arma::vec& weights,
+             const bool useInitialModel)
+{
+  // Only perform initial clustering if the user wanted it.  An EMFit with a
+  // maximum of one iteration only performs the initial clustering.
+  if (!useInitialModel)
+  {
+    EMFit<InitialClusteringType, CovarianceConstraintPolicy> initialFit(1,
+        tolerance, clusterer, constraint);
+    initialFit.Estimate(observations, dists, weights, false);
+  }
+
+  const double totalWeight = tree.Stat().Weight();
+
+  CacheComponents(dists, weights);
+  double l = ExpectationStep(tree, pointWeights, dists);
+
+  Log::Debug << "KDTreeEMFit::Estimate(): initial clustering log-likelihood: "
+      << l << std::endl;
+
+  double lOld = -DBL_MAX;
+
+  // Iterate to update the model until no more improvement is found.
+  size_t iteration = 1;
+  while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
+  {
+    Log::Info << "KDTreeEMFit::Estimate(): iteration " << iteration << ", "
+        << "log-likelihood " << l << "." << std::endl;
+
+    // Calculate the new means and covariances from the sufficient statistics
+    // accumulated by the E-step.
+    for (size_t i = 0; i < dists.size(); ++i)
+    {
+      // Don't update if there's no probability of the Gaussian having points.
+      if (weightSums[i] == 0.0)
+        continue;
+
+      arma::vec mean = meanSums.col(i) / weightSums[i];
+      arma::mat covariance = momentSums[i] / weightSums[i] - mean *
+          trans(mean);
+
+      // Apply covariance constraint.
+      constraint.ApplyConstraint(covariance);
+
+      dists[i].Mean() = std::move(mean);
+      dists[i].Covariance(std::move(covariance));
+    }
+
+    // Calculate the new values for omega.
+    weights = weightSums / totalWeight;
+
+    // Update values of l; calculate new log-likelihood.
+    lOld = l;
+    CacheComponents(dists, weights);
+    l = ExpectationStep(tree, pointWeights, dists);
+
+    iteration++;
+  }
+
+  Log::Info << "KDTreeEMFit::Estimate(): " << numPrunes << " nodes pruned in "
+      << iteration << " E-steps." << std::endl;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+CacheComponents(const std::vector<distribution::GaussianDistribution>& dists,
+                const arma::vec& weights)
+{
+  const double log2pi = 1.83787706640934533908193770912475883;
+  const size_t dimensionality = dists[0].Mean().n_elem;
+
+  invCovs.resize(dists.size());
+  logNorms.set_size(dists.size());
+  minEigvals.set_size(dists.size());
+  maxEigvals.set_size(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    arma::vec eigenvalues;
+    arma::mat eigenvectors;
+    arma::eig_sym(eigenvalues, eigenvectors, dists[i].Covariance());
+
+    minEigvals[i] = eigenvalues.min();
+    maxEigvals[i] = eigenvalues.max();
+    invCovs[i] = eigenvectors * arma::diagmat(1.0 / eigenvalues) *
+        trans(eigenvectors);
+    logNorms[i] = std::log(weights[i]) - 0.5 * (dimensionality * log2pi +
+        arma::accu(arma::log(eigenvalues)));
+  }
+
+  // Clear the sufficient statistics for the next E-step.
+  weightSums.zeros(dists.size());
+  meanSums.zeros(dimensionality, dists.size());
+  momentSums.resize(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+    momentSums[i].zeros(dimensionality, dimensionality);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+double KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ExpectationStep(const Tree& node,
+                const arma::vec& pointWeights,
+                const std::vector<distribution::GaussianDistribution>& dists)
+{
+  const MRKDStatistic& stat = node.Stat();
+  if (stat.Weight() == 0.0)
+    return 0.0;
+
+  // The log of the weighted density of each component is bounded over the
+  // bounding box of the node, using the distance from the mean to the box and
+  // the eigenvalues of the covariance to bound the Mahalanobis distance.
+  const size_t numComponents = dists.size();
+  arma::vec logMin(numComponents), logMax(numComponents);
+  for (size_t i = 0; i < numComponents; ++i)
+  {
+    const double minDistance = node.Bound().MinDistance(dists[i].Mean());
+    const double maxDistance = node.Bound().MaxDistance(dists[i].Mean());
+    logMax[i] = logNorms[i] - 0.5 * minDistance * minDistance / maxEigvals[i];
+    logMin[i] = logNorms[i] - 0.5 * maxDistance * maxDistance / minEigvals[i];
+  }
+
+  // From these, bound the responsibility of each component.  Components with
+  // no weight have no responsibility anywhere.
+  bool prune = true;
+  for (size_t i = 0; i < numComponents && prune; ++i)
+  {
+    if (!std::isfinite(logNorms[i]))
+      continue;
+
+    double otherMin = 0.0, otherMax = 0.0;
+    for (size_t j = 0; j < numComponents; ++j)
+    {
+      if (j == i || !std::isfinite(logNorms[j]))
+        continue;
+
+      otherMin += std::exp(logMin[j] - logMax[i]);
+      otherMax += std::exp(logMax[j] - logMin[i]);
+    }
+
+    const double maxResponsibility = 1.0 / (1.0 + otherMin);
+    const double minResponsibility = 1.0 / (1.0 + otherMax);
+    if (maxResponsibility - minResponsibility > responsibilityTolerance)
+      prune = false;
+  }
+
+  arma::vec logProbs(numComponents);
+  if (prune)
+  {
+    // Every point of the node gets the responsibilities of the centroid.
+    ++numPrunes;
+    const arma::vec centroid = stat.Sum() / stat.Weight();
+    for (size_t i = 0; i < numComponents; ++i)
+    {
+      const arma::vec diff = centroid - dists[i].Mean();
+      logProbs[i] = logNorms[i] - 0.5 * arma::dot(diff, invCovs[i] * diff);
+    }
+
+    arma::vec responsibilities = arma::exp(logProbs - logProbs.max());
+    responsibilities /= arma::accu(responsibilities);
+
+    for (size_t i = 0; i < numComponents; ++i)
+    {
+      weightSums[i] += responsibilities[i] * stat.Weight();
+      meanSums.col(i) += responsibilities[i] * stat.Sum();
+      momentSums[i] += responsibilities[i] * stat.Moment();
+    }
+
+    // The log-likelihood of a point is the log of the weighted density of any
+    // component minus the log of its responsibility.  The sum of the former
+    // over the node can be computed exactly from the statistics of the node, so
+    // only the responsibility (of the most likely component) is approximated.
+    arma::uword best;
+    responsibilities.max(best);
+    const arma::vec& mean = dists[best].Mean();
+    const arma::vec invCovMean = invCovs[best] * mean;
+    const double mahalanobisSum = arma::accu(invCovs[best] % stat.Moment()) -
+        2.0 * arma::dot(invCovMean, stat.Sum()) + stat.Weight() *
+        arma::dot(mean, invCovMean);
+
+    return stat.Weight() * (logNorms[best] - std::log(responsibilities[best]))
+        - 0.5 * mahalanobisSum;
+  }
+
+  // Otherwise, recurse into the children, or handle each point of a leaf.
+  double logLikelihood = 0.0;
+  for (size_t c = 0; c < node.NumChildren(); ++c)
+    logLikelihood += ExpectationStep(node.Child(c), pointWeights, dists);
+
+  for (size_t p = 0; p < node.NumPoints(); ++p)
+  {
+    const size_t point = node.Point(p);
+    const double weight = pointWeights.is_empty() ? 1.0 : pointWeights[point];
+    if (weight == 0.0)
+      continue;
+
+    const arma::vec x = node.Dataset().col(point);
+    for (size_t i = 0; i < numComponents; ++i)
+    {
+      const arma::vec diff = x - dists[i].Mean();
+      logProbs[i] = logNorms[i] - 0.5 * arma::dot(diff, invCovs[i] * diff);
+    }
+
+    // If the point can't belong to any component, ignore it.
+    const double maxLogProb = logProbs.max();
+    if (!std::isfinite(maxLogProb))
+      continue;
+
+    arma::vec responsibilities = arma::exp(logProbs - maxLogProb);
+    const double sum = arma::accu(responsibilities);
+    responsibilities *= weight / sum;
+    logLikelihood += weight * (maxLogProb + std::log(sum));
+
+    weightSums += responsibilities;
+    meanSums += x * trans(responsibilities);
+    for (size_t i = 0; i < numComponents; ++i)
+      momentSums[i] += responsibilities[i] * x * trans(x);
+  }
+
+  return logLikelihood;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+template<typename Archive>
+void KDTreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(maxIterations, "maxIterations");
+  ar & CreateNVP(tolerance, "tolerance");
+  ar & CreateNVP(responsibilityTolerance, "responsibilityTolerance");
+  ar & CreateNVP(leafSize, "leafSize");
+  ar & CreateNVP(clusterer, "clusterer");
+  ar & CreateNVP(constraint, "constraint");
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file mrkd_statistic.hpp
+ *
+ * A StatisticType for trees which holds the sufficient statistics of the points
+ * of a node, as in the mrkd-trees of Moore.  Used by KDTreeEMFit.
+ */
+#ifndef MLPACK_METHODS_GMM_MRKD_STATISTIC_HPP
+#define MLPACK_METHODS_GMM_MRKD_STATISTIC_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * A statistic for trees which holds the (weighted) number of points of a node,
+ * the sum of the points, and the sum of the outer products of the points.  From
+ * these, the contribution of all the points of a node to the M-step of EM can
+ * be computed at once when every point of the node has nearly the same
+ * responsibilities.  When the statistic is built with the tree, every point has
+ * a weight of 1; the weights can be changed afterwards with Compute().
+ */
+class MRKDStatistic
+{
+ public:
+  //! Initialize the statistic without a node (this does nothing).
+  MRKDStatistic() : weight(0.0) { }
+
+  //! Initialize the statistic for a node; this calculates the unweighted
+  //! sufficient statistics of the node from those of its children.
+  template<typename TreeType>
+  MRKDStatistic(TreeType& node) :
+      weight(0.0)
+  {
+    arma::vec pointWeights;
+    Accumulate(node, pointWeights);
+  }
+
+  /**
+   * Recalculate the sufficient statistics of the given node and all of its
+   * descendants with the given weight for each point (in the order of the
+   * dataset held by the tree).
+   *
+   * @param node Node to calculate the statistics of.
+   * @param pointWeights Weight of each point of the tree's dataset.
+   */
+  template<typename TreeType>
+  static void Compute(TreeType& node, const arma::vec& pointWeights)
+  {
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+      Compute(node.Child(i), pointWeights);
+
+    node.Stat().Accumulate(node, pointWeights);
+  }
+
+  //! Get the total weight of the points of the node.
+  double Weight() const { return weight; }
+  //! Get the weighted sum of the points of the node.
+  const arma::vec& Sum() const { return sum; }
+  //! Get the weighted sum of the outer products of the points of the node.
+  const arma::mat& Moment() const { return moment; }
+
+  /**
+   * Serialize the statistic.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    ar & CreateNVP(weight, "weight");
+    ar & CreateNVP(sum, "sum");
+    ar & CreateNVP(moment, "moment");
+  }
+
+ private:
+  /**
+   * Calculate the statistics of the node from those of its children and from
+   * its own points.  If pointWeights is empty, each point has a weight of 1.
+   */
+  template<typename TreeType>
+  void Accumulate(TreeType& node, const arma::vec& pointWeights)
+  {
+    const size_t dimensionality = node.Dataset().n_rows;
+    weight = 0.0;
+    sum.zeros(dimensionality);
+    moment.zeros(dimensionality, dimensionality);
+
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      weight += node.Child(i).Stat().Weight();
+      sum += node.Child(i).Stat().Sum();
+      moment += node.Child(i).Stat().Moment();
+    }
+
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+    {
+      const size_t point = node.Point(i);
+      const double w = pointWeights.is_empty() ? 1.0 : pointWeights[point];
+      weight += w;
+      sum += w * node.Dataset().col(point);
+      moment += w * node.Dataset().col(point) *
+          trans(node.Dataset().col(point));
+    }
+  }
+
+  //! The total weight of the points of the node.
+  double weight;
+  //! The weighted sum of the points of the node.
+  arma::vec sum;
+  //! The weighted sum of the outer products of the points of the node.
+  arma::mat moment;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file online_em_fit.hpp
+ *
+ * Utility class to fit a GMM with online (stochastic) EM on mini-batches.
+ * Used by GMM::Train<>() and GMM::Update<>().
+ *
+ * The method is described in the following paper:
+ *
+ * @article{cappe2009online,
+ *   title={On-line expectation-maximization algorithm for latent data models},
+ *   author={Capp{\'e}, O. and Moulines, E.},
+ *   journal={Journal of the Royal Statistical Society: Series B (Statistical
+ *       Methodology)},
+ *   volume={71},
+ *   number={3},
+ *   pages={593--613},
+ *   year={2009}
+ * }
+ */
+#ifndef MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+#define MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+
+#include <mlpack/core.hpp>
+
+// The initial model is fitted with EMFit.
+#include "em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class fits a GMM to observations with online EM: the observations are
+ * processed one mini-batch at a time, and each mini-batch moves the sufficient
+ * statistics of the model (the weight, the weighted mean and the weighted
+ * second moment of each component) towards the statistics of the mini-batch.
+ * After t mini-batches, the step size is (t + stepOffset)^(-decay), so the
+ * model adapts quickly at first and then settles down; a decay between 0.5 and
+ * 1 ensures convergence.  Only one mini-batch needs to be held at a time.
+ *
+ * OnlineEMFit can be used as the FittingType of GMM::Train(), in which case the
+ * dataset is shuffled and passed over the given number of times.  It can also
+ * refresh an already trained model with new data through GMM::Update(), one
+ * batch at a time, without holding the older data:
+ *
+ * @code
+ * GMM gmm(10, data.n_rows);
+ * OnlineEMFit<> fitter(1000);
+ * gmm.Train(data, 1, false, fitter);
+ *
+ * // Then, whenever a new batch arrives...
+ * gmm.Update(batch, fitter);
+ * @endcode
+ *
+ * The fitter keeps the number of steps it has taken, which sets the step size
+ * of the next step.  A fresh fitter takes a large first step, so before using
+ * one to update a model that was trained elsewhere, set Steps() to roughly the
+ * number of batches the model has already seen.
+ *
+ * The InitialClusteringType, CovarianceConstraintPolicy and DistributionType
+ * template parameters are the same as for EMFit.  If no initial model is given,
+ * the initial model is fitted by the InitialClusteringType on the first
+ * mini-batch.
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename DistributionType = distribution::GaussianDistribution>
+class OnlineEMFit
+{
+ public:
+  /**
+   * Construct the OnlineEMFit object.  A std::invalid_argument is thrown if the
+   * batch size is 0, if the decay is not in (0, 1], or if the step offset is
+   * less than 1.
+   *
+   * @param batchSize Number of points in each mini-batch used by Estimate().
+   * @param passes Number of passes over the dataset made by Estimate().
+   * @param decay Decay exponent of the step size.
+   * @param stepOffset Offset of the step count in the step size.
+   * @param clusterer Object which will perform the initial clustering.
+   * @param constraint Object which applies constraints to the covariances.
+   */
+  OnlineEMFit(const size_t batchSize = 1000,
+              const size_t passes = 3,
+              const double decay = 0.6,
+              const double stepOffset = 1.0,
+              InitialClusteringType clusterer = InitialClusteringType(),
+              CovarianceConstraintPolicy constraint =
+                  CovarianceConstraintPolicy());
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using online EM
+   * over shuffled mini-batches, starting with a step count of 0.  The size of
+   * the vectors (indicating the number of components) must already be set.
+   * Optionally, if useInitialModel is set to true, then the model given in the
+   * dists and weights parameters is used as the initial model, instead of
+   * clustering the first mini-batch.
+   *
+   * @param observations List of observations to train on.
+   * @param dists Vector of components to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                std::vector<DistributionType>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using online EM
+   * over shuffled mini-batches, taking into account the probabilities of each
+   * point being from this mixture.  See the other overload for details.
+   *
+   * @param observations List of observations to train on.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector of components to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities,
+                std::vector<DistributionType>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Take one online EM step with the given mini-batch, and increase the step
+   * count.  The model must already be initialized, and a std::invalid_argument
+   * is thrown if the dimensionality of the batch does not match it.
+   *
+   * @param batch Mini-batch of observations.
+   * @param dists Vector of components to update.
+   * @param weights Vector of a priori weights to update.
+   */
+  void Step(const arma::mat& batch,
+            std::vector<DistributionType>& dists,
+            arma::vec& weights);
+
+  /**
+   * Take one online EM step with the given mini-batch, taking into account the
+   * probability of each point being from this mixture, and increase the step
+   * count.
+   *
+   * @param batch Mini-batch of observations.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector of components to update.
+   * @param weights Vector of a priori weights to update.
+   */
+  void Step(const arma::mat& batch,
+            const arma::vec& probabilities,
+            std::vector<DistributionType>& dists,
+            arma::vec& weights);
+
+  //! Get the step size of the next step.
+  double StepSize() const { return std::pow(steps + stepOffset, -decay); }
+
+  //! Get the number of steps taken so far.
+  size_t Steps() const { return steps; }
+  //! Modify the number of steps taken so far.
+  size_t& Steps() { return steps; }
+
+  //! Get the number of points in each mini-batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points in each mini-batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of passes over the dataset made by Estimate().
+  size_t Passes() const { return passes; }
+  //! Modify the number of passes over the dataset made by Estimate().
+  size_t& Passes() { return passes; }
+
+  //! Get the decay exponent of the step size.
+  double Decay() const { return decay; }
+  //! Modify the decay exponent of the step size.
+  double& Decay() { return decay; }
+
+  //! Get the offset of the step count in the step size.
+  double StepOffset() const { return stepOffset; }
+  //! Modify the offset of the step count in the step size.
+  double& StepOffset() { return stepOffset; }
+
+  //! Get the clusterer.
+  const InitialClusteringType& Clusterer() const { return clusterer; }
+  //! Modify the clusterer.
+  InitialClusteringType& Clusterer() { return clusterer; }
+
+  //! Get the covariance constraint policy class.
+  const CovarianceConstraintPolicy& Constraint() const { return constraint; }
+  //! Modify the covariance constraint policy class.
+  CovarianceConstraintPolicy& Constraint() { return constraint; }
+
+  //! Serialize the fitter.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+ private:
+  /**
+   * Shuffle the observations, fit the initial model if needed, and then pass
+   * over the mini-batches.  This is a helper function for both overloads of
+   * Estimate(); if probabilities is empty, every point has probability 1.
+   */
+  void EstimateBatches(const arma::mat& observations,
+                       const arma::vec& probabilities,
+                       std::vector<DistributionType>& dists,
+                       arma::vec& weights,
+                       const bool useInitialModel);
+
+  //! Number of points in each mini-batch.
+  size_t batchSize;
+  //! Number of passes over the dataset made by Estimate().
+  size_t passes;
+  //! Decay exponent of the step size.
+  double decay;
+  //! Offset of the step count in the step size.
+  double stepOffset;
+  //! Number of steps taken so far.
+  size_t steps;
+  //! Object which will perform the clustering.
+  InitialClusteringType clusterer;
+  //! Object which applies constraints to the covariance matrix.
+  CovarianceConstraintPolicy constraint;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "online_em_fit_impl.hpp"
+
+#endif
@@ -0,0 +1,287 @@
+/**
+ * @file online_em_fit_impl.hpp
+ *
+ * Implementation of online EM for fitting GMMs.
+ */
+#ifndef MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+#define MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+//! Constructor.
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::OnlineEMFit(
+    const size_t batchSize,
+    const size_t passes,
+    const double decay,
+    const double stepOffset,
+    InitialClusteringType clusterer,
+    CovarianceConstraintPolicy constraint) :
+    batchSize(batchSize),
+    passes(passes),
+    decay(decay),
+    stepOffset(stepOffset),
+    steps(0),
+    clusterer(clusterer),
+    constraint(constraint)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("OnlineEMFit::OnlineEMFit(): batch size must "
+        "be greater than 0");
+
+  if (decay <= 0.0 || decay > 1.0)
+  {
+    std::ostringstream oss;
+    oss << "OnlineEMFit::OnlineEMFit(): decay (" << decay << ") must be in "
+        << "(0, 1]";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (stepOffset < 1.0)
+  {
+    std::ostringstream oss;
+    oss << "OnlineEMFit::OnlineEMFit(): step offset (" << stepOffset << ") "
+        << "must be at least 1";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
+    const arma::mat& observations,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  EstimateBatches(observations, arma::vec(), dists, weights, useInitialModel);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  EstimateBatches(observations, probabilities, dists, weights,
+      useInitialModel);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Step(
+    const arma::mat& batch,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights)
+{
+  Step(batch, arma::ones<arma::vec>(batch.n_cols), dists, weights);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Step(
+    const arma::mat& batch,
+    const arma::vec& probabilities,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights)
+{
+  if (dists.empty())
+    throw std::invalid_argument("OnlineEMFit::Step(): the model has no "
+        "components");
+
+  if (batch.n_rows != dists[0].Dimensionality())
+  {
+    std::ostringstream oss;
+    oss << "OnlineEMFit::Step(): dimensionality of batch (" << batch.n_rows
+        << ") is not equal to the dimensionality of the model ("
+        << dists[0].Dimensionality() << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (probabilities.n_elem != batch.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "OnlineEMFit::Step(): number of probabilities ("
+        << probabilities.n_elem << ") is not equal to the number of points ("
+        << batch.n_cols << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Calculate the conditional probability of each component given each point
+  // (the E-step).  This is done in log-space so that points far from every
+  // component are still assigned to the closest one.
+  arma::mat condProb(batch.n_cols, dists.size());
+  arma::vec logProbs;
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    dists[i].LogProbability(batch, logProbs);
+    condProb.col(i) = logProbs + std::log(weights[i]);
+  }
+
+  for (size_t j = 0; j < batch.n_cols; ++j)
+  {
+    // If the point can't belong to any component, ignore it.
+    const double maxLogProb = condProb.row(j).max();
+    if (!std::isfinite(maxLogProb))
+    {
+      condProb.row(j).zeros();
+      continue;
+    }
+
+    condProb.row(j) = arma::exp(condProb.row(j) - maxLogProb);
+    condProb.row(j) /= arma::accu(condProb.row(j));
+  }
+  condProb.each_col() %= probabilities;
+
+  const double totalProb = arma::accu(condProb);
+  if (totalProb == 0.0)
+  {
+    Log::Warn << "OnlineEMFit::Step(): no point of the batch can belong to the "
+        << "model; the model is not changed." << std::endl;
+    return;
+  }
+
+  // Take a step from the sufficient statistics of the current model (the
+  // weight, the weighted mean and the weighted second moment of each
+  // component) towards the sufficient statistics of the batch, and then
+  // recover the model from the new statistics (the M-step).
+  typedef typename std::decay<decltype(dists[0].Covariance())>::type
+      CovarianceType;
+  const double stepSize = StepSize();
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    const arma::vec& oldMean = dists[i].Mean();
+    CovarianceType moment = dists[i].Covariance();
+    AddCovariance(oldMean, oldMean, moment);
+
+    arma::mat weightedBatch = batch;
+    weightedBatch.each_row() %= trans(condProb.col(i));
+    CovarianceType batchMoment;
+    batchMoment.zeros(moment.n_rows, moment.n_cols);
+    AddCovariance(batch, weightedBatch, batchMoment);
+
+    const double oldWeight = weights[i];
+    const double weight = (1 - stepSize) * oldWeight + stepSize *
+        arma::accu(condProb.col(i)) / totalProb;
+
+    // Don't update the component if it has no weight left.
+    weights[i] = weight;
+    if (weight == 0.0)
+      continue;
+
+    arma::vec mean = ((1 - stepSize) * oldWeight * oldMean + stepSize *
+        arma::sum(weightedBatch, 1) / totalProb) / weight;
+    CovarianceType covariance = ((1 - stepSize) * oldWeight * moment +
+        stepSize * batchMoment / totalProb) / weight;
+    AddCovariance(arma::vec(-mean), mean, covariance);
+
+    // Apply covariance constraint.
+    constraint.ApplyConstraint(covariance);
+
+    dists[i].Mean() = std::move(mean);
+    dists[i].Covariance(std::move(covariance));
+  }
+
+  // Correct any rounding error in the weights.
+  weights /= arma::accu(weights);
+
+  ++steps;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::EstimateBatches(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  steps = 0;
+  if (observations.n_cols == 0)
+    return;
+
+  arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+      observations.n_cols - 1, observations.n_cols));
+
+  if (!useInitialModel)
+  {
+    // Fit the initial model to the first batch.  An EMFit with a maximum of one
+    // iteration only performs the initial clustering.
+    const size_t initialSize = std::min((size_t) observations.n_cols,
+        std::max(batchSize, dists.size()));
+    const arma::mat initialBatch = observations.cols(order.subvec(0,
+        initialSize - 1));
+
+    EMFit<InitialClusteringType, CovarianceConstraintPolicy, DistributionType>
+        initialFit(1, 1e-10, clusterer, constraint);
+    initialFit.Estimate(initialBatch, dists, weights, false);
+  }
+
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    if (pass > 0)
+      order = arma::shuffle(order);
+
+    for (size_t begin = 0; begin < observations.n_cols; begin += batchSize)
+    {
+      const size_t end = std::min(begin + batchSize,
+          (size_t) observations.n_cols);
+      const arma::uvec indices = order.subvec(begin, end - 1);
+
+      if (probabilities.is_empty())
+        Step(observations.cols(indices), dists, weights);
+      else
+        Step(observations.cols(indices), probabilities.elem(indices), dists,
+            weights);
+    }
+
+    Log::Info << "OnlineEMFit::Estimate(): pass " << pass + 1 << " done; step "
+        << "size is now " << StepSize() << "." << std::endl;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename Archive>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(batchSize, "batchSize");
+  ar & CreateNVP(passes, "passes");
+  ar & CreateNVP(decay, "decay");
+  ar & CreateNVP(stepOffset, "stepOffset");
+  ar & CreateNVP(steps, "steps");
+  ar & CreateNVP(clusterer, "clusterer");
+  ar & CreateNVP(constraint, "constraint");
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -57,6 +57,26 @@ class PositiveDefiniteConstraint
     }
   }
 
+  /**
+   * Apply the positive definiteness constraint to the given diagonal covariance
+   * matrix (given as the vector of its diagonal elements, which are also its
+   * eigenvalues), in the same way as for a full covariance matrix.
+   *
+   * @param diagCovariance The diagonal of the covariance matrix.
+   */
+  static void ApplyConstraint(arma::vec& diagCovariance)
+  {
+    const double minValue = diagCovariance.min();
+    const double maxValue = diagCovariance.max();
+    if ((minValue < 0.0) || ((maxValue / minValue) > 1e5) ||
+        (maxValue < 1e-50))
+    {
+      const double minEigval = std::max(maxValue / 1e5, 1e-50);
+      for (size_t i = 0; i < diagCovariance.n_elem; ++i)
+        diagCovariance[i] = std::max(diagCovariance[i], minEigval);
+    }
+  }
+
   //! Serialize the constraint (which stores nothing, so, nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
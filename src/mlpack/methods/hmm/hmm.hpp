@@ -11,6 +11,8 @@
 
 #include <mlpack/core.hpp>
 
+#include "transition_util.hpp"
+
 namespace mlpack {
 namespace hmm /** Hidden Markov Models. */ {
 
@@ -73,9 +75,18 @@ namespace hmm /** Hidden Markov Models. */ {
  * (with Predict()), generate a sequence (with Generate()), or estimate the
  * probabilities of each state for a sequence of observations (with Train()).
  *
+ * The transition matrix may be sparse (MatType = arma::sp_mat), as for
+ * left-to-right or banded topologies.  Then the Forward-Backward algorithm, the
+ * Viterbi algorithm and the Baum-Welch algorithm only visit the nonzero
+ * transitions, so each time step takes O(nnz) time instead of O(S^2) for S
+ * states.  Baum-Welch training never adds transitions to a sparse matrix, and
+ * labeled training only adds the transitions present in the labels.
+ *
  * @tparam Distribution Type of emission distribution for this HMM.
+ * @tparam MatType Type of the transition matrix (arma::mat or arma::sp_mat).
  */
-template<typename Distribution = distribution::DiscreteDistribution>
+template<typename Distribution = distribution::DiscreteDistribution,
+         typename MatType = arma::mat>
 class HMM
 {
  public:
@@ -113,7 +124,8 @@ class HMM
    *
    * The transition matrix should be such that T(i, j) is the probability of
    * transition to state i from state j.  The columns of the matrix should sum
-   * to 1.
+   * to 1.  If the matrix is sparse, only its nonzero transitions can ever be
+   * taken.
    *
    * The emission matrix should be such that E(i, j) is the probability of
    * emission i while in state j.  The columns of the matrix should sum to 1.
@@ -128,7 +140,7 @@ class HMM
    *      (Baum-Welch).
    */
   HMM(const arma::vec& initial,
-      const arma::mat& transition,
+      const MatType& transition,
       const std::vector<Distribution>& emission,
       const double tolerance = 1e-5);
 
@@ -261,6 +273,17 @@ class HMM
    */
   double LogLikelihood(const arma::mat& dataSeq) const;
 
+  /**
+   * Compute the log-likelihood of each of the given data sequences.  The
+   * sequences are scored in parallel.
+   *
+   * @param dataSeq Data sequences to evaluate the likelihood of.
+   * @param logLikelihoods Vector in which the log-likelihood of each sequence
+   *     will be stored.
+   */
+  void LogLikelihood(const std::vector<arma::mat>& dataSeq,
+                     arma::vec& logLikelihoods) const;
+
   /**
    * HMM filtering. Computes the k-step-ahead expected emission at each time
    * conditioned only on prior observations. That is
@@ -297,9 +320,9 @@ class HMM
   arma::vec& Initial() { return initial; }
 
   //! Return the transition matrix.
-  const arma::mat& Transition() const { return transition; }
+  const MatType& Transition() const { return transition; }
   //! Return a modifiable transition matrix reference.
-  arma::mat& Transition() { return transition; }
+  MatType& Transition() { return transition; }
 
   //! Return the emission distributions.
   const std::vector<Distribution>& Emission() const { return emission; }
@@ -353,13 +376,89 @@ class HMM
                 const arma::vec& scales,
                 arma::mat& backwardProb) const;
 
+  /**
+   * Run the Forward-Backward algorithm like the public Estimate(), and also
+   * return the emission probabilities of the sequence, which are computed only
+   * once for both passes.
+   *
+   * @param dataSeq Sequence of observations.
+   * @param stateProb Matrix in which the state probabilities will be stored.
+   * @param forwardProb Matrix in which the forward probabilities will be
+   *    stored.
+   * @param backwardProb Matrix in which the backward probabilities will be
+   *    stored.
+   * @param scales Vector in which the scaling factors will be stored.
+   * @param emissionProb Matrix in which the emission probabilities will be
+   *    stored.
+   * @return Log-likelihood of most likely state sequence.
+   */
+  double Estimate(const arma::mat& dataSeq,
+                  arma::mat& stateProb,
+                  arma::mat& forwardProb,
+                  arma::mat& backwardProb,
+                  arma::vec& scales,
+                  arma::mat& emissionProb) const;
+
+  /**
+   * The Forward algorithm, given the emission probabilities of each state for
+   * each observation (as computed by EmissionProbabilities()).
+   *
+   * @param emissionProb Emission probabilities of the data sequence.
+   * @param scales Vector in which scaling factors will be saved.
+   * @param forwardProb Matrix in which forward probabilities will be saved.
+   */
+  void ForwardEmissions(const arma::mat& emissionProb,
+                        arma::vec& scales,
+                        arma::mat& forwardProb) const;
+
+  /**
+   * The Backward algorithm, given the emission probabilities of each state for
+   * each observation (as computed by EmissionProbabilities()).
+   *
+   * @param emissionProb Emission probabilities of the data sequence.
+   * @param scales Vector of scaling factors.
+   * @param backwardProb Matrix in which backward probabilities will be saved.
+   */
+  void BackwardEmissions(const arma::mat& emissionProb,
+                         const arma::vec& scales,
+                         arma::mat& backwardProb) const;
+
+  /**
+   * Compute the log-probability of each observation in the given data sequence
+   * under the emission distribution of each state.  The observations are
+   * evaluated in parallel blocks, with the batch LogProbability() of the
+   * emission distribution when it has one (like GaussianDistribution and GMM).
+   *
+   * @param dataSeq Data sequence to compute log-probabilities for.
+   * @param logEmissionProb Matrix in which emission log-probabilities will be
+   *     saved.
+   */
+  void EmissionLogProbabilities(const arma::mat& dataSeq,
+                                arma::mat& logEmissionProb) const;
+
+  /**
+   * Compute the probability of each observation in the given data sequence
+   * under the emission distribution of each state.  The returned matrix has
+   * rows equal to the number of hidden states and columns equal to the number
+   * of observations.
+   *
+   * @param dataSeq Data sequence to compute probabilities for.
+   * @param emissionProb Matrix in which emission probabilities will be saved.
+   */
+  void EmissionProbabilities(const arma::mat& dataSeq,
+                             arma::mat& emissionProb) const;
+
   //! Set of emission probability distributions; one for each state.
   std::vector<Distribution> emission;
 
   //! Transition probability matrix.
-  arma::mat transition;
+  MatType transition;
 
  private:
+  //! The number of observations whose emission probabilities are evaluated
+  //! together.
+  static const size_t BlockSize = 1024;
+
   //! Initial state probability vector.
   arma::vec initial;
 
@@ -12,17 +12,66 @@
 // Just in case...
 #include "hmm.hpp"
 
+#include <mlpack/core/util/sfinae_utility.hpp>
+
 namespace mlpack {
 namespace hmm {
 
+/**
+ * This gives us a HasBatchLogProbabilityCheck object that we can use to tell
+ * whether or not an emission distribution can compute the log-probabilities of
+ * many observations at once.
+ */
+HAS_MEM_FUNC(LogProbability, HasBatchLogProbabilityCheck);
+
+/**
+ * 'value' is true if the Distribution class has a member
+ * LogProbability(const arma::mat& observations, arma::vec& logProbabilities).
+ */
+template<typename Distribution>
+struct HasBatchLogProbability
+{
+  static const bool value = HasBatchLogProbabilityCheck<Distribution,
+      void(Distribution::*)(const arma::mat&, arma::vec&) const>::value;
+};
+
+//! Compute the log-probabilities of the given observations with the batch
+//! LogProbability() of the distribution.
+template<typename Distribution>
+void BatchLogProbability(
+    const Distribution& distribution,
+    const arma::mat& observations,
+    arma::vec& logProbabilities,
+    const typename boost::enable_if_c<
+        HasBatchLogProbability<Distribution>::value == true>::type* = 0)
+{
+  distribution.LogProbability(observations, logProbabilities);
+}
+
+//! Compute the log-probabilities of the given observations one at a time, if
+//! the distribution has no batch LogProbability().
+template<typename Distribution>
+void BatchLogProbability(
+    const Distribution& distribution,
+    const arma::mat& observations,
+    arma::vec& logProbabilities,
+    const typename boost::enable_if_c<
+        HasBatchLogProbability<Distribution>::value == false>::type* = 0)
+{
+  logProbabilities.set_size(observations.n_cols);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+    logProbabilities[i] = std::log(distribution.Probability(
+        observations.unsafe_col(i)));
+}
+
 /**
  * Create the Hidden Markov Model with the given number of hidden states and the
  * given number of emission states.
  */
-template<typename Distribution>
-HMM<Distribution>::HMM(const size_t states,
-                       const Distribution emissions,
-                       const double tolerance) :
+template<typename Distribution, typename MatType>
+HMM<Distribution, MatType>::HMM(const size_t states,
+                                const Distribution emissions,
+                                const double tolerance) :
     emission(states, /* default distribution */ emissions),
     transition(arma::ones<arma::mat>(states, states) / (double) states),
     initial(arma::ones<arma::vec>(states) / (double) states),
@@ -34,11 +83,11 @@ HMM<Distribution>::HMM(const size_t states,
  * Create the Hidden Markov Model with the given transition matrix and the given
  * emission probability matrix.
  */
-template<typename Distribution>
-HMM<Distribution>::HMM(const arma::vec& initial,
-                       const arma::mat& transition,
-                       const std::vector<Distribution>& emission,
-                       const double tolerance) :
+template<typename Distribution, typename MatType>
+HMM<Distribution, MatType>::HMM(const arma::vec& initial,
+                                const MatType& transition,
+                                const std::vector<Distribution>& emission,
+                                const double tolerance) :
     emission(emission),
     transition(transition),
     initial(initial),
@@ -71,8 +120,8 @@ HMM<Distribution>::HMM(const arma::vec& initial,
  *
  * @param dataSeq Set of data sequences to train on.
  */
-template<typename Distribution>
-void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Train(const std::vector<arma::mat>& dataSeq)
 {
   // We should allow a guess at the transition and emission matrices.
   double loglik = 0;
@@ -94,92 +143,114 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
   }
 
   // These are used later for training of each distribution.  We initialize it
-  // all now so we don't have to do any allocation later on.
+  // all now so we don't have to do any allocation later on.  The observations
+  // don't change between iterations, so the list of emission observations is
+  // filled only once; offsets[seq] is the position of the first observation of
+  // sequence seq in that list.
   std::vector<arma::vec> emissionProb(transition.n_cols,
       arma::vec(totalLength));
   arma::mat emissionList(dimensionality, totalLength);
+  std::vector<size_t> offsets(dataSeq.size() + 1, 0);
+  for (size_t seq = 0; seq < dataSeq.size(); seq++)
+  {
+    offsets[seq + 1] = offsets[seq] + dataSeq[seq].n_cols;
+    if (dataSeq[seq].n_cols > 0)
+      emissionList.cols(offsets[seq], offsets[seq + 1] - 1) = dataSeq[seq];
+  }
+
+  // The sequences are split into groups of consecutive sequences, and the
+  // E-steps of the groups are run in parallel, each group with its own
+  // accumulator for the transitions.  The number of groups does not depend on
+  // the number of threads, and the accumulators are added up in order, so the
+  // results do not depend on the number of threads.
+  const size_t numGroups = std::max((size_t) 1,
+      std::min(dataSeq.size(), (size_t) 64));
 
   // This should be the Baum-Welch algorithm (EM for HMM estimation). This
   // follows the procedure outlined in Elliot, Aggoun, and Moore's book "Hidden
   // Markov Models: Estimation and Control", pp. 36-40.
   for (size_t iter = 0; iter < iterations; iter++)
   {
-    // Clear new transition matrix and emission probabilities.
-    arma::vec newInitial(transition.n_rows);
-    newInitial.zeros();
-    arma::mat newTransition(transition.n_rows, transition.n_cols);
-    newTransition.zeros();
-
-    // Reset log likelihood.
-    loglik = 0;
-
-    // Sum over time.
-    size_t sumTime = 0;
+    // Clear new transition matrix and emission probabilities.  The transition
+    // accumulators hold one value for each (nonzero) transition.
+    std::vector<arma::vec> groupTransitions(numGroups,
+        arma::zeros<arma::vec>(NumTransitionValues(transition)));
+    arma::mat seqInitial(transition.n_rows, dataSeq.size());
+    arma::vec seqLoglik(dataSeq.size());
 
     // Loop over each sequence.
-    for (size_t seq = 0; seq < dataSeq.size(); seq++)
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_size_t g = 0; g < (omp_size_t) numGroups; ++g)
     {
-      arma::mat stateProb;
-      arma::mat forward;
-      arma::mat backward;
-      arma::vec scales;
-
-      // Add the log-likelihood of this sequence.  This is the E-step.
-      loglik += Estimate(dataSeq[seq], stateProb, forward, backward, scales);
-
-      // Add to estimate of initial probability for state j.
-      for (size_t j = 0; j < transition.n_cols; ++j)
-        newInitial[j] += stateProb(j, 0);
-
-      // Now re-estimate the parameters.  This is the M-step.
-      //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
-      //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t]) b(i,
-      //           t + 1)))
-      //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t) b(i, t)
-      // We store the new estimates in a different matrix.
-      for (size_t t = 0; t < dataSeq[seq].n_cols; ++t)
+      arma::vec& newTransition = groupTransitions[g];
+      arma::vec emissions(transition.n_rows);
+
+      const size_t groupBegin = g * dataSeq.size() / numGroups;
+      const size_t groupEnd = (g + 1) * dataSeq.size() / numGroups;
+      for (size_t seq = groupBegin; seq < groupEnd; seq++)
       {
-        for (size_t j = 0; j < transition.n_cols; ++j)
+        arma::mat stateProb;
+        arma::mat forward;
+        arma::mat backward;
+        arma::vec scales;
+        arma::mat seqEmissionProb;
+
+        // Find the log-likelihood of this sequence.  This is the E-step.
+        seqLoglik[seq] = Estimate(dataSeq[seq], stateProb, forward, backward,
+            scales, seqEmissionProb);
+
+        // Estimate of initial probability for state j.
+        seqInitial.col(seq) = stateProb.col(0);
+
+        // Now re-estimate the parameters.  This is the M-step.
+        //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
+        //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t])
+        //           b(i, t + 1)))
+        //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t)
+        //           b(i, t)
+        // We store the new estimates in a different matrix.
+        for (size_t t = 0; t < dataSeq[seq].n_cols; ++t)
         {
           if (t < dataSeq[seq].n_cols - 1)
           {
-            // Estimate of T_ij (probability of transition from state j to state
-            // i).  We postpone multiplication of the old T_ij until later.
-            for (size_t i = 0; i < transition.n_rows; i++)
-              newTransition(i, j) += forward(j, t) * backward(i, t + 1) *
-                  emission[i].Probability(dataSeq[seq].unsafe_col(t + 1)) /
-                  scales[t + 1];
+            // The emission probabilities of the next observation, times the
+            // backward probabilities, are the same for every j.
+            emissions = seqEmissionProb.unsafe_col(t + 1) %
+                backward.unsafe_col(t + 1) / scales[t + 1];
+
+            // Estimate of T_ij (probability of transition from state j to
+            // state i).  We postpone multiplication of the old T_ij until
+            // later.  Only the nonzero transitions can be taken.
+            AccumulateTransitions(transition, forward.unsafe_col(t), emissions,
+                newTransition);
           }
 
-          // Add to list of emission observations, for Distribution::Train().
-          emissionList.col(sumTime) = dataSeq[seq].col(t);
-          emissionProb[j][sumTime] = stateProb(j, t);
+          // Add to list of emission probabilities, for
+          // Distribution::Train().
+          for (size_t j = 0; j < transition.n_cols; ++j)
+            emissionProb[j][offsets[seq] + t] = stateProb(j, t);
         }
-        sumTime++;
       }
     }
 
+    // Now add up the results of each sequence, in order.
+    loglik = arma::accu(seqLoglik);
+    const arma::vec newInitial = arma::sum(seqInitial, 1);
+    arma::vec newTransition = groupTransitions[0];
+    for (size_t g = 1; g < numGroups; ++g)
+      newTransition += groupTransitions[g];
+
     // Normalize the new initial probabilities.
     if (dataSeq.size() > 1)
       initial = newInitial / dataSeq.size();
     else
       initial = newInitial;
 
-    // Assign the new transition matrix.  We use %= (element-wise
-    // multiplication) because every element of the new transition matrix must
-    // still be multiplied by the old elements (this is the multiplication we
-    // earlier postponed).
-    transition %= newTransition;
-
-    // Now we normalize the transition matrix.
-    for (size_t i = 0; i < transition.n_cols; i++)
-    {
-      const double sum = accu(transition.col(i));
-      if (sum > 0.0)
-        transition.col(i) /= sum;
-      else
-        transition.col(i).fill(1.0 / (double) transition.n_rows);
-    }
+    // Assign the new transition matrix.  Every element of the new transition
+    // matrix must still be multiplied by the old elements (this is the
+    // multiplication we earlier postponed), and then the columns are
+    // normalized.
+    ReestimateTransitions(transition, newTransition);
 
     // Now estimate emission probabilities.
     for (size_t state = 0; state < transition.n_cols; state++)
@@ -202,9 +273,10 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
  * Train the model using the given labeled observations; the transition and
  * emission matrices are directly estimated.
  */
-template<typename Distribution>
-void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
-                              const std::vector<arma::Row<size_t> >& stateSeq)
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Train(
+    const std::vector<arma::mat>& dataSeq,
+    const std::vector<arma::Row<size_t> >& stateSeq)
 {
   // Simple error checking.
   if (dataSeq.size() != stateSeq.size())
@@ -215,7 +287,6 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
   }
 
   initial.zeros();
-  transition.zeros();
 
   // Estimate the transition and emission matrices directly from the
   // observations.  The emission list holds the time indices for observations
@@ -240,14 +311,11 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
           << dimensionality << " dimensions)." << std::endl;
     }
 
-    // Loop over each observation in the sequence.  For estimation of the
-    // transition matrix, we must ignore the last observation.
+    // Loop over each observation in the sequence.  The transitions are
+    // counted after all the sequences have been checked.
     initial[stateSeq[seq][0]]++;
     for (size_t t = 0; t < dataSeq[seq].n_cols - 1; t++)
-    {
-      transition(stateSeq[seq][t + 1], stateSeq[seq][t])++;
       emissionList[stateSeq[seq][t]].push_back(std::make_pair(seq, t));
-    }
 
     // Last observation.
     emissionList[stateSeq[seq][stateSeq[seq].n_elem - 1]].push_back(
@@ -257,16 +325,9 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
   // Normalize initial weights.
   initial /= accu(initial);
 
-  // Normalize transition matrix.
-  for (size_t col = 0; col < transition.n_cols; col++)
-  {
-    // If the transition probability sum is greater than 0 in this column, the
-    // emission probability sum will also be greater than 0.  We want to avoid
-    // division by 0.
-    double sum = accu(transition.col(col));
-    if (sum > 0)
-      transition.col(col) /= sum;
-  }
+  // Estimate the transition matrix from the counts of each transition, and
+  // normalize it.
+  CountTransitions(stateSeq, transition);
 
   // Estimate emission matrix.
   for (size_t state = 0; state < transition.n_cols; state++)
@@ -297,16 +358,37 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
  * Estimate the probabilities of each hidden state at each time step for each
  * given data observation.
  */
-template<typename Distribution>
-double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
-                                   arma::mat& stateProb,
-                                   arma::mat& forwardProb,
-                                   arma::mat& backwardProb,
-                                   arma::vec& scales) const
+template<typename Distribution, typename MatType>
+double HMM<Distribution, MatType>::Estimate(const arma::mat& dataSeq,
+                                            arma::mat& stateProb,
+                                            arma::mat& forwardProb,
+                                            arma::mat& backwardProb,
+                                            arma::vec& scales) const
 {
-  // First run the forward-backward algorithm.
-  Forward(dataSeq, scales, forwardProb);
-  Backward(dataSeq, scales, backwardProb);
+  // We don't need to save the emission probabilities.
+  arma::mat emissionProb;
+
+  return Estimate(dataSeq, stateProb, forwardProb, backwardProb, scales,
+      emissionProb);
+}
+
+/**
+ * Estimate the probabilities of each hidden state at each time step for each
+ * given data observation, and return the emission probabilities too.
+ */
+template<typename Distribution, typename MatType>
+double HMM<Distribution, MatType>::Estimate(const arma::mat& dataSeq,
+                                            arma::mat& stateProb,
+                                            arma::mat& forwardProb,
+                                            arma::mat& backwardProb,
+                                            arma::vec& scales,
+                                            arma::mat& emissionProb) const
+{
+  // First run the forward-backward algorithm; the emission probabilities are
+  // the same for both passes.
+  EmissionProbabilities(dataSeq, emissionProb);
+  ForwardEmissions(emissionProb, scales, forwardProb);
+  BackwardEmissions(emissionProb, scales, backwardProb);
 
   // Now assemble the state probability matrix based on the forward and backward
   // probabilities.
@@ -320,9 +402,9 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
  * Estimate the probabilities of each hidden state at each time step for each
  * given data observation.
  */
-template<typename Distribution>
-double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
-                                   arma::mat& stateProb) const
+template<typename Distribution, typename MatType>
+double HMM<Distribution, MatType>::Estimate(const arma::mat& dataSeq,
+                                            arma::mat& stateProb) const
 {
   // We don't need to save these.
   arma::mat forwardProb, backwardProb;
@@ -336,11 +418,11 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
  * stored in the dataSequence parameter, and the state sequence is stored in
  * the stateSequence parameter.
  */
-template<typename Distribution>
-void HMM<Distribution>::Generate(const size_t length,
-                                 arma::mat& dataSequence,
-                                 arma::Row<size_t>& stateSequence,
-                                 const size_t startState) const
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Generate(const size_t length,
+                                          arma::mat& dataSequence,
+                                          arma::Row<size_t>& stateSequence,
+                                          const size_t startState) const
 {
   // Set vectors to the right size.
   stateSequence.set_size(length);
@@ -385,49 +467,46 @@ void HMM<Distribution>::Generate(const size_t length,
  * using the Viterbi algorithm. Returns the log-likelihood of the most likely
  * sequence.
  */
-template<typename Distribution>
-double HMM<Distribution>::Predict(const arma::mat& dataSeq,
-                                  arma::Row<size_t>& stateSeq) const
+template<typename Distribution, typename MatType>
+double HMM<Distribution, MatType>::Predict(const arma::mat& dataSeq,
+                                           arma::Row<size_t>& stateSeq) const
 {
   // This is an implementation of the Viterbi algorithm for finding the most
-  // probable sequence of states to produce the observed data sequence.  We
-  // don't use log-likelihoods to save that little bit of time, but we'll
-  // calculate the log-likelihood at the end of it all.
+  // probable sequence of states to produce the observed data sequence.  It
+  // works with log-probabilities, so each time step is a max-plus product of
+  // the log transition matrix and the previous log-probabilities, which only
+  // visits the nonzero transitions.
   stateSeq.set_size(dataSeq.n_cols);
   arma::mat logStateProb(transition.n_rows, dataSeq.n_cols);
-  arma::mat stateSeqBack(transition.n_rows, dataSeq.n_cols);
+  arma::Mat<size_t> stateSeqBack(transition.n_rows, dataSeq.n_cols);
 
-  // Store the logs of the transposed transition matrix.  This is because we
-  // will be using the rows of the transition matrix.
-  arma::mat logTrans(log(trans(transition)));
+  // The logs of the (nonzero) transitions.
+  const arma::vec logTransValues = LogTransitionValues(transition);
+
+  arma::mat logEmissionProb;
+  EmissionLogProbabilities(dataSeq, logEmissionProb);
 
   // The calculation of the first state is slightly different; the probability
   // of the first state being state j is the maximum probability that the state
   // came to be j from another state.
-  logStateProb.col(0).zeros();
+  logStateProb.col(0) = log(initial) + logEmissionProb.col(0);
   for (size_t state = 0; state < transition.n_rows; state++)
-  {
-    logStateProb(state, 0) = log(initial[state] *
-        emission[state].Probability(dataSeq.unsafe_col(0)));
     stateSeqBack(state, 0) = state;
-  }
 
-  // Store the best first state.
-  arma::uword index;
+  arma::vec best;
   for (size_t t = 1; t < dataSeq.n_cols; t++)
   {
-    // Assemble the state probability for this element.
     // Given that we are in state j, we use state with the highest probability
-    // of being the previous state.
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
-      logStateProb(j, t) = prob.max(index) +
-          log(emission[j].Probability(dataSeq.unsafe_col(t)));
-        stateSeqBack(j, t) = index;
-    }
+    // of being the previous state.  The previous states are taken one at a
+    // time, and each updates the best previous state of every j it can
+    // transition to; states which can't have been reached are skipped.
+    ViterbiStep(transition, logTransValues, logStateProb.unsafe_col(t - 1),
+        best, stateSeqBack.colptr(t));
+
+    logStateProb.col(t) = best + logEmissionProb.col(t);
   }
 
+  arma::uword index;
   // Backtrack to find the most probable state sequence.
   logStateProb.unsafe_col(dataSeq.n_cols - 1).max(index);
   stateSeq[dataSeq.n_cols - 1] = index;
@@ -441,8 +520,8 @@ double HMM<Distribution>::Predict(const arma::mat& dataSeq,
 /**
  * Compute the log-likelihood of the given data sequence.
  */
-template<typename Distribution>
-double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
+template<typename Distribution, typename MatType>
+double HMM<Distribution, MatType>::LogLikelihood(const arma::mat& dataSeq) const
 {
   arma::mat forward;
   arma::vec scales;
@@ -453,13 +532,31 @@ double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
   return accu(log(scales));
 }
 
+/**
+ * Compute the log-likelihood of each of the given data sequences.
+ */
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::LogLikelihood(
+    const std::vector<arma::mat>& dataSeq,
+    arma::vec& logLikelihoods) const
+{
+  logLikelihoods.set_size(dataSeq.size());
+
+  // The sequences are independent, so each thread takes one sequence at a
+  // time; the emission probabilities of a sequence are then evaluated by the
+  // thread itself.
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t seq = 0; seq < (omp_size_t) dataSeq.size(); ++seq)
+    logLikelihoods[seq] = LogLikelihood(dataSeq[seq]);
+}
+
 /**
  * HMM filtering.
  */
-template<typename Distribution>
-void HMM<Distribution>::Filter(const arma::mat& dataSeq,
-                               arma::mat& filterSeq,
-                               size_t ahead) const
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Filter(const arma::mat& dataSeq,
+                                        arma::mat& filterSeq,
+                                        size_t ahead) const
 {
   // First run the forward algorithm.
   arma::mat forwardProb;
@@ -480,9 +577,9 @@ void HMM<Distribution>::Filter(const arma::mat& dataSeq,
 /**
  * HMM smoothing.
  */
-template<typename Distribution>
-void HMM<Distribution>::Smooth(const arma::mat& dataSeq,
-                               arma::mat& smoothSeq) const
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Smooth(const arma::mat& dataSeq,
+                                        arma::mat& smoothSeq) const
 {
   // First run the forward algorithm.
   arma::mat stateProb;
@@ -498,24 +595,34 @@ void HMM<Distribution>::Smooth(const arma::mat& dataSeq,
 /**
  * The Forward procedure (part of the Forward-Backward algorithm).
  */
-template<typename Distribution>
-void HMM<Distribution>::Forward(const arma::mat& dataSeq,
-                                arma::vec& scales,
-                                arma::mat& forwardProb) const
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Forward(const arma::mat& dataSeq,
+                                         arma::vec& scales,
+                                         arma::mat& forwardProb) const
+{
+  arma::mat emissionProb;
+  EmissionProbabilities(dataSeq, emissionProb);
+
+  ForwardEmissions(emissionProb, scales, forwardProb);
+}
+
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::ForwardEmissions(
+    const arma::mat& emissionProb,
+    arma::vec& scales,
+    arma::mat& forwardProb) const
 {
   // Our goal is to calculate the forward probabilities:
   //  P(X_k | o_{1:k}) for all possible states X_k, for each time point k.
-  forwardProb.zeros(transition.n_rows, dataSeq.n_cols);
-  scales.zeros(dataSeq.n_cols);
+  forwardProb.zeros(transition.n_rows, emissionProb.n_cols);
+  scales.zeros(emissionProb.n_cols);
 
   // The first entry in the forward algorithm uses the initial state
   // probabilities.  Note that MATLAB assumes that the starting state (at
   // t = -1) is state 0; this is not our assumption here.  To force that
   // behavior, you could append a single starting state to every single data
   // sequence and that should produce results in line with MATLAB.
-  for (size_t state = 0; state < transition.n_rows; state++)
-    forwardProb(state, 0) = initial(state) *
-        emission[state].Probability(dataSeq.unsafe_col(0));
+  forwardProb.col(0) = initial % emissionProb.col(0);
 
   // Then normalize the column.
   scales[0] = accu(forwardProb.col(0));
@@ -523,17 +630,14 @@ void HMM<Distribution>::Forward(const arma::mat& dataSeq,
     forwardProb.col(0) /= scales[0];
 
   // Now compute the probabilities for each successive observation.
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  for (size_t t = 1; t < emissionProb.n_cols; t++)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      // The forward probability of state j at time t is the sum over all states
-      // of the probability of the previous state transitioning to the current
-      // state and emitting the given observation.
-      forwardProb(j, t) = accu(forwardProb.col(t - 1) %
-          trans(transition.row(j))) *
-          emission[j].Probability(dataSeq.unsafe_col(t));
-    }
+    // The forward probability of state j at time t is the sum over all states
+    // of the probability of the previous state transitioning to the current
+    // state and emitting the given observation; for all j at once, this is a
+    // matrix-vector product.
+    forwardProb.col(t) = (transition * forwardProb.col(t - 1)) %
+        emissionProb.col(t);
 
     // Normalize probability.
     scales[t] = accu(forwardProb.col(t));
@@ -542,42 +646,96 @@ void HMM<Distribution>::Forward(const arma::mat& dataSeq,
   }
 }
 
-template<typename Distribution>
-void HMM<Distribution>::Backward(const arma::mat& dataSeq,
-                                 const arma::vec& scales,
-                                 arma::mat& backwardProb) const
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::Backward(const arma::mat& dataSeq,
+                                          const arma::vec& scales,
+                                          arma::mat& backwardProb) const
+{
+  arma::mat emissionProb;
+  EmissionProbabilities(dataSeq, emissionProb);
+
+  BackwardEmissions(emissionProb, scales, backwardProb);
+}
+
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::BackwardEmissions(
+    const arma::mat& emissionProb,
+    const arma::vec& scales,
+    arma::mat& backwardProb) const
 {
   // Our goal is to calculate the backward probabilities:
   //  P(X_k | o_{k + 1:T}) for all possible states X_k, for each time point k.
-  backwardProb.zeros(transition.n_rows, dataSeq.n_cols);
+  backwardProb.zeros(transition.n_rows, emissionProb.n_cols);
 
   // The last element probability is 1.
-  backwardProb.col(dataSeq.n_cols - 1).fill(1);
+  backwardProb.col(emissionProb.n_cols - 1).fill(1);
+
+  // The transposed transition matrix is used at every step.
+  const MatType transitionTrans = trans(transition);
 
   // Now step backwards through all other observations.
-  for (size_t t = dataSeq.n_cols - 2; t + 1 > 0; t--)
+  for (size_t t = emissionProb.n_cols - 2; t + 1 > 0; t--)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      // The backward probability of state j at time t is the sum over all state
-      // of the probability of the next state having been a transition from the
-      // current state multiplied by the probability of each of those states
-      // emitting the given observation.
-      for (size_t state = 0; state < transition.n_rows; state++)
-        backwardProb(j, t) += transition(state, j) * backwardProb(state, t + 1)
-            * emission[state].Probability(dataSeq.unsafe_col(t + 1));
-
-      // Normalize by the weights from the forward algorithm.
-      if (scales[t + 1] > 0.0)
-        backwardProb(j, t) /= scales[t + 1];
-    }
+    // The backward probability of state j at time t is the sum over all state
+    // of the probability of the next state having been a transition from the
+    // current state multiplied by the probability of each of those states
+    // emitting the given observation; for all j at once, this is a product
+    // with the transposed transition matrix.
+    backwardProb.col(t) = transitionTrans * (backwardProb.col(t + 1) %
+        emissionProb.col(t + 1));
+
+    // Normalize by the weights from the forward algorithm.
+    if (scales[t + 1] > 0.0)
+      backwardProb.col(t) /= scales[t + 1];
   }
 }
 
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::EmissionLogProbabilities(
+    const arma::mat& dataSeq,
+    arma::mat& logEmissionProb) const
+{
+  logEmissionProb.set_size(transition.n_rows, dataSeq.n_cols);
+
+  // Each task is one block of observations for one state, so that there is
+  // parallel work even for short sequences of models with many states.  Short
+  // sequences are evaluated by the calling thread.
+  const size_t states = transition.n_rows;
+  const size_t blocks = (dataSeq.n_cols + BlockSize - 1) / BlockSize;
+  #pragma omp parallel for schedule(dynamic) \
+      if (dataSeq.n_cols * states > BlockSize)
+  for (omp_size_t task = 0; task < (omp_size_t) (blocks * states); ++task)
+  {
+    const size_t state = task % states;
+    const size_t begin = (task / states) * BlockSize;
+    const size_t count = std::min((size_t) BlockSize,
+        (size_t) dataSeq.n_cols - begin);
+
+    // Use the observations of the block where they are, without a copy.
+    const arma::mat block(const_cast<double*>(dataSeq.colptr(begin)),
+        dataSeq.n_rows, count, false, true);
+
+    arma::vec logProbs;
+    BatchLogProbability(emission[state], block, logProbs);
+    logEmissionProb.submat(state, begin, state, begin + count - 1) =
+        trans(logProbs);
+  }
+}
+
+template<typename Distribution, typename MatType>
+void HMM<Distribution, MatType>::EmissionProbabilities(
+    const arma::mat& dataSeq,
+    arma::mat& emissionProb) const
+{
+  EmissionLogProbabilities(dataSeq, emissionProb);
+  emissionProb = exp(emissionProb);
+}
+
 //! Serialize the HMM.
-template<typename Distribution>
+template<typename Distribution, typename MatType>
 template<typename Archive>
-void HMM<Distribution>::Serialize(Archive& ar, const unsigned int /* version */)
+void HMM<Distribution, MatType>::Serialize(Archive& ar,
+                                           const unsigned int /* version */)
 {
   ar & data::CreateNVP(dimensionality, "dimensionality");
   ar & data::CreateNVP(tolerance, "tolerance");
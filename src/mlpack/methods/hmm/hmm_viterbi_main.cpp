@@ -9,6 +9,7 @@
 
 #include "hmm.hpp"
 #include "hmm_util.hpp"
+#include "viterbi_decoder.hpp"
 
 #include <mlpack/methods/gmm/gmm.hpp>
 
@@ -16,12 +17,20 @@ PROGRAM_INFO("Hidden Markov Model (HMM) Viterbi State Prediction", "This "
     "utility takes an already-trained HMM (--model_file) and evaluates the "
     "most probably hidden state sequence of a given sequence of observations "
     "(--input_file), using the Viterbi algorithm.  The computed state sequence "
-    "is saved to the specified output file (--output_file).");
+    "is saved to the specified output file (--output_file)."
+    "\n\n"
+    "If --max_lag (-l) is specified, the observations are instead decoded one "
+    "at a time by a streaming decoder, which leaves no more than the given "
+    "number of time steps undecided.  This bounds the memory used for long "
+    "sequences, but the state sequence may then differ from the most probable "
+    "one where the survivor paths take longer than the lag to converge.");
 
 PARAM_STRING_REQ("input_file", "File containing observations,", "i");
 PARAM_STRING_REQ("model_file", "File containing HMM.", "m");
 PARAM_STRING("output_file", "File to save predicted state sequence to.",
     "o", "");
+PARAM_INT("max_lag", "If nonzero, decode with a streaming decoder that leaves "
+    "at most this many time steps undecided.", "l", 0);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -60,7 +69,32 @@ struct Viterbi
           << hmm.Emission()[0].Dimensionality() << ")!" << endl;
 
     arma::Row<size_t> sequence;
-    hmm.Predict(dataSeq, sequence);
+    const int maxLag = CLI::GetParam<int>("max_lag");
+    if (maxLag == 0)
+    {
+      hmm.Predict(dataSeq, sequence);
+    }
+    else
+    {
+      ViterbiDecoder<HMMType> decoder(hmm, maxLag);
+      sequence.set_size(dataSeq.n_cols);
+      size_t decodedStates = 0;
+      arma::Row<size_t> decoded;
+      for (size_t t = 0; t <= dataSeq.n_cols; ++t)
+      {
+        if (t < dataSeq.n_cols)
+          decoder.Push(dataSeq.col(t), decoded);
+        else
+          decoder.Flush(decoded);
+
+        if (decoded.n_elem > 0)
+        {
+          sequence.subvec(decodedStates, decodedStates + decoded.n_elem - 1) =
+              decoded;
+          decodedStates += decoded.n_elem;
+        }
+      }
+    }
 
     // Save output.
     if (CLI::HasParam("output_file"))
@@ -73,6 +107,10 @@ int main(int argc, char** argv)
   // Parse command line options.
   CLI::ParseCommandLine(argc, argv);
 
+  if (CLI::GetParam<int>("max_lag") < 0)
+    Log::Fatal << "Invalid value for --max_lag (-l) ("
+        << CLI::GetParam<int>("max_lag") << "); must be 0 or greater!" << endl;
+
   if (CLI::HasParam("output_file"))
     Log::Warn << "--output_file (-o) is not specified; no results will be "
         << "saved!" << endl;
@@ -0,0 +1,295 @@
+/**
+ * @file transition_util.hpp
+ *
+ * Operations on the transition matrix of an HMM which depend on whether it is
+ * dense (arma::mat) or sparse (arma::sp_mat).  The sparse overloads only visit
+ * the nonzero transitions, so they take O(nnz) time instead of O(S^2).
+ *
+ * The values of a transition matrix are its elements in column-major order for
+ * a dense matrix, and its nonzero elements in compressed sparse column order
+ * for a sparse matrix.  The sparse overloads read the compressed arrays of the
+ * matrix directly, so they sync them first (see SyncSparse()).
+ */
+#ifndef MLPACK_METHODS_HMM_TRANSITION_UTIL_HPP
+#define MLPACK_METHODS_HMM_TRANSITION_UTIL_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace hmm {
+
+//! Return the number of values of the dense transition matrix.
+inline size_t NumTransitionValues(const arma::mat& transition)
+{
+  return transition.n_elem;
+}
+
+//! Return the number of values of the sparse transition matrix.
+inline size_t NumTransitionValues(const arma::sp_mat& transition)
+{
+  return transition.n_nonzero;
+}
+
+//! Return the logs of the values of the dense transition matrix.
+inline arma::vec LogTransitionValues(const arma::mat& transition)
+{
+  return arma::vectorise(arma::log(transition));
+}
+
+//! Return the logs of the values of the sparse transition matrix.
+inline arma::vec LogTransitionValues(const arma::sp_mat& transition)
+{
+  SyncSparse(transition);
+  return arma::log(arma::vec(transition.values, transition.n_nonzero));
+}
+
+/**
+ * Take one step of the Viterbi algorithm: for each state j, find the state i
+ * maximizing prev[i] + log T(j, i), store the maximum in best[j] and i in
+ * back[j].  Previous states with a log-probability of -inf are skipped, and
+ * ties are broken towards the lowest i; if there is no valid previous state,
+ * best[j] is -inf and back[j] is 0.
+ *
+ * @param transition Transition matrix.
+ * @param logValues Logs of the values of the transition matrix (see
+ *     LogTransitionValues()).
+ * @param prev Log-probabilities of the previous states.
+ * @param best Vector to store the best log-probability of each state in.
+ * @param back Array to store the best previous state of each state in.
+ */
+inline void ViterbiStep(const arma::mat& transition,
+                        const arma::vec& logValues,
+                        const arma::vec& prev,
+                        arma::vec& best,
+                        size_t* back)
+{
+  const double negInf = -std::numeric_limits<double>::infinity();
+  best.set_size(transition.n_rows);
+  best.fill(negInf);
+  std::fill(back, back + transition.n_rows, 0);
+
+  // Column i holds the transitions from state i, so the inner loop runs over
+  // contiguous memory.
+  for (size_t i = 0; i < transition.n_cols; ++i)
+  {
+    if (prev[i] == negInf)
+      continue;
+
+    const double* logTransFrom = logValues.memptr() + i * transition.n_rows;
+    for (size_t j = 0; j < transition.n_rows; ++j)
+    {
+      const double prob = prev[i] + logTransFrom[j];
+      if (prob > best[j])
+      {
+        best[j] = prob;
+        back[j] = i;
+      }
+    }
+  }
+}
+
+/**
+ * Take one step of the Viterbi algorithm with a sparse transition matrix.  See
+ * the dense overload for details; zero transitions are never taken.
+ */
+inline void ViterbiStep(const arma::sp_mat& transition,
+                        const arma::vec& logValues,
+                        const arma::vec& prev,
+                        arma::vec& best,
+                        size_t* back)
+{
+  const double negInf = -std::numeric_limits<double>::infinity();
+  best.set_size(transition.n_rows);
+  best.fill(negInf);
+  std::fill(back, back + transition.n_rows, 0);
+
+  SyncSparse(transition);
+  for (size_t i = 0; i < transition.n_cols; ++i)
+  {
+    if (prev[i] == negInf)
+      continue;
+
+    for (size_t k = transition.col_ptrs[i]; k < transition.col_ptrs[i + 1];
+        ++k)
+    {
+      const size_t j = transition.row_indices[k];
+      const double prob = prev[i] + logValues[k];
+      if (prob > best[j])
+      {
+        best[j] = prob;
+        back[j] = i;
+      }
+    }
+  }
+}
+
+/**
+ * Add from[j] * to[i] to the accumulator of each value T(i, j) of the dense
+ * transition matrix; this is the expected number of transitions from j to i of
+ * one time step in the Baum-Welch algorithm, before multiplication by T(i, j).
+ *
+ * @param transition Transition matrix.
+ * @param from Weight of each state the transitions come from.
+ * @param to Weight of each state the transitions go to.
+ * @param accumulator Accumulator for each value of the transition matrix.
+ */
+inline void AccumulateTransitions(const arma::mat& transition,
+                                  const arma::vec& from,
+                                  const arma::vec& to,
+                                  arma::vec& accumulator)
+{
+  arma::mat accumulatorMat(accumulator.memptr(), transition.n_rows,
+      transition.n_cols, false, true);
+  accumulatorMat += to * trans(from);
+}
+
+/**
+ * Add from[j] * to[i] to the accumulator of each nonzero value T(i, j) of the
+ * sparse transition matrix.  See the dense overload for details.
+ */
+inline void AccumulateTransitions(const arma::sp_mat& transition,
+                                  const arma::vec& from,
+                                  const arma::vec& to,
+                                  arma::vec& accumulator)
+{
+  SyncSparse(transition);
+  for (size_t j = 0; j < transition.n_cols; ++j)
+  {
+    if (from[j] == 0.0)
+      continue;
+
+    for (size_t k = transition.col_ptrs[j]; k < transition.col_ptrs[j + 1];
+        ++k)
+      accumulator[k] += from[j] * to[transition.row_indices[k]];
+  }
+}
+
+/**
+ * Multiply each value of the dense transition matrix by its accumulator, and
+ * normalize the columns.  A column which sums to 0 is set to the uniform
+ * distribution.
+ */
+inline void ReestimateTransitions(arma::mat& transition,
+                                  const arma::vec& accumulator)
+{
+  transition %= arma::reshape(accumulator, transition.n_rows,
+      transition.n_cols);
+
+  for (size_t i = 0; i < transition.n_cols; i++)
+  {
+    const double sum = accu(transition.col(i));
+    if (sum > 0.0)
+      transition.col(i) /= sum;
+    else
+      transition.col(i).fill(1.0 / (double) transition.n_rows);
+  }
+}
+
+/**
+ * Multiply each nonzero value of the sparse transition matrix by its
+ * accumulator, and normalize the columns.  A column which would sum to 0 keeps
+ * its old values, so that the sparsity pattern of the matrix is not lost; the
+ * values which become 0 are removed.
+ */
+inline void ReestimateTransitions(arma::sp_mat& transition,
+                                  const arma::vec& accumulator)
+{
+  SyncSparse(transition);
+  arma::vec values = arma::vec(transition.values, transition.n_nonzero) %
+      accumulator;
+
+  for (size_t j = 0; j < transition.n_cols; ++j)
+  {
+    const size_t begin = transition.col_ptrs[j];
+    const size_t end = transition.col_ptrs[j + 1];
+    if (begin == end)
+      continue;
+
+    const double sum = accu(values.subvec(begin, end - 1));
+    if (sum > 0.0)
+      values.subvec(begin, end - 1) /= sum;
+    else
+      values.subvec(begin, end - 1) = arma::vec(transition.values + begin,
+          end - begin);
+  }
+
+  const arma::uvec rowIndices(transition.row_indices, transition.n_nonzero);
+  const arma::uvec colPointers(transition.col_ptrs, transition.n_cols + 1);
+  transition = arma::sp_mat(rowIndices, colPointers, values, transition.n_rows,
+      transition.n_cols);
+}
+
+/**
+ * Set the dense transition matrix to the counts of the transitions from
+ * stateSeq[t] to stateSeq[t + 1] over all the given state sequences,
+ * normalized so that each column with a nonzero count sums to 1.
+ *
+ * @param stateSeq State sequences to count the transitions of.
+ * @param transition Transition matrix to set; its size is not changed.
+ */
+inline void CountTransitions(const std::vector<arma::Row<size_t>>& stateSeq,
+                             arma::mat& transition)
+{
+  transition.zeros();
+  for (size_t seq = 0; seq < stateSeq.size(); seq++)
+    for (size_t t = 0; t + 1 < stateSeq[seq].n_elem; t++)
+      transition(stateSeq[seq][t + 1], stateSeq[seq][t])++;
+
+  for (size_t col = 0; col < transition.n_cols; col++)
+  {
+    // If the transition probability sum is greater than 0 in this column, the
+    // emission probability sum will also be greater than 0.  We want to avoid
+    // division by 0.
+    const double sum = accu(transition.col(col));
+    if (sum > 0)
+      transition.col(col) /= sum;
+  }
+}
+
+/**
+ * Set the sparse transition matrix to the normalized counts of the transitions
+ * of the given state sequences.  Only the transitions which appear in the
+ * sequences are nonzero.  See the dense overload for details.
+ */
+inline void CountTransitions(const std::vector<arma::Row<size_t>>& stateSeq,
+                             arma::sp_mat& transition)
+{
+  size_t numTransitions = 0;
+  for (size_t seq = 0; seq < stateSeq.size(); seq++)
+    if (stateSeq[seq].n_elem > 1)
+      numTransitions += stateSeq[seq].n_elem - 1;
+
+  arma::umat locations(2, numTransitions);
+  size_t n = 0;
+  for (size_t seq = 0; seq < stateSeq.size(); seq++)
+  {
+    for (size_t t = 0; t + 1 < stateSeq[seq].n_elem; t++, n++)
+    {
+      locations(0, n) = stateSeq[seq][t + 1];
+      locations(1, n) = stateSeq[seq][t];
+    }
+  }
+
+  // Repeated locations are added up.
+  arma::sp_mat counts(true, locations, arma::ones<arma::vec>(numTransitions),
+      transition.n_rows, transition.n_cols);
+
+  arma::vec values(counts.values, counts.n_nonzero);
+  for (size_t j = 0; j < counts.n_cols; ++j)
+  {
+    const size_t begin = counts.col_ptrs[j];
+    const size_t end = counts.col_ptrs[j + 1];
+    if (begin < end)
+      values.subvec(begin, end - 1) /= accu(values.subvec(begin, end - 1));
+  }
+
+  const arma::uvec rowIndices(counts.row_indices, counts.n_nonzero);
+  const arma::uvec colPointers(counts.col_ptrs, counts.n_cols + 1);
+  transition = arma::sp_mat(rowIndices, colPointers, values, counts.n_rows,
+      counts.n_cols);
+}
+
+} // namespace hmm
+} // namespace mlpack
+
+#endif
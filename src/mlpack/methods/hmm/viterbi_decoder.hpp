@@ -0,0 +1,147 @@
+/**
+ * @file viterbi_decoder.hpp
+ *
+ * Definition of the ViterbiDecoder class, which decodes the most probable state
+ * sequence of an HMM from a stream of observations with bounded memory.
+ */
+#ifndef MLPACK_METHODS_HMM_VITERBI_DECODER_HPP
+#define MLPACK_METHODS_HMM_VITERBI_DECODER_HPP
+
+#include <mlpack/core.hpp>
+#include "hmm.hpp"
+
+#include <deque>
+
+namespace mlpack {
+namespace hmm /** Hidden Markov Models. */ {
+
+/**
+ * An online Viterbi decoder for an HMM.  The observations are given one at a
+ * time with Push(), and the states of the most probable state sequence are
+ * returned as soon as they are known.  The state at some time step is known
+ * once the survivor paths of every state at the current time step go through
+ * the same state at that time step; before that, only the backpointers of the
+ * undecided time steps are kept.
+ *
+ * The survivor paths usually converge after a few time steps, but they are not
+ * guaranteed to.  To bound the memory, no more than the given maximum lag of
+ * time steps are left undecided; when there are more, the oldest one is decided
+ * from the path of the currently most probable state (fixed-lag decoding).
+ * With a maximum lag of 0, the memory is unbounded, and the decoded sequence is
+ * the same as the one given by HMM::Predict() on the whole sequence.
+ *
+ * @code
+ * ViterbiDecoder<HMM<GaussianDistribution>> decoder(hmm, 100);
+ * arma::Row<size_t> states;
+ * while (...) // For each new observation.
+ * {
+ *   decoder.Push(observation, states);
+ *   // Use the newly decoded states, if any.
+ * }
+ * decoder.Flush(states); // Decode the remaining states.
+ * @endcode
+ *
+ * The decoder keeps a reference to the HMM, which must not be modified or
+ * destroyed while the decoder is in use.
+ *
+ * @tparam HMMType Type of the HMM to decode (an HMM<Distribution, MatType>).
+ */
+template<typename HMMType>
+class ViterbiDecoder
+{
+ public:
+  /**
+   * Create a decoder for the given HMM.
+   *
+   * @param hmm HMM to decode the observations with.
+   * @param maxLag Maximum number of undecided time steps (0 means no limit).
+   */
+  ViterbiDecoder(const HMMType& hmm, const size_t maxLag = 100);
+
+  /**
+   * Add an observation to the stream, and store in decoded the states of the
+   * time steps which have become decided, in order (decoded may be empty).
+   * A std::invalid_argument is thrown if the dimensionality of the observation
+   * does not match the HMM.
+   *
+   * @param observation Next observation of the stream.
+   * @param decoded Row vector to store the newly decoded states in.
+   */
+  void Push(const arma::vec& observation, arma::Row<size_t>& decoded);
+
+  /**
+   * End the stream: store in decoded the states of the remaining undecided
+   * time steps, along the path of the most probable state, and reset the
+   * decoder so that a new stream can be decoded.
+   *
+   * @param decoded Row vector to store the remaining decoded states in.
+   */
+  void Flush(arma::Row<size_t>& decoded);
+
+  //! Forget the stream so far, without decoding the undecided time steps.
+  void Reset();
+
+  //! Get the number of undecided time steps.
+  size_t Lag() const { return backpointers.size(); }
+
+  //! Get the maximum number of undecided time steps (0 means no limit).
+  size_t MaxLag() const { return maxLag; }
+  //! Modify the maximum number of undecided time steps (0 means no limit).
+  size_t& MaxLag() { return maxLag; }
+
+  //! Get the number of observations pushed since the stream began.
+  size_t Observations() const { return observations; }
+
+  /**
+   * Get the log-likelihood of the most probable state sequence of the
+   * observations pushed so far.
+   */
+  double LogLikelihood() const;
+
+ private:
+  /**
+   * Find the latest time step at which the survivor paths of all the current
+   * states converge, and decode every undecided time step up to it.
+   */
+  void DecodeConverged(arma::Row<size_t>& decoded);
+
+  /**
+   * Decode the given number of the oldest undecided time steps along the path
+   * of the currently most probable state, and append them to decoded.
+   */
+  void DecodeOldest(const size_t count, arma::Row<size_t>& decoded);
+
+  //! Append states to the given row vector.
+  static void Append(arma::Row<size_t>& decoded,
+                     const arma::Row<size_t>& states);
+
+  //! The HMM to decode with.
+  const HMMType& hmm;
+  //! Maximum number of undecided time steps.
+  size_t maxLag;
+
+  //! Logs of the values of the transition matrix of the HMM (see
+  //! LogTransitionValues()).
+  arma::vec logTransition;
+  //! Logs of the initial state probabilities of the HMM.
+  arma::vec logInitial;
+
+  //! Log-probability of the most probable path ending in each state, up to
+  //! the offset.
+  arma::vec logStateProb;
+  //! The offset removed from logStateProb to keep it from underflowing.
+  double logOffset;
+  //! The best previous state of each state, for each undecided time step (the
+  //! oldest first).
+  std::deque<arma::Col<size_t>> backpointers;
+  //! Number of observations pushed since the stream began.
+  size_t observations;
+};
+
+} // namespace hmm
+} // namespace mlpack
+
+// Include implementation.
+#include "viterbi_decoder_impl.hpp"
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file viterbi_decoder_impl.hpp
+ *
+ * Implementation of the ViterbiDecoder class.
+ */
+#ifndef MLPACK_METHODS_HMM_VITERBI_DECODER_IMPL_HPP
+#define MLPACK_METHODS_HMM_VITERBI_DECODER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "viterbi_decoder.hpp"
+
+namespace mlpack {
+namespace hmm {
+
+template<typename HMMType>
+ViterbiDecoder<HMMType>::ViterbiDecoder(const HMMType& hmm,
+                                        const size_t maxLag) :
+    hmm(hmm),
+    maxLag(maxLag),
+    logTransition(LogTransitionValues(hmm.Transition())),
+    logInitial(log(hmm.Initial())),
+    logOffset(0.0),
+    observations(0)
+{
+  // Nothing else to do.
+}
+
+template<typename HMMType>
+void ViterbiDecoder<HMMType>::Push(const arma::vec& observation,
+                                   arma::Row<size_t>& decoded)
+{
+  if (observation.n_elem != hmm.Emission()[0].Dimensionality())
+  {
+    std::ostringstream oss;
+    oss << "ViterbiDecoder::Push(): observation dimensionality ("
+        << observation.n_elem << ") does not match HMM dimensionality ("
+        << hmm.Emission()[0].Dimensionality() << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t states = hmm.Transition().n_rows;
+  arma::vec logEmissionProb(states);
+  for (size_t j = 0; j < states; ++j)
+    logEmissionProb[j] = std::log(hmm.Emission()[j].Probability(observation));
+
+  arma::Col<size_t> back(states);
+  if (observations == 0)
+  {
+    // The first state has no previous state.
+    logStateProb = logInitial + logEmissionProb;
+    for (size_t j = 0; j < states; ++j)
+      back[j] = j;
+  }
+  else
+  {
+    // This is the same max-plus step as in HMM::Predict(), with the same
+    // handling of ties.
+    arma::vec best;
+    ViterbiStep(hmm.Transition(), logTransition, logStateProb, best,
+        back.memptr());
+
+    logStateProb = best + logEmissionProb;
+  }
+
+  // Keep the log-probabilities near zero, so that they don't underflow on long
+  // streams.
+  const double maxLogProb = logStateProb.max();
+  if (std::isfinite(maxLogProb))
+  {
+    logStateProb -= maxLogProb;
+    logOffset += maxLogProb;
+  }
+
+  backpointers.push_back(std::move(back));
+  ++observations;
+
+  decoded.reset();
+  DecodeConverged(decoded);
+  if (maxLag > 0 && backpointers.size() > maxLag)
+    DecodeOldest(backpointers.size() - maxLag, decoded);
+}
+
+template<typename HMMType>
+void ViterbiDecoder<HMMType>::Flush(arma::Row<size_t>& decoded)
+{
+  decoded.reset();
+  DecodeOldest(backpointers.size(), decoded);
+  Reset();
+}
+
+template<typename HMMType>
+void ViterbiDecoder<HMMType>::Reset()
+{
+  logStateProb.reset();
+  logOffset = 0.0;
+  backpointers.clear();
+  observations = 0;
+}
+
+template<typename HMMType>
+double ViterbiDecoder<HMMType>::LogLikelihood() const
+{
+  if (observations == 0)
+    return 0.0;
+
+  return logStateProb.max() + logOffset;
+}
+
+template<typename HMMType>
+void ViterbiDecoder<HMMType>::DecodeConverged(arma::Row<size_t>& decoded)
+{
+  const size_t states = hmm.Transition().n_rows;
+  const size_t lag = backpointers.size();
+
+  // Start with the states the current time step can be in.  If it can't be in
+  // any state, every one is kept, since HMM::Predict() would still choose one.
+  std::vector<bool> survivors(states, false);
+  size_t numSurvivors = 0;
+  for (size_t j = 0; j < states; ++j)
+  {
+    if (logStateProb[j] != -std::numeric_limits<double>::infinity())
+    {
+      survivors[j] = true;
+      ++numSurvivors;
+    }
+  }
+  if (numSurvivors == 0)
+  {
+    survivors.assign(states, true);
+    numSurvivors = states;
+  }
+
+  // Follow the survivor paths back in time, until they go through only one
+  // state.  Then that time step and all the ones before it are decided.
+  size_t step = lag;
+  while (numSurvivors > 1 && step > 1)
+  {
+    --step;
+    std::vector<bool> previous(states, false);
+    numSurvivors = 0;
+    for (size_t j = 0; j < states; ++j)
+    {
+      if (survivors[j] && !previous[backpointers[step][j]])
+      {
+        previous[backpointers[step][j]] = true;
+        ++numSurvivors;
+      }
+    }
+    survivors.swap(previous);
+  }
+
+  if (numSurvivors > 1)
+    return;
+
+  // The paths converge at undecided time step (step - 1); backtrack from there.
+  size_t state = 0;
+  while (!survivors[state])
+    ++state;
+
+  arma::Row<size_t> states(step);
+  states[step - 1] = state;
+  for (size_t t = step - 1; t > 0; --t)
+    states[t - 1] = backpointers[t][states[t]];
+
+  Append(decoded, states);
+  backpointers.erase(backpointers.begin(), backpointers.begin() + step);
+}
+
+template<typename HMMType>
+void ViterbiDecoder<HMMType>::DecodeOldest(const size_t count,
+                                           arma::Row<size_t>& decoded)
+{
+  const size_t lag = backpointers.size();
+  if (count == 0 || lag == 0)
+    return;
+
+  // Backtrack from the most probable current state.
+  arma::uword index;
+  logStateProb.max(index);
+
+  arma::Row<size_t> path(lag);
+  path[lag - 1] = index;
+  for (size_t t = lag - 1; t > 0; --t)
+    path[t - 1] = backpointers[t][path[t]];
+
+  Append(decoded, path.subvec(0, count - 1));
+  backpointers.erase(backpointers.begin(), backpointers.begin() + count);
+}
+
+template<typename HMMType>
+void ViterbiDecoder<HMMType>::Append(arma::Row<size_t>& decoded,
+                                     const arma::Row<size_t>& states)
+{
+  decoded.insert_cols(decoded.n_elem, states);
+}
+
+} // namespace hmm
+} // namespace mlpack
+
+#endif
@@ -9,6 +9,7 @@
 #define MLPACK_METHODS_HOEFFDING_SPLIT_BINARY_NUMERIC_SPLIT_HPP
 
 #include "binary_numeric_split_info.hpp"
+#include "memory_usage.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -101,6 +102,14 @@ class BinaryNumericSplit
   //! The probability of the majority class given the points seen so far.
   double MajorityProbability() const;
 
+  //! Return the number of bytes of memory used by the split (including the
+  //! object itself).  This grows with the number of points seen.
+  size_t MemoryUsage() const
+  {
+    return sizeof(*this) + MapMemoryUsage(sortedElements) +
+        HeapMemoryUsage(classCounts);
+  }
+
   //! Serialize the object.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
@@ -27,6 +27,10 @@ class BinaryNumericSplitInfo
     return (value < splitPoint) ? 0 : 1;
   }
 
+  //! Get the split point; values greater than or equal to it go to the second
+  //! child.
+  const ObservationType& SplitPoint() const { return splitPoint; }
+
   //! Serialize the split (save/load the split points).
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
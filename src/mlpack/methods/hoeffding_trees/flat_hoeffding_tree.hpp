@@ -0,0 +1,165 @@
+/**
+ * @file flat_hoeffding_tree.hpp
+ *
+ * A read-only, flattened form of a trained HoeffdingTree for fast
+ * classification: the nodes are stored in contiguous arrays instead of being
+ * linked by pointers, and points are classified in blocks.
+ */
+#ifndef MLPACK_METHODS_HOEFFDING_TREES_FLAT_HOEFFDING_TREE_HPP
+#define MLPACK_METHODS_HOEFFDING_TREES_FLAT_HOEFFDING_TREE_HPP
+
+#include <mlpack/core.hpp>
+#include "numeric_split_info.hpp"
+#include "binary_numeric_split_info.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A flattened copy of a HoeffdingTree, which can only classify points.  Each
+ * node of the tree is an entry in a few contiguous arrays: its split dimension,
+ * the kind of split (numeric or categorical), the range of its numeric
+ * thresholds, the index of its first child (the children of a node are stored
+ * one after the other), and, for leaves, the majority class and its
+ * probability.  A numeric split sends a value to the child whose index is the
+ * number of thresholds below the value, which is counted without branches; a
+ * categorical split sends it to the child of its category.
+ *
+ * Batches of points are classified in blocks of points which go down the tree
+ * one level at a time, so that the lookups of the points of a block are
+ * independent of each other, and the blocks are classified in parallel.
+ *
+ * The flattened tree is a copy: it does not change when the HoeffdingTree is
+ * trained further, so it must be built again after training.
+ *
+ * @code
+ * HoeffdingTree<> tree(data, info, labels, numClasses);
+ * FlatHoeffdingTree flatTree(tree);
+ * flatTree.Classify(testData, predictions, probabilities);
+ * @endcode
+ */
+class FlatHoeffdingTree
+{
+ public:
+  /**
+   * Flatten the given HoeffdingTree (or subtree).  Its numeric split type must
+   * use NumericSplitInfo or BinaryNumericSplitInfo.
+   *
+   * @param tree Trained tree to flatten.
+   */
+  template<typename TreeType>
+  FlatHoeffdingTree(const TreeType& tree);
+
+  /**
+   * Classify the given point and return the predicted label.
+   *
+   * @param point Point to classify.
+   */
+  template<typename VecType>
+  size_t Classify(const VecType& point) const;
+
+  /**
+   * Classify the given point, and also return an estimate of the probability
+   * that the prediction is correct (the majority probability of its leaf).
+   *
+   * @param point Point to classify.
+   * @param prediction Predicted label of point.
+   * @param probability Probability estimate of the predicted label.
+   */
+  template<typename VecType>
+  void Classify(const VecType& point, size_t& prediction, double& probability)
+      const;
+
+  /**
+   * Classify the given points.
+   *
+   * @param data Points to classify.
+   * @param predictions Predicted labels for each point.
+   */
+  template<typename MatType>
+  void Classify(const MatType& data, arma::Row<size_t>& predictions) const;
+
+  /**
+   * Classify the given points, and also return the probability estimate of
+   * each predicted label.
+   *
+   * @param data Points to classify.
+   * @param predictions Predicted labels for each point.
+   * @param probabilities Probability estimates for each predicted label.
+   */
+  template<typename MatType>
+  void Classify(const MatType& data,
+                arma::Row<size_t>& predictions,
+                arma::rowvec& probabilities) const;
+
+  //! Get the number of nodes.
+  size_t NumNodes() const { return kinds.size(); }
+
+ private:
+  //! The kinds of nodes.
+  enum NodeKind
+  {
+    Leaf,
+    //! Values greater than a threshold go past it.
+    Numeric,
+    //! Values greater than or equal to a threshold go past it.
+    NumericInclusive,
+    Categorical
+  };
+
+  //! The kind of each node.
+  std::vector<char> kinds;
+  //! The split dimension of each node.
+  arma::Col<size_t> dimensions;
+  //! The index of the first child of each node.
+  arma::Col<size_t> firstChildren;
+  //! The index of the first threshold of each node.
+  arma::Col<size_t> thresholdBegins;
+  //! The number of thresholds of each node.
+  arma::Col<size_t> thresholdCounts;
+  //! The thresholds of the numeric splits.
+  arma::vec thresholds;
+  //! The majority class of each node.
+  arma::Col<size_t> classes;
+  //! The majority probability of each node.
+  arma::vec probabilities;
+
+  //! The number of points classified together.
+  static const size_t BlockSize = 64;
+
+  //! Return the index of the child of the given node that the value goes to.
+  size_t Direction(const size_t node, const double value) const;
+
+  //! Return the index of the leaf that the given point goes to.
+  template<typename VecType>
+  size_t Leaf(const VecType& point) const;
+
+  //! Find the leaves of the points [begin, begin + count) of the given data
+  //! (count is at most BlockSize).
+  template<typename MatType>
+  void Leaves(const MatType& data,
+              const size_t begin,
+              const size_t count,
+              size_t* leaves) const;
+
+  //! Get the thresholds of a numeric split.
+  template<typename ObservationType>
+  static void Thresholds(const NumericSplitInfo<ObservationType>& splitInfo,
+                         arma::vec& splitThresholds,
+                         bool& inclusive);
+
+  //! Get the threshold of a binary numeric split.
+  template<typename ObservationType>
+  static void Thresholds(
+      const BinaryNumericSplitInfo<ObservationType>& splitInfo,
+      arma::vec& splitThresholds,
+      bool& inclusive);
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "flat_hoeffding_tree_impl.hpp"
+
+#endif
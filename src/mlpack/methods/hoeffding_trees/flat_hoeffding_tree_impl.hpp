@@ -0,0 +1,207 @@
+/**
+ * @file flat_hoeffding_tree_impl.hpp
+ *
+ * Implementation of the FlatHoeffdingTree class.
+ */
+#ifndef MLPACK_METHODS_HOEFFDING_TREES_FLAT_HOEFFDING_TREE_IMPL_HPP
+#define MLPACK_METHODS_HOEFFDING_TREES_FLAT_HOEFFDING_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "flat_hoeffding_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType>
+FlatHoeffdingTree::FlatHoeffdingTree(const TreeType& tree)
+{
+  // Number the nodes in breadth-first order, so that the children of each node
+  // are consecutive.
+  std::vector<const TreeType*> nodes(1, &tree);
+  for (size_t i = 0; i < nodes.size(); ++i)
+    for (size_t c = 0; c < nodes[i]->NumChildren(); ++c)
+      nodes.push_back(&nodes[i]->Child(c));
+
+  kinds.resize(nodes.size());
+  dimensions.set_size(nodes.size());
+  firstChildren.set_size(nodes.size());
+  thresholdBegins.set_size(nodes.size());
+  thresholdCounts.zeros(nodes.size());
+  classes.set_size(nodes.size());
+  probabilities.set_size(nodes.size());
+
+  std::vector<double> allThresholds;
+  size_t nextChild = 1;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const TreeType& node = *nodes[i];
+    classes[i] = node.MajorityClass();
+    probabilities[i] = node.MajorityProbability();
+    dimensions[i] = node.SplitDimension();
+    firstChildren[i] = nextChild;
+    thresholdBegins[i] = allThresholds.size();
+
+    if (node.NumChildren() == 0)
+    {
+      kinds[i] = Leaf;
+      continue;
+    }
+
+    nextChild += node.NumChildren();
+    if (node.DatasetInfo().Type(node.SplitDimension()) ==
+        data::Datatype::categorical)
+    {
+      kinds[i] = Categorical;
+    }
+    else
+    {
+      arma::vec splitThresholds;
+      bool inclusive;
+      Thresholds(node.NumericSplit(), splitThresholds, inclusive);
+
+      kinds[i] = inclusive ? NumericInclusive : Numeric;
+      thresholdCounts[i] = splitThresholds.n_elem;
+      allThresholds.insert(allThresholds.end(), splitThresholds.begin(),
+          splitThresholds.end());
+    }
+  }
+
+  thresholds = arma::conv_to<arma::vec>::from(allThresholds);
+}
+
+inline size_t FlatHoeffdingTree::Direction(const size_t node,
+                                           const double value) const
+{
+  if (kinds[node] == Categorical)
+    return size_t(value);
+
+  // Count the thresholds below the value.
+  const double* nodeThresholds = thresholds.memptr() + thresholdBegins[node];
+  const size_t count = thresholdCounts[node];
+  size_t direction = 0;
+  if (kinds[node] == NumericInclusive)
+  {
+    for (size_t i = 0; i < count; ++i)
+      direction += (value >= nodeThresholds[i]);
+  }
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      direction += (value > nodeThresholds[i]);
+  }
+
+  return direction;
+}
+
+template<typename VecType>
+size_t FlatHoeffdingTree::Leaf(const VecType& point) const
+{
+  size_t node = 0;
+  while (kinds[node] != Leaf)
+    node = firstChildren[node] + Direction(node, point[dimensions[node]]);
+
+  return node;
+}
+
+template<typename MatType>
+void FlatHoeffdingTree::Leaves(const MatType& data,
+                               const size_t begin,
+                               const size_t count,
+                               size_t* leaves) const
+{
+  for (size_t i = 0; i < count; ++i)
+    leaves[i] = 0;
+
+  // Move every point of the block down one level at a time, so that the
+  // lookups of different points don't wait for each other.
+  bool moved = true;
+  while (moved)
+  {
+    moved = false;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const size_t node = leaves[i];
+      if (kinds[node] == Leaf)
+        continue;
+
+      leaves[i] = firstChildren[node] +
+          Direction(node, data(dimensions[node], begin + i));
+      moved = true;
+    }
+  }
+}
+
+template<typename VecType>
+size_t FlatHoeffdingTree::Classify(const VecType& point) const
+{
+  return classes[Leaf(point)];
+}
+
+template<typename VecType>
+void FlatHoeffdingTree::Classify(const VecType& point,
+                                 size_t& prediction,
+                                 double& probability) const
+{
+  const size_t leaf = Leaf(point);
+  prediction = classes[leaf];
+  probability = probabilities[leaf];
+}
+
+template<typename MatType>
+void FlatHoeffdingTree::Classify(const MatType& data,
+                                 arma::Row<size_t>& predictions) const
+{
+  arma::rowvec leafProbabilities;
+  Classify(data, predictions, leafProbabilities);
+}
+
+template<typename MatType>
+void FlatHoeffdingTree::Classify(const MatType& data,
+                                 arma::Row<size_t>& predictions,
+                                 arma::rowvec& probabilities) const
+{
+  predictions.set_size(data.n_cols);
+  probabilities.set_size(data.n_cols);
+
+  const size_t blocks = (data.n_cols + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    const size_t begin = b * BlockSize;
+    const size_t count = std::min((size_t) BlockSize,
+        (size_t) data.n_cols - begin);
+
+    size_t leaves[BlockSize];
+    Leaves(data, begin, count, leaves);
+    for (size_t i = 0; i < count; ++i)
+    {
+      predictions[begin + i] = classes[leaves[i]];
+      probabilities[begin + i] = this->probabilities[leaves[i]];
+    }
+  });
+}
+
+template<typename ObservationType>
+void FlatHoeffdingTree::Thresholds(
+    const NumericSplitInfo<ObservationType>& splitInfo,
+    arma::vec& splitThresholds,
+    bool& inclusive)
+{
+  splitThresholds = arma::conv_to<arma::vec>::from(splitInfo.SplitPoints());
+  inclusive = false;
+}
+
+template<typename ObservationType>
+void FlatHoeffdingTree::Thresholds(
+    const BinaryNumericSplitInfo<ObservationType>& splitInfo,
+    arma::vec& splitThresholds,
+    bool& inclusive)
+{
+  splitThresholds.set_size(1);
+  splitThresholds[0] = splitInfo.SplitPoint();
+  inclusive = true;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -10,6 +10,7 @@
 
 #include <mlpack/core.hpp>
 #include "categorical_split_info.hpp"
+#include "memory_usage.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -101,6 +102,13 @@ class HoeffdingCategoricalSplit
   //! Get the probability of the majority class given the points seen so far.
   double MajorityProbability() const;
 
+  //! Return the number of bytes of memory used by the split (including the
+  //! object itself).
+  size_t MemoryUsage() const
+  {
+    return sizeof(*this) + HeapMemoryUsage(sufficientStatistics);
+  }
+
   //! Serialize the categorical split.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
@@ -11,6 +11,7 @@
 
 #include <mlpack/core.hpp>
 #include "numeric_split_info.hpp"
+#include "memory_usage.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -114,6 +115,15 @@ class HoeffdingNumericSplit
   //! Return the number of bins.
   size_t Bins() const { return bins; }
 
+  //! Return the number of bytes of memory used by the split (including the
+  //! object itself).
+  size_t MemoryUsage() const
+  {
+    return sizeof(*this) + HeapMemoryUsage(observations) +
+        HeapMemoryUsage(labels) + HeapMemoryUsage(splitPoints) +
+        HeapMemoryUsage(sufficientStatistics);
+  }
+
   //! Serialize the object.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
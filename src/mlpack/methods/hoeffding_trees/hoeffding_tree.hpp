@@ -12,6 +12,7 @@
 #include "gini_impurity.hpp"
 #include "hoeffding_numeric_split.hpp"
 #include "hoeffding_categorical_split.hpp"
+#include "memory_usage.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -42,6 +43,17 @@ namespace tree {
  * are handled.  As far as the actual splitting goes, the meat of the splitting
  * procedure will be contained in those two classes.
  *
+ * As in the VFDT paper, the memory used by the tree can be bounded with
+ * MaxMemory().  Most of the memory of a Hoeffding tree is held by the split
+ * statistics of its leaves, so when the tree grows past the budget, the leaves
+ * which are least promising (those which have misclassified the fewest of the
+ * training points they saw, an estimate of the error reduction a split would
+ * give) are deactivated: their statistics are dropped, and they only keep the
+ * count of each class, so they can still classify points but can't split.
+ * Each time the budget is enforced, inactive leaves which have become more
+ * promising than active ones are reactivated, with new statistics, if the
+ * budget allows it.
+ *
  * @tparam FitnessFunction Fitness function to use.
  * @tparam NumericSplitType Technique for splitting numeric features.
  * @tparam CategoricalSplitType Technique for splitting categorical features.
@@ -187,6 +199,17 @@ class HoeffdingTree
   //! Get the number of children.
   size_t NumChildren() const { return children.size(); }
 
+  //! Get the information on the dataset (the type of each dimension).
+  const data::DatasetInfo& DatasetInfo() const { return *datasetInfo; }
+
+  //! Get the split information, if the node is split on a numeric dimension.
+  const typename NumericSplitType<FitnessFunction>::SplitInfo& NumericSplit()
+      const { return numericSplit; }
+  //! Get the split information, if the node is split on a categorical
+  //! dimension.
+  const typename CategoricalSplitType<FitnessFunction>::SplitInfo&
+      CategoricalSplit() const { return categoricalSplit; }
+
   //! Get a child.
   const HoeffdingTree& Child(const size_t i) const { return *children[i]; }
   //! Modify a child.
@@ -212,6 +235,43 @@ class HoeffdingTree
   //! Modify the number of samples before a split check is performed.
   void CheckInterval(const size_t checkInterval);
 
+  //! Get the maximum number of bytes of memory the tree may use (0 means no
+  //! limit).
+  size_t MaxMemory() const { return maxMemory; }
+  //! Modify the maximum number of bytes of memory the tree may use (0 means no
+  //! limit).  The budget is enforced when training is called on this node, so
+  //! this should be set on the root of the tree.
+  void MaxMemory(const size_t maxMemory) { this->maxMemory = maxMemory; }
+
+  //! Get the number of points trained on in streaming mode between two
+  //! enforcements of the memory budget.
+  size_t MemoryCheckInterval() const { return memoryCheckInterval; }
+  //! Modify the number of points trained on in streaming mode between two
+  //! enforcements of the memory budget.
+  void MemoryCheckInterval(const size_t memoryCheckInterval);
+
+  //! Return whether or not this node keeps split statistics (only leaves may
+  //! be inactive).
+  bool IsActive() const { return active; }
+
+  /**
+   * Return the number of bytes of memory used by this node and the subtree
+   * below it: the nodes themselves, their class counts, and the statistics of
+   * their splits.  The dataset information and dimension mappings, which are
+   * shared by all the nodes, are not counted.
+   */
+  size_t MemoryUsage() const;
+
+  /**
+   * If the memory used by the tree is over MaxMemory(), deactivate the least
+   * promising leaves, and reactivate the most promising inactive leaves if the
+   * budget allows it.  This is called during training (every
+   * MemoryCheckInterval() points in streaming mode, and after each batch in
+   * batch mode), so it only needs to be called by hand after MaxMemory() is
+   * lowered.  Nothing is done if MaxMemory() is 0.
+   */
+  void EnforceMemoryBudget();
+
   /**
    * Given a point and that this node is not a leaf, calculate the index of the
    * child node this point would go towards.  This method is primarily used by
@@ -278,11 +338,55 @@ class HoeffdingTree
    */
   void CreateChildren();
 
+  /**
+   * Train on a set of points in batch mode: the statistics of every dimension
+   * are updated with all the points (in parallel across dimensions, for large
+   * batches), the split is checked once, and if the node is split, the points
+   * are partitioned between the children, which are trained in the same way
+   * (in parallel, as tasks of the thread pool).
+   */
+  template<typename MatType>
+  void TrainBatch(const MatType& data, const arma::Row<size_t>& labels);
+
+  //! Return the amount of work (number of point-dimension statistics updates)
+  //! below which a node or block of dimensions is not worth training as a
+  //! separate task.
+  static size_t ParallelWork() { return (size_t) 1 << 16; }
+
   //! Serialize the split.
   template<typename Archive>
-  void Serialize(Archive& ar, const unsigned int /* version */);
+  void Serialize(Archive& ar, const unsigned int version);
 
  private:
+  //! Train on a single point in streaming mode, without enforcing the memory
+  //! budget.
+  template<typename VecType>
+  void TrainPoint(const VecType& point, const size_t label);
+
+  //! Set the majority class and its probability, from the split statistics
+  //! if they have seen every point of the node, and from the class counts
+  //! otherwise.
+  void UpdateMajorityClass();
+
+  //! Return the number of bytes of memory used by the split statistics of this
+  //! node (for an inactive leaf, its empty prototype splits).
+  size_t StatisticsMemoryUsage() const;
+
+  //! Return the number of bytes of memory the split statistics of this leaf
+  //! would use if it was deactivated.
+  size_t InactiveMemoryUsage() const;
+
+  //! Return the number of bytes of memory the split statistics of this leaf
+  //! would use right after it is (re)activated.
+  size_t ActiveMemoryUsage() const;
+
+  //! Drop the split statistics of this leaf, keeping only an empty split of
+  //! each type to create new statistics from.
+  void Deactivate();
+
+  //! Create new split statistics for this inactive leaf.
+  void Activate();
+
   // We need to keep some information for before we have split.
 
   //! Information for splitting of numeric features (used before split).
@@ -311,6 +415,18 @@ class HoeffdingTree
   bool ownsInfo;
   //! The required probability of success for a split to be performed.
   double successProbability;
+  //! The number of points of each class seen by this node while it was a leaf.
+  arma::Col<size_t> classCounts;
+  //! Whether or not this node keeps split statistics.
+  bool active;
+  //! The maximum number of bytes of memory the tree may use (0 for no limit).
+  size_t maxMemory;
+  //! The number of points trained on in streaming mode between two
+  //! enforcements of the memory budget.
+  size_t memoryCheckInterval;
+  //! The number of points trained on in streaming mode since the memory budget
+  //! was last enforced.
+  size_t pointsSinceMemoryCheck;
 
   // And we need to keep some information for after we have split.
 
@@ -332,6 +448,14 @@ class HoeffdingTree
 } // namespace tree
 } // namespace mlpack
 
+//! Set the serialization version of the HoeffdingTree class.
+BOOST_TEMPLATE_CLASS_VERSION(
+    template<typename FitnessFunction MLPACK_COMMA
+             template<typename> class NumericSplitType MLPACK_COMMA
+             template<typename> class CategoricalSplitType>,
+    mlpack::tree::HoeffdingTree<FitnessFunction MLPACK_COMMA NumericSplitType
+        MLPACK_COMMA CategoricalSplitType>, 1);
+
 #include "hoeffding_tree_impl.hpp"
 
 #endif
@@ -44,6 +44,11 @@ HoeffdingTree<
     datasetInfo(&datasetInfo),
     ownsInfo(false),
     successProbability(successProbability),
+    classCounts(arma::zeros<arma::Col<size_t>>(numClasses)),
+    active(true),
+    maxMemory(0),
+    memoryCheckInterval(1000),
+    pointsSinceMemoryCheck(0),
     splitDimension(size_t(-1)),
     categoricalSplit(0),
     numericSplit()
@@ -100,6 +105,11 @@ HoeffdingTree<
     datasetInfo(&datasetInfo),
     ownsInfo(false),
     successProbability(successProbability),
+    classCounts(arma::zeros<arma::Col<size_t>>(numClasses)),
+    active(true),
+    maxMemory(0),
+    memoryCheckInterval(1000),
+    pointsSinceMemoryCheck(0),
     splitDimension(size_t(-1)),
     categoricalSplit(0),
     numericSplit()
@@ -162,6 +172,11 @@ HoeffdingTree<FitnessFunction, NumericSplitType, CategoricalSplitType>::
     datasetInfo(new data::DatasetInfo(*other.datasetInfo)),
     ownsInfo(true),
     successProbability(other.successProbability),
+    classCounts(other.classCounts),
+    active(other.active),
+    maxMemory(other.maxMemory),
+    memoryCheckInterval(other.memoryCheckInterval),
+    pointsSinceMemoryCheck(other.pointsSinceMemoryCheck),
     splitDimension(other.splitDimension),
     majorityClass(other.majorityClass),
     majorityProbability(other.majorityProbability),
@@ -202,67 +217,154 @@ void HoeffdingTree<
 {
   if (batchTraining)
   {
-    // Pass all the points through the nodes, and then split only after that.
-    checkInterval = data.n_cols; // Only split on the last sample.
-    // Don't split if there are fewer than five points.
-    size_t oldMaxSamples = maxSamples;
-    maxSamples = std::max(size_t(data.n_cols - 1), size_t(5));
+    // The nodes (and the dimensions of large nodes) are trained by tasks of the
+    // thread pool.
+    ThreadPool::Run([&]() { TrainBatch(data, labels); });
+
+    if (maxMemory > 0)
+      EnforceMemoryBudget();
+  }
+  else
+  {
+    // We aren't training in batch mode; loop through the points.
     for (size_t i = 0; i < data.n_cols; ++i)
       Train(data.col(i), labels[i]);
-    maxSamples = oldMaxSamples;
+  }
+}
+
+//! Train on a set of points in batch mode.
+template<typename FitnessFunction,
+         template<typename> class NumericSplitType,
+         template<typename> class CategoricalSplitType>
+template<typename MatType>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::TrainBatch(const MatType& data, const arma::Row<size_t>& labels)
+{
+  if (data.n_cols == 0)
+    return;
 
-    // Now, if we did split, find out which points go to which child, and
-    // perform the same batch training.
-    if (children.size() > 0)
+  if (splitDimension == size_t(-1))
+  {
+    for (size_t j = 0; j < labels.n_elem; ++j)
+      ++classCounts[labels[j]];
+
+    // An inactive leaf only counts the classes.
+    if (!active)
     {
-      // We need to create a vector of indices that represent the points that
-      // must go to each child, so we need children.size() vectors, but we don't
-      // know how long they will be.  Therefore, we will create vectors each of
-      // size data.n_cols, but will probably not use all the memory we
-      // allocated, and then pass subvectors to the submat() function.
-      std::vector<arma::uvec> indices(children.size(), arma::uvec(data.n_cols));
-      arma::Col<size_t> counts =
-          arma::zeros<arma::Col<size_t>>(children.size());
+      UpdateMajorityClass();
+      return;
+    }
 
-      for (size_t i = 0; i < data.n_cols; ++i)
+    // Pass all the points through the statistics of each dimension.  The
+    // dimensions are independent, so for large batches, blocks of dimensions
+    // are trained by separate tasks.
+    numSamples += data.n_cols;
+    auto trainDimension = [&](const size_t i)
+    {
+      const size_t type = dimensionMappings->at(i).first;
+      const size_t index = dimensionMappings->at(i).second;
+      if (type == data::Datatype::categorical)
+      {
+        for (size_t j = 0; j < data.n_cols; ++j)
+          categoricalSplits[index].Train(data(i, j), labels[j]);
+      }
+      else if (type == data::Datatype::numeric)
       {
-        size_t direction = CalculateDirection(data.col(i));
-        size_t currentIndex = counts[direction];
-        indices[direction][currentIndex] = i;
-        counts[direction]++;
+        for (size_t j = 0; j < data.n_cols; ++j)
+          numericSplits[index].Train(data(i, j), labels[j]);
       }
+    };
 
-      // Now pass each of these submatrices to the children to perform
-      // batch-mode training.
-      for (size_t i = 0; i < children.size(); ++i)
+    const size_t dimsPerTask = std::max((size_t) 1,
+        ParallelWork() / data.n_cols);
+    if (dimsPerTask >= data.n_rows)
+    {
+      for (size_t i = 0; i < data.n_rows; ++i)
+        trainDimension(i);
+    }
+    else
+    {
+      for (size_t first = 0; first < data.n_rows; first += dimsPerTask)
       {
-        // If we don't have any points that go to the child in question, don't
-        // train that child.
-        if (counts[i] == 0)
-          continue;
-
-        // The submatrix here is non-contiguous, but I think this will be faster
-        // than copying the points to an ordered state.  We still have to
-        // assemble the labels vector, though.
-        arma::Row<size_t> childLabels = labels.cols(
-            indices[i].subvec(0, counts[i] - 1));
-
-        // Unfortunately, limitations of Armadillo's non-contiguous subviews
-        // prohibits us from successfully passing the non-contiguous subview to
-        // Train(), since the col() function is not provided.  So,
-        // unfortunately, instead, we'll just extract the non-contiguous
-        // submatrix.
-        MatType childData = data.cols(indices[i].subvec(0, counts[i] - 1));
-        children[i]->Train(childData, childLabels, true);
+        const size_t last = std::min(first + dimsPerTask,
+            (size_t) data.n_rows);
+        ThreadPool::Spawn([first, last, &trainDimension]()
+        {
+          for (size_t i = first; i < last; ++i)
+            trainDimension(i);
+        });
       }
+      ThreadPool::Wait();
+    }
+
+    UpdateMajorityClass();
+
+    // Check for a split once, after the whole batch.
+    checkInterval = data.n_cols;
+    // Don't split if there are fewer than five points.
+    size_t oldMaxSamples = maxSamples;
+    maxSamples = std::max(size_t(data.n_cols - 1), size_t(5));
+    const size_t numChildren = SplitCheck();
+    if (numChildren > 0)
+    {
+      // We need to add a bunch of children.
+      children.clear();
+      CreateChildren();
     }
+    maxSamples = oldMaxSamples;
+
+    // If we didn't split, we are done; otherwise the points are passed to the
+    // new children.
+    if (children.size() == 0)
+      return;
   }
-  else
+
+  // Find out which points go to which child, and perform the same batch
+  // training on each child.  We need children.size() vectors of indices, but
+  // we don't know how long they will be, so we will create vectors each of
+  // size data.n_cols, but will probably not use all the memory we allocated.
+  std::vector<arma::uvec> indices(children.size(), arma::uvec(data.n_cols));
+  arma::Col<size_t> counts = arma::zeros<arma::Col<size_t>>(children.size());
+
+  for (size_t i = 0; i < data.n_cols; ++i)
   {
-    // We aren't training in batch mode; loop through the points.
-    for (size_t i = 0; i < data.n_cols; ++i)
-      Train(data.col(i), labels[i]);
+    size_t direction = CalculateDirection(data.col(i));
+    size_t currentIndex = counts[direction];
+    indices[direction][currentIndex] = i;
+    counts[direction]++;
+  }
+
+  // Now pass each of these submatrices to the children, in parallel if they
+  // are large enough.
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    // If we don't have any points that go to the child in question, don't
+    // train that child.
+    if (counts[i] == 0)
+      continue;
+
+    auto trainChild = [&, i]()
+    {
+      // Unfortunately, limitations of Armadillo's non-contiguous subviews
+      // prohibits us from successfully passing the non-contiguous subview to
+      // Train(), since the col() function is not provided.  So,
+      // unfortunately, instead, we'll just extract the non-contiguous
+      // submatrix, and assemble the labels vector.
+      const arma::uvec childIndices = indices[i].subvec(0, counts[i] - 1);
+      const arma::Row<size_t> childLabels = labels.cols(childIndices);
+      const MatType childData = data.cols(childIndices);
+      children[i]->TrainBatch(childData, childLabels);
+    };
+
+    if (counts[i] * data.n_rows >= ParallelWork())
+      ThreadPool::Spawn(trainChild);
+    else
+      trainChild();
   }
+  ThreadPool::Wait();
 }
 
 //! Train on one point.
@@ -275,9 +377,37 @@ void HoeffdingTree<
     NumericSplitType,
     CategoricalSplitType
 >::Train(const VecType& point, const size_t label)
+{
+  TrainPoint(point, label);
+
+  if (maxMemory > 0 && ++pointsSinceMemoryCheck >= memoryCheckInterval)
+  {
+    pointsSinceMemoryCheck = 0;
+    EnforceMemoryBudget();
+  }
+}
+
+template<typename FitnessFunction,
+         template<typename> class NumericSplitType,
+         template<typename> class CategoricalSplitType>
+template<typename VecType>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::TrainPoint(const VecType& point, const size_t label)
 {
   if (splitDimension == size_t(-1))
   {
+    ++classCounts[label];
+
+    // An inactive leaf only counts the classes.
+    if (!active)
+    {
+      UpdateMajorityClass();
+      return;
+    }
+
     ++numSamples;
     size_t numericIndex = 0;
     size_t categoricalIndex = 0;
@@ -289,17 +419,7 @@ void HoeffdingTree<
         numericSplits[numericIndex++].Train(point[i], label);
     }
 
-    // Grab majority class from splits.
-    if (categoricalSplits.size() > 0)
-    {
-      majorityClass = categoricalSplits[0].MajorityClass();
-      majorityProbability = categoricalSplits[0].MajorityProbability();
-    }
-    else
-    {
-      majorityClass = numericSplits[0].MajorityClass();
-      majorityProbability = numericSplits[0].MajorityProbability();
-    }
+    UpdateMajorityClass();
 
     // Check for a split, if we should.
     if (numSamples % checkInterval == 0)
@@ -318,7 +438,7 @@ void HoeffdingTree<
   {
     // Already split.  Pass the training point to the relevant child.
     size_t direction = CalculateDirection(point);
-    children[direction]->Train(point, label);
+    children[direction]->TrainPoint(point, label);
   }
 }
 
@@ -331,8 +451,8 @@ size_t HoeffdingTree<
     CategoricalSplitType
 >::SplitCheck()
 {
-  // Do nothing if we've already split.
-  if (splitDimension != size_t(-1))
+  // Do nothing if we've already split, or if we have no statistics.
+  if (splitDimension != size_t(-1) || !active)
     return 0;
 
   // If not enough points have been seen, we cannot split.
@@ -475,6 +595,315 @@ void HoeffdingTree<
     children[i]->CheckInterval(checkInterval);
 }
 
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::MemoryCheckInterval(const size_t memoryCheckInterval)
+{
+  if (memoryCheckInterval == 0)
+    throw std::invalid_argument("HoeffdingTree::MemoryCheckInterval(): the "
+        "interval must be greater than 0");
+
+  this->memoryCheckInterval = memoryCheckInterval;
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+size_t HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::MemoryUsage() const
+{
+  size_t memory = sizeof(*this) + HeapMemoryUsage(classCounts) +
+      StatisticsMemoryUsage() + children.capacity() * sizeof(HoeffdingTree*);
+  for (size_t i = 0; i < children.size(); ++i)
+    memory += children[i]->MemoryUsage();
+
+  return memory;
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::EnforceMemoryBudget()
+{
+  if (maxMemory == 0)
+    return;
+
+  // Collect the leaves.
+  std::vector<HoeffdingTree*> leaves;
+  std::vector<HoeffdingTree*> stack(1, this);
+  while (!stack.empty())
+  {
+    HoeffdingTree* node = stack.back();
+    stack.pop_back();
+    if (node->children.size() == 0)
+      leaves.push_back(node);
+    else
+      stack.insert(stack.end(), node->children.begin(), node->children.end());
+  }
+
+  // The promise of a leaf is the number of training points it misclassified,
+  // which bounds the number of errors a split of the leaf could remove.  (This
+  // is the product of the probability that a point reaches the leaf and its
+  // error rate, used by VFDT, scaled by the number of points seen.)  Active
+  // leaves come first among leaves with the same promise, so that they aren't
+  // swapped for no gain.
+  std::vector<std::pair<size_t, HoeffdingTree*>> promises;
+  for (size_t i = 0; i < leaves.size(); ++i)
+  {
+    const arma::Col<size_t>& counts = leaves[i]->classCounts;
+    const size_t seen = arma::accu(counts);
+    const size_t promise = (seen == 0) ? 0 : seen - counts.max();
+    promises.push_back(std::make_pair(promise, leaves[i]));
+  }
+  std::stable_sort(promises.begin(), promises.end(),
+      [](const std::pair<size_t, HoeffdingTree*>& a,
+         const std::pair<size_t, HoeffdingTree*>& b)
+      {
+        if (a.first != b.first)
+          return a.first > b.first;
+        return a.second->active && !b.second->active;
+      });
+
+  // The statistics of a deactivated leaf and of a new leaf have the same size
+  // for every leaf, since every leaf creates its splits from the same
+  // prototypes and dimensions.
+  const size_t inactiveMemory = leaves[0]->InactiveMemoryUsage();
+  size_t activeMemory = 0;
+  bool activeMemoryKnown = false;
+
+  // Start from the memory the tree would use if every leaf was inactive, and
+  // keep the most promising leaves active while they fit in the budget.
+  size_t memory = MemoryUsage();
+  for (size_t i = 0; i < leaves.size(); ++i)
+    memory -= leaves[i]->StatisticsMemoryUsage();
+  memory += leaves.size() * inactiveMemory;
+
+  bool full = false;
+  for (size_t i = 0; i < promises.size(); ++i)
+  {
+    HoeffdingTree* leaf = promises[i].second;
+    if (!full)
+    {
+      size_t leafMemory;
+      if (leaf->active)
+      {
+        leafMemory = leaf->StatisticsMemoryUsage();
+      }
+      else
+      {
+        if (!activeMemoryKnown)
+        {
+          activeMemory = leaf->ActiveMemoryUsage();
+          activeMemoryKnown = true;
+        }
+        leafMemory = activeMemory;
+      }
+
+      const size_t extra = (leafMemory > inactiveMemory) ?
+          leafMemory - inactiveMemory : 0;
+      if (memory + extra <= maxMemory)
+      {
+        memory += extra;
+        if (!leaf->active)
+          leaf->Activate();
+        continue;
+      }
+
+      // The leaves after this one are less promising, so they are all
+      // deactivated too.
+      full = true;
+    }
+
+    if (leaf->active)
+      leaf->Deactivate();
+  }
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::UpdateMajorityClass()
+{
+  const size_t seen = arma::accu(classCounts);
+  if (active && numSamples == seen)
+  {
+    // Grab majority class from splits.
+    if (categoricalSplits.size() > 0)
+    {
+      majorityClass = categoricalSplits[0].MajorityClass();
+      majorityProbability = categoricalSplits[0].MajorityProbability();
+    }
+    else
+    {
+      majorityClass = numericSplits[0].MajorityClass();
+      majorityProbability = numericSplits[0].MajorityProbability();
+    }
+  }
+  else if (seen > 0)
+  {
+    // The statistics were dropped at some point, so only the class counts
+    // cover every point.
+    arma::uword maxIndex = 0;
+    classCounts.max(maxIndex);
+    majorityClass = (size_t) maxIndex;
+    majorityProbability = double(classCounts[maxIndex]) / seen;
+  }
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+size_t HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::StatisticsMemoryUsage() const
+{
+  size_t memory = 0;
+  for (size_t i = 0; i < numericSplits.size(); ++i)
+    memory += numericSplits[i].MemoryUsage();
+  for (size_t i = 0; i < categoricalSplits.size(); ++i)
+    memory += categoricalSplits[i].MemoryUsage();
+
+  return memory;
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+size_t HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::InactiveMemoryUsage() const
+{
+  if (!active)
+    return StatisticsMemoryUsage();
+
+  size_t memory = 0;
+  if (numericSplits.size() > 0)
+    memory += NumericSplitType<FitnessFunction>(numClasses,
+        numericSplits[0]).MemoryUsage();
+  if (categoricalSplits.size() > 0)
+    memory += CategoricalSplitType<FitnessFunction>(0, numClasses,
+        categoricalSplits[0]).MemoryUsage();
+
+  return memory;
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+size_t HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::ActiveMemoryUsage() const
+{
+  // Create the splits of each dimension one at a time, to measure them.
+  size_t memory = 0;
+  for (size_t i = 0; i < datasetInfo->Dimensionality(); ++i)
+  {
+    if (datasetInfo->Type(i) == data::Datatype::categorical)
+      memory += CategoricalSplitType<FitnessFunction>(
+          datasetInfo->NumMappings(i), numClasses,
+          categoricalSplits[0]).MemoryUsage();
+    else
+      memory += NumericSplitType<FitnessFunction>(numClasses,
+          numericSplits[0]).MemoryUsage();
+  }
+
+  return memory;
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::Deactivate()
+{
+  std::vector<NumericSplitType<FitnessFunction>> numericPrototype;
+  if (numericSplits.size() > 0)
+    numericPrototype.push_back(NumericSplitType<FitnessFunction>(numClasses,
+        numericSplits[0]));
+  std::vector<CategoricalSplitType<FitnessFunction>> categoricalPrototype;
+  if (categoricalSplits.size() > 0)
+    categoricalPrototype.push_back(CategoricalSplitType<FitnessFunction>(0,
+        numClasses, categoricalSplits[0]));
+
+  numericSplits.swap(numericPrototype);
+  categoricalSplits.swap(categoricalPrototype);
+
+  // The statistics will start from scratch if the leaf is reactivated.
+  numSamples = 0;
+  active = false;
+}
+
+template<
+    typename FitnessFunction,
+    template<typename> class NumericSplitType,
+    template<typename> class CategoricalSplitType
+>
+void HoeffdingTree<
+    FitnessFunction,
+    NumericSplitType,
+    CategoricalSplitType
+>::Activate()
+{
+  std::vector<NumericSplitType<FitnessFunction>> numericPrototype;
+  std::vector<CategoricalSplitType<FitnessFunction>> categoricalPrototype;
+  numericPrototype.swap(numericSplits);
+  categoricalPrototype.swap(categoricalSplits);
+
+  // The splits must be in the order of the dimension mappings.
+  for (size_t i = 0; i < datasetInfo->Dimensionality(); ++i)
+  {
+    if (datasetInfo->Type(i) == data::Datatype::categorical)
+      categoricalSplits.push_back(CategoricalSplitType<FitnessFunction>(
+          datasetInfo->NumMappings(i), numClasses, categoricalPrototype[0]));
+    else
+      numericSplits.push_back(NumericSplitType<FitnessFunction>(numClasses,
+          numericPrototype[0]));
+  }
+
+  active = true;
+}
+
 template<
     typename FitnessFunction,
     template<typename> class NumericSplitType,
@@ -652,6 +1081,7 @@ void HoeffdingTree<
   // Eliminate now-unnecessary split information.
   numericSplits.clear();
   categoricalSplits.clear();
+  classCounts.reset();
 }
 
 template<
@@ -664,12 +1094,25 @@ void HoeffdingTree<
     FitnessFunction,
     NumericSplitType,
     CategoricalSplitType
->::Serialize(Archive& ar, const unsigned int /* version */)
+>::Serialize(Archive& ar, const unsigned int version)
 {
   using data::CreateNVP;
 
   ar & CreateNVP(splitDimension, "splitDimension");
 
+  if (version >= 1)
+  {
+    ar & CreateNVP(maxMemory, "maxMemory");
+    ar & CreateNVP(memoryCheckInterval, "memoryCheckInterval");
+  }
+  else if (Archive::is_loading::value)
+  {
+    maxMemory = 0;
+    memoryCheckInterval = 1000;
+  }
+  if (Archive::is_loading::value)
+    pointsSinceMemoryCheck = 0;
+
   // Clear memory for the mappings if necessary.
   if (Archive::is_loading::value && ownsMappings && dimensionMappings)
     delete dimensionMappings;
@@ -709,6 +1152,28 @@ void HoeffdingTree<
     ar & CreateNVP(maxSamples, "maxSamples");
     ar & CreateNVP(successProbability, "successProbability");
 
+    if (version >= 1)
+    {
+      ar & CreateNVP(classCounts, "classCounts");
+      ar & CreateNVP(active, "active");
+    }
+    else if (Archive::is_loading::value)
+    {
+      // Older models don't have the class counts, so make up counts with the
+      // same majority class and number of misclassified points.
+      classCounts.zeros(numClasses);
+      if (numSamples > 0 && numClasses > 0)
+      {
+        const size_t majorityCount = std::min(numSamples,
+            (size_t) std::round(majorityProbability * numSamples));
+        classCounts[majorityClass] = majorityCount;
+        if (numClasses > 1)
+          classCounts[(majorityClass + 1) % numClasses] = numSamples -
+              majorityCount;
+      }
+      active = true;
+    }
+
     // Serialize the splits, but not if we haven't seen any samples yet (in
     // which case we can just reinitialize).
     if (Archive::is_loading::value)
@@ -730,10 +1195,14 @@ void HoeffdingTree<
       categoricalSplit = typename CategoricalSplitType<FitnessFunction>::
           SplitInfo(numClasses);
       numericSplit = typename NumericSplitType<FitnessFunction>::SplitInfo();
+
+      // An inactive leaf only keeps the prototypes of its splits.
+      if (!active)
+        Deactivate();
     }
 
     // There's no need to serialize if there's no information contained in the
-    // splits.
+    // splits (which is always the case for inactive leaves).
     if (numSamples == 0)
       return;
 
@@ -794,6 +1263,8 @@ void HoeffdingTree<
       numClasses = 0;
       maxSamples = 0;
       successProbability = 0.0;
+      classCounts.reset();
+      active = true;
     }
   }
 }
@@ -7,8 +7,9 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/hoeffding_trees/hoeffding_tree.hpp>
 #include <mlpack/methods/hoeffding_trees/binary_numeric_split.hpp>
+#include <mlpack/methods/hoeffding_trees/quantile_numeric_split.hpp>
 #include <mlpack/methods/hoeffding_trees/information_gain.hpp>
-#include <queue>
+#include <mlpack/methods/hoeffding_trees/flat_hoeffding_tree.hpp>
 
 using namespace std;
 using namespace mlpack;
@@ -39,7 +40,13 @@ PROGRAM_INFO("Hoeffding trees",
     " with the --test_labels_file (-L) option.  Predictions for each test point"
     " will be stored in the file specified by --predictions_file (-p) and "
     "probabilities for each predictions will be stored in the file specified by"
-    " the --probabilities_file (-P) option.");
+    " the --probabilities_file (-P) option."
+    "\n\n"
+    "The memory used by the tree may be bounded with the --max_memory (-X) "
+    "option.  When the tree reaches that size, its least promising leaves stop "
+    "collecting the statistics needed to split (they can still classify "
+    "points), and they may start again later if they become more promising "
+    "than the other leaves.");
 
 PARAM_STRING("training_file", "Training dataset file.", "t", "");
 PARAM_STRING("labels_file", "Labels for training dataset.", "l", "");
@@ -62,19 +69,24 @@ PARAM_STRING("probabilities_file", "In addition to predicting labels, "
     "provide prediction probabilities in this file.", "P", "");
 
 PARAM_STRING("numeric_split_strategy", "The splitting strategy to use for "
-    "numeric features: 'domingos' or 'binary'.", "N", "binary");
+    "numeric features: 'domingos', 'binary', or 'quantile'.", "N", "binary");
 PARAM_FLAG("batch_mode", "If true, samples will be considered in batch instead "
     "of as a stream.  This generally results in better trees but at the cost of"
     " memory usage and runtime.", "b");
 PARAM_FLAG("info_gain", "If set, information gain is used instead of Gini "
     "impurity for calculating Hoeffding bounds.", "i");
 PARAM_INT("passes", "Number of passes to take over the dataset.", "s", 1);
+PARAM_DOUBLE("max_memory", "Maximum memory used by the tree, in megabytes (0 "
+    "indicates no limit).", "X", 0.0);
 
 PARAM_INT("bins", "If the 'domingos' split strategy is used, this specifies "
     "the number of bins for each numeric split.", "B", 10);
 PARAM_INT("observations_before_binning", "If the 'domingos' split strategy is "
     "used, this specifies the number of samples observed before binning is "
     "performed.", "o", 100);
+PARAM_INT("max_centroids", "If the 'quantile' split strategy is used, this "
+    "specifies the maximum number of centroids of the quantile sketch of each "
+    "numeric split.", "C", 100);
 
 // Helper function for once we have chosen a tree type.
 template<typename TreeType>
@@ -114,6 +126,10 @@ int main(int argc, char** argv)
   if (!CLI::HasParam("training_file") && CLI::HasParam("batch_mode"))
     Log::Warn << "--batch_mode (-b) ignored; no training set provided." << endl;
 
+  if (CLI::GetParam<double>("max_memory") < 0.0)
+    Log::Fatal << "--max_memory (-X) must be greater than or equal to 0!"
+        << endl;
+
   if (CLI::HasParam("passes") && CLI::HasParam("batch_mode"))
     Log::Warn << "--batch_mode (-b) ignored because --passes was specified."
         << endl;
@@ -135,11 +151,18 @@ int main(int argc, char** argv)
       PerformActions<HoeffdingTree<InformationGain, BinaryDoubleNumericSplit,
           HoeffdingCategoricalSplit>>();
     }
+    else if (numericSplitStrategy == "quantile")
+    {
+      const size_t maxCentroids = (size_t) CLI::GetParam<int>("max_centroids");
+      QuantileDoubleNumericSplit<InformationGain> ns(0, maxCentroids);
+      PerformActions<HoeffdingTree<InformationGain, QuantileDoubleNumericSplit,
+          HoeffdingCategoricalSplit>>(ns);
+    }
     else
     {
       Log::Fatal << "Unrecognized numeric split strategy ("
-          << numericSplitStrategy << ")!  Must be 'domingos' or 'binary'."
-          << endl;
+          << numericSplitStrategy << ")!  Must be 'domingos', 'binary', or "
+          << "'quantile'." << endl;
     }
   }
   else
@@ -159,11 +182,18 @@ int main(int argc, char** argv)
       PerformActions<HoeffdingTree<GiniImpurity, BinaryDoubleNumericSplit,
           HoeffdingCategoricalSplit>>();
     }
+    else if (numericSplitStrategy == "quantile")
+    {
+      const size_t maxCentroids = (size_t) CLI::GetParam<int>("max_centroids");
+      QuantileDoubleNumericSplit<GiniImpurity> ns(0, maxCentroids);
+      PerformActions<HoeffdingTree<GiniImpurity, QuantileDoubleNumericSplit,
+          HoeffdingCategoricalSplit>>(ns);
+    }
     else
     {
       Log::Fatal << "Unrecognized numeric split strategy ("
-          << numericSplitStrategy << ")!  Must be 'domingos' or 'binary'."
-          << endl;
+          << numericSplitStrategy << ")!  Must be 'domingos', 'binary', or "
+          << "'quantile'." << endl;
     }
   }
 }
@@ -188,6 +218,8 @@ void PerformActions(const typename TreeType::NumericSplit& numericSplit)
   const size_t passes = (size_t) CLI::GetParam<int>("passes");
   if (passes > 1)
     batchTraining = false; // We already warned about this earlier.
+  const size_t maxMemory = (size_t) (CLI::GetParam<double>("max_memory") *
+      1024 * 1024);
 
   TreeType* tree = NULL;
   DatasetInfo datasetInfo;
@@ -208,10 +240,13 @@ void PerformActions(const typename TreeType::NumericSplit& numericSplit)
     if (passes > 1)
       Log::Info << "Taking " << passes << " passes over the dataset." << endl;
 
-    tree = new TreeType(trainingSet, datasetInfo, labels, max(labels) + 1,
-        batchTraining, confidence, maxSamples, 100, minSamples,
-        typename TreeType::CategoricalSplit(0, 0), numericSplit);
+    // The memory budget must be set before the tree is trained.
+    tree = new TreeType(datasetInfo, max(labels) + 1, confidence, maxSamples,
+        100, minSamples, typename TreeType::CategoricalSplit(0, 0),
+        numericSplit);
+    tree->MaxMemory(maxMemory);
 
+    tree->Train(trainingSet, labels, batchTraining);
     for (size_t i = 1; i < passes; ++i)
       tree->Train(trainingSet, labels, false);
     Timer::Stop("tree_training");
@@ -220,6 +255,11 @@ void PerformActions(const typename TreeType::NumericSplit& numericSplit)
   {
     tree = new TreeType(datasetInfo, 1, 1);
     data::Load(inputModelFile, "streamingDecisionTree", *tree, true);
+    if (CLI::HasParam("max_memory"))
+    {
+      tree->MaxMemory(maxMemory);
+      tree->EnforceMemoryBudget();
+    }
 
     if (CLI::HasParam("training_file"))
     {
@@ -249,13 +289,16 @@ void PerformActions(const typename TreeType::NumericSplit& numericSplit)
     }
   }
 
+  // Classification is done with a flattened copy of the tree, which is faster.
+  FlatHoeffdingTree flatTree(*tree);
+
   if (CLI::HasParam("training_file"))
   {
     // Get training error.
     arma::mat trainingSet;
     data::Load(trainingFile, trainingSet, datasetInfo, true);
     arma::Row<size_t> predictions;
-    tree->Classify(trainingSet, predictions);
+    flatTree.Classify(trainingSet, predictions);
 
     arma::Col<size_t> labelsIn;
     data::Load(labelsFile, labelsIn, true, false);
@@ -271,20 +314,9 @@ void PerformActions(const typename TreeType::NumericSplit& numericSplit)
         100.0 << ")." << endl;
   }
 
-  // Get the number of nods in the tree.
-  std::queue<TreeType*> queue;
-  queue.push(tree);
-  size_t nodes = 0;
-  while (!queue.empty())
-  {
-    TreeType* node = queue.front();
-    queue.pop();
-    ++nodes;
-
-    for (size_t i = 0; i < node->NumChildren(); ++i)
-      queue.push(&node->Child(i));
-  }
-  Log::Info << nodes << " nodes in the tree." << endl;
+  Log::Info << flatTree.NumNodes() << " nodes in the tree." << endl;
+  Log::Info << "The tree uses " << tree->MemoryUsage() << " bytes of memory."
+      << endl;
 
   // The tree is trained or loaded.  Now do any testing if we need.
   if (CLI::HasParam("test_file"))
@@ -296,7 +328,7 @@ void PerformActions(const typename TreeType::NumericSplit& numericSplit)
     arma::rowvec probabilities;
 
     Timer::Start("tree_testing");
-    tree->Classify(testSet, predictions, probabilities);
+    flatTree.Classify(testSet, predictions, probabilities);
     Timer::Stop("tree_testing");
 
     if (CLI::HasParam("test_labels_file"))
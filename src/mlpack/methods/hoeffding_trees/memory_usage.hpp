@@ -0,0 +1,45 @@
+/**
+ * @file memory_usage.hpp
+ *
+ * Helper functions to count the memory used by the statistics of the splits of
+ * a Hoeffding tree.
+ */
+#ifndef MLPACK_METHODS_HOEFFDING_TREES_MEMORY_USAGE_HPP
+#define MLPACK_METHODS_HOEFFDING_TREES_MEMORY_USAGE_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Return the number of bytes of heap memory held by the given Armadillo
+ * object.  Small objects keep their elements inside the object itself, so they
+ * hold no heap memory.
+ *
+ * @param x Object to count the memory of.
+ */
+template<typename eT>
+inline size_t HeapMemoryUsage(const arma::Mat<eT>& x)
+{
+  return (x.n_elem > arma::arma_config::mat_prealloc) ?
+      x.n_elem * sizeof(eT) : 0;
+}
+
+/**
+ * Return the number of bytes of heap memory held by the given std::multimap
+ * (or std::map).  Each element is stored in its own node of a red-black tree,
+ * which also holds three links and a color.
+ *
+ * @param x Object to count the memory of.
+ */
+template<typename MapType>
+inline size_t MapMemoryUsage(const MapType& x)
+{
+  return x.size() * (sizeof(typename MapType::value_type) + 4 * sizeof(void*));
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
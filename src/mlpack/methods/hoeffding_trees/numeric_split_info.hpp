@@ -31,6 +31,10 @@ class NumericSplitInfo
     return bin;
   }
 
+  //! Get the split points (in ascending order); a value goes to the child
+  //! whose index is the number of split points it is greater than.
+  const arma::Col<ObservationType>& SplitPoints() const { return splitPoints; }
+
   //! Serialize the split (save/load the split points).
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
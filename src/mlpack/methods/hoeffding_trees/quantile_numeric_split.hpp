@@ -0,0 +1,165 @@
+/**
+ * @file quantile_numeric_split.hpp
+ *
+ * A numeric feature split for Hoeffding trees which summarizes the observed
+ * values with a bounded-size quantile sketch.
+ */
+#ifndef MLPACK_METHODS_HOEFFDING_TREES_QUANTILE_NUMERIC_SPLIT_HPP
+#define MLPACK_METHODS_HOEFFDING_TREES_QUANTILE_NUMERIC_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+#include "numeric_split_info.hpp"
+#include "memory_usage.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The QuantileNumericSplit class makes binary splits of a numeric feature, like
+ * BinaryNumericSplit, but with a bounded amount of memory.  Instead of keeping
+ * every observed value, the values are summarized by a sketch of at most a
+ * given number of centroids, in the spirit of the t-digest of Dunning and Ertl:
+ *
+ * @code
+ * @article{dunning2019computing,
+ *   title={Computing Extremely Accurate Quantiles Using t-Digests},
+ *   author={Dunning, T. and Ertl, O.},
+ *   journal={arXiv preprint arXiv:1902.04023},
+ *   year={2019}
+ * }
+ * @endcode
+ *
+ * Each centroid holds the mean of the values it summarizes and the number of
+ * these values in each class.  A new value gets its own centroid (unless a
+ * centroid already has exactly this value); when there are too many centroids,
+ * the two adjacent centroids with the smallest total count are merged.  So the
+ * centroids tend to hold similar numbers of points, and the candidate split
+ * points (between adjacent centroids) follow the quantiles of the observed
+ * distribution, whatever its skew, rather than an equal-width binning of the
+ * first points seen (as with HoeffdingNumericSplit).
+ *
+ * Training takes O(c) time and the memory used is O(c * k), where c is the
+ * maximum number of centroids and k is the number of classes.  Evaluating the
+ * fitness function takes O(c * k) time.  A split sends values greater than the
+ * split point to the second child and the others to the first child.
+ *
+ * @tparam FitnessFunction Fitness function to use for calculating gain.
+ * @tparam ObservationType Type of observations in this dimension.
+ */
+template<typename FitnessFunction,
+         typename ObservationType = double>
+class QuantileNumericSplit
+{
+ public:
+  //! The splitting information type required by the QuantileNumericSplit.
+  typedef NumericSplitInfo<ObservationType> SplitInfo;
+
+  /**
+   * Create the QuantileNumericSplit object with the given number of classes and
+   * the given size of the sketch.
+   *
+   * @param numClasses Number of classes.
+   * @param maxCentroids Maximum number of centroids in the sketch.
+   */
+  QuantileNumericSplit(const size_t numClasses,
+                       const size_t maxCentroids = 100);
+
+  /**
+   * Create the QuantileNumericSplit object with the given number of classes,
+   * using the size of the sketch of the given other split.
+   */
+  QuantileNumericSplit(const size_t numClasses,
+                       const QuantileNumericSplit& other);
+
+  /**
+   * Train on the given value with the given label.
+   *
+   * @param value The value to train on.
+   * @param label The label to train on.
+   */
+  void Train(ObservationType value, const size_t label);
+
+  /**
+   * Evaluate the fitness function of the best binary split between adjacent
+   * centroids of the sketch.  Because only that split is kept, the fitness of
+   * the second best split (secondBestFitness) is set to 0, and the best split
+   * competes with the best splits of the other dimensions.
+   *
+   * @param bestFitness Value of the fitness function for the best split.
+   * @param secondBestFitness Value of the fitness function for the second best
+   *      split (always 0 for this split).
+   */
+  void EvaluateFitnessFunction(double& bestFitness, double& secondBestFitness);
+
+  //! Return the number of children if this node splits on this feature.
+  size_t NumChildren() const { return 2; }
+
+  /**
+   * Given that a split should happen, return the majority classes of the (two)
+   * children and an initialized SplitInfo object.
+   *
+   * @param childMajorities Majority classes of the children after the split.
+   * @param splitInfo Split information.
+   */
+  void Split(arma::Col<size_t>& childMajorities, SplitInfo& splitInfo);
+
+  //! Return the majority class.
+  size_t MajorityClass() const;
+  //! Return the probability of the majority class.
+  double MajorityProbability() const;
+
+  //! Return the maximum number of centroids.
+  size_t MaxCentroids() const { return maxCentroids; }
+  //! Return the number of centroids in the sketch.
+  size_t NumCentroids() const { return numCentroids; }
+
+  //! Return the number of bytes of memory used by the split (including the
+  //! object itself).
+  size_t MemoryUsage() const
+  {
+    return sizeof(*this) + HeapMemoryUsage(centroids) +
+        HeapMemoryUsage(counts) + HeapMemoryUsage(totals) +
+        HeapMemoryUsage(classCounts);
+  }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
+ private:
+  //! The maximum number of centroids.
+  size_t maxCentroids;
+  //! The number of centroids in the sketch.
+  size_t numCentroids;
+  //! The means of the centroids, in ascending order (with room for one more
+  //! centroid than the maximum).
+  arma::vec centroids;
+  //! The number of points of each class (rows) in each centroid (columns).
+  arma::Mat<size_t> counts;
+  //! The total number of points in each centroid.
+  arma::Col<size_t> totals;
+  //! The number of points of each class seen so far.
+  arma::Col<size_t> classCounts;
+
+  //! The index of the centroid before the best split point.
+  size_t bestSplit;
+  //! If true, bestSplit is accurate (that is, we have not seen any more
+  //! samples since we calculated it).
+  bool isAccurate;
+
+  //! Merge the two adjacent centroids with the smallest total count.
+  void Merge();
+};
+
+//! Convenience typedef.
+template<typename FitnessFunction>
+using QuantileDoubleNumericSplit = QuantileNumericSplit<FitnessFunction,
+    double>;
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "quantile_numeric_split_impl.hpp"
+
+#endif
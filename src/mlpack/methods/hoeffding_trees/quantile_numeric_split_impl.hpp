@@ -0,0 +1,216 @@
+/**
+ * @file quantile_numeric_split_impl.hpp
+ *
+ * Implementation of the QuantileNumericSplit class.
+ */
+#ifndef MLPACK_METHODS_HOEFFDING_TREES_QUANTILE_NUMERIC_SPLIT_IMPL_HPP
+#define MLPACK_METHODS_HOEFFDING_TREES_QUANTILE_NUMERIC_SPLIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "quantile_numeric_split.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename FitnessFunction, typename ObservationType>
+QuantileNumericSplit<FitnessFunction, ObservationType>::QuantileNumericSplit(
+    const size_t numClasses,
+    const size_t maxCentroids) :
+    maxCentroids(std::max(maxCentroids, (size_t) 2)),
+    numCentroids(0),
+    centroids(this->maxCentroids + 1),
+    counts(arma::zeros<arma::Mat<size_t>>(numClasses, this->maxCentroids + 1)),
+    totals(arma::zeros<arma::Col<size_t>>(this->maxCentroids + 1)),
+    classCounts(arma::zeros<arma::Col<size_t>>(numClasses)),
+    bestSplit(0),
+    isAccurate(true)
+{
+  centroids.zeros();
+}
+
+template<typename FitnessFunction, typename ObservationType>
+QuantileNumericSplit<FitnessFunction, ObservationType>::QuantileNumericSplit(
+    const size_t numClasses,
+    const QuantileNumericSplit& other) :
+    QuantileNumericSplit(numClasses, other.maxCentroids)
+{
+  // Nothing to do.
+}
+
+template<typename FitnessFunction, typename ObservationType>
+void QuantileNumericSplit<FitnessFunction, ObservationType>::Train(
+    ObservationType value,
+    const size_t label)
+{
+  ++classCounts[label];
+  isAccurate = false;
+
+  // Find the first centroid which is not less than the value.
+  const double* begin = centroids.memptr();
+  const size_t i = std::lower_bound(begin, begin + numCentroids,
+      double(value)) - begin;
+  if (i < numCentroids && centroids[i] == double(value))
+  {
+    ++counts(label, i);
+    ++totals[i];
+    return;
+  }
+
+  // Make room for a new centroid before centroid i.
+  std::copy_backward(centroids.memptr() + i,
+      centroids.memptr() + numCentroids,
+      centroids.memptr() + numCentroids + 1);
+  std::copy_backward(totals.memptr() + i, totals.memptr() + numCentroids,
+      totals.memptr() + numCentroids + 1);
+  std::copy_backward(counts.colptr(i), counts.colptr(numCentroids),
+      counts.colptr(numCentroids) + counts.n_rows);
+
+  centroids[i] = double(value);
+  totals[i] = 1;
+  counts.col(i).zeros();
+  counts(label, i) = 1;
+  ++numCentroids;
+
+  if (numCentroids > maxCentroids)
+    Merge();
+}
+
+template<typename FitnessFunction, typename ObservationType>
+void QuantileNumericSplit<FitnessFunction, ObservationType>::
+    EvaluateFitnessFunction(double& bestFitness,
+                            double& secondBestFitness)
+{
+  secondBestFitness = 0.0; // We only keep the best split.
+
+  // Start with every point on the right side of the split, and move the
+  // centroids to the left side one by one.
+  arma::Mat<size_t> splitCounts(classCounts.n_elem, 2);
+  splitCounts.col(0).zeros();
+  splitCounts.col(1) = classCounts;
+
+  bestFitness = FitnessFunction::Evaluate(splitCounts);
+  bestSplit = 0;
+  for (size_t i = 0; i + 1 < numCentroids; ++i)
+  {
+    splitCounts.col(0) += counts.col(i);
+    splitCounts.col(1) -= counts.col(i);
+
+    const double fitness = FitnessFunction::Evaluate(splitCounts);
+    if (fitness > bestFitness)
+    {
+      bestFitness = fitness;
+      bestSplit = i;
+    }
+  }
+
+  isAccurate = true;
+}
+
+template<typename FitnessFunction, typename ObservationType>
+void QuantileNumericSplit<FitnessFunction, ObservationType>::Split(
+    arma::Col<size_t>& childMajorities,
+    SplitInfo& splitInfo)
+{
+  if (!isAccurate)
+  {
+    double bestFitness, secondBestFitness;
+    EvaluateFitnessFunction(bestFitness, secondBestFitness);
+  }
+
+  childMajorities.set_size(2);
+  if (numCentroids < 2)
+  {
+    // There is nothing to split; both children get every point.
+    childMajorities.fill(MajorityClass());
+    arma::Col<ObservationType> splitPoints(1);
+    splitPoints[0] = ObservationType(numCentroids == 0 ? 0.0 : centroids[0]);
+    splitInfo = SplitInfo(splitPoints);
+    return;
+  }
+
+  // Calculate the majority classes of the children.
+  const arma::Col<size_t> leftCounts =
+      arma::sum(counts.cols(0, bestSplit), 1);
+  const arma::Col<size_t> rightCounts = classCounts - leftCounts;
+
+  arma::uword maxIndex;
+  leftCounts.max(maxIndex);
+  childMajorities[0] = size_t(maxIndex);
+  rightCounts.max(maxIndex);
+  childMajorities[1] = size_t(maxIndex);
+
+  // The split point is halfway between the centroids on each side.
+  arma::Col<ObservationType> splitPoints(1);
+  splitPoints[0] = ObservationType((centroids[bestSplit] +
+      centroids[bestSplit + 1]) / 2.0);
+  splitInfo = SplitInfo(splitPoints);
+}
+
+template<typename FitnessFunction, typename ObservationType>
+size_t QuantileNumericSplit<FitnessFunction, ObservationType>::MajorityClass()
+    const
+{
+  arma::uword maxIndex;
+  classCounts.max(maxIndex);
+  return size_t(maxIndex);
+}
+
+template<typename FitnessFunction, typename ObservationType>
+double QuantileNumericSplit<FitnessFunction, ObservationType>::
+    MajorityProbability() const
+{
+  return double(arma::max(classCounts)) / double(arma::accu(classCounts));
+}
+
+template<typename FitnessFunction, typename ObservationType>
+void QuantileNumericSplit<FitnessFunction, ObservationType>::Merge()
+{
+  // Find the adjacent centroids with the smallest total count.
+  size_t merged = 0;
+  for (size_t i = 1; i + 1 < numCentroids; ++i)
+    if (totals[i] + totals[i + 1] < totals[merged] + totals[merged + 1])
+      merged = i;
+
+  // Merge centroid merged + 1 into centroid merged.
+  const double total = double(totals[merged] + totals[merged + 1]);
+  centroids[merged] = (totals[merged] * centroids[merged] +
+      totals[merged + 1] * centroids[merged + 1]) / total;
+  totals[merged] += totals[merged + 1];
+  counts.col(merged) += counts.col(merged + 1);
+
+  // Close the gap.
+  std::copy(centroids.memptr() + merged + 2,
+      centroids.memptr() + numCentroids, centroids.memptr() + merged + 1);
+  std::copy(totals.memptr() + merged + 2, totals.memptr() + numCentroids,
+      totals.memptr() + merged + 1);
+  std::copy(counts.colptr(merged + 2), counts.colptr(numCentroids - 1) +
+      counts.n_rows, counts.colptr(merged + 1));
+  --numCentroids;
+}
+
+template<typename FitnessFunction, typename ObservationType>
+template<typename Archive>
+void QuantileNumericSplit<FitnessFunction, ObservationType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(maxCentroids, "maxCentroids");
+  ar & CreateNVP(numCentroids, "numCentroids");
+  ar & CreateNVP(centroids, "centroids");
+  ar & CreateNVP(counts, "counts");
+  ar & CreateNVP(totals, "totals");
+  ar & CreateNVP(classCounts, "classCounts");
+
+  if (Archive::is_loading::value)
+  {
+    bestSplit = 0;
+    isAccurate = false;
+  }
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
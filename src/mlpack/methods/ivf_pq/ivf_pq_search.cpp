@@ -0,0 +1,312 @@
+/**
+ * @file ivf_pq_search.cpp
+ *
+ * Implementation of the IVFPQSearch class.
+ */
+#include "ivf_pq_search.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
+#include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+IVFPQSearch::IVFPQSearch(const arma::mat& referenceSet,
+                         const size_t numLists,
+                         const size_t numSubspaces,
+                         const size_t numCentroids,
+                         const size_t maxIterations)
+{
+  Train(referenceSet, numLists, numSubspaces, numCentroids, maxIterations);
+}
+
+IVFPQSearch::IVFPQSearch()
+{
+  // Nothing to do.
+}
+
+void IVFPQSearch::Train(const arma::mat& referenceSet,
+                        const size_t numLists,
+                        const size_t numSubspaces,
+                        const size_t numCentroids,
+                        const size_t maxIterations)
+{
+  if (numLists == 0 || numLists > referenceSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "IVFPQSearch::Train(): number of lists (" << numLists << ") must be "
+        << "between 1 and the number of points (" << referenceSet.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (numSubspaces == 0 || numSubspaces > referenceSet.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "IVFPQSearch::Train(): number of subspaces (" << numSubspaces
+        << ") must be between 1 and the dimensionality of the data ("
+        << referenceSet.n_rows << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (numCentroids == 0 || numCentroids > 256 ||
+      numCentroids > referenceSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "IVFPQSearch::Train(): number of centroids (" << numCentroids
+        << ") must be between 1 and 256, and at most the number of points ("
+        << referenceSet.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Train the coarse quantizer.
+  kmeans::KMeans<> kmeans(maxIterations);
+  arma::Row<size_t> assignments;
+  kmeans.Cluster(referenceSet, numLists, assignments, coarseCentroids);
+
+  // Train the quantizer of each subspace on the residuals.
+  arma::mat residuals(referenceSet);
+  for (size_t i = 0; i < residuals.n_cols; ++i)
+    residuals.col(i) -= coarseCentroids.col(assignments[i]);
+
+  codebooks.clear();
+  codebooks.resize(numSubspaces);
+  for (size_t j = 0; j < numSubspaces; ++j)
+  {
+    const arma::mat subResiduals = residuals.rows(SubspaceBegin(j),
+        SubspaceBegin(j + 1) - 1);
+    kmeans.Cluster(subResiduals, numCentroids, codebooks[j]);
+  }
+
+  Log::Info << "IVFPQSearch::Train(): trained " << numLists << " lists and "
+      << numSubspaces << " subspaces with " << numCentroids << " centroids."
+      << std::endl;
+
+  // Now empty the index and encode the points.
+  listOffsets.zeros(numLists + 1);
+  listIndices.reset();
+  codes.set_size(numSubspaces, 0);
+  Insert(referenceSet);
+}
+
+void IVFPQSearch::Insert(const arma::mat& newPoints)
+{
+  if (NumLists() == 0)
+    throw std::invalid_argument("IVFPQSearch::Insert(): the index must be "
+        "trained before points can be inserted");
+
+  if (newPoints.n_rows != Dimensionality())
+  {
+    std::ostringstream oss;
+    oss << "IVFPQSearch::Insert(): dimensionality of new points ("
+        << newPoints.n_rows << ") is not equal to the dimensionality the index "
+        << "was trained on (" << Dimensionality() << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (newPoints.n_cols == 0)
+    return;
+
+  arma::Row<size_t> lists;
+  arma::Mat<unsigned char> newCodes;
+  Encode(newPoints, lists, newCodes);
+
+  // Count the points of each list with the new points.
+  const size_t numLists = NumLists();
+  arma::Col<size_t> newCounts(numLists);
+  for (size_t i = 0; i < numLists; ++i)
+    newCounts[i] = listOffsets[i + 1] - listOffsets[i];
+  for (size_t i = 0; i < lists.n_elem; ++i)
+    newCounts[lists[i]]++;
+
+  arma::Col<size_t> newOffsets(numLists + 1);
+  newOffsets[0] = 0;
+  for (size_t i = 0; i < numLists; ++i)
+    newOffsets[i + 1] = newOffsets[i] + newCounts[i];
+
+  // Copy the existing points of each list, then add the new points after them.
+  // 'next' holds the position of the next point of each list.
+  const size_t oldNumPoints = NumPoints();
+  arma::Col<size_t> newIndices(newOffsets[numLists]);
+  arma::Mat<unsigned char> allCodes(NumSubspaces(), newOffsets[numLists]);
+  arma::Col<size_t> next(numLists);
+  for (size_t i = 0; i < numLists; ++i)
+  {
+    const size_t size = listOffsets[i + 1] - listOffsets[i];
+    if (size > 0)
+    {
+      newIndices.subvec(newOffsets[i], newOffsets[i] + size - 1) =
+          listIndices.subvec(listOffsets[i], listOffsets[i + 1] - 1);
+      allCodes.cols(newOffsets[i], newOffsets[i] + size - 1) =
+          codes.cols(listOffsets[i], listOffsets[i + 1] - 1);
+    }
+
+    next[i] = newOffsets[i] + size;
+  }
+
+  for (size_t i = 0; i < lists.n_elem; ++i)
+  {
+    const size_t position = next[lists[i]]++;
+    newIndices[position] = oldNumPoints + i;
+    allCodes.col(position) = newCodes.col(i);
+  }
+
+  listOffsets = std::move(newOffsets);
+  listIndices = std::move(newIndices);
+  codes = std::move(allCodes);
+}
+
+void IVFPQSearch::Search(const arma::mat& querySet,
+                         const size_t k,
+                         arma::Mat<size_t>& resultingNeighbors,
+                         arma::mat& distances,
+                         const size_t numProbes) const
+{
+  if (NumLists() == 0)
+    throw std::invalid_argument("IVFPQSearch::Search(): the index must be "
+        "trained before it can be searched");
+
+  if (querySet.n_rows != Dimensionality())
+  {
+    std::ostringstream oss;
+    oss << "IVFPQSearch::Search(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality the index "
+        << "was trained on (" << Dimensionality() << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (k > NumPoints())
+  {
+    std::ostringstream oss;
+    oss << "IVFPQSearch::Search(): requested " << k << " approximate nearest "
+        << "neighbors, but the index has " << NumPoints() << " points!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (numProbes == 0)
+    throw std::invalid_argument("IVFPQSearch::Search(): number of probes must "
+        "be greater than 0");
+
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  resultingNeighbors.fill(NumPoints());
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(NearestNeighborSort::WorstDistance());
+
+  if (k == 0)
+    return;
+
+  const size_t numLists = NumLists();
+  const size_t numVisited = std::min(numProbes, numLists);
+  const size_t numSubspaces = NumSubspaces();
+  const size_t numCentroids = NumCentroids();
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t q = 0; q < (omp_size_t) querySet.n_cols; ++q)
+  {
+    double* queryDistances = distances.colptr(q);
+    size_t* queryNeighbors = resultingNeighbors.colptr(q);
+
+    // Find the closest cells.
+    std::vector<std::pair<double, size_t>> cells(numLists);
+    for (size_t i = 0; i < numLists; ++i)
+      cells[i] = std::make_pair(metric::SquaredEuclideanDistance::Evaluate(
+          querySet.unsafe_col(q), coarseCentroids.unsafe_col(i)), i);
+    std::partial_sort(cells.begin(), cells.begin() + numVisited, cells.end());
+
+    arma::mat table(numCentroids, numSubspaces);
+    for (size_t p = 0; p < numVisited; ++p)
+    {
+      const size_t list = cells[p].second;
+      if (listOffsets[list] == listOffsets[list + 1])
+        continue;
+
+      // Compute the squared distances from the residual of the query to every
+      // centroid of every subspace.
+      const arma::vec residual = querySet.col(q) - coarseCentroids.col(list);
+      for (size_t j = 0; j < numSubspaces; ++j)
+      {
+        const arma::vec subResidual = residual.subvec(SubspaceBegin(j),
+            SubspaceBegin(j + 1) - 1);
+        for (size_t c = 0; c < numCentroids; ++c)
+          table(c, j) = metric::SquaredEuclideanDistance::Evaluate(
+              subResidual, codebooks[j].unsafe_col(c));
+      }
+
+      // The distance to each point of the list is the sum of the distances of
+      // the centroids of its code.
+      for (size_t i = listOffsets[list]; i < listOffsets[list + 1]; ++i)
+      {
+        const unsigned char* code = codes.colptr(i);
+        double distance = 0.0;
+        for (size_t j = 0; j < numSubspaces; ++j)
+          distance += table(code[j], j);
+
+        CandidateHeap<NearestNeighborSort>::Insert(queryDistances,
+            queryNeighbors, k, distance, listIndices[i]);
+      }
+    }
+
+    CandidateHeap<NearestNeighborSort>::Sort(queryDistances, queryNeighbors,
+        k);
+    for (size_t i = 0; i < k; ++i)
+      if (queryDistances[i] != NearestNeighborSort::WorstDistance())
+        queryDistances[i] = std::sqrt(queryDistances[i]);
+  }
+}
+
+size_t IVFPQSearch::SubspaceBegin(const size_t subspace) const
+{
+  // The first (d % numSubspaces) subspaces get one extra dimension.
+  const size_t dimensionality = Dimensionality();
+  const size_t numSubspaces = NumSubspaces();
+  return subspace * (dimensionality / numSubspaces) +
+      std::min(subspace, dimensionality % numSubspaces);
+}
+
+void IVFPQSearch::Encode(const arma::mat& points,
+                         arma::Row<size_t>& lists,
+                         arma::Mat<unsigned char>& pointCodes) const
+{
+  const size_t numSubspaces = NumSubspaces();
+  lists.set_size(points.n_cols);
+  pointCodes.set_size(numSubspaces, points.n_cols);
+
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) points.n_cols; ++i)
+  {
+    // Find the closest cell.
+    double bestDistance = DBL_MAX;
+    lists[i] = 0;
+    for (size_t c = 0; c < coarseCentroids.n_cols; ++c)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          points.unsafe_col(i), coarseCentroids.unsafe_col(c));
+      if (distance < bestDistance)
+      {
+        bestDistance = distance;
+        lists[i] = c;
+      }
+    }
+
+    // Encode each subvector of the residual by its closest centroid.
+    const arma::vec residual = points.col(i) - coarseCentroids.col(lists[i]);
+    for (size_t j = 0; j < numSubspaces; ++j)
+    {
+      const arma::vec subResidual = residual.subvec(SubspaceBegin(j),
+          SubspaceBegin(j + 1) - 1);
+      bestDistance = DBL_MAX;
+      pointCodes(j, i) = 0;
+      for (size_t c = 0; c < codebooks[j].n_cols; ++c)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            subResidual, codebooks[j].unsafe_col(c));
+        if (distance < bestDistance)
+        {
+          bestDistance = distance;
+          pointCodes(j, i) = (unsigned char) c;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,208 @@
+/**
+ * @file ivf_pq_search.hpp
+ *
+ * Defines the IVFPQSearch class, which performs approximate nearest neighbor
+ * search with an inverted file index and product quantization (IVF-PQ).
+ *
+ * The details of this method can be found in the following paper:
+ *
+ * @article{jegou2011product,
+ *   title={Product quantization for nearest neighbor search},
+ *   author={J{\'e}gou, H. and Douze, M. and Schmid, C.},
+ *   journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *   volume={33},
+ *   number={1},
+ *   pages={117--128},
+ *   year={2011}
+ * }
+ */
+#ifndef MLPACK_METHODS_IVF_PQ_IVF_PQ_SEARCH_HPP
+#define MLPACK_METHODS_IVF_PQ_IVF_PQ_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The IVFPQSearch class is a compressed index for approximate nearest neighbor
+ * search with the Euclidean distance.  It does not keep the reference points;
+ * each point is stored as a code of one byte per subspace, so a point takes
+ * numSubspaces bytes (plus its index) instead of eight bytes per dimension.
+ *
+ * The index has two levels of quantization.  First, a coarse quantizer
+ * (trained with k-means) splits the space into numLists cells, and each point
+ * is put into the inverted list of its cell.  Then the residual of each point
+ * (its difference to the center of its cell) is split into numSubspaces
+ * subvectors of consecutive dimensions, and each subvector is encoded by the
+ * index of the nearest of numCentroids centroids (trained with k-means on the
+ * residuals of that subspace).
+ *
+ * A query only visits the numProbes inverted lists whose cells are closest to
+ * it.  For each visited list, the squared distances from the residual of the
+ * query to every centroid of every subspace are computed once, and then the
+ * (asymmetric) distance to each point of the list is the sum of numSubspaces
+ * table lookups.
+ *
+ * @code
+ * // 1000 inverted lists, 16 bytes per point.
+ * IVFPQSearch pq(trainingSet, 1000, 16);
+ * pq.Insert(moreData);
+ * pq.Search(querySet, 10, neighbors, distances, 16);
+ * @endcode
+ *
+ * Because the points are not stored, the distances returned by Search() are
+ * the approximate distances between the queries and the encoded points.
+ */
+class IVFPQSearch
+{
+ public:
+  /**
+   * Train the quantizers on the given dataset, and then encode the dataset into
+   * the index.  See Train() for details.
+   *
+   * @param referenceSet Set of reference points.
+   * @param numLists Number of inverted lists (cells of the coarse quantizer).
+   * @param numSubspaces Number of subspaces (bytes per encoded point).
+   * @param numCentroids Number of centroids of each subspace (at most 256).
+   * @param maxIterations Maximum number of iterations of each k-means run.
+   */
+  IVFPQSearch(const arma::mat& referenceSet,
+              const size_t numLists,
+              const size_t numSubspaces,
+              const size_t numCentroids = 256,
+              const size_t maxIterations = 100);
+
+  /**
+   * Create an untrained index.  Be sure to call Train() before calling
+   * Insert() or Search(); otherwise, an exception will be thrown.
+   */
+  IVFPQSearch();
+
+  /**
+   * Train the coarse quantizer and the product quantizer on the given dataset,
+   * and then encode the dataset into the index (replacing what it held).  For
+   * very large datasets, the quantizers can be trained on a sample of the
+   * points, and the rest of the points can then be added with Insert().  A
+   * std::invalid_argument is thrown if the parameters don't fit the dataset:
+   * there must be at least numLists and numCentroids points and at least
+   * numSubspaces dimensions, and numCentroids must be between 1 and 256.
+   *
+   * @param referenceSet Set of reference points.
+   * @param numLists Number of inverted lists (cells of the coarse quantizer).
+   * @param numSubspaces Number of subspaces (bytes per encoded point).
+   * @param numCentroids Number of centroids of each subspace (at most 256).
+   * @param maxIterations Maximum number of iterations of each k-means run.
+   */
+  void Train(const arma::mat& referenceSet,
+             const size_t numLists,
+             const size_t numSubspaces,
+             const size_t numCentroids = 256,
+             const size_t maxIterations = 100);
+
+  /**
+   * Encode the given points with the trained quantizers and add them to the
+   * index.  The new points get the next indices, so the first new point has
+   * index n, where n is the number of points in the index before the call.  A
+   * std::invalid_argument is thrown if the index is not trained or the points
+   * have the wrong dimensionality.
+   *
+   * @param newPoints Points to add to the index.
+   */
+  void Insert(const arma::mat& newPoints);
+
+  /**
+   * Compute the approximate nearest neighbors of the points in the given query
+   * set and store the output in the given matrices.  The matrices will be set
+   * to the size of n columns by k rows, where n is the number of points in the
+   * query set.  If fewer than k points are found in the visited lists, the
+   * remaining neighbors are set to the number of points in the index, with a
+   * distance of DBL_MAX.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing the approximate distances of neighbors
+   *     for each query point.
+   * @param numProbes Number of inverted lists to visit for each query; more
+   *     lists give better recall but slower searches.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances,
+              const size_t numProbes = 1) const;
+
+  /**
+   * Serialize the index.
+   *
+   * @param ar Archive to serialize to.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
+  //! Get the dimensionality of the indexed points.
+  size_t Dimensionality() const { return coarseCentroids.n_rows; }
+  //! Get the number of points in the index.
+  size_t NumPoints() const { return listIndices.n_elem; }
+  //! Get the number of inverted lists.
+  size_t NumLists() const { return coarseCentroids.n_cols; }
+  //! Get the number of subspaces.
+  size_t NumSubspaces() const { return codebooks.size(); }
+  //! Get the number of centroids of each subspace.
+  size_t NumCentroids() const
+  { return codebooks.empty() ? 0 : codebooks[0].n_cols; }
+
+  //! Get the centers of the cells of the coarse quantizer (one per column).
+  const arma::mat& CoarseCentroids() const { return coarseCentroids; }
+  //! Get the centroids of subspace i (one per column).
+  const arma::mat& Codebook(const size_t i) const { return codebooks[i]; }
+
+  //! Get the offsets of the inverted lists.  The points in list i are
+  //! ListIndices()[ListOffsets()[i]] up to (but not including)
+  //! ListIndices()[ListOffsets()[i + 1]].
+  const arma::Col<size_t>& ListOffsets() const { return listOffsets; }
+  //! Get the indices of the points of all the inverted lists, list after list.
+  const arma::Col<size_t>& ListIndices() const { return listIndices; }
+  //! Get the codes of the points, in the same order as ListIndices(); column
+  //! i holds the code of point ListIndices()[i] (one byte per subspace).
+  const arma::Mat<unsigned char>& Codes() const { return codes; }
+
+ private:
+  //! Get the first dimension of the given subspace.
+  size_t SubspaceBegin(const size_t subspace) const;
+
+  /**
+   * Find the nearest coarse centroid of each point, and encode the residual of
+   * each point with the product quantizer.
+   *
+   * @param points Points to encode.
+   * @param lists The inverted list of each point.
+   * @param pointCodes The code of each point (one column per point).
+   */
+  void Encode(const arma::mat& points,
+              arma::Row<size_t>& lists,
+              arma::Mat<unsigned char>& pointCodes) const;
+
+  //! The centers of the cells of the coarse quantizer.
+  arma::mat coarseCentroids;
+  //! The centroids of each subspace.
+  std::vector<arma::mat> codebooks;
+
+  //! The offset of each inverted list in listIndices and codes, plus the total
+  //! number of points at the end; length numLists + 1.
+  arma::Col<size_t> listOffsets;
+  //! The indices of the points of each inverted list, list after list.
+  arma::Col<size_t> listIndices;
+  //! The codes of the points, in the same order as listIndices.
+  arma::Mat<unsigned char> codes;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation of Serialize().
+#include "ivf_pq_search_impl.hpp"
+
+#endif
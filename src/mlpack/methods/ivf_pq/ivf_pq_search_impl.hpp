@@ -0,0 +1,31 @@
+/**
+ * @file ivf_pq_search_impl.hpp
+ *
+ * Implementation of the templated Serialize() function of the IVFPQSearch
+ * class.
+ */
+#ifndef MLPACK_METHODS_IVF_PQ_IVF_PQ_SEARCH_IMPL_HPP
+#define MLPACK_METHODS_IVF_PQ_IVF_PQ_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "ivf_pq_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename Archive>
+void IVFPQSearch::Serialize(Archive& ar, const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(coarseCentroids, "coarseCentroids");
+  ar & CreateNVP(codebooks, "codebooks");
+  ar & CreateNVP(listOffsets, "listOffsets");
+  ar & CreateNVP(listIndices, "listIndices");
+  ar & CreateNVP(codes, "codes");
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * @file kde.hpp
+ *
+ * Defines the KDE class, which performs kernel density estimation with trees.
+ */
+#ifndef MLPACK_METHODS_KDE_KDE_HPP
+#define MLPACK_METHODS_KDE_KDE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde /** Kernel density estimation. */ {
+
+/**
+ * The KDE class performs kernel density estimation: the density at a query
+ * point q, given the reference points r_1, ..., r_N, is estimated as
+ *
+ *   f(q) = (1 / (N h)) sum_i K(d(q, r_i)),
+ *
+ * where K is the kernel, d is the metric and h is the normalizer of the kernel
+ * (its integral), if the kernel has a Normalizer(dimension) function (as the
+ * GaussianKernel, EpanechnikovKernel and SphericalKernel do); otherwise h is 1
+ * and the estimates are not normalized.
+ *
+ * The estimates are computed with trees built on the reference points (and, in
+ * dual-tree mode, on the query points), in the style of a generalized
+ * tree-independent dual-tree algorithm (see the KDERules class).  The kernel
+ * values of a reference node are approximated when the bounds on the distances
+ * to the node are tight enough, so that each estimate differs from the exact
+ * estimate by at most relError times the exact estimate plus absError.
+ * Setting both errors to 0 gives the exact estimates.  With trees whose first
+ * point is the centroid of each node (like the cover tree), dual-tree mode
+ * uses a single-tree traversal for each query point instead.
+ *
+ * @code
+ * extern arma::mat reference, query;
+ * KDE<> kde(0.05, 0.0, kernel::GaussianKernel(0.5));
+ * kde.Train(reference);
+ *
+ * arma::vec estimations;
+ * kde.Evaluate(query, estimations);
+ * @endcode
+ *
+ * Naive and single-tree estimation handle blocks of query points in parallel.
+ *
+ * @tparam KernelType Kernel to use; must be a decreasing function of the
+ *      distance with an Evaluate(double distance) function.
+ * @tparam MetricType Metric to use.
+ * @tparam MatType Type of data to use.
+ * @tparam TreeType Type of tree to use; must satisfy the TreeType policy API.
+ */
+template<typename KernelType = kernel::GaussianKernel,
+         typename MetricType = metric::EuclideanDistance,
+         typename MatType = arma::mat,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class KDE
+{
+ public:
+  //! Convenience typedef.
+  typedef TreeType<MetricType, tree::EmptyStatistic, MatType> Tree;
+
+  /**
+   * Create the KDE object without any reference data; call Train() before
+   * Evaluate().  A std::invalid_argument is thrown if either error tolerance
+   * is negative.
+   *
+   * @param relError Relative error tolerance of each estimate.
+   * @param absError Absolute error tolerance of each estimate.
+   * @param kernel Instantiated kernel.
+   * @param metric Instantiated distance metric.
+   * @param naive If true, the estimates are computed exactly, without trees.
+   *      This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree traversals are used (as opposed to
+   *      dual-tree traversals).
+   */
+  KDE(const double relError = 0.05,
+      const double absError = 0.0,
+      const KernelType& kernel = KernelType(),
+      const MetricType& metric = MetricType(),
+      const bool naive = false,
+      const bool singleMode = false);
+
+  //! The trees can't be copied; use serialization to copy a model.
+  KDE(const KDE& other) = delete;
+  //! The trees can't be copied; use serialization to copy a model.
+  KDE& operator=(const KDE& other) = delete;
+
+  /**
+   * Destroy the KDE object.  If trees were created, they will be deleted.
+   */
+  ~KDE();
+
+  /**
+   * Set the reference set, and build a tree on a copy of it if necessary.  In
+   * naive mode the reference set is not copied, so it must be kept alive.
+   *
+   * @param referenceSet Set of reference points.
+   */
+  void Train(const MatType& referenceSet);
+
+  /**
+   * Set the reference set, taking ownership of it, and build a tree on it if
+   * necessary (which may rearrange the points).
+   *
+   * @param referenceSet Set of reference points.
+   */
+  void Train(MatType&& referenceSet);
+
+  /**
+   * Estimate the density at each point of the query set.  A
+   * std::invalid_argument is thrown if the model has not been trained or if
+   * the dimensionality of the query set does not match that of the reference
+   * set.
+   *
+   * @param querySet Set of query points.
+   * @param estimations Vector to store the estimates in (one per query point).
+   */
+  void Evaluate(const MatType& querySet, arma::vec& estimations);
+
+  /**
+   * Estimate the density at each point of the reference set.  Each reference
+   * point contributes to its own estimate.  A std::invalid_argument is thrown
+   * if the model has not been trained.
+   *
+   * @param estimations Vector to store the estimates in (one per reference
+   *      point).
+   */
+  void Evaluate(arma::vec& estimations);
+
+  //! Get the relative error tolerance.
+  double RelativeError() const { return relError; }
+  //! Set the relative error tolerance (it must not be negative).
+  void RelativeError(const double newError);
+
+  //! Get the absolute error tolerance.
+  double AbsoluteError() const { return absError; }
+  //! Set the absolute error tolerance (it must not be negative).
+  void AbsoluteError(const double newError);
+
+  //! Get the kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the kernel.
+  KernelType& Kernel() { return kernel; }
+
+  //! Get the metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the metric.
+  MetricType& Metric() { return metric; }
+
+  //! Get whether naive estimation is used.
+  bool Naive() const { return naive; }
+  //! Get whether single-tree estimation is used.
+  bool SingleMode() const { return singleMode; }
+  //! Modify whether single-tree estimation is used.
+  bool& SingleMode() { return singleMode; }
+
+  //! Get whether the model has been trained.
+  bool IsTrained() const { return referenceSet != NULL; }
+
+  //! Get the reference set (in the order of the tree, if any).
+  const MatType& ReferenceSet() const { return *referenceSet; }
+  //! Get the reference tree (NULL in naive mode).
+  Tree* ReferenceTree() { return referenceTree; }
+
+  //! Get the number of base cases of the last estimation.
+  size_t BaseCases() const { return baseCases; }
+  //! Get the number of scores of the last estimation.
+  size_t Scores() const { return scores; }
+
+  //! Serialize the model.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+ private:
+  //! Free the reference tree and set, if we own them.
+  void Clear();
+
+  /**
+   * Add the kernel values of the reference points to the density of each
+   * query point, given in the order of the query set (or of the query tree,
+   * if one is given).
+   */
+  void Estimate(const MatType& querySet, Tree* queryTree, arma::vec& densities);
+
+  //! Return the normalizer of the estimates (see KernelNormalizer).
+  double Normalizer();
+
+  //! Reference tree (NULL in naive mode).
+  Tree* referenceTree;
+  //! Reference set.
+  const MatType* referenceSet;
+  //! Mappings to the original reference points (if the tree rearranges them).
+  std::vector<size_t> oldFromNewReferences;
+  //! If true, this object owns the reference tree.
+  bool treeOwner;
+  //! If true, this object owns the reference set (in naive mode).
+  bool setOwner;
+
+  //! Relative error tolerance.
+  double relError;
+  //! Absolute error tolerance.
+  double absError;
+  //! Instantiated kernel.
+  KernelType kernel;
+  //! Instantiated metric.
+  MetricType metric;
+  //! If true, estimate naively.
+  bool naive;
+  //! If true, use single-tree traversals.
+  bool singleMode;
+
+  //! The number of base cases of the last estimation.
+  size_t baseCases;
+  //! The number of scores of the last estimation.
+  size_t scores;
+
+  //! The number of query points in each block of a parallel naive or
+  //! single-tree estimation.
+  static const size_t QueryBlockSize = 64;
+};
+
+} // namespace kde
+} // namespace mlpack
+
+// Include implementation.
+#include "kde_impl.hpp"
+
+#endif
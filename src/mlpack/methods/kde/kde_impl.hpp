@@ -0,0 +1,470 @@
+/**
+ * @file kde_impl.hpp
+ *
+ * Implementation of the KDE class.
+ */
+#ifndef MLPACK_METHODS_KDE_KDE_IMPL_HPP
+#define MLPACK_METHODS_KDE_KDE_IMPL_HPP
+
+// Just in case it hasn't been included.
+#include "kde.hpp"
+
+namespace mlpack {
+namespace kde {
+
+//! Call the tree constructor that does mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    const typename TreeType::Mat& dataset,
+    std::vector<size_t>& oldFromNew,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset, oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    const typename TreeType::Mat& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset);
+}
+
+//! Call the tree constructor that does mapping, taking ownership of the data.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat&& dataset,
+    std::vector<size_t>& oldFromNew,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(std::move(dataset), oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping, taking ownership of the
+//! data.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat&& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(std::move(dataset));
+}
+
+HAS_MEM_FUNC(Normalizer, HasNormalizerCheck);
+
+//! Return the normalizer of a kernel that has one, for the given dimension.
+template<typename KernelType>
+double KernelNormalizer(
+    KernelType& kernel,
+    const size_t dimension,
+    const typename boost::enable_if_c<
+        HasNormalizerCheck<KernelType, double(KernelType::*)(size_t)>::value ||
+        HasNormalizerCheck<KernelType,
+            double(KernelType::*)(size_t) const>::value>::type* = 0)
+{
+  return kernel.Normalizer(dimension);
+}
+
+//! Return 1 for a kernel that has no normalizer.
+template<typename KernelType>
+double KernelNormalizer(
+    KernelType& /* kernel */,
+    const size_t /* dimension */,
+    const typename boost::disable_if_c<
+        HasNormalizerCheck<KernelType, double(KernelType::*)(size_t)>::value ||
+        HasNormalizerCheck<KernelType,
+            double(KernelType::*)(size_t) const>::value>::type* = 0)
+{
+  return 1.0;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+KDE<KernelType, MetricType, MatType, TreeType>::KDE(const double relError,
+    const double absError,
+    const KernelType& kernel,
+    const MetricType& metric,
+    const bool naive,
+    const bool singleMode) :
+    referenceTree(NULL),
+    referenceSet(NULL),
+    treeOwner(false),
+    setOwner(false),
+    relError(0.0),
+    absError(0.0),
+    kernel(kernel),
+    metric(metric),
+    naive(naive),
+    singleMode(!naive && singleMode), // Naive overrides single mode.
+    baseCases(0),
+    scores(0)
+{
+  RelativeError(relError);
+  AbsoluteError(absError);
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+KDE<KernelType, MetricType, MatType, TreeType>::~KDE()
+{
+  Clear();
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Train(
+    const MatType& referenceSetIn)
+{
+  Clear();
+
+  if (naive)
+  {
+    referenceSet = &referenceSetIn;
+    return;
+  }
+
+  Timer::Start("kde/tree_building");
+  referenceTree = BuildTree<Tree>(referenceSetIn, oldFromNewReferences);
+  Timer::Stop("kde/tree_building");
+  referenceSet = &referenceTree->Dataset();
+  treeOwner = true;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Train(
+    MatType&& referenceSetIn)
+{
+  Clear();
+
+  if (naive)
+  {
+    referenceSet = new MatType(std::move(referenceSetIn));
+    setOwner = true;
+    return;
+  }
+
+  Timer::Start("kde/tree_building");
+  referenceTree = BuildTree<Tree>(std::move(referenceSetIn),
+      oldFromNewReferences);
+  Timer::Stop("kde/tree_building");
+  referenceSet = &referenceTree->Dataset();
+  treeOwner = true;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Evaluate(
+    const MatType& querySet,
+    arma::vec& estimations)
+{
+  if (!referenceSet)
+    throw std::invalid_argument("KDE::Evaluate(): no reference set; call "
+        "Train() first");
+
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "KDE::Evaluate(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  Timer::Start("kde/computing_estimations");
+  baseCases = 0;
+  scores = 0;
+
+  if (naive || singleMode || tree::TreeTraits<Tree>::FirstPointIsCentroid)
+  {
+    estimations.zeros(querySet.n_cols);
+    Estimate(querySet, NULL, estimations);
+  }
+  else
+  {
+    // Build the query tree.
+    Timer::Stop("kde/computing_estimations");
+    Timer::Start("kde/tree_building");
+    std::vector<size_t> oldFromNewQueries;
+    Tree* queryTree = BuildTree<Tree>(querySet, oldFromNewQueries);
+    Timer::Stop("kde/tree_building");
+    Timer::Start("kde/computing_estimations");
+
+    arma::vec densities(querySet.n_cols, arma::fill::zeros);
+    Estimate(queryTree->Dataset(), queryTree, densities);
+    delete queryTree;
+
+    // Map the estimates back to the original query points, if necessary.
+    if (tree::TreeTraits<Tree>::RearrangesDataset)
+    {
+      estimations.set_size(querySet.n_cols);
+      for (size_t i = 0; i < densities.n_elem; ++i)
+        estimations[oldFromNewQueries[i]] = densities[i];
+    }
+    else
+    {
+      estimations = std::move(densities);
+    }
+  }
+
+  estimations /= referenceSet->n_cols * Normalizer();
+  Timer::Stop("kde/computing_estimations");
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Evaluate(
+    arma::vec& estimations)
+{
+  if (!referenceSet)
+    throw std::invalid_argument("KDE::Evaluate(): no reference set; call "
+        "Train() first");
+
+  if (naive)
+  {
+    Evaluate(*referenceSet, estimations);
+    return;
+  }
+
+  Timer::Start("kde/computing_estimations");
+  baseCases = 0;
+  scores = 0;
+
+  // The reference tree is also the query tree.
+  arma::vec densities(referenceSet->n_cols, arma::fill::zeros);
+  const bool dualTree = !singleMode &&
+      !tree::TreeTraits<Tree>::FirstPointIsCentroid;
+  Estimate(*referenceSet, dualTree ? referenceTree : NULL, densities);
+
+  // Map the estimates back to the original reference points, if necessary.
+  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    estimations.set_size(densities.n_elem);
+    for (size_t i = 0; i < densities.n_elem; ++i)
+      estimations[oldFromNewReferences[i]] = densities[i];
+  }
+  else
+  {
+    estimations = std::move(densities);
+  }
+
+  estimations /= referenceSet->n_cols * Normalizer();
+  Timer::Stop("kde/computing_estimations");
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::RelativeError(
+    const double newError)
+{
+  if (newError < 0.0)
+    throw std::invalid_argument("KDE::RelativeError(): the relative error "
+        "tolerance must not be negative");
+  relError = newError;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::AbsoluteError(
+    const double newError)
+{
+  if (newError < 0.0)
+    throw std::invalid_argument("KDE::AbsoluteError(): the absolute error "
+        "tolerance must not be negative");
+  absError = newError;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename Archive>
+void KDE<KernelType, MetricType, MatType, TreeType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(relError, "relError");
+  ar & CreateNVP(absError, "absError");
+  ar & CreateNVP(kernel, "kernel");
+  ar & CreateNVP(naive, "naive");
+  ar & CreateNVP(singleMode, "singleMode");
+
+  // Free the current model and reset the counts if we are loading.
+  if (Archive::is_loading::value)
+  {
+    Clear();
+    baseCases = 0;
+    scores = 0;
+  }
+
+  // In naive mode we serialize the dataset; otherwise we serialize the tree.
+  if (naive)
+  {
+    ar & CreateNVP(referenceSet, "referenceSet");
+    ar & CreateNVP(metric, "metric");
+
+    // After we load the dataset, we will own it.
+    if (Archive::is_loading::value)
+      setOwner = (referenceSet != NULL);
+  }
+  else
+  {
+    ar & CreateNVP(referenceTree, "referenceTree");
+    ar & CreateNVP(oldFromNewReferences, "oldFromNewReferences");
+
+    // After we load the tree, we will own it.
+    if (Archive::is_loading::value && referenceTree)
+    {
+      treeOwner = true;
+      referenceSet = &referenceTree->Dataset();
+      metric = referenceTree->Metric(); // Get the metric from the tree.
+    }
+  }
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Clear()
+{
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+  if (setOwner && referenceSet)
+    delete referenceSet;
+
+  referenceTree = NULL;
+  referenceSet = NULL;
+  oldFromNewReferences.clear();
+  treeOwner = false;
+  setOwner = false;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Estimate(
+    const MatType& querySet,
+    Tree* queryTree,
+    arma::vec& densities)
+{
+  typedef KDERules<MetricType, KernelType, Tree> RuleType;
+
+  // The absolute error tolerance is given for the normalized estimates.
+  RuleType rules(*referenceSet, querySet, densities, relError,
+      absError * Normalizer(), metric, kernel);
+
+  if (queryTree)
+  {
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+    return;
+  }
+
+  // Each block of query points is estimated with its own copy of the rules,
+  // which writes only to the densities of its own query points.
+  const size_t blocks = (querySet.n_cols + QueryBlockSize - 1) /
+      QueryBlockSize;
+  std::vector<size_t> blockBaseCases(blocks), blockScores(blocks);
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    RuleType blockRules(rules);
+
+    const size_t begin = b * QueryBlockSize;
+    const size_t end = std::min((size_t) querySet.n_cols,
+        begin + QueryBlockSize);
+    if (naive)
+    {
+      for (size_t i = begin; i < end; ++i)
+        for (size_t j = 0; j < referenceSet->n_cols; ++j)
+          blockRules.BaseCase(i, j);
+    }
+    else
+    {
+      typename Tree::template SingleTreeTraverser<RuleType> traverser(
+          blockRules);
+      for (size_t i = begin; i < end; ++i)
+        traverser.Traverse(i, *referenceTree);
+    }
+
+    blockBaseCases[b] = blockRules.BaseCases();
+    blockScores[b] = blockRules.Scores();
+  });
+
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    baseCases += blockBaseCases[b];
+    scores += blockScores[b];
+  }
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+double KDE<KernelType, MetricType, MatType, TreeType>::Normalizer()
+{
+  return KernelNormalizer(kernel, referenceSet->n_rows);
+}
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * @file kde_main.cpp
+ *
+ * Executable for kernel density estimation with trees.
+ */
+#include <mlpack/core.hpp>
+
+#include "kde_model.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::kde;
+
+PROGRAM_INFO("Kernel Density Estimation",
+    "This program performs kernel density estimation: given a set of reference "
+    "points, it estimates the density at each query point as the average of "
+    "the kernel values between the query point and the reference points, "
+    "divided by the integral of the kernel (for the Gaussian, Epanechnikov and "
+    "spherical kernels; the estimates of the Laplacian and triangular kernels "
+    "are not normalized).  The kernel is chosen with --kernel (-k) and its "
+    "bandwidth with --bandwidth (-b)."
+    "\n\n"
+    "The estimates are computed with trees (a dual-tree algorithm, or a "
+    "single-tree algorithm with --single_mode), which approximate the kernel "
+    "values of groups of reference points that are far enough from the query "
+    "points.  Each estimate is within --rel_error (-e) times the exact "
+    "estimate plus --abs_error (-E) of the exact estimate; with both set to 0, "
+    "the exact estimates are computed.  --naive (-N) computes them by brute "
+    "force."
+    "\n\n"
+    "For example, the following will estimate the density at each point of "
+    "'query.csv' of the points of 'reference.csv' with a Gaussian kernel of "
+    "bandwidth 0.5, and store the estimates in 'estimates.csv':"
+    "\n\n"
+    "$ mlpack_kde -r reference.csv -q query.csv -k gaussian -b 0.5 "
+    "-o estimates.csv"
+    "\n\n"
+    "If no query file is given, the density is estimated at each reference "
+    "point.  The model can be saved with --output_model_file (-M) and used "
+    "again with --input_model_file (-m).");
+
+PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
+    "");
+PARAM_STRING("query_file", "File containing the query points (optional).",
+    "q", "");
+PARAM_STRING("output_file", "File to save the density estimates to.", "o", "");
+
+PARAM_STRING("input_model_file", "File containing a pre-trained KDE model.",
+    "m", "");
+PARAM_STRING("output_model_file", "If specified, the KDE model will be saved "
+    "to the given file.", "M", "");
+
+PARAM_STRING("kernel", "Kernel to use: 'gaussian', 'epanechnikov', "
+    "'laplacian', 'spherical', 'triangular'.", "k", "gaussian");
+PARAM_DOUBLE("bandwidth", "Bandwidth of the kernel.", "b", 1.0);
+PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'ball', 'cover', 'r'.",
+    "t", "kd");
+PARAM_DOUBLE("rel_error", "Relative error tolerance of each estimate.", "e",
+    0.05);
+PARAM_DOUBLE("abs_error", "Absolute error tolerance of each estimate.", "E",
+    0.0);
+
+PARAM_FLAG("naive", "If true, the estimates are computed by brute force.",
+    "N");
+PARAM_FLAG("single_mode", "If true, single-tree estimation is used (as opposed "
+    "to dual-tree estimation).", "S");
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  // A user cannot specify both reference data and a model.
+  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
+    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
+        << " may be specified!" << endl;
+
+  // A user must specify one of them...
+  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
+    Log::Fatal << "No model specified (--input_model_file) and no reference "
+        << "data specified (--reference_file)!  One must be provided." << endl;
+
+  if (!CLI::HasParam("output_file") && !CLI::HasParam("output_model_file"))
+    Log::Warn << "Neither --output_file nor --output_model_file are specified; "
+        << "no results will be saved!" << endl;
+
+  KDEModel kde;
+  if (CLI::HasParam("reference_file"))
+  {
+    const double bandwidth = CLI::GetParam<double>("bandwidth");
+    const double relError = CLI::GetParam<double>("rel_error");
+    const double absError = CLI::GetParam<double>("abs_error");
+    if (bandwidth <= 0.0)
+      Log::Fatal << "Invalid --bandwidth " << bandwidth << "; it must be "
+          << "positive." << endl;
+    if (relError < 0.0 || absError < 0.0)
+      Log::Fatal << "--rel_error and --abs_error must not be negative." << endl;
+
+    const string kernelType = CLI::GetParam<string>("kernel");
+    if (kernelType == "gaussian")
+      kde.KernelType() = KDEModel::GAUSSIAN_KERNEL;
+    else if (kernelType == "epanechnikov")
+      kde.KernelType() = KDEModel::EPANECHNIKOV_KERNEL;
+    else if (kernelType == "laplacian")
+      kde.KernelType() = KDEModel::LAPLACIAN_KERNEL;
+    else if (kernelType == "spherical")
+      kde.KernelType() = KDEModel::SPHERICAL_KERNEL;
+    else if (kernelType == "triangular")
+      kde.KernelType() = KDEModel::TRIANGULAR_KERNEL;
+    else
+      Log::Fatal << "Unknown kernel '" << kernelType << "'; valid choices are "
+          << "'gaussian', 'epanechnikov', 'laplacian', 'spherical' and "
+          << "'triangular'." << endl;
+
+    const string treeType = CLI::GetParam<string>("tree_type");
+    if (treeType == "kd")
+      kde.TreeType() = KDEModel::KD_TREE;
+    else if (treeType == "ball")
+      kde.TreeType() = KDEModel::BALL_TREE;
+    else if (treeType == "cover")
+      kde.TreeType() = KDEModel::COVER_TREE;
+    else if (treeType == "r")
+      kde.TreeType() = KDEModel::R_TREE;
+    else
+      Log::Fatal << "Unknown tree type '" << treeType << "'; valid choices are "
+          << "'kd', 'ball', 'cover' and 'r'." << endl;
+
+    kde.Bandwidth() = bandwidth;
+    kde.RelativeError() = relError;
+    kde.AbsoluteError() = absError;
+
+    const bool naive = CLI::HasParam("naive");
+    const bool singleMode = CLI::HasParam("single_mode");
+    if (naive && singleMode)
+      Log::Warn << "--single_mode ignored because --naive is present." << endl;
+
+    const string referenceFile = CLI::GetParam<string>("reference_file");
+    arma::mat referenceSet;
+    data::Load(referenceFile, referenceSet, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceSet.n_rows << "x" << referenceSet.n_cols << ")." << endl;
+
+    kde.BuildModel(std::move(referenceSet), naive, singleMode);
+  }
+  else
+  {
+    // Notify the user of parameters that will be ignored.
+    const char* modelParams[] = { "kernel", "bandwidth", "tree_type",
+        "rel_error", "abs_error", "naive", "single_mode" };
+    for (const char* param : modelParams)
+    {
+      if (CLI::HasParam(param))
+        Log::Warn << "--" << param << " will be ignored because "
+            << "--input_model_file is specified." << endl;
+    }
+
+    const string inputModelFile = CLI::GetParam<string>("input_model_file");
+    data::Load(inputModelFile, "kde_model", kde, true); // Fatal on failure.
+
+    Log::Info << "Loaded KDE model with the " << kde.KernelName() << " and "
+        << "the " << kde.TreeName() << " from '" << inputModelFile << "'."
+        << endl;
+  }
+
+  if (CLI::HasParam("output_file"))
+  {
+    arma::vec estimations;
+    if (CLI::HasParam("query_file"))
+    {
+      const string queryFile = CLI::GetParam<string>("query_file");
+      arma::mat querySet;
+      data::Load(queryFile, querySet, true);
+
+      Log::Info << "Loaded query data from '" << queryFile << "' ("
+          << querySet.n_rows << "x" << querySet.n_cols << ")." << endl;
+
+      if (querySet.n_rows != kde.Dimensionality())
+      {
+        Log::Fatal << "The query points have " << querySet.n_rows
+            << " dimensions, but the reference points have "
+            << kde.Dimensionality() << "." << endl;
+      }
+
+      kde.Evaluate(querySet, estimations);
+    }
+    else
+    {
+      kde.Evaluate(estimations);
+    }
+
+    Log::Info << "Estimation complete; " << kde.BaseCases() << " base cases "
+        << "were evaluated." << endl;
+
+    data::Save(CLI::GetParam<string>("output_file"), estimations);
+  }
+
+  if (CLI::HasParam("output_model_file"))
+  {
+    const string outputModelFile = CLI::GetParam<string>("output_model_file");
+    data::Save(outputModelFile, "kde_model", kde);
+  }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file kde_model.cpp
+ *
+ * Implementation of non-templatized functions of KDEModel.
+ */
+#include "kde_model.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kde;
+
+KDEModel::KDEModel(const double bandwidth,
+                   const double relError,
+                   const double absError,
+                   const KernelTypes kernelType,
+                   const TreeTypes treeType) :
+    bandwidth(bandwidth),
+    relError(relError),
+    absError(absError),
+    kernelType(kernelType),
+    treeType(treeType)
+{
+  // Nothing to do.
+}
+
+KDEModel::~KDEModel()
+{
+  boost::apply_visitor(DeleteVisitor(), kde);
+}
+
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class KDETreeType>
+void KDEModel::InitializeKDE(const bool naive, const bool singleMode)
+{
+  switch (kernelType)
+  {
+    case GAUSSIAN_KERNEL:
+      kde = new KDEType<kernel::GaussianKernel, KDETreeType>(relError,
+          absError, kernel::GaussianKernel(bandwidth),
+          metric::EuclideanDistance(), naive, singleMode);
+      break;
+    case EPANECHNIKOV_KERNEL:
+      kde = new KDEType<kernel::EpanechnikovKernel, KDETreeType>(relError,
+          absError, kernel::EpanechnikovKernel(bandwidth),
+          metric::EuclideanDistance(), naive, singleMode);
+      break;
+    case LAPLACIAN_KERNEL:
+      kde = new KDEType<kernel::LaplacianKernel, KDETreeType>(relError,
+          absError, kernel::LaplacianKernel(bandwidth),
+          metric::EuclideanDistance(), naive, singleMode);
+      break;
+    case SPHERICAL_KERNEL:
+      kde = new KDEType<kernel::SphericalKernel, KDETreeType>(relError,
+          absError, kernel::SphericalKernel(bandwidth),
+          metric::EuclideanDistance(), naive, singleMode);
+      break;
+    case TRIANGULAR_KERNEL:
+      kde = new KDEType<kernel::TriangularKernel, KDETreeType>(relError,
+          absError, kernel::TriangularKernel(bandwidth),
+          metric::EuclideanDistance(), naive, singleMode);
+      break;
+  }
+}
+
+void KDEModel::BuildModel(arma::mat&& referenceSet,
+                          const bool naive,
+                          const bool singleMode)
+{
+  // Clean memory, if necessary.
+  boost::apply_visitor(DeleteVisitor(), kde);
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      InitializeKDE<tree::KDTree>(naive, singleMode);
+      break;
+    case BALL_TREE:
+      InitializeKDE<tree::BallTree>(naive, singleMode);
+      break;
+    case COVER_TREE:
+      InitializeKDE<tree::StandardCoverTree>(naive, singleMode);
+      break;
+    case R_TREE:
+      InitializeKDE<tree::RTree>(naive, singleMode);
+      break;
+  }
+
+  if (!naive)
+    Log::Info << "Building reference tree..." << std::endl;
+
+  TrainVisitor train(std::move(referenceSet));
+  boost::apply_visitor(train, kde);
+
+  if (!naive)
+    Log::Info << "Tree built." << std::endl;
+}
+
+void KDEModel::Evaluate(const arma::mat& querySet, arma::vec& estimations)
+{
+  EvaluateVisitor evaluate(querySet, estimations);
+  boost::apply_visitor(evaluate, kde);
+}
+
+void KDEModel::Evaluate(arma::vec& estimations)
+{
+  MonoEvaluateVisitor evaluate(estimations);
+  boost::apply_visitor(evaluate, kde);
+}
+
+size_t KDEModel::BaseCases() const
+{
+  return boost::apply_visitor(BaseCasesVisitor(), kde);
+}
+
+size_t KDEModel::Dimensionality() const
+{
+  return boost::apply_visitor(DimensionalityVisitor(), kde);
+}
+
+std::string KDEModel::KernelName() const
+{
+  switch (kernelType)
+  {
+    case GAUSSIAN_KERNEL:
+      return "Gaussian kernel";
+    case EPANECHNIKOV_KERNEL:
+      return "Epanechnikov kernel";
+    case LAPLACIAN_KERNEL:
+      return "Laplacian kernel";
+    case SPHERICAL_KERNEL:
+      return "spherical kernel";
+    case TRIANGULAR_KERNEL:
+      return "triangular kernel";
+    default:
+      return "unknown kernel";
+  }
+}
+
+std::string KDEModel::TreeName() const
+{
+  switch (treeType)
+  {
+    case KD_TREE:
+      return "kd-tree";
+    case BALL_TREE:
+      return "ball tree";
+    case COVER_TREE:
+      return "cover tree";
+    case R_TREE:
+      return "R tree";
+    default:
+      return "unknown tree";
+  }
+}
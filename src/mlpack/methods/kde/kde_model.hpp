@@ -0,0 +1,262 @@
+/**
+ * @file kde_model.hpp
+ *
+ * This is a model for kernel density estimation.  It provides an easy way to
+ * serialize a model, abstracts away the different types of kernels and trees,
+ * and reflects the KDE API.
+ */
+#ifndef MLPACK_METHODS_KDE_KDE_MODEL_HPP
+#define MLPACK_METHODS_KDE_KDE_MODEL_HPP
+
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/laplacian_kernel.hpp>
+#include <mlpack/core/kernels/spherical_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+#include <boost/variant.hpp>
+#include "kde.hpp"
+
+namespace mlpack {
+namespace kde {
+
+//! Alias template for Euclidean kernel density estimation.
+template<typename KernelType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+using KDEType = KDE<KernelType, metric::EuclideanDistance, arma::mat, TreeType>;
+
+/**
+ * TrainVisitor sets the reference set of the given KDEType.
+ */
+class TrainVisitor : public boost::static_visitor<void>
+{
+ private:
+  arma::mat&& referenceSet;
+
+ public:
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+
+  TrainVisitor(arma::mat&& referenceSet) :
+      referenceSet(std::move(referenceSet))
+  {};
+};
+
+/**
+ * EvaluateVisitor estimates the density of the points of a query set with the
+ * given KDEType.
+ */
+class EvaluateVisitor : public boost::static_visitor<void>
+{
+ private:
+  const arma::mat& querySet;
+  arma::vec& estimations;
+
+ public:
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+
+  EvaluateVisitor(const arma::mat& querySet, arma::vec& estimations) :
+      querySet(querySet),
+      estimations(estimations)
+  {};
+};
+
+/**
+ * MonoEvaluateVisitor estimates the density of the points of the reference set
+ * with the given KDEType.
+ */
+class MonoEvaluateVisitor : public boost::static_visitor<void>
+{
+ private:
+  arma::vec& estimations;
+
+ public:
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+
+  MonoEvaluateVisitor(arma::vec& estimations) : estimations(estimations) {};
+};
+
+/**
+ * BaseCasesVisitor exposes the number of base cases evaluated by the last
+ * estimation of the given KDEType.
+ */
+class BaseCasesVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  template<typename KDEType>
+  size_t operator()(KDEType* kde) const;
+};
+
+/**
+ * DimensionalityVisitor exposes the dimensionality of the reference set of the
+ * given KDEType.
+ */
+class DimensionalityVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  template<typename KDEType>
+  size_t operator()(KDEType* kde) const;
+};
+
+/**
+ * DeleteVisitor deletes the given KDEType instance.
+ */
+class DeleteVisitor : public boost::static_visitor<void>
+{
+ public:
+  template<typename KDEType>
+  void operator()(KDEType* kde) const;
+};
+
+/**
+ * The KDEModel class provides an easy way to serialize a kernel density
+ * estimation model, abstracts away the different types of kernels and trees,
+ * and reflects the KDE API.  It is used by the mlpack_kde program.
+ */
+class KDEModel
+{
+ public:
+  //! Enum type to identify each accepted kernel.
+  enum KernelTypes
+  {
+    GAUSSIAN_KERNEL,
+    EPANECHNIKOV_KERNEL,
+    LAPLACIAN_KERNEL,
+    SPHERICAL_KERNEL,
+    TRIANGULAR_KERNEL
+  };
+
+  //! Enum type to identify each accepted tree type.
+  enum TreeTypes
+  {
+    KD_TREE,
+    BALL_TREE,
+    COVER_TREE,
+    R_TREE
+  };
+
+ private:
+  //! Bandwidth of the kernel.
+  double bandwidth;
+  //! Relative error tolerance.
+  double relError;
+  //! Absolute error tolerance.
+  double absError;
+  //! Kernel type.
+  KernelTypes kernelType;
+  //! Tree type.
+  TreeTypes treeType;
+
+  /**
+   * kde holds an instance of the KDE class for the current kernel and tree
+   * type.  It is initialized every time BuildModel() is executed.  We access
+   * the contained value through the visitor classes defined above.
+   */
+  boost::variant<KDEType<kernel::GaussianKernel, tree::KDTree>*,
+                 KDEType<kernel::GaussianKernel, tree::BallTree>*,
+                 KDEType<kernel::GaussianKernel, tree::StandardCoverTree>*,
+                 KDEType<kernel::GaussianKernel, tree::RTree>*,
+                 KDEType<kernel::EpanechnikovKernel, tree::KDTree>*,
+                 KDEType<kernel::EpanechnikovKernel, tree::BallTree>*,
+                 KDEType<kernel::EpanechnikovKernel, tree::StandardCoverTree>*,
+                 KDEType<kernel::EpanechnikovKernel, tree::RTree>*,
+                 KDEType<kernel::LaplacianKernel, tree::KDTree>*,
+                 KDEType<kernel::LaplacianKernel, tree::BallTree>*,
+                 KDEType<kernel::LaplacianKernel, tree::StandardCoverTree>*,
+                 KDEType<kernel::LaplacianKernel, tree::RTree>*,
+                 KDEType<kernel::SphericalKernel, tree::KDTree>*,
+                 KDEType<kernel::SphericalKernel, tree::BallTree>*,
+                 KDEType<kernel::SphericalKernel, tree::StandardCoverTree>*,
+                 KDEType<kernel::SphericalKernel, tree::RTree>*,
+                 KDEType<kernel::TriangularKernel, tree::KDTree>*,
+                 KDEType<kernel::TriangularKernel, tree::BallTree>*,
+                 KDEType<kernel::TriangularKernel, tree::StandardCoverTree>*,
+                 KDEType<kernel::TriangularKernel, tree::RTree>*> kde;
+
+ public:
+  /**
+   * Initialize the KDEModel with the given parameters.  The model is trained
+   * by BuildModel().
+   */
+  KDEModel(const double bandwidth = 1.0,
+           const double relError = 0.05,
+           const double absError = 0.0,
+           const KernelTypes kernelType = GAUSSIAN_KERNEL,
+           const TreeTypes treeType = KD_TREE);
+
+  //! Clean memory, if necessary.
+  ~KDEModel();
+
+  //! Serialize the KDE model.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
+  //! Get the bandwidth of the kernel.
+  double Bandwidth() const { return bandwidth; }
+  //! Modify the bandwidth of the kernel (used by the next BuildModel()).
+  double& Bandwidth() { return bandwidth; }
+
+  //! Get the relative error tolerance.
+  double RelativeError() const { return relError; }
+  //! Modify the relative error tolerance (used by the next BuildModel()).
+  double& RelativeError() { return relError; }
+
+  //! Get the absolute error tolerance.
+  double AbsoluteError() const { return absError; }
+  //! Modify the absolute error tolerance (used by the next BuildModel()).
+  double& AbsoluteError() { return absError; }
+
+  //! Get the kernel type.
+  KernelTypes KernelType() const { return kernelType; }
+  //! Modify the kernel type (used by the next BuildModel()).
+  KernelTypes& KernelType() { return kernelType; }
+
+  //! Get the tree type.
+  TreeTypes TreeType() const { return treeType; }
+  //! Modify the tree type (used by the next BuildModel()).
+  TreeTypes& TreeType() { return treeType; }
+
+  //! Build the model on the given reference set.
+  void BuildModel(arma::mat&& referenceSet,
+                  const bool naive,
+                  const bool singleMode);
+
+  //! Estimate the density at each point of the query set.
+  void Evaluate(const arma::mat& querySet, arma::vec& estimations);
+
+  //! Estimate the density at each point of the reference set.
+  void Evaluate(arma::vec& estimations);
+
+  //! Get the number of base cases evaluated by the last estimation.
+  size_t BaseCases() const;
+
+  //! Get the dimensionality of the reference set.
+  size_t Dimensionality() const;
+
+  //! Return a string representation of the current kernel.
+  std::string KernelName() const;
+
+  //! Return a string representation of the current tree type.
+  std::string TreeName() const;
+
+ private:
+  //! Create an untrained KDE object of the current kernel and tree type.
+  template<template<typename TreeMetricType,
+                    typename TreeStatType,
+                    typename TreeMatType> class KDETreeType>
+  void InitializeKDE(const bool naive, const bool singleMode);
+};
+
+} // namespace kde
+} // namespace mlpack
+
+// Include implementation.
+#include "kde_model_impl.hpp"
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file kde_model_impl.hpp
+ *
+ * Implementation of the templated functions of the KDEModel class and of its
+ * visitors.
+ */
+#ifndef MLPACK_METHODS_KDE_KDE_MODEL_IMPL_HPP
+#define MLPACK_METHODS_KDE_KDE_MODEL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kde_model.hpp"
+
+#include <boost/serialization/variant.hpp>
+
+namespace mlpack {
+namespace kde {
+
+//! Train the given KDEType instance.
+template<typename KDEType>
+void TrainVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->Train(std::move(referenceSet));
+  throw std::runtime_error("no KDE model initialized");
+}
+
+//! Estimate the densities of the query points with the given KDEType instance.
+template<typename KDEType>
+void EvaluateVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->Evaluate(querySet, estimations);
+  throw std::runtime_error("no KDE model initialized");
+}
+
+//! Estimate the densities of the reference points with the given KDEType
+//! instance.
+template<typename KDEType>
+void MonoEvaluateVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->Evaluate(estimations);
+  throw std::runtime_error("no KDE model initialized");
+}
+
+//! Return the number of base cases of the given KDEType instance.
+template<typename KDEType>
+size_t BaseCasesVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->BaseCases();
+  throw std::runtime_error("no KDE model initialized");
+}
+
+//! Return the dimensionality of the reference set of the given KDEType.
+template<typename KDEType>
+size_t DimensionalityVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    return kde->ReferenceSet().n_rows;
+  throw std::runtime_error("no KDE model initialized");
+}
+
+//! Delete the given KDEType instance.
+template<typename KDEType>
+void DeleteVisitor::operator()(KDEType* kde) const
+{
+  if (kde)
+    delete kde;
+}
+
+//! Serialize the KDE model.
+template<typename Archive>
+void KDEModel::Serialize(Archive& ar, const unsigned int /* version */)
+{
+  ar & data::CreateNVP(bandwidth, "bandwidth");
+  ar & data::CreateNVP(relError, "relError");
+  ar & data::CreateNVP(absError, "absError");
+  ar & data::CreateNVP(kernelType, "kernelType");
+  ar & data::CreateNVP(treeType, "treeType");
+
+  // This should never happen, but just in case, be clean with memory.
+  if (Archive::is_loading::value)
+    boost::apply_visitor(DeleteVisitor(), kde);
+
+  ar & data::CreateNVP(kde, "kde_model");
+}
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
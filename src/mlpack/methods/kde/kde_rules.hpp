@@ -0,0 +1,189 @@
+/**
+ * @file kde_rules.hpp
+ *
+ * Rules for kernel density estimation, so that it can be done with arbitrary
+ * tree types.
+ */
+#ifndef MLPACK_METHODS_KDE_KDE_RULES_HPP
+#define MLPACK_METHODS_KDE_KDE_RULES_HPP
+
+#include <mlpack/core/tree/traversal_info.hpp>
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * The rules for kernel density estimation.  For each query point, the kernel
+ * values of all the reference points are summed into a vector of (unnormalized)
+ * densities.  A reference node is pruned when the kernel values of its points
+ * are known well enough from the bounds on their distance to the query point
+ * (or to the points of the query node): if the kernel values are all between
+ * minK and maxK, and
+ *
+ *   (maxK - minK) / 2 <= relError * minK + absError,
+ *
+ * the node contributes (maxK + minK) / 2 for each of its points, which differs
+ * from each true kernel value by at most relError times that value plus
+ * absError.  So each density is within relError of the exact density plus
+ * absError times the number of reference points.
+ *
+ * The kernel must be a decreasing function of the distance, with an
+ * Evaluate(double distance) function (such as the GaussianKernel or the
+ * EpanechnikovKernel).
+ *
+ * The dual-tree Score() assumes that the points of a node are base cases of
+ * none of its ancestors, so it can't be used with trees whose first point is
+ * the centroid (such as the cover tree); the KDE class uses single-tree
+ * traversals with those trees.
+ *
+ * @tparam MetricType Metric to compute distances with.
+ * @tparam KernelType Kernel to evaluate.
+ * @tparam TreeType Type of tree to use.
+ */
+template<typename MetricType, typename KernelType, typename TreeType>
+class KDERules
+{
+ public:
+  /**
+   * Construct the KDERules object.  This is usually done from within the KDE
+   * class at estimation time.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param densities Vector to add the kernel values of each query point to.
+   * @param relError Relative error tolerance of each kernel value.
+   * @param absError Absolute error tolerance of each kernel value.
+   * @param metric Instantiated metric.
+   * @param kernel Instantiated kernel.
+   */
+  KDERules(const typename TreeType::Mat& referenceSet,
+           const typename TreeType::Mat& querySet,
+           arma::vec& densities,
+           const double relError,
+           const double absError,
+           MetricType& metric,
+           const KernelType& kernel);
+
+  /**
+   * Compute the base case between the given query point and reference point,
+   * and add its kernel value to the density of the query point.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of reference point.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for recursion order.  A low score indicates priority for
+   * recursion, while DBL_MAX indicates that the node should not be recursed
+   * into at all (it should be pruned).  If the node is pruned, the
+   * approximate kernel values of its points are added to the density of the
+   * query point.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  Nothing is pruned later than
+   * it is scored, so this returns the old score.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  /**
+   * Get the score for recursion order.  A low score indicates priority for
+   * recursion, while DBL_MAX indicates that the node should not be recursed
+   * into at all (it should be pruned).  If the nodes are pruned, the
+   * approximate kernel values of the reference points are added to the
+   * density of each point of the query node.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  Nothing is pruned later than
+   * it is scored, so this returns the old score.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  typedef typename tree::TraversalInfo<TreeType> TraversalInfoType;
+
+  const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
+  TraversalInfoType& TraversalInfo() { return traversalInfo; }
+
+  //! Get the number of base cases.
+  size_t BaseCases() const { return baseCases; }
+  //! Modify the number of base cases.
+  size_t& BaseCases() { return baseCases; }
+  //! Get the number of scores (that is, calls to RangeDistance()).
+  size_t Scores() const { return scores; }
+  //! Modify the number of scores.
+  size_t& Scores() { return scores; }
+
+ private:
+  /**
+   * Return the approximate kernel value of points between the given minimum
+   * and maximum distance, or a negative number if the kernel values are not
+   * known well enough.
+   */
+  double Approximate(const double minDistance,
+                     const double maxDistance) const;
+
+  //! The reference set.
+  const typename TreeType::Mat& referenceSet;
+
+  //! The query set.
+  const typename TreeType::Mat& querySet;
+
+  //! The densities of the query points.
+  arma::vec& densities;
+
+  //! The relative error tolerance.
+  double relError;
+
+  //! The absolute error tolerance.
+  double absError;
+
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The instantiated kernel.
+  KernelType kernel;
+
+  //! The last query index.
+  size_t lastQueryIndex;
+  //! The last reference index.
+  size_t lastReferenceIndex;
+
+  //! Traversal info for the parent combination; this is updated by the
+  //! traversal before each call to Score().
+  TraversalInfoType traversalInfo;
+
+  //! The number of base cases.
+  size_t baseCases;
+  //! The number of scores.
+  size_t scores;
+};
+
+} // namespace kde
+} // namespace mlpack
+
+// Include implementation.
+#include "kde_rules_impl.hpp"
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * @file kde_rules_impl.hpp
+ *
+ * Implementation of rules for kernel density estimation with generic trees.
+ */
+#ifndef MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+#define MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde {
+
+template<typename MetricType, typename KernelType, typename TreeType>
+KDERules<MetricType, KernelType, TreeType>::KDERules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    arma::vec& densities,
+    const double relError,
+    const double absError,
+    MetricType& metric,
+    const KernelType& kernel) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    densities(densities),
+    relError(relError),
+    absError(absError),
+    metric(metric),
+    kernel(kernel),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+//! The base case.  Evaluate the kernel between the two points and add it to the
+//! density of the query point.
+template<typename MetricType, typename KernelType, typename TreeType>
+inline force_inline
+double KDERules<MetricType, KernelType, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  // If we have just performed this base case, don't do it again.
+  if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
+    return 0.0;
+
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+      referenceSet.unsafe_col(referenceIndex));
+  ++baseCases;
+
+  // Update last indices, so we don't accidentally perform a base case twice.
+  lastQueryIndex = queryIndex;
+  lastReferenceIndex = referenceIndex;
+
+  densities[queryIndex] += kernel.Evaluate(distance);
+
+  return distance;
+}
+
+//! Single-tree scoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  const math::RangeType<typename TreeType::ElemType> distances =
+      referenceNode.RangeDistance(querySet.unsafe_col(queryIndex));
+  ++scores;
+
+  const double value = Approximate(distances.Lo(), distances.Hi());
+  if (value < 0.0)
+    return distances.Lo();
+
+  // The traverser does not evaluate the base case of a pruned node, except
+  // that the point of a self-child has already been evaluated by its parent.
+  size_t count = referenceNode.NumDescendants();
+  if (tree::TreeTraits<TreeType>::HasSelfChildren &&
+      (referenceNode.Parent() != NULL) &&
+      (referenceNode.Point(0) == referenceNode.Parent()->Point(0)))
+    --count;
+
+  densities[queryIndex] += count * value;
+  return DBL_MAX;
+}
+
+//! Single-tree rescoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    const size_t /* queryIndex */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Dual-tree scoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  const math::RangeType<typename TreeType::ElemType> distances =
+      queryNode.RangeDistance(&referenceNode);
+  ++scores;
+
+  const double value = Approximate(distances.Lo(), distances.Hi());
+  if (value < 0.0)
+    return distances.Lo();
+
+  // Every reference point contributes to the density of every query point.
+  const double contribution = referenceNode.NumDescendants() * value;
+  for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+    densities[queryNode.Descendant(i)] += contribution;
+
+  return DBL_MAX;
+}
+
+//! Dual-tree rescoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    TreeType& /* queryNode */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+inline double KDERules<MetricType, KernelType, TreeType>::Approximate(
+    const double minDistance,
+    const double maxDistance) const
+{
+  // The kernel decreases with the distance.
+  const double maxKernel = kernel.Evaluate(minDistance);
+  const double minKernel = kernel.Evaluate(maxDistance);
+
+  if (maxKernel - minKernel > 2 * (relError * minKernel + absError))
+    return -1.0;
+
+  return (maxKernel + minKernel) / 2;
+}
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
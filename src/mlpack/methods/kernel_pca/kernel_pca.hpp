@@ -10,6 +10,7 @@
 #define MLPACK_METHODS_KERNEL_PCA_KERNEL_PCA_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/kernel_pca/kernel_projection.hpp>
 #include <mlpack/methods/kernel_pca/kernel_rules/naive_method.hpp>
 
 namespace mlpack {
@@ -27,6 +28,13 @@ namespace kpca {
  * There are numerous available kernels in the mlpack::kernel namespace (see
  * files in mlpack/core/kernels/) and it is easy to write your own; see other
  * implementations for examples.
+ *
+ * Each call to Apply() also keeps what is needed to project new points onto the
+ * kernel principal components it found (see KernelProjection), so a trained
+ * KernelPCA object can embed new points with Transform(), only evaluating the
+ * kernel between the new points and the points of the dataset (or, with the
+ * NystroemKernelRule, the selected points).  The trained object can be
+ * serialized.
  */
 template <
   typename KernelType,
@@ -101,6 +109,40 @@ class KernelPCA
    */
   void Apply(arma::mat& data, const size_t newDimension);
 
+  /**
+   * Apply Kernel Principal Components Analysis to the dataset of the given
+   * kernel cache, with the kernel of the cache (which becomes the kernel of
+   * this object).  The kernel values which are already cached are not computed
+   * again.
+   *
+   * @param cache Kernel cache of the data matrix.
+   * @param transformedData Matrix to output results into.
+   * @param eigval KPCA eigenvalues will be written to this vector.
+   * @param eigvec KPCA eigenvectors will be written to this matrix.
+   * @param newDimension New dimension for the dataset (0 to keep every
+   *     dimension).
+   */
+  void Apply(kernel::KernelCache<KernelType>& cache,
+             arma::mat& transformedData,
+             arma::vec& eigval,
+             arma::mat& eigvec,
+             const size_t newDimension);
+
+  /**
+   * Project new points onto the kernel principal components found by the last
+   * call to Apply(), keeping as many dimensions as it did.  The kernel values
+   * of the new points are centered like the kernel matrix of the dataset, so
+   * that the points of the dataset are projected onto the same coordinates as
+   * returned by Apply().  Blocks of points are projected in parallel.
+   *
+   * @param points Points to project (one per column).
+   * @param transformedPoints Matrix to output the projected points into.
+   */
+  void Transform(const arma::mat& points, arma::mat& transformedPoints);
+
+  //! Get the projection of new points found by the last call to Apply().
+  const KernelProjection& Projection() const { return projection; }
+
   //! Get the kernel.
   const KernelType& Kernel() const { return kernel; }
   //! Modify the kernel.
@@ -111,6 +153,10 @@ class KernelPCA
   //! Return whether or not the transformed data is centered.
   bool& CenterTransformedData() { return centerTransformedData; }
 
+  //! Serialize the KernelPCA object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
  private:
   //! The instantiated kernel.
   KernelType kernel;
@@ -118,6 +164,15 @@ class KernelPCA
   //! run.
   bool centerTransformedData;
 
+  //! The projection of new points found by the last call to Apply().
+  KernelProjection projection;
+  //! The mean of the transformed data, if it is centered.
+  arma::vec transformedMean;
+
+  //! Keep the given number of dimensions of the projection (every dimension if
+  //! 0), and the mean of the transformed data if it is centered.
+  void FinishProjection(const arma::mat& transformedData,
+                        const size_t newDimension);
 }; // class KernelPCA
 
 } // namespace kpca
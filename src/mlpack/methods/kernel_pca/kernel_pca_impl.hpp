@@ -31,7 +31,9 @@ void KernelPCA<KernelType, KernelRule>::Apply(const arma::mat& data,
                                   const size_t newDimension)
 {
   KernelRule::ApplyKernelMatrix(data, transformedData, eigval,
-                                eigvec, newDimension, kernel);
+                                eigvec, newDimension, kernel, &projection);
+
+  FinishProjection(transformedData, newDimension);
 
   // Center the transformed data, if the user asked for it.
   if (centerTransformedData)
@@ -76,6 +78,84 @@ void KernelPCA<KernelType, KernelRule>::Apply(arma::mat& data,
     data.shed_rows(newDimension, data.n_rows - 1);
 }
 
+//! Apply Kernel Principal Component Analysis to the dataset of a kernel cache.
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Apply(
+    kernel::KernelCache<KernelType>& cache,
+    arma::mat& transformedData,
+    arma::vec& eigval,
+    arma::mat& eigvec,
+    const size_t newDimension)
+{
+  kernel = cache.Kernel();
+  KernelRule::ApplyKernelMatrix(cache, transformedData, eigval, eigvec,
+                                newDimension, &projection);
+
+  FinishProjection(transformedData, newDimension);
+  const size_t dimension = projection.Dimensionality();
+
+  // Center the transformed data, if the user asked for it.
+  if (centerTransformedData)
+  {
+    arma::colvec transformedDataMean = arma::mean(transformedData, 1);
+    transformedData = transformedData - (transformedDataMean *
+        arma::ones<arma::rowvec>(transformedData.n_cols));
+  }
+
+  if (dimension < transformedData.n_rows)
+    transformedData.shed_rows(dimension, transformedData.n_rows - 1);
+}
+
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::FinishProjection(
+    const arma::mat& transformedData,
+    const size_t newDimension)
+{
+  if (newDimension > 0)
+    projection.Truncate(newDimension);
+
+  if (centerTransformedData)
+  {
+    transformedMean = arma::mean(transformedData, 1);
+    if (projection.Dimensionality() < transformedMean.n_elem)
+      transformedMean.shed_rows(projection.Dimensionality(),
+          transformedMean.n_elem - 1);
+  }
+  else
+  {
+    transformedMean.reset();
+  }
+}
+
+//! Project new points onto the kernel principal components.
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Transform(const arma::mat& points,
+                                                  arma::mat& transformedPoints)
+{
+  if (projection.Dimensionality() == 0)
+  {
+    Log::Fatal << "KernelPCA::Transform(): Apply() must be called first!"
+        << std::endl;
+  }
+
+  projection.Transform(kernel, points, transformedPoints);
+
+  if (centerTransformedData)
+    transformedPoints.each_col() -= transformedMean;
+}
+
+template <typename KernelType, typename KernelRule>
+template<typename Archive>
+void KernelPCA<KernelType, KernelRule>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  ar & data::CreateNVP(kernel, "kernel");
+  ar & data::CreateNVP(centerTransformedData, "centerTransformedData");
+  ar & data::CreateNVP(projection, "projection");
+  ar & data::CreateNVP(transformedMean, "transformedMean");
+}
+
 } // namespace mlpack
 } // namespace kpca
 
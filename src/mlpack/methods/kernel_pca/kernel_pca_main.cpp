@@ -70,7 +70,10 @@ PROGRAM_INFO("Kernel Principal Components Analysis",
     " a subset of the data as basis to reconstruct the kernel matrix; to specify"
     " the sampling scheme, the --sampling parameter is used, the sampling scheme"
     " for the nystr\u00F6m method can be chosen from the following list: kmeans,"
-    " random, ordered.");
+    " random, ordered, hamerly, minibatch.  The 'hamerly' (Hamerly's k-means "
+    "with k-means++ initialization) and 'minibatch' (mini-batch k-means) "
+    "schemes select the same kind of points as 'kmeans', but much faster on "
+    "large datasets.");
 
 PARAM_STRING_REQ("input_file", "Input dataset to perform KPCA on.", "i");
 PARAM_STRING_REQ("output_file", "File to save modified dataset to.", "o");
@@ -87,7 +90,7 @@ PARAM_FLAG("center", "If set, the transformed data will be centered about the "
 PARAM_FLAG("nystroem_method", "If set, the nystroem method will be used.", "n");
 
 PARAM_STRING("sampling", "Sampling scheme to use for the nystroem method: "
-    "'kmeans', 'random', 'ordered'", "s", "kmeans");
+    "'kmeans', 'random', 'ordered', 'hamerly', 'minibatch'", "s", "kmeans");
 
 PARAM_DOUBLE("kernel_scale", "Scale, for 'hyptan' kernel.", "S", 1.0);
 PARAM_DOUBLE("offset", "Offset, for 'hyptan' and 'polynomial' kernels.", "O",
@@ -127,11 +130,24 @@ void RunKPCA(arma::mat& dataset,
           OrderedSelection> > kpca;
       kpca.Apply(dataset, newDim);
     }
+    else if (sampling == "hamerly")
+    {
+      KernelPCA<KernelType, NystroemKernelRule<KernelType,
+          HamerlyKMeansSelection<> > > kpca;
+      kpca.Apply(dataset, newDim);
+    }
+    else if (sampling == "minibatch")
+    {
+      KernelPCA<KernelType, NystroemKernelRule<KernelType,
+          MiniBatchKMeansSelection<> > > kpca;
+      kpca.Apply(dataset, newDim);
+    }
     else
     {
       // Invalid sampling scheme.
       Log::Fatal << "Invalid sampling scheme ('" << sampling << "'); valid "
-        << "choices are 'kmeans', 'random' and 'ordered'" << endl;
+        << "choices are 'kmeans', 'random', 'ordered', 'hamerly' and "
+        << "'minibatch'" << endl;
     }
   }
   else
@@ -0,0 +1,147 @@
+/**
+ * @file kernel_projection.hpp
+ *
+ * The projection of new points onto the kernel principal components found by
+ * KernelPCA.
+ */
+#ifndef MLPACK_METHODS_KERNEL_PCA_KERNEL_PROJECTION_HPP
+#define MLPACK_METHODS_KERNEL_PCA_KERNEL_PROJECTION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * The projection of new points onto the kernel principal components found by
+ * a kernel rule.  The kernel values k of a point with a set of reference points
+ * (the points of the dataset for the NaiveKernelRule, or the points selected by
+ * the NystroemKernelRule) are mapped to features f = M^T k (or f = k, if there
+ * is no map M), which are centered like the features of the dataset:
+ *
+ *   f' = f - (mean features of the dataset) - w * sum(f) + c,
+ *
+ * and the point is projected to P^T f'.  So only the kernel values of the new
+ * points with the reference points are evaluated; this is done in parallel
+ * blocks of points, with the batch Evaluate() of the kernel when it has one.
+ */
+class KernelProjection
+{
+ public:
+  //! Create an empty projection.
+  KernelProjection() : sumWeight(0.0), offset(0.0) { }
+
+  /**
+   * Project the given points.
+   *
+   * @param kernel Kernel used to find the projection.
+   * @param points Points to project (one per column).
+   * @param transformedPoints Matrix to output the projected points into.
+   */
+  template<typename KernelType>
+  void Transform(KernelType& kernel,
+                 const arma::mat& points,
+                 arma::mat& transformedPoints) const
+  {
+    transformedPoints.set_size(projection.n_cols, points.n_cols);
+
+    const size_t blocks = (points.n_cols + BlockSize - 1) / BlockSize;
+    ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+    {
+      const size_t begin = b * BlockSize;
+      const size_t count = std::min((size_t) BlockSize,
+          (size_t) points.n_cols - begin);
+
+      // Use the points of the block where they are, without a copy.
+      const arma::mat block(const_cast<double*>(points.colptr(begin)),
+          points.n_rows, count, false, true);
+
+      arma::mat features;
+      kernel::KernelMatrix(kernel, referencePoints, block, features);
+      if (featureMap.n_elem > 0)
+        features = featureMap.t() * features;
+
+      const arma::rowvec sums = arma::sum(features, 0);
+      features.each_col() -= featureMeans;
+      features.each_row() -= sumWeight * sums;
+      features += offset;
+
+      transformedPoints.cols(begin, begin + count - 1) = projection.t() *
+          features;
+    });
+  }
+
+  //! Keep only the given number of dimensions of the projection.
+  void Truncate(const size_t dimensions)
+  {
+    if (dimensions < projection.n_cols)
+      projection.shed_cols(dimensions, projection.n_cols - 1);
+  }
+
+  //! Get the number of dimensions of the projected points.
+  size_t Dimensionality() const { return projection.n_cols; }
+
+  //! Get the reference points.
+  const arma::mat& ReferencePoints() const { return referencePoints; }
+  //! Modify the reference points.
+  arma::mat& ReferencePoints() { return referencePoints; }
+
+  //! Get the map from kernel values to features (empty if there is none).
+  const arma::mat& FeatureMap() const { return featureMap; }
+  //! Modify the map from kernel values to features.
+  arma::mat& FeatureMap() { return featureMap; }
+
+  //! Get the mean features of the dataset.
+  const arma::vec& FeatureMeans() const { return featureMeans; }
+  //! Modify the mean features of the dataset.
+  arma::vec& FeatureMeans() { return featureMeans; }
+
+  //! Get the weight of the sum of the features of a point in its centering.
+  double SumWeight() const { return sumWeight; }
+  //! Modify the weight of the sum of the features of a point.
+  double& SumWeight() { return sumWeight; }
+
+  //! Get the offset added to the centered features.
+  double Offset() const { return offset; }
+  //! Modify the offset added to the centered features.
+  double& Offset() { return offset; }
+
+  //! Get the projection of the centered features (one column per dimension).
+  const arma::mat& Projection() const { return projection; }
+  //! Modify the projection of the centered features.
+  arma::mat& Projection() { return projection; }
+
+  //! Serialize the projection.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(referencePoints, "referencePoints");
+    ar & data::CreateNVP(featureMap, "featureMap");
+    ar & data::CreateNVP(featureMeans, "featureMeans");
+    ar & data::CreateNVP(sumWeight, "sumWeight");
+    ar & data::CreateNVP(offset, "offset");
+    ar & data::CreateNVP(projection, "projection");
+  }
+
+ private:
+  //! The points whose kernel values with a new point are evaluated.
+  arma::mat referencePoints;
+  //! The map from kernel values to features (empty if there is none).
+  arma::mat featureMap;
+  //! The mean features of the dataset.
+  arma::vec featureMeans;
+  //! The weight of the sum of the features of a point in its centering.
+  double sumWeight;
+  //! The offset added to the centered features.
+  double offset;
+  //! The projection of the centered features.
+  arma::mat projection;
+
+  //! The number of points projected together.
+  static const size_t BlockSize = 256;
+};
+
+} // namespace kpca
+} // namespace mlpack
+
+#endif
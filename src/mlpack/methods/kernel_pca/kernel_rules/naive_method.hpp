@@ -9,6 +9,7 @@
 #define MLPACK_METHODS_KERNEL_PCA_NAIVE_METHOD_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/kernel_pca/kernel_projection.hpp>
 
 namespace mlpack {
 namespace kpca {
@@ -26,46 +27,93 @@ class NaiveKernelRule
      * @param eigvec KPCA eigenvectors will be written to this matrix.
      * @param rank Rank to be used for matrix approximation.
      * @param kernel Kernel to be used for computation.
+     * @param projection If not NULL, the projection of new points is stored in
+     *     it.
      */
     static void ApplyKernelMatrix(const arma::mat& data,
                                   arma::mat& transformedData,
                                   arma::vec& eigval,
                                   arma::mat& eigvec,
                                   const size_t /* unused */,
-                                  KernelType kernel = KernelType())
+                                  KernelType kernel = KernelType(),
+                                  KernelProjection* projection = NULL)
   {
-    // Construct the kernel matrix.
+    // Construct the kernel matrix (in one batch, if the kernel supports it;
+    // otherwise only the upper triangular part is evaluated, since it is
+    // symmetric).
     arma::mat kernelMatrix;
-    // Resize the kernel matrix to the right size.
-    kernelMatrix.set_size(data.n_cols, data.n_cols);
+    kernel::KernelMatrix(kernel, data, kernelMatrix);
 
-    // Note that we only need to calculate the upper triangular part of the
-    // kernel matrix, since it is symmetric. This helps minimize the number of
-    // kernel evaluations.
-    for (size_t i = 0; i < data.n_cols; ++i)
+    // New points are projected with their kernel values with every point.
+    if (projection)
     {
-      for (size_t j = i; j < data.n_cols; ++j)
-      {
-        // Evaluate the kernel on these two points.
-        kernelMatrix(i, j) = kernel.Evaluate(data.unsafe_col(i),
-                                             data.unsafe_col(j));
-      }
+      projection->ReferencePoints() = data;
+      projection->FeatureMap().reset();
     }
 
-    // Copy to the lower triangular part of the matrix.
-    for (size_t i = 1; i < data.n_cols; ++i)
-      for (size_t j = 0; j < i; ++j)
-        kernelMatrix(i, j) = kernelMatrix(j, i);
+    Decompose(kernelMatrix, transformedData, eigval, eigvec, projection);
+  }
+
+    /**
+     * Construct the exact kernel matrix from the given kernel cache (the
+     * columns which are already cached are not computed again).
+     *
+     * @param cache Kernel cache of the input data points.
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param rank Rank to be used for matrix approximation.
+     * @param projection If not NULL, the projection of new points is stored in
+     *     it.
+     */
+    static void ApplyKernelMatrix(kernel::KernelCache<KernelType>& cache,
+                                  arma::mat& transformedData,
+                                  arma::vec& eigval,
+                                  arma::mat& eigvec,
+                                  const size_t /* unused */,
+                                  KernelProjection* projection = NULL)
+  {
+    arma::mat kernelMatrix;
+    cache.Matrix(kernelMatrix);
 
+    if (projection)
+    {
+      projection->ReferencePoints() = cache.Dataset();
+      projection->FeatureMap().reset();
+    }
+
+    Decompose(kernelMatrix, transformedData, eigval, eigvec, projection);
+  }
+
+    /**
+     * Center the given kernel matrix, eigendecompose it, and project the points
+     * onto the eigenvectors.
+     *
+     * @param kernelMatrix Kernel matrix of the input data points (modified).
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param projection If not NULL, the centering and projection of the
+     *     kernel values of new points are stored in it.
+     */
+    static void Decompose(arma::mat& kernelMatrix,
+                          arma::mat& transformedData,
+                          arma::vec& eigval,
+                          arma::mat& eigvec,
+                          KernelProjection* projection = NULL)
+  {
     // For PCA the data has to be centered, even if the data is centered. But it
     // is not guaranteed that the data, when mapped to the kernel space, is also
     // centered. Since we actually never work in the feature space we cannot
     // center the data. So, we perform a "psuedo-centering" using the kernel
     // matrix.
     arma::rowvec rowMean = arma::sum(kernelMatrix, 0) / kernelMatrix.n_cols;
-    kernelMatrix.each_col() -= arma::sum(kernelMatrix, 1) / kernelMatrix.n_cols;
+    const arma::vec columnMeans = arma::sum(kernelMatrix, 1) /
+        kernelMatrix.n_cols;
+    const double offset = arma::sum(rowMean) / kernelMatrix.n_cols;
+    kernelMatrix.each_col() -= columnMeans;
     kernelMatrix.each_row() -= rowMean;
-    kernelMatrix += arma::sum(rowMean) / kernelMatrix.n_cols;
+    kernelMatrix += offset;
 
     // Eigendecompose the centered kernel matrix.
     arma::eig_sym(eigval, eigvec, kernelMatrix);
@@ -80,6 +128,16 @@ class NaiveKernelRule
 
     transformedData = eigvec.t() * kernelMatrix;
     transformedData.each_col() /= arma::sqrt(eigval);
+
+    // The kernel values of a new point are centered in the same way.
+    if (projection)
+    {
+      projection->FeatureMeans() = columnMeans;
+      projection->SumWeight() = 1.0 / kernelMatrix.n_cols;
+      projection->Offset() = offset;
+      projection->Projection() = eigvec;
+      projection->Projection().each_row() /= arma::trans(arma::sqrt(eigval));
+    }
   }
 };
 
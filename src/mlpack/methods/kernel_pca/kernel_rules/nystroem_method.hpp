@@ -11,6 +11,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/nystroem_method/kmeans_selection.hpp>
 #include <mlpack/methods/nystroem_method/nystroem_method.hpp>
+#include <mlpack/methods/kernel_pca/kernel_projection.hpp>
 
 namespace mlpack {
 namespace kpca {
@@ -31,18 +32,83 @@ class NystroemKernelRule
      * @param eigvec KPCA eigenvectors will be written to this matrix.
      * @param rank Rank to be used for matrix approximation.
      * @param kernel Kernel to be used for computation.
+     * @param projection If not NULL, the projection of new points is stored in
+     *     it.
      */
     static void ApplyKernelMatrix(const arma::mat& data,
                                   arma::mat& transformedData,
                                   arma::vec& eigval,
                                   arma::mat& eigvec,
                                   const size_t rank,
-                                  KernelType kernel = KernelType())
+                                  KernelType kernel = KernelType(),
+                                  KernelProjection* projection = NULL)
     {
       arma::mat G, v;
       kernel::NystroemMethod<KernelType, PointSelectionPolicy> nm(data, kernel,
                                                         rank);
       nm.Apply(G);
+
+      // New points are projected with their kernel values with the selected
+      // points.
+      if (projection)
+      {
+        projection->ReferencePoints() = nm.SelectedPoints();
+        projection->FeatureMap() = nm.Normalization();
+      }
+
+      Decompose(G, transformedData, eigval, eigvec, projection);
+    }
+
+    /**
+     * Construct the kernel matrix approximation using the nystroem method, with
+     * the kernel values of the given kernel cache (when the point selection
+     * policy selects points of the dataset).
+     *
+     * @param cache Kernel cache of the input data points.
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param rank Rank to be used for matrix approximation.
+     * @param projection If not NULL, the projection of new points is stored in
+     *     it.
+     */
+    static void ApplyKernelMatrix(kernel::KernelCache<KernelType>& cache,
+                                  arma::mat& transformedData,
+                                  arma::vec& eigval,
+                                  arma::mat& eigvec,
+                                  const size_t rank,
+                                  KernelProjection* projection = NULL)
+    {
+      arma::mat G;
+      kernel::NystroemMethod<KernelType, PointSelectionPolicy> nm(cache, rank);
+      nm.Apply(G);
+
+      if (projection)
+      {
+        projection->ReferencePoints() = nm.SelectedPoints();
+        projection->FeatureMap() = nm.Normalization();
+      }
+
+      Decompose(G, transformedData, eigval, eigvec, projection);
+    }
+
+    /**
+     * Center the kernel matrix approximation G * G^T, eigendecompose it, and
+     * project the points onto the eigenvectors.
+     *
+     * @param G Low-rank factor of the kernel matrix approximation (modified).
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param projection If not NULL, the centering and projection of the
+     *     features of new points are stored in it.
+     */
+    static void Decompose(arma::mat& G,
+                          arma::mat& transformedData,
+                          arma::vec& eigval,
+                          arma::mat& eigvec,
+                          KernelProjection* projection = NULL)
+    {
       transformedData = G.t() * G;
 
       // Center the reconstructed approximation.
@@ -54,9 +120,11 @@ class NystroemKernelRule
       // cannot center the data. So, we perform a "psuedo-centering" using the
       // kernel matrix.
       arma::colvec colMean = arma::sum(G, 1) / G.n_rows;
-      G.each_row() -= arma::sum(G, 0) / G.n_rows;
+      const arma::rowvec featureMeans = arma::sum(G, 0) / G.n_rows;
+      const double offset = arma::sum(colMean) / G.n_rows;
+      G.each_row() -= featureMeans;
       G.each_col() -= colMean;
-      G += arma::sum(colMean) / G.n_rows;
+      G += offset;
 
       // Eigendecompose the centered kernel matrix.
       arma::eig_sym(eigval, eigvec, transformedData);
@@ -70,6 +138,15 @@ class NystroemKernelRule
       eigvec = arma::fliplr(eigvec);
 
       transformedData = eigvec.t() * G.t();
+
+      // The features of a new point are centered in the same way.
+      if (projection)
+      {
+        projection->FeatureMeans() = featureMeans.t();
+        projection->SumWeight() = 1.0 / G.n_rows;
+        projection->Offset() = offset;
+        projection->Projection() = eigvec;
+      }
     }
 };
 
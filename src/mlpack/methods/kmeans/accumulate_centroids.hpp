@@ -0,0 +1,112 @@
+/**
+ * @file accumulate_centroids.hpp
+ *
+ * Helper functions for Lloyd steps, which add points (dense or sparse, of any
+ * element type) to centroids, and sum the points assigned to each cluster in
+ * parallel.
+ */
+#ifndef MLPACK_METHODS_KMEANS_ACCUMULATE_CENTROIDS_HPP
+#define MLPACK_METHODS_KMEANS_ACCUMULATE_CENTROIDS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Add the given point of a dense dataset (of any element type), times the
+ * given scale, to the given column of a matrix.
+ *
+ * @param dataset Dataset points (one per column).
+ * @param point Index of the point to add.
+ * @param sums Matrix to add the point to.
+ * @param column Column of sums to add the point to.
+ * @param scale Factor to multiply the point by.
+ */
+template<typename eT>
+inline void AddPoint(const arma::Mat<eT>& dataset,
+                     const size_t point,
+                     arma::mat& sums,
+                     const size_t column,
+                     const double scale = 1.0)
+{
+  const eT* p = dataset.colptr(point);
+  double* s = sums.colptr(column);
+  for (size_t r = 0; r < dataset.n_rows; ++r)
+    s[r] += scale * p[r];
+}
+
+/**
+ * Add the given point of a sparse dataset, times the given scale, to the given
+ * column of a matrix.  Only the nonzero elements of the point are visited, so
+ * the point is never densified.
+ *
+ * @param dataset Dataset points (one per column).
+ * @param point Index of the point to add.
+ * @param sums Matrix to add the point to.
+ * @param column Column of sums to add the point to.
+ * @param scale Factor to multiply the point by.
+ */
+template<typename eT>
+inline void AddPoint(const arma::SpMat<eT>& dataset,
+                     const size_t point,
+                     arma::mat& sums,
+                     const size_t column,
+                     const double scale = 1.0)
+{
+  double* s = sums.colptr(column);
+  typename arma::SpMat<eT>::const_iterator it = dataset.begin_col(point);
+  for (; it != dataset.end_col(point); ++it)
+    s[it.row()] += scale * (*it);
+}
+
+/**
+ * Given the cluster assignment of each point, compute the sum of the points and
+ * the number of points of each cluster.  The points are first sorted by
+ * cluster, and then the clusters are summed in parallel with OpenMP; but the
+ * points of each cluster are always added in order of index, so the sums are
+ * exactly the same as those of a serial loop over the points, whatever the
+ * number of threads.
+ *
+ * @param dataset Dataset points (one per column).
+ * @param assignments Cluster of each point.
+ * @param numClusters Number of clusters.
+ * @param sums Matrix to store the sum of each cluster in (one per column).
+ * @param counts Vector to store the number of points of each cluster in.
+ */
+template<typename MatType>
+void AccumulateCentroids(const MatType& dataset,
+                         const arma::Col<size_t>& assignments,
+                         const size_t numClusters,
+                         arma::mat& sums,
+                         arma::Col<size_t>& counts)
+{
+  sums.zeros(dataset.n_rows, numClusters);
+  counts.zeros(numClusters);
+  if (numClusters == 0)
+    return;
+
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    counts[assignments[i]]++;
+
+  // Sort the points by cluster (keeping them in order within each cluster).
+  arma::Col<size_t> offsets(numClusters + 1);
+  offsets[0] = 0;
+  for (size_t c = 0; c < numClusters; ++c)
+    offsets[c + 1] = offsets[c] + counts[c];
+
+  arma::Col<size_t> next(offsets.subvec(0, numClusters - 1));
+  arma::Col<size_t> order(assignments.n_elem);
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    order[next[assignments[i]]++] = i;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t c = 0; c < (omp_size_t) numClusters; ++c)
+    for (size_t i = offsets[c]; i < offsets[c + 1]; ++i)
+      AddPoint(dataset, order[i], sums, c);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,238 @@
+/**
+ * @file centroid_distances.hpp
+ *
+ * A helper class for Lloyd steps and empty cluster policies, which computes the
+ * distances between the points of a dense or sparse dataset (of any element
+ * type) and the current centroids.
+ */
+#ifndef MLPACK_METHODS_KMEANS_CENTROID_DISTANCES_HPP
+#define MLPACK_METHODS_KMEANS_CENTROID_DISTANCES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * 'value' is true if the given metric is the Euclidean distance or the squared
+ * Euclidean distance, which can be computed from the squared norms of the two
+ * points and their dot product.
+ */
+template<typename MetricType>
+struct IsEuclidean
+{
+  static const bool value = false;
+};
+
+template<bool TakeRoot>
+struct IsEuclidean<metric::LMetric<2, TakeRoot>>
+{
+  static const bool value = true;
+  static const bool takeRoot = TakeRoot;
+};
+
+/**
+ * CentroidDistances computes the distance between a point of the dataset and a
+ * centroid, for dataset types the metric can't take directly.
+ *
+ *  - For sparse datasets and the (squared) Euclidean distance, the distance is
+ *    computed as ||x||^2 - 2 x^T c + ||c||^2, with the squared norms of the
+ *    points computed once, the squared norms of the centroids computed once per
+ *    set of centroids, and the dot product computed with only the nonzero
+ *    elements of the point.  So the point is never densified, and the cost of
+ *    a distance is proportional to the number of nonzero elements of the point.
+ *  - For dense datasets whose elements are not doubles (such as arma::fmat),
+ *    the (squared) Euclidean distance is computed directly in double precision,
+ *    and other metrics are given a copy of the point as an arma::vec.
+ *  - Otherwise (arma::mat, or arma::sp_mat with another metric), the metric is
+ *    given the point and centroid as they are.
+ *
+ * Evaluate() may be called from several threads at once.
+ *
+ * @code
+ * CentroidDistances<metric::EuclideanDistance, arma::sp_mat> distances(dataset,
+ *     metric);
+ * distances.Centroids(centroids);
+ * const double distance = distances.Evaluate(point, cluster);
+ * @endcode
+ *
+ * @tparam MetricType Type of metric.
+ * @tparam MatType Type of dataset (arma::Mat<eT> or arma::SpMat<eT>).
+ */
+template<typename MetricType, typename MatType>
+class CentroidDistances
+{
+ public:
+  //! The type of element of the dataset.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Prepare to compute distances from the points of the given dataset.  For
+   * sparse datasets with the Euclidean distance, this computes the squared
+   * norm of every point.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   */
+  CentroidDistances(const MatType& dataset, MetricType& metric) :
+      dataset(dataset),
+      metric(metric),
+      centroids(NULL)
+  {
+    PointNorms(UseNorms());
+  }
+
+  /**
+   * Set the centroids to compute distances to.  The centroids must not change
+   * or be destroyed while distances are computed.
+   *
+   * @param centroids Centroids (one per column).
+   */
+  void Centroids(const arma::mat& centroids)
+  {
+    this->centroids = &centroids;
+    if (UseNorms::value)
+      centroidNorms = arma::trans(arma::sum(arma::square(centroids), 0));
+  }
+
+  /**
+   * Return the distance between the given point of the dataset and the given
+   * centroid.
+   *
+   * @param point Index of the point.
+   * @param centroid Index of the centroid.
+   */
+  double Evaluate(const size_t point, const size_t centroid) const
+  {
+    return Evaluate(point, centroid, UseNorms(), std::integral_constant<bool,
+        std::is_same<ElemType, double>::value>());
+  }
+
+ private:
+  //! True if the distances are computed from the norms of the points.
+  typedef std::integral_constant<bool, arma::is_SpMat<MatType>::value &&
+      IsEuclidean<MetricType>::value> UseNorms;
+
+  //! Compute the squared norms of the points.
+  void PointNorms(std::true_type /* useNorms */)
+  {
+    pointNorms.zeros(dataset.n_cols);
+    for (typename MatType::const_iterator it = dataset.begin();
+         it != dataset.end(); ++it)
+      pointNorms[it.col()] += double(*it) * double(*it);
+  }
+
+  //! The norms of the points are not needed.
+  void PointNorms(std::false_type /* useNorms */) { }
+
+  //! Compute the distance from the norms and the dot product.
+  template<typename IsDouble>
+  double Evaluate(const size_t point,
+                  const size_t centroid,
+                  std::true_type /* useNorms */,
+                  IsDouble /* isDouble */) const
+  {
+    const double* c = centroids->colptr(centroid);
+    double dot = 0.0;
+    for (typename MatType::const_iterator it = dataset.begin_col(point);
+         it != dataset.end_col(point); ++it)
+      dot += double(*it) * c[it.row()];
+
+    // Rounding may make the squared distance of very close points negative.
+    const double squaredDistance = std::max(pointNorms[point] - 2 * dot +
+        centroidNorms[centroid], 0.0);
+    return Root(squaredDistance);
+  }
+
+  //! Give the point and the centroid to the metric.
+  double Evaluate(const size_t point,
+                  const size_t centroid,
+                  std::false_type /* useNorms */,
+                  std::true_type /* isDouble */) const
+  {
+    return metric.Evaluate(dataset.col(point), centroids->col(centroid));
+  }
+
+  //! Convert the point to double precision for the metric.
+  double Evaluate(const size_t point,
+                  const size_t centroid,
+                  std::false_type /* useNorms */,
+                  std::false_type /* isDouble */) const
+  {
+    return Convert(point, centroid, std::integral_constant<bool,
+        IsEuclidean<MetricType>::value && !arma::is_SpMat<MatType>::value>());
+  }
+
+  //! Compute the (squared) Euclidean distance in double precision.
+  double Convert(const size_t point,
+                 const size_t centroid,
+                 std::true_type /* denseEuclidean */) const
+  {
+    const ElemType* p = dataset.colptr(point);
+    const double* c = centroids->colptr(centroid);
+    double squaredDistance = 0.0;
+    for (size_t r = 0; r < dataset.n_rows; ++r)
+    {
+      const double difference = double(p[r]) - c[r];
+      squaredDistance += difference * difference;
+    }
+
+    return Root(squaredDistance);
+  }
+
+  //! Give a copy of the point to the metric.
+  double Convert(const size_t point,
+                 const size_t centroid,
+                 std::false_type /* denseEuclidean */) const
+  {
+    arma::vec p(dataset.n_rows, arma::fill::zeros);
+    Copy(dataset, point, p);
+    return metric.Evaluate(p, centroids->col(centroid));
+  }
+
+  //! Copy a point of a dense dataset.
+  static void Copy(const arma::Mat<ElemType>& dataset,
+                   const size_t point,
+                   arma::vec& p)
+  {
+    const ElemType* x = dataset.colptr(point);
+    for (size_t r = 0; r < dataset.n_rows; ++r)
+      p[r] = double(x[r]);
+  }
+
+  //! Copy a point of a sparse dataset.
+  static void Copy(const arma::SpMat<ElemType>& dataset,
+                   const size_t point,
+                   arma::vec& p)
+  {
+    typename arma::SpMat<ElemType>::const_iterator it =
+        dataset.begin_col(point);
+    for (; it != dataset.end_col(point); ++it)
+      p[it.row()] = double(*it);
+  }
+
+  //! Take the square root of the squared distance, if the metric does.
+  static double Root(const double squaredDistance)
+  {
+    return IsEuclidean<MetricType>::takeRoot ? std::sqrt(squaredDistance) :
+        squaredDistance;
+  }
+
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+  //! The current centroids.
+  const arma::mat* centroids;
+
+  //! The squared norms of the points (if they are used).
+  arma::vec pointNorms;
+  //! The squared norms of the centroids (if they are used).
+  arma::vec centroidNorms;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * @file chunked_kmeans.hpp
+ *
+ * Defines the ChunkedKMeans class, which runs Lloyd iterations over a dataset
+ * file that is read in chunks, so that datasets larger than memory can be
+ * clustered.
+ */
+#ifndef MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_HPP
+#define MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The ChunkedKMeans class performs (naive) k-means clustering on a dataset that
+ * is stored in a file and never loaded into memory all at once.  Each Lloyd
+ * iteration reads the whole file with data::ChunkedLoader, a chunk of points at
+ * a time; the points of each chunk are assigned to their closest centroid (in
+ * parallel) and added to the sum and count of that centroid, and then the chunk
+ * is dropped.  So the memory used is O(k * d + chunkSize * d) instead of
+ * O(N * d).  The input file can be a text file (.csv, .tsv or .txt) or an
+ * Armadillo binary file (.bin); binary files are much faster to read.
+ *
+ * The centroids are the same as those of KMeans<MetricType,
+ * SampleInitialization, AllowEmptyClusters, NaiveKMeans> on the loaded dataset
+ * from the same initial centroids (up to floating-point rounding); empty
+ * clusters keep their centroid.  Without initial centroids, the initial
+ * centroids are sampled uniformly from the file (in one extra pass).
+ *
+ * @code
+ * ChunkedKMeans<> k(100000);
+ * arma::mat centroids;
+ * k.Cluster("data.bin", 1000, centroids);
+ * k.Assign("data.bin", centroids, "labels.csv");
+ * @endcode
+ *
+ * @tparam MetricType The distance metric to use.
+ */
+template<typename MetricType = metric::EuclideanDistance>
+class ChunkedKMeans
+{
+ public:
+  /**
+   * Create a ChunkedKMeans object.
+   *
+   * @param chunkSize Number of points to read at a time.
+   * @param maxIterations Maximum number of iterations allowed before giving up
+   *     (0 is valid, but the algorithm may never terminate).
+   * @param metric Optional MetricType object.
+   */
+  ChunkedKMeans(const size_t chunkSize = 100000,
+                const size_t maxIterations = 1000,
+                const MetricType metric = MetricType());
+
+  /**
+   * Cluster the dataset in the given file into the given number of clusters,
+   * and return the centroids.  A std::invalid_argument is thrown if the initial
+   * centroids don't fit the dataset, and a std::runtime_error if the file can't
+   * be read.
+   *
+   * @param filename File holding the dataset.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *     initial cluster centroids.
+   */
+  void Cluster(const std::string& filename,
+               const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
+  /**
+   * Assign each point of the given input file to its closest centroid, and
+   * write the assignments to the given output file (.csv or .txt) in a final
+   * streaming pass.  If labelsOnly is false, each output point is the input
+   * point with its assignment appended as an extra dimension, like the output
+   * of mlpack_kmeans.
+   *
+   * @param inputFile File holding the dataset.
+   * @param centroids Cluster centroids.
+   * @param outputFile File to write the assignments to.
+   * @param labelsOnly If true, only write the assignments.
+   */
+  void Assign(const std::string& inputFile,
+              const arma::mat& centroids,
+              const std::string& outputFile,
+              const bool labelsOnly = true);
+
+  //! Get the number of points read at a time.
+  size_t ChunkSize() const { return chunkSize; }
+  //! Modify the number of points read at a time.
+  size_t& ChunkSize() { return chunkSize; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Set the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the distance metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the distance metric.
+  MetricType& Metric() { return metric; }
+
+ private:
+  /**
+   * Find the closest centroid to each point of the given chunk.
+   */
+  void AssignChunk(const arma::mat& chunk,
+                   const arma::mat& centroids,
+                   arma::Col<size_t>& assignments);
+
+  //! Sample the initial centroids uniformly from the file.
+  void SampleCentroids(data::ChunkedLoader<double>& loader,
+                       const size_t clusters,
+                       arma::mat& centroids);
+
+  //! Number of points read at a time.
+  size_t chunkSize;
+  //! Maximum number of iterations before giving up.
+  size_t maxIterations;
+  //! Instantiated distance metric.
+  MetricType metric;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "chunked_kmeans_impl.hpp"
+
+#endif
@@ -0,0 +1,226 @@
+/**
+ * @file chunked_kmeans_impl.hpp
+ *
+ * Implementation of the ChunkedKMeans class.
+ */
+#ifndef MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_IMPL_HPP
+#define MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chunked_kmeans.hpp"
+
+#include "accumulate_centroids.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType>
+ChunkedKMeans<MetricType>::ChunkedKMeans(const size_t chunkSize,
+                                         const size_t maxIterations,
+                                         const MetricType metric) :
+    chunkSize(chunkSize),
+    maxIterations(maxIterations),
+    metric(metric)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType>
+void ChunkedKMeans<MetricType>::Cluster(const std::string& filename,
+                                        const size_t clusters,
+                                        arma::mat& centroids,
+                                        const bool initialGuess)
+{
+  if (chunkSize == 0)
+    throw std::invalid_argument("ChunkedKMeans::Cluster(): chunk size must be "
+        "greater than 0");
+
+  if (clusters == 0)
+    throw std::invalid_argument("ChunkedKMeans::Cluster(): number of clusters "
+        "must be greater than 0");
+
+  data::ChunkedLoader<double> loader(filename);
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+    {
+      std::ostringstream oss;
+      oss << "ChunkedKMeans::Cluster(): wrong number of initial cluster "
+          << "centroids (" << centroids.n_cols << ", should be " << clusters
+          << ")";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+  else
+  {
+    SampleCentroids(loader, clusters, centroids);
+  }
+
+  arma::mat chunk;
+  arma::Col<size_t> assignments;
+  arma::mat sums, chunkSums;
+  arma::Col<size_t> counts, chunkCounts;
+  size_t iteration = 0;
+  double cNorm;
+  do
+  {
+    // Accumulate the sums and counts of each cluster over all the chunks, in
+    // the order of the file.
+    sums.zeros(centroids.n_rows, clusters);
+    counts.zeros(clusters);
+    loader.Reset();
+    while (loader.Next(chunk, chunkSize))
+    {
+      if (chunk.n_rows != centroids.n_rows)
+      {
+        std::ostringstream oss;
+        oss << "ChunkedKMeans::Cluster(): cluster centroids have wrong "
+            << "dimensionality (" << centroids.n_rows << ", should be "
+            << chunk.n_rows << ")";
+        throw std::invalid_argument(oss.str());
+      }
+
+      AssignChunk(chunk, centroids, assignments);
+      AccumulateCentroids(chunk, assignments, clusters, chunkSums,
+          chunkCounts);
+      sums += chunkSums;
+      counts += chunkCounts;
+    }
+
+    // Empty clusters keep their centroid.
+    cNorm = 0.0;
+    for (size_t c = 0; c < clusters; ++c)
+    {
+      if (counts[c] == 0)
+        continue;
+
+      const arma::vec newCentroid = sums.col(c) / counts[c];
+      cNorm += std::pow(metric.Evaluate(centroids.col(c), newCentroid), 2.0);
+      centroids.col(c) = newCentroid;
+    }
+    cNorm = std::sqrt(cNorm);
+
+    iteration++;
+    Log::Info << "ChunkedKMeans::Cluster(): iteration " << iteration
+        << " over " << loader.PointsRead() << " points, residual " << cNorm
+        << ".\n";
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  if (iteration != maxIterations)
+    Log::Info << "ChunkedKMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  else
+    Log::Info << "ChunkedKMeans::Cluster(): terminated after limit of "
+        << iteration << " iterations." << std::endl;
+}
+
+template<typename MetricType>
+void ChunkedKMeans<MetricType>::Assign(const std::string& inputFile,
+                                       const arma::mat& centroids,
+                                       const std::string& outputFile,
+                                       const bool labelsOnly)
+{
+  if (chunkSize == 0)
+    throw std::invalid_argument("ChunkedKMeans::Assign(): chunk size must be "
+        "greater than 0");
+
+  data::ChunkedLoader<double> loader(inputFile);
+  data::ChunkedSaver saver(outputFile);
+  arma::mat chunk;
+  arma::Col<size_t> assignments;
+  while (loader.Next(chunk, chunkSize))
+  {
+    if (chunk.n_rows != centroids.n_rows)
+    {
+      std::ostringstream oss;
+      oss << "ChunkedKMeans::Assign(): cluster centroids have wrong "
+          << "dimensionality (" << centroids.n_rows << ", should be "
+          << chunk.n_rows << ")";
+      throw std::invalid_argument(oss.str());
+    }
+
+    AssignChunk(chunk, centroids, assignments);
+    if (labelsOnly)
+    {
+      saver.Write(arma::Mat<size_t>(assignments.t()));
+    }
+    else
+    {
+      chunk.insert_rows(chunk.n_rows,
+          arma::conv_to<arma::rowvec>::from(assignments.t()));
+      saver.Write(chunk);
+    }
+  }
+}
+
+template<typename MetricType>
+void ChunkedKMeans<MetricType>::AssignChunk(const arma::mat& chunk,
+                                            const arma::mat& centroids,
+                                            arma::Col<size_t>& assignments)
+{
+  assignments.set_size(chunk.n_cols);
+
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) chunk.n_cols; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = 0;
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+    {
+      const double distance = metric.Evaluate(chunk.col(i), centroids.col(c));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = c;
+      }
+    }
+
+    assignments[i] = closestCluster;
+  }
+}
+
+template<typename MetricType>
+void ChunkedKMeans<MetricType>::SampleCentroids(
+    data::ChunkedLoader<double>& loader,
+    const size_t clusters,
+    arma::mat& centroids)
+{
+  // Reservoir sampling: after t points, each point is in the sample with
+  // probability clusters / t.
+  arma::mat chunk;
+  size_t numPoints = 0;
+  loader.Reset();
+  while (loader.Next(chunk, chunkSize))
+  {
+    if (numPoints == 0)
+      centroids.set_size(chunk.n_rows, clusters);
+
+    for (size_t i = 0; i < chunk.n_cols; ++i, ++numPoints)
+    {
+      if (numPoints < clusters)
+      {
+        centroids.col(numPoints) = chunk.col(i);
+      }
+      else
+      {
+        const size_t j = std::min((size_t) (math::Random() * (numPoints + 1)),
+            numPoints);
+        if (j < clusters)
+          centroids.col(j) = chunk.col(i);
+      }
+    }
+  }
+
+  if (numPoints < clusters)
+  {
+    std::ostringstream oss;
+    oss << "ChunkedKMeans::Cluster(): more clusters requested (" << clusters
+        << ") than points in the dataset (" << numPoints << ")";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
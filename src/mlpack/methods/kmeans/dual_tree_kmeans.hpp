@@ -80,6 +80,13 @@ class DualTreeKMeans
   Tree* tree;
   //! The dataset we are using.
   const MatType& dataset;
+  //! The tree built on the centroids, which is kept between iterations.
+  Tree* centroidTree;
+  //! Mappings of the centroids in the centroid tree.
+  std::vector<size_t> oldFromNewCentroids;
+  //! The sum of the largest centroid movement of each iteration since the
+  //! centroid tree was built.
+  double centroidMovement;
   //! The metric.
   MetricType metric;
 
@@ -44,6 +44,47 @@ TreeType* BuildTree(
   return new TreeType(dataset);
 }
 
+//! This gives us a HasRefitBounds object, which tells us whether or not a tree
+//! type can refit its bounds after its points have moved.
+HAS_MEM_FUNC(RefitBounds, HasRefitBoundsCheck);
+
+//! Move the points of a tree built on the old centroids to the new centroids
+//! and refit its bounds, for tree types that can do that.  This returns true.
+template<typename TreeType>
+bool RefitTree(
+    TreeType& tree,
+    const typename TreeType::Mat& dataset,
+    const std::vector<size_t>& oldFromNew,
+    const typename boost::enable_if_c<
+        HasRefitBoundsCheck<TreeType, void(TreeType::*)()>::value>::type* = 0)
+{
+  if (tree::TreeTraits<TreeType>::RearrangesDataset)
+  {
+    for (size_t i = 0; i < oldFromNew.size(); ++i)
+      tree.Dataset().col(i) = dataset.col(oldFromNew[i]);
+  }
+  else
+  {
+    tree.Dataset() = dataset;
+  }
+
+  tree.RefitBounds();
+  return true;
+}
+
+//! For tree types that can't refit their bounds, do nothing and return false,
+//! so that a new tree is built.
+template<typename TreeType>
+bool RefitTree(
+    TreeType& /* tree */,
+    const typename TreeType::Mat& /* dataset */,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::disable_if_c<
+        HasRefitBoundsCheck<TreeType, void(TreeType::*)()>::value>::type* = 0)
+{
+  return false;
+}
+
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
@@ -55,6 +96,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
     datasetOrig(dataset),
     tree(new Tree(const_cast<MatType&>(dataset))),
     dataset(tree->Dataset()),
+    centroidTree(NULL),
+    centroidMovement(0.0),
     metric(metric),
     distanceCalculations(0),
     iteration(0),
@@ -83,6 +126,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::~DualTreeKMeans()
 {
   if (tree)
     delete tree;
+  if (centroidTree)
+    delete centroidTree;
 }
 
 // Run a single iteration.
@@ -96,10 +141,24 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     arma::mat& newCentroids,
     arma::Col<size_t>& counts)
 {
-  // Build a tree on the centroids.  This will make a copy if necessary, which
-  // is unfortunate, but I don't see a reasonable way around it.
-  std::vector<size_t> oldFromNewCentroids;
-  Tree* centroidTree = BuildTree<Tree>(centroids, oldFromNewCentroids);
+  // If the centroids have not moved much since the centroid tree was built,
+  // its structure is still good, so we move its points to the new centroids and
+  // refit its bounds.  Otherwise (or if the tree type can't be refit), we
+  // build a new tree on the centroids.  This will make a copy if necessary,
+  // which is unfortunate, but I don't see a reasonable way around it.
+  if (centroidTree && (centroidTree->Dataset().n_cols != centroids.n_cols ||
+      centroidMovement > 0.1 * centroidTree->FurthestDescendantDistance() ||
+      !RefitTree(*centroidTree, centroids, oldFromNewCentroids)))
+  {
+    delete centroidTree;
+    centroidTree = NULL;
+  }
+
+  if (!centroidTree)
+  {
+    centroidTree = BuildTree<Tree>(centroids, oldFromNewCentroids);
+    centroidMovement = 0.0;
+  }
 
   // Reset information in the tree, if we need to.
   if (iteration > 0)
@@ -194,8 +253,7 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     }
   }
   distanceCalculations += centroids.n_cols;
-
-  delete centroidTree;
+  centroidMovement += clusterDistances[centroids.n_cols];
 
   ++iteration;
 
@@ -337,12 +395,42 @@ visited[node.Descendant(i)] << ".\n";
   // Recurse into children, and if all the children (and all the points) are
   // pruned, then we can mark this as statically pruned.
   bool allChildrenPruned = true;
-  for (size_t i = 0; i < node.NumChildren(); ++i)
+  if (prunedLastIteration && node.Stat().StaticPruned() &&
+      node.NumChildren() > 0)
+  {
+    // This node is still pruned with the same owner, so all of its descendants
+    // are too, and none of them will be visited by the traversal.  Instead of
+    // updating the whole subtree, we only remember how far the bounds moved,
+    // and pass that on to the children once we recurse into them again.
+    node.Stat().PendingUpperBoundMovement() +=
+        clusterDistances[node.Stat().Owner()];
+    node.Stat().PendingLowerBoundMovement() +=
+        clusterDistances[centroids.n_cols];
+  }
+  else
   {
-    UpdateTree(node.Child(i), centroids, unadjustedUpperBound,
-        adjustedUpperBound, unadjustedLowerBound, adjustedLowerBound);
-    if (!node.Child(i).Stat().StaticPruned())
-      allChildrenPruned = false;
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      // The child missed the bound movements of the iterations where it was
+      // skipped.
+      Tree& child = node.Child(i);
+      child.Stat().StaticUpperBoundMovement() +=
+          node.Stat().PendingUpperBoundMovement();
+      child.Stat().StaticLowerBoundMovement() +=
+          node.Stat().PendingLowerBoundMovement();
+      child.Stat().PendingUpperBoundMovement() +=
+          node.Stat().PendingUpperBoundMovement();
+      child.Stat().PendingLowerBoundMovement() +=
+          node.Stat().PendingLowerBoundMovement();
+
+      UpdateTree(child, centroids, unadjustedUpperBound, adjustedUpperBound,
+          unadjustedLowerBound, adjustedLowerBound);
+      if (!child.Stat().StaticPruned())
+        allChildrenPruned = false;
+    }
+
+    node.Stat().PendingUpperBoundMovement() = 0.0;
+    node.Stat().PendingLowerBoundMovement() = 0.0;
   }
 
   bool allPointsPruned = true;
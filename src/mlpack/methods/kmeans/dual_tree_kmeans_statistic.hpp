@@ -25,6 +25,8 @@ class DualTreeKMeansStatistic : public
       staticPruned(false),
       staticUpperBoundMovement(0.0),
       staticLowerBoundMovement(0.0),
+      pendingUpperBoundMovement(0.0),
+      pendingLowerBoundMovement(0.0),
       centroid(),
       trueParent(NULL)
   {
@@ -41,6 +43,8 @@ class DualTreeKMeansStatistic : public
       staticPruned(false),
       staticUpperBoundMovement(0.0),
       staticLowerBoundMovement(0.0),
+      pendingUpperBoundMovement(0.0),
+      pendingLowerBoundMovement(0.0),
       trueParent(node.Parent())
   {
     // Empirically calculate the centroid.
@@ -91,6 +95,14 @@ class DualTreeKMeansStatistic : public
   double StaticLowerBoundMovement() const { return staticLowerBoundMovement; }
   double& StaticLowerBoundMovement() { return staticLowerBoundMovement; }
 
+  // The movement of the bounds while the children of this node were skipped,
+  // which has not been passed down to the children yet.
+  double PendingUpperBoundMovement() const { return pendingUpperBoundMovement; }
+  double& PendingUpperBoundMovement() { return pendingUpperBoundMovement; }
+
+  double PendingLowerBoundMovement() const { return pendingLowerBoundMovement; }
+  double& PendingLowerBoundMovement() { return pendingLowerBoundMovement; }
+
   void* TrueParent() const { return trueParent; }
   void*& TrueParent() { return trueParent; }
 
@@ -107,6 +119,8 @@ class DualTreeKMeansStatistic : public
   bool staticPruned;
   double staticUpperBoundMovement;
   double staticLowerBoundMovement;
+  double pendingUpperBoundMovement;
+  double pendingLowerBoundMovement;
   arma::vec centroid;
   void* trueParent;
   std::vector<void*> trueChildren;
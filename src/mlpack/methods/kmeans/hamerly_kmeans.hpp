@@ -7,9 +7,21 @@
 #ifndef MLPACK_METHODS_KMEANS_HAMERLY_KMEANS_HPP
 #define MLPACK_METHODS_KMEANS_HAMERLY_KMEANS_HPP
 
+#include "centroid_distances.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
+/**
+ * An implementation of Hamerly's algorithm for a single Lloyd iteration, which
+ * keeps an upper bound on the distance of each point to its centroid and a
+ * lower bound on its distance to the second closest centroid.  The dataset may
+ * be dense or sparse, of any element type (such as arma::fmat); see
+ * CentroidDistances for how the distances are computed.
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat, arma::fmat or arma::sp_mat).
+ */
 template<typename MetricType, typename MatType>
 class HamerlyKMeans
 {
@@ -39,6 +51,8 @@ class HamerlyKMeans
   const MatType& dataset;
   //! The instantiated metric.
   MetricType& metric;
+  //! The distances between the points and the centroids.
+  CentroidDistances<MetricType, MatType> distances;
 
   //! Minimum cluster distances from each cluster.
   arma::vec minClusterDistances;
@@ -10,6 +10,8 @@
 // In case it hasn't been included yet.
 #include "hamerly_kmeans.hpp"
 
+#include "accumulate_centroids.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -18,6 +20,7 @@ HamerlyKMeans<MetricType, MatType>::HamerlyKMeans(const MatType& dataset,
                                                   MetricType& metric) :
     dataset(dataset),
     metric(metric),
+    distances(dataset, metric),
     distanceCalculations(0)
 {
   // Nothing to do.
@@ -40,10 +43,6 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     minClusterDistances.set_size(centroids.n_cols);
   }
 
-  // Reset new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // Calculate minimum intra-cluster distance for each cluster.
   minClusterDistances.fill(DBL_MAX);
   for (size_t i = 0; i < centroids.n_cols; ++i)
@@ -62,7 +61,12 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
   }
 
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  // Each point only touches its own bounds and assignment, so the points are
+  // processed in parallel.
+  distances.Centroids(centroids);
+  size_t pointDistances = 0;
+  #pragma omp parallel for reduction(+:hamerlyPruned, pointDistances)
+  for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; ++i)
   {
     const double m = std::max(minClusterDistances(assignments[i]),
                               lowerBounds(i));
@@ -71,23 +75,16 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     if (upperBounds(i) <= m)
     {
       ++hamerlyPruned;
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
       continue;
     }
 
     // Tighten upper bound.
-    upperBounds(i) = metric.Evaluate(dataset.col(i),
-                                     centroids.col(assignments[i]));
-    ++distanceCalculations;
+    upperBounds(i) = distances.Evaluate(i, assignments[i]);
+    ++pointDistances;
 
     // Second bound test.
     if (upperBounds(i) <= m)
-    {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
       continue;
-    }
 
     // The bounds failed.  So test against all other clusters.
     // This is Hamerly's Point-All-Ctrs() function from the paper.
@@ -98,7 +95,7 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
       if (c == assignments[i])
         continue;
 
-      const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+      const double dist = distances.Evaluate(i, c);
 
       // Is this a better cluster?  At this point, upperBounds[i] = d(i, c(i)).
       if (dist < upperBounds(i))
@@ -114,12 +111,13 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
         lowerBounds(i) = dist;
       }
     }
-    distanceCalculations += centroids.n_cols - 1;
-
-    // Update new centroids.
-    newCentroids.col(assignments[i]) += dataset.col(i);
-    ++counts(assignments[i]);
+    pointDistances += centroids.n_cols - 1;
   }
+  distanceCalculations += pointDistances;
+
+  // Update new centroids.
+  AccumulateCentroids(dataset, assignments, centroids.n_cols, newCentroids,
+      counts);
 
   // Normalize centroids and calculate cluster movement (contains parts of
   // Move-Centers() and Update-Bounds()).
@@ -153,7 +151,8 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   }
 
   // Now update bounds (lines 3-8 of Update-Bounds()).
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; ++i)
   {
     upperBounds(i) += centroidMovements(assignments[i]);
     if (assignments[i] == furthestMovingCluster)
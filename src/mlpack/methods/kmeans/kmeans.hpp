@@ -8,6 +8,7 @@
 #define MLPACK_METHODS_KMEANS_KMEANS_HPP
 
 #include <mlpack/core.hpp>
+#include <functional>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "sample_initialization.hpp"
@@ -56,6 +57,12 @@ namespace kmeans /** K-Means clustering. */ {
  *     arma::mat& newCentroids, arma::Col<size_t>& counts, MetricType& metric,
  *     const size_t iteration)'.
  * @tparam LloydStepType Implementation of single Lloyd step to use.
+ * @tparam MatType Type of dataset.  Sparse datasets (arma::sp_mat) and datasets
+ *     of other element types (such as arma::fmat) are supported by the
+ *     NaiveKMeans, HamerlyKMeans and MiniBatchKMeans steps and the
+ *     SampleInitialization, RandomPartition, AllowEmptyClusters and
+ *     MaxVarianceNewCluster policies, without being converted to arma::mat;
+ *     the centroids are always stored as an arma::mat.
  *
  * @see RandomPartition, SampleInitialization, RefinedStart, AllowEmptyClusters,
  *      MaxVarianceNewCluster, NaiveKMeans, ElkanKMeans
@@ -68,6 +75,9 @@ template<typename MetricType = metric::EuclideanDistance,
 class KMeans
 {
  public:
+  //! The type of the Lloyd step used by Cluster().
+  typedef LloydStepType<MetricType, MatType> LloydStep;
+
   /**
    * Create a K-Means object and (optionally) set the parameters which K-Means
    * will be run with.
@@ -171,6 +181,17 @@ class KMeans
   //! Modify the empty cluster policy.
   EmptyClusterPolicy& EmptyClusterAction() { return emptyClusterAction; }
 
+  /**
+   * Get the function that Cluster() calls on each Lloyd step object it creates,
+   * before the first iteration.  This is how the parameters of a step (such as
+   * MiniBatchKMeans::BatchSize()) are set for this KMeans object only.  It is
+   * empty by default.
+   */
+  const std::function<void(LloydStep&)>& StepSetup() const
+  { return stepSetup; }
+  //! Modify the function that Cluster() calls on each Lloyd step object.
+  std::function<void(LloydStep&)>& StepSetup() { return stepSetup; }
+
   //! Serialize the k-means object.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int version);
@@ -184,6 +205,8 @@ class KMeans
   InitialPartitionPolicy partitioner;
   //! Instantiated empty cluster policy.
   EmptyClusterPolicy emptyClusterAction;
+  //! Function called on each Lloyd step object before the first iteration.
+  std::function<void(LloydStep&)> stepSetup;
 };
 
 } // namespace kmeans
@@ -9,6 +9,8 @@
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/util/sfinae_utility.hpp>
+#include "accumulate_centroids.hpp"
+#include "centroid_distances.hpp"
 
 namespace mlpack {
 namespace kmeans {
@@ -187,7 +189,7 @@ Cluster(const MatType& data,
       centroids.zeros(data.n_rows, clusters);
       for (size_t i = 0; i < data.n_cols; ++i)
       {
-        centroids.col(assignments[i]) += arma::vec(data.col(i));
+        AddPoint(data, i, centroids, assignments[i]);
         counts[assignments[i]]++;
       }
 
@@ -202,7 +204,9 @@ Cluster(const MatType& data,
 
   size_t iteration = 0;
 
-  LloydStepType<MetricType, MatType> lloydStep(data, metric);
+  LloydStep lloydStep(data, metric);
+  if (stepSetup)
+    stepSetup(lloydStep);
   arma::mat centroidsOther;
   double cNorm;
 
@@ -221,7 +225,7 @@ Cluster(const MatType& data,
     {
       if (counts[i] == 0)
       {
-        Log::Info << "Cluster " << i << " is empty.\n";
+        MLPACK_LOG(Log::Info) << "Cluster " << i << " is empty.\n";
         if (iteration % 2 == 0)
           emptyClusterAction.EmptyCluster(data, i, centroids, centroidsOther,
               counts, metric, iteration);
@@ -232,12 +236,13 @@ Cluster(const MatType& data,
     }
 
     iteration++;
-    Log::Info << "KMeans::Cluster(): iteration " << iteration << ", residual "
-        << cNorm << ".\n";
+    MLPACK_LOG(Log::Info) << "KMeans::Cluster(): iteration " << iteration
+        << ", residual " << cNorm << ".\n";
     if (std::isnan(cNorm) || std::isinf(cNorm))
       cNorm = 1e-4; // Keep iterating.
 
   } while (cNorm > 1e-5 && iteration != maxIterations);
+  Counter::Add("kmeans/iterations", iteration);
 
   // If we ended on an even iteration, then the centroids are in the
   // centroidsOther matrix, and we need to steal its memory (steal_mem() avoids
@@ -295,7 +300,7 @@ Cluster(const MatType& data,
     centroids.zeros(data.n_rows, clusters);
     for (size_t i = 0; i < data.n_cols; ++i)
     {
-      centroids.col(assignments[i]) += arma::vec(data.col(i));
+      AddPoint(data, i, centroids, assignments[i]);
       counts[assignments[i]]++;
     }
 
@@ -308,6 +313,8 @@ Cluster(const MatType& data,
       initialAssignmentGuess || initialCentroidGuess);
 
   // Calculate final assignments.
+  CentroidDistances<MetricType, MatType> distances(data, metric);
+  distances.Centroids(centroids);
   assignments.set_size(data.n_cols);
   for (size_t i = 0; i < data.n_cols; ++i)
   {
@@ -317,7 +324,7 @@ Cluster(const MatType& data,
 
     for (size_t j = 0; j < centroids.n_cols; j++)
     {
-      const double distance = metric.Evaluate(data.col(i), centroids.col(j));
+      const double distance = distances.Evaluate(i, j);
 
       if (distance < minDistance)
       {
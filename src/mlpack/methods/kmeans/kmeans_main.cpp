@@ -10,10 +10,15 @@
 #include "allow_empty_clusters.hpp"
 #include "kill_empty_clusters.hpp"
 #include "refined_start.hpp"
+#include "kmeans_plus_plus_initialization.hpp"
+#include "kmeans_parallel_initialization.hpp"
 #include "elkan_kmeans.hpp"
 #include "hamerly_kmeans.hpp"
 #include "pelleg_moore_kmeans.hpp"
 #include "dual_tree_kmeans.hpp"
+#include "mini_batch_kmeans.hpp"
+#include "yinyang_kmeans.hpp"
+#include "chunked_kmeans.hpp"
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
@@ -35,14 +40,41 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     "to be used in each sample, the --percentage parameter is used (it should "
     "be a value between 0.0 and 1.0)."
     "\n\n"
+    "Alternatively, the k-means++ seeding (\"k-means++: the advantages of "
+    "careful seeding\", 2007) can be used with --kmeans_plus_plus (-K), or "
+    "its scalable variant k-means|| (\"Scalable k-means++\", 2012) can be "
+    "used with --kmeans_parallel (-L).  k-means|| makes --rounds (-R) passes "
+    "over the dataset, sampling about --oversampling (-O) times the number of "
+    "clusters candidate points in each pass, and then reclusters the "
+    "candidates.  Both usually give better initial centroids than random "
+    "sampling, so fewer Lloyd iterations are needed."
+    "\n\n"
     "There are several options available for the algorithm used for each Lloyd "
     "iteration, specified with the --algorithm (-a) option.  The standard O(kN)"
     " approach can be used ('naive').  Other options include the Pelleg-Moore "
     "tree-based algorithm ('pelleg-moore'), Elkan's triangle-inequality based "
     "algorithm ('elkan'), Hamerly's modification to Elkan's algorithm "
-    "('hamerly'), the dual-tree k-means algorithm ('dualtree'), and the "
+    "('hamerly'), Yinyang k-means, which keeps one bound per group of "
+    "centroids ('yinyang'; the number of groups is set with --groups (-G)), "
+    "the dual-tree k-means algorithm ('dualtree'), and the "
     "dual-tree k-means algorithm using the cover tree ('dualtree-covertree')."
     "\n\n"
+    "For very large datasets, Sculley's mini-batch k-means ('minibatch') only "
+    "uses a random sample of --batch_size (-b) points in each iteration, and "
+    "converges much faster to good (but not exact) centroids.  Because each "
+    "iteration only moves the centroids a little, more iterations are needed "
+    "than with the other algorithms; and since the default empty cluster "
+    "policy makes a full pass over the dataset, -e is recommended with it."
+    "\n\n"
+    "If the dataset does not fit in memory, --chunk_size (-z) can be given; "
+    "then the input file (which may be a .csv, .tsv, .txt or Armadillo binary "
+    ".bin file) is never loaded at once, but read --chunk_size points at a "
+    "time in each iteration, and the assignments are written in a final pass "
+    "over the file.  This only supports the naive algorithm, random initial "
+    "centroids (or --initial_centroids), and empty clusters keep their "
+    "centroid (as with -e).  The output file must be a .csv or .txt file, and "
+    "--in_place is not supported."
+    "\n\n"
     "The behavior for when an empty cluster is encountered can be modified with"
     " the --allow_empty_clusters (-e) option.  When this option is specified "
     "and there is a cluster owning no points at the end of an iteration, that "
@@ -84,6 +116,15 @@ PARAM_STRING("initial_centroids", "Start with the specified initial centroids.",
              "I", "");
 
 // Parameters for "refined start" k-means.
+PARAM_FLAG("kmeans_plus_plus", "Use the k-means++ seeding to choose initial "
+    "points.", "K");
+PARAM_FLAG("kmeans_parallel", "Use the k-means|| seeding to choose initial "
+    "points.", "L");
+PARAM_DOUBLE("oversampling", "Expected number of candidates sampled in each "
+    "round of k-means||, as a multiple of the number of clusters (use when "
+    "--kmeans_parallel is specified).", "O", 2.0);
+PARAM_INT("rounds", "Number of sampling rounds of k-means|| (use when "
+    "--kmeans_parallel is specified).", "R", 5);
 PARAM_FLAG("refined_start", "Use the refined initial point strategy by Bradley "
     "and Fayyad to choose initial points.", "r");
 PARAM_INT("samplings", "Number of samplings to perform for refined start (use "
@@ -92,8 +133,18 @@ PARAM_DOUBLE("percentage", "Percentage of dataset to use for each refined start"
     " sampling (use when --refined_start is specified).", "p", 0.02);
 
 PARAM_STRING("algorithm", "Algorithm to use for the Lloyd iteration ('naive', "
-    "'pelleg-moore', 'elkan', 'hamerly', 'dualtree', or 'dualtree-covertree').",
+    "'pelleg-moore', 'elkan', 'hamerly', 'yinyang', 'dualtree', "
+    "'dualtree-covertree', or 'minibatch').",
     "a", "naive");
+PARAM_INT("groups", "Number of centroid groups of the 'yinyang' algorithm (if "
+    "0, the number of clusters divided by 10 is used).", "G", 0);
+PARAM_INT("batch_size", "Number of points sampled in each iteration of the "
+    "'minibatch' algorithm.", "b", 1000);
+PARAM_INT("chunk_size", "If positive, the input file is read this many points "
+    "at a time in each iteration instead of being loaded into memory.", "z", 0);
+
+// Run k-means on an input file that is read in chunks.
+void RunChunkedKMeans();
 
 // Given the type of initial partition policy, figure out the empty cluster
 // policy and run k-means.
@@ -111,6 +162,15 @@ template<typename InitialPartitionPolicy,
          template<class, class> class LloydStepType>
 void RunKMeans(const InitialPartitionPolicy& ipp);
 
+// Set the parameters of the Lloyd step from the command line.  Most steps have
+// none.
+template<typename LloydStep>
+void SetStepParameters(LloydStep& /* step */) { }
+void SetStepParameters(
+    MiniBatchKMeans<metric::EuclideanDistance, arma::mat>& step);
+void SetStepParameters(
+    YinyangKMeans<metric::EuclideanDistance, arma::mat>& step);
+
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
@@ -121,9 +181,35 @@ int main(int argc, char** argv)
   else
     math::RandomSeed((size_t) std::time(NULL));
 
+  // Check the batch size of mini-batch k-means.
+  const int batchSize = CLI::GetParam<int>("batch_size");
+  if (batchSize <= 0)
+    Log::Fatal << "Invalid batch size: " << batchSize << ".  Must be greater "
+        << "than 0." << endl;
+
+  // Check the number of groups of Yinyang k-means.
+  const int groups = CLI::GetParam<int>("groups");
+  if (groups < 0)
+    Log::Fatal << "Invalid number of groups: " << groups << ".  Must be "
+        << "non-negative." << endl;
+
+  if (CLI::GetParam<int>("chunk_size") < 0)
+    Log::Fatal << "Invalid chunk size: " << CLI::GetParam<int>("chunk_size")
+        << ".  Must be non-negative." << endl;
+  if (CLI::GetParam<int>("chunk_size") > 0)
+  {
+    RunChunkedKMeans();
+    return 0;
+  }
+
   // Now, start building the KMeans type that we'll be using.  Start with the
   // initial partition policy.  The call to FindEmptyClusterPolicy<> results in
   // a call to RunKMeans<> and the algorithm is completed.
+  if (CLI::HasParam("refined_start") + CLI::HasParam("kmeans_plus_plus") +
+      CLI::HasParam("kmeans_parallel") > 1)
+    Log::Fatal << "Only one of --refined_start (-r), --kmeans_plus_plus (-K), "
+        << "or --kmeans_parallel (-L) may be specified!" << endl;
+
   if (CLI::HasParam("refined_start"))
   {
     const int samplings = CLI::GetParam<int>("samplings");
@@ -138,12 +224,104 @@ int main(int argc, char** argv)
 
     FindEmptyClusterPolicy<RefinedStart>(RefinedStart(samplings, percentage));
   }
+  else if (CLI::HasParam("kmeans_plus_plus"))
+  {
+    FindEmptyClusterPolicy<KMeansPlusPlusInitialization>(
+        KMeansPlusPlusInitialization());
+  }
+  else if (CLI::HasParam("kmeans_parallel"))
+  {
+    const double oversampling = CLI::GetParam<double>("oversampling");
+    const int rounds = CLI::GetParam<int>("rounds");
+
+    if (oversampling <= 0.0)
+      Log::Fatal << "Oversampling factor (" << oversampling << ") must be "
+          << "greater than 0.0!" << endl;
+    if (rounds < 0)
+      Log::Fatal << "Number of rounds (" << rounds << ") must be "
+          << "non-negative!" << endl;
+
+    FindEmptyClusterPolicy<KMeansParallelInitialization>(
+        KMeansParallelInitialization(oversampling, (size_t) rounds));
+  }
   else
   {
     FindEmptyClusterPolicy<SampleInitialization>(SampleInitialization());
   }
 }
 
+// Run k-means on an input file that is read in chunks.
+void RunChunkedKMeans()
+{
+  if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+      CLI::HasParam("kmeans_parallel"))
+    Log::Fatal << "--refined_start, --kmeans_plus_plus, and --kmeans_parallel "
+        << "are not supported with --chunk_size (-z)!" << endl;
+  if (CLI::HasParam("in_place"))
+    Log::Fatal << "--in_place is not supported with --chunk_size (-z)!" << endl;
+  if (CLI::GetParam<string>("algorithm") != "naive")
+    Log::Fatal << "Only the 'naive' algorithm is supported with --chunk_size "
+        << "(-z)!" << endl;
+  if (CLI::HasParam("kill_empty_clusters"))
+    Log::Warn << "--kill_empty_clusters is ignored with --chunk_size (-z); "
+        << "empty clusters keep their centroid." << endl;
+
+  const string inputFile = CLI::GetParam<string>("input_file");
+  int clusters = CLI::GetParam<int>("clusters");
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+  if (clusters < 0)
+    Log::Fatal << "Invalid number of clusters requested (" << clusters << ")! "
+        << "Must be greater than or equal to 0." << endl;
+  if (maxIterations < 0)
+    Log::Fatal << "Invalid value for maximum iterations (" << maxIterations <<
+        ")! Must be greater than or equal to 0." << endl;
+
+  if (!CLI::HasParam("output_file") && !CLI::HasParam("centroid_file"))
+    Log::Warn << "--output_file and --centroid_file are not set; no results "
+        << "will be saved." << std::endl;
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  if (initialCentroidGuess)
+  {
+    data::Load(CLI::GetParam<string>("initial_centroids"), centroids, true);
+    if (clusters == 0)
+      clusters = centroids.n_cols;
+  }
+  else if (clusters == 0)
+  {
+    Log::Fatal << "Number of clusters requested is 0, and no initial centroids "
+        << "provided!" << endl;
+  }
+
+  // The input file is read (and the output file written) as the clustering
+  // goes, so a read or write error can happen at any pass; the initial
+  // centroids are also only checked against the file then.
+  ChunkedKMeans<> kmeans((size_t) CLI::GetParam<int>("chunk_size"),
+      (size_t) maxIterations);
+  try
+  {
+    Timer::Start("clustering");
+    kmeans.Cluster(inputFile, clusters, centroids, initialCentroidGuess);
+    Timer::Stop("clustering");
+
+    if (CLI::HasParam("output_file"))
+    {
+      Timer::Start("assignment");
+      kmeans.Assign(inputFile, centroids, CLI::GetParam<string>("output_file"),
+          CLI::HasParam("labels_only"));
+      Timer::Stop("assignment");
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+
+  if (CLI::HasParam("centroid_file"))
+    data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+}
+
 // Given the type of initial partition policy, figure out the empty cluster
 // policy and run k-means.
 template<typename InitialPartitionPolicy>
@@ -171,6 +349,8 @@ void FindLloydStepType(const InitialPartitionPolicy& ipp)
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, ElkanKMeans>(ipp);
   else if (algorithm == "hamerly")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, HamerlyKMeans>(ipp);
+  else if (algorithm == "yinyang")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, YinyangKMeans>(ipp);
   else if (algorithm == "pelleg-moore")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
         PellegMooreKMeans>(ipp);
@@ -182,10 +362,13 @@ void FindLloydStepType(const InitialPartitionPolicy& ipp)
         CoverTreeDualTreeKMeans>(ipp);
   else if (algorithm == "naive")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, NaiveKMeans>(ipp);
+  else if (algorithm == "minibatch")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        MiniBatchKMeans>(ipp);
   else
     Log::Fatal << "Unknown algorithm: '" << algorithm << "'.  Supported options"
-        << " are 'naive', 'pelleg-moore', 'elkan', 'hamerly', 'dualtree', and "
-        << "'dualtree-covertree'." << endl;
+        << " are 'naive', 'pelleg-moore', 'elkan', 'hamerly', 'yinyang', "
+        << "'dualtree', 'dualtree-covertree', and 'minibatch'." << endl;
 }
 
 // Given the template parameters, sanitize/load input and run k-means.
@@ -246,16 +429,23 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     if (CLI::HasParam("refined_start"))
       Log::Warn << "Initial centroids are specified, but will be ignored "
           << "because --refined_start is also specified!" << endl;
+    else if (CLI::HasParam("kmeans_plus_plus") ||
+             CLI::HasParam("kmeans_parallel"))
+      Log::Warn << "--kmeans_plus_plus and --kmeans_parallel are ignored "
+          << "because initial centroids are specified!" << endl;
     else
       Log::Info << "Using initial centroid guesses from '" <<
           initialCentroidsFile << "'." << endl;
   }
 
   Timer::Start("clustering");
-  KMeans<metric::EuclideanDistance,
-         InitialPartitionPolicy,
-         EmptyClusterPolicy,
-         LloydStepType> kmeans(maxIterations, metric::EuclideanDistance(), ipp);
+  typedef KMeans<metric::EuclideanDistance,
+                 InitialPartitionPolicy,
+                 EmptyClusterPolicy,
+                 LloydStepType> KMeansType;
+  KMeansType kmeans(maxIterations, metric::EuclideanDistance(), ipp);
+  kmeans.StepSetup() = [](typename KMeansType::LloydStep& step)
+      { SetStepParameters(step); };
 
   if (CLI::HasParam("output_file") || CLI::HasParam("in_place"))
   {
@@ -313,3 +503,17 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   if (CLI::HasParam("centroid_file"))
     data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
 }
+
+// Set the batch size of mini-batch k-means.
+void SetStepParameters(
+    MiniBatchKMeans<metric::EuclideanDistance, arma::mat>& step)
+{
+  step.BatchSize() = (size_t) CLI::GetParam<int>("batch_size");
+}
+
+// Set the number of groups of Yinyang k-means.
+void SetStepParameters(
+    YinyangKMeans<metric::EuclideanDistance, arma::mat>& step)
+{
+  step.NumGroups() = (size_t) CLI::GetParam<int>("groups");
+}
@@ -0,0 +1,111 @@
+/**
+ * @file kmeans_parallel_initialization.hpp
+ *
+ * An implementation of the scalable k-means|| seeding of Bahmani et al., which
+ * oversamples candidate centroids in a few passes over the dataset and then
+ * reclusters the candidates.
+ */
+#ifndef MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_HPP
+#define MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means|| initialization policy is a scalable variant of k-means++.
+ * Where k-means++ needs k sequential passes over the dataset, k-means|| only
+ * makes a few rounds: it starts with one point sampled uniformly, and in each
+ * round every point is independently added to the candidates with probability
+ * l * d(x)^2 / phi, where d(x) is the distance from x to its closest candidate,
+ * phi is the sum of d(x)^2 over the dataset, and l = oversampling * k.  Then
+ * each candidate is weighted by the number of points closest to it, and the
+ * weighted candidates (of which there are about rounds * l) are reclustered
+ * into k centroids with the weighted k-means++ seeding followed by a few
+ * weighted Lloyd iterations.  The distance computations of each round are done
+ * in parallel with OpenMP.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @article{bahmani2012scalable,
+ *   title={Scalable k-means++},
+ *   author={Bahmani, B. and Moseley, B. and Vattani, A. and Kumar, R. and
+ *       Vassilvitskii, S.},
+ *   journal={Proceedings of the VLDB Endowment},
+ *   volume={5},
+ *   number={7},
+ *   pages={622--633},
+ *   year={2012}
+ * }
+ * @endcode
+ */
+class KMeansParallelInitialization
+{
+ public:
+  /**
+   * Create the KMeansParallelInitialization object, optionally specifying the
+   * oversampling factor (the expected number of candidates sampled in each
+   * round, as a multiple of the number of clusters) and the number of rounds.
+   */
+  KMeansParallelInitialization(const double oversampling = 2.0,
+                               const size_t rounds = 5) :
+      oversampling(oversampling), rounds(rounds) { }
+
+  /**
+   * Initialize the centroids matrix with the k-means|| seeding.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset.
+   * @param clusters Number of clusters.
+   * @param centroids Matrix to put initial centroids into.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::mat& centroids) const;
+
+  //! Get the oversampling factor.
+  double Oversampling() const { return oversampling; }
+  //! Modify the oversampling factor.
+  double& Oversampling() { return oversampling; }
+  //! Get the number of sampling rounds.
+  size_t Rounds() const { return rounds; }
+  //! Modify the number of sampling rounds.
+  size_t& Rounds() { return rounds; }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(oversampling, "oversampling");
+    ar & data::CreateNVP(rounds, "rounds");
+  }
+
+ private:
+  /**
+   * Update the squared distance from each point to its closest candidate, and
+   * the index of that candidate, with the candidates starting at the given
+   * index.
+   */
+  template<typename MatType>
+  static void UpdateDistances(const MatType& data,
+                              const std::vector<size_t>& candidates,
+                              const size_t firstNew,
+                              arma::vec& distances,
+                              arma::Col<size_t>& closest);
+
+  //! The oversampling factor.
+  double oversampling;
+  //! The number of sampling rounds.
+  size_t rounds;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "kmeans_parallel_initialization_impl.hpp"
+
+#endif
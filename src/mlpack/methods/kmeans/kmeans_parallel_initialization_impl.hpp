@@ -0,0 +1,160 @@
+/**
+ * @file kmeans_parallel_initialization_impl.hpp
+ *
+ * Implementation of the k-means|| seeding.
+ */
+#ifndef MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_IMPL_HPP
+#define MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_parallel_initialization.hpp"
+
+#include "kmeans_plus_plus_initialization.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void KMeansParallelInitialization::Cluster(const MatType& data,
+                                           const size_t clusters,
+                                           arma::mat& centroids) const
+{
+  centroids.set_size(data.n_rows, clusters);
+  if (clusters == 0 || data.n_cols == 0)
+    return;
+
+  // Start with one point sampled uniformly.
+  std::vector<size_t> candidates;
+  candidates.push_back((size_t) math::RandInt(0, data.n_cols));
+
+  arma::vec distances(data.n_cols);
+  distances.fill(DBL_MAX);
+  arma::Col<size_t> closest(data.n_cols);
+  UpdateDistances(data, candidates, 0, distances, closest);
+
+  // Oversample the candidates.  The sampling itself is cheap next to the
+  // distance calculations, and is done serially so that the results only
+  // depend on the random seed.
+  const double expectedSamples = oversampling * clusters;
+  for (size_t r = 0; r < rounds; ++r)
+  {
+    const double cost = arma::accu(distances);
+    if (cost == 0.0)
+      break; // Every point is a candidate already.
+
+    const size_t firstNew = candidates.size();
+    for (size_t i = 0; i < data.n_cols; ++i)
+      if (math::Random() < expectedSamples * distances[i] / cost)
+        candidates.push_back(i);
+
+    UpdateDistances(data, candidates, firstNew, distances, closest);
+  }
+
+  // Weight each candidate by the number of points closest to it.
+  arma::mat candidatePoints(data.n_rows, candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i)
+    candidatePoints.col(i) = data.col(candidates[i]);
+  arma::vec weights(candidates.size(), arma::fill::zeros);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    weights[closest[i]] += 1.0;
+
+  Log::Info << "KMeansParallelInitialization::Cluster(): sampled "
+      << candidates.size() << " candidate centroids." << std::endl;
+
+  if (candidates.size() <= clusters)
+  {
+    // Not enough candidates to recluster; take all of them, and sample the
+    // rest of the centroids uniformly.
+    centroids.cols(0, candidates.size() - 1) = candidatePoints;
+    for (size_t c = candidates.size(); c < clusters; ++c)
+      centroids.col(c) = data.col(math::RandInt(0, data.n_cols));
+    return;
+  }
+
+  // Recluster the weighted candidates: seed with k-means++, and then run a few
+  // weighted Lloyd iterations (the candidates are few, so this is cheap).
+  KMeansPlusPlusInitialization::Cluster(candidatePoints, weights, clusters,
+      centroids);
+
+  const size_t maxLloydIterations = 30;
+  arma::Col<size_t> assignments(candidates.size());
+  assignments.fill(clusters);
+  for (size_t iteration = 0; iteration < maxLloydIterations; ++iteration)
+  {
+    bool changed = false;
+    for (size_t i = 0; i < candidatePoints.n_cols; ++i)
+    {
+      double minDistance = DBL_MAX;
+      size_t closestCluster = 0;
+      for (size_t c = 0; c < clusters; ++c)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            candidatePoints.col(i), centroids.col(c));
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestCluster = c;
+        }
+      }
+
+      if (assignments[i] != closestCluster)
+      {
+        assignments[i] = closestCluster;
+        changed = true;
+      }
+    }
+
+    if (!changed)
+      break;
+
+    // Empty clusters keep their centroid.
+    arma::mat sums(data.n_rows, clusters, arma::fill::zeros);
+    arma::vec totalWeights(clusters, arma::fill::zeros);
+    for (size_t i = 0; i < candidatePoints.n_cols; ++i)
+    {
+      sums.col(assignments[i]) += weights[i] * candidatePoints.col(i);
+      totalWeights[assignments[i]] += weights[i];
+    }
+
+    for (size_t c = 0; c < clusters; ++c)
+      if (totalWeights[c] > 0.0)
+        centroids.col(c) = sums.col(c) / totalWeights[c];
+  }
+}
+
+template<typename MatType>
+void KMeansParallelInitialization::UpdateDistances(
+    const MatType& data,
+    const std::vector<size_t>& candidates,
+    const size_t firstNew,
+    arma::vec& distances,
+    arma::Col<size_t>& closest)
+{
+  if (firstNew == candidates.size())
+    return;
+
+  // Copy the new candidates, so sparse columns aren't extracted repeatedly.
+  arma::mat newCandidates(data.n_rows, candidates.size() - firstNew);
+  for (size_t j = firstNew; j < candidates.size(); ++j)
+    newCandidates.col(j - firstNew) = data.col(candidates[j]);
+
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) data.n_cols; ++i)
+  {
+    for (size_t j = 0; j < newCandidates.n_cols; ++j)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), newCandidates.col(j));
+      if (distance < distances[i])
+      {
+        distances[i] = distance;
+        closest[i] = firstNew + j;
+      }
+    }
+  }
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file kmeans_plus_plus_initialization.hpp
+ *
+ * An implementation of the k-means++ seeding of Arthur and Vassilvitskii,
+ * which chooses initial centroids that are spread out over the dataset.
+ */
+#ifndef MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_INITIALIZATION_HPP
+#define MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_INITIALIZATION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means++ initialization policy picks the first centroid uniformly at
+ * random from the dataset, and then each next centroid is a point of the
+ * dataset sampled with probability proportional to its squared distance to the
+ * closest centroid chosen so far.  The seeding is O(log k)-competitive with the
+ * optimal clustering, and it usually needs far fewer Lloyd iterations than
+ * SampleInitialization.  The distances are updated in parallel with OpenMP.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{arthur2007k,
+ *   title={k-means++: The advantages of careful seeding},
+ *   author={Arthur, D. and Vassilvitskii, S.},
+ *   booktitle={Proceedings of the Eighteenth Annual ACM-SIAM Symposium on
+ *       Discrete Algorithms (SODA '07)},
+ *   pages={1027--1035},
+ *   year={2007}
+ * }
+ * @endcode
+ */
+class KMeansPlusPlusInitialization
+{
+ public:
+  //! Empty constructor, required by the InitialPartitionPolicy type definition.
+  KMeansPlusPlusInitialization() { }
+
+  /**
+   * Initialize the centroids matrix with the k-means++ seeding.
+   *
+   * @param data Dataset.
+   * @param clusters Number of clusters.
+   * @param centroids Matrix to put initial centroids into.
+   */
+  template<typename MatType>
+  inline static void Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::mat& centroids)
+  {
+    Cluster(data, arma::ones<arma::vec>(data.n_cols), clusters, centroids);
+  }
+
+  /**
+   * Initialize the centroids matrix with the k-means++ seeding of a weighted
+   * dataset, where each point counts as many times as its weight.  This is
+   * used by KMeansParallelInitialization to recluster its candidates.
+   *
+   * @param data Dataset.
+   * @param weights Non-negative weight of each point.
+   * @param clusters Number of clusters.
+   * @param centroids Matrix to put initial centroids into.
+   */
+  template<typename MatType>
+  inline static void Cluster(const MatType& data,
+                             const arma::vec& weights,
+                             const size_t clusters,
+                             arma::mat& centroids)
+  {
+    centroids.set_size(data.n_rows, clusters);
+    if (clusters == 0 || data.n_cols == 0)
+      return;
+
+    // The first centroid is sampled with probability proportional to the
+    // weight of each point.
+    centroids.col(0) = data.col(SampleIndex(weights));
+
+    arma::vec distances(data.n_cols);
+    distances.fill(DBL_MAX);
+    arma::vec probabilities(data.n_cols);
+    for (size_t c = 1; c < clusters; ++c)
+    {
+      // Update the squared distance from each point to its closest centroid.
+      #pragma omp parallel for
+      for (omp_size_t i = 0; i < (omp_size_t) data.n_cols; ++i)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            data.col(i), centroids.col(c - 1));
+        if (distance < distances[i])
+          distances[i] = distance;
+        probabilities[i] = weights[i] * distances[i];
+      }
+
+      // If every point is already a centroid, fall back to the weights.
+      if (arma::accu(probabilities) > 0.0)
+        centroids.col(c) = data.col(SampleIndex(probabilities));
+      else
+        centroids.col(c) = data.col(SampleIndex(weights));
+    }
+  }
+
+ private:
+  /**
+   * Sample an index with probability proportional to the given non-negative
+   * values.  If all values are zero, an index is sampled uniformly.
+   */
+  inline static size_t SampleIndex(const arma::vec& values)
+  {
+    const double total = arma::accu(values);
+    if (total <= 0.0)
+      return (size_t) math::RandInt(0, values.n_elem);
+
+    const double target = math::Random() * total;
+    double sum = 0.0;
+    for (size_t i = 0; i < values.n_elem; ++i)
+    {
+      sum += values[i];
+      if (target < sum)
+        return i;
+    }
+
+    // Rounding errors can leave us past the end; take the last nonzero value.
+    size_t i = values.n_elem - 1;
+    while (i > 0 && values[i] == 0.0)
+      --i;
+    return i;
+  }
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -11,12 +11,18 @@
 
 #include <mlpack/core.hpp>
 
+#include "accumulate_centroids.hpp"
+#include "centroid_distances.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
 /**
  * When an empty cluster is detected, this class takes the point furthest from
- * the centroid of the cluster with maximum variance as a new cluster.
+ * the centroid of the cluster with maximum variance as a new cluster.  Sparse
+ * datasets are never densified: the distances are computed with
+ * CentroidDistances, and the point is moved between the centroids with only its
+ * nonzero elements.
  */
 class MaxVarianceNewCluster
 {
@@ -28,7 +34,7 @@ class MaxVarianceNewCluster
    * Take the point furthest from the centroid of the cluster with maximum
    * variance to be a new cluster.
    *
-   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @tparam MatType Type of data (arma::mat, arma::fmat or arma::sp_mat).
    * @param data Dataset on which clustering is being performed.
    * @param emptyCluster Index of cluster which is empty.
    * @param oldCentroids Centroids of each cluster (one per column), at the
@@ -40,14 +40,16 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
     return 0;
 
   // Now, inside this cluster, find the point which is furthest away.
+  CentroidDistances<MetricType, MatType> distances(data, metric);
+  distances.Centroids(newCentroids);
   size_t furthestPoint = data.n_cols;
   double maxDistance = -DBL_MAX;
   for (size_t i = 0; i < data.n_cols; ++i)
   {
     if (assignments[i] == maxVarCluster)
     {
-      const double distance = std::pow(metric.Evaluate(data.col(i),
-          newCentroids.col(maxVarCluster)), 2.0);
+      const double distance = std::pow(distances.Evaluate(i, maxVarCluster),
+          2.0);
 
       if (distance > maxDistance)
       {
@@ -60,11 +62,12 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
   // Take that point and add it to the empty cluster.
   newCentroids.col(maxVarCluster) *= (double(clusterCounts[maxVarCluster]) /
       double(clusterCounts[maxVarCluster] - 1));
-  newCentroids.col(maxVarCluster) -= (1.0 / (clusterCounts[maxVarCluster] - 1.0)) *
-      arma::vec(data.col(furthestPoint));
+  AddPoint(data, furthestPoint, newCentroids, maxVarCluster,
+      -1.0 / (clusterCounts[maxVarCluster] - 1.0));
   clusterCounts[maxVarCluster]--;
   clusterCounts[emptyCluster]++;
-  newCentroids.col(emptyCluster) = arma::vec(data.col(furthestPoint));
+  newCentroids.col(emptyCluster).zeros();
+  AddPoint(data, furthestPoint, newCentroids, emptyCluster);
   assignments[furthestPoint] = emptyCluster;
 
   // Modify the variances, as necessary.
@@ -118,6 +121,8 @@ void MaxVarianceNewCluster::Precalculate(const MatType& data,
   // dataset.
   variances.zeros(oldCentroids.n_cols);
   assignments.set_size(data.n_cols);
+  CentroidDistances<MetricType, MatType> distances(data, metric);
+  distances.Centroids(oldCentroids);
 
   // Add the variance of each point's distance away from the cluster.  I think
   // this is the sensible thing to do.
@@ -129,7 +134,7 @@ void MaxVarianceNewCluster::Precalculate(const MatType& data,
 
     for (size_t j = 0; j < oldCentroids.n_cols; j++)
     {
-      const double distance = metric.Evaluate(data.col(i), oldCentroids.col(j));
+      const double distance = distances.Evaluate(i, j);
 
       if (distance < minDistance)
       {
@@ -139,8 +144,7 @@ void MaxVarianceNewCluster::Precalculate(const MatType& data,
     }
 
     assignments[i] = closestCluster;
-    variances[closestCluster] += std::pow(metric.Evaluate(data.col(i),
-        oldCentroids.col(closestCluster)), 2.0);
+    variances[closestCluster] += std::pow(minDistance, 2.0);
   }
 
   // Divide by the number of points in the cluster to produce the variance,
@@ -0,0 +1,124 @@
+/**
+ * @file mini_batch_kmeans.hpp
+ *
+ * An implementation of a mini-batch k-means step, which updates the centroids
+ * with a small random sample of the dataset in each iteration.
+ */
+#ifndef MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+#define MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+
+#include "centroid_distances.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * This is an implementation of the mini-batch k-means step of Sculley, for use
+ * as the LloydStepType of the KMeans class.  Instead of a full pass over the
+ * dataset, each iteration samples BatchSize() points uniformly at random (with
+ * replacement), assigns each of them to its closest centroid, and then moves
+ * each centroid towards its sampled points with a per-centroid learning rate of
+ * 1 / (number of points the centroid has been given so far).  An iteration
+ * therefore costs O(BatchSize() * k) distance calculations, whatever the size
+ * of the dataset, and the centroids converge to a good (but not exact) solution
+ * in far less time than with full Lloyd iterations on large datasets.
+ *
+ * The counts given by Iterate() are the total number of sampled points given
+ * to each centroid since the first iteration, so a cluster is only empty if no
+ * sampled point was ever assigned to it.  Since the MaxVarianceNewCluster
+ * policy makes a full pass over the dataset to fill an empty cluster,
+ * AllowEmptyClusters is usually a better choice with this step on very large
+ * datasets.
+ *
+ * The batch size of the step created by a KMeans object can be set with
+ * KMeans::StepSetup():
+ *
+ * @code
+ * typedef KMeans<metric::EuclideanDistance, SampleInitialization,
+ *     AllowEmptyClusters, MiniBatchKMeans> KMeansType;
+ * KMeansType k;
+ * k.StepSetup() = [](KMeansType::LloydStep& step)
+ *     { step.BatchSize() = 5000; };
+ * k.Cluster(dataset, clusters, centroids);
+ * @endcode
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{sculley2010web,
+ *   title={Web-scale k-means clustering},
+ *   author={Sculley, D.},
+ *   booktitle={Proceedings of the 19th International Conference on World Wide
+ *       Web (WWW '10)},
+ *   pages={1177--1178},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * The dataset may be dense or sparse, of any element type (such as arma::fmat);
+ * see CentroidDistances for how the distances are computed.  Sparse sampled
+ * points are added to the centroids without being densified.
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat, arma::fmat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class MiniBatchKMeans
+{
+ public:
+  /**
+   * Construct the MiniBatchKMeans object with the given dataset and metric.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   * @param batchSize Number of points sampled in each iteration.
+   */
+  MiniBatchKMeans(const MatType& dataset,
+                  MetricType& metric,
+                  const size_t batchSize = 1000);
+
+  /**
+   * Run a single mini-batch iteration, updating the given centroids into the
+   * newCentroids matrix.  Centroids that are not given any sampled point in
+   * this iteration are not changed.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Total number of sampled points given to each cluster so far.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+  //! Get the number of points sampled in each iteration (default 1000).
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points sampled in each iteration.
+  size_t& BatchSize() { return batchSize; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+  //! The distances between the points and the centroids.
+  CentroidDistances<MetricType, MatType> distances;
+
+  //! The number of sampled points given to each centroid so far.
+  arma::Col<size_t> centroidCounts;
+
+  //! Number of points sampled in each iteration.
+  size_t batchSize;
+
+  //! Number of distance calculations.
+  size_t distanceCalculations;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "mini_batch_kmeans_impl.hpp"
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file mini_batch_kmeans_impl.hpp
+ *
+ * Implementation of the mini-batch k-means step.
+ */
+#ifndef MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+#define MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mini_batch_kmeans.hpp"
+
+#include "accumulate_centroids.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+MiniBatchKMeans<MetricType, MatType>::MiniBatchKMeans(const MatType& dataset,
+                                                      MetricType& metric,
+                                                      const size_t batchSize) :
+    dataset(dataset),
+    metric(metric),
+    distances(dataset, metric),
+    batchSize(batchSize),
+    distanceCalculations(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename MatType>
+double MiniBatchKMeans<MetricType, MatType>::Iterate(
+    const arma::mat& centroids,
+    arma::mat& newCentroids,
+    arma::Col<size_t>& counts)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("MiniBatchKMeans::Iterate(): batch size must "
+        "be greater than 0");
+
+  // If this is the first iteration, no centroid has been given any points yet.
+  if (centroidCounts.n_elem != centroids.n_cols)
+    centroidCounts.zeros(centroids.n_cols);
+
+  // Sample the batch.  (math::RandInt() is not used because it can't handle
+  // more than INT_MAX points.)
+  arma::Col<size_t> batch(batchSize);
+  for (size_t i = 0; i < batch.n_elem; ++i)
+    batch[i] = std::min((size_t) (math::Random() * dataset.n_cols),
+        (size_t) dataset.n_cols - 1);
+
+  // Find the closest centroid to each sampled point, in parallel.
+  distances.Centroids(centroids);
+  arma::Col<size_t> batchAssignments(batch.n_elem);
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) batch.n_elem; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      const double distance = distances.Evaluate(batch[i], j);
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    Log::Assert(closestCluster != centroids.n_cols);
+    batchAssignments[i] = closestCluster;
+  }
+  distanceCalculations += batch.n_elem * centroids.n_cols;
+
+  // Now take a gradient step for each sampled point, with a learning rate that
+  // decreases with the number of points the centroid has been given.
+  newCentroids = centroids;
+  for (size_t i = 0; i < batch.n_elem; ++i)
+  {
+    const size_t c = batchAssignments[i];
+    const double eta = 1.0 / (double) (++centroidCounts[c]);
+    newCentroids.col(c) *= (1.0 - eta);
+    AddPoint(dataset, batch[i], newCentroids, c, eta);
+  }
+
+  counts = centroidCounts;
+
+  // Calculate cluster distortion for this iteration.
+  double cNorm = 0.0;
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+  {
+    cNorm += std::pow(metric.Evaluate(centroids.col(i), newCentroids.col(i)),
+        2.0);
+  }
+  distanceCalculations += centroids.n_cols;
+
+  return std::sqrt(cNorm);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
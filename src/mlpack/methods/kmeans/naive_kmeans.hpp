@@ -9,6 +9,8 @@
 #ifndef MLPACK_METHODS_KMEANS_NAIVE_KMEANS_HPP
 #define MLPACK_METHODS_KMEANS_NAIVE_KMEANS_HPP
 
+#include "centroid_distances.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -18,8 +20,11 @@ namespace kmeans {
  * looking for the mlpack::kmeans::KMeans class instead of this one.  This class
  * is used by KMeans as the actual implementation of the Lloyd iteration.
  *
+ * The dataset may be dense or sparse, of any element type (such as arma::fmat);
+ * see CentroidDistances for how the distances are computed.
+ *
  * @param MetricType Type of metric used with this implementation.
- * @param MatType Matrix type (arma::mat or arma::sp_mat).
+ * @param MatType Matrix type (arma::mat, arma::fmat or arma::sp_mat).
  */
 template<typename MetricType, typename MatType>
 class NaiveKMeans
@@ -54,6 +59,8 @@ class NaiveKMeans
   const MatType& dataset;
   //! The instantiated metric.
   MetricType& metric;
+  //! The distances between the points and the centroids.
+  CentroidDistances<MetricType, MatType> distances;
 
   //! Number of distance calculations.
   size_t distanceCalculations;
@@ -12,6 +12,8 @@
 // In case it hasn't been included yet.
 #include "naive_kmeans.hpp"
 
+#include "accumulate_centroids.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -20,6 +22,7 @@ NaiveKMeans<MetricType, MatType>::NaiveKMeans(const MatType& dataset,
                                               MetricType& metric) :
     dataset(dataset),
     metric(metric),
+    distances(dataset, metric),
     distanceCalculations(0)
 { /* Nothing to do. */ }
 
@@ -29,11 +32,11 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
                                                  arma::mat& newCentroids,
                                                  arma::Col<size_t>& counts)
 {
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
-  // Find the closest centroid to each point and update the new centroids.
-  for (size_t i = 0; i < dataset.n_cols; i++)
+  // Find the closest centroid to each point, in parallel.
+  distances.Centroids(centroids);
+  arma::Col<size_t> assignments(dataset.n_cols);
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; i++)
   {
     // Find the closest centroid to this point.
     double minDistance = std::numeric_limits<double>::infinity();
@@ -41,7 +44,7 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
 
     for (size_t j = 0; j < centroids.n_cols; j++)
     {
-      const double distance = metric.Evaluate(dataset.col(i), centroids.col(j));
+      const double distance = distances.Evaluate(i, j);
 
       if (distance < minDistance)
       {
@@ -51,12 +54,14 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
 
     Log::Assert(closestCluster != centroids.n_cols);
-
-    // We now have the minimum distance centroid index.  Update that centroid.
-    newCentroids.col(closestCluster) += arma::vec(dataset.col(i));
-    counts(closestCluster)++;
+    assignments[i] = closestCluster;
   }
 
+  // We now have the minimum distance centroid index of each point.  Update the
+  // centroids.
+  AccumulateCentroids(dataset, assignments, centroids.n_cols, newCentroids,
+      counts);
+
   // Now normalize the centroid.
   for (size_t i = 0; i < centroids.n_cols; ++i)
     if (counts(i) != 0)
@@ -21,42 +21,68 @@ void RefinedStart::Cluster(const MatType& data,
                            const size_t clusters,
                            arma::mat& centroids) const
 {
-  // This will hold the sampled datasets.
   const size_t numPoints = size_t(percentage * data.n_cols);
-  MatType sampledData(data.n_rows, numPoints);
-  // vector<bool> is packed so each bool is 1 bit.
-  std::vector<bool> pointsUsed(data.n_cols, false);
   arma::mat sampledCentroids(data.n_rows, samplings * clusters);
+  std::vector<std::exception_ptr> errors(samplings);
 
-  for (size_t i = 0; i < samplings; ++i)
+  // The samplings are independent, so they run in parallel.  Each one draws
+  // its random numbers from its own stream, so the sampled centroids don't
+  // depend on the number of threads; the generator of the thread is left
+  // alone.
+  const math::RandomStreams streams;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t i = 0; i < (omp_size_t) samplings; ++i)
   {
-    // First, assemble the sampled dataset.
-    size_t curSample = 0;
-    while (curSample < numPoints)
-    {
-      // Pick a random point in [0, numPoints).
-      size_t sample = (size_t) math::RandInt(data.n_cols);
+    std::mt19937 generator = streams.Stream(i);
+    const math::RandomGeneratorScope randomScope(generator);
 
-      if (!pointsUsed[sample])
+    // Exceptions can't leave the parallel loop; the first one is rethrown
+    // afterwards.
+    try
+    {
+      // First, assemble the sampled dataset.
+      MatType sampledData(data.n_rows, numPoints);
+      // vector<bool> is packed so each bool is 1 bit.
+      std::vector<bool> pointsUsed(data.n_cols, false);
+      size_t curSample = 0;
+      while (curSample < numPoints)
       {
-        // This point isn't used yet.  So we'll put it in our sample.
-        pointsUsed[sample] = true;
-        sampledData.col(curSample) = data.col(sample);
-        ++curSample;
+        // Pick a random point in [0, numPoints).
+        size_t sample = (size_t) math::RandInt(data.n_cols);
+
+        if (!pointsUsed[sample])
+        {
+          // This point isn't used yet.  So we'll put it in our sample.
+          pointsUsed[sample] = true;
+          sampledData.col(curSample) = data.col(sample);
+          ++curSample;
+        }
       }
-    }
-
-    // Now, using the sampled dataset, run k-means.  In the case of an empty
-    // cluster, we re-initialize that cluster as the point furthest away from
-    // the cluster with maximum variance.  This is not *exactly* what the paper
-    // implements, but it is quite similar, and we'll call it "good enough".
-    KMeans<> kmeans;
-    kmeans.Cluster(sampledData, clusters, centroids);
 
-    // Store the sampled centroids.
-    sampledCentroids.cols(i * clusters, (i + 1) * clusters - 1) = centroids;
+      // Now, using the sampled dataset, run k-means.  In the case of an empty
+      // cluster, we re-initialize that cluster as the point furthest away from
+      // the cluster with maximum variance.  This is not *exactly* what the
+      // paper implements, but it is quite similar, and we'll call it "good
+      // enough".
+      KMeans<> kmeans;
+      arma::mat sampleCentroids;
+      kmeans.Cluster(sampledData, clusters, sampleCentroids);
+
+      // Store the sampled centroids.
+      sampledCentroids.cols(i * clusters, (i + 1) * clusters - 1) =
+          sampleCentroids;
+    }
+    catch (...)
+    {
+      errors[i] = std::current_exception();
+    }
+  }
 
-    pointsUsed.assign(data.n_cols, false);
+  for (size_t i = 0; i < samplings; ++i)
+  {
+    if (errors[i])
+      std::rethrow_exception(errors[i]);
   }
 
   // Now, we run k-means on the sampled centroids to get our final clusters.
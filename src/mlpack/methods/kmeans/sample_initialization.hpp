@@ -11,6 +11,8 @@
 
 #include <mlpack/core.hpp>
 
+#include "accumulate_centroids.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -33,12 +35,12 @@ class SampleInitialization
                              const size_t clusters,
                              arma::mat& centroids)
   {
-    centroids.set_size(data.n_rows, clusters);
+    centroids.zeros(data.n_rows, clusters);
     for (size_t i = 0; i < clusters; ++i)
     {
       // Randomly sample a point.
       const size_t index = math::RandInt(0, data.n_cols);
-      centroids.col(i) = data.col(index);
+      AddPoint(data, index, centroids, i);
     }
   }
 };
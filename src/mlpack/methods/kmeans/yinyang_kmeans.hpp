@@ -0,0 +1,127 @@
+/**
+ * @file yinyang_kmeans.hpp
+ *
+ * An implementation of Yinyang k-means, which keeps one lower bound per group
+ * of centroids for each point.
+ */
+#ifndef MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+#define MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of the Yinyang k-means algorithm of Ding et al. for exact
+ * Lloyd iterations.  Before the first iteration, the centroids are split into
+ * groups by clustering the centroids themselves.  Each point then keeps an
+ * upper bound on the distance to its centroid, and one lower bound on the
+ * distance to the centroids of each group (excluding its own centroid).  After
+ * each iteration, the bounds are loosened by how far the centroids (or the
+ * furthest-moving centroid of each group) moved.
+ *
+ * A point is skipped entirely if its upper bound is below all its group lower
+ * bounds, and otherwise only the groups whose lower bound is below the upper
+ * bound are searched.  This gives most of the pruning of ElkanKMeans, which
+ * keeps k bounds per point, with only NumGroups() bounds per point, and prunes
+ * much better than HamerlyKMeans for large k.
+ *
+ * The number of groups of the step created by a KMeans object can be set with
+ * KMeans::StepSetup().  If it is 0 (the default), k / 10 groups are used, as
+ * suggested by the authors.
+ *
+ * @code
+ * typedef KMeans<metric::EuclideanDistance, SampleInitialization,
+ *     MaxVarianceNewCluster, YinyangKMeans> KMeansType;
+ * KMeansType k;
+ * k.StepSetup() = [](KMeansType::LloydStep& step) { step.NumGroups() = 20; };
+ * k.Cluster(dataset, clusters, centroids);
+ * @endcode
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{ding2015yinyang,
+ *   title={Yinyang k-means: A drop-in replacement of the classic k-means with
+ *       consistent speedup},
+ *   author={Ding, Y. and Zhao, Y. and Shen, X. and Musuvathi, M. and
+ *       Mytkowicz, T.},
+ *   booktitle={Proceedings of the 32nd International Conference on Machine
+ *       Learning (ICML '15)},
+ *   pages={579--587},
+ *   year={2015}
+ * }
+ * @endcode
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class YinyangKMeans
+{
+ public:
+  /**
+   * Construct the YinyangKMeans object, which must store the bounds of each
+   * point.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   * @param numGroups Number of centroid groups (0 means k / 10).
+   */
+  YinyangKMeans(const MatType& dataset,
+                MetricType& metric,
+                const size_t numGroups = 0);
+
+  /**
+   * Run a single iteration of Yinyang k-means, updating the given centroids
+   * into the newCentroids matrix.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Current counts, to be overwritten with new counts.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+  //! Get the number of centroid groups (0 means k / 10).
+  size_t NumGroups() const { return numGroups; }
+  //! Modify the number of centroid groups (0 means k / 10).
+  size_t& NumGroups() { return numGroups; }
+
+ private:
+  //! Split the centroids into groups with a few Lloyd iterations on them.
+  void GroupCentroids(const arma::mat& centroids);
+
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The number of centroid groups (0 means k / 10).
+  size_t numGroups;
+
+  //! The centroids of each group.
+  std::vector<std::vector<size_t>> groups;
+  //! The group of each centroid.
+  arma::Col<size_t> centroidGroups;
+
+  //! Upper bounds for each point.
+  arma::vec upperBounds;
+  //! Lower bounds for each group (rows) and each point (columns).
+  arma::mat lowerBounds;
+  //! Assignments for each point.
+  arma::Col<size_t> assignments;
+
+  //! Track distance calculations.
+  size_t distanceCalculations;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "yinyang_kmeans_impl.hpp"
+
+#endif
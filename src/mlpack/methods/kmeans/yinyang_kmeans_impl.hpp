@@ -0,0 +1,252 @@
+/**
+ * @file yinyang_kmeans_impl.hpp
+ *
+ * Implementation of Yinyang k-means.
+ */
+#ifndef MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+#define MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "yinyang_kmeans.hpp"
+
+#include "accumulate_centroids.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+YinyangKMeans<MetricType, MatType>::YinyangKMeans(const MatType& dataset,
+                                                  MetricType& metric,
+                                                  const size_t numGroups) :
+    dataset(dataset),
+    metric(metric),
+    numGroups(numGroups),
+    distanceCalculations(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename MatType>
+double YinyangKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
+                                                   arma::mat& newCentroids,
+                                                   arma::Col<size_t>& counts)
+{
+  // If this is the first iteration, we need to group the centroids and set all
+  // the bounds.  Bounds of zero force the distances to every centroid to be
+  // computed.
+  if (centroidGroups.n_elem != centroids.n_cols ||
+      assignments.n_elem != dataset.n_cols)
+  {
+    GroupCentroids(centroids);
+    upperBounds.set_size(dataset.n_cols);
+    upperBounds.fill(DBL_MAX);
+    lowerBounds.zeros(groups.size(), dataset.n_cols);
+    assignments.zeros(dataset.n_cols);
+  }
+
+  const size_t groupCount = groups.size();
+  size_t globalPruned = 0;
+  size_t pointDistances = 0;
+  #pragma omp parallel
+  {
+    // The closest and second closest centroids of each searched group.
+    std::vector<double> groupMin(groupCount);
+    std::vector<double> groupSecondMin(groupCount);
+    std::vector<size_t> groupMinIndex(groupCount);
+    std::vector<bool> searched(groupCount);
+
+    #pragma omp for reduction(+:globalPruned, pointDistances)
+    for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; ++i)
+    {
+      // Global filter: if the upper bound is below every group lower bound, the
+      // assignment can't change.
+      const double globalLowerBound = lowerBounds.unsafe_col(i).min();
+      if (upperBounds(i) <= globalLowerBound)
+      {
+        ++globalPruned;
+        continue;
+      }
+
+      // Tighten the upper bound and try again.
+      const size_t oldAssignment = assignments[i];
+      const double oldDistance = metric.Evaluate(dataset.col(i),
+          centroids.col(oldAssignment));
+      ++pointDistances;
+      upperBounds(i) = oldDistance;
+      if (oldDistance <= globalLowerBound)
+      {
+        ++globalPruned;
+        continue;
+      }
+
+      // Group filter: only search the groups whose lower bound is below the
+      // distance to the best centroid found so far.  The old centroid is left
+      // out of the searches, since its distance is known.
+      size_t best = oldAssignment;
+      double bestDistance = oldDistance;
+      for (size_t g = 0; g < groupCount; ++g)
+      {
+        searched[g] = (lowerBounds(g, i) < bestDistance);
+        if (!searched[g])
+          continue;
+
+        groupMin[g] = DBL_MAX;
+        groupSecondMin[g] = DBL_MAX;
+        groupMinIndex[g] = centroids.n_cols;
+        for (size_t j = 0; j < groups[g].size(); ++j)
+        {
+          const size_t c = groups[g][j];
+          if (c == oldAssignment)
+            continue;
+
+          const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+          ++pointDistances;
+          if (dist < groupMin[g])
+          {
+            groupSecondMin[g] = groupMin[g];
+            groupMin[g] = dist;
+            groupMinIndex[g] = c;
+          }
+          else if (dist < groupSecondMin[g])
+          {
+            groupSecondMin[g] = dist;
+          }
+        }
+
+        if (groupMin[g] < bestDistance)
+        {
+          bestDistance = groupMin[g];
+          best = groupMinIndex[g];
+        }
+      }
+
+      // The new lower bound of each searched group is its closest centroid,
+      // unless that is the new assignment.  If the assignment changed, the old
+      // centroid now counts towards the bound of its group.
+      for (size_t g = 0; g < groupCount; ++g)
+        if (searched[g])
+          lowerBounds(g, i) = (groupMinIndex[g] == best) ? groupSecondMin[g] :
+              groupMin[g];
+      if (best != oldAssignment)
+      {
+        const size_t oldGroup = centroidGroups[oldAssignment];
+        lowerBounds(oldGroup, i) = std::min(lowerBounds(oldGroup, i),
+            oldDistance);
+      }
+
+      upperBounds(i) = bestDistance;
+      assignments[i] = best;
+    }
+  }
+  distanceCalculations += pointDistances;
+
+  AccumulateCentroids(dataset, assignments, centroids.n_cols, newCentroids,
+      counts);
+
+  // Normalize centroids and calculate the movement of each centroid and the
+  // largest movement in each group.
+  arma::vec centroidMovements(centroids.n_cols);
+  arma::vec groupMovements(groupCount, arma::fill::zeros);
+  double centroidMovement = 0.0;
+  for (size_t c = 0; c < centroids.n_cols; ++c)
+  {
+    if (counts(c) > 0)
+      newCentroids.col(c) /= counts(c);
+
+    const double movement = metric.Evaluate(centroids.col(c),
+                                            newCentroids.col(c));
+    centroidMovements(c) = movement;
+    centroidMovement += std::pow(movement, 2.0);
+    ++distanceCalculations;
+
+    if (movement > groupMovements(centroidGroups[c]))
+      groupMovements(centroidGroups[c]) = movement;
+  }
+
+  // Now update the bounds.
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; ++i)
+  {
+    upperBounds(i) += centroidMovements(assignments[i]);
+    for (size_t g = 0; g < groupCount; ++g)
+      lowerBounds(g, i) = std::max(lowerBounds(g, i) - groupMovements(g), 0.0);
+  }
+
+  Log::Info << "Yinyang global prunes: " << globalPruned << ".\n";
+
+  return std::sqrt(centroidMovement);
+}
+
+template<typename MetricType, typename MatType>
+void YinyangKMeans<MetricType, MatType>::GroupCentroids(
+    const arma::mat& centroids)
+{
+  const size_t k = centroids.n_cols;
+  size_t groupCount = numGroups;
+  if (groupCount == 0)
+    groupCount = std::max(k / 10, (size_t) 1);
+  groupCount = std::min(groupCount, k);
+
+  // Seed the groups with evenly spaced centroids, and then run a few Lloyd
+  // iterations on the centroids, as in the paper.
+  arma::mat groupCenters(centroids.n_rows, groupCount);
+  for (size_t g = 0; g < groupCount; ++g)
+    groupCenters.col(g) = centroids.col(g * k / groupCount);
+
+  centroidGroups.zeros(k);
+  for (size_t iteration = 0; iteration < 5; ++iteration)
+  {
+    for (size_t c = 0; c < k; ++c)
+    {
+      double minDistance = DBL_MAX;
+      for (size_t g = 0; g < groupCount; ++g)
+      {
+        const double dist = metric.Evaluate(centroids.col(c),
+            groupCenters.col(g));
+        ++distanceCalculations;
+        if (dist < minDistance)
+        {
+          minDistance = dist;
+          centroidGroups[c] = g;
+        }
+      }
+    }
+
+    // Empty groups keep their center.
+    arma::mat sums(centroids.n_rows, groupCount, arma::fill::zeros);
+    arma::Col<size_t> groupCounts(groupCount, arma::fill::zeros);
+    for (size_t c = 0; c < k; ++c)
+    {
+      sums.col(centroidGroups[c]) += centroids.col(c);
+      ++groupCounts[centroidGroups[c]];
+    }
+
+    for (size_t g = 0; g < groupCount; ++g)
+      if (groupCounts[g] > 0)
+        groupCenters.col(g) = sums.col(g) / groupCounts[g];
+  }
+
+  // Collect the members of each group, leaving out empty groups.
+  std::vector<std::vector<size_t>> members(groupCount);
+  for (size_t c = 0; c < k; ++c)
+    members[centroidGroups[c]].push_back(c);
+
+  groups.clear();
+  for (size_t g = 0; g < groupCount; ++g)
+  {
+    if (members[g].empty())
+      continue;
+
+    for (size_t j = 0; j < members[g].size(); ++j)
+      centroidGroups[members[g][j]] = groups.size();
+    groups.push_back(members[g]);
+  }
+
+  Log::Info << "YinyangKMeans: split " << k << " centroids into "
+      << groups.size() << " groups." << std::endl;
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -19,7 +19,8 @@ LARS::LARS(const bool useCholesky,
     lambda1(lambda1),
     elasticNet((lambda1 != 0) && (lambda2 != 0)),
     lambda2(lambda2),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    maxActiveSize(0)
 { /* Nothing left to do. */ }
 
 LARS::LARS(const bool useCholesky,
@@ -33,13 +34,31 @@ LARS::LARS(const bool useCholesky,
     lambda1(lambda1),
     elasticNet((lambda1 != 0) && (lambda2 != 0)),
     lambda2(lambda2),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    maxActiveSize(0)
 { /* Nothing left to do */ }
 
 void LARS::Train(const arma::mat& matX,
                  const arma::vec& y,
                  arma::vec& beta,
                  const bool transposeData)
+{
+  TrainInternal(matX, y, beta, transposeData);
+}
+
+void LARS::Train(const arma::sp_mat& matX,
+                 const arma::vec& y,
+                 arma::vec& beta,
+                 const bool transposeData)
+{
+  TrainInternal(matX, y, beta, transposeData);
+}
+
+template<typename MatType>
+void LARS::TrainInternal(const MatType& matX,
+                         const arma::vec& y,
+                         arma::vec& beta,
+                         const bool transposeData)
 {
   Timer::Start("lars_regression");
 
@@ -53,14 +72,14 @@ void LARS::Train(const arma::mat& matX,
   matUtriCholFactor.reset();
 
   // This matrix may end up holding the transpose -- if necessary.
-  arma::mat dataTrans;
+  MatType dataTrans;
   // dataRef is row-major.
-  const arma::mat& dataRef = (transposeData ? dataTrans : matX);
+  const MatType& dataRef = (transposeData ? dataTrans : matX);
   if (transposeData)
     dataTrans = trans(matX);
 
   // Compute X' * y.
-  arma::vec vecXTy = trans(dataRef) * y;
+  arma::vec vecXTy = arma::trans(arma::trans(y) * dataRef);
 
   // Set up active set variables.  In the beginning, the active set has size 0
   // (all dimensions are inactive).
@@ -100,15 +119,28 @@ void LARS::Train(const arma::mat& matX,
     return;
   }
 
-  // Compute the Gram matrix.  If this is the elastic net problem, we will add
-  // lambda2 * I_n to the matrix.
-  if (matGram->n_elem != dataRef.n_cols * dataRef.n_cols)
+  // Compute the Gram matrix, unless one was given.  If this is the elastic net
+  // problem, we will add lambda2 * I_n to the matrix.  With Cholesky
+  // decomposition, the entries of the Gram matrix are computed when they are
+  // needed instead, so the full Gram matrix is never stored.
+  if (matGram == &matGramInternal)
   {
-    // In this case, matGram should reference matGramInternal.
-    matGramInternal = trans(dataRef) * dataRef;
-
-    if (elasticNet && !useCholesky)
-      matGramInternal += lambda2 * arma::eye(dataRef.n_cols, dataRef.n_cols);
+    if (useCholesky)
+    {
+      matGramInternal.reset();
+    }
+    else
+    {
+      ComputeGram(dataRef);
+      if (elasticNet)
+        matGramInternal.diag() += lambda2;
+    }
+  }
+  else if (matGram->n_elem != dataRef.n_cols * dataRef.n_cols)
+  {
+    Log::Fatal << "LARS::Train(): the given Gram matrix has size "
+        << matGram->n_rows << "x" << matGram->n_cols << ", but the data has "
+        << dataRef.n_cols << " dimensions!" << std::endl;
   }
 
   // Main loop.
@@ -126,20 +158,19 @@ void LARS::Train(const arma::mat& matX,
       }
     }
 
+    // Stop before the active set grows beyond its maximum size.
+    if (!lassocond && maxActiveSize != 0 && activeSet.size() >= maxActiveSize)
+      break;
+
     if (!lassocond)
     {
       if (useCholesky)
       {
-        // vec newGramCol = vec(activeSet.size());
-        // for (size_t i = 0; i < activeSet.size(); i++)
-        // {
-        //   newGramCol[i] = dot(matX.col(activeSet[i]), matX.col(changeInd));
-        // }
-        // This is equivalent to the above 5 lines.
-        arma::vec newGramCol = matGram->elem(changeInd * dataRef.n_cols +
-            arma::conv_to<arma::uvec>::from(activeSet));
-
-        CholeskyInsert((*matGram)(changeInd, changeInd), newGramCol);
+        arma::vec newGramCol;
+        double sqNorm;
+        GramColumn(dataRef, changeInd, newGramCol, sqNorm);
+
+        CholeskyInsert(sqNorm, newGramCol);
       }
 
       // Add variable to active set.
@@ -147,9 +178,10 @@ void LARS::Train(const arma::mat& matX,
     }
 
     // Compute signs of correlations.
-    arma::vec s = arma::vec(activeSet.size());
-    for (size_t i = 0; i < activeSet.size(); i++)
-      s(i) = corr(activeSet[i]) / fabs(corr(activeSet[i]));
+    const arma::uvec activeIndices = arma::conv_to<arma::uvec>::from(
+        activeSet);
+    arma::vec s = corr.elem(activeIndices) / arma::abs(corr.elem(
+        activeIndices));
 
     // Compute the "equiangular" direction in parameter space (betaDirection).
     // We use quotes because in the case of non-unit norm variables, this need
@@ -197,15 +229,12 @@ void LARS::Train(const arma::mat& matX,
     }
     else
     {
-      arma::mat matGramActive = arma::mat(activeSet.size(), activeSet.size());
-      for (size_t i = 0; i < activeSet.size(); i++)
-        for (size_t j = 0; j < activeSet.size(); j++)
-          matGramActive(i, j) = (*matGram)(activeSet[i], activeSet[j]);
+      const arma::mat matGramActive = matGram->submat(activeIndices,
+          activeIndices);
 
       // Check for singularity.
-      arma::mat matS = s * arma::ones<arma::mat>(1, activeSet.size());
       const bool solvedOk = solve(unnormalizedBetaDirection,
-          matGramActive % trans(matS) % matS,
+          matGramActive % (s * trans(s)),
           arma::ones<arma::mat>(activeSet.size(), 1));
       if (solvedOk)
       {
@@ -234,13 +263,15 @@ void LARS::Train(const arma::mat& matX,
     // If not all variables are active.
     if ((activeSet.size() + ignoreSet.size()) < dataRef.n_cols)
     {
-      // Compute correlations with direction.
+      // Compute correlations with direction, all with one product.
+      const arma::vec dirCorrs = arma::trans(arma::trans(yHatDirection) *
+          dataRef);
       for (size_t ind = 0; ind < dataRef.n_cols; ind++)
       {
         if (isActive[ind] || isIgnored[ind])
           continue;
 
-        double dirCorr = dot(dataRef.col(ind), yHatDirection);
+        const double dirCorr = dirCorrs[ind];
         double val1 = (maxCorr - corr(ind)) / (normalization - dirCorr);
         double val2 = (maxCorr + corr(ind)) / (normalization + dirCorr);
         if ((val1 > 0) && (val1 < gamma))
@@ -279,10 +310,7 @@ void LARS::Train(const arma::mat& matX,
     yHat += gamma * yHatDirection;
 
     // Update the estimator.
-    for (size_t i = 0; i < activeSet.size(); i++)
-    {
-      beta(activeSet[i]) += gamma * betaDirection(i);
-    }
+    beta.elem(activeIndices) += gamma * betaDirection;
 
     // Sanity check to make sure the kicked out dimension is actually zero.
     if (lassocond)
@@ -302,7 +330,7 @@ void LARS::Train(const arma::mat& matX,
       Deactivate(changeInd);
     }
 
-    corr = vecXTy - trans(dataRef) * yHat;
+    corr = vecXTy - arma::trans(arma::trans(yHat) * dataRef);
     if (elasticNet)
       corr -= lambda2 * beta;
 
@@ -342,6 +370,16 @@ void LARS::Predict(const arma::mat& points,
     predictions = (betaPath.back().t() * points).t();
 }
 
+void LARS::Predict(const arma::sp_mat& points,
+                   arma::vec& predictions,
+                   const bool rowMajor) const
+{
+  if (rowMajor)
+    predictions = points * betaPath.back();
+  else
+    predictions = (betaPath.back().t() * points).t();
+}
+
 // Private functions.
 void LARS::Deactivate(const size_t activeVarInd)
 {
@@ -361,7 +399,51 @@ void LARS::Ignore(const size_t varInd)
   ignoreSet.push_back(varInd);
 }
 
-void LARS::ComputeYHatDirection(const arma::mat& matX,
+template<typename MatType>
+void LARS::ComputeGram(const MatType& dataRef)
+{
+  // Each task computes a block of columns of X^T X.
+  matGramInternal.set_size(dataRef.n_cols, dataRef.n_cols);
+  const size_t blocks = (dataRef.n_cols + GramBlockSize - 1) / GramBlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    const size_t begin = b * GramBlockSize;
+    const size_t end = std::min((size_t) dataRef.n_cols,
+        begin + GramBlockSize) - 1;
+    const MatType block = dataRef.cols(begin, end);
+    matGramInternal.cols(begin, end) = arma::mat(arma::trans(dataRef) *
+        block);
+  });
+}
+
+template<typename MatType>
+void LARS::GramColumn(const MatType& dataRef,
+                      const size_t varInd,
+                      arma::vec& newGramCol,
+                      double& sqNorm) const
+{
+  if (matGram->n_elem > 0)
+  {
+    // The entries are in the Gram matrix.
+    newGramCol = matGram->elem(varInd * dataRef.n_cols +
+        arma::conv_to<arma::uvec>::from(activeSet));
+    sqNorm = (*matGram)(varInd, varInd);
+    return;
+  }
+
+  // Compute the dot products of the dimension with the active dimensions, in
+  // parallel.
+  newGramCol.set_size(activeSet.size());
+  const MatType column = dataRef.col(varInd);
+  ThreadPool::ParallelFor(0, activeSet.size(), [&](const size_t i)
+  {
+    newGramCol[i] = arma::dot(dataRef.col(activeSet[i]), column);
+  }, 16);
+  sqNorm = arma::dot(column, column);
+}
+
+template<typename MatType>
+void LARS::ComputeYHatDirection(const MatType& matX,
                                 const arma::vec& betaDirection,
                                 arma::vec& yHatDirection)
 {
@@ -419,21 +501,18 @@ void LARS::CholeskyInsert(double sqNormNewX, const arma::vec& newGramCol)
   }
   else
   {
-    arma::mat matNewR = arma::mat(n + 1, n + 1);
-
     if (elasticNet)
       sqNormNewX += lambda2;
 
     arma::vec matUtriCholFactork = solve(trimatl(trans(matUtriCholFactor)),
         newGramCol);
 
-    matNewR(arma::span(0, n - 1), arma::span(0, n - 1)) = matUtriCholFactor;
-    matNewR(arma::span(0, n - 1), n) = matUtriCholFactork;
-    matNewR(n, arma::span(0, n - 1)).fill(0.0);
-    matNewR(n, n) = sqrt(sqNormNewX - dot(matUtriCholFactork,
-                                          matUtriCholFactork));
-
-    matUtriCholFactor = matNewR;
+    // Grow the factor in place; resize() keeps the existing entries.
+    matUtriCholFactor.resize(n + 1, n + 1);
+    matUtriCholFactor(arma::span(0, n - 1), n) = matUtriCholFactork;
+    matUtriCholFactor(n, arma::span(0, n - 1)).fill(0.0);
+    matUtriCholFactor(n, n) = sqrt(sqNormNewX - dot(matUtriCholFactork,
+                                                    matUtriCholFactork));
   }
 }
 
@@ -53,6 +53,15 @@ namespace regression {
  * Note: This algorithm is not recommended for use (in terms of efficiency)
  * when \f$ \lambda_1 \f$ = 0.
  *
+ * If no Gram matrix is given, the full Gram matrix \f$ X^T X \f$ is only
+ * computed (in parallel, in blocks of columns) when Cholesky decomposition is
+ * not used.  With Cholesky decomposition, only the entries of the Gram matrix
+ * between the active dimensions are needed, so they are computed when a
+ * dimension becomes active, and the memory used grows with the size of the
+ * active set instead of with the square of the dimensionality.  So
+ * useCholesky = true is recommended for high-dimensional data.  The data may
+ * be dense or sparse.
+ *
  * For more details, see the following papers:
  *
  * @code
@@ -136,6 +145,21 @@ class LARS
              arma::vec& beta,
              const bool transposeData = true);
 
+  /**
+   * Run LARS on sparse data.  As for dense data, the data is transposed
+   * internally unless transposeData is false.
+   *
+   * @param data Column-major input data (or row-major input data if rowMajor =
+   *     true).
+   * @param responses A vector of targets.
+   * @param beta Vector to store the solution (the coefficients) in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void Train(const arma::sp_mat& data,
+             const arma::vec& responses,
+             arma::vec& beta,
+             const bool transposeData = true);
+
   /**
    * Predict y_i for each data point in the given data matrix, using the
    * currently-trained LARS model (so make sure you run Regress() first).  If
@@ -149,6 +173,18 @@ class LARS
                arma::vec& predictions,
                const bool rowMajor = false) const;
 
+  /**
+   * Predict y_i for each point in the given sparse data matrix, using the
+   * currently-trained LARS model.
+   *
+   * @param points The data points to regress on.
+   * @param predictions y, which will contained calculated values on completion.
+   * @param rowMajor Set to true if the data is row-major.
+   */
+  void Predict(const arma::sp_mat& points,
+               arma::vec& predictions,
+               const bool rowMajor = false) const;
+
   //! Access the set of active dimensions.
   const std::vector<size_t>& ActiveSet() const { return activeSet; }
 
@@ -163,6 +199,14 @@ class LARS
   //! Access the upper triangular cholesky factor.
   const arma::mat& MatUtriCholFactor() const { return matUtriCholFactor; }
 
+  //! Get the maximum size of the active set (0 means no limit).
+  size_t MaxActiveSize() const { return maxActiveSize; }
+  //! Modify the maximum size of the active set (0 means no limit); once that
+  //! many dimensions are active, the path stops before another dimension
+  //! would be added, so the solution has at most that many nonzero
+  //! coefficients.  This is not serialized.
+  size_t& MaxActiveSize() { return maxActiveSize; }
+
   /**
    * Serialize the LARS model.
    */
@@ -195,6 +239,9 @@ class LARS
   //! Tolerance for main loop.
   double tolerance;
 
+  //! Maximum size of the active set (0 means no limit).
+  size_t maxActiveSize;
+
   //! Solution path.
   std::vector<arma::vec> betaPath;
 
@@ -215,6 +262,41 @@ class LARS
   //! Membership indicator for set of ignored variables.
   std::vector<bool> isIgnored;
 
+  //! The number of columns of the Gram matrix computed by each task.
+  static const size_t GramBlockSize = 64;
+
+  //! Run LARS on dense or sparse data.
+  template<typename MatType>
+  void TrainInternal(const MatType& matX,
+                     const arma::vec& y,
+                     arma::vec& beta,
+                     const bool transposeData);
+
+  /**
+   * Compute the full Gram matrix of the given (row-major) data into
+   * matGramInternal, in parallel blocks of columns.
+   *
+   * @param dataRef Row-major data.
+   */
+  template<typename MatType>
+  void ComputeGram(const MatType& dataRef);
+
+  /**
+   * Compute the entries of the Gram matrix between the given dimension and the
+   * active dimensions, and the squared norm of the dimension, either from the
+   * Gram matrix or (if there is none) from the data.
+   *
+   * @param dataRef Row-major data.
+   * @param varInd Dimension to compute the entries of.
+   * @param newGramCol Vector to store the entries for the active set in.
+   * @param sqNorm Set to the squared norm of the dimension.
+   */
+  template<typename MatType>
+  void GramColumn(const MatType& dataRef,
+                  const size_t varInd,
+                  arma::vec& newGramCol,
+                  double& sqNorm) const;
+
   /**
    * Remove activeVarInd'th element from active set.
    *
@@ -237,7 +319,8 @@ class LARS
   void Ignore(const size_t varInd);
 
   // compute "equiangular" direction in output space
-  void ComputeYHatDirection(const arma::mat& matX,
+  template<typename MatType>
+  void ComputeYHatDirection(const MatType& matX,
                             const arma::vec& betaDirection,
                             arma::vec& yHatDirection);
 
@@ -40,7 +40,14 @@ PROGRAM_INFO("LARS", "An implementation of LARS: Least Angle Regression "
     " can be saved with the --output_model_file, or, if training is not desired"
     " at all, a model can be loaded with --input_model_file.  Any output "
     "predictions from a test file can be saved into the file specified by the "
-    "--output_predictions option.");
+    "--output_predictions option."
+    "\n\n"
+    "If the input file or the test file is a LIBSVM / SVMlight file (with "
+    "extension .svm, .libsvm or .svmlight), it is loaded as a sparse matrix and"
+    " used without converting it to a dense matrix.  Then the responses may be "
+    "omitted, in which case the labels of the input file are used.  For "
+    "high-dimensional data, --use_cholesky avoids computing the full Gram "
+    "matrix.");
 
 PARAM_STRING("input_file", "File containing covariates (X).", "i", "");
 PARAM_STRING("responses_file", "File containing y (responses/observations).",
@@ -66,6 +73,13 @@ using namespace std;
 using namespace mlpack;
 using namespace mlpack::regression;
 
+// Return whether the given file is a (sparse) LIBSVM / SVMlight file.
+bool IsLibSVMFile(const string& filename)
+{
+  return data::IsLibSVMExtension(data::Extension(data::UncompressedName(
+      filename)));
+}
+
 int main(int argc, char* argv[])
 {
   // Handle parameters,
@@ -76,7 +90,8 @@ int main(int argc, char* argv[])
   bool useCholesky = CLI::HasParam("use_cholesky");
 
   // Check parameters -- make sure everything given makes sense.
-  if (CLI::HasParam("input_file") && !CLI::HasParam("responses_file"))
+  if (CLI::HasParam("input_file") && !CLI::HasParam("responses_file") &&
+      !IsLibSVMFile(CLI::GetParam<string>("input_file")))
     Log::Fatal << "--input_file (-i) is specified, but --responses_file (-r) is"
         << " not!" << endl;
 
@@ -109,7 +124,41 @@ int main(int argc, char* argv[])
   // Initialize the object.
   LARS lars(useCholesky, lambda1, lambda2);
 
-  if (CLI::HasParam("input_file"))
+  if (CLI::HasParam("input_file") &&
+      IsLibSVMFile(CLI::GetParam<string>("input_file")))
+  {
+    // Load the sparse covariates, with one point per column; LARS will
+    // transpose them.
+    const string inputFile = CLI::GetParam<string>("input_file");
+    sp_mat matX;
+    rowvec labels;
+    data::Load(inputFile, matX, labels, true);
+
+    vec responses;
+    if (CLI::HasParam("responses_file"))
+    {
+      mat matY;
+      data::Load(CLI::GetParam<string>("responses_file"), matY, true, false);
+      if (matY.n_rows == 1)
+        matY = trans(matY);
+      if (matY.n_cols > 1)
+        Log::Fatal << "Only one column or row allowed in responses file!"
+            << endl;
+      responses = matY.col(0);
+    }
+    else
+    {
+      responses = trans(labels);
+    }
+
+    if (responses.n_elem != matX.n_cols)
+      Log::Fatal << "Number of responses must be equal to number of points in "
+          << "X!" << endl;
+
+    vec beta;
+    lars.Train(matX, responses, beta);
+  }
+  else if (CLI::HasParam("input_file"))
   {
     // Load covariates.  We can avoid LARS transposing our data by choosing to
     // not transpose this data.
@@ -147,20 +196,40 @@ int main(int argc, char* argv[])
   {
     Log::Info << "Regressing on test points." << endl;
     const string testFile = CLI::GetParam<string>("test_file");
-
-    // Load test points.
-    mat testPoints;
-    data::Load(testFile, testPoints, true, false);
-
-    // Make sure the dimensionality is right.  We haven't transposed, so, we
-    // check n_cols not n_rows.
-    if (testPoints.n_cols != lars.BetaPath().back().n_elem)
-      Log::Fatal << "Dimensionality of test set (" << testPoints.n_cols << ") "
-          << "is not equal to the dimensionality of the model ("
-          << lars.BetaPath().back().n_elem << ")!" << endl;
+    const size_t dimensionality = lars.BetaPath().back().n_elem;
 
     arma::vec predictions;
-    lars.Predict(testPoints.t(), predictions, false);
+    if (IsLibSVMFile(testFile))
+    {
+      // Load sparse test points, one per column.  Trailing dimensions which
+      // are zero for every point are not stored in LIBSVM files.
+      sp_mat testPoints;
+      data::Load(testFile, testPoints, true);
+      if (testPoints.n_rows < dimensionality)
+        testPoints.resize(dimensionality, testPoints.n_cols);
+
+      if (testPoints.n_rows != dimensionality)
+        Log::Fatal << "Dimensionality of test set (" << testPoints.n_rows
+            << ") is not equal to the dimensionality of the model ("
+            << dimensionality << ")!" << endl;
+
+      lars.Predict(testPoints, predictions, false);
+    }
+    else
+    {
+      // Load test points.
+      mat testPoints;
+      data::Load(testFile, testPoints, true, false);
+
+      // Make sure the dimensionality is right.  We haven't transposed, so, we
+      // check n_cols not n_rows.
+      if (testPoints.n_cols != dimensionality)
+        Log::Fatal << "Dimensionality of test set (" << testPoints.n_cols
+            << ") is not equal to the dimensionality of the model ("
+            << dimensionality << ")!" << endl;
+
+      lars.Predict(testPoints, predictions, true);
+    }
 
     // Save test predictions.  One per line, so, don't transpose on save.
     if (CLI::HasParam("output_predictions"))
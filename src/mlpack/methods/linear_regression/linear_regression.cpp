@@ -93,6 +93,33 @@ void LinearRegression::Train(const arma::mat& predictors,
   }
 }
 
+void LinearRegression::Train(const LinearRegressionStatistics& statistics)
+{
+  if (statistics.NumPoints() == 0)
+  {
+    Log::Fatal << "LinearRegression::Train(): cannot train on statistics of no "
+        << "points!" << std::endl;
+  }
+
+  intercept = statistics.Intercept();
+
+  // We solve the normal equations (X X^T + lambda I) B = X y.  As when training
+  // on the data, the intercept is not penalized.
+  arma::mat gram = statistics.Gram();
+  if (lambda != 0.0)
+  {
+    for (size_t i = (intercept ? 1 : 0); i < gram.n_rows; ++i)
+      gram(i, i) += lambda;
+  }
+
+  if (!arma::solve(parameters, gram, statistics.Moments()))
+  {
+    Log::Fatal << "LinearRegression::Train(): the normal equations could not "
+        << "be solved; try a Tikhonov regularization constant (lambda) greater "
+        << "than 0." << std::endl;
+  }
+}
+
 void LinearRegression::Predict(const arma::mat& points, arma::vec& predictions)
     const
 {
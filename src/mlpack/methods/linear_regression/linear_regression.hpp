@@ -9,6 +9,7 @@
 #define MLPACK_METHODS_LINEAR_REGRESSION_LINEAR_REGRESSION_HPP
 
 #include <mlpack/core.hpp>
+#include "linear_regression_statistics.hpp"
 
 namespace mlpack {
 namespace regression /** Regression methods. */ {
@@ -67,6 +68,19 @@ class LinearRegression
              const bool intercept = true,
              const arma::vec& weights = arma::vec());
 
+  /**
+   * Train the LinearRegression model from the given sufficient statistics,
+   * which may have been accumulated over chunks of a dataset too large to fit
+   * in memory, by solving the normal equations.  The model is the same as the
+   * model trained on the whole dataset (up to floating-point rounding), with
+   * the current value of lambda, and it has an intercept term if the
+   * statistics have one.  Careful!  This will completely ignore and overwrite
+   * the existing model.
+   *
+   * @param statistics Sufficient statistics of the training set.
+   */
+  void Train(const LinearRegressionStatistics& statistics);
+
   /**
    * Calculate y_i for each data point in points.
    *
@@ -5,6 +5,7 @@
  * Main function for least-squares linear regression.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
 #include "linear_regression.hpp"
 
 PROGRAM_INFO("Simple Linear Regression and Prediction",
@@ -24,7 +25,15 @@ PROGRAM_INFO("Simple Linear Regression and Prediction",
     "and these predicted responses, y', are saved to a file "
     "(--output_predictions).  This type of regression is related to "
     "least-angle regression, which mlpack implements with the 'lars' "
-    "executable.");
+    "executable."
+    "\n\n"
+    "If the training set does not fit in memory, --chunk_size (-z) can be "
+    "given; then the training file (which may be a .csv, .tsv, .txt or "
+    "Armadillo binary .bin file) is read --chunk_size points at a time, and "
+    "only the sufficient statistics X'X and X'y are kept, so the memory used "
+    "does not depend on the number of points.  A separate responses file "
+    "(--training_responses) must then have one response per line.  The "
+    "solution is the same as when the training set is loaded.");
 
 PARAM_STRING("training_file", "File containing training set X (regressors).",
     "t", "");
@@ -42,6 +51,8 @@ PARAM_STRING("output_predictions", "If --test_file is specified, this "
 
 PARAM_DOUBLE("lambda", "Tikhonov regularization for ridge regression.  If 0, "
     "the method reduces to linear regression.", "l", 0.0);
+PARAM_INT("chunk_size", "If positive, the training file is read this many "
+    "points at a time instead of being loaded into memory.", "z", 0);
 
 using namespace mlpack;
 using namespace mlpack::regression;
@@ -62,6 +73,7 @@ int main(int argc, char* argv[])
   const string testFile = CLI::GetParam<string>("test_file");
   const string trainFile = CLI::GetParam<string>("training_file");
   const double lambda = CLI::GetParam<double>("lambda");
+  const int chunkSize = CLI::GetParam<int>("chunk_size");
 
   mat regressors;
   mat responses;
@@ -109,15 +121,80 @@ int main(int argc, char* argv[])
     Log::Warn << "--lambda ignored because no model is being trained." << endl;
   }
 
+  if (chunkSize < 0)
+    Log::Fatal << "Invalid chunk size: " << chunkSize << ".  Must be 0 or "
+        << "greater." << endl;
+  if (!computeModel && chunkSize > 0)
+    Log::Warn << "--chunk_size ignored because no model is being trained."
+        << endl;
+
   // An input file was given and we need to generate the model.
-  if (computeModel)
+  if (computeModel && chunkSize > 0)
+  {
+    // Accumulate the sufficient statistics of the training set one chunk at a
+    // time; the training set is never loaded at once.  The files are read as
+    // the statistics are accumulated, so a read error can happen at any chunk.
+    LinearRegressionStatistics statistics;
+    bool responsesMatch = true;
+    Timer::Start("regression");
+    try
+    {
+      data::ChunkedLoader<double> loader(trainFile);
+      std::unique_ptr<data::ChunkedLoader<double>> responsesLoader;
+      if (CLI::HasParam("training_responses"))
+        responsesLoader.reset(new data::ChunkedLoader<double>(
+            trainingResponsesFile));
+
+      mat chunk, responsesChunk;
+      while (loader.Next(chunk, (size_t) chunkSize))
+      {
+        if (responsesLoader)
+        {
+          if (!responsesLoader->Next(responsesChunk, chunk.n_cols) ||
+              responsesChunk.n_rows != 1 ||
+              responsesChunk.n_cols != chunk.n_cols)
+          {
+            responsesMatch = false;
+            break;
+          }
+
+          statistics.Add(chunk, vec(trans(responsesChunk)));
+        }
+        else
+        {
+          // The responses are the last row.
+          const vec chunkResponses = trans(chunk.row(chunk.n_rows - 1));
+          chunk.shed_row(chunk.n_rows - 1);
+          statistics.Add(chunk, chunkResponses);
+        }
+      }
+
+      if (responsesMatch && responsesLoader &&
+          responsesLoader->Next(responsesChunk, 1))
+        responsesMatch = false;
+    }
+    catch (std::runtime_error& e)
+    {
+      Log::Fatal << e.what() << endl;
+    }
+
+    if (!responsesMatch)
+      Log::Fatal << "The responses must have one column and the same number "
+          << "of rows as the training file.\n";
+
+    lr.Train(statistics);
+    Timer::Stop("regression");
+    Log::Info << "Trained on " << statistics.NumPoints() << " points in chunks "
+        << "of " << chunkSize << "." << endl;
+  }
+  else if (computeModel)
   {
     Timer::Start("load_regressors");
     data::Load(trainFile, regressors, true);
     Timer::Stop("load_regressors");
 
     // Are the responses in a separate file?
-    if (CLI::HasParam("training_responses"))
+    if (!CLI::HasParam("training_responses"))
     {
       // The initial predictors for y, Nx1.
       responses = trans(regressors.row(regressors.n_rows - 1));
@@ -142,9 +219,12 @@ int main(int argc, char* argv[])
     }
 
     Timer::Start("regression");
-    lr = LinearRegression(regressors, responses.unsafe_col(0));
+    lr = LinearRegression(regressors, responses.unsafe_col(0), lambda);
     Timer::Stop("regression");
+  }
 
+  if (computeModel)
+  {
     // Save the parameters.
     if (CLI::HasParam("output_model_file"))
       data::Save(outputModelFile, "linearRegressionModel", lr);
@@ -0,0 +1,141 @@
+/**
+ * @file linear_regression_statistics.cpp
+ *
+ * Implementation of the sufficient statistics of linear regression.
+ */
+#include "linear_regression_statistics.hpp"
+
+using namespace mlpack;
+using namespace mlpack::regression;
+
+LinearRegressionStatistics::LinearRegressionStatistics(const bool intercept) :
+    numPoints(0),
+    intercept(intercept)
+{ /* Nothing to do. */ }
+
+void LinearRegressionStatistics::Add(const arma::mat& predictors,
+                                     const arma::vec& responses,
+                                     const arma::vec& weights)
+{
+  if (responses.n_elem != predictors.n_cols)
+  {
+    Log::Fatal << "LinearRegressionStatistics::Add(): there are "
+        << responses.n_elem << " responses for " << predictors.n_cols
+        << " points!" << std::endl;
+  }
+  if (weights.n_elem > 0 && weights.n_elem != predictors.n_cols)
+  {
+    Log::Fatal << "LinearRegressionStatistics::Add(): there are "
+        << weights.n_elem << " weights for " << predictors.n_cols
+        << " points!" << std::endl;
+  }
+
+  // The first row and column are for the intercept.
+  const size_t offset = intercept ? 1 : 0;
+  const size_t dimensions = predictors.n_rows + offset;
+  if (gram.n_rows == 0)
+  {
+    gram.zeros(dimensions, dimensions);
+    moments.zeros(dimensions);
+  }
+  else if (gram.n_rows != dimensions)
+  {
+    Log::Fatal << "LinearRegressionStatistics::Add(): the points have "
+        << predictors.n_rows << " dimensions, but the statistics have "
+        << Dimensionality() << "!" << std::endl;
+  }
+
+  if (predictors.n_cols == 0)
+    return;
+
+  // Each thread accumulates the statistics of its own range of points, and
+  // then the statistics of the ranges are added.
+  const size_t ranges = std::max((size_t) 1, std::min(ThreadPool::Threads(),
+      (size_t) predictors.n_cols / BlockSize));
+  std::vector<arma::mat> grams(ranges);
+  std::vector<arma::vec> rangeMoments(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * predictors.n_cols / ranges;
+    const size_t count = (r + 1) * predictors.n_cols / ranges - begin;
+
+    // Use the points where they are, without a copy.
+    const arma::mat points(const_cast<double*>(predictors.colptr(begin)),
+        predictors.n_rows, count, false, true);
+    const arma::vec pointResponses(const_cast<double*>(responses.memptr()) +
+        begin, count, false, true);
+
+    // With weights W, the statistics are X W X^T and X W y.
+    arma::mat scaledPoints;
+    arma::vec rangeWeights;
+    if (weights.n_elem > 0)
+    {
+      rangeWeights = weights.subvec(begin, begin + count - 1);
+      scaledPoints = points;
+      scaledPoints.each_row() %= rangeWeights.t();
+    }
+    else
+    {
+      rangeWeights.ones(count);
+    }
+    const arma::mat& weightedPoints = (weights.n_elem > 0) ? scaledPoints :
+        points;
+
+    arma::mat& rangeGram = grams[r];
+    arma::vec& rangeMoment = rangeMoments[r];
+    rangeGram.set_size(dimensions, dimensions);
+    rangeMoment.set_size(dimensions);
+    rangeGram.submat(offset, offset, dimensions - 1, dimensions - 1) =
+        weightedPoints * points.t();
+    rangeMoment.subvec(offset, dimensions - 1) = weightedPoints *
+        pointResponses;
+
+    // The row of ones of the intercept is not stored.
+    if (intercept)
+    {
+      const arma::vec sums = arma::sum(weightedPoints, 1);
+      rangeGram(0, 0) = arma::accu(rangeWeights);
+      rangeGram.submat(1, 0, dimensions - 1, 0) = sums;
+      rangeGram.submat(0, 1, 0, dimensions - 1) = sums.t();
+      rangeMoment[0] = arma::dot(rangeWeights, pointResponses);
+    }
+  });
+
+  for (size_t r = 0; r < ranges; ++r)
+  {
+    gram += grams[r];
+    moments += rangeMoments[r];
+  }
+  numPoints += predictors.n_cols;
+}
+
+void LinearRegressionStatistics::Merge(const LinearRegressionStatistics& other)
+{
+  if (other.intercept != intercept)
+  {
+    Log::Fatal << "LinearRegressionStatistics::Merge(): cannot merge statistics"
+        << " with and without an intercept!" << std::endl;
+  }
+
+  if (other.gram.n_rows == 0)
+    return;
+
+  if (gram.n_rows == 0)
+  {
+    gram = other.gram;
+    moments = other.moments;
+  }
+  else if (gram.n_rows != other.gram.n_rows)
+  {
+    Log::Fatal << "LinearRegressionStatistics::Merge(): the statistics have "
+        << Dimensionality() << " dimensions, but the other statistics have "
+        << other.Dimensionality() << "!" << std::endl;
+  }
+  else
+  {
+    gram += other.gram;
+    moments += other.moments;
+  }
+
+  numPoints += other.numPoints;
+}
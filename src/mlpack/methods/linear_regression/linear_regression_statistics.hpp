@@ -0,0 +1,116 @@
+/**
+ * @file linear_regression_statistics.hpp
+ *
+ * The sufficient statistics of least-squares linear regression, which can be
+ * accumulated over chunks of a dataset that does not fit in memory.
+ */
+#ifndef MLPACK_METHODS_LINEAR_REGRESSION_LINEAR_REGRESSION_STATISTICS_HPP
+#define MLPACK_METHODS_LINEAR_REGRESSION_LINEAR_REGRESSION_STATISTICS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * The sufficient statistics of (ridge) least-squares linear regression on a
+ * set of points: the matrix X X^T and the vector X y, where X holds the points
+ * (with a row of ones first, if an intercept is fitted) and y the responses.
+ * The solution of the normal equations (X X^T + lambda I) b = X y is the same
+ * as the one LinearRegression computes from the whole dataset, but the
+ * statistics only take O(d^2) memory, so they can be accumulated over chunks
+ * of a dataset that does not fit in memory.  Statistics accumulated separately
+ * (for instance, on different machines) can be merged, and serialized.
+ *
+ * @code
+ * data::ChunkedLoader<double> loader("data.csv");
+ * LinearRegressionStatistics statistics;
+ * arma::mat chunk;
+ * while (loader.Next(chunk, 100000))
+ * {
+ *   const arma::vec responses = chunk.row(chunk.n_rows - 1).t();
+ *   chunk.shed_row(chunk.n_rows - 1);
+ *   statistics.Add(chunk, responses);
+ * }
+ *
+ * LinearRegression lr;
+ * lr.Train(statistics);
+ * @endcode
+ */
+class LinearRegressionStatistics
+{
+ public:
+  /**
+   * Create empty statistics.  Their dimensionality is set by the first points
+   * added.
+   *
+   * @param intercept Whether or not to include an intercept term.
+   */
+  LinearRegressionStatistics(const bool intercept = true);
+
+  /**
+   * Add the given points to the statistics.  Ranges of the points are
+   * accumulated in parallel.
+   *
+   * @param predictors X, matrix of data points to add.
+   * @param responses y, the measured data for each point in X.
+   * @param weights Observation weights (optional).
+   */
+  void Add(const arma::mat& predictors,
+           const arma::vec& responses,
+           const arma::vec& weights = arma::vec());
+
+  /**
+   * Add the given statistics (accumulated on other points, with the same
+   * dimensionality and intercept setting) to these statistics.
+   *
+   * @param other Statistics to merge into these statistics.
+   */
+  void Merge(const LinearRegressionStatistics& other);
+
+  //! Return the dimensionality of the points (0 if no point was added).
+  size_t Dimensionality() const
+  {
+    return (gram.n_rows == 0) ? 0 : gram.n_rows - (intercept ? 1 : 0);
+  }
+  //! Return the number of points added.
+  size_t NumPoints() const { return numPoints; }
+  //! Return whether or not an intercept term is used.
+  bool Intercept() const { return intercept; }
+
+  //! Return the matrix X X^T (the first row and column are for the intercept,
+  //! if one is used).
+  const arma::mat& Gram() const { return gram; }
+  //! Return the vector X y.
+  const arma::vec& Moments() const { return moments; }
+
+  /**
+   * Serialize the statistics.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(gram, "gram");
+    ar & data::CreateNVP(moments, "moments");
+    ar & data::CreateNVP(numPoints, "numPoints");
+    ar & data::CreateNVP(intercept, "intercept");
+  }
+
+ private:
+  //! The matrix X X^T.
+  arma::mat gram;
+  //! The vector X y.
+  arma::vec moments;
+  //! The number of points added.
+  size_t numPoints;
+  //! Indicates whether the first row and column are for the intercept.
+  bool intercept;
+
+  //! The minimum number of points that each thread accumulates.
+  static const size_t BlockSize = 1024;
+};
+
+} // namespace regression
+} // namespace mlpack
+
+#endif
@@ -139,7 +139,9 @@ class LocalCoordinateCoding
                  DictionaryInitializer());
 
   /**
-   * Code each point via distance-weighted LARS.
+   * Code each point via distance-weighted LARS.  The points are coded in
+   * parallel.  To encode many batches of points with the same dictionary, use
+   * an LCCEncoder, which computes the Gram matrix only once.
    *
    * @param data Matrix containing points to encode.
    * @param codes Output matrix to store codes in.
@@ -0,0 +1,122 @@
+/**
+ * @file lcc_encoder.cpp
+ *
+ * Implementation of the LCCEncoder class.
+ */
+#include "lcc_encoder.hpp"
+
+namespace mlpack {
+namespace lcc {
+
+LCCEncoder::LCCEncoder(const LocalCoordinateCoding& model,
+                       const size_t maxActiveSize) :
+    LCCEncoder(model.Dictionary(), model.Lambda(), maxActiveSize)
+{
+  // Nothing to do.
+}
+
+LCCEncoder::LCCEncoder(const arma::mat& dictionary,
+                       const double lambda,
+                       const size_t maxActiveSize) :
+    dictionary(dictionary),
+    gram(trans(dictionary) * dictionary),
+    atomSqNorms(trans(sum(square(dictionary)))),
+    lambda(lambda),
+    maxActiveSize(maxActiveSize)
+{
+  // Nothing to do.
+}
+
+LCCEncoder::LCCEncoder(const LCCEncoder& other) :
+    dictionary(other.dictionary),
+    gram(other.gram),
+    atomSqNorms(other.atomSqNorms),
+    lambda(other.lambda),
+    maxActiveSize(other.maxActiveSize)
+{
+  // Nothing to do.
+}
+
+LCCEncoder& LCCEncoder::operator=(const LCCEncoder& other)
+{
+  if (this != &other)
+  {
+    dictionary = other.dictionary;
+    gram = other.gram;
+    atomSqNorms = other.atomSqNorms;
+    lambda = other.lambda;
+    maxActiveSize = other.maxActiveSize;
+    workspaces.clear();
+  }
+
+  return *this;
+}
+
+void LCCEncoder::Encode(const arma::mat& data, arma::mat& codes)
+{
+  if (data.n_rows != dictionary.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LCCEncoder::Encode(): the points have " << data.n_rows
+        << " dimensions, but the dictionary has " << dictionary.n_rows;
+    throw std::invalid_argument(oss.str());
+  }
+
+  Log::Debug << "Optimizing the codes of " << data.n_cols << " points."
+      << std::endl;
+
+  // Each thread of the loop uses its own workspace.  If the loop will run
+  // serially (because this is called from a parallel region), only the first
+  // workspace is used.
+  const bool serial = ThreadPool::InParallel();
+  const size_t threads = serial ? 1 : ThreadPool::Threads();
+  while (workspaces.size() < threads)
+  {
+    workspaces.emplace_back(new Workspace(0.5 * lambda));
+    workspaces.back()->lars.MaxActiveSize() = maxActiveSize;
+  }
+
+  // The codes of the points are independent, so blocks of points are coded in
+  // parallel.
+  codes.set_size(dictionary.n_cols, data.n_cols);
+  const size_t blocks = (data.n_cols + EncodeBlockSize - 1) / EncodeBlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    size_t thread = 0;
+    #ifdef _OPENMP
+      if (!serial)
+        thread = omp_get_thread_num();
+    #endif
+    Workspace& workspace = *workspaces[thread];
+
+    // Compute the inverse squared distances of the points of the block to the
+    // atoms, with one product.
+    const size_t begin = b * EncodeBlockSize;
+    const size_t end = std::min((size_t) data.n_cols, begin + EncodeBlockSize);
+    workspace.invSqDists = -2.0 * trans(dictionary) * data.cols(begin,
+        end - 1);
+    workspace.invSqDists.each_col() += atomSqNorms;
+    workspace.invSqDists.each_row() += sum(square(data.cols(begin, end - 1)));
+    workspace.invSqDists = 1.0 / workspace.invSqDists;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      // dictPrime = dictionary * diagmat(invW), and
+      // gramPrime = diagmat(invW) * gram * diagmat(invW).
+      const arma::vec invW = workspace.invSqDists.unsafe_col(i - begin);
+      workspace.dictPrime = dictionary;
+      workspace.dictPrime.each_row() %= trans(invW);
+      workspace.gramPrime = gram % (invW * trans(invW));
+
+      // Run LARS for this point, by making an alias of the point and passing
+      // that.
+      arma::vec beta = codes.unsafe_col(i);
+      workspace.lars.Train(workspace.dictPrime, data.unsafe_col(i), beta,
+          false);
+      beta %= invW; // Remember, beta is an alias of codes.col(i).
+    }
+  });
+}
+
+} // namespace lcc
+} // namespace mlpack
@@ -0,0 +1,128 @@
+/**
+ * @file lcc_encoder.hpp
+ *
+ * Definition of the LCCEncoder class, which encodes new points with a trained
+ * local coordinate coding dictionary.
+ */
+#ifndef MLPACK_METHODS_LOCAL_COORDINATE_CODING_LCC_ENCODER_HPP
+#define MLPACK_METHODS_LOCAL_COORDINATE_CODING_LCC_ENCODER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/lars/lars.hpp>
+
+#include "lcc.hpp"
+
+namespace mlpack {
+namespace lcc {
+
+/**
+ * An LCCEncoder encodes batches of points with a fixed dictionary (for
+ * instance, the dictionary of a trained LocalCoordinateCoding model), solving
+ * the same distance-weighted LASSO problem for each point as
+ * LocalCoordinateCoding::Encode().  It is meant to be kept alive and used for
+ * many batches: the Gram matrix of the dictionary and the squared norms of the
+ * atoms are computed once, when the encoder is created, and each thread keeps
+ * its own workspace (the weighted dictionary and Gram matrix of a point, and a
+ * LARS solver which refers to that Gram matrix) from one batch to the next.
+ * The points of a batch are coded in parallel, and the distances of each block
+ * of points to the atoms are computed with a single matrix product.
+ *
+ * Optionally, the number of nonzero coefficients of each code can be bounded:
+ * LARS then stops once that many atoms are active, which also bounds the time
+ * spent on each point.
+ *
+ * Encode() must not be called by several threads at once on the same encoder
+ * (use one encoder per calling thread instead); copies of an encoder share
+ * nothing.
+ */
+class LCCEncoder
+{
+ public:
+  /**
+   * Create an encoder for the dictionary and the regularization parameter of
+   * the given local coordinate coding model.
+   *
+   * @param model Trained local coordinate coding model.
+   * @param maxActiveSize Maximum number of nonzero coefficients of each code
+   *     (0 means no limit).
+   */
+  LCCEncoder(const LocalCoordinateCoding& model,
+             const size_t maxActiveSize = 0);
+
+  /**
+   * Create an encoder for the given dictionary.
+   *
+   * @param dictionary Dictionary (columns are atoms).
+   * @param lambda Regularization parameter for the weighted l1-norm penalty.
+   * @param maxActiveSize Maximum number of nonzero coefficients of each code
+   *     (0 means no limit).
+   */
+  LCCEncoder(const arma::mat& dictionary,
+             const double lambda,
+             const size_t maxActiveSize = 0);
+
+  //! Copy the given encoder (but not its workspaces).
+  LCCEncoder(const LCCEncoder& other);
+
+  //! Copy the given encoder (but not its workspaces).
+  LCCEncoder& operator=(const LCCEncoder& other);
+
+  /**
+   * Encode each of the given points with distance-weighted LARS.  A
+   * std::invalid_argument is thrown if the dimensionality of the points is not
+   * the one of the dictionary.
+   *
+   * @param data Points to encode (one per column).
+   * @param codes Matrix to store the codes in (one per column).
+   */
+  void Encode(const arma::mat& data, arma::mat& codes);
+
+  //! Get the dictionary.
+  const arma::mat& Dictionary() const { return dictionary; }
+  //! Get the Gram matrix of the dictionary.
+  const arma::mat& Gram() const { return gram; }
+  //! Get the L1 regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Get the maximum number of nonzero coefficients of each code (0 means no
+  //! limit).
+  size_t MaxActiveSize() const { return maxActiveSize; }
+
+ private:
+  //! The buffers and the solver used by one thread.
+  struct Workspace
+  {
+    Workspace(const double lambda) : lars(false, gramPrime, lambda) { }
+
+    //! The dictionary, weighted for the current point.
+    arma::mat dictPrime;
+    //! The Gram matrix of the weighted dictionary.
+    arma::mat gramPrime;
+    //! The inverse squared distances of the current block of points to the
+    //! atoms.
+    arma::mat invSqDists;
+    //! The solver, which refers to gramPrime.
+    regression::LARS lars;
+  };
+
+  //! Dictionary (columns are atoms).
+  arma::mat dictionary;
+  //! Gram matrix of the dictionary.
+  arma::mat gram;
+  //! Squared norms of the atoms.
+  arma::vec atomSqNorms;
+  //! l1 regularization term.
+  double lambda;
+  //! Maximum number of nonzero coefficients of each code (0 means no limit).
+  size_t maxActiveSize;
+
+  //! The workspace of each thread, created when first needed.
+  std::vector<std::unique_ptr<Workspace>> workspaces;
+
+  //! The number of points coded by each task in Encode().
+  static const size_t EncodeBlockSize = 16;
+};
+
+} // namespace lcc
+} // namespace mlpack
+
+#endif
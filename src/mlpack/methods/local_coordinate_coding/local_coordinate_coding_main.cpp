@@ -22,7 +22,9 @@ PROGRAM_INFO("Local Coordinate Coding",
     "\n\n"
     "The coding is found with an algorithm which alternates between a "
     "dictionary step, which updates the dictionary D, and a coding step, which "
-    "updates the coding matrix Z."
+    "updates the coding matrix Z.  The coding step, which takes most of the "
+    "time, codes the points in parallel; the number of threads can be set with"
+    " --threads (-j)."
     "\n\n"
     "To run this program, the input matrix X must be specified (with -i), along"
     " with the number of atoms in the dictionary (-k).  An initial dictionary "
@@ -201,6 +201,46 @@ class LogisticRegression
   void Classify(const MatType& dataset,
                 arma::mat& probabilities) const;
 
+  /**
+   * Score the given points in a single pass: the linear function, the sigmoid
+   * and the decision boundary are applied to each point at once, without
+   * temporary matrices, and blocks of points are scored in parallel.  The
+   * probability that each point has label 1 and its predicted label are
+   * written to the given rows, which are only resized if they don't already
+   * have one element per point (so preallocated rows, or rows wrapping memory
+   * of the caller, are reused).
+   *
+   * The points can be dense or sparse, and of doubles or floats (in which
+   * case the probabilities are floats, and are computed with floats),
+   * whatever MatType is.  A std::invalid_argument is thrown if the
+   * dimensionality of the points is not the one of the model.
+   *
+   * @param points Points to score (one per column).
+   * @param probabilities Probability of label 1 for each point.
+   * @param labels Predicted label of each point.
+   * @param decisionBoundary Decision boundary (default 0.5).
+   */
+  template<typename ScoreMatType>
+  void Score(const ScoreMatType& points,
+             arma::Row<typename ScoreMatType::elem_type>& probabilities,
+             arma::Row<size_t>& labels,
+             const double decisionBoundary = 0.5) const;
+
+  /**
+   * Predict the labels of the given points in a single parallel pass, as
+   * Score() does, but without computing the probabilities: the linear
+   * function of each point is compared with the logit of the decision
+   * boundary instead.
+   *
+   * @param points Points to score (one per column).
+   * @param labels Predicted label of each point.
+   * @param decisionBoundary Decision boundary (default 0.5).
+   */
+  template<typename ScoreMatType>
+  void Score(const ScoreMatType& points,
+             arma::Row<size_t>& labels,
+             const double decisionBoundary = 0.5) const;
+
   /**
    * Compute the accuracy of the model on the given predictors and responses,
    * optionally using the given decision boundary.  The responses should be
@@ -235,6 +275,26 @@ class LogisticRegression
   void Serialize(Archive& ar, const unsigned int /* version */);
 
  private:
+  /**
+   * Call the given function with the index and the linear function of each
+   * of the given points, in parallel blocks of points, after checking their
+   * dimensionality.
+   */
+  template<typename ScoreMatType, typename FunctionType>
+  void ScoreColumns(const ScoreMatType& points, FunctionType function) const;
+
+  //! Compute the linear function of the given dense point.
+  template<typename eT>
+  static eT LinearScore(const arma::Mat<eT>& points,
+                        const size_t col,
+                        const arma::Col<eT>& weights);
+
+  //! Compute the linear function of the given sparse point.
+  template<typename eT>
+  static eT LinearScore(const arma::SpMat<eT>& points,
+                        const size_t col,
+                        const arma::Col<eT>& weights);
+
   //! Vector of trained parameters (size: dimensionality plus one).
   arma::vec parameters;
   //! L2-regularization penalty parameter.
@@ -76,6 +76,22 @@ class LogisticRegressionFunction
    */
   double Evaluate(const arma::mat& parameters, const size_t i) const;
 
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters, using only the points begin to (begin + batchSize - 1).  This
+   * is the sum of the separable objectives of those points, computed with one
+   * matrix-vector product; it is used by the MiniBatchSGD optimizer.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point to use.
+   * @param batchSize Number of points to use.
+   * @param deterministic Unused (there is nothing random in the objective).
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic) const;
+
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
    * with the given parameters.
@@ -99,6 +115,54 @@ class LogisticRegressionFunction
                 const size_t i,
                 arma::mat& gradient) const;
 
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with respect to only one point, as a sparse vector.  This is only available
+   * for sparse data (MatType = arma::sp_mat); SGD and ParallelSGD use it to
+   * update only the coordinates where the point is nonzero.  The regularization
+   * term is dense, so for sparse updates set lambda to 0 and use the weight
+   * decay of the optimizer (SGD::Decay()), if any, instead.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param i Index of the point to use for the gradient evaluation.
+   * @param gradient Sparse vector to output gradient into.
+   */
+  template<typename T = MatType>
+  typename std::enable_if<arma::is_SpMat<T>::value, void>::type
+  Gradient(const arma::mat& parameters,
+           const size_t i,
+           arma::sp_mat& gradient) const;
+
+  /**
+   * Give the indices of the parameters where the sparse gradient of the given
+   * point may be nonzero (the intercept, and the coordinates where the point
+   * is nonzero), without computing it.  SGD uses this to apply its lazy weight
+   * decay to these parameters before computing the gradient.
+   *
+   * @param i Index of the point.
+   * @param support Vector to store the indices of the parameters in.
+   */
+  template<typename T = MatType>
+  typename std::enable_if<arma::is_SpMat<T>::value, void>::type
+  GradientSupport(const size_t i, arma::uvec& support) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters, with respect to the points begin to (begin +
+   * batchSize - 1).  This is the sum of the separable gradients of those
+   * points, computed with one matrix-vector product; it is used by the
+   * MiniBatchSGD optimizer.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point to use.
+   * @param gradient Vector to output gradient into.
+   * @param batchSize Number of points to use.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
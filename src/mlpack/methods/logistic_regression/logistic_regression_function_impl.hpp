@@ -71,10 +71,12 @@ double LogisticRegressionFunction<MatType>::Evaluate(
                 parameters.col(0).subvec(1, parameters.n_elem - 1));
 
   // Calculate vectors of sigmoids.  The intercept term is parameters(0, 0) and
-  // does not need to be multiplied by any of the predictors.
-  const arma::vec exponents = parameters(0, 0) + predictors.t() *
-      parameters.col(0).subvec(1, parameters.n_elem - 1);
-  const arma::vec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
+  // does not need to be multiplied by any of the predictors.  The product is
+  // taken as a row vector times the predictors, so that no transpose of the
+  // predictors (which would be expensive if they are sparse) is needed.
+  const arma::rowvec exponents = parameters(0, 0) +
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t() * predictors;
+  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
 
   // Assemble full objective function.  Often the objective function and the
   // regularization as given are divided by the number of features, but this
@@ -105,7 +107,9 @@ double LogisticRegressionFunction<MatType>::Evaluate(
 {
   // Calculate the regularization term.  We must divide by the number of points,
   // so that sum(Evaluate(parameters, [1:points])) == Evaluate(parameters).
-  const double regularization = lambda * (1.0 / (2.0 * predictors.n_cols)) *
+  // Without regularization, this stays O(nnz) for sparse points.
+  const double regularization = (lambda == 0.0) ? 0.0 :
+      lambda * (1.0 / (2.0 * predictors.n_cols)) *
       arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
                 parameters.col(0).subvec(1, parameters.n_elem - 1));
 
@@ -120,6 +124,43 @@ double LogisticRegressionFunction<MatType>::Evaluate(
     return -log(1.0 - sigmoid) + regularization;
 }
 
+/**
+ * Evaluate the logistic regression objective function on a batch of
+ * consecutive points.  This is useful for optimizers that use mini-batches,
+ * such as MiniBatchSGD.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize,
+    const bool /* deterministic */) const
+{
+  // The regularization term of each point is divided by the number of points,
+  // as in the separable objective function.
+  const double regularization = lambda * (batchSize /
+      (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  // Calculate the sigmoids of the whole batch at once.
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-parameters(0, 0) -
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t() *
+      predictors.cols(begin, begin + batchSize - 1)));
+
+  double result = 0.0;
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    if (responses[begin + i] == 1)
+      result += log(sigmoids[i]);
+    else
+      result += log(1.0 - sigmoids[i]);
+  }
+
+  // Invert the result, because it's a minimization.
+  return -result + regularization;
+}
+
 //! Evaluate the gradient of the logistic regression objective function.
 template<typename MatType>
 void LogisticRegressionFunction<MatType>::Gradient(
@@ -165,6 +206,112 @@ void LogisticRegressionFunction<MatType>::Gradient(
       * (responses[i] - sigmoid) + regularization;
 }
 
+/**
+ * Evaluate the gradient of the logistic regression objective function with
+ * respect to one sparse point, as a sparse vector, in O(nnz) time when there is
+ * no regularization.
+ */
+template<typename MatType>
+template<typename T>
+typename std::enable_if<arma::is_SpMat<T>::value, void>::type
+LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const size_t i,
+    arma::sp_mat& gradient) const
+{
+  // The regularization term makes the gradient dense.
+  if (lambda != 0.0)
+  {
+    arma::mat denseGradient;
+    Gradient(parameters, i, denseGradient);
+    gradient = arma::sp_mat(denseGradient);
+    return;
+  }
+
+  // Walk the nonzero elements of the point directly.
+  SyncSparse(predictors);
+  const size_t first = predictors.col_ptrs[i];
+  const size_t nnz = predictors.col_ptrs[i + 1] - first;
+
+  double exponent = parameters(0, 0);
+  for (size_t k = first; k < first + nnz; ++k)
+    exponent += predictors.values[k] *
+        parameters[predictors.row_indices[k] + 1];
+  const double error = responses[i] - 1.0 / (1.0 + std::exp(-exponent));
+
+  // The intercept, then one element for each nonzero element of the point.
+  arma::umat locations;
+  locations.zeros(2, nnz + 1);
+  arma::vec values(nnz + 1);
+  values[0] = -error;
+  for (size_t k = 0; k < nnz; ++k)
+  {
+    locations(0, k + 1) = predictors.row_indices[first + k] + 1;
+    values[k + 1] = -predictors.values[first + k] * error;
+  }
+
+  gradient = arma::sp_mat(locations, values, parameters.n_elem, 1);
+}
+
+/**
+ * Give the indices of the parameters that the sparse gradient of one point
+ * depends on, in O(nnz) time when there is no regularization.
+ */
+template<typename MatType>
+template<typename T>
+typename std::enable_if<arma::is_SpMat<T>::value, void>::type
+LogisticRegressionFunction<MatType>::GradientSupport(const size_t i,
+                                                     arma::uvec& support) const
+{
+  // The regularization term makes the gradient dense.
+  if (lambda != 0.0)
+  {
+    support = arma::linspace<arma::uvec>(0, predictors.n_rows,
+        predictors.n_rows + 1);
+    return;
+  }
+
+  // The intercept, then the nonzero elements of the point.
+  SyncSparse(predictors);
+  const size_t first = predictors.col_ptrs[i];
+  const size_t nnz = predictors.col_ptrs[i + 1] - first;
+  support.set_size(nnz + 1);
+  support[0] = 0;
+  for (size_t k = 0; k < nnz; ++k)
+    support[k + 1] = predictors.row_indices[first + k] + 1;
+}
+
+/**
+ * Evaluate the gradient of the logistic regression objective function with
+ * respect to a batch of consecutive points.  This is useful for optimizers
+ * that use mini-batches, such as MiniBatchSGD.
+ */
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  // Calculate the regularization term of the batch.
+  arma::mat regularization;
+  regularization = lambda * parameters.col(0).subvec(1, parameters.n_elem - 1)
+      * batchSize / predictors.n_cols;
+
+  // Calculate the errors of the whole batch at once.
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-parameters(0, 0) -
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t() *
+      predictors.cols(begin, begin + batchSize - 1)));
+  const arma::rowvec errors = arma::conv_to<arma::rowvec>::from(
+      responses.subvec(begin, begin + batchSize - 1)) - sigmoids;
+
+  gradient.set_size(parameters.n_elem);
+  gradient[0] = -arma::accu(errors);
+  gradient.col(0).subvec(1, parameters.n_elem - 1) =
+      -predictors.cols(begin, begin + batchSize - 1) * errors.t() +
+      regularization;
+}
+
 } // namespace regression
 } // namespace mlpack
 
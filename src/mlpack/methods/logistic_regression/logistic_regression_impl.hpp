@@ -97,12 +97,7 @@ void LogisticRegression<MatType>::Predict(const MatType& predictors,
                                           arma::Row<size_t>& responses,
                                           const double decisionBoundary) const
 {
-  // Calculate sigmoid function for each point.  The (1.0 - decisionBoundary)
-  // term correctly sets an offset so that floor() returns 0 or 1 correctly.
-  responses = arma::conv_to<arma::Row<size_t>>::from((1.0 /
-      (1.0 + arma::exp(-parameters(0) - predictors.t() *
-      parameters.subvec(1, parameters.n_elem - 1)))) +
-      (1.0 - decisionBoundary));
+  Score(predictors, responses, decisionBoundary);
 }
 
 template<typename MatType>
@@ -131,18 +126,117 @@ void LogisticRegression<MatType>::Classify(const MatType& dataset,
   // Set correct size of output matrix.
   probabilities.set_size(2, dataset.n_cols);
 
-  probabilities.row(1) = 1.0 / (1.0 + arma::exp(-parameters(0) - dataset.t() *
-      parameters.subvec(1, parameters.n_elem - 1))).t();
+  probabilities.row(1) = 1.0 / (1.0 + arma::exp(-parameters(0) -
+      parameters.subvec(1, parameters.n_elem - 1).t() * dataset));
   probabilities.row(0) = 1.0 - probabilities.row(1);
 }
 
+template<typename MatType>
+template<typename ScoreMatType>
+void LogisticRegression<MatType>::Score(
+    const ScoreMatType& points,
+    arma::Row<typename ScoreMatType::elem_type>& probabilities,
+    arma::Row<size_t>& labels,
+    const double decisionBoundary) const
+{
+  typedef typename ScoreMatType::elem_type ElemType;
+
+  probabilities.set_size(points.n_cols);
+  labels.set_size(points.n_cols);
+  ElemType* probabilitiesMem = probabilities.memptr();
+  size_t* labelsMem = labels.memptr();
+  ScoreColumns(points, [&](const size_t i, const ElemType score)
+  {
+    const ElemType probability = 1 / (1 + std::exp(-score));
+    probabilitiesMem[i] = probability;
+    labelsMem[i] = (probability >= decisionBoundary) ? 1 : 0;
+  });
+}
+
+template<typename MatType>
+template<typename ScoreMatType>
+void LogisticRegression<MatType>::Score(const ScoreMatType& points,
+                                        arma::Row<size_t>& labels,
+                                        const double decisionBoundary) const
+{
+  typedef typename ScoreMatType::elem_type ElemType;
+
+  // The sigmoid of the score is at least the decision boundary if the score is
+  // at least the logit of the boundary, so no exponential is needed.
+  const double logit = (decisionBoundary <= 0.0) ?
+      -std::numeric_limits<double>::infinity() : (decisionBoundary >= 1.0) ?
+      std::numeric_limits<double>::infinity() :
+      std::log(decisionBoundary / (1.0 - decisionBoundary));
+
+  labels.set_size(points.n_cols);
+  size_t* labelsMem = labels.memptr();
+  ScoreColumns(points, [&](const size_t i, const ElemType score)
+  {
+    labelsMem[i] = ((double) score >= logit) ? 1 : 0;
+  });
+}
+
+template<typename MatType>
+template<typename ScoreMatType, typename FunctionType>
+void LogisticRegression<MatType>::ScoreColumns(const ScoreMatType& points,
+                                               FunctionType function) const
+{
+  typedef typename ScoreMatType::elem_type ElemType;
+
+  if (points.n_rows != parameters.n_elem - 1)
+  {
+    std::ostringstream oss;
+    oss << "LogisticRegression::Score(): the points have "
+        << points.n_rows << " dimensions, but the model has "
+        << parameters.n_elem - 1;
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The parameters are converted once to the element type of the points.
+  const arma::Col<ElemType> weights =
+      arma::conv_to<arma::Col<ElemType>>::from(parameters);
+  ThreadPool::ParallelFor(0, points.n_cols, [&](const size_t i)
+  {
+    function(i, LinearScore(points, i, weights));
+  }, 1024);
+}
+
+template<typename MatType>
+template<typename eT>
+eT LogisticRegression<MatType>::LinearScore(const arma::Mat<eT>& points,
+                                            const size_t col,
+                                            const arma::Col<eT>& weights)
+{
+  const eT* point = points.colptr(col);
+  const eT* w = weights.memptr() + 1;
+  eT score = weights[0];
+  for (size_t j = 0; j < points.n_rows; ++j)
+    score += w[j] * point[j];
+
+  return score;
+}
+
+template<typename MatType>
+template<typename eT>
+eT LogisticRegression<MatType>::LinearScore(const arma::SpMat<eT>& points,
+                                            const size_t col,
+                                            const arma::Col<eT>& weights)
+{
+  eT score = weights[0];
+  typename arma::SpMat<eT>::const_iterator it = points.begin_col(col);
+  for (; it != points.end_col(col); ++it)
+    score += weights[it.row() + 1] * (*it);
+
+  return score;
+}
+
 template<typename MatType>
 double LogisticRegression<MatType>::ComputeError(
     const MatType& predictors,
     const arma::Row<size_t>& responses) const
 {
   // Construct a new error function.
-  LogisticRegressionFunction<> newErrorFunction(predictors, responses,
+  LogisticRegressionFunction<MatType> newErrorFunction(predictors, responses,
       lambda);
 
   return newErrorFunction.Evaluate(parameters);
@@ -66,7 +66,15 @@ PROGRAM_INFO("L2-regularized Logistic Regression and Prediction",
     "\n\n"
     "This implementation of logistic regression does not support the general "
     "multi-class case but instead only the two-class case.  Any responses must "
-    "be either 0 or 1.");
+    "be either 0 or 1."
+    "\n\n"
+    "If the training file (or, when no training file is given, the test file) "
+    "is a LIBSVM / SVMlight file (with extension .svm, .libsvm or .svmlight), "
+    "the model is trained and used on the sparse data directly, without "
+    "converting it to a dense matrix.  In that case the labels are read from "
+    "the training file (unless --labels_file is given), and labels greater "
+    "than 0 are taken as class 1 while the others (such as -1) are taken as "
+    "class 0.");
 
 // Training parameters.
 PARAM_STRING("training_file", "A file containing the training set (the matrix "
@@ -102,25 +110,30 @@ PARAM_DOUBLE("decision_boundary", "Decision boundary for prediction; if the "
     "logistic function for a point is less than the boundary, the class is "
     "taken to be 0; otherwise, the class is 1.", "d", 0.5);
 
+// Return whether the given file is a (sparse) LIBSVM / SVMlight file.
+bool IsLibSVMFile(const string& filename)
+{
+  return !filename.empty() && data::IsLibSVMExtension(
+      data::Extension(data::UncompressedName(filename)));
+}
+
+// Helper function to train and use a model on dense or sparse data.
+template<typename MatType>
+void PerformActions();
+
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
 
   // Collect command-line options.
   const string trainingFile = CLI::GetParam<string>("training_file");
-  const string labelsFile = CLI::GetParam<string>("labels_file");
   const double lambda = CLI::GetParam<double>("lambda");
   const string optimizerType = CLI::GetParam<string>("optimizer");
   const double tolerance = CLI::GetParam<double>("tolerance");
   const double stepSize = CLI::GetParam<double>("step_size");
-  const size_t batchSize = (size_t) CLI::GetParam<int>("batch_size");
-  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
   const string inputModelFile = CLI::GetParam<string>("input_model_file");
   const string outputModelFile = CLI::GetParam<string>("output_model_file");
   const string testFile = CLI::GetParam<string>("test_file");
-  const string outputFile = CLI::GetParam<string>("output_file");
-  const string outputProbabilitiesFile =
-      CLI::GetParam<string>("output_probabilities_file");
   const double decisionBoundary = CLI::GetParam<double>("decision_boundary");
 
   // One of inputFile and modelFile must be specified.
@@ -168,31 +181,89 @@ int main(int argc, char** argv)
     Log::Warn << "Batch size (--batch_size) ignored because 'minibatch-sgd' "
         << "optimizer is not being used." << endl;
 
+  // LIBSVM files are loaded as sparse matrices, and then the model is trained
+  // and used on the sparse data directly.  The type of the training set
+  // decides, or the type of the test set if there is no training set.
+  const bool sparse = !trainingFile.empty() ? IsLibSVMFile(trainingFile) :
+      IsLibSVMFile(testFile);
+  if (sparse)
+    PerformActions<arma::sp_mat>();
+  else
+    PerformActions<arma::mat>();
+}
+
+// Move or convert the loaded points to the type used by the model.
+void Assign(arma::mat& from, arma::mat& to) { to.swap(from); }
+void Assign(arma::sp_mat& from, arma::sp_mat& to) { to = from; }
+template<typename FromType, typename ToType>
+void Assign(FromType& from, ToType& to) { to = ToType(from); }
+
+// Load the points of the given file, and their labels if it is a LIBSVM file.
+// LIBSVM labels (often -1 and +1) are mapped to 0 (for nonpositive labels) and
+// 1 (for positive labels).  LIBSVM files don't store trailing zero dimensions,
+// so they get at least the given number of dimensions.
+template<typename MatType>
+void LoadPoints(const string& filename,
+                const size_t dimensionality,
+                MatType& points,
+                arma::Row<size_t>& labels)
+{
+  if (IsLibSVMFile(filename))
+  {
+    arma::sp_mat sparsePoints;
+    arma::Row<double> fileLabels;
+    data::Load(filename, sparsePoints, fileLabels, true);
+    if (sparsePoints.n_rows < dimensionality)
+      sparsePoints.resize(dimensionality, sparsePoints.n_cols);
+
+    labels = arma::conv_to<arma::Row<size_t>>::from(fileLabels > 0.0);
+    Assign(sparsePoints, points);
+  }
+  else
+  {
+    arma::mat densePoints;
+    data::Load(filename, densePoints, true);
+    labels.reset();
+    Assign(densePoints, points);
+  }
+}
+
+template<typename MatType>
+void PerformActions()
+{
+  const string trainingFile = CLI::GetParam<string>("training_file");
+  const string labelsFile = CLI::GetParam<string>("labels_file");
+  const string optimizerType = CLI::GetParam<string>("optimizer");
+  const double tolerance = CLI::GetParam<double>("tolerance");
+  const double stepSize = CLI::GetParam<double>("step_size");
+  const size_t batchSize = (size_t) CLI::GetParam<int>("batch_size");
+  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
+  const string inputModelFile = CLI::GetParam<string>("input_model_file");
+  const string outputModelFile = CLI::GetParam<string>("output_model_file");
+  const string testFile = CLI::GetParam<string>("test_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string outputProbabilitiesFile =
+      CLI::GetParam<string>("output_probabilities_file");
+  const double decisionBoundary = CLI::GetParam<double>("decision_boundary");
+
   // These are the matrices we might use.
-  arma::mat regressors;
+  MatType regressors;
   arma::Mat<size_t> responsesMat;
   arma::Row<size_t> responses;
-  arma::mat testSet;
+  MatType testSet;
   arma::Row<size_t> predictions;
 
-  // Load data matrix.
-  if (!trainingFile.empty())
-    data::Load(trainingFile, regressors, true);
-
   // Load the model, if necessary.
-  LogisticRegression<> model(0, 0); // Empty model.
+  LogisticRegression<MatType> model(0, 0); // Empty model.
   if (!inputModelFile.empty())
-  {
     data::Load(inputModelFile, "logistic_regression_model", model);
-  }
-  else
-  {
-    // Set the size of the parameters vector, if necessary.
-    if (labelsFile.empty())
-      model.Parameters() = arma::zeros<arma::vec>(regressors.n_rows - 1);
-    else
-      model.Parameters() = arma::zeros<arma::vec>(regressors.n_rows);
-  }
+
+  // Load data matrix.  If the model was loaded, the training set has (at least)
+  // its dimensionality.
+  const size_t dimensionality = inputModelFile.empty() ? 0 :
+      model.Parameters().n_elem - 1;
+  if (!trainingFile.empty())
+    LoadPoints(trainingFile, dimensionality, regressors, responses);
 
   // Check if the responses are in a separate file.
   if (!trainingFile.empty() && !labelsFile.empty())
@@ -207,14 +278,21 @@ int main(int argc, char** argv)
       Log::Fatal << "The labels (--labels_file) must have the same number of "
           << "points as the training dataset (--training_file)." << endl;
   }
-  else if (!trainingFile.empty())
+  else if (!trainingFile.empty() && responses.n_elem == 0)
   {
     // The initial predictors for y, Nx1.
     responses = arma::conv_to<arma::Row<size_t>>::from(
-        regressors.row(regressors.n_rows - 1));
+        arma::rowvec(regressors.row(regressors.n_rows - 1)));
     regressors.shed_row(regressors.n_rows - 1);
   }
 
+  // Set the size of the parameters vector, if necessary.
+  if (inputModelFile.empty())
+    model.Parameters() = arma::zeros<arma::vec>(regressors.n_rows + 1);
+  else if (!trainingFile.empty() && regressors.n_rows != dimensionality)
+    Log::Fatal << "The training set (--training_file) has " << regressors.n_rows
+        << " dimensions, but the model has " << dimensionality << "!" << endl;
+
   // Verify the labels.
   if (!trainingFile.empty() && max(responses) > 1)
     Log::Fatal << "The labels must be either 0 or 1, not " << max(responses)
@@ -223,10 +301,11 @@ int main(int argc, char** argv)
   // Now, do the training.
   if (!trainingFile.empty())
   {
-    LogisticRegressionFunction<> lrf(regressors, responses, model.Parameters());
+    LogisticRegressionFunction<MatType> lrf(regressors, responses,
+        model.Parameters());
     if (optimizerType == "sgd")
     {
-      SGD<LogisticRegressionFunction<>> sgdOpt(lrf);
+      SGD<LogisticRegressionFunction<MatType>> sgdOpt(lrf);
       sgdOpt.MaxIterations() = maxIterations;
       sgdOpt.Tolerance() = tolerance;
       sgdOpt.StepSize() = stepSize;
@@ -237,7 +316,7 @@ int main(int argc, char** argv)
     }
     else if (optimizerType == "lbfgs")
     {
-      L_BFGS<LogisticRegressionFunction<>> lbfgsOpt(lrf);
+      L_BFGS<LogisticRegressionFunction<MatType>> lbfgsOpt(lrf);
       lbfgsOpt.MaxIterations() = maxIterations;
       lbfgsOpt.MinGradientNorm() = tolerance;
       Log::Info << "Training model with L-BFGS optimizer." << endl;
@@ -247,7 +326,7 @@ int main(int argc, char** argv)
     }
     else if (optimizerType == "minibatch-sgd")
     {
-      MiniBatchSGD<LogisticRegressionFunction<>> mbsgdOpt(lrf);
+      MiniBatchSGD<LogisticRegressionFunction<MatType>> mbsgdOpt(lrf);
       mbsgdOpt.BatchSize() = batchSize;
       mbsgdOpt.Tolerance() = tolerance;
       mbsgdOpt.StepSize() = stepSize;
@@ -261,27 +340,39 @@ int main(int argc, char** argv)
 
   if (!testFile.empty())
   {
-    data::Load(testFile, testSet, true);
+    arma::Row<size_t> testLabels;
+    LoadPoints(testFile, model.Parameters().n_elem - 1, testSet, testLabels);
+    if (testSet.n_rows != model.Parameters().n_elem - 1)
+      Log::Fatal << "The test set (--test_file) has " << testSet.n_rows
+          << " dimensions, but the model has " << model.Parameters().n_elem - 1
+          << "!" << endl;
 
     // We must perform predictions on the test set.  Training (and the
-    // optimizer) are irrelevant here; we'll pass in the model we have.
-    if (!outputFile.empty())
-    {
-      Log::Info << "Predicting classes of points in '" << testFile << "'."
-          << endl;
-      model.Classify(testSet, predictions, decisionBoundary);
-
-      data::Save(outputFile, predictions, false);
-    }
-
+    // optimizer) are irrelevant here; we'll pass in the model we have.  If
+    // both the classes and the probabilities are wanted, they are computed in
+    // the same pass.
     if (!outputProbabilitiesFile.empty())
     {
       Log::Info << "Calculating class probabilities of points in '" << testFile
           << "'." << endl;
-      arma::mat probabilities;
-      model.Classify(testSet, probabilities);
+      arma::rowvec probabilities;
+      model.Score(testSet, probabilities, predictions, decisionBoundary);
 
-      data::Save(outputProbabilitiesFile, probabilities, false);
+      if (!outputFile.empty())
+        data::Save(outputFile, predictions, false);
+
+      arma::mat classProbabilities(2, probabilities.n_elem);
+      classProbabilities.row(0) = 1.0 - probabilities;
+      classProbabilities.row(1) = probabilities;
+      data::Save(outputProbabilitiesFile, classProbabilities, false);
+    }
+    else if (!outputFile.empty())
+    {
+      Log::Info << "Predicting classes of points in '" << testFile << "'."
+          << endl;
+      model.Score(testSet, predictions, decisionBoundary);
+
+      data::Save(outputFile, predictions, false);
     }
   }
 
@@ -67,8 +67,11 @@ PARAM_DOUBLE("hash_width", "The hash width for the first-level hashing in the "
 PARAM_INT("second_hash_size", "The size of the second level hash table.", "S",
     99901);
 PARAM_INT("bucket_size", "The maximum size of a bucket in the second level "
-    "hash; 0 indicates no limit (so the table can be arbitrarily large!).", "B",
-    500);
+    "hash; 0 indicates no limit.", "B", 0);
+PARAM_INT("num_probes", "Number of additional buckets to probe in each "
+    "search (multi-probe LSH).  With a few probes, far fewer tables are needed "
+    "for the same recall.  If 0, only the bucket of the query in each table is "
+    "searched.", "T", 0);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 int main(int argc, char *argv[])
@@ -92,6 +95,12 @@ int main(int argc, char *argv[])
   size_t secondHashSize = CLI::GetParam<int>("second_hash_size");
   size_t bucketSize = CLI::GetParam<int>("bucket_size");
 
+  if (CLI::GetParam<int>("num_probes") < 0)
+    Log::Fatal << "Invalid number of probes ("
+        << CLI::GetParam<int>("num_probes") << "); must be non-negative."
+        << endl;
+  const size_t numProbes = CLI::GetParam<int>("num_probes");
+
   if (CLI::HasParam("input_model_file") && CLI::HasParam("reference_file"))
   {
     Log::Fatal << "Cannot specify both --reference_file and --input_model_file!"
@@ -180,11 +189,11 @@ int main(int argc, char *argv[])
         Log::Info << "Loaded query data from '" << queryFile << "' ("
             << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
       }
-      allkann.Search(queryData, k, neighbors, distances);
+      allkann.Search(queryData, k, neighbors, distances, 0, numProbes);
     }
     else
     {
-      allkann.Search(k, neighbors, distances);
+      allkann.Search(k, neighbors, distances, 0, numProbes);
     }
   }
 
@@ -29,6 +29,10 @@
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
+
+#include "pstable_hash.hpp"
+#include "sim_hash.hpp"
 
 namespace mlpack {
 namespace neighbor {
@@ -38,9 +42,22 @@ namespace neighbor {
  * this hash to compute the distance-approximate nearest-neighbors of the given
  * queries.
  *
+ * If OpenMP is available, the hash tables are built in parallel in Train(), and
+ * blocks of query points are searched in parallel in Search().  The results do
+ * not depend on the number of threads.
+ *
+ * The family of hash functions is given by the HashType policy.  By default,
+ * PStableHash is used, which searches for the neighbors in Euclidean distance.
+ * SimHash packs the sign bits of the projections of each table into a 64-bit
+ * word and returns the Hamming distances between the words, for the cosine
+ * distance; see the PStableHash class for the functions a hash family must
+ * implement.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam HashType The family of hash functions; see PStableHash and SimHash.
  */
-template<typename SortPolicy = NearestNeighborSort>
+template<typename SortPolicy = NearestNeighborSort,
+         typename HashType = PStableHash>
 class LSHSearch
 {
  public:
@@ -59,16 +76,15 @@ class LSHSearch
    *     upper bound on the nearest-neighbor distance in general.
    * @param secondHashSize The size of the second hash table. This should be a
    *     large prime number.
-   * @param bucketSize The size of the bucket in the second hash table. This is
-   *     the maximum number of points that can be hashed into single bucket.  A
-   *     value of 0 indicates that there is no limit (so the second hash table
-   *     can be arbitrarily large---be careful!).
+   * @param bucketSize The maximum number of points that are kept in a single
+   *     bucket of the second hash table; points beyond that are dropped.  A
+   *     value of 0 (the default) indicates that there is no limit.
    */
   LSHSearch(const arma::mat& referenceSet,
             const arma::cube& projections,
             const double hashWidth = 0.0,
             const size_t secondHashSize = 99901,
-            const size_t bucketSize = 500);
+            const size_t bucketSize = 0);
 
   /**
    * This function initializes the LSH class. It builds the hash one the
@@ -86,17 +102,39 @@ class LSHSearch
    *     upper bound on the nearest-neighbor distance in general.
    * @param secondHashSize The size of the second hash table. This should be a
    *     large prime number.
-   * @param bucketSize The size of the bucket in the second hash table. This is
-   *     the maximum number of points that can be hashed into single bucket.  A
-   *     value of 0 indicates that there is no limit (so the second hash table
-   *     can be arbitrarily large---be careful!).
+   * @param bucketSize The maximum number of points that are kept in a single
+   *     bucket of the second hash table; points beyond that are dropped.  A
+   *     value of 0 (the default) indicates that there is no limit.
    */
   LSHSearch(const arma::mat& referenceSet,
             const size_t numProj,
             const size_t numTables,
             const double hashWidth = 0.0,
             const size_t secondHashSize = 99901,
-            const size_t bucketSize = 500);
+            const size_t bucketSize = 0);
+
+  /**
+   * Initialize the LSH class with a reference set that may be shared with other
+   * objects (for instance, with other search models on the same points).  The
+   * reference set is never copied or modified (until Insert() is called), and
+   * the object holds on to it for as long as it uses it, so it is only freed
+   * when the last object sharing it is done with it.  The parameters are the
+   * same as for the constructor above.
+   *
+   * @param referenceSet Shared set of reference points (must not be NULL).
+   * @param numProj Number of projections in each hash table.
+   * @param numTables Total number of hash tables.
+   * @param hashWidth The width of hash for every table (0 to compute it).
+   * @param secondHashSize The size of the second hash table.
+   * @param bucketSize The maximum number of points that are kept in a single
+   *     bucket of the second hash table (0 for no limit).
+   */
+  LSHSearch(std::shared_ptr<const arma::mat> referenceSet,
+            const size_t numProj,
+            const size_t numTables,
+            const double hashWidth = 0.0,
+            const size_t secondHashSize = 99901,
+            const size_t bucketSize = 0);
 
   /**
    * Create an untrained LSH model.  Be sure to call Train() before calling
@@ -125,10 +163,9 @@ class LSHSearch
    *     upper bound on the nearest-neighbor distance in general.
    * @param secondHashSize The size of the second hash table. This should be a
    *     large prime number.
-   * @param bucketSize The size of the bucket in the second hash table. This is
-   *     the maximum number of points that can be hashed into single bucket.  A
-   *     value of 0 indicates that there is no limit (so the second hash table
-   *     can be arbitrarily large---be careful!).
+   * @param bucketSize The maximum number of points that are kept in a single
+   *     bucket of the second hash table; points beyond that are dropped.  A
+   *     value of 0 (the default) indicates that there is no limit.
    * @param projections Cube of projection tables. For a cube of size (a, b, c)
    *     we set numProj = a, numTables = c. b is the reference set
    *     dimensionality.
@@ -138,9 +175,58 @@ class LSHSearch
              const size_t numTables,
              const double hashWidth = 0.0,
              const size_t secondHashSize = 99901,
-             const size_t bucketSize = 500,
+             const size_t bucketSize = 0,
+             const arma::cube& projection = arma::cube());
+
+  /**
+   * Train the LSH model on the given reference set, which may be shared with
+   * other objects; the object holds on to the set for as long as it uses it.
+   * The other parameters are the same as for the Train() method above.
+   *
+   * @param referenceSet Shared set of reference points (must not be NULL).
+   * @param numProj Number of projections in each hash table.
+   * @param numTables Total number of hash tables.
+   * @param hashWidth The width of hash for every table (0 to compute it).
+   * @param secondHashSize The size of the second hash table.
+   * @param bucketSize The maximum number of points that are kept in a single
+   *     bucket of the second hash table (0 for no limit).
+   * @param projections Cube of projection tables.
+   */
+  void Train(std::shared_ptr<const arma::mat> referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double hashWidth = 0.0,
+             const size_t secondHashSize = 99901,
+             const size_t bucketSize = 0,
              const arma::cube& projection = arma::cube());
 
+  /**
+   * Add the given points to the reference set, and hash them into the existing
+   * hash tables and buckets, without retraining the model.  The new points get
+   * the next indices, so the first new point has index n, where n is the
+   * number of points in the reference set before the call.  The reference set
+   * is copied (and owned by this object from then on), and the buckets are
+   * rebuilt around the new points, so it is much cheaper to insert many points
+   * at once than one at a time.  A std::invalid_argument is thrown if the
+   * model is not trained or the points have the wrong dimensionality.
+   *
+   * @param newPoints Points to add to the reference set.
+   */
+  void Insert(const arma::mat& newPoints);
+
+  /**
+   * Remove the points with the given indices from the buckets, so that they
+   * are not returned by Search() anymore.  The points stay in the reference
+   * set, so the indices of the other points don't change (and removed indices
+   * are not reused by Insert()).  Removing a point that was already removed has
+   * no effect, but a std::invalid_argument is thrown if an index is not a point
+   * of the reference set.  Retraining the model (with Train() or
+   * Projections()) hashes all points of the reference set again.
+   *
+   * @param indices Indices of the points to remove.
+   */
+  void Remove(const arma::uvec& indices);
+
   /**
    * Compute the nearest neighbors of the points in the given query set and
    * store the output in the given matrices.  The matrices will be set to the
@@ -159,12 +245,19 @@ class LSHSearch
    *     available without having to build hashing for every table size.
    *     By default, this is set to zero in which case all tables are
    *     considered.
+   * @param numProbes Number of additional buckets to probe (multi-probe LSH).
+   *     Besides the bucket of the query in each table, the buckets of the
+   *     numProbes perturbed keys (over all tables) that are most likely to
+   *     hold near neighbors are searched too.  This gives the same recall
+   *     with far fewer tables.  By default, this is zero, and only the bucket
+   *     of the query in each table is searched.
    */
   void Search(const arma::mat& querySet,
               const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
-              const size_t numTablesToSearch = 0);
+              const size_t numTablesToSearch = 0,
+              const size_t numProbes = 0);
 
   /**
    * Compute the nearest neighbors and store the output in the given matrices.
@@ -183,11 +276,14 @@ class LSHSearch
    *     available without having to build hashing for every table size.
    *     By default, this is set to zero in which case all tables are
    *     considered.
+   * @param numProbes Number of additional buckets to probe (multi-probe LSH);
+   *     see the other overload of Search().
    */
   void Search(const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
-              const size_t numTablesToSearch = 0);
+              const size_t numTablesToSearch = 0,
+              const size_t numProbes = 0);
 
   /**
    * Compute the recall (% of neighbors found) given the neighbors returned by
@@ -221,7 +317,11 @@ class LSHSearch
   size_t NumProjections() const { return projections.n_slices; }
 
   //! Get the offsets 'b' for each of the projections.  (One 'b' per column.)
-  const arma::mat& Offsets() const { return offsets; }
+  //! This is only available with the PStableHash family.
+  const arma::mat& Offsets() const { return hash.Offsets(); }
+
+  //! Get the family of hash functions.
+  const HashType& Hash() const { return hash; }
 
   //! Get the weights of the second hash.
   const arma::vec& SecondHashWeights() const { return secondHashWeights; }
@@ -229,9 +329,14 @@ class LSHSearch
   //! Get the bucket size of the second hash.
   size_t BucketSize() const { return bucketSize; }
 
-  //! Get the second hash table.
-  const std::vector<arma::Col<size_t>>& SecondHashTable() const
-      { return secondHashTable; }
+  //! Get the offsets of the buckets of the second hash table.  The points in
+  //! bucket i are BucketContents()[BucketOffsets()[i]] up to (but not
+  //! including) BucketContents()[BucketOffsets()[i + 1]].
+  const arma::Col<size_t>& BucketOffsets() const { return bucketOffsets; }
+
+  //! Get the points in all the buckets of the second hash table, bucket after
+  //! bucket.
+  const arma::Col<size_t>& BucketContents() const { return bucketContents; }
 
   //! Get the projection tables.
   const arma::cube& Projections() { return projections; }
@@ -240,7 +345,7 @@ class LSHSearch
   void Projections(const arma::cube& projTables)
   {
     // Simply call Train() with the given projection tables.
-    Train(*referenceSet, numProj, numTables, hashWidth, secondHashSize,
+    Train(*referenceSet, numProj, numTables, hash.HashWidth(), secondHashSize,
         bucketSize, projTables);
   }
 
@@ -250,78 +355,128 @@ class LSHSearch
 
  private:
   /**
-   * This function takes a query and hashes it into each of the hash tables to
-   * get keys for the query and then the key is hashed to a bucket of the second
-   * hash table and all the points (if any) in those buckets are collected as
-   * the potential neighbor candidates.
+   * Hash each of the given points into each of the hash tables, and then hash
+   * its key in each table to a bucket of the second hash table.  The keys are
+   * also given to the hash family, as the keys of the reference points begin
+   * to (begin + points.n_cols - 1).
+   *
+   * @param points Points to hash.
+   * @param begin Index of the first point in the reference set.
+   * @param secondHashVectors The bucket of each point (column) in each table
+   *     (row).
+   */
+  void HashPoints(const arma::mat& points,
+                  const size_t begin,
+                  arma::Mat<size_t>& secondHashVectors);
+
+  /**
+   * This function hashes the given queries into each of the first
+   * 'numTablesToSearch' hash tables and returns, for each query, its keys in
+   * each table and the distances from the query to the boundaries of those
+   * keys (see HashType::Hash()).  The keys in each table are computed for all
+   * the queries at once.
+   *
+   * @param queries The queries to hash.
+   * @param numTablesToSearch The number of tables to hash into.
+   * @param keys The keys; slice i holds the keys of query i, with one column
+   *     for each table.
+   * @param lowerDistances The distances to the lower boundaries of the keys,
+   *     laid out as the keys.
+   * @param upperDistances The distances to the upper boundaries of the keys,
+   *     laid out as the keys.
+   */
+  void HashQueries(const arma::mat& queries,
+                   const size_t numTablesToSearch,
+                   arma::cube& keys,
+                   arma::cube& lowerDistances,
+                   arma::cube& upperDistances) const;
+
+  /**
+   * This function takes the keys of a query in each of the hash tables (see
+   * HashQueries()), and then the key of the query in each table is hashed to a
+   * bucket of the second hash table and all the points (if any) in those
+   * buckets are collected as the potential neighbor candidates.
    *
-   * @param queryPoint The query point currently being processed.
+   * @param keys The keys of the query in each of the tables to search.
+   * @param lowerDistances The distances to the lower boundaries of the keys.
+   * @param upperDistances The distances to the upper boundaries of the keys.
    * @param referenceIndices The list of neighbor candidates obtained from
    *    hashing the query into all the hash tables and eventually into
    *    multiple buckets of the second hash table.
+   * @param numProbes The number of additional buckets to probe.
    */
-  template<typename VecType>
-  void ReturnIndicesFromTable(const VecType& queryPoint,
+  void ReturnIndicesFromTable(const arma::mat& keys,
+                              const arma::mat& lowerDistances,
+                              const arma::mat& upperDistances,
                               arma::uvec& referenceIndices,
-                              size_t numTablesToSearch) const;
+                              const size_t numProbes) const;
 
   /**
-   * This is a helper function that computes the distance of the query to the
-   * neighbor candidates and appropriately stores the best 'k' candidates.  This
-   * is specific to the monochromatic search case, where the query set is the
-   * reference set.
+   * Find the perturbed keys of the query that are most likely to hash to
+   * buckets with near neighbors and append their second hash values to the
+   * given list of buckets.  This is the query-directed probing sequence of
+   * multi-probe LSH:
    *
-   * @param queryIndex The index of the query in question
-   * @param referenceIndex The index of the neighbor candidate in question
-   * @param neighbors Matrix holding output neighbors.
-   * @param distances Matrix holding output distances.
-   */
-  void BaseCase(const size_t queryIndex,
-                const size_t referenceIndex,
-                arma::Mat<size_t>& neighbors,
-                arma::mat& distances) const;
-
-  /**
-   * This is a helper function that computes the distance of the query to the
-   * neighbor candidates and appropriately stores the best 'k' candidates.  This
-   * is specific to bichromatic search, where the query set is not the same as
-   * the reference set.
+   * @inproceedings{lv2007multi,
+   *   title={Multi-probe {LSH}: efficient indexing for high-dimensional
+   *       similarity search},
+   *   author={Lv, Q. and Josephson, W. and Wang, Z. and Charikar, M. and Li,
+   *       K.},
+   *   booktitle={Proceedings of the 33rd International Conference on Very
+   *       Large Data Bases},
+   *   pages={950--961},
+   *   year={2007}
+   * }
    *
-   * @param queryIndex The index of the query in question
-   * @param referenceIndex The index of the neighbor candidate in question
-   * @param querySet Set of query points.
-   * @param neighbors Matrix holding output neighbors.
-   * @param distances Matrix holding output distances.
+   * Each coordinate of the key of a table can be moved by -1 or +1, and a set
+   * of moves is scored by the sum of the squared distances from the query to
+   * the boundaries it crosses.  Moves whose distance is DBL_MAX are not
+   * possible.  The numProbes best sets of moves over all tables are used.
+   *
+   * @param lowerDistances Distance from the query to the lower boundary of its
+   *     key along each projection (row), for each table (column).
+   * @param upperDistances Distance from the query to the upper boundary of its
+   *     key along each projection, for each table.
+   * @param unreducedHashVec Second hash value of the key of the query in each
+   *     table, before the modulus.
+   * @param numProbes Number of additional buckets to return.
+   * @param hashVec List of buckets to append to.
    */
-  void BaseCase(const size_t queryIndex,
-                const size_t referenceIndex,
-                const arma::mat& querySet,
-                arma::Mat<size_t>& neighbors,
-                arma::mat& distances) const;
+  void GetAdditionalProbingBins(const arma::mat& lowerDistances,
+                                const arma::mat& upperDistances,
+                                const arma::rowvec& unreducedHashVec,
+                                const size_t numProbes,
+                                std::vector<size_t>& hashVec) const;
 
   /**
-   * This is a helper function that efficiently inserts better neighbor
-   * candidates into an existing set of neighbor candidates. This function is
-   * only called by the 'BaseCase' function.
+   * Compute the distance of the query to the neighbor candidates with the hash
+   * family and store the best candidates in the given columns of the output
+   * matrices, skipping the candidate with index 'skip' (the query itself, for
+   * monochromatic search).
    *
-   * @param distances Matrix holding output distances.
-   * @param neighbors Matrix holding output neighbors.
-   * @param queryIndex This is the index of the query being processed currently
-   * @param pos The position of the neighbor candidate in the current list of
-   *    neighbor candidates.
-   * @param neighbor The neighbor candidate that is being inserted into the list
-   *    of the best 'k' candidates for the query in question.
-   * @param distance The distance of the query to the neighbor candidate.
+   * @param query The query point.
+   * @param queryKeys The keys of the query in the searched tables.
+   * @param candidates The indices of the neighbor candidates.
+   * @param skip Index of a candidate to skip (or the number of reference
+   *     points, to skip none).
+   * @param neighbors Column of the output neighbors of the query.
+   * @param distances Column of the output distances of the query.
+   * @param k Number of neighbors to search for.
    */
-  void InsertNeighbor(arma::mat& distances,
-                      arma::Mat<size_t>& neighbors,
-                      const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance) const;
+  template<typename VecType>
+  void BaseCase(const VecType& query,
+                const arma::mat& queryKeys,
+                const arma::uvec& candidates,
+                const size_t skip,
+                size_t* neighbors,
+                double* distances,
+                const size_t k) const;
 
   //! Reference dataset.
   const arma::mat* referenceSet;
+  //! The shared reference dataset, if we were given one; this keeps it alive
+  //! for as long as we refer to it.
+  std::shared_ptr<const arma::mat> sharedReferenceSet;
   //! If true, we own the reference set.
   bool ownsSet;
 
@@ -333,11 +488,9 @@ class LSHSearch
   //! The arma::cube containing the projection matrix of each table.
   arma::cube projections; // should be [numProj x dims] x numTables slices
 
-  //! The list of the offsets 'b' for each of the projection for each table.
-  arma::mat offsets; // should be numProj x numTables
-
-  //! The hash width.
-  double hashWidth;
+  //! The family of hash functions (which holds any other parameters of the
+  //! hash functions, such as the offsets and the hash width of PStableHash).
+  HashType hash;
 
   //! The big prime representing the size of the second hash.
   size_t secondHashSize;
@@ -348,17 +501,13 @@ class LSHSearch
   //! The bucket size of the second hash.
   size_t bucketSize;
 
-  //! The final hash table; should be (< secondHashSize) vectors each with
-  //! (<= bucketSize) elements.
-  std::vector<arma::Col<size_t>> secondHashTable;
-
-  //! The number of elements present in each hash bucket; should be
-  //! secondHashSize.
-  arma::Col<size_t> bucketContentSize;
+  //! The offset of each bucket of the second hash in bucketContents, plus the
+  //! total number of elements at the end; length secondHashSize + 1.
+  arma::Col<size_t> bucketOffsets;
 
-  //! For a particular hash value, points to the row in secondHashTable
-  //! corresponding to this value. Length secondHashSize.
-  arma::Col<size_t> bucketRowInHashTable;
+  //! The points in each bucket of the second hash, stored contiguously bucket
+  //! after bucket.
+  arma::Col<size_t> bucketContents;
 
   //! The number of distance evaluations.
   size_t distanceEvaluations;
@@ -368,8 +517,9 @@ class LSHSearch
 } // namespace mlpack
 
 //! Set the serialization version of the LSHSearch class.
-BOOST_TEMPLATE_CLASS_VERSION(template<typename SortPolicy>,
-    mlpack::neighbor::LSHSearch<SortPolicy>, 1);
+BOOST_TEMPLATE_CLASS_VERSION(
+    template<typename SortPolicy MLPACK_COMMA typename HashType>,
+    mlpack::neighbor::LSHSearch<SortPolicy MLPACK_COMMA HashType>, 2);
 
 // Include implementation.
 #include "lsh_search_impl.hpp"
@@ -8,13 +8,14 @@
 #define MLPACK_METHODS_NEIGHBOR_SEARCH_LSH_SEARCH_IMPL_HPP
 
 #include <mlpack/core.hpp>
+#include <queue>
 
 namespace mlpack {
 namespace neighbor {
 
 // Construct the object with random tables
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::
 LSHSearch(const arma::mat& referenceSet,
           const size_t numProj,
           const size_t numTables,
@@ -25,7 +26,6 @@ LSHSearch(const arma::mat& referenceSet,
   ownsSet(false),
   numProj(numProj),
   numTables(numTables),
-  hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
   distanceEvaluations(0)
@@ -35,9 +35,31 @@ LSHSearch(const arma::mat& referenceSet,
       bucketSize);
 }
 
+// Construct the object with random tables on a shared reference set.
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::
+LSHSearch(std::shared_ptr<const arma::mat> referenceSet,
+          const size_t numProj,
+          const size_t numTables,
+          const double hashWidthIn,
+          const size_t secondHashSize,
+          const size_t bucketSize) :
+  referenceSet(NULL), // This will be set in Train().
+  ownsSet(false),
+  numProj(numProj),
+  numTables(numTables),
+  secondHashSize(secondHashSize),
+  bucketSize(bucketSize),
+  distanceEvaluations(0)
+{
+  // Pass work to training function.
+  Train(std::move(referenceSet), numProj, numTables, hashWidthIn,
+      secondHashSize, bucketSize);
+}
+
 // Construct the object with given tables
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::
 LSHSearch(const arma::mat& referenceSet,
           const arma::cube& projections,
           const double hashWidthIn,
@@ -47,7 +69,6 @@ LSHSearch(const arma::mat& referenceSet,
   ownsSet(false),
   numProj(projections.n_cols),
   numTables(projections.n_slices),
-  hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
   distanceEvaluations(0)
@@ -58,91 +79,86 @@ LSHSearch(const arma::mat& referenceSet,
 }
 
 // Empty constructor.
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::LSHSearch() :
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::LSHSearch() :
     referenceSet(new arma::mat()), // Use an empty dataset.
     ownsSet(true),
     numProj(0),
     numTables(0),
-    hashWidth(0),
     secondHashSize(99901),
-    bucketSize(500),
+    bucketSize(0),
     distanceEvaluations(0)
 {
   // Nothing to do.
 }
 
 // Destructor.
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::~LSHSearch()
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::~LSHSearch()
 {
   if (ownsSet)
     delete referenceSet;
 }
 
+// Train on a new, shared reference set.
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Train(
+    std::shared_ptr<const arma::mat> referenceSet,
+    const size_t numProj,
+    const size_t numTables,
+    const double hashWidthIn,
+    const size_t secondHashSize,
+    const size_t bucketSize,
+    const arma::cube& projection)
+{
+  Train(*referenceSet, numProj, numTables, hashWidthIn, secondHashSize,
+      bucketSize, projection);
+  sharedReferenceSet = std::move(referenceSet);
+}
+
 // Train on a new reference set.
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
-                                  const size_t numProj,
-                                  const size_t numTables,
-                                  const double hashWidthIn,
-                                  const size_t secondHashSize,
-                                  const size_t bucketSize,
-                                  const arma::cube &projection)
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Train(const arma::mat& referenceSet,
+                                            const size_t numProj,
+                                            const size_t numTables,
+                                            const double hashWidthIn,
+                                            const size_t secondHashSize,
+                                            const size_t bucketSize,
+                                            const arma::cube &projection)
 {
-  // Set new reference set.
-  if (this->referenceSet && ownsSet)
-    delete this->referenceSet;
-  this->referenceSet = &referenceSet;
-  this->ownsSet = false;
+  // Set new reference set.  (If we are retrained on our own reference set, for
+  // instance by Projections(), we keep it.)
+  if (this->referenceSet != &referenceSet)
+  {
+    if (this->referenceSet && ownsSet)
+      delete this->referenceSet;
+    this->referenceSet = &referenceSet;
+    this->ownsSet = false;
+    sharedReferenceSet.reset();
+  }
 
   // Set new parameters.
   this->numProj = numProj;
   this->numTables = numTables;
-  this->hashWidth = hashWidthIn;
   this->secondHashSize = secondHashSize;
   this->bucketSize = bucketSize;
 
-  if (hashWidth == 0.0) // The user has not provided any value.
-  {
-    // Compute a heuristic hash width from the data.
-    for (size_t i = 0; i < 25; i++)
-    {
-      size_t p1 = (size_t) math::RandInt(referenceSet.n_cols);
-      size_t p2 = (size_t) math::RandInt(referenceSet.n_cols);
-
-      hashWidth += std::sqrt(metric::EuclideanDistance::Evaluate(
-          referenceSet.unsafe_col(p1), referenceSet.unsafe_col(p2)));
-    }
-
-    hashWidth /= 25;
-  }
-
-  Log::Info << "Hash width chosen as: " << hashWidth << std::endl;
-
   // Hash building procedure:
   // The first level hash for a single table outputs a 'numProj'-dimensional
   // integer key for each point in the set -- (key, pointID).  The key creation
-  // details are presented below.
+  // details are given by the hash family.
 
   // Step I: Prepare the second level hash.
 
-  // Obtain the weights for the second hash.
+  // Obtain the weights for the second hash.  They are drawn before anything
+  // else, so that the random draws are in the same order as before hash
+  // families were introduced (when the hash width is given).
   secondHashWeights = arma::floor(arma::randu(numProj) *
                                   (double) secondHashSize);
 
-  // Instead of putting the points in the row corresponding to the bucket, we
-  // chose the next empty row and keep track of the row in which the bucket
-  // lies. This allows us to stack together and slice out the empty buckets at
-  // the end of the hashing.
-  bucketRowInHashTable.set_size(secondHashSize);
-  bucketRowInHashTable.fill(secondHashSize);
-
-  // Step II: The offsets for all projections in all tables.
-  // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
-  // as randu(numProj, numTables) * hashWidth.
-  offsets.randu(numProj, numTables);
-  offsets *= hashWidth;
+  // Step II: Prepare the hash family (for instance, the offsets and the hash
+  // width of PStableHash).
+  hash.Train(referenceSet, numProj, numTables, hashWidthIn);
 
   // Step III: Obtain the 'numProj' projections for each table.
   projections.clear(); // Reset projections vector.
@@ -150,7 +166,8 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
   if (projection.n_slices == 0) // Randomly generate the tables.
   {
     // For L2 metric, 2-stable distributions are used, and the normal Z ~ N(0,
-    // 1) is a 2-stable distribution.
+    // 1) is a 2-stable distribution.  (For SimHash, the normals of the random
+    // hyperplanes are drawn from the same distribution.)
 
     // Build numTables random tables arranged in a cube.
     projections.randn(referenceSet.n_rows, numProj, numTables);
@@ -165,219 +182,299 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
         "tables provided must be equal to numProj");
   }
 
-  // We will store the second hash vectors in this matrix; the second hash
-  // vector for table i will be held in row i.
-  arma::Mat<size_t> secondHashVectors(numTables, referenceSet.n_cols);
-
-  for (size_t i = 0; i < numTables; i++)
-  {
-    // Step IV: create the 'numProj'-dimensional key for each point in each
-    // table.
-
-    // The following code performs the task of hashing each point to a
-    // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x
-    // 'referenceSet.n_cols') key matrix.
-    //
-    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
-    // and the corresponding offset be 'offset_i'.  Then the key of a single
-    // point is obtained as:
-    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
-    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
-                                       referenceSet.n_cols);
-    arma::mat hashMat = projections.slice(i).t() * (referenceSet);
-    hashMat += offsetMat;
-    hashMat /= hashWidth;
-
-    // Step V: Putting the points in the 'secondHashTable' by hashing the key.
-    // Now we hash every key, point ID to its corresponding bucket.
-    secondHashVectors.row(i) = arma::conv_to<arma::Row<size_t>>::from(
-        secondHashWeights.t() * arma::floor(hashMat));
-  }
-
-  // Normalize hashes (take modulus with secondHashSize).
-  secondHashVectors.transform([secondHashSize](size_t val)
-      { return val % secondHashSize; });
+  // Step IV: hash every point in every table to a bucket of the second hash
+  // table.
+  arma::Mat<size_t> secondHashVectors;
+  HashPoints(referenceSet, 0, secondHashVectors);
 
-  // Now, using the hash vectors for each table, count the number of rows we
-  // have in the second hash table.
-  arma::Row<size_t> secondHashBinCounts(secondHashSize, arma::fill::zeros);
+  // The buckets are stored contiguously, so they are built in two passes.
+  // First, count the number of points in each bucket, and compute the offsets
+  // of the buckets from the counts.
+  arma::Col<size_t> secondHashBinCounts(secondHashSize, arma::fill::zeros);
   for (size_t i = 0; i < secondHashVectors.n_elem; ++i)
     secondHashBinCounts[secondHashVectors[i]]++;
 
-  // Enforce the maximum bucket size.
-  const size_t effectiveBucketSize = (bucketSize == 0) ? SIZE_MAX : bucketSize;
-  secondHashBinCounts.transform([effectiveBucketSize](size_t val)
-      { return std::min(val, effectiveBucketSize); });
+  // Enforce the maximum bucket size, if there is one.
+  if (bucketSize > 0)
+    secondHashBinCounts.transform([bucketSize](size_t val)
+        { return std::min(val, bucketSize); });
 
-  const size_t numRowsInTable = arma::accu(secondHashBinCounts > 0);
-  bucketContentSize.zeros(numRowsInTable);
-  secondHashTable.resize(numRowsInTable);
+  bucketOffsets.set_size(secondHashSize + 1);
+  bucketOffsets[0] = 0;
+  for (size_t i = 0; i < secondHashSize; ++i)
+    bucketOffsets[i + 1] = bucketOffsets[i] + secondHashBinCounts[i];
 
-  // Next we must assign each point in each table to the right second hash
-  // table.
-  size_t currentRow = 0;
+  // Second, put each point of each table into its bucket, in order of tables
+  // and then points.  secondHashBinCounts is reused to hold the number of
+  // points still to be put into each bucket.
+  bucketContents.set_size(bucketOffsets[secondHashSize]);
   for (size_t i = 0; i < numTables; ++i)
   {
-    // Insert the point in the corresponding row to its bucket in the
-    // 'secondHashTable'.
-    for (size_t j = 0; j < secondHashVectors.n_cols; j++)
+    for (size_t j = 0; j < secondHashVectors.n_cols; ++j)
     {
       // This is the bucket number.
-      size_t hashInd = (size_t) secondHashVectors(i, j);
-      // The point ID is 'j'.
-
-      // If this is currently an empty bucket, start a new row keep track of
-      // which row corresponds to the bucket.
-      const size_t maxSize = secondHashBinCounts[hashInd];
-      if (bucketRowInHashTable[hashInd] == secondHashSize)
+      const size_t hashInd = secondHashVectors(i, j);
+      // The point ID is 'j'.  If the bucket is full, it is dropped.
+      if (secondHashBinCounts[hashInd] > 0)
       {
-        bucketRowInHashTable[hashInd] = currentRow;
-        secondHashTable[currentRow].set_size(maxSize);
-        currentRow++;
+        bucketContents[bucketOffsets[hashInd + 1] -
+            secondHashBinCounts[hashInd]] = j;
+        secondHashBinCounts[hashInd]--;
       }
-
-      // If this vector in the hash table is not full, add the point.
-      const size_t index = bucketRowInHashTable[hashInd];
-      if (bucketContentSize[index] < maxSize)
-        secondHashTable[index](bucketContentSize[index]++) = j;
-
     } // Loop over all points in the reference set.
   } // Loop over tables.
 
-  Log::Info << "Final hash table size: " << numRowsInTable << " rows, with a "
-            << "maximum length of " << arma::max(secondHashBinCounts) << ", "
-            << "totaling " << arma::accu(secondHashBinCounts) << " elements."
-            << std::endl;
+  size_t numBuckets = 0, maxBucketSize = 0;
+  for (size_t i = 0; i < secondHashSize; ++i)
+  {
+    const size_t size = bucketOffsets[i + 1] - bucketOffsets[i];
+    numBuckets += (size > 0) ? 1 : 0;
+    maxBucketSize = std::max(maxBucketSize, size);
+  }
+
+  Log::Info << "Final hash table size: " << numBuckets << " buckets, with a "
+            << "maximum length of " << maxBucketSize << ", totaling "
+            << bucketContents.n_elem << " elements." << std::endl;
 }
 
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::InsertNeighbor(arma::mat& distances,
-                                           arma::Mat<size_t>& neighbors,
-                                           const size_t queryIndex,
-                                           const size_t pos,
-                                           const size_t neighbor,
-                                           const double distance) const
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::HashPoints(
+    const arma::mat& points,
+    const size_t begin,
+    arma::Mat<size_t>& secondHashVectors)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (distances.n_rows - 1))
+  // We will store the second hash vectors in this matrix; the second hash
+  // vector for table i will be held in row i.
+  secondHashVectors.set_size(numTables, points.n_cols);
+  hash.Resize(begin + points.n_cols);
+
+  // The tables are independent, so they are hashed in parallel.
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < (omp_size_t) numTables; i++)
   {
-    const size_t len = (distances.n_rows - 1) - pos;
-    memmove(distances.colptr(queryIndex) + (pos + 1),
-        distances.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(neighbors.colptr(queryIndex) + (pos + 1),
-        neighbors.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
+    // The hash family hashes each point to a 'numProj'-dimensional integer
+    // key.  Hence you get a ('numProj' x 'points.n_cols') key matrix.
+    arma::mat keys, lowerDistances, upperDistances;
+    hash.Hash(points, projections.slice(i), i, keys, lowerDistances,
+        upperDistances);
+    hash.Index(keys, i, begin);
+
+    // Now we hash every key, point ID to its corresponding bucket.
+    secondHashVectors.row(i) = arma::conv_to<arma::Row<size_t>>::from(
+        secondHashWeights.t() * keys);
   }
 
-  // Now put the new information in the right index.
-  distances(pos, queryIndex) = distance;
-  neighbors(pos, queryIndex) = neighbor;
+  // Normalize hashes (take modulus with secondHashSize).
+  const size_t hashSize = secondHashSize;
+  secondHashVectors.transform([hashSize](size_t val)
+      { return val % hashSize; });
 }
 
-// Base case where the query set is the reference set.  (So, we can't return
-// ourselves as the nearest neighbor.)
-template<typename SortPolicy>
-inline force_inline
-void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
-                                     const size_t referenceIndex,
-                                     arma::Mat<size_t>& neighbors,
-                                     arma::mat& distances) const
+// Add new points to the reference set and the buckets.
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Insert(const arma::mat& newPoints)
 {
-  // If the points are the same, we can't continue.
-  if (queryIndex == referenceIndex)
+  if (numTables == 0)
+    throw std::invalid_argument("LSHSearch::Insert(): the model must be "
+        "trained before points can be inserted");
+
+  if (newPoints.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Insert(): dimensionality of new points ("
+        << newPoints.n_rows << ") is not equal to the dimensionality the model "
+        << "was trained on (" << referenceSet->n_rows << ")!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (newPoints.n_cols == 0)
     return;
 
-  const double distance = metric::EuclideanDistance::Evaluate(
-      referenceSet->unsafe_col(queryIndex),
-      referenceSet->unsafe_col(referenceIndex));
-
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  size_t insertPosition = SortPolicy::SortDistance(queryDist, queryIndices,
-      distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(distances, neighbors, queryIndex, insertPosition,
-        referenceIndex, distance);
+  // Hash the new points with the existing tables.
+  arma::Mat<size_t> secondHashVectors;
+  HashPoints(newPoints, referenceSet->n_cols, secondHashVectors);
+
+  // The new points get the next indices, so append them to our own copy of
+  // the reference set.
+  const size_t oldNumPoints = referenceSet->n_cols;
+  arma::mat* newReferenceSet = new arma::mat(arma::join_rows(*referenceSet,
+      newPoints));
+  if (ownsSet)
+    delete referenceSet;
+  referenceSet = newReferenceSet;
+  ownsSet = true;
+  sharedReferenceSet.reset();
+
+  // Count the points of each bucket with the new points, respecting the
+  // maximum bucket size (if there is one).
+  arma::Col<size_t> oldCounts(secondHashSize);
+  for (size_t i = 0; i < secondHashSize; ++i)
+    oldCounts[i] = bucketOffsets[i + 1] - bucketOffsets[i];
+
+  arma::Col<size_t> newCounts(oldCounts);
+  for (size_t i = 0; i < secondHashVectors.n_elem; ++i)
+    newCounts[secondHashVectors[i]]++;
+
+  if (bucketSize > 0)
+    for (size_t i = 0; i < secondHashSize; ++i)
+      newCounts[i] = std::max(oldCounts[i], std::min(newCounts[i],
+          bucketSize));
+
+  arma::Col<size_t> newOffsets(secondHashSize + 1);
+  newOffsets[0] = 0;
+  for (size_t i = 0; i < secondHashSize; ++i)
+    newOffsets[i + 1] = newOffsets[i] + newCounts[i];
+
+  // Copy the existing points of each bucket, then add the new points after
+  // them, in order of tables and then points.  'next' holds the position of
+  // the next point of each bucket.
+  arma::Col<size_t> newContents(newOffsets[secondHashSize]);
+  arma::Col<size_t> next(secondHashSize);
+  for (size_t i = 0; i < secondHashSize; ++i)
+  {
+    std::copy(bucketContents.begin() + bucketOffsets[i],
+        bucketContents.begin() + bucketOffsets[i + 1],
+        newContents.begin() + newOffsets[i]);
+    next[i] = newOffsets[i] + oldCounts[i];
+  }
+
+  for (size_t i = 0; i < numTables; ++i)
+  {
+    for (size_t j = 0; j < secondHashVectors.n_cols; ++j)
+    {
+      const size_t hashInd = secondHashVectors(i, j);
+      // If the bucket is full, the point is dropped.
+      if (next[hashInd] < newOffsets[hashInd + 1])
+        newContents[next[hashInd]++] = oldNumPoints + j;
+    }
+  }
+
+  bucketOffsets = std::move(newOffsets);
+  bucketContents = std::move(newContents);
 }
 
-// Base case for bichromatic search.
-template<typename SortPolicy>
-inline force_inline
-void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
-                                     const size_t referenceIndex,
-                                     const arma::mat& querySet,
-                                     arma::Mat<size_t>& neighbors,
-                                     arma::mat& distances) const
+// Remove points from the buckets.
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Remove(const arma::uvec& indices)
 {
-  const double distance = metric::EuclideanDistance::Evaluate(
-      querySet.unsafe_col(queryIndex),
-      referenceSet->unsafe_col(referenceIndex));
-
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  size_t insertPosition = SortPolicy::SortDistance(queryDist, queryIndices,
-      distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(distances, neighbors, queryIndex, insertPosition,
-        referenceIndex, distance);
+  std::vector<bool> removed(referenceSet->n_cols, false);
+  for (size_t i = 0; i < indices.n_elem; ++i)
+  {
+    if (indices[i] >= referenceSet->n_cols)
+    {
+      std::ostringstream oss;
+      oss << "LSHSearch::Remove(): index " << indices[i] << " is not a point "
+          << "of the reference set, which has " << referenceSet->n_cols
+          << " points";
+      throw std::invalid_argument(oss.str());
+    }
+
+    removed[indices[i]] = true;
+  }
+
+  // Compact the buckets in place, skipping the removed points.
+  size_t numKept = 0;
+  size_t begin = 0;
+  for (size_t i = 0; i + 1 < bucketOffsets.n_elem; ++i)
+  {
+    const size_t end = bucketOffsets[i + 1];
+    for (size_t j = begin; j < end; ++j)
+      if (!removed[bucketContents[j]])
+        bucketContents[numKept++] = bucketContents[j];
+
+    begin = end;
+    bucketOffsets[i + 1] = numKept;
+  }
+
+  bucketContents.resize(numKept);
 }
 
-template<typename SortPolicy>
+// Compute the distances to the candidates and keep the best ones.
+template<typename SortPolicy, typename HashType>
 template<typename VecType>
-void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
-    const VecType& queryPoint,
-    arma::uvec& referenceIndices,
-    size_t numTablesToSearch) const
+inline force_inline
+void LSHSearch<SortPolicy, HashType>::BaseCase(const VecType& query,
+                                               const arma::mat& queryKeys,
+                                               const arma::uvec& candidates,
+                                               const size_t skip,
+                                               size_t* neighbors,
+                                               double* distances,
+                                               const size_t k) const
 {
-  // Decide on the number of tables to look into.
-  if (numTablesToSearch == 0) // If no user input is given, search all.
-    numTablesToSearch = numTables;
+  arma::vec candidateDistances;
+  hash.Evaluate(query, queryKeys, *referenceSet, candidates,
+      candidateDistances);
 
-  // Sanity check to make sure that the existing number of tables is not
-  // exceeded.
-  if (numTablesToSearch > numTables)
-    numTablesToSearch = numTables;
+  for (size_t j = 0; j < candidates.n_elem; ++j)
+  {
+    // In monochromatic search, we can't return the query as its own neighbor.
+    if (candidates[j] == skip)
+      continue;
 
-  // Hash the query in each of the 'numTablesToSearch' hash tables using the
-  // 'numProj' projections for each table. This gives us 'numTablesToSearch'
-  // keys for the query where each key is a 'numProj' dimensional integer
-  // vector.
+    // Add the point to the candidates if it is better than the worst one.
+    CandidateHeap<SortPolicy>::Insert(distances, neighbors, k,
+        candidateDistances[j], candidates[j]);
+  }
+}
 
-  // Compute the projection of the query in each table.
-  arma::mat allProjInTables(numProj, numTablesToSearch);
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::HashQueries(
+    const arma::mat& queries,
+    const size_t numTablesToSearch,
+    arma::cube& keys,
+    arma::cube& lowerDistances,
+    arma::cube& upperDistances) const
+{
+  // Hash the queries in each of the 'numTablesToSearch' hash tables using the
+  // 'numProj' projections for each table. This gives us 'numTablesToSearch'
+  // keys for each query where each key is a 'numProj' dimensional integer
+  // vector.  The keys of all the queries in a table are computed at once.
+  keys.set_size(numProj, numTablesToSearch, queries.n_cols);
+  lowerDistances.set_size(numProj, numTablesToSearch, queries.n_cols);
+  upperDistances.set_size(numProj, numTablesToSearch, queries.n_cols);
+  arma::mat tableKeys, tableLower, tableUpper;
   for (size_t i = 0; i < numTablesToSearch; i++)
-    //allProjInTables.unsafe_col(i) = projections[i].t() * queryPoint;
-    allProjInTables.unsafe_col(i) = projections.slice(i).t() * queryPoint;
-  allProjInTables += offsets.cols(0, numTablesToSearch - 1);
-  allProjInTables /= hashWidth;
+  {
+    hash.Hash(queries, projections.slice(i), i, tableKeys, tableLower,
+        tableUpper);
+
+    for (size_t j = 0; j < queries.n_cols; ++j)
+    {
+      keys.slice(j).col(i) = tableKeys.unsafe_col(j);
+      lowerDistances.slice(j).col(i) = tableLower.unsafe_col(j);
+      upperDistances.slice(j).col(i) = tableUpper.unsafe_col(j);
+    }
+  }
+}
+
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::ReturnIndicesFromTable(
+    const arma::mat& keys,
+    const arma::mat& lowerDistances,
+    const arma::mat& upperDistances,
+    arma::uvec& referenceIndices,
+    const size_t numProbes) const
+{
+  const size_t numTablesToSearch = keys.n_cols;
 
   // Compute the hash value of each key of the query into a bucket of the
-  // 'secondHashTable' using the 'secondHashWeights'.
-  arma::rowvec hashVec = secondHashWeights.t() * arma::floor(allProjInTables);
+  // second hash table using the 'secondHashWeights'.
+  const arma::rowvec unreducedHashVec = secondHashWeights.t() * keys;
 
-  for (size_t i = 0; i < hashVec.n_elem; i++)
-    hashVec[i] = (double) ((size_t) hashVec[i] % secondHashSize);
+  // These are the buckets to look into: the bucket of the key of the query in
+  // each table, and then the buckets of the perturbed keys, if any.
+  std::vector<size_t> hashVec(numTablesToSearch);
+  for (size_t i = 0; i < numTablesToSearch; i++)
+    hashVec[i] = (size_t) unreducedHashVec[i] % secondHashSize;
 
-  Log::Assert(hashVec.n_elem == numTablesToSearch);
+  if (numProbes > 0)
+    GetAdditionalProbingBins(lowerDistances, upperDistances, unreducedHashVec,
+        numProbes, hashVec);
 
-  // Count number of points hashed in the same bucket as the query.
+  // Count number of points hashed in the same buckets as the query.
   size_t maxNumPoints = 0;
-  for (size_t i = 0; i < numTablesToSearch; ++i)
-  {
-    const size_t hashInd = (size_t) hashVec[i];
-    const size_t tableRow = bucketRowInHashTable[hashInd];
-    if (tableRow != secondHashSize)
-      maxNumPoints += bucketContentSize[tableRow];
-  }
+  for (size_t i = 0; i < hashVec.size(); ++i)
+    maxNumPoints += bucketOffsets[hashVec[i] + 1] - bucketOffsets[hashVec[i]];
 
   // There are two ways to proceed here:
   // Either allocate a maxNumPoints-size vector, place all candidates, and run
@@ -398,15 +495,13 @@ void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
     arma::Col<size_t> refPointsConsidered;
     refPointsConsidered.zeros(referenceSet->n_cols);
 
-    for (size_t i = 0; i < hashVec.n_elem; ++i)
+    for (size_t i = 0; i < hashVec.size(); ++i)
     {
-      const size_t hashInd = (size_t) hashVec[i];
-      const size_t tableRow = bucketRowInHashTable[hashInd];
-
       // Pick the indices in the bucket corresponding to 'hashInd'.
-      if (tableRow != secondHashSize)
-        for (size_t j = 0; j < bucketContentSize[tableRow]; j++)
-          refPointsConsidered[secondHashTable[tableRow](j)]++;
+      const size_t hashInd = hashVec[i];
+      for (size_t j = bucketOffsets[hashInd]; j < bucketOffsets[hashInd + 1];
+           j++)
+        refPointsConsidered[bucketContents[j]]++;
     }
 
     // Only keep reference points found in at least one bucket.
@@ -423,15 +518,14 @@ void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
 
     // Retrieve candidates.
     size_t start = 0;
-    for (size_t i = 0; i < numTablesToSearch; ++i) // For all tables
+    for (size_t i = 0; i < hashVec.size(); ++i) // For all buckets.
     {
-      const size_t hashInd = (size_t) hashVec[i]; // Find the query's bucket.
-      const size_t tableRow = bucketRowInHashTable[hashInd];
+      const size_t hashInd = hashVec[i]; // Find the query's bucket.
 
-      // Store all secondHashTable points in the candidates set.
-      if (tableRow != secondHashSize)
-        for (size_t j = 0; j < bucketContentSize[tableRow]; ++j)
-          refPointsConsideredSmall(start++) = secondHashTable[tableRow][j];
+      // Store all the points of the bucket in the candidates set.
+      for (size_t j = bucketOffsets[hashInd]; j < bucketOffsets[hashInd + 1];
+           ++j)
+        refPointsConsideredSmall(start++) = bucketContents[j];
     }
 
     // Only keep unique candidates.
@@ -440,13 +534,117 @@ void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
   }
 }
 
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::GetAdditionalProbingBins(
+    const arma::mat& lowerDistances,
+    const arma::mat& upperDistances,
+    const arma::rowvec& unreducedHashVec,
+    const size_t numProbes,
+    std::vector<size_t>& hashVec) const
+{
+  // A perturbation set is a list of positions in the sorted list of
+  // boundaries of a table, together with its score (the sum of the squared
+  // distances to those boundaries).  The sets of each table are enumerated in
+  // increasing order of score with a heap, by shifting and expanding sets that
+  // were already taken out of it.
+  typedef std::pair<double, std::vector<size_t>> PerturbationSet;
+
+  // The score and second hash value of the best valid perturbation sets of all
+  // tables.
+  std::vector<std::pair<double, size_t>> probes;
+
+  for (size_t t = 0; t < lowerDistances.n_cols; ++t)
+  {
+    // Moving coordinate j of the key by -1 (entry 2j) or +1 (entry 2j + 1)
+    // costs the squared distance from the query to that boundary of its bucket.
+    // Moves that the hash family doesn't allow are left out.
+    std::vector<std::pair<double, size_t>> boundaries;
+    boundaries.reserve(2 * numProj);
+    for (size_t j = 0; j < numProj; ++j)
+    {
+      const double lower = lowerDistances(j, t);
+      const double upper = upperDistances(j, t);
+      if (lower != DBL_MAX)
+        boundaries.push_back(std::make_pair(lower * lower, 2 * j));
+      if (upper != DBL_MAX)
+        boundaries.push_back(std::make_pair(upper * upper, 2 * j + 1));
+    }
+    if (boundaries.empty())
+      continue;
+    std::sort(boundaries.begin(), boundaries.end());
+
+    std::priority_queue<PerturbationSet, std::vector<PerturbationSet>,
+        std::greater<PerturbationSet>> heap;
+    heap.push(PerturbationSet(boundaries[0].first,
+        std::vector<size_t>(1, 0)));
+
+    size_t numFound = 0;
+    while (!heap.empty() && numFound < numProbes)
+    {
+      const PerturbationSet set = heap.top();
+      heap.pop();
+
+      // Generate the next sets: shift the last position, and add the next
+      // position.
+      const size_t last = set.second.back();
+      if (last + 1 < boundaries.size())
+      {
+        PerturbationSet shifted(set);
+        shifted.second.back() = last + 1;
+        shifted.first += boundaries[last + 1].first - boundaries[last].first;
+        heap.push(shifted);
+
+        PerturbationSet expanded(set);
+        expanded.second.push_back(last + 1);
+        expanded.first += boundaries[last + 1].first;
+        heap.push(expanded);
+      }
+
+      // A set is only valid if it moves each coordinate at most once.
+      bool valid = true;
+      for (size_t i = 0; i < set.second.size() && valid; ++i)
+        for (size_t j = i + 1; j < set.second.size() && valid; ++j)
+          if (boundaries[set.second[i]].second / 2 ==
+              boundaries[set.second[j]].second / 2)
+            valid = false;
+
+      if (!valid)
+        continue;
+
+      // Compute the second hash of the perturbed key the same way as the hash
+      // of the key itself.
+      double hash = unreducedHashVec[t];
+      for (size_t i = 0; i < set.second.size(); ++i)
+      {
+        const size_t entry = boundaries[set.second[i]].second;
+        if (entry % 2 == 0)
+          hash -= secondHashWeights[entry / 2];
+        else
+          hash += secondHashWeights[entry / 2];
+      }
+
+      probes.push_back(std::make_pair(set.first,
+          (size_t) hash % secondHashSize));
+      ++numFound;
+    }
+  }
+
+  // Keep the best perturbations over all tables.
+  const size_t numKept = std::min(numProbes, probes.size());
+  std::partial_sort(probes.begin(), probes.begin() + numKept, probes.end());
+  for (size_t i = 0; i < numKept; ++i)
+    hashVec.push_back(probes[i].second);
+}
+
 // Search for nearest neighbors in a given query set.
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
-                                   const size_t k,
-                                   arma::Mat<size_t>& resultingNeighbors,
-                                   arma::mat& distances,
-                                   const size_t numTablesToSearch)
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Search(
+    const arma::mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    const size_t numTablesToSearch,
+    const size_t numProbes)
 {
   // Ensure the dimensionality of the query set is correct.
   if (querySet.n_rows != referenceSet->n_rows)
@@ -479,27 +677,51 @@ void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
 
   size_t avgIndicesReturned = 0;
 
+  // The queries are projected onto the tables in blocks of this size.
+  const size_t queryBlockSize = 256;
+  const size_t tablesToSearch = (numTablesToSearch == 0) ? numTables :
+      std::min(numTablesToSearch, numTables);
+  const size_t numBlocks = (querySet.n_cols + queryBlockSize - 1) /
+      queryBlockSize;
+
   Timer::Start("computing_neighbors");
 
-  // Go through every query point sequentially.
-  for (size_t i = 0; i < querySet.n_cols; i++)
+  // Go through the blocks of query points in parallel.
+  #pragma omp parallel for schedule(dynamic) reduction(+:avgIndicesReturned)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
   {
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(querySet.col(i), refIndices, numTablesToSearch);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    for (size_t j = 0; j < refIndices.n_elem; j++)
-      BaseCase(i, (size_t) refIndices[j], querySet, resultingNeighbors,
-          distances);
+    const size_t begin = b * queryBlockSize;
+    const size_t end = std::min(begin + queryBlockSize,
+        (size_t) querySet.n_cols);
+
+    // Hash every query into every hash table.
+    arma::cube keys, lowerDistances, upperDistances;
+    HashQueries(querySet.cols(begin, end - 1), tablesToSearch, keys,
+        lowerDistances, upperDistances);
+
+    for (size_t i = begin; i < end; i++)
+    {
+      // Hash the keys of the query into the second hash table to obtain the
+      // neighbor candidates.
+      arma::uvec refIndices;
+      ReturnIndicesFromTable(keys.slice(i - begin),
+          lowerDistances.slice(i - begin), upperDistances.slice(i - begin),
+          refIndices, numProbes);
+
+      // An informative book-keeping for the number of neighbor candidates
+      // returned on average.
+      avgIndicesReturned += refIndices.n_elem;
+
+      // Go through all the candidates and save the best 'k' candidates.
+      BaseCase(querySet.unsafe_col(i), keys.slice(i - begin), refIndices,
+          referenceSet->n_cols, resultingNeighbors.colptr(i),
+          distances.colptr(i), k);
+    }
   }
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, resultingNeighbors);
+
   Timer::Stop("computing_neighbors");
 
   distanceEvaluations += avgIndicesReturned;
@@ -509,12 +731,13 @@ void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
 }
 
 // Search for approximate neighbors of the reference set.
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::
 Search(const size_t k,
        arma::Mat<size_t>& resultingNeighbors,
        arma::mat& distances,
-       const size_t numTablesToSearch)
+       const size_t numTablesToSearch,
+       const size_t numProbes)
 {
   // This is monochromatic search; the query set is the reference set.
   resultingNeighbors.set_size(k, referenceSet->n_cols);
@@ -524,26 +747,51 @@ Search(const size_t k,
 
   size_t avgIndicesReturned = 0;
 
+  // The queries are projected onto the tables in blocks of this size.
+  const size_t queryBlockSize = 256;
+  const size_t tablesToSearch = (numTablesToSearch == 0) ? numTables :
+      std::min(numTablesToSearch, numTables);
+  const size_t numBlocks = (referenceSet->n_cols + queryBlockSize - 1) /
+      queryBlockSize;
+
   Timer::Start("computing_neighbors");
 
-  // Go through every query point sequentially.
-  for (size_t i = 0; i < referenceSet->n_cols; i++)
+  // Go through the blocks of query points in parallel.
+  #pragma omp parallel for schedule(dynamic) reduction(+:avgIndicesReturned)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
   {
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(referenceSet->col(i), refIndices, numTablesToSearch);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    for (size_t j = 0; j < refIndices.n_elem; j++)
-      BaseCase(i, (size_t) refIndices[j], resultingNeighbors, distances);
+    const size_t begin = b * queryBlockSize;
+    const size_t end = std::min(begin + queryBlockSize,
+        (size_t) referenceSet->n_cols);
+
+    // Hash every query into every hash table.
+    arma::cube keys, lowerDistances, upperDistances;
+    HashQueries(referenceSet->cols(begin, end - 1), tablesToSearch, keys,
+        lowerDistances, upperDistances);
+
+    for (size_t i = begin; i < end; i++)
+    {
+      // Hash the keys of the query into the second hash table to obtain the
+      // neighbor candidates.
+      arma::uvec refIndices;
+      ReturnIndicesFromTable(keys.slice(i - begin),
+          lowerDistances.slice(i - begin), upperDistances.slice(i - begin),
+          refIndices, numProbes);
+
+      // An informative book-keeping for the number of neighbor candidates
+      // returned on average.
+      avgIndicesReturned += refIndices.n_elem;
+
+      // Go through all the candidates and save the best 'k' candidates (the
+      // query itself is skipped).
+      BaseCase(referenceSet->unsafe_col(i), keys.slice(i - begin), refIndices,
+          i, resultingNeighbors.colptr(i), distances.colptr(i), k);
+    }
   }
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, resultingNeighbors);
+
   Timer::Stop("computing_neighbors");
 
   distanceEvaluations += avgIndicesReturned;
@@ -552,8 +800,8 @@ Search(const size_t k,
       std::endl;
 }
 
-template<typename SortPolicy>
-double LSHSearch<SortPolicy>::ComputeRecall(
+template<typename SortPolicy, typename HashType>
+double LSHSearch<SortPolicy, HashType>::ComputeRecall(
     const arma::Mat<size_t>& foundNeighbors,
     const arma::Mat<size_t>& realNeighbors)
 {
@@ -579,10 +827,10 @@ double LSHSearch<SortPolicy>::ComputeRecall(
   return ((double) found) / realNeighbors.n_elem;
 }
 
-template<typename SortPolicy>
+template<typename SortPolicy, typename HashType>
 template<typename Archive>
-void LSHSearch<SortPolicy>::Serialize(Archive& ar,
-                                      const unsigned int version)
+void LSHSearch<SortPolicy, HashType>::Serialize(Archive& ar,
+                                                const unsigned int version)
 {
   using data::CreateNVP;
 
@@ -592,6 +840,7 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
     if (ownsSet)
       delete referenceSet;
     ownsSet = true;
+    sharedReferenceSet.reset();
   }
   ar & CreateNVP(referenceSet, "referenceSet");
 
@@ -618,86 +867,89 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
     ar & CreateNVP(projections, "projections");
   }
 
-  ar & CreateNVP(offsets, "offsets");
-  ar & CreateNVP(hashWidth, "hashWidth");
+  // The hash family holds the other parameters of the hash functions (for
+  // PStableHash, the offsets and the hash width).
+  hash.Serialize(ar, version);
   ar & CreateNVP(secondHashSize, "secondHashSize");
   ar & CreateNVP(secondHashWeights, "secondHashWeights");
   ar & CreateNVP(bucketSize, "bucketSize");
-  // needs specific handling for new version
 
-  // Backward compatibility: in older versions of LSHSearch, the secondHashTable
-  // was stored as an arma::Mat<size_t>.  So we need to properly load that, then
-  // prune it down to size.
-  if (version == 0)
+  // Backward compatibility: older versions of LSHSearch stored each non-empty
+  // bucket in its own row of the secondHashTable, along with the size of each
+  // row and the row of each bucket.  We load those and convert them to the
+  // contiguous layout.
+  if (version < 2)
   {
-    arma::Mat<size_t> tmpSecondHashTable;
-    ar & CreateNVP(tmpSecondHashTable, "secondHashTable");
+    std::vector<arma::Col<size_t>> secondHashTable;
+    arma::Col<size_t> bucketContentSize;
+    arma::Col<size_t> bucketRowInHashTable;
 
-    // The old secondHashTable was stored in row-major format, so we transpose
-    // it.
-    tmpSecondHashTable = tmpSecondHashTable.t();
-
-    secondHashTable.resize(tmpSecondHashTable.n_cols);
-    for (size_t i = 0; i < tmpSecondHashTable.n_cols; ++i)
+    // In version 0, the secondHashTable was stored as an arma::Mat<size_t>,
+    // with one bucket in each row, padded with referenceSet->n_cols.
+    if (version == 0)
     {
-      // Find length of each column.  We know we are at the end of the list when
-      // the value referenceSet->n_cols is seen.
+      arma::Mat<size_t> tmpSecondHashTable;
+      ar & CreateNVP(tmpSecondHashTable, "secondHashTable");
 
-      size_t len = 0;
-      for ( ; len < tmpSecondHashTable.n_rows; ++len)
-        if (tmpSecondHashTable(len, i) == referenceSet->n_cols)
-          break;
+      // The old secondHashTable was stored in row-major format, so we
+      // transpose it.
+      tmpSecondHashTable = tmpSecondHashTable.t();
 
-      // Set the size of the new column correctly.
-      secondHashTable[i].set_size(len);
-      for (size_t j = 0; j < len; ++j)
-        secondHashTable[i](j) = tmpSecondHashTable(j, i);
+      secondHashTable.resize(tmpSecondHashTable.n_cols);
+      for (size_t i = 0; i < tmpSecondHashTable.n_cols; ++i)
+      {
+        // Find length of each column.  We know we are at the end of the list
+        // when the value referenceSet->n_cols is seen.
+        size_t len = 0;
+        for ( ; len < tmpSecondHashTable.n_rows; ++len)
+          if (tmpSecondHashTable(len, i) == referenceSet->n_cols)
+            break;
+
+        // Set the size of the new column correctly.
+        secondHashTable[i].set_size(len);
+        for (size_t j = 0; j < len; ++j)
+          secondHashTable[i](j) = tmpSecondHashTable(j, i);
+      }
     }
-  }
-  else
-  {
-    size_t tables;
-    if (Archive::is_saving::value)
-      tables = secondHashTable.size();
-    ar & CreateNVP(tables, "numSecondHashTables");
-
-    // Set size of second hash table if needed.
-    if (Archive::is_loading::value)
+    else
     {
-      secondHashTable.clear();
+      size_t tables;
+      ar & CreateNVP(tables, "numSecondHashTables");
+
       secondHashTable.resize(tables);
+      for (size_t i = 0; i < secondHashTable.size(); ++i)
+      {
+        std::ostringstream oss;
+        oss << "secondHashTable" << i;
+        ar & CreateNVP(secondHashTable[i], oss.str());
+      }
     }
 
-    for (size_t i = 0; i < secondHashTable.size(); ++i)
+    // Version 0 held bucketContentSize for all possible buckets (of size
+    // secondHashSize), and version 1 held it for each row.  But each row of
+    // the secondHashTable already has the right length, so it isn't needed.
+    ar & CreateNVP(bucketContentSize, "bucketContentSize");
+    ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
+
+    bucketOffsets.set_size(secondHashSize + 1);
+    bucketOffsets[0] = 0;
+    for (size_t i = 0; i < secondHashSize; ++i)
     {
-      std::ostringstream oss;
-      oss << "secondHashTable" << i;
-      ar & CreateNVP(secondHashTable[i], oss.str());
+      const size_t row = bucketRowInHashTable[i];
+      bucketOffsets[i + 1] = bucketOffsets[i] + ((row == secondHashSize) ? 0 :
+          secondHashTable[row].n_elem);
     }
-  }
-
-  // Backward compatibility: old versions of LSHSearch held bucketContentSize
-  // for all possible buckets (of size secondHashSize), but now we hold a
-  // compressed representation.
-  if (version == 0)
-  {
-    // The vector was stored in the old uncompressed form.  So we need to shrink
-    // it.  But we can't do that until we have bucketRowInHashTable, so we also
-    // have to load that.
-    arma::Col<size_t> tmpBucketContentSize;
-    ar & CreateNVP(tmpBucketContentSize, "bucketContentSize");
-    ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
 
-    // Compress into a smaller vector by just dropping all of the zeros.
-    bucketContentSize.set_size(secondHashTable.size());
-    for (size_t i = 0; i < tmpBucketContentSize.n_elem; ++i)
-      if (tmpBucketContentSize[i] > 0)
-        bucketContentSize[bucketRowInHashTable[i]] = tmpBucketContentSize[i];
+    bucketContents.set_size(bucketOffsets[secondHashSize]);
+    for (size_t i = 0; i < secondHashSize; ++i)
+      if (bucketOffsets[i + 1] > bucketOffsets[i])
+        bucketContents.subvec(bucketOffsets[i], bucketOffsets[i + 1] - 1) =
+            secondHashTable[bucketRowInHashTable[i]];
   }
   else
   {
-    ar & CreateNVP(bucketContentSize, "bucketContentSize");
-    ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
+    ar & CreateNVP(bucketOffsets, "bucketOffsets");
+    ar & CreateNVP(bucketContents, "bucketContents");
   }
 
   ar & CreateNVP(distanceEvaluations, "distanceEvaluations");
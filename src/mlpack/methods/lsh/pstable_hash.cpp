@@ -0,0 +1,61 @@
+/**
+ * @file pstable_hash.cpp
+ *
+ * Implementation of the PStableHash class.
+ */
+#include "pstable_hash.hpp"
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+void PStableHash::Train(const arma::mat& referenceSet,
+                        const size_t numProj,
+                        const size_t numTables,
+                        const double hashWidthIn)
+{
+  hashWidth = hashWidthIn;
+  if (hashWidth == 0.0) // The user has not provided any value.
+  {
+    // Compute a heuristic hash width from the data.
+    for (size_t i = 0; i < 25; i++)
+    {
+      size_t p1 = (size_t) math::RandInt(referenceSet.n_cols);
+      size_t p2 = (size_t) math::RandInt(referenceSet.n_cols);
+
+      hashWidth += std::sqrt(metric::EuclideanDistance::Evaluate(
+          referenceSet.unsafe_col(p1), referenceSet.unsafe_col(p2)));
+    }
+
+    hashWidth /= 25;
+  }
+
+  Log::Info << "Hash width chosen as: " << hashWidth << std::endl;
+
+  // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
+  // as randu(numProj, numTables) * hashWidth.
+  offsets.randu(numProj, numTables);
+  offsets *= hashWidth;
+}
+
+void PStableHash::Hash(const arma::mat& points,
+                       const arma::mat& projections,
+                       const size_t table,
+                       arma::mat& keys,
+                       arma::mat& lowerDistances,
+                       arma::mat& upperDistances) const
+{
+  // For a single table, let the 'numProj' projections be denoted by 'proj_i'
+  // and the corresponding offset be 'offset_i'.  Then the key of a single
+  // point is obtained as:
+  // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
+  arma::mat hashMat = projections.t() * points;
+  hashMat.each_col() += offsets.unsafe_col(table);
+  hashMat /= hashWidth;
+
+  keys = arma::floor(hashMat);
+
+  // The position of each point inside its key is its distance to the lower
+  // boundary.
+  lowerDistances = hashMat - keys;
+  upperDistances = 1.0 - lowerDistances;
+}
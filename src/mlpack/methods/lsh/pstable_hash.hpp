@@ -0,0 +1,155 @@
+/**
+ * @file pstable_hash.hpp
+ *
+ * Definition of the PStableHash class, the family of hash functions used by
+ * LSHSearch for the Euclidean distance.
+ */
+#ifndef MLPACK_METHODS_LSH_PSTABLE_HASH_HPP
+#define MLPACK_METHODS_LSH_PSTABLE_HASH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The PStableHash class is the family of hash functions of LSH for the
+ * Euclidean distance, with 2-stable (Gaussian) projections.  Each hash function
+ * maps a point x to the key floor((<a, x> + b) / w), where a is a projection, b
+ * is an offset drawn uniformly in [0, w], and w is the hash width.  The
+ * candidates are ranked by their Euclidean distance to the query.
+ *
+ * This is the default hash family of LSHSearch; see SimHash for another one.  A
+ * hash family must implement the following functions:
+ *
+ * @code
+ * // Prepare the hash functions of numTables tables of numProj projections.
+ * void Train(const arma::mat& referenceSet, const size_t numProj,
+ *            const size_t numTables, const double hashWidth);
+ *
+ * // Compute the keys of the points in the given table, and the distance from
+ * // each point to the lower and upper boundaries of its key along each
+ * // projection (for multi-probe LSH; DBL_MAX if a key can't be moved that
+ * // way).
+ * void Hash(const arma::mat& points, const arma::mat& projections,
+ *           const size_t table, arma::mat& keys, arma::mat& lowerDistances,
+ *           arma::mat& upperDistances) const;
+ *
+ * // Store the keys of the points begin to (begin + keys.n_cols - 1) of the
+ * // reference set in the given table (after Resize() to the new number of
+ * // points).
+ * void Resize(const size_t numPoints);
+ * void Index(const arma::mat& keys, const size_t table, const size_t begin);
+ *
+ * // Compute the distance from the query to each candidate, given the keys of
+ * // the query in the searched tables.
+ * template<typename VecType>
+ * void Evaluate(const VecType& query, const arma::mat& queryKeys,
+ *               const arma::mat& referenceSet, const arma::uvec& candidates,
+ *               arma::vec& distances) const;
+ *
+ * // Get the hash width (0 if the family has none), and serialize the family.
+ * double HashWidth() const;
+ * template<typename Archive>
+ * void Serialize(Archive& ar, const unsigned int version);
+ * @endcode
+ */
+class PStableHash
+{
+ public:
+  //! Create the hash family; Train() must be called before it is used.
+  PStableHash() : hashWidth(0.0) { }
+
+  /**
+   * Draw the offsets of the projections of each table.  If the given hash
+   * width is 0, it is set to the average distance between 25 random pairs of
+   * points of the reference set.
+   *
+   * @param referenceSet Set of reference points.
+   * @param numProj Number of projections in each table.
+   * @param numTables Number of tables.
+   * @param hashWidth Hash width (0 to compute it).
+   */
+  void Train(const arma::mat& referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double hashWidth);
+
+  /**
+   * Compute the keys of the given points in the given table, and the distance
+   * from each point to the boundaries of its key along each projection, in
+   * units of the hash width.
+   *
+   * @param points Points to hash.
+   * @param projections Projections of the table (one per column).
+   * @param table Index of the table.
+   * @param keys Keys of the points (one per column).
+   * @param lowerDistances Distances to the lower boundaries of the keys.
+   * @param upperDistances Distances to the upper boundaries of the keys.
+   */
+  void Hash(const arma::mat& points,
+            const arma::mat& projections,
+            const size_t table,
+            arma::mat& keys,
+            arma::mat& lowerDistances,
+            arma::mat& upperDistances) const;
+
+  //! The keys of the reference points are not needed by Evaluate().
+  void Resize(const size_t /* numPoints */) { }
+
+  //! The keys of the reference points are not needed by Evaluate().
+  void Index(const arma::mat& /* keys */,
+             const size_t /* table */,
+             const size_t /* begin */) { }
+
+  /**
+   * Compute the Euclidean distance from the query to each candidate.
+   *
+   * @param query Query point.
+   * @param queryKeys Keys of the query in the searched tables (unused).
+   * @param referenceSet Set of reference points.
+   * @param candidates Indices of the candidates.
+   * @param distances Distance to each candidate.
+   */
+  template<typename VecType>
+  void Evaluate(const VecType& query,
+                const arma::mat& /* queryKeys */,
+                const arma::mat& referenceSet,
+                const arma::uvec& candidates,
+                arma::vec& distances) const
+  {
+    distances.set_size(candidates.n_elem);
+    for (size_t i = 0; i < candidates.n_elem; ++i)
+      distances[i] = metric::EuclideanDistance::Evaluate(query,
+          referenceSet.unsafe_col(candidates[i]));
+  }
+
+  //! Get the hash width.
+  double HashWidth() const { return hashWidth; }
+
+  //! Get the offsets 'b' for each of the projections.  (One 'b' per column.)
+  const arma::mat& Offsets() const { return offsets; }
+
+  /**
+   * Serialize the hash family.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(offsets, "offsets");
+    ar & data::CreateNVP(hashWidth, "hashWidth");
+  }
+
+ private:
+  //! The offsets 'b' of each projection (row) of each table (column).
+  arma::mat offsets;
+
+  //! The hash width.
+  double hashWidth;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
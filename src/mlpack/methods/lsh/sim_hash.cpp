@@ -0,0 +1,63 @@
+/**
+ * @file sim_hash.cpp
+ *
+ * Implementation of the SimHash class.
+ */
+#include "sim_hash.hpp"
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+void SimHash::Train(const arma::mat& /* referenceSet */,
+                    const size_t numProj,
+                    const size_t numTables,
+                    const double /* hashWidth */)
+{
+  if (numProj > 64)
+  {
+    std::ostringstream oss;
+    oss << "SimHash::Train(): the bits of a table are packed into a 64-bit "
+        << "word, so numProj must be at most 64 (got " << numProj << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  codes.set_size(numTables, 0);
+}
+
+void SimHash::Hash(const arma::mat& points,
+                   const arma::mat& projections,
+                   const size_t /* table */,
+                   arma::mat& keys,
+                   arma::mat& lowerDistances,
+                   arma::mat& upperDistances) const
+{
+  const arma::mat values = projections.t() * points;
+
+  // The distance from a point to a hyperplane is the absolute value of its
+  // projection, divided by the norm of the normal.
+  const arma::rowvec norms = arma::sqrt(arma::sum(arma::square(projections),
+      0));
+
+  keys.set_size(values.n_rows, values.n_cols);
+  lowerDistances.set_size(values.n_rows, values.n_cols);
+  upperDistances.set_size(values.n_rows, values.n_cols);
+  for (size_t j = 0; j < values.n_cols; ++j)
+  {
+    for (size_t i = 0; i < values.n_rows; ++i)
+    {
+      const double distance = std::abs(values(i, j)) / norms[i];
+      if (values(i, j) >= 0.0)
+      {
+        keys(i, j) = 1.0;
+        lowerDistances(i, j) = distance;
+        upperDistances(i, j) = DBL_MAX;
+      }
+      else
+      {
+        keys(i, j) = 0.0;
+        lowerDistances(i, j) = DBL_MAX;
+        upperDistances(i, j) = distance;
+      }
+    }
+  }
+}
@@ -0,0 +1,189 @@
+/**
+ * @file sim_hash.hpp
+ *
+ * Definition of the SimHash class, the family of hash functions used by
+ * LSHSearch for the cosine distance (sign random projections).
+ */
+#ifndef MLPACK_METHODS_LSH_SIM_HASH_HPP
+#define MLPACK_METHODS_LSH_SIM_HASH_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The SimHash class is the family of hash functions of LSH for the cosine
+ * distance (the angle between two points).  Each hash function is a random
+ * hyperplane through the origin, and maps a point to one bit: 1 if the point is
+ * on the positive side of the hyperplane, and 0 otherwise.  Two points get
+ * different bits with probability theta / pi, where theta is the angle between
+ * them, so the scale of the points doesn't matter.  This is described in the
+ * following paper:
+ *
+ * @inproceedings{charikar2002similarity,
+ *   title={Similarity estimation techniques from rounding algorithms},
+ *   author={Charikar, M.S.},
+ *   booktitle={Proceedings of the 34th Annual ACM Symposium on Theory of
+ *       Computing},
+ *   pages={380--388},
+ *   year={2002}
+ * }
+ *
+ * The bits of each table (at most 64, one per projection) are packed into one
+ * 64-bit word, and the words of all the reference points are kept, so the index
+ * takes numTables words per point.  The candidates of a query are ranked by
+ * the Hamming distance between their words and the words of the query in the
+ * searched tables, computed with popcount, so the reference points are never
+ * read by Search().  The distances returned by LSHSearch are these Hamming
+ * distances: the number of bits that differ, between 0 and numProj times the
+ * number of searched tables.  (The angle between the points is about pi times
+ * the Hamming distance divided by the number of bits.)
+ *
+ * For multi-probe LSH, the bits of the query that are closest to flipping (the
+ * hyperplanes closest to the query) are flipped first.
+ *
+ * @code
+ * LSHSearch<NearestNeighborSort, SimHash> lsh(dataset, 64, 10);
+ * lsh.Search(queries, k, neighbors, hammingDistances, 0, numProbes);
+ * @endcode
+ */
+class SimHash
+{
+ public:
+  //! Create the hash family; Train() must be called before it is used.
+  SimHash() { }
+
+  /**
+   * Prepare the hash family for numTables tables of numProj projections,
+   * forgetting the words of the reference points.  A std::invalid_argument is
+   * thrown if numProj is greater than 64.
+   *
+   * @param referenceSet Set of reference points (unused).
+   * @param numProj Number of projections in each table.
+   * @param numTables Number of tables.
+   * @param hashWidth Hash width (unused).
+   */
+  void Train(const arma::mat& referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double hashWidth);
+
+  /**
+   * Compute the bits of the given points in the given table, and the distance
+   * from each point to each hyperplane of the table.  A bit can only be moved
+   * down if it is 1 and up if it is 0, so the other distance is DBL_MAX.
+   *
+   * @param points Points to hash.
+   * @param projections Hyperplanes of the table (one normal per column).
+   * @param table Index of the table.
+   * @param keys Bits of the points (one point per column).
+   * @param lowerDistances Distances to the hyperplanes of the bits that are 1.
+   * @param upperDistances Distances to the hyperplanes of the bits that are 0.
+   */
+  void Hash(const arma::mat& points,
+            const arma::mat& projections,
+            const size_t table,
+            arma::mat& keys,
+            arma::mat& lowerDistances,
+            arma::mat& upperDistances) const;
+
+  //! Make room for the words of the given number of reference points, keeping
+  //! the words of the points already indexed.
+  void Resize(const size_t numPoints) { codes.resize(codes.n_rows, numPoints); }
+
+  /**
+   * Store the words of the reference points begin to (begin + keys.n_cols - 1)
+   * in the given table.
+   *
+   * @param keys Bits of the points in the table (one point per column).
+   * @param table Index of the table.
+   * @param begin Index of the first point.
+   */
+  void Index(const arma::mat& keys, const size_t table, const size_t begin)
+  {
+    for (size_t i = 0; i < keys.n_cols; ++i)
+      codes(table, begin + i) = Pack(keys.colptr(i), keys.n_rows);
+  }
+
+  /**
+   * Compute the Hamming distance between the words of the query and of each
+   * candidate in the searched tables.
+   *
+   * @param query Query point (unused).
+   * @param queryKeys Bits of the query in the searched tables.
+   * @param referenceSet Set of reference points (unused).
+   * @param candidates Indices of the candidates.
+   * @param distances Hamming distance to each candidate.
+   */
+  template<typename VecType>
+  void Evaluate(const VecType& /* query */,
+                const arma::mat& queryKeys,
+                const arma::mat& /* referenceSet */,
+                const arma::uvec& candidates,
+                arma::vec& distances) const
+  {
+    std::vector<arma::u64> queryCodes(queryKeys.n_cols);
+    for (size_t t = 0; t < queryKeys.n_cols; ++t)
+      queryCodes[t] = Pack(queryKeys.colptr(t), queryKeys.n_rows);
+
+    distances.set_size(candidates.n_elem);
+    for (size_t i = 0; i < candidates.n_elem; ++i)
+    {
+      const arma::u64* candidateCodes = codes.colptr(candidates[i]);
+      size_t distance = 0;
+      for (size_t t = 0; t < queryCodes.size(); ++t)
+        distance += PopCount(queryCodes[t] ^ candidateCodes[t]);
+      distances[i] = (double) distance;
+    }
+  }
+
+  //! SimHash has no hash width.
+  double HashWidth() const { return 0.0; }
+
+  //! Get the words of the reference points (one point per column, one table
+  //! per row).
+  const arma::Mat<arma::u64>& Codes() const { return codes; }
+
+  /**
+   * Serialize the hash family.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(codes, "codes");
+  }
+
+  //! Pack the given bits into a word (the first bit is the lowest).
+  static arma::u64 Pack(const double* bits, const size_t numBits)
+  {
+    arma::u64 code = 0;
+    for (size_t i = 0; i < numBits; ++i)
+      if (bits[i] != 0.0)
+        code |= (arma::u64(1) << i);
+    return code;
+  }
+
+  //! Count the bits of the given word that are 1.
+  static size_t PopCount(arma::u64 word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t) __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) +
+        ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (size_t) ((word * 0x0101010101010101ULL) >> 56);
+#endif
+  }
+
+ private:
+  //! The words of the reference points in each table (row).
+  arma::Mat<arma::u64> codes;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -16,7 +16,7 @@ MatrixCompletion::MatrixCompletion(const size_t m,
                                    const arma::vec& values,
                                    const size_t r) :
     m(m), n(n), indices(indices), values(values),
-    sdp(indices.n_cols, 0, arma::randu<arma::mat>(m + n, r))
+    sdp(0, 0, arma::randu<arma::mat>(m + n, r))
 {
   CheckValues();
   InitSDP();
@@ -28,7 +28,7 @@ MatrixCompletion::MatrixCompletion(const size_t m,
                                    const arma::vec& values,
                                    const arma::mat& initialPoint) :
     m(m), n(n), indices(indices), values(values),
-    sdp(indices.n_cols, 0, initialPoint)
+    sdp(0, 0, initialPoint)
 {
   CheckValues();
   InitSDP();
@@ -39,7 +39,7 @@ MatrixCompletion::MatrixCompletion(const size_t m,
                                    const arma::umat& indices,
                                    const arma::vec& values) :
     m(m), n(n), indices(indices), values(values),
-    sdp(indices.n_cols, 0,
+    sdp(0, 0,
         arma::randu<arma::mat>(m + n, DefaultRank(m, n, indices.n_cols)))
 {
   CheckValues();
@@ -71,12 +71,29 @@ void MatrixCompletion::InitSDP()
   sdp.SDP().C().eye(m + n, m + n);
   sdp.SDP().SparseB() = 2. * values;
   const size_t p = indices.n_cols;
+
+  // Each known entry (i, j) gives a constraint matrix with the two elements
+  // (i, m + j) and (m + j, i).  A sparse matrix of size (m + n) x (m + n) for
+  // each constraint would take too much memory, so the elements are given to
+  // the LRSDP as one flat list instead.
+  arma::Col<size_t>& offsets = sdp.Function().SparseOffsets();
+  arma::umat& locations = sdp.Function().SparseLocations();
+  offsets.set_size(p + 1);
+  locations.set_size(2, 2 * p);
+  sdp.Function().SparseValues().ones(2 * p);
   for (size_t i = 0; i < p; i++)
   {
-    sdp.SDP().SparseA()[i].zeros(m + n, m + n);
-    sdp.SDP().SparseA()[i](indices(0, i), m + indices(1, i)) = 1.;
-    sdp.SDP().SparseA()[i](m + indices(1, i), indices(0, i)) = 1.;
+    offsets[i] = 2 * i;
+    locations(0, 2 * i) = indices(0, i);
+    locations(1, 2 * i) = m + indices(1, i);
+    locations(0, 2 * i + 1) = m + indices(1, i);
+    locations(1, 2 * i + 1) = indices(0, i);
   }
+  offsets[p] = 2 * p;
+
+  // The LRSDP was created without constraints, so there is one Lagrange
+  // multiplier to add for each.
+  sdp.AugLag().Lambda().zeros(p);
 }
 
 void MatrixCompletion::Recover(arma::mat& recovered)
@@ -22,6 +22,13 @@ namespace meanshift /** Mean shift clustering. */ {
  * apply mean shift algorithm until maximum iterations or convergence.  Then
  * remove duplicate centroids.
  *
+ * All the seeds are shifted together: in each iteration, the range search
+ * tree built on the dataset is queried with the centroids of all the seeds
+ * that have not converged yet, in blocks, with a dual-tree search, and the new
+ * centroids of a block are computed in parallel.  Seeds whose centroids fall
+ * into the same cell of a grid as fine as the convergence tolerance are merged
+ * as soon as this happens, since they follow the same path from then on.
+ *
  * A simple example of how to run mean shift clustering is shown below.
  *
  * @code
@@ -121,13 +128,15 @@ class MeanShift
    * @param data The whole dataset
    * @param neighbors Valid neighbors
    * @param distances Distances to neighbors
-   # @param centroid Store calculated centroid
+   * @param count Number of valid neighbors
+   * @param centroid Store calculated centroid
    */
   template<bool ApplyKernel = UseKernel>
   typename std::enable_if<ApplyKernel, bool>::type
   CalculateCentroid(const MatType& data,
-                    const std::vector<size_t>& neighbors,
-                    const std::vector<double>& distances,
+                    const size_t* neighbors,
+                    const double* distances,
+                    const size_t count,
                     arma::colvec& centroid);
 
   /**
@@ -136,13 +145,15 @@ class MeanShift
    * @param data The whole dataset
    * @param neighbors Valid neighbors
    * @param distances Distances to neighbors
-   # @param centroid Store calculated centroid
+   * @param count Number of valid neighbors
+   * @param centroid Store calculated centroid
    */
   template<bool ApplyKernel = UseKernel>
   typename std::enable_if<!ApplyKernel, bool>::type
   CalculateCentroid(const MatType& data,
-                    const std::vector<size_t>& neighbors,
-                    const std::vector<double>&, /*unused*/
+                    const size_t* neighbors,
+                    const double*, /*unused*/
+                    const size_t count,
                     arma::colvec& centroid);
 
   /**
@@ -157,6 +168,9 @@ class MeanShift
 
   //! Instantiated kernel.
   KernelType kernel;
+
+  //! The number of seeds whose range searches are done together.
+  static const size_t BlockSize = 4096;
 };
 
 } // namespace meanshift
@@ -130,12 +130,13 @@ template<bool ApplyKernel>
 typename std::enable_if<ApplyKernel, bool>::type
 MeanShift<UseKernel, KernelType, MatType>::
 CalculateCentroid(const MatType& data,
-                  const std::vector<size_t>& neighbors,
-                  const std::vector<double>& distances,
+                  const size_t* neighbors,
+                  const double* distances,
+                  const size_t count,
                   arma::colvec& centroid)
 {
   double sumWeight = 0;
-  for (size_t i = 0; i < neighbors.size(); ++i)
+  for (size_t i = 0; i < count; ++i)
   {
     if (distances[i] > 0)
     {
@@ -160,14 +161,15 @@ template<bool ApplyKernel>
 typename std::enable_if<!ApplyKernel, bool>::type
 MeanShift<UseKernel, KernelType, MatType>::
 CalculateCentroid(const MatType& data,
-                  const std::vector<size_t>& neighbors,
-                  const std::vector<double>&, /*unused*/
+                  const size_t* neighbors,
+                  const double*, /*unused*/
+                  const size_t count,
                   arma::colvec& centroid)
 {
-  for (size_t i = 0; i < neighbors.size(); ++i)
+  for (size_t i = 0; i < count; ++i)
     centroid += data.unsafe_col(neighbors[i]);
 
-  centroid /= neighbors.size();
+  centroid /= count;
   return true;
 }
 
@@ -196,63 +198,113 @@ inline void MeanShift<UseKernel, KernelType, MatType>::Cluster(
     pSeeds = &seeds;
   }
 
-  // Holds all centroids before removing duplicate ones.
-  arma::mat allCentroids(pSeeds->n_rows, pSeeds->n_cols);
+  // Holds all centroids before removing duplicate ones; initially, the
+  // centroid of each seed is the seed itself.
+  arma::mat allCentroids(*pSeeds);
 
-  assignments.set_size(data.n_cols);
+  // Whether the centroid of each seed has converged.
+  std::vector<char> converged(pSeeds->n_cols, 0);
 
+  // The seeds which are still shifted.
+  std::vector<size_t> active(pSeeds->n_cols);
+  for (size_t i = 0; i < active.size(); ++i)
+    active[i] = i;
+
+  // The tree is built once, and queried with the centroids of all the active
+  // seeds in each iteration.
   range::RangeSearch<> rangeSearcher(data);
   math::Range validRadius(0, radius);
-  std::vector<std::vector<size_t> > neighbors;
-  std::vector<std::vector<double> > distances;
+  const double tolerance = 1e-3 * radius;
 
-  // For each seed, perform mean shift algorithm.
-  for (size_t i = 0; i < pSeeds->n_cols; ++i)
+  std::vector<size_t> offsets;
+  std::vector<size_t> neighbors;
+  std::vector<double> distances;
+  for (size_t completedIterations = 0; completedIterations < maxIterations &&
+       !active.empty(); completedIterations++)
   {
-    // Initial centroid is the seed itself.
-    allCentroids.col(i) = pSeeds->unsafe_col(i);
-    for (size_t completedIterations = 0; completedIterations < maxIterations;
-         completedIterations++)
-    {
-      // Store new centroid in this.
-      arma::colvec newCentroid = arma::zeros<arma::colvec>(pSeeds->n_rows);
+    // Whether each active seed is still active after this iteration.
+    std::vector<char> stillActive(active.size(), 0);
 
-      rangeSearcher.Search(allCentroids.unsafe_col(i), validRadius,
-          neighbors, distances);
-      if (neighbors[0].size() <= 1)
-        break;
+    for (size_t blockBegin = 0; blockBegin < active.size();
+         blockBegin += BlockSize)
+    {
+      const size_t blockSize = std::min((size_t) BlockSize,
+          active.size() - blockBegin);
 
-      // Calculate new centroid.
-      if (!CalculateCentroid(data, neighbors[0], distances[0], newCentroid))
-        newCentroid = allCentroids.unsafe_col(i);
+      // Search for the neighbors of the centroids of the whole block at once.
+      arma::mat queries(pSeeds->n_rows, blockSize);
+      for (size_t j = 0; j < blockSize; ++j)
+        queries.col(j) = allCentroids.col(active[blockBegin + j]);
+      rangeSearcher.Search(queries, validRadius, offsets, neighbors,
+          distances);
 
-      // If the mean shift vector is small enough, it has converged.
-      if (metric::EuclideanDistance::Evaluate(newCentroid,
-          allCentroids.unsafe_col(i)) < 1e-3 * radius)
+      ThreadPool::ParallelFor(0, blockSize, [&](const size_t j)
       {
-        // Determine if the new centroid is duplicate with old ones.
-        bool isDuplicated = false;
-        for (size_t k = 0; k < centroids.n_cols; ++k)
+        const size_t i = active[blockBegin + j];
+        const size_t count = offsets[j + 1] - offsets[j];
+        if (count <= 1)
+          return;
+
+        // Calculate new centroid.
+        arma::colvec newCentroid = arma::zeros<arma::colvec>(pSeeds->n_rows);
+        if (!CalculateCentroid(data, neighbors.data() + offsets[j],
+            distances.data() + offsets[j], count, newCentroid))
+          newCentroid = allCentroids.unsafe_col(i);
+
+        // If the mean shift vector is small enough, it has converged.
+        if (metric::EuclideanDistance::Evaluate(newCentroid,
+            allCentroids.unsafe_col(i)) < tolerance)
         {
-          const double distance = metric::EuclideanDistance::Evaluate(
-              allCentroids.unsafe_col(i), centroids.unsafe_col(k));
-          if (distance < radius)
-          {
-            isDuplicated = true;
-            break;
-          }
+          converged[i] = 1;
+          return;
         }
 
-        if (!isDuplicated)
-          centroids.insert_cols(centroids.n_cols, allCentroids.unsafe_col(i));
+        // Update the centroid.
+        allCentroids.col(i) = newCentroid;
+        stillActive[blockBegin + j] = 1;
+      }, 16);
+    }
 
-        // Get out of the loop.
+    // Seeds whose centroids are in the same cell of a grid of the size of the
+    // tolerance are merged, keeping the first one.
+    typedef arma::colvec VecType;
+    std::map<VecType, size_t, less<VecType> > cells;
+    size_t remaining = 0;
+    for (size_t j = 0; j < active.size(); ++j)
+    {
+      if (!stillActive[j])
+        continue;
+
+      const VecType cell = arma::floor(allCentroids.unsafe_col(active[j]) /
+          tolerance);
+      if (cells.insert(std::make_pair(cell, active[j])).second)
+        active[remaining++] = active[j];
+    }
+    active.resize(remaining);
+  }
+
+  // Determine if the converged centroids are duplicates of earlier ones, in
+  // the order of the seeds.
+  centroids.set_size(pSeeds->n_rows, 0);
+  for (size_t i = 0; i < pSeeds->n_cols; ++i)
+  {
+    if (!converged[i])
+      continue;
+
+    bool isDuplicated = false;
+    for (size_t k = 0; k < centroids.n_cols; ++k)
+    {
+      const double distance = metric::EuclideanDistance::Evaluate(
+          allCentroids.unsafe_col(i), centroids.unsafe_col(k));
+      if (distance < radius)
+      {
+        isDuplicated = true;
         break;
       }
-
-      // Update the centroid.
-      allCentroids.col(i) = newCentroid;
     }
+
+    if (!isDuplicated)
+      centroids.insert_cols(centroids.n_cols, allCentroids.unsafe_col(i));
   }
 
   // Assign centroids to each point.
@@ -18,7 +18,10 @@ using namespace std;
 PROGRAM_INFO("Mean Shift Clustering", "This program performs mean shift "
     "clustering on the given dataset, storing the learned cluster assignments "
     "either as a column of labels in the file containing the input dataset or "
-    "in a separate file.");
+    "in a separate file."
+    "\n\n"
+    "The seeds are shifted together, and their new centroids are computed with "
+    "as many threads as specified by the --threads (-j) option.");
 
 // Required options.
 PARAM_STRING_REQ("inputFile", "Input dataset to perform clustering on.", "i");
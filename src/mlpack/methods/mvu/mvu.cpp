@@ -3,8 +3,6 @@
  * @author Ryan Curtin
  *
  * Implementation of the MVU class and its auxiliary objective function class.
- *
- * Note: this implementation of MVU does not work.  See #189.
  */
 #include "mvu.hpp"
 
@@ -32,70 +30,89 @@ void MVU::Unfold(const size_t newDim,
   // Following Nick's idea.
   outputData.randu(data.n_cols, newDim);
 
-  // The number of constraints is the number of nearest neighbors plus one.
-  LRSDP<arma::sp_mat> mvuSolver(numNeighbors * data.n_cols + 1, outputData);
+  // There is one sparse constraint for each nearest neighbor of each point,
+  // and one dense constraint.  The constraints are set below, so the LRSDP is
+  // created without any (its constructor would allocate an n x n matrix for
+  // each of them).
+  const size_t numConstraints = numNeighbors * data.n_cols;
+  LRSDP<SDP<arma::sp_mat>> mvuSolver(0, 0, outputData);
 
   // Set up the objective.  Because we are maximizing the trace of (R R^T),
   // we'll instead state it as min(-I_n * (R R^T)), meaning C() is -I_n.
-  mvuSolver.C().eye(data.n_cols, data.n_cols);
-  mvuSolver.C() *= -1;
-
-  // Now set up each of the constraints.
-  // The first constraint is trace(ones * R * R^T) = 0.
-  mvuSolver.B()[0] = 0;
-  mvuSolver.A()[0].ones(data.n_cols, data.n_cols);
+  mvuSolver.SDP().C().eye(data.n_cols, data.n_cols);
+  mvuSolver.SDP().C() *= -1;
+
+  // The dense constraint centers the output: trace(ones * R * R^T) = 0.  The
+  // matrix of ones is 1 1^T, so it is given by its factor, and the constraint
+  // is evaluated as ||1^T R||^2 without an n x n matrix.
+  mvuSolver.SDP().DenseB().zeros(1);
+  mvuSolver.Function().DenseFactors().ones(data.n_cols, 1);
+
+  // Now all of the other constraints.  We first have to find the nearest
+  // neighbors, with the parallel dual-tree traverser.
+  typedef tree::KDTree<metric::EuclideanDistance,
+      neighbor::NeighborSearchStat<neighbor::NearestNeighborSort>, arma::mat>
+      TreeType;
+  neighbor::NeighborSearch<neighbor::NearestNeighborSort,
+      metric::EuclideanDistance, arma::mat, tree::KDTree,
+      TreeType::ParallelDualTreeTraverser> knn(data);
 
-  // All of our other constraints will be sparse except the first.  So set that
-  // vector of modes accordingly.
-  mvuSolver.AModes().ones();
-  mvuSolver.AModes()[0] = 0;
-
-  // Now all of the other constraints.  We first have to run KNN to get the
-  // list of nearest neighbors.
   arma::Mat<size_t> neighbors;
   arma::mat distances;
-
-  KNN knn(data);
   knn.Search(numNeighbors, neighbors, distances);
 
   // Add each of the other constraints.  They are sparse constraints:
-  //   Tr(A_ij K) = d_ij;
+  //   Tr(A_ij K) = d_ij^2;
   //   A_ij = zeros except for 1 at (i, i), (j, j); -1 at (i, j), (j, i).
-  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  // Their elements are given to the LRSDP as one flat list (four elements per
+  // constraint), so that evaluating them only gathers the rows of R of the
+  // two points and takes their dot products.
+  mvuSolver.SDP().SparseB().set_size(numConstraints);
+  arma::Col<size_t>& offsets = mvuSolver.Function().SparseOffsets();
+  arma::umat& locations = mvuSolver.Function().SparseLocations();
+  arma::vec& values = mvuSolver.Function().SparseValues();
+  offsets.set_size(numConstraints + 1);
+  locations.set_size(2, 4 * numConstraints);
+  values.set_size(4 * numConstraints);
+  ThreadPool::ParallelFor(0, neighbors.n_cols, [&](const size_t i)
   {
     for (size_t j = 0; j < numNeighbors; ++j)
     {
       // This is the index of the constraint.
-      const size_t index = (i * numNeighbors) + j + 1;
-
-      arma::mat& aRef = mvuSolver.A()[index];
-
-      aRef.set_size(3, 4);
+      const size_t index = (i * numNeighbors) + j;
+      const size_t neighbor = neighbors(j, i);
+      const size_t offset = 4 * index;
+      offsets[index] = offset;
 
       // A_ij(i, i) = 1.
-      aRef(0, 0) = i;
-      aRef(1, 0) = i;
-      aRef(2, 0) = 1;
+      locations(0, offset) = i;
+      locations(1, offset) = i;
+      values[offset] = 1;
 
       // A_ij(i, j) = -1.
-      aRef(0, 1) = i;
-      aRef(1, 1) = neighbors(j, i);
-      aRef(2, 1) = -1;
+      locations(0, offset + 1) = i;
+      locations(1, offset + 1) = neighbor;
+      values[offset + 1] = -1;
 
       // A_ij(j, i) = -1.
-      aRef(0, 2) = neighbors(j, i);
-      aRef(1, 2) = i;
-      aRef(2, 2) = -1;
+      locations(0, offset + 2) = neighbor;
+      locations(1, offset + 2) = i;
+      values[offset + 2] = -1;
 
       // A_ij(j, j) = 1.
-      aRef(0, 3) = neighbors(j, i);
-      aRef(1, 3) = neighbors(j, i);
-      aRef(2, 3) = 1;
+      locations(0, offset + 3) = neighbor;
+      locations(1, offset + 3) = neighbor;
+      values[offset + 3] = 1;
 
-      // The constraint b_ij is the distance between these two points.
-      mvuSolver.B()[index] = distances(j, i);
+      // The constraint b_ij is the squared distance between these two points.
+      mvuSolver.SDP().SparseB()[index] = distances(j, i) * distances(j, i);
     }
-  }
+  });
+  offsets[numConstraints] = 4 * numConstraints;
+
+  // The LRSDP was created with only the dense constraint, so there is one
+  // Lagrange multiplier to add for each sparse constraint.
+  mvuSolver.AugLag().Lambda().zeros(numConstraints + 1);
 
   // Now on with the solving.
   double objective = mvuSolver.Optimize(outputData);
@@ -6,8 +6,6 @@
  * class as well as a class representing the objective function (a semidefinite
  * program) which MVU seeks to minimize.  Minimization is performed by the
  * Augmented Lagrangian optimizer (which in turn uses the L-BFGS optimizer).
- *
- * Note: this implementation of MVU does not work.  See #189.
  */
 #ifndef MLPACK_METHODS_MVU_MVU_HPP
 #define MLPACK_METHODS_MVU_MVU_HPP
@@ -3,8 +3,6 @@
  * @author Ryan Curtin
  *
  * Executable for MVU.
- *
- * Note: this implementation of MVU does not work.  See #189.
  */
 #include <mlpack/core.hpp>
 #include "mvu.hpp"
@@ -37,7 +35,7 @@ int main(int argc, char **argv)
   const int newDim = CLI::GetParam<int>("new_dim");
   const int numNeighbors = CLI::GetParam<int>("num_neighbors");
 
-  if (CLI::HasParam("output_file"))
+  if (!CLI::HasParam("output_file"))
     Log::Warn << "--output_file (-o) is not specified; no results will be "
         << "saved!" << endl;
 
@@ -85,6 +85,10 @@ class NaiveBayesClassifier
    * classes, either re-initialize or call Means(), Variances(), and
    * Probabilities() individually to set them to the right size.
    *
+   * With the incremental algorithm, the statistics of each class in the given
+   * data are computed and then merged into the model, so the data can be a
+   * mini-batch of a stream.
+   *
    * @param data The dataset to train on.
    * @param incremental Whether or not to use the incremental algorithm for
    *      training.
@@ -106,7 +110,9 @@ class NaiveBayesClassifier
 
   /**
    * Given a bunch of data points, this function evaluates the class of each of
-   * those data points, and puts it in the vector 'results'.
+   * those data points, and puts it in the vector 'results'.  The
+   * log-likelihoods of blocks of points for every class are computed with
+   * matrix products, and the blocks are classified in parallel.
    *
    * @code
    * arma::mat test_data; // each column is a test point
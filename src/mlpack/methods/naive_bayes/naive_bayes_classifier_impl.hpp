@@ -67,29 +67,56 @@ void NaiveBayesClassifier<MatType>::Train(const MatType& data,
   // for each of the features with respect to each of the labels.
   if (incremental)
   {
-    // Use incremental algorithm.
-    // Fist, de-normalize probabilities.
-    probabilities *= trainingPoints;
-
+    // Use incremental algorithm.  First, compute the count, mean, and sum of
+    // squared deviations of each class in the batch (with two passes over the
+    // batch).
+    arma::vec batchCounts(probabilities.n_elem, arma::fill::zeros);
+    arma::mat batchMeans(means.n_rows, means.n_cols, arma::fill::zeros);
     for (size_t j = 0; j < data.n_cols; ++j)
     {
       const size_t label = labels[j];
-      ++probabilities[label];
+      ++batchCounts[label];
+      batchMeans.col(label) += data.col(j);
+    }
+
+    for (size_t i = 0; i < batchCounts.n_elem; ++i)
+      if (batchCounts[i] != 0.0)
+        batchMeans.col(i) /= batchCounts[i];
 
-      arma::vec delta = data.col(j) - means.col(label);
-      means.col(label) += delta / probabilities[label];
-      variances.col(label) += delta % (data.col(j) - means.col(label));
+    arma::mat batchSquares(means.n_rows, means.n_cols, arma::fill::zeros);
+    for (size_t j = 0; j < data.n_cols; ++j)
+    {
+      const size_t label = labels[j];
+      batchSquares.col(label) += square(data.col(j) - batchMeans.col(label));
     }
 
+    // Now merge the statistics of the batch into the model, with the formula
+    // of Chan, Golub, and LeVeque for combining the variances of two sets.
+    // Fist, de-normalize probabilities.
+    probabilities *= trainingPoints;
     for (size_t i = 0; i < probabilities.n_elem; ++i)
     {
-      if (probabilities[i] > 2)
-        variances.col(i) /= (probabilities[i] - 1);
+      if (batchCounts[i] == 0.0)
+        continue;
+
+      const double count = probabilities[i] + batchCounts[i];
+      const arma::vec delta = batchMeans.col(i) - means.col(i);
+
+      arma::vec squares = batchSquares.col(i) + square(delta) *
+          (probabilities[i] * batchCounts[i] / count);
+      if (probabilities[i] > 1)
+        squares += variances.col(i) * (probabilities[i] - 1);
+
+      means.col(i) += delta * (batchCounts[i] / count);
+      variances.col(i) = (count > 1) ? arma::vec(squares / (count - 1)) :
+          squares;
+      probabilities[i] = count;
     }
   }
   else
   {
     // Set all parameters to zero
+    trainingPoints = 0;
     probabilities.zeros();
     means.zeros();
     variances.zeros();
@@ -131,8 +158,8 @@ void NaiveBayesClassifier<MatType>::Train(const MatType& data,
     if (variances[i] == 0.0)
       variances[i] = 1e-50;
 
-  probabilities /= data.n_cols;
   trainingPoints += data.n_cols;
+  probabilities /= trainingPoints;
 }
 
 template<typename MatType>
@@ -164,48 +191,51 @@ void NaiveBayesClassifier<MatType>::Classify(const MatType& data,
   // training data.
   Log::Assert(data.n_rows == means.n_rows);
 
-  arma::vec probs = arma::log(probabilities);
-  arma::mat invVar = 1.0 / variances;
-
-  arma::mat testProbs = arma::repmat(probs.t(), data.n_cols, 1);
-
   results.set_size(data.n_cols); // No need to fill with anything yet.
 
   Log::Info << "Running Naive Bayes classifier on " << data.n_cols
       << " data points with " << data.n_rows << " features each." << std::endl;
 
-  // Calculate the joint probability for each of the data points for each of the
-  // means.n_cols.
-
-  // Loop over every class.
-  for (size_t i = 0; i < means.n_cols; i++)
+  // The log-likelihood of a point x for class c, whose features are Gaussians
+  // with means mu_c and variances var_c, is
+  //
+  //   log p(c) - (d / 2) log(2 pi) - 0.5 * sum(log(var_c))
+  //       - 0.5 * sum((x - mu_c)^2 / var_c),
+  //
+  // and expanding the square gives
+  //
+  //   logNormalizers(c) + (mu_c / var_c)^T x - 0.5 * (1 / var_c)^T (x % x),
+  //
+  // so the log-likelihoods of a block of points for every class are given by
+  // two matrix products.
+  const arma::mat invVar = 1.0 / variances;
+  const arma::mat meansInvVar = means % invVar;
+  const arma::vec logNormalizers = arma::log(probabilities) -
+      data.n_rows / 2.0 * std::log(2 * M_PI) -
+      0.5 * arma::trans(arma::sum(arma::log(variances), 0)) -
+      0.5 * arma::trans(arma::sum(means % meansInvVar, 0));
+
+  // The blocks of points are independent, so they are classified in parallel.
+  const size_t blockSize = 1024;
+  const size_t blocks = (data.n_cols + blockSize - 1) / blockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
   {
-    // This is an adaptation of gmm::phi() for the case where the covariance is
-    // a diagonal matrix.
-    arma::mat diffs = data - arma::repmat(means.col(i), 1, data.n_cols);
-    arma::mat rhs = -0.5 * arma::diagmat(invVar.col(i)) * diffs;
-    arma::vec exponents(diffs.n_cols);
-    for (size_t j = 0; j < diffs.n_cols; ++j) // log(exp(value)) == value
-      exponents(j) = arma::accu(diffs.col(j) % rhs.unsafe_col(j));
-
-    // Calculate probability as sum of logarithm to decrease floating point
-    // errors.
-    testProbs.col(i) += (data.n_rows / -2.0 * log(2 * M_PI) - 0.5 *
-        log(arma::det(arma::diagmat(variances.col(i)))) + exponents);
-  }
-
-  // Now calculate the label.
-  for (size_t i = 0; i < data.n_cols; ++i)
-  {
-    // Find the index of the class with maximum probability for this point.
-    arma::uword maxIndex = 0;
-    arma::vec pointProbs = testProbs.row(i).t();
-    pointProbs.max(maxIndex);
+    const size_t begin = b * blockSize;
+    const size_t end = std::min((size_t) data.n_cols, begin + blockSize);
+    const arma::mat block = data.cols(begin, end - 1);
 
-    results[i] = maxIndex;
-  }
+    arma::mat testProbs = meansInvVar.t() * block -
+        0.5 * invVar.t() * arma::square(block);
+    testProbs.each_col() += logNormalizers;
 
-  return;
+    // Find the index of the class with maximum probability for each point.
+    arma::uword maxIndex;
+    for (size_t j = 0; j < block.n_cols; ++j)
+    {
+      testProbs.unsafe_col(j).max(maxIndex);
+      results[begin + j] = maxIndex;
+    }
+  });
 }
 
 template<typename MatType>
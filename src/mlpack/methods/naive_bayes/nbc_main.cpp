@@ -9,6 +9,8 @@
  */
 #include <mlpack/core.hpp>
 
+#include <mlpack/core/cv/k_fold_cv.hpp>
+
 #include "naive_bayes_classifier.hpp"
 
 PROGRAM_INFO("Parametric Naive Bayes Classifier",
@@ -25,6 +27,10 @@ PROGRAM_INFO("Parametric Naive Bayes Classifier",
     "use an incremental algorithm for calculating variance.  This is slower, "
     "but can help avoid loss of precision in some cases."
     "\n\n"
+    "If the --folds (-f) option is given with a value of at least 2, the "
+    "accuracy of the classifier on the training set is also estimated with "
+    "k-fold cross-validation (with that number of folds, trained in parallel)."
+    "\n\n"
     "If classifying a test set is desired, the test set should be in the file "
     "specified with the --test_file (-T) option, and the classifications will "
     "be saved to the file specified with the --output_file (-o) option.  If "
@@ -43,6 +49,8 @@ PARAM_STRING("labels_file", "A file containing labels for the training set.",
     "l", "");
 PARAM_FLAG("incremental_variance", "The variance of each class will be "
     "calculated incrementally.", "I");
+PARAM_INT("folds", "If at least 2, the number of folds of the k-fold "
+    "cross-validation of the classifier on the training set.", "f", 0);
 
 // Test parameters.
 PARAM_STRING("test_file", "A file containing the test set.", "T", "");
@@ -144,6 +152,28 @@ int main(int argc, char* argv[])
     model.nbc = NaiveBayesClassifier<>(trainingData, labels,
         model.mappings.n_elem, incrementalVariance);
     Timer::Stop("nbc_training");
+
+    const int folds = CLI::GetParam<int>("folds");
+    if (folds > 1)
+    {
+      if ((size_t) folds > trainingData.n_cols)
+        Log::Fatal << "Cannot use more folds (" << folds << ") than training "
+            << "points (" << trainingData.n_cols << ")!" << endl;
+
+      Timer::Start("nbc_cross_validation");
+      const size_t numClasses = model.mappings.n_elem;
+      cv::KFoldCV<> cv(trainingData, labels, (size_t) folds);
+      const double accuracy = cv.Evaluate(
+          [&](const mat& foldData, const Row<size_t>& foldLabels)
+          {
+            return NaiveBayesClassifier<>(foldData, foldLabels, numClasses,
+                incrementalVariance);
+          });
+      Timer::Stop("nbc_cross_validation");
+
+      Log::Info << folds << "-fold cross-validation accuracy: " << accuracy
+          << "." << endl;
+    }
   }
   else
   {
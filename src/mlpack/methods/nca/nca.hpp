@@ -77,6 +77,13 @@ class NCA
   //! Get the labels reference.
   const arma::Row<size_t>& Labels() const { return labels; }
 
+  //! Get the objective function.
+  const SoftmaxErrorFunction<MetricType>& Function() const
+  { return errorFunction; }
+  //! Modify the objective function (for instance, to truncate it to the
+  //! nearest neighbors of each point).
+  SoftmaxErrorFunction<MetricType>& Function() { return errorFunction; }
+
   //! Get the optimizer.
   const OptimizerType<SoftmaxErrorFunction<MetricType> >& Optimizer() const
   { return optimizer; }
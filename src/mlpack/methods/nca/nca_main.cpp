@@ -68,7 +68,16 @@ PROGRAM_INFO("Neighborhood Components Analysis (NCA)",
     "documentation (in lbfgs.hpp) or the vast set of published literature on "
     "L-BFGS."
     "\n\n"
-    "By default, the SGD optimizer is used.");
+    "By default, the SGD optimizer is used."
+    "\n\n"
+    "For large datasets, the objective can be truncated to the nearest "
+    "neighbors of each point with the --neighbors (-k) option; then each point "
+    "only takes time proportional to the number of neighbors, instead of the "
+    "number of points.  The neighbors are found again (with a dual-tree "
+    "nearest neighbor search in the stretched space) after every "
+    "--refresh_interval "
+    "(-R) passes over the dataset.  The truncated objective is evaluated for "
+    "L-BFGS with several threads, as specified by --threads (-j).");
 
 PARAM_STRING_REQ("input_file", "Input dataset to run NCA on.", "i");
 PARAM_STRING_REQ("output_file", "Output file for learned distance matrix.",
@@ -101,6 +110,11 @@ PARAM_INT("max_line_search_trials", "Maximum number of line search trials for "
 PARAM_DOUBLE("min_step", "Minimum step of line search for L-BFGS.", "m", 1e-20);
 PARAM_DOUBLE("max_step", "Maximum step of line search for L-BFGS.", "M", 1e20);
 
+PARAM_INT("neighbors", "Number of nearest neighbors of each point to consider "
+    "in the objective (0 means all the points).", "k", 0);
+PARAM_INT("refresh_interval", "Number of passes over the dataset after which "
+    "the nearest neighbors are found again (with --neighbors).", "R", 1);
+
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 using namespace mlpack;
@@ -190,6 +204,23 @@ int main(int argc, char* argv[])
   const double maxStep = CLI::GetParam<double>("max_step");
   const size_t batchSize = (size_t) CLI::GetParam<int>("batch_size");
 
+  if (CLI::GetParam<int>("neighbors") < 0)
+  {
+    Log::Fatal << "Invalid number of neighbors (" << CLI::GetParam<int>(
+        "neighbors") << "); must be 0 or greater!" << endl;
+  }
+  if (CLI::GetParam<int>("refresh_interval") <= 0)
+  {
+    Log::Fatal << "Invalid refresh interval (" << CLI::GetParam<int>(
+        "refresh_interval") << "); must be greater than 0!" << endl;
+  }
+  if (CLI::HasParam("refresh_interval") && !CLI::HasParam("neighbors"))
+    Log::Warn << "Parameter --refresh_interval ignored (--neighbors is not "
+        << "given)." << endl;
+  const size_t neighbors = (size_t) CLI::GetParam<int>("neighbors");
+  const size_t refreshInterval = (size_t) CLI::GetParam<int>(
+      "refresh_interval");
+
   // Load data.
   arma::mat data;
   data::Load(inputFile, data, true);
@@ -244,6 +275,8 @@ int main(int argc, char* argv[])
   if (optimizerType == "sgd")
   {
     NCA<LMetric<2> > nca(data, labels);
+    nca.Function().Neighbors() = neighbors;
+    nca.Function().RefreshInterval() = refreshInterval;
     nca.Optimizer().StepSize() = stepSize;
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().Tolerance() = tolerance;
@@ -254,6 +287,8 @@ int main(int argc, char* argv[])
   else if (optimizerType == "lbfgs")
   {
     NCA<LMetric<2>, L_BFGS> nca(data, labels);
+    nca.Function().Neighbors() = neighbors;
+    nca.Function().RefreshInterval() = refreshInterval;
     nca.Optimizer().NumBasis() = numBasis;
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().ArmijoConstant() = armijoConstant;
@@ -268,6 +303,8 @@ int main(int argc, char* argv[])
   else if (optimizerType == "minibatch-sgd")
   {
     NCA<LMetric<2>, MiniBatchSGD> nca(data, labels);
+    nca.Function().Neighbors() = neighbors;
+    nca.Function().RefreshInterval() = refreshInterval;
     nca.Optimizer().StepSize() = stepSize;
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().Tolerance() = tolerance;
@@ -9,6 +9,7 @@
 #define MLPACK_METHODS_NCA_NCA_SOFTMAX_ERROR_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 
 namespace mlpack {
 namespace nca {
@@ -31,7 +32,22 @@ namespace nca {
  * In addition to the standard Evaluate() and Gradient() functions which mlpack
  * optimizers use, overloads of Evaluate() and Gradient() are given which only
  * operate on one point in the dataset.  This is useful for optimizers like
- * stochastic gradient descent (see mlpack::optimization::SGD).
+ * stochastic gradient descent (see mlpack::optimization::SGD).  Overloads which
+ * operate on a batch of consecutive points are also given, for mini-batch
+ * optimizers (see mlpack::optimization::MiniBatchSGD); they stretch the
+ * dataset once per batch and sum the outer products of the gradient with
+ * matrix multiplications.
+ *
+ * All of these take O(N) time per point, which is infeasible for large
+ * datasets.  Since exp(-D(A x_i, A x_k)) decays quickly with the distance, the
+ * objective can instead be truncated to the k nearest neighbors of each point
+ * in the stretched space (see Neighbors()); then the softmax of each point is
+ * only taken over its neighbors, and each point takes O(k) time.  The
+ * neighborhoods are found with dual-tree nearest neighbor search (with the
+ * Euclidean distance between the stretched points) and are refreshed after
+ * every RefreshInterval() passes over the dataset, since they change as the
+ * optimizer changes the stretching.  The non-separable Evaluate() and
+ * Gradient() run over the points in parallel when the objective is truncated.
  */
 template<typename MetricType = metric::SquaredEuclideanDistance>
 class SoftmaxErrorFunction
@@ -51,6 +67,24 @@ class SoftmaxErrorFunction
                        const arma::Row<size_t>& labels,
                        MetricType metric = MetricType());
 
+  /**
+   * Initialize the function with the objective truncated to the given number
+   * of nearest neighbors of each point.
+   *
+   * @param dataset Matrix containing the dataset.
+   * @param labels Vector of class labels for each point in the dataset.
+   * @param neighbors Number of nearest neighbors of each point to consider (0
+   *     means all the points).
+   * @param refreshInterval Number of passes over the dataset after which the
+   *     neighborhoods are found again.
+   * @param metric Instantiated metric (optional).
+   */
+  SoftmaxErrorFunction(const arma::mat& dataset,
+                       const arma::Row<size_t>& labels,
+                       const size_t neighbors,
+                       const size_t refreshInterval = 1,
+                       MetricType metric = MetricType());
+
   /**
    * Evaluate the softmax function for the given covariance matrix.  This is the
    * non-separable implementation, where the objective function is not
@@ -72,6 +106,21 @@ class SoftmaxErrorFunction
    */
   double Evaluate(const arma::mat& covariance, const size_t i);
 
+  /**
+   * Evaluate the softmax objective function for the given covariance matrix on
+   * the points begin to (begin + batchSize - 1) of the dataset.  This is the
+   * sum of the separable objective functions of those points.
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param begin Index of the first point to use for objective function.
+   * @param batchSize Number of points to use for objective function.
+   * @param deterministic Unused (there is nothing random in the objective).
+   */
+  double Evaluate(const arma::mat& covariance,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic);
+
   /**
    * Evaluate the gradient of the softmax function for the given covariance
    * matrix.  This is the non-separable implementation, where the objective
@@ -97,6 +146,21 @@ class SoftmaxErrorFunction
                 const size_t i,
                 arma::mat& gradient);
 
+  /**
+   * Evaluate the gradient of the softmax function for the given covariance
+   * matrix on the points begin to (begin + batchSize - 1) of the dataset.  This
+   * is the sum of the separable gradients of those points.
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param begin Index of the first point to use for objective function.
+   * @param gradient Matrix to store the calculated gradient in.
+   * @param batchSize Number of points to use for objective function.
+   */
+  void Gradient(const arma::mat& covariance,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize);
+
   /**
    * Get the initial point.
    */
@@ -108,6 +172,19 @@ class SoftmaxErrorFunction
    */
   size_t NumFunctions() const { return dataset.n_cols; }
 
+  //! Get the number of nearest neighbors of each point considered (0 means all
+  //! the points).
+  size_t Neighbors() const { return neighbors; }
+  //! Modify the number of nearest neighbors of each point considered.
+  size_t& Neighbors() { return neighbors; }
+
+  //! Get the number of passes over the dataset after which the neighborhoods
+  //! are found again.
+  size_t RefreshInterval() const { return refreshInterval; }
+  //! Modify the number of passes after which the neighborhoods are found
+  //! again.
+  size_t& RefreshInterval() { return refreshInterval; }
+
  private:
   //! The dataset.
   const arma::mat& dataset;
@@ -130,6 +207,20 @@ class SoftmaxErrorFunction
   //! False if nothing has ever been precalculated (only at construction time).
   bool precalculated;
 
+  //! The number of nearest neighbors of each point considered (0 for all).
+  size_t neighbors;
+  //! The number of passes after which the neighborhoods are found again.
+  size_t refreshInterval;
+  //! The nearest neighbors of each point in the stretched space (one column
+  //! per point).
+  arma::Mat<size_t> neighborhoods;
+  //! The number of points evaluated since the neighborhoods were found.
+  size_t pointsSinceRefresh;
+
+  //! The minimum number of points that each thread handles in the truncated
+  //! non-separable Evaluate() and Gradient().
+  static const size_t BlockSize = 256;
+
   /**
    * Precalculate the denominators and numerators that will make up the p_ij,
    * but only if the coordinates matrix is different than the last coordinates
@@ -144,6 +235,48 @@ class SoftmaxErrorFunction
    * @param coordinates Coordinates matrix to use for precalculation.
    */
   void Precalculate(const arma::mat& coordinates);
+
+  /**
+   * Compute exp(-D(A x_i, A x_k)) for each point i of the given batch (one
+   * column per point) and each point k of the dataset (one row per point),
+   * with zeros where i == k.  The stretched dataset must already be computed.
+   *
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param kernel Matrix to store the results in.
+   */
+  void BatchKernel(const size_t begin,
+                   const size_t batchSize,
+                   arma::mat& kernel);
+
+  /**
+   * Find the nearest neighbors of each point in the stretched space, if there
+   * are none yet or if the refresh interval has passed, and count the given
+   * number of points as evaluated.
+   *
+   * @param coordinates Coordinates matrix to stretch the dataset with.
+   * @param points Number of points which are about to be evaluated.
+   */
+  void UpdateNeighborhoods(const arma::mat& coordinates, const size_t points);
+
+  //! Return the indices of the given point and its neighbors (the point
+  //! first).
+  arma::uvec NeighborhoodIndices(const size_t i) const;
+
+  /**
+   * Compute p_i over the neighborhood of point i and, if sum is not NULL, add
+   * sum_k w_ik x_ik x_ik^T to it, where w_ik = p_ik (p_i - [class of k is the
+   * class of i]); the gradient of -p_i is -2 A times this sum.  If the
+   * denominator of p_i is 0, 0 is returned and nothing is added.
+   *
+   * @param i Index of the point.
+   * @param stretchedPoints Stretched point i and its neighbors, in the order
+   *     of NeighborhoodIndices(i).
+   * @param sum Matrix to add the weighted outer products to (may be NULL).
+   */
+  double NeighborhoodTerms(const size_t i,
+                           const arma::mat& stretchedPoints,
+                           arma::mat* sum);
 };
 
 } // namespace nca
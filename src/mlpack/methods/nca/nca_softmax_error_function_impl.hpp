@@ -22,7 +22,27 @@ SoftmaxErrorFunction<MetricType>::SoftmaxErrorFunction(
     dataset(dataset),
     labels(labels),
     metric(metric),
-    precalculated(false)
+    precalculated(false),
+    neighbors(0),
+    refreshInterval(1),
+    pointsSinceRefresh(0)
+{ /* nothing to do */ }
+
+// Initialize with the objective truncated to the nearest neighbors.
+template<typename MetricType>
+SoftmaxErrorFunction<MetricType>::SoftmaxErrorFunction(
+    const arma::mat& dataset,
+    const arma::Row<size_t>& labels,
+    const size_t neighbors,
+    const size_t refreshInterval,
+    MetricType metric) :
+    dataset(dataset),
+    labels(labels),
+    metric(metric),
+    precalculated(false),
+    neighbors(neighbors),
+    refreshInterval(refreshInterval),
+    pointsSinceRefresh(0)
 { /* nothing to do */ }
 
 //! The non-separable implementation, which uses Precalculate() to save time.
@@ -41,6 +61,14 @@ template<typename MetricType>
 double SoftmaxErrorFunction<MetricType>::Evaluate(const arma::mat& coordinates,
                                                   const size_t i)
 {
+  // With a truncated objective, only the neighbors of the point are stretched.
+  if (neighbors > 0)
+  {
+    UpdateNeighborhoods(coordinates, 0);
+    return -NeighborhoodTerms(i, coordinates * dataset.cols(
+        NeighborhoodIndices(i)), NULL);
+  }
+
   // Unfortunately each evaluation will take O(N) time because it requires a
   // scan over all points in the dataset.  Our objective is to compute p_i.
   double denominator = 0;
@@ -78,6 +106,57 @@ double SoftmaxErrorFunction<MetricType>::Evaluate(const arma::mat& coordinates,
                                      // minimizer.
 }
 
+//! The separated objective function of a batch of points.
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::Evaluate(
+    const arma::mat& coordinates,
+    const size_t begin,
+    const size_t batchSize,
+    const bool /* deterministic */)
+{
+  if (neighbors > 0)
+  {
+    UpdateNeighborhoods(coordinates, 0);
+
+    double result = 0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      result -= NeighborhoodTerms(i, coordinates * dataset.cols(
+          NeighborhoodIndices(i)), NULL);
+    }
+
+    return result;
+  }
+
+  stretchedDataset = coordinates * dataset;
+
+  arma::mat kernel;
+  BatchKernel(begin, batchSize, kernel);
+
+  double result = 0;
+  for (size_t j = 0; j < batchSize; ++j)
+  {
+    const size_t i = begin + j;
+
+    double numerator = 0;
+    for (size_t k = 0; k < dataset.n_cols; ++k)
+      if (labels[i] == labels[k])
+        numerator += kernel(k, j);
+
+    const double denominator = arma::accu(kernel.col(j));
+    if (denominator == 0.0)
+    {
+      Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
+      continue;
+    }
+
+    result -= numerator / denominator; // Negate because the optimizer is a
+                                       // minimizer.
+  }
+
+  return result;
+}
+
 //! The non-separable implementation, where Precalculate() is used.
 template<typename MetricType>
 void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
@@ -86,6 +165,33 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   // Calculate the denominators and numerators, if necessary.
   Precalculate(coordinates);
 
+  if (neighbors > 0)
+  {
+    // Each thread sums the gradient terms of its own range of points, and then
+    // the sums of the ranges are added.
+    const size_t ranges = std::max((size_t) 1, std::min(ThreadPool::Threads(),
+        (size_t) dataset.n_cols / BlockSize));
+    std::vector<arma::mat> sums(ranges);
+    ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+    {
+      const size_t begin = r * dataset.n_cols / ranges;
+      const size_t end = (r + 1) * dataset.n_cols / ranges;
+
+      sums[r].zeros(dataset.n_rows, dataset.n_rows);
+      for (size_t i = begin; i < end; ++i)
+      {
+        NeighborhoodTerms(i, stretchedDataset.cols(NeighborhoodIndices(i)),
+            &sums[r]);
+      }
+    });
+
+    for (size_t r = 1; r < ranges; ++r)
+      sums[0] += sums[r];
+
+    gradient = -2 * coordinates * sums[0];
+    return;
+  }
+
   // Now, we handle the summation over i:
   //   sum_i (p_i sum_k (p_ik x_ik x_ik^T) -
   //       sum_{j in class of i} (p_ij x_ij x_ij^T)
@@ -132,6 +238,18 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
                                                 const size_t i,
                                                 arma::mat& gradient)
 {
+  // With a truncated objective, only the neighbors of the point are stretched.
+  if (neighbors > 0)
+  {
+    UpdateNeighborhoods(coordinates, 1);
+
+    arma::mat sum(dataset.n_rows, dataset.n_rows, arma::fill::zeros);
+    NeighborhoodTerms(i, coordinates * dataset.cols(NeighborhoodIndices(i)),
+        &sum);
+    gradient = -2 * coordinates * sum;
+    return;
+  }
+
   // We will need to calculate p_i before this evaluation is done, so these two
   // variables will hold the information necessary for that.
   double numerator = 0;
@@ -196,6 +314,83 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   gradient = -2 * coordinates * (p * firstTerm - secondTerm);
 }
 
+//! The separable implementation for a batch of points.
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
+                                                const size_t begin,
+                                                arma::mat& gradient,
+                                                const size_t batchSize)
+{
+  if (neighbors > 0)
+  {
+    UpdateNeighborhoods(coordinates, batchSize);
+
+    arma::mat sum(dataset.n_rows, dataset.n_rows, arma::fill::zeros);
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      NeighborhoodTerms(i, coordinates * dataset.cols(NeighborhoodIndices(i)),
+          &sum);
+    }
+
+    gradient = -2 * coordinates * sum;
+    return;
+  }
+
+  stretchedDataset = coordinates * dataset;
+
+  // The gradient of point i is
+  //   -2 A sum_k (p_ik (p_i - [class of k is the class of i])) x_ik x_ik^T,
+  // so we turn the kernel into the weights of the outer products.
+  arma::mat weights;
+  BatchKernel(begin, batchSize, weights);
+  for (size_t j = 0; j < batchSize; ++j)
+  {
+    const size_t i = begin + j;
+
+    double numerator = 0;
+    for (size_t k = 0; k < dataset.n_cols; ++k)
+      if (labels[i] == labels[k])
+        numerator += weights(k, j);
+
+    const double denominator = arma::accu(weights.col(j));
+    if (denominator == 0)
+    {
+      Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
+      // There is no gradient contribution from this point.
+      weights.col(j).zeros();
+      continue;
+    }
+
+    const double p = numerator / denominator;
+    for (size_t k = 0; k < dataset.n_cols; ++k)
+    {
+      weights(k, j) *= (p - ((labels[i] == labels[k]) ? 1.0 : 0.0)) /
+          denominator;
+    }
+  }
+
+  // With w_ki the weights of the batch, the sum of the weighted outer products
+  // sum_i sum_k w_ki (x_i - x_k) (x_i - x_k)^T expands into
+  //   sum_i s_i x_i x_i^T - X_b M^T - M X_b^T + sum_k r_k x_k x_k^T,
+  // where s and r are the column and row sums of the weights, X_b holds the
+  // points of the batch, and M = X W.  For x_ik we are not using stretched
+  // points.
+  const arma::mat batch(const_cast<double*>(dataset.colptr(begin)),
+      dataset.n_rows, batchSize, false, true);
+  const arma::mat m = dataset * weights;
+
+  arma::mat scaledBatch = batch;
+  scaledBatch.each_row() %= arma::sum(weights, 0);
+  arma::mat scaledDataset = dataset;
+  scaledDataset.each_row() %= trans(arma::sum(weights, 1));
+
+  const arma::mat sum = scaledBatch * trans(batch) - batch * trans(m) -
+      m * trans(batch) + scaledDataset * trans(dataset);
+
+  // Assemble the final gradient.
+  gradient = -2 * coordinates * sum;
+}
+
 template<typename MetricType>
 const arma::mat SoftmaxErrorFunction<MetricType>::GetInitialPoint() const
 {
@@ -218,6 +413,22 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   lastCoordinates = coordinates;
   stretchedDataset = coordinates * dataset;
 
+  if (neighbors > 0)
+  {
+    // Each p_i is only taken over the neighborhood of point i, so the points
+    // are independent.
+    UpdateNeighborhoods(coordinates, dataset.n_cols);
+    p.set_size(dataset.n_cols);
+    ThreadPool::ParallelFor(0, dataset.n_cols, [&](const size_t i)
+    {
+      p[i] = NeighborhoodTerms(i, stretchedDataset.cols(NeighborhoodIndices(i)),
+          NULL);
+    }, BlockSize);
+
+    precalculated = true;
+    return;
+  }
+
   // For each point i, we must evaluate the softmax function:
   //   p_ij = exp( -K(x_i, x_j) ) / ( sum_{k != i} ( exp( -K(x_i, x_k) )))
   //   p_i = sum_{j in class of i} p_ij
@@ -267,6 +478,105 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   precalculated = true;
 }
 
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::BatchKernel(const size_t begin,
+                                                   const size_t batchSize,
+                                                   arma::mat& kernel)
+{
+  kernel.set_size(dataset.n_cols, batchSize);
+  for (size_t j = 0; j < batchSize; ++j)
+  {
+    const size_t i = begin + j;
+    for (size_t k = 0; k < dataset.n_cols; ++k)
+    {
+      // Don't consider the case where the points are the same.
+      kernel(k, j) = (k == i) ? 0.0 : std::exp(-metric.Evaluate(
+          stretchedDataset.unsafe_col(i), stretchedDataset.unsafe_col(k)));
+    }
+  }
+}
+
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::UpdateNeighborhoods(
+    const arma::mat& coordinates,
+    const size_t points)
+{
+  // A point cannot be its own neighbor.
+  const size_t k = std::min(neighbors, (size_t) dataset.n_cols - 1);
+  if (neighborhoods.n_rows == k && neighborhoods.n_cols == dataset.n_cols &&
+      pointsSinceRefresh < refreshInterval * dataset.n_cols)
+  {
+    pointsSinceRefresh += points;
+    return;
+  }
+
+  Log::Debug << "Finding the " << k << " nearest neighbors of each point in "
+      << "the stretched space." << std::endl;
+
+  arma::mat distances;
+  neighbor::KNN knn(arma::mat(coordinates * dataset));
+  knn.Search(k, neighborhoods, distances);
+
+  pointsSinceRefresh = points;
+}
+
+template<typename MetricType>
+arma::uvec SoftmaxErrorFunction<MetricType>::NeighborhoodIndices(
+    const size_t i) const
+{
+  arma::uvec indices(neighborhoods.n_rows + 1);
+  indices[0] = i;
+  for (size_t j = 0; j < neighborhoods.n_rows; ++j)
+    indices[j + 1] = neighborhoods(j, i);
+
+  return indices;
+}
+
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::NeighborhoodTerms(
+    const size_t i,
+    const arma::mat& stretchedPoints,
+    arma::mat* sum)
+{
+  const size_t k = neighborhoods.n_rows;
+
+  // Evaluate exp(-D(A x_i, A x_k)) for each neighbor k.
+  arma::vec evals(k);
+  double numerator = 0;
+  for (size_t j = 0; j < k; ++j)
+  {
+    evals[j] = std::exp(-metric.Evaluate(stretchedPoints.unsafe_col(0),
+        stretchedPoints.unsafe_col(j + 1)));
+    if (labels[i] == labels[neighborhoods(j, i)])
+      numerator += evals[j];
+  }
+
+  const double denominator = arma::accu(evals);
+  if (denominator == 0.0)
+    return 0;
+
+  const double p = numerator / denominator;
+  if (sum != NULL)
+  {
+    // For x_ik we are not using stretched points.
+    arma::mat differences(dataset.n_rows, k);
+    arma::mat weightedDifferences(dataset.n_rows, k);
+    for (size_t j = 0; j < k; ++j)
+    {
+      const size_t n = neighborhoods(j, i);
+      const double weight = evals[j] / denominator *
+          (p - ((labels[i] == labels[n]) ? 1.0 : 0.0));
+
+      differences.col(j) = dataset.col(i) - dataset.col(n);
+      weightedDifferences.col(j) = weight * differences.col(j);
+    }
+
+    *sum += weightedDifferences * trans(differences);
+  }
+
+  return p;
+}
+
 } // namespace nca
 } // namespace mlpack
 
@@ -0,0 +1,130 @@
+/**
+ * @file blocked_brute_force.hpp
+ *
+ * Defines the BlockedBruteForce class, which performs brute-force neighbor
+ * search with the Euclidean distance using blocked matrix multiplications.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_BLOCKED_BRUTE_FORCE_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_BLOCKED_BRUTE_FORCE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#include "candidate_heap.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * This is a template metaprogramming class that tells whether BlockedBruteForce
+ * can be used for the given metric and matrix type.  By default it can't; it
+ * can only be used for the (squared) Euclidean distance on dense matrices of
+ * doubles.
+ */
+template<typename MetricType, typename MatType>
+struct BlockedBruteForceTraits
+{
+  //! Whether BlockedBruteForce can be used.
+  static const bool UseBlockedBruteForce = false;
+  //! Whether the distances are square-rooted.
+  static const bool TakeRoot = false;
+};
+
+//! The (squared) Euclidean distance on dense matrices can be used.
+template<bool TTakeRoot>
+struct BlockedBruteForceTraits<metric::LMetric<2, TTakeRoot>, arma::mat>
+{
+  //! Whether BlockedBruteForce can be used.
+  static const bool UseBlockedBruteForce = true;
+  //! Whether the distances are square-rooted.
+  static const bool TakeRoot = TTakeRoot;
+};
+
+/**
+ * The BlockedBruteForce class computes the k nearest (or furthest) neighbors of
+ * a set of query points by brute force, for the Euclidean distance.  Instead of
+ * evaluating the metric once for each pair of points, the squared distances
+ * between a block of query points and a block of reference points are computed
+ * at once as ||q||^2 + ||r||^2 - 2 q^T r, where the inner products are computed
+ * with a single matrix multiplication (which goes through BLAS, if available).
+ * The points are first shifted by the mean of the reference set, to keep the
+ * cancellation error of the expansion small.  A reference point is only
+ * skipped when even the best distance within a tolerance of the expansion
+ * can't be a candidate; otherwise its distance is computed exactly with the
+ * metric, and the candidates for each query point are kept in a CandidateHeap
+ * by their exact distances.  So, the results are exact even for data far from
+ * the origin.  Query blocks are processed in parallel with OpenMP.
+ *
+ * In high dimensions this is often faster than any tree-based search.
+ * NeighborSearch uses it automatically in naive mode when the metric and
+ * matrix type allow it (see BlockedBruteForceTraits); the same traits decide
+ * whether NeighborSearchRules computes the base cases of pairs of large leaves
+ * with a matrix product.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ */
+template<typename SortPolicy>
+class BlockedBruteForce
+{
+ public:
+  /**
+   * Search for the neighbors of each query point, if this is possible for the
+   * given metric and matrix type, and return whether it was.  The neighbors
+   * and distances matrices must have k rows and one column for each query
+   * point, and they must be initialized like the results of NeighborSearchRules
+   * (with size_t() - 1 and SortPolicy::WorstDistance()).  Like with
+   * NeighborSearchRules, the candidates for each query point are left as a
+   * heap in its column, so the columns must be sorted with
+   * CandidateHeap::Sort() afterwards.
+   *
+   * @tparam MetricType The metric to use for computation.
+   * @param querySet Set of query points.
+   * @param referenceSet Set of reference points.
+   * @param neighbors Matrix of candidate neighbors for each query point.
+   * @param distances Matrix of candidate distances for each query point.
+   * @param sameSet If true, the query set is the reference set, and a point is
+   *     not returned as its own neighbor.
+   * @param queryBlockSize Number of query points in each block.
+   * @param referenceBlockSize Number of reference points in each block.
+   */
+  template<typename MetricType, typename MatType>
+  static bool Search(const MatType& querySet,
+                     const MatType& referenceSet,
+                     arma::Mat<size_t>& neighbors,
+                     arma::mat& distances,
+                     const bool sameSet = false,
+                     const size_t queryBlockSize = 256,
+                     const size_t referenceBlockSize = 1024);
+
+ private:
+  //! Perform the search; this is called when it is possible.
+  template<typename MetricType, typename MatType>
+  static bool Search(const MatType& querySet,
+                     const MatType& referenceSet,
+                     arma::Mat<size_t>& neighbors,
+                     arma::mat& distances,
+                     const bool sameSet,
+                     const size_t queryBlockSize,
+                     const size_t referenceBlockSize,
+                     const std::true_type& /* possible */);
+
+  //! Do nothing; this is called when the search is not possible.
+  template<typename MetricType, typename MatType>
+  static bool Search(const MatType& /* querySet */,
+                     const MatType& /* referenceSet */,
+                     arma::Mat<size_t>& /* neighbors */,
+                     arma::mat& /* distances */,
+                     const bool /* sameSet */,
+                     const size_t /* queryBlockSize */,
+                     const size_t /* referenceBlockSize */,
+                     const std::false_type& /* possible */)
+  { return false; }
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "blocked_brute_force_impl.hpp"
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file blocked_brute_force_impl.hpp
+ *
+ * Implementation of the BlockedBruteForce class.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_BLOCKED_BRUTE_FORCE_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_BLOCKED_BRUTE_FORCE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "blocked_brute_force.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy>
+template<typename MetricType, typename MatType>
+bool BlockedBruteForce<SortPolicy>::Search(const MatType& querySet,
+                                           const MatType& referenceSet,
+                                           arma::Mat<size_t>& neighbors,
+                                           arma::mat& distances,
+                                           const bool sameSet,
+                                           const size_t queryBlockSize,
+                                           const size_t referenceBlockSize)
+{
+  typedef std::integral_constant<bool, BlockedBruteForceTraits<MetricType,
+      MatType>::UseBlockedBruteForce> Possible;
+
+  return Search<MetricType>(querySet, referenceSet, neighbors, distances,
+      sameSet, queryBlockSize, referenceBlockSize, Possible());
+}
+
+template<typename SortPolicy>
+template<typename MetricType, typename MatType>
+bool BlockedBruteForce<SortPolicy>::Search(const MatType& querySet,
+                                           const MatType& referenceSet,
+                                           arma::Mat<size_t>& neighbors,
+                                           arma::mat& distances,
+                                           const bool sameSet,
+                                           const size_t queryBlockSize,
+                                           const size_t referenceBlockSize,
+                                           const std::true_type& /* possible */)
+{
+  if (queryBlockSize == 0 || referenceBlockSize == 0)
+    throw std::invalid_argument("BlockedBruteForce::Search(): block sizes must "
+        "be greater than 0");
+
+  const size_t k = neighbors.n_rows;
+  if (k == 0 || referenceSet.n_cols == 0)
+    return true;
+
+  const bool takeRoot = BlockedBruteForceTraits<MetricType,
+      MatType>::TakeRoot;
+  const size_t numBlocks = (querySet.n_cols + queryBlockSize - 1) /
+      queryBlockSize;
+
+  // The points are shifted by the mean of the reference set, which keeps their
+  // norms (and so the cancellation error of ||q||^2 + ||r||^2 - 2 q^T r) small
+  // when the data is far from the origin.
+  const arma::vec center = arma::mean(referenceSet, 1);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+  {
+    const size_t queryBegin = b * queryBlockSize;
+    const size_t queryEnd = std::min(queryBegin + queryBlockSize,
+        (size_t) querySet.n_cols);
+    arma::mat queryBlock = querySet.cols(queryBegin, queryEnd - 1);
+    queryBlock.each_col() -= center;
+    const arma::rowvec queryNorms = arma::sum(arma::square(queryBlock), 0);
+
+    arma::mat referenceBlock, products;
+    arma::rowvec referenceNorms;
+    for (size_t referenceBegin = 0; referenceBegin < referenceSet.n_cols;
+         referenceBegin += referenceBlockSize)
+    {
+      const size_t referenceEnd = std::min(referenceBegin + referenceBlockSize,
+          (size_t) referenceSet.n_cols);
+      referenceBlock = referenceSet.cols(referenceBegin, referenceEnd - 1);
+      referenceBlock.each_col() -= center;
+      referenceNorms = arma::sum(arma::square(referenceBlock), 0);
+      products = referenceBlock.t() * queryBlock;
+
+      for (size_t j = 0; j < queryBlock.n_cols; ++j)
+      {
+        const size_t queryIndex = queryBegin + j;
+        double* queryDistances = distances.colptr(queryIndex);
+        size_t* queryNeighbors = neighbors.colptr(queryIndex);
+        const double* queryProducts = products.colptr(j);
+
+        for (size_t r = 0; r < products.n_rows; ++r)
+        {
+          const size_t referenceIndex = referenceBegin + r;
+          if (sameSet && referenceIndex == queryIndex)
+            continue;
+
+          // As in NeighborSearchRules::BaseCase() for pairs of leaves, the
+          // squared distance given by the product may be off by its
+          // cancellation error, which is far below the tolerance.  If even the
+          // best distance within the tolerance can't be a candidate, the exact
+          // distance can't either; otherwise, the exact distance is computed,
+          // so the candidates are always chosen by their exact distances.
+          const double squaredDistance = queryNorms[j] +
+              referenceNorms[r] - 2 * queryProducts[r];
+          const double tolerance = 1e-8 * (queryNorms[j] + referenceNorms[r]);
+          double lower = std::max(squaredDistance - tolerance, 0.0);
+          double upper = squaredDistance + tolerance;
+          if (takeRoot)
+          {
+            lower = std::sqrt(lower);
+            upper = std::sqrt(upper);
+          }
+
+          const double best = SortPolicy::IsBetter(lower, upper) ? lower :
+              upper;
+          if (!SortPolicy::IsBetter(best, queryDistances[0]))
+            continue;
+
+          const double distance = metric::LMetric<2, takeRoot>::Evaluate(
+              querySet.unsafe_col(queryIndex),
+              referenceSet.unsafe_col(referenceIndex));
+          CandidateHeap<SortPolicy>::Insert(queryDistances, queryNeighbors, k,
+              distance, referenceIndex);
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
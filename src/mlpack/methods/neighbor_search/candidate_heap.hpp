@@ -0,0 +1,146 @@
+/**
+ * @file candidate_heap.hpp
+ *
+ * Defines the CandidateHeap class, which keeps the k best neighbor candidates
+ * of a query point as a bounded binary heap, so that inserting a candidate
+ * takes O(log k) time instead of O(k).
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The CandidateHeap class holds utility functions to keep the k best candidates
+ * found so far for a query point in a column of a distances matrix and the
+ * corresponding column of a neighbors matrix.  The candidates are organized as
+ * a binary heap with the worst candidate first, so the current k'th best
+ * distance (which is what the pruning rules need) is always in the first row,
+ * and a new candidate replaces the worst one in O(log k) time.  Once the search
+ * is done, Sort() puts each column in order, with the best candidate first.
+ *
+ * Candidates with equal distances are ordered by their index, so the set of
+ * candidates that is kept does not depend on the order in which they were
+ * found.  Empty slots have the worst possible distance and the index
+ * (size_t() - 1), so any actual candidate is better than an empty slot.  A
+ * column filled with SortPolicy::WorstDistance() and (size_t() - 1) is a valid
+ * heap.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ */
+template<typename SortPolicy>
+class CandidateHeap
+{
+ public:
+  //! Return whether the first candidate is strictly better than the second.
+  static bool IsBetter(const double distance,
+                       const size_t index,
+                       const double otherDistance,
+                       const size_t otherIndex)
+  {
+    if (distance != otherDistance)
+      return SortPolicy::IsBetter(distance, otherDistance);
+
+    return (index < otherIndex);
+  }
+
+  /**
+   * Insert the given candidate into the heap of k candidates, if it is better
+   * than the worst candidate in the heap (which is then removed).  Return
+   * whether the candidate was inserted.
+   *
+   * @param distances Distances of the candidates in the heap.
+   * @param neighbors Indices of the candidates in the heap.
+   * @param k Number of candidates in the heap.
+   * @param distance Distance of the new candidate.
+   * @param neighbor Index of the new candidate.
+   */
+  static bool Insert(double* distances,
+                     size_t* neighbors,
+                     const size_t k,
+                     const double distance,
+                     const size_t neighbor)
+  {
+    if (k == 0 || !IsBetter(distance, neighbor, distances[0], neighbors[0]))
+      return false;
+
+    distances[0] = distance;
+    neighbors[0] = neighbor;
+    SiftDown(distances, neighbors, k, 0);
+    return true;
+  }
+
+  /**
+   * Sort the heap of k candidates in place, so that the best candidate is
+   * first.
+   *
+   * @param distances Distances of the candidates in the heap.
+   * @param neighbors Indices of the candidates in the heap.
+   * @param k Number of candidates in the heap.
+   */
+  static void Sort(double* distances, size_t* neighbors, const size_t k)
+  {
+    // This is a heap sort: repeatedly move the worst remaining candidate to the
+    // end of the remaining part.
+    for (size_t size = k; size > 1; --size)
+    {
+      std::swap(distances[0], distances[size - 1]);
+      std::swap(neighbors[0], neighbors[size - 1]);
+      SiftDown(distances, neighbors, size - 1, 0);
+    }
+  }
+
+  /**
+   * Sort every column of the given matrices, which each hold a heap of
+   * candidates for one query point.
+   *
+   * @param distances Matrix of candidate distances.
+   * @param neighbors Matrix of candidate indices.
+   */
+  static void Sort(arma::mat& distances, arma::Mat<size_t>& neighbors)
+  {
+    #pragma omp parallel for if (distances.n_cols >= 1024)
+    for (omp_size_t i = 0; i < (omp_size_t) distances.n_cols; ++i)
+      Sort(distances.colptr(i), neighbors.colptr(i), distances.n_rows);
+  }
+
+ private:
+  //! Move the candidate at the given position down until the heap property
+  //! holds again.
+  static void SiftDown(double* distances,
+                       size_t* neighbors,
+                       const size_t size,
+                       size_t pos)
+  {
+    const double distance = distances[pos];
+    const size_t neighbor = neighbors[pos];
+
+    while (2 * pos + 1 < size)
+    {
+      // Find the worse of the two children.
+      size_t child = 2 * pos + 1;
+      if (child + 1 < size && IsBetter(distances[child], neighbors[child],
+          distances[child + 1], neighbors[child + 1]))
+        ++child;
+
+      // Stop if the candidate is worse than both children.
+      if (!IsBetter(distance, neighbor, distances[child], neighbors[child]))
+        break;
+
+      distances[pos] = distances[child];
+      neighbors[pos] = neighbors[child];
+      pos = child;
+    }
+
+    distances[pos] = distance;
+    neighbors[pos] = neighbor;
+  }
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file dynamic_neighbor_search.hpp
+ *
+ * Defines the DynamicNeighborSearch class, which supports inserting and
+ * removing reference points without rebuilding the whole index, by keeping a
+ * set of static trees of geometrically increasing size (the logarithmic method
+ * of Bentley and Saxe).
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The DynamicNeighborSearch class performs distance-based neighbor searches
+ * like NeighborSearch, but the reference set can change after the index has
+ * been built.  Points are identified by an index: the points of the initial
+ * reference set have indices 0 to n - 1, and each inserted point gets the next
+ * index.  Indices are never reused, even after a point is removed.
+ *
+ * Inserted points are first kept in a small buffer that is searched by brute
+ * force.  When the buffer is full, it is merged with the trees of the smallest
+ * sizes into one new tree, like carrying in a binary counter, so the tree at
+ * level i holds roughly bufferSize * 2^i points.  Each point is therefore only
+ * moved into a new tree O(log n) times.  Removed points are only marked as
+ * removed; a tree is rebuilt without them once more than half of its points
+ * have been removed.  A search queries every tree (asking for a few more
+ * neighbors to make up for removed points) and the buffer, and merges the
+ * results, so it returns exactly the same neighbors as a NeighborSearch built
+ * on the current set of points.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MetricType The metric to use for computation.
+ * @tparam MatType The type of data matrix; this must be a dense matrix.
+ * @tparam TreeType The tree type to use; must adhere to the TreeType API.
+ */
+template<typename SortPolicy = NearestNeighborSort,
+         typename MetricType = mlpack::metric::EuclideanDistance,
+         typename MatType = arma::mat,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class DynamicNeighborSearch
+{
+ public:
+  //! The type of NeighborSearch object used for each tree.
+  typedef NeighborSearch<SortPolicy, MetricType, MatType, TreeType> NSType;
+  //! The type of tree.
+  typedef typename NSType::Tree Tree;
+  //! The type of element held in MatType.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Create an empty DynamicNeighborSearch object.  Points can be added with
+   * Insert().
+   *
+   * @param bufferSize Number of inserted points that are kept in the
+   *     brute-force buffer before they are moved into a tree.
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *     dual-tree search).
+   * @param epsilon Relative approximate error (non-negative).
+   * @param metric An optional instance of the MetricType class.
+   */
+  DynamicNeighborSearch(const size_t bufferSize = 256,
+                        const bool singleMode = false,
+                        const double epsilon = 0,
+                        const MetricType metric = MetricType());
+
+  /**
+   * Create a DynamicNeighborSearch object and build an index on the given
+   * reference set.  The points will have the indices 0 to
+   * referenceSet.n_cols - 1.
+   *
+   * @param referenceSet Set of reference points.
+   * @param bufferSize Number of inserted points that are kept in the
+   *     brute-force buffer before they are moved into a tree.
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *     dual-tree search).
+   * @param epsilon Relative approximate error (non-negative).
+   * @param metric An optional instance of the MetricType class.
+   */
+  DynamicNeighborSearch(const MatType& referenceSet,
+                        const size_t bufferSize = 256,
+                        const bool singleMode = false,
+                        const double epsilon = 0,
+                        const MetricType metric = MetricType());
+
+  //! Delete all of the trees.
+  ~DynamicNeighborSearch();
+
+  // The trees are owned by this object, so it cannot be copied.
+  DynamicNeighborSearch(const DynamicNeighborSearch& other) = delete;
+  DynamicNeighborSearch& operator=(const DynamicNeighborSearch& other) =
+      delete;
+
+  /**
+   * Insert a new reference point, and return its index.
+   *
+   * @param point Point to insert.
+   */
+  size_t Insert(const arma::Col<ElemType>& point);
+
+  /**
+   * Remove the reference point with the given index.  A std::invalid_argument
+   * is thrown if there is no such point (or if it was removed already).
+   *
+   * @param index Index of the point to remove.
+   */
+  void Remove(const size_t index);
+
+  /**
+   * For each point in the query set, compute the nearest neighbors among the
+   * current reference points, and store the output in the given matrices.  The
+   * neighbors are given by their indices, as described above.
+   *
+   * @param querySet Set of query points (can be just one point).
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   */
+  void Search(const MatType& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  //! Return the number of reference points (not counting removed points).
+  size_t NumPoints() const { return numPoints; }
+
+  //! Return whether the point with the given index is a current reference
+  //! point.
+  bool Contains(const size_t index) const
+  { return index < location.size() && location[index] != removedLocation; }
+
+  //! Return the number of trees that are currently built.
+  size_t NumTrees() const;
+
+  //! Get the size of the brute-force buffer.
+  size_t BufferSize() const { return bufferSize; }
+
+  //! Access whether or not search is done in single-tree mode.
+  bool SingleMode() const { return singleMode; }
+  //! Access the relative error to be considered in approximate search.
+  double Epsilon() const { return epsilon; }
+
+ private:
+  //! One of the static trees.
+  struct Component
+  {
+    Component() : tree(NULL), search(NULL), numRemoved(0) { }
+
+    //! The tree, or NULL if this level is empty.
+    Tree* tree;
+    //! The NeighborSearch object that searches the tree.
+    NSType* search;
+    //! The index of each point in the dataset of the tree.
+    std::vector<size_t> indices;
+    //! The number of points in the tree that have been removed.
+    size_t numRemoved;
+  };
+
+  /**
+   * Append the points of the tree at the given level that have not been
+   * removed to the given matrix and indices, and delete the tree.
+   */
+  void Collect(const size_t level,
+               MatType& points,
+               std::vector<size_t>& indices);
+
+  //! Build a tree at the given level on the given points.
+  void Build(const size_t level,
+             MatType&& points,
+             const std::vector<size_t>& indices);
+
+  //! Move the buffer into the trees.
+  void Flush();
+
+  //! The value of location[] for points in the buffer.
+  static const size_t bufferLocation = size_t(-1);
+  //! The value of location[] for removed points.
+  static const size_t removedLocation = size_t(-2);
+
+  //! The trees, indexed by level.
+  std::vector<Component> components;
+  //! Inserted points that are not in a tree yet.
+  MatType buffer;
+  //! The indices of the points in the buffer.
+  std::vector<size_t> bufferIndices;
+  //! For each point, the level of the tree holding it, bufferLocation, or
+  //! removedLocation.
+  std::vector<size_t> location;
+
+  //! The number of reference points that have not been removed.
+  size_t numPoints;
+  //! The dimensionality of the points (0 if there are no points yet).
+  size_t dimensionality;
+  //! The maximum number of points in the buffer.
+  size_t bufferSize;
+  //! Indicates if single-tree search is being used (as opposed to dual-tree).
+  bool singleMode;
+  //! Indicates the relative error to be considered in approximate search.
+  double epsilon;
+  //! Instantiation of metric.
+  MetricType metric;
+};
+
+/**
+ * The DynamicKNN class is the dynamic k-nearest-neighbors method, with L2
+ * (Euclidean) distances.
+ */
+typedef DynamicNeighborSearch<NearestNeighborSort, metric::EuclideanDistance>
+    DynamicKNN;
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "dynamic_neighbor_search_impl.hpp"
+
+#endif
@@ -0,0 +1,359 @@
+/**
+ * @file dynamic_neighbor_search_impl.hpp
+ *
+ * Implementation of the DynamicNeighborSearch class.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dynamic_neighbor_search.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+DynamicNeighborSearch(const size_t bufferSize,
+                      const bool singleMode,
+                      const double epsilon,
+                      const MetricType metric) :
+    numPoints(0),
+    dimensionality(0),
+    bufferSize(bufferSize),
+    singleMode(singleMode),
+    epsilon(epsilon),
+    metric(metric)
+{
+  if (bufferSize == 0)
+    throw std::invalid_argument("DynamicNeighborSearch: bufferSize must be "
+        "greater than 0");
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+DynamicNeighborSearch(const MatType& referenceSet,
+                      const size_t bufferSize,
+                      const bool singleMode,
+                      const double epsilon,
+                      const MetricType metric) :
+    numPoints(referenceSet.n_cols),
+    dimensionality(referenceSet.n_rows),
+    bufferSize(bufferSize),
+    singleMode(singleMode),
+    epsilon(epsilon),
+    metric(metric)
+{
+  if (bufferSize == 0)
+    throw std::invalid_argument("DynamicNeighborSearch: bufferSize must be "
+        "greater than 0");
+
+  if (referenceSet.n_cols == 0)
+    return;
+
+  // Put the initial points at the smallest level that is large enough.
+  size_t level = 0;
+  while ((bufferSize << level) < referenceSet.n_cols)
+    ++level;
+
+  std::vector<size_t> indices(referenceSet.n_cols);
+  for (size_t i = 0; i < indices.size(); ++i)
+    indices[i] = i;
+
+  location.resize(referenceSet.n_cols);
+  Build(level, MatType(referenceSet), indices);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+~DynamicNeighborSearch()
+{
+  for (size_t i = 0; i < components.size(); ++i)
+  {
+    delete components[i].search;
+    delete components[i].tree;
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+size_t DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Insert(const arma::Col<ElemType>& point)
+{
+  if (dimensionality == 0)
+  {
+    dimensionality = point.n_elem;
+  }
+  else if (point.n_elem != dimensionality)
+  {
+    std::ostringstream oss;
+    oss << "DynamicNeighborSearch::Insert(): point has dimensionality "
+        << point.n_elem << ", but the reference points have dimensionality "
+        << dimensionality;
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t index = location.size();
+  location.resize(index + 1);
+  location[index] = bufferLocation;
+  buffer.insert_cols(buffer.n_cols, point);
+  bufferIndices.push_back(index);
+  ++numPoints;
+
+  if (buffer.n_cols >= bufferSize)
+    Flush();
+
+  return index;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Remove(const size_t index)
+{
+  if (!Contains(index))
+  {
+    std::ostringstream oss;
+    oss << "DynamicNeighborSearch::Remove(): there is no point with index "
+        << index;
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t level = location[index];
+  location[index] = removedLocation;
+  --numPoints;
+
+  if (level == bufferLocation)
+  {
+    // Points in the buffer can just be removed; the order doesn't matter.
+    const size_t i = std::find(bufferIndices.begin(), bufferIndices.end(),
+        index) - bufferIndices.begin();
+    const size_t last = buffer.n_cols - 1;
+    if (i != last)
+    {
+      buffer.col(i) = buffer.col(last);
+      bufferIndices[i] = bufferIndices[last];
+    }
+    buffer.shed_col(last);
+    bufferIndices.pop_back();
+    return;
+  }
+
+  // If more than half of the points of the tree have been removed, rebuild it
+  // on the remaining points.
+  Component& component = components[level];
+  ++component.numRemoved;
+  if (2 * component.numRemoved > component.indices.size())
+  {
+    MatType points;
+    std::vector<size_t> indices;
+    Collect(level, points, indices);
+    if (!indices.empty())
+      Build(level, std::move(points), indices);
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Search(const MatType& querySet,
+       const size_t k,
+       arma::Mat<size_t>& neighbors,
+       arma::mat& distances)
+{
+  if (k > numPoints)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << numPoints << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Collect candidates for each query point from every tree and the buffer.
+  typedef std::pair<double, size_t> Candidate;
+  std::vector<std::vector<Candidate> > candidates(querySet.n_cols);
+
+  for (size_t level = 0; level < components.size(); ++level)
+  {
+    Component& component = components[level];
+    if (component.tree == NULL)
+      continue;
+
+    // Ask for enough extra neighbors that the k best points that have not been
+    // removed are among the results.
+    const size_t componentK = std::min(k + component.numRemoved,
+        component.indices.size());
+    arma::Mat<size_t> componentNeighbors;
+    arma::mat componentDistances;
+    component.search->Search(querySet, componentK, componentNeighbors,
+        componentDistances);
+
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      for (size_t j = 0; j < componentK; ++j)
+      {
+        const size_t index = component.indices[componentNeighbors(j, i)];
+        if (location[index] != removedLocation)
+          candidates[i].push_back(Candidate(componentDistances(j, i), index));
+      }
+    }
+  }
+
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+    for (size_t j = 0; j < buffer.n_cols; ++j)
+      candidates[i].push_back(Candidate(metric.Evaluate(querySet.col(i),
+          buffer.col(j)), bufferIndices[j]));
+
+  // Now keep the k best candidates for each query point.
+  neighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    std::partial_sort(candidates[i].begin(), candidates[i].begin() + k,
+        candidates[i].end(), [](const Candidate& a, const Candidate& b)
+        {
+          return SortPolicy::IsBetter(a.first, b.first) ||
+              (a.first == b.first && a.second < b.second);
+        });
+
+    for (size_t j = 0; j < k; ++j)
+    {
+      distances(j, i) = candidates[i][j].first;
+      neighbors(j, i) = candidates[i][j].second;
+    }
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+size_t DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+NumTrees() const
+{
+  size_t numTrees = 0;
+  for (size_t i = 0; i < components.size(); ++i)
+    if (components[i].tree != NULL)
+      ++numTrees;
+
+  return numTrees;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Collect(const size_t level, MatType& points, std::vector<size_t>& indices)
+{
+  Component& component = components[level];
+  const MatType& dataset = component.tree->Dataset();
+
+  size_t column = points.n_cols;
+  points.resize(dimensionality, points.n_cols + component.indices.size() -
+      component.numRemoved);
+  for (size_t i = 0; i < component.indices.size(); ++i)
+  {
+    const size_t index = component.indices[i];
+    if (location[index] == removedLocation)
+      continue;
+
+    points.col(column++) = dataset.col(i);
+    indices.push_back(index);
+  }
+
+  delete component.search;
+  delete component.tree;
+  component = Component();
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Build(const size_t level,
+      MatType&& points,
+      const std::vector<size_t>& indices)
+{
+  if (components.size() <= level)
+    components.resize(level + 1);
+
+  Component& component = components[level];
+  std::vector<size_t> oldFromNew;
+  component.tree = BuildTree<MatType, Tree>(std::move(points), oldFromNew);
+  component.search = new NSType(component.tree, singleMode, epsilon, metric);
+
+  // Store the indices in the order of the dataset of the tree, since that is
+  // how the NeighborSearch object returns results for a tree it didn't build.
+  component.indices.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    component.indices[i] = oldFromNew.empty() ? indices[i] :
+        indices[oldFromNew[i]];
+    location[component.indices[i]] = level;
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Flush()
+{
+  // Merge the buffer with all of the trees at the lowest levels, until we find
+  // an empty level.
+  MatType points = std::move(buffer);
+  std::vector<size_t> indices;
+  indices.swap(bufferIndices);
+  buffer.reset();
+
+  size_t level = 0;
+  while (level < components.size() && components[level].tree != NULL)
+    Collect(level++, points, indices);
+
+  Build(level, std::move(points), indices);
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -7,10 +7,12 @@ w
  * options.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
 
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 #include "neighbor_search.hpp"
 #include "unmap.hpp"
@@ -40,7 +42,18 @@ PROGRAM_INFO("All K-Furthest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th furthest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "The format of the output files is chosen by their extension.  For large "
+    "results, the native binary format (.mlbin) is much faster to write and "
+    "much smaller than text: the matrices are written as they are in memory, "
+    "so they can be loaded with a single read or memory-mapped.  HDF5 files "
+    "(.h5) may also be written, if mlpack was built with HDF5 support."
+    "\n\n"
+    "If the query set is too large to fit in memory, --query_chunk_size may be "
+    "specified; then the query file is read and searched that many points at "
+    "a time, and the results of each chunk are appended to the output files "
+    "(which must be .csv, .txt, .mlbin or HDF5 files).");
 
 // Define our input parameters that this program will take.
 PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
@@ -58,11 +71,16 @@ PARAM_STRING("output_model_file", "If specified, the kFN model will be saved to"
 // neighbors to search for.
 PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
 PARAM_INT("k", "Number of furthest neighbors to find.", "k", 0);
+PARAM_INT("query_chunk_size", "If positive, the query file is read and "
+    "searched this many points at a time, and the results are appended to the "
+    "output files after each chunk.", "c", 0);
 
 // The user may specify the type of tree to use, and a few pararmeters for tree
 // building.
 PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'cover', 'r', 'r-star', "
-    "'x', 'ball'.", "t", "kd");
+    "'x', 'ball', 'vp', 'rp', 'max-rp', or 'auto' to choose the tree type and "
+    "leaf size by building each kind of tree on a sample of the reference set "
+    "and timing a search with it.", "t", "kd");
 PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
@@ -78,92 +96,19 @@ PARAM_DOUBLE("percentage", "If specified, will do approximate furthest neighbor"
     " search. Must be in the range (0,1] (decimal form). Resultant neighbors "
     "will be at least (p*100) % of the distance as the true furthest neighbor.",
     "p", 1);
-
-// Convenience typedef.
-typedef NSModel<FurthestNeighborSort> KFNModel;
-
-int main(int argc, char *argv[])
+PARAM_FLAG("float", "If set, the data is loaded and processed in single "
+    "precision, which halves the memory used.  A model saved with --float must "
+    "also be loaded with --float.", "f");
+
+// Build or load the model, run the search, and save the results, using the
+// given matrix type for the data.
+template<typename MatType>
+void RunKFN(const size_t leafSize, const double epsilon)
 {
-  // Give CLI the command line parameters the user passed in.
-  CLI::ParseCommandLine(argc, argv);
-
-  if (CLI::GetParam<int>("seed") != 0)
-    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
-  else
-    math::RandomSeed((size_t) std::time(NULL));
-
-  // A user cannot specify both reference data and a model.
-  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
-    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
-        << " may be specified!" << endl;
-
-  // A user must specify one of them...
-  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
-    Log::Fatal << "No model specified (--input_model_file) and no reference "
-        << "data specified (--reference_file)!  One must be provided." << endl;
-
-  if (CLI::HasParam("input_model_file"))
-  {
-    // Notify the user of parameters that will be ignored.
-    if (CLI::HasParam("tree_type"))
-      Log::Warn << "--tree_type (-t) will be ignored because --input_model_file"
-          << " is specified." << endl;
-    if (CLI::HasParam("leaf_size"))
-      Log::Warn << "--leaf_size (-l) will be ignored because --input_model_file"
-          << " is specified." << endl;
-    if (CLI::HasParam("random_basis"))
-      Log::Warn << "--random_basis (-R) will be ignored because "
-          << "--input_model_file is specified." << endl;
-    if (CLI::HasParam("naive"))
-      Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
-          << "specified." << endl;
-  }
-
-  // The user should give something to do...
-  if (!CLI::HasParam("k") && !CLI::HasParam("output_model_file"))
-    Log::Warn << "Neither -k nor --output_model_file are specified, so no "
-        << "results from this program will be saved!" << endl;
-
-  // If the user specifies k but no output files, they should be warned.
-  if (CLI::HasParam("k") &&
-      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
-    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
-        << "so the furthest neighbor search results will not be saved!" << endl;
-
-  // If the user specifies output files but no k, they should be warned.
-  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
-      !CLI::HasParam("k"))
-    Log::Warn << "An output file for furthest neighbor search is given ("
-        << "--neighbors_file or --distances_file), but furthest neighbor search"
-        << " is not being performed because k (--k) is not specified!  No "
-        << "results will be saved." << endl;
-
-  // Sanity check on leaf size.
-  const int lsInt = CLI::GetParam<int>("leaf_size");
-  if (lsInt < 1)
-    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater than 0."
-        << endl;
-
-  // Sanity check on epsilon.
-  double epsilon = CLI::GetParam<double>("epsilon");
-  if (epsilon < 0 || epsilon >= 1)
-    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be in the range "
-        << "[0,1)." << endl;
-
-  // Sanity check on percentage.
-  const double percentage = CLI::GetParam<double>("percentage");
-  if (percentage <= 0 || percentage > 1)
-    Log::Fatal << "Invalid percentage: " << percentage << ".  Must be in the "
-        << "range (0,1] (decimal form)." << endl;
-
-  if (CLI::HasParam("percentage") && CLI::HasParam("epsilon"))
-    Log::Fatal << "Cannot provide both epsilon and percentage." << endl;
-
-  if (CLI::HasParam("percentage"))
-    epsilon = 1 - percentage;
+  typedef NSModel<FurthestNeighborSort, MatType> KFNModel;
 
   // We either have to load the reference data, or we have to load the model.
-  NSModel<FurthestNeighborSort> kfn;
+  KFNModel kfn;
   const bool naive = CLI::HasParam("naive");
   const bool singleMode = CLI::HasParam("single_mode");
   if (CLI::HasParam("reference_file"))
@@ -173,7 +118,7 @@ int main(int argc, char *argv[])
     const string treeType = CLI::GetParam<string>("tree_type");
     const bool randomBasis = CLI::HasParam("random_basis");
 
-    KFNModel::TreeTypes tree = KFNModel::KD_TREE;
+    typename KFNModel::TreeTypes tree = KFNModel::KD_TREE;
     if (treeType == "kd")
       tree = KFNModel::KD_TREE;
     else if (treeType == "cover")
@@ -186,20 +131,39 @@ int main(int argc, char *argv[])
       tree = KFNModel::BALL_TREE;
     else if (treeType == "x")
       tree = KFNModel::X_TREE;
-    else
+    else if (treeType == "vp")
+      tree = KFNModel::VP_TREE;
+    else if (treeType == "rp")
+      tree = KFNModel::RP_TREE;
+    else if (treeType == "max-rp")
+      tree = KFNModel::MAX_RP_TREE;
+    else if (treeType != "auto")
       Log::Fatal << "Unknown tree type '" << treeType << "'; valid choices are "
-          << "'kd', 'cover', 'r', 'r-star', 'x' and 'ball'." << endl;
+          << "'kd', 'cover', 'r', 'r-star', 'x', 'ball', 'vp', 'rp', 'max-rp' "
+          << "and 'auto'." << endl;
 
     kfn.TreeType() = tree;
     kfn.RandomBasis() = randomBasis;
 
-    arma::mat referenceSet;
+    MatType referenceSet;
     data::Load(referenceFile, referenceSet, true);
 
     Log::Info << "Loaded reference data from '" << referenceFile << "' ("
         << referenceSet.n_rows << "x" << referenceSet.n_cols << ")." << endl;
 
-    kfn.BuildModel(std::move(referenceSet), size_t(lsInt), naive, singleMode,
+    // Choose the tree type and leaf size by searching a sample of the
+    // reference set with each of them, if asked to (no tree is used in naive
+    // mode).
+    size_t buildLeafSize = leafSize;
+    if (treeType == "auto" && !naive)
+    {
+      const size_t k = CLI::HasParam("k") ?
+          (size_t) CLI::GetParam<int>("k") : 1;
+      kfn.SelectTree(referenceSet, k, singleMode, epsilon);
+      buildLeafSize = kfn.LeafSize();
+    }
+
+    kfn.BuildModel(std::move(referenceSet), buildLeafSize, naive, singleMode,
         epsilon);
   }
   else
@@ -215,7 +179,6 @@ int main(int argc, char *argv[])
     // Adjust singleMode and naive if necessary.
     kfn.SingleMode() = CLI::HasParam("single_mode");
     kfn.Naive() = CLI::HasParam("naive");
-    kfn.LeafSize() = size_t(lsInt);
     kfn.Epsilon() = epsilon;
   }
 
@@ -224,9 +187,10 @@ int main(int argc, char *argv[])
   {
     const string queryFile = CLI::GetParam<string>("query_file");
     const size_t k = (size_t) CLI::GetParam<int>("k");
+    const size_t chunkSize = (size_t) CLI::GetParam<int>("query_chunk_size");
 
-    arma::mat queryData;
-    if (queryFile != "")
+    MatType queryData;
+    if (queryFile != "" && chunkSize == 0)
     {
       data::Load(queryFile, queryData, true);
       Log::Info << "Loaded query data from '" << queryFile << "' ("
@@ -251,22 +215,162 @@ int main(int argc, char *argv[])
     arma::Mat<size_t> neighbors;
     arma::mat distances;
 
-    if (CLI::HasParam("query_file"))
-      kfn.Search(std::move(queryData), k, neighbors, distances);
+    if (CLI::HasParam("query_file") && chunkSize > 0)
+    {
+      // Search each chunk of the query set separately, and append its results
+      // to the output files, so that the whole query set is never in memory.
+      // The files are read and written as the search goes, so a read or write
+      // error can happen at any chunk.
+      try
+      {
+        data::ChunkedLoader<typename MatType::elem_type> loader(queryFile);
+        std::unique_ptr<data::ChunkedSaver> neighborsSaver, distancesSaver;
+        if (CLI::HasParam("neighbors_file"))
+          neighborsSaver.reset(new data::ChunkedSaver(
+              CLI::GetParam<string>("neighbors_file")));
+        if (CLI::HasParam("distances_file"))
+          distancesSaver.reset(new data::ChunkedSaver(
+              CLI::GetParam<string>("distances_file")));
+
+        MatType chunk;
+        while (loader.Next(chunk, chunkSize))
+        {
+          kfn.Search(std::move(chunk), k, neighbors, distances);
+          if (neighborsSaver)
+            neighborsSaver->Write(neighbors);
+          if (distancesSaver)
+            distancesSaver->Write(distances);
+        }
+
+        Log::Info << "Search complete (" << loader.PointsRead() << " query "
+            << "points in chunks of " << chunkSize << ")." << endl;
+      }
+      catch (std::runtime_error& e)
+      {
+        Log::Fatal << e.what() << endl;
+      }
+    }
     else
-      kfn.Search(k, neighbors, distances);
-    Log::Info << "Search complete." << endl;
-
-    // Save output, if desired.
-    if (CLI::HasParam("neighbors_file"))
-      data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
-    if (CLI::HasParam("distances_file"))
-      data::Save(CLI::GetParam<string>("distances_file"), distances);
+    {
+      if (CLI::HasParam("query_file"))
+        kfn.Search(std::move(queryData), k, neighbors, distances);
+      else
+        kfn.Search(k, neighbors, distances);
+      Log::Info << "Search complete." << endl;
+
+      // Save output, if desired.
+      if (CLI::HasParam("neighbors_file"))
+        data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
+      if (CLI::HasParam("distances_file"))
+        data::Save(CLI::GetParam<string>("distances_file"), distances);
+    }
   }
 
   if (CLI::HasParam("output_model_file"))
   {
-    const string outputModelFile = CLI::GetParam<string>("output_model_File");
+    const string outputModelFile = CLI::GetParam<string>("output_model_file");
     data::Save(outputModelFile, "kfn_model", kfn);
   }
 }
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) std::time(NULL));
+
+  // A user cannot specify both reference data and a model.
+  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
+    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
+        << " may be specified!" << endl;
+
+  // A user must specify one of them...
+  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
+    Log::Fatal << "No model specified (--input_model_file) and no reference "
+        << "data specified (--reference_file)!  One must be provided." << endl;
+
+  if (CLI::HasParam("input_model_file"))
+  {
+    // Notify the user of parameters that will be ignored.
+    if (CLI::HasParam("tree_type"))
+      Log::Warn << "--tree_type (-t) will be ignored because --input_model_file"
+          << " is specified." << endl;
+    if (CLI::HasParam("leaf_size"))
+      Log::Warn << "--leaf_size (-l) will be ignored because --input_model_file"
+          << " is specified." << endl;
+    if (CLI::HasParam("random_basis"))
+      Log::Warn << "--random_basis (-R) will be ignored because "
+          << "--input_model_file is specified." << endl;
+    if (CLI::HasParam("naive"))
+      Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
+          << "specified." << endl;
+  }
+  else if (CLI::GetParam<string>("tree_type") == "auto" &&
+      CLI::HasParam("leaf_size"))
+  {
+    Log::Warn << "--leaf_size (-l) will be ignored because --tree_type (-t) "
+        << "is 'auto'." << endl;
+  }
+
+  // The user should give something to do...
+  if (!CLI::HasParam("k") && !CLI::HasParam("output_model_file"))
+    Log::Warn << "Neither -k nor --output_model_file are specified, so no "
+        << "results from this program will be saved!" << endl;
+
+  // If the user specifies k but no output files, they should be warned.
+  if (CLI::HasParam("k") &&
+      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
+    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
+        << "so the furthest neighbor search results will not be saved!" << endl;
+
+  // If the user specifies output files but no k, they should be warned.
+  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
+      !CLI::HasParam("k"))
+    Log::Warn << "An output file for furthest neighbor search is given ("
+        << "--neighbors_file or --distances_file), but furthest neighbor search"
+        << " is not being performed because k (--k) is not specified!  No "
+        << "results will be saved." << endl;
+
+  // Sanity check on the query chunk size.
+  if (CLI::GetParam<int>("query_chunk_size") < 0)
+    Log::Fatal << "Invalid query chunk size: "
+        << CLI::GetParam<int>("query_chunk_size") << ".  Must be "
+        << "non-negative." << endl;
+  if (CLI::HasParam("query_chunk_size") && !CLI::HasParam("query_file"))
+    Log::Warn << "--query_chunk_size (-c) will be ignored because "
+        << "--query_file (-q) is not specified." << endl;
+
+  // Sanity check on leaf size.
+  const int lsInt = CLI::GetParam<int>("leaf_size");
+  if (lsInt < 1)
+    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater than 0."
+        << endl;
+
+  // Sanity check on epsilon.
+  double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0 || epsilon >= 1)
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be in the range "
+        << "[0,1)." << endl;
+
+  // Sanity check on percentage.
+  const double percentage = CLI::GetParam<double>("percentage");
+  if (percentage <= 0 || percentage > 1)
+    Log::Fatal << "Invalid percentage: " << percentage << ".  Must be in the "
+        << "range (0,1] (decimal form)." << endl;
+
+  if (CLI::HasParam("percentage") && CLI::HasParam("epsilon"))
+    Log::Fatal << "Cannot provide both epsilon and percentage." << endl;
+
+  if (CLI::HasParam("percentage"))
+    epsilon = 1 - percentage;
+
+  // Do the actual work in single or double precision.
+  if (CLI::HasParam("float"))
+    RunKFN<arma::fmat>(size_t(lsInt), epsilon);
+  else
+    RunKFN<arma::mat>(size_t(lsInt), epsilon);
+}
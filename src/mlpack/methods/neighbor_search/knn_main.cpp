@@ -7,10 +7,15 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/data/batch_server.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
+#include <mlpack/core/data/load_async.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
 
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 #include "neighbor_search.hpp"
 #include "unmap.hpp"
@@ -41,7 +46,40 @@ PROGRAM_INFO("k-Nearest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th nearest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "The format of the output files is chosen by their extension.  For large "
+    "results, the native binary format (.mlbin) is much faster to write and "
+    "much smaller than text: the matrices are written as they are in memory, "
+    "so they can be loaded with a single read or memory-mapped.  HDF5 files "
+    "(.h5) may also be written, if mlpack was built with HDF5 support."
+    "\n\n"
+    "If the query set is too large to fit in memory, --query_chunk_size may be "
+    "specified; then the query file is read and searched that many points at "
+    "a time, and the results of each chunk are appended to the output files "
+    "(which must be .csv, .txt, .mlbin or HDF5 files)."
+    "\n\n"
+    "With --serve, the model is built or loaded once, and then batches of "
+    "query points are read from the standard input until it ends, and the k "
+    "nearest neighbors of each batch are written to the standard output.  Each "
+    "batch is a matrix in the native binary (.mlbin) format, and the response "
+    "to each batch is the neighbors matrix followed by the distances matrix, "
+    "in the same format; the output is flushed after each response.  All the "
+    "messages of the program are written to the standard error instead.  This "
+    "avoids loading the model and building the trees for each batch.  For "
+    "example:"
+    "\n\n"
+    "$ mlpack_knn --input_model_file=model.bin --k=5 --serve < queries.mlbin "
+    "> results.mlbin"
+    "\n\n"
+    "To search with the Mahalanobis distance d(x, y) = sqrt((x - y)^T Q "
+    "(x - y)) instead of the Euclidean distance, give the matrix Q in "
+    "--mahalanobis_file.  The points are transformed once with the Cholesky "
+    "factor of Q before the trees are built, so all tree types may be used, "
+    "and the distances returned are Mahalanobis distances.  (For the output "
+    "matrix A of mlpack_nca, Q is A^T A.)  A model saved with a Mahalanobis "
+    "matrix keeps it, so the option is not needed again with "
+    "--input_model_file.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
@@ -59,15 +97,24 @@ PARAM_STRING("output_model_file", "If specified, the kNN model will be saved "
 // neighbors to search for.
 PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
 PARAM_INT("k", "Number of nearest neighbors to find.", "k", 0);
+PARAM_INT("query_chunk_size", "If positive, the query file is read and "
+    "searched this many points at a time, and the results are appended to the "
+    "output files after each chunk.", "c", 0);
+PARAM_FLAG("serve", "If set, answer batches of query points read from the "
+    "standard input, and write the results to the standard output.", "");
 
 // The user may specify the type of tree to use, and a few parameters for tree
 // building.
 PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'cover', 'r', 'r-star', "
-    "'x', 'ball'.", "t", "kd");
+    "'x', 'ball', 'vp', 'rp', 'max-rp', or 'auto' to choose the tree type and "
+    "leaf size by building each kind of tree on a sample of the reference set "
+    "and timing a search with it.", "t", "kd");
 PARAM_INT("leaf_size", "Leaf size for tree building (used for kd-trees, R "
     "trees, and R* trees).", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_STRING("mahalanobis_file", "File containing the matrix Q of a "
+    "Mahalanobis distance to search with (optional).", "Q", "");
 PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
@@ -76,82 +123,33 @@ PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "S");
 PARAM_DOUBLE("epsilon", "If specified, will do approximate nearest neighbor "
     "search with given relative error.", "e", 0);
-
-// Convenience typedef.
-typedef NSModel<NearestNeighborSort> KNNModel;
-
-int main(int argc, char *argv[])
+PARAM_FLAG("float", "If set, the data is loaded and processed in single "
+    "precision, which halves the memory used.  A model saved with --float must "
+    "also be loaded with --float.", "f");
+
+// Build or load the model, run the search, and save the results, using the
+// given matrix type for the data.
+template<typename MatType>
+void RunKNN(const size_t leafSize, const double epsilon)
 {
-  // Give CLI the command line parameters the user passed in.
-  CLI::ParseCommandLine(argc, argv);
-
-  if (CLI::GetParam<int>("seed") != 0)
-    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
-  else
-    math::RandomSeed((size_t) std::time(NULL));
-
-  // A user cannot specify both reference data and a model.
-  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
-    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
-        << " may be specified!" << endl;
-
-  // A user must specify one of them...
-  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
-    Log::Fatal << "No model specified (--input_model_file) and no reference "
-        << "data specified (--reference_file)!  One must be provided." << endl;
-
-  if (CLI::HasParam("input_model_file"))
-  {
-    // Notify the user of parameters that will be ignored.
-    if (CLI::HasParam("tree_type"))
-      Log::Warn << "--tree_type (-t) will be ignored because --input_model_file"
-          << " is specified." << endl;
-    if (CLI::HasParam("leaf_size"))
-      Log::Warn << "--leaf_size (-l) will be ignored because --input_model_file"
-          << " is specified." << endl;
-    if (CLI::HasParam("random_basis"))
-      Log::Warn << "--random_basis (-R) will be ignored because "
-          << "--input_model_file is specified." << endl;
-    if (CLI::HasParam("naive"))
-      Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
-          << "specified." << endl;
-  }
-
-  // The user should give something to do...
-  if (!CLI::HasParam("k") && !CLI::HasParam("output_model_file"))
-    Log::Warn << "Neither -k nor --output_model_file are specified, so no "
-        << "results from this program will be saved!" << endl;
-
-  // If the user specifies k but no output files, they should be warned.
-  if (CLI::HasParam("k") &&
-      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
-    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
-        << "so the nearest neighbor search results will not be saved!" << endl;
-
-  // If the user specifies output files but no k, they should be warned.
-  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
-      !CLI::HasParam("k"))
-    Log::Warn << "An output file for nearest neighbor search is given ("
-        << "--neighbors_file or --distances_file), but nearest neighbor search "
-        << "is not being performed because k (--k) is not specified!  No "
-        << "results will be saved." << endl;
-
-  // Sanity check on leaf size.
-  const int lsInt = CLI::GetParam<int>("leaf_size");
-  if (lsInt < 1)
-    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater "
-        "than 0." << endl;
-
-  // Sanity check on epsilon.
-  const double epsilon = CLI::GetParam<double>("epsilon");
-  if (epsilon < 0)
-    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be non-negative. "
-        << endl;
+  typedef NSModel<NearestNeighborSort, MatType> KNNModel;
 
   // We either have to load the reference data, or we have to load the model.
-  NSModel<NearestNeighborSort> knn;
+  KNNModel knn;
   const bool naive = CLI::HasParam("naive");
   const bool singleMode = CLI::HasParam("single_mode");
+
+  // If the whole query set will be searched at once, load it on a background
+  // thread, while the reference set is loaded and its tree is built (or the
+  // model is loaded).
+  const string queryFile = CLI::GetParam<string>("query_file");
+  const size_t chunkSize = (size_t) CLI::GetParam<int>("query_chunk_size");
+  MatType queryData;
+  std::future<bool> queryLoad;
+  if (CLI::HasParam("k") && queryFile != "" && chunkSize == 0 &&
+      !CLI::HasParam("serve"))
+    queryLoad = data::LoadAsync(queryFile, queryData, true);
+
   if (CLI::HasParam("reference_file"))
   {
     // Get all the parameters.
@@ -159,7 +157,7 @@ int main(int argc, char *argv[])
     const string treeType = CLI::GetParam<string>("tree_type");
     const bool randomBasis = CLI::HasParam("random_basis");
 
-    KNNModel::TreeTypes tree = KNNModel::KD_TREE;
+    typename KNNModel::TreeTypes tree = KNNModel::KD_TREE;
     if (treeType == "kd")
       tree = KNNModel::KD_TREE;
     else if (treeType == "cover")
@@ -172,21 +170,60 @@ int main(int argc, char *argv[])
       tree = KNNModel::BALL_TREE;
     else if (treeType == "x")
       tree = KNNModel::X_TREE;
-    else
+    else if (treeType == "vp")
+      tree = KNNModel::VP_TREE;
+    else if (treeType == "rp")
+      tree = KNNModel::RP_TREE;
+    else if (treeType == "max-rp")
+      tree = KNNModel::MAX_RP_TREE;
+    else if (treeType != "auto")
       Log::Fatal << "Unknown tree type '" << treeType << "'; valid choices are "
-          << "'kd', 'cover', 'r', 'r-star', 'x' and 'ball'." << endl;
+          << "'kd', 'cover', 'r', 'r-star', 'x', 'ball', 'vp', 'rp', 'max-rp' "
+          << "and 'auto'." << endl;
 
     knn.TreeType() = tree;
     knn.RandomBasis() = randomBasis;
 
-    arma::mat referenceSet;
+    MatType referenceSet;
     data::Load(referenceFile, referenceSet, true);
 
     Log::Info << "Loaded reference data from '" << referenceFile << "' ("
         << referenceSet.n_rows << " x " << referenceSet.n_cols << ")."
         << endl;
 
-    knn.BuildModel(std::move(referenceSet), size_t(lsInt), naive, singleMode,
+    // Search with a Mahalanobis distance by whitening the points first.
+    if (CLI::HasParam("mahalanobis_file"))
+    {
+      const string mahalanobisFile = CLI::GetParam<string>("mahalanobis_file");
+      arma::mat covariance;
+      data::Load(mahalanobisFile, covariance, true);
+      if (covariance.n_rows != referenceSet.n_rows ||
+          covariance.n_cols != referenceSet.n_rows)
+      {
+        Log::Fatal << "The Mahalanobis matrix in '" << mahalanobisFile << "' ("
+            << covariance.n_rows << "x" << covariance.n_cols << ") must be "
+            << referenceSet.n_rows << "x" << referenceSet.n_rows << "." << endl;
+      }
+
+      arma::mat transformation;
+      MahalanobisDistance<> mahalanobis(covariance);
+      mahalanobis.Whitening(transformation);
+      knn.Transformation() = arma::conv_to<MatType>::from(transformation);
+    }
+
+    // Choose the tree type and leaf size by searching a sample of the
+    // reference set with each of them, if asked to (no tree is used in naive
+    // mode).
+    size_t buildLeafSize = leafSize;
+    if (treeType == "auto" && !naive)
+    {
+      const size_t k = CLI::HasParam("k") ?
+          (size_t) CLI::GetParam<int>("k") : 1;
+      knn.SelectTree(referenceSet, k, singleMode, epsilon);
+      buildLeafSize = knn.LeafSize();
+    }
+
+    knn.BuildModel(std::move(referenceSet), buildLeafSize, naive, singleMode,
         epsilon);
   }
   else
@@ -202,20 +239,17 @@ int main(int argc, char *argv[])
     // Adjust singleMode and naive if necessary.
     knn.SingleMode() = CLI::HasParam("single_mode");
     knn.Naive() = CLI::HasParam("naive");
-    knn.LeafSize() = size_t(lsInt);
     knn.Epsilon() = epsilon;
   }
 
   // Perform search, if desired.
   if (CLI::HasParam("k"))
   {
-    const string queryFile = CLI::GetParam<string>("query_file");
     const size_t k = (size_t) CLI::GetParam<int>("k");
 
-    arma::mat queryData;
-    if (queryFile != "")
+    if (queryLoad.valid())
     {
-      data::Load(queryFile, queryData, true);
+      queryLoad.get(); // Throws if the load failed.
       Log::Info << "Loaded query data from '" << queryFile << "' ("
           << queryData.n_rows << "x" << queryData.n_cols << ")." << endl;
     }
@@ -240,17 +274,83 @@ int main(int argc, char *argv[])
     arma::Mat<size_t> neighbors;
     arma::mat distances;
 
-    if (CLI::HasParam("query_file"))
-      knn.Search(std::move(queryData), k, neighbors, distances);
+    if (CLI::HasParam("serve"))
+    {
+      // The responses go to the standard output, so the messages that would be
+      // printed there are sent to the standard error for the rest of the
+      // program.
+      std::ostream responses(std::cout.rdbuf());
+      std::cout.rdbuf(std::cerr.rdbuf());
+
+      // Answer each batch of query points with the model that is already
+      // built, until the input ends.
+      data::BatchServer<typename MatType::elem_type> server(std::cin,
+          responses);
+      MatType batch;
+      while (server.Next(batch))
+      {
+        if (batch.n_rows != knn.Dataset().n_rows)
+        {
+          Log::Fatal << "Query batch " << server.Batches() << " has "
+              << batch.n_rows << " dimensions, but the reference set has "
+              << knn.Dataset().n_rows << " dimensions!" << endl;
+        }
+
+        knn.Search(std::move(batch), k, neighbors, distances);
+        server.Reply(neighbors);
+        server.Reply(distances);
+        server.Flush();
+      }
+    }
+    else if (CLI::HasParam("query_file") && chunkSize > 0)
+    {
+      // Search each chunk of the query set separately, and append its results
+      // to the output files, so that the whole query set is never in memory.
+      // The files are read and written as the search goes, so a read or write
+      // error can happen at any chunk.
+      try
+      {
+        data::ChunkedLoader<typename MatType::elem_type> loader(queryFile);
+        std::unique_ptr<data::ChunkedSaver> neighborsSaver, distancesSaver;
+        if (CLI::HasParam("neighbors_file"))
+          neighborsSaver.reset(new data::ChunkedSaver(
+              CLI::GetParam<string>("neighbors_file")));
+        if (CLI::HasParam("distances_file"))
+          distancesSaver.reset(new data::ChunkedSaver(
+              CLI::GetParam<string>("distances_file")));
+
+        MatType chunk;
+        while (loader.Next(chunk, chunkSize))
+        {
+          knn.Search(std::move(chunk), k, neighbors, distances);
+          if (neighborsSaver)
+            neighborsSaver->Write(neighbors);
+          if (distancesSaver)
+            distancesSaver->Write(distances);
+        }
+
+        Log::Info << "Search complete (" << loader.PointsRead() << " query "
+            << "points in chunks of " << chunkSize << ")." << endl;
+      }
+      catch (std::runtime_error& e)
+      {
+        Log::Fatal << e.what() << endl;
+      }
+    }
     else
-      knn.Search(k, neighbors, distances);
-    Log::Info << "Search complete." << endl;
-
-    // Save output, if desired.
-    if (CLI::HasParam("neighbors_file"))
-      data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
-    if (CLI::HasParam("distances_file"))
-      data::Save(CLI::GetParam<string>("distances_file"), distances);
+    {
+      if (CLI::HasParam("query_file"))
+        knn.Search(std::move(queryData), k, neighbors, distances);
+      else
+        knn.Search(k, neighbors, distances);
+      Log::Info << "Search complete." << endl;
+
+      // Save output, if desired.
+      if (CLI::HasParam("neighbors_file"))
+        data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
+      if (CLI::HasParam("distances_file"))
+        data::Save(CLI::GetParam<string>("distances_file"), distances);
+    }
   }
 
   if (CLI::HasParam("output_model_file"))
@@ -259,3 +359,104 @@ int main(int argc, char *argv[])
     data::Save(outputModelFile, "knn_model", knn);
   }
 }
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) std::time(NULL));
+
+  // A user cannot specify both reference data and a model.
+  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
+    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
+        << " may be specified!" << endl;
+
+  // A user must specify one of them...
+  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
+    Log::Fatal << "No model specified (--input_model_file) and no reference "
+        << "data specified (--reference_file)!  One must be provided." << endl;
+
+  if (CLI::HasParam("input_model_file"))
+  {
+    // Notify the user of parameters that will be ignored.
+    if (CLI::HasParam("tree_type"))
+      Log::Warn << "--tree_type (-t) will be ignored because --input_model_file"
+          << " is specified." << endl;
+    if (CLI::HasParam("leaf_size"))
+      Log::Warn << "--leaf_size (-l) will be ignored because --input_model_file"
+          << " is specified." << endl;
+    if (CLI::HasParam("random_basis"))
+      Log::Warn << "--random_basis (-R) will be ignored because "
+          << "--input_model_file is specified." << endl;
+    if (CLI::HasParam("naive"))
+      Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
+          << "specified." << endl;
+  }
+  else if (CLI::GetParam<string>("tree_type") == "auto" &&
+      CLI::HasParam("leaf_size"))
+  {
+    Log::Warn << "--leaf_size (-l) will be ignored because --tree_type (-t) "
+        << "is 'auto'." << endl;
+  }
+
+  // The user should give something to do...
+  if (!CLI::HasParam("k") && !CLI::HasParam("output_model_file"))
+    Log::Warn << "Neither -k nor --output_model_file are specified, so no "
+        << "results from this program will be saved!" << endl;
+
+  // The server needs k, and takes its queries from the standard input.
+  if (CLI::HasParam("serve"))
+  {
+    if (!CLI::HasParam("k"))
+      Log::Fatal << "--k must be specified with --serve!" << endl;
+    if (CLI::HasParam("query_file") || CLI::HasParam("neighbors_file") ||
+        CLI::HasParam("distances_file"))
+      Log::Warn << "--query_file, --neighbors_file and --distances_file will "
+          << "be ignored because --serve is specified." << endl;
+  }
+
+  // If the user specifies k but no output files, they should be warned.
+  if (CLI::HasParam("k") && !CLI::HasParam("serve") &&
+      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
+    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
+        << "so the nearest neighbor search results will not be saved!" << endl;
+
+  // If the user specifies output files but no k, they should be warned.
+  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
+      !CLI::HasParam("k"))
+    Log::Warn << "An output file for nearest neighbor search is given ("
+        << "--neighbors_file or --distances_file), but nearest neighbor search "
+        << "is not being performed because k (--k) is not specified!  No "
+        << "results will be saved." << endl;
+
+  // Sanity check on the query chunk size.
+  if (CLI::GetParam<int>("query_chunk_size") < 0)
+    Log::Fatal << "Invalid query chunk size: "
+        << CLI::GetParam<int>("query_chunk_size") << ".  Must be "
+        << "non-negative." << endl;
+  if (CLI::HasParam("query_chunk_size") && !CLI::HasParam("query_file"))
+    Log::Warn << "--query_chunk_size (-c) will be ignored because "
+        << "--query_file (-q) is not specified." << endl;
+
+  // Sanity check on leaf size.
+  const int lsInt = CLI::GetParam<int>("leaf_size");
+  if (lsInt < 1)
+    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater "
+        "than 0." << endl;
+
+  // Sanity check on epsilon.
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0)
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be non-negative. "
+        << endl;
+
+  // Do the actual work in single or double precision.
+  if (CLI::HasParam("float"))
+    RunKNN<arma::fmat>(size_t(lsInt), epsilon);
+  else
+    RunKNN<arma::mat>(size_t(lsInt), epsilon);
+}
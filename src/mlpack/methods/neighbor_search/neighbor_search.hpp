@@ -20,6 +20,7 @@
 #include "neighbor_search_stat.hpp"
 #include "sort_policies/nearest_neighbor_sort.hpp"
 #include "neighbor_search_rules.hpp"
+#include "blocked_brute_force.hpp"
 
 namespace mlpack {
 namespace neighbor /** Neighbor-search routines.  These include
@@ -27,7 +28,7 @@ namespace neighbor /** Neighbor-search routines.  These include
                     * searches. */ {
 
 // Forward declaration.
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType>
 class TrainVisitor;
 
 /**
@@ -44,6 +45,13 @@ class TrainVisitor;
  * can be found in the NearestNeighborSort class and the kernel::ExampleKernel
  * class.
  *
+ * In naive mode, searches with the (squared) Euclidean distance on dense
+ * matrices of doubles use the BlockedBruteForce class, which computes the
+ * distances with blocked matrix multiplications.  With those metrics, the
+ * dual-tree search of BinarySpaceTree also computes the base cases of a pair of
+ * large leaves with one matrix multiplication (see
+ * NeighborSearchRules::LeafBaseCases()).
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
  * @tparam MatType The type of data matrix.
@@ -66,6 +74,8 @@ class NeighborSearch
  public:
   //! Convenience typedef.
   typedef TreeType<MetricType, NeighborSearchStat<SortPolicy>, MatType> Tree;
+  //! The type of element held in MatType.
+  typedef typename MatType::elem_type ElemType;
 
   /**
    * Initialize the NeighborSearch object, passing a reference dataset (this is
@@ -119,6 +129,31 @@ class NeighborSearch
                  const double epsilon = 0,
                  const MetricType metric = MetricType());
 
+  /**
+   * Initialize the NeighborSearch object with a reference dataset that may be
+   * shared with other objects (for instance, with other search models on the
+   * same points).  The object holds on to the dataset for as long as it uses
+   * it, so the dataset is only freed when the last object sharing it is done
+   * with it.  The dataset is never modified.  Trees that rearrange the dataset
+   * (like the kd-tree) are built on a temporary permuted copy of it, which is
+   * freed once the tree is built: the search then reads the points from the
+   * shared dataset through the permutation, so the reference tree does not
+   * hold any points.
+   *
+   * @param referenceSet Shared set of reference points (must not be NULL).
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param epsilon Relative approximate error (non-negative).
+   * @param metric An optional instance of the MetricType class.
+   */
+  NeighborSearch(std::shared_ptr<const MatType> referenceSet,
+                 const bool naive = false,
+                 const bool singleMode = false,
+                 const double epsilon = 0,
+                 const MetricType metric = MetricType());
+
   /**
    * Initialize the NeighborSearch object with the given pre-constructed
    * reference tree (this is the tree built on the points that will be
@@ -193,6 +228,16 @@ class NeighborSearch
    */
   void Train(MatType&& referenceSet);
 
+  /**
+   * Set the reference set to a new reference set that may be shared with other
+   * objects, and build a tree if necessary.  The object holds on to the set for
+   * as long as it uses it; see the constructor that takes a shared reference
+   * set.
+   *
+   * @param referenceSet New shared set of reference data (must not be NULL).
+   */
+  void Train(std::shared_ptr<const MatType> referenceSet);
+
   /**
    * Set the reference tree to a new reference tree.
    */
@@ -227,10 +272,11 @@ class NeighborSearch
    * number of points in the query dataset and k is the number of neighbors
    * being searched for.
    *
-   * Note that if you are calling Search() multiple times with a single query
-   * tree, you need to reset the bounds in the statistic of each query node,
-   * otherwise the result may be wrong!  You can do this by calling
-   * TreeType::Stat()::Reset() on each node in the query tree.
+   * The results are in the order of the points in the query tree (which may
+   * have been rearranged when it was built).  The bounds in the statistic of
+   * each query node are reset before the search, so the same query tree can be
+   * used for any number of searches (for instance, with different values of k,
+   * or after the reference set is changed with Train()).
    *
    * @param queryTree Tree built on query points.
    * @param k Number of neighbors to search for.
@@ -243,6 +289,35 @@ class NeighborSearch
               arma::Mat<size_t>& neighbors,
               arma::mat& distances);
 
+  /**
+   * Given a pre-built query tree and the mapping of its points to the original
+   * query set (as returned by the tree constructor), search for the nearest
+   * neighbors of each query point like Search(Tree*, ...), but store the
+   * results in the order of the original query set.  This lets a query tree be
+   * built once and reused for many searches.
+   *
+   * @code
+   * std::vector<size_t> oldFromNew;
+   * KNN::Tree queryTree(querySet, oldFromNew);
+   * for (size_t k = 1; k <= 10; ++k)
+   *   knn.Search(&queryTree, oldFromNew, k, neighbors, distances);
+   * @endcode
+   *
+   * @param queryTree Tree built on query points.
+   * @param oldFromNewQueries Mapping from the indices of the points in the
+   *     query tree to their original indices; empty if the tree does not
+   *     rearrange the points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   */
+  void Search(Tree* queryTree,
+              const std::vector<size_t>& oldFromNewQueries,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
   /**
    * Search for the nearest neighbors of every point in the reference set.  This
    * is basically equivalent to calling any other overload of Search() with the
@@ -261,6 +336,67 @@ class NeighborSearch
               arma::Mat<size_t>& neighbors,
               arma::mat& distances);
 
+  /**
+   * For each point in the query set, search for the nearest neighbors within a
+   * budget, and store the output in the given matrices (like Search()).  The
+   * reference tree is searched single-tree and best-first, with the
+   * BestFirstSingleTreeTraverser of the tree, so the most promising leaves are
+   * searched first; the search of a query point stops when it has performed
+   * maxBaseCases base cases, or when maxTime seconds have passed since the
+   * call.  So, the results are the best neighbors found within the budget, and
+   * the return value tells whether they are exact (that is, whether no query
+   * point was stopped by the budget).  Query points whose search was stopped
+   * before k neighbors were found have neighbors with index SIZE_MAX and the
+   * worst distance.
+   *
+   * This is only available for BinarySpaceTree types (such as the default
+   * KDTree).  In naive mode, the search is exact and ignores the budget.
+   *
+   * @param querySet Set of query points (can be just one point).
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   * @param maxBaseCases Maximum number of base cases for each query point (0
+   *     means there is no limit).
+   * @param maxTime Maximum time for the whole search, in seconds (0 means there
+   *     is no limit).
+   * @return Whether the results are exact.
+   */
+  bool BudgetedSearch(const MatType& querySet,
+                      const size_t k,
+                      arma::Mat<size_t>& neighbors,
+                      arma::mat& distances,
+                      const size_t maxBaseCases,
+                      const double maxTime = 0);
+
+  /**
+   * Search for the nearest neighbors of a single query point, and store the
+   * results in the given vectors.  This is meant for serving individual queries
+   * with low latency: no query tree is built, no rules object or traverser is
+   * created, and if the given vectors already have k elements, nothing is
+   * allocated.  The search does not modify the NeighborSearch object or the
+   * reference tree, so it can be called from several threads at once on the
+   * same object (as long as the model is not changed at the same time).  For
+   * the same reason, the BaseCases() and Scores() counters are not updated, and
+   * nothing is timed or logged.
+   *
+   * If the object is in naive mode, a linear scan is done; otherwise, the
+   * reference tree is searched depth-first, always recursing into the most
+   * promising child first.  The single-tree and dual-tree settings make no
+   * difference here.  The results are the same as those of Search() with a
+   * query set holding only this point.
+   *
+   * @param query Query point.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Vector that will hold the indices of the k neighbors.
+   * @param distances Vector that will hold the distances to the k neighbors.
+   */
+  void SearchOne(const arma::Col<ElemType>& query,
+                 const size_t k,
+                 arma::Col<size_t>& neighbors,
+                 arma::vec& distances) const;
+
   //! Return the total number of base case evaluations performed during the last
   //! search.
   size_t BaseCases() const { return baseCases; }
@@ -297,6 +433,9 @@ class NeighborSearch
   Tree* referenceTree;
   //! Reference dataset.  In some situations we may be the owner of this.
   const MatType* referenceSet;
+  //! The shared reference dataset, if we were given one; this keeps it alive
+  //! for as long as we (or our tree) refer to it.
+  std::shared_ptr<const MatType> sharedReferenceSet;
 
   //! If true, this object created the trees and is responsible for them.
   bool treeOwner;
@@ -322,8 +461,55 @@ class NeighborSearch
   //! Search() without a query set.
   bool treeNeedsReset;
 
+  /**
+   * Compute the base cases between every query point and every reference point
+   * (in naive mode), or traverse the reference tree with every query point (in
+   * single-tree mode), with the given rules.  With OpenMP, the query points are
+   * split between the threads, each with its own copy of the rules; the
+   * counters of the copies are added to the given rules.
+   *
+   * @param rules Rules to use for the search.
+   * @param numQueries Number of query points.
+   */
+  template<typename RuleType>
+  void SearchQueries(RuleType& rules, const size_t numQueries);
+
+  //! Reset the bounds in the statistic of each node of the given tree.
+  static void ResetTree(Tree& tree);
+
+  /**
+   * Search the given reference node for the neighbors of a single query point,
+   * as part of SearchOne().
+   */
+  void SearchOneRecursion(const arma::Col<ElemType>& query,
+                          const Tree& node,
+                          arma::Col<size_t>& neighbors,
+                          arma::vec& distances) const;
+
+  //! Evaluate the distance between a query point and a reference point, and
+  //! add the reference point to the results of SearchOne() if it is good
+  //! enough.
+  void SearchOneBaseCase(const arma::Col<ElemType>& query,
+                         const size_t referenceIndex,
+                         arma::Col<size_t>& neighbors,
+                         arma::vec& distances) const;
+
+  //! Hold on to the given shared reference set, after a tree (if any) was
+  //! built on it; a tree that rearranges the points then lets go of its copy.
+  void ShareReferenceSet(std::shared_ptr<const MatType> referenceSet);
+
+  //! Get the column of the reference set that holds the point with each tree
+  //! index, if the tree was built on a shared set that it does not hold (and
+  //! NULL otherwise).
+  const std::vector<size_t>* ReferenceMap() const
+  {
+    return (sharedReferenceSet && !naive &&
+        tree::TreeTraits<Tree>::RearrangesDataset) ? &oldFromNewReferences :
+        NULL;
+  }
+
   //! The NSModel class should have access to internal members.
-  friend class TrainVisitor<SortPolicy>;
+  friend class TrainVisitor<SortPolicy, MatType>;
 }; // class NeighborSearch
 
 } // namespace neighbor
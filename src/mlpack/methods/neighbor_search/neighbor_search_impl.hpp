@@ -11,6 +11,7 @@
 #include <mlpack/core.hpp>
 
 #include "neighbor_search_rules.hpp"
+#include "unmap.hpp"
 
 namespace mlpack {
 namespace neighbor {
@@ -127,6 +128,25 @@ NeighborSearch(MatType&& referenceSetIn,
     throw std::invalid_argument("epsilon must be non-negative");
 }
 
+// Construct the object on a shared reference set.
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+NeighborSearch(std::shared_ptr<const MatType> referenceSetIn,
+               const bool naive,
+               const bool singleMode,
+               const double epsilon,
+               const MetricType metric) :
+    NeighborSearch(*referenceSetIn, naive, singleMode, epsilon, metric)
+{
+  ShareReferenceSet(std::move(referenceSetIn));
+}
+
 // Construct the object.
 template<typename SortPolicy,
          typename MetricType,
@@ -244,6 +264,9 @@ Train(const MatType& referenceSet)
   else
     this->referenceSet = &referenceSet;
   setOwner = false; // We don't own the set in either case.
+
+  // Let go of the old shared set, if we had one.
+  sharedReferenceSet.reset();
 }
 
 template<typename SortPolicy,
@@ -286,6 +309,48 @@ Train(MatType&& referenceSetIn)
     referenceSet = new MatType(std::move(referenceSetIn));
     setOwner = true;
   }
+
+  sharedReferenceSet.reset();
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+Train(std::shared_ptr<const MatType> referenceSetIn)
+{
+  Train(*referenceSetIn);
+  ShareReferenceSet(std::move(referenceSetIn));
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+ShareReferenceSet(std::shared_ptr<const MatType> referenceSetIn)
+{
+  // A tree that rearranges the points was built on a permuted copy of the
+  // shared set.  The copy is only needed to build the tree, so it is freed,
+  // and the points are read from the shared set through oldFromNewReferences
+  // instead.  (Only trees that own their dataset rearrange it.)
+  if (!naive && tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    const_cast<MatType&>(referenceTree->Dataset()).reset();
+    referenceSet = referenceSetIn.get();
+  }
+
+  // Hold on to the shared set if we (or a tree that doesn't rearrange the
+  // points) refer to it.
+  if (referenceSet == referenceSetIn.get())
+    sharedReferenceSet = std::move(referenceSetIn);
 }
 
 template<typename SortPolicy,
@@ -311,6 +376,7 @@ Train(Tree* referenceTree)
   this->referenceSet = &referenceTree->Dataset();
   treeOwner = false;
   setOwner = false;
+  sharedReferenceSet.reset();
 }
 
 /**
@@ -348,57 +414,41 @@ Search(const MatType& querySet,
 
   // If we have built the trees ourselves, then we will have to map all the
   // indices back to their original indices when this computation is finished.
-  // To avoid an extra copy, we will store the neighbors and distances in a
-  // separate matrix.
-  arma::Mat<size_t>* neighborPtr = &neighbors;
-  arma::mat* distancePtr = &distances;
-
-  // Mapping is only necessary if the tree rearranges points.
-  if (tree::TreeTraits<Tree>::RearrangesDataset)
-  {
-    if (!singleMode && !naive)
-    {
-      distancePtr = new arma::mat; // Query indices need to be mapped.
-      neighborPtr = new arma::Mat<size_t>;
-    }
-
-    if (treeOwner)
-      neighborPtr = new arma::Mat<size_t>; // Reference indices need mapping.
-  }
-
+  // This is done in place, so the results are stored directly in the output
+  // matrices.
   // Set the size of the neighbor and distance matrices.
-  neighborPtr->set_size(k, querySet.n_cols);
-  neighborPtr->fill(size_t() - 1);
-  distancePtr->set_size(k, querySet.n_cols);
-  distancePtr->fill(SortPolicy::WorstDistance());
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
 
   typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
 
   if (naive)
   {
-    // Create the helper object for the tree traversal.
-    RuleType rules(*referenceSet, querySet, *neighborPtr, *distancePtr, metric,
-        epsilon);
+    // For the Euclidean distance on dense data, the brute-force search can be
+    // done with blocked matrix multiplications, which is much faster.
+    if (!BlockedBruteForce<SortPolicy>::template Search<MetricType>(querySet,
+        *referenceSet, neighbors, distances))
+    {
+      // Create the helper object for the tree traversal.
+      RuleType rules(*referenceSet, querySet, neighbors, distances,
+          metric, epsilon);
 
-    // The naive brute-force traversal.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+      // The naive brute-force traversal.
+      SearchQueries(rules, querySet.n_cols);
+    }
 
     baseCases += querySet.n_cols * referenceSet->n_cols;
   }
   else if (singleMode)
   {
     // Create the helper object for the tree traversal.
-    RuleType rules(*referenceSet, querySet, *neighborPtr, *distancePtr, metric,
-        epsilon);
+    RuleType rules(*referenceSet, querySet, neighbors, distances, metric,
+        epsilon, false, ReferenceMap());
 
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    // Now traverse the tree for each point.
+    SearchQueries(rules, querySet.n_cols);
 
     scores += rules.Scores();
     baseCases += rules.BaseCases();
@@ -416,8 +466,8 @@ Search(const MatType& querySet,
     Timer::Start("computing_neighbors");
 
     // Create the helper object for the tree traversal.
-    RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr,
-        *distancePtr, metric, epsilon);
+    RuleType rules(*referenceSet, queryTree->Dataset(), neighbors,
+        distances, metric, epsilon, false, ReferenceMap());
 
     // Create the traverser.
     TraversalType<RuleType> traverser(rules);
@@ -433,7 +483,12 @@ Search(const MatType& querySet,
     delete queryTree;
   }
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, neighbors);
+
   Timer::Stop("computing_neighbors");
+  Counter::Add("neighbor_search/base_cases", baseCases);
+  Counter::Add("neighbor_search/scores", scores);
 
   // Map points back to original indices, if necessary.
   if (tree::TreeTraits<Tree>::RearrangesDataset)
@@ -441,59 +496,129 @@ Search(const MatType& querySet,
     if (!singleMode && !naive && treeOwner)
     {
       // We must map both query and reference indices.
-      neighbors.set_size(k, querySet.n_cols);
-      distances.set_size(k, querySet.n_cols);
-
-      for (size_t i = 0; i < distances.n_cols; i++)
-      {
-        // Map distances (copy a column).
-        distances.col(oldFromNewQueries[i]) = distancePtr->col(i);
-
-        // Map indices of neighbors.
-        for (size_t j = 0; j < distances.n_rows; j++)
-        {
-          neighbors(j, oldFromNewQueries[i]) =
-              oldFromNewReferences[(*neighborPtr)(j, i)];
-        }
-      }
-
-      // Finished with temporary matrices.
-      delete neighborPtr;
-      delete distancePtr;
+      UnmapInPlace(neighbors, distances, oldFromNewReferences,
+          oldFromNewQueries);
     }
     else if (!singleMode && !naive)
     {
       // We must map query indices only.
-      neighbors.set_size(k, querySet.n_cols);
-      distances.set_size(k, querySet.n_cols);
-
-      for (size_t i = 0; i < distances.n_cols; ++i)
-      {
-        // Map distances (copy a column).
-        const size_t queryMapping = oldFromNewQueries[i];
-        distances.col(queryMapping) = distancePtr->col(i);
-        neighbors.col(queryMapping) = neighborPtr->col(i);
-      }
-
-      // Finished with temporary matrices.
-      delete neighborPtr;
-      delete distancePtr;
+      PermuteColumns(neighbors, oldFromNewQueries);
+      PermuteColumns(distances, oldFromNewQueries);
     }
     else if (treeOwner)
     {
       // We must map reference indices only.
-      neighbors.set_size(k, querySet.n_cols);
+      UnmapInPlace(neighbors, distances, oldFromNewReferences);
+    }
+  }
+} // Search()
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+bool NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+BudgetedSearch(const MatType& querySet,
+               const size_t k,
+               arma::Mat<size_t>& neighbors,
+               arma::mat& distances,
+               const size_t maxBaseCases,
+               const double maxTime)
+{
+  // The deadline is counted from the start of the call.
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  if (naive)
+  {
+    Search(querySet, k, neighbors, distances);
+    return true;
+  }
+
+  if (k > referenceSet->n_cols)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << referenceSet->n_cols << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  Timer::Start("computing_neighbors");
+
+  baseCases = 0;
+  scores = 0;
+
+  // Only the reference indices may need to be mapped (in place, at the end),
+  // since the query points are searched one at a time.
+
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
+
+  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
+  RuleType rules(*referenceSet, querySet, neighbors, distances, metric,
+      epsilon, false, ReferenceMap());
+  rules.MaxBaseCases() = maxBaseCases;
+  if (maxTime > 0)
+  {
+    rules.Deadline() = start + std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(maxTime));
+  }
+
+  // Each thread uses its own copy of the rules and traverser, as in
+  // SearchQueries().
+  size_t ruleBaseCases = 0, ruleScores = 0, inexactQueries = 0;
+  #pragma omp parallel reduction(+:ruleBaseCases, ruleScores, inexactQueries)
+  {
+    RuleType threadRules(rules);
+    threadRules.BaseCases() = 0;
+    threadRules.Scores() = 0;
 
-      // Map indices of neighbors.
-      for (size_t i = 0; i < neighbors.n_cols; i++)
-        for (size_t j = 0; j < neighbors.n_rows; j++)
-          neighbors(j, i) = oldFromNewReferences[(*neighborPtr)(j, i)];
+    typename Tree::template BestFirstSingleTreeTraverser<RuleType>
+        traverser(threadRules);
 
-      // Finished with temporary matrix.
-      delete neighborPtr;
+    #pragma omp for schedule(dynamic, 16)
+    for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+    {
+      traverser.Traverse(i, *referenceTree);
+      if (!traverser.Exact())
+        ++inexactQueries;
     }
+
+    ruleBaseCases += threadRules.BaseCases();
+    ruleScores += threadRules.Scores();
   }
-} // Search()
+
+  baseCases += ruleBaseCases;
+  scores += ruleScores;
+
+  Log::Info << scores << " node combinations were scored.\n";
+  Log::Info << baseCases << " base cases were calculated.\n";
+  if (inexactQueries > 0)
+  {
+    Log::Info << "The search of " << inexactQueries << " query points was "
+        << "stopped by the budget.\n";
+  }
+
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, neighbors);
+
+  Timer::Stop("computing_neighbors");
+  Counter::Add("neighbor_search/base_cases", baseCases);
+  Counter::Add("neighbor_search/scores", scores);
+
+  // Map the reference indices back, if necessary.  The queries that were
+  // stopped by the budget may have no neighbors, which are left unmapped.
+  if (tree::TreeTraits<Tree>::RearrangesDataset && treeOwner)
+    UnmapInPlace(neighbors, distances, oldFromNewReferences);
+
+  return (inexactQueries == 0);
+}
 
 template<typename SortPolicy,
          typename MetricType,
@@ -529,21 +654,21 @@ Search(Tree* queryTree,
   // Get a reference to the query set.
   const MatType& querySet = queryTree->Dataset();
 
-  // We won't need to map query indices, but will we need to map distances?
-  arma::Mat<size_t>* neighborPtr = &neighbors;
+  // The query tree may have been used for another search already.
+  ResetTree(*queryTree);
 
-  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
-    neighborPtr = new arma::Mat<size_t>;
+  // We won't need to map query indices, but the reference indices may need to
+  // be mapped (in place) at the end.
 
-  neighborPtr->set_size(k, querySet.n_cols);
-  neighborPtr->fill(size_t() - 1);
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(size_t() - 1);
   distances.set_size(k, querySet.n_cols);
   distances.fill(SortPolicy::WorstDistance());
 
   // Create the helper object for the traversal.
   typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, querySet, *neighborPtr, distances, metric,
-      epsilon);
+  RuleType rules(*referenceSet, querySet, neighbors, distances, metric,
+      epsilon, false, ReferenceMap());
 
   // Create the traverser.
   TraversalType<RuleType> traverser(rules);
@@ -552,22 +677,53 @@ Search(Tree* queryTree,
   scores += rules.Scores();
   baseCases += rules.BaseCases();
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, neighbors);
+
   Timer::Stop("computing_neighbors");
+  Counter::Add("neighbor_search/base_cases", baseCases);
+  Counter::Add("neighbor_search/scores", scores);
 
-  // Do we need to map indices?
+  // Do we need to map indices?  We must map reference indices only.
   if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
-  {
-    // We must map reference indices only.
-    neighbors.set_size(k, querySet.n_cols);
+    UnmapInPlace(neighbors, distances, oldFromNewReferences);
+}
 
-    // Map indices of neighbors.
-    for (size_t i = 0; i < neighbors.n_cols; i++)
-      for (size_t j = 0; j < neighbors.n_rows; j++)
-        neighbors(j, i) = oldFromNewReferences[(*neighborPtr)(j, i)];
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+Search(Tree* queryTree,
+       const std::vector<size_t>& oldFromNewQueries,
+       const size_t k,
+       arma::Mat<size_t>& neighbors,
+       arma::mat& distances)
+{
+  // Without a mapping, the points of the tree are in their original order.
+  if (oldFromNewQueries.empty())
+  {
+    Search(queryTree, k, neighbors, distances);
+    return;
+  }
 
-    // Finished with temporary matrix.
-    delete neighborPtr;
+  const size_t numQueries = queryTree->Dataset().n_cols;
+  if (oldFromNewQueries.size() != numQueries)
+  {
+    std::stringstream ss;
+    ss << "the mapping of the query points has " << oldFromNewQueries.size()
+        << " elements, but the query tree has " << numQueries << " points";
+    throw std::invalid_argument(ss.str());
   }
+
+  Search(queryTree, k, neighbors, distances);
+
+  // Map the query indices back to the original order, in place.
+  PermuteColumns(neighbors, oldFromNewQueries);
+  PermuteColumns(distances, oldFromNewQueries);
 }
 
 template<typename SortPolicy,
@@ -595,44 +751,34 @@ Search(const size_t k,
   baseCases = 0;
   scores = 0;
 
-  arma::Mat<size_t>* neighborPtr = &neighbors;
-  arma::mat* distancePtr = &distances;
-
-  if (tree::TreeTraits<Tree>::RearrangesDataset && treeOwner)
-  {
-    // We will always need to rearrange in this case.
-    distancePtr = new arma::mat;
-    neighborPtr = new arma::Mat<size_t>;
-  }
-
+  // If we built the tree ourselves, the results are mapped back in place at
+  // the end.
   // Initialize results.
-  neighborPtr->set_size(k, referenceSet->n_cols);
-  neighborPtr->fill(size_t() - 1);
-  distancePtr->set_size(k, referenceSet->n_cols);
-  distancePtr->fill(SortPolicy::WorstDistance());
+  neighbors.set_size(k, referenceSet->n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, referenceSet->n_cols);
+  distances.fill(SortPolicy::WorstDistance());
 
   // Create the helper object for the traversal.
   typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, *referenceSet, *neighborPtr, *distancePtr,
-      metric, epsilon, true /* don't return the same point as nearest neighbor */);
+  RuleType rules(*referenceSet, *referenceSet, neighbors, distances,
+      metric, epsilon, true /* don't return the same point as nearest neighbor */,
+      ReferenceMap());
 
   if (naive)
   {
-    // The naive brute-force solution.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+    // The naive brute-force solution.  For the Euclidean distance on dense
+    // data, it can be done with blocked matrix multiplications.
+    if (!BlockedBruteForce<SortPolicy>::template Search<MetricType>(
+        *referenceSet, *referenceSet, neighbors, distances, true))
+      SearchQueries(rules, referenceSet->n_cols);
 
     baseCases += referenceSet->n_cols * referenceSet->n_cols;
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    // Now traverse the tree for each point.
+    SearchQueries(rules, referenceSet->n_cols);
 
     scores += rules.Scores();
     baseCases += rules.BaseCases();
@@ -645,22 +791,7 @@ Search(const size_t k,
     // The dual-tree monochromatic search case may require resetting the bounds
     // in the tree.
     if (treeNeedsReset)
-    {
-      std::stack<Tree*> nodes;
-      nodes.push(referenceTree);
-      while (!nodes.empty())
-      {
-        Tree* node = nodes.top();
-        nodes.pop();
-
-        // Reset bounds of this node.
-        node->Stat().Reset();
-
-        // Then add the children.
-        for (size_t i = 0; i < node->NumChildren(); ++i)
-          nodes.push(&node->Child(i));
-      }
-    }
+      ResetTree(*referenceTree);
 
     // Create the traverser.
     TraversalType<RuleType> traverser(rules);
@@ -677,29 +808,247 @@ Search(const size_t k,
     treeNeedsReset = true;
   }
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, neighbors);
+
   Timer::Stop("computing_neighbors");
+  Counter::Add("neighbor_search/base_cases", baseCases);
+  Counter::Add("neighbor_search/scores", scores);
 
-  // Do we need to map the reference indices?
+  // Do we need to map the reference indices?  The query points are the
+  // reference points, so the columns are mapped too.
   if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+    UnmapInPlace(neighbors, distances, oldFromNewReferences,
+        oldFromNewReferences);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+SearchOne(const arma::Col<ElemType>& query,
+          const size_t k,
+          arma::Col<size_t>& neighbors,
+          arma::vec& distances) const
+{
+  if (k > referenceSet->n_cols)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << referenceSet->n_cols << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  if (query.n_elem != referenceSet->n_rows)
+  {
+    std::stringstream ss;
+    ss << "dimensionality of query point (" << query.n_elem << ") is not equal"
+        << " to the dimensionality of the reference set ("
+        << referenceSet->n_rows << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // These only allocate memory if the vectors don't have the right size yet.
+  neighbors.set_size(k);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k);
+  distances.fill(SortPolicy::WorstDistance());
+
+  if (k == 0)
+    return;
+
+  if (naive)
   {
-    neighbors.set_size(k, referenceSet->n_cols);
-    distances.set_size(k, referenceSet->n_cols);
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+      SearchOneBaseCase(query, i, neighbors, distances);
+  }
+  else
+  {
+    SearchOneRecursion(query, *referenceTree, neighbors, distances);
+  }
+
+  // The candidates were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances.memptr(), neighbors.memptr(), k);
 
-    for (size_t i = 0; i < distances.n_cols; ++i)
+  // Map the neighbors back to their original indices, if necessary.
+  if (tree::TreeTraits<Tree>::RearrangesDataset && treeOwner && !naive)
+    for (size_t i = 0; i < k; ++i)
+      if (neighbors[i] != size_t() - 1)
+        neighbors[i] = oldFromNewReferences[neighbors[i]];
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+SearchOneRecursion(const arma::Col<ElemType>& query,
+                   const Tree& node,
+                   arma::Col<size_t>& neighbors,
+                   arma::vec& distances) const
+{
+  // Only the points held in leaves are evaluated, since every point is held in
+  // exactly one leaf (this is also true for trees where internal nodes hold
+  // points, like the cover tree, whose self-children repeat those points).
+  if (node.NumChildren() == 0)
+  {
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+      SearchOneBaseCase(query, node.Point(i), neighbors, distances);
+
+    return;
+  }
+
+  // Score the children, and sort them so that the best child is visited first.
+  // Nodes with many children (like cover tree nodes) are visited in order
+  // instead, so that no memory has to be allocated.
+  const size_t maxSortedChildren = 8;
+  if (node.NumChildren() <= maxSortedChildren)
+  {
+    double scores[maxSortedChildren];
+    size_t order[maxSortedChildren];
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      scores[i] = SortPolicy::BestPointToNodeDistance(query, &node.Child(i));
+
+      // Insertion sort by score.
+      size_t j = i;
+      for ( ; j > 0 && SortPolicy::IsBetter(scores[i], scores[order[j - 1]]);
+          --j)
+        order[j] = order[j - 1];
+      order[j] = i;
+    }
+
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      // The k'th best distance may have improved since the child was scored.
+      const double bestDistance = SortPolicy::Relax(distances[0], epsilon);
+      if (!SortPolicy::IsBetter(scores[order[i]], bestDistance))
+        break; // The remaining children can't be any better.
+
+      SearchOneRecursion(query, node.Child(order[i]), neighbors, distances);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < node.NumChildren(); ++i)
     {
-      // Map distances (copy a column).
-      const size_t refMapping = oldFromNewReferences[i];
-      distances.col(refMapping) = distancePtr->col(i);
+      const double score = SortPolicy::BestPointToNodeDistance(query,
+          &node.Child(i));
+      const double bestDistance = SortPolicy::Relax(distances[0], epsilon);
+      if (SortPolicy::IsBetter(score, bestDistance))
+        SearchOneRecursion(query, node.Child(i), neighbors, distances);
+    }
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+SearchOneBaseCase(const arma::Col<ElemType>& query,
+                  const size_t referenceIndex,
+                  arma::Col<size_t>& neighbors,
+                  arma::vec& distances) const
+{
+  // Evaluate() doesn't modify any of the metrics, but not all of them declare
+  // it const.
+  const double distance = const_cast<MetricType&>(metric).Evaluate(query,
+      referenceSet->col(ReferenceMap() ?
+      oldFromNewReferences[referenceIndex] : referenceIndex));
+
+  CandidateHeap<SortPolicy>::Insert(distances.memptr(), neighbors.memptr(),
+      distances.n_elem, distance, referenceIndex);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+ResetTree(Tree& tree)
+{
+  std::stack<Tree*> nodes;
+  nodes.push(&tree);
+  while (!nodes.empty())
+  {
+    Tree* node = nodes.top();
+    nodes.pop();
+
+    // Reset bounds of this node.
+    node->Stat().Reset();
+
+    // Then add the children.
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      nodes.push(&node->Child(i));
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+template<typename RuleType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+SearchQueries(RuleType& rules, const size_t numQueries)
+{
+  // For trees with self-children whose first point is the centroid (i.e. the
+  // cover tree), the single-tree rules cache distances in the statistics of the
+  // reference nodes, so those can only be searched by one thread at a time.
+  const bool parallel = naive ||
+      !(tree::TreeTraits<Tree>::FirstPointIsCentroid &&
+        tree::TreeTraits<Tree>::HasSelfChildren);
+  (void) parallel; // This is only used by OpenMP.
+
+  // Each thread uses its own copy of the rules, and they all write to the same
+  // results matrices; that is fine because each query point has its own column.
+  size_t ruleBaseCases = 0, ruleScores = 0;
+  #pragma omp parallel if (parallel) reduction(+:ruleBaseCases, ruleScores)
+  {
+    RuleType threadRules(rules);
+    threadRules.BaseCases() = 0;
+    threadRules.Scores() = 0;
+
+    typename Tree::template SingleTreeTraverser<RuleType>
+        traverser(threadRules);
 
-      // Map each neighbor's index.
-      for (size_t j = 0; j < distances.n_rows; ++j)
-        neighbors(j, refMapping) = oldFromNewReferences[(*neighborPtr)(j, i)];
+    // The cost of each query point can vary a lot, so use dynamic scheduling.
+    #pragma omp for schedule(dynamic, 16)
+    for (omp_size_t i = 0; i < (omp_size_t) numQueries; ++i)
+    {
+      if (naive)
+      {
+        for (size_t j = 0; j < referenceSet->n_cols; ++j)
+          threadRules.BaseCase(i, j);
+      }
+      else
+      {
+        traverser.Traverse(i, *referenceTree);
+      }
     }
 
-    // Finished with temporary matrices.
-    delete neighborPtr;
-    delete distancePtr;
+    ruleBaseCases += threadRules.BaseCases();
+    ruleScores += threadRules.Scores();
   }
+
+  rules.BaseCases() += ruleBaseCases;
+  rules.Scores() += ruleScores;
 }
 
 //! Serialize the NeighborSearch model.
@@ -760,9 +1109,24 @@ void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
       treeOwner = true;
     }
 
+    // A tree built on a shared set does not hold the points; give it a
+    // permuted copy while it is saved, so that the archive can be loaded on
+    // its own.
+    const bool mapped = Archive::is_saving::value && ReferenceMap();
+    if (mapped)
+    {
+      MatType& treeSet = const_cast<MatType&>(referenceTree->Dataset());
+      treeSet.set_size(referenceSet->n_rows, referenceSet->n_cols);
+      for (size_t i = 0; i < oldFromNewReferences.size(); ++i)
+        treeSet.col(i) = referenceSet->col(oldFromNewReferences[i]);
+    }
+
     ar & CreateNVP(referenceTree, "referenceTree");
     ar & CreateNVP(oldFromNewReferences, "oldFromNewReferences");
 
+    if (mapped)
+      const_cast<MatType&>(referenceTree->Dataset()).reset();
+
     // If we are loading, set the dataset accordingly and clean up memory if
     // necessary.
     if (Archive::is_loading::value)
@@ -776,11 +1140,13 @@ void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
     }
   }
 
-  // Reset base cases and scores.
+  // Reset base cases and scores.  A loaded model owns its data, so it does not
+  // share a reference set.
   if (Archive::is_loading::value)
   {
     baseCases = 0;
     scores = 0;
+    sharedReferenceSet.reset();
   }
 }
 
@@ -9,10 +9,22 @@
 #define MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 
 #include <mlpack/core/tree/traversal_info.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#include <chrono>
+
+#include "candidate_heap.hpp"
+#include "blocked_brute_force.hpp"
 
 namespace mlpack {
 namespace neighbor {
 
+/**
+ * The base case and pruning rules for NeighborSearch.  During the search, the
+ * candidates for each query point are kept as a heap in its column of the
+ * neighbors and distances matrices (see CandidateHeap), so the columns must be
+ * sorted with CandidateHeap::Sort() once the search is done.
+ */
 template<typename SortPolicy, typename MetricType, typename TreeType>
 class NeighborSearchRules
 {
@@ -23,7 +35,8 @@ class NeighborSearchRules
                       arma::mat& distances,
                       MetricType& metric,
                       const double epsilon = 0,
-                      const bool sameSet = false);
+                      const bool sameSet = false,
+                      const std::vector<size_t>* referenceMap = NULL);
   /**
    * Get the distance from the query point to the reference point.
    * This will update the "neighbor" matrix with the new point if appropriate
@@ -34,6 +47,27 @@ class NeighborSearchRules
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Evaluate the base cases of a pair of leaves at once, if both leaves hold at
+   * least BlockedBaseCaseSize points and the metric allows it (see
+   * BlockedBruteForceTraits), and return whether that was done.  Each query
+   * point of the query leaf is scored against the reference leaf first, like
+   * the traversers do.  Then the squared distances between the remaining query
+   * points and the reference points are computed with a single matrix product,
+   * and only the pairs which may give a candidate are evaluated with
+   * BaseCase(), so the results are the same as with BaseCase() alone.  If this
+   * returns false, nothing was done, and the traverser must evaluate the base
+   * cases itself.
+   *
+   * @param queryNode Query leaf.
+   * @param referenceNode Reference leaf.
+   * @param numBaseCases Counter of the base cases of the traverser; the number
+   *     of reference points is added to it for each query point not pruned.
+   */
+  bool LeafBaseCases(TreeType& queryNode,
+                     TreeType& referenceNode,
+                     size_t& numBaseCases);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -94,6 +128,49 @@ class NeighborSearchRules
   //! Modify the number of scores that have been performed.
   size_t& Scores() { return scores; }
 
+  //! Convenience typedef.
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  //! Get the maximum number of base cases for each query point, for budgeted
+  //! traversals (0 means there is no limit).
+  size_t MaxBaseCases() const { return maxBaseCases; }
+  //! Modify the maximum number of base cases for each query point.
+  size_t& MaxBaseCases() { return maxBaseCases; }
+
+  //! Get the time at which budgeted traversals stop (TimePoint::max() means
+  //! there is no deadline).
+  const TimePoint& Deadline() const { return deadline; }
+  //! Modify the time at which budgeted traversals stop.
+  TimePoint& Deadline() { return deadline; }
+
+  /**
+   * Return whether the budget of a budgeted traversal (such as the
+   * BestFirstSingleTreeTraverser of BinarySpaceTree) is exhausted: either the
+   * given number of base cases for the current query point reached
+   * MaxBaseCases(), or the Deadline() has passed.
+   *
+   * @param queryBaseCases Number of base cases performed for the current query
+   *     point.
+   */
+  bool BudgetExhausted(const size_t queryBaseCases) const
+  {
+    if (maxBaseCases != 0 && queryBaseCases >= maxBaseCases)
+      return true;
+
+    return (deadline != TimePoint::max()) &&
+        (std::chrono::steady_clock::now() >= deadline);
+  }
+
+  /**
+   * Return whether the score value is at least as good as the score ref, so
+   * that best-first traversals search the most promising nodes first.  Scores
+   * are distances, so for furthest neighbor search, higher scores are better.
+   */
+  static bool IsBetterScore(const double value, const double ref)
+  {
+    return SortPolicy::IsBetter(value, ref);
+  }
+
   //! Convenience typedef.
   typedef typename tree::TraversalInfo<TreeType> TraversalInfoType;
 
@@ -121,6 +198,11 @@ class NeighborSearchRules
   //! Denotes whether or not the reference and query sets are the same.
   bool sameSet;
 
+  //! If not NULL, the column of referenceSet that holds the point with each
+  //! tree index (and, if sameSet is true, the same for querySet).  This is used
+  //! when the tree was built on a copy of the set that it no longer holds.
+  const std::vector<size_t>* referenceMap;
+
   //! Relative error to be considered in approximate search.
   const double epsilon;
 
@@ -136,6 +218,11 @@ class NeighborSearchRules
   //! The number of scores that have been performed.
   size_t scores;
 
+  //! The maximum number of base cases for each query point (0 for no limit).
+  size_t maxBaseCases;
+  //! The time at which budgeted traversals stop.
+  TimePoint deadline;
+
   //! Traversal info for the parent combination; this is updated by the
   //! traversal before each call to Score().
   TraversalInfoType traversalInfo;
@@ -145,19 +232,24 @@ class NeighborSearchRules
    */
   double CalculateBound(TreeType& queryNode) const;
 
-  /**
-   * Insert a point into the neighbors and distances matrices; this is a helper
-   * function.
-   *
-   * @param queryIndex Index of point whose neighbors we are inserting into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of reference point which is being inserted.
-   * @param distance Distance from query point to reference point.
-   */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  //! Evaluate the base cases of a pair of leaves with a matrix product; this is
+  //! called when the metric and matrix type allow it.
+  bool LeafBaseCases(TreeType& queryNode,
+                     TreeType& referenceNode,
+                     size_t& numBaseCases,
+                     const std::true_type& /* possible */);
+
+  //! Do nothing; this is called when the metric and matrix type don't allow
+  //! the matrix product.
+  bool LeafBaseCases(TreeType& /* queryNode */,
+                     TreeType& /* referenceNode */,
+                     size_t& /* numBaseCases */,
+                     const std::false_type& /* possible */)
+  { return false; }
+
+  //! The smallest number of points that both leaves of a pair must hold for
+  //! LeafBaseCases() to use a matrix product.
+  static const size_t BlockedBaseCaseSize = 32;
 };
 
 } // namespace neighbor
@@ -13,6 +13,45 @@
 namespace mlpack {
 namespace neighbor {
 
+// Forward declaration (it is only needed to specialize the base case below).
+class NearestNeighborSort;
+
+namespace aux {
+
+//! Compute the distance of a base case with the metric.
+template<typename SortPolicy, typename MetricType>
+struct BaseCaseDistance
+{
+  template<typename VecTypeA, typename VecTypeB>
+  static double Evaluate(MetricType& metric,
+                         const VecTypeA& query,
+                         const VecTypeB& reference,
+                         const double /* bestDistance */)
+  {
+    return metric.Evaluate(query, reference);
+  }
+};
+
+//! For nearest neighbor search with an LMetric, a reference point further than
+//! the k'th best candidate can't be a candidate, so the distance computation
+//! may stop as soon as it exceeds that bound.  The partial distance is a lower
+//! bound on the distance, which is all the rules use base cases for.
+template<int Power, bool TakeRoot>
+struct BaseCaseDistance<NearestNeighborSort, metric::LMetric<Power, TakeRoot> >
+{
+  template<typename VecTypeA, typename VecTypeB>
+  static double Evaluate(metric::LMetric<Power, TakeRoot>& /* metric */,
+                         const VecTypeA& query,
+                         const VecTypeB& reference,
+                         const double bestDistance)
+  {
+    return metric::LMetric<Power, TakeRoot>::EvaluateBounded(query, reference,
+        bestDistance);
+  }
+};
+
+} // namespace aux
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
     const typename TreeType::Mat& referenceSet,
@@ -21,18 +60,22 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
     arma::mat& distances,
     MetricType& metric,
     const double epsilon,
-    const bool sameSet) :
+    const bool sameSet,
+    const std::vector<size_t>* referenceMap) :
     referenceSet(referenceSet),
     querySet(querySet),
     neighbors(neighbors),
     distances(distances),
     metric(metric),
     sameSet(sameSet),
+    referenceMap(referenceMap),
     epsilon(epsilon),
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols),
     baseCases(0),
-    scores(0)
+    scores(0),
+    maxBaseCases(0),
+    deadline(TimePoint::max())
 {
   // We must set the traversal info last query and reference node pointers to
   // something that is both invalid (i.e. not a tree node) and not NULL.  We'll
@@ -55,20 +98,19 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
     return lastBaseCase;
 
-  double distance = metric.Evaluate(querySet.col(queryIndex),
-                                    referenceSet.col(referenceIndex));
+  const size_t queryColumn = (referenceMap && sameSet) ?
+      (*referenceMap)[queryIndex] : queryIndex;
+  const size_t referenceColumn = referenceMap ?
+      (*referenceMap)[referenceIndex] : referenceIndex;
+  double distance = aux::BaseCaseDistance<SortPolicy, MetricType>::Evaluate(
+      metric, querySet.col(queryColumn), referenceSet.col(referenceColumn),
+      distances(0, queryIndex));
   ++baseCases;
 
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  const size_t insertPosition = SortPolicy::SortDistance(queryDist,
-      queryIndices, distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // If this distance is better than the worst of the current candidates, it
+  // replaces that candidate.
+  CandidateHeap<SortPolicy>::Insert(distances.colptr(queryIndex),
+      neighbors.colptr(queryIndex), distances.n_rows, distance, referenceIndex);
 
   // Cache this information for the next time BaseCase() is called.
   lastQueryIndex = queryIndex;
@@ -78,6 +120,103 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+bool NeighborSearchRules<SortPolicy, MetricType, TreeType>::LeafBaseCases(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    size_t& numBaseCases)
+{
+  if (queryNode.NumPoints() < BlockedBaseCaseSize ||
+      referenceNode.NumPoints() < BlockedBaseCaseSize)
+    return false;
+
+  typedef std::integral_constant<bool, BlockedBruteForceTraits<MetricType,
+      typename TreeType::Mat>::UseBlockedBruteForce> Possible;
+
+  return LeafBaseCases(queryNode, referenceNode, numBaseCases, Possible());
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+bool NeighborSearchRules<SortPolicy, MetricType, TreeType>::LeafBaseCases(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    size_t& numBaseCases,
+    const std::true_type& /* possible */)
+{
+  // The score of a query point only depends on its own candidates, so all the
+  // query points can be scored before any base case is evaluated.
+  std::vector<size_t> queries;
+  queries.reserve(queryNode.NumPoints());
+  for (size_t i = 0; i < queryNode.NumPoints(); ++i)
+  {
+    const size_t queryIndex = queryNode.Point(i);
+    if (Score(queryIndex, referenceNode) != DBL_MAX)
+      queries.push_back(queryIndex);
+  }
+
+  if (queries.empty())
+    return true;
+
+  const size_t numReferences = referenceNode.NumPoints();
+  numBaseCases += queries.size() * numReferences;
+
+  arma::mat queryBlock(querySet.n_rows, queries.size());
+  for (size_t j = 0; j < queries.size(); ++j)
+  {
+    queryBlock.col(j) = querySet.col((referenceMap && sameSet) ?
+        (*referenceMap)[queries[j]] : queries[j]);
+  }
+
+  arma::mat referenceBlock(referenceSet.n_rows, numReferences);
+  for (size_t r = 0; r < numReferences; ++r)
+  {
+    const size_t referenceIndex = referenceNode.Point(r);
+    referenceBlock.col(r) = referenceSet.col(referenceMap ?
+        (*referenceMap)[referenceIndex] : referenceIndex);
+  }
+
+  const arma::rowvec queryNorms = arma::sum(arma::square(queryBlock), 0);
+  const arma::rowvec referenceNorms =
+      arma::sum(arma::square(referenceBlock), 0);
+  const arma::mat products = referenceBlock.t() * queryBlock;
+
+  const bool takeRoot = BlockedBruteForceTraits<MetricType,
+      typename TreeType::Mat>::TakeRoot;
+  for (size_t j = 0; j < queries.size(); ++j)
+  {
+    const size_t queryIndex = queries[j];
+    for (size_t r = 0; r < numReferences; ++r)
+    {
+      const size_t referenceIndex = referenceNode.Point(r);
+      if (sameSet && (queryIndex == referenceIndex))
+        continue;
+
+      // The squared distance given by the product may be off by the
+      // cancellation error of ||q||^2 + ||r||^2 - 2 q^T r, which is far below
+      // the tolerance.  If even the best distance within the tolerance can't
+      // be a candidate, the exact distance can't either.
+      const double squaredDistance = queryNorms[j] + referenceNorms[r] -
+          2 * products(r, j);
+      const double tolerance = 1e-8 * (queryNorms[j] + referenceNorms[r]);
+      double lower = std::max(squaredDistance - tolerance, 0.0);
+      double upper = squaredDistance + tolerance;
+      if (takeRoot)
+      {
+        lower = std::sqrt(lower);
+        upper = std::sqrt(upper);
+      }
+
+      const double best = SortPolicy::IsBetter(lower, upper) ? lower : upper;
+      if (SortPolicy::IsBetter(best, distances(0, queryIndex)))
+        BaseCase(queryIndex, referenceIndex);
+      else
+        ++baseCases;
+    }
+  }
+
+  return true;
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
@@ -109,12 +248,15 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
   }
   else
   {
-    distance = SortPolicy::BestPointToNodeDistance(querySet.col(queryIndex),
+    const size_t queryColumn = (referenceMap && sameSet) ?
+        (*referenceMap)[queryIndex] : queryIndex;
+    distance = SortPolicy::BestPointToNodeDistance(querySet.col(queryColumn),
         &referenceNode);
   }
 
-  // Compare against the best k'th distance for this query point so far.
-  double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  // Compare against the best k'th distance for this query point so far (which
+  // is at the top of its heap of candidates).
+  double bestDistance = distances(0, queryIndex);
   bestDistance = SortPolicy::Relax(bestDistance, epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ? distance : DBL_MAX;
@@ -131,7 +273,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
     return oldScore;
 
   // Just check the score again against the distances.
-  double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  double bestDistance = distances(0, queryIndex);
   bestDistance = SortPolicy::Relax(bestDistance, epsilon);
 
   return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
@@ -354,7 +496,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // Loop over points held in the node.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const double distance = distances(distances.n_rows - 1, queryNode.Point(i));
+    const double distance = distances(0, queryNode.Point(i));
     if (SortPolicy::IsBetter(worstDistance, distance))
       worstDistance = distance;
     if (SortPolicy::IsBetter(distance, bestPointDistance))
@@ -431,38 +573,6 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
     return bestDistance;
 }
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
-template<typename SortPolicy, typename MetricType, typename TreeType>
-void NeighborSearchRules<SortPolicy, MetricType, TreeType>::InsertNeighbor(
-    const size_t queryIndex,
-    const size_t pos,
-    const size_t neighbor,
-    const double distance)
-{
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (distances.n_rows - 1))
-  {
-    int len = (distances.n_rows - 1) - pos;
-    memmove(distances.colptr(queryIndex) + (pos + 1),
-        distances.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(neighbors.colptr(queryIndex) + (pos + 1),
-        neighbors.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
-
-  // Now put the new information in the right index.
-  distances(pos, queryIndex) = distance;
-  neighbors(pos, queryIndex) = neighbor;
-}
-
 } // namespace neighbor
 } // namespace mlpack
 
@@ -20,19 +20,24 @@ namespace mlpack {
 namespace neighbor {
 
 /**
- * Alias template for euclidean neighbor search.
+ * Alias template for euclidean neighbor search.  The MatType may be arma::mat
+ * or arma::fmat, for single-precision search.  Dual-tree searches use the
+ * parallel traverser of the tree, if it has one (see
+ * tree::ParallelDualTreeTraversal).
  */
 template<typename SortPolicy,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
+                  typename TreeMatType> class TreeType,
+         typename MatType = arma::mat>
 using NSType = NeighborSearch<SortPolicy,
                               metric::EuclideanDistance,
-                              arma::mat,
+                              MatType,
                               TreeType,
-                              TreeType<metric::EuclideanDistance,
+                              tree::ParallelDualTreeTraversal<TreeType<
+                                  metric::EuclideanDistance,
                                   NeighborSearchStat<SortPolicy>,
-                                  arma::mat>::template DualTreeTraverser>;
+                                  MatType>>::template Type>;
 
 template<typename SortPolicy>
 struct NSModelName
@@ -82,11 +87,11 @@ class MonoSearchVisitor : public boost::static_visitor<void>
  * accept leafSize as a parameter. In these cases, before doing neighbor search,
  * a query tree with proper leafSize is built from the querySet.
  */
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType = arma::mat>
 class BiSearchVisitor : public boost::static_visitor<void>
 {
  private:
-  const arma::mat& querySet;
+  const MatType& querySet;
   const size_t k;
   arma::Mat<size_t>& neighbors;
   arma::mat& distances;
@@ -101,7 +106,7 @@ class BiSearchVisitor : public boost::static_visitor<void>
   template<template<typename TreeMetricType,
                     typename TreeStatType,
                     typename TreeMatType> class TreeType>
-  using NSTypeT = NSType<SortPolicy, TreeType>;
+  using NSTypeT = NSType<SortPolicy, TreeType, MatType>;
 
   //! Default Bichromatic neighbor search on the given NSType instance.
   template<template<typename TreeMetricType,
@@ -115,7 +120,17 @@ class BiSearchVisitor : public boost::static_visitor<void>
   //! Bichromatic neighbor search on the given NSType specialized for BallTrees.
   void operator()(NSTypeT<tree::BallTree>* ns) const;
 
-  BiSearchVisitor(const arma::mat& querySet,
+  //! Bichromatic neighbor search on the given NSType specialized for VPTrees.
+  void operator()(NSTypeT<tree::VPTree>* ns) const;
+
+  //! Bichromatic neighbor search on the given NSType specialized for RPTrees.
+  void operator()(NSTypeT<tree::RPTree>* ns) const;
+
+  //! Bichromatic neighbor search on the given NSType specialized for
+  //! MaxRPTrees.
+  void operator()(NSTypeT<tree::MaxRPTree>* ns) const;
+
+  BiSearchVisitor(const MatType& querySet,
                   const size_t k,
                   arma::Mat<size_t>& neighbors,
                   arma::mat& distances,
@@ -128,11 +143,11 @@ class BiSearchVisitor : public boost::static_visitor<void>
  * accept leafSize as a parameter. In these cases, a reference tree with proper
  * leafSize is built from the referenceSet.
  */
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType = arma::mat>
 class TrainVisitor : public boost::static_visitor<void>
 {
  private:
-  arma::mat&& referenceSet;
+  MatType&& referenceSet;
   size_t leafSize;
 
   //! Train on the given NSType considering the leafSize.
@@ -144,7 +159,7 @@ class TrainVisitor : public boost::static_visitor<void>
   template<template<typename TreeMetricType,
                     typename TreeStatType,
                     typename TreeMatType> class TreeType>
-  using NSTypeT = NSType<SortPolicy, TreeType>;
+  using NSTypeT = NSType<SortPolicy, TreeType, MatType>;
 
   //! Default Train on the given NSType instance.
   template<template<typename TreeMetricType,
@@ -158,7 +173,16 @@ class TrainVisitor : public boost::static_visitor<void>
   //! Train on the given NSType specialized for BallTrees.
   void operator()(NSTypeT<tree::BallTree>* ns) const;
 
-  TrainVisitor(arma::mat&& referenceSet, const size_t leafSize);
+  //! Train on the given NSType specialized for VPTrees.
+  void operator()(NSTypeT<tree::VPTree>* ns) const;
+
+  //! Train on the given NSType specialized for RPTrees.
+  void operator()(NSTypeT<tree::RPTree>* ns) const;
+
+  //! Train on the given NSType specialized for MaxRPTrees.
+  void operator()(NSTypeT<tree::MaxRPTree>* ns) const;
+
+  TrainVisitor(MatType&& referenceSet, const size_t leafSize);
 };
 
 /**
@@ -191,14 +215,26 @@ class EpsilonVisitor : public boost::static_visitor<double&>
   double& operator()(NSType *ns) const;
 };
 
+/**
+ * BaseCasesVisitor exposes the number of base cases evaluated by the last
+ * search of the given NSType.
+ */
+class BaseCasesVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  template<typename NSType>
+  size_t operator()(NSType *ns) const;
+};
+
 /**
  * ReferenceSetVisitor exposes the referenceSet of the given NSType.
  */
-class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
+template<typename MatType = arma::mat>
+class ReferenceSetVisitor : public boost::static_visitor<const MatType&>
 {
  public:
   template<typename NSType>
-  const arma::mat& operator()(NSType *ns) const;
+  const MatType& operator()(NSType *ns) const;
 };
 
 /**
@@ -215,9 +251,14 @@ class DeleteVisitor : public boost::static_visitor<void>
  * The NSModel class provides an easy way to serialize a model, abstracts away
  * the different types of trees, and also reflects the NeighborSearch API.
  *
+ * The MatType may be arma::mat or arma::fmat; with arma::fmat, the reference
+ * and query sets and the trees are stored in single precision.  The distances
+ * are always returned as an arma::mat.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MatType The type of data matrix.
  */
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType = arma::mat>
 class NSModel
 {
  public:
@@ -229,7 +270,10 @@ class NSModel
     R_TREE,
     R_STAR_TREE,
     BALL_TREE,
-    X_TREE
+    X_TREE,
+    VP_TREE,
+    RP_TREE,
+    MAX_RP_TREE
   };
 
  private:
@@ -241,19 +285,26 @@ class NSModel
 
   //! For random projections.
   bool randomBasis;
-  arma::mat q;
+  MatType q;
+
+  //! Linear transformation applied to the points before search (empty if not
+  //! used).
+  MatType transformation;
 
   /**
    * nSearch holds an instance of the NeigborSearch class for the current
    * treeType. It is initialized every time BuildModel is executed.
    * We access to the contained value through the visitor classes defined above.
    */
-  boost::variant<NSType<SortPolicy, tree::KDTree>*,
-                 NSType<SortPolicy, tree::StandardCoverTree>*,
-                 NSType<SortPolicy, tree::RTree>*,
-                 NSType<SortPolicy, tree::RStarTree>*,
-                 NSType<SortPolicy, tree::BallTree>*,
-                 NSType<SortPolicy, tree::XTree>*> nSearch;
+  boost::variant<NSType<SortPolicy, tree::KDTree, MatType>*,
+                 NSType<SortPolicy, tree::StandardCoverTree, MatType>*,
+                 NSType<SortPolicy, tree::RTree, MatType>*,
+                 NSType<SortPolicy, tree::RStarTree, MatType>*,
+                 NSType<SortPolicy, tree::BallTree, MatType>*,
+                 NSType<SortPolicy, tree::XTree, MatType>*,
+                 NSType<SortPolicy, tree::VPTree, MatType>*,
+                 NSType<SortPolicy, tree::RPTree, MatType>*,
+                 NSType<SortPolicy, tree::MaxRPTree, MatType>*> nSearch;
 
  public:
   /**
@@ -267,10 +318,10 @@ class NSModel
 
   //! Serialize the neighbor search model.
   template<typename Archive>
-  void Serialize(Archive& ar, const unsigned int /* version */);
+  void Serialize(Archive& ar, const unsigned int version);
 
   //! Expose the dataset.
-  const arma::mat& Dataset() const;
+  const MatType& Dataset() const;
 
   //! Expose singleMode.
   bool SingleMode() const;
@@ -296,15 +347,52 @@ class NSModel
   bool RandomBasis() const { return randomBasis; }
   bool& RandomBasis() { return randomBasis; }
 
+  /**
+   * Expose the linear transformation applied to the reference and query points
+   * before search (and before the random basis, if one is used).  If it is the
+   * whitening transformation of a Mahalanobis distance (see
+   * metric::MahalanobisDistance::Whitening()), the search uses that distance,
+   * and the distances returned are Mahalanobis distances.  If empty (the
+   * default), the points are not transformed.  Don't modify this after the
+   * model has been built.
+   */
+  const MatType& Transformation() const { return transformation; }
+  MatType& Transformation() { return transformation; }
+
+  /**
+   * Choose the tree type and leaf size to search the given reference set with,
+   * and store them in TreeType() and LeafSize(), so that the next call to
+   * BuildModel() can use them.  Each candidate tree (every tree type, with
+   * several leaf sizes for the types that use one) is built on a random sample
+   * of the reference set, and searched for the neighbors of a random probe set
+   * of reference points; the candidate that takes the least time to build and
+   * search is chosen.  The points are transformed by Transformation() first,
+   * but not by the random basis.
+   *
+   * @param referenceSet Set of reference points.
+   * @param k Number of neighbors that will be searched for.
+   * @param singleMode Whether single-tree search will be used.
+   * @param epsilon Relative error tolerance of the searches.
+   * @param sampleSize Number of reference points to build the candidate trees
+   *     on.
+   * @param probeSize Number of query points to search the candidate trees with.
+   */
+  void SelectTree(const MatType& referenceSet,
+                  const size_t k,
+                  const bool singleMode,
+                  const double epsilon = 0,
+                  const size_t sampleSize = 5000,
+                  const size_t probeSize = 500);
+
   //! Build the reference tree.
-  void BuildModel(arma::mat&& referenceSet,
+  void BuildModel(MatType&& referenceSet,
                   const size_t leafSize,
                   const bool naive,
                   const bool singleMode,
                   const double epsilon = 0);
 
   //! Perform neighbor search.  The query set will be reordered.
-  void Search(arma::mat&& querySet,
+  void Search(MatType&& querySet,
               const size_t k,
               arma::Mat<size_t>& neighbors,
               arma::mat& distances);
@@ -316,11 +404,22 @@ class NSModel
 
   //! Return a string representation of the current tree type.
   std::string TreeName() const;
+
+ private:
+  //! Create an untrained NeighborSearch object of the current tree type.
+  void InitializeSearch(const bool naive,
+                        const bool singleMode,
+                        const double epsilon);
 };
 
 } // namespace neighbor
 } // namespace mlpack
 
+//! Set the serialization version of the NSModel class.
+BOOST_TEMPLATE_CLASS_VERSION(
+    template<typename SortPolicy MLPACK_COMMA typename MatType>,
+    mlpack::neighbor::NSModel<SortPolicy MLPACK_COMMA MatType>, 2);
+
 // Include implementation.
 #include "ns_model_impl.hpp"
 
@@ -14,6 +14,7 @@
 #include "ns_model.hpp"
 
 #include <boost/serialization/variant.hpp>
+#include <chrono>
 
 namespace mlpack {
 namespace neighbor {
@@ -28,12 +29,13 @@ void MonoSearchVisitor::operator()(NSType *ns) const
 }
 
 //! Save parameters for bichromatic neighbor search.
-template<typename SortPolicy>
-BiSearchVisitor<SortPolicy>::BiSearchVisitor(const arma::mat& querySet,
-                                             const size_t k,
-                                             arma::Mat<size_t>& neighbors,
-                                             arma::mat& distances,
-                                             const size_t leafSize) :
+template<typename SortPolicy, typename MatType>
+BiSearchVisitor<SortPolicy, MatType>::BiSearchVisitor(
+    const MatType& querySet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances,
+    const size_t leafSize) :
     querySet(querySet),
     k(k),
     neighbors(neighbors),
@@ -42,11 +44,12 @@ BiSearchVisitor<SortPolicy>::BiSearchVisitor(const arma::mat& querySet,
 {}
 
 //! Default Bichromatic neighbor search on the given NSType instance.
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType>
 template<template<typename TreeMetricType,
                   typename TreeStatType,
                   typename TreeMatType> class TreeType>
-void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<TreeType>* ns) const
+void BiSearchVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<TreeType>* ns) const
 {
   if (ns)
     return ns->Search(querySet, k, neighbors, distances);
@@ -54,8 +57,9 @@ void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<TreeType>* ns) const
 }
 
 //! Bichromatic neighbor search on the given NSType specialized for KDTrees.
-template<typename SortPolicy>
-void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::KDTree>* ns) const
+template<typename SortPolicy, typename MatType>
+void BiSearchVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::KDTree>* ns) const
 {
   if (ns)
     return SearchLeaf(ns);
@@ -63,8 +67,39 @@ void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::KDTree>* ns) const
 }
 
 //! Bichromatic neighbor search on the given NSType specialized for BallTrees.
-template<typename SortPolicy>
-void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::BallTree>* ns) const
+template<typename SortPolicy, typename MatType>
+void BiSearchVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::BallTree>* ns) const
+{
+  if (ns)
+    return SearchLeaf(ns);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Bichromatic neighbor search on the given NSType specialized for VPTrees.
+template<typename SortPolicy, typename MatType>
+void BiSearchVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::VPTree>* ns) const
+{
+  if (ns)
+    return SearchLeaf(ns);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Bichromatic neighbor search on the given NSType specialized for RPTrees.
+template<typename SortPolicy, typename MatType>
+void BiSearchVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::RPTree>* ns) const
+{
+  if (ns)
+    return SearchLeaf(ns);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Bichromatic neighbor search on the given NSType specialized for MaxRPTrees.
+template<typename SortPolicy, typename MatType>
+void BiSearchVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::MaxRPTree>* ns) const
 {
   if (ns)
     return SearchLeaf(ns);
@@ -72,9 +107,9 @@ void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::BallTree>* ns) const
 }
 
 //! Bichromatic neighbor search on the given NSType considering the leafSize.
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType>
 template<typename NSType>
-void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns) const
+void BiSearchVisitor<SortPolicy, MatType>::SearchLeaf(NSType* ns) const
 {
   if (!ns->Naive() && !ns->SingleMode())
   {
@@ -100,19 +135,19 @@ void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns) const
 }
 
 //! Save parameters for Train.
-template<typename SortPolicy>
-TrainVisitor<SortPolicy>::TrainVisitor(arma::mat&& referenceSet,
-                                       const size_t leafSize) :
+template<typename SortPolicy, typename MatType>
+TrainVisitor<SortPolicy, MatType>::TrainVisitor(MatType&& referenceSet,
+                                                const size_t leafSize) :
     referenceSet(std::move(referenceSet)),
     leafSize(leafSize)
 {}
 
 //! Default Train on the given NSType instance.
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType>
 template<template<typename TreeMetricType,
                   typename TreeStatType,
                   typename TreeMatType> class TreeType>
-void TrainVisitor<SortPolicy>::operator()(NSTypeT<TreeType>* ns) const
+void TrainVisitor<SortPolicy, MatType>::operator()(NSTypeT<TreeType>* ns) const
 {
   if (ns)
     return ns->Train(std::move(referenceSet));
@@ -120,8 +155,9 @@ void TrainVisitor<SortPolicy>::operator()(NSTypeT<TreeType>* ns) const
 }
 
 //! Train on the given NSType specialized for KDTrees.
-template<typename SortPolicy>
-void TrainVisitor<SortPolicy>::operator ()(NSTypeT<tree::KDTree>* ns) const
+template<typename SortPolicy, typename MatType>
+void TrainVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::KDTree>* ns) const
 {
   if (ns)
     return TrainLeaf(ns);
@@ -129,8 +165,39 @@ void TrainVisitor<SortPolicy>::operator ()(NSTypeT<tree::KDTree>* ns) const
 }
 
 //! Train on the given NSType specialized for BallTrees.
-template<typename SortPolicy>
-void TrainVisitor<SortPolicy>::operator ()(NSTypeT<tree::BallTree>* ns) const
+template<typename SortPolicy, typename MatType>
+void TrainVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::BallTree>* ns) const
+{
+  if (ns)
+    return TrainLeaf(ns);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Train on the given NSType specialized for VPTrees.
+template<typename SortPolicy, typename MatType>
+void TrainVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::VPTree>* ns) const
+{
+  if (ns)
+    return TrainLeaf(ns);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Train on the given NSType specialized for RPTrees.
+template<typename SortPolicy, typename MatType>
+void TrainVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::RPTree>* ns) const
+{
+  if (ns)
+    return TrainLeaf(ns);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Train on the given NSType specialized for MaxRPTrees.
+template<typename SortPolicy, typename MatType>
+void TrainVisitor<SortPolicy, MatType>::operator()(
+    NSTypeT<tree::MaxRPTree>* ns) const
 {
   if (ns)
     return TrainLeaf(ns);
@@ -138,9 +205,9 @@ void TrainVisitor<SortPolicy>::operator ()(NSTypeT<tree::BallTree>* ns) const
 }
 
 //! Train on the given NSType considering the leafSize.
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType>
 template<typename NSType>
-void TrainVisitor<SortPolicy>::TrainLeaf(NSType* ns) const
+void TrainVisitor<SortPolicy, MatType>::TrainLeaf(NSType* ns) const
 {
   if (ns->Naive())
     ns->Train(std::move(referenceSet));
@@ -185,9 +252,19 @@ double& EpsilonVisitor::operator()(NSType* ns) const
   throw std::runtime_error("no neighbor search model initialized");
 }
 
+//! Expose the number of base cases of the last search of the given NSType.
+template<typename NSType>
+size_t BaseCasesVisitor::operator()(NSType* ns) const
+{
+  if (ns)
+    return ns->BaseCases();
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
 //! Expose the referenceSet of the given NSType.
+template<typename MatType>
 template<typename NSType>
-const arma::mat& ReferenceSetVisitor::operator()(NSType* ns) const
+const MatType& ReferenceSetVisitor<MatType>::operator()(NSType* ns) const
 {
   if (ns)
     return ns->ReferenceSet();
@@ -206,17 +283,18 @@ void DeleteVisitor::operator()(NSType* ns) const
  * Initialize the NSModel with the given type and whether or not a random
  * basis should be used.
  */
-template<typename SortPolicy>
-NSModel<SortPolicy>::NSModel(TreeTypes treeType, bool randomBasis) :
+template<typename SortPolicy, typename MatType>
+NSModel<SortPolicy, MatType>::NSModel(TreeTypes treeType, bool randomBasis) :
     treeType(treeType),
+    leafSize(20),
     randomBasis(randomBasis)
 {
   // Nothing to do.
 }
 
 //! Clean memory, if necessary.
-template<typename SortPolicy>
-NSModel<SortPolicy>::~NSModel()
+template<typename SortPolicy, typename MatType>
+NSModel<SortPolicy, MatType>::~NSModel()
 {
   boost::apply_visitor(DeleteVisitor(), nSearch);
 }
@@ -243,15 +321,28 @@ void serialize(
 }
 
 //! Serialize the kNN model.
-template<typename SortPolicy>
+template<typename SortPolicy, typename MatType>
 template<typename Archive>
-void NSModel<SortPolicy>::Serialize(Archive& ar,
-                                    const unsigned int /* version */)
+void NSModel<SortPolicy, MatType>::Serialize(Archive& ar,
+                                    const unsigned int version)
 {
   ar & data::CreateNVP(treeType, "treeType");
+
+  // Models before version 2 didn't record their leaf size.
+  if (version >= 2)
+    ar & data::CreateNVP(leafSize, "leafSize");
+  else if (Archive::is_loading::value)
+    leafSize = 20;
+
   ar & data::CreateNVP(randomBasis, "randomBasis");
   ar & data::CreateNVP(q, "q");
 
+  // Models before version 1 had no transformation.
+  if (version >= 1)
+    ar & data::CreateNVP(transformation, "transformation");
+  else if (Archive::is_loading::value)
+    transformation.reset();
+
   // This should never happen, but just in case, be clean with memory.
   if (Archive::is_loading::value)
     boost::apply_visitor(DeleteVisitor(), nSearch);
@@ -261,58 +352,159 @@ void NSModel<SortPolicy>::Serialize(Archive& ar,
 }
 
 //! Expose the dataset.
-template<typename SortPolicy>
-const arma::mat& NSModel<SortPolicy>::Dataset() const
+template<typename SortPolicy, typename MatType>
+const MatType& NSModel<SortPolicy, MatType>::Dataset() const
 {
-  return boost::apply_visitor(ReferenceSetVisitor(), nSearch);
+  return boost::apply_visitor(ReferenceSetVisitor<MatType>(), nSearch);
 }
 
 //! Expose singleMode.
-template<typename SortPolicy>
-bool NSModel<SortPolicy>::SingleMode() const
+template<typename SortPolicy, typename MatType>
+bool NSModel<SortPolicy, MatType>::SingleMode() const
 {
   return boost::apply_visitor(SingleModeVisitor(), nSearch);
 }
 
-template<typename SortPolicy>
-bool& NSModel<SortPolicy>::SingleMode()
+template<typename SortPolicy, typename MatType>
+bool& NSModel<SortPolicy, MatType>::SingleMode()
 {
   return boost::apply_visitor(SingleModeVisitor(), nSearch);
 }
 
 //! Expose Naive.
-template<typename SortPolicy>
-bool NSModel<SortPolicy>::Naive() const
+template<typename SortPolicy, typename MatType>
+bool NSModel<SortPolicy, MatType>::Naive() const
 {
   return boost::apply_visitor(NaiveVisitor(), nSearch);
 }
 
-template<typename SortPolicy>
-bool& NSModel<SortPolicy>::Naive()
+template<typename SortPolicy, typename MatType>
+bool& NSModel<SortPolicy, MatType>::Naive()
 {
   return boost::apply_visitor(NaiveVisitor(), nSearch);
 }
 
-template<typename SortPolicy>
-double NSModel<SortPolicy>::Epsilon() const
+template<typename SortPolicy, typename MatType>
+double NSModel<SortPolicy, MatType>::Epsilon() const
 {
   return boost::apply_visitor(EpsilonVisitor(), nSearch);
 }
 
-template<typename SortPolicy>
-double& NSModel<SortPolicy>::Epsilon()
+template<typename SortPolicy, typename MatType>
+double& NSModel<SortPolicy, MatType>::Epsilon()
 {
   return boost::apply_visitor(EpsilonVisitor(), nSearch);
 }
 
+//! Choose the tree type and leaf size for the given reference set.
+template<typename SortPolicy, typename MatType>
+void NSModel<SortPolicy, MatType>::SelectTree(const MatType& referenceSet,
+                                              const size_t k,
+                                              const bool singleMode,
+                                              const double epsilon,
+                                              const size_t sampleSize,
+                                              const size_t probeSize)
+{
+  if (referenceSet.n_cols == 0)
+    throw std::invalid_argument("NSModel::SelectTree(): the reference set is "
+        "empty");
+
+  // Draw the sample and the probe set from a random order of the points; they
+  // only overlap if there are too few points for both.
+  const size_t n = referenceSet.n_cols;
+  const size_t numSample = std::max(size_t(1), std::min(sampleSize, n));
+  const size_t numProbe = std::max(size_t(1), std::min(probeSize, n));
+  const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0, n - 1,
+      n));
+  MatType sample = referenceSet.cols(order.head(numSample));
+  MatType probe = referenceSet.cols(order.tail(numProbe));
+  if (!transformation.is_empty())
+  {
+    sample = transformation * sample;
+    probe = transformation * probe;
+  }
+  const size_t probeK = std::max(size_t(1), std::min(k, numSample));
+
+  Log::Info << "Selecting the tree type with " << numSample << " reference "
+      << "points and " << numProbe << " query points..." << std::endl;
+
+  const TreeTypes treeTypes[] = { KD_TREE, COVER_TREE, R_TREE, R_STAR_TREE,
+      BALL_TREE, X_TREE, VP_TREE, RP_TREE, MAX_RP_TREE };
+  const size_t leafSizes[] = { 5, 10, 20, 40, 80 };
+
+  TreeTypes bestTreeType = KD_TREE;
+  size_t bestLeafSize = 20;
+  double bestTime = DBL_MAX;
+  for (const TreeTypes candidateType : treeTypes)
+  {
+    // Only these trees take a leaf size; the others are tried once.
+    const bool takesLeafSize = (candidateType == KD_TREE ||
+        candidateType == BALL_TREE || candidateType == VP_TREE ||
+        candidateType == RP_TREE || candidateType == MAX_RP_TREE);
+    for (const size_t candidateLeafSize : leafSizes)
+    {
+      if (!takesLeafSize && candidateLeafSize != 20)
+        continue;
+
+      NSModel candidate(candidateType);
+      candidate.leafSize = candidateLeafSize;
+      candidate.InitializeSearch(false, singleMode, epsilon);
+
+      const std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+
+      MatType candidateSample(sample);
+      TrainVisitor<SortPolicy, MatType> train(std::move(candidateSample),
+          candidateLeafSize);
+      boost::apply_visitor(train, candidate.nSearch);
+
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+      BiSearchVisitor<SortPolicy, MatType> search(probe, probeK, neighbors,
+          distances, candidateLeafSize);
+      boost::apply_visitor(search, candidate.nSearch);
+
+      const double time = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      const size_t baseCases = boost::apply_visitor(BaseCasesVisitor(),
+          candidate.nSearch);
+
+      Log::Info << "  " << candidate.TreeName();
+      if (takesLeafSize)
+        Log::Info << " (leaf size " << candidateLeafSize << ")";
+      Log::Info << ": " << time << "s, " << baseCases << " base cases."
+          << std::endl;
+
+      if (time < bestTime)
+      {
+        bestTime = time;
+        bestTreeType = candidateType;
+        bestLeafSize = candidateLeafSize;
+      }
+    }
+  }
+
+  treeType = bestTreeType;
+  leafSize = bestLeafSize;
+  Log::Info << "Selected " << TreeName() << " with leaf size " << leafSize
+      << "." << std::endl;
+}
+
 //! Build the reference tree.
-template<typename SortPolicy>
-void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
-                                     const size_t leafSize,
-                                     const bool naive,
-                                     const bool singleMode,
-                                     const double epsilon)
+template<typename SortPolicy, typename MatType>
+void NSModel<SortPolicy, MatType>::BuildModel(MatType&& referenceSet,
+                                              const size_t leafSize,
+                                              const bool naive,
+                                              const bool singleMode,
+                                              const double epsilon)
 {
+  this->leafSize = leafSize;
+
+  // Transform the reference set first, so that the random basis (if any) has
+  // the dimensionality of the transformed points.
+  if (!transformation.is_empty())
+    referenceSet = transformation * referenceSet;
+
   // Initialize random basis if necessary.
   if (randomBasis)
   {
@@ -321,11 +513,11 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
     {
       // [Q, R] = qr(randn(d, d));
       // Q = Q * diag(sign(diag(R)));
-      arma::mat r;
-      if (arma::qr(q, r, arma::randn<arma::mat>(referenceSet.n_rows,
+      MatType r;
+      if (arma::qr(q, r, arma::randn<MatType>(referenceSet.n_rows,
               referenceSet.n_rows)))
       {
-        arma::vec rDiag(r.n_rows);
+        arma::Col<typename MatType::elem_type> rDiag(r.n_rows);
         for (size_t i = 0; i < rDiag.n_elem; ++i)
         {
           if (r(i, i) < 0)
@@ -345,9 +537,6 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
     }
   }
 
-  // Clean memory, if necessary.
-  boost::apply_visitor(DeleteVisitor(), nSearch);
-
   // Do we need to modify the reference set?
   if (randomBasis)
     referenceSet = q * referenceSet;
@@ -358,50 +547,78 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
     Log::Info << "Building reference tree..." << std::endl;
   }
 
+  InitializeSearch(naive, singleMode, epsilon);
+
+  TrainVisitor<SortPolicy, MatType> tn(std::move(referenceSet), leafSize);
+  boost::apply_visitor(tn, nSearch);
+
+  if (!naive)
+  {
+    Timer::Stop("tree_building");
+    Log::Info << "Tree built." << std::endl;
+  }
+}
+
+//! Create an untrained NeighborSearch object of the current tree type.
+template<typename SortPolicy, typename MatType>
+void NSModel<SortPolicy, MatType>::InitializeSearch(const bool naive,
+                                                    const bool singleMode,
+                                                    const double epsilon)
+{
+  // Clean memory, if necessary.
+  boost::apply_visitor(DeleteVisitor(), nSearch);
+
   switch (treeType)
   {
     case KD_TREE:
-      nSearch = new NSType<SortPolicy, tree::KDTree>(naive, singleMode,
+      nSearch = new NSType<SortPolicy, tree::KDTree, MatType>(naive, singleMode,
           epsilon);
       break;
     case COVER_TREE:
-      nSearch = new NSType<SortPolicy, tree::StandardCoverTree>(naive,
+      nSearch = new NSType<SortPolicy, tree::StandardCoverTree, MatType>(naive,
           singleMode, epsilon);
       break;
     case R_TREE:
-      nSearch = new NSType<SortPolicy, tree::RTree>(naive, singleMode, epsilon);
+      nSearch = new NSType<SortPolicy, tree::RTree, MatType>(naive,
+          singleMode, epsilon);
       break;
     case R_STAR_TREE:
-      nSearch = new NSType<SortPolicy, tree::RStarTree>(naive, singleMode,
-          epsilon);
+      nSearch = new NSType<SortPolicy, tree::RStarTree, MatType>(naive,
+          singleMode, epsilon);
       break;
     case BALL_TREE:
-      nSearch = new NSType<SortPolicy, tree::BallTree>(naive, singleMode,
-          epsilon);
+      nSearch = new NSType<SortPolicy, tree::BallTree, MatType>(naive,
+          singleMode, epsilon);
       break;
     case X_TREE:
-      nSearch = new NSType<SortPolicy, tree::XTree>(naive, singleMode, epsilon);
+      nSearch = new NSType<SortPolicy, tree::XTree, MatType>(naive,
+          singleMode, epsilon);
+      break;
+    case VP_TREE:
+      nSearch = new NSType<SortPolicy, tree::VPTree, MatType>(naive,
+          singleMode, epsilon);
+      break;
+    case RP_TREE:
+      nSearch = new NSType<SortPolicy, tree::RPTree, MatType>(naive,
+          singleMode, epsilon);
+      break;
+    case MAX_RP_TREE:
+      nSearch = new NSType<SortPolicy, tree::MaxRPTree, MatType>(naive,
+          singleMode, epsilon);
       break;
-  }
-
-  TrainVisitor<SortPolicy> tn(std::move(referenceSet), leafSize);
-  boost::apply_visitor(tn, nSearch);
-
-  if (!naive)
-  {
-    Timer::Stop("tree_building");
-    Log::Info << "Tree built." << std::endl;
   }
 }
 
 //! Perform neighbor search.  The query set will be reordered.
-template<typename SortPolicy>
-void NSModel<SortPolicy>::Search(arma::mat&& querySet,
-                                 const size_t k,
-                                 arma::Mat<size_t>& neighbors,
-                                 arma::mat& distances)
+template<typename SortPolicy, typename MatType>
+void NSModel<SortPolicy, MatType>::Search(MatType&& querySet,
+                                          const size_t k,
+                                          arma::Mat<size_t>& neighbors,
+                                          arma::mat& distances)
 {
-  // We may need to map the query set randomly.
+  // The query set is transformed like the reference set.
+  if (!transformation.is_empty())
+    querySet = transformation * querySet;
   if (randomBasis)
     querySet = q * querySet;
 
@@ -416,16 +633,16 @@ void NSModel<SortPolicy>::Search(arma::mat&& querySet,
     Log::Info << "Maximum of " << Epsilon() * 100 << "% relative error."
         << std::endl;
 
-  BiSearchVisitor<SortPolicy> search(querySet, k, neighbors, distances,
+  BiSearchVisitor<SortPolicy, MatType> search(querySet, k, neighbors, distances,
       leafSize);
   boost::apply_visitor(search, nSearch);
 }
 
 //! Perform neighbor search.
-template<typename SortPolicy>
-void NSModel<SortPolicy>::Search(const size_t k,
-                                 arma::Mat<size_t>& neighbors,
-                                 arma::mat& distances)
+template<typename SortPolicy, typename MatType>
+void NSModel<SortPolicy, MatType>::Search(const size_t k,
+                                          arma::Mat<size_t>& neighbors,
+                                          arma::mat& distances)
 {
   Log::Info << "Searching for " << k << " neighbors with ";
   if (!Naive() && !SingleMode())
@@ -443,8 +660,8 @@ void NSModel<SortPolicy>::Search(const size_t k,
 }
 
 //! Get the name of the tree type.
-template<typename SortPolicy>
-std::string NSModel<SortPolicy>::TreeName() const
+template<typename SortPolicy, typename MatType>
+std::string NSModel<SortPolicy, MatType>::TreeName() const
 {
   switch (treeType)
   {
@@ -460,6 +677,12 @@ std::string NSModel<SortPolicy>::TreeName() const
       return "ball tree";
     case X_TREE:
       return "X tree";
+    case VP_TREE:
+      return "vantage point tree";
+    case RP_TREE:
+      return "random projection tree (mean split)";
+    case MAX_RP_TREE:
+      return "random projection tree (max split)";
     default:
       return "unknown tree";
   }
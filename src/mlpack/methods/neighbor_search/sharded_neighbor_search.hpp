@@ -0,0 +1,167 @@
+/**
+ * @file sharded_neighbor_search.hpp
+ *
+ * Defines the ShardedNeighborSearch class, which splits the reference set into
+ * shards that are each searched by their own NeighborSearch object, and merges
+ * the results of the shards.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_SHARDED_NEIGHBOR_SEARCH_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_SHARDED_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The ShardedNeighborSearch class performs distance-based neighbor searches on
+ * a reference set that is split into shards of consecutive points.  Each shard
+ * has its own NeighborSearch object (and tree), and the k best neighbors found
+ * in each shard are merged into the k best neighbors overall, with the indices
+ * mapped back to indices in the full reference set.  The distances are exactly
+ * the same as those of a single NeighborSearch object on the full reference
+ * set.  Neighbors with equal distances are listed in the order of their
+ * indices in the full reference set.  A single NeighborSearch object breaks
+ * ties by the position of the points in its tree instead, so when several
+ * points tie for the k'th distance, the points that are kept may differ too.
+ *
+ * The shards don't have to live in the same process.  Each shard can be saved
+ * with data::Save() (it is just a NeighborSearch object) and searched somewhere
+ * else, and the results of all shards can then be merged with the static
+ * Merge() function, given the index of the first point of each shard:
+ *
+ * @code
+ * // In process i, with the i'th shard of the reference set, which starts at
+ * // point offsets[i]:
+ * KNN shard;
+ * data::Load("shard_i.xml", "shard", shard);
+ * shard.Search(querySet, k, neighbors[i], distances[i]);
+ *
+ * // Then, once the results of all shards are collected:
+ * ShardedKNN::Merge(neighbors, distances, offsets, k, allNeighbors,
+ *     allDistances);
+ * @endcode
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MetricType The metric to use for computation.
+ * @tparam MatType The type of data matrix.
+ * @tparam TreeType The tree type to use; must adhere to the TreeType API.
+ */
+template<typename SortPolicy = NearestNeighborSort,
+         typename MetricType = mlpack::metric::EuclideanDistance,
+         typename MatType = arma::mat,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class ShardedNeighborSearch
+{
+ public:
+  //! The type of NeighborSearch object used for each shard.
+  typedef NeighborSearch<SortPolicy, MetricType, MatType, TreeType> NSType;
+
+  /**
+   * Split the given reference set into the given number of shards of (almost)
+   * equal size, and build a NeighborSearch object for each shard.
+   *
+   * @param referenceSet Set of reference points.
+   * @param numShards Number of shards; this must be between 1 and the number of
+   *     reference points.
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param epsilon Relative approximate error (non-negative).
+   * @param metric An optional instance of the MetricType class.
+   */
+  ShardedNeighborSearch(const MatType& referenceSet,
+                        const size_t numShards,
+                        const bool naive = false,
+                        const bool singleMode = false,
+                        const double epsilon = 0,
+                        const MetricType metric = MetricType());
+
+  //! Delete the NeighborSearch objects of the shards.
+  ~ShardedNeighborSearch();
+
+  // The shards are owned by this object, so it cannot be copied.
+  ShardedNeighborSearch(const ShardedNeighborSearch& other) = delete;
+  ShardedNeighborSearch& operator=(const ShardedNeighborSearch& other) =
+      delete;
+
+  /**
+   * For each point in the query set, compute the nearest neighbors in the full
+   * reference set by searching every shard and merging the results, and store
+   * the output in the given matrices.
+   *
+   * @param querySet Set of query points (can be just one point).
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   */
+  void Search(const MatType& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Merge the results of searching each shard of a reference set into the k
+   * best neighbors in the full reference set.  Shard i must hold the
+   * consecutive reference points starting at offsets[i], and its results must
+   * have one column for each query point, with indices relative to the shard.
+   * Neighbors with the index size_t() - 1 are ignored, and neighbors with
+   * equal distances are ordered by their index in the full reference set (so
+   * the smallest indices are kept).  A std::invalid_argument
+   * is thrown if the results of the shards have different numbers of columns,
+   * or if the shards don't give k neighbors in total.
+   *
+   * @param shardNeighbors Neighbors found in each shard.
+   * @param shardDistances Distances of the neighbors found in each shard.
+   * @param offsets Index of the first point of each shard.
+   * @param k Number of neighbors to keep.
+   * @param neighbors Matrix storing the merged neighbors of each query point.
+   * @param distances Matrix storing the merged distances of each query point.
+   */
+  static void Merge(const std::vector<arma::Mat<size_t> >& shardNeighbors,
+                    const std::vector<arma::mat>& shardDistances,
+                    const std::vector<size_t>& offsets,
+                    const size_t k,
+                    arma::Mat<size_t>& neighbors,
+                    arma::mat& distances);
+
+  //! Get the number of shards.
+  size_t NumShards() const { return shards.size(); }
+  //! Get the NeighborSearch object of the given shard.
+  const NSType& Shard(const size_t i) const { return *shards[i]; }
+  //! Modify the NeighborSearch object of the given shard.
+  NSType& Shard(const size_t i) { return *shards[i]; }
+  //! Get the index of the first reference point of the given shard.
+  size_t ShardOffset(const size_t i) const { return offsets[i]; }
+  //! Get the number of reference points in the given shard.
+  size_t ShardSize(const size_t i) const { return sizes[i]; }
+
+ private:
+  //! The NeighborSearch objects of the shards.
+  std::vector<NSType*> shards;
+  //! The index of the first reference point of each shard.
+  std::vector<size_t> offsets;
+  //! The number of reference points in each shard.
+  std::vector<size_t> sizes;
+};
+
+/**
+ * The ShardedKNN class is the sharded k-nearest-neighbors method, with L2
+ * (Euclidean) distances.
+ */
+typedef ShardedNeighborSearch<NearestNeighborSort, metric::EuclideanDistance>
+    ShardedKNN;
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "sharded_neighbor_search_impl.hpp"
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file sharded_neighbor_search_impl.hpp
+ *
+ * Implementation of the ShardedNeighborSearch class.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_SHARDED_NEIGHBOR_SEARCH_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_SHARDED_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sharded_neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+ShardedNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+ShardedNeighborSearch(const MatType& referenceSet,
+                      const size_t numShards,
+                      const bool naive,
+                      const bool singleMode,
+                      const double epsilon,
+                      const MetricType metric)
+{
+  if (numShards == 0 || numShards > referenceSet.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "ShardedNeighborSearch: number of shards (" << numShards << ") must "
+        << "be between 1 and the number of reference points ("
+        << referenceSet.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The first (n % numShards) shards get one extra point.
+  size_t offset = 0;
+  for (size_t i = 0; i < numShards; ++i)
+  {
+    const size_t size = referenceSet.n_cols / numShards +
+        ((i < referenceSet.n_cols % numShards) ? 1 : 0);
+    offsets.push_back(offset);
+    sizes.push_back(size);
+    shards.push_back(new NSType(MatType(referenceSet.cols(offset,
+        offset + size - 1)), naive, singleMode, epsilon, metric));
+    offset += size;
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+ShardedNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+~ShardedNeighborSearch()
+{
+  for (size_t i = 0; i < shards.size(); ++i)
+    delete shards[i];
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void ShardedNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Search(const MatType& querySet,
+       const size_t k,
+       arma::Mat<size_t>& neighbors,
+       arma::mat& distances)
+{
+  const size_t numPoints = offsets.back() + sizes.back();
+  if (k > numPoints)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << numPoints << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Each shard can only give as many neighbors as it has points.
+  std::vector<arma::Mat<size_t> > shardNeighbors(shards.size());
+  std::vector<arma::mat> shardDistances(shards.size());
+  for (size_t i = 0; i < shards.size(); ++i)
+    shards[i]->Search(querySet, std::min(k, sizes[i]), shardNeighbors[i],
+        shardDistances[i]);
+
+  Merge(shardNeighbors, shardDistances, offsets, k, neighbors, distances);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void ShardedNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Merge(const std::vector<arma::Mat<size_t> >& shardNeighbors,
+      const std::vector<arma::mat>& shardDistances,
+      const std::vector<size_t>& offsets,
+      const size_t k,
+      arma::Mat<size_t>& neighbors,
+      arma::mat& distances)
+{
+  if (shardNeighbors.size() != shardDistances.size() ||
+      shardNeighbors.size() != offsets.size() || shardNeighbors.empty())
+    throw std::invalid_argument("ShardedNeighborSearch::Merge(): there must be "
+        "the same (nonzero) number of neighbor matrices, distance matrices, "
+        "and offsets");
+
+  const size_t numQueries = shardNeighbors[0].n_cols;
+  size_t totalNeighbors = 0;
+  for (size_t i = 0; i < shardNeighbors.size(); ++i)
+  {
+    if (shardNeighbors[i].n_cols != numQueries ||
+        shardDistances[i].n_cols != numQueries ||
+        shardNeighbors[i].n_rows != shardDistances[i].n_rows)
+    {
+      std::ostringstream oss;
+      oss << "ShardedNeighborSearch::Merge(): results of shard " << i << " ("
+          << shardNeighbors[i].n_rows << "x" << shardNeighbors[i].n_cols
+          << " neighbors, " << shardDistances[i].n_rows << "x"
+          << shardDistances[i].n_cols << " distances) don't match the results "
+          << "of shard 0 (" << numQueries << " query points)";
+      throw std::invalid_argument(oss.str());
+    }
+
+    totalNeighbors += shardNeighbors[i].n_rows;
+  }
+
+  if (totalNeighbors < k)
+  {
+    std::ostringstream oss;
+    oss << "ShardedNeighborSearch::Merge(): requested " << k << " neighbors, "
+        << "but the shards only give " << totalNeighbors;
+    throw std::invalid_argument(oss.str());
+  }
+
+  neighbors.set_size(k, numQueries);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, numQueries);
+  distances.fill(SortPolicy::WorstDistance());
+
+  #pragma omp parallel for if (numQueries >= 1024)
+  for (omp_size_t q = 0; q < (omp_size_t) numQueries; ++q)
+  {
+    double* queryDistances = distances.colptr(q);
+    size_t* queryNeighbors = neighbors.colptr(q);
+    for (size_t i = 0; i < shardNeighbors.size(); ++i)
+    {
+      for (size_t j = 0; j < shardNeighbors[i].n_rows; ++j)
+      {
+        const size_t neighbor = shardNeighbors[i](j, q);
+        if (neighbor == size_t() - 1)
+          continue;
+
+        CandidateHeap<SortPolicy>::Insert(queryDistances, queryNeighbors, k,
+            shardDistances[i](j, q), offsets[i] + neighbor);
+      }
+    }
+
+    CandidateHeap<SortPolicy>::Sort(queryDistances, queryNeighbors, k);
+  }
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -22,8 +22,10 @@ void Unmap(const arma::Mat<size_t>& neighbors,
   neighborsOut.set_size(neighbors.n_rows, neighbors.n_cols);
   distancesOut.set_size(distances.n_rows, distances.n_cols);
 
-  // Unmap distances.
-  for (size_t i = 0; i < distances.n_cols; ++i)
+  // Unmap distances.  The query map is a permutation, so each column is written
+  // by one thread only.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) distances.n_cols; ++i)
   {
     // Map columns to the correct place.  The ternary operator does not work
     // here...
@@ -56,9 +58,43 @@ void Unmap(const arma::Mat<size_t>& neighbors,
     distancesOut = distances;
 
   // Map neighbors back to original locations.
-  for (size_t j = 0; j < neighbors.n_elem; ++j)
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t j = 0; j < (omp_size_t) neighbors.n_elem; ++j)
     neighborsOut[j] = referenceMap[neighbors[j]];
 }
 
+// Useful in the dual-tree setting, without a copy of the results.
+void UnmapInPlace(arma::Mat<size_t>& neighbors,
+                  arma::mat& distances,
+                  const std::vector<size_t>& referenceMap,
+                  const std::vector<size_t>& queryMap,
+                  const bool squareRoot)
+{
+  // First map the neighbor indices and take the square roots, in parallel, and
+  // then move the columns.
+  UnmapInPlace(neighbors, distances, referenceMap, squareRoot);
+
+  PermuteColumns(neighbors, queryMap);
+  PermuteColumns(distances, queryMap);
+}
+
+// Useful in the single-tree setting, without a copy of the results.
+void UnmapInPlace(arma::Mat<size_t>& neighbors,
+                  arma::mat& distances,
+                  const std::vector<size_t>& referenceMap,
+                  const bool squareRoot)
+{
+  // Map neighbors back to original locations, unless none was found.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t j = 0; j < (omp_size_t) neighbors.n_elem; ++j)
+  {
+    if (neighbors[j] != size_t() - 1)
+      neighbors[j] = referenceMap[neighbors[j]];
+  }
+
+  if (squareRoot)
+    distances = sqrt(distances);
+}
+
 } // namespace neighbor
 } // namespace mlpack
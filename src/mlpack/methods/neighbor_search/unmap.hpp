@@ -55,6 +55,74 @@ void Unmap(const arma::Mat<size_t>& neighbors,
            arma::mat& distancesOut,
            const bool squareRoot = false);
 
+/**
+ * Unmap the columns of the neighbors and distances matrices, and the entries
+ * in each row of neighbors, in place: this is the same as the dual-tree
+ * Unmap(), but no second copy of the results is made, so the peak memory is
+ * halved.  The columns are moved by following the cycles of the query
+ * permutation, and the neighbor indices are mapped in parallel.  Neighbor
+ * indices equal to size_t() - 1 (no neighbor was found) are left as they are.
+ *
+ * @param neighbors Matrix of neighbors to unmap.
+ * @param distances Matrix of distances to unmap.
+ * @param referenceMap Mapping of reference set to old points.
+ * @param queryMap Mapping of query set to old points.
+ * @param squareRoot If true, take the square root of the distances.
+ */
+void UnmapInPlace(arma::Mat<size_t>& neighbors,
+                  arma::mat& distances,
+                  const std::vector<size_t>& referenceMap,
+                  const std::vector<size_t>& queryMap,
+                  const bool squareRoot = false);
+
+/**
+ * Unmap the entries of the neighbors matrix in place, in parallel; this is the
+ * same as the single-tree Unmap(), without a second copy of the results.
+ * Neighbor indices equal to size_t() - 1 are left as they are.
+ *
+ * @param neighbors Matrix of neighbors to unmap.
+ * @param distances Matrix of distances.
+ * @param referenceMap Mapping of reference set to old points.
+ * @param squareRoot If true, take the square root of the distances.
+ */
+void UnmapInPlace(arma::Mat<size_t>& neighbors,
+                  arma::mat& distances,
+                  const std::vector<size_t>& referenceMap,
+                  const bool squareRoot = false);
+
+/**
+ * Move the columns of the given matrix to the positions given by the mapping
+ * (column i is moved to column map[i]), in place, by following the cycles of
+ * the permutation.  Only one column is held outside of the matrix at a time.
+ *
+ * @param matrix Matrix whose columns are permuted.
+ * @param map Mapping of the columns; it must be a permutation.
+ */
+template<typename eT>
+void PermuteColumns(arma::Mat<eT>& matrix, const std::vector<size_t>& map)
+{
+  std::vector<bool> visited(matrix.n_cols, false);
+  arma::Col<eT> carry(matrix.n_rows);
+  for (size_t start = 0; start < matrix.n_cols; ++start)
+  {
+    if (visited[start])
+      continue;
+
+    // Follow the cycle of the column at start, moving each column to its
+    // place and carrying the column that was there.
+    carry = matrix.col(start);
+    size_t current = start;
+    do
+    {
+      const size_t next = map[current];
+      visited[next] = true;
+      std::swap_ranges(carry.memptr(), carry.memptr() + matrix.n_rows,
+          matrix.colptr(next));
+      current = next;
+    } while (current != start);
+  }
+}
+
 } // namespace neighbor
 } // namespace mlpack
 
@@ -0,0 +1,343 @@
+/**
+ * @file nn_descent.cpp
+ *
+ * Implementation of the NNDescent class.
+ */
+#include "nn_descent.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/methods/lsh/lsh_search.hpp>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+NNDescent::NNDescent(const size_t maxIterations,
+                     const double sampleRate,
+                     const double tolerance,
+                     const size_t lshTables,
+                     const size_t lshProjections) :
+    maxIterations(maxIterations),
+    sampleRate(sampleRate),
+    tolerance(tolerance),
+    lshTables(lshTables),
+    lshProjections(lshProjections),
+    iterations(0),
+    distanceEvaluations(0)
+{
+  // Nothing to do.
+}
+
+namespace {
+
+//! A candidate neighbor of a point found by a local join.
+struct Update
+{
+  //! The point whose neighbors may be updated.
+  size_t point;
+  //! The candidate neighbor.
+  size_t candidate;
+  //! The distance between the point and the candidate.
+  double distance;
+};
+
+} // anonymous namespace
+
+void NNDescent::Build(const arma::mat& dataset,
+                      const size_t k,
+                      arma::Mat<size_t>& neighbors,
+                      arma::mat& distances)
+{
+  const size_t n = dataset.n_cols;
+  if (k == 0 || k >= n)
+  {
+    std::ostringstream oss;
+    oss << "NNDescent::Build(): number of neighbors (" << k << ") must be "
+        << "between 1 and the number of points minus one (" << n << " - 1)";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (sampleRate <= 0.0 || sampleRate > 1.0)
+  {
+    std::ostringstream oss;
+    oss << "NNDescent::Build(): sample rate (" << sampleRate << ") must be in "
+        << "(0, 1]";
+    throw std::invalid_argument(oss.str());
+  }
+
+  iterations = 0;
+  distanceEvaluations = 0;
+
+  // Seed the graph.  The neighbors that are not found yet are set to n, with
+  // the worst distance, which is where LSHSearch puts them too.
+  if (lshTables > 0)
+  {
+    LSHSearch<> lsh(dataset, lshProjections, lshTables);
+    lsh.Search(k, neighbors, distances);
+  }
+  else
+  {
+    neighbors.set_size(k, n);
+    neighbors.fill(n);
+    distances.set_size(k, n);
+    distances.fill(DBL_MAX);
+  }
+
+  // Every neighbor is new until it takes part in a local join.
+  arma::Mat<unsigned char> isNew(k, n);
+  isNew.fill(1);
+
+  const math::RandomStreams streams;
+  const size_t blocks = (n + BlockSize - 1) / BlockSize;
+  std::vector<size_t> blockCounts(blocks);
+
+  // Fill the neighbors that are not found yet with random points.
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    std::mt19937 generator = streams.Stream(b);
+    std::uniform_int_distribution<size_t> uniform(0, n - 1);
+
+    blockCounts[b] = 0;
+    const size_t end = std::min(n, (b + 1) * BlockSize);
+    for (size_t i = b * BlockSize; i < end; ++i)
+    {
+      while (distances(k - 1, i) == DBL_MAX)
+      {
+        const size_t j = uniform(generator);
+        if (j == i)
+          continue;
+
+        const double distance = metric::EuclideanDistance::Evaluate(
+            dataset.unsafe_col(i), dataset.unsafe_col(j));
+        ++blockCounts[b];
+        Insert(neighbors.colptr(i), distances.colptr(i), isNew.colptr(i), k, j,
+            distance);
+      }
+    }
+  });
+  for (size_t b = 0; b < blocks; ++b)
+    distanceEvaluations += blockCounts[b];
+  isNew.fill(1);
+
+  // The neighbors and reverse neighbors used in the local join of each point.
+  // The first newForward[i] (or oldForward[i]) elements of each list are
+  // neighbors of point i, and the rest are reverse neighbors.
+  const size_t sampleSize = std::max((size_t) 1,
+      (size_t) std::ceil(sampleRate * k));
+  std::vector<std::vector<size_t>> newLists(n), oldLists(n);
+  std::vector<size_t> newForward(n), oldForward(n), newSeen(n), oldSeen(n);
+
+  // The reverse neighbors of each point are sampled serially, with reservoir
+  // sampling.
+  std::mt19937 reverseGenerator = streams.Stream(blocks);
+  auto addReverse = [&](std::vector<std::vector<size_t>>& lists,
+                        const std::vector<size_t>& forward,
+                        std::vector<size_t>& seen,
+                        const size_t point,
+                        const size_t reverse)
+  {
+    const size_t count = seen[point]++;
+    if (count < sampleSize)
+    {
+      lists[point].push_back(reverse);
+    }
+    else
+    {
+      std::uniform_int_distribution<size_t> uniform(0, count);
+      const size_t position = uniform(reverseGenerator);
+      if (position < sampleSize)
+        lists[point][forward[point] + position] = reverse;
+    }
+  };
+
+  const size_t ranges = std::max((size_t) 1, std::min(ThreadPool::Threads(),
+      blocks));
+  std::vector<std::vector<Update>> updates(ranges);
+  std::vector<size_t> rangeCounts(ranges);
+  arma::Col<size_t> offsets(n + 1);
+  std::vector<std::pair<size_t, double>> candidates;
+
+  while (iterations < maxIterations)
+  {
+    const size_t iteration = iterations++;
+
+    // Sample the new neighbors of each point (they are old after this
+    // iteration), and collect its old neighbors.
+    ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+    {
+      std::mt19937 generator = streams.Stream((iteration + 1) * blocks + b +
+          1);
+      std::vector<size_t> positions;
+
+      const size_t end = std::min(n, (b + 1) * BlockSize);
+      for (size_t i = b * BlockSize; i < end; ++i)
+      {
+        newLists[i].clear();
+        oldLists[i].clear();
+        positions.clear();
+        for (size_t j = 0; j < k; ++j)
+        {
+          if (isNew(j, i))
+            positions.push_back(j);
+          else
+            oldLists[i].push_back(neighbors(j, i));
+        }
+
+        // Choose the sampled new neighbors with a partial shuffle.
+        const size_t count = std::min(sampleSize, positions.size());
+        for (size_t j = 0; j < count; ++j)
+        {
+          std::uniform_int_distribution<size_t> uniform(j,
+              positions.size() - 1);
+          std::swap(positions[j], positions[uniform(generator)]);
+          newLists[i].push_back(neighbors(positions[j], i));
+          isNew(positions[j], i) = 0;
+        }
+
+        newForward[i] = newLists[i].size();
+        oldForward[i] = oldLists[i].size();
+      }
+    });
+
+    // Add the reverse neighbors.
+    std::fill(newSeen.begin(), newSeen.end(), 0);
+    std::fill(oldSeen.begin(), oldSeen.end(), 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < newForward[i]; ++j)
+        addReverse(newLists, newForward, newSeen, newLists[i][j], i);
+      for (size_t j = 0; j < oldForward[i]; ++j)
+        addReverse(oldLists, oldForward, oldSeen, oldLists[i][j], i);
+    }
+
+    // The local join of each point compares every pair of its new neighbors,
+    // and every new neighbor with every old neighbor.  The neighbors are not
+    // modified during the joins; each range of points keeps the candidates
+    // that are better than the current worst neighbor of a point.
+    ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+    {
+      std::vector<Update>& rangeUpdates = updates[r];
+      rangeUpdates.clear();
+      rangeCounts[r] = 0;
+
+      auto join = [&](const size_t p, const size_t q)
+      {
+        if (p == q)
+          return;
+
+        const double distance = metric::EuclideanDistance::Evaluate(
+            dataset.unsafe_col(p), dataset.unsafe_col(q));
+        ++rangeCounts[r];
+        if (distance < distances(k - 1, p))
+          rangeUpdates.push_back(Update({ p, q, distance }));
+        if (distance < distances(k - 1, q))
+          rangeUpdates.push_back(Update({ q, p, distance }));
+      };
+
+      const size_t begin = r * n / ranges;
+      const size_t end = (r + 1) * n / ranges;
+      for (size_t i = begin; i < end; ++i)
+      {
+        const std::vector<size_t>& newList = newLists[i];
+        const std::vector<size_t>& oldList = oldLists[i];
+        for (size_t a = 0; a < newList.size(); ++a)
+        {
+          for (size_t c = a + 1; c < newList.size(); ++c)
+            join(newList[a], newList[c]);
+          for (size_t c = 0; c < oldList.size(); ++c)
+            join(newList[a], oldList[c]);
+        }
+      }
+    });
+
+    // Group the candidates by point, so that the neighbors of each point are
+    // updated by one thread.
+    offsets.zeros();
+    for (size_t r = 0; r < ranges; ++r)
+    {
+      distanceEvaluations += rangeCounts[r];
+      for (size_t u = 0; u < updates[r].size(); ++u)
+        ++offsets[updates[r][u].point + 1];
+    }
+    for (size_t i = 0; i < n; ++i)
+      offsets[i + 1] += offsets[i];
+
+    candidates.resize(offsets[n]);
+    arma::Col<size_t> next(offsets.memptr(), n);
+    for (size_t r = 0; r < ranges; ++r)
+    {
+      for (size_t u = 0; u < updates[r].size(); ++u)
+      {
+        const Update& update = updates[r][u];
+        candidates[next[update.point]++] = std::make_pair(update.candidate,
+            update.distance);
+      }
+    }
+
+    ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+    {
+      blockCounts[b] = 0;
+      const size_t end = std::min(n, (b + 1) * BlockSize);
+      for (size_t i = b * BlockSize; i < end; ++i)
+      {
+        for (size_t c = offsets[i]; c < offsets[i + 1]; ++c)
+        {
+          Insert(neighbors.colptr(i), distances.colptr(i), isNew.colptr(i), k,
+              candidates[c].first, candidates[c].second);
+        }
+
+        // Count the neighbors that were added and are still there (this
+        // doesn't depend on the order of the candidates).
+        for (size_t j = 0; j < k; ++j)
+        {
+          if (isNew(j, i) == 2)
+          {
+            isNew(j, i) = 1;
+            ++blockCounts[b];
+          }
+        }
+      }
+    });
+
+    size_t changes = 0;
+    for (size_t b = 0; b < blocks; ++b)
+      changes += blockCounts[b];
+
+    Log::Info << "NNDescent::Build(): iteration " << iterations << ": "
+        << changes << " neighbors updated." << std::endl;
+
+    if (changes <= tolerance * k * n)
+      break;
+  }
+
+  Log::Info << "NNDescent::Build(): " << distanceEvaluations << " distances "
+      << "computed in " << iterations << " iterations." << std::endl;
+}
+
+bool NNDescent::Insert(size_t* neighbors,
+                       double* distances,
+                       unsigned char* isNew,
+                       const size_t k,
+                       const size_t index,
+                       const double distance)
+{
+  if (distance >= distances[k - 1])
+    return false;
+
+  for (size_t j = 0; j < k; ++j)
+    if (neighbors[j] == index)
+      return false;
+
+  // Shift the worse neighbors to make room for the new one.
+  size_t j = k - 1;
+  for ( ; j > 0 && distances[j - 1] > distance; --j)
+  {
+    neighbors[j] = neighbors[j - 1];
+    distances[j] = distances[j - 1];
+    isNew[j] = isNew[j - 1];
+  }
+
+  neighbors[j] = index;
+  distances[j] = distance;
+  isNew[j] = 2;
+  return true;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file nn_descent.hpp
+ *
+ * Defines the NNDescent class, which builds an approximate k-nearest-neighbor
+ * graph of a dataset by refining the neighbors of each point with the
+ * neighbors of its neighbors.
+ *
+ * The details of this method can be found in the following paper:
+ *
+ * @inproceedings{dong2011efficient,
+ *   title={Efficient k-nearest neighbor graph construction for generic
+ *       similarity measures},
+ *   author={Dong, W. and Moses, C. and Li, K.},
+ *   booktitle={Proceedings of the 20th International Conference on World Wide
+ *       Web (WWW '11)},
+ *   pages={577--586},
+ *   year={2011}
+ * }
+ */
+#ifndef MLPACK_METHODS_NN_DESCENT_NN_DESCENT_HPP
+#define MLPACK_METHODS_NN_DESCENT_NN_DESCENT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The NNDescent class builds an approximate all-k-nearest-neighbor graph of a
+ * dataset with the Euclidean distance.  Exact all-k-nearest-neighbor search
+ * with trees becomes little better than a linear scan when the dimensionality
+ * is high, but NN-Descent only relies on the observation that a neighbor of a
+ * neighbor is likely to be a neighbor, so it works in any dimensionality, and
+ * typically finds almost all of the true neighbors while computing the
+ * distances of a small fraction of the pairs of points.
+ *
+ * The graph is seeded with random neighbors, or with the neighbors found by
+ * LSHSearch.  Then each iteration does a local join around every point: every
+ * pair of points among the (sampled) neighbors and reverse neighbors of the
+ * point is compared, and each point of the pair is offered to the other as a
+ * candidate neighbor.  Only pairs with at least one neighbor that is new since
+ * the last iteration are compared.  The iterations stop when fewer than
+ * tolerance * k * n neighbors were updated, or after maxIterations iterations.
+ *
+ * The local joins and the updates of the neighbors are done in parallel; the
+ * random sampling uses one random stream per block of points, and the updates
+ * of each point don't depend on the order of its candidates, so the graph
+ * doesn't depend on the number of threads (except for ties in distance).
+ *
+ * @code
+ * NNDescent nnd;
+ * arma::Mat<size_t> neighbors;
+ * arma::mat distances;
+ * nnd.Build(dataset, 10, neighbors, distances);
+ * @endcode
+ *
+ * The results have the format of those of NeighborSearch::Search() with the
+ * reference set as the query set: column i holds the k neighbors of point i
+ * (which is not its own neighbor) and their distances, best first.
+ */
+class NNDescent
+{
+ public:
+  /**
+   * Create the NNDescent object with the given parameters.
+   *
+   * @param maxIterations Maximum number of iterations.
+   * @param sampleRate Fraction of the new neighbors (and reverse neighbors) of
+   *     each point used in each local join, in (0, 1].
+   * @param tolerance The iterations stop when fewer than tolerance * k * n
+   *     neighbors were updated in an iteration.
+   * @param lshTables Number of hash tables of the LSHSearch used to seed the
+   *     graph (0 means the graph is seeded with random neighbors).
+   * @param lshProjections Number of projections of each LSH hash table.
+   */
+  NNDescent(const size_t maxIterations = 20,
+            const double sampleRate = 0.5,
+            const double tolerance = 0.001,
+            const size_t lshTables = 0,
+            const size_t lshProjections = 10);
+
+  /**
+   * Build the approximate k-nearest-neighbor graph of the given dataset, and
+   * store it in the given matrices, which will be set to the size of n columns
+   * by k rows, where n is the number of points.  A std::invalid_argument is
+   * thrown if k is 0 or not smaller than the number of points.
+   *
+   * @param dataset Points to build the graph of.
+   * @param k Number of neighbors of each point.
+   * @param neighbors Matrix storing the neighbors of each point.
+   * @param distances Matrix storing the distances to the neighbors of each
+   *     point.
+   */
+  void Build(const arma::mat& dataset,
+             const size_t k,
+             arma::Mat<size_t>& neighbors,
+             arma::mat& distances);
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the fraction of new neighbors used in each local join.
+  double SampleRate() const { return sampleRate; }
+  //! Modify the fraction of new neighbors used in each local join.
+  double& SampleRate() { return sampleRate; }
+
+  //! Get the tolerance of the stopping criterion.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance of the stopping criterion.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the number of LSH tables used to seed the graph.
+  size_t LSHTables() const { return lshTables; }
+  //! Modify the number of LSH tables used to seed the graph.
+  size_t& LSHTables() { return lshTables; }
+
+  //! Get the number of projections of each LSH table.
+  size_t LSHProjections() const { return lshProjections; }
+  //! Modify the number of projections of each LSH table.
+  size_t& LSHProjections() { return lshProjections; }
+
+  //! Get the number of iterations of the last call to Build().
+  size_t Iterations() const { return iterations; }
+  //! Get the number of distances computed by the last call to Build().
+  size_t DistanceEvaluations() const { return distanceEvaluations; }
+
+ private:
+  /**
+   * Add the given point to the sorted neighbors of a point, if it is better
+   * than the worst of them and not already one of them, and mark it as just
+   * added (with a flag of 2; the flag of a new neighbor is 1 and that of an
+   * old neighbor is 0).
+   *
+   * @return Whether the point was added.
+   */
+  static bool Insert(size_t* neighbors,
+                     double* distances,
+                     unsigned char* isNew,
+                     const size_t k,
+                     const size_t index,
+                     const double distance);
+
+  //! The maximum number of iterations.
+  size_t maxIterations;
+  //! The fraction of new neighbors used in each local join.
+  double sampleRate;
+  //! The tolerance of the stopping criterion.
+  double tolerance;
+  //! The number of LSH tables used to seed the graph.
+  size_t lshTables;
+  //! The number of projections of each LSH table.
+  size_t lshProjections;
+
+  //! The number of iterations of the last call to Build().
+  size_t iterations;
+  //! The number of distances computed by the last call to Build().
+  size_t distanceEvaluations;
+
+  //! The number of points sampled (or updated) with one random stream.
+  static const size_t BlockSize = 1024;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
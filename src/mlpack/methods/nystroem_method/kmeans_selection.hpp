@@ -10,12 +10,19 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus_initialization.hpp>
+#include <mlpack/methods/kmeans/allow_empty_clusters.hpp>
+#include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
 
 namespace mlpack {
 namespace kernel {
 
 /**
- * Implementation of the kmeans sampling scheme.
+ * Implementation of the kmeans sampling scheme.  Any k-means variant can be
+ * used as the clustering type; HamerlyKMeansSelection and
+ * MiniBatchKMeansSelection are faster choices than the default on large
+ * datasets.
  *
  * @tparam ClusteringType Type of clustering.
  * @tparam maxIterations Maximum number of iterations allowed before giving up.
@@ -34,17 +41,37 @@ class KMeansSelection
    */
   const static arma::mat* Select(const arma::mat& data, const size_t m)
   {
-    arma::Row<size_t> assignments;
     arma::mat* centroids = new arma::mat;
 
-    // Perform the K-Means clustering method.
+    // Perform the K-Means clustering method.  Only the centroids are needed,
+    // so the final assignments of the points are not computed.
     ClusteringType kmeans(maxIterations);
-    kmeans.Cluster(data, m, assignments, *centroids);
+    kmeans.Cluster(data, m, *centroids);
 
     return centroids;
   }
 };
 
+/**
+ * The kmeans sampling scheme with Hamerly's algorithm, initialized with
+ * k-means++; each iteration avoids most of the distance calculations of a full
+ * Lloyd iteration.
+ */
+template<size_t maxIterations = 5>
+using HamerlyKMeansSelection = KMeansSelection<kmeans::KMeans<
+    metric::EuclideanDistance, kmeans::KMeansPlusPlusInitialization,
+    kmeans::MaxVarianceNewCluster, kmeans::HamerlyKMeans>, maxIterations>;
+
+/**
+ * The kmeans sampling scheme with mini-batch k-means; each iteration only
+ * looks at a random sample of the points, so its cost does not depend on the
+ * size of the dataset.
+ */
+template<size_t maxIterations = 100>
+using MiniBatchKMeansSelection = KMeansSelection<kmeans::KMeans<
+    metric::EuclideanDistance, kmeans::SampleInitialization,
+    kmeans::AllowEmptyClusters, kmeans::MiniBatchKMeans>, maxIterations>;
+
 } // namespace kernel
 } // namespace mlpack
 
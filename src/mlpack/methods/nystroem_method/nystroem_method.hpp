@@ -33,6 +33,18 @@ class NystroemMethod
    */
   NystroemMethod(const arma::mat& data, KernelType& kernel, const size_t rank);
 
+  /**
+   * Create the NystroemMethod object on the dataset and kernel of the given
+   * kernel cache.  When the selected points are points of the dataset (that
+   * is, for every point selection policy but KMeansSelection), the columns of
+   * the kernel matrix are taken from the cache, and those which are computed
+   * are stored in it.
+   *
+   * @param cache Kernel cache of the data matrix.
+   * @param rank Rank to be used for matrix approximation.
+   */
+  NystroemMethod(KernelCache<KernelType>& cache, const size_t rank);
+
   /**
    * Apply the low-rank factorization to obtain an output matrix G such that
    * K' = G * G^T.
@@ -41,6 +53,13 @@ class NystroemMethod
    */
   void Apply(arma::mat& output);
 
+  //! Get the points selected by the last call to Apply() (one per column).
+  const arma::mat& SelectedPoints() const { return selectedPoints; }
+  //! Get the matrix which maps the kernel values of a point with the selected
+  //! points to its row of the output of the last call to Apply(): the output
+  //! is the semi-kernel matrix times this matrix.
+  const arma::mat& Normalization() const { return normalization; }
+
   /**
    * Construct the kernel matrix with matrix that contains the selected points.
    *
@@ -70,6 +89,24 @@ class NystroemMethod
   KernelType& kernel;
   //! Rank used for matrix approximation.
   const size_t rank;
+  //! The kernel cache of the dataset, if one was given (NULL otherwise).
+  KernelCache<KernelType>* cache;
+  //! The points selected by the last call to Apply().
+  arma::mat selectedPoints;
+  //! The normalization of the semi-kernel matrix of the last call to Apply().
+  arma::mat normalization;
+
+  //! The number of points whose kernel values are evaluated together.
+  static const size_t BlockSize = 1024;
+
+  /**
+   * Construct the semi-kernel matrix of the kernel values of every point with
+   * the selected points, in parallel blocks of points.
+   *
+   * @param selectedData Selected points.
+   * @param semiKernel Matrix to store the semi-kernel matrix in.
+   */
+  void SemiKernelMatrix(const arma::mat& selectedData, arma::mat& semiKernel);
 };
 
 } // namespace kernel
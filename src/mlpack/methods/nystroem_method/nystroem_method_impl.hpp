@@ -21,7 +21,18 @@ NystroemMethod<KernelType, PointSelectionPolicy>::NystroemMethod(
     const size_t rank) :
     data(data),
     kernel(kernel),
-    rank(rank)
+    rank(rank),
+    cache(NULL)
+{ }
+
+template<typename KernelType, typename PointSelectionPolicy>
+NystroemMethod<KernelType, PointSelectionPolicy>::NystroemMethod(
+    KernelCache<KernelType>& cache,
+    const size_t rank) :
+    data(cache.Dataset()),
+    kernel(cache.Kernel()),
+    rank(rank),
+    cache(&cache)
 { }
 
 template<typename KernelType, typename PointSelectionPolicy>
@@ -30,20 +41,18 @@ void NystroemMethod<KernelType, PointSelectionPolicy>::GetKernelMatrix(
     arma::mat& miniKernel,
     arma::mat& semiKernel)
 {
+  // Keep the selected points, to map new points.
+  selectedPoints = *selectedData;
+
+  // Clean the memory.
+  delete selectedData;
+
   // Assemble mini-kernel matrix.
-  for (size_t i = 0; i < rank; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      miniKernel(i, j) = kernel.Evaluate(selectedData->col(i),
-                                         selectedData->col(j));
+  KernelMatrix(kernel, selectedPoints, miniKernel);
 
   // Construct semi-kernel matrix with interactions between selected data and
   // all points.
-  for (size_t i = 0; i < data.n_cols; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      semiKernel(i, j) = kernel.Evaluate(data.col(i),
-                                         selectedData->col(j));
-  // Clean the memory.
-  delete selectedData;
+  SemiKernelMatrix(selectedPoints, semiKernel);
 }
 
 template<typename KernelType, typename PointSelectionPolicy>
@@ -52,18 +61,52 @@ void NystroemMethod<KernelType, PointSelectionPolicy>::GetKernelMatrix(
     arma::mat& miniKernel,
     arma::mat& semiKernel)
 {
+  // The semi-kernel matrix is made of the columns of the kernel matrix for the
+  // selected points, and the mini-kernel matrix is made of its rows for the
+  // selected points.
+  // The kernel matrices are evaluated in batches on a copy of the selected
+  // points, which is also kept to map new points.
+  const arma::uvec indices = arma::conv_to<arma::uvec>::from(selectedPoints);
+  this->selectedPoints = data.cols(indices);
+
+  if (cache)
+  {
+    cache->Columns(selectedPoints, semiKernel);
+    miniKernel = semiKernel.rows(indices);
+    return;
+  }
+
   // Assemble mini-kernel matrix.
-  for (size_t i = 0; i < rank; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      miniKernel(i, j) = kernel.Evaluate(data.col(selectedPoints(i)),
-                                         data.col(selectedPoints(j)));
+  KernelMatrix(kernel, this->selectedPoints, miniKernel);
 
   // Construct semi-kernel matrix with interactions between selected points and
   // all points.
-  for (size_t i = 0; i < data.n_cols; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      semiKernel(i, j) = kernel.Evaluate(data.col(i),
-                                         data.col(selectedPoints(j)));
+  SemiKernelMatrix(this->selectedPoints, semiKernel);
+}
+
+template<typename KernelType, typename PointSelectionPolicy>
+void NystroemMethod<KernelType, PointSelectionPolicy>::SemiKernelMatrix(
+    const arma::mat& selectedData,
+    arma::mat& semiKernel)
+{
+  semiKernel.set_size(data.n_cols, selectedData.n_cols);
+
+  // The rows of blocks of points are evaluated in parallel, each in one batch.
+  const size_t blocks = (data.n_cols + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    const size_t begin = b * BlockSize;
+    const size_t count = std::min((size_t) BlockSize,
+        (size_t) data.n_cols - begin);
+
+    // Use the points of the block where they are, without a copy.
+    const arma::mat block(const_cast<double*>(data.colptr(begin)), data.n_rows,
+        count, false, true);
+
+    arma::mat blockKernel;
+    KernelMatrix(kernel, block, selectedData, blockKernel);
+    semiKernel.rows(begin, begin + count - 1) = blockKernel;
+  });
 }
 
 template<typename KernelType, typename PointSelectionPolicy>
@@ -81,8 +124,8 @@ void NystroemMethod<KernelType, PointSelectionPolicy>::Apply(arma::mat& output)
   arma::svd(U, s, V, miniKernel);
 
   // Construct the output matrix.
-  arma::mat normalization = arma::diagmat(1.0 / sqrt(s));
-  output = semiKernel * U * normalization * V;
+  normalization = U * arma::diagmat(1.0 / sqrt(s)) * V;
+  output = semiKernel * normalization;
 }
 
 } // namespace kernel
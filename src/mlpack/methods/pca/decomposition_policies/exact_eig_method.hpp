@@ -0,0 +1,65 @@
+/**
+ * @file exact_eig_method.hpp
+ *
+ * Implementation of the eigendecomposition method for use in the PCA class.
+ */
+#ifndef MLPACK_METHODS_PCA_DECOMPOSITION_POLICIES_EXACT_EIG_METHOD_HPP
+#define MLPACK_METHODS_PCA_DECOMPOSITION_POLICIES_EXACT_EIG_METHOD_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * Implementation of the exact eigendecomposition policy, which computes all
+ * the principal components as the eigenvectors of the covariance matrix of the
+ * data.  The covariance is accumulated in a single, parallel pass over the
+ * points (see math::Covariance()), and only a (dimensionality x
+ * dimensionality) matrix is decomposed, so this is much faster than the SVD
+ * of the data when there are many more points than dimensions.  It is slightly
+ * less accurate for the smallest components, whose eigenvalues are the squares
+ * of the singular values of the data.
+ */
+class ExactEigPolicy
+{
+ public:
+  /**
+   * Apply Principal Component Analysis to the provided (centered) data set
+   * using the eigendecomposition of its covariance.
+   *
+   * @param centeredData Centered data matrix.
+   * @param transformedData Matrix to put results of PCA into.
+   * @param eigVal Vector to put eigenvalues into.
+   * @param eigvec Matrix to put eigenvectors (loadings) into.
+   * @param rank Rank of the decomposition (unused: all the components are
+   *     computed).
+   */
+  void Apply(const arma::mat& centeredData,
+             arma::mat& transformedData,
+             arma::vec& eigVal,
+             arma::mat& eigvec,
+             const size_t /* rank */) const
+  {
+    // The covariance matrix is X * X' / (N - 1).
+    arma::vec mean;
+    arma::mat covariance;
+    math::Covariance(centeredData, mean, covariance);
+    arma::eig_sym(eigVal, eigvec, covariance);
+
+    // The eigenvalues are in ascending order; the principal components are
+    // sorted by decreasing variance.  Rounding can make the eigenvalues of
+    // null directions slightly negative.
+    eigVal = arma::flipud(eigVal);
+    eigvec = arma::fliplr(eigvec);
+    eigVal.elem(arma::find(eigVal < 0)).zeros();
+
+    // Project the samples to the principals.
+    transformedData = arma::trans(eigvec) * centeredData;
+  }
+};
+
+} // namespace pca
+} // namespace mlpack
+
+#endif
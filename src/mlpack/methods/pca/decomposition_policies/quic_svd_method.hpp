@@ -0,0 +1,93 @@
+/**
+ * @file quic_svd_method.hpp
+ *
+ * Implementation of the QUIC-SVD method for use in the PCA class.
+ */
+#ifndef MLPACK_METHODS_PCA_DECOMPOSITION_POLICIES_QUIC_SVD_METHOD_HPP
+#define MLPACK_METHODS_PCA_DECOMPOSITION_POLICIES_QUIC_SVD_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/quic_svd/quic_svd.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * Implementation of the QUIC-SVD policy (see svd::QUIC_SVD).  The rank of the
+ * decomposition is chosen by QUIC-SVD from the given error tolerance, and only
+ * the components up to the requested rank are kept.
+ */
+class QUICSVDPolicy
+{
+ public:
+  /**
+   * Use QUIC-SVD with the given parameters.
+   *
+   * @param epsilon Error tolerance fraction for calculated subspace.
+   * @param delta Cumulative probability for Monte Carlo error lower bound.
+   */
+  QUICSVDPolicy(const double epsilon = 0.03, const double delta = 0.1) :
+      epsilon(epsilon),
+      delta(delta)
+  {
+    /* Nothing to do. */
+  }
+
+  /**
+   * Apply Principal Component Analysis to the provided (centered) data set
+   * using QUIC-SVD.
+   *
+   * @param centeredData Centered data matrix.
+   * @param transformedData Matrix to put results of PCA into.
+   * @param eigVal Vector to put eigenvalues into.
+   * @param eigvec Matrix to put eigenvectors (loadings) into.
+   * @param rank Maximum number of principal components to keep.
+   */
+  void Apply(const arma::mat& centeredData,
+             arma::mat& transformedData,
+             arma::vec& eigVal,
+             arma::mat& eigvec,
+             const size_t rank) const
+  {
+    // This matrix will store the right singular values; we do not need them.
+    arma::mat v, sigma;
+
+    svd::QUIC_SVD quicsvd(centeredData, eigvec, v, sigma, epsilon, delta);
+
+    // Now we must square the singular values to get the eigenvalues.
+    // In addition we must divide by the number of points, because the
+    // covariance matrix is X * X' / (N - 1).
+    eigVal = arma::square(sigma.diag()) / (centeredData.n_cols - 1);
+
+    // The singular values are not sorted.
+    const arma::uvec order = arma::sort_index(eigVal, "descend");
+    const size_t components = std::min(rank, (size_t) eigVal.n_elem);
+    const arma::uvec kept = order.subvec(0, components - 1);
+    eigVal = eigVal.elem(kept);
+    eigvec = eigvec.cols(kept);
+
+    // Project the samples to the principals.
+    transformedData = arma::trans(eigvec) * centeredData;
+  }
+
+  //! Get the error tolerance fraction for calculated subspace.
+  double Epsilon() const { return epsilon; }
+  //! Modify the error tolerance fraction for calculated subspace.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the cumulative probability for Monte Carlo error lower bound.
+  double Delta() const { return delta; }
+  //! Modify the cumulative probability for Monte Carlo error lower bound.
+  double& Delta() { return delta; }
+
+ private:
+  //! Error tolerance fraction for calculated subspace.
+  double epsilon;
+  //! Cumulative probability for Monte Carlo error lower bound.
+  double delta;
+};
+
+} // namespace pca
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file randomized_svd_method.hpp
+ *
+ * Implementation of the randomized SVD method for use in the PCA class.
+ */
+#ifndef MLPACK_METHODS_PCA_DECOMPOSITION_POLICIES_RANDOMIZED_SVD_METHOD_HPP
+#define MLPACK_METHODS_PCA_DECOMPOSITION_POLICIES_RANDOMIZED_SVD_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/randomized_svd/randomized_svd.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * Implementation of the randomized SVD policy, which only computes the given
+ * number of leading principal components (see svd::RandomizedSVD).  This is
+ * much faster than the exact SVD when the rank is much smaller than the
+ * dimensionality of the data.
+ */
+class RandomizedSVDPolicy
+{
+ public:
+  /**
+   * Use the randomized SVD with the given parameters.
+   *
+   * @param iteratedPower Number of power iterations.
+   * @param oversampling Number of columns of the basis beyond the rank.
+   */
+  RandomizedSVDPolicy(const size_t iteratedPower = 2,
+                      const size_t oversampling = 10) :
+      rSVD(iteratedPower, oversampling)
+  {
+    /* Nothing to do. */
+  }
+
+  /**
+   * Apply Principal Component Analysis to the provided (centered) data set
+   * using the randomized SVD.
+   *
+   * @param centeredData Centered data matrix.
+   * @param transformedData Matrix to put results of PCA into.
+   * @param eigVal Vector to put eigenvalues into.
+   * @param eigvec Matrix to put eigenvectors (loadings) into.
+   * @param rank Number of principal components to compute.
+   */
+  void Apply(const arma::mat& centeredData,
+             arma::mat& transformedData,
+             arma::vec& eigVal,
+             arma::mat& eigvec,
+             const size_t rank) const
+  {
+    // This matrix will store the right singular values; we do not need them.
+    arma::mat v;
+
+    rSVD.Apply(centeredData, eigvec, eigVal, v, std::min(rank,
+        (size_t) std::min(centeredData.n_rows, centeredData.n_cols)));
+
+    // Now we must square the singular values to get the eigenvalues.
+    // In addition we must divide by the number of points, because the
+    // covariance matrix is X * X' / (N - 1).
+    eigVal %= eigVal / (centeredData.n_cols - 1);
+
+    // Project the samples to the principals.
+    transformedData = arma::trans(eigvec) * centeredData;
+  }
+
+  //! Get the randomized SVD object.
+  const svd::RandomizedSVD& RandomizedSVD() const { return rSVD; }
+  //! Modify the randomized SVD object.
+  svd::RandomizedSVD& RandomizedSVD() { return rSVD; }
+
+ private:
+  //! Randomized SVD object.
+  svd::RandomizedSVD rSVD;
+};
+
+} // namespace pca
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file incremental_pca.cpp
+ *
+ * Implementation of the IncrementalPCA class.
+ */
+#include "incremental_pca.hpp"
+
+using namespace mlpack;
+using namespace mlpack::pca;
+
+IncrementalPCA::IncrementalPCA(const size_t rank) :
+    rank(rank),
+    numPoints(0),
+    sumSquares(0.0)
+{ /* Nothing to do. */ }
+
+void IncrementalPCA::Update(const arma::mat& batch)
+{
+  if (batch.n_cols == 0)
+    return;
+
+  if (numPoints > 0 && batch.n_rows != mean.n_elem)
+  {
+    std::ostringstream oss;
+    oss << "IncrementalPCA::Update(): the points have " << batch.n_rows
+        << " dimensions, but the model has " << mean.n_elem;
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Stack the current basis (scaled by the singular values), the centered
+  // batch, and the change of the mean (weighted so that the stacked matrix
+  // has the same scatter as all of the points around the new mean).
+  const size_t dimensionality = batch.n_rows;
+  const size_t oldComponents = basis.n_cols;
+  const size_t batchSize = batch.n_cols;
+  const arma::vec batchMean = arma::mean(batch, 1);
+  arma::mat stacked(dimensionality,
+      oldComponents + batchSize + ((numPoints > 0) ? 1 : 0));
+
+  if (oldComponents > 0)
+  {
+    stacked.cols(0, oldComponents - 1) = basis *
+        arma::diagmat(singularValues);
+  }
+
+  stacked.cols(oldComponents, oldComponents + batchSize - 1) =
+      batch.each_col() - batchMean;
+  const double batchSumSquares = arma::accu(arma::square(
+      stacked.cols(oldComponents, oldComponents + batchSize - 1)));
+
+  if (numPoints > 0)
+  {
+    const double n = (double) numPoints;
+    const double m = (double) batchSize;
+    const arma::vec shift = mean - batchMean;
+    stacked.col(stacked.n_cols - 1) = std::sqrt(n * m / (n + m)) * shift;
+
+    sumSquares += batchSumSquares + (n * m / (n + m)) * arma::dot(shift, shift);
+    mean = (n * mean + m * batchMean) / (n + m);
+  }
+  else
+  {
+    sumSquares = batchSumSquares;
+    mean = batchMean;
+  }
+  numPoints += batchSize;
+
+  // Only the left singular vectors are needed.
+  arma::mat u, v;
+  arma::vec s;
+  if (!arma::svd_econ(u, s, v, stacked, 'l'))
+    throw std::runtime_error("IncrementalPCA::Update(): the SVD failed");
+
+  const size_t maxComponents = (rank == 0) ? dimensionality :
+      std::min(rank, dimensionality);
+  const size_t components = std::min(maxComponents, (size_t) s.n_elem);
+  basis = u.cols(0, components - 1);
+  singularValues = s.subvec(0, components - 1);
+
+  // Make the largest coordinate of each component positive, so that the signs
+  // of the components don't flip between updates.
+  for (size_t i = 0; i < components; ++i)
+  {
+    const arma::vec magnitudes = arma::abs(basis.col(i));
+    arma::uword largest;
+    magnitudes.max(largest);
+    if (basis(largest, i) < 0.0)
+      basis.col(i) *= -1.0;
+  }
+}
+
+void IncrementalPCA::Transform(const arma::mat& data,
+                               arma::mat& transformedData) const
+{
+  if (numPoints == 0)
+    throw std::invalid_argument("IncrementalPCA::Transform(): the model has "
+        "not seen any points");
+
+  if (data.n_rows != mean.n_elem)
+  {
+    std::ostringstream oss;
+    oss << "IncrementalPCA::Transform(): the points have " << data.n_rows
+        << " dimensions, but the model has " << mean.n_elem;
+    throw std::invalid_argument(oss.str());
+  }
+
+  transformedData = basis.t() * (data.each_col() - mean);
+}
+
+arma::vec IncrementalPCA::Eigenvalues() const
+{
+  if (numPoints < 2)
+    return arma::zeros<arma::vec>(singularValues.n_elem);
+
+  return arma::square(singularValues) / (double) (numPoints - 1);
+}
+
+double IncrementalPCA::VarianceRetained() const
+{
+  if (sumSquares == 0.0)
+    return 1.0;
+
+  return std::min(1.0, arma::accu(arma::square(singularValues)) / sumSquares);
+}
@@ -0,0 +1,144 @@
+/**
+ * @file incremental_pca.hpp
+ *
+ * Definition of the IncrementalPCA class, which maintains the leading principal
+ * components of a stream of data, updated one batch of points at a time.
+ */
+#ifndef MLPACK_METHODS_PCA_INCREMENTAL_PCA_HPP
+#define MLPACK_METHODS_PCA_INCREMENTAL_PCA_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * IncrementalPCA computes the principal components of a dataset which is given
+ * a batch of points at a time, without keeping the points, so that the model
+ * can be updated when new data arrives instead of being computed again from
+ * scratch.  Only the mean of the points seen so far, their leading principal
+ * components (the basis) and the corresponding singular values are kept.
+ *
+ * Each call to Update() merges a batch into the model with the sequential
+ * Karhunen-Loeve update of Ross et al.: the thin SVD of the matrix holding the
+ * basis scaled by the singular values, the centered points of the batch and a
+ * column for the change of the mean is computed, and truncated to the given
+ * rank.  So the memory used is O(d * (rank + batch size)) for d dimensions.
+ * Without truncation (a rank of 0, or at least the dimensionality), the result
+ * is the same as with PCA on all the points; otherwise it is an approximation
+ * of the leading components, which is very accurate when the remaining
+ * components hold little variance.
+ *
+ * @code
+ * IncrementalPCA ipca(10);
+ * data::ChunkedLoader<double> loader("data.csv");
+ * arma::mat batch;
+ * while (loader.Next(batch, 10000))
+ *   ipca.Update(batch);
+ *
+ * arma::mat transformed;
+ * ipca.Transform(points, transformed);
+ * @endcode
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @article{ross2008incremental,
+ *   title={Incremental learning for robust visual tracking},
+ *   author={Ross, David A. and Lim, Jongwoo and Lin, Ruei-Sung and Yang,
+ *       Ming-Hsuan},
+ *   journal={International Journal of Computer Vision},
+ *   volume={77},
+ *   number={1--3},
+ *   pages={125--141},
+ *   year={2008}
+ * }
+ * @endcode
+ */
+class IncrementalPCA
+{
+ public:
+  /**
+   * Create an empty model, which will keep the given number of principal
+   * components.
+   *
+   * @param rank Number of principal components to keep (0 keeps all of them).
+   */
+  IncrementalPCA(const size_t rank = 0);
+
+  /**
+   * Merge the given batch of points into the model.  A std::invalid_argument
+   * is thrown if the dimensionality of the points is not the one of the points
+   * seen before, and a std::runtime_error if the SVD fails.
+   *
+   * @param batch Points to add (one per column).
+   */
+  void Update(const arma::mat& batch);
+
+  /**
+   * Project the given points onto the principal components.  A
+   * std::invalid_argument is thrown if no points were seen yet, or if the
+   * dimensionality of the points is not the one of the model.  It is safe to
+   * pass the same matrix reference for both data and transformedData.
+   *
+   * @param data Points to project (one per column).
+   * @param transformedData Matrix to store the projected points in.
+   */
+  void Transform(const arma::mat& data, arma::mat& transformedData) const;
+
+  /**
+   * Get the variances of the points seen so far along the principal components
+   * (the eigenvalues of their covariance matrix), in decreasing order.
+   */
+  arma::vec Eigenvalues() const;
+
+  /**
+   * Get the fraction of the variance of the points seen so far that is kept
+   * by the principal components (between 0 and 1).
+   */
+  double VarianceRetained() const;
+
+  //! Get the number of principal components to keep (0 means all).
+  size_t Rank() const { return rank; }
+  //! Get the number of points seen so far.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the mean of the points seen so far.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the principal components (one per column).
+  const arma::mat& Basis() const { return basis; }
+  //! Get the singular values of the centered points seen so far.
+  const arma::vec& SingularValues() const { return singularValues; }
+
+  /**
+   * Serialize the model.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(rank, "rank");
+    ar & data::CreateNVP(numPoints, "numPoints");
+    ar & data::CreateNVP(mean, "mean");
+    ar & data::CreateNVP(basis, "basis");
+    ar & data::CreateNVP(singularValues, "singularValues");
+    ar & data::CreateNVP(sumSquares, "sumSquares");
+  }
+
+ private:
+  //! The number of principal components to keep (0 means all).
+  size_t rank;
+  //! The number of points seen so far.
+  size_t numPoints;
+  //! The mean of the points seen so far.
+  arma::vec mean;
+  //! The principal components (one per column).
+  arma::mat basis;
+  //! The singular values of the centered points seen so far.
+  arma::vec singularValues;
+  //! The sum of the squared distances of the points seen so far to their mean.
+  double sumSquares;
+};
+
+} // namespace pca
+} // namespace mlpack
+
+#endif
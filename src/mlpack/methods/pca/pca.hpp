@@ -9,6 +9,7 @@
 #define MLPACK_METHODS_PCA_PCA_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/pca/decomposition_policies/exact_svd_method.hpp>
 
 namespace mlpack {
 namespace pca {
@@ -19,8 +20,23 @@ namespace pca {
  * or transforming data into a better basis.  Further information on PCA can be
  * found in almost any statistics or machine learning textbook, and all over the
  * internet.
+ *
+ * The decomposition of the centered data is done by the given decomposition
+ * policy: ExactSVDPolicy (the default) computes all the principal components,
+ * as does ExactEigPolicy, which decomposes the covariance matrix instead and is
+ * much faster when there are many more points than dimensions, while
+ * RandomizedSVDPolicy and QUICSVDPolicy compute approximations of the leading
+ * components only, which is much faster when the data is reduced to a small
+ * fraction of its dimensionality.
+ *
+ * The data is centered into the output matrix, and decomposed there, so that
+ * no other copy of it is made.
+ *
+ * @tparam DecompositionPolicy Class used to decompose the centered data; it
+ *     must provide Apply(centeredData, transformedData, eigVal, eigvec, rank).
  */
-class PCA
+template<typename DecompositionPolicy = ExactSVDPolicy>
+class PCAType
 {
  public:
   /**
@@ -28,8 +44,10 @@ class PCA
    * dimension by standard deviation when PCA is performed.
    *
    * @param scaleData Whether or not to scale the data.
+   * @param decomposition Decomposition policy to use.
    */
-  PCA(const bool scaleData = false);
+  PCAType(const bool scaleData = false,
+          const DecompositionPolicy& decomposition = DecompositionPolicy());
 
   /**
    * Apply Principal Component Analysis to the provided data set.  It is safe to
@@ -60,8 +78,9 @@ class PCA
   /**
    * Use PCA for dimensionality reduction on the given dataset.  This will save
    * the newDimension largest principal components of the data and remove the
-   * rest.  The parameter returned is the amount of variance of the data that is
-   * retained; this is a value between 0 and 1.  For instance, a value of 0.9
+   * rest; newDimension is also the target rank of the decomposition.  The
+   * parameter returned is the amount of variance of the data that is retained;
+   * this is a value between 0 and 1.  For instance, a value of 0.9
    * indicates that 90% of the variance present in the data was retained.
    *
    * @param data Data matrix.
@@ -100,14 +119,31 @@ class PCA
   //! the data when PCA is performed.
   bool& ScaleData() { return scaleData; }
 
+  //! Get the decomposition policy.
+  const DecompositionPolicy& Decomposition() const { return decomposition; }
+  //! Modify the decomposition policy.
+  DecompositionPolicy& Decomposition() { return decomposition; }
+
  private:
+  //! Center the given data (and scale it, if scaleData is set).
+  void Center(const arma::mat& data, arma::mat& centeredData) const;
+
   //! Whether or not the data will be scaled by standard deviation when PCA is
   //! performed.
   bool scaleData;
 
-}; // class PCA
+  //! Decomposition policy used to perform PCA.
+  DecompositionPolicy decomposition;
+
+}; // class PCAType
+
+//! PCA with the exact SVD.
+typedef PCAType<ExactSVDPolicy> PCA;
 
 } // namespace pca
 } // namespace mlpack
 
+// Include implementation.
+#include "pca_impl.hpp"
+
 #endif
@@ -5,8 +5,14 @@
  * Main executable to run PCA.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
 
 #include "pca.hpp"
+#include "incremental_pca.hpp"
+#include "decomposition_policies/exact_svd_method.hpp"
+#include "decomposition_policies/exact_eig_method.hpp"
+#include "decomposition_policies/randomized_svd_method.hpp"
+#include "decomposition_policies/quic_svd_method.hpp"
 
 using namespace mlpack;
 using namespace mlpack::pca;
@@ -17,7 +23,27 @@ PROGRAM_INFO("Principal Components Analysis", "This program performs principal "
     "components analysis on the given dataset.  It will transform the data "
     "onto its principal components, optionally performing dimensionality "
     "reduction by ignoring the principal components with the smallest "
-    "eigenvalues.");
+    "eigenvalues."
+    "\n\n"
+    "The decomposition method can be chosen with --decomposition_method (-c): "
+    "'exact' computes the full SVD of the data, 'eig' computes the "
+    "eigendecomposition of its covariance matrix (which is faster when there "
+    "are many more points than dimensions), while 'randomized' (the "
+    "randomized SVD, with power iterations) and 'quic' (QUIC-SVD) only "
+    "approximate the leading principal components.  With these, the new "
+    "dimensionality (-d) is the rank of the decomposition, and reducing the "
+    "data to a few of its dimensions is much faster than with 'exact'."
+    "\n\n"
+    "If --chunk_size (-z) is positive, incremental PCA is used instead: the "
+    "input file (a text, ARFF, Armadillo binary, native binary or HDF5 file) "
+    "is read --chunk_size points at a time, each chunk updates the principal "
+    "components, and the file is then read again to write the transformed "
+    "points (to a .csv, .txt, .mlbin or HDF5 file), so the dataset is never "
+    "loaded at once.  Incremental PCA is also used if a model is loaded with "
+    "--input_model_file (-m) or saved with --output_model_file (-M); a loaded "
+    "model is updated with the input dataset, so that it can be refreshed "
+    "when new data arrives without processing the old data again.  In this "
+    "case, -d is the number of principal components kept by the model.");
 
 // Parameters for program.
 PARAM_STRING_REQ("input_file", "Input dataset to perform PCA on.", "i");
@@ -31,11 +57,166 @@ PARAM_DOUBLE("var_to_retain", "Amount of variance to retain; should be between "
 PARAM_FLAG("scale", "If set, the data will be scaled before running PCA, such "
     "that the variance of each feature is 1.", "s");
 
+PARAM_STRING("decomposition_method", "Method used for the principal components "
+    "analysis: 'exact', 'eig', 'randomized', or 'quic'.", "c", "exact");
+PARAM_INT("iterated_power", "Number of power iterations of the randomized "
+    "SVD.", "p", 2);
+
+PARAM_INT("chunk_size", "If positive, incremental PCA is used, and the input "
+    "file is read this many points at a time.", "z", 0);
+PARAM_STRING("input_model_file", "File containing an incremental PCA model to "
+    "update.", "m", "");
+PARAM_STRING("output_model_file", "File to save the incremental PCA model "
+    "to.", "M", "");
+
+// Run PCA on the given dataset with the given decomposition method.
+template<typename DecompositionPolicy>
+void RunPCA(arma::mat& dataset,
+            const size_t newDimension,
+            const bool scale,
+            const DecompositionPolicy& decomposition = DecompositionPolicy())
+{
+  PCAType<DecompositionPolicy> p(scale, decomposition);
+
+  Log::Info << "Performing PCA on dataset..." << endl;
+  double varRetained;
+  if (CLI::GetParam<double>("var_to_retain") != 0)
+  {
+    if (CLI::GetParam<int>("new_dimensionality") != 0)
+      Log::Warn << "New dimensionality (-d) ignored because --var_to_retain was"
+          << " specified." << endl;
+
+    varRetained = p.Apply(dataset, CLI::GetParam<double>("var_to_retain"));
+  }
+  else
+  {
+    varRetained = p.Apply(dataset, newDimension);
+  }
+
+  Log::Info << (varRetained * 100) << "% of variance retained (" <<
+      dataset.n_rows << " dimensions)." << endl;
+}
+
+// Run incremental PCA, reading the input file in chunks if chunkSize is
+// positive.
+void RunIncrementalPCA(const string& inputFile,
+                       const string& outputFile,
+                       const size_t chunkSize)
+{
+  if (CLI::HasParam("scale"))
+    Log::Fatal << "--scale is not supported by incremental PCA!" << endl;
+  if (CLI::GetParam<double>("var_to_retain") != 0)
+    Log::Warn << "--var_to_retain ignored because incremental PCA is used."
+        << endl;
+  if (CLI::HasParam("decomposition_method"))
+    Log::Warn << "--decomposition_method ignored because incremental PCA is "
+        << "used." << endl;
+
+  const int newDimensionality = CLI::GetParam<int>("new_dimensionality");
+  if (newDimensionality < 0)
+    Log::Fatal << "New dimensionality (" << newDimensionality << ") cannot be "
+        << "negative!" << endl;
+
+  IncrementalPCA model((size_t) newDimensionality);
+  if (CLI::HasParam("input_model_file"))
+  {
+    data::Load(CLI::GetParam<string>("input_model_file"), "incrementalPCA",
+        model, true);
+    if (newDimensionality != 0 && (size_t) newDimensionality != model.Rank())
+      Log::Warn << "New dimensionality (-d) ignored because the loaded model "
+          << "keeps " << model.Rank() << " components." << endl;
+  }
+
+  // Check each chunk before updating the model with it.  The errors are
+  // thrown, so that they are reported with the I/O errors below.
+  auto update = [&model](const arma::mat& points)
+  {
+    std::ostringstream oss;
+    if (model.NumPoints() > 0 && points.n_rows != model.Mean().n_elem)
+    {
+      oss << "Input dimensionality (" << points.n_rows << ") must be the same "
+          << "as the model's (" << model.Mean().n_elem << ")!";
+      throw std::invalid_argument(oss.str());
+    }
+    if (model.Rank() > points.n_rows)
+    {
+      oss << "New dimensionality (" << model.Rank() << ") cannot be greater "
+          << "than existing dimensionality (" << points.n_rows << ")!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    model.Update(points);
+  };
+
+  Log::Info << "Performing incremental PCA on dataset..." << endl;
+  // In chunked mode, the files are read and written as the model is updated,
+  // and ChunkedLoader and ChunkedSaver throw std::runtime_error if any chunk
+  // can't be read or written.
+  try
+  {
+    if (chunkSize > 0)
+    {
+      data::ChunkedLoader<double> loader(inputFile);
+      arma::mat chunk;
+      Timer::Start("incremental_pca");
+      while (loader.Next(chunk, chunkSize))
+        update(chunk);
+      Timer::Stop("incremental_pca");
+
+      // Read the file again to transform it.
+      loader.Reset();
+      data::ChunkedSaver saver(outputFile);
+      while (loader.Next(chunk, chunkSize))
+      {
+        model.Transform(chunk, chunk);
+        saver.Write(chunk);
+      }
+    }
+    else
+    {
+      arma::mat dataset;
+      data::Load(inputFile, dataset);
+
+      Timer::Start("incremental_pca");
+      update(dataset);
+      Timer::Stop("incremental_pca");
+
+      model.Transform(dataset, dataset);
+      data::Save(outputFile, dataset);
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+
+  Log::Info << (model.VarianceRetained() * 100) << "% of variance retained ("
+      << model.Basis().n_cols << " dimensions, " << model.NumPoints()
+      << " points seen)." << endl;
+
+  if (CLI::HasParam("output_model_file"))
+    data::Save(CLI::GetParam<string>("output_model_file"), "incrementalPCA",
+        model);
+}
+
 int main(int argc, char** argv)
 {
   // Parse commandline.
   CLI::ParseCommandLine(argc, argv);
 
+  const int chunkSize = CLI::GetParam<int>("chunk_size");
+  if (chunkSize < 0)
+    Log::Fatal << "Invalid chunk size: " << chunkSize << ".  Must be 0 or "
+        << "greater." << endl;
+
+  if (chunkSize > 0 || CLI::HasParam("input_model_file") ||
+      CLI::HasParam("output_model_file"))
+  {
+    RunIncrementalPCA(CLI::GetParam<string>("input_file"),
+        CLI::GetParam<string>("output_file"), (size_t) chunkSize);
+    return 0;
+  }
+
   // Load input dataset.
   string inputFile = CLI::GetParam<string>("input_file");
   arma::mat dataset;
@@ -56,28 +237,41 @@ int main(int argc, char** argv)
   }
 
   // Get the options for running PCA.
-  const size_t scale = CLI::HasParam("scale");
+  const bool scale = CLI::HasParam("scale");
 
   // Perform PCA.
-  PCA p(scale);
-  Log::Info << "Performing PCA on dataset..." << endl;
-  double varRetained;
-  if (CLI::GetParam<double>("var_to_retain") != 0)
+  const string decompositionMethod = CLI::GetParam<string>(
+      "decomposition_method");
+  if (decompositionMethod == "exact")
   {
-    if (CLI::GetParam<int>("new_dimensionality") != 0)
-      Log::Warn << "New dimensionality (-d) ignored because --var_to_retain was"
-          << " specified." << endl;
+    RunPCA<ExactSVDPolicy>(dataset, newDimension, scale);
+  }
+  else if (decompositionMethod == "eig")
+  {
+    RunPCA<ExactEigPolicy>(dataset, newDimension, scale);
+  }
+  else if (decompositionMethod == "randomized")
+  {
+    const int iteratedPower = CLI::GetParam<int>("iterated_power");
+    if (iteratedPower < 0)
+      Log::Fatal << "Number of power iterations (" << iteratedPower << ") must "
+          << "not be negative!" << endl;
 
-    varRetained = p.Apply(dataset, CLI::GetParam<double>("var_to_retain"));
+    RunPCA(dataset, newDimension, scale,
+        RandomizedSVDPolicy((size_t) iteratedPower));
+  }
+  else if (decompositionMethod == "quic")
+  {
+    RunPCA<QUICSVDPolicy>(dataset, newDimension, scale);
   }
   else
   {
-    varRetained = p.Apply(dataset, newDimension);
+    // Invalid decomposition method.
+    Log::Fatal << "Invalid decomposition method ('" << decompositionMethod
+        << "'); valid choices are 'exact', 'eig', 'randomized', and 'quic'."
+        << endl;
   }
 
-  Log::Info << (varRetained * 100) << "% of variance retained (" <<
-      dataset.n_rows << " dimensions)." << endl;
-
   // Now save the results.
   string outputFile = CLI::GetParam<string>("output_file");
   data::Save(outputFile, dataset);
@@ -0,0 +1,73 @@
+/**
+ * @file minibatch_weight_update.hpp
+ *
+ * Mini-batch weight update rule for the perceptron.
+ */
+#ifndef MLPACK_METHODS_PERCEPTRON_LEARNING_POLICIES_MINIBATCH_WEIGHT_UPDATE_HPP
+#define MLPACK_METHODS_PERCEPTRON_LEARNING_POLICIES_MINIBATCH_WEIGHT_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * This class updates the weights of the perceptron once per mini-batch of
+ * points, instead of once per misclassified point.  All the points of a batch
+ * are classified with the same weights (with one matrix multiplication, split
+ * between the threads), and then the simple update rule of every misclassified
+ * point of the batch is applied at once:
+ *
+ *  W = W + X C
+ *
+ * where X holds the points of the batch and C has one row per point, with -w in
+ * the column of the class it was incorrectly classified as and +w in the column
+ * of its true class (w is the weight of the point, or 0 if it was correctly
+ * classified).  With a batch size of 1, this is SimpleWeightUpdate.
+ */
+class MiniBatchWeightUpdate
+{
+ public:
+  /**
+   * Create the learning policy.
+   *
+   * @param batchSize Number of points classified with the same weights.
+   */
+  MiniBatchWeightUpdate(const size_t batchSize = 256) : batchSize(batchSize)
+  { /* Nothing to do. */ }
+
+  /**
+   * Apply the corrections of a batch of points to the weights.
+   *
+   * @tparam MatType Type of matrix (should be an Armadillo matrix like
+   *      arma::mat or arma::sp_mat).
+   * @param points Points of the batch.
+   * @param weights Matrix of weights.
+   * @param biases Vector of biases.
+   * @param corrections Corrections of the points (one row per point, one
+   *      column per class).
+   */
+  template<typename MatType>
+  void UpdateWeights(const MatType& points,
+                     arma::mat& weights,
+                     arma::vec& biases,
+                     const arma::mat& corrections)
+  {
+    weights += points * corrections;
+    biases += arma::sum(corrections, 0).t();
+  }
+
+  //! Get the number of points classified with the same weights.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points classified with the same weights.
+  size_t& BatchSize() { return batchSize; }
+
+ private:
+  //! The number of points classified with the same weights.
+  size_t batchSize;
+};
+
+} // namespace perceptron
+} // namespace mlpack
+
+#endif
@@ -12,16 +12,33 @@
 #include "initialization_methods/zero_init.hpp"
 #include "initialization_methods/random_init.hpp"
 #include "learning_policies/simple_weight_update.hpp"
+#include "learning_policies/minibatch_weight_update.hpp"
 
 namespace mlpack {
 namespace perceptron {
 
+HAS_MEM_FUNC(BatchSize, HasBatchSizeCheck);
+
+/**
+ * This is a template struct that tells whether a learning policy updates the
+ * weights once per mini-batch of points (that is, whether it has a BatchSize()
+ * function).
+ */
+template<typename LearnPolicy>
+struct IsBatchLearnPolicy
+{
+  static const bool value = HasBatchSizeCheck<LearnPolicy,
+      size_t(LearnPolicy::*)() const>::value;
+};
+
 /**
  * This class implements a simple perceptron (i.e., a single layer neural
  * network).  It converges if the supplied training dataset is linearly
  * separable.
  *
- * @tparam LearnPolicy Options of SimpleWeightUpdate and GradientDescent.
+ * @tparam LearnPolicy Options of SimpleWeightUpdate (one update per
+ *      misclassified point) and MiniBatchWeightUpdate (one update per batch of
+ *      points, classified together in parallel).
  * @tparam WeightInitializationPolicy Option of ZeroInitialization and
  *      RandomInitialization.
  */
@@ -87,6 +104,10 @@ class Perceptron
    * This training does not reset the model weights, so you can call Train() on
    * multiple datasets sequentially.
    *
+   * If the learning policy updates the weights once per mini-batch (like
+   * MiniBatchWeightUpdate), the points of each batch are classified together,
+   * in parallel.
+   *
    * @param data Dataset on which training should be performed.
    * @param labels Labels of the dataset.  Make sure that these labels don't
    *      contain any values greater than NumClasses()!
@@ -99,7 +120,9 @@ class Perceptron
 
   /**
    * Classification function. After training, use the weights matrix to
-   * classify test, and put the predicted classes in predictedLabels.
+   * classify test, and put the predicted classes in predictedLabels.  The
+   * points are classified in blocks (with one matrix multiplication per
+   * block), in parallel.
    *
    * @param test Testing data or data to classify.
    * @param predictedLabels Vector to store the predicted classes after
@@ -131,7 +154,30 @@ class Perceptron
   //! Modify the biases.  You had better know what you are doing!
   arma::vec& Biases() { return biases; }
 
+  //! Get the learning policy.
+  const LearnPolicy& Policy() const { return learnPolicy; }
+  //! Modify the learning policy.
+  LearnPolicy& Policy() { return learnPolicy; }
+
 private:
+  //! Train with one update per misclassified point.
+  void Train(const MatType& data,
+             const arma::Row<size_t>& labels,
+             const arma::rowvec& instanceWeights,
+             const std::false_type /* batchPolicy */);
+
+  //! Train with one update per mini-batch of points.
+  void Train(const MatType& data,
+             const arma::Row<size_t>& labels,
+             const arma::rowvec& instanceWeights,
+             const std::true_type /* batchPolicy */);
+
+  //! The number of points classified at once by Classify().
+  static const size_t BlockSize = 256;
+
+  //! The learning policy.
+  LearnPolicy learnPolicy;
+
   //! The maximum number of iterations during training.
   size_t maxIterations;
 
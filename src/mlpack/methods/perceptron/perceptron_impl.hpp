@@ -107,16 +107,26 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Classify(
     const MatType& test,
     arma::Row<size_t>& predictedLabels)
 {
-  arma::vec tempLabelMat;
-  arma::uword maxIndex;
+  predictedLabels.set_size(test.n_cols);
 
-  // Could probably be faster if done in batch.
-  for (size_t i = 0; i < test.n_cols; i++)
+  // The scores of a block of points are computed with one matrix
+  // multiplication, and the blocks are split between the threads.
+  const size_t blocks = (test.n_cols + BlockSize - 1) / BlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
   {
-    tempLabelMat = weights.t() * test.col(i) + biases;
-    tempLabelMat.max(maxIndex);
-    predictedLabels(0, i) = maxIndex;
-  }
+    const size_t begin = b * BlockSize;
+    const size_t end = std::min((size_t) test.n_cols, begin + BlockSize);
+
+    arma::mat scores = weights.t() * test.cols(begin, end - 1);
+    scores.each_col() += biases;
+
+    arma::uword maxIndex;
+    for (size_t i = 0; i < scores.n_cols; i++)
+    {
+      scores.col(i).max(maxIndex);
+      predictedLabels[begin + i] = maxIndex;
+    }
+  });
 }
 
 /**
@@ -137,6 +147,24 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
     const MatType& data,
     const arma::Row<size_t>& labels,
     const arma::rowvec& instanceWeights)
+{
+  Train(data, labels, instanceWeights,
+      std::integral_constant<bool, IsBatchLearnPolicy<LearnPolicy>::value>());
+}
+
+/**
+ * Train with one update of the weights per misclassified point.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const std::false_type /* batchPolicy */)
 {
   size_t j, i = 0;
   bool converged = false;
@@ -144,8 +172,6 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
   arma::uword maxIndexRow, maxIndexCol;
   arma::mat tempLabelMat;
 
-  LearnPolicy LP;
-
   const bool hasWeights = (instanceWeights.n_elem > 0);
 
   while ((i < maxIterations) && (!converged))
@@ -175,16 +201,70 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
         // the value of the vector to update it with.  Send tempLabel to know
         // the correct class.
         if (hasWeights)
-          LP.UpdateWeights(data.col(j), weights, biases, maxIndexRow, tempLabel,
-              instanceWeights(j));
+          learnPolicy.UpdateWeights(data.col(j), weights, biases, maxIndexRow,
+              tempLabel, instanceWeights(j));
         else
-          LP.UpdateWeights(data.col(j), weights, biases, maxIndexRow,
+          learnPolicy.UpdateWeights(data.col(j), weights, biases, maxIndexRow,
               tempLabel);
       }
     }
   }
 }
 
+/**
+ * Train with one update of the weights per mini-batch of points.  The points of
+ * a batch are classified together with Classify(), and the corrections of the
+ * misclassified points are applied at once.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const std::true_type /* batchPolicy */)
+{
+  const size_t batchSize = std::max((size_t) 1, learnPolicy.BatchSize());
+  const bool hasWeights = (instanceWeights.n_elem > 0);
+
+  arma::Row<size_t> predictions;
+  arma::mat corrections;
+  bool converged = false;
+  for (size_t i = 0; (i < maxIterations) && !converged; i++)
+  {
+    converged = true;
+    for (size_t begin = 0; begin < data.n_cols; begin += batchSize)
+    {
+      const size_t end = std::min((size_t) data.n_cols, begin + batchSize);
+      const MatType batch = data.cols(begin, end - 1);
+      Classify(batch, predictions);
+
+      corrections.zeros(batch.n_cols, weights.n_cols);
+      bool correct = true;
+      for (size_t j = 0; j < batch.n_cols; j++)
+      {
+        const size_t label = labels[begin + j];
+        if (predictions[j] != label)
+        {
+          const double weight = hasWeights ? instanceWeights[begin + j] : 1.0;
+          corrections(j, predictions[j]) -= weight;
+          corrections(j, label) += weight;
+          correct = false;
+        }
+      }
+
+      if (!correct)
+      {
+        converged = false;
+        learnPolicy.UpdateWeights(batch, weights, biases, corrections);
+      }
+    }
+  }
+}
+
 //! Serialize the perceptron.
 template<typename LearnPolicy,
          typename WeightInitializationPolicy,
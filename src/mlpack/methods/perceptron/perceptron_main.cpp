@@ -58,6 +58,12 @@ PROGRAM_INFO("Perceptron",
     "classes and then re-train with a 4-class dataset.  Similarly, attempting "
     "classification on a 3-dimensional dataset with a perceptron that has been "
     "trained on 8 dimensions will cause an error."
+    "\n\n"
+    "If --batch_size (-b) is given, the weights are updated once per batch of "
+    "that many points (which are classified together, in parallel) instead of "
+    "once per misclassified point.  Classification is always done in parallel "
+    "blocks of points, with as many threads as specified by the --threads (-j) "
+    "option."
     );
 
 // Training parameters.
@@ -66,6 +72,8 @@ PARAM_STRING("labels_file", "A file containing labels for the training set.",
   "l", "");
 PARAM_INT("max_iterations","The maximum number of iterations the perceptron is "
   "to be run", "n", 1000);
+PARAM_INT("batch_size", "If nonzero, the number of points per weight update "
+    "(mini-batch training).", "b", 0);
 
 // Model loading/saving.
 PARAM_STRING("input_model_file", "File containing input perceptron model.", "m",
@@ -98,6 +106,22 @@ class PerceptronModel
   }
 };
 
+// Train the given perceptron with one weight update per mini-batch of points.
+void TrainMiniBatch(Perceptron<>& p,
+                    const mat& trainingData,
+                    const Row<size_t>& labels,
+                    const size_t batchSize)
+{
+  Perceptron<MiniBatchWeightUpdate> mbp(0, 0, p.MaxIterations());
+  mbp.Weights() = p.Weights();
+  mbp.Biases() = p.Biases();
+  mbp.Policy().BatchSize() = batchSize;
+  mbp.Train(trainingData, labels);
+
+  p.Weights() = mbp.Weights();
+  p.Biases() = mbp.Biases();
+}
+
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
@@ -110,6 +134,7 @@ int main(int argc, char** argv)
   const string outputModelFile = CLI::GetParam<string>("output_model_file");
   const string outputFile = CLI::GetParam<string>("output_file");
   const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
+  const int batchSize = CLI::GetParam<int>("batch_size");
 
   // We must either load a model or train a model.
   if (!CLI::HasParam("input_model_file") && !CLI::HasParam("training_file"))
@@ -126,6 +151,9 @@ int main(int argc, char** argv)
   if (CLI::HasParam("test_file") && !CLI::HasParam("output_file"))
     Log::Fatal << "--output_file must be specified with --test_file" << endl;
 
+  if (batchSize < 0)
+    Log::Fatal << "--batch_size must be nonnegative!" << endl;
+
   // Now, load our model, if there is one.
   Perceptron<>* p = NULL;
   Col<size_t> mappings;
@@ -188,8 +216,17 @@ int main(int argc, char** argv)
     {
       // Create and train the classifier.
       Timer::Start("training");
-      p = new Perceptron<>(trainingData, labels, max(labels) + 1,
-          maxIterations);
+      if (batchSize == 0)
+      {
+        p = new Perceptron<>(trainingData, labels, max(labels) + 1,
+            maxIterations);
+      }
+      else
+      {
+        p = new Perceptron<>(max(labels) + 1, trainingData.n_rows,
+            maxIterations);
+        TrainMiniBatch(*p, trainingData, labels, (size_t) batchSize);
+      }
       Timer::Stop("training");
     }
     else
@@ -214,7 +251,10 @@ int main(int argc, char** argv)
       // Now train.
       Timer::Start("training");
       p->MaxIterations() = maxIterations;
-      p->Train(trainingData, labels.t());
+      if (batchSize == 0)
+        p->Train(trainingData, labels.t());
+      else
+        TrainMiniBatch(*p, trainingData, labels, (size_t) batchSize);
       Timer::Stop("training");
     }
   }
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/data/split_data.hpp>
+#include <mlpack/core/data/split_files.hpp>
 
 PROGRAM_INFO("Split Data", "This utility takes a dataset and optionally labels "
     "and splits them into a training set and a test set. Before the split, the "
@@ -36,7 +37,22 @@ PROGRAM_INFO("Split Data", "This utility takes a dataset and optionally labels "
     "\n\n"
     "$ mlpack_preprocess_split -i dataset.csv -I labels.csv -r 0.3\n"
     "> -t training_set.csv -l training_labels.csv -T test_set.csv\n"
-    "> -L test_labels.csv");
+    "> -L test_labels.csv"
+    "\n\n"
+    "Datasets too large to fit in memory can be split as they are read, "
+    "--chunk_size (-c) points at a time.  Then each point is put in the test "
+    "set with probability --test_ratio, so the size of the test set is only "
+    "approximately the given ratio, and the test set keeps the order of the "
+    "dataset.  The training set keeps the order of the dataset too, unless "
+    "--shuffle_buffer_size (-b) is given: then it is shuffled in external "
+    "memory, with runs of that many points written to temporary files next to "
+    "the training file.  The input files can be text, ARFF, Armadillo binary, "
+    "mlpack native binary (.mlbin) or HDF5 files, and the output files text "
+    "(.csv or .txt), native binary or HDF5 files; the binary formats are much "
+    "faster and smaller for large datasets.  The labels files then hold one "
+    "label per line (or per point)."
+    "\n\n"
+    "The split is reproducible with the --seed (-s) option.");
 
 // Define parameters for data.
 PARAM_STRING_REQ("input_file", "File containing data,", "i");
@@ -51,6 +67,13 @@ PARAM_STRING("test_labels_file", "File name to save test label", "L","");
 PARAM_DOUBLE("test_ratio", "Ratio of test set, if not set,"
     "the ratio defaults to 0.2", "r", 0.2);
 
+PARAM_INT("chunk_size", "If positive, the dataset is split as it is read, this "
+    "many points at a time, instead of being loaded into memory.", "c", 0);
+PARAM_INT("shuffle_buffer_size", "If positive (with --chunk_size), the "
+    "training set is shuffled in external memory, this many points at a time.",
+    "b", 0);
+PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+
 using namespace mlpack;
 using namespace arma;
 using namespace std;
@@ -68,17 +91,17 @@ int main(int argc, char** argv)
   const double testRatio = CLI::GetParam<double>("test_ratio");
 
   // Check on label parameters.
-  if (CLI::HasParam("input_labels"))
+  if (CLI::HasParam("input_labels_file"))
   {
     if (!CLI::HasParam("training_labels_file"))
     {
       Log::Fatal << "--training_labels_file (-l) must be specified if "
-          << "--input_labels (-l) is specified!" << endl;
+          << "--input_labels_file (-I) is specified!" << endl;
     }
     if (!CLI::HasParam("test_labels_file"))
     {
       Log::Fatal << "--test_labels_file (-L) must be specified if "
-          << "--input_labels (-I) is specified!" << endl;
+          << "--input_labels_file (-I) is specified!" << endl;
     }
   }
   else
@@ -87,11 +110,29 @@ int main(int argc, char** argv)
         CLI::HasParam("test_labels_file"))
     {
       Log::Fatal << "When specifying --training_labels_file or "
-          << "--test_labels_file, you must also specify --input_labels."
+          << "--test_labels_file, you must also specify --input_labels_file."
           << endl;
     }
   }
 
+  const int chunkSize = CLI::GetParam<int>("chunk_size");
+  const int shuffleBufferSize = CLI::GetParam<int>("shuffle_buffer_size");
+  if (chunkSize < 0)
+  {
+    Log::Fatal << "Invalid chunk size (" << chunkSize << "); must be 0 or "
+        << "greater." << endl;
+  }
+  if (shuffleBufferSize < 0)
+  {
+    Log::Fatal << "Invalid shuffle buffer size (" << shuffleBufferSize
+        << "); must be 0 or greater." << endl;
+  }
+  if (shuffleBufferSize > 0 && chunkSize == 0)
+  {
+    Log::Fatal << "--shuffle_buffer_size (-b) can only be specified with "
+        << "--chunk_size (-c)." << endl;
+  }
+
   // Check test_ratio.
   if (CLI::HasParam("test_ratio"))
   {
@@ -107,37 +148,69 @@ int main(int argc, char** argv)
         << " set to 0.2." << endl;
   }
 
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) std::time(NULL));
+
+  if (chunkSize > 0)
+  {
+    // Split the dataset as it is read, without loading it.  SplitFiles()
+    // throws std::runtime_error if a file can't be read or written, or if the
+    // labels don't match the points.
+    std::pair<size_t, size_t> sizes;
+    try
+    {
+      sizes = data::SplitFiles(inputFile, inputLabels, trainingFile, testFile,
+          trainingLabelsFile, testLabelsFile, testRatio, (size_t) chunkSize,
+          (size_t) shuffleBufferSize);
+    }
+    catch (std::runtime_error& e)
+    {
+      Log::Fatal << e.what() << endl;
+    }
+
+    Log::Info << "Training data contains " << sizes.first << " points."
+        << endl;
+    Log::Info << "Test data contains " << sizes.second << " points." << endl;
+    return 0;
+  }
+
   // Load the data.
   arma::mat data;
   data::Load(inputFile, data, true);
 
+  // The data is split in place, so the training and test sets are the first
+  // and last columns of the loaded matrix, and are saved without copies.
   // If parameters for labels exist, we must split the labels too.
+  size_t trainSize;
   if (CLI::HasParam("input_labels_file"))
   {
     arma::mat labels;
     data::Load(inputLabels, labels, true);
     arma::rowvec labelsRow = labels.row(0);
 
-    const auto value = data::Split(data, labelsRow, testRatio);
-    Log::Info << "Training data contains " << get<0>(value).n_cols << " points."
-        << endl;
-    Log::Info << "Test data contains " << get<1>(value).n_cols << " points."
-        << endl;
+    trainSize = data::SplitInPlace(data, labelsRow, testRatio);
 
-    data::Save(trainingFile, get<0>(value), false);
-    data::Save(testFile, get<1>(value), false);
-    data::Save(trainingLabelsFile, get<2>(value), false);
-    data::Save(testLabelsFile, get<3>(value), false);
+    const arma::rowvec trainLabels(labelsRow.memptr(), trainSize, false, true);
+    const arma::rowvec testLabels(labelsRow.memptr() + trainSize,
+        labelsRow.n_elem - trainSize, false, true);
+    data::Save(trainingLabelsFile, trainLabels, false);
+    data::Save(testLabelsFile, testLabels, false);
   }
   else // We have no labels, so just split the dataset.
   {
-    const auto value = data::Split(data, testRatio);
-    Log::Info << "Training data contains " << get<0>(value).n_cols << " points."
-        << endl;
-    Log::Info << "Test data contains " << get<1>(value).n_cols << " points."
-        << endl;
-
-    data::Save(trainingFile, get<0>(value), false);
-    data::Save(testFile, get<1>(value), false);
+    trainSize = data::SplitInPlace(data, testRatio);
   }
+
+  const arma::mat trainData(data.memptr(), data.n_rows, trainSize, false,
+      true);
+  const arma::mat testData(data.colptr(trainSize), data.n_rows,
+      data.n_cols - trainSize, false, true);
+  Log::Info << "Training data contains " << trainData.n_cols << " points."
+      << endl;
+  Log::Info << "Test data contains " << testData.n_cols << " points." << endl;
+
+  data::Save(trainingFile, trainData, false);
+  data::Save(testFile, testData, false);
 }
@@ -15,12 +15,12 @@ using namespace mlpack::tree;
 namespace mlpack {
 namespace svd {
 
-QUIC_SVD::QUIC_SVD(const arma::mat& dataset,
-                   arma::mat& u,
-                   arma::mat& v,
-                   arma::mat& sigma,
-                   const double epsilon,
-                   const double delta) :
+inline QUIC_SVD::QUIC_SVD(const arma::mat& dataset,
+                          arma::mat& u,
+                          arma::mat& v,
+                          arma::mat& sigma,
+                          const double epsilon,
+                          const double delta) :
     dataset(dataset)
 {
   // Since columns are sample in the implementation, the matrix is transposed if
@@ -39,9 +39,9 @@ QUIC_SVD::QUIC_SVD(const arma::mat& dataset,
   ExtractSVD(u, v, sigma);
 }
 
-void QUIC_SVD::ExtractSVD(arma::mat& u,
-                          arma::mat& v,
-                          arma::mat& sigma)
+inline void QUIC_SVD::ExtractSVD(arma::mat& u,
+                                 arma::mat& v,
+                                 arma::mat& sigma)
 {
   // Calculate A * V_hat, necessary for further calculations.
   arma::mat projectedMat;
@@ -59,37 +59,46 @@ double Radical::Vasicek(vec& z) const
 }
 
 
-double Radical::DoRadical2D(const mat& matX)
+void Radical::CopyAndPerturb(mat& xNew,
+                             const mat& x,
+                             std::mt19937& generator) const
 {
-  CopyAndPerturb(perturbed, matX);
-
-  mat::fixed<2, 2> matJacobi;
+  std::normal_distribution<double> noise(0.0, noiseStdDev);
+  xNew = repmat(x, replicates, 1);
+  for (uword i = 0; i < xNew.n_elem; i++)
+    xNew[i] += noise(generator);
+}
 
+double Radical::OptimalAngle(const mat& perturbedX) const
+{
   vec values(angles);
 
-  for (size_t i = 0; i < angles; i++)
+  // Each angle is evaluated with its own candidate columns.
+  ThreadPool::ParallelFor(0, angles, [&](const size_t i)
   {
     const double theta = (i / (double) angles) * M_PI / 2.0;
     const double cosTheta = cos(theta);
     const double sinTheta = sin(theta);
 
-    matJacobi(0, 0) = cosTheta;
-    matJacobi(1, 0) = -sinTheta;
-    matJacobi(0, 1) = sinTheta;
-    matJacobi(1, 1) = cosTheta;
-
-    candidate = perturbed * matJacobi;
-    vec candidateY1 = candidate.unsafe_col(0);
-    vec candidateY2 = candidate.unsafe_col(1);
+    vec candidateY1 = cosTheta * perturbedX.col(0) - sinTheta *
+        perturbedX.col(1);
+    vec candidateY2 = sinTheta * perturbedX.col(0) + cosTheta *
+        perturbedX.col(1);
 
     values(i) = Vasicek(candidateY1) + Vasicek(candidateY2);
-  }
+  });
 
   uword indOpt;
   values.min(indOpt); // we ignore the return value; we don't care about it
   return (indOpt / (double) angles) * M_PI / 2.0;
 }
 
+double Radical::DoRadical2D(const mat& matX)
+{
+  CopyAndPerturb(perturbed, matX);
+  return OptimalAngle(perturbed);
+}
+
 
 void Radical::DoRadical(const mat& matXT, mat& matY, mat& matW)
 {
@@ -125,43 +134,61 @@ void Radical::DoRadical(const mat& matXT, mat& matY, mat& matW)
   Timer::Start("radical_do_radical");
   matW = matWhitening;
 
-  mat matYSubspace(nPoints, 2);
-
-  mat matJ = eye(nDims, nDims);
+  // The pairs of dimensions are visited in rounds of disjoint pairs (the
+  // circle method: with an even number of slots, slot 0 stays in place and
+  // the others rotate; with an odd number of dimensions, the extra slot pairs
+  // a dimension with nothing).  The rotation of a pair only changes the two
+  // columns of the pair, so the pairs of a round don't depend on each other.
+  const size_t slots = nDims + (nDims % 2);
+  std::vector<std::pair<size_t, size_t> > pairs;
+  pairs.reserve(slots / 2);
 
   for (size_t sweepNum = 0; sweepNum < sweeps; sweepNum++)
   {
     Log::Info << "RADICAL: sweep " << sweepNum << "." << std::endl;
 
-    for (size_t i = 0; i < nDims - 1; i++)
+    for (size_t round = 0; round + 1 < slots; round++)
     {
-      for (size_t j = i + 1; j < nDims; j++)
+      pairs.clear();
+      for (size_t k = 0; k < slots / 2; k++)
+      {
+        const size_t a = (k == 0) ? 0 : 1 + (round + k - 1) % (slots - 1);
+        const size_t b = 1 + (round + slots - 2 - k) % (slots - 1);
+        if (a < nDims && b < nDims)
+        {
+          pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+          Log::Debug << "RADICAL 2D on dimensions " << pairs.back().first
+              << " and " << pairs.back().second << "." << std::endl;
+        }
+      }
+
+      // Each pair perturbs its points with its own random stream, so the
+      // result doesn't depend on the number of threads.
+      const math::RandomStreams streams;
+      ThreadPool::ParallelFor(0, pairs.size(), [&](const size_t p)
       {
-        Log::Debug << "RADICAL 2D on dimensions " << i << " and " << j << "."
-            << std::endl;
+        const size_t i = pairs[p].first;
+        const size_t j = pairs[p].second;
 
+        mat matYSubspace(nPoints, 2);
         matYSubspace.col(0) = matY.col(i);
         matYSubspace.col(1) = matY.col(j);
 
-        const double thetaOpt = DoRadical2D(matYSubspace);
+        std::mt19937 generator = streams.Stream(p);
+        mat perturbedSubspace;
+        CopyAndPerturb(perturbedSubspace, matYSubspace, generator);
+        const double thetaOpt = OptimalAngle(perturbedSubspace);
 
         const double cosThetaOpt = cos(thetaOpt);
         const double sinThetaOpt = sin(thetaOpt);
 
-        // Set elements of transformation matrix.
-        matJ(i, i) = cosThetaOpt;
-        matJ(j, i) = -sinThetaOpt;
-        matJ(i, j) = sinThetaOpt;
-        matJ(j, j) = cosThetaOpt;
-
-        matY *= matJ;
-
-        // Unset elements of transformation matrix, so matJ = eye() again.
-        matJ(i, i) = 1;
-        matJ(j, i) = 0;
-        matJ(i, j) = 0;
-        matJ(j, j) = 1;
-      }
+        // Rotate the two columns; this is matY *= J, where J is the identity
+        // except for the rotation in dimensions i and j.
+        matY.col(i) = cosThetaOpt * matYSubspace.col(0) - sinThetaOpt *
+            matYSubspace.col(1);
+        matY.col(j) = sinThetaOpt * matYSubspace.col(0) + cosThetaOpt *
+            matYSubspace.col(1);
+      });
     }
   }
   Timer::Stop("radical_do_radical");
@@ -178,9 +205,21 @@ void mlpack::radical::WhitenFeatureMajorMatrix(const mat& matX,
                                                mat& matXWhitened,
                                                mat& matWhitening)
 {
+  // The points are the rows of matX, so the covariance is accumulated over
+  // transposed blocks of rows, without a centered copy of the whole matrix.
+  math::CovarianceAccumulator accumulator;
+  for (size_t begin = 0; begin < matX.n_rows;
+       begin += math::CovarianceAccumulator::ChunkSize)
+  {
+    const size_t end = std::min(begin + math::CovarianceAccumulator::ChunkSize,
+        (size_t) matX.n_rows);
+    const mat points = trans(matX.rows(begin, end - 1));
+    accumulator.Add(points);
+  }
+
   mat matU, matV;
   vec s;
-  svd(matU, s, matV, cov(matX));
+  svd(matU, s, matV, accumulator.Covariance());
   matWhitening = matU * diagmat(1 / sqrt(s)) * trans(matV);
   matXWhitened = matX * matWhitening;
 }
@@ -58,7 +58,10 @@ class Radical
           const size_t m = 0);
 
   /**
-   * Run RADICAL.
+   * Run RADICAL.  Each sweep is done in rounds of disjoint pairs of dimensions
+   * (a round-robin schedule, so that every pair is in one round of each
+   * sweep); the rotations of the pairs of a round commute, so they are found
+   * and applied in parallel.
    *
    * @param matX Input data into the algorithm - a matrix where each column is
    *    a point and each row is a dimension.
@@ -83,7 +86,8 @@ class Radical
    */
   void CopyAndPerturb(arma::mat& xNew, const arma::mat& x) const;
 
-  //! Two-dimensional version of RADICAL.
+  //! Two-dimensional version of RADICAL.  The angles are evaluated in
+  //! parallel.
   double DoRadical2D(const arma::mat& matX);
 
   //! Get the standard deviation of the additive Gaussian noise.
@@ -126,8 +130,22 @@ class Radical
 
   //! Internal matrix, held as member variable to prevent memory reallocations.
   arma::mat perturbed;
-  //! Internal matrix, held as member variable to prevent memory reallocations.
-  arma::mat candidate;
+
+  /**
+   * Make the perturbed replicates of the data points like CopyAndPerturb(),
+   * with noise drawn from the given generator, so that it can be called from
+   * several threads.
+   */
+  void CopyAndPerturb(arma::mat& xNew,
+                      const arma::mat& x,
+                      std::mt19937& generator) const;
+
+  /**
+   * Return the angle of the rotation of the given perturbed two-dimensional
+   * points which minimizes the sum of the entropies of the two dimensions.
+   * The angles are evaluated in parallel.
+   */
+  double OptimalAngle(const arma::mat& perturbedX) const;
 };
 
 void WhitenFeatureMajorMatrix(const arma::mat& matX,
@@ -0,0 +1,60 @@
+/**
+ * @file randomized_svd.cpp
+ *
+ * Implementation of the randomized SVD.
+ */
+#include "randomized_svd.hpp"
+
+using namespace mlpack;
+using namespace mlpack::svd;
+
+RandomizedSVD::RandomizedSVD(const size_t iteratedPower,
+                             const size_t oversampling) :
+    iteratedPower(iteratedPower),
+    oversampling(oversampling)
+{ /* Nothing to do. */ }
+
+void RandomizedSVD::Apply(const arma::mat& data,
+                          arma::mat& u,
+                          arma::vec& s,
+                          arma::mat& v,
+                          const size_t rank) const
+{
+  const size_t maxRank = std::min(data.n_rows, data.n_cols);
+  if (rank == 0 || rank > maxRank)
+  {
+    Log::Fatal << "RandomizedSVD::Apply(): rank (" << rank << ") must be "
+        << "between 1 and the smaller dimension of the matrix (" << maxRank
+        << ")!" << std::endl;
+  }
+
+  // The basis has a few more columns than the rank, so that the leading
+  // singular vectors are captured accurately.
+  const size_t columns = std::min(rank + oversampling, maxRank);
+
+  // Find an orthonormal basis of the range of the matrix.
+  arma::mat q, r;
+  arma::qr_econ(q, r, data * arma::randn<arma::mat>(data.n_cols, columns));
+
+  // Each power iteration multiplies by (A A^T); the basis is orthonormalized
+  // after each product, so that the small singular values are not lost to
+  // rounding.
+  for (size_t i = 0; i < iteratedPower; ++i)
+  {
+    arma::qr_econ(q, r, trans(data) * q);
+    arma::qr_econ(q, r, data * q);
+  }
+
+  // The SVD of the projection of the matrix on the basis gives the SVD of the
+  // matrix.
+  arma::mat uSmall;
+  arma::svd_econ(uSmall, s, v, trans(q) * data);
+  u = q * uSmall;
+
+  if (rank < s.n_elem)
+  {
+    u.shed_cols(rank, u.n_cols - 1);
+    s.shed_rows(rank, s.n_elem - 1);
+    v.shed_cols(rank, v.n_cols - 1);
+  }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file randomized_svd.hpp
+ *
+ * An implementation of the randomized SVD, which computes the leading singular
+ * values and vectors of a matrix.
+ */
+#ifndef MLPACK_METHODS_RANDOMIZED_SVD_RANDOMIZED_SVD_HPP
+#define MLPACK_METHODS_RANDOMIZED_SVD_RANDOMIZED_SVD_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace svd {
+
+/**
+ * The randomized SVD computes an approximation of the leading singular values
+ * and vectors of a matrix A (of size m x n) much faster than a full SVD when
+ * only a few of them are needed.  A random range finder builds an orthonormal
+ * basis Q of a few more columns than the target rank k for the range of A, by
+ * orthonormalizing A Omega, where Omega is a Gaussian random matrix; power
+ * iterations (alternating products with A^T and A, with an orthonormalization
+ * after each product) make the basis more accurate when the singular values
+ * decay slowly.  The SVD of the small matrix Q^T A then gives the SVD of A.
+ * This takes O(m n (k + p) (2 q + 2)) time, where p is the oversampling and q
+ * the number of power iterations, instead of O(m n min(m, n)).  For more
+ * information, see the following paper:
+ *
+ * @code
+ * @article{halko2011finding,
+ *   title={Finding Structure with Randomness: Probabilistic Algorithms for
+ *       Constructing Approximate Matrix Decompositions},
+ *   author={Halko, N. and Martinsson, P.G. and Tropp, J.A.},
+ *   journal={SIAM Review},
+ *   volume={53},
+ *   number={2},
+ *   pages={217--288},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * An example of how to use the interface is shown below:
+ *
+ * @code
+ * arma::mat data; // Data matrix.
+ * arma::mat u, v; // Singular vectors; data ~= u * diagmat(s) * v.t().
+ * arma::vec s; // Singular values.
+ *
+ * RandomizedSVD rSVD;
+ * rSVD.Apply(data, u, s, v, 50);
+ * @endcode
+ */
+class RandomizedSVD
+{
+ public:
+  /**
+   * Create the RandomizedSVD object.
+   *
+   * @param iteratedPower Number of power iterations.
+   * @param oversampling Number of columns of the basis beyond the target rank.
+   */
+  RandomizedSVD(const size_t iteratedPower = 2,
+                const size_t oversampling = 10);
+
+  /**
+   * Compute the leading singular values and vectors of the given matrix.  The
+   * singular values are in descending order.
+   *
+   * @param data Matrix to decompose.
+   * @param u Matrix to store the left singular vectors in.
+   * @param s Vector to store the singular values in.
+   * @param v Matrix to store the right singular vectors in.
+   * @param rank Number of singular values and vectors to compute (at most the
+   *     smaller dimension of the matrix).
+   */
+  void Apply(const arma::mat& data,
+             arma::mat& u,
+             arma::vec& s,
+             arma::mat& v,
+             const size_t rank) const;
+
+  //! Get the number of power iterations.
+  size_t IteratedPower() const { return iteratedPower; }
+  //! Modify the number of power iterations.
+  size_t& IteratedPower() { return iteratedPower; }
+
+  //! Get the oversampling.
+  size_t Oversampling() const { return oversampling; }
+  //! Modify the oversampling.
+  size_t& Oversampling() { return oversampling; }
+
+ private:
+  //! The number of power iterations.
+  size_t iteratedPower;
+  //! The number of columns of the basis beyond the target rank.
+  size_t oversampling;
+};
+
+} // namespace svd
+} // namespace mlpack
+
+#endif
@@ -12,12 +12,14 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include "range_search_stat.hpp"
+#include "range_search_rules.hpp"
 
 namespace mlpack {
 namespace range /** Range-search routines. */ {
 
 //! Forward declaration.
-class RSModel;
+template<typename MatType>
+class RSModelType;
 
 /**
  * The RangeSearch class is a template class for performing range searches.  It
@@ -28,12 +30,29 @@ class RSModel;
  * @tparam MetricType Metric to use for range search calculations.
  * @tparam MatType Type of data to use.
  * @tparam TreeType Type of tree to use; must satisfy the TreeType policy API.
+ * @tparam TraversalType The type of dual-tree traversal to use (defaults to the
+ *      tree's default traverser).
+ *
+ * Naive and single-tree searches handle blocks of query points in parallel.
+ * Dual-tree searches are parallel with a parallel traverser, such as the
+ * ParallelDualTreeTraverser of the BinarySpaceTree:
+ *
+ * @code
+ * typedef tree::KDTree<metric::EuclideanDistance, RangeSearchStat, arma::mat>
+ *     TreeType;
+ * RangeSearch<metric::EuclideanDistance, arma::mat, tree::KDTree,
+ *     TreeType::ParallelDualTreeTraverser> rs(data);
+ * @endcode
  */
 template<typename MetricType = metric::EuclideanDistance,
          typename MatType = arma::mat,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType = tree::KDTree>
+                  typename TreeMatType> class TreeType = tree::KDTree,
+         template<typename RuleType> class TraversalType =
+             TreeType<MetricType,
+                      RangeSearchStat,
+                      MatType>::template DualTreeTraverser>
 class RangeSearch
 {
  public:
@@ -85,6 +104,29 @@ class RangeSearch
               const bool singleMode = false,
               const MetricType metric = MetricType());
 
+  /**
+   * Initialize the RangeSearch object with a reference dataset that may be
+   * shared with other objects (for instance, with other search models on the
+   * same points).  The object holds on to the dataset for as long as it uses
+   * it, so the dataset is only freed when the last object sharing it is done
+   * with it.  The dataset is never modified.  Trees that rearrange the dataset
+   * (like the kd-tree) are built on a temporary permuted copy of it, which is
+   * freed once the tree is built: the search then reads the points from the
+   * shared dataset through the permutation, so the reference tree does not
+   * hold any points.
+   *
+   * @param referenceSet Shared set of reference points (must not be NULL).
+   * @param naive If true, brute force naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  RangeSearch(std::shared_ptr<const MatType> referenceSet,
+              const bool naive = false,
+              const bool singleMode = false,
+              const MetricType metric = MetricType());
+
   /**
    * Initialize the RangeSearch object with the given pre-constructed reference
    * tree (this is the tree built on the reference set, which is the set that is
@@ -153,6 +195,16 @@ class RangeSearch
    */
   void Train(MatType&& referenceSet);
 
+  /**
+   * Set the reference set to a new reference set that may be shared with other
+   * objects, and build a tree if necessary.  The object holds on to the set for
+   * as long as it uses it; see the constructor that takes a shared reference
+   * set.
+   *
+   * @param referenceSet New shared set of reference data (must not be NULL).
+   */
+  void Train(std::shared_ptr<const MatType> referenceSet);
+
   /**
    * Set the reference tree to a new reference tree.
    */
@@ -265,6 +317,86 @@ class RangeSearch
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, returning the results in compressed sparse row form: the
+   * results of all query points are stored one after another in the neighbors
+   * and distances vectors, and offsets gives where the results of each query
+   * point start.  This avoids allocating a vector for each query point, which
+   * is much cheaper when there are many query points with few results each.
+   *
+   * That is:
+   *
+   * - offsets.size() equals the number of query points plus one, offsets[0] is
+   *   0, and offsets.back() equals neighbors.size() and distances.size().
+   *
+   * - neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1] are the indices of
+   *   all the points in the reference set which have distances inside the
+   *   given range to query point i.
+   *
+   * - distances[j] is the distance corresponding to neighbors[j].
+   *
+   * - The results of each query point are not sorted in any particular order.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param offsets Object which will hold the index of the first result of
+   *      each query point, followed by the total number of results.
+   * @param neighbors Object which will hold the indices of the reference points
+   *      which fell into the given range, for all query points.
+   * @param distances Object which will hold the distances of the reference
+   *      points which fell into the given range, for all query points.
+   */
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              std::vector<size_t>& offsets,
+              std::vector<size_t>& neighbors,
+              std::vector<double>& distances);
+
+  /**
+   * Given a pre-built query tree, search for all reference points in the given
+   * range for each point in the query set, returning the results in compressed
+   * sparse row form (see the Search() overload above for the layout).  Like
+   * with the other overload that takes a query tree, query indices are not
+   * mapped back to the original order of the query set, and this will throw
+   * an invalid_argument exception if either naive or singleMode are set to
+   * true.
+   *
+   * @param queryTree Tree built on query points.
+   * @param range Range of distances in which to search.
+   * @param offsets Object which will hold the index of the first result of
+   *      each query point, followed by the total number of results.
+   * @param neighbors Object which will hold the indices of the reference points
+   *      which fell into the given range, for all query points.
+   * @param distances Object which will hold the distances of the reference
+   *      points which fell into the given range, for all query points.
+   */
+  void Search(Tree* queryTree,
+              const math::Range& range,
+              std::vector<size_t>& offsets,
+              std::vector<size_t>& neighbors,
+              std::vector<double>& distances);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set (which was passed to the constructor), returning the results in
+   * compressed sparse row form (see the Search() overload above for the
+   * layout).  This means that the query set and the reference set are the
+   * same.
+   *
+   * @param range Range of distances in which to search.
+   * @param offsets Object which will hold the index of the first result of
+   *      each query point, followed by the total number of results.
+   * @param neighbors Object which will hold the indices of the reference points
+   *      which fell into the given range, for all query points.
+   * @param distances Object which will hold the distances of the reference
+   *      points which fell into the given range, for all query points.
+   */
+  void Search(const math::Range& range,
+              std::vector<size_t>& offsets,
+              std::vector<size_t>& neighbors,
+              std::vector<double>& distances);
+
   //! Get whether single-tree search is being used.
   bool SingleMode() const { return singleMode; }
   //! Modify whether single-tree search is being used.
@@ -298,6 +430,9 @@ class RangeSearch
   //! Reference set (data should be accessed using this).  In some situations we
   //! may be the owner of this.
   const MatType* referenceSet;
+  //! The shared reference set, if we were given one; this keeps it alive for as
+  //! long as we (or our tree) refer to it.
+  std::shared_ptr<const MatType> sharedReferenceSet;
 
   //! If true, this object is responsible for deleting the trees.
   bool treeOwner;
@@ -317,8 +452,50 @@ class RangeSearch
   //! The total number of scores during the last search.
   size_t scores;
 
+  /**
+   * Convert the flat list of results of a search to compressed sparse row
+   * form, mapping the query and reference indices with the given mappings (if
+   * they are not NULL).  The results of each query point keep the order in
+   * which they were found.
+   */
+  static void FlattenResults(const RangeSearchResultBuffers& results,
+                             const size_t numQueries,
+                             const std::vector<size_t>* oldFromNewQueries,
+                             const std::vector<size_t>* oldFromNewReferences,
+                             std::vector<size_t>& offsets,
+                             std::vector<size_t>& neighbors,
+                             std::vector<double>& distances);
+
+  /**
+   * Search for the results of the query points [0, numQueries) with the given
+   * rules, naively or with a single-tree traversal for each point.  Blocks of
+   * query points are searched in parallel, each with its own copy of the
+   * rules; their numbers of base cases and scores are added to the rules.
+   */
+  template<typename RuleType>
+  void SearchQueries(RuleType& rules, const size_t numQueries);
+
+  //! The number of query points in each block of a parallel naive or
+  //! single-tree search.
+  static const size_t QueryBlockSize = 64;
+
+  //! Hold on to the given shared reference set, after a tree (if any) was
+  //! built on it; a tree that rearranges the points then lets go of its copy.
+  void ShareReferenceSet(std::shared_ptr<const MatType> referenceSet);
+
+  //! Get the column of the reference set that holds the point with each tree
+  //! index, if the tree was built on a shared set that it does not hold (and
+  //! NULL otherwise).
+  const std::vector<size_t>* ReferenceMap() const
+  {
+    return (sharedReferenceSet && !naive &&
+        tree::TreeTraits<Tree>::RearrangesDataset) ? &oldFromNewReferences :
+        NULL;
+  }
+
   //! For access to mappings when building models.
-  friend RSModel;
+  template<typename RSMatType>
+  friend class RSModelType;
 };
 
 } // namespace range
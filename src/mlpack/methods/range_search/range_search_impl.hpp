@@ -65,8 +65,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+RangeSearch<MetricType, MatType, TreeType, TraversalType>::RangeSearch(
     const MatType& referenceSetIn,
     const bool naive,
     const bool singleMode,
@@ -90,8 +91,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+RangeSearch<MetricType, MatType, TreeType, TraversalType>::RangeSearch(
     MatType&& referenceSet,
     const bool naive,
     const bool singleMode,
@@ -111,12 +113,30 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
   // Nothing to do.
 }
 
+// Construct the object on a shared reference set.
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+RangeSearch<MetricType, MatType, TreeType, TraversalType>::RangeSearch(
+    std::shared_ptr<const MatType> referenceSetIn,
+    const bool naive,
+    const bool singleMode,
+    const MetricType metric) :
+    RangeSearch(*referenceSetIn, naive, singleMode, metric)
+{
+  ShareReferenceSet(std::move(referenceSetIn));
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+RangeSearch<MetricType, MatType, TreeType, TraversalType>::RangeSearch(
     Tree* referenceTree,
     const bool singleMode,
     const MetricType metric) :
@@ -137,8 +157,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+RangeSearch<MetricType, MatType, TreeType, TraversalType>::RangeSearch(
     const bool naive,
     const bool singleMode,
     const MetricType metric) :
@@ -165,8 +186,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-RangeSearch<MetricType, MatType, TreeType>::~RangeSearch()
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+RangeSearch<MetricType, MatType, TreeType, TraversalType>::~RangeSearch()
 {
   if (treeOwner && referenceTree)
     delete referenceTree;
@@ -178,8 +200,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-void RangeSearch<MetricType, MatType, TreeType>::Train(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Train(
     const MatType& referenceSet)
 {
   // Clean up the old tree, if we built one.
@@ -207,14 +230,18 @@ void RangeSearch<MetricType, MatType, TreeType>::Train(
   else
     this->referenceSet = &referenceSet;
   setOwner = false;
+
+  // Let go of the old shared set, if we had one.
+  sharedReferenceSet.reset();
 }
 
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-void RangeSearch<MetricType, MatType, TreeType>::Train(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Train(
     MatType&& referenceSet)
 {
   // Clean up the old tree, if we built one.
@@ -247,14 +274,55 @@ void RangeSearch<MetricType, MatType, TreeType>::Train(
     this->referenceSet = new MatType(std::move(referenceSet));
     setOwner = true;
   }
+
+  sharedReferenceSet.reset();
 }
 
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-void RangeSearch<MetricType, MatType, TreeType>::Train(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Train(
+    std::shared_ptr<const MatType> referenceSetIn)
+{
+  Train(*referenceSetIn);
+  ShareReferenceSet(std::move(referenceSetIn));
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::
+    ShareReferenceSet(std::shared_ptr<const MatType> referenceSetIn)
+{
+  // A tree that rearranges the points was built on a permuted copy of the
+  // shared set.  The copy is only needed to build the tree, so it is freed,
+  // and the points are read from the shared set through oldFromNewReferences
+  // instead.  (Only trees that own their dataset rearrange it.)
+  if (!naive && tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    const_cast<MatType&>(referenceTree->Dataset()).reset();
+    referenceSet = referenceSetIn.get();
+  }
+
+  // Hold on to the shared set if we (or a tree that doesn't rearrange the
+  // points) refer to it.
+  if (referenceSet == referenceSetIn.get())
+    sharedReferenceSet = std::move(referenceSetIn);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Train(
   Tree* referenceTree)
 {
   if (naive)
@@ -270,14 +338,16 @@ void RangeSearch<MetricType, MatType, TreeType>::Train(
   this->referenceSet = &referenceTree->Dataset();
   treeOwner = false;
   setOwner = false;
+  sharedReferenceSet.reset();
 }
 
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-void RangeSearch<MetricType, MatType, TreeType>::Search(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Search(
     const MatType& querySet,
     const math::Range& range,
     std::vector<std::vector<size_t>>& neighbors,
@@ -299,26 +369,18 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
 
   // If we have built the trees ourselves, then we will have to map all the
   // indices back to their original indices when this computation is finished.
-  // To avoid extra copies, we will store the unmapped neighbors and distances
-  // in a separate object.
+  // If the query indices must be mapped, we will store the unmapped results in
+  // a separate object, whose vectors are then moved into place; reference
+  // indices are mapped in place.
   std::vector<std::vector<size_t>>* neighborPtr = &neighbors;
   std::vector<std::vector<double>>* distancePtr = &distances;
 
-  // Mapping is only necessary if the tree rearranges points.
-  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  // Query indices only need to be mapped if the tree rearranges points and we
+  // are building the query tree ourselves.
+  if (tree::TreeTraits<Tree>::RearrangesDataset && !singleMode && !naive)
   {
-    // Query indices only need to be mapped if we are building the query tree
-    // ourselves.
-    if (!singleMode && !naive)
-    {
-      distancePtr = new std::vector<std::vector<double>>;
-      neighborPtr = new std::vector<std::vector<size_t>>;
-    }
-
-    // Reference indices only need to be mapped if we built the reference tree
-    // ourselves.
-    if (treeOwner)
-      neighborPtr = new std::vector<std::vector<size_t>>;
+    distancePtr = new std::vector<std::vector<double>>;
+    neighborPtr = new std::vector<std::vector<size_t>>;
   }
 
   // Resize each vector.
@@ -336,26 +398,19 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
 
   if (naive)
   {
+    // The naive brute-force solution.
     RuleType rules(*referenceSet, querySet, range, *neighborPtr, *distancePtr,
         metric);
-
-    // The naive brute-force solution.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+    SearchQueries(rules, querySet.n_cols);
 
     baseCases += (querySet.n_cols * referenceSet->n_cols);
   }
   else if (singleMode)
   {
-    // Create the traverser.
+    // Traverse the reference tree for each point.
     RuleType rules(*referenceSet, querySet, range, *neighborPtr, *distancePtr,
-        metric);
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+        metric, false, ReferenceMap());
+    SearchQueries(rules, querySet.n_cols);
 
     baseCases += rules.BaseCases();
     scores += rules.Scores();
@@ -372,8 +427,8 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
 
     // Create the traverser.
     RuleType rules(*referenceSet, queryTree->Dataset(), range, *neighborPtr,
-        *distancePtr, metric);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+        *distancePtr, metric, false, ReferenceMap());
+    TraversalType<RuleType> traverser(rules);
 
     traverser.Traverse(*queryTree, *referenceTree);
 
@@ -397,17 +452,17 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
       distances.clear();
       distances.resize(querySet.n_cols);
 
-      for (size_t i = 0; i < distances.size(); i++)
+      // The results of each query are moved, not copied, and the neighbors
+      // are mapped in place.  The query map is a permutation, so each result
+      // is written by one thread only.
+      #pragma omp parallel for schedule(dynamic, 256)
+      for (omp_size_t i = 0; i < (omp_size_t) distances.size(); i++)
       {
-        // Map distances (copy a column).
         const size_t queryMapping = oldFromNewQueries[i];
-        distances[queryMapping] = (*distancePtr)[i];
-
-        // Copy each neighbor individually, because we need to map it.
-        neighbors[queryMapping].resize(distances[queryMapping].size());
-        for (size_t j = 0; j < distances[queryMapping].size(); j++)
-          neighbors[queryMapping][j] =
-              oldFromNewReferences[(*neighborPtr)[i][j]];
+        distances[queryMapping] = std::move((*distancePtr)[i]);
+        neighbors[queryMapping] = std::move((*neighborPtr)[i]);
+        for (size_t& neighbor : neighbors[queryMapping])
+          neighbor = oldFromNewReferences[neighbor];
       }
 
       // Finished with temporary objects.
@@ -424,10 +479,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
 
       for (size_t i = 0; i < distances.size(); ++i)
       {
-        // Map distances and neighbors (copy a column).
+        // Map distances and neighbors (move a column).
         const size_t queryMapping = oldFromNewQueries[i];
-        distances[queryMapping] = (*distancePtr)[i];
-        neighbors[queryMapping] = (*neighborPtr)[i];
+        distances[queryMapping] = std::move((*distancePtr)[i]);
+        neighbors[queryMapping] = std::move((*neighborPtr)[i]);
       }
 
       // Finished with temporary objects.
@@ -436,19 +491,11 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
     }
     else if (treeOwner)
     {
-      // We must map reference indices only.
-      neighbors.clear();
-      neighbors.resize(querySet.n_cols);
-
-      for (size_t i = 0; i < neighbors.size(); i++)
-      {
-        neighbors[i].resize((*neighborPtr)[i].size());
-        for (size_t j = 0; j < neighbors[i].size(); j++)
-          neighbors[i][j] = oldFromNewReferences[(*neighborPtr)[i][j]];
-      }
-
-      // Finished with temporary object.
-      delete neighborPtr;
+      // We must map reference indices only; this is done in place.
+      #pragma omp parallel for schedule(dynamic, 256)
+      for (omp_size_t i = 0; i < (omp_size_t) neighbors.size(); i++)
+        for (size_t& neighbor : neighbors[i])
+          neighbor = oldFromNewReferences[neighbor];
     }
   }
 }
@@ -457,8 +504,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-void RangeSearch<MetricType, MatType, TreeType>::Search(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Search(
     Tree* queryTree,
     const math::Range& range,
     std::vector<std::vector<size_t>>& neighbors,
@@ -474,25 +522,20 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
     throw std::invalid_argument("cannot call RangeSearch::Search() with a "
         "query tree when naive or singleMode are set to true");
 
-  // We won't need to map query indices, but will we need to map distances?
-  std::vector<std::vector<size_t>>* neighborPtr = &neighbors;
-
-  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
-    neighborPtr = new std::vector<std::vector<size_t>>;
-
-  // Resize each vector.
-  neighborPtr->clear(); // Just in case there was anything in it.
-  neighborPtr->resize(querySet.n_cols);
+  // We won't need to map query indices, but the reference indices may need to
+  // be mapped (in place) at the end.
+  neighbors.clear(); // Just in case there was anything in it.
+  neighbors.resize(querySet.n_cols);
   distances.clear();
   distances.resize(querySet.n_cols);
 
   // Create the helper object for the traversal.
   typedef RangeSearchRules<MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, queryTree->Dataset(), range, *neighborPtr,
-      distances, metric);
+  RuleType rules(*referenceSet, queryTree->Dataset(), range, neighbors,
+      distances, metric, false, ReferenceMap());
 
   // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+  TraversalType<RuleType> traverser(rules);
 
   traverser.Traverse(*queryTree, *referenceTree);
 
@@ -505,18 +548,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
   {
     // We must map reference indices only.
-    neighbors.clear();
-    neighbors.resize(querySet.n_cols);
-
-    for (size_t i = 0; i < neighbors.size(); i++)
-    {
-      neighbors[i].resize((*neighborPtr)[i].size());
-      for (size_t j = 0; j < neighbors[i].size(); j++)
-        neighbors[i][j] = oldFromNewReferences[(*neighborPtr)[i][j]];
-    }
-
-    // Finished with temporary object.
-    delete neighborPtr;
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (omp_size_t i = 0; i < (omp_size_t) neighbors.size(); i++)
+      for (size_t& neighbor : neighbors[i])
+        neighbor = oldFromNewReferences[neighbor];
   }
 }
 
@@ -524,8 +559,9 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-void RangeSearch<MetricType, MatType, TreeType>::Search(
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Search(
     const math::Range& range,
     std::vector<std::vector<size_t>>& neighbors,
     std::vector<std::vector<double>>& distances)
@@ -552,26 +588,21 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   // Create the helper object for the traversal.
   typedef RangeSearchRules<MetricType, Tree> RuleType;
   RuleType rules(*referenceSet, *referenceSet, range, *neighborPtr,
-      *distancePtr, metric, true /* don't return the query in the results */);
+      *distancePtr, metric, true /* don't return the query in the results */,
+      ReferenceMap());
 
   if (naive)
   {
     // The naive brute-force solution.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+    SearchQueries(rules, referenceSet->n_cols);
 
     baseCases = (referenceSet->n_cols * referenceSet->n_cols);
     scores = 0;
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    // Traverse the reference tree for each point.
+    SearchQueries(rules, referenceSet->n_cols);
 
     baseCases = rules.BaseCases();
     scores = rules.Scores();
@@ -579,7 +610,7 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   else // Dual-tree recursion.
   {
     // Create the traverser.
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    TraversalType<RuleType> traverser(rules);
 
     traverser.Traverse(*referenceTree, *referenceTree);
 
@@ -597,18 +628,16 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
     distances.clear();
     distances.resize(referenceSet->n_cols);
 
-    for (size_t i = 0; i < distances.size(); i++)
+    // The results of each point are moved, not copied, and the neighbors are
+    // mapped in place.
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (omp_size_t i = 0; i < (omp_size_t) distances.size(); i++)
     {
-      // Map distances (copy a column).
       const size_t refMapping = oldFromNewReferences[i];
-      distances[refMapping] = (*distancePtr)[i];
-
-      // Copy each neighbor individually, because we need to map it.
-      neighbors[refMapping].resize(distances[refMapping].size());
-      for (size_t j = 0; j < distances[refMapping].size(); j++)
-      {
-        neighbors[refMapping][j] = oldFromNewReferences[(*neighborPtr)[i][j]];
-      }
+      distances[refMapping] = std::move((*distancePtr)[i]);
+      neighbors[refMapping] = std::move((*neighborPtr)[i]);
+      for (size_t& neighbor : neighbors[refMapping])
+        neighbor = oldFromNewReferences[neighbor];
     }
 
     // Finished with temporary objects.
@@ -621,9 +650,306 @@ template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    std::vector<size_t>& offsets,
+    std::vector<size_t>& neighbors,
+    std::vector<double>& distances)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // This will hold mappings for query points, if necessary.
+  std::vector<size_t> oldFromNewQueries;
+
+  // All results are collected here, in the order they are found (in one
+  // buffer for each copy of the rules), and then grouped by query point.
+  RangeSearchResultBuffers results;
+
+  // Create the helper object for the traversal.
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+
+  // Reset counts.
+  baseCases = 0;
+  scores = 0;
+
+  if (naive)
+  {
+    // The naive brute-force solution.
+    RuleType rules(*referenceSet, querySet, range, results, metric);
+    SearchQueries(rules, querySet.n_cols);
+
+    baseCases += (querySet.n_cols * referenceSet->n_cols);
+  }
+  else if (singleMode)
+  {
+    // Traverse the reference tree for each point.
+    RuleType rules(*referenceSet, querySet, range, results, metric, false,
+        ReferenceMap());
+    SearchQueries(rules, querySet.n_cols);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(querySet),
+        oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    // Create the traverser.
+    RuleType rules(*referenceSet, queryTree->Dataset(), range, results,
+        metric, false, ReferenceMap());
+    TraversalType<RuleType> traverser(rules);
+
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+
+    // Clean up tree memory.
+    delete queryTree;
+  }
+
+  // Query indices only need to be mapped if we built the query tree, and
+  // reference indices only need to be mapped if we built the reference tree.
+  const bool rearranges = tree::TreeTraits<Tree>::RearrangesDataset;
+  FlattenResults(results, querySet.n_cols,
+      (rearranges && !singleMode && !naive) ? &oldFromNewQueries : NULL,
+      (rearranges && treeOwner) ? &oldFromNewReferences : NULL,
+      offsets, neighbors, distances);
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Search(
+    Tree* queryTree,
+    const math::Range& range,
+    std::vector<size_t>& offsets,
+    std::vector<size_t>& neighbors,
+    std::vector<double>& distances)
+{
+  // Make sure we are in dual-tree mode.
+  if (singleMode || naive)
+    throw std::invalid_argument("cannot call RangeSearch::Search() with a "
+        "query tree when naive or singleMode are set to true");
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // All results are collected here, in the order they are found (in one
+  // buffer for each copy of the rules), and then grouped by query point.
+  RangeSearchResultBuffers results;
+
+  // Create the helper object for the traversal.
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  RuleType rules(*referenceSet, queryTree->Dataset(), range, results, metric,
+      false, ReferenceMap());
+
+  // Create the traverser.
+  TraversalType<RuleType> traverser(rules);
+
+  traverser.Traverse(*queryTree, *referenceTree);
+
+  baseCases = rules.BaseCases();
+  scores = rules.Scores();
+
+  // We won't need to map query indices, but we may need to map reference
+  // indices.
+  FlattenResults(results, queryTree->Dataset().n_cols, NULL,
+      (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset) ?
+      &oldFromNewReferences : NULL, offsets, neighbors, distances);
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Search(
+    const math::Range& range,
+    std::vector<size_t>& offsets,
+    std::vector<size_t>& neighbors,
+    std::vector<double>& distances)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  // All results are collected here, in the order they are found (in one
+  // buffer for each copy of the rules), and then grouped by query point.
+  RangeSearchResultBuffers results;
+
+  // Create the helper object for the traversal.
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  RuleType rules(*referenceSet, *referenceSet, range, results, metric,
+      true /* don't return the query in the results */, ReferenceMap());
+
+  if (naive)
+  {
+    // The naive brute-force solution.
+    SearchQueries(rules, referenceSet->n_cols);
+
+    baseCases = (referenceSet->n_cols * referenceSet->n_cols);
+    scores = 0;
+  }
+  else if (singleMode)
+  {
+    // Traverse the reference tree for each point.
+    SearchQueries(rules, referenceSet->n_cols);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+  }
+  else // Dual-tree recursion.
+  {
+    // Create the traverser.
+    TraversalType<RuleType> traverser(rules);
+
+    traverser.Traverse(*referenceTree, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+  }
+
+  // The query and reference indices both need to be mapped if we built the
+  // reference tree.
+  const bool mapIndices = (tree::TreeTraits<Tree>::RearrangesDataset &&
+      treeOwner);
+  FlattenResults(results, referenceSet->n_cols,
+      mapIndices ? &oldFromNewReferences : NULL,
+      mapIndices ? &oldFromNewReferences : NULL,
+      offsets, neighbors, distances);
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::
+FlattenResults(const RangeSearchResultBuffers& results,
+               const size_t numQueries,
+               const std::vector<size_t>* oldFromNewQueries,
+               const std::vector<size_t>* oldFromNewReferences,
+               std::vector<size_t>& offsets,
+               std::vector<size_t>& neighbors,
+               std::vector<double>& distances)
+{
+  // Count the results of each query point, then turn the counts into offsets.
+  offsets.assign(numQueries + 1, 0);
+  for (const std::vector<RangeSearchResult>& buffer : results.Buffers())
+  {
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+      const size_t query = oldFromNewQueries ?
+          (*oldFromNewQueries)[buffer[i].query] : buffer[i].query;
+      ++offsets[query + 1];
+    }
+  }
+
+  for (size_t i = 0; i < numQueries; ++i)
+    offsets[i + 1] += offsets[i];
+
+  // Now put each result in the next free slot of its query point.  All the
+  // results of a query point are in the same buffer.
+  std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+  neighbors.resize(offsets.back());
+  distances.resize(offsets.back());
+  for (const std::vector<RangeSearchResult>& buffer : results.Buffers())
+  {
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+      const size_t query = oldFromNewQueries ?
+          (*oldFromNewQueries)[buffer[i].query] : buffer[i].query;
+      const size_t position = next[query]++;
+      neighbors[position] = oldFromNewReferences ?
+          (*oldFromNewReferences)[buffer[i].reference] : buffer[i].reference;
+      distances[position] = buffer[i].distance;
+    }
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+template<typename RuleType>
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::
+SearchQueries(RuleType& rules, const size_t numQueries)
+{
+  // Each block of query points is searched with its own copy of the rules,
+  // which writes only to the results of its own query points (or to its own
+  // buffer).
+  const size_t blocks = (numQueries + QueryBlockSize - 1) / QueryBlockSize;
+  std::vector<size_t> blockBaseCases(blocks), blockScores(blocks);
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    RuleType blockRules(rules);
+    blockRules.BaseCases() = 0;
+    blockRules.Scores() = 0;
+
+    const size_t begin = b * QueryBlockSize;
+    const size_t end = std::min(numQueries, begin + QueryBlockSize);
+    if (naive)
+    {
+      for (size_t i = begin; i < end; ++i)
+        for (size_t j = 0; j < referenceSet->n_cols; ++j)
+          blockRules.BaseCase(i, j);
+    }
+    else
+    {
+      typename Tree::template SingleTreeTraverser<RuleType> traverser(
+          blockRules);
+      for (size_t i = begin; i < end; ++i)
+        traverser.Traverse(i, *referenceTree);
+    }
+
+    blockBaseCases[b] = blockRules.BaseCases();
+    blockScores[b] = blockRules.Scores();
+  });
+
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    rules.BaseCases() += blockBaseCases[b];
+    rules.Scores() += blockScores[b];
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
 template<typename Archive>
-void RangeSearch<MetricType, MatType, TreeType>::Serialize(
+void RangeSearch<MetricType, MatType, TreeType, TraversalType>::Serialize(
     Archive& ar,
     const unsigned int /* version */)
 {
@@ -678,9 +1004,24 @@ void RangeSearch<MetricType, MatType, TreeType>::Serialize(
       treeOwner = true;
     }
 
+    // A tree built on a shared set does not hold the points; give it a
+    // permuted copy while it is saved, so that the archive can be loaded on
+    // its own.
+    const bool mapped = Archive::is_saving::value && ReferenceMap();
+    if (mapped)
+    {
+      MatType& treeSet = const_cast<MatType&>(referenceTree->Dataset());
+      treeSet.set_size(referenceSet->n_rows, referenceSet->n_cols);
+      for (size_t i = 0; i < oldFromNewReferences.size(); ++i)
+        treeSet.col(i) = referenceSet->col(oldFromNewReferences[i]);
+    }
+
     ar & CreateNVP(referenceTree, "referenceTree");
     ar & CreateNVP(oldFromNewReferences, "oldFromNewReferences");
 
+    if (mapped)
+      const_cast<MatType&>(referenceTree->Dataset()).reset();
+
     // If we are loading, set the dataset accordingly and clean up memory if
     // necessary.
     if (Archive::is_loading::value)
@@ -693,6 +1034,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Serialize(
       setOwner = false;
     }
   }
+
+  // A loaded model owns its data, so it does not share a reference set.
+  if (Archive::is_loading::value)
+    sharedReferenceSet.reset();
 }
 
 } // namespace range
@@ -8,7 +8,9 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/data/load_async.hpp>
 
 #include "range_search.hpp"
 #include "rs_model.hpp"
@@ -47,7 +49,16 @@ PROGRAM_INFO("Range Search",
     " resultant CSV-like files may not be loadable by many programs.  However, "
     "at this time a better way to store this non-square result is not known.  "
     "As a result, any output files will be written as CSVs in this manner, "
-    "regardless of the given extension.");
+    "regardless of the given extension."
+    "\n\n"
+    "To search with the Mahalanobis distance d(x, y) = sqrt((x - y)^T Q "
+    "(x - y)) instead of the Euclidean distance, give the matrix Q in "
+    "--mahalanobis_file.  The points are transformed once with the Cholesky "
+    "factor of Q before the trees are built, so all tree types may be used, "
+    "and the range and the distances returned are Mahalanobis distances.  (For "
+    "the output matrix A of mlpack_nca, Q is A^T A.)  A model saved with a "
+    "Mahalanobis matrix keeps it, so the option is not needed again with "
+    "--input_model_file.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
@@ -74,85 +85,43 @@ PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'cover', 'r', 'r-star', "
 PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_STRING("mahalanobis_file", "File containing the matrix Q of a "
+    "Mahalanobis distance to search with (optional).", "Q", "");
 PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
+PARAM_FLAG("float", "If set, the data is loaded and processed in single "
+    "precision, which halves the memory used.  A model saved with --float must "
+    "also be loaded with --float.", "f");
 
 typedef RangeSearch<> RSType;
 typedef CoverTree<EuclideanDistance, RangeSearchStat> CoverTreeType;
 typedef RangeSearch<EuclideanDistance, arma::mat, StandardCoverTree>
     RSCoverType;
 
-int main(int argc, char *argv[])
+// Build or load the model, run the search, and save the results, using the
+// given matrix type for the data.
+template<typename MatType>
+void RunRangeSearch(const size_t leafSize)
 {
-  // Give CLI the command line parameters the user passed in.
-  CLI::ParseCommandLine(argc, argv);
-
-  if (CLI::GetParam<int>("seed") != 0)
-    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
-  else
-    math::RandomSeed((size_t) std::time(NULL));
-
-  // A user cannot specify both reference data and a model.
-  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
-    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
-        << " may be specified!" << endl;
-
-  // A user must specify one of them...
-  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
-    Log::Fatal << "No model specified (--input_model_file) and no reference "
-        << "data specified (--reference_file)!  One must be provided." << endl;
-
-  if (CLI::HasParam("input_model_file"))
-  {
-    // Notify the user of parameters that will be ignored.
-    if (CLI::HasParam("tree_type"))
-      Log::Warn << "--tree_type (-t) will be ignored because --input_model_file"
-          << " is specified." << endl;
-    if (CLI::HasParam("leaf_size"))
-      Log::Warn << "--leaf_size (-l) will be ignored because --input_model_file"
-          << " is specified." << endl;
-    if (CLI::HasParam("random_basis"))
-      Log::Warn << "--random_basis (-R) will be ignored because "
-          << "--input_model_file is specified." << endl;
-    if (CLI::HasParam("naive"))
-      Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
-          << "specified." << endl;
-  }
-
-  // The user must give something to do...
-  if (!CLI::HasParam("min") && !CLI::HasParam("max") &&
-      !CLI::HasParam("output_model_file"))
-    Log::Warn << "Neither --min, --max, nor --output_model_file are specified, "
-        << "so no results from this program will be saved!" << endl;
-
-  // If the user specifies a range but not output files, they should be warned.
-  if ((CLI::HasParam("min") || CLI::HasParam("max")) &&
-      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
-    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
-        << "so the range search results will not be saved!" << endl;
-
-  // If the user specifies output files but no range, they should be warned.
-  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
-      !(CLI::HasParam("min") || CLI::HasParam("max")))
-    Log::Warn << "An output file for range search is given (--neighbors_file "
-        << "or --distances_file), but range search is not being performed "
-        << "because neither --min nor --max are specified!  No results will be "
-        << "saved." << endl;
-
-  // Sanity check on leaf size.
-  int lsInt = CLI::GetParam<int>("leaf_size");
-  if (lsInt < 1)
-    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater than 0."
-        << endl;
+  typedef RSModelType<MatType> ModelType;
 
   // We either have to load the reference data, or we have to load the model.
-  RSModel rs;
+  ModelType rs;
   const bool naive = CLI::HasParam("naive");
   const bool singleMode = CLI::HasParam("single_mode");
+
+  // Load the query set on a background thread, while the reference set is
+  // loaded and its tree is built (or the model is loaded).
+  const string queryFile = CLI::GetParam<string>("query_file");
+  MatType queryData;
+  std::future<bool> queryLoad;
+  if ((CLI::HasParam("min") || CLI::HasParam("max")) && queryFile != "")
+    queryLoad = data::LoadAsync(queryFile, queryData, true);
+
   if (CLI::HasParam("reference_file"))
   {
     // Get all the parameters.
@@ -160,19 +129,19 @@ int main(int argc, char *argv[])
     const string treeType = CLI::GetParam<string>("tree_type");
     const bool randomBasis = CLI::HasParam("random_basis");
 
-    RSModel::TreeTypes tree = RSModel::KD_TREE;
+    typename ModelType::TreeTypes tree = ModelType::KD_TREE;
     if (treeType == "kd")
-      tree = RSModel::KD_TREE;
+      tree = ModelType::KD_TREE;
     else if (treeType == "cover")
-      tree = RSModel::COVER_TREE;
+      tree = ModelType::COVER_TREE;
     else if (treeType == "r")
-      tree = RSModel::R_TREE;
+      tree = ModelType::R_TREE;
     else if (treeType == "r-star")
-      tree = RSModel::R_STAR_TREE;
+      tree = ModelType::R_STAR_TREE;
     else if (treeType == "ball")
-      tree = RSModel::BALL_TREE;
+      tree = ModelType::BALL_TREE;
     else if (treeType == "x")
-      tree = RSModel::X_TREE;
+      tree = ModelType::X_TREE;
     else
       Log::Fatal << "Unknown tree type '" << treeType << "; valid choices are "
           << "'kd', 'cover', 'r', 'r-star', 'x' and 'ball'." << endl;
@@ -180,13 +149,31 @@ int main(int argc, char *argv[])
     rs.TreeType() = tree;
     rs.RandomBasis() = randomBasis;
 
-    arma::mat referenceSet;
+    MatType referenceSet;
     data::Load(referenceFile, referenceSet, true);
 
     Log::Info << "Loaded reference data from '" << referenceFile << "' ("
         << referenceSet.n_rows << "x" << referenceSet.n_cols << ")." << endl;
 
-    const size_t leafSize = size_t(lsInt);
+    // Search with a Mahalanobis distance by whitening the points first.
+    if (CLI::HasParam("mahalanobis_file"))
+    {
+      const string mahalanobisFile = CLI::GetParam<string>("mahalanobis_file");
+      arma::mat covariance;
+      data::Load(mahalanobisFile, covariance, true);
+      if (covariance.n_rows != referenceSet.n_rows ||
+          covariance.n_cols != referenceSet.n_rows)
+      {
+        Log::Fatal << "The Mahalanobis matrix in '" << mahalanobisFile << "' ("
+            << covariance.n_rows << "x" << covariance.n_cols << ") must be "
+            << referenceSet.n_rows << "x" << referenceSet.n_rows << "." << endl;
+      }
+
+      arma::mat transformation;
+      MahalanobisDistance<> mahalanobis(covariance);
+      mahalanobis.Whitening(transformation);
+      rs.Transformation() = arma::conv_to<MatType>::from(transformation);
+    }
 
     rs.BuildModel(std::move(referenceSet), leafSize, naive, singleMode);
   }
@@ -203,23 +190,21 @@ int main(int argc, char *argv[])
     // Adjust singleMode and naive if necessary.
     rs.SingleMode() = CLI::HasParam("single_mode");
     rs.Naive() = CLI::HasParam("naive");
-    rs.LeafSize() = size_t(lsInt);
+    rs.LeafSize() = leafSize;
   }
 
   // Perform search, if desired.
   if (CLI::HasParam("min") || CLI::HasParam("max"))
   {
-    const string queryFile = CLI::GetParam<string>("query_file");
     const double min = CLI::GetParam<double>("min");
     const double max = CLI::HasParam("max") ? CLI::GetParam<double>("max") :
         DBL_MAX;
 
     math::Range r(min, max);
 
-    arma::mat queryData;
-    if (queryFile != "")
+    if (queryLoad.valid())
     {
-      data::Load(queryFile, queryData, true);
+      queryLoad.get(); // Throws if the load failed.
       Log::Info << "Loaded query data from '" << queryFile << "' ("
           << queryData.n_rows << "x" << queryData.n_cols << ")." << endl;
     }
@@ -228,14 +213,16 @@ int main(int argc, char *argv[])
     if (singleMode && naive)
       Log::Warn << "--single_mode ignored because --naive is present." << endl;
 
-    // Now run the search.
-    vector<vector<size_t>> neighbors;
-    vector<vector<double>> distances;
+    // Now run the search.  The results of all query points are stored in
+    // compressed sparse row form, to avoid a vector for each query point.
+    vector<size_t> offsets;
+    vector<size_t> neighbors;
+    vector<double> distances;
 
     if (CLI::HasParam("query_file"))
-      rs.Search(std::move(queryData), r, neighbors, distances);
+      rs.Search(std::move(queryData), r, offsets, neighbors, distances);
     else
-      rs.Search(r, neighbors, distances);
+      rs.Search(r, offsets, neighbors, distances);
 
     Log::Info << "Search complete." << endl;
 
@@ -252,15 +239,16 @@ int main(int argc, char *argv[])
       else
       {
         // Loop over each point.
-        for (size_t i = 0; i < distances.size(); ++i)
+        for (size_t i = 0; i + 1 < offsets.size(); ++i)
         {
           // Store the distances of each point.  We may have 0 points to store,
           // so we must account for that possibility.
-          for (size_t j = 0; j + 1 < distances[i].size(); ++j)
-            distancesStr << distances[i][j] << ", ";
-
-          if (distances[i].size() > 0)
-            distancesStr << distances[i][distances[i].size() - 1];
+          for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+          {
+            if (j > offsets[i])
+              distancesStr << ", ";
+            distancesStr << distances[j];
+          }
 
           distancesStr << endl;
         }
@@ -281,15 +269,16 @@ int main(int argc, char *argv[])
       else
       {
         // Loop over each point.
-        for (size_t i = 0; i < neighbors.size(); ++i)
+        for (size_t i = 0; i + 1 < offsets.size(); ++i)
         {
           // Store the neighbors of each point.  We may have 0 points to store,
           // so we must account for that possibility.
-          for (size_t j = 0; j + 1 < neighbors[i].size(); ++j)
-            neighborsStr << neighbors[i][j] << ", ";
-
-          if (neighbors[i].size() > 0)
-            neighborsStr << neighbors[i][neighbors[i].size() - 1];
+          for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+          {
+            if (j > offsets[i])
+              neighborsStr << ", ";
+            neighborsStr << neighbors[j];
+          }
 
           neighborsStr << endl;
         }
@@ -306,3 +295,73 @@ int main(int argc, char *argv[])
     data::Save(outputModelFile, "rs_model", rs);
   }
 }
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) std::time(NULL));
+
+  // A user cannot specify both reference data and a model.
+  if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
+    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
+        << " may be specified!" << endl;
+
+  // A user must specify one of them...
+  if (!CLI::HasParam("reference_file") && !CLI::HasParam("input_model_file"))
+    Log::Fatal << "No model specified (--input_model_file) and no reference "
+        << "data specified (--reference_file)!  One must be provided." << endl;
+
+  if (CLI::HasParam("input_model_file"))
+  {
+    // Notify the user of parameters that will be ignored.
+    if (CLI::HasParam("tree_type"))
+      Log::Warn << "--tree_type (-t) will be ignored because --input_model_file"
+          << " is specified." << endl;
+    if (CLI::HasParam("leaf_size"))
+      Log::Warn << "--leaf_size (-l) will be ignored because --input_model_file"
+          << " is specified." << endl;
+    if (CLI::HasParam("random_basis"))
+      Log::Warn << "--random_basis (-R) will be ignored because "
+          << "--input_model_file is specified." << endl;
+    if (CLI::HasParam("naive"))
+      Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
+          << "specified." << endl;
+  }
+
+  // The user must give something to do...
+  if (!CLI::HasParam("min") && !CLI::HasParam("max") &&
+      !CLI::HasParam("output_model_file"))
+    Log::Warn << "Neither --min, --max, nor --output_model_file are specified, "
+        << "so no results from this program will be saved!" << endl;
+
+  // If the user specifies a range but not output files, they should be warned.
+  if ((CLI::HasParam("min") || CLI::HasParam("max")) &&
+      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
+    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
+        << "so the range search results will not be saved!" << endl;
+
+  // If the user specifies output files but no range, they should be warned.
+  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
+      !(CLI::HasParam("min") || CLI::HasParam("max")))
+    Log::Warn << "An output file for range search is given (--neighbors_file "
+        << "or --distances_file), but range search is not being performed "
+        << "because neither --min nor --max are specified!  No results will be "
+        << "saved." << endl;
+
+  // Sanity check on leaf size.
+  int lsInt = CLI::GetParam<int>("leaf_size");
+  if (lsInt < 1)
+    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater than 0."
+        << endl;
+
+  // Do the actual work in single or double precision.
+  if (CLI::HasParam("float"))
+    RunRangeSearch<arma::fmat>(size_t(lsInt));
+  else
+    RunRangeSearch<arma::mat>(size_t(lsInt));
+}
@@ -9,9 +9,69 @@
 
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 namespace mlpack {
 namespace range {
 
+/**
+ * A single result of range search: a reference point in the range of a query
+ * point, and the distance between them.  This is used to collect all the
+ * results of a search in one flat array, instead of in a vector for each query
+ * point.
+ */
+struct RangeSearchResult
+{
+  //! Index of the query point.
+  size_t query;
+  //! Index of the reference point.
+  size_t reference;
+  //! Distance between the query point and the reference point.
+  double distance;
+};
+
+/**
+ * The buffers that RangeSearchRules append their flat results to.  The rules
+ * given to a search get one buffer, and each copy of them (such as the copy
+ * made for each task of a parallel traverser, or for each block of query
+ * points) gets a new one, so copies used by different threads never append to
+ * the same vector.  All the results of a query point are found by one copy of
+ * the rules, so they are in one buffer, in the order they were found.
+ */
+class RangeSearchResultBuffers
+{
+ public:
+  //! Add a new empty buffer, and return it.
+  std::vector<RangeSearchResult>& Add()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back(std::vector<RangeSearchResult>());
+    return buffers.back();
+  }
+
+  //! Get the buffers.
+  const std::list<std::vector<RangeSearchResult> >& Buffers() const
+  {
+    return buffers;
+  }
+
+  //! Get the total number of results in the buffers.
+  size_t Size() const
+  {
+    size_t size = 0;
+    for (const std::vector<RangeSearchResult>& buffer : buffers)
+      size += buffer.size();
+    return size;
+  }
+
+ private:
+  //! The buffers (in a list, so that adding one doesn't move the others).
+  std::list<std::vector<RangeSearchResult> > buffers;
+  //! The lock for adding buffers.
+  std::mutex mutex;
+};
 
 template<typename MetricType, typename TreeType>
 class RangeSearchRules
@@ -29,14 +89,49 @@ class RangeSearchRules
    * @param metric Instantiated metric.
    * @param sameSet If true, the query and reference set are taken to be the
    *      same, and a query point will not return itself in the results.
+   * @param referenceMap If not NULL, the column of the reference set that
+   *      holds the point with each tree index (and, if sameSet is true, the
+   *      same for the query set).
    */
-  RangeSearchRules(const arma::mat& referenceSet,
-                   const arma::mat& querySet,
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
                    const math::Range& range,
                    std::vector<std::vector<size_t> >& neighbors,
                    std::vector<std::vector<double> >& distances,
                    MetricType& metric,
-                   const bool sameSet = false);
+                   const bool sameSet = false,
+                   const std::vector<size_t>* referenceMap = NULL);
+
+  /**
+   * Construct the RangeSearchRules object so that all results are appended to
+   * flat vectors, in the order they are found.  This avoids allocating a
+   * vector for each query point.  Each copy of the rules appends to its own
+   * buffer, so these rules can be used with a parallel traverser.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param buffers Buffers to append the results to.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not return itself in the results.
+   * @param referenceMap If not NULL, the column of the reference set that
+   *      holds the point with each tree index (and, if sameSet is true, the
+   *      same for the query set).
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   RangeSearchResultBuffers& buffers,
+                   MetricType& metric,
+                   const bool sameSet = false,
+                   const std::vector<size_t>* referenceMap = NULL);
+
+  /**
+   * Copy the rules.  If the results are appended to buffers, the copy appends
+   * its results to a new buffer.
+   */
+  RangeSearchRules(const RangeSearchRules& other);
 
   /**
    * Compute the base case between the given query point and reference point.
@@ -103,24 +198,38 @@ class RangeSearchRules
 
   //! Get the number of base cases.
   size_t BaseCases() const { return baseCases; }
+  //! Modify the number of base cases.
+  size_t& BaseCases() { return baseCases; }
   //! Get the number of scores (that is, calls to RangeDistance()).
   size_t Scores() const { return scores; }
+  //! Modify the number of scores.
+  size_t& Scores() { return scores; }
 
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! The range of distances for which we are searching.
   const math::Range& range;
 
-  //! The vector the resultant neighbor indices should be stored in.
-  std::vector<std::vector<size_t> >& neighbors;
+  //! The vector the resultant neighbor indices should be stored in (NULL if
+  //! the results are stored in one flat vector).
+  std::vector<std::vector<size_t> >* neighbors;
+
+  //! The vector the resultant neighbor distances should be stored in (NULL if
+  //! the results are stored in one flat vector).
+  std::vector<std::vector<double> >* distances;
 
-  //! The vector the resultant neighbor distances should be stored in.
-  std::vector<std::vector<double> >& distances;
+  //! The buffers of flat results (NULL if the results are stored for each
+  //! query point).
+  RangeSearchResultBuffers* buffers;
+
+  //! The buffer this object appends its results to (NULL if the results are
+  //! stored for each query point).
+  std::vector<RangeSearchResult>* results;
 
   //! The instantiated metric.
   MetricType& metric;
@@ -128,11 +237,30 @@ class RangeSearchRules
   //! If true, the query and reference set are taken to be the same.
   bool sameSet;
 
+  //! If not NULL, the column of referenceSet that holds the point with each
+  //! tree index (and, if sameSet is true, the same for querySet).  This is used
+  //! when the tree was built on a copy of the set that it no longer holds.
+  const std::vector<size_t>* referenceMap;
+
   //! The last query index.
   size_t lastQueryIndex;
   //! The last reference index.
   size_t lastReferenceIndex;
 
+  //! The query index of the last single-tree Score() call.
+  size_t lastScoreQueryIndex;
+  //! For trees whose first point is the centroid, the distance between the
+  //! query point of the last single-tree Score() call and the centroid of
+  //! each reference node scored for it.  A self-child has the centroid of its
+  //! parent, so its distance is looked up here instead of being computed
+  //! again.  The map is cleared when Score() moves to another query point.
+  std::unordered_map<const TreeType*, double> nodeDistances;
+
+  //! Add the given reference point to the results for the given query point.
+  void AddNeighbor(const size_t queryIndex,
+                   const size_t referenceIndex,
+                   const double distance);
+
   //! Add all the points in the given node to the results for the given query
   //! point.  If the base case has already been calculated, we make sure to not
   //! add that to the results twice.
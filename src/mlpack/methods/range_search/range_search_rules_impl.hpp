@@ -15,28 +15,85 @@ namespace range {
 
 template<typename MetricType, typename TreeType>
 RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
-    const arma::mat& referenceSet,
-    const arma::mat& querySet,
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
     const math::Range& range,
     std::vector<std::vector<size_t> >& neighbors,
     std::vector<std::vector<double> >& distances,
     MetricType& metric,
-    const bool sameSet) :
+    const bool sameSet,
+    const std::vector<size_t>* referenceMap) :
     referenceSet(referenceSet),
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
+    neighbors(&neighbors),
+    distances(&distances),
+    buffers(NULL),
+    results(NULL),
     metric(metric),
     sameSet(sameSet),
+    referenceMap(referenceMap),
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols),
+    lastScoreQueryIndex(querySet.n_cols),
     baseCases(0),
     scores(0)
 {
   // Nothing to do.
 }
 
+template<typename MetricType, typename TreeType>
+RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    RangeSearchResultBuffers& buffers,
+    MetricType& metric,
+    const bool sameSet,
+    const std::vector<size_t>* referenceMap) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    buffers(&buffers),
+    results(&buffers.Add()),
+    metric(metric),
+    sameSet(sameSet),
+    referenceMap(referenceMap),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    lastScoreQueryIndex(querySet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+    const RangeSearchRules& other) :
+    referenceSet(other.referenceSet),
+    querySet(other.querySet),
+    range(other.range),
+    neighbors(other.neighbors),
+    distances(other.distances),
+    buffers(other.buffers),
+    results(other.buffers ? &other.buffers->Add() : NULL),
+    metric(other.metric),
+    sameSet(other.sameSet),
+    referenceMap(other.referenceMap),
+    lastQueryIndex(other.lastQueryIndex),
+    lastReferenceIndex(other.lastReferenceIndex),
+    lastScoreQueryIndex(other.lastScoreQueryIndex),
+    nodeDistances(other.nodeDistances),
+    traversalInfo(other.traversalInfo),
+    baseCases(other.baseCases),
+    scores(other.scores)
+{
+  // Nothing to do.
+}
+
 //! The base case.  Evaluate the distance between the two points and add to the
 //! results if necessary.
 template<typename MetricType, typename TreeType>
@@ -53,8 +110,12 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
   if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
     return 0.0; // No value to return... this shouldn't do anything bad.
 
-  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-      referenceSet.unsafe_col(referenceIndex));
+  const size_t queryColumn = (referenceMap && sameSet) ?
+      (*referenceMap)[queryIndex] : queryIndex;
+  const size_t referenceColumn = referenceMap ?
+      (*referenceMap)[referenceIndex] : referenceIndex;
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryColumn),
+      referenceSet.unsafe_col(referenceColumn));
   ++baseCases;
 
   // Update last indices, so we don't accidentally perform a base case twice.
@@ -62,10 +123,7 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
   lastReferenceIndex = referenceIndex;
 
   if (range.Contains(distance))
-  {
-    neighbors[queryIndex].push_back(referenceIndex);
-    distances[queryIndex].push_back(distance);
-  }
+    AddNeighbor(queryIndex, referenceIndex, distance);
 
   return distance;
 }
@@ -81,16 +139,29 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
 
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
   {
+    // The distances to the reference nodes are only kept for the current query
+    // point.
+    if (queryIndex != lastScoreQueryIndex)
+    {
+      nodeDistances.clear();
+      lastScoreQueryIndex = queryIndex;
+    }
+
     // In this situation, we calculate the base case.  So we should check to be
     // sure we haven't already done that.
     double baseCase;
+    typename std::unordered_map<const TreeType*, double>::const_iterator
+        parentDistance = nodeDistances.end();
     if (tree::TreeTraits<TreeType>::HasSelfChildren &&
         (referenceNode.Parent() != NULL) &&
         (referenceNode.Point(0) == referenceNode.Parent()->Point(0)))
+      parentDistance = nodeDistances.find(referenceNode.Parent());
+
+    if (parentDistance != nodeDistances.end())
     {
       // If the tree has self-children and this is a self-child, the base case
       // was already calculated.
-      baseCase = referenceNode.Parent()->Stat().LastDistance();
+      baseCase = parentDistance->second;
       lastQueryIndex = queryIndex;
       lastReferenceIndex = referenceNode.Point(0);
     }
@@ -105,11 +176,13 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
     distances.Hi() = baseCase + referenceNode.FurthestDescendantDistance();
 
     // Update last distance calculation.
-    referenceNode.Stat().LastDistance() = baseCase;
+    nodeDistances[&referenceNode] = baseCase;
   }
   else
   {
-    distances = referenceNode.RangeDistance(querySet.unsafe_col(queryIndex));
+    const size_t queryColumn = (referenceMap && sameSet) ?
+        (*referenceMap)[queryIndex] : queryIndex;
+    distances = referenceNode.RangeDistance(querySet.unsafe_col(queryColumn));
     ++scores;
   }
 
@@ -234,23 +307,50 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
   // Resize distances and neighbors vectors appropriately.  We have to use
   // reserve() and not resize(), because we don't know if we will encounter the
   // case where the datasets and points are the same (and we skip in that case).
-  const size_t oldSize = neighbors[queryIndex].size();
-  neighbors[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
-  distances[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
+  // The flat vector of results is left to grow geometrically.
+  if (!results)
+  {
+    const size_t oldSize = (*neighbors)[queryIndex].size();
+    (*neighbors)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+    (*distances)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+  }
 
+  const size_t queryColumn = (referenceMap && sameSet) ?
+      (*referenceMap)[queryIndex] : queryIndex;
   for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
   {
     if ((&referenceSet == &querySet) &&
         (queryIndex == referenceNode.Descendant(i)))
       continue;
 
-    const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-        referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
+    const size_t referenceColumn = referenceMap ?
+        (*referenceMap)[referenceNode.Descendant(i)] :
+        referenceNode.Descendant(i);
+    const double distance = metric.Evaluate(querySet.unsafe_col(queryColumn),
+        referenceSet.unsafe_col(referenceColumn));
 
-    neighbors[queryIndex].push_back(referenceNode.Descendant(i));
-    distances[queryIndex].push_back(distance);
+    AddNeighbor(queryIndex, referenceNode.Descendant(i), distance);
+  }
+}
+
+template<typename MetricType, typename TreeType>
+inline force_inline
+void RangeSearchRules<MetricType, TreeType>::AddNeighbor(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
+  if (results)
+  {
+    const RangeSearchResult result = { queryIndex, referenceIndex, distance };
+    results->push_back(result);
+  }
+  else
+  {
+    (*neighbors)[queryIndex].push_back(referenceIndex);
+    (*distances)[queryIndex].push_back(distance);
   }
 }
 
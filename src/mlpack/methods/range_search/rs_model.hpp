@@ -19,7 +19,17 @@
 namespace mlpack {
 namespace range {
 
-class RSModel
+/**
+ * The RSModelType class provides an easy way to serialize a range search
+ * model, abstracts away the different types of trees, and also reflects the
+ * RangeSearch API.  The MatType may be arma::mat or arma::fmat; with
+ * arma::fmat, the reference and query sets and the trees are stored in single
+ * precision.  The distances are always returned as doubles.
+ *
+ * @tparam MatType The type of data matrix.
+ */
+template<typename MatType>
+class RSModelType
 {
  public:
   enum TreeTypes
@@ -39,13 +49,19 @@ class RSModel
   //! If true, we randomly project the data into a new basis before search.
   bool randomBasis;
   //! Random projection matrix.
-  arma::mat q;
+  MatType q;
+  //! Linear transformation applied to the points before search (empty if not
+  //! used).
+  MatType transformation;
 
-  //! The mostly-specified type of the range search model.
+  //! The mostly-specified type of the range search model.  Dual-tree searches
+  //! use the parallel traverser of the tree, if it has one.
   template<template<typename TreeMetricType,
                     typename TreeStatType,
                     typename TreeMatType> class TreeType>
-  using RSType = RangeSearch<metric::EuclideanDistance, arma::mat, TreeType>;
+  using RSType = RangeSearch<metric::EuclideanDistance, MatType, TreeType,
+      tree::ParallelDualTreeTraversal<TreeType<metric::EuclideanDistance,
+          RangeSearchStat, MatType>>::template Type>;
 
   // Only one of these pointers will be non-NULL.
   //! kd-tree based range search object (NULL if not in use).
@@ -69,20 +85,20 @@ class RSModel
    * @param treeType Type of tree to use.
    * @param randomBasis Whether or not to use a random basis.
    */
-  RSModel(const TreeTypes treeType = TreeTypes::KD_TREE,
-          const bool randomBasis = false);
+  RSModelType(const TreeTypes treeType = TreeTypes::KD_TREE,
+              const bool randomBasis = false);
 
   /**
    * Clean memory, if necessary.
    */
-  ~RSModel();
+  ~RSModelType();
 
   //! Serialize the range search model.
   template<typename Archive>
-  void Serialize(Archive& ar, const unsigned int /* version */);
+  void Serialize(Archive& ar, const unsigned int version);
 
   //! Expose the dataset.
-  const arma::mat& Dataset() const;
+  const MatType& Dataset() const;
 
   //! Get whether the model is in single-tree search mode.
   bool SingleMode() const;
@@ -110,6 +126,19 @@ class RSModel
   //! been built).
   bool& RandomBasis() { return randomBasis; }
 
+  /**
+   * Get the linear transformation applied to the reference and query points
+   * before search (and before the random basis, if one is used).  If it is the
+   * whitening transformation of a Mahalanobis distance (see
+   * metric::MahalanobisDistance::Whitening()), the search uses that distance,
+   * so ranges and returned distances are Mahalanobis distances.  If empty (the
+   * default), the points are not transformed.
+   */
+  const MatType& Transformation() const { return transformation; }
+  //! Modify the linear transformation applied to the points before search
+  //! (don't do this after the model has been built).
+  MatType& Transformation() { return transformation; }
+
   /**
    * Build the reference tree on the given dataset with the given parameters.
    * This takes possession of the reference set to avoid a copy.
@@ -119,7 +148,7 @@ class RSModel
    * @param naive Whether naive search should be used.
    * @param singleMode Whether single-tree search should be used.
    */
-  void BuildModel(arma::mat&& referenceSet,
+  void BuildModel(MatType&& referenceSet,
                   const size_t leafSize,
                   const bool naive,
                   const bool singleMode);
@@ -134,7 +163,7 @@ class RSModel
    * @param neighbors Output: neighbors falling within the desired range.
    * @param distances Output: distances of neighbors.
    */
-  void Search(arma::mat&& querySet,
+  void Search(MatType&& querySet,
               const math::Range& range,
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
@@ -152,6 +181,41 @@ class RSModel
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Perform range search, returning the results in compressed sparse row form.
+   * This takes possession of the query set, so the query set will not be
+   * usable after the search.  For more information on the output format, see
+   * RangeSearch<>::Search().
+   *
+   * @param querySet Set of query points.
+   * @param range Range to search for.
+   * @param offsets Output: index of the first result of each query point,
+   *     followed by the total number of results.
+   * @param neighbors Output: neighbors falling within the desired range.
+   * @param distances Output: distances of neighbors.
+   */
+  void Search(MatType&& querySet,
+              const math::Range& range,
+              std::vector<size_t>& offsets,
+              std::vector<size_t>& neighbors,
+              std::vector<double>& distances);
+
+  /**
+   * Perform monochromatic range search, with the reference set as the query
+   * set, returning the results in compressed sparse row form.  For more
+   * information on the output format, see RangeSearch<>::Search().
+   *
+   * @param range Range to search for.
+   * @param offsets Output: index of the first result of each query point,
+   *     followed by the total number of results.
+   * @param neighbors Output: neighbors falling within the desired range.
+   * @param distances Output: distances of neighbors.
+   */
+  void Search(const math::Range& range,
+              std::vector<size_t>& offsets,
+              std::vector<size_t>& neighbors,
+              std::vector<double>& distances);
+
  private:
   /**
    * Return a string representing the name of the tree.  This is used for
@@ -159,16 +223,32 @@ class RSModel
    */
   std::string TreeName() const;
 
+  /**
+   * Map the query indices of results in compressed sparse row form from the
+   * order of the points in a query tree back to their original order.
+   */
+  static void MapQueries(const std::vector<size_t>& oldFromNewQueries,
+                         std::vector<size_t>& offsets,
+                         std::vector<size_t>& neighbors,
+                         std::vector<double>& distances);
+
   /**
    * Clean up memory.
    */
   void CleanMemory();
 };
 
+//! The range search model for double-precision data.
+typedef RSModelType<arma::mat> RSModel;
+
 } // namespace range
 } // namespace mlpack
 
-// Include implementation (of Serialize() and inline functions).
+//! Set the serialization version of the RSModelType class.
+BOOST_TEMPLATE_CLASS_VERSION(template<typename MatType>,
+    mlpack::range::RSModelType<MatType>, 1);
+
+// Include implementation.
 #include "rs_model_impl.hpp"
 
 #endif
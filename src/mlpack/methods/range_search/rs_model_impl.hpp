@@ -2,7 +2,7 @@
  * @file rs_model_impl.hpp
  * @author Ryan Curtin
  *
- * Implementation of Serialize() and inline functions for RSModel.
+ * Implementation of the range search model class.
  */
 #ifndef MLPACK_METHODS_RANGE_SEARCH_RS_MODEL_IMPL_HPP
 #define MLPACK_METHODS_RANGE_SEARCH_RS_MODEL_IMPL_HPP
@@ -14,8 +14,10 @@ namespace mlpack {
 namespace range {
 
 // Serialize the model.
+template<typename MatType>
 template<typename Archive>
-void RSModel::Serialize(Archive& ar, const unsigned int /* version */)
+void RSModelType<MatType>::Serialize(Archive& ar,
+                                     const unsigned int version)
 {
   using data::CreateNVP;
 
@@ -23,6 +25,12 @@ void RSModel::Serialize(Archive& ar, const unsigned int /* version */)
   ar & CreateNVP(randomBasis, "randomBasis");
   ar & CreateNVP(q, "q");
 
+  // Models before version 1 had no transformation.
+  if (version >= 1)
+    ar & CreateNVP(transformation, "transformation");
+  else if (Archive::is_loading::value)
+    transformation.reset();
+
   // This should never happen, but just in case...
   if (Archive::is_loading::value)
     CleanMemory();
@@ -56,7 +64,8 @@ void RSModel::Serialize(Archive& ar, const unsigned int /* version */)
   }
 }
 
-inline const arma::mat& RSModel::Dataset() const
+template<typename MatType>
+const MatType& RSModelType<MatType>::Dataset() const
 {
   if (kdTreeRS)
     return kdTreeRS->ReferenceSet();
@@ -74,7 +83,8 @@ inline const arma::mat& RSModel::Dataset() const
   throw std::runtime_error("no range search model initialized");
 }
 
-inline bool RSModel::SingleMode() const
+template<typename MatType>
+bool RSModelType<MatType>::SingleMode() const
 {
   if (kdTreeRS)
     return kdTreeRS->SingleMode();
@@ -92,7 +102,8 @@ inline bool RSModel::SingleMode() const
   throw std::runtime_error("no range search model initialized");
 }
 
-inline bool& RSModel::SingleMode()
+template<typename MatType>
+bool& RSModelType<MatType>::SingleMode()
 {
   if (kdTreeRS)
     return kdTreeRS->SingleMode();
@@ -110,7 +121,8 @@ inline bool& RSModel::SingleMode()
   throw std::runtime_error("no range search model initialized");
 }
 
-inline bool RSModel::Naive() const
+template<typename MatType>
+bool RSModelType<MatType>::Naive() const
 {
   if (kdTreeRS)
     return kdTreeRS->Naive();
@@ -128,7 +140,8 @@ inline bool RSModel::Naive() const
   throw std::runtime_error("no range search model initialized");
 }
 
-inline bool& RSModel::Naive()
+template<typename MatType>
+bool& RSModelType<MatType>::Naive()
 {
   if (kdTreeRS)
     return kdTreeRS->Naive();
@@ -146,6 +159,499 @@ inline bool& RSModel::Naive()
   throw std::runtime_error("no range search model initialized");
 }
 
+/**
+ * Initialize the RSModel with the given tree type and whether or not a random
+ * basis should be used.
+ */
+template<typename MatType>
+RSModelType<MatType>::RSModelType(TreeTypes treeType, bool randomBasis) :
+    treeType(treeType),
+    randomBasis(randomBasis),
+    kdTreeRS(NULL),
+    coverTreeRS(NULL),
+    rTreeRS(NULL),
+    rStarTreeRS(NULL),
+    ballTreeRS(NULL),
+    xTreeRS(NULL)
+{
+  // Nothing to do.
+}
+
+// Clean memory, if necessary.
+template<typename MatType>
+RSModelType<MatType>::~RSModelType()
+{
+  CleanMemory();
+}
+
+template<typename MatType>
+void RSModelType<MatType>::BuildModel(MatType&& referenceSet,
+                                      const size_t leafSize,
+                                      const bool naive,
+                                      const bool singleMode)
+{
+  // Transform the reference set first, so that the random basis (if any) has
+  // the dimensionality of the transformed points.
+  if (!transformation.is_empty())
+    referenceSet = transformation * referenceSet;
+
+  // Initialize random basis if necessary.
+  if (randomBasis)
+  {
+    Log::Info << "Creating random basis..." << std::endl;
+    arma::mat basis;
+    math::RandomBasis(basis, referenceSet.n_rows);
+    q = arma::conv_to<MatType>::from(basis);
+  }
+
+  // Clean memory, if necessary.
+  CleanMemory();
+
+  // Do we need to modify the reference set?
+  if (randomBasis)
+    referenceSet = q * referenceSet;
+
+  if (!naive)
+  {
+    Timer::Start("tree_building");
+    Log::Info << "Building reference tree..." << std::endl;
+  }
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      // If necessary, build the tree.
+      if (naive)
+      {
+        kdTreeRS = new RSType<tree::KDTree>(std::move(referenceSet), naive,
+            singleMode);
+      }
+      else
+      {
+        std::vector<size_t> oldFromNewReferences;
+        typename RSType<tree::KDTree>::Tree* kdTree =
+            new typename RSType<tree::KDTree>::Tree(std::move(referenceSet),
+            oldFromNewReferences, leafSize);
+        kdTreeRS = new RSType<tree::KDTree>(kdTree, singleMode);
+
+        // Give the model ownership of the tree and the mappings.
+        kdTreeRS->treeOwner = true;
+        kdTreeRS->oldFromNewReferences = std::move(oldFromNewReferences);
+      }
+
+      break;
+
+    case COVER_TREE:
+      coverTreeRS = new RSType<tree::StandardCoverTree>(std::move(referenceSet),
+          naive, singleMode);
+      break;
+
+    case R_TREE:
+      rTreeRS = new RSType<tree::RTree>(std::move(referenceSet), naive,
+          singleMode);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS = new RSType<tree::RStarTree>(std::move(referenceSet), naive,
+          singleMode);
+      break;
+
+    case BALL_TREE:
+      // If necessary, build the ball tree.
+      if (naive)
+      {
+        ballTreeRS = new RSType<tree::BallTree>(std::move(referenceSet), naive,
+            singleMode);
+      }
+      else
+      {
+        std::vector<size_t> oldFromNewReferences;
+        typename RSType<tree::BallTree>::Tree* ballTree =
+            new typename RSType<tree::BallTree>::Tree(std::move(referenceSet),
+            oldFromNewReferences, leafSize);
+        ballTreeRS = new RSType<tree::BallTree>(ballTree, singleMode);
+
+        // Give the model ownership of the tree and the mappings.
+        ballTreeRS->treeOwner = true;
+        ballTreeRS->oldFromNewReferences = std::move(oldFromNewReferences);
+      }
+
+      break;
+
+    case X_TREE:
+      xTreeRS = new RSType<tree::XTree>(std::move(referenceSet), naive,
+          singleMode);
+      break;
+  }
+
+  if (!naive)
+  {
+    Timer::Stop("tree_building");
+    Log::Info << "Tree built." << std::endl;
+  }
+}
+
+// Perform range search.
+template<typename MatType>
+void RSModelType<MatType>::Search(MatType&& querySet,
+                                  const math::Range& range,
+                                  std::vector<std::vector<size_t>>& neighbors,
+                                  std::vector<std::vector<double>>& distances)
+{
+  // The query set is transformed like the reference set.
+  if (!transformation.is_empty())
+    querySet = transformation * querySet;
+  if (randomBasis)
+    querySet = q * querySet;
+
+  Log::Info << "Search for points in the range [" << range.Lo() << ", "
+      << range.Hi() << "] with ";
+  if (!Naive() && !SingleMode())
+    Log::Info << "dual-tree " << TreeName() << " search..." << std::endl;
+  else if (!Naive())
+    Log::Info << "single-tree " << TreeName() << " search..." << std::endl;
+  else
+    Log::Info << "brute-force (naive) search..." << std::endl;
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      if (!kdTreeRS->Naive() && !kdTreeRS->SingleMode())
+      {
+        // Build a second tree and search.
+        Timer::Start("tree_building");
+        Log::Info << "Building query tree..." << std::endl;
+        std::vector<size_t> oldFromNewQueries;
+        typename RSType<tree::KDTree>::Tree queryTree(std::move(querySet),
+            oldFromNewQueries, leafSize);
+        Log::Info << "Tree built." << std::endl;
+        Timer::Stop("tree_building");
+
+        std::vector<std::vector<size_t>> neighborsOut;
+        std::vector<std::vector<double>> distancesOut;
+        kdTreeRS->Search(&queryTree, range, neighborsOut, distancesOut);
+
+        // Remap the query points.
+        neighbors.resize(queryTree.Dataset().n_cols);
+        distances.resize(queryTree.Dataset().n_cols);
+        for (size_t i = 0; i < queryTree.Dataset().n_cols; ++i)
+        {
+          neighbors[oldFromNewQueries[i]] = neighborsOut[i];
+          distances[oldFromNewQueries[i]] = distancesOut[i];
+        }
+      }
+      else
+      {
+        // Search without building a second tree.
+        kdTreeRS->Search(querySet, range, neighbors, distances);
+      }
+      break;
+
+    case COVER_TREE:
+      coverTreeRS->Search(querySet, range, neighbors, distances);
+      break;
+
+    case R_TREE:
+      rTreeRS->Search(querySet, range, neighbors, distances);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS->Search(querySet, range, neighbors, distances);
+      break;
+
+    case BALL_TREE:
+      if (!ballTreeRS->Naive() && !ballTreeRS->SingleMode())
+      {
+        // Build a second tree and search.
+        Timer::Start("tree_building");
+        Log::Info << "Building query tree..." << std::endl;
+        std::vector<size_t> oldFromNewQueries;
+        typename RSType<tree::BallTree>::Tree queryTree(std::move(querySet),
+            oldFromNewQueries, leafSize);
+        Log::Info << "Tree built." << std::endl;
+        Timer::Stop("tree_building");
+
+        std::vector<std::vector<size_t>> neighborsOut;
+        std::vector<std::vector<double>> distancesOut;
+        ballTreeRS->Search(&queryTree, range, neighborsOut, distancesOut);
+
+        // Remap the query points.
+        neighbors.resize(queryTree.Dataset().n_cols);
+        distances.resize(queryTree.Dataset().n_cols);
+        for (size_t i = 0; i < queryTree.Dataset().n_cols; ++i)
+        {
+          neighbors[oldFromNewQueries[i]] = neighborsOut[i];
+          distances[oldFromNewQueries[i]] = distancesOut[i];
+        }
+      }
+      else
+      {
+        // Search without building a second tree.
+        ballTreeRS->Search(querySet, range, neighbors, distances);
+      }
+      break;
+
+    case X_TREE:
+      xTreeRS->Search(querySet, range, neighbors, distances);
+      break;
+  }
+}
+
+// Perform range search (monochromatic case).
+template<typename MatType>
+void RSModelType<MatType>::Search(const math::Range& range,
+                                  std::vector<std::vector<size_t>>& neighbors,
+                                  std::vector<std::vector<double>>& distances)
+{
+  Log::Info << "Search for points in the range [" << range.Lo() << ", "
+      << range.Hi() << "] with ";
+  if (!Naive() && !SingleMode())
+    Log::Info << "dual-tree " << TreeName() << " search..." << std::endl;
+  else if (!Naive())
+    Log::Info << "single-tree " << TreeName() << " search..." << std::endl;
+  else
+    Log::Info << "brute-force (naive) search..." << std::endl;
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      kdTreeRS->Search(range, neighbors, distances);
+      break;
+
+    case COVER_TREE:
+      coverTreeRS->Search(range, neighbors, distances);
+      break;
+
+    case R_TREE:
+      rTreeRS->Search(range, neighbors, distances);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS->Search(range, neighbors, distances);
+      break;
+
+    case BALL_TREE:
+      ballTreeRS->Search(range, neighbors, distances);
+      break;
+
+    case X_TREE:
+      xTreeRS->Search(range, neighbors, distances);
+      break;
+  }
+}
+
+// Perform range search, with results in compressed sparse row form.
+template<typename MatType>
+void RSModelType<MatType>::Search(MatType&& querySet,
+                                  const math::Range& range,
+                                  std::vector<size_t>& offsets,
+                                  std::vector<size_t>& neighbors,
+                                  std::vector<double>& distances)
+{
+  // The query set is transformed like the reference set.
+  if (!transformation.is_empty())
+    querySet = transformation * querySet;
+  if (randomBasis)
+    querySet = q * querySet;
+
+  Log::Info << "Search for points in the range [" << range.Lo() << ", "
+      << range.Hi() << "] with ";
+  if (!Naive() && !SingleMode())
+    Log::Info << "dual-tree " << TreeName() << " search..." << std::endl;
+  else if (!Naive())
+    Log::Info << "single-tree " << TreeName() << " search..." << std::endl;
+  else
+    Log::Info << "brute-force (naive) search..." << std::endl;
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      if (!kdTreeRS->Naive() && !kdTreeRS->SingleMode())
+      {
+        // Build a second tree and search.
+        Timer::Start("tree_building");
+        Log::Info << "Building query tree..." << std::endl;
+        std::vector<size_t> oldFromNewQueries;
+        typename RSType<tree::KDTree>::Tree queryTree(std::move(querySet),
+            oldFromNewQueries, leafSize);
+        Log::Info << "Tree built." << std::endl;
+        Timer::Stop("tree_building");
+
+        kdTreeRS->Search(&queryTree, range, offsets, neighbors, distances);
+        MapQueries(oldFromNewQueries, offsets, neighbors, distances);
+      }
+      else
+      {
+        // Search without building a second tree.
+        kdTreeRS->Search(querySet, range, offsets, neighbors, distances);
+      }
+      break;
+
+    case COVER_TREE:
+      coverTreeRS->Search(querySet, range, offsets, neighbors, distances);
+      break;
+
+    case R_TREE:
+      rTreeRS->Search(querySet, range, offsets, neighbors, distances);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS->Search(querySet, range, offsets, neighbors, distances);
+      break;
+
+    case BALL_TREE:
+      if (!ballTreeRS->Naive() && !ballTreeRS->SingleMode())
+      {
+        // Build a second tree and search.
+        Timer::Start("tree_building");
+        Log::Info << "Building query tree..." << std::endl;
+        std::vector<size_t> oldFromNewQueries;
+        typename RSType<tree::BallTree>::Tree queryTree(std::move(querySet),
+            oldFromNewQueries, leafSize);
+        Log::Info << "Tree built." << std::endl;
+        Timer::Stop("tree_building");
+
+        ballTreeRS->Search(&queryTree, range, offsets, neighbors, distances);
+        MapQueries(oldFromNewQueries, offsets, neighbors, distances);
+      }
+      else
+      {
+        // Search without building a second tree.
+        ballTreeRS->Search(querySet, range, offsets, neighbors, distances);
+      }
+      break;
+
+    case X_TREE:
+      xTreeRS->Search(querySet, range, offsets, neighbors, distances);
+      break;
+  }
+}
+
+// Perform range search (monochromatic case), with results in compressed sparse
+// row form.
+template<typename MatType>
+void RSModelType<MatType>::Search(const math::Range& range,
+                                  std::vector<size_t>& offsets,
+                                  std::vector<size_t>& neighbors,
+                                  std::vector<double>& distances)
+{
+  Log::Info << "Search for points in the range [" << range.Lo() << ", "
+      << range.Hi() << "] with ";
+  if (!Naive() && !SingleMode())
+    Log::Info << "dual-tree " << TreeName() << " search..." << std::endl;
+  else if (!Naive())
+    Log::Info << "single-tree " << TreeName() << " search..." << std::endl;
+  else
+    Log::Info << "brute-force (naive) search..." << std::endl;
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      kdTreeRS->Search(range, offsets, neighbors, distances);
+      break;
+
+    case COVER_TREE:
+      coverTreeRS->Search(range, offsets, neighbors, distances);
+      break;
+
+    case R_TREE:
+      rTreeRS->Search(range, offsets, neighbors, distances);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS->Search(range, offsets, neighbors, distances);
+      break;
+
+    case BALL_TREE:
+      ballTreeRS->Search(range, offsets, neighbors, distances);
+      break;
+
+    case X_TREE:
+      xTreeRS->Search(range, offsets, neighbors, distances);
+      break;
+  }
+}
+
+// Map query indices of compressed sparse row results back to the original
+// order.
+template<typename MatType>
+void RSModelType<MatType>::MapQueries(
+    const std::vector<size_t>& oldFromNewQueries,
+    std::vector<size_t>& offsets,
+    std::vector<size_t>& neighbors,
+    std::vector<double>& distances)
+{
+  const size_t numQueries = oldFromNewQueries.size();
+  std::vector<size_t> mappedOffsets(numQueries + 1, 0);
+  for (size_t i = 0; i < numQueries; ++i)
+    mappedOffsets[oldFromNewQueries[i] + 1] = offsets[i + 1] - offsets[i];
+  for (size_t i = 0; i < numQueries; ++i)
+    mappedOffsets[i + 1] += mappedOffsets[i];
+
+  std::vector<size_t> mappedNeighbors(neighbors.size());
+  std::vector<double> mappedDistances(distances.size());
+  for (size_t i = 0; i < numQueries; ++i)
+  {
+    const size_t position = mappedOffsets[oldFromNewQueries[i]];
+    std::copy(neighbors.begin() + offsets[i],
+        neighbors.begin() + offsets[i + 1], mappedNeighbors.begin() + position);
+    std::copy(distances.begin() + offsets[i],
+        distances.begin() + offsets[i + 1], mappedDistances.begin() + position);
+  }
+
+  offsets.swap(mappedOffsets);
+  neighbors.swap(mappedNeighbors);
+  distances.swap(mappedDistances);
+}
+
+// Get the name of the tree type.
+template<typename MatType>
+std::string RSModelType<MatType>::TreeName() const
+{
+  switch (treeType)
+  {
+    case KD_TREE:
+      return "kd-tree";
+    case COVER_TREE:
+      return "cover tree";
+    case R_TREE:
+      return "R tree";
+    case R_STAR_TREE:
+      return "R* tree";
+    case BALL_TREE:
+      return "ball tree";
+    case X_TREE:
+      return "X tree";
+    default:
+      return "unknown tree";
+  }
+}
+
+// Clean memory.
+template<typename MatType>
+void RSModelType<MatType>::CleanMemory()
+{
+  if (kdTreeRS)
+    delete kdTreeRS;
+  if (coverTreeRS)
+    delete coverTreeRS;
+  if (rTreeRS)
+    delete rTreeRS;
+  if (rStarTreeRS)
+    delete rStarTreeRS;
+  if (ballTreeRS)
+    delete ballTreeRS;
+  if (xTreeRS)
+    delete xTreeRS;
+
+  kdTreeRS = NULL;
+  coverTreeRS = NULL;
+  rTreeRS = NULL;
+  rStarTreeRS = NULL;
+  ballTreeRS = NULL;
+  xTreeRS = NULL;
+}
+
 } // namespace range
 } // namespace mlpack
 
@@ -6,6 +6,7 @@
  * options.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
 
 #include "ra_search.hpp"
 #include "ra_model.hpp"
@@ -42,7 +43,18 @@ PROGRAM_INFO("K-Rank-Approximate-Nearest-Neighbors (kRANN)",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th nearest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "The format of the output files is chosen by their extension.  For large "
+    "results, the native binary format (.mlbin) is much faster to write and "
+    "much smaller than text: the matrices are written as they are in memory, "
+    "so they can be loaded with a single read or memory-mapped.  HDF5 files "
+    "(.h5) may also be written, if mlpack was built with HDF5 support."
+    "\n\n"
+    "If the query set is too large to fit in memory, --query_chunk_size may be "
+    "specified; then the query file is read and searched that many points at "
+    "a time, and the results of each chunk are appended to the output files "
+    "(which must be .csv, .txt, .mlbin or HDF5 files).");
 
 // Define our input parameters that this program will take.
 PARAM_STRING("reference_file", "File containing the reference dataset.",
@@ -60,6 +72,9 @@ PARAM_STRING("output_model_file", "If specified, the kNN model will be saved "
 // neighbors to search for.
 PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
 PARAM_INT("k", "Number of nearest neighbors to find.", "k", 0);
+PARAM_INT("query_chunk_size", "If positive, the query file is read and "
+    "searched this many points at a time, and the results are appended to the "
+    "output files after each chunk.", "c", 0);
 
 // The user may specify the type of tree to use, and a few parameters for tree
 // building.
@@ -96,6 +111,7 @@ int main(int argc, char *argv[])
     math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
   else
     math::RandomSeed((size_t) std::time(NULL));
+
  // A user cannot specify both reference data and a model.
   if (CLI::HasParam("reference_file") && CLI::HasParam("input_model_file"))
     Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
@@ -142,6 +158,15 @@ int main(int argc, char *argv[])
         << "is not being performed because k (--k) is not specified!  No "
         << "results will be saved." << endl;
 
+  // Sanity check on the query chunk size.
+  if (CLI::GetParam<int>("query_chunk_size") < 0)
+    Log::Fatal << "Invalid query chunk size: "
+        << CLI::GetParam<int>("query_chunk_size") << ".  Must be "
+        << "non-negative." << endl;
+  if (CLI::HasParam("query_chunk_size") && !CLI::HasParam("query_file"))
+    Log::Warn << "--query_chunk_size (-c) will be ignored because "
+        << "--query_file (-q) is not specified." << endl;
+
   // Sanity check on leaf size.
   const int lsInt = CLI::GetParam<int>("leaf_size");
   if (lsInt < 1)
@@ -219,9 +244,10 @@ int main(int argc, char *argv[])
   {
     const string queryFile = CLI::GetParam<string>("query_file");
     const size_t k = (size_t) CLI::GetParam<int>("k");
+    const size_t chunkSize = (size_t) CLI::GetParam<int>("query_chunk_size");
 
     arma::mat queryData;
-    if (queryFile != "")
+    if (queryFile != "" && chunkSize == 0)
     {
       data::Load(queryFile, queryData, true);
       Log::Info << "Loaded query data from '" << queryFile << "' ("
@@ -246,17 +272,55 @@ int main(int argc, char *argv[])
 
     arma::Mat<size_t> neighbors;
     arma::mat distances;
-    if (CLI::HasParam("query_file"))
-      rann.Search(std::move(queryData), k, neighbors, distances);
+    if (CLI::HasParam("query_file") && chunkSize > 0)
+    {
+      // Search each chunk of the query set separately, and append its results
+      // to the output files, so that the whole query set is never in memory.
+      // The files are read and written as the search goes, so a read or write
+      // error can happen at any chunk.
+      try
+      {
+        data::ChunkedLoader<double> loader(queryFile);
+        std::unique_ptr<data::ChunkedSaver> neighborsSaver, distancesSaver;
+        if (CLI::HasParam("neighbors_file"))
+          neighborsSaver.reset(new data::ChunkedSaver(
+              CLI::GetParam<string>("neighbors_file")));
+        if (CLI::HasParam("distances_file"))
+          distancesSaver.reset(new data::ChunkedSaver(
+              CLI::GetParam<string>("distances_file")));
+
+        arma::mat chunk;
+        while (loader.Next(chunk, chunkSize))
+        {
+          rann.Search(std::move(chunk), k, neighbors, distances);
+          if (neighborsSaver)
+            neighborsSaver->Write(neighbors);
+          if (distancesSaver)
+            distancesSaver->Write(distances);
+        }
+
+        Log::Info << "Search complete (" << loader.PointsRead() << " query "
+            << "points in chunks of " << chunkSize << ")." << endl;
+      }
+      catch (std::runtime_error& e)
+      {
+        Log::Fatal << e.what() << endl;
+      }
+    }
     else
-      rann.Search(k, neighbors, distances);
-    Log::Info << "Search complete." << endl;
-
-    // Save output, if desired.
-    if (CLI::HasParam("neighbors_file"))
-      data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
-    if (CLI::HasParam("distances_file"))
-      data::Save(CLI::GetParam<string>("distances_file"), distances);
+    {
+      if (CLI::HasParam("query_file"))
+        rann.Search(std::move(queryData), k, neighbors, distances);
+      else
+        rann.Search(k, neighbors, distances);
+      Log::Info << "Search complete." << endl;
+
+      // Save output, if desired.
+      if (CLI::HasParam("neighbors_file"))
+        data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
+      if (CLI::HasParam("distances_file"))
+        data::Save(CLI::GetParam<string>("distances_file"), distances);
+    }
   }
 
   if (CLI::HasParam("output_model_file"))
@@ -53,6 +53,16 @@ class RAModel;
  *
  * RASearch is currently known to not work with ball trees (#356).
  *
+ * With OpenMP, the search runs in parallel: in naive and single-tree mode the
+ * query points are split into blocks, and in dual-tree mode the query tree is
+ * split into disjoint subtrees (except for trees with self-children, like the
+ * cover tree, which are traversed by one thread).  Each block or subtree draws
+ * its samples from its own random number stream (see math::RandomStreams),
+ * indexed by the block or subtree, so for a fixed random seed the
+ * results are reproducible.  In naive and single-tree mode they do not depend
+ * on the number of threads either; in dual-tree mode the split of the query
+ * tree depends on the number of threads.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
  * @tparam TreeType The tree type to use.
@@ -446,6 +456,37 @@ class RASearch
   //! Instantiation of kernel.
   MetricType metric;
 
+  /**
+   * Run the naive or single-tree search for each query point with the given
+   * rules.  The query points are split into blocks that are searched in
+   * parallel by threads with their own copy of the rules, and each block draws
+   * its samples from its own random number generator.  In naive mode, each
+   * query point is compared with its own random samples of the reference set
+   * and then with the given samples, or with every reference point if
+   * naiveSamples is NULL.
+   *
+   * @param rules Rules to use for the search.
+   * @param numQueries Number of query points.
+   * @param naiveSamples Reference points that every query point is compared
+   *     with in naive mode (or NULL for all of them).
+   */
+  template<typename RuleType>
+  void SearchQueries(RuleType& rules,
+                     const size_t numQueries,
+                     const arma::uvec* naiveSamples);
+
+  /**
+   * Run the dual-tree search of the given query tree with the given rules.
+   * The query tree is split into disjoint subtrees (a few for each thread),
+   * which are traversed in parallel against the reference tree with their own
+   * copy of the rules and their own random number generator.
+   *
+   * @param rules Rules to use for the search.
+   * @param queryTree Tree built on the query points.
+   */
+  template<typename RuleType>
+  void TraverseDual(RuleType& rules, Tree& queryTree);
+
   //! RAModel can modify internal members as necessary.
   friend class RAModel<SortPolicy>;
 }; // class RASearch
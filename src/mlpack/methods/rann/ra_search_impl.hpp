@@ -353,6 +353,7 @@ Search(const MatType& querySet,
 
   // Set the size of the neighbor and distance matrices.
   neighborPtr->set_size(k, querySet.n_cols);
+  neighborPtr->fill(size_t() - 1);
   distancePtr->set_size(k, querySet.n_cols);
   distancePtr->fill(SortPolicy::WorstDistance());
 
@@ -360,8 +361,10 @@ Search(const MatType& querySet,
 
   if (naive)
   {
+    // The samples of each query point are drawn in SearchQueries(), not by the
+    // rules.
     RuleType rules(*referenceSet, querySet, *neighborPtr, *distancePtr, metric,
-                   tau, alpha, naive, sampleAtLeaves, firstLeafExact,
+                   tau, alpha, false, sampleAtLeaves, firstLeafExact,
                    singleSampleLimit, false);
 
     // Find how many samples from the reference set we need and sample uniformly
@@ -374,9 +377,7 @@ Search(const MatType& querySet,
 
     // Run the base case on each combination of query point and sampled
     // reference point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < distinctSamples.n_elem; ++j)
-        rules.BaseCase(i, (size_t) distinctSamples[j]);
+    SearchQueries(rules, querySet.n_cols, &distinctSamples);
   }
   else if (singleMode)
   {
@@ -390,12 +391,8 @@ Search(const MatType& querySet,
     {
       Log::Info << "Performing single-tree traversal..." << std::endl;
 
-      // Create the traverser.
-      typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-      // Now have it traverse for each point.
-      for (size_t i = 0; i < querySet.n_cols; ++i)
-        traverser.Traverse(i, *referenceTree);
+      // Now traverse the tree for each point.
+      SearchQueries(rules, querySet.n_cols, NULL);
 
       Log::Info << "Single-tree traversal complete." << std::endl;
       Log::Info << "Average number of distance calculations per query point: "
@@ -418,12 +415,11 @@ Search(const MatType& querySet,
     RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr,
                    *distancePtr, metric, tau, alpha, naive, sampleAtLeaves,
                    firstLeafExact, singleSampleLimit, false);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
 
     Log::Info << "Query statistic pre-search: "
         << queryTree->Stat().NumSamplesMade() << std::endl;
 
-    traverser.Traverse(*queryTree, *referenceTree);
+    TraverseDual(rules, *queryTree);
 
     Log::Info << "Dual-tree traversal complete." << std::endl;
     Log::Info << "Average number of distance calculations per query point: "
@@ -432,6 +428,9 @@ Search(const MatType& querySet,
     delete queryTree;
   }
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(*distancePtr, *neighborPtr);
+
   Timer::Stop("computing_neighbors");
 
   // Map points back to original indices, if necessary.
@@ -533,9 +532,11 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
                  metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
                  singleSampleLimit, false);
 
-  // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-  traverser.Traverse(*queryTree, *referenceTree);
+  // Traverse the trees.
+  TraverseDual(rules, *queryTree);
+
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(distances, *neighborPtr);
 
   Timer::Stop("computing_neighbors");
 
@@ -584,44 +585,32 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   distancePtr->set_size(k, referenceSet->n_cols);
   distancePtr->fill(SortPolicy::WorstDistance());
 
-  // Create the helper object for the tree traversal.
+  // Create the helper object for the tree traversal.  In naive mode, the
+  // samples of each query point are drawn in SearchQueries(), not by the rules.
   typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
   RuleType rules(*referenceSet, *referenceSet, *neighborPtr, *distancePtr,
-                 metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
+                 metric, tau, alpha, false, sampleAtLeaves, firstLeafExact,
                  singleSampleLimit, true /* sets are the same */);
 
   if (naive)
   {
-    // Find how many samples from the reference set we need and sample uniformly
-    // from the reference set without replacement.
-    const size_t numSamples = RAUtil::MinimumSamplesReqd(referenceSet->n_cols,
-        k, tau, alpha);
-    arma::uvec distinctSamples;
-    RAUtil::ObtainDistinctSamples(numSamples, referenceSet->n_cols,
-        distinctSamples);
-
     // The naive brute-force solution.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+    SearchQueries(rules, referenceSet->n_cols, NULL);
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    // Now traverse the tree for each point.
+    SearchQueries(rules, referenceSet->n_cols, NULL);
   }
   else
   {
-    // Create the traverser.
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*referenceTree, *referenceTree);
+    // Traverse the tree with itself.
+    TraverseDual(rules, *referenceTree);
   }
 
+  // The candidates for each query point were kept as a heap; sort them.
+  CandidateHeap<SortPolicy>::Sort(*distancePtr, *neighborPtr);
+
   Timer::Stop("computing_neighbors");
 
   // Do we need to map the reference indices?
@@ -647,6 +636,152 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename RuleType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::SearchQueries(
+    RuleType& rules,
+    const size_t numQueries,
+    const arma::uvec* naiveSamples)
+{
+  // Each block has its own random number stream, so the samples don't depend
+  // on which thread searches the block.
+  const math::RandomStreams streams;
+  const size_t blockSize = 64;
+  const size_t numBlocks = (numQueries + blockSize - 1) / blockSize;
+
+  // Each thread uses its own copy of the rules, and they all write to the same
+  // results matrices; that is fine because each query point has its own column.
+  size_t numDistComputations = 0;
+  #pragma omp parallel reduction(+:numDistComputations)
+  {
+    RuleType threadRules(rules);
+    threadRules.NumDistComputations() = 0;
+
+    typename Tree::template SingleTreeTraverser<RuleType>
+        traverser(threadRules);
+
+    // The cost of each block can vary a lot, so use dynamic scheduling.
+    #pragma omp for schedule(dynamic)
+    for (omp_size_t b = 0; b < (omp_size_t) numBlocks; ++b)
+    {
+      std::mt19937 generator = streams.Stream((size_t) b);
+      threadRules.Generator() = &generator;
+
+      const size_t end = std::min((size_t) (b + 1) * blockSize, numQueries);
+      for (size_t i = (size_t) b * blockSize; i < end; ++i)
+      {
+        if (naive)
+        {
+          arma::uvec querySamples;
+          RAUtil::ObtainDistinctSamples(threadRules.MinimumSamplesReqd(),
+              referenceSet->n_cols, querySamples, generator);
+          for (size_t j = 0; j < querySamples.n_elem; ++j)
+            threadRules.BaseCase(i, (size_t) querySamples[j]);
+
+          if (naiveSamples)
+          {
+            for (size_t j = 0; j < naiveSamples->n_elem; ++j)
+              threadRules.BaseCase(i, (size_t) (*naiveSamples)[j]);
+          }
+          else
+          {
+            for (size_t j = 0; j < referenceSet->n_cols; ++j)
+              threadRules.BaseCase(i, j);
+          }
+        }
+        else
+        {
+          traverser.Traverse(i, *referenceTree);
+        }
+      }
+    }
+
+    numDistComputations += threadRules.NumDistComputations();
+  }
+
+  rules.NumDistComputations() += numDistComputations;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename RuleType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::TraverseDual(
+    RuleType& rules,
+    Tree& queryTree)
+{
+  // Each subtree has its own random number stream.
+  const math::RandomStreams streams;
+
+  // We want several subtrees per thread so that dynamic scheduling can balance
+  // subtrees of different cost.  Trees with self-children (like the cover
+  // tree) are not split, since their dual-tree traversal depends on the scales
+  // of the nodes above.
+  size_t numThreads = 1;
+  #ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+  #endif
+  const size_t targetTasks = (numThreads == 1 ||
+      tree::TreeTraits<Tree>::HasSelfChildren) ? 1 : 8 * numThreads;
+  const size_t minTaskSize = 256;
+
+  // Replace every splittable subtree with its children, one level at a time,
+  // until we have enough subtrees.  Splitting level by level keeps the order
+  // of the subtrees (and so their seeds) deterministic.
+  std::vector<Tree*> tasks(1, &queryTree);
+  bool split = true;
+  while (split && tasks.size() < targetTasks)
+  {
+    split = false;
+    std::vector<Tree*> nextTasks;
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+      if (tasks[i]->NumChildren() > 0 &&
+          tasks[i]->NumDescendants() >= minTaskSize)
+      {
+        for (size_t j = 0; j < tasks[i]->NumChildren(); ++j)
+          nextTasks.push_back(&tasks[i]->Child(j));
+        split = true;
+      }
+      else
+      {
+        nextTasks.push_back(tasks[i]);
+      }
+    }
+
+    tasks.swap(nextTasks);
+  }
+
+  // Each subtree is traversed against the whole reference tree with its own
+  // copy of the rules.  The subtrees are disjoint, so no two of them write to
+  // the same query point or query node.
+  size_t numDistComputations = 0;
+  #pragma omp parallel for schedule(dynamic) reduction(+:numDistComputations)
+  for (omp_size_t i = 0; i < (omp_size_t) tasks.size(); ++i)
+  {
+    RuleType taskRules(rules);
+    taskRules.NumDistComputations() = 0;
+
+    std::mt19937 generator = streams.Stream((size_t) i);
+    taskRules.Generator() = &generator;
+
+    typename Tree::template DualTreeTraverser<RuleType> traverser(taskRules);
+    traverser.Traverse(*tasks[i], *referenceTree);
+
+    numDistComputations += taskRules.NumDistComputations();
+  }
+
+  rules.NumDistComputations() += numDistComputations;
+}
+
 template<typename SortPolicy,
          typename MetricType,
          typename MatType,
@@ -10,6 +10,7 @@
 #define MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 
 #include <mlpack/core/tree/traversal_info.hpp>
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
 
 namespace mlpack {
 namespace neighbor {
@@ -29,7 +30,8 @@ class RASearchRules
                 const bool sampleAtLeaves = false,
                 const bool firstLeafExact = false,
                 const size_t singleSampleLimit = 20,
-                const bool sameSet = false);
+                const bool sameSet = false,
+                std::mt19937& generator = math::randGen);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
@@ -176,7 +178,20 @@ class RASearchRules
                  const double oldScore);
 
 
-  size_t NumDistComputations() { return numDistComputations; }
+  //! Get the number of distance computations.
+  size_t NumDistComputations() const { return numDistComputations; }
+  //! Modify the number of distance computations.
+  size_t& NumDistComputations() { return numDistComputations; }
+
+  //! Get the minimum number of samples required for each query point.
+  size_t MinimumSamplesReqd() const { return numSamplesReqd; }
+
+  //! Get the random number generator used for sampling.
+  std::mt19937* Generator() const { return generator; }
+  //! Modify the random number generator used for sampling.  Copies of the
+  //! rules that are used by different threads should each be given their own.
+  std::mt19937*& Generator() { return generator; }
+
   size_t NumEffectiveSamples()
   {
     if (numSamplesMade.n_elem == 0)
@@ -230,21 +245,10 @@ class RASearchRules
   //! If the query and reference set are identical, this is true.
   bool sameSet;
 
-  TraversalInfoType traversalInfo;
+  //! The random number generator used for sampling.
+  std::mt19937* generator;
 
-  /**
-   * Insert a point into the neighbors and distances matrices; this is a helper
-   * function.
-   *
-   * @param queryIndex Index of point whose neighbors we are inserting into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of reference point which is being inserted.
-   * @param distance Distance from query point to reference point.
-   */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  TraversalInfoType traversalInfo;
 
   /**
    * Perform actual scoring for single-tree case.
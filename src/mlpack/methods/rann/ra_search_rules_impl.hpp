@@ -26,7 +26,8 @@ RASearchRules(const arma::mat& referenceSet,
               const bool sampleAtLeaves,
               const bool firstLeafExact,
               const size_t singleSampleLimit,
-              const bool sameSet) :
+              const bool sameSet,
+              std::mt19937& generator) :
     referenceSet(referenceSet),
     querySet(querySet),
     neighbors(neighbors),
@@ -35,7 +36,8 @@ RASearchRules(const arma::mat& referenceSet,
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
-    sameSet(sameSet)
+    sameSet(sameSet),
+    generator(&generator)
 {
   // Validate tau to make sure that the rank approximation is greater than the
   // number of neighbors requested.
@@ -74,7 +76,8 @@ RASearchRules(const arma::mat& referenceSet,
     for (size_t i = 0; i < querySet.n_cols; ++i)
     {
       arma::uvec distinctSamples;
-      RAUtil::ObtainDistinctSamples(numSamplesReqd, n, distinctSamples);
+      RAUtil::ObtainDistinctSamples(numSamplesReqd, n, distinctSamples,
+          generator);
       for (size_t j = 0; j < distinctSamples.n_elem; j++)
         BaseCase(i, (size_t) distinctSamples[j]);
     }
@@ -95,16 +98,9 @@ double RASearchRules<SortPolicy, MetricType, TreeType>::BaseCase(
   double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
                                     referenceSet.unsafe_col(referenceIndex));
 
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  size_t insertPosition = SortPolicy::SortDistance(queryDist, queryIndices,
-      distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // Add the point to the candidates if it is better than the worst one.
+  CandidateHeap<SortPolicy>::Insert(distances.colptr(queryIndex),
+      neighbors.colptr(queryIndex), distances.n_rows, distance, referenceIndex);
 
   numSamplesMade[queryIndex]++;
 
@@ -122,7 +118,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode);
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = distances(0, queryIndex);
 
   return Score(queryIndex, referenceNode, distance, bestDistance);
 }
@@ -136,7 +132,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode, baseCaseResult);
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = distances(0, queryIndex);
 
   return Score(queryIndex, referenceNode, distance, bestDistance);
 }
@@ -180,7 +176,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           arma::uvec distinctSamples;
           RAUtil::ObtainDistinctSamples(samplesReqd,
               referenceNode.NumDescendants(),
-                                distinctSamples);
+              distinctSamples, *generator);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -197,7 +193,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             arma::uvec distinctSamples;
             RAUtil::ObtainDistinctSamples(samplesReqd,
                 referenceNode.NumDescendants(),
-                                  distinctSamples);
+                distinctSamples, *generator);
             for (size_t i = 0; i < distinctSamples.n_elem; i++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -250,7 +246,7 @@ Rescore(const size_t queryIndex,
     return oldScore;
 
   // Just check the score again against the distances.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = distances(0, queryIndex);
 
   // If this is better than the best distance we've seen so far,
   // maybe there will be something down this node.
@@ -285,7 +281,8 @@ Rescore(const size_t queryIndex,
         // by sampling enough number of points.
         arma::uvec distinctSamples;
         RAUtil::ObtainDistinctSamples(samplesReqd,
-            referenceNode.NumDescendants(), distinctSamples);
+            referenceNode.NumDescendants(), distinctSamples,
+            *generator);
         for (size_t i = 0; i < distinctSamples.n_elem; i++)
           // The counting of the samples are done in the 'BaseCase' function so
           // no book-keeping is required here.
@@ -301,7 +298,8 @@ Rescore(const size_t queryIndex,
           // Approximate node by sampling enough points.
           arma::uvec distinctSamples;
           RAUtil::ObtainDistinctSamples(samplesReqd,
-              referenceNode.NumDescendants(), distinctSamples);
+              referenceNode.NumDescendants(), distinctSamples,
+              *generator);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -350,7 +348,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = distances(0, queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -389,7 +387,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = distances(0, queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -488,7 +486,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             const size_t queryIndex = queryNode.Descendant(i);
             arma::uvec distinctSamples;
             RAUtil::ObtainDistinctSamples(samplesReqd,
-                referenceNode.NumDescendants(), distinctSamples);
+                referenceNode.NumDescendants(), distinctSamples,
+                *generator);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -518,7 +517,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
               const size_t queryIndex = queryNode.Descendant(i);
               arma::uvec distinctSamples;
               RAUtil::ObtainDistinctSamples(samplesReqd,
-                  referenceNode.NumDescendants(), distinctSamples);
+                  referenceNode.NumDescendants(), distinctSamples,
+                  *generator);
               for (size_t j = 0; j < distinctSamples.n_elem; j++)
                 // The counting of the samples are done in the 'BaseCase'
                 // function so no book-keeping is required here.
@@ -603,7 +603,7 @@ Rescore(TreeType& queryNode,
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = distances(0, queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -693,7 +693,8 @@ Rescore(TreeType& queryNode,
           const size_t queryIndex = queryNode.Descendant(i);
           arma::uvec distinctSamples;
           RAUtil::ObtainDistinctSamples(samplesReqd,
-              referenceNode.NumDescendants(), distinctSamples);
+              referenceNode.NumDescendants(), distinctSamples,
+              *generator);
           for (size_t j = 0; j < distinctSamples.n_elem; j++)
             // The counting of the samples are done in the 'BaseCase'
             // function so no book-keeping is required here.
@@ -722,7 +723,8 @@ Rescore(TreeType& queryNode,
             const size_t queryIndex = queryNode.Descendant(i);
             arma::uvec distinctSamples;
             RAUtil::ObtainDistinctSamples(samplesReqd,
-                referenceNode.NumDescendants(), distinctSamples);
+                referenceNode.NumDescendants(), distinctSamples,
+                *generator);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in BaseCase() so no
               // book-keeping is required here.
@@ -774,38 +776,6 @@ Rescore(TreeType& queryNode,
   }
 } // Rescore(node, node, oldScore)
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
-template<typename SortPolicy, typename MetricType, typename TreeType>
-void RASearchRules<SortPolicy, MetricType, TreeType>::InsertNeighbor(
-    const size_t queryIndex,
-    const size_t pos,
-    const size_t neighbor,
-    const double distance)
-{
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (distances.n_rows - 1))
-  {
-    int len = (distances.n_rows - 1) - pos;
-    memmove(distances.colptr(queryIndex) + (pos + 1),
-        distances.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(neighbors.colptr(queryIndex) + (pos + 1),
-        neighbors.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
-
-  // Now put the new information in the right index.
-  distances(pos, queryIndex) = distance;
-  neighbors(pos, queryIndex) = neighbor;
-}
-
 } // namespace neighbor
 } // namespace mlpack
 
@@ -169,13 +169,27 @@ void mlpack::neighbor::RAUtil::ObtainDistinctSamples(
     const size_t numSamples,
     const size_t rangeUpperBound,
     arma::uvec& distinctSamples)
+{
+  ObtainDistinctSamples(numSamples, rangeUpperBound, distinctSamples,
+      math::randGen);
+}
+
+void mlpack::neighbor::RAUtil::ObtainDistinctSamples(
+    const size_t numSamples,
+    const size_t rangeUpperBound,
+    arma::uvec& distinctSamples,
+    std::mt19937& generator)
 {
   // Keep track of the points that are sampled.
   arma::Col<size_t> sampledPoints;
   sampledPoints.zeros(rangeUpperBound);
 
+  // This draws the same numbers as math::RandInt() when the generator is
+  // math::randGen.
+  std::uniform_real_distribution<> uniform;
   for (size_t i = 0; i < numSamples; i++)
-    sampledPoints[(size_t) math::RandInt(rangeUpperBound)]++;
+    sampledPoints[(size_t) std::floor((double) rangeUpperBound *
+        uniform(generator))]++;
 
   distinctSamples = arma::find(sampledPoints > 0);
   return;
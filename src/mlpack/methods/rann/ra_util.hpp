@@ -56,6 +56,23 @@ class RAUtil
   static void ObtainDistinctSamples(const size_t numSamples,
                                     const size_t rangeUpperBound,
                                     arma::uvec& distinctSamples);
+
+  /**
+   * Pick up desired number of samples (with replacement) from a given range
+   * of integers so that only the distinct samples are returned from the range
+   * [0 - specified upper bound), using the given random number generator
+   * instead of the global one.  This is used by threads that each draw
+   * samples from their own stream.
+   *
+   * @param numSamples Number of random samples.
+   * @param rangeUpperBound The upper bound on the range of integers.
+   * @param distinctSamples The list of the distinct samples.
+   * @param generator Random number generator to draw the samples with.
+   */
+  static void ObtainDistinctSamples(const size_t numSamples,
+                                    const size_t rangeUpperBound,
+                                    arma::uvec& distinctSamples,
+                                    std::mt19937& generator);
 };
 
 } // namespace neighbor
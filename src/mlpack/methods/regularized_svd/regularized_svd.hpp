@@ -10,6 +10,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
 #include <mlpack/methods/cf/cf.hpp>
 
 #include "regularized_svd_function.hpp"
@@ -29,6 +30,12 @@ namespace svd {
  * http://sifter.org/~simon/journal/20061211.html
  * http://www.cs.uic.edu/~liub/KDD-cup-2007/proceedings/Regular-Paterek.pdf
  *
+ * Each SGD update only touches the factors of one user and one item, so it
+ * takes O(rank) time.  With the ParallelSGD optimizer
+ * (RegularizedSVD<optimization::ParallelSGD>), the updates are done by several
+ * threads at once without locking (Hogwild!); since different ratings rarely
+ * share a user or an item, this scales well with the number of threads.
+ *
  * An example of how to use the interface is shown below:
  *
  * @code
@@ -61,9 +68,10 @@ class RegularizedSVD
    * Constructor for Regularized SVD. Obtains the user and item matrices after
    * training on the passed data. The constructor initiates an object of class
    * RegularizedSVDFunction for optimization. It uses the SGD optimizer by
-   * default. The optimizer uses a template specialization of Optimize().
+   * default.
    *
-   * @param iterations Number of optimization iterations.
+   * @param iterations Number of optimization iterations (passes over the
+   *     ratings).
    * @param alpha Learning rate for the SGD optimizer.
    * @param lambda Regularization parameter for the optimization.
    */
@@ -85,6 +93,24 @@ class RegularizedSVD
              arma::mat& v);
 
  private:
+  //! Return the maximum number of iterations of SGD, which takes a step for
+  //! one rating in each iteration.
+  size_t MaxIterations(
+      const optimization::SGD<RegularizedSVDFunction>& /* optimizer */,
+      const size_t numRatings) const
+  {
+    return iterations * numRatings;
+  }
+
+  //! Return the maximum number of iterations of ParallelSGD, which makes a
+  //! pass over all the ratings in each iteration.
+  size_t MaxIterations(
+      const optimization::ParallelSGD<RegularizedSVDFunction>& /* optimizer */,
+      const size_t /* numRatings */) const
+  {
+    return iterations;
+  }
+
   //! Number of optimization iterations.
   size_t iterations;
   //! Learning rate for the SGD optimizer.
@@ -108,6 +134,16 @@ class FactorizerTraits<mlpack::svd::RegularizedSVD<> >
   static const bool UsesCoordinateList = true;
 };
 
+//! Factorizer traits of Regularized SVD with the ParallelSGD optimizer.
+template<>
+class FactorizerTraits<mlpack::svd::RegularizedSVD<
+    mlpack::optimization::ParallelSGD> >
+{
+ public:
+  //! Data provided to RegularizedSVD need not be cleaned.
+  static const bool UsesCoordinateList = true;
+};
+
 } // namespace cf
 } // namespace mlpack
 
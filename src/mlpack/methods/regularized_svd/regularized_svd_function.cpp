@@ -116,66 +116,73 @@ void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
   }
 }
 
-} // namespace svd
-} // namespace mlpack
-
-// Template specialization for the SGD optimizer.
-namespace mlpack {
-namespace optimization {
-
-template<>
-double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(arma::mat& parameters)
+void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
+                                      const size_t i,
+                                      arma::sp_mat& gradient) const
 {
-  // Find the number of functions to use.
-  const size_t numFunctions = function.NumFunctions();
-
-  // To keep track of where we are and how things are going.
-  size_t currentFunction = 0;
-  double overallObjective = 0;
-
-  // Calculate the first objective function.
-  for(size_t i = 0; i < numFunctions; i++)
-    overallObjective += function.Evaluate(parameters, i);
-
-  const arma::mat data = function.Dataset();
+  // Indices for accessing the the correct parameter columns.
+  const size_t user = data(0, i);
+  const size_t item = data(1, i) + numUsers;
 
-  // Now iterate!
-  for(size_t i = 1; i != maxIterations; i++, currentFunction++)
+  // Prediction error for the example.
+  const double rating = data(2, i);
+  const double ratingError = rating - arma::dot(parameters.col(user),
+                                                parameters.col(item));
+
+  // The gradient is non-zero only for the user and the item columns (the user
+  // column comes first, since the item columns follow all the user columns).
+  arma::umat locations(2, 2 * rank);
+  arma::vec values(2 * rank);
+  for (size_t k = 0; k < rank; ++k)
   {
-    // Is this iteration the start of a sequence?
-    if((currentFunction % numFunctions) == 0)
-    {
-      // Reset the counter variables.
-      overallObjective = 0;
-      currentFunction = 0;
-    }
-
-    const size_t numUsers = function.NumUsers();
-
-    // Indices for accessing the the correct parameter columns.
-    const size_t user = data(0, currentFunction);
-    const size_t item = data(1, currentFunction) + numUsers;
-
-    // Prediction error for the example.
-    const double rating = data(2, currentFunction);
-    double ratingError = rating - arma::dot(parameters.col(user),
-                                            parameters.col(item));
+    locations(0, k) = k;
+    locations(1, k) = user;
+    values[k] = 2 * (lambda * parameters(k, user) -
+        ratingError * parameters(k, item));
+
+    locations(0, rank + k) = k;
+    locations(1, rank + k) = item;
+    values[rank + k] = 2 * (lambda * parameters(k, item) -
+        ratingError * parameters(k, user));
+  }
 
-    double lambda = function.Lambda();
+  // The locations are already sorted.
+  gradient = arma::sp_mat(locations, values, rank, numUsers + numItems, false);
+}
 
-    // Gradient is non-zero only for the parameter columns corresponding to the
-    // example.
-    parameters.col(user) -= stepSize * (lambda * parameters.col(user) -
-                                        ratingError * parameters.col(item));
-    parameters.col(item) -= stepSize * (lambda * parameters.col(item) -
-                                        ratingError * parameters.col(user));
+void RegularizedSVDFunction::Gradient(
+    const arma::mat& parameters,
+    const size_t i,
+    optimization::ColumnGradient& gradient) const
+{
+  // Indices for accessing the the correct parameter columns.
+  const size_t user = data(0, i);
+  const size_t item = data(1, i) + numUsers;
 
-    // Now add that to the overall objective function.
-    overallObjective += function.Evaluate(parameters, currentFunction);
-  }
+  // Prediction error for the example.
+  const double rating = data(2, i);
+  const double ratingError = rating - arma::dot(parameters.col(user),
+                                                parameters.col(item));
+
+  // The gradient is non-zero only for the user and the item columns.
+  gradient.Columns().set_size(2);
+  gradient.Columns()[0] = user;
+  gradient.Columns()[1] = item;
+
+  gradient.Values().set_size(rank, 2);
+  gradient.Values().col(0) = 2 * (lambda * parameters.col(user) -
+                                   ratingError * parameters.col(item));
+  gradient.Values().col(1) = 2 * (lambda * parameters.col(item) -
+                                   ratingError * parameters.col(user));
+}
 
-  return overallObjective;
+void RegularizedSVDFunction::GradientSupport(const size_t i,
+                                             arma::uvec& support) const
+{
+  support.set_size(2);
+  support[0] = (size_t) data(0, i);
+  support[1] = (size_t) data(1, i) + numUsers;
 }
 
-} // namespace optimization
+} // namespace svd
 } // namespace mlpack
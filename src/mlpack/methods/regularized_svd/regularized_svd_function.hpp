@@ -58,6 +58,43 @@ class RegularizedSVDFunction
   void Gradient(const arma::mat& parameters,
                 arma::mat& gradient) const;
 
+  /**
+   * Evaluates the gradient of the cost function for one training example.
+   * Only the columns of the user and the item of the example are nonzero, so
+   * the gradient is sparse.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param i Index of the training example to be used.
+   * @param gradient Calculated gradient for the parameters.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::sp_mat& gradient) const;
+
+  /**
+   * Evaluates the gradient of the cost function for one training example, as
+   * its two nonzero columns (the user column first, then the item column).
+   * This takes O(rank) time, and is used by the SGD and ParallelSGD
+   * optimizers.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param i Index of the training example to be used.
+   * @param gradient Calculated nonzero columns of the gradient.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                optimization::ColumnGradient& gradient) const;
+
+  /**
+   * Give the columns of the gradient of one training example (the user column,
+   * then the item column) without computing it.  SGD uses this to apply its
+   * lazy weight decay to these columns before computing the gradient.
+   *
+   * @param i Index of the training example.
+   * @param support Vector to store the indices of the columns in.
+   */
+  void GradientSupport(const size_t i, arma::uvec& support) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
@@ -97,19 +134,4 @@ class RegularizedSVDFunction
 } // namespace svd
 } // namespace mlpack
 
-namespace mlpack {
-namespace optimization {
-
-  /**
-   * Template specialization for SGD optimizer. Used because the gradient
-   * affects only a small number of parameters per example, and thus the normal
-   * abstraction does not work as fast as we might like it to.
-   */
-  template<>
-  double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(
-      arma::mat& parameters);
-
-} // namespace optimization
-} // namespace mlpack
-
 #endif
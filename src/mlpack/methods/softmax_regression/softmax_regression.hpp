@@ -113,6 +113,40 @@ class SoftmaxRegression
    */
   void Predict(const arma::mat& testData, arma::Row<size_t>& predictions) const;
 
+  /**
+   * Score the given points in a single pass: the linear functions of the
+   * classes, the softmax and the choice of the most probable class are
+   * computed for each point at once, without temporary matrices, and blocks of
+   * points are scored in parallel.  The class probabilities and the predicted
+   * label of each point are written to the given matrix and row, which are
+   * only resized if they don't already have the right size (so preallocated
+   * buffers, or buffers wrapping memory of the caller, are reused).
+   *
+   * The points can be dense or sparse, and of doubles or floats (in which
+   * case the probabilities are floats, and are computed with floats).  A
+   * std::invalid_argument is thrown if the dimensionality of the points is
+   * not the one of the model.
+   *
+   * @param points Points to score (one per column).
+   * @param probabilities Class probabilities (one column per point).
+   * @param labels Predicted label of each point.
+   */
+  template<typename ScoreMatType>
+  void Score(const ScoreMatType& points,
+             arma::Mat<typename ScoreMatType::elem_type>& probabilities,
+             arma::Row<size_t>& labels) const;
+
+  /**
+   * Predict the labels of the given points in a single parallel pass, as
+   * Score() does, but without computing the probabilities: the label is the
+   * class with the largest linear function.
+   *
+   * @param points Points to score (one per column).
+   * @param labels Predicted label of each point.
+   */
+  template<typename ScoreMatType>
+  void Score(const ScoreMatType& points, arma::Row<size_t>& labels) const;
+
   /**
    * Computes accuracy of the learned model given the feature data and the
    * labels associated with each data point. Predictions are made using the
@@ -182,6 +216,32 @@ class SoftmaxRegression
   }
 
  private:
+  /**
+   * Call the given function with the index of each of the given points and
+   * a buffer holding the linear functions of the classes for the point, in
+   * parallel blocks of points, after checking their dimensionality.
+   */
+  template<typename ScoreMatType, typename FunctionType>
+  void ScoreColumns(const ScoreMatType& points, FunctionType function) const;
+
+  //! Add the linear functions of the classes of the given dense point to the
+  //! given buffer.
+  template<typename eT>
+  static void AddLinearScores(const arma::Mat<eT>& points,
+                              const size_t col,
+                              const arma::Mat<eT>& weights,
+                              const size_t offset,
+                              eT* scores);
+
+  //! Add the linear functions of the classes of the given sparse point to the
+  //! given buffer.
+  template<typename eT>
+  static void AddLinearScores(const arma::SpMat<eT>& points,
+                              const size_t col,
+                              const arma::Mat<eT>& weights,
+                              const size_t offset,
+                              eT* scores);
+
   //! Parameters after optimization.
   arma::mat parameters;
   //! Number of classes.
@@ -105,6 +105,21 @@ void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
     const arma::mat& parameters,
     arma::mat& probabilities) const
 {
+  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+}
+
+/**
+ * Evaluate the probabilities matrix of a batch of training examples.  The
+ * columns of the batch are used where they are, without a copy.
+ */
+void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
+    const arma::mat& parameters,
+    arma::mat& probabilities,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  const arma::mat batch(const_cast<double*>(data.colptr(begin)), data.n_rows,
+      batchSize, false, true);
   arma::mat hypothesis;
 
   if (fitIntercept)
@@ -115,12 +130,12 @@ void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
     //
     // Since the cost of join maybe high due to the copy of original data,
     // split the hypothesis computation to two components.
-    hypothesis = arma::exp(arma::repmat(parameters.col(0), 1, data.n_cols) +
-                           parameters.cols(1, parameters.n_cols - 1) * data);
+    hypothesis = arma::exp(arma::repmat(parameters.col(0), 1, batch.n_cols) +
+                           parameters.cols(1, parameters.n_cols - 1) * batch);
   }
   else
   {
-    hypothesis = arma::exp(parameters * data);
+    hypothesis = arma::exp(parameters * batch);
   }
 
   probabilities = hypothesis / arma::repmat(arma::sum(hypothesis, 0),
@@ -141,62 +156,121 @@ double SoftmaxRegressionFunction::Evaluate(const arma::mat& parameters) const
   // 'm' is the number of training examples.
   // The cost also takes into account the regularization to control the
   // parameter weights.
+  //
+  // The objectives of the batches add up to the full objective, so it is
+  // computed one block of training examples at a time (so that the matrix of
+  // class probabilities has at most BlockSize columns), and each thread sums
+  // the objectives of the blocks of its own range of training examples.
+  const size_t ranges = NumRanges();
+  arma::vec objectives = arma::zeros<arma::vec>(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * data.n_cols / ranges;
+    const size_t end = (r + 1) * data.n_cols / ranges;
+    for (size_t i = begin; i < end; i += BlockSize)
+    {
+      objectives[r] += Evaluate(parameters, i,
+          std::min((size_t) BlockSize, end - i), true);
+    }
+  });
 
-  // Calculate the class probabilities for each training example. The
-  // probabilities for each of the classes are given by:
-  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
-  // The sum is calculated over all the classes.
-  // x_i is the input vector for a particular training example.
-  // theta_j is the parameter vector associated with a particular class.
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities);
+  return arma::accu(objectives);
+}
+
+/**
+ * Calculates and stores the gradient values given a set of parameters.
+ */
+void SoftmaxRegressionFunction::Gradient(const arma::mat& parameters,
+                                         arma::mat& gradient) const
+{
+  // As in Evaluate(), the gradients of the blocks of training examples are
+  // summed by each thread over its own range, and then the sums of the ranges
+  // are added.
+  const size_t ranges = NumRanges();
+  std::vector<arma::mat> gradients(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * data.n_cols / ranges;
+    const size_t end = (r + 1) * data.n_cols / ranges;
+    gradients[r].zeros(parameters.n_rows, parameters.n_cols);
+
+    arma::mat blockGradient;
+    for (size_t i = begin; i < end; i += BlockSize)
+    {
+      Gradient(parameters, i, blockGradient,
+          std::min((size_t) BlockSize, end - i));
+      gradients[r] += blockGradient;
+    }
+  });
+
+  gradient = gradients[0];
+  for (size_t r = 1; r < ranges; ++r)
+    gradient += gradients[r];
+}
 
-  // Calculate the log likelihood and regularization terms.
-  double logLikelihood, weightDecay, cost;
+/**
+ * Split the training examples into one range per thread, but with at least one
+ * block of training examples in each range.
+ */
+size_t SoftmaxRegressionFunction::NumRanges() const
+{
+  const size_t blocks = (data.n_cols + BlockSize - 1) / BlockSize;
+  return std::max((size_t) 1, std::min(ThreadPool::Threads(), blocks));
+}
 
-  logLikelihood = arma::accu(groundTruth % arma::log(probabilities)) /
-                  data.n_cols;
-  weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
+/**
+ * Evaluates the objective function of a batch of training examples.
+ */
+double SoftmaxRegressionFunction::Evaluate(const arma::mat& parameters,
+                                           const size_t begin,
+                                           const size_t batchSize,
+                                           const bool /* deterministic */)
+    const
+{
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, probabilities, begin, batchSize);
 
-  // The cost is the sum of the negative log likelihood and the regularization
-  // terms.
-  cost = -logLikelihood + weightDecay;
+  // The log likelihood term is divided by the total number of training
+  // examples, and the batch takes its share of the regularization term.
+  const arma::sp_mat batchTruth = groundTruth.cols(begin,
+      begin + batchSize - 1);
+  const double logLikelihood = arma::accu(batchTruth %
+      arma::log(probabilities)) / data.n_cols;
+  const double weightDecay = 0.5 * lambda * arma::accu(parameters %
+      parameters) * batchSize / data.n_cols;
 
-  return cost;
+  return -logLikelihood + weightDecay;
 }
 
 /**
- * Calculates and stores the gradient values given a set of parameters.
+ * Calculates and stores the gradient values of a batch of training examples.
  */
 void SoftmaxRegressionFunction::Gradient(const arma::mat& parameters,
-                                         arma::mat& gradient) const
+                                         const size_t begin,
+                                         arma::mat& gradient,
+                                         const size_t batchSize) const
 {
-  // Calculate the class probabilities for each training example. The
-  // probabilities for each of the classes are given by:
-  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
-  // The sum is calculated over all the classes.
-  // x_i is the input vector for a particular training example.
-  // theta_j is the parameter vector associated with a particular class.
   arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities);
+  GetProbabilitiesMatrix(parameters, probabilities, begin, batchSize);
+
+  const arma::mat batch(const_cast<double*>(data.colptr(begin)), data.n_rows,
+      batchSize, false, true);
+  const double scale = (double) batchSize / data.n_cols;
 
-  // Calculate the parameter gradients.
+  // Calculate the parameter gradients, as in the full Gradient().
   gradient.set_size(parameters.n_rows, parameters.n_cols);
+  const arma::sp_mat batchTruth = groundTruth.cols(begin,
+      begin + batchSize - 1);
+  const arma::mat inner = probabilities - batchTruth;
   if (fitIntercept)
   {
-    // Treating the intercept term parameters.col(0) seperately to avoid
-    // the cost of building matrix [1; data].
-    arma::mat inner = probabilities - groundTruth;
-    gradient.col(0) =
-      inner * arma::ones<arma::mat>(data.n_cols, 1) / data.n_cols +
-      lambda * parameters.col(0);
-    gradient.cols(1, parameters.n_cols - 1) =
-      inner * data.t() / data.n_cols +
-      lambda * parameters.cols(1, parameters.n_cols - 1);
+    gradient.col(0) = arma::sum(inner, 1) / data.n_cols +
+        scale * lambda * parameters.col(0);
+    gradient.cols(1, parameters.n_cols - 1) = inner * batch.t() / data.n_cols +
+        scale * lambda * parameters.cols(1, parameters.n_cols - 1);
   }
   else
   {
-    gradient = (probabilities - groundTruth) * data.t() / data.n_cols +
-               lambda * parameters;
+    gradient = inner * batch.t() / data.n_cols + scale * lambda * parameters;
   }
 }
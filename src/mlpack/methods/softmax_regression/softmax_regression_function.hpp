@@ -84,6 +84,20 @@ class SoftmaxRegressionFunction
   void GetProbabilitiesMatrix(const arma::mat& parameters,
                               arma::mat& probabilities) const;
 
+  /**
+   * Evaluate the probabilities matrix with the passed parameters, for the
+   * training examples begin to (begin + batchSize - 1) only.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param probabilities Pointer to arma::mat which stores the probabilities.
+   * @param begin Index of the first training example to use.
+   * @param batchSize Number of training examples to use.
+   */
+  void GetProbabilitiesMatrix(const arma::mat& parameters,
+                              arma::mat& probabilities,
+                              const size_t begin,
+                              const size_t batchSize) const;
+
   /**
    * Evaluates the objective function of the softmax regression model using the
    * given parameters. The cost function has terms for the log likelihood error
@@ -91,6 +105,10 @@ class SoftmaxRegressionFunction
    * the model generalizes well for the given training data, while having small
    * parameter values.
    *
+   * The training examples are processed in blocks of BlockSize, so that the
+   * matrix of class probabilities does not grow with the number of training
+   * examples, and the blocks are split between the threads.
+   *
    * @param parameters Current values of the model parameters.
    */
   double Evaluate(const arma::mat& parameters) const;
@@ -99,16 +117,54 @@ class SoftmaxRegressionFunction
    * Evaluates the gradient values of the objective function given the current
    * set of parameters. The function calculates the probabilities for each class
    * given the parameters, and computes the gradients based on the difference
-   * from the ground truth.
+   * from the ground truth.  As in Evaluate(), the training examples are
+   * processed in blocks, in parallel.
    *
    * @param parameters Current values of the model parameters.
    * @param gradient Matrix where gradient values will be stored.
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluates the objective function of the softmax regression model on the
+   * training examples begin to (begin + batchSize - 1).  The log likelihood
+   * term is still divided by the total number of training examples, and the
+   * regularization term is split evenly over the training examples, so that
+   * the objectives of all the batches add up to Evaluate(parameters).  This is
+   * used by the MiniBatchSGD optimizer.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first training example to use.
+   * @param batchSize Number of training examples to use.
+   * @param deterministic Unused (there is nothing random in the objective).
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic) const;
+
+  /**
+   * Evaluates the gradient of the objective function on the training examples
+   * begin to (begin + batchSize - 1), with the same scaling as the batch
+   * Evaluate(), using one matrix multiplication.  This is used by the
+   * MiniBatchSGD optimizer.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first training example to use.
+   * @param gradient Matrix where gradient values will be stored.
+   * @param batchSize Number of training examples to use.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
+  //! Return the number of training examples, for mini-batch optimizers.
+  size_t NumFunctions() const { return data.n_cols; }
+
   //! Gets the number of classes.
   size_t NumClasses() const { return numClasses; }
 
@@ -128,6 +184,14 @@ class SoftmaxRegressionFunction
   bool FitIntercept() const { return fitIntercept; }
 
  private:
+  //! The number of training examples whose class probabilities are computed at
+  //! once by the full Evaluate() and Gradient().
+  static const size_t BlockSize = 1024;
+
+  //! Return the number of ranges of training examples that the full Evaluate()
+  //! and Gradient() split between the threads.
+  size_t NumRanges() const;
+
   //! Training data matrix.
   const arma::mat& data;
   //! Label matrix for the provided data.
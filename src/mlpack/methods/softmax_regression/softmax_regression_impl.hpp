@@ -61,56 +61,147 @@ void SoftmaxRegression<OptimizerType>::Predict(const arma::mat& testData,
                                                arma::Row<size_t>& predictions)
     const
 {
-  if (testData.n_rows != FeatureSize())
-  {
-    std::ostringstream oss;
-    oss << "SoftmaxRegression::Predict(): test data has " << testData.n_rows
-        << " dimensions, but model has " << FeatureSize() << "dimensions";
-    throw std::invalid_argument(oss.str());
-  }
+  Score(testData, predictions);
+}
 
-  // Calculate the probabilities for each test input.
-  arma::mat hypothesis, probabilities;
-  if (fitIntercept)
+template<template<typename> class OptimizerType>
+template<typename ScoreMatType>
+void SoftmaxRegression<OptimizerType>::Score(
+    const ScoreMatType& points,
+    arma::Mat<typename ScoreMatType::elem_type>& probabilities,
+    arma::Row<size_t>& labels) const
+{
+  typedef typename ScoreMatType::elem_type ElemType;
+
+  probabilities.set_size(numClasses, points.n_cols);
+  labels.set_size(points.n_cols);
+  size_t* labelsMem = labels.memptr();
+  ScoreColumns(points, [&](const size_t i, const ElemType* scores)
   {
-    // In order to add the intercept term, we should compute following matrix:
-    //     [1; data] = arma::join_cols(ones(1, data.n_cols), data)
-    //     hypothesis = arma::exp(parameters * [1; data]).
-    //
-    // Since the cost of join maybe high due to the copy of original data,
-    // split the hypothesis computation to two components.
-    hypothesis = arma::exp(
-      arma::repmat(parameters.col(0), 1, testData.n_cols) +
-      parameters.cols(1, parameters.n_cols - 1) * testData);
-  }
-  else
+    // Subtract the largest score before exponentiating, so that the
+    // exponentials can't overflow.
+    size_t best = 0;
+    for (size_t j = 1; j < numClasses; ++j)
+      if (scores[j] > scores[best])
+        best = j;
+
+    ElemType* column = probabilities.colptr(i);
+    ElemType sum = 0;
+    for (size_t j = 0; j < numClasses; ++j)
+    {
+      column[j] = std::exp(scores[j] - scores[best]);
+      sum += column[j];
+    }
+    for (size_t j = 0; j < numClasses; ++j)
+      column[j] /= sum;
+
+    labelsMem[i] = best;
+  });
+}
+
+template<template<typename> class OptimizerType>
+template<typename ScoreMatType>
+void SoftmaxRegression<OptimizerType>::Score(const ScoreMatType& points,
+                                             arma::Row<size_t>& labels) const
+{
+  typedef typename ScoreMatType::elem_type ElemType;
+
+  // The softmax is increasing, so the most probable class is the one with the
+  // largest score.
+  labels.set_size(points.n_cols);
+  size_t* labelsMem = labels.memptr();
+  ScoreColumns(points, [&](const size_t i, const ElemType* scores)
   {
-    hypothesis = arma::exp(parameters * testData);
-  }
+    size_t best = 0;
+    for (size_t j = 1; j < numClasses; ++j)
+      if (scores[j] > scores[best])
+        best = j;
 
-  probabilities = hypothesis / arma::repmat(arma::sum(hypothesis, 0),
-                                            numClasses, 1);
+    labelsMem[i] = best;
+  });
+}
 
-  // Prepare necessary data.
-  predictions.zeros(testData.n_cols);
-  double maxProbability = 0;
+template<template<typename> class OptimizerType>
+template<typename ScoreMatType, typename FunctionType>
+void SoftmaxRegression<OptimizerType>::ScoreColumns(
+    const ScoreMatType& points,
+    FunctionType function) const
+{
+  typedef typename ScoreMatType::elem_type ElemType;
+
+  if (points.n_rows != FeatureSize())
+  {
+    std::ostringstream oss;
+    oss << "SoftmaxRegression::Score(): the points have " << points.n_rows
+        << " dimensions, but the model has " << FeatureSize();
+    throw std::invalid_argument(oss.str());
+  }
 
-  // For each test input.
-  for (size_t i = 0; i < testData.n_cols; i++)
+  // The parameters are converted once to the element type of the points.  The
+  // points are split into blocks, so that each block needs a single buffer
+  // for the scores.
+  const arma::Mat<ElemType> weights =
+      arma::conv_to<arma::Mat<ElemType>>::from(parameters);
+  const size_t offset = fitIntercept ? 1 : 0;
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (points.n_cols + blockSize - 1) / blockSize;
+  ThreadPool::ParallelFor(0, numBlocks, [&](const size_t block)
   {
-    // For each class.
-    for (size_t j = 0; j < numClasses; j++)
+    std::vector<ElemType> scores(numClasses);
+    const size_t end = std::min((size_t) points.n_cols,
+        (block + 1) * blockSize);
+    for (size_t i = block * blockSize; i < end; ++i)
     {
-      // If a higher class probability is encountered, change prediction.
-      if (probabilities(j, i) > maxProbability)
-      {
-        maxProbability = probabilities(j, i);
-        predictions(i) = j;
-      }
+      if (fitIntercept)
+        std::copy(weights.colptr(0), weights.colptr(0) + numClasses,
+            scores.begin());
+      else
+        std::fill(scores.begin(), scores.end(), ElemType(0));
+
+      AddLinearScores(points, i, weights, offset, scores.data());
+      function(i, (const ElemType*) scores.data());
     }
+  });
+}
 
-    // Set maximum probability to zero for the next input.
-    maxProbability = 0;
+template<template<typename> class OptimizerType>
+template<typename eT>
+void SoftmaxRegression<OptimizerType>::AddLinearScores(
+    const arma::Mat<eT>& points,
+    const size_t col,
+    const arma::Mat<eT>& weights,
+    const size_t offset,
+    eT* scores)
+{
+  // Each column of the weights holds the coefficients of one dimension for all
+  // the classes, so it is added contiguously.
+  const eT* point = points.colptr(col);
+  for (size_t d = 0; d < points.n_rows; ++d)
+  {
+    if (point[d] == eT(0))
+      continue;
+
+    const eT* w = weights.colptr(d + offset);
+    for (size_t j = 0; j < weights.n_rows; ++j)
+      scores[j] += w[j] * point[d];
+  }
+}
+
+template<template<typename> class OptimizerType>
+template<typename eT>
+void SoftmaxRegression<OptimizerType>::AddLinearScores(
+    const arma::SpMat<eT>& points,
+    const size_t col,
+    const arma::Mat<eT>& weights,
+    const size_t offset,
+    eT* scores)
+{
+  typename arma::SpMat<eT>::const_iterator it = points.begin_col(col);
+  for (; it != points.end_col(col); ++it)
+  {
+    const eT* w = weights.colptr(it.row() + offset);
+    for (size_t j = 0; j < weights.n_rows; ++j)
+      scores[j] += w[j] * (*it);
   }
 }
 
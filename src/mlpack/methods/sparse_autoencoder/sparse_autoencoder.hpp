@@ -52,7 +52,14 @@ namespace nn {
  * @endcode
  *
  * This implementation allows the use of arbitrary mlpack optimizers via the
- * OptimizerType template parameter.
+ * OptimizerType template parameter.  Mini-batch optimizers such as MiniBatchSGD
+ * and Adam can be used too, since SparseAutoencoderFunction is decomposable:
+ *
+ * @code
+ * SparseAutoencoderFunction saf(data, vSize, hSize);
+ * MiniBatchSGD<SparseAutoencoderFunction> sgd(saf, 256, 0.1, 100000);
+ * SparseAutoencoder<MiniBatchSGD> encoder3(sgd);
+ * @endcode
  *
  * @tparam OptimizerType The optimizer to use; by default this is L-BFGS.  Any
  *     mlpack optimizer can be used here.
@@ -21,7 +21,8 @@ SparseAutoencoderFunction::SparseAutoencoderFunction(const arma::mat& data,
     hiddenSize(hiddenSize),
     lambda(lambda),
     beta(beta),
-    rho(rho)
+    rho(rho),
+    activationMomentum(0.99)
 {
   // Initialize the parameters to suitable values.
   initialPoint = InitializeWeights();
@@ -79,35 +80,41 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   // to control the parameter weights and sparsity of the model respectively.
 
   // Compute the limits for the parameters w1, w2, b1 and b2.
-  const size_t l1 = hiddenSize;
   const size_t l2 = visibleSize;
   const size_t l3 = 2 * hiddenSize;
 
-  // w1, w2, b1 and b2 are not extracted separately, 'parameters' is directly
-  // used in their place to avoid copying data. The following representations
-  // are used:
-  // w1 <- parameters.submat(0, 0, l1-1, l2-1)
-  // w2 <- parameters.submat(l1, 0, l3-1, l2-1).t()
-  // b1 <- parameters.submat(0, l2, l1-1, l2)
-  // b2 <- parameters.submat(l3, 0, l3, l2-1).t()
-
-  arma::mat hiddenLayer, outputLayer;
-
-  // Compute activations of the hidden and output layers.
-  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
-      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, data.n_cols),
-      hiddenLayer);
-
-  Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
-      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, data.n_cols),
-      outputLayer);
-
-  arma::mat rhoCap, diff;
+  // The reconstruction error and the sums of the activations of the hidden
+  // layer are accumulated one block of data points at a time (so that the
+  // activation matrices have at most BlockSize columns), and each thread sums
+  // the blocks of its own range of data points.
+  const size_t ranges = NumRanges();
+  arma::vec errors = arma::zeros<arma::vec>(ranges);
+  std::vector<arma::vec> activationSums(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * data.n_cols / ranges;
+    const size_t end = (r + 1) * data.n_cols / ranges;
+    activationSums[r].zeros(hiddenSize);
+
+    arma::mat hiddenLayer, outputLayer;
+    for (size_t i = begin; i < end; i += BlockSize)
+    {
+      const size_t batchSize = std::min((size_t) BlockSize, end - i);
+      HiddenActivations(parameters, i, batchSize, hiddenLayer);
+      OutputActivations(parameters, hiddenLayer, outputLayer);
+
+      // Difference between the reconstructed data and the original data.
+      const arma::mat diff = outputLayer - data.cols(i, i + batchSize - 1);
+      errors[r] += arma::accu(diff % diff);
+      activationSums[r] += arma::sum(hiddenLayer, 1);
+    }
+  });
 
   // Average activations of the hidden layer.
-  rhoCap = arma::sum(hiddenLayer, 1) / data.n_cols;
-  // Difference between the reconstructed data and the original data.
-  diff = outputLayer - data;
+  arma::vec rhoCap = activationSums[0];
+  for (size_t r = 1; r < ranges; ++r)
+    rhoCap += activationSums[r];
+  rhoCap /= data.n_cols;
 
   double wL2SquaredNorm;
 
@@ -123,7 +130,7 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   // of the weights w1 and w2. 'klDivergence' is the cost of the hidden layer
   // activations not being low. It is given by the following formula:
   // KL = sum_over_hSize(rho*log(rho/rhoCaq) + (1-rho)*log((1-rho)/(1-rhoCap)))
-  sumOfSquaresError = 0.5 * arma::accu(diff % diff) / data.n_cols;
+  sumOfSquaresError = 0.5 * arma::accu(errors) / data.n_cols;
   weightDecay = 0.5 * lambda * wL2SquaredNorm;
   klDivergence = beta * arma::accu(rho * arma::log(rho / rhoCap) + (1 - rho) *
       arma::log((1 - rho) / (1 - rhoCap)));
@@ -139,17 +146,128 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
 void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
                                          arma::mat& gradient) const
 {
-  // Performs a feedforward pass of the neural network, and computes the
-  // activations of the output layer as in the Evaluate() method. It uses the
-  // Backpropagation algorithm to calculate the delta values at each layer,
-  // except for the input layer. The delta values are then used with input layer
-  // and hidden layer activations to get the parameter gradients.
+  // The sparsity term of the delta values of the hidden layer depends on the
+  // average activations of the hidden layer over all the data points, so they
+  // are computed first, in blocks, in parallel.
+  const size_t ranges = NumRanges();
+  std::vector<arma::vec> activationSums(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * data.n_cols / ranges;
+    const size_t end = (r + 1) * data.n_cols / ranges;
+    activationSums[r].zeros(hiddenSize);
+
+    arma::mat hiddenLayer;
+    for (size_t i = begin; i < end; i += BlockSize)
+    {
+      HiddenActivations(parameters, i, std::min((size_t) BlockSize, end - i),
+          hiddenLayer);
+      activationSums[r] += arma::sum(hiddenLayer, 1);
+    }
+  });
+
+  arma::vec rhoCap = activationSums[0];
+  for (size_t r = 1; r < ranges; ++r)
+    rhoCap += activationSums[r];
+  rhoCap /= data.n_cols;
+
+  // Then the gradients of the blocks are summed by each thread over its own
+  // range, and the sums of the ranges are added.
+  std::vector<arma::mat> gradients(ranges);
+  ThreadPool::ParallelFor(0, ranges, [&](const size_t r)
+  {
+    const size_t begin = r * data.n_cols / ranges;
+    const size_t end = (r + 1) * data.n_cols / ranges;
+    gradients[r].zeros(2 * hiddenSize + 1, visibleSize + 1);
+
+    arma::mat blockGradient;
+    for (size_t i = begin; i < end; i += BlockSize)
+    {
+      BatchGradient(parameters, i, std::min((size_t) BlockSize, end - i),
+          rhoCap, blockGradient);
+      gradients[r] += blockGradient;
+    }
+  });
+
+  gradient = gradients[0];
+  for (size_t r = 1; r < ranges; ++r)
+    gradient += gradients[r];
+}
 
-  // Compute the limits for the parameters w1, w2, b1 and b2.
-  const size_t l1 = hiddenSize;
+/** Evaluates the objective function on a batch of data points.
+  */
+double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters,
+                                           const size_t begin,
+                                           const size_t batchSize,
+                                           const bool /* deterministic */)
+    const
+{
   const size_t l2 = visibleSize;
   const size_t l3 = 2 * hiddenSize;
 
+  arma::mat hiddenLayer, outputLayer;
+  HiddenActivations(parameters, begin, batchSize, hiddenLayer);
+  OutputActivations(parameters, hiddenLayer, outputLayer);
+
+  // Before the first mini-batch gradient, the batch's own average activations
+  // are used.
+  const arma::vec rhoCap = (averageActivations.n_elem == hiddenSize) ?
+      averageActivations : arma::vec(arma::sum(hiddenLayer, 1) / batchSize);
+
+  const arma::mat diff = outputLayer - data.cols(begin, begin + batchSize - 1);
+  const double scale = (double) batchSize / data.n_cols;
+
+  // The reconstruction error is divided by the total number of data points,
+  // and the batch takes its share of the other terms.
+  const double sumOfSquaresError = 0.5 * arma::accu(diff % diff) / data.n_cols;
+  const double weightDecay = 0.5 * lambda * arma::accu(parameters.submat(0, 0,
+      l3 - 1, l2 - 1) % parameters.submat(0, 0, l3 - 1, l2 - 1));
+  const double klDivergence = beta * arma::accu(rho * arma::log(rho / rhoCap) +
+      (1 - rho) * arma::log((1 - rho) / (1 - rhoCap)));
+
+  return sumOfSquaresError + scale * (weightDecay + klDivergence);
+}
+
+/** Calculates and stores the gradient values on a batch of data points.
+  */
+void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
+                                         const size_t begin,
+                                         arma::mat& gradient,
+                                         const size_t batchSize) const
+{
+  // Update the running estimate of the average activations with the
+  // activations of the batch.
+  arma::mat hiddenLayer;
+  HiddenActivations(parameters, begin, batchSize, hiddenLayer);
+  const arma::vec batchActivations = arma::sum(hiddenLayer, 1) / batchSize;
+  if (averageActivations.n_elem != hiddenSize)
+    averageActivations = batchActivations;
+  else
+    averageActivations = activationMomentum * averageActivations +
+        (1 - activationMomentum) * batchActivations;
+
+  BatchGradient(parameters, begin, batchSize, averageActivations, gradient);
+}
+
+/**
+ * Split the data points into one range per thread, but with at least one block
+ * of data points in each range.
+ */
+size_t SparseAutoencoderFunction::NumRanges() const
+{
+  const size_t blocks = (data.n_cols + BlockSize - 1) / BlockSize;
+  return std::max((size_t) 1, std::min(ThreadPool::Threads(), blocks));
+}
+
+void SparseAutoencoderFunction::HiddenActivations(const arma::mat& parameters,
+                                                  const size_t begin,
+                                                  const size_t batchSize,
+                                                  arma::mat& hiddenLayer) const
+{
+  // Compute the limits for the parameters w1 and b1.
+  const size_t l1 = hiddenSize;
+  const size_t l2 = visibleSize;
+
   // w1, w2, b1 and b2 are not extracted separately, 'parameters' is directly
   // used in their place to avoid copying data. The following representations
   // are used:
@@ -157,24 +275,57 @@ void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
   // w2 <- parameters.submat(l1, 0, l3-1, l2-1).t()
   // b1 <- parameters.submat(0, l2, l1-1, l2)
   // b2 <- parameters.submat(l3, 0, l3, l2-1).t()
+  //
+  // The columns of the batch are used where they are, without a copy.
+  const arma::mat batch(const_cast<double*>(data.colptr(begin)), data.n_rows,
+      batchSize, false, true);
 
-  arma::mat hiddenLayer, outputLayer;
+  arma::mat preactivation = parameters.submat(0, 0, l1 - 1, l2 - 1) * batch;
+  preactivation.each_col() += parameters.submat(0, l2, l1 - 1, l2);
+  Sigmoid(preactivation, hiddenLayer);
+}
+
+void SparseAutoencoderFunction::OutputActivations(const arma::mat& parameters,
+                                                  const arma::mat& hiddenLayer,
+                                                  arma::mat& outputLayer) const
+{
+  // Compute the limits for the parameters w2 and b2.
+  const size_t l1 = hiddenSize;
+  const size_t l2 = visibleSize;
+  const size_t l3 = 2 * hiddenSize;
+
+  arma::mat preactivation = parameters.submat(l1, 0, l3 - 1, l2 - 1).t() *
+      hiddenLayer;
+  preactivation.each_col() += parameters.submat(l3, 0, l3, l2 - 1).t();
+  Sigmoid(preactivation, outputLayer);
+}
+
+void SparseAutoencoderFunction::BatchGradient(const arma::mat& parameters,
+                                              const size_t begin,
+                                              const size_t batchSize,
+                                              const arma::vec& rhoCap,
+                                              arma::mat& gradient) const
+{
+  // Performs a feedforward pass of the neural network, and computes the
+  // activations of the output layer as in the Evaluate() method. It uses the
+  // Backpropagation algorithm to calculate the delta values at each layer,
+  // except for the input layer. The delta values are then used with input layer
+  // and hidden layer activations to get the parameter gradients.
 
-  // Compute activations of the hidden and output layers.
-  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
-      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, data.n_cols),
-      hiddenLayer);
+  // Compute the limits for the parameters w1, w2, b1 and b2.
+  const size_t l1 = hiddenSize;
+  const size_t l2 = visibleSize;
+  const size_t l3 = 2 * hiddenSize;
 
-  Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
-      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, data.n_cols),
-      outputLayer);
+  const arma::mat batch(const_cast<double*>(data.colptr(begin)), data.n_rows,
+      batchSize, false, true);
 
-  arma::mat rhoCap, diff;
+  arma::mat hiddenLayer, outputLayer;
+  HiddenActivations(parameters, begin, batchSize, hiddenLayer);
+  OutputActivations(parameters, hiddenLayer, outputLayer);
 
-  // Average activations of the hidden layer.
-  rhoCap = arma::sum(hiddenLayer, 1) / data.n_cols;
   // Difference between the reconstructed data and the original data.
-  diff = outputLayer - data;
+  const arma::mat diff = outputLayer - batch;
 
   arma::mat klDivGrad, delOut, delHid;
 
@@ -186,20 +337,22 @@ void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
   // includes the KL divergence term, we adjust for that in the formula below.
   klDivGrad = beta * (-(rho / rhoCap) + (1 - rho) / (1 - rhoCap));
   delOut = diff % outputLayer % (1 - outputLayer);
-  delHid = (parameters.submat(l1, 0, l3 - 1, l2 - 1) * delOut +
-      arma::repmat(klDivGrad, 1, data.n_cols)) % hiddenLayer %
-      (1 - hiddenLayer);
+  delHid = parameters.submat(l1, 0, l3 - 1, l2 - 1) * delOut;
+  delHid.each_col() += klDivGrad;
+  delHid %= hiddenLayer % (1 - hiddenLayer);
 
   gradient.zeros(2 * hiddenSize + 1, visibleSize + 1);
 
   // Compute the gradient values using the activations and the delta values. The
-  // formula also accounts for the regularization terms in the objective.
-  // function.
-  gradient.submat(0, 0, l1 - 1, l2 - 1) = delHid * data.t() / data.n_cols +
-      lambda * parameters.submat(0, 0, l1 - 1, l2 - 1);
+  // formula also accounts for the regularization terms in the objective
+  // function; the batch takes its share of them.
+  const double scale = (double) batchSize / data.n_cols;
+  gradient.submat(0, 0, l1 - 1, l2 - 1) = delHid * batch.t() / data.n_cols +
+      scale * lambda * parameters.submat(0, 0, l1 - 1, l2 - 1);
   gradient.submat(l1, 0, l3 - 1, l2 - 1) =
       (delOut * hiddenLayer.t() / data.n_cols +
-      lambda * parameters.submat(l1, 0, l3 - 1, l2 - 1).t()).t();
+      scale * lambda * parameters.submat(l1, 0, l3 - 1, l2 - 1).t()).t();
   gradient.submat(0, l2, l1 - 1, l2) = arma::sum(delHid, 1) / data.n_cols;
-  gradient.submat(l3, 0, l3, l2 - 1) = (arma::sum(delOut, 1) / data.n_cols).t();
+  gradient.submat(l3, 0, l3, l2 - 1) = (arma::sum(delOut, 1) /
+      data.n_cols).t();
 }
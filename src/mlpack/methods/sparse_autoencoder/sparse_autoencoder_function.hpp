@@ -17,6 +17,13 @@ namespace nn {
  * This is a class for the sparse autoencoder objective function. It can be used
  * to create learning models like self-taught learning, stacked autoencoders,
  * conditional random fields (CRFs), and so forth.
+ *
+ * The function can be optimized on the whole dataset (for instance with
+ * L-BFGS), in which case the data points are processed in parallel blocks, or
+ * one mini-batch at a time (with MiniBatchSGD or Adam).  The sparsity term
+ * depends on the average activations of the hidden layer over the whole
+ * dataset, so mini-batch gradients use a running estimate of them instead,
+ * which each mini-batch gradient updates.
  */
 class SparseAutoencoderFunction
 {
@@ -65,6 +72,72 @@ class SparseAutoencoderFunction
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluates the objective function on the data points begin to (begin +
+   * batchSize - 1).  The reconstruction error is still divided by the total
+   * number of data points, and the batch takes its share of the regularization
+   * and sparsity terms, so that the objectives of all the batches add up to the
+   * full objective (with the running estimate of the average activations in
+   * place of the exact ones, once there is one).  This is used by the
+   * MiniBatchSGD optimizer.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first data point to use.
+   * @param batchSize Number of data points to use.
+   * @param deterministic Unused (there is nothing random in the objective).
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize,
+                  const bool deterministic) const;
+
+  /**
+   * Evaluates the gradient of the objective function on the data points begin
+   * to (begin + batchSize - 1), with the same scaling as the batch Evaluate().
+   * The running estimate of the average activations of the hidden layer is
+   * first updated with the activations of the batch, so this should not be
+   * called from several threads at once.  This is used by the MiniBatchSGD
+   * optimizer.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first data point to use.
+   * @param gradient Matrix where gradient values will be stored.
+   * @param batchSize Number of data points to use.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const;
+
+  /**
+   * Evaluates the objective function on the given data point only, as the
+   * batch Evaluate() with a batch of one point.  This is used by the Adam
+   * optimizer.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the data point to use.
+   */
+  double Evaluate(const arma::mat& parameters, const size_t i) const
+  {
+    return Evaluate(parameters, i, 1, true);
+  }
+
+  /**
+   * Evaluates the gradient of the objective function on the given data point
+   * only, as the batch Gradient() with a batch of one point.  This is used by
+   * the Adam optimizer.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the data point to use.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::mat& gradient) const
+  {
+    Gradient(parameters, i, gradient, 1);
+  }
+
   /**
    * Returns the elementwise sigmoid of the passed matrix, where the sigmoid
    * function of a real number 'x' is [1 / (1 + exp(-x))].
@@ -79,6 +152,22 @@ class SparseAutoencoderFunction
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
+  //! Return the number of data points, for mini-batch optimizers.
+  size_t NumFunctions() const { return data.n_cols; }
+
+  //! Get the running estimate of the average activations of the hidden layer
+  //! (empty before the first mini-batch gradient).
+  const arma::vec& AverageActivations() const { return averageActivations; }
+  //! Modify the running estimate of the average activations.
+  arma::vec& AverageActivations() { return averageActivations; }
+
+  //! Get the weight of the previous running estimate of the average
+  //! activations when it is updated with a mini-batch.
+  double ActivationMomentum() const { return activationMomentum; }
+  //! Modify the weight of the previous running estimate of the average
+  //! activations.
+  double& ActivationMomentum() { return activationMomentum; }
+
   //! Sets size of the visible layer.
   void VisibleSize(const size_t visible)
   {
@@ -140,6 +229,36 @@ class SparseAutoencoderFunction
   }
 
  private:
+  //! The number of data points whose activations are computed at once by the
+  //! full Evaluate() and Gradient().
+  static const size_t BlockSize = 1024;
+
+  //! Return the number of ranges of data points that the full Evaluate() and
+  //! Gradient() split between the threads.
+  size_t NumRanges() const;
+
+  //! Compute the activations of the hidden layer for the data points begin to
+  //! (begin + batchSize - 1).
+  void HiddenActivations(const arma::mat& parameters,
+                         const size_t begin,
+                         const size_t batchSize,
+                         arma::mat& hiddenLayer) const;
+
+  //! Compute the activations of the output layer from the activations of the
+  //! hidden layer.
+  void OutputActivations(const arma::mat& parameters,
+                         const arma::mat& hiddenLayer,
+                         arma::mat& outputLayer) const;
+
+  //! Compute the gradient on the data points begin to (begin + batchSize - 1),
+  //! with the given average activations of the hidden layer, scaled so that
+  //! the gradients of all the batches add up to the full gradient.
+  void BatchGradient(const arma::mat& parameters,
+                     const size_t begin,
+                     const size_t batchSize,
+                     const arma::vec& rhoCap,
+                     arma::mat& gradient) const;
+
   //! The matrix of data points.
   const arma::mat& data;
   //! Initial parameter vector.
@@ -154,6 +273,10 @@ class SparseAutoencoderFunction
   double beta;
   //! Sparsity parameter.
   double rho;
+  //! The running estimate of the average activations of the hidden layer.
+  mutable arma::vec averageActivations;
+  //! The weight of the previous running estimate when it is updated.
+  double activationMomentum;
 };
 
 } // namespace nn
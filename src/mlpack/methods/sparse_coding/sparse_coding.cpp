@@ -6,6 +6,7 @@
  * l1+l2 (Elastic Net) regularization.
  */
 #include "sparse_coding.hpp"
+#include "sparse_coding_encoder.hpp"
 
 namespace mlpack {
 namespace sparse_coding {
@@ -29,26 +30,7 @@ SparseCoding::SparseCoding(
 
 void SparseCoding::Encode(const arma::mat& data, arma::mat& codes)
 {
-  // When using the Cholesky version of LARS, this is correct even if
-  // lambda2 > 0.
-  arma::mat matGram = trans(dictionary) * dictionary;
-
-  codes.set_size(atoms, data.n_cols);
-  for (size_t i = 0; i < data.n_cols; ++i)
-  {
-    // Report progress.
-    if ((i % 100) == 0)
-      Log::Debug << "Optimization at point " << i << "." << std::endl;
-
-    bool useCholesky = true;
-    regression::LARS lars(useCholesky, matGram, lambda1, lambda2);
-
-    // Create an alias of the code (using the same memory), and then LARS will
-    // place the result directly into that; then we will not need to have an
-    // extra copy.
-    arma::vec code = codes.unsafe_col(i);
-    lars.Train(dictionary, data.unsafe_col(i), code, false);
-  }
+  SparseCodingEncoder(dictionary, lambda1, lambda2).Encode(data, codes);
 }
 
 // Dictionary step for optimization.
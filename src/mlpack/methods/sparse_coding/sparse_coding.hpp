@@ -180,7 +180,10 @@ class SparseCoding
 
   /**
    * Sparse code each point in the given dataset via LARS, using the current
-   * dictionary and store the encoded data in the codes matrix.
+   * dictionary and store the encoded data in the codes matrix.  The points are
+   * coded in parallel, and all their LARS problems share the Gram matrix of the
+   * dictionary.  To encode many batches of points with the same dictionary,
+   * use a SparseCodingEncoder, which computes the Gram matrix only once.
    *
    * @param data Input data matrix to be encoded.
    * @param codes Output codes matrix.
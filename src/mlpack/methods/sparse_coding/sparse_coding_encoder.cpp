@@ -0,0 +1,111 @@
+/**
+ * @file sparse_coding_encoder.cpp
+ *
+ * Implementation of the SparseCodingEncoder class.
+ */
+#include "sparse_coding_encoder.hpp"
+
+namespace mlpack {
+namespace sparse_coding {
+
+SparseCodingEncoder::SparseCodingEncoder(const SparseCoding& model,
+                                         const size_t maxActiveSize) :
+    SparseCodingEncoder(model.Dictionary(), model.Lambda1(), model.Lambda2(),
+        maxActiveSize)
+{
+  // Nothing to do.
+}
+
+SparseCodingEncoder::SparseCodingEncoder(const arma::mat& dictionary,
+                                         const double lambda1,
+                                         const double lambda2,
+                                         const size_t maxActiveSize) :
+    dictionary(dictionary),
+    // When using the Cholesky version of LARS, this is correct even if
+    // lambda2 > 0.
+    gram(trans(dictionary) * dictionary),
+    lambda1(lambda1),
+    lambda2(lambda2),
+    maxActiveSize(maxActiveSize)
+{
+  // Nothing to do.
+}
+
+SparseCodingEncoder::SparseCodingEncoder(const SparseCodingEncoder& other) :
+    dictionary(other.dictionary),
+    gram(other.gram),
+    lambda1(other.lambda1),
+    lambda2(other.lambda2),
+    maxActiveSize(other.maxActiveSize)
+{
+  // Nothing to do.
+}
+
+SparseCodingEncoder& SparseCodingEncoder::operator=(
+    const SparseCodingEncoder& other)
+{
+  if (this != &other)
+  {
+    dictionary = other.dictionary;
+    gram = other.gram;
+    lambda1 = other.lambda1;
+    lambda2 = other.lambda2;
+    maxActiveSize = other.maxActiveSize;
+    solvers.clear();
+  }
+
+  return *this;
+}
+
+void SparseCodingEncoder::Encode(const arma::mat& data, arma::mat& codes)
+{
+  if (data.n_rows != dictionary.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "SparseCodingEncoder::Encode(): the points have " << data.n_rows
+        << " dimensions, but the dictionary has " << dictionary.n_rows;
+    throw std::invalid_argument(oss.str());
+  }
+
+  Log::Debug << "Optimizing the codes of " << data.n_cols << " points."
+      << std::endl;
+
+  // Each thread of the loop uses its own solver.  If the loop will run
+  // serially (because this is called from a parallel region), only the first
+  // solver is used.
+  const bool serial = ThreadPool::InParallel();
+  const size_t threads = serial ? 1 : ThreadPool::Threads();
+  while (solvers.size() < threads)
+  {
+    solvers.emplace_back(new regression::LARS(true, gram, lambda1, lambda2));
+    solvers.back()->MaxActiveSize() = maxActiveSize;
+  }
+
+  // The codes of the points are independent, so blocks of points are coded in
+  // parallel.
+  codes.set_size(dictionary.n_cols, data.n_cols);
+  const size_t blocks = (data.n_cols + EncodeBlockSize - 1) / EncodeBlockSize;
+  ThreadPool::ParallelFor(0, blocks, [&](const size_t b)
+  {
+    size_t thread = 0;
+    #ifdef _OPENMP
+      if (!serial)
+        thread = omp_get_thread_num();
+    #endif
+    regression::LARS& lars = *solvers[thread];
+
+    const size_t end = std::min((size_t) data.n_cols,
+        (b + 1) * EncodeBlockSize);
+    for (size_t i = b * EncodeBlockSize; i < end; ++i)
+    {
+      // Create an alias of the code (using the same memory), and then LARS
+      // will place the result directly into that; then we will not need to
+      // have an extra copy.
+      arma::vec code = codes.unsafe_col(i);
+      lars.Train(dictionary, data.unsafe_col(i), code, false);
+    }
+  });
+}
+
+} // namespace sparse_coding
+} // namespace mlpack
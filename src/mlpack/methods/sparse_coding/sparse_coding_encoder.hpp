@@ -0,0 +1,124 @@
+/**
+ * @file sparse_coding_encoder.hpp
+ *
+ * Definition of the SparseCodingEncoder class, which encodes new points with a
+ * trained sparse coding dictionary.
+ */
+#ifndef MLPACK_METHODS_SPARSE_CODING_SPARSE_CODING_ENCODER_HPP
+#define MLPACK_METHODS_SPARSE_CODING_SPARSE_CODING_ENCODER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/lars/lars.hpp>
+
+#include "sparse_coding.hpp"
+
+namespace mlpack {
+namespace sparse_coding {
+
+/**
+ * A SparseCodingEncoder encodes batches of points with a fixed dictionary (for
+ * instance, the dictionary of a trained SparseCoding model), solving the same
+ * LASSO (or Elastic Net) problem for each point as SparseCoding::Encode().  It
+ * is meant to be kept alive and used for many batches: the Gram matrix of the
+ * dictionary is computed once, when the encoder is created, and each thread
+ * keeps its own Cholesky LARS solver (which refers to the Gram matrix) from
+ * one batch to the next.  The points of a batch are coded in parallel.
+ *
+ * Optionally, the number of nonzero coefficients of each code can be bounded:
+ * LARS then stops once that many atoms are active, which also bounds the time
+ * spent on each point.
+ *
+ * @code
+ * SparseCoding sc(data, 200, 0.1);
+ * SparseCodingEncoder encoder(sc, 10);
+ *
+ * arma::mat codes;
+ * while (...)
+ *   encoder.Encode(batch, codes);
+ * @endcode
+ *
+ * Encode() must not be called by several threads at once on the same encoder
+ * (use one encoder per calling thread instead); copies of an encoder share
+ * nothing.
+ */
+class SparseCodingEncoder
+{
+ public:
+  /**
+   * Create an encoder for the dictionary and the regularization parameters of
+   * the given sparse coding model.
+   *
+   * @param model Trained sparse coding model.
+   * @param maxActiveSize Maximum number of nonzero coefficients of each code
+   *     (0 means no limit).
+   */
+  SparseCodingEncoder(const SparseCoding& model,
+                      const size_t maxActiveSize = 0);
+
+  /**
+   * Create an encoder for the given dictionary.
+   *
+   * @param dictionary Dictionary (columns are atoms).
+   * @param lambda1 Regularization parameter for the l1-norm penalty.
+   * @param lambda2 Regularization parameter for the l2-norm penalty.
+   * @param maxActiveSize Maximum number of nonzero coefficients of each code
+   *     (0 means no limit).
+   */
+  SparseCodingEncoder(const arma::mat& dictionary,
+                      const double lambda1,
+                      const double lambda2 = 0.0,
+                      const size_t maxActiveSize = 0);
+
+  //! Copy the given encoder (but not its solvers, which refer to its Gram
+  //! matrix).
+  SparseCodingEncoder(const SparseCodingEncoder& other);
+
+  //! Copy the given encoder (but not its solvers, which refer to its Gram
+  //! matrix).
+  SparseCodingEncoder& operator=(const SparseCodingEncoder& other);
+
+  /**
+   * Encode each of the given points with LARS.  A std::invalid_argument is
+   * thrown if the dimensionality of the points is not the one of the
+   * dictionary.
+   *
+   * @param data Points to encode (one per column).
+   * @param codes Matrix to store the codes in (one per column).
+   */
+  void Encode(const arma::mat& data, arma::mat& codes);
+
+  //! Get the dictionary.
+  const arma::mat& Dictionary() const { return dictionary; }
+  //! Get the Gram matrix of the dictionary.
+  const arma::mat& Gram() const { return gram; }
+  //! Get the L1 regularization parameter.
+  double Lambda1() const { return lambda1; }
+  //! Get the L2 regularization parameter.
+  double Lambda2() const { return lambda2; }
+  //! Get the maximum number of nonzero coefficients of each code (0 means no
+  //! limit).
+  size_t MaxActiveSize() const { return maxActiveSize; }
+
+ private:
+  //! Dictionary (columns are atoms).
+  arma::mat dictionary;
+  //! Gram matrix of the dictionary.
+  arma::mat gram;
+  //! l1 regularization term.
+  double lambda1;
+  //! l2 regularization term.
+  double lambda2;
+  //! Maximum number of nonzero coefficients of each code (0 means no limit).
+  size_t maxActiveSize;
+
+  //! The LARS solver of each thread, created when first needed.
+  std::vector<std::unique_ptr<regression::LARS>> solvers;
+
+  //! The number of points coded by each task in Encode().
+  static const size_t EncodeBlockSize = 16;
+};
+
+} // namespace sparse_coding
+} // namespace mlpack
+
+#endif
@@ -20,7 +20,9 @@ PROGRAM_INFO("Sparse Coding", "An implementation of Sparse Coding with "
     "\n\n"
     "The sparse coding is found with an algorithm which alternates between a "
     "dictionary step, which updates the dictionary D, and a sparse coding step,"
-    " which updates the sparse coding matrix."
+    " which updates the sparse coding matrix.  The sparse coding step, which "
+    "takes most of the time, codes the points in parallel; the number of "
+    "threads can be set with --threads (-j)."
     "\n\n"
     "Once a dictionary D is found, the sparse coding model may be used to "
     "encode other matrices, and saved for future usage."
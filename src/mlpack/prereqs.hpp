@@ -24,6 +24,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <tuple>
+#include <memory>
 
 // Defining _USE_MATH_DEFINES should set M_PI.
 #define _USE_MATH_DEFINES
@@ -47,6 +48,20 @@
   #define force_inline __forceinline
 #endif
 
+// Include OpenMP if it is available.  Any code that uses OpenMP routines (as
+// opposed to only pragmas) must guard them with #ifdef _OPENMP.
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+// The Visual Studio OpenMP implementation only supports signed loop indices,
+// so parallel loops should use omp_size_t as their index type.
+#ifdef _WIN32
+  #define omp_size_t intmax_t
+#else
+  #define omp_size_t size_t
+#endif
+
 // We'll need the necessary boost::serialization features, as well as what we
 // use with mlpack.  In Boost 1.59 and newer, the BOOST_PFTO code is no longer
 // defined, but we still need to define it (as nothing) so that the mlpack
@@ -878,4 +878,46 @@ BOOST_AUTO_TEST_CASE(DecisionStumpSerializationTest)
   }
 }
 
+/**
+ * Make sure that the parallel, blocked classification gives the same results
+ * as accumulating the votes of each weak learner over the whole test set.
+ */
+BOOST_AUTO_TEST_CASE(BlockedClassifyTest)
+{
+  arma::mat inputData;
+  if (!data::Load("iris.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset iris.csv!");
+
+  arma::Mat<size_t> labels;
+  if (!data::Load("iris_labels.txt", labels))
+    BOOST_FAIL("Cannot load labels for iris_labels.txt");
+
+  DecisionStump<> ds(inputData, labels.row(0), 3, 6);
+  AdaBoost<DecisionStump<>> a(inputData, labels.row(0), ds, 50, 1e-10);
+
+  // Make the test set larger than one block.
+  arma::mat testData = arma::repmat(inputData, 1, 20);
+  testData += 0.1 * arma::randn<arma::mat>(testData.n_rows, testData.n_cols);
+
+  arma::mat votes(a.Classes(), testData.n_cols);
+  votes.zeros();
+  for (size_t i = 0; i < a.WeakLearners(); ++i)
+  {
+    arma::Row<size_t> weakPredictions(testData.n_cols);
+    a.WeakLearner(i).Classify(testData, weakPredictions);
+    for (size_t j = 0; j < testData.n_cols; ++j)
+      votes(weakPredictions[j], j) += a.Alpha(i);
+  }
+
+  arma::Row<size_t> predictedLabels;
+  a.Classify(testData, predictedLabels);
+  BOOST_REQUIRE_EQUAL(predictedLabels.n_elem, testData.n_cols);
+  for (size_t j = 0; j < testData.n_cols; ++j)
+  {
+    arma::uword maxIndex;
+    votes.unsafe_col(j).max(maxIndex);
+    BOOST_REQUIRE_EQUAL(predictedLabels[j], (size_t) maxIndex);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
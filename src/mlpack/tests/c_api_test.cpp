@@ -0,0 +1,217 @@
+/**
+ * @file c_api_test.cpp
+ *
+ * Tests for the C API of mlpack: models saved by the C++ library must give the
+ * same predictions through the C API.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/bindings/c/mlpack.h>
+#include <mlpack/methods/neighbor_search/ns_model.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/hoeffding_trees/hoeffding_tree.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+using namespace mlpack;
+
+BOOST_AUTO_TEST_SUITE(CAPITest);
+
+/**
+ * Make sure kNN search through the C API gives the same results as NSModel,
+ * and writes them into the caller's arrays.
+ */
+BOOST_AUTO_TEST_CASE(CAPIKNNTest)
+{
+  const arma::mat referenceData = arma::randu<arma::mat>(4, 300);
+  const arma::mat queryData = arma::randu<arma::mat>(4, 50);
+
+  neighbor::NSModel<neighbor::NearestNeighborSort> model;
+  model.BuildModel(arma::mat(referenceData), 20, false, false);
+  data::Save("c_api_knn_model.xml", "knn_model", model);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  model.Search(arma::mat(queryData), 5, neighbors, distances);
+
+  mlpack_knn_model* cModel = mlpack_knn_load("c_api_knn_model.xml");
+  BOOST_REQUIRE(cModel != NULL);
+  BOOST_REQUIRE_EQUAL(mlpack_knn_dimensionality(cModel), 4);
+  BOOST_REQUIRE_EQUAL(mlpack_knn_num_points(cModel), 300);
+
+  std::vector<size_t> cNeighbors(5 * 50);
+  std::vector<double> cDistances(5 * 50);
+  BOOST_REQUIRE_EQUAL(mlpack_knn_search(cModel, queryData.memptr(), 4, 50, 5,
+      cNeighbors.data(), cDistances.data()), 0);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(cNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(cDistances[i], distances[i], 1e-5);
+  }
+
+  // Errors are reported, not thrown.
+  BOOST_REQUIRE_EQUAL(mlpack_knn_search(cModel, queryData.memptr(), 3, 50, 5,
+      cNeighbors.data(), cDistances.data()), -1);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+  BOOST_REQUIRE_EQUAL(mlpack_knn_search(cModel, queryData.memptr(), 4, 50, 301,
+      cNeighbors.data(), cDistances.data()), -1);
+
+  mlpack_knn_free(cModel);
+  remove("c_api_knn_model.xml");
+
+  BOOST_REQUIRE(mlpack_knn_load("c_api_nonexistent_model.xml") == NULL);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+}
+
+/**
+ * Make sure classification with a logistic regression model and densities of
+ * a GMM through the C API are the same as with the C++ models.
+ */
+BOOST_AUTO_TEST_CASE(CAPILogisticRegressionGMMTest)
+{
+  arma::mat data = arma::randn<arma::mat>(3, 200);
+  data.cols(100, 199) += 2.0;
+  arma::Row<size_t> responses(200);
+  responses.cols(0, 99).zeros();
+  responses.cols(100, 199).ones();
+
+  regression::LogisticRegression<> lr(data, responses);
+  data::Save("c_api_lr_model.xml", "logistic_regression_model", lr);
+
+  arma::Row<size_t> labels;
+  lr.Classify(data, labels);
+  arma::mat probabilities;
+  lr.Classify(data, probabilities);
+
+  mlpack_logistic_regression_model* cLR =
+      mlpack_logistic_regression_load("c_api_lr_model.xml");
+  BOOST_REQUIRE(cLR != NULL);
+  BOOST_REQUIRE_EQUAL(mlpack_logistic_regression_dimensionality(cLR), 3);
+
+  std::vector<size_t> cLabels(200);
+  std::vector<double> cProbabilities(200);
+  BOOST_REQUIRE_EQUAL(mlpack_logistic_regression_classify(cLR, data.memptr(),
+      3, 200, 0.5, cLabels.data(), cProbabilities.data()), 0);
+  for (size_t i = 0; i < 200; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(cLabels[i], labels[i]);
+    BOOST_REQUIRE_CLOSE(cProbabilities[i], probabilities(1, i), 1e-5);
+  }
+
+  mlpack_logistic_regression_free(cLR);
+  remove("c_api_lr_model.xml");
+
+  gmm::GMM g(2, 3);
+  g.Train(data);
+  data::Save("c_api_gmm_model.xml", "gmm", g);
+
+  arma::vec densities;
+  g.Probability(data, densities);
+
+  mlpack_gmm_model* cGMM = mlpack_gmm_load("c_api_gmm_model.xml");
+  BOOST_REQUIRE(cGMM != NULL);
+  BOOST_REQUIRE_EQUAL(mlpack_gmm_dimensionality(cGMM), 3);
+
+  std::vector<double> cDensities(200);
+  BOOST_REQUIRE_EQUAL(mlpack_gmm_probability(cGMM, data.memptr(), 3, 200, 0,
+      cDensities.data()), 0);
+  for (size_t i = 0; i < 200; ++i)
+    BOOST_REQUIRE_CLOSE(cDensities[i], densities[i], 1e-5);
+
+  BOOST_REQUIRE_EQUAL(mlpack_gmm_probability(cGMM, data.memptr(), 3, 200, 1,
+      cDensities.data()), 0);
+  for (size_t i = 0; i < 200; ++i)
+    BOOST_REQUIRE_CLOSE(cDensities[i], std::log(densities[i]), 1e-5);
+
+  mlpack_gmm_free(cGMM);
+  remove("c_api_gmm_model.xml");
+}
+
+/**
+ * Make sure that a Hoeffding tree saved by the C++ library classifies points
+ * the same way through the C API, and that bad arguments are reported.
+ */
+BOOST_AUTO_TEST_CASE(CAPIHoeffdingTreeTest)
+{
+  // The second dimension is categorical.
+  arma::mat data(3, 3000);
+  arma::Row<size_t> responses(3000);
+  data::DatasetInfo info(3);
+  info.MapString("a", 1);
+  info.MapString("b", 1);
+  for (size_t i = 0; i < 3000; ++i)
+  {
+    data(0, i) = math::Random();
+    data(1, i) = i % 2;
+    data(2, i) = math::Random();
+    responses[i] = (i % 2 == 0) ? 0 : ((data(0, i) > 0.5) ? 1 : 2);
+  }
+
+  tree::HoeffdingTree<> hoeffdingTree(data, info, responses, 3, false);
+  data::Save("c_api_hoeffding_tree_model.xml", "streamingDecisionTree",
+      hoeffdingTree);
+
+  arma::Row<size_t> labels;
+  arma::rowvec probabilities;
+  hoeffdingTree.Classify(data, labels, probabilities);
+
+  mlpack_hoeffding_tree_model* cTree = mlpack_hoeffding_tree_load(
+      "c_api_hoeffding_tree_model.xml", "domingos");
+  BOOST_REQUIRE(cTree != NULL);
+  BOOST_REQUIRE_EQUAL(mlpack_hoeffding_tree_dimensionality(cTree), 3);
+
+  std::vector<size_t> cLabels(3000);
+  std::vector<double> cProbabilities(3000);
+  BOOST_REQUIRE_EQUAL(mlpack_hoeffding_tree_classify(cTree, data.memptr(), 3,
+      3000, cLabels.data(), cProbabilities.data()), 0);
+  for (size_t i = 0; i < 3000; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(cLabels[i], labels[i]);
+    BOOST_REQUIRE_CLOSE(cProbabilities[i], probabilities[i], 1e-5);
+  }
+
+  // Points of the wrong dimensionality, a NULL model and an unknown split
+  // strategy are reported, not thrown.
+  BOOST_REQUIRE_EQUAL(mlpack_hoeffding_tree_classify(cTree, data.memptr(), 2,
+      3000, cLabels.data(), NULL), -1);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+  BOOST_REQUIRE_EQUAL(mlpack_hoeffding_tree_classify(NULL, data.memptr(), 3,
+      3000, cLabels.data(), NULL), -1);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+  BOOST_REQUIRE_EQUAL(mlpack_hoeffding_tree_dimensionality(NULL), 0);
+  BOOST_REQUIRE(mlpack_hoeffding_tree_load("c_api_hoeffding_tree_model.xml",
+      "unknown") == NULL);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+
+  mlpack_hoeffding_tree_free(cTree);
+  remove("c_api_hoeffding_tree_model.xml");
+}
+
+/**
+ * Make sure that the functions given a NULL model report a failure instead of
+ * crashing.
+ */
+BOOST_AUTO_TEST_CASE(CAPINullModelTest)
+{
+  const arma::mat points = arma::randu<arma::mat>(3, 10);
+  std::vector<size_t> labels(10);
+  std::vector<double> values(10);
+
+  BOOST_REQUIRE_EQUAL(mlpack_knn_search(NULL, points.memptr(), 3, 10, 1,
+      labels.data(), values.data()), -1);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+  BOOST_REQUIRE_EQUAL(mlpack_logistic_regression_classify(NULL,
+      points.memptr(), 3, 10, 0.5, labels.data(), NULL), -1);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+  BOOST_REQUIRE_EQUAL(mlpack_gmm_probability(NULL, points.memptr(), 3, 10, 0,
+      values.data()), -1);
+  BOOST_REQUIRE(std::string(mlpack_last_error()) != "");
+
+  BOOST_REQUIRE_EQUAL(mlpack_knn_dimensionality(NULL), 0);
+  BOOST_REQUIRE_EQUAL(mlpack_knn_num_points(NULL), 0);
+  BOOST_REQUIRE_EQUAL(mlpack_logistic_regression_dimensionality(NULL), 0);
+  BOOST_REQUIRE_EQUAL(mlpack_gmm_dimensionality(NULL), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
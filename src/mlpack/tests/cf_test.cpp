@@ -496,6 +496,8 @@ BOOST_AUTO_TEST_CASE(SerializationTest)
 
   CheckMatrices(c.W(), cXml.W(), cBinary.W(), cText.W());
   CheckMatrices(c.H(), cXml.H(), cBinary.H(), cText.H());
+  CheckMatrices(c.Neighborhood(), cXml.Neighborhood(), cBinary.Neighborhood(),
+      cText.Neighborhood());
 
   BOOST_REQUIRE_EQUAL(c.CleanedData().n_rows, cXml.CleanedData().n_rows);
   BOOST_REQUIRE_EQUAL(c.CleanedData().n_rows, cBinary.CleanedData().n_rows);
@@ -538,5 +540,227 @@ BOOST_AUTO_TEST_CASE(SerializationTest)
   }
 }
 
+/**
+ * Make sure that the neighborhoods computed when the model is trained are the
+ * nearest neighbors of each user, and that they are computed again when the
+ * neighborhood size changes.
+ */
+BOOST_AUTO_TEST_CASE(CFNeighborhoodTest)
+{
+  arma::sp_mat data;
+  data.sprandu(100, 80, 0.3);
+
+  CF c(data, amf::NMFALSFactorizer(), 5, 5);
+
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_rows, 5);
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_cols, 80);
+
+  c.NumUsersForSimilarity(3);
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_rows, 3);
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_cols, 80);
+
+  // Find the neighbors of each user by brute force, with the same distance.
+  const arma::mat stretchedH = arma::chol(c.W().t() * c.W()) * c.H();
+  for (size_t i = 0; i < stretchedH.n_cols; ++i)
+  {
+    arma::vec distances(stretchedH.n_cols);
+    for (size_t j = 0; j < stretchedH.n_cols; ++j)
+      distances[j] = arma::norm(stretchedH.col(i) - stretchedH.col(j), 2);
+    const arma::vec sortedDistances = arma::sort(distances);
+
+    for (size_t k = 0; k < 3; ++k)
+      BOOST_REQUIRE_SMALL(distances[c.Neighborhood()(k, i)] -
+          sortedDistances[k], 1e-5);
+  }
+
+  // The predictions should use the new neighborhoods.
+  for (size_t user = 0; user < 80; ++user)
+  {
+    double rating = 0.0;
+    for (size_t k = 0; k < 3; ++k)
+      rating += arma::dot(c.W().row(7), c.H().col(c.Neighborhood()(k, user)));
+    BOOST_REQUIRE_CLOSE(c.Predict(user, 7), rating / 3.0, 1e-5);
+  }
+}
+
+/**
+ * Make sure that a model can be trained when the neighborhood size is larger
+ * than the number of users.
+ */
+BOOST_AUTO_TEST_CASE(CFSmallNeighborhoodTest)
+{
+  arma::sp_mat data;
+  data.sprandu(50, 4, 0.5);
+
+  CF c(data, amf::NMFALSFactorizer(), 10, 2);
+
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_rows, 4);
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_cols, 4);
+
+  const double rating = c.Predict(1, 3);
+  BOOST_REQUIRE(std::isfinite(rating));
+}
+
+/**
+ * Make sure that the recommendations found with FastMKS are the same as the
+ * ones found by computing the estimated rating of every item.
+ */
+BOOST_AUTO_TEST_CASE(CFMaxInnerProductRecommendationsTest)
+{
+  arma::sp_mat data;
+  data.sprandu(200, 100, 0.1);
+
+  CF c(data, amf::NMFALSFactorizer(), 5, 5);
+
+  arma::Mat<size_t> recommendations, fastmksRecommendations;
+  c.GetRecommendations(10, recommendations);
+  c.GetMaxInnerProductRecommendations(10, fastmksRecommendations);
+
+  BOOST_REQUIRE_EQUAL(recommendations.n_rows, fastmksRecommendations.n_rows);
+  BOOST_REQUIRE_EQUAL(recommendations.n_cols, fastmksRecommendations.n_cols);
+  for (size_t i = 0; i < recommendations.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(recommendations[i], fastmksRecommendations[i]);
+
+  // Now for a few users only.
+  arma::Col<size_t> users("3 17 42 99");
+  c.GetRecommendations(10, recommendations, users);
+  c.GetMaxInnerProductRecommendations(10, fastmksRecommendations, users);
+
+  BOOST_REQUIRE_EQUAL(recommendations.n_rows, fastmksRecommendations.n_rows);
+  BOOST_REQUIRE_EQUAL(recommendations.n_cols, fastmksRecommendations.n_cols);
+  for (size_t i = 0; i < recommendations.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(recommendations[i], fastmksRecommendations[i]);
+
+  // The index of the items is not serialized, so a loaded model must build it
+  // again.
+  CF cXml, cText, cBinary;
+  SerializeObjectAll(c, cXml, cText, cBinary);
+  cXml.GetMaxInnerProductRecommendations(10, fastmksRecommendations, users);
+  for (size_t i = 0; i < recommendations.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(recommendations[i], fastmksRecommendations[i]);
+
+  // An untrained model has no index.
+  CF untrained;
+  BOOST_REQUIRE_THROW(untrained.GetMaxInnerProductRecommendations(10,
+      fastmksRecommendations), std::invalid_argument);
+}
+
+/**
+ * Make sure that new users are folded into a trained model: their factors
+ * should solve the regularized least-squares problem, and they should have
+ * neighborhoods.
+ */
+BOOST_AUTO_TEST_CASE(CFAddRatingsTest)
+{
+  arma::sp_mat data;
+  data.sprandu(100, 80, 0.3);
+
+  CF c(data, amf::NMFALSFactorizer(), 5, 5);
+  const arma::mat oldW = c.W();
+  const arma::mat oldH = c.H();
+
+  // Two new users (80 and 81), and a new rating for user 3.
+  arma::mat ratings("80 80 80 81 81 3;"
+                    "10 20 30 20 40 50;"
+                    "0.5 0.2 0.9 0.7 0.4 0.3");
+  c.AddRatings(ratings, 0.01);
+
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_rows, 100);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_cols, 82);
+  BOOST_REQUIRE_EQUAL(c.H().n_cols, 82);
+  BOOST_REQUIRE_EQUAL(c.Neighborhood().n_cols, 82);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+    BOOST_REQUIRE_CLOSE(c.CleanedData()(ratings(1, i), ratings(0, i)),
+        ratings(2, i), 1e-5);
+
+  // W and the factors of the users without new ratings do not change.
+  for (size_t i = 0; i < oldW.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(oldW[i], c.W()[i]);
+  for (size_t u = 0; u < 80; ++u)
+    for (size_t k = 0; k < oldH.n_rows && u != 3; ++k)
+      BOOST_REQUIRE_EQUAL(oldH(k, u), c.H()(k, u));
+
+  // The factors of each user with new ratings solve the normal equations.
+  const size_t users[3] = { 3, 80, 81 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const size_t u = users[i];
+    arma::vec gradient = 0.01 * c.H().col(u);
+    for (arma::sp_mat::const_iterator it = c.CleanedData().begin_col(u);
+         it != c.CleanedData().end_col(u); ++it)
+    {
+      const arma::rowvec wRow = c.W().row(it.row());
+      gradient += wRow.t() * (arma::as_scalar(wRow * c.H().col(u)) - *it);
+    }
+
+    for (size_t k = 0; k < gradient.n_elem; ++k)
+      BOOST_REQUIRE_SMALL(gradient[k], 1e-5);
+  }
+
+  // A pair rated several times in one batch keeps its last rating.
+  arma::mat repeatedRatings("82 5 82 82;"
+                            "10 7 10 11;"
+                            "0.1 0.6 0.8 0.2");
+  c.AddRatings(repeatedRatings, 0.01);
+
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_cols, 83);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().col(82).n_nonzero, 2);
+  BOOST_REQUIRE_CLOSE(c.CleanedData()(10, 82), 0.8, 1e-5);
+  BOOST_REQUIRE_CLOSE(c.CleanedData()(11, 82), 0.2, 1e-5);
+  BOOST_REQUIRE_CLOSE(c.CleanedData()(7, 5), 0.6, 1e-5);
+
+  // Unknown items are not allowed.
+  arma::mat badRatings("5; 100; 1.0");
+  BOOST_REQUIRE_THROW(c.AddRatings(badRatings), std::invalid_argument);
+}
+
+/**
+ * Make sure that the recommendations and the batch predictions do not depend on
+ * the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(CFParallelRecommendationsTest)
+{
+  arma::sp_mat data;
+  data.sprandu(200, 100, 0.1);
+
+  CF c(data, amf::NMFALSFactorizer(), 5, 5);
+
+  arma::Mat<size_t> combinations(2, 500);
+  for (size_t i = 0; i < combinations.n_cols; ++i)
+  {
+    combinations(0, i) = math::RandInt(100);
+    combinations(1, i) = math::RandInt(200);
+  }
+
+  arma::Mat<size_t> recommendations1, recommendations4;
+  arma::vec predictions1, predictions4;
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  c.GetRecommendations(10, recommendations1);
+  c.Predict(combinations, predictions1);
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  c.GetRecommendations(10, recommendations4);
+  c.Predict(combinations, predictions4);
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(recommendations1.n_elem, recommendations4.n_elem);
+  for (size_t i = 0; i < recommendations1.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(recommendations1[i], recommendations4[i]);
+
+  BOOST_REQUIRE_EQUAL(predictions1.n_elem, predictions4.n_elem);
+  for (size_t i = 0; i < predictions1.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(predictions1[i], predictions4[i]);
+
+  // None of the recommendations should be already rated.
+  for (size_t u = 0; u < recommendations1.n_cols; ++u)
+    for (size_t i = 0; i < recommendations1.n_rows; ++i)
+      BOOST_REQUIRE_EQUAL(data(recommendations1(i, u), u), 0.0);
+}
 
 BOOST_AUTO_TEST_SUITE_END();
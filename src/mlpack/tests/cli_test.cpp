@@ -222,6 +222,66 @@ BOOST_AUTO_TEST_CASE(TestPrefixedOutStreamModifiers)
       "I have a precise number which is 000156");
 }
 
+//! Count the calls, to see whether log arguments are evaluated.
+static int CountCall(int& calls) { return ++calls; }
+
+/**
+ * Make sure that MLPACK_LOG() only evaluates its arguments when the stream is
+ * enabled.
+ */
+BOOST_AUTO_TEST_CASE(LazyLogTest)
+{
+  std::stringstream ss;
+  PrefixedOutStream pss(ss, BASH_GREEN "[INFO ] " BASH_CLEAR, true);
+
+  int calls = 0;
+  MLPACK_LOG(pss) << "call " << CountCall(calls) << std::endl;
+  BOOST_REQUIRE_EQUAL(calls, 0);
+  BOOST_REQUIRE_EQUAL(ss.str(), "");
+
+  pss.ignoreInput = false;
+  MLPACK_LOG(pss) << "call " << CountCall(calls) << std::endl;
+  BOOST_REQUIRE_EQUAL(calls, 1);
+  BOOST_REQUIRE_EQUAL(ss.str(), BASH_GREEN "[INFO ] " BASH_CLEAR "call 1\n");
+
+  NullOutStream nos;
+  MLPACK_LOG(nos) << CountCall(calls);
+  BOOST_REQUIRE_EQUAL(calls, 1);
+}
+
+/**
+ * Make sure that lines written from a parallel loop are not interleaved.
+ */
+BOOST_AUTO_TEST_CASE(ParallelPrefixedOutStreamTest)
+{
+  std::stringstream ss;
+  PrefixedOutStream pss(ss, "[TEST] ");
+
+  ThreadPool::ParallelFor(0, 100, [&pss](const size_t i)
+  {
+    pss << "line " << i << " ";
+    pss << "written" << std::endl;
+  });
+
+  std::vector<bool> seen(100, false);
+  std::string line;
+  size_t lines = 0;
+  while (std::getline(ss, line))
+  {
+    std::istringstream lineStream(line);
+    std::string prefix, word, written;
+    size_t i = 100;
+    lineStream >> prefix >> word >> i >> written;
+    BOOST_REQUIRE_EQUAL(prefix + " " + word + " " + written,
+        "[TEST] line written");
+    BOOST_REQUIRE_LT(i, 100);
+    BOOST_REQUIRE(!seen[i]);
+    seen[i] = true;
+    ++lines;
+  }
+  BOOST_REQUIRE_EQUAL(lines, 100);
+}
+
 /**
  * We should be able to start and then stop a timer multiple times and it should
  * save the value.
@@ -284,4 +344,228 @@ BOOST_AUTO_TEST_CASE(TwiceStopTimerTest)
   BOOST_REQUIRE_THROW(Timer::Stop("test_timer"), std::runtime_error);
 }
 
+/**
+ * Make sure that timers started through handles on many threads are summed, and
+ * that a timer may be nested within itself.
+ */
+BOOST_AUTO_TEST_CASE(ThreadedTimerHandleTest)
+{
+  const TimerHandle outer = Timer::Register("handle_timer");
+  const TimerHandle inner = Timer::Register("inner", outer);
+  BOOST_REQUIRE_EQUAL(Timer::Register("handle_timer").Index(), outer.Index());
+  BOOST_REQUIRE_EQUAL(Timer::Register("handle_timer/inner").Index(),
+      inner.Index());
+
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < 4; ++i)
+  {
+    ScopedTimer outerTimer(outer);
+    {
+      // Only the outermost scope of each thread is timed.
+      ScopedTimer nestedTimer(outer);
+      ScopedTimer innerTimer(inner);
+      #ifdef _WIN32
+      Sleep(10);
+      #else
+      usleep(10000);
+      #endif
+    }
+  }
+
+  // Every iteration is counted, whichever thread ran it.
+  BOOST_REQUIRE_GE(Timer::Get("handle_timer").count(), 40000);
+  BOOST_REQUIRE_GE(Timer::Get("handle_timer/inner").count(), 40000);
+  BOOST_REQUIRE_LE(Timer::Get("handle_timer/inner").count(),
+      Timer::Get("handle_timer").count());
+
+  BOOST_REQUIRE_THROW(Timer::Stop(outer), std::runtime_error);
+}
+
+/**
+ * Make sure that a thread which uses two Timers objects alternately keeps its
+ * timers in each of them, so that a timer left running while the other object
+ * is used still runs, and can be stopped.
+ */
+BOOST_AUTO_TEST_CASE(InterleavedTimersTest)
+{
+  Timers timers;
+  const TimerHandle handle = Timers::Register("interleaved_timer");
+
+  timers.StartTimer(handle);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    Timer::Start("interleaved_cli_timer");
+    #ifdef _WIN32
+    Sleep(5);
+    #else
+    usleep(5000);
+    #endif
+    Timer::Stop("interleaved_cli_timer");
+
+    // Nest the running timer in itself, between the uses of the CLI timers.
+    timers.StartTimer(handle);
+    timers.StopTimer(handle);
+  }
+  timers.StopTimer(handle);
+
+  BOOST_REQUIRE_GE(timers.GetTimer("interleaved_timer").count(), 15000);
+  BOOST_REQUIRE_GE(Timer::Get("interleaved_cli_timer").count(), 15000);
+  BOOST_REQUIRE_EQUAL(timers.GetTimer("interleaved_cli_timer").count(), 0);
+
+  // Each object still knows which of its timers are running.
+  BOOST_REQUIRE_THROW(timers.StopTimer(handle), std::runtime_error);
+  BOOST_REQUIRE_THROW(Timer::Stop("interleaved_cli_timer"),
+      std::runtime_error);
+}
+
+/**
+ * Make sure that counters added to from many threads are summed.
+ */
+BOOST_AUTO_TEST_CASE(CounterTest)
+{
+  BOOST_REQUIRE_EQUAL(Counter::Get("test_counter"), 0);
+
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < 100; ++i)
+    Counter::Add("test_counter", 3);
+
+  BOOST_REQUIRE_EQUAL(Counter::Get("test_counter"), 300);
+}
+
+/**
+ * Make sure that hardware counters are added up for the timers they are enabled
+ * for, when they are available.
+ */
+BOOST_AUTO_TEST_CASE(HardwareCountersTest)
+{
+  Timers timers;
+  const TimerHandle handle = Timers::Register("hardware_counters_timer");
+
+  // Without hardware counters, nothing is counted.
+  timers.StartTimer(handle);
+  timers.StopTimer(handle);
+  BOOST_REQUIRE(timers.GetAllHardwareCounts().empty());
+
+  // The counters may not be compiled in, or not allowed by the system.
+  if (!timers.EnableHardwareCounters())
+  {
+    BOOST_TEST_MESSAGE("Hardware counters are unavailable; skipping.");
+    return;
+  }
+
+  double sum = 0.0;
+  timers.StartTimer(handle);
+  for (size_t i = 0; i < 100000; ++i)
+    sum += std::sqrt((double) i);
+  timers.StopTimer(handle);
+  BOOST_REQUIRE_GT(sum, 0.0);
+
+  std::map<std::string, HardwareCounters::Counts> counts =
+      timers.GetAllHardwareCounts();
+  BOOST_REQUIRE_EQUAL(counts.size(), 1);
+  BOOST_REQUIRE_GT(counts["hardware_counters_timer"][
+      HardwareCounters::INSTRUCTIONS], 100000);
+}
+
+/**
+ * Make sure that MemoryAccounting counts the tracked memory and its peak in
+ * nested scopes, and that the timers report the memory used while they run.
+ */
+BOOST_AUTO_TEST_CASE(MemoryAccountingTest)
+{
+  const uint64_t allocations =
+      MemoryAccounting::Allocations(MemoryAccounting::TREE_NODES);
+  const uint64_t current = MemoryAccounting::CurrentBytes();
+
+  const uint64_t outerState = MemoryAccounting::BeginPeak();
+  void* first = MemoryAccounting::Allocate(1000, MemoryAccounting::TREE_NODES);
+  BOOST_REQUIRE_EQUAL((size_t) first % 16, 0);
+
+  const uint64_t innerState = MemoryAccounting::BeginPeak();
+  void* second = MemoryAccounting::Allocate(3000,
+      MemoryAccounting::TREE_NODES, 64);
+  BOOST_REQUIRE_EQUAL((size_t) second % 64, 0);
+  MemoryAccounting::Free(second, MemoryAccounting::TREE_NODES);
+  BOOST_REQUIRE_GE(MemoryAccounting::EndPeak(innerState), current + 4000);
+
+  MemoryAccounting::Free(first, MemoryAccounting::TREE_NODES);
+  BOOST_REQUIRE_GE(MemoryAccounting::EndPeak(outerState), current + 4000);
+  BOOST_REQUIRE_EQUAL(MemoryAccounting::Allocations(
+      MemoryAccounting::TREE_NODES), allocations + 2);
+
+  // Memory usage is only reported for timers run with memory accounting.
+  Timers timers;
+  const TimerHandle handle = Timers::Register("memory_accounting_timer");
+  timers.StartTimer(handle);
+  timers.StopTimer(handle);
+  BOOST_REQUIRE(timers.GetAllMemoryUsage().empty());
+
+  timers.EnableMemoryAccounting();
+  timers.StartTimer(handle);
+  MemoryAccounting::Free(MemoryAccounting::Allocate(5000,
+      MemoryAccounting::TREE_NODES), MemoryAccounting::TREE_NODES);
+  timers.StopTimer(handle);
+
+  std::map<std::string, MemoryUsage> usage = timers.GetAllMemoryUsage();
+  BOOST_REQUIRE_EQUAL(usage.size(), 1);
+  BOOST_REQUIRE_GE(usage["memory_accounting_timer"].peakTrackedBytes, 5000);
+  BOOST_REQUIRE_GE(usage["memory_accounting_timer"].allocations, 1);
+}
+
+/**
+ * Make sure that ThreadPool::ParallelFor() visits every index once, for any
+ * block size.
+ */
+BOOST_AUTO_TEST_CASE(ThreadPoolParallelForTest)
+{
+  for (size_t blockSize = 1; blockSize < 20; blockSize += 6)
+  {
+    std::vector<size_t> visits(1000, 0);
+    ThreadPool::ParallelFor(3, 1000, [&visits](const size_t i)
+    {
+      ++visits[i];
+    }, blockSize);
+
+    for (size_t i = 0; i < 1000; ++i)
+      BOOST_REQUIRE_EQUAL(visits[i], (i < 3) ? 0 : 1);
+  }
+}
+
+//! Sum the integers in [begin, end) recursively, with a task for each half.
+static size_t TaskSum(const size_t begin, const size_t end)
+{
+  if (end - begin <= 100)
+  {
+    size_t sum = 0;
+    for (size_t i = begin; i < end; ++i)
+      sum += i;
+    return sum;
+  }
+
+  const size_t middle = (begin + end) / 2;
+  size_t left = 0;
+  size_t* leftPtr = &left;
+  ThreadPool::Spawn([leftPtr, begin, middle]()
+  {
+    *leftPtr = TaskSum(begin, middle);
+  });
+  const size_t right = TaskSum(middle, end);
+  ThreadPool::Wait();
+
+  return left + right;
+}
+
+/**
+ * Make sure that recursive tasks give the same result as a serial computation,
+ * both from Run() and outside of it.
+ */
+BOOST_AUTO_TEST_CASE(ThreadPoolTaskTest)
+{
+  size_t sum = 0;
+  ThreadPool::Run([&sum]() { sum = TaskSum(0, 100000); });
+  BOOST_REQUIRE_EQUAL(sum, (size_t) 100000 * 99999 / 2);
+
+  BOOST_REQUIRE_EQUAL(TaskSum(0, 100000), (size_t) 100000 * 99999 / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -11,6 +11,8 @@
 #include <mlpack/methods/ann/convolution_rules/naive_convolution.hpp>
 #include <mlpack/methods/ann/convolution_rules/fft_convolution.hpp>
 #include <mlpack/methods/ann/convolution_rules/svd_convolution.hpp>
+#include <mlpack/methods/ann/convolution_rules/im2col_convolution.hpp>
+#include <mlpack/methods/ann/layer/conv_layer.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -144,6 +146,10 @@ BOOST_AUTO_TEST_CASE(ValidConvolution2DTest)
   // speeded up the computation.
   Convolution2DMethodTest<SVDConvolution<ValidConvolution> >(input, filter,
       output);
+
+  // Perform the convolution through im2col and matrix multiplication.
+  Convolution2DMethodTest<Im2ColConvolution<ValidConvolution> >(input, filter,
+      output);
 }
 
 /**
@@ -181,6 +187,10 @@ BOOST_AUTO_TEST_CASE(FullConvolution2DTest)
   // speeded up the computation.
   Convolution2DMethodTest<SVDConvolution<FullConvolution> >(input, filter,
       output);
+
+  // Perform the convolution through im2col and matrix multiplication.
+  Convolution2DMethodTest<Im2ColConvolution<FullConvolution> >(input, filter,
+      output);
 }
 
 /**
@@ -226,6 +236,10 @@ BOOST_AUTO_TEST_CASE(ValidConvolution3DTest)
   // speeded up the computation.
   Convolution3DMethodTest<SVDConvolution<ValidConvolution> >(inputCube,
       filterCube, outputCube);
+
+  // Perform the convolution through im2col and matrix multiplication.
+  Convolution3DMethodTest<Im2ColConvolution<ValidConvolution> >(inputCube,
+      filterCube, outputCube);
 }
 
 /**
@@ -275,6 +289,10 @@ BOOST_AUTO_TEST_CASE(FullConvolution3DTest)
   // speeded up the computation.
   Convolution3DMethodTest<SVDConvolution<FullConvolution> >(inputCube,
       filterCube, outputCube);
+
+  // Perform the convolution through im2col and matrix multiplication.
+  Convolution3DMethodTest<Im2ColConvolution<FullConvolution> >(inputCube,
+      filterCube, outputCube);
 }
 
 /**
@@ -317,6 +335,10 @@ BOOST_AUTO_TEST_CASE(ValidConvolutionBatchTest)
   // speeded up the computation.
   ConvolutionMethodBatchTest<SVDConvolution<ValidConvolution> >(input,
       filterCube, outputCube);
+
+  // Perform the convolution through im2col and matrix multiplication.
+  ConvolutionMethodBatchTest<Im2ColConvolution<ValidConvolution> >(input,
+      filterCube, outputCube);
 }
 
 /**
@@ -363,6 +385,117 @@ BOOST_AUTO_TEST_CASE(FullConvolutionBatchTest)
   // speeded up the computation.
   ConvolutionMethodBatchTest<SVDConvolution<FullConvolution> >(input,
       filterCube, outputCube);
+
+  // Perform the convolution through im2col and matrix multiplication.
+  ConvolutionMethodBatchTest<Im2ColConvolution<FullConvolution> >(input,
+      filterCube, outputCube);
+}
+
+/**
+ * Check that the two given cubes have the same size and (nearly) the same
+ * elements.
+ */
+static void CheckCubesClose(const arma::cube& a, const arma::cube& b)
+{
+  BOOST_REQUIRE_EQUAL(a.n_rows, b.n_rows);
+  BOOST_REQUIRE_EQUAL(a.n_cols, b.n_cols);
+  BOOST_REQUIRE_EQUAL(a.n_slices, b.n_slices);
+
+  for (size_t i = 0; i < a.n_elem; ++i)
+  {
+    if (std::abs(a[i]) < 1e-8)
+      BOOST_REQUIRE_SMALL(b[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(a[i], b[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that ConvLayer computes the same forward pass, backward pass and
+ * gradient with the im2col convolution rules (which convolve all the maps in
+ * one matrix multiplication) as with the naive convolution rules.
+ */
+BOOST_AUTO_TEST_CASE(Im2ColConvLayerTest)
+{
+  ConvLayer<> naiveLayer(3, 2, 3, 2);
+  ConvLayer<Im2ColConvolution<ValidConvolution>,
+            Im2ColConvolution<FullConvolution>,
+            Im2ColConvolution<ValidConvolution> > im2colLayer(3, 2, 3, 2);
+
+  naiveLayer.Weights().randn();
+  im2colLayer.Weights() = naiveLayer.Weights();
+
+  arma::cube input(8, 7, 3, arma::fill::randu);
+  naiveLayer.InputParameter() = input;
+  im2colLayer.InputParameter() = input;
+
+  arma::cube naiveOutput, im2colOutput;
+  naiveLayer.Forward(input, naiveOutput);
+  im2colLayer.Forward(input, im2colOutput);
+
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_rows, 6);
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_cols, 6);
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_slices, 2);
+  CheckCubesClose(naiveOutput, im2colOutput);
+
+  arma::cube error(6, 6, 2, arma::fill::randn);
+  arma::cube naiveDelta, im2colDelta;
+  naiveLayer.Backward(naiveOutput, error, naiveDelta);
+  im2colLayer.Backward(im2colOutput, error, im2colDelta);
+
+  BOOST_REQUIRE_EQUAL(im2colDelta.n_rows, input.n_rows);
+  BOOST_REQUIRE_EQUAL(im2colDelta.n_cols, input.n_cols);
+  BOOST_REQUIRE_EQUAL(im2colDelta.n_slices, input.n_slices);
+  CheckCubesClose(naiveDelta, im2colDelta);
+
+  arma::cube naiveGradient, im2colGradient;
+  naiveLayer.Gradient(input, error, naiveGradient);
+  im2colLayer.Gradient(input, error, im2colGradient);
+
+  BOOST_REQUIRE_EQUAL(im2colGradient.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(im2colGradient.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(im2colGradient.n_slices, 6);
+  CheckCubesClose(naiveGradient, im2colGradient);
+}
+
+/**
+ * Make sure that ConvLayer computes the same forward pass, backward pass and
+ * gradient with the FFT convolution rules (which reuse the spectra of the
+ * filters) as with the naive convolution rules, also after the weights change.
+ */
+BOOST_AUTO_TEST_CASE(FFTConvLayerTest)
+{
+  ConvLayer<> naiveLayer(3, 2, 3, 2);
+  ConvLayer<FFTConvolution<ValidConvolution>,
+            FFTConvolution<FullConvolution>,
+            FFTConvolution<ValidConvolution> > fftLayer(3, 2, 3, 2);
+
+  arma::cube input(8, 7, 3, arma::fill::randu);
+  naiveLayer.InputParameter() = input;
+  fftLayer.InputParameter() = input;
+
+  // The second time, the spectra of the old weights must not be used.
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    naiveLayer.Weights().randn();
+    fftLayer.Weights() = naiveLayer.Weights();
+
+    arma::cube naiveOutput, fftOutput;
+    naiveLayer.Forward(input, naiveOutput);
+    fftLayer.Forward(input, fftOutput);
+    CheckCubesClose(naiveOutput, fftOutput);
+
+    arma::cube error(6, 6, 2, arma::fill::randn);
+    arma::cube naiveDelta, fftDelta;
+    naiveLayer.Backward(naiveOutput, error, naiveDelta);
+    fftLayer.Backward(fftOutput, error, fftDelta);
+    CheckCubesClose(naiveDelta, fftDelta);
+
+    arma::cube naiveGradient, fftGradient;
+    naiveLayer.Gradient(input, error, naiveGradient);
+    fftLayer.Gradient(input, error, fftGradient);
+    CheckCubesClose(naiveGradient, fftGradient);
+  }
 }
 
 BOOST_AUTO_TEST_SUITE_END();
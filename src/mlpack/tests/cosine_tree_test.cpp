@@ -217,4 +217,26 @@ BOOST_AUTO_TEST_CASE(CosineTreeModifiedGramSchmidt)
   }
 }
 
+/**
+ * Checks that the basis built by the CosineTree constructor is orthonormal, and
+ * that the projection of the dataset onto it has a small error.
+ */
+BOOST_AUTO_TEST_CASE(CosineTreeOrthonormalBasis)
+{
+  // A dataset of rank 10 with many columns, so that the columns are processed
+  // in several blocks.
+  arma::mat data = arma::randu(50, 10) * arma::randu(10, 3000);
+
+  CosineTree ctree(data, 0.01, 0.1);
+  arma::mat basis;
+  ctree.GetFinalBasis(basis);
+
+  const arma::mat identity = arma::eye<arma::mat>(basis.n_cols, basis.n_cols);
+  BOOST_REQUIRE_SMALL(arma::norm(basis.t() * basis - identity, "fro"), 1e-8);
+
+  const double relativeError = arma::norm(data - basis * (basis.t() * data),
+      "fro") / arma::norm(data, "fro");
+  BOOST_REQUIRE_SMALL(relativeError, 0.2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
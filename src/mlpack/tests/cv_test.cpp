@@ -0,0 +1,188 @@
+/**
+ * @file cv_test.cpp
+ *
+ * Tests for k-fold cross-validation and hyperparameter search.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/cv/k_fold_cv.hpp>
+#include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+using namespace mlpack;
+using namespace mlpack::cv;
+using namespace mlpack::naive_bayes;
+
+BOOST_AUTO_TEST_SUITE(CVTest);
+
+// A model which predicts the same label for every point.
+class ConstantModel
+{
+ public:
+  ConstantModel(const size_t label) : label(label) { }
+
+  void Classify(const arma::mat& points, arma::Row<size_t>& predictions) const
+  {
+    predictions.set_size(points.n_cols);
+    predictions.fill(label);
+  }
+
+ private:
+  size_t label;
+};
+
+// A model with only a Predict() method, which predicts the label of a point
+// from the sign of its first dimension.
+class SignModel
+{
+ public:
+  void Predict(const arma::mat& points, arma::Row<size_t>& predictions) const
+  {
+    predictions.set_size(points.n_cols);
+    for (size_t i = 0; i < points.n_cols; ++i)
+      predictions[i] = (points(0, i) > 0.0) ? 1 : 0;
+  }
+};
+
+/**
+ * Make sure that the folds partition the dataset, and that the test points of
+ * each fold are not used for training.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVIndicesTest)
+{
+  arma::mat data(3, 103, arma::fill::randu);
+  arma::Row<size_t> labels(103, arma::fill::zeros);
+
+  for (size_t shuffle = 0; shuffle < 2; ++shuffle)
+  {
+    KFoldCV<> cv(data, labels, 10, shuffle == 1);
+    BOOST_REQUIRE_EQUAL(cv.K(), 10);
+
+    arma::Row<size_t> testCounts(103, arma::fill::zeros);
+    for (size_t fold = 0; fold < 10; ++fold)
+    {
+      arma::uvec trainIndices, testIndices;
+      cv.Indices(fold, trainIndices, testIndices);
+
+      BOOST_REQUIRE_EQUAL(trainIndices.n_elem + testIndices.n_elem, 103);
+      BOOST_REQUIRE_GE(testIndices.n_elem, 10);
+      BOOST_REQUIRE_LE(testIndices.n_elem, 11);
+
+      arma::Row<size_t> seen(103, arma::fill::zeros);
+      for (size_t i = 0; i < trainIndices.n_elem; ++i)
+        ++seen[trainIndices[i]];
+      for (size_t i = 0; i < testIndices.n_elem; ++i)
+      {
+        ++seen[testIndices[i]];
+        ++testCounts[testIndices[i]];
+      }
+
+      // Every point is either a training point or a test point.
+      for (size_t i = 0; i < 103; ++i)
+        BOOST_REQUIRE_EQUAL(seen[i], 1);
+    }
+
+    // Every point is a test point of exactly one fold.
+    for (size_t i = 0; i < 103; ++i)
+      BOOST_REQUIRE_EQUAL(testCounts[i], 1);
+  }
+}
+
+/**
+ * Make sure that invalid parameters are rejected.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVInvalidTest)
+{
+  arma::mat data(3, 10, arma::fill::randu);
+  arma::Row<size_t> labels(10, arma::fill::zeros);
+  arma::Row<size_t> shortLabels(9, arma::fill::zeros);
+
+  BOOST_REQUIRE_THROW(KFoldCV<>(data, labels, 1), std::invalid_argument);
+  BOOST_REQUIRE_THROW(KFoldCV<>(data, labels, 11), std::invalid_argument);
+  BOOST_REQUIRE_THROW(KFoldCV<>(data, shortLabels, 5),
+      std::invalid_argument);
+
+  // Exceptions thrown while training are passed to the caller.
+  KFoldCV<> cv(data, labels, 5);
+  BOOST_REQUIRE_THROW(cv.Evaluate(
+      [](const arma::mat&, const arma::Row<size_t>&) -> ConstantModel
+      {
+        throw std::runtime_error("training failed");
+      }), std::runtime_error);
+}
+
+/**
+ * Cross-validate the naive Bayes classifier on two well-separated Gaussians,
+ * which it should classify (almost) perfectly.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVNaiveBayesTest)
+{
+  arma::mat data(2, 400, arma::fill::randn);
+  arma::Row<size_t> labels(400);
+  for (size_t i = 0; i < 400; ++i)
+  {
+    labels[i] = i % 2;
+    data(0, i) += (i % 2 == 0) ? -10.0 : 10.0;
+  }
+
+  KFoldCV<> cv(data, labels, 5);
+  const double accuracy = cv.Evaluate(
+      [](const arma::mat& trainData, const arma::Row<size_t>& trainLabels)
+      {
+        return NaiveBayesClassifier<>(trainData, trainLabels, 2);
+      });
+  BOOST_REQUIRE_GT(accuracy, 0.99);
+
+  arma::vec accuracies;
+  cv.EvaluateFolds(
+      [](const arma::mat& trainData, const arma::Row<size_t>& trainLabels)
+      {
+        return NaiveBayesClassifier<>(trainData, trainLabels, 2);
+      }, accuracies);
+  BOOST_REQUIRE_EQUAL(accuracies.n_elem, 5);
+  for (size_t fold = 0; fold < 5; ++fold)
+    BOOST_REQUIRE_GT(accuracies[fold], 0.98);
+
+  // A model with only a Predict() method can be used too.
+  const double signAccuracy = cv.Evaluate(
+      [](const arma::mat&, const arma::Row<size_t>&) { return SignModel(); });
+  BOOST_REQUIRE_GT(signAccuracy, 0.99);
+}
+
+/**
+ * Make sure that Search() finds the best point of a grid, and computes the
+ * accuracy of every point.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVSearchTest)
+{
+  // 60% of the points have label 2, 30% label 1, and 10% label 0.
+  arma::mat data(2, 100, arma::fill::randu);
+  arma::Row<size_t> labels(100);
+  for (size_t i = 0; i < 100; ++i)
+    labels[i] = (i % 10 < 6) ? 2 : (i % 10 < 9) ? 1 : 0;
+
+  KFoldCV<> cv(data, labels, 4);
+  const std::vector<size_t> grid = { 0, 1, 2, 3 };
+  arma::vec accuracies;
+  const size_t best = cv.Search(grid,
+      [](const arma::mat&, const arma::Row<size_t>&, const size_t label)
+      {
+        return ConstantModel(label);
+      }, accuracies);
+
+  BOOST_REQUIRE_EQUAL(best, 2);
+  BOOST_REQUIRE_EQUAL(accuracies.n_elem, 4);
+  BOOST_REQUIRE_CLOSE(accuracies[0], 0.1, 1e-5);
+  BOOST_REQUIRE_CLOSE(accuracies[1], 0.3, 1e-5);
+  BOOST_REQUIRE_CLOSE(accuracies[2], 0.6, 1e-5);
+  BOOST_REQUIRE_SMALL(accuracies[3], 1e-5);
+
+  BOOST_REQUIRE_THROW(cv.Search(std::vector<size_t>(),
+      [](const arma::mat&, const arma::Row<size_t>&, const size_t label)
+      {
+        return ConstantModel(label);
+      }, accuracies), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -353,4 +353,37 @@ BOOST_AUTO_TEST_CASE(EmptyConstructorTest)
   BOOST_CHECK_EQUAL(predictedLabels(0, 7), 2);
 }
 
+/**
+ * Make sure that a weighted decision stump trained with presorted indices is
+ * the same as one which sorts the data itself.
+ */
+BOOST_AUTO_TEST_CASE(PresortedTrainingTest)
+{
+  arma::mat trainingData(5, 300);
+  trainingData.randu();
+  arma::Row<size_t> labelsIn(300);
+  for (size_t i = 0; i < 300; ++i)
+    labelsIn[i] = (trainingData(2, i) > 0.6) ? 2 :
+        ((trainingData(4, i) > 0.3) ? 1 : 0);
+
+  arma::rowvec weights(300);
+  weights.randu();
+
+  DecisionStump<> other(trainingData, labelsIn, 3, 5);
+  DecisionStump<> stump(other, trainingData, labelsIn, weights);
+
+  arma::Mat<size_t> sortedIndices;
+  math::Presort(trainingData, sortedIndices);
+  DecisionStump<> presortedStump(other, trainingData, sortedIndices, labelsIn,
+      weights);
+
+  BOOST_REQUIRE_EQUAL(stump.SplitDimension(), presortedStump.SplitDimension());
+  BOOST_REQUIRE_EQUAL(stump.Split().n_elem, presortedStump.Split().n_elem);
+  for (size_t i = 0; i < stump.Split().n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(stump.Split()[i], presortedStump.Split()[i]);
+    BOOST_REQUIRE_EQUAL(stump.BinLabels()[i], presortedStump.BinLabels()[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
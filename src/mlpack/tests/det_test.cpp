@@ -18,6 +18,7 @@
 
 #include <mlpack/methods/det/dtree.hpp>
 #include <mlpack/methods/det/dt_utils.hpp>
+#include <mlpack/methods/det/flat_dtree.hpp>
 
 #ifndef _WIN32
   #undef protected
@@ -212,6 +213,53 @@ BOOST_AUTO_TEST_CASE(TestGrow)
   BOOST_REQUIRE_CLOSE(alpha, min(rootAlpha, rAlpha), 1e-10);
 }
 
+// Check that two trees have the same structure and splits.
+void CheckSameTree(const DTree& a, const DTree& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Start(), b.Start());
+  BOOST_REQUIRE_EQUAL(a.End(), b.End());
+  BOOST_REQUIRE_EQUAL(a.SubtreeLeaves(), b.SubtreeLeaves());
+  BOOST_REQUIRE_EQUAL(a.Left() == NULL, b.Left() == NULL);
+  if (a.Left() == NULL)
+    return;
+
+  BOOST_REQUIRE_EQUAL(a.SplitDim(), b.SplitDim());
+  BOOST_REQUIRE_EQUAL(a.SplitValue(), b.SplitValue());
+  CheckSameTree(*a.Left(), *b.Left());
+  CheckSameTree(*a.Right(), *b.Right());
+}
+
+/**
+ * Make sure that growing a tree large enough to be grown in parallel gives the
+ * same tree as growing it with one thread.
+ */
+BOOST_AUTO_TEST_CASE(TestParallelGrow)
+{
+  arma::mat data;
+  data.randu(40, 3000);
+
+  arma::mat serialData(data);
+  arma::Col<size_t> serialOldFromNew =
+      arma::linspace<arma::Col<size_t> >(0, data.n_cols - 1, data.n_cols);
+  DTree serialTree(serialData);
+  ThreadPool::SetThreads(1);
+  const double serialAlpha = serialTree.Grow(serialData, serialOldFromNew,
+      false, 10, 5);
+
+  arma::mat parallelData(data);
+  arma::Col<size_t> parallelOldFromNew =
+      arma::linspace<arma::Col<size_t> >(0, data.n_cols - 1, data.n_cols);
+  DTree parallelTree(parallelData);
+  ThreadPool::SetThreads(0);
+  const double parallelAlpha = parallelTree.Grow(parallelData,
+      parallelOldFromNew, false, 10, 5);
+
+  BOOST_REQUIRE_EQUAL(serialAlpha, parallelAlpha);
+  CheckSameTree(serialTree, parallelTree);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(serialOldFromNew[i], parallelOldFromNew[i]);
+}
+
 BOOST_AUTO_TEST_CASE(TestPruneAndUpdate)
 {
   arma::mat testData(3, 5);
@@ -357,4 +405,46 @@ BOOST_AUTO_TEST_CASE(TestPrintLeafMembership)
 }
 */
 
+/**
+ * Make sure the flattened tree gives the same density estimates as the tree,
+ * both inside and outside of the bounding box of the tree.
+ */
+BOOST_AUTO_TEST_CASE(TestFlatDTree)
+{
+  arma::mat data(3, 1000);
+  data.randu();
+  arma::mat trainingData(data);
+
+  arma::Col<size_t> oldFromNew(trainingData.n_cols);
+  for (size_t i = 0; i < oldFromNew.n_elem; ++i)
+    oldFromNew[i] = i;
+
+  DTree tree(trainingData);
+  tree.Grow(trainingData, oldFromNew, false, 10, 5);
+  FlatDTree flatTree(tree);
+
+  // Some of the queries are outside of the bounding box.
+  arma::mat queries(3, 500);
+  queries.randu();
+  queries = 1.2 * queries - 0.1;
+
+  arma::rowvec values;
+  flatTree.ComputeValues(queries, values);
+  BOOST_REQUIRE_EQUAL(values.n_elem, queries.n_cols);
+
+  size_t outside = 0;
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    const arma::vec query = queries.col(i);
+    const double value = tree.ComputeValue(query);
+    if (value == 0.0)
+      ++outside;
+
+    BOOST_REQUIRE_CLOSE(values[i], value, 1e-10);
+    BOOST_REQUIRE_CLOSE(flatTree.ComputeValue(query), value, 1e-10);
+  }
+
+  BOOST_REQUIRE_GT(outside, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -307,6 +307,35 @@ BOOST_AUTO_TEST_CASE(GaussianMultipointMultivariateProbabilityTest)
   BOOST_REQUIRE_CLOSE(phis(5), -14.900192463287908, 1e-5);
 }
 
+/**
+ * Make sure the batch log-probabilities are the same as the log-probabilities
+ * of each point, also after the covariance is changed.
+ */
+BOOST_AUTO_TEST_CASE(GaussianBatchLogProbabilityTest)
+{
+  arma::vec mean(10, arma::fill::randu);
+  arma::mat cov(10, 10, arma::fill::randu);
+  cov = cov * trans(cov) + arma::eye<arma::mat>(10, 10);
+
+  GaussianDistribution g(mean, cov);
+  arma::mat points(10, 1000, arma::fill::randn);
+  points *= 3.0;
+
+  arma::vec logProbs;
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    g.LogProbability(points, logProbs);
+    BOOST_REQUIRE_EQUAL(logProbs.n_elem, 1000);
+    for (size_t i = 0; i < 1000; ++i)
+      BOOST_REQUIRE_CLOSE(logProbs[i], g.LogProbability(points.unsafe_col(i)),
+          1e-7);
+
+    // Now change the covariance; the cached factor must be updated too.
+    cov.diag() += 2.0;
+    g.Covariance(cov);
+  }
+}
+
 /**
  * Make sure random observations follow the probability distribution correctly.
  */
@@ -373,4 +402,78 @@ BOOST_AUTO_TEST_CASE(GaussianDistributionTrainTest)
       BOOST_REQUIRE_SMALL(d.Covariance()(i, j) - actualCov(i, j), 1e-5);
 }
 
+/**
+ * Make sure that DiagonalGaussianDistribution gives the same probabilities as a
+ * GaussianDistribution with the same diagonal covariance.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianDistributionProbabilityTest)
+{
+  arma::vec mean("1.0 -2.0 0.5 3.0");
+  arma::vec variances("0.5 2.0 1.5 4.0");
+
+  DiagonalGaussianDistribution d(mean, variances);
+  GaussianDistribution g(mean, arma::diagmat(variances));
+
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), 4);
+
+  arma::mat points(4, 100);
+  points.randn();
+  points *= 2.0;
+
+  arma::vec dProbs, gProbs;
+  d.Probability(points, dProbs);
+  g.Probability(points, gProbs);
+
+  BOOST_REQUIRE_EQUAL(dProbs.n_elem, 100);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(dProbs[i], gProbs[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(d.Probability(points.unsafe_col(i)), gProbs[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(d.LogProbability(points.unsafe_col(i)),
+        g.LogProbability(points.unsafe_col(i)), 1e-5);
+  }
+}
+
+/**
+ * Make sure that DiagonalGaussianDistribution estimates the mean and the
+ * variances of the observations, with and without probabilities.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianDistributionTrainTest)
+{
+  arma::vec mean("1.0 3.0 0.0 2.5");
+  arma::vec variances("3.0 2.4 6.3 9.1");
+
+  arma::mat observations(4, 10000);
+  for (size_t i = 0; i < 10000; i++)
+    observations.col(i) = arma::sqrt(variances) % arma::randn<arma::vec>(4) +
+        mean;
+
+  // Find actual mean and variances of the data.
+  arma::vec actualMean = arma::mean(observations, 1);
+  arma::vec actualVar = arma::var(observations, 0, 1);
+
+  DiagonalGaussianDistribution d;
+  d.Train(observations);
+
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), 4);
+  for (size_t i = 0; i < 4; i++)
+  {
+    BOOST_REQUIRE_SMALL(d.Mean()[i] - actualMean[i], 1e-5);
+    BOOST_REQUIRE_SMALL(d.Covariance()[i] - actualVar[i], 1e-5);
+  }
+
+  // With equal probabilities, the mean is the same, and the variances are the
+  // biased estimates.
+  arma::vec probabilities(10000);
+  probabilities.fill(0.5);
+  d.Train(observations, probabilities);
+
+  for (size_t i = 0; i < 4; i++)
+  {
+    BOOST_REQUIRE_SMALL(d.Mean()[i] - actualMean[i], 1e-5);
+    BOOST_REQUIRE_SMALL(d.Covariance()[i] - actualVar[i] * 9999.0 / 10000.0,
+        1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -275,4 +275,47 @@ BOOST_AUTO_TEST_CASE(BallTreeTest)
 
 }
 
+/**
+ * Make sure the parallel traversal and the parallel naive computation give the
+ * same results as the serial dual-tree computation.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeVsNaive)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  typedef KDTree<EuclideanDistance, DTBStat, arma::mat> TreeType;
+
+  const size_t oldThreads = ThreadPool::Threads();
+  ThreadPool::SetThreads(1);
+  DualTreeBoruvka<> dtb(inputData);
+  arma::mat serialResults;
+  dtb.ComputeMST(serialResults);
+
+  ThreadPool::SetThreads(0);
+  DualTreeBoruvka<EuclideanDistance, arma::mat, KDTree,
+      TreeType::ParallelDualTreeTraverser> parallelDtb(inputData);
+  arma::mat parallelResults;
+  parallelDtb.ComputeMST(parallelResults);
+
+  DualTreeBoruvka<> naive(inputData, true);
+  arma::mat naiveResults;
+  naive.ComputeMST(naiveResults);
+  ThreadPool::SetThreads(oldThreads);
+
+  BOOST_REQUIRE_EQUAL(parallelResults.n_cols, serialResults.n_cols);
+  BOOST_REQUIRE_EQUAL(naiveResults.n_cols, serialResults.n_cols);
+  for (size_t i = 0; i < serialResults.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelResults(0, i), serialResults(0, i));
+    BOOST_REQUIRE_EQUAL(parallelResults(1, i), serialResults(1, i));
+    BOOST_REQUIRE_CLOSE(parallelResults(2, i), serialResults(2, i), 1e-5);
+
+    BOOST_REQUIRE_EQUAL(naiveResults(0, i), serialResults(0, i));
+    BOOST_REQUIRE_EQUAL(naiveResults(1, i), serialResults(1, i));
+    BOOST_REQUIRE_CLOSE(naiveResults(2, i), serialResults(2, i), 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -122,6 +122,86 @@ BOOST_AUTO_TEST_CASE(DualTreeVsSingleTree)
   }
 }
 
+/**
+ * Make sure that single-tree and dual-tree search give the right results on a
+ * compacted cover tree.
+ */
+BOOST_AUTO_TEST_CASE(CompactTreeVsNaive)
+{
+  arma::mat data;
+  data.randn(5, 1000);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(data, lk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(10, naiveIndices, naiveProducts);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    IPMetric<LinearKernel> metric(lk);
+    FastMKS<LinearKernel>::Tree tree(data, metric);
+    tree.Compact();
+    BOOST_REQUIRE_EQUAL(tree.IsCompact(), true);
+
+    FastMKS<LinearKernel> f(&tree, (mode == 0));
+    arma::Mat<size_t> indices;
+    arma::mat products;
+    f.Search(10, indices, products);
+
+    for (size_t i = 0; i < naiveIndices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(indices[i], naiveIndices[i]);
+      BOOST_REQUIRE_CLOSE(products[i], naiveProducts[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Compare single-tree and naive search with a separate query set that is large
+ * enough to be split between threads, for both a normalized and an
+ * unnormalized kernel.
+ */
+BOOST_AUTO_TEST_CASE(SingleTreeQuerySetVsNaive)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 3000);
+  arma::mat queryData = arma::randu<arma::mat>(5, 1000);
+
+  GaussianKernel gk(0.5);
+  FastMKS<GaussianKernel> gaussianNaive(referenceData, gk, false, true);
+  FastMKS<GaussianKernel> gaussianSingle(referenceData, gk, true);
+
+  arma::Mat<size_t> naiveIndices, singleIndices;
+  arma::mat naiveKernels, singleKernels;
+  gaussianNaive.Search(queryData, 5, naiveIndices, naiveKernels);
+  gaussianSingle.Search(queryData, 5, singleIndices, singleKernels);
+
+  for (size_t q = 0; q < queryData.n_cols; ++q)
+  {
+    for (size_t r = 0; r < 5; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(singleIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(singleKernels(r, q), naiveKernels(r, q), 1e-5);
+    }
+  }
+
+  LinearKernel lk;
+  FastMKS<LinearKernel> linearNaive(referenceData, lk, false, true);
+  FastMKS<LinearKernel> linearSingle(referenceData, lk, true);
+
+  linearNaive.Search(queryData, 5, naiveIndices, naiveKernels);
+  linearSingle.Search(queryData, 5, singleIndices, singleKernels);
+
+  for (size_t q = 0; q < queryData.n_cols; ++q)
+  {
+    for (size_t r = 0; r < 5; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(singleIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(singleKernels(r, q), naiveKernels(r, q), 1e-5);
+    }
+  }
+}
+
 /**
  * Test sparse FastMKS (how useful is this, I'm not sure).
  */
@@ -953,4 +1033,115 @@ BOOST_AUTO_TEST_CASE(FastMKSModelTriangularTest)
   }
 }
 
+/**
+ * Make sure that the search with a kernel cache gives the same results as naive
+ * search.
+ */
+BOOST_AUTO_TEST_CASE(KernelCacheSearchTest)
+{
+  arma::mat data;
+  data.randn(5, 300);
+  PolynomialKernel pk(2.0);
+
+  FastMKS<PolynomialKernel> naive(data, pk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveKernels;
+  naive.Search(5, naiveIndices, naiveKernels);
+
+  KernelCache<PolynomialKernel> cache(data, pk);
+  arma::Mat<size_t> cacheIndices;
+  arma::mat cacheKernels;
+  naive.Search(cache, 5, cacheIndices, cacheKernels);
+
+  BOOST_REQUIRE_EQUAL(cache.CachedColumns(), data.n_cols);
+  BOOST_REQUIRE_EQUAL(cacheIndices.n_rows, naiveIndices.n_rows);
+  BOOST_REQUIRE_EQUAL(cacheIndices.n_cols, naiveIndices.n_cols);
+  for (size_t i = 0; i < naiveIndices.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(cacheIndices[i], naiveIndices[i]);
+    BOOST_REQUIRE_CLOSE(cacheKernels[i], naiveKernels[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that searches with several threads (which search blocks of query
+ * points in parallel, and evaluate the kernels of reference leaves together)
+ * give the same results as a naive search with one thread.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSearchTest)
+{
+  arma::mat referenceData, queryData;
+  referenceData.randn(5, 1000);
+  queryData.randn(5, 2500);
+  LinearKernel lk;
+
+  const size_t oldThreads = ThreadPool::Threads();
+  ThreadPool::SetThreads(1);
+  FastMKS<LinearKernel> naive(referenceData, lk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveKernels;
+  naive.Search(queryData, 5, naiveIndices, naiveKernels);
+
+  ThreadPool::SetThreads(0);
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    FastMKS<LinearKernel> f(referenceData, lk, mode == 0, mode == 1);
+    arma::Mat<size_t> indices;
+    arma::mat kernels;
+    f.Search(queryData, 5, indices, kernels);
+
+    BOOST_REQUIRE_EQUAL(indices.n_rows, naiveIndices.n_rows);
+    BOOST_REQUIRE_EQUAL(indices.n_cols, naiveIndices.n_cols);
+    for (size_t i = 0; i < naiveIndices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(indices[i], naiveIndices[i]);
+      BOOST_REQUIRE_CLOSE(kernels[i], naiveKernels[i], 1e-5);
+    }
+  }
+  ThreadPool::SetThreads(oldThreads);
+}
+
+/**
+ * Make sure that FastMKS uses a shared reference set without a copy and keeps
+ * it alive.
+ */
+BOOST_AUTO_TEST_CASE(SharedReferenceSetTest)
+{
+  arma::mat data;
+  data.randn(5, 500);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(data, lk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(5, naiveIndices, naiveProducts);
+
+  std::shared_ptr<const arma::mat> shared(new arma::mat(data));
+  const arma::mat* sharedSet = shared.get();
+  FastMKS<LinearKernel> sharedNaive(shared, lk, false, true);
+  FastMKS<LinearKernel> sharedTree;
+  sharedTree.Train(shared, lk);
+
+  BOOST_REQUIRE_EQUAL(&sharedNaive.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(&sharedTree.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(shared.use_count(), 3);
+  shared.reset();
+
+  for (size_t m = 0; m < 2; ++m)
+  {
+    arma::Mat<size_t> indices;
+    arma::mat products;
+    if (m == 0)
+      sharedNaive.Search(5, indices, products);
+    else
+      sharedTree.Search(5, indices, products);
+
+    for (size_t i = 0; i < naiveIndices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(indices[i], naiveIndices[i]);
+      BOOST_REQUIRE_CLOSE(products[i], naiveProducts[i], 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
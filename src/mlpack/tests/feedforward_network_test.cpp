@@ -17,11 +17,16 @@
 #include <mlpack/methods/ann/layer/base_layer.hpp>
 #include <mlpack/methods/ann/layer/dropout_layer.hpp>
 #include <mlpack/methods/ann/layer/binary_classification_layer.hpp>
+#include <mlpack/methods/ann/layer/multiclass_classification_layer.hpp>
+#include <mlpack/methods/ann/layer/softmax_cross_entropy_layer.hpp>
 #include <mlpack/methods/ann/layer/dropconnect_layer.hpp>
+#include <mlpack/methods/ann/layer/sparse_input_layer.hpp>
 
 #include <mlpack/methods/ann/ffn.hpp>
+#include <mlpack/methods/ann/inference_network.hpp>
 #include <mlpack/methods/ann/performance_functions/mse_function.hpp>
 #include <mlpack/core/optimizers/rmsprop/rmsprop.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -501,4 +506,440 @@ BOOST_AUTO_TEST_CASE(DropConnectNetworkTest)
       (dataset, labels, dataset, labels, 8, 30, 0.4);
 }
 
+/**
+ * Make sure that propagating a batch of points through the network gives the
+ * same objective, gradient and predictions as propagating them one at a time.
+ */
+BOOST_AUTO_TEST_CASE(BatchPropagationTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 40);
+  arma::mat labels = arma::randu<arma::mat>(3, 40);
+
+  LinearLayer<> inputLayer(5, 8);
+  BiasLayer<> inputBiasLayer(8);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer1(8, 3);
+  BiasLayer<> hiddenBiasLayer1(3);
+  BaseLayer<LogisticFunction> outputLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+                          hiddenLayer1, hiddenBiasLayer1, outputLayer);
+
+  FFN<decltype(modules), decltype(classOutputLayer), RandomInitialization,
+      MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+  // With a single iteration, this only stores the data in the network.
+  MiniBatchSGD<decltype(net)> opt(net, 10, 0.01, 1);
+  net.Train(data, labels, opt);
+
+  // Objective and gradient of points 10 to 19.
+  const double batchObjective = net.Evaluate(net.Parameters(), 10, 10, true);
+  arma::mat batchGradient;
+  net.Gradient(net.Parameters(), 10, batchGradient, 10);
+
+  double objective = 0.0;
+  arma::mat gradient = arma::zeros<arma::mat>(batchGradient.n_rows,
+      batchGradient.n_cols);
+  for (size_t i = 10; i < 20; ++i)
+  {
+    objective += net.Evaluate(net.Parameters(), i, true);
+
+    arma::mat pointGradient;
+    net.Gradient(net.Parameters(), i, pointGradient);
+    gradient += pointGradient;
+  }
+
+  BOOST_REQUIRE_CLOSE(batchObjective, objective, 1e-5);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(batchGradient[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(batchGradient[i], gradient[i], 1e-5);
+  }
+
+  // Predicting all the points at once should give the same results as
+  // predicting each one.
+  arma::mat predictions;
+  net.Predict(data, predictions);
+  BOOST_REQUIRE_EQUAL(predictions.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(predictions.n_cols, 40);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    arma::mat point = data.col(i);
+    arma::mat prediction;
+    net.Predict(point, prediction);
+    for (size_t j = 0; j < prediction.n_elem; ++j)
+      BOOST_REQUIRE_EQUAL(prediction[j], predictions(j, i));
+  }
+}
+
+/**
+ * Make sure that the gradient of a batch which is split into shards computed in
+ * parallel is the same as the gradient of the whole batch, and that it does not
+ * depend on the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelBatchGradientTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 200);
+  arma::mat labels = arma::randu<arma::mat>(3, 200);
+
+  LinearLayer<> inputLayer(5, 8);
+  BiasLayer<> inputBiasLayer(8);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer1(8, 3);
+  BiasLayer<> hiddenBiasLayer1(3);
+  BaseLayer<LogisticFunction> outputLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+                          hiddenLayer1, hiddenBiasLayer1, outputLayer);
+
+  FFN<decltype(modules), decltype(classOutputLayer), RandomInitialization,
+      MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+  // With a single iteration, this only stores the data in the network.
+  MiniBatchSGD<decltype(net)> opt(net, 10, 0.01, 1);
+  net.Train(data, labels, opt);
+
+  // Gradient of points 10 to 189, without splitting the batch.
+  net.ShardSize() = 0;
+  arma::mat gradient;
+  net.Gradient(net.Parameters(), 10, gradient, 180);
+
+  net.ShardSize() = 32;
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+
+  arma::mat serialGradient;
+  net.Gradient(net.Parameters(), 10, serialGradient, 180);
+
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+
+  arma::mat parallelGradient;
+  net.Gradient(net.Parameters(), 10, parallelGradient, 180);
+
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(serialGradient.n_elem, gradient.n_elem);
+  BOOST_REQUIRE_EQUAL(parallelGradient.n_elem, gradient.n_elem);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-10)
+    {
+      BOOST_REQUIRE_SMALL(serialGradient[i], 1e-10);
+      BOOST_REQUIRE_SMALL(parallelGradient[i], 1e-10);
+    }
+    else
+    {
+      BOOST_REQUIRE_CLOSE(serialGradient[i], gradient[i], 1e-5);
+      BOOST_REQUIRE_CLOSE(parallelGradient[i], serialGradient[i], 1e-10);
+    }
+  }
+
+  // Modify a layer through Network(); the copies of the layers used by the
+  // other threads must see the change.
+  std::get<4>(net.Network()).Bias() = 3.0;
+  net.ShardSize() = 0;
+  net.Gradient(net.Parameters(), 10, gradient, 180);
+
+  net.ShardSize() = 32;
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+
+  net.Gradient(net.Parameters(), 10, parallelGradient, 180);
+
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(parallelGradient[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(parallelGradient[i], gradient[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that the fused inference network gives the same predictions as the
+ * network it was made from, and fuses each linear, bias and activation layer
+ * into one stage, removing the dropout layer.
+ */
+BOOST_AUTO_TEST_CASE(InferenceNetworkTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 100);
+  arma::mat labels = arma::randu<arma::mat>(3, 100);
+
+  LinearLayer<> inputLayer(5, 8);
+  BiasLayer<> inputBiasLayer(8);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  DropoutLayer<> dropoutLayer1;
+
+  LinearLayer<> hiddenLayer1(8, 3);
+  BiasLayer<> hiddenBiasLayer1(3);
+  BaseLayer<TanHFunction> outputLayer;
+
+  MulticlassClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+                          dropoutLayer1, hiddenLayer1, hiddenBiasLayer1,
+                          outputLayer);
+
+  FFN<decltype(modules), decltype(classOutputLayer), RandomInitialization,
+      MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+  MiniBatchSGD<decltype(net)> opt(net, 10, 0.01, 200);
+  net.Train(data, labels, opt);
+
+  arma::mat prediction;
+  net.Predict(data, prediction);
+
+  InferenceNetwork inference(net);
+  BOOST_REQUIRE_EQUAL(inference.NumStages(), 2);
+
+  arma::mat inferencePrediction;
+  inference.Predict(data, inferencePrediction);
+
+  BOOST_REQUIRE_EQUAL(inferencePrediction.n_rows, prediction.n_rows);
+  BOOST_REQUIRE_EQUAL(inferencePrediction.n_cols, prediction.n_cols);
+  for (size_t i = 0; i < prediction.n_elem; ++i)
+  {
+    if (std::abs(prediction[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(inferencePrediction[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(inferencePrediction[i], prediction[i], 1e-8);
+  }
+}
+
+/**
+ * Make sure that a network with sparse predictors gives the same gradient and
+ * the same predictions as the same network with the dense predictors.
+ */
+BOOST_AUTO_TEST_CASE(SparseInputNetworkTest)
+{
+  arma::sp_mat sparseData = arma::sprandu<arma::sp_mat>(50, 100, 0.05);
+  arma::mat data(sparseData);
+  arma::mat labels = arma::randu<arma::mat>(3, 100);
+
+  SparseInputLayer<> denseInputLayer(50, 8);
+  BiasLayer<> denseBiasLayer(8);
+  BaseLayer<LogisticFunction> denseBaseLayer;
+  LinearLayer<> denseHiddenLayer(8, 3);
+  BaseLayer<LogisticFunction> denseOutputLayer;
+  BinaryClassificationLayer denseClassOutputLayer;
+
+  auto denseModules = std::tie(denseInputLayer, denseBiasLayer, denseBaseLayer,
+      denseHiddenLayer, denseOutputLayer);
+  FFN<decltype(denseModules), decltype(denseClassOutputLayer),
+      RandomInitialization, MeanSquaredErrorFunction> denseNet(denseModules,
+      denseClassOutputLayer);
+
+  SparseInputLayer<arma::sp_mat> sparseInputLayer(50, 8);
+  BiasLayer<> sparseBiasLayer(8);
+  BaseLayer<LogisticFunction> sparseBaseLayer;
+  LinearLayer<> sparseHiddenLayer(8, 3);
+  BaseLayer<LogisticFunction> sparseOutputLayer;
+  BinaryClassificationLayer sparseClassOutputLayer;
+
+  auto sparseModules = std::tie(sparseInputLayer, sparseBiasLayer,
+      sparseBaseLayer, sparseHiddenLayer, sparseOutputLayer);
+  FFN<decltype(sparseModules), decltype(sparseClassOutputLayer),
+      RandomInitialization, MeanSquaredErrorFunction, arma::sp_mat>
+      sparseNet(sparseModules, sparseClassOutputLayer);
+
+  // With a single iteration, this only stores the data in the networks.
+  MiniBatchSGD<decltype(denseNet)> denseOpt(denseNet, 10, 0.01, 1);
+  denseNet.Train(data, labels, denseOpt);
+  MiniBatchSGD<decltype(sparseNet)> sparseOpt(sparseNet, 10, 0.01, 1);
+  sparseNet.Train(sparseData, labels, sparseOpt);
+
+  sparseNet.Parameters() = denseNet.Parameters();
+
+  arma::mat denseGradient, sparseGradient;
+  denseNet.Gradient(denseNet.Parameters(), 0, denseGradient, 100);
+  sparseNet.Gradient(sparseNet.Parameters(), 0, sparseGradient, 100);
+
+  BOOST_REQUIRE_EQUAL(sparseGradient.n_elem, denseGradient.n_elem);
+  for (size_t i = 0; i < denseGradient.n_elem; ++i)
+  {
+    if (std::abs(denseGradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sparseGradient[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(sparseGradient[i], denseGradient[i], 1e-5);
+  }
+
+  arma::mat densePrediction, sparsePrediction;
+  denseNet.Predict(data, densePrediction);
+  sparseNet.Predict(sparseData, sparsePrediction);
+
+  BOOST_REQUIRE_EQUAL(sparsePrediction.n_elem, densePrediction.n_elem);
+  for (size_t i = 0; i < densePrediction.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(sparsePrediction[i], densePrediction[i]);
+}
+
+/**
+ * Make sure that a network with single precision layers and predictors gives
+ * nearly the same gradient and predictions as the same network in double
+ * precision, while its parameters stay in double precision.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecisionNetworkTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 100);
+  arma::mat labels = arma::randu<arma::mat>(3, 100);
+
+  LinearLayer<> inputLayer(5, 8);
+  BiasLayer<> inputBiasLayer(8);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+  LinearLayer<> hiddenLayer(8, 3);
+  BaseLayer<LogisticFunction> outputLayer;
+  MulticlassClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+      hiddenLayer, outputLayer);
+  FFN<decltype(modules), decltype(classOutputLayer), RandomInitialization,
+      MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+  LinearLayer<arma::fmat, arma::fmat> floatInputLayer(5, 8);
+  BiasLayer<arma::fmat, arma::fmat> floatInputBiasLayer(8);
+  BaseLayer<LogisticFunction, arma::fmat, arma::fmat> floatInputBaseLayer;
+  LinearLayer<arma::fmat, arma::fmat> floatHiddenLayer(8, 3);
+  BaseLayer<LogisticFunction, arma::fmat, arma::fmat> floatOutputLayer;
+  MulticlassClassificationLayer floatClassOutputLayer;
+
+  auto floatModules = std::tie(floatInputLayer, floatInputBiasLayer,
+      floatInputBaseLayer, floatHiddenLayer, floatOutputLayer);
+  FFN<decltype(floatModules), decltype(floatClassOutputLayer),
+      RandomInitialization, MeanSquaredErrorFunction, arma::fmat>
+      floatNet(floatModules, floatClassOutputLayer);
+
+  // With a single iteration, this only stores the data in the networks.
+  MiniBatchSGD<decltype(net)> opt(net, 10, 0.01, 1);
+  net.Train(data, labels, opt);
+
+  arma::fmat floatData = arma::conv_to<arma::fmat>::from(data);
+  arma::fmat floatLabels = arma::conv_to<arma::fmat>::from(labels);
+  MiniBatchSGD<decltype(floatNet)> floatOpt(floatNet, 10, 0.01, 1);
+  floatNet.Train(floatData, floatLabels, floatOpt);
+
+  // The parameters of both networks are double precision.
+  floatNet.Parameters() = net.Parameters();
+
+  arma::mat gradient, floatGradient;
+  net.Gradient(net.Parameters(), 0, gradient, 100);
+  floatNet.Gradient(floatNet.Parameters(), 0, floatGradient, 100);
+
+  BOOST_REQUIRE_EQUAL(floatGradient.n_elem, gradient.n_elem);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(floatGradient[i] - gradient[i], 1e-3);
+
+  arma::mat prediction;
+  arma::fmat floatPrediction;
+  net.Predict(data, prediction);
+  floatNet.Predict(floatData, floatPrediction);
+
+  BOOST_REQUIRE_EQUAL(floatPrediction.n_elem, prediction.n_elem);
+  for (size_t i = 0; i < prediction.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(floatPrediction[i] - prediction[i], 1e-4);
+}
+
+/**
+ * Make sure that the softmax cross-entropy layer gives the cross entropy of the
+ * softmax of its input and the gradient p - y, with class indices or one-hot
+ * targets, and that an FFN with it reports that loss.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxCrossEntropyLayerTest)
+{
+  // Large inputs would overflow an unshifted softmax.
+  arma::mat input = 400 * arma::randn<arma::mat>(4, 20);
+  arma::mat labels(1, 20);
+  arma::mat oneHot = arma::zeros<arma::mat>(4, 20);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    labels(i) = 1 + (i % 4);
+    oneHot(i % 4, i) = 1;
+  }
+
+  arma::mat logProbabilities = input.each_row() - arma::max(input);
+  logProbabilities.each_row() -= arma::log(arma::sum(
+      arma::exp(logProbabilities)));
+  const double expectedLoss = -arma::accu(logProbabilities % oneHot);
+  const arma::mat expectedError = arma::exp(logProbabilities) - oneHot;
+
+  SoftmaxCrossEntropyLayer layer;
+  arma::mat error, oneHotError;
+  const double loss = layer.CalculateError(input, labels, error);
+  const double oneHotLoss = layer.CalculateError(input, oneHot, oneHotError);
+
+  BOOST_REQUIRE_CLOSE(loss, expectedLoss, 1e-8);
+  BOOST_REQUIRE_CLOSE(oneHotLoss, expectedLoss, 1e-8);
+  for (size_t i = 0; i < error.n_elem; ++i)
+  {
+    BOOST_REQUIRE_SMALL(error[i] - expectedError[i], 1e-10);
+    BOOST_REQUIRE_SMALL(oneHotError[i] - expectedError[i], 1e-10);
+  }
+
+  arma::mat data = arma::randu<arma::mat>(5, 20);
+  LinearLayer<> inputLayer(5, 4);
+  BiasLayer<> inputBiasLayer(4);
+
+  auto modules = std::tie(inputLayer, inputBiasLayer);
+  FFN<decltype(modules), SoftmaxCrossEntropyLayer, RandomInitialization>
+      net(modules, layer);
+
+  // With a single iteration, this only stores the data in the network.
+  MiniBatchSGD<decltype(net)> opt(net, 10, 0.01, 1);
+  net.Train(data, labels, opt);
+
+  arma::mat prediction;
+  net.Predict(data, prediction);
+  const double netLoss = -arma::accu(arma::log(prediction) % oneHot);
+  BOOST_REQUIRE_CLOSE(net.Evaluate(net.Parameters(), 0, 20, true), netLoss,
+      1e-5);
+}
+
+/**
+ * Make sure that the sparse gradient of the SparseInputLayer is right when it
+ * is written over the gradient of another batch, of which only the columns of
+ * the features are cleared.
+ */
+BOOST_AUTO_TEST_CASE(SparseInputLayerGradientTest)
+{
+  SparseInputLayer<arma::sp_mat> layer(50, 8, 0.0);
+  layer.Weights().randu(8, 50);
+
+  arma::mat gradient;
+  for (size_t trial = 0; trial < 3; ++trial)
+  {
+    arma::sp_mat input = arma::sprandu<arma::sp_mat>(50, 10, 0.05);
+    arma::mat delta = arma::randu<arma::mat>(8, 10);
+    layer.Gradient(input, delta, gradient);
+
+    const arma::mat expected = delta * arma::mat(input).t() / 10.0;
+    BOOST_REQUIRE_EQUAL(gradient.n_rows, expected.n_rows);
+    BOOST_REQUIRE_EQUAL(gradient.n_cols, expected.n_cols);
+    for (size_t i = 0; i < expected.n_elem; ++i)
+    {
+      if (std::abs(expected[i]) < 1e-10)
+        BOOST_REQUIRE_SMALL(gradient[i], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(gradient[i], expected[i], 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,198 @@
+/**
+ * @file glimpse_layer_test.cpp
+ *
+ * Tests the GlimpseLayer class, which crops patches of increasing size around
+ * a location and scales them down to the glimpse size.
+ */
+#include <mlpack/core.hpp>
+
+#include <mlpack/methods/ann/layer/glimpse_layer.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+using namespace mlpack;
+using namespace mlpack::ann;
+
+BOOST_AUTO_TEST_SUITE(GlimpseLayerTest);
+
+/**
+ * Build a 10x10 image whose value at (r, c) is r + 10 * c (plus 100 times the
+ * slice index).
+ */
+static arma::cube Image(const size_t slices = 1)
+{
+  arma::cube input(10, 10, slices);
+  for (size_t s = 0; s < slices; ++s)
+    for (size_t c = 0; c < 10; ++c)
+      for (size_t r = 0; r < 10; ++r)
+        input(r, c, s) = r + 10.0 * c + 100.0 * s;
+
+  return input;
+}
+
+/**
+ * Make sure that the glimpse of the first scale is the crop of the image around
+ * the location, with zeros where the patch leaves the image.
+ */
+BOOST_AUTO_TEST_CASE(GlimpseLayerCropTest)
+{
+  const arma::cube input = Image();
+  arma::cube output;
+
+  // In the middle of the image: the 3x3 patch is centered on (4, 4), since the
+  // offset is floor((0 + 1) / 2 * (10 + 2 - 3)) - 1 = 3.
+  GlimpseLayer<> layer(1, 3, 1);
+  layer.Location(arma::mat("0; 0"));
+  layer.Forward(input, output);
+
+  BOOST_REQUIRE_EQUAL(output.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(output.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(output.n_slices, 1);
+  for (size_t c = 0; c < 3; ++c)
+    for (size_t r = 0; r < 3; ++r)
+      BOOST_REQUIRE_CLOSE(output(r, c, 0), input(3 + r, 3 + c, 0), 1e-10);
+
+  // In the top left corner, the first row and column of the patch are in the
+  // zero padding.
+  layer.Location(arma::mat("-1; -1"));
+  layer.Forward(input, output);
+
+  for (size_t c = 0; c < 3; ++c)
+  {
+    for (size_t r = 0; r < 3; ++r)
+    {
+      if (r == 0 || c == 0)
+        BOOST_REQUIRE_SMALL(output(r, c, 0), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(output(r, c, 0), input(r - 1, c - 1, 0), 1e-10);
+    }
+  }
+}
+
+/**
+ * Make sure that the patches of the larger scales are mean pooled when the
+ * scale is 2, and that the slices of each input are laid out by scale.
+ */
+BOOST_AUTO_TEST_CASE(GlimpseLayerMeanPoolTest)
+{
+  const arma::cube input = Image(2);
+  arma::cube output;
+
+  // Glimpse size 2: the 2x2 patch starts at floor(0.5 * 8) = 4.  The 4x4 patch
+  // of the second scale starts at floor(0.5 * 8) - 1 = 3, and is pooled in
+  // 2x2 blocks.
+  GlimpseLayer<> layer(1, 2, 2, 2);
+  layer.Location(arma::mat("0; 0"));
+  layer.Forward(input, output);
+
+  BOOST_REQUIRE_EQUAL(output.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(output.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(output.n_slices, 4);
+  for (size_t s = 0; s < 2; ++s)
+  {
+    for (size_t c = 0; c < 2; ++c)
+    {
+      for (size_t r = 0; r < 2; ++r)
+      {
+        BOOST_REQUIRE_CLOSE(output(r, c, 2 * s), input(4 + r, 4 + c, s),
+            1e-10);
+
+        const double pooled = arma::accu(input.slice(s).submat(3 + 2 * r,
+            3 + 2 * c, 4 + 2 * r, 4 + 2 * c)) / 4.0;
+        BOOST_REQUIRE_CLOSE(output(r, c, 2 * s + 1), pooled, 1e-10);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that the patches of the larger scales are resampled when the scale
+ * is not 2.
+ */
+BOOST_AUTO_TEST_CASE(GlimpseLayerResampleTest)
+{
+  const arma::cube input = Image();
+  arma::cube output;
+
+  // The 9x9 patch of the second scale starts at floor(0.5 * 9) - 4 = 0, and
+  // its resampling to 3x3 falls exactly on rows and columns 0, 4 and 8.
+  GlimpseLayer<> layer(1, 3, 2, 3);
+  layer.Location(arma::mat("0; 0"));
+  layer.Forward(input, output);
+
+  BOOST_REQUIRE_EQUAL(output.n_slices, 2);
+  for (size_t c = 0; c < 3; ++c)
+    for (size_t r = 0; r < 3; ++r)
+      BOOST_REQUIRE_CLOSE(output(r, c, 1) + 1.0, input(4 * r, 4 * c, 0) + 1.0,
+          1e-10);
+}
+
+/**
+ * Compare the gradient of Backward() with a central difference of a weighted
+ * sum of the outputs.  Backward() returns each slice of the gradient
+ * transposed (the layout that the recurrent attention model expects).
+ */
+void CheckGlimpseGradient(const size_t size,
+                          const size_t depth,
+                          const size_t scale,
+                          const arma::mat& location)
+{
+  arma::cube input(10, 10, 2, arma::fill::randu);
+  arma::cube output;
+
+  GlimpseLayer<> layer(1, size, depth, scale);
+  layer.Location(location);
+  layer.Forward(input, output);
+
+  // The weight of each output; each column of the error holds one slice.
+  const arma::cube weights(output.n_rows, output.n_cols, output.n_slices,
+      arma::fill::randu);
+  arma::mat error(output.n_rows * output.n_cols, output.n_slices);
+  for (size_t s = 0; s < output.n_slices; ++s)
+    error.col(s) = arma::vectorise(weights.slice(s));
+
+  arma::cube gradient;
+  layer.InputParameter() = input;
+  layer.Backward(output, error, gradient);
+
+  BOOST_REQUIRE_EQUAL(gradient.n_rows, input.n_rows);
+  BOOST_REQUIRE_EQUAL(gradient.n_cols, input.n_cols);
+  BOOST_REQUIRE_EQUAL(gradient.n_slices, input.n_slices);
+
+  const double eps = 1e-6;
+  for (size_t i = 0; i < input.n_elem; ++i)
+  {
+    const double original = input[i];
+    input[i] = original + eps;
+    layer.Forward(input, output);
+    const double plus = arma::accu(output % weights);
+    input[i] = original - eps;
+    layer.Forward(input, output);
+    const double minus = arma::accu(output % weights);
+    input[i] = original;
+
+    const size_t r = i % input.n_rows;
+    const size_t c = (i / input.n_rows) % input.n_cols;
+    const size_t s = i / (input.n_rows * input.n_cols);
+    const double numerical = (plus - minus) / (2 * eps);
+    if (std::abs(numerical) < 1e-5)
+      BOOST_REQUIRE_SMALL(gradient(c, r, s), 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(gradient(c, r, s), numerical, 1e-3);
+  }
+}
+
+/**
+ * Check the gradient of the crop, of the mean pooling and of the resampling,
+ * in the middle of the image and where the patches leave it.
+ */
+BOOST_AUTO_TEST_CASE(GlimpseLayerGradientTest)
+{
+  CheckGlimpseGradient(2, 3, 2, arma::mat("0.3; -0.5"));
+  CheckGlimpseGradient(2, 3, 2, arma::mat("-1; 1"));
+  CheckGlimpseGradient(3, 2, 3, arma::mat("0.2; 0.6"));
+  CheckGlimpseGradient(3, 2, 3, arma::mat("1; -1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,8 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/gmm/diagonal_gmm.hpp>
+#include <mlpack/methods/gmm/kd_tree_em_fit.hpp>
 
 #include <mlpack/methods/gmm/no_constraint.hpp>
 #include <mlpack/methods/gmm/positive_definite_constraint.hpp>
@@ -41,6 +43,39 @@ BOOST_AUTO_TEST_CASE(GMMProbabilityTest)
   BOOST_REQUIRE_CLOSE(gmm.Probability("1.4 0"), 0.024676682176, 1e-5);
 }
 
+/**
+ * Make sure the batch GMM::Probability() gives the same results as the
+ * probability of each observation.
+ */
+BOOST_AUTO_TEST_CASE(GMMBatchProbabilityTest)
+{
+  GMM gmm(2, 2);
+  gmm.Component(0) = distribution::GaussianDistribution("0 0", "1 0; 0 1");
+  gmm.Component(1) = distribution::GaussianDistribution("3 3", "2 1; 1 2");
+  gmm.Weights() = "0.3 0.7";
+
+  // Enough points to use several blocks.
+  arma::mat points(2, 3000, arma::fill::randn);
+  points *= 3.0;
+
+  arma::vec probabilities;
+  gmm.Probability(points, probabilities);
+  BOOST_REQUIRE_EQUAL(probabilities.n_elem, 3000);
+  for (size_t i = 0; i < 3000; ++i)
+    BOOST_REQUIRE_CLOSE(probabilities[i], gmm.Probability(points.unsafe_col(i)),
+        1e-7);
+
+  // The observations from GMMProbabilityTest.
+  const arma::mat observations("0 1 2 3 -1 1.4; 0 1 2 3 5.3 0");
+  gmm.Probability(observations, probabilities);
+  BOOST_REQUIRE_CLOSE(probabilities[0], 0.05094887202, 1e-5);
+  BOOST_REQUIRE_CLOSE(probabilities[1], 0.03451996667, 1e-5);
+  BOOST_REQUIRE_CLOSE(probabilities[2], 0.04696302254, 1e-5);
+  BOOST_REQUIRE_CLOSE(probabilities[3], 0.06432759685, 1e-5);
+  BOOST_REQUIRE_CLOSE(probabilities[4], 2.503171278804e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(probabilities[5], 0.024676682176, 1e-5);
+}
+
 /**
  * Test GMM::Probability() for a single observation being from a particular
  * component.
@@ -781,5 +816,336 @@ BOOST_AUTO_TEST_CASE(UseExistingModelTest)
   }
 }
 
+/**
+ * Make sure that EM training gives the same model whatever the number of
+ * threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelEMTest)
+{
+  // Three Gaussians, with enough points that they are split into many blocks.
+  arma::mat data(5, 5000);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) += 10.0 * (i % 3);
+
+  GMM gmm(3, 5);
+  gmm.Train(data, 1);
+
+  GMM gmm1(gmm), gmm4(gmm);
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  gmm1.Train(data, 1, true);
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  gmm4.Train(data, 1, true);
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(gmm1.Weights()[i], gmm4.Weights()[i], 1e-8);
+    BOOST_REQUIRE_SMALL(arma::norm(gmm1.Component(i).Mean() -
+        gmm4.Component(i).Mean()), 1e-8);
+    BOOST_REQUIRE_SMALL(arma::norm(gmm1.Component(i).Covariance() -
+        gmm4.Component(i).Covariance()), 1e-8);
+  }
+}
+
+/**
+ * Make sure that trials run concurrently give the same model whatever the
+ * number of trials that run at once, since each trial has its own random
+ * stream.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTrialsTest)
+{
+  arma::mat data(3, 1500);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) += 6.0 * (i % 3);
+
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(4);
+#endif
+
+  // One trial at a time (serially) gives the same model as well.
+  const size_t trialThreads[] = { 4, 2, 3, 1 };
+  std::vector<GMM> gmms(4, GMM(3, 3));
+  arma::vec likelihoods(4);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    math::RandomSeed(123);
+    likelihoods[i] = gmms[i].Train(data, 6, false, EMFit<>(),
+        trialThreads[i]);
+  }
+
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  for (size_t i = 1; i < 4; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(likelihoods[i], likelihoods[0], 1e-5);
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(gmms[i].Weights()[j], gmms[0].Weights()[j], 1e-5);
+      BOOST_REQUIRE_SMALL(arma::norm(gmms[i].Component(j).Mean() -
+          gmms[0].Component(j).Mean()), 1e-5);
+    }
+  }
+
+  // The returned log-likelihood is the one of the kept model.
+  double likelihood = 0.0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+    likelihood += std::log(gmms[0].Probability(data.col(i)));
+  BOOST_REQUIRE_CLOSE(likelihoods[0], likelihood, 1e-5);
+}
+
+/**
+ * Make sure that a DiagonalGMM gives the same model as a GMM trained with the
+ * DiagonalConstraint, when both start from the same model.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGMMTrainTest)
+{
+  // Three Gaussians with different variances in each dimension.
+  arma::mat data(4, 3000);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    data(0, i) *= 1.0 + (i % 3);
+    data(2, i) *= 3.0 - (i % 3);
+    data.col(i) += 10.0 * (i % 3);
+  }
+
+  // Start both models at the same point.
+  std::vector<distribution::DiagonalGaussianDistribution> diagDists;
+  std::vector<distribution::GaussianDistribution> dists;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    arma::vec mean(4);
+    mean.fill(10.0 * i + 0.5);
+    diagDists.push_back(distribution::DiagonalGaussianDistribution(mean,
+        arma::ones<arma::vec>(4)));
+    dists.push_back(distribution::GaussianDistribution(mean,
+        arma::eye<arma::mat>(4, 4)));
+  }
+  arma::vec weights(3);
+  weights.fill(1.0 / 3.0);
+
+  DiagonalGMM diagGmm(diagDists, weights);
+  GMM gmm(dists, weights);
+
+  const double diagLikelihood = diagGmm.Train(data, 1, true);
+  EMFit<kmeans::KMeans<>, DiagonalConstraint> fitter;
+  const double likelihood = gmm.Train(data, 1, true, fitter);
+
+  BOOST_REQUIRE_CLOSE(diagLikelihood, likelihood, 1e-5);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(diagGmm.Weights()[i], gmm.Weights()[i], 1e-5);
+    BOOST_REQUIRE_SMALL(arma::norm(diagGmm.Component(i).Mean() -
+        gmm.Component(i).Mean()), 1e-5);
+    BOOST_REQUIRE_SMALL(arma::norm(diagGmm.Component(i).Covariance() -
+        arma::diagvec(gmm.Component(i).Covariance())), 1e-5);
+
+    // The variances should be recovered too.
+    BOOST_REQUIRE_CLOSE(diagGmm.Component(i).Covariance()[0],
+        std::pow(1.0 + i, 2.0), 10.0);
+    BOOST_REQUIRE_CLOSE(diagGmm.Component(i).Covariance()[2],
+        std::pow(3.0 - i, 2.0), 10.0);
+  }
+
+  // The classification should be the same, too.
+  arma::Row<size_t> diagLabels, labels;
+  diagGmm.Classify(data, diagLabels);
+  gmm.Classify(data, labels);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(diagLabels[i], labels[i]);
+}
+
+/**
+ * Make sure that the batch log-probability of a DiagonalGMM is the log of its
+ * batch probability, and that it stays finite far from every component.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGMMLogProbabilityTest)
+{
+  std::vector<distribution::DiagonalGaussianDistribution> dists;
+  dists.push_back(distribution::DiagonalGaussianDistribution("0 0 0",
+      "1 2 0.5"));
+  dists.push_back(distribution::DiagonalGaussianDistribution("3 -1 2",
+      "0.3 1 4"));
+  DiagonalGMM gmm(dists, arma::vec("0.3 0.7"));
+
+  arma::mat observations(3, 2000, arma::fill::randn);
+  observations *= 2.0;
+
+  arma::vec probabilities, logProbabilities;
+  gmm.Probability(observations, probabilities);
+  gmm.LogProbability(observations, logProbabilities);
+
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, observations.n_cols);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], std::log(probabilities[i]), 1e-5);
+
+  // The probability of this point underflows, but its log-probability is the
+  // one of the closest component.
+  const arma::mat far("1e3; 0; 0");
+  gmm.LogProbability(far, logProbabilities);
+  BOOST_REQUIRE_CLOSE(logProbabilities[0], std::log(0.3) +
+      dists[0].LogProbability(far.col(0)), 1e-5);
+}
+
+/**
+ * Make sure that online EM recovers three well-separated Gaussians.
+ */
+BOOST_AUTO_TEST_CASE(OnlineEMTrainTest)
+{
+  arma::mat data(3, 6000);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) += 10.0 * (i % 3);
+
+  GMM gmm(3, 3);
+  OnlineEMFit<> fitter(500, 5);
+  gmm.Train(data, 3, false, fitter);
+
+  // Sort the components by their means.
+  arma::vec firstCoordinates(3);
+  for (size_t i = 0; i < 3; ++i)
+    firstCoordinates[i] = gmm.Component(i).Mean()[0];
+  arma::uvec order = arma::sort_index(firstCoordinates);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const distribution::GaussianDistribution& d = gmm.Component(order[i]);
+    BOOST_REQUIRE_CLOSE(gmm.Weights()[order[i]], 1.0 / 3.0, 5.0);
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_SMALL(d.Mean()[j] - 10.0 * i, 0.2);
+      BOOST_REQUIRE_CLOSE(d.Covariance()(j, j), 1.0, 20.0);
+    }
+  }
+}
+
+/**
+ * Make sure that GMM::Update() moves a trained model towards new data.
+ */
+BOOST_AUTO_TEST_CASE(OnlineEMUpdateTest)
+{
+  arma::mat data(3, 1000);
+  data.randn();
+
+  GMM gmm(1, 3);
+  gmm.Train(data);
+
+  // With a fresh fitter, the first step size is 1, so the model is just fitted
+  // to the batch.
+  arma::mat batch(3, 200);
+  batch.randn();
+  batch += 5.0;
+  OnlineEMFit<> fitter;
+  BOOST_REQUIRE_CLOSE(fitter.StepSize(), 1.0, 1e-10);
+  gmm.Update(batch, fitter);
+  BOOST_REQUIRE_EQUAL(fitter.Steps(), 1);
+
+  const arma::vec mean = arma::mean(batch, 1);
+  const arma::mat covariance = ccov(batch, 1 /* biased */);
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[0], 1.0, 1e-5);
+  BOOST_REQUIRE_SMALL(arma::norm(gmm.Component(0).Mean() - mean), 1e-5);
+  BOOST_REQUIRE_SMALL(arma::norm(gmm.Component(0).Covariance() - covariance),
+      1e-5);
+
+  // Now start again with a fitter that has already taken some steps, and
+  // stream batches from a shifted distribution.
+  gmm.Train(data);
+  OnlineEMFit<> slowFitter;
+  slowFitter.Steps() = 10;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    batch.randn();
+    batch += 5.0;
+    gmm.Update(batch, slowFitter);
+  }
+
+  BOOST_REQUIRE_EQUAL(slowFitter.Steps(), 110);
+  for (size_t j = 0; j < 3; ++j)
+  {
+    BOOST_REQUIRE_SMALL(gmm.Component(0).Mean()[j] - 5.0, 0.2);
+    BOOST_REQUIRE_CLOSE(gmm.Component(0).Covariance()(j, j), 1.0, 20.0);
+  }
+
+  // A batch of the wrong dimensionality is an error.
+  arma::mat wrongBatch(4, 10, arma::fill::randn);
+  BOOST_REQUIRE_THROW(gmm.Update(wrongBatch, slowFitter),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that the kd-tree accelerated EM gives the same model as EMFit on a
+ * large low-dimensional dataset, and that it actually prunes.
+ */
+BOOST_AUTO_TEST_CASE(KDTreeEMFitTest)
+{
+  arma::mat data(2, 20000);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    data(0, i) *= 1.0 + (i % 3);
+    data.col(i) += 8.0 * (i % 3);
+  }
+
+  // Start every fit from the same model.
+  std::vector<distribution::GaussianDistribution> initialDists;
+  for (size_t i = 0; i < 3; ++i)
+    initialDists.push_back(distribution::GaussianDistribution(
+        arma::vec(2).fill(8.0 * i + 1.0), arma::eye<arma::mat>(2, 2)));
+  arma::vec initialWeights(3);
+  initialWeights.fill(1.0 / 3.0);
+
+  std::vector<distribution::GaussianDistribution> dists(initialDists),
+      exactDists(initialDists), treeDists(initialDists);
+  arma::vec weights(initialWeights), exactWeights(initialWeights),
+      treeWeights(initialWeights);
+
+  EMFit<> emFit(10);
+  emFit.Estimate(data, dists, weights, true);
+
+  // Without pruning, the result should be the same.
+  KDTreeEMFit<> exactFit(10, 1e-10, 0.0);
+  exactFit.Estimate(data, exactDists, exactWeights, true);
+
+  KDTreeEMFit<> treeFit(10);
+  treeFit.Estimate(data, treeDists, treeWeights, true);
+  BOOST_REQUIRE_GT(treeFit.NumPrunes(), 0);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(exactWeights[i], weights[i], 1e-5);
+    BOOST_REQUIRE_SMALL(arma::norm(exactDists[i].Mean() - dists[i].Mean()),
+        1e-5);
+    BOOST_REQUIRE_SMALL(arma::norm(exactDists[i].Covariance() -
+        dists[i].Covariance()), 1e-5);
+
+    BOOST_REQUIRE_CLOSE(treeWeights[i], weights[i], 1.0);
+    BOOST_REQUIRE_SMALL(arma::norm(treeDists[i].Mean() - dists[i].Mean()),
+        0.05);
+    BOOST_REQUIRE_SMALL(arma::norm(treeDists[i].Covariance() -
+        dists[i].Covariance()), 0.1);
+  }
+
+  // It should also work as the FittingType of a GMM.
+  GMM gmm(3, 2);
+  gmm.Train(data, 1, false, KDTreeEMFit<>());
+  arma::vec firstCoordinates(3);
+  for (size_t i = 0; i < 3; ++i)
+    firstCoordinates[i] = gmm.Component(i).Mean()[1];
+  arma::uvec order = arma::sort_index(firstCoordinates);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_SMALL(gmm.Component(order[i]).Mean()[1] - 8.0 * i, 0.1);
+}
 
 BOOST_AUTO_TEST_SUITE_END();
@@ -5,6 +5,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/hmm/hmm.hpp>
+#include <mlpack/methods/hmm/viterbi_decoder.hpp>
 #include <mlpack/methods/gmm/gmm.hpp>
 
 #include <boost/test/unit_test.hpp>
@@ -152,6 +153,139 @@ BOOST_AUTO_TEST_CASE(ForwardBackwardTwoState)
   BOOST_REQUIRE_SMALL(stateProb(1, 9), 1e-5);
 }
 
+/**
+ * Make sure that the Viterbi algorithm finds the same most probable state
+ * sequence as an exhaustive search over every state sequence, for a random
+ * HMM with more than two states.
+ */
+BOOST_AUTO_TEST_CASE(ViterbiExhaustiveTest)
+{
+  const size_t states = 4;
+  const size_t length = 6;
+
+  arma::vec initial = arma::randu<arma::vec>(states) + 0.1;
+  initial /= accu(initial);
+  arma::mat transition = arma::randu<arma::mat>(states, states) + 0.1;
+  for (size_t i = 0; i < states; ++i)
+    transition.col(i) /= accu(transition.col(i));
+
+  std::vector<DiscreteDistribution> emission(states);
+  for (size_t i = 0; i < states; ++i)
+  {
+    arma::vec probabilities = arma::randu<arma::vec>(3) + 0.1;
+    probabilities /= accu(probabilities);
+    emission[i] = DiscreteDistribution(probabilities);
+  }
+
+  HMM<DiscreteDistribution> hmm(initial, transition, emission);
+
+  arma::mat observation(1, length);
+  for (size_t t = 0; t < length; ++t)
+    observation[t] = math::RandInt(3);
+
+  arma::Row<size_t> predicted;
+  const double logLikelihood = hmm.Predict(observation, predicted);
+
+  // Find the best state sequence by trying every one of them.
+  double bestLogLikelihood = -std::numeric_limits<double>::infinity();
+  arma::Row<size_t> best(length), stateSeq(length);
+  for (size_t code = 0; code < std::pow(states, length); ++code)
+  {
+    size_t c = code;
+    for (size_t t = 0; t < length; ++t, c /= states)
+      stateSeq[t] = c % states;
+
+    double l = std::log(initial[stateSeq[0]]);
+    for (size_t t = 0; t < length; ++t)
+    {
+      if (t > 0)
+        l += std::log(transition(stateSeq[t], stateSeq[t - 1]));
+      l += std::log(emission[stateSeq[t]].Probability(
+          observation.unsafe_col(t)));
+    }
+
+    if (l > bestLogLikelihood)
+    {
+      bestLogLikelihood = l;
+      best = stateSeq;
+    }
+  }
+
+  BOOST_REQUIRE_CLOSE(logLikelihood, bestLogLikelihood, 1e-8);
+  for (size_t t = 0; t < length; ++t)
+    BOOST_REQUIRE_EQUAL(predicted[t], best[t]);
+}
+
+/**
+ * Make sure that the streaming Viterbi decoder with no lag limit gives the
+ * same state sequence as HMM::Predict(), and that with a lag limit, it never
+ * leaves more time steps undecided than the limit.
+ */
+BOOST_AUTO_TEST_CASE(ViterbiDecoderTest)
+{
+  arma::vec initial("0.4 0.3 0.3");
+  arma::mat transition("0.8 0.1 0.1; 0.1 0.8 0.1; 0.1 0.1 0.8");
+  std::vector<GaussianDistribution> emission(3);
+  emission[0] = GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0");
+  emission[1] = GaussianDistribution("1.5 0.0", "1.0 0.0; 0.0 1.0");
+  emission[2] = GaussianDistribution("0.0 1.5", "1.0 0.0; 0.0 1.0");
+
+  typedef HMM<GaussianDistribution> HMMType;
+  HMMType hmm(initial, transition, emission);
+
+  arma::mat observations;
+  arma::Row<size_t> states;
+  hmm.Generate(2000, observations, states);
+
+  arma::Row<size_t> predicted;
+  const double logLikelihood = hmm.Predict(observations, predicted);
+
+  ViterbiDecoder<HMMType> decoder(hmm, 0);
+  arma::Row<size_t> streamed, decoded;
+  size_t maxLag = 0;
+  for (size_t t = 0; t < observations.n_cols; ++t)
+  {
+    decoder.Push(observations.col(t), decoded);
+    streamed.insert_cols(streamed.n_elem, decoded);
+    maxLag = std::max(maxLag, decoder.Lag());
+  }
+  BOOST_REQUIRE_CLOSE(decoder.LogLikelihood(), logLikelihood, 1e-8);
+  decoder.Flush(decoded);
+  streamed.insert_cols(streamed.n_elem, decoded);
+
+  BOOST_REQUIRE_EQUAL(decoder.Lag(), 0);
+  BOOST_REQUIRE_EQUAL(streamed.n_elem, observations.n_cols);
+  for (size_t t = 0; t < observations.n_cols; ++t)
+    BOOST_REQUIRE_EQUAL(streamed[t], predicted[t]);
+
+  // The survivor paths should converge long before the end of the sequence.
+  BOOST_REQUIRE_LT(maxLag, 500);
+
+  // Now bound the lag.
+  decoder.MaxLag() = 5;
+  streamed.reset();
+  for (size_t t = 0; t < observations.n_cols; ++t)
+  {
+    decoder.Push(observations.col(t), decoded);
+    streamed.insert_cols(streamed.n_elem, decoded);
+    BOOST_REQUIRE_LE(decoder.Lag(), 5);
+  }
+  decoder.Flush(decoded);
+  streamed.insert_cols(streamed.n_elem, decoded);
+  BOOST_REQUIRE_EQUAL(streamed.n_elem, observations.n_cols);
+
+  // Most of the states should still be the same.
+  size_t same = 0;
+  for (size_t t = 0; t < observations.n_cols; ++t)
+    if (streamed[t] == predicted[t])
+      ++same;
+  BOOST_REQUIRE_GT(same, 0.9 * observations.n_cols);
+
+  // Observations of the wrong dimensionality are rejected.
+  BOOST_REQUIRE_THROW(decoder.Push(arma::vec("1.0 2.0 3.0"), decoded),
+      std::invalid_argument);
+}
+
 /**
  * In this example we try to estimate the transmission and emission matrices
  * based on some observations.  We use the simplest possible model.
@@ -1164,5 +1298,263 @@ BOOST_AUTO_TEST_CASE(DiscreteHMMLoadSaveTest)
           hmm2.Emission()[j].Probabilities()[i], 1e-3);
 }
 
-BOOST_AUTO_TEST_SUITE_END();
+/**
+ * Make sure that Baum-Welch training on many sequences gives the same model
+ * whatever the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelBaumWelchTest)
+{
+  // Generate many short sequences from a discrete HMM.
+  HMM<DiscreteDistribution> hmm(2, DiscreteDistribution(3));
+  hmm.Transition() = arma::mat("0.8 0.3; 0.2 0.7");
+  hmm.Emission()[0].Probabilities() = "0.6 0.3 0.1";
+  hmm.Emission()[1].Probabilities() = "0.1 0.2 0.7";
+
+  std::vector<arma::mat> observations(500);
+  for (size_t i = 0; i < observations.size(); ++i)
+  {
+    arma::Row<size_t> stateSeq;
+    hmm.Generate(10 + i % 7, observations[i], stateSeq);
+  }
+
+  // Start both models from the same point.
+  HMM<DiscreteDistribution> start(2, DiscreteDistribution(3));
+  start.Transition() = arma::mat("0.6 0.4; 0.4 0.6");
+  start.Emission()[0].Probabilities() = "0.5 0.3 0.2";
+  start.Emission()[1].Probabilities() = "0.2 0.3 0.5";
+
+  HMM<DiscreteDistribution> hmm1(start), hmm4(start);
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  hmm1.Train(observations);
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  hmm4.Train(observations);
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  BOOST_REQUIRE_SMALL(arma::norm(hmm1.Transition() - hmm4.Transition()),
+      1e-10);
+  BOOST_REQUIRE_SMALL(arma::norm(hmm1.Initial() - hmm4.Initial()), 1e-10);
+  for (size_t j = 0; j < 2; ++j)
+    BOOST_REQUIRE_SMALL(arma::norm(hmm1.Emission()[j].Probabilities() -
+        hmm4.Emission()[j].Probabilities()), 1e-10);
+}
 
+/**
+ * Make sure that an HMM with a sparse transition matrix gives the same results
+ * as the same HMM with a dense transition matrix, for a left-to-right model.
+ */
+BOOST_AUTO_TEST_CASE(SparseTransitionHMMTest)
+{
+  // Each state either stays, or moves on to one of the next two states; the
+  // last state goes back to the first one.
+  const size_t states = 20;
+  arma::mat transition(states, states, arma::fill::zeros);
+  for (size_t j = 0; j < states; ++j)
+  {
+    transition(j, j) = 0.6;
+    transition((j + 1) % states, j) = 0.3;
+    transition((j + 2) % states, j) = 0.1;
+  }
+
+  std::vector<DiscreteDistribution> emission(states);
+  for (size_t j = 0; j < states; ++j)
+  {
+    arma::vec probabilities = arma::randu<arma::vec>(5) + 0.1;
+    probabilities /= accu(probabilities);
+    emission[j] = DiscreteDistribution(probabilities);
+  }
+
+  arma::vec initial(states, arma::fill::zeros);
+  initial[0] = 1.0;
+
+  HMM<DiscreteDistribution> denseHMM(initial, transition, emission);
+  HMM<DiscreteDistribution, arma::sp_mat> sparseHMM(initial,
+      arma::sp_mat(transition), emission);
+  BOOST_REQUIRE_EQUAL(sparseHMM.Transition().n_nonzero, 3 * states);
+
+  std::vector<arma::mat> observations(10);
+  std::vector<arma::Row<size_t>> stateSeqs(10);
+  for (size_t i = 0; i < 10; ++i)
+    denseHMM.Generate(200, observations[i], stateSeqs[i]);
+
+  // The forward-backward algorithm and the Viterbi algorithm.
+  arma::mat denseStateProb, sparseStateProb;
+  const double denseLoglik = denseHMM.Estimate(observations[0],
+      denseStateProb);
+  const double sparseLoglik = sparseHMM.Estimate(observations[0],
+      sparseStateProb);
+  BOOST_REQUIRE_CLOSE(denseLoglik, sparseLoglik, 1e-8);
+  for (size_t i = 0; i < denseStateProb.n_elem; ++i)
+  {
+    if (std::abs(denseStateProb[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sparseStateProb[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(denseStateProb[i], sparseStateProb[i], 1e-6);
+  }
+
+  arma::Row<size_t> densePredicted, sparsePredicted;
+  BOOST_REQUIRE_CLOSE(denseHMM.Predict(observations[0], densePredicted),
+      sparseHMM.Predict(observations[0], sparsePredicted), 1e-8);
+  for (size_t t = 0; t < densePredicted.n_elem; ++t)
+    BOOST_REQUIRE_EQUAL(densePredicted[t], sparsePredicted[t]);
+
+  // The Baum-Welch algorithm keeps the zero transitions at zero, so both
+  // should find the same model.
+  denseHMM.Train(observations);
+  sparseHMM.Train(observations);
+  BOOST_REQUIRE_LE(sparseHMM.Transition().n_nonzero, 3 * states);
+  for (size_t i = 0; i < states; ++i)
+  {
+    for (size_t j = 0; j < states; ++j)
+    {
+      if (denseHMM.Transition()(i, j) < 1e-10)
+        BOOST_REQUIRE_SMALL((double) sparseHMM.Transition()(i, j), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(denseHMM.Transition()(i, j),
+            (double) sparseHMM.Transition()(i, j), 1e-5);
+    }
+  }
+
+  // Labeled training only creates the transitions seen in the labels.
+  denseHMM.Train(observations, stateSeqs);
+  sparseHMM.Train(observations, stateSeqs);
+  BOOST_REQUIRE_LE(sparseHMM.Transition().n_nonzero, 3 * states);
+  for (size_t i = 0; i < states; ++i)
+    for (size_t j = 0; j < states; ++j)
+      BOOST_REQUIRE_CLOSE(denseHMM.Transition()(i, j) + 1.0,
+          (double) sparseHMM.Transition()(i, j) + 1.0, 1e-8);
+}
+
+/**
+ * Make sure that the elements written to a sparse transition matrix through its
+ * element access operators are used, even if Armadillo only holds them in its
+ * element cache.
+ */
+BOOST_AUTO_TEST_CASE(SparseTransitionElementWriteTest)
+{
+  const size_t states = 6;
+  arma::mat transition(states, states, arma::fill::zeros);
+  std::vector<DiscreteDistribution> emission(states);
+  for (size_t j = 0; j < states; ++j)
+  {
+    transition(j, j) = 0.7;
+    transition((j + 1) % states, j) = 0.3;
+
+    arma::vec probabilities = arma::randu<arma::vec>(4) + 0.1;
+    probabilities /= accu(probabilities);
+    emission[j] = DiscreteDistribution(probabilities);
+  }
+
+  arma::vec initial(states, arma::fill::zeros);
+  initial[0] = 1.0;
+
+  HMM<DiscreteDistribution> denseHMM(initial, transition, emission);
+  HMM<DiscreteDistribution, arma::sp_mat> sparseHMM(initial,
+      arma::sp_mat(states, states), emission);
+  for (size_t j = 0; j < states; ++j)
+  {
+    sparseHMM.Transition()(j, j) = 0.7;
+    sparseHMM.Transition()((j + 1) % states, j) = 0.3;
+  }
+
+  arma::mat observations;
+  arma::Row<size_t> stateSeq;
+  denseHMM.Generate(100, observations, stateSeq);
+
+  arma::Row<size_t> densePredicted, sparsePredicted;
+  BOOST_REQUIRE_CLOSE(denseHMM.Predict(observations, densePredicted),
+      sparseHMM.Predict(observations, sparsePredicted), 1e-8);
+  for (size_t t = 0; t < densePredicted.n_elem; ++t)
+    BOOST_REQUIRE_EQUAL(densePredicted[t], sparsePredicted[t]);
+
+  BOOST_REQUIRE_CLOSE(denseHMM.LogLikelihood(observations),
+      sparseHMM.LogLikelihood(observations), 1e-8);
+}
+
+/**
+ * Make sure that the batch log-likelihood of many sequences of a GMM-based HMM
+ * matches a naive forward algorithm, and that the batch log-probability of a
+ * GMM matches its probability.
+ */
+BOOST_AUTO_TEST_CASE(GMMHMMBatchLogLikelihoodTest)
+{
+  std::vector<GMM> gmms(2);
+  gmms[0] = GMM(2, 2);
+  gmms[0].Weights() = arma::vec("0.75 0.25");
+  gmms[0].Component(0) = GaussianDistribution("4.25 3.10",
+                                              "1.00 0.20; 0.20 0.89");
+  gmms[0].Component(1) = GaussianDistribution("7.10 5.01",
+                                              "1.00 0.00; 0.00 1.01");
+
+  gmms[1] = GMM(3, 2);
+  gmms[1].Weights() = arma::vec("0.4 0.2 0.4");
+  gmms[1].Component(0) = GaussianDistribution("-3.00 -6.12",
+                                              "1.00 0.00; 0.00 1.00");
+  gmms[1].Component(1) = GaussianDistribution("-4.25 -7.12",
+                                              "1.50 0.60; 0.60 1.20");
+  gmms[1].Component(2) = GaussianDistribution("-6.15 -2.00",
+                                              "1.00 0.80; 0.80 1.00");
+
+  arma::vec initial("0.6 0.4");
+  arma::mat trans("0.30 0.50;"
+                  "0.70 0.50");
+  HMM<GMM> hmm(initial, trans, gmms);
+
+  // The last sequence is longer than a block of observations.
+  std::vector<arma::mat> observations(20);
+  for (size_t i = 0; i < observations.size(); ++i)
+  {
+    arma::Row<size_t> stateSeq;
+    hmm.Generate((i == observations.size() - 1) ? 2500 : 50 + 10 * i,
+        observations[i], stateSeq);
+  }
+
+  arma::vec logLikelihoods;
+  hmm.LogLikelihood(observations, logLikelihoods);
+  BOOST_REQUIRE_EQUAL(logLikelihoods.n_elem, observations.size());
+
+  for (size_t i = 0; i < observations.size(); ++i)
+  {
+    BOOST_REQUIRE_CLOSE(logLikelihoods[i], hmm.LogLikelihood(observations[i]),
+        1e-8);
+
+    // A scaled forward algorithm with the probabilities of each observation.
+    arma::vec forward = initial;
+    double logLikelihood = 0.0;
+    for (size_t t = 0; t < observations[i].n_cols; ++t)
+    {
+      if (t > 0)
+        forward = trans * forward;
+      for (size_t j = 0; j < 2; ++j)
+        forward[j] *= gmms[j].Probability(observations[i].col(t));
+
+      logLikelihood += std::log(accu(forward));
+      forward /= accu(forward);
+    }
+
+    BOOST_REQUIRE_CLOSE(logLikelihoods[i], logLikelihood, 1e-5);
+  }
+
+  // The batch log-probability of each GMM.
+  for (size_t j = 0; j < 2; ++j)
+  {
+    arma::vec logProbabilities;
+    gmms[j].LogProbability(observations.back(), logProbabilities);
+    BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, observations.back().n_cols);
+    for (size_t t = 0; t < observations.back().n_cols; ++t)
+    {
+      const double probability = gmms[j].Probability(
+          observations.back().col(t));
+      if (probability > 1e-300)
+        BOOST_REQUIRE_CLOSE(logProbabilities[t], std::log(probability), 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
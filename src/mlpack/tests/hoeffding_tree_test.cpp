@@ -10,6 +10,8 @@
 #include <mlpack/methods/hoeffding_trees/hoeffding_tree.hpp>
 #include <mlpack/methods/hoeffding_trees/hoeffding_categorical_split.hpp>
 #include <mlpack/methods/hoeffding_trees/binary_numeric_split.hpp>
+#include <mlpack/methods/hoeffding_trees/quantile_numeric_split.hpp>
+#include <mlpack/methods/hoeffding_trees/flat_hoeffding_tree.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -972,6 +974,45 @@ BOOST_AUTO_TEST_CASE(BatchTrainingTest)
   BOOST_REQUIRE_GE(batchCorrect, streamCorrect);
 }
 
+/**
+ * Make sure that batch training gives the same tree with one thread as with
+ * many, including when a batch is given to a tree which is already split.
+ */
+BOOST_AUTO_TEST_CASE(ParallelBatchTrainingTest)
+{
+  arma::mat dataset(20, 8000);
+  dataset.randu();
+  arma::Row<size_t> labels(8000);
+  for (size_t i = 0; i < 8000; ++i)
+    labels[i] = (dataset(3, i) > 0.5) ? ((dataset(7, i) > 0.3) ? 2 : 1) : 0;
+
+  const arma::mat firstBatch = dataset.cols(0, 3999);
+  const arma::mat secondBatch = dataset.cols(4000, 7999);
+  const arma::Row<size_t> firstLabels = labels.subvec(0, 3999);
+  const arma::Row<size_t> secondLabels = labels.subvec(4000, 7999);
+
+  data::DatasetInfo info(20);
+
+  ThreadPool::SetThreads(1);
+  HoeffdingTree<> serialTree(firstBatch, info, firstLabels, 3, true);
+  serialTree.Train(secondBatch, secondLabels, true);
+
+  ThreadPool::SetThreads(0);
+  HoeffdingTree<> parallelTree(firstBatch, info, firstLabels, 3, true);
+  parallelTree.Train(secondBatch, secondLabels, true);
+
+  BOOST_REQUIRE_GT(serialTree.NumChildren(), 0);
+  BOOST_REQUIRE_EQUAL(serialTree.NumChildren(), parallelTree.NumChildren());
+  BOOST_REQUIRE_EQUAL(serialTree.SplitDimension(),
+      parallelTree.SplitDimension());
+
+  arma::Row<size_t> serialPredictions, parallelPredictions;
+  serialTree.Classify(dataset, serialPredictions);
+  parallelTree.Classify(dataset, parallelPredictions);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(serialPredictions[i], parallelPredictions[i]);
+}
+
 // Make sure that changing the confidence properly propagates to all leaves.
 BOOST_AUTO_TEST_CASE(ConfidenceChangeTest)
 {
@@ -1140,4 +1181,320 @@ BOOST_AUTO_TEST_CASE(MultipleSerializationTest)
   }
 }
 
+/**
+ * Check that the flattened tree gives the same predictions and probabilities as
+ * the given tree.
+ */
+template<typename TreeType>
+void CheckFlatTree(const TreeType& tree, const arma::mat& dataset)
+{
+  FlatHoeffdingTree flatTree(tree);
+
+  arma::Row<size_t> predictions, flatPredictions;
+  arma::rowvec probabilities, flatProbabilities;
+  tree.Classify(dataset, predictions, probabilities);
+  flatTree.Classify(dataset, flatPredictions, flatProbabilities);
+
+  BOOST_REQUIRE_EQUAL(flatPredictions.n_elem, dataset.n_cols);
+  BOOST_REQUIRE_EQUAL(flatProbabilities.n_elem, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(flatPredictions[i], predictions[i]);
+    BOOST_REQUIRE_CLOSE(flatProbabilities[i], probabilities[i], 1e-10);
+
+    size_t prediction;
+    double probability;
+    flatTree.Classify(dataset.col(i), prediction, probability);
+    BOOST_REQUIRE_EQUAL(prediction, predictions[i]);
+    BOOST_REQUIRE_CLOSE(probability, probabilities[i], 1e-10);
+    BOOST_REQUIRE_EQUAL(flatTree.Classify(dataset.col(i)), predictions[i]);
+  }
+}
+
+/**
+ * Make sure the flattened tree classifies points like the tree, with numeric
+ * and binary numeric splits, and with categorical splits.
+ */
+BOOST_AUTO_TEST_CASE(FlatHoeffdingTreeTest)
+{
+  // The second dimension is categorical.
+  arma::mat dataset(3, 9000);
+  arma::Row<size_t> labels(9000);
+  data::DatasetInfo info(3);
+  info.MapString("a", 1);
+  info.MapString("b", 1);
+  info.MapString("c", 1);
+  for (size_t i = 0; i < 9000; ++i)
+  {
+    dataset(0, i) = mlpack::math::Random();
+    dataset(1, i) = i % 3;
+    dataset(2, i) = mlpack::math::Random();
+    if (i % 3 == 0)
+      labels[i] = 0;
+    else
+      labels[i] = (dataset(0, i) > 0.4) ? ((dataset(2, i) > 0.7) ? 1 : 2) : 3;
+  }
+
+  HoeffdingTree<> tree(dataset, info, labels, 4, false);
+  BOOST_REQUIRE_GT(tree.NumChildren(), 0);
+  CheckFlatTree(tree, dataset);
+
+  typedef HoeffdingTree<GiniImpurity, BinaryDoubleNumericSplit> BinaryTree;
+  BinaryTree binaryTree(dataset, info, labels, 4, false);
+  BOOST_REQUIRE_GT(binaryTree.NumChildren(), 0);
+  CheckFlatTree(binaryTree, dataset);
+
+  // Make sure some of the points are on the split points of the binary tree.
+  arma::mat splitPoints(dataset.cols(0, 99));
+  std::stack<const BinaryTree*> stack;
+  stack.push(&binaryTree);
+  size_t i = 0;
+  while (!stack.empty() && i < splitPoints.n_cols)
+  {
+    const BinaryTree* node = stack.top();
+    stack.pop();
+    if (node->NumChildren() > 0 && info.Type(node->SplitDimension()) ==
+        data::Datatype::numeric)
+    {
+      splitPoints(node->SplitDimension(), i++) =
+          node->NumericSplit().SplitPoint();
+    }
+
+    for (size_t c = 0; c < node->NumChildren(); ++c)
+      stack.push(&node->Child(c));
+  }
+  CheckFlatTree(binaryTree, splitPoints);
+}
+
+/**
+ * Create a QuantileNumericSplit object with two well-separated classes, and
+ * make sure the sketch stays bounded and still finds a good split.
+ */
+BOOST_AUTO_TEST_CASE(QuantileNumericSplitSimpleSplitTest)
+{
+  QuantileNumericSplit<GiniImpurity> split(2, 50); // 2 classes.
+
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    split.Train(mlpack::math::Random(), 0);
+    split.Train(mlpack::math::Random() + 2.0, 1);
+  }
+
+  BOOST_REQUIRE_EQUAL(split.NumCentroids(), 50);
+  BOOST_REQUIRE_EQUAL(split.MajorityProbability(), 0.5);
+
+  // The Gini impurity for the unsplit node is 0.5, and at most one centroid
+  // can hold points of both classes.
+  double bestGain, secondBestGain;
+  split.EvaluateFitnessFunction(bestGain, secondBestGain);
+  BOOST_REQUIRE_GT(bestGain, 0.45);
+  BOOST_REQUIRE_EQUAL(secondBestGain, 0.0);
+
+  arma::Col<size_t> childMajorities;
+  NumericSplitInfo<> splitInfo;
+  split.Split(childMajorities, splitInfo);
+
+  BOOST_REQUIRE_EQUAL(childMajorities[0], 0);
+  BOOST_REQUIRE_EQUAL(childMajorities[1], 1);
+  BOOST_REQUIRE_EQUAL(splitInfo.CalculateDirection(-1.0), 0);
+  BOOST_REQUIRE_EQUAL(splitInfo.CalculateDirection(0.5), 0);
+  BOOST_REQUIRE_EQUAL(splitInfo.CalculateDirection(2.5), 1);
+  BOOST_REQUIRE_EQUAL(splitInfo.CalculateDirection(4.0), 1);
+}
+
+/**
+ * Make sure the QuantileNumericSplit finds the split of a heavily skewed
+ * feature, where equal-width bins would put most points in the first bin.
+ */
+BOOST_AUTO_TEST_CASE(QuantileNumericSplitSkewedTest)
+{
+  QuantileNumericSplit<GiniImpurity> split(2);
+
+  for (size_t i = 0; i < 5000; ++i)
+  {
+    const double value = std::exp(10.0 * mlpack::math::Random());
+    split.Train(value, (value > 10.0) ? 1 : 0);
+  }
+
+  BOOST_REQUIRE_LE(split.NumCentroids(), split.MaxCentroids());
+
+  double bestGain, secondBestGain;
+  split.EvaluateFitnessFunction(bestGain, secondBestGain);
+  BOOST_REQUIRE_GT(bestGain, 0.0);
+
+  arma::Col<size_t> childMajorities;
+  NumericSplitInfo<> splitInfo;
+  split.Split(childMajorities, splitInfo);
+
+  BOOST_REQUIRE_EQUAL(childMajorities[0], 0);
+  BOOST_REQUIRE_EQUAL(childMajorities[1], 1);
+  BOOST_REQUIRE_EQUAL(splitInfo.CalculateDirection(5.0), 0);
+  BOOST_REQUIRE_EQUAL(splitInfo.CalculateDirection(20.0), 1);
+}
+
+/**
+ * Train a Hoeffding tree with quantile numeric splits, and make sure it is
+ * accurate and that it can be flattened.
+ */
+BOOST_AUTO_TEST_CASE(QuantileNumericHoeffdingTreeTest)
+{
+  arma::mat dataset(3, 9000);
+  arma::Row<size_t> labels(9000);
+  data::DatasetInfo info(3);
+  for (size_t i = 0; i < 9000; i += 3)
+  {
+    dataset(0, i) = mlpack::math::Random();
+    dataset(1, i) = mlpack::math::Random();
+    dataset(2, i) = mlpack::math::Random();
+    labels[i] = 0;
+
+    dataset(0, i + 1) = mlpack::math::Random();
+    dataset(1, i + 1) = mlpack::math::Random() - 1.0;
+    dataset(2, i + 1) = mlpack::math::Random() + 0.5;
+    labels[i + 1] = 2;
+
+    dataset(0, i + 2) = mlpack::math::Random();
+    dataset(1, i + 2) = mlpack::math::Random() + 1.0;
+    dataset(2, i + 2) = mlpack::math::Random() + 0.8;
+    labels[i + 2] = 1;
+  }
+
+  typedef HoeffdingTree<GiniImpurity, QuantileDoubleNumericSplit> TreeType;
+  TreeType tree(info, 3);
+  for (size_t i = 0; i < 9000; ++i)
+    tree.Train(dataset.col(i), labels[i]);
+
+  BOOST_REQUIRE_GT(tree.NumChildren(), 0);
+  BOOST_REQUIRE_EQUAL(tree.SplitDimension(), 1);
+
+  arma::Row<size_t> predictions;
+  tree.Classify(dataset, predictions);
+  size_t correct = 0;
+  for (size_t i = 0; i < 9000; ++i)
+    if (labels[i] == predictions[i])
+      ++correct;
+
+  // Require a pretty high accuracy: 95%.
+  BOOST_REQUIRE_GT(correct, 8550);
+
+  CheckFlatTree(tree, dataset);
+}
+
+/**
+ * Count the leaves of the given tree, and the inactive ones among them.
+ */
+template<typename TreeType>
+void CountLeaves(const TreeType& tree, size_t& leaves, size_t& inactiveLeaves)
+{
+  leaves = 0;
+  inactiveLeaves = 0;
+  std::stack<const TreeType*> stack;
+  stack.push(&tree);
+  while (!stack.empty())
+  {
+    const TreeType* node = stack.top();
+    stack.pop();
+    if (node->NumChildren() == 0)
+    {
+      ++leaves;
+      if (!node->IsActive())
+        ++inactiveLeaves;
+    }
+
+    for (size_t c = 0; c < node->NumChildren(); ++c)
+      stack.push(&node->Child(c));
+  }
+}
+
+/**
+ * Train a tree with a memory budget of half the memory the tree uses without
+ * one, and make sure some leaves are deactivated, the budget is respected, and
+ * the tree still classifies well.  Then make sure leaves are deactivated and
+ * reactivated when the budget changes, and that the inactive leaves are kept
+ * by serialization.
+ */
+BOOST_AUTO_TEST_CASE(MemoryBudgetTest)
+{
+  // Only the first dimension is useful; each class is an interval of it.
+  arma::mat dataset(10, 20000, arma::fill::randu);
+  arma::Row<size_t> labels(20000);
+  for (size_t i = 0; i < 20000; ++i)
+    labels[i] = std::min((size_t) (8 * dataset(0, i)), (size_t) 7);
+  data::DatasetInfo info(10);
+
+  HoeffdingTree<> fullTree(dataset, info, labels, 8, false);
+  BOOST_REQUIRE_GT(fullTree.NumChildren(), 0);
+  size_t leaves, inactiveLeaves;
+  CountLeaves(fullTree, leaves, inactiveLeaves);
+  BOOST_REQUIRE_EQUAL(inactiveLeaves, 0);
+
+  const size_t maxMemory = fullTree.MemoryUsage() / 2;
+  HoeffdingTree<> tree(info, 8);
+  tree.MaxMemory(maxMemory);
+  tree.Train(dataset, labels, false);
+  tree.EnforceMemoryBudget();
+
+  CountLeaves(tree, leaves, inactiveLeaves);
+  BOOST_REQUIRE_GT(inactiveLeaves, 0);
+  BOOST_REQUIRE_LT(inactiveLeaves, leaves);
+  BOOST_REQUIRE_LE(tree.MemoryUsage(), maxMemory);
+
+  arma::Row<size_t> predictions;
+  tree.Classify(dataset, predictions);
+  size_t correct = 0;
+  for (size_t i = 0; i < 20000; ++i)
+    if (labels[i] == predictions[i])
+      ++correct;
+  BOOST_REQUIRE_GT(correct, 14000);
+  CheckFlatTree(tree, dataset);
+
+  // Serialize the tree, and make sure the inactive leaves stay inactive.
+  HoeffdingTree<> loadedTree(info, 8);
+  std::ostringstream oss;
+  {
+    boost::archive::binary_oarchive boa(oss);
+    boa << data::CreateNVP(tree, "streamingDecisionTree");
+  }
+
+  std::istringstream iss(oss.str());
+  {
+    boost::archive::binary_iarchive bia(iss);
+    bia >> data::CreateNVP(loadedTree, "streamingDecisionTree");
+  }
+
+  size_t loadedLeaves, loadedInactiveLeaves;
+  CountLeaves(loadedTree, loadedLeaves, loadedInactiveLeaves);
+  BOOST_REQUIRE_EQUAL(loadedLeaves, leaves);
+  BOOST_REQUIRE_EQUAL(loadedInactiveLeaves, inactiveLeaves);
+  BOOST_REQUIRE_EQUAL(loadedTree.MaxMemory(), maxMemory);
+
+  arma::Row<size_t> loadedPredictions;
+  loadedTree.Classify(dataset, loadedPredictions);
+  for (size_t i = 0; i < 20000; ++i)
+    BOOST_REQUIRE_EQUAL(loadedPredictions[i], predictions[i]);
+
+  // With no room for statistics, every leaf is deactivated, but the
+  // predictions don't change.
+  tree.MaxMemory(1);
+  tree.EnforceMemoryBudget();
+  CountLeaves(tree, leaves, inactiveLeaves);
+  BOOST_REQUIRE_EQUAL(inactiveLeaves, leaves);
+
+  tree.Classify(dataset, loadedPredictions);
+  for (size_t i = 0; i < 20000; ++i)
+    BOOST_REQUIRE_EQUAL(loadedPredictions[i], predictions[i]);
+
+  // With plenty of room, every leaf is reactivated, and may split again.
+  tree.MaxMemory(size_t(-1));
+  tree.EnforceMemoryBudget();
+  CountLeaves(tree, leaves, inactiveLeaves);
+  BOOST_REQUIRE_EQUAL(inactiveLeaves, 0);
+
+  tree.Train(dataset, labels, false);
+  size_t newLeaves;
+  CountLeaves(tree, newLeaves, inactiveLeaves);
+  BOOST_REQUIRE_GE(newLeaves, leaves);
+  BOOST_REQUIRE_EQUAL(inactiveLeaves, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,168 @@
+/**
+ * @file ivf_pq_search_test.cpp
+ *
+ * Unit tests for the 'IVFPQSearch' class.
+ */
+#include <mlpack/core.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+#include <mlpack/methods/ivf_pq/ivf_pq_search.hpp>
+#include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(IVFPQSearchTest);
+
+/**
+ * Make sure that every point is in exactly one inverted list, and that the
+ * codes are valid.
+ */
+BOOST_AUTO_TEST_CASE(IndexStructureTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(10, 500);
+
+  IVFPQSearch pq(dataset, 8, 3, 16);
+
+  BOOST_REQUIRE_EQUAL(pq.NumPoints(), 500);
+  BOOST_REQUIRE_EQUAL(pq.Dimensionality(), 10);
+  BOOST_REQUIRE_EQUAL(pq.NumLists(), 8);
+  BOOST_REQUIRE_EQUAL(pq.NumSubspaces(), 3);
+  BOOST_REQUIRE_EQUAL(pq.NumCentroids(), 16);
+
+  // The subspaces have 4, 3 and 3 dimensions.
+  BOOST_REQUIRE_EQUAL(pq.Codebook(0).n_rows, 4);
+  BOOST_REQUIRE_EQUAL(pq.Codebook(1).n_rows, 3);
+  BOOST_REQUIRE_EQUAL(pq.Codebook(2).n_rows, 3);
+
+  BOOST_REQUIRE_EQUAL(pq.ListOffsets().n_elem, 9);
+  BOOST_REQUIRE_EQUAL(pq.ListOffsets()[0], 0);
+  BOOST_REQUIRE_EQUAL(pq.ListOffsets()[8], 500);
+  BOOST_REQUIRE_EQUAL(pq.Codes().n_rows, 3);
+  BOOST_REQUIRE_EQUAL(pq.Codes().n_cols, 500);
+
+  arma::Col<size_t> counts(500, arma::fill::zeros);
+  for (size_t i = 0; i < pq.ListIndices().n_elem; ++i)
+    counts[pq.ListIndices()[i]]++;
+  for (size_t i = 0; i < 500; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  BOOST_REQUIRE_LT(pq.Codes().max(), 16);
+}
+
+/**
+ * When every list is visited, the approximate neighbors should find a good
+ * part of the true neighbors, and the approximate distances should be close to
+ * the true distances.
+ */
+BOOST_AUTO_TEST_CASE(RecallTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(8, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(8, 100);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(queryData, 10, trueNeighbors, trueDistances);
+
+  IVFPQSearch pq(referenceData, 16, 4, 64);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  pq.Search(queryData, 10, neighbors, distances, 16);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, 100);
+  BOOST_REQUIRE_GE(LSHSearch<>::ComputeRecall(neighbors, trueNeighbors),
+      0.25);
+
+  // The distances are sorted, and not too far from the true distances.
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      BOOST_REQUIRE_LT(neighbors(j, i), 2000);
+      if (j > 0)
+        BOOST_REQUIRE_GE(distances(j, i), distances(j - 1, i));
+
+      const double trueDistance = metric::EuclideanDistance::Evaluate(
+          queryData.col(i), referenceData.col(neighbors(j, i)));
+      BOOST_REQUIRE_SMALL(distances(j, i) - trueDistance, 0.5);
+    }
+  }
+
+  // With one list, we should still find something for each query point.
+  pq.Search(queryData, 1, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    BOOST_REQUIRE_LT(neighbors(0, i), 2000);
+}
+
+/**
+ * Points inserted after training get the next indices and are found by
+ * Search().
+ */
+BOOST_AUTO_TEST_CASE(InsertTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(6, 800);
+  const arma::mat firstPoints = dataset.cols(0, 399);
+
+  IVFPQSearch pq(firstPoints, 4, 3, 32);
+  pq.Insert(dataset.cols(400, 799));
+
+  BOOST_REQUIRE_EQUAL(pq.NumPoints(), 800);
+  BOOST_REQUIRE_EQUAL(pq.ListOffsets()[4], 800);
+  BOOST_REQUIRE_EQUAL(pq.Codes().n_cols, 800);
+
+  arma::Col<size_t> counts(800, arma::fill::zeros);
+  for (size_t i = 0; i < pq.ListIndices().n_elem; ++i)
+    counts[pq.ListIndices()[i]]++;
+  for (size_t i = 0; i < 800; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  // Each inserted point should mostly find itself (its code is the closest).
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  pq.Search(dataset.cols(400, 799), 1, neighbors, distances, 4);
+  size_t found = 0;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    if (neighbors(0, i) == 400 + i)
+      ++found;
+  BOOST_REQUIRE_GE(found, 150);
+
+  BOOST_REQUIRE_THROW(pq.Insert(arma::randu<arma::mat>(5, 10)),
+      std::invalid_argument);
+}
+
+/**
+ * Invalid parameters and untrained indices are errors.
+ */
+BOOST_AUTO_TEST_CASE(InvalidParametersTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 100);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  IVFPQSearch pq;
+  BOOST_REQUIRE_THROW(pq.Search(dataset, 1, neighbors, distances),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Insert(dataset), std::invalid_argument);
+
+  BOOST_REQUIRE_THROW(pq.Train(dataset, 0, 2), std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Train(dataset, 101, 2), std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Train(dataset, 4, 5), std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Train(dataset, 4, 2, 257), std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Train(dataset, 4, 2, 0), std::invalid_argument);
+
+  pq.Train(dataset, 4, 2, 16);
+  BOOST_REQUIRE_THROW(pq.Search(dataset, 101, neighbors, distances),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Search(dataset, 1, neighbors, distances, 0),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(pq.Search(arma::randu<arma::mat>(3, 10), 1, neighbors,
+      distances), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,277 @@
+/**
+ * @file kde_test.cpp
+ *
+ * Tests for the KDE class and the KDEModel class.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/methods/kde/kde.hpp>
+#include <mlpack/methods/kde/kde_model.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+#include "serialization.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+using namespace mlpack::metric;
+using namespace mlpack::tree;
+
+BOOST_AUTO_TEST_SUITE(KDETest);
+
+/**
+ * Compute the density estimates of the query points by brute force.
+ */
+template<typename KernelType>
+arma::vec BruteForceKDE(const arma::mat& reference,
+                        const arma::mat& query,
+                        KernelType kernel,
+                        const double normalizer)
+{
+  arma::vec estimations(query.n_cols, arma::fill::zeros);
+  for (size_t i = 0; i < query.n_cols; ++i)
+    for (size_t j = 0; j < reference.n_cols; ++j)
+      estimations[i] += kernel.Evaluate(EuclideanDistance::Evaluate(
+          query.col(i), reference.col(j)));
+
+  return estimations / (reference.n_cols * normalizer);
+}
+
+/**
+ * Make sure that each estimate is within the error bounds of the exact
+ * estimate (up to rounding, since the kernel values are summed in a different
+ * order).
+ */
+void CheckBounds(const arma::vec& estimations,
+                 const arma::vec& exact,
+                 const double relError,
+                 const double absError)
+{
+  BOOST_REQUIRE_EQUAL(estimations.n_elem, exact.n_elem);
+  for (size_t i = 0; i < exact.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LE(std::abs(estimations[i] - exact[i]),
+        (relError + 1e-10) * exact[i] + absError + 1e-12);
+  }
+}
+
+/**
+ * Estimate the densities with the given KDE type in naive, single-tree and
+ * dual-tree mode, and make sure they are all within the error bounds.
+ */
+template<typename KernelType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckModes(const arma::mat& reference,
+                const arma::mat& query,
+                const KernelType& kernel,
+                const double relError,
+                const double absError)
+{
+  typedef KDE<KernelType, EuclideanDistance, arma::mat, TreeType> KDEType;
+
+  KDEType naive(relError, absError, kernel, EuclideanDistance(), true);
+  naive.Train(reference);
+  arma::vec exact;
+  naive.Evaluate(query, exact);
+
+  KDEType single(relError, absError, kernel, EuclideanDistance(), false,
+      true);
+  single.Train(reference);
+  arma::vec singleEstimations;
+  single.Evaluate(query, singleEstimations);
+  CheckBounds(singleEstimations, exact, relError, absError);
+
+  KDEType dual(relError, absError, kernel);
+  dual.Train(reference);
+  arma::vec dualEstimations;
+  dual.Evaluate(query, dualEstimations);
+  CheckBounds(dualEstimations, exact, relError, absError);
+
+  // The monochromatic estimates are the estimates at the reference points.
+  arma::vec exactMono, monoEstimations;
+  naive.Evaluate(reference, exactMono);
+  dual.Evaluate(monoEstimations);
+  CheckBounds(monoEstimations, exactMono, relError, absError);
+  single.Evaluate(monoEstimations);
+  CheckBounds(monoEstimations, exactMono, relError, absError);
+}
+
+/**
+ * Make sure that naive estimation gives the normalized Gaussian density
+ * estimate.
+ */
+BOOST_AUTO_TEST_CASE(NaiveGaussianTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(3, 100);
+  arma::mat query = arma::randu<arma::mat>(3, 50);
+  const double bandwidth = 0.3;
+
+  KDE<> kde(0.0, 0.0, GaussianKernel(bandwidth), EuclideanDistance(), true);
+  kde.Train(reference);
+  arma::vec estimations;
+  kde.Evaluate(query, estimations);
+
+  BOOST_REQUIRE_EQUAL(estimations.n_elem, query.n_cols);
+  for (size_t i = 0; i < query.n_cols; ++i)
+  {
+    double density = 0.0;
+    for (size_t j = 0; j < reference.n_cols; ++j)
+    {
+      const double distance = arma::norm(query.col(i) - reference.col(j));
+      density += std::exp(-distance * distance /
+          (2 * bandwidth * bandwidth));
+    }
+    density /= reference.n_cols * std::pow(std::sqrt(2 * M_PI) * bandwidth,
+        3.0);
+
+    BOOST_REQUIRE_CLOSE(estimations[i], density, 1e-8);
+  }
+}
+
+/**
+ * With no error tolerance, the tree estimates must be the exact estimates.
+ */
+BOOST_AUTO_TEST_CASE(ExactTreeTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(2, 300);
+  arma::mat query = arma::randu<arma::mat>(2, 100);
+  EpanechnikovKernel kernel(0.2);
+
+  const arma::vec exact = BruteForceKDE(reference, query, kernel,
+      kernel.Normalizer(2));
+
+  KDE<EpanechnikovKernel> kde(0.0, 0.0, kernel);
+  kde.Train(reference);
+  arma::vec estimations;
+  kde.Evaluate(query, estimations);
+
+  for (size_t i = 0; i < query.n_cols; ++i)
+  {
+    if (exact[i] == 0.0)
+      BOOST_REQUIRE_SMALL(estimations[i], 1e-12);
+    else
+      BOOST_REQUIRE_CLOSE(estimations[i], exact[i], 1e-8);
+  }
+
+  // The Epanechnikov kernel is 0 beyond the bandwidth, so far nodes must have
+  // been pruned.
+  BOOST_REQUIRE_LT(kde.BaseCases(), reference.n_cols * query.n_cols);
+}
+
+/**
+ * Check the error bounds of the kd-tree with a relative error tolerance.
+ */
+BOOST_AUTO_TEST_CASE(KDTreeRelativeErrorTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(3, 1000);
+  arma::mat query = arma::randu<arma::mat>(3, 200);
+
+  CheckModes<GaussianKernel, KDTree>(reference, query, GaussianKernel(0.1),
+      0.05, 0.0);
+}
+
+/**
+ * Check the error bounds of the kd-tree with an absolute error tolerance.
+ */
+BOOST_AUTO_TEST_CASE(KDTreeAbsoluteErrorTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(3, 1000);
+  arma::mat query = arma::randu<arma::mat>(3, 200);
+
+  CheckModes<GaussianKernel, KDTree>(reference, query, GaussianKernel(0.1),
+      0.0, 0.01);
+}
+
+/**
+ * Check the error bounds of the other tree types.
+ */
+BOOST_AUTO_TEST_CASE(TreeTypesTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(3, 500);
+  arma::mat query = arma::randu<arma::mat>(3, 100);
+
+  CheckModes<GaussianKernel, BallTree>(reference, query, GaussianKernel(0.2),
+      0.05, 0.0);
+  CheckModes<GaussianKernel, StandardCoverTree>(reference, query,
+      GaussianKernel(0.2), 0.05, 0.0);
+  CheckModes<GaussianKernel, RTree>(reference, query, GaussianKernel(0.2),
+      0.05, 0.0);
+  CheckModes<EpanechnikovKernel, StandardCoverTree>(reference, query,
+      EpanechnikovKernel(0.3), 0.0, 0.0);
+}
+
+/**
+ * Check the error bounds of the other kernels.
+ */
+BOOST_AUTO_TEST_CASE(KernelsTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(3, 500);
+  arma::mat query = arma::randu<arma::mat>(3, 100);
+
+  CheckModes<EpanechnikovKernel, KDTree>(reference, query,
+      EpanechnikovKernel(0.3), 0.05, 0.0);
+  CheckModes<LaplacianKernel, KDTree>(reference, query, LaplacianKernel(0.2),
+      0.05, 0.0);
+  CheckModes<SphericalKernel, KDTree>(reference, query, SphericalKernel(0.3),
+      0.0, 0.0);
+  CheckModes<TriangularKernel, KDTree>(reference, query, TriangularKernel(0.4),
+      0.05, 0.0);
+}
+
+/**
+ * Make sure invalid arguments are rejected.
+ */
+BOOST_AUTO_TEST_CASE(InvalidArgumentsTest)
+{
+  BOOST_REQUIRE_THROW(KDE<>(-0.1, 0.0), std::invalid_argument);
+  BOOST_REQUIRE_THROW(KDE<>(0.1, -1.0), std::invalid_argument);
+
+  KDE<> kde;
+  arma::vec estimations;
+  arma::mat query = arma::randu<arma::mat>(3, 10);
+  BOOST_REQUIRE_THROW(kde.Evaluate(query, estimations), std::invalid_argument);
+  BOOST_REQUIRE_THROW(kde.Evaluate(estimations), std::invalid_argument);
+
+  kde.Train(arma::randu<arma::mat>(4, 10));
+  BOOST_REQUIRE_THROW(kde.Evaluate(query, estimations), std::invalid_argument);
+  BOOST_REQUIRE_THROW(kde.RelativeError(-1.0), std::invalid_argument);
+}
+
+/**
+ * Make sure that a serialized KDEModel gives the same estimates.
+ */
+BOOST_AUTO_TEST_CASE(KDEModelSerializationTest)
+{
+  arma::mat reference = arma::randu<arma::mat>(3, 300);
+  arma::mat query = arma::randu<arma::mat>(3, 50);
+
+  for (size_t t = 0; t < 4; ++t)
+  {
+    KDEModel model(0.2, 0.05, 0.0, KDEModel::EPANECHNIKOV_KERNEL,
+        (KDEModel::TreeTypes) t);
+    model.BuildModel(arma::mat(reference), false, false);
+
+    arma::vec estimations;
+    model.Evaluate(query, estimations);
+
+    KDEModel xmlModel, textModel, binaryModel;
+    xmlModel.BuildModel(arma::randu<arma::mat>(2, 10), true, false);
+    SerializeObjectAll(model, xmlModel, textModel, binaryModel);
+
+    BOOST_REQUIRE_EQUAL(xmlModel.TreeType(), model.TreeType());
+    BOOST_REQUIRE_EQUAL(xmlModel.KernelType(), model.KernelType());
+
+    arma::vec xmlEstimations, textEstimations, binaryEstimations;
+    xmlModel.Evaluate(query, xmlEstimations);
+    textModel.Evaluate(query, textEstimations);
+    binaryModel.Evaluate(query, binaryEstimations);
+
+    CheckMatrices(estimations, xmlEstimations, textEstimations,
+        binaryEstimations);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
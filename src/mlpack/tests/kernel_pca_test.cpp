@@ -8,9 +8,11 @@
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 #include <mlpack/methods/kernel_pca/kernel_rules/nystroem_method.hpp>
 #include <mlpack/methods/kernel_pca/kernel_pca.hpp>
+#include <mlpack/methods/nystroem_method/ordered_selection.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
+#include "serialization.hpp"
 
 BOOST_AUTO_TEST_SUITE(KernelPCATest);
 
@@ -145,4 +147,123 @@ BOOST_AUTO_TEST_CASE(CircleTransformationTestNystroem)
   BOOST_REQUIRE_EQUAL(ranges[1].Contains(ranges[2]), false);
 }
 
+/**
+ * Make sure that KernelPCA with a kernel cache gives the same results as
+ * without, and that Transform() projects the points of the dataset onto the
+ * same coordinates as Apply().
+ */
+BOOST_AUTO_TEST_CASE(KernelCacheTransformTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 100);
+  GaussianKernel g(0.5);
+
+  for (size_t center = 0; center < 2; ++center)
+  {
+    KernelPCA<GaussianKernel> p(g, center == 1);
+    arma::mat transformedData, eigvec;
+    arma::vec eigval;
+    p.Apply(dataset, transformedData, eigval, eigvec);
+
+    KernelCache<GaussianKernel> cache(dataset, g);
+    KernelPCA<GaussianKernel> cachedP(g, center == 1);
+    arma::mat cachedTransformedData, cachedEigvec;
+    arma::vec cachedEigval;
+    cachedP.Apply(cache, cachedTransformedData, cachedEigval, cachedEigvec, 2);
+
+    // Only the first two dimensions are kept.
+    BOOST_REQUIRE_EQUAL(cachedTransformedData.n_rows, 2);
+    BOOST_REQUIRE_EQUAL(cachedTransformedData.n_cols, dataset.n_cols);
+    for (size_t i = 0; i < 2; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(cachedEigval[i], eigval[i], 1e-5);
+      for (size_t j = 0; j < dataset.n_cols; ++j)
+      {
+        BOOST_REQUIRE_CLOSE(cachedTransformedData(i, j),
+            transformedData(i, j), 1e-3);
+      }
+    }
+
+    arma::mat transformedPoints;
+    cachedP.Transform(dataset.cols(0, 9), transformedPoints);
+    BOOST_REQUIRE_EQUAL(transformedPoints.n_rows, 2);
+    BOOST_REQUIRE_EQUAL(transformedPoints.n_cols, 10);
+    for (size_t i = 0; i < transformedPoints.n_elem; ++i)
+    {
+      const size_t row = i % 2;
+      const size_t col = i / 2;
+      if (std::abs(cachedTransformedData(row, col)) < 1e-5)
+        BOOST_REQUIRE_SMALL(transformedPoints[i], 1e-5);
+      else
+        BOOST_REQUIRE_CLOSE(transformedPoints[i],
+            cachedTransformedData(row, col), 1e-3);
+    }
+  }
+}
+
+/**
+ * Make sure that Transform() projects the points of the dataset onto the same
+ * coordinates as Apply(), with and without the Nystroem method.
+ */
+BOOST_AUTO_TEST_CASE(TransformTrainingPointsTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 600);
+  GaussianKernel g(0.5);
+
+  KernelPCA<GaussianKernel> p(g, true);
+  arma::mat transformedData;
+  arma::vec eigval;
+  arma::mat eigvec;
+  p.Apply(dataset, transformedData, eigval, eigvec, 3);
+
+  KernelPCA<GaussianKernel, NystroemKernelRule<GaussianKernel,
+      OrderedSelection> > nystroemP(g);
+  arma::mat nystroemTransformedData;
+  nystroemP.Apply(dataset, nystroemTransformedData, eigval, eigvec, 20);
+
+  arma::mat transformedPoints, nystroemTransformedPoints;
+  p.Transform(dataset, transformedPoints);
+  nystroemP.Transform(dataset, nystroemTransformedPoints);
+
+  BOOST_REQUIRE_EQUAL(transformedPoints.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(nystroemTransformedPoints.n_rows, 20);
+  BOOST_REQUIRE_EQUAL(transformedPoints.n_cols, dataset.n_cols);
+  BOOST_REQUIRE_EQUAL(nystroemTransformedPoints.n_cols, dataset.n_cols);
+  BOOST_REQUIRE_SMALL(arma::norm(transformedPoints -
+      transformedData.rows(0, 2), "fro") / arma::norm(transformedPoints, "fro"),
+      1e-5);
+  BOOST_REQUIRE_SMALL(arma::norm(nystroemTransformedPoints -
+      nystroemTransformedData, "fro") / arma::norm(nystroemTransformedData,
+      "fro"), 1e-5);
+}
+
+/**
+ * Make sure that a serialized KernelPCA object projects new points like the
+ * original object.
+ */
+BOOST_AUTO_TEST_CASE(KernelPCASerializationTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 100);
+
+  KernelPCA<GaussianKernel> p(GaussianKernel(0.5), true);
+  arma::mat transformedData;
+  arma::vec eigval;
+  p.Apply(dataset, transformedData, eigval);
+
+  KernelPCA<GaussianKernel> xmlP, textP, binaryP;
+  SerializeObjectAll(p, xmlP, textP, binaryP);
+
+  arma::mat points;
+  points.randu(3, 20);
+  arma::mat transformedPoints, xmlPoints, textPoints, binaryPoints;
+  p.Transform(points, transformedPoints);
+  xmlP.Transform(points, xmlPoints);
+  textP.Transform(points, textPoints);
+  binaryP.Transform(points, binaryPoints);
+
+  CheckMatrices(transformedPoints, xmlPoints, textPoints, binaryPoints);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
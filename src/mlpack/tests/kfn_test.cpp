@@ -563,4 +563,59 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest)
   }
 }
 
+/**
+ * Make sure that a budgeted furthest neighbor search without a limit gives the
+ * exact results, and that with a small budget the most promising (furthest)
+ * nodes are searched first, so the furthest neighbors found are close to the
+ * exact ones.
+ */
+BOOST_AUTO_TEST_CASE(BudgetedSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryset = arma::randu<arma::mat>(3, 100);
+
+  KFN kfn(dataset);
+  arma::mat distances;
+  arma::Mat<size_t> neighbors;
+  kfn.Search(queryset, 5, neighbors, distances);
+
+  // With no limit, the search is exact.
+  arma::mat budgetedDistances;
+  arma::Mat<size_t> budgetedNeighbors;
+  BOOST_REQUIRE(kfn.BudgetedSearch(queryset, 5, budgetedNeighbors,
+      budgetedDistances, 0));
+  for (size_t i = 0; i < distances.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(budgetedNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(budgetedDistances[i], distances[i], 1e-5);
+  }
+
+  // With a budget of a few leaves, the search is stopped, and the neighbors
+  // are no better than the exact ones.  Since the leaves which may hold the
+  // furthest points are searched first, the furthest neighbor found is nearly
+  // as far as the exact one (searching the closest leaves first would find
+  // neighbors several times closer).
+  BOOST_REQUIRE(!kfn.BudgetedSearch(queryset, 5, budgetedNeighbors,
+      budgetedDistances, 40));
+  double ratio = 0.0;
+  for (size_t i = 0; i < distances.n_cols; ++i)
+  {
+    for (size_t j = 0; j < distances.n_rows; ++j)
+    {
+      BOOST_REQUIRE_LE(budgetedDistances(j, i), distances(j, i) + 1e-10);
+
+      // Every neighbor that was found has the right distance.
+      if (budgetedNeighbors(j, i) != size_t() - 1)
+      {
+        BOOST_REQUIRE_CLOSE(budgetedDistances(j, i), arma::norm(
+            queryset.col(i) - dataset.col(budgetedNeighbors(j, i))), 1e-5);
+      }
+    }
+
+    ratio += budgetedDistances(0, i) / distances(0, i);
+  }
+
+  BOOST_REQUIRE_GT(ratio / distances.n_cols, 0.9);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
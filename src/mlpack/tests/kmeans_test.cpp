@@ -7,10 +7,15 @@
 #include <mlpack/methods/kmeans/kmeans.hpp>
 #include <mlpack/methods/kmeans/allow_empty_clusters.hpp>
 #include <mlpack/methods/kmeans/refined_start.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus_initialization.hpp>
+#include <mlpack/methods/kmeans/kmeans_parallel_initialization.hpp>
 #include <mlpack/methods/kmeans/elkan_kmeans.hpp>
 #include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/yinyang_kmeans.hpp>
 #include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
 #include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/chunked_kmeans.hpp>
 #include <mlpack/methods/kmeans/sample_initialization.hpp>
 #include <mlpack/methods/kmeans/random_partition.hpp>
 
@@ -448,6 +453,119 @@ BOOST_AUTO_TEST_CASE(RefinedStartTest)
   BOOST_REQUIRE_LT(distortion, 14000.0);
 }
 
+/**
+ * Make sure that the refined start gives the same centroids for a given seed,
+ * whatever the number of threads that run the samplings.
+ */
+BOOST_AUTO_TEST_CASE(RefinedStartThreadsTest)
+{
+  arma::mat data = arma::randn<arma::mat>(3, 2000);
+  data.cols(1000, 1999) += 5.0;
+
+  RefinedStart rs(20, 0.1);
+  arma::mat centroids1, centroids4;
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  math::RandomSeed(11);
+  rs.Cluster(data, 4, centroids1);
+  const double next1 = math::Random();
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  math::RandomSeed(11);
+  rs.Cluster(data, 4, centroids4);
+  const double next4 = math::Random();
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(centroids1.n_elem, centroids4.n_elem);
+  for (size_t i = 0; i < centroids1.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids1[i], centroids4[i], 1e-10);
+
+  // The global generator is left in the same state.
+  BOOST_REQUIRE_EQUAL(next1, next4);
+}
+
+/**
+ * Make sure that the given initial centroids of five clusters centered at
+ * 1000 * e_1, ..., 1000 * e_5 are each close to a different cluster center.
+ */
+void CheckSeparatedCentroids(const arma::mat& centroids)
+{
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 5);
+
+  std::vector<bool> found(5, false);
+  for (size_t c = 0; c < 5; ++c)
+  {
+    arma::uword cluster;
+    centroids.col(c).max(cluster);
+    const arma::vec center = 1000.0 * arma::eye<arma::mat>(5, 5).col(cluster);
+    BOOST_REQUIRE_LT(metric::EuclideanDistance::Evaluate(centroids.col(c),
+        center), 20.0);
+    BOOST_REQUIRE(!found[cluster]);
+    found[cluster] = true;
+  }
+}
+
+/**
+ * Make sure that the k-means++ seeding picks one point of each of five
+ * well-separated clusters, and that KMeans can use it.
+ */
+BOOST_AUTO_TEST_CASE(KMeansPlusPlusTest)
+{
+  arma::mat dataset(5, 1000);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = 1000.0 * arma::eye<arma::mat>(5, 5).col(i % 5) +
+        arma::randn<arma::vec>(5);
+
+  arma::mat centroids;
+  KMeansPlusPlusInitialization::Cluster(dataset, 5, centroids);
+  CheckSeparatedCentroids(centroids);
+
+  // Clustering from the seeds must recover the clusters.
+  KMeans<metric::EuclideanDistance, KMeansPlusPlusInitialization> km;
+  arma::Row<size_t> assignments;
+  km.Cluster(dataset, 5, assignments);
+  for (size_t i = 5; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[i % 5]);
+}
+
+/**
+ * Make sure that the k-means|| seeding finds one centroid near each of five
+ * well-separated clusters, and that KMeans can use it.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelTest)
+{
+  arma::mat dataset(5, 1000);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = 1000.0 * arma::eye<arma::mat>(5, 5).col(i % 5) +
+        arma::randn<arma::vec>(5);
+
+  KMeansParallelInitialization kmp(2.0, 5);
+  BOOST_REQUIRE_EQUAL(kmp.Oversampling(), 2.0);
+  BOOST_REQUIRE_EQUAL(kmp.Rounds(), 5);
+
+  arma::mat centroids;
+  kmp.Cluster(dataset, 5, centroids);
+  CheckSeparatedCentroids(centroids);
+
+  KMeans<metric::EuclideanDistance, KMeansParallelInitialization> km;
+  arma::Row<size_t> assignments;
+  km.Cluster(dataset, 5, assignments);
+  for (size_t i = 5; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[i % 5]);
+
+  // With no rounds, the centroids are the first sampled point and random
+  // points; there must still be five of them.
+  kmp.Rounds() = 0;
+  kmp.Cluster(dataset, 5, centroids);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 5);
+}
+
 #ifdef ARMA_HAS_SPMAT
 // Can't do this test on Armadillo 3.4; var(SpBase) is not implemented.
 #if !((ARMA_VERSION_MAJOR == 3) && (ARMA_VERSION_MINOR == 4))
@@ -568,6 +686,368 @@ BOOST_AUTO_TEST_CASE(HamerlyTest)
   }
 }
 
+/**
+ * Make sure Yinyang k-means returns the same clusters as the naive method, for
+ * different numbers of groups.
+ */
+BOOST_AUTO_TEST_CASE(YinyangTest)
+{
+  typedef KMeans<metric::EuclideanDistance, RandomPartition,
+      MaxVarianceNewCluster, YinyangKMeans> YinyangType;
+
+  const size_t trials = 5;
+  const size_t numGroups[trials] = { 0, 1, 3, 7, 100 };
+  for (size_t t = 0; t < trials; ++t)
+  {
+    arma::mat dataset(10, 1000);
+    dataset.randu();
+
+    const size_t k = 10 * (t + 1);
+    arma::mat centroids(10, k);
+    centroids.randu();
+
+    arma::mat naiveCentroids(centroids);
+    KMeans<> km;
+    arma::Row<size_t> assignments;
+    km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+    YinyangType yinyang;
+    const size_t groups = numGroups[t];
+    yinyang.StepSetup() = [groups](YinyangType::LloydStep& step)
+        { step.NumGroups() = groups; };
+    arma::Row<size_t> yinyangAssignments;
+    arma::mat yinyangCentroids(centroids);
+    yinyang.Cluster(dataset, k, yinyangAssignments, yinyangCentroids, false,
+        true);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(assignments[i], yinyangAssignments[i]);
+
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(naiveCentroids[i], yinyangCentroids[i], 1e-5);
+  }
+}
+
+/**
+ * Run k-means with the given Lloyd step type from the given centroids, once
+ * with one thread and once with four, and make sure the clusterings are
+ * exactly the same.
+ */
+template<template<class, class> class LloydStepType>
+void CheckThreadCountIndependence(const arma::mat& dataset,
+                                  const arma::mat& centroids)
+{
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      LloydStepType> km;
+
+  arma::Row<size_t> assignments1, assignments2;
+  arma::mat centroids1(centroids), centroids2(centroids);
+
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  km.Cluster(dataset, centroids.n_cols, assignments1, centroids1, false, true);
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  km.Cluster(dataset, centroids.n_cols, assignments2, centroids2, false, true);
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(arma::accu(assignments1 != assignments2), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(centroids1 != centroids2), 0);
+}
+
+/**
+ * Make sure that the naive, Elkan, and Hamerly Lloyd steps give bitwise
+ * identical results whatever the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelLloydStepTest)
+{
+  arma::mat dataset(10, 3000);
+  dataset.randu();
+  arma::mat centroids(10, 20);
+  centroids.randu();
+
+  CheckThreadCountIndependence<NaiveKMeans>(dataset, centroids);
+  CheckThreadCountIndependence<ElkanKMeans>(dataset, centroids);
+  CheckThreadCountIndependence<HamerlyKMeans>(dataset, centroids);
+  CheckThreadCountIndependence<YinyangKMeans>(dataset, centroids);
+}
+
+/**
+ * Make sure that a mini-batch step only moves the centroids that are given
+ * sampled points, and that the counts add up to the number of sampled points.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchIterateTest)
+{
+  arma::mat dataset(3, 500);
+  dataset.randu();
+  arma::mat centroids(3, 4);
+  centroids.randu();
+
+  typedef MiniBatchKMeans<metric::EuclideanDistance, arma::mat> StepType;
+  metric::EuclideanDistance metric;
+  StepType step(dataset, metric, 50);
+  arma::mat newCentroids, otherCentroids;
+  arma::Col<size_t> counts;
+  step.Iterate(centroids, newCentroids, counts);
+
+  BOOST_REQUIRE_EQUAL(counts.n_elem, 4);
+  BOOST_REQUIRE_EQUAL(arma::accu(counts), 50);
+  BOOST_REQUIRE_EQUAL(step.DistanceCalculations(), 50 * 4 + 4);
+  for (size_t c = 0; c < 4; ++c)
+    if (counts[c] == 0)
+      BOOST_REQUIRE_EQUAL(arma::accu(newCentroids.col(c) != centroids.col(c)),
+          0);
+
+  // The counts keep growing over iterations.
+  step.Iterate(newCentroids, otherCentroids, counts);
+  BOOST_REQUIRE_EQUAL(arma::accu(counts), 100);
+}
+
+/**
+ * Make sure that the batch size set through StepSetup() is only used by the
+ * KMeans object it is set on.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchStepSetupTest)
+{
+  arma::mat dataset(3, 300);
+  dataset.randu();
+  arma::mat centroids;
+
+  typedef KMeans<metric::EuclideanDistance, SampleInitialization,
+      AllowEmptyClusters, MiniBatchKMeans> KMeansType;
+  KMeansType small(3), other(3);
+
+  size_t setups = 0;
+  small.StepSetup() = [&setups](KMeansType::LloydStep& step)
+  {
+    step.BatchSize() = 10;
+    ++setups;
+  };
+  size_t otherBatchSize = 0;
+  other.StepSetup() = [&otherBatchSize](KMeansType::LloydStep& step)
+      { otherBatchSize = step.BatchSize(); };
+
+  small.Cluster(dataset, 4, centroids);
+  other.Cluster(dataset, 4, centroids);
+  small.Cluster(dataset, 4, centroids);
+
+  BOOST_REQUIRE_EQUAL(setups, 2);
+  BOOST_REQUIRE_EQUAL(otherBatchSize, 1000);
+}
+
+/**
+ * Make sure that mini-batch k-means finds the centers of well-separated
+ * clusters.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchTest)
+{
+  // Five Gaussian clusters, far apart.
+  arma::mat means = 20.0 * arma::eye<arma::mat>(5, 5);
+  arma::mat dataset(5, 5000);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = means.col(i % 5) + arma::randn<arma::vec>(5);
+
+  // Start near the true centers, so every algorithm finds the same clusters.
+  arma::mat centroids = means + 2.0 * arma::randu<arma::mat>(5, 5);
+
+  arma::mat naiveCentroids(centroids);
+  KMeans<> km;
+  arma::Row<size_t> assignments;
+  km.Cluster(dataset, 5, assignments, naiveCentroids, false, true);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, AllowEmptyClusters,
+      MiniBatchKMeans> miniBatch(200);
+  arma::Row<size_t> miniBatchAssignments;
+  arma::mat miniBatchCentroids(centroids);
+  miniBatch.Cluster(dataset, 5, miniBatchAssignments, miniBatchCentroids,
+      false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], miniBatchAssignments[i]);
+
+  // The mini-batch centroids are only approximate.
+  for (size_t c = 0; c < 5; ++c)
+    BOOST_REQUIRE_LT(metric::EuclideanDistance::Evaluate(
+        naiveCentroids.col(c), miniBatchCentroids.col(c)), 0.2);
+}
+
+/**
+ * Make sure that the naive, Hamerly and mini-batch steps find the same clusters
+ * on a sparse dataset as on the same dataset stored densely.
+ */
+BOOST_AUTO_TEST_CASE(SparseLloydStepsTest)
+{
+  // Each cluster has its own block of 20 dimensions.
+  arma::sp_mat data(100, 1000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    for (size_t d = 0; d < 20; ++d)
+      if (math::Random() < 0.3)
+        data(20 * (i % 5) + d, i) = math::Random(0.5, 1.5);
+  arma::mat denseData(data);
+
+  // Start from one point of each cluster.
+  arma::mat centroids = denseData.cols(0, 4);
+
+  KMeans<> km;
+  arma::Row<size_t> assignments;
+  arma::mat denseCentroids(centroids);
+  km.Cluster(denseData, 5, assignments, denseCentroids, false, true);
+
+  KMeans<metric::EuclideanDistance, SampleInitialization,
+      MaxVarianceNewCluster, NaiveKMeans, arma::sp_mat> naive;
+  arma::Row<size_t> naiveAssignments;
+  arma::mat naiveCentroids(centroids);
+  naive.Cluster(data, 5, naiveAssignments, naiveCentroids, false, true);
+
+  KMeans<metric::EuclideanDistance, SampleInitialization,
+      MaxVarianceNewCluster, HamerlyKMeans, arma::sp_mat> hamerly;
+  arma::Row<size_t> hamerlyAssignments;
+  arma::mat hamerlyCentroids(centroids);
+  hamerly.Cluster(data, 5, hamerlyAssignments, hamerlyCentroids, false, true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(naiveAssignments[i], assignments[i]);
+    BOOST_REQUIRE_EQUAL(hamerlyAssignments[i], assignments[i]);
+  }
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+  {
+    BOOST_REQUIRE_SMALL(naiveCentroids[i] - denseCentroids[i], 1e-10);
+    BOOST_REQUIRE_SMALL(hamerlyCentroids[i] - denseCentroids[i], 1e-10);
+  }
+
+  // The mini-batch step samples the same points with the same seed.
+  KMeans<metric::EuclideanDistance, SampleInitialization, AllowEmptyClusters,
+      MiniBatchKMeans> miniBatch(20);
+  arma::mat miniBatchCentroids(centroids);
+  math::RandomSeed(1);
+  miniBatch.Cluster(denseData, 5, miniBatchCentroids, true);
+
+  KMeans<metric::EuclideanDistance, SampleInitialization, AllowEmptyClusters,
+      MiniBatchKMeans, arma::sp_mat> sparseMiniBatch(20);
+  arma::mat sparseMiniBatchCentroids(centroids);
+  math::RandomSeed(1);
+  sparseMiniBatch.Cluster(data, 5, sparseMiniBatchCentroids, true);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(sparseMiniBatchCentroids[i] - miniBatchCentroids[i],
+        1e-10);
+}
+
+/**
+ * Make sure that the naive and Hamerly steps find the same clusters on a
+ * single-precision dataset as on the same dataset in double precision.
+ */
+BOOST_AUTO_TEST_CASE(FloatKMeansTest)
+{
+  // Five Gaussian clusters, far apart.
+  arma::mat means = 20.0 * arma::eye<arma::mat>(5, 5);
+  arma::fmat data(5, 2000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = arma::conv_to<arma::fvec>::from(means.col(i % 5) +
+        arma::randn<arma::vec>(5));
+  const arma::mat doubleData = arma::conv_to<arma::mat>::from(data);
+
+  arma::mat centroids = means + 2.0 * arma::randu<arma::mat>(5, 5);
+
+  KMeans<> km;
+  arma::Row<size_t> assignments;
+  arma::mat doubleCentroids(centroids);
+  km.Cluster(doubleData, 5, assignments, doubleCentroids, false, true);
+
+  KMeans<metric::EuclideanDistance, SampleInitialization,
+      MaxVarianceNewCluster, NaiveKMeans, arma::fmat> naive;
+  arma::Row<size_t> naiveAssignments;
+  arma::mat naiveCentroids(centroids);
+  naive.Cluster(data, 5, naiveAssignments, naiveCentroids, false, true);
+
+  KMeans<metric::EuclideanDistance, SampleInitialization,
+      MaxVarianceNewCluster, HamerlyKMeans, arma::fmat> hamerly;
+  arma::Row<size_t> hamerlyAssignments;
+  arma::mat hamerlyCentroids(centroids);
+  hamerly.Cluster(data, 5, hamerlyAssignments, hamerlyCentroids, false, true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(naiveAssignments[i], assignments[i]);
+    BOOST_REQUIRE_EQUAL(hamerlyAssignments[i], assignments[i]);
+  }
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], doubleCentroids[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(hamerlyCentroids[i], doubleCentroids[i], 1e-8);
+  }
+
+  // Sampled initial centroids are points of the dataset.
+  KMeans<metric::EuclideanDistance, SampleInitialization,
+      MaxVarianceNewCluster, NaiveKMeans, arma::fmat> sampled;
+  arma::mat sampledCentroids;
+  sampled.Cluster(data, 5, sampledCentroids);
+  BOOST_REQUIRE_EQUAL(sampledCentroids.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(sampledCentroids.n_cols, 5);
+}
+
+/**
+ * Make sure that ChunkedKMeans, reading the dataset from a file in chunks,
+ * finds the same clusters as the naive method on the loaded dataset, and that
+ * Assign() writes the same assignments.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedKMeansTest)
+{
+  arma::mat dataset(4, 503);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = 10.0 * arma::eye<arma::mat>(4, 4).col(i % 4) +
+        arma::randn<arma::vec>(4);
+  arma::mat centroids = 10.0 * arma::eye<arma::mat>(4, 4) +
+      arma::randu<arma::mat>(4, 4);
+
+  for (size_t format = 0; format < 2; ++format)
+  {
+    const std::string filename = (format == 0) ? "test_chunked_kmeans.csv" :
+        "test_chunked_kmeans.bin";
+    BOOST_REQUIRE(data::Save(filename, dataset) == true);
+    arma::mat loaded;
+    BOOST_REQUIRE(data::Load(filename, loaded) == true);
+
+    arma::mat naiveCentroids(centroids);
+    KMeans<metric::EuclideanDistance, RandomPartition, AllowEmptyClusters> km;
+    arma::Row<size_t> assignments;
+    km.Cluster(loaded, 4, assignments, naiveCentroids, false, true);
+
+    ChunkedKMeans<> chunked(50);
+    arma::mat chunkedCentroids(centroids);
+    chunked.Cluster(filename, 4, chunkedCentroids, true);
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(naiveCentroids[i], chunkedCentroids[i], 1e-5);
+
+    chunked.Assign(filename, chunkedCentroids, "test_chunked_labels.csv");
+    arma::Mat<size_t> labels;
+    BOOST_REQUIRE(data::Load("test_chunked_labels.csv", labels) == true);
+    BOOST_REQUIRE_EQUAL(labels.n_elem, dataset.n_cols);
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(labels[i], assignments[i]);
+
+    // Sampled initial centroids must give the right number of centroids.
+    arma::mat sampledCentroids;
+    chunked.Cluster(filename, 4, sampledCentroids);
+    BOOST_REQUIRE_EQUAL(sampledCentroids.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(sampledCentroids.n_cols, 4);
+
+    BOOST_REQUIRE_THROW(chunked.Cluster(filename, 1000, sampledCentroids),
+        std::invalid_argument);
+    remove(filename.c_str());
+  }
+
+  remove("test_chunked_labels.csv");
+}
+
 BOOST_AUTO_TEST_CASE(PellegMooreTest)
 {
   const size_t trials = 5;
@@ -666,6 +1146,46 @@ BOOST_AUTO_TEST_CASE(DTNNCoverTreeTest)
   }
 }
 
+/**
+ * Make sure that every iteration of the dual-tree Lloyd step gives the same
+ * result as the naive step when the centroids only move a little, so that the
+ * centroid tree is refit instead of rebuilt and pruned parts of the tree are
+ * skipped.
+ */
+BOOST_AUTO_TEST_CASE(DTNNIterateTest)
+{
+  arma::mat means(3, 5);
+  means.randu();
+  means *= 50;
+
+  arma::mat dataset(3, 2000);
+  dataset.randn();
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) += means.col(i % 5);
+
+  metric::EuclideanDistance metric;
+  NaiveKMeans<metric::EuclideanDistance, arma::mat> naive(dataset, metric);
+  DefaultDualTreeKMeans<metric::EuclideanDistance, arma::mat> dtnn(dataset,
+      metric);
+
+  arma::mat centroids = means + 2.0;
+  for (size_t iteration = 0; iteration < 20; ++iteration)
+  {
+    arma::mat naiveCentroids, dtnnCentroids;
+    arma::Col<size_t> naiveCounts, dtnnCounts;
+    naive.Iterate(centroids, naiveCentroids, naiveCounts);
+    dtnn.Iterate(centroids, dtnnCentroids, dtnnCounts);
+
+    for (size_t i = 0; i < naiveCounts.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(naiveCounts[i], dtnnCounts[i]);
+
+    for (size_t i = 0; i < naiveCentroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(naiveCentroids[i], dtnnCentroids[i], 1e-5);
+
+    centroids = naiveCentroids;
+  }
+}
+
 /**
  * Make sure that the sample initialization strategy successfully samples points
  * from the dataset.
@@ -7,10 +7,14 @@
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 #include <mlpack/methods/neighbor_search/unmap.hpp>
 #include <mlpack/methods/neighbor_search/ns_model.hpp>
+#include <mlpack/methods/neighbor_search/dynamic_neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/sharded_neighbor_search.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/example_tree.hpp>
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
+#include "serialization.hpp"
 
 using namespace mlpack;
 using namespace mlpack::neighbor;
@@ -161,6 +165,55 @@ BOOST_AUTO_TEST_CASE(SingleTreeUnmapTest)
   }
 }
 
+/**
+ * Check that UnmapInPlace() gives the same results as Unmap(), for random
+ * permutations with cycles of many lengths.
+ */
+BOOST_AUTO_TEST_CASE(UnmapInPlaceTest)
+{
+  const size_t numQueries = 1000;
+  const size_t numReferences = 300;
+  const size_t k = 5;
+
+  std::vector<size_t> refMap(numReferences), queryMap(numQueries);
+  const arma::uvec refPermutation = arma::shuffle(
+      arma::linspace<arma::uvec>(0, numReferences - 1, numReferences));
+  const arma::uvec queryPermutation = arma::shuffle(
+      arma::linspace<arma::uvec>(0, numQueries - 1, numQueries));
+  for (size_t i = 0; i < numReferences; ++i)
+    refMap[i] = refPermutation[i];
+  for (size_t i = 0; i < numQueries; ++i)
+    queryMap[i] = queryPermutation[i];
+
+  arma::Mat<size_t> neighbors(k, numQueries);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    neighbors[i] = math::RandInt(numReferences);
+  const arma::mat distances = arma::randu<arma::mat>(k, numQueries);
+
+  // The dual-tree case.
+  arma::Mat<size_t> neighborsOut;
+  arma::mat distancesOut;
+  Unmap(neighbors, distances, refMap, queryMap, neighborsOut, distancesOut,
+      true);
+
+  arma::Mat<size_t> neighborsInPlace(neighbors);
+  arma::mat distancesInPlace(distances);
+  UnmapInPlace(neighborsInPlace, distancesInPlace, refMap, queryMap, true);
+
+  BOOST_REQUIRE_EQUAL(arma::accu(neighborsInPlace != neighborsOut), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(distancesInPlace != distancesOut), 0);
+
+  // The single-tree case.
+  Unmap(neighbors, distances, refMap, neighborsOut, distancesOut);
+
+  neighborsInPlace = neighbors;
+  distancesInPlace = distances;
+  UnmapInPlace(neighborsInPlace, distancesInPlace, refMap);
+
+  BOOST_REQUIRE_EQUAL(arma::accu(neighborsInPlace != neighborsOut), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(distancesInPlace != distancesOut), 0);
+}
+
 /**
  * Test that an empty KNN object will throw exceptions when Search() is
  * called.
@@ -888,6 +941,928 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest)
   }
 }
 
+/**
+ * Test the vantage-point tree single-tree and dual-tree nearest neighbors
+ * methods against the naive method, with both the Euclidean distance and the
+ * Manhattan distance.
+ */
+template<typename MetricType>
+void CheckVPTreeKNN()
+{
+  arma::mat referenceData = arma::randu<arma::mat>(20, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(20, 200);
+
+  NeighborSearch<NearestNeighborSort, MetricType, arma::mat, VPTree>
+      naive(referenceData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(queryData, 5, naiveNeighbors, naiveDistances);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    NeighborSearch<NearestNeighborSort, MetricType, arma::mat, VPTree>
+        vpSearch(referenceData, false, (mode == 0));
+    arma::Mat<size_t> vpNeighbors;
+    arma::mat vpDistances;
+    vpSearch.Search(queryData, 5, vpNeighbors, vpDistances);
+
+    for (size_t i = 0; i < vpNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(vpNeighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(vpDistances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(VPTreeTest)
+{
+  CheckVPTreeKNN<EuclideanDistance>();
+  CheckVPTreeKNN<ManhattanDistance>();
+}
+
+/**
+ * Test the single-tree and dual-tree nearest neighbors methods with random
+ * projection trees against the naive method, on data of low intrinsic
+ * dimension embedded in a high-dimensional space.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckRPTreeKNN()
+{
+  // The points lie near a random 3-dimensional subspace of a 30-dimensional
+  // space.
+  const arma::mat basis = arma::randn<arma::mat>(30, 3);
+  arma::mat referenceData = basis * arma::randu<arma::mat>(3, 1000) +
+      0.01 * arma::randu<arma::mat>(30, 1000);
+  arma::mat queryData = basis * arma::randu<arma::mat>(3, 200) +
+      0.01 * arma::randu<arma::mat>(30, 200);
+
+  KNN naive(referenceData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(queryData, 5, naiveNeighbors, naiveDistances);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, TreeType>
+        rpSearch(referenceData, false, (mode == 0));
+    arma::Mat<size_t> rpNeighbors;
+    arma::mat rpDistances;
+    rpSearch.Search(queryData, 5, rpNeighbors, rpDistances);
+
+    for (size_t i = 0; i < rpNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(rpNeighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(rpDistances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RPTreeTest)
+{
+  CheckRPTreeKNN<RPTree>();
+  CheckRPTreeKNN<MaxRPTree>();
+}
+
+/**
+ * Test the parallel dual-tree traverser against the naive method, both with a
+ * separate query set and in the monochromatic setting.  A small task size is
+ * used so that the query tree is actually split into many tasks.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeVsNaive)
+{
+  arma::mat dataset;
+  if (!data::Load("test_data_3_1000.csv", dataset))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  typedef KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, KDTree,
+      TreeType::ParallelDualTreeTraverser> parallelKnn(dataset);
+
+  KNN naive(dataset, true);
+
+  arma::Mat<size_t> neighborsTree, neighborsNaive;
+  arma::mat distancesTree, distancesNaive;
+
+  parallelKnn.Search(dataset, 15, neighborsTree, distancesTree);
+  naive.Search(dataset, 15, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+
+  parallelKnn.Search(15, neighborsTree, distancesTree);
+  naive.Search(15, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+
+  // Now use the traverser directly with a very small task size.
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 5);
+  arma::Mat<size_t> neighbors(3, dataset.n_cols);
+  arma::mat distances(3, dataset.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.fill(DBL_MAX);
+
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance, TreeType>
+      RuleType;
+  EuclideanDistance metric;
+  RuleType rules(tree.Dataset(), tree.Dataset(), neighbors, distances, metric,
+      0.0, true);
+  TreeType::ParallelDualTreeTraverser<RuleType> traverser(rules, 10);
+  traverser.Traverse(tree, tree);
+
+  // The rules keep the candidates as heaps, so they must be sorted.
+  CandidateHeap<NearestNeighborSort>::Sort(distances, neighbors);
+
+  naive.Search(3, neighborsNaive, distancesNaive);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(oldFromNew[neighbors(j, i)],
+          neighborsNaive(j, oldFromNew[i]));
+      BOOST_REQUIRE_CLOSE(distances(j, i), distancesNaive(j, oldFromNew[i]),
+          1e-5);
+    }
+  }
+
+  BOOST_REQUIRE_GT(rules.BaseCases(), 0);
+  BOOST_REQUIRE_GT(traverser.NumVisited(), 0);
+}
+
+/**
+ * Test the parallel breadth-first dual-tree traverser against the naive method,
+ * both through NeighborSearch and directly, with trees of small leaves (many
+ * levels) and of large leaves (shallow trees).
+ */
+BOOST_AUTO_TEST_CASE(ParallelBreadthFirstDualTreeVsNaive)
+{
+  arma::mat dataset;
+  if (!data::Load("test_data_3_1000.csv", dataset))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  typedef KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, KDTree,
+      TreeType::ParallelBreadthFirstDualTreeTraverser> parallelKnn(dataset);
+
+  KNN naive(dataset, true);
+
+  arma::Mat<size_t> neighborsTree, neighborsNaive;
+  arma::mat distancesTree, distancesNaive;
+
+  parallelKnn.Search(dataset, 15, neighborsTree, distancesTree);
+  naive.Search(dataset, 15, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+
+  parallelKnn.Search(15, neighborsTree, distancesTree);
+  naive.Search(15, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+
+  // Now use the traverser directly.
+  naive.Search(3, neighborsNaive, distancesNaive);
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance, TreeType>
+      RuleType;
+  EuclideanDistance metric;
+  const size_t leafSizes[] = { 1, 100 };
+  for (size_t l = 0; l < 2; ++l)
+  {
+    std::vector<size_t> oldFromNew;
+    TreeType tree(dataset, oldFromNew, leafSizes[l]);
+    arma::Mat<size_t> neighbors(3, dataset.n_cols);
+    arma::mat distances(3, dataset.n_cols);
+    neighbors.fill(size_t() - 1);
+    distances.fill(DBL_MAX);
+
+    RuleType rules(tree.Dataset(), tree.Dataset(), neighbors, distances,
+        metric, 0.0, true);
+    TreeType::ParallelBreadthFirstDualTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(tree, tree);
+
+    // The rules keep the candidates as heaps, so they must be sorted.
+    CandidateHeap<NearestNeighborSort>::Sort(distances, neighbors);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+    {
+      for (size_t j = 0; j < 3; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(oldFromNew[neighbors(j, i)],
+            neighborsNaive(j, oldFromNew[i]));
+        BOOST_REQUIRE_CLOSE(distances(j, i), distancesNaive(j, oldFromNew[i]),
+            1e-5);
+      }
+    }
+
+    BOOST_REQUIRE_GT(rules.BaseCases(), 0);
+    BOOST_REQUIRE_GT(traverser.NumLevels(), 1);
+    BOOST_REQUIRE_GE(traverser.NumBaseCases(), rules.BaseCases());
+  }
+}
+
+/**
+ * Make sure that a query tree can be reused for searches with different values
+ * of k and different reference sets, and that the results are in the original
+ * order of the query points.
+ */
+BOOST_AUTO_TEST_CASE(QueryTreeReuseTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  std::vector<size_t> oldFromNew;
+  KNN::Tree queryTree(queryData, oldFromNew);
+
+  KNN knn(referenceData);
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    // Search with a new reference set in the second trial.
+    if (trial == 1)
+    {
+      referenceData = arma::randu<arma::mat>(3, 400);
+      knn.Train(referenceData);
+    }
+
+    KNN naive(referenceData, true);
+    const size_t ks[] = { 5, 1, 10, 5 };
+    for (size_t i = 0; i < 4; ++i)
+    {
+      arma::Mat<size_t> neighbors, naiveNeighbors;
+      arma::mat distances, naiveDistances;
+      knn.Search(&queryTree, oldFromNew, ks[i], neighbors, distances);
+      naive.Search(queryData, ks[i], naiveNeighbors, naiveDistances);
+
+      BOOST_REQUIRE_EQUAL(neighbors.n_rows, ks[i]);
+      BOOST_REQUIRE_EQUAL(neighbors.n_cols, queryData.n_cols);
+      for (size_t j = 0; j < neighbors.n_elem; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[j], naiveNeighbors[j]);
+        BOOST_REQUIRE_CLOSE(distances[j], naiveDistances[j], 1e-5);
+      }
+    }
+  }
+
+  // A mapping of the wrong size is an error.
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  std::vector<size_t> wrongMapping(10);
+  BOOST_REQUIRE_THROW(knn.Search(&queryTree, wrongMapping, 5, neighbors,
+      distances), std::invalid_argument);
+}
+
+/**
+ * Make sure that dual-tree and single-tree search give the right results on a
+ * compacted tree.
+ */
+BOOST_AUTO_TEST_CASE(CompactTreeVsNaive)
+{
+  arma::mat dataset;
+  if (!data::Load("test_data_3_1000.csv", dataset))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  std::vector<size_t> oldFromNew;
+  KNN::Tree tree(dataset, oldFromNew, 5);
+  tree.Compact();
+  BOOST_REQUIRE_EQUAL(tree.IsCompact(), true);
+
+  KNN naive(dataset, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(10, neighborsNaive, distancesNaive);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    // The tree statistics must be reset between searches.
+    std::queue<KNN::Tree*> queue;
+    queue.push(&tree);
+    while (!queue.empty())
+    {
+      KNN::Tree* node = queue.front();
+      queue.pop();
+      node->Stat().Reset();
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+        queue.push(&node->Child(i));
+    }
+
+    KNN knn(&tree, (mode == 1));
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(10, neighbors, distances);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+    {
+      for (size_t j = 0; j < 10; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(oldFromNew[neighbors(j, i)],
+            neighborsNaive(j, oldFromNew[i]));
+        BOOST_REQUIRE_CLOSE(distances(j, i), distancesNaive(j, oldFromNew[i]),
+            1e-5);
+      }
+    }
+  }
+}
+
+//! Compare the results of a DynamicKNN object with naive search on the points
+//! it currently contains.
+void CheckDynamicKNN(DynamicKNN& dynamicKnn,
+                     const arma::mat& points,
+                     const arma::mat& querySet,
+                     const size_t k)
+{
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < points.n_cols; ++i)
+    if (dynamicKnn.Contains(i))
+      indices.push_back(i);
+  BOOST_REQUIRE_EQUAL(dynamicKnn.NumPoints(), indices.size());
+
+  arma::mat currentPoints(points.n_rows, indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+    currentPoints.col(i) = points.col(indices[i]);
+
+  KNN naive(currentPoints, true);
+  arma::Mat<size_t> neighbors, naiveNeighbors;
+  arma::mat distances, naiveDistances;
+  dynamicKnn.Search(querySet, k, neighbors, distances);
+  naive.Search(querySet, k, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], indices[naiveNeighbors[i]]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that DynamicKNN gives the same results as naive search while
+ * points are inserted and removed.
+ */
+BOOST_AUTO_TEST_CASE(DynamicKNNTest)
+{
+  arma::mat points(3, 1500);
+  points.randu();
+  arma::mat querySet(3, 50);
+  querySet.randu();
+
+  DynamicKNN dynamicKnn(points.cols(0, 499), 32);
+  CheckDynamicKNN(dynamicKnn, points.cols(0, 499), querySet, 5);
+
+  // Insert the rest of the points, checking periodically.
+  for (size_t i = 500; i < points.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(dynamicKnn.Insert(points.col(i)), i);
+    if (i % 250 == 0)
+      CheckDynamicKNN(dynamicKnn, points.cols(0, i), querySet, 5);
+  }
+
+  BOOST_REQUIRE_GT(dynamicKnn.NumTrees(), 1);
+  CheckDynamicKNN(dynamicKnn, points, querySet, 10);
+
+  // Now remove most of the points; this also removes points from the buffer
+  // and forces trees to be rebuilt.
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    if (i % 3 != 0)
+      dynamicKnn.Remove(i);
+    if (i % 300 == 0)
+      CheckDynamicKNN(dynamicKnn, points, querySet, 10);
+  }
+
+  CheckDynamicKNN(dynamicKnn, points, querySet, 10);
+  BOOST_REQUIRE_EQUAL(dynamicKnn.NumPoints(), 500);
+
+  // Removing a point twice is not allowed, and neither is asking for too many
+  // neighbors.
+  BOOST_REQUIRE_THROW(dynamicKnn.Remove(1), std::invalid_argument);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  BOOST_REQUIRE_THROW(dynamicKnn.Search(querySet, 501, neighbors, distances),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that ShardedKNN gives the same results as a single KNN object, and
+ * that shards saved and searched separately can be merged.
+ */
+BOOST_AUTO_TEST_CASE(ShardedKNNTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat querySet = arma::randu<arma::mat>(3, 100);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(querySet, 10, trueNeighbors, trueDistances);
+
+  const size_t numShards[] = { 1, 3, 7, 200 };
+  for (size_t s = 0; s < 4; ++s)
+  {
+    ShardedKNN shardedKnn(referenceData, numShards[s], false, (s % 2 == 1));
+    BOOST_REQUIRE_EQUAL(shardedKnn.NumShards(), numShards[s]);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    shardedKnn.Search(querySet, 10, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], trueNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], trueDistances[i], 1e-5);
+    }
+  }
+
+  // Now save each shard, load it again, search it, and merge the results.
+  ShardedKNN shardedKnn(referenceData, 4);
+  std::vector<arma::Mat<size_t> > shardNeighbors(4);
+  std::vector<arma::mat> shardDistances(4);
+  std::vector<size_t> offsets(4);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    BOOST_REQUIRE(data::Save("shard.xml", "shard", shardedKnn.Shard(i)));
+
+    KNN shard;
+    BOOST_REQUIRE(data::Load("shard.xml", "shard", shard));
+    shard.Search(querySet, 10, shardNeighbors[i], shardDistances[i]);
+    offsets[i] = shardedKnn.ShardOffset(i);
+  }
+  remove("shard.xml");
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  ShardedKNN::Merge(shardNeighbors, shardDistances, offsets, 10, neighbors,
+      distances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], trueNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], trueDistances[i], 1e-5);
+  }
+
+  // Asking for more neighbors than the shards give is not allowed.
+  BOOST_REQUIRE_THROW(ShardedKNN::Merge(shardNeighbors, shardDistances,
+      offsets, 41, neighbors, distances), std::invalid_argument);
+  BOOST_REQUIRE_THROW(ShardedKNN(referenceData, 0), std::invalid_argument);
+}
+
+/**
+ * Make sure that single-tree and naive search give exactly the same results and
+ * counters when the query points are split between several threads as with
+ * one thread, for both bichromatic and monochromatic search.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeAndNaiveTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 2000);
+  arma::mat querySet = arma::randu<arma::mat>(4, 500);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    const bool naive = (mode == 1);
+    KNN knn(referenceData, naive, true);
+
+    #ifdef _OPENMP
+      const int numThreads = omp_get_max_threads();
+      omp_set_num_threads(1);
+    #endif
+
+    arma::Mat<size_t> serialNeighbors, serialMonoNeighbors;
+    arma::mat serialDistances, serialMonoDistances;
+    knn.Search(querySet, 5, serialNeighbors, serialDistances);
+    const size_t serialBaseCases = knn.BaseCases();
+    const size_t serialScores = knn.Scores();
+    knn.Search(5, serialMonoNeighbors, serialMonoDistances);
+
+    #ifdef _OPENMP
+      omp_set_num_threads(numThreads);
+    #endif
+
+    arma::Mat<size_t> neighbors, monoNeighbors;
+    arma::mat distances, monoDistances;
+    knn.Search(querySet, 5, neighbors, distances);
+    BOOST_REQUIRE_EQUAL(knn.BaseCases(), serialBaseCases);
+    BOOST_REQUIRE_EQUAL(knn.Scores(), serialScores);
+    knn.Search(5, monoNeighbors, monoDistances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], serialNeighbors[i]);
+      BOOST_REQUIRE_EQUAL(distances[i], serialDistances[i]);
+    }
+
+    for (size_t i = 0; i < monoNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(monoNeighbors[i], serialMonoNeighbors[i]);
+      BOOST_REQUIRE_EQUAL(monoDistances[i], serialMonoDistances[i]);
+    }
+  }
+}
+
+//! Check that SearchOne() gives the same results as naive search for each of
+//! the given query points.
+template<typename SearchType>
+void CheckSearchOne(const SearchType& search,
+                    const arma::mat& referenceData,
+                    const arma::mat& querySet,
+                    const size_t k)
+{
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  SearchType naiveSearch(referenceData, true);
+  naiveSearch.Search(querySet, k, neighbors, distances);
+
+  arma::Col<size_t> oneNeighbors;
+  arma::vec oneDistances;
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    const arma::vec query = querySet.col(i);
+    search.SearchOne(query, k, oneNeighbors, oneDistances);
+
+    BOOST_REQUIRE_EQUAL(oneNeighbors.n_elem, k);
+    BOOST_REQUIRE_EQUAL(oneDistances.n_elem, k);
+    for (size_t j = 0; j < k; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(oneDistances[j], distances(j, i), 1e-5);
+      BOOST_REQUIRE_EQUAL(oneNeighbors[j], neighbors(j, i));
+    }
+  }
+}
+
+/**
+ * Make sure that SearchOne() gives the same results as naive search for several
+ * tree types, for naive search, and for furthest neighbor search.
+ */
+BOOST_AUTO_TEST_CASE(SearchOneTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 2000);
+  arma::mat querySet = arma::randu<arma::mat>(4, 100);
+
+  KNN kdTree(referenceData);
+  CheckSearchOne(kdTree, referenceData, querySet, 10);
+
+  KNN naive(referenceData, true);
+  CheckSearchOne(naive, referenceData, querySet, 10);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      StandardCoverTree> coverTree(referenceData);
+  CheckSearchOne(coverTree, referenceData, querySet, 10);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, RTree>
+      rTree(referenceData);
+  CheckSearchOne(rTree, referenceData, querySet, 10);
+
+  NeighborSearch<FurthestNeighborSort, EuclideanDistance, arma::mat, BallTree>
+      ballTree(referenceData);
+  CheckSearchOne(ballTree, referenceData, querySet, 10);
+
+  // A query point with the wrong dimensionality, or too large a k, is invalid.
+  arma::Col<size_t> neighbors;
+  arma::vec distances;
+  BOOST_REQUIRE_THROW(kdTree.SearchOne(arma::vec(3, arma::fill::randu), 5,
+      neighbors, distances), std::invalid_argument);
+  BOOST_REQUIRE_THROW(kdTree.SearchOne(querySet.col(0), 2001, neighbors,
+      distances), std::invalid_argument);
+}
+
+/**
+ * Make sure that SearchOne() doesn't reallocate the result vectors when they
+ * already have the right size, and that it can be called from several threads
+ * at once on the same object.
+ */
+BOOST_AUTO_TEST_CASE(SearchOneConcurrentTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 3000);
+  arma::mat querySet = arma::randu<arma::mat>(3, 400);
+
+  const KNN knn(referenceData, false, true);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  KNN batchKnn(referenceData, false, true);
+  batchKnn.Search(querySet, 5, neighbors, distances);
+
+  arma::Col<size_t> oneNeighbors(5);
+  arma::vec oneDistances(5);
+  const size_t* neighborsMemory = oneNeighbors.memptr();
+  const double* distancesMemory = oneDistances.memptr();
+  knn.SearchOne(querySet.col(0), 5, oneNeighbors, oneDistances);
+  BOOST_REQUIRE_EQUAL(oneNeighbors.memptr(), neighborsMemory);
+  BOOST_REQUIRE_EQUAL(oneDistances.memptr(), distancesMemory);
+
+  arma::Mat<size_t> parallelNeighbors(5, querySet.n_cols);
+  arma::mat parallelDistances(5, querySet.n_cols);
+  #pragma omp parallel
+  {
+    arma::Col<size_t> threadNeighbors(5);
+    arma::vec threadDistances(5);
+
+    #pragma omp for
+    for (omp_size_t i = 0; i < (omp_size_t) querySet.n_cols; ++i)
+    {
+      knn.SearchOne(querySet.col(i), 5, threadNeighbors, threadDistances);
+      parallelNeighbors.col(i) = threadNeighbors;
+      parallelDistances.col(i) = threadDistances;
+    }
+  }
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(parallelDistances[i], distances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that CandidateHeap keeps the k best candidates, breaks ties by
+ * index, and sorts them correctly.
+ */
+BOOST_AUTO_TEST_CASE(CandidateHeapTest)
+{
+  const size_t k = 20;
+  arma::vec distances(k);
+  arma::Col<size_t> neighbors(k);
+  distances.fill(DBL_MAX);
+  neighbors.fill(size_t() - 1);
+
+  // Insert 100 candidates in a scrambled order, with many equal distances.
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const size_t index = (37 * i) % 100;
+    CandidateHeap<NearestNeighborSort>::Insert(distances.memptr(),
+        neighbors.memptr(), k, (double) (index / 4), index);
+  }
+
+  CandidateHeap<NearestNeighborSort>::Sort(distances.memptr(),
+      neighbors.memptr(), k);
+  for (size_t i = 0; i < k; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], i);
+    BOOST_REQUIRE_EQUAL(distances[i], (double) (i / 4));
+  }
+
+  // Now do the same for furthest neighbors, where the largest distances are
+  // best.
+  distances.fill(0.0);
+  neighbors.fill(size_t() - 1);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const size_t index = (37 * i) % 100;
+    CandidateHeap<FurthestNeighborSort>::Insert(distances.memptr(),
+        neighbors.memptr(), k, (double) (index / 4), index);
+  }
+
+  // A candidate that is no better than the worst one is not inserted.
+  BOOST_REQUIRE(!CandidateHeap<FurthestNeighborSort>::Insert(
+      distances.memptr(), neighbors.memptr(), k, 0.0, 1000));
+  BOOST_REQUIRE(CandidateHeap<FurthestNeighborSort>::Insert(
+      distances.memptr(), neighbors.memptr(), k, 30.0, 1000));
+
+  CandidateHeap<FurthestNeighborSort>::Sort(distances.memptr(),
+      neighbors.memptr(), k);
+  BOOST_REQUIRE_EQUAL(neighbors[0], 1000);
+  BOOST_REQUIRE_EQUAL(distances[0], 30.0);
+  for (size_t i = 1; i < k; ++i)
+  {
+    const size_t j = i - 1;
+    BOOST_REQUIRE_EQUAL(neighbors[i], 96 - 4 * (j / 4) + (j % 4));
+    BOOST_REQUIRE_EQUAL(distances[i], (double) (24 - j / 4));
+  }
+}
+
+/**
+ * Make sure that tree-based search is still correct for large k, where the
+ * candidate lists are long.
+ */
+BOOST_AUTO_TEST_CASE(LargeKTest)
+{
+  arma::mat dataset;
+  if (!data::Load("test_data_3_1000.csv", dataset))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  KNN naive(dataset, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(500, neighborsNaive, distancesNaive);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    KNN knn(dataset, false, (mode == 1));
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(500, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+    }
+  }
+
+  // Check furthest neighbor search too, with a query set.
+  arma::mat querySet = dataset.cols(0, 99);
+  KFN kfnNaive(dataset, true);
+  KFN kfn(dataset);
+  kfnNaive.Search(querySet, 500, neighborsNaive, distancesNaive);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  kfn.Search(querySet, 500, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that BlockedBruteForce gives the same results as tree-based search,
+ * for block sizes that don't divide the number of points.
+ */
+BOOST_AUTO_TEST_CASE(BlockedBruteForceTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(20, 1000);
+  arma::mat querySet = arma::randu<arma::mat>(20, 300);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    arma::Mat<size_t> neighbors, neighborsTree;
+    arma::mat distances, distancesTree;
+
+    const bool sameSet = (mode == 2);
+    const arma::mat& queries = sameSet ? referenceData : querySet;
+    neighbors.set_size(10, queries.n_cols);
+    neighbors.fill(size_t() - 1);
+    distances.set_size(10, queries.n_cols);
+
+    if (mode == 1)
+    {
+      distances.fill(FurthestNeighborSort::WorstDistance());
+      BOOST_REQUIRE(BlockedBruteForce<FurthestNeighborSort>::Search<
+          EuclideanDistance>(queries, referenceData, neighbors, distances,
+          sameSet, 17, 33));
+      CandidateHeap<FurthestNeighborSort>::Sort(distances, neighbors);
+
+      KFN kfn(referenceData);
+      kfn.Search(queries, 10, neighborsTree, distancesTree);
+    }
+    else
+    {
+      distances.fill(NearestNeighborSort::WorstDistance());
+      BOOST_REQUIRE(BlockedBruteForce<NearestNeighborSort>::Search<
+          EuclideanDistance>(queries, referenceData, neighbors, distances,
+          sameSet, 17, 33));
+      CandidateHeap<NearestNeighborSort>::Sort(distances, neighbors);
+
+      KNN knn(referenceData);
+      if (sameSet)
+        knn.Search(10, neighborsTree, distancesTree);
+      else
+        knn.Search(queries, 10, neighborsTree, distancesTree);
+    }
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], neighborsTree[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], distancesTree[i], 1e-5);
+    }
+  }
+
+  // Other metrics are not supported.
+  arma::Mat<size_t> neighbors(10, querySet.n_cols);
+  arma::mat distances(10, querySet.n_cols);
+  BOOST_REQUIRE(!BlockedBruteForce<NearestNeighborSort>::Search<
+      ManhattanDistance>(querySet, referenceData, neighbors, distances));
+}
+
+/**
+ * Make sure that BlockedBruteForce (and so naive search) is exact for data far
+ * from the origin, where ||q||^2 + ||r||^2 - 2 q^T r suffers from cancellation,
+ * by comparing it with the metric evaluated for each pair of points.
+ */
+BOOST_AUTO_TEST_CASE(BlockedBruteForceOffsetTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 500) + 1e6;
+  arma::mat querySet = arma::randu<arma::mat>(5, 100) + 1e6;
+
+  // Sort the distances of each query point to every reference point.
+  arma::Mat<size_t> trueNeighbors(10, querySet.n_cols);
+  arma::mat trueDistances(10, querySet.n_cols);
+  arma::vec pointDistances(referenceData.n_cols);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    for (size_t j = 0; j < referenceData.n_cols; ++j)
+    {
+      pointDistances[j] = EuclideanDistance::Evaluate(querySet.col(i),
+          referenceData.col(j));
+    }
+
+    const arma::uvec order = arma::stable_sort_index(pointDistances);
+    for (size_t n = 0; n < 10; ++n)
+    {
+      trueNeighbors(n, i) = order[n];
+      trueDistances(n, i) = pointDistances[order[n]];
+    }
+  }
+
+  arma::Mat<size_t> neighbors(10, querySet.n_cols);
+  neighbors.fill(size_t() - 1);
+  arma::mat distances(10, querySet.n_cols);
+  distances.fill(NearestNeighborSort::WorstDistance());
+  BOOST_REQUIRE(BlockedBruteForce<NearestNeighborSort>::Search<
+      EuclideanDistance>(querySet, referenceData, neighbors, distances, false,
+      17, 33));
+  CandidateHeap<NearestNeighborSort>::Sort(distances, neighbors);
+
+  // Naive search uses BlockedBruteForce too.
+  KNN knn(referenceData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  knn.Search(querySet, 10, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < trueNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], trueNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], trueDistances[i], 1e-5);
+    BOOST_REQUIRE_EQUAL(naiveNeighbors[i], trueNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(naiveDistances[i], trueDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that the dual-tree search gives the same results as the naive
+ * search when the leaves are large enough for their base cases to be computed
+ * with a matrix product.
+ */
+BOOST_AUTO_TEST_CASE(LargeLeafDualTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(10, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(10, 500);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    arma::Mat<size_t> neighbors, naiveNeighbors;
+    arma::mat distances, naiveDistances;
+
+    arma::mat referenceCopy(referenceData);
+    arma::mat queryCopy(queryData);
+    if (mode == 0)
+    {
+      // Bichromatic nearest neighbor search.
+      NSModel<NearestNeighborSort> model(
+          NSModel<NearestNeighborSort>::TreeTypes::KD_TREE, false);
+      model.BuildModel(std::move(referenceCopy), 64, false, false);
+      model.Search(std::move(queryCopy), 5, neighbors, distances);
+
+      KNN naive(referenceData, true);
+      naive.Search(queryData, 5, naiveNeighbors, naiveDistances);
+    }
+    else if (mode == 1)
+    {
+      // Monochromatic nearest neighbor search.
+      NSModel<NearestNeighborSort> model(
+          NSModel<NearestNeighborSort>::TreeTypes::KD_TREE, false);
+      model.BuildModel(std::move(referenceCopy), 64, false, false);
+      model.Search(5, neighbors, distances);
+
+      KNN naive(referenceData, true);
+      naive.Search(5, naiveNeighbors, naiveDistances);
+    }
+    else
+    {
+      // Bichromatic furthest neighbor search.
+      NSModel<FurthestNeighborSort> model(
+          NSModel<FurthestNeighborSort>::TreeTypes::KD_TREE, false);
+      model.BuildModel(std::move(referenceCopy), 64, false, false);
+      model.Search(std::move(queryCopy), 5, neighbors, distances);
+
+      KFN naive(referenceData, true);
+      naive.Search(queryData, 5, naiveNeighbors, naiveDistances);
+    }
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, naiveNeighbors.n_rows);
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, naiveNeighbors.n_cols);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
 /**
  * Make sure sparse nearest neighbors works with kd trees.
  */
@@ -977,7 +1952,7 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
   arma::mat referenceData = arma::randu<arma::mat>(10, 200);
 
   // Build all the possible models.
-  KNNModel models[12];
+  KNNModel models[18];
   models[0] = KNNModel(KNNModel::TreeTypes::KD_TREE, true);
   models[1] = KNNModel(KNNModel::TreeTypes::KD_TREE, false);
   models[2] = KNNModel(KNNModel::TreeTypes::COVER_TREE, true);
@@ -990,6 +1965,12 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
   models[9] = KNNModel(KNNModel::TreeTypes::X_TREE, false);
   models[10] = KNNModel(KNNModel::TreeTypes::BALL_TREE, true);
   models[11] = KNNModel(KNNModel::TreeTypes::BALL_TREE, false);
+  models[12] = KNNModel(KNNModel::TreeTypes::VP_TREE, true);
+  models[13] = KNNModel(KNNModel::TreeTypes::VP_TREE, false);
+  models[14] = KNNModel(KNNModel::TreeTypes::RP_TREE, true);
+  models[15] = KNNModel(KNNModel::TreeTypes::RP_TREE, false);
+  models[16] = KNNModel(KNNModel::TreeTypes::MAX_RP_TREE, true);
+  models[17] = KNNModel(KNNModel::TreeTypes::MAX_RP_TREE, false);
 
   for (size_t j = 0; j < 2; ++j)
   {
@@ -999,7 +1980,7 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
     arma::mat baselineDistances;
     knn.Search(queryData, 3, baselineNeighbors, baselineDistances);
 
-    for (size_t i = 0; i < 12; ++i)
+    for (size_t i = 0; i < 18; ++i)
     {
       // We only have std::move() constructors so make a copy of our data.
       arma::mat referenceCopy(referenceData);
@@ -1043,7 +2024,7 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
   arma::mat referenceData = arma::randu<arma::mat>(10, 200);
 
   // Build all the possible models.
-  KNNModel models[12];
+  KNNModel models[18];
   models[0] = KNNModel(KNNModel::TreeTypes::KD_TREE, true);
   models[1] = KNNModel(KNNModel::TreeTypes::KD_TREE, false);
   models[2] = KNNModel(KNNModel::TreeTypes::COVER_TREE, true);
@@ -1056,6 +2037,12 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
   models[9] = KNNModel(KNNModel::TreeTypes::X_TREE, false);
   models[10] = KNNModel(KNNModel::TreeTypes::BALL_TREE, true);
   models[11] = KNNModel(KNNModel::TreeTypes::BALL_TREE, false);
+  models[12] = KNNModel(KNNModel::TreeTypes::VP_TREE, true);
+  models[13] = KNNModel(KNNModel::TreeTypes::VP_TREE, false);
+  models[14] = KNNModel(KNNModel::TreeTypes::RP_TREE, true);
+  models[15] = KNNModel(KNNModel::TreeTypes::RP_TREE, false);
+  models[16] = KNNModel(KNNModel::TreeTypes::MAX_RP_TREE, true);
+  models[17] = KNNModel(KNNModel::TreeTypes::MAX_RP_TREE, false);
 
   for (size_t j = 0; j < 2; ++j)
   {
@@ -1065,7 +2052,7 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
     arma::mat baselineDistances;
     knn.Search(3, baselineNeighbors, baselineDistances);
 
-    for (size_t i = 0; i < 12; ++i)
+    for (size_t i = 0; i < 18; ++i)
     {
       // We only have a std::move() constructor... so copy the data.
       arma::mat referenceCopy(referenceData);
@@ -1099,6 +2086,146 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
   }
 }
 
+/**
+ * Make sure that an NSModel built on single-precision data gives the same
+ * results as double-precision search on the same points, for every tree type.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelFloatTest)
+{
+  typedef NSModel<NearestNeighborSort, arma::fmat> FloatKNNModel;
+
+  arma::fmat queryData = arma::randu<arma::fmat>(10, 50);
+  arma::fmat referenceData = arma::randu<arma::fmat>(10, 200);
+
+  // Get a baseline on the same points in double precision.
+  const arma::mat doubleQueryData = arma::conv_to<arma::mat>::from(queryData);
+  const arma::mat doubleReferenceData =
+      arma::conv_to<arma::mat>::from(referenceData);
+  KNN knn(doubleReferenceData);
+  arma::Mat<size_t> baselineNeighbors;
+  arma::mat baselineDistances;
+  knn.Search(doubleQueryData, 3, baselineNeighbors, baselineDistances);
+
+  const FloatKNNModel::TreeTypes treeTypes[] = { FloatKNNModel::KD_TREE,
+      FloatKNNModel::COVER_TREE, FloatKNNModel::R_TREE,
+      FloatKNNModel::R_STAR_TREE, FloatKNNModel::X_TREE,
+      FloatKNNModel::BALL_TREE, FloatKNNModel::VP_TREE };
+
+  for (size_t i = 0; i < 7; ++i)
+  {
+    for (size_t j = 0; j < 2; ++j)
+    {
+      FloatKNNModel model(treeTypes[i]);
+      arma::fmat referenceCopy(referenceData);
+      arma::fmat queryCopy(queryData);
+      model.BuildModel(std::move(referenceCopy), 20, false, (j == 1));
+
+      BOOST_REQUIRE_EQUAL(model.Dataset().n_rows, 10);
+      BOOST_REQUIRE_EQUAL(model.Dataset().n_cols, 200);
+
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+      model.Search(std::move(queryCopy), 3, neighbors, distances);
+
+      BOOST_REQUIRE_EQUAL(neighbors.n_rows, baselineNeighbors.n_rows);
+      BOOST_REQUIRE_EQUAL(neighbors.n_cols, baselineNeighbors.n_cols);
+      BOOST_REQUIRE_EQUAL(distances.n_rows, baselineDistances.n_rows);
+      BOOST_REQUIRE_EQUAL(distances.n_cols, baselineDistances.n_cols);
+      for (size_t k = 0; k < distances.n_elem; ++k)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[k], baselineNeighbors[k]);
+        BOOST_REQUIRE_CLOSE(distances[k], baselineDistances[k], 1e-3);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that an NSModel with the whitening transformation of a Mahalanobis
+ * distance finds the same neighbors, at the same distances, as naive search
+ * with the Mahalanobis distance itself.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelMahalanobisTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat queryData = arma::randu<arma::mat>(5, 50);
+  arma::mat referenceData = arma::randu<arma::mat>(5, 200);
+
+  arma::mat a = arma::randu<arma::mat>(5, 5);
+  MahalanobisDistance<> md(a.t() * a + 0.1 * arma::eye<arma::mat>(5, 5));
+
+  NeighborSearch<NearestNeighborSort, MahalanobisDistance<>, arma::mat,
+      StandardCoverTree> baseline(referenceData, true, false, 0, md);
+  arma::Mat<size_t> baselineNeighbors;
+  arma::mat baselineDistances;
+  baseline.Search(queryData, 3, baselineNeighbors, baselineDistances);
+
+  KNNModel::TreeTypes treeTypes[] = { KNNModel::KD_TREE, KNNModel::COVER_TREE,
+      KNNModel::BALL_TREE };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    KNNModel model(treeTypes[i]);
+    md.Whitening(model.Transformation());
+
+    arma::mat referenceCopy(referenceData);
+    arma::mat queryCopy(queryData);
+    model.BuildModel(std::move(referenceCopy), 20, false, false);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    model.Search(std::move(queryCopy), 3, neighbors, distances);
+
+    for (size_t k = 0; k < distances.n_elem; ++k)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[k], baselineNeighbors[k]);
+      BOOST_REQUIRE_CLOSE(distances[k], baselineDistances[k], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that NSModel::SelectTree() chooses a valid tree type and leaf size,
+ * that a model built with them gives the same results as naive search, and that
+ * the choice is saved with the model.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelSelectTreeTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat queryData = arma::randu<arma::mat>(4, 100);
+  arma::mat referenceData = arma::randu<arma::mat>(4, 1000);
+
+  KNN naive(referenceData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(queryData, 5, naiveNeighbors, naiveDistances);
+
+  KNNModel model;
+  model.SelectTree(referenceData, 5, false, 0, 300, 50);
+  BOOST_REQUIRE_GE(model.LeafSize(), 1);
+
+  arma::mat referenceCopy(referenceData);
+  model.BuildModel(std::move(referenceCopy), model.LeafSize(), false, false);
+
+  KNNModel xmlModel, textModel, binaryModel;
+  SerializeObjectAll(model, xmlModel, textModel, binaryModel);
+  BOOST_REQUIRE_EQUAL(xmlModel.TreeType(), model.TreeType());
+  BOOST_REQUIRE_EQUAL(xmlModel.LeafSize(), model.LeafSize());
+  BOOST_REQUIRE_EQUAL(textModel.LeafSize(), model.LeafSize());
+  BOOST_REQUIRE_EQUAL(binaryModel.LeafSize(), model.LeafSize());
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  model.Search(std::move(queryData), 5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
 /**
  * If we search twice with the same reference tree, the bounds need to be reset
  * before the second search.  This test ensures that that happens, by making
@@ -1148,4 +2275,128 @@ BOOST_AUTO_TEST_CASE(NeighborPtrDeleteTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+/**
+ * Make sure that a budgeted search without a limit gives the exact results,
+ * and that a search stopped by the budget reports it and gives neighbors that
+ * are no better than the exact ones.
+ */
+BOOST_AUTO_TEST_CASE(BudgetedSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryset = arma::randu<arma::mat>(3, 100);
+
+  KNN knn(dataset);
+  arma::mat distances;
+  arma::Mat<size_t> neighbors;
+  knn.Search(queryset, 5, neighbors, distances);
+
+  // With no limit, the search is exact.
+  arma::mat budgetedDistances;
+  arma::Mat<size_t> budgetedNeighbors;
+  BOOST_REQUIRE(knn.BudgetedSearch(queryset, 5, budgetedNeighbors,
+      budgetedDistances, 0));
+  for (size_t i = 0; i < distances.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(budgetedNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(budgetedDistances[i], distances[i], 1e-5);
+  }
+
+  // With a budget of one leaf, some query points are not searched completely.
+  BOOST_REQUIRE(!knn.BudgetedSearch(queryset, 5, budgetedNeighbors,
+      budgetedDistances, 1));
+  BOOST_REQUIRE_EQUAL(budgetedNeighbors.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(budgetedNeighbors.n_cols, 100);
+  for (size_t i = 0; i < distances.n_cols; ++i)
+  {
+    for (size_t j = 0; j < distances.n_rows; ++j)
+    {
+      BOOST_REQUIRE_GE(budgetedDistances(j, i), distances(j, i) - 1e-10);
+
+      // Every neighbor that was found has the right distance.
+      if (budgetedNeighbors(j, i) != size_t() - 1)
+      {
+        BOOST_REQUIRE_CLOSE(budgetedDistances(j, i), arma::norm(
+            queryset.col(i) - dataset.col(budgetedNeighbors(j, i))), 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that several models can share one reference set, which they keep
+ * alive, and that none of them copies it (the kd-tree reads it through its
+ * permutation).
+ */
+BOOST_AUTO_TEST_CASE(SharedReferenceSetTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 500);
+
+  KNN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      StandardCoverTree> CoverTreeKNN;
+
+  std::shared_ptr<const arma::mat> shared(new arma::mat(dataset));
+  const arma::mat* sharedSet = shared.get();
+  KNN sharedNaive(shared, true);
+  CoverTreeKNN sharedCoverTree(shared);
+  KNN sharedKDTree;
+  sharedKDTree.Train(shared);
+
+  BOOST_REQUIRE_EQUAL(&sharedNaive.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(&sharedCoverTree.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(&sharedKDTree.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(shared.use_count(), 4);
+
+  // The models keep the set alive after we let go of it.
+  shared.reset();
+
+  // A saved kd-tree model holds its own points, so it can be loaded alone.
+  KNN xmlKDTree, textKDTree, binaryKDTree;
+  SerializeObjectAll(sharedKDTree, xmlKDTree, textKDTree, binaryKDTree);
+
+  for (size_t m = 0; m < 5; ++m)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    if (m == 0)
+    {
+      sharedNaive.Search(5, neighbors, distances);
+    }
+    else if (m == 1)
+    {
+      sharedCoverTree.Search(5, neighbors, distances);
+    }
+    else if (m == 2)
+    {
+      sharedKDTree.Search(5, neighbors, distances);
+    }
+    else if (m == 3)
+    {
+      // Bichromatic single-tree search, with the points as queries.
+      sharedKDTree.SingleMode() = true;
+      arma::Mat<size_t> allNeighbors;
+      arma::mat allDistances;
+      sharedKDTree.Search(dataset, 6, allNeighbors, allDistances);
+
+      // Each point is its own nearest neighbor.
+      neighbors = allNeighbors.rows(1, 5);
+      distances = allDistances.rows(1, 5);
+    }
+    else
+    {
+      binaryKDTree.Search(5, neighbors, distances);
+    }
+
+    for (size_t i = 0; i < naiveNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
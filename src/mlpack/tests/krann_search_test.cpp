@@ -700,4 +700,75 @@ BOOST_AUTO_TEST_CASE(RAModelTest)
   }
 }
 
+// Require that two sets of results are exactly the same.
+void CheckSameResults(const arma::Mat<size_t>& neighbors1,
+                      const arma::mat& distances1,
+                      const arma::Mat<size_t>& neighbors2,
+                      const arma::mat& distances2)
+{
+  BOOST_REQUIRE_EQUAL(neighbors1.n_rows, neighbors2.n_rows);
+  BOOST_REQUIRE_EQUAL(neighbors1.n_cols, neighbors2.n_cols);
+  BOOST_REQUIRE_EQUAL(arma::accu(neighbors1 != neighbors2), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(distances1 != distances2), 0);
+}
+
+/**
+ * Make sure that, for a fixed random seed, rank-approximate search gives the
+ * same results every time in every mode, and that the results of naive and
+ * single-tree search don't depend on the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ReproducibleParallelSearchTest)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    const bool naive = (mode == 0);
+    const bool singleMode = (mode == 1);
+    RASearch<> ra(refData, naive, singleMode, 5.0);
+
+    arma::Mat<size_t> neighbors1, neighbors2;
+    arma::mat distances1, distances2;
+
+    math::RandomSeed(42);
+    ra.Search(queryData, 3, neighbors1, distances1);
+    math::RandomSeed(42);
+    ra.Search(queryData, 3, neighbors2, distances2);
+
+    CheckSameResults(neighbors1, distances1, neighbors2, distances2);
+
+    // Monochromatic search, too.  In dual-tree mode, the reference tree is
+    // also the query tree, and its statistics are modified by the search, so
+    // use fresh objects.
+    RASearch<> monoRA1(refData, naive, singleMode, 5.0);
+    RASearch<> monoRA2(refData, naive, singleMode, 5.0);
+    math::RandomSeed(42);
+    monoRA1.Search(3, neighbors1, distances1);
+    math::RandomSeed(42);
+    monoRA2.Search(3, neighbors2, distances2);
+
+    CheckSameResults(neighbors1, distances1, neighbors2, distances2);
+
+#ifdef _OPENMP
+    if (!naive && !singleMode)
+      continue;
+
+    const int oldThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    math::RandomSeed(42);
+    ra.Search(queryData, 3, neighbors1, distances1);
+    omp_set_num_threads(4);
+    math::RandomSeed(42);
+    ra.Search(queryData, 3, neighbors2, distances2);
+    omp_set_num_threads(oldThreads);
+
+    CheckSameResults(neighbors1, distances1, neighbors2, distances2);
+#endif
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -273,4 +273,80 @@ BOOST_AUTO_TEST_CASE(RetrainCholeskyTest)
   LARSVerifyCorrectness(betaOpt, errCorr, 0.1);
 }
 
+/**
+ * Make sure that LARS gives the same solution on sparse data as on dense data,
+ * with and without Cholesky decomposition, and that the sparse predictions
+ * are the same.
+ */
+BOOST_AUTO_TEST_CASE(LARSSparseTest)
+{
+  arma::sp_mat X;
+  X.sprandn(30, 200, 0.3);
+  const arma::mat denseX(X);
+  const arma::vec y = trans(denseX) * arma::randn<arma::vec>(30);
+
+  for (size_t useCholesky = 0; useCholesky < 2; ++useCholesky)
+  {
+    LARS lars((useCholesky == 1), 0.5, 0.1);
+    arma::vec beta;
+    lars.Train(denseX, y, beta);
+
+    LARS sparseLARS((useCholesky == 1), 0.5, 0.1);
+    arma::vec sparseBeta;
+    sparseLARS.Train(X, y, sparseBeta);
+
+    arma::vec errCorr = (denseX * trans(denseX) + 0.1 *
+        arma::eye(30, 30)) * sparseBeta - denseX * y;
+    LARSVerifyCorrectness(sparseBeta, errCorr, 0.5);
+
+    BOOST_REQUIRE_EQUAL(beta.n_elem, sparseBeta.n_elem);
+    for (size_t i = 0; i < beta.n_elem; ++i)
+      BOOST_REQUIRE_SMALL(beta[i] - sparseBeta[i], 1e-8);
+
+    arma::vec predictions, sparsePredictions;
+    lars.Predict(denseX, predictions);
+    sparseLARS.Predict(X, sparsePredictions);
+    BOOST_REQUIRE_EQUAL(predictions.n_elem, 200);
+    BOOST_REQUIRE_EQUAL(sparsePredictions.n_elem, 200);
+    for (size_t i = 0; i < predictions.n_elem; ++i)
+      BOOST_REQUIRE_SMALL(predictions[i] - sparsePredictions[i], 1e-8);
+  }
+}
+
+/**
+ * Make sure that with Cholesky decomposition, computing the entries of the
+ * Gram matrix on demand gives the same solution as passing the full Gram
+ * matrix, for enough dimensions that the Gram matrix is computed in several
+ * blocks without Cholesky decomposition.
+ */
+BOOST_AUTO_TEST_CASE(LARSGramOnDemandTest)
+{
+  arma::mat X;
+  arma::vec y;
+  GenerateProblem(X, y, 150, 100);
+
+  const arma::mat gram = X * trans(X);
+  const double lambda1 = 0.1 * max(abs(X * y));
+
+  LARS lars(true, gram, lambda1, 0.2);
+  arma::vec beta;
+  lars.Train(X, y, beta);
+
+  LARS onDemandLARS(true, lambda1, 0.2);
+  arma::vec onDemandBeta;
+  onDemandLARS.Train(X, y, onDemandBeta);
+
+  LARS gramLARS(false, lambda1, 0.2);
+  arma::vec gramBeta;
+  gramLARS.Train(X, y, gramBeta);
+
+  BOOST_REQUIRE_EQUAL(beta.n_elem, onDemandBeta.n_elem);
+  BOOST_REQUIRE_EQUAL(beta.n_elem, gramBeta.n_elem);
+  for (size_t i = 0; i < beta.n_elem; ++i)
+  {
+    BOOST_REQUIRE_SMALL(beta[i] - onDemandBeta[i], 1e-8);
+    BOOST_REQUIRE_SMALL(beta[i] - gramBeta[i], 1e-6);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
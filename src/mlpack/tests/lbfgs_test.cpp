@@ -8,12 +8,16 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
 #include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
+#include <mlpack/core/optimizers/parallel_function/parallel_function.hpp>
+#include <mlpack/core/optimizers/distributed_function/distributed_function.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression_function.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
 
 using namespace mlpack::optimization;
 using namespace mlpack::optimization::test;
+using namespace mlpack::regression;
 
 BOOST_AUTO_TEST_SUITE(LBFGSTest);
 
@@ -112,4 +116,161 @@ BOOST_AUTO_TEST_CASE(RosenbrockWoodFunctionTest)
   }
 }
 
+/**
+ * Make sure that ParallelFunction gives the full objective and gradient of a
+ * decomposable function, independently of the number of threads, and that
+ * L-BFGS finds the same optimum with it.
+ */
+BOOST_AUTO_TEST_CASE(ParallelFunctionTest)
+{
+  arma::mat data = arma::randu<arma::mat>(4, 1000);
+  arma::Row<size_t> responses(1000);
+  for (size_t i = 0; i < 1000; ++i)
+    responses[i] = (data(0, i) + data(1, i) > 1.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  ParallelFunction<LogisticRegressionFunction<>> f(lrf, 7);
+
+  const arma::mat coordinates = arma::randn<arma::mat>(5, 1);
+  BOOST_REQUIRE_CLOSE(f.Evaluate(coordinates), lrf.Evaluate(coordinates),
+      1e-8);
+
+  arma::mat gradient, fullGradient;
+  f.Gradient(coordinates, gradient);
+  lrf.Gradient(coordinates, fullGradient);
+  BOOST_REQUIRE_EQUAL(gradient.n_elem, fullGradient.n_elem);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(gradient[i], fullGradient[i], 1e-8);
+
+#ifdef _OPENMP
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  const double serialObjective = f.Evaluate(coordinates);
+  arma::mat serialGradient;
+  f.Gradient(coordinates, serialGradient);
+#ifdef _OPENMP
+  omp_set_num_threads(oldThreads);
+#endif
+
+  // The results should not depend on the number of threads.
+  BOOST_REQUIRE_EQUAL(serialObjective, f.Evaluate(coordinates));
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(serialGradient[i], gradient[i]);
+
+  L_BFGS<LogisticRegressionFunction<>> lbfgs(lrf);
+  L_BFGS<ParallelFunction<LogisticRegressionFunction<>>> parallelLbfgs(f);
+
+  arma::mat parameters = lrf.GetInitialPoint();
+  arma::mat parallelParameters = f.GetInitialPoint();
+  const double objective = lbfgs.Optimize(parameters);
+  const double parallelObjective = parallelLbfgs.Optimize(parallelParameters);
+
+  BOOST_REQUIRE_CLOSE(parallelObjective, objective, 1e-3);
+}
+
+#ifdef HAS_MPI
+
+/**
+ * Make sure that DistributedFunction gives the objective and gradient of the
+ * wrapped function when the test runs as a single rank, and that L-BFGS finds
+ * the same optimum with it.
+ */
+BOOST_AUTO_TEST_CASE(DistributedFunctionTest)
+{
+  int initialized = 0;
+  MPI_Initialized(&initialized);
+  if (!initialized)
+  {
+    MPI_Init(NULL, NULL);
+    std::atexit([]() { MPI_Finalize(); });
+  }
+
+  arma::mat data = arma::randu<arma::mat>(4, 1000);
+  arma::Row<size_t> responses(1000);
+  for (size_t i = 0; i < 1000; ++i)
+    responses[i] = (data(0, i) + data(1, i) > 1.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  DistributedFunction<LogisticRegressionFunction<>> f(lrf, MPI_COMM_SELF);
+  BOOST_REQUIRE_EQUAL(f.Ranks(), 1);
+  BOOST_REQUIRE_EQUAL(f.NumFunctions(), 1000);
+
+  const arma::mat coordinates = arma::randn<arma::mat>(5, 1);
+  BOOST_REQUIRE_EQUAL(f.Evaluate(coordinates), lrf.Evaluate(coordinates));
+  BOOST_REQUIRE_EQUAL(f.Evaluate(coordinates, 100, 50),
+      lrf.Evaluate(coordinates, 100, 50, true));
+
+  arma::mat gradient, fullGradient;
+  f.Gradient(coordinates, gradient);
+  lrf.Gradient(coordinates, fullGradient);
+  BOOST_REQUIRE_EQUAL(gradient.n_elem, fullGradient.n_elem);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(gradient[i], fullGradient[i]);
+
+  // A batch past the end of the shard gives only the points of the shard.
+  f.Gradient(coordinates, 990, gradient, 50);
+  lrf.Gradient(coordinates, 990, fullGradient, 10);
+  BOOST_REQUIRE_EQUAL(gradient.n_elem, fullGradient.n_elem);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(gradient[i], fullGradient[i]);
+
+  L_BFGS<LogisticRegressionFunction<>> lbfgs(lrf);
+  L_BFGS<DistributedFunction<LogisticRegressionFunction<>>> distributedLbfgs(
+      f);
+
+  arma::mat parameters = lrf.GetInitialPoint();
+  arma::mat distributedParameters = f.GetInitialPoint();
+  const double objective = lbfgs.Optimize(parameters);
+  const double distributedObjective =
+      distributedLbfgs.Optimize(distributedParameters);
+
+  BOOST_REQUIRE_CLOSE(distributedObjective, objective, 1e-5);
+}
+
+#endif
+
+/**
+ * Make sure the callback is given the progress of each L-BFGS iteration and can
+ * stop the optimization.
+ */
+BOOST_AUTO_TEST_CASE(LBFGSCallbackTest)
+{
+  RosenbrockFunction f;
+  L_BFGS<RosenbrockFunction> lbfgs(f);
+  lbfgs.MaxIterations() = 10000;
+
+  std::vector<OptimizerStatus> statuses;
+  lbfgs.Callback() = [&statuses](const OptimizerStatus& status)
+  {
+    statuses.push_back(status);
+    return (statuses.size() == 3);
+  };
+
+  arma::vec coords = f.GetInitialPoint();
+  const double initialObjective = f.Evaluate(coords);
+  const double result = lbfgs.Optimize(coords);
+
+  BOOST_REQUIRE_EQUAL(statuses.size(), 3);
+  BOOST_REQUIRE_CLOSE(statuses[0].objective, initialObjective, 1e-10);
+  BOOST_REQUIRE_EQUAL(statuses[0].stepSize, 0.0);
+  for (size_t i = 0; i < statuses.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(statuses[i].iteration, i);
+    BOOST_REQUIRE_GT(statuses[i].gradientNorm, 0.0);
+    if (i > 0)
+    {
+      // The line search only accepts steps which decrease the objective.
+      BOOST_REQUIRE_LT(statuses[i].objective, statuses[i - 1].objective);
+      BOOST_REQUIRE_GT(statuses[i].stepSize, 0.0);
+      BOOST_REQUIRE_GE(statuses[i].elapsed, statuses[i - 1].elapsed);
+    }
+  }
+
+  // The optimization stopped at the last reported iterate, far from the
+  // optimum.
+  BOOST_REQUIRE_CLOSE(result, statuses[2].objective, 1e-10);
+  BOOST_REQUIRE_GT(result, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
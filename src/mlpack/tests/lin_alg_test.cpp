@@ -73,6 +73,47 @@ BOOST_AUTO_TEST_CASE(TestCenterB)
       BOOST_REQUIRE_CLOSE(tmp_out(row, col), (double) (col - 2.5) * row, 1e-5);
 }
 
+/**
+ * Make sure the covariance computed in a single pass matches arma::cov(), also
+ * when the points are far from the origin, and that accumulators of parts of
+ * the points can be merged.
+ */
+BOOST_AUTO_TEST_CASE(TestCovariance)
+{
+  mat x = randn<mat>(4, 3000);
+  x.row(0) += 1e6;
+  x.row(1) *= 5.0;
+
+  const mat armaCov = cov(trans(x));
+  const vec armaMean = arma::mean(x, 1);
+
+  vec mean;
+  mat covariance;
+  Covariance(x, mean, covariance);
+
+  CovarianceAccumulator first, second;
+  first.Add(x.cols(0, 1999));
+  second.Add(x.cols(2000, 2999));
+  first.Merge(second);
+
+  BOOST_REQUIRE_EQUAL(first.Count(), 3000);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(mean[i], armaMean[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(first.Mean()[i], armaMean[i], 1e-8);
+    for (size_t j = 0; j < 4; ++j)
+    {
+      BOOST_REQUIRE_SMALL(covariance(i, j) - armaCov(i, j), 1e-6);
+      BOOST_REQUIRE_SMALL(first.Covariance()(i, j) - armaCov(i, j), 1e-6);
+    }
+  }
+
+  // Normalizing by n.
+  Covariance(x, mean, covariance, 1);
+  BOOST_REQUIRE_CLOSE(covariance(1, 1), armaCov(1, 1) * 2999.0 / 3000.0,
+      1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(TestWhitenUsingEig)
 {
   // After whitening using eigendecomposition, the covariance of
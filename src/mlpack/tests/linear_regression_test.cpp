@@ -194,4 +194,76 @@ BOOST_AUTO_TEST_CASE(LinearRegressionTrainTest)
     BOOST_REQUIRE_CLOSE(lr.Parameters()[i], lrTrain.Parameters()[i], 1e-5);
 }
 
+/**
+ * Test that a model trained from sufficient statistics accumulated over chunks
+ * of the dataset is the same as a model trained on the whole dataset, with and
+ * without an intercept, ridge regularization and weights.
+ */
+BOOST_AUTO_TEST_CASE(LinearRegressionStatisticsTest)
+{
+  // Use enough points that the chunks are split between threads.
+  arma::mat dataset = arma::randu<arma::mat>(4, 5000);
+  arma::vec responses = arma::randu<arma::vec>(5000);
+  arma::vec weights = arma::randu<arma::vec>(5000) + 0.5;
+
+  for (size_t trial = 0; trial < 8; ++trial)
+  {
+    const bool intercept = (trial % 2 == 0);
+    const double lambda = ((trial / 2) % 2 == 0) ? 0.0 : 0.5;
+    const arma::vec trialWeights = (trial / 4 == 0) ? arma::vec() : weights;
+
+    LinearRegression lr(dataset, responses, lambda, intercept, trialWeights);
+
+    LinearRegressionStatistics statistics(intercept);
+    for (size_t begin = 0; begin < dataset.n_cols; begin += 1300)
+    {
+      const size_t end = std::min((size_t) dataset.n_cols, begin + 1300) - 1;
+      statistics.Add(dataset.cols(begin, end), responses.subvec(begin, end),
+          (trialWeights.n_elem == 0) ? arma::vec() :
+          arma::vec(trialWeights.subvec(begin, end)));
+    }
+    BOOST_REQUIRE_EQUAL(statistics.NumPoints(), 5000);
+    BOOST_REQUIRE_EQUAL(statistics.Dimensionality(), 4);
+
+    LinearRegression lrStatistics;
+    lrStatistics.Lambda() = lambda;
+    lrStatistics.Train(statistics);
+
+    BOOST_REQUIRE_EQUAL(lrStatistics.Intercept(), intercept);
+    BOOST_REQUIRE_EQUAL(lr.Parameters().n_elem,
+        lrStatistics.Parameters().n_elem);
+    for (size_t i = 0; i < lr.Parameters().n_elem; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(lr.Parameters()[i], lrStatistics.Parameters()[i],
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Test that merging the statistics of two halves of a dataset gives the
+ * statistics of the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(LinearRegressionStatisticsMergeTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 800);
+  arma::vec responses = arma::randu<arma::vec>(800);
+
+  LinearRegressionStatistics statistics, first, second;
+  statistics.Add(dataset, responses);
+  first.Add(dataset.cols(0, 299), responses.subvec(0, 299));
+  second.Add(dataset.cols(300, 799), responses.subvec(300, 799));
+
+  LinearRegressionStatistics merged;
+  merged.Merge(first);
+  merged.Merge(second);
+
+  BOOST_REQUIRE_EQUAL(merged.NumPoints(), 800);
+  BOOST_REQUIRE_EQUAL(merged.Gram().n_rows, 4);
+  for (size_t i = 0; i < statistics.Gram().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(merged.Gram()[i], statistics.Gram()[i], 1e-8);
+  for (size_t i = 0; i < statistics.Moments().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(merged.Moments()[i], statistics.Moments()[i], 1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
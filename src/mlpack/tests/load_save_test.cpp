@@ -7,6 +7,9 @@
 #include <sstream>
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/batch_server.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
+#include <mlpack/core/data/prefetching_loader.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -1596,4 +1599,920 @@ BOOST_AUTO_TEST_CASE(BadDatasetInfoARFFTest)
   remove("test.arff");
 }
 
+/**
+ * Make sure that ChunkedLoader reads a file in chunks that together give the
+ * same matrix as data::Load(), and that ChunkedSaver writes chunks that load
+ * back as one matrix.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedLoadSaveTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 10);
+  BOOST_REQUIRE(data::Save("test_chunked.csv", dataset) == true);
+
+  for (size_t format = 0; format < 2; ++format)
+  {
+    arma::mat full;
+    if (format == 1)
+    {
+      // Rewrite the file as raw ASCII, with an empty line in the middle.
+      BOOST_REQUIRE(data::Load("test_chunked.csv", full) == true);
+      fstream f("test_chunked.txt", fstream::out);
+      for (size_t i = 0; i < full.n_cols; ++i)
+      {
+        f << full(0, i) << " " << full(1, i) << " " << full(2, i) << " "
+            << full(3, i) << endl;
+        if (i == 4)
+          f << endl;
+      }
+      f.close();
+    }
+
+    const string filename = (format == 0) ? "test_chunked.csv" :
+        "test_chunked.txt";
+    BOOST_REQUIRE(data::Load(filename, full) == true);
+
+    ChunkedLoader<double> loader(filename);
+    ChunkedSaver saver("test_chunked_out.csv");
+    arma::mat chunk;
+    size_t numChunks = 0;
+    while (loader.Next(chunk, 3))
+    {
+      BOOST_REQUIRE_EQUAL(chunk.n_rows, 4);
+      BOOST_REQUIRE_EQUAL(chunk.n_cols, (numChunks < 3) ? 3 : 1);
+      for (size_t i = 0; i < chunk.n_elem; ++i)
+        BOOST_REQUIRE_CLOSE(chunk[i], full[12 * numChunks + i], 1e-5);
+
+      saver.Write(chunk);
+      ++numChunks;
+    }
+
+    BOOST_REQUIRE_EQUAL(numChunks, 4);
+    BOOST_REQUIRE_EQUAL(loader.PointsRead(), 10);
+    BOOST_REQUIRE_EQUAL(saver.PointsWritten(), 10);
+    BOOST_REQUIRE(!loader.Next(chunk, 3));
+
+    arma::mat saved;
+    BOOST_REQUIRE(data::Load("test_chunked_out.csv", saved) == true);
+    BOOST_REQUIRE_EQUAL(saved.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(saved.n_cols, 10);
+    for (size_t i = 0; i < saved.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(saved[i], full[i], 1e-5);
+  }
+
+  // Other formats and inconsistent dimensionalities are not accepted, and
+  // binary files can't be written.
+  BOOST_REQUIRE_THROW(ChunkedLoader<double>("test_chunked.arff"),
+      std::runtime_error);
+  BOOST_REQUIRE_THROW(ChunkedSaver("test_chunked.bin"), std::runtime_error);
+
+  fstream f("test_chunked.csv", fstream::out);
+  f << "1, 2, 3" << endl << "4, 5, 6" << endl << "7, 8" << endl;
+  f.close();
+  ChunkedLoader<double> loader("test_chunked.csv");
+  arma::mat chunk;
+  BOOST_REQUIRE(loader.Next(chunk, 2));
+  BOOST_REQUIRE_THROW(loader.Next(chunk, 2), std::runtime_error);
+
+  remove("test_chunked.csv");
+  remove("test_chunked.txt");
+  remove("test_chunked_out.csv");
+}
+
+/**
+ * Make sure that ChunkedLoader reads Armadillo binary files of doubles and
+ * floats in chunks, and that Reset() starts again from the first point.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedLoadBinaryTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 10);
+  arma::fmat fdataset = arma::conv_to<arma::fmat>::from(dataset);
+  BOOST_REQUIRE(data::Save("test_chunked.bin", dataset) == true);
+  BOOST_REQUIRE(data::Save("test_chunked_float.bin", fdataset) == true);
+
+  for (size_t format = 0; format < 2; ++format)
+  {
+    ChunkedLoader<double> loader((format == 0) ? "test_chunked.bin" :
+        "test_chunked_float.bin");
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+      arma::mat chunk;
+      size_t numChunks = 0;
+      while (loader.Next(chunk, 3))
+      {
+        BOOST_REQUIRE_EQUAL(chunk.n_rows, 4);
+        BOOST_REQUIRE_EQUAL(chunk.n_cols, (numChunks < 3) ? 3 : 1);
+        for (size_t i = 0; i < chunk.n_elem; ++i)
+        {
+          if (format == 0)
+            BOOST_REQUIRE_EQUAL(chunk[i], dataset[12 * numChunks + i]);
+          else
+            BOOST_REQUIRE_EQUAL(chunk[i], fdataset[12 * numChunks + i]);
+        }
+
+        ++numChunks;
+      }
+
+      BOOST_REQUIRE_EQUAL(numChunks, 4);
+      BOOST_REQUIRE_EQUAL(loader.PointsRead(), 10);
+      loader.Reset();
+      BOOST_REQUIRE_EQUAL(loader.PointsRead(), 0);
+    }
+  }
+
+  remove("test_chunked.bin");
+  remove("test_chunked_float.bin");
+}
+
+/**
+ * Make sure a matrix saved in the native binary format loads back identically,
+ * both with data::Load() and with MappedMatrix, and that other element types
+ * are rejected.
+ */
+BOOST_AUTO_TEST_CASE(NativeBinaryLoadSaveTest)
+{
+  arma::mat dataset(7, 1000, arma::fill::randu);
+  BOOST_REQUIRE(data::Save("test_native.mlbin", dataset));
+
+  // Native binary files are never transposed.
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_native.mlbin", loaded));
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 1000);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], dataset[i]);
+
+  {
+    data::MappedMatrix<double> mapped;
+    BOOST_REQUIRE(data::Load("test_native.mlbin", mapped));
+    BOOST_REQUIRE(!mapped.HasInfo());
+    BOOST_REQUIRE_EQUAL(mapped.Info().Dimensionality(), 7);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 7);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 1000);
+    for (size_t i = 0; i < dataset.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], dataset[i]);
+
+    // Modifying the mapped matrix must not modify the file.
+    mapped.Matrix().zeros();
+  }
+
+  BOOST_REQUIRE(data::Load("test_native.mlbin", loaded));
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], dataset[i]);
+
+  // The element type must match.
+  arma::fmat floatLoaded;
+  BOOST_REQUIRE(!data::Load("test_native.mlbin", floatLoaded));
+  BOOST_REQUIRE_THROW(data::MappedMatrix<float>("test_native.mlbin"),
+      std::runtime_error);
+
+  // Other files can't be mapped.
+  fstream f;
+  f.open("test_native.csv", fstream::out);
+  f << "1, 2, 3" << endl;
+  f.close();
+  data::MappedMatrix<double> mapped;
+  BOOST_REQUIRE(!data::Load("test_native.csv", mapped));
+  BOOST_REQUIRE_EQUAL(mapped.Matrix().n_elem, 0);
+
+  remove("test_native.mlbin");
+  remove("test_native.csv");
+}
+
+/**
+ * Make sure the DatasetInfo saved with a native binary file is loaded back.
+ */
+BOOST_AUTO_TEST_CASE(NativeBinaryDatasetInfoTest)
+{
+  fstream f;
+  f.open("test.arff", fstream::out);
+  f << "@relation test" << endl;
+  f << "@attribute one STRING" << endl;
+  f << "@attribute two REAL" << endl;
+  f << "@data" << endl;
+  f << "hello, 1" << endl;
+  f << "cheese, 2.34" << endl;
+  f << "hello, -1.3" << endl;
+  f.close();
+
+  arma::mat dataset;
+  DatasetInfo info;
+  BOOST_REQUIRE(data::Load("test.arff", dataset, info));
+  BOOST_REQUIRE(data::Save("test_native.mlbin", dataset, info));
+
+  // Only native binary files can hold a DatasetInfo.
+  BOOST_REQUIRE(!data::Save("test_native.csv", dataset, info));
+
+  arma::mat loaded;
+  DatasetInfo loadedInfo;
+  BOOST_REQUIRE(data::Load("test_native.mlbin", loaded, loadedInfo));
+  BOOST_REQUIRE_EQUAL(loadedInfo.Dimensionality(), 2);
+  BOOST_REQUIRE(loadedInfo.Type(0) == Datatype::categorical);
+  BOOST_REQUIRE(loadedInfo.Type(1) == Datatype::numeric);
+  BOOST_REQUIRE_EQUAL(loadedInfo.NumMappings(0), 2);
+  BOOST_REQUIRE_EQUAL(loadedInfo.UnmapString(loaded(0, 1), 0), "cheese");
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], dataset[i]);
+
+  data::MappedMatrix<double> mapped("test_native.mlbin");
+  BOOST_REQUIRE(mapped.HasInfo());
+  DatasetInfo mappedInfo = mapped.Info();
+  BOOST_REQUIRE_EQUAL(mappedInfo.NumMappings(0), 2);
+  BOOST_REQUIRE_EQUAL(mappedInfo.UnmapString(mapped.Matrix()(0, 0), 0),
+      "hello");
+
+  remove("test.arff");
+  remove("test_native.mlbin");
+}
+
+/**
+ * Make sure that ChunkedSaver writes native binary files of results (of any
+ * element type) in chunks that load back as one matrix, and that the file is
+ * valid after each chunk.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedSaveNativeBinaryTest)
+{
+  arma::Mat<size_t> neighbors(5, 1000);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    neighbors[i] = i;
+  arma::mat distances(5, 1000, arma::fill::randu);
+
+  {
+    ChunkedSaver neighborsSaver("test_chunked_neighbors.mlbin");
+    ChunkedSaver distancesSaver("test_chunked_distances.mlbin");
+    for (size_t begin = 0; begin < 1000; begin += 300)
+    {
+      const size_t end = std::min((size_t) 1000, begin + 300);
+      neighborsSaver.Write(arma::Mat<size_t>(neighbors.cols(begin, end - 1)));
+      distancesSaver.Write(arma::mat(distances.cols(begin, end - 1)));
+
+      // The results written so far can already be loaded.
+      arma::mat partial;
+      BOOST_REQUIRE(data::Load("test_chunked_distances.mlbin", partial));
+      BOOST_REQUIRE_EQUAL(partial.n_rows, 5);
+      BOOST_REQUIRE_EQUAL(partial.n_cols, end);
+    }
+
+    BOOST_REQUIRE_EQUAL(neighborsSaver.PointsWritten(), 1000);
+
+    // Chunks of another dimensionality or type can't be appended.
+    BOOST_REQUIRE_THROW(distancesSaver.Write(arma::mat(4, 2)),
+        std::runtime_error);
+    BOOST_REQUIRE_THROW(distancesSaver.Write(arma::fmat(5, 2)),
+        std::runtime_error);
+  }
+
+  arma::Mat<size_t> loadedNeighbors;
+  BOOST_REQUIRE(data::Load("test_chunked_neighbors.mlbin", loadedNeighbors));
+  BOOST_REQUIRE_EQUAL(loadedNeighbors.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(loadedNeighbors.n_cols, 1000);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loadedNeighbors[i], neighbors[i]);
+
+  data::MappedMatrix<double> mapped("test_chunked_distances.mlbin");
+  BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 5);
+  BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 1000);
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], distances[i]);
+
+  remove("test_chunked_neighbors.mlbin");
+  remove("test_chunked_distances.mlbin");
+}
+
+/**
+ * Make sure that BatchServer reads each request of a stream, writes the
+ * responses in order, and stops at the end of the input.
+ */
+BOOST_AUTO_TEST_CASE(BatchServerTest)
+{
+  std::vector<arma::mat> batches;
+  std::stringstream requests;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    batches.push_back(arma::randu<arma::mat>(4, 10 * i + 1));
+    SaveNativeBinary(requests, "requests", batches[i]);
+  }
+
+  std::stringstream responses;
+  BatchServer<double> server(requests, responses);
+  arma::mat batch;
+  while (server.Next(batch))
+  {
+    arma::Mat<size_t> size(1, 1);
+    size[0] = batch.n_cols;
+    server.Reply(size);
+    server.Reply(arma::mat(arma::sum(batch, 0)));
+    server.Flush();
+  }
+  BOOST_REQUIRE_EQUAL(server.Batches(), 3);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    arma::Mat<size_t> size;
+    arma::mat sums;
+    LoadNativeBinary(responses, "responses", size);
+    LoadNativeBinary(responses, "responses", sums);
+
+    BOOST_REQUIRE_EQUAL(size[0], batches[i].n_cols);
+    BOOST_REQUIRE_EQUAL(sums.n_cols, batches[i].n_cols);
+    for (size_t j = 0; j < sums.n_cols; ++j)
+      BOOST_REQUIRE_CLOSE(sums[j], arma::accu(batches[i].col(j)), 1e-5);
+  }
+  BOOST_REQUIRE_EQUAL(responses.peek(), std::char_traits<char>::eof());
+
+  // A truncated request is an error.
+  std::stringstream truncated;
+  SaveNativeBinary(truncated, "truncated", batches[2]);
+  const std::string s = truncated.str();
+  std::stringstream truncatedRequests(s.substr(0, s.size() - 8));
+  BatchServer<double> truncatedServer(truncatedRequests, responses);
+  BOOST_REQUIRE_THROW(truncatedServer.Next(batch), std::runtime_error);
+}
+
+/**
+ * Make sure that ChunkedLoader maps the categorical dimensions of ARFF and text
+ * files consistently across chunks, and reads native binary files.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedLoadDatasetInfoTest)
+{
+  fstream f;
+  f.open("test_chunked.arff", fstream::out);
+  f << "@relation test" << endl;
+  f << "@attribute one STRING" << endl;
+  f << "@attribute two REAL" << endl;
+  f << "@data" << endl;
+  f << "hello, 1" << endl;
+  f << "cheese, 2.5" << endl;
+  f << "\"hello\", -1" << endl;
+  f.close();
+
+  f.open("test_chunked.csv", fstream::out);
+  f << "1, hello" << endl;
+  f << "2, cheese" << endl;
+  f << "3, hello" << endl;
+  f.close();
+
+  arma::mat full;
+  DatasetInfo fullInfo;
+  BOOST_REQUIRE(data::Load("test_chunked.arff", full, fullInfo));
+
+  for (size_t format = 0; format < 2; ++format)
+  {
+    ChunkedLoader<double> loader((format == 0) ? "test_chunked.arff" :
+        "test_chunked.csv");
+    const size_t categorical = (format == 0) ? 0 : 1;
+    const size_t numeric = 1 - categorical;
+
+    arma::mat chunk;
+    std::vector<double> values;
+    std::vector<double> numbers;
+    while (loader.Next(chunk, 2))
+    {
+      BOOST_REQUIRE_EQUAL(chunk.n_rows, 2);
+      for (size_t i = 0; i < chunk.n_cols; ++i)
+      {
+        values.push_back(chunk(categorical, i));
+        numbers.push_back(chunk(numeric, i));
+      }
+    }
+
+    BOOST_REQUIRE_EQUAL(values.size(), 3);
+    BOOST_REQUIRE(loader.Info().Type(categorical) == Datatype::categorical);
+    BOOST_REQUIRE(loader.Info().Type(numeric) == Datatype::numeric);
+    BOOST_REQUIRE_EQUAL(loader.Info().NumMappings(categorical), 2);
+
+    // The third point is in the second chunk, but it must be mapped as the
+    // first one.
+    BOOST_REQUIRE_EQUAL(values[0], values[2]);
+    BOOST_REQUIRE_NE(values[0], values[1]);
+    if (format == 0)
+    {
+      for (size_t i = 0; i < 3; ++i)
+        BOOST_REQUIRE_EQUAL(numbers[i], full(1, i));
+    }
+    else
+    {
+      BOOST_REQUIRE_EQUAL(numbers[2], 3.0);
+    }
+  }
+
+  // A given DatasetInfo is used for the mappings, and must have the right
+  // dimensionality.
+  {
+    ChunkedLoader<double> loader("test_chunked.arff", fullInfo);
+    arma::mat chunk;
+    BOOST_REQUIRE(loader.Next(chunk, 10));
+    BOOST_REQUIRE_EQUAL(chunk.n_cols, 3);
+    for (size_t i = 0; i < chunk.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(chunk[i], full[i]);
+  }
+  BOOST_REQUIRE_THROW(ChunkedLoader<double>("test_chunked.arff",
+      DatasetInfo(3)), std::invalid_argument);
+
+  // A native binary file is read with its DatasetInfo.
+  BOOST_REQUIRE(data::Save("test_chunked.mlbin", full, fullInfo));
+  ChunkedLoader<float> loader("test_chunked.mlbin");
+  BOOST_REQUIRE_EQUAL(loader.Info().NumMappings(0), 2);
+  arma::fmat chunk;
+  size_t numChunks = 0;
+  while (loader.Next(chunk, 2))
+  {
+    BOOST_REQUIRE_EQUAL(chunk.n_rows, 2);
+    for (size_t i = 0; i < chunk.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(chunk[i], (float) full[4 * numChunks + i]);
+    ++numChunks;
+  }
+  BOOST_REQUIRE_EQUAL(numChunks, 2);
+
+  remove("test_chunked.arff");
+  remove("test_chunked.csv");
+  remove("test_chunked.mlbin");
+}
+
+/**
+ * Make sure that PrefetchingLoader gives the chunks that ChunkedLoader gives,
+ * transformed and (if asked) shuffled, over several passes.
+ */
+BOOST_AUTO_TEST_CASE(PrefetchingLoaderTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 25);
+  BOOST_REQUIRE(data::Save("test_prefetch.csv", dataset) == true);
+  arma::mat full;
+  BOOST_REQUIRE(data::Load("test_prefetch.csv", full) == true);
+
+  // Without shuffling, the chunks are those of the file, transformed.
+  PrefetchingLoader<double> loader("test_prefetch.csv", 10, false,
+      [](arma::mat& chunk) { chunk *= 2.0; });
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    arma::mat chunk;
+    size_t numChunks = 0;
+    while (loader.Next(chunk))
+    {
+      BOOST_REQUIRE_EQUAL(chunk.n_rows, 3);
+      BOOST_REQUIRE_EQUAL(chunk.n_cols, (numChunks < 2) ? 10 : 5);
+      for (size_t i = 0; i < chunk.n_elem; ++i)
+        BOOST_REQUIRE_EQUAL(chunk[i], 2.0 * full[30 * numChunks + i]);
+      ++numChunks;
+    }
+
+    BOOST_REQUIRE_EQUAL(numChunks, 3);
+    BOOST_REQUIRE_EQUAL(loader.PointsRead(), 25);
+    BOOST_REQUIRE(!loader.Next(chunk));
+    loader.Reset();
+  }
+
+  // With shuffling, each chunk holds the points of the same chunk of the file,
+  // in another order for each pass.
+  PrefetchingLoader<double> shuffledLoader("test_prefetch.csv", 10, true);
+  arma::mat firstPass(3, 25);
+  bool reordered = false;
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    arma::mat chunk;
+    size_t numChunks = 0;
+    while (shuffledLoader.Next(chunk))
+    {
+      const size_t begin = 10 * numChunks;
+      std::vector<bool> found(chunk.n_cols, false);
+      for (size_t i = 0; i < chunk.n_cols; ++i)
+      {
+        size_t j = 0;
+        while (j < chunk.n_cols &&
+            (found[j] || arma::any(chunk.col(i) != full.col(begin + j))))
+          ++j;
+        BOOST_REQUIRE_LT(j, chunk.n_cols);
+        found[j] = true;
+      }
+
+      if (pass == 0)
+        firstPass.cols(begin, begin + chunk.n_cols - 1) = chunk;
+      else if (arma::any(arma::vectorise(chunk !=
+          firstPass.cols(begin, begin + chunk.n_cols - 1))))
+        reordered = true;
+      ++numChunks;
+    }
+
+    BOOST_REQUIRE_EQUAL(numChunks, 3);
+    shuffledLoader.Reset();
+  }
+  BOOST_REQUIRE(reordered);
+
+  BOOST_REQUIRE_THROW(PrefetchingLoader<double>("test_prefetch.csv", 0),
+      std::invalid_argument);
+
+  remove("test_prefetch.csv");
+}
+
+/**
+ * Make sure the text parser handles blank lines, Windows line endings, short
+ * lines and trailing commas in CSV files, and loads every number exactly.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTextLoadTest)
+{
+  fstream f;
+  f.open("test_text.csv", fstream::out | fstream::binary);
+  f << "1, 2.5, -3e2,\r\n";
+  f << "\r\n";
+  f << "4,5\r\n";
+  f << "  0.1 ,1e-310, 123456789.123456789" << endl;
+  f.close();
+
+  arma::mat test;
+  BOOST_REQUIRE(data::Load("test_text.csv", test));
+  BOOST_REQUIRE_EQUAL(test.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(test(0, 0), 1.0);
+  BOOST_REQUIRE_EQUAL(test(1, 0), 2.5);
+  BOOST_REQUIRE_EQUAL(test(2, 0), -300.0);
+  BOOST_REQUIRE_EQUAL(test(0, 1), 4.0);
+  BOOST_REQUIRE_EQUAL(test(1, 1), 5.0);
+  BOOST_REQUIRE_EQUAL(test(2, 1), 0.0);
+  BOOST_REQUIRE_EQUAL(test(0, 2), 0.1);
+  BOOST_REQUIRE_EQUAL(test(1, 2), std::strtod("1e-310", NULL));
+  BOOST_REQUIRE_EQUAL(test(2, 2), std::strtod("123456789.123456789", NULL));
+
+  BOOST_REQUIRE(data::Load("test_text.csv", test, false, false));
+  BOOST_REQUIRE_EQUAL(test.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(test(1, 0), 4.0);
+  BOOST_REQUIRE_EQUAL(test(2, 1), std::strtod("1e-310", NULL));
+
+  // Numbers written with full precision must be read back exactly.
+  arma::mat dataset(5, 2000, arma::fill::randn);
+  dataset.row(1) *= 1e100;
+  dataset.row(2) /= 1e100;
+  f.open("test_text.txt", fstream::out);
+  f.precision(17);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    for (size_t j = 0; j < dataset.n_rows; ++j)
+      f << dataset(j, i) << ((j + 1 < dataset.n_rows) ? " " : "\n");
+  }
+  f.close();
+
+  BOOST_REQUIRE(data::Load("test_text.txt", test));
+  BOOST_REQUIRE_EQUAL(test.n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(test.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(test[i], dataset[i]);
+
+  // Whitespace-separated files must have the same number of fields on each
+  // line, and only numbers.
+  f.open("test_text.txt", fstream::out);
+  f << "1 2 3" << endl << "4 5" << endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_text.txt", test));
+
+  f.open("test_text.txt", fstream::out);
+  f << "1 2 3" << endl << "4 five 6" << endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_text.txt", test));
+
+  remove("test_text.csv");
+  remove("test_text.txt");
+}
+
+/**
+ * Make sure the text writer formats numbers with the fewest digits that read
+ * back exactly, and that saved matrices load back exactly.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTextSaveTest)
+{
+  char buffer[MaxFormattedNumberLength];
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(0.1, buffer)), "0.1");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(3.0, buffer)), "3");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(-0.0, buffer)), "-0");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(-2.5e-8, buffer)),
+      "-2.5e-08");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(1e100, buffer)), "1e+100");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(0.1f, buffer)), "0.1");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber((size_t) 1234, buffer)),
+      "1234");
+  BOOST_REQUIRE_EQUAL(string(buffer, FormatNumber(-17, buffer)), "-17");
+
+  // Enough points for several blocks, with numbers of all magnitudes.
+  arma::mat dataset(5, 30000, arma::fill::randn);
+  dataset.row(1) *= 1e100;
+  dataset.row(2) /= 1e100;
+  dataset.row(3) = arma::round(dataset.row(3) * 1000);
+  dataset(4, 0) = 1.0 / 3.0;
+
+  arma::mat test;
+  BOOST_REQUIRE(data::Save("test_save_text.csv", dataset));
+  BOOST_REQUIRE(data::Load("test_save_text.csv", test));
+  BOOST_REQUIRE_EQUAL(test.n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(test.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(test[i], dataset[i]);
+
+  // Without transposing, each row is a line.
+  BOOST_REQUIRE(data::Save("test_save_text.txt", dataset, false, false));
+  BOOST_REQUIRE(data::Load("test_save_text.txt", test, false, false));
+  BOOST_REQUIRE_EQUAL(test.n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(test.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(test[i], dataset[i]);
+
+  // Integer matrices are written as integers.
+  arma::Mat<size_t> labels(1, 3);
+  labels[0] = 0;
+  labels[1] = 12;
+  labels[2] = 345;
+  BOOST_REQUIRE(data::Save("test_save_text.csv", labels));
+  fstream f("test_save_text.csv", fstream::in);
+  string line;
+  getline(f, line);
+  BOOST_REQUIRE_EQUAL(line, "0");
+  getline(f, line);
+  BOOST_REQUIRE_EQUAL(line, "12");
+  getline(f, line);
+  BOOST_REQUIRE_EQUAL(line, "345");
+  f.close();
+
+  remove("test_save_text.csv");
+  remove("test_save_text.txt");
+}
+
+/**
+ * Make sure that gzip-compressed datasets and models load back as they were
+ * saved, or give an error if mlpack was built without Boost.Iostreams.
+ */
+BOOST_AUTO_TEST_CASE(CompressedLoadSaveTest)
+{
+  arma::mat dataset(4, 100, arma::fill::randu);
+  Test x(10, 12);
+
+  if (!data::CompressionSupported())
+  {
+    BOOST_REQUIRE(!data::Save("test_compressed.csv.gz", dataset));
+    BOOST_REQUIRE(!data::Save("test_compressed.xml.gz", "x", x));
+    return;
+  }
+
+  const char* names[] = { "test_compressed.csv.gz", "test_compressed.bin.gz",
+      "test_compressed.mlbin.gz" };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE(data::Save(names[i], dataset));
+
+    arma::mat loaded;
+    BOOST_REQUIRE(data::Load(names[i], loaded));
+    BOOST_REQUIRE_EQUAL(loaded.n_rows, dataset.n_rows);
+    BOOST_REQUIRE_EQUAL(loaded.n_cols, dataset.n_cols);
+    for (size_t j = 0; j < dataset.n_elem; ++j)
+      BOOST_REQUIRE_CLOSE(loaded[j], dataset[j], 1e-3);
+
+    arma::mat infoLoaded;
+    DatasetInfo loadedInfo;
+    if (i != 1) // DatasetInfo can't be loaded from Armadillo binary files.
+    {
+      BOOST_REQUIRE(data::Load(names[i], infoLoaded, loadedInfo));
+      BOOST_REQUIRE_EQUAL(infoLoaded.n_cols, dataset.n_cols);
+      BOOST_REQUIRE_EQUAL(loadedInfo.Dimensionality(), 4);
+    }
+
+    remove(names[i]);
+  }
+
+  BOOST_REQUIRE(data::Save("test_compressed.xml.gz", "x", x));
+  Test y(11, 14);
+  BOOST_REQUIRE(data::Load("test_compressed.xml.gz", "x", y));
+  BOOST_REQUIRE_EQUAL(y.x, x.x);
+  BOOST_REQUIRE_EQUAL(y.y, x.y);
+  BOOST_REQUIRE_EQUAL(y.inb.s, x.inb.s);
+  remove("test_compressed.xml.gz");
+
+  // Sparse matrices go through the sparse text parser after decompression.
+  arma::sp_mat sparse;
+  sparse.sprandu(20, 30, 0.1);
+  const char* sparseNames[] = { "test_compressed.svm.gz",
+      "test_compressed.coo.gz" };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BOOST_REQUIRE(data::Save(sparseNames[i], sparse));
+
+    arma::sp_mat loaded;
+    BOOST_REQUIRE(data::Load(sparseNames[i], loaded));
+    BOOST_REQUIRE_EQUAL(loaded.n_nonzero, sparse.n_nonzero);
+    for (arma::sp_mat::const_iterator it = sparse.begin(); it != sparse.end();
+        ++it)
+      BOOST_REQUIRE_CLOSE((double) loaded(it.row(), it.col()), *it, 1e-3);
+
+    remove(sparseNames[i]);
+  }
+
+  // A file which isn't compressed gives an error.
+  BOOST_REQUIRE(data::Save("test_compressed.csv", dataset));
+  rename("test_compressed.csv", "test_compressed.csv.gz");
+  arma::mat loaded;
+  BOOST_REQUIRE(!data::Load("test_compressed.csv.gz", loaded));
+  remove("test_compressed.csv.gz");
+
+  BOOST_REQUIRE(data::Save("test_compressed.svm", sparse));
+  rename("test_compressed.svm", "test_compressed.svm.gz");
+  arma::sp_mat sparseLoaded;
+  BOOST_REQUIRE(!data::Load("test_compressed.svm.gz", sparseLoaded));
+  remove("test_compressed.svm.gz");
+}
+
+/**
+ * Make sure DatasetInfo maps many distinct strings consistently, one at a time
+ * and in bulk, and that the mappings survive serialization.
+ */
+BOOST_AUTO_TEST_CASE(DatasetInfoManyMappingsTest)
+{
+  DatasetInfo info(2);
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < 5000; ++i)
+    strings.push_back("id" + std::to_string(i * 7919));
+
+  for (size_t i = 0; i < strings.size(); ++i)
+    BOOST_REQUIRE_EQUAL(info.MapString(strings[i], 0), i);
+  BOOST_REQUIRE_EQUAL(info.NumMappings(0), strings.size());
+  BOOST_REQUIRE(info.Type(0) == Datatype::categorical);
+  BOOST_REQUIRE(info.Type(1) == Datatype::numeric);
+
+  // Mapping the strings again in bulk, in reverse, gives the same values.
+  std::vector<std::string> reversed(strings.rbegin(), strings.rend());
+  arma::Row<size_t> values;
+  info.MapStrings(reversed, 0, values);
+  BOOST_REQUIRE_EQUAL(values.n_elem, strings.size());
+  for (size_t i = 0; i < values.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(values[i], strings.size() - 1 - i);
+  BOOST_REQUIRE_EQUAL(info.NumMappings(0), strings.size());
+
+  std::vector<std::string> unmapped;
+  info.UnmapStrings(values, 0, unmapped);
+  for (size_t i = 0; i < unmapped.size(); ++i)
+    BOOST_REQUIRE_EQUAL(unmapped[i], reversed[i]);
+
+  BOOST_REQUIRE_THROW(info.UnmapString(strings.size(), 0),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(info.UnmapString(0, 1), std::invalid_argument);
+
+  // The empty string is a valid category too.
+  BOOST_REQUIRE_EQUAL(info.MapString("", 1), 0);
+  BOOST_REQUIRE_EQUAL(info.MapString("id0", 1), 1);
+  BOOST_REQUIRE_EQUAL(info.UnmapString(0, 1), "");
+
+  BOOST_REQUIRE(data::Save("test_info.xml", "info", info));
+  DatasetInfo loaded;
+  BOOST_REQUIRE(data::Load("test_info.xml", "info", loaded));
+  remove("test_info.xml");
+
+  BOOST_REQUIRE_EQUAL(loaded.Dimensionality(), 2);
+  BOOST_REQUIRE_EQUAL(loaded.NumMappings(0), strings.size());
+  BOOST_REQUIRE_EQUAL(loaded.NumMappings(1), 2);
+  for (size_t i = 0; i < strings.size(); ++i)
+    BOOST_REQUIRE_EQUAL(loaded.MapString(strings[i], 0), i);
+  BOOST_REQUIRE_EQUAL(loaded.MapString("new", 0), strings.size());
+  BOOST_REQUIRE_EQUAL(loaded.UnmapString(1, 1), "id0");
+}
+
+/**
+ * Make sure LIBSVM files are parsed correctly, including labels, comments,
+ * "qid:" fields, unordered indices and explicit zeros.
+ */
+BOOST_AUTO_TEST_CASE(LoadLibSVMTest)
+{
+  std::fstream f;
+  f.open("test_file.svm", std::fstream::out);
+  f << "# A comment line." << std::endl;
+  f << "1 1:0.5 3:2.5" << std::endl;
+  f << "-1 qid:3 5:-1 2:4e1 # Unordered indices." << std::endl;
+  f << std::endl;
+  f << "1 4:0" << std::endl;
+  f.close();
+
+  arma::sp_mat matrix;
+  arma::Row<int> labels;
+  BOOST_REQUIRE(data::Load("test_file.svm", matrix, labels));
+  remove("test_file.svm");
+
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_nonzero, 4);
+  BOOST_REQUIRE_CLOSE((double) matrix(0, 0), 0.5, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) matrix(2, 0), 2.5, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) matrix(1, 1), 40.0, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) matrix(4, 1), -1.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 3);
+  BOOST_REQUIRE_EQUAL(labels[0], 1);
+  BOOST_REQUIRE_EQUAL(labels[1], -1);
+  BOOST_REQUIRE_EQUAL(labels[2], 1);
+
+  // A repeated index is an error.
+  f.open("test_file.svm", std::fstream::out);
+  f << "1 2:0.5 2:1.5" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_file.svm", matrix));
+  remove("test_file.svm");
+}
+
+/**
+ * Save and load a random sparse matrix in both sparse text formats.
+ */
+BOOST_AUTO_TEST_CASE(SparseTextLoadSaveTest)
+{
+  arma::sp_mat matrix;
+  matrix.sprandu(50, 3000, 0.02);
+  // Make sure the last point and dimension are used, so that a coordinate list
+  // gives the same size.
+  arma::sp_mat corner(50, 3000);
+  corner(49, 2999) = 0.25;
+  matrix += corner;
+  arma::Row<size_t> labels = arma::randi<arma::Row<size_t>>(3000,
+      arma::distr_param(0, 4));
+
+  BOOST_REQUIRE(data::Save("test_file.svm", matrix, labels));
+  BOOST_REQUIRE(data::Save("test_file.coo", matrix));
+
+  arma::sp_mat svmMatrix, cooMatrix;
+  arma::Row<size_t> svmLabels;
+  BOOST_REQUIRE(data::Load("test_file.svm", svmMatrix, svmLabels));
+  BOOST_REQUIRE(data::Load("test_file.coo", cooMatrix));
+  remove("test_file.svm");
+  remove("test_file.coo");
+
+  // Labels can't be saved to a coordinate list.
+  BOOST_REQUIRE(!data::Save("test_file.coo", matrix, labels));
+
+  // A wrong number of labels gives an error instead of an exception.
+  const arma::Row<size_t> fewLabels = labels.head(10);
+  BOOST_REQUIRE(!data::Save("test_file.svm", matrix, fewLabels));
+  remove("test_file.svm");
+
+  const arma::sp_mat* loaded[] = { &svmMatrix, &cooMatrix };
+  for (size_t m = 0; m < 2; ++m)
+  {
+    BOOST_REQUIRE_EQUAL(loaded[m]->n_rows, matrix.n_rows);
+    BOOST_REQUIRE_EQUAL(loaded[m]->n_cols, matrix.n_cols);
+    BOOST_REQUIRE_EQUAL(loaded[m]->n_nonzero, matrix.n_nonzero);
+    for (size_t i = 0; i < matrix.n_nonzero; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(loaded[m]->row_indices[i], matrix.row_indices[i]);
+      BOOST_REQUIRE_CLOSE(loaded[m]->values[i], matrix.values[i], 1e-10);
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(svmLabels.n_elem, labels.n_elem);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(svmLabels[i], labels[i]);
+}
+
+#ifdef HAS_HDF5
+/**
+ * Make sure that ranges of points of an HDF5 dataset can be loaded, both with
+ * data::Load() and with ChunkedLoader.
+ */
+BOOST_AUTO_TEST_CASE(LoadHDF5RangeTest)
+{
+  arma::mat matrix;
+  matrix.randu(5, 103);
+  BOOST_REQUIRE(data::Save("test_range.h5", matrix));
+
+  arma::mat range;
+  BOOST_REQUIRE(data::Load("test_range.h5", range, "dataset", 17, 40));
+  BOOST_REQUIRE_EQUAL(range.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(range.n_cols, 40);
+  for (size_t i = 0; i < range.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(range[i], matrix.cols(17, 56)[i], 1e-10);
+
+  // Ranges past the end and missing datasets can't be loaded.
+  Log::Warn.ignoreInput = true;
+  BOOST_REQUIRE(!data::Load("test_range.h5", range, "dataset", 100, 4));
+  BOOST_REQUIRE(!data::Load("test_range.h5", range, "missing", 0, 4));
+  Log::Warn.ignoreInput = false;
+
+  // Read the whole file, and then a range, in chunks.
+  ChunkedLoader<float> loader("test_range.h5");
+  arma::fmat chunk;
+  size_t points = 0;
+  while (loader.Next(chunk, 10))
+  {
+    BOOST_REQUIRE_EQUAL(chunk.n_rows, 5);
+    for (size_t i = 0; i < chunk.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(chunk[i], (float) matrix[5 * points + i], 1e-4);
+    points += chunk.n_cols;
+  }
+  BOOST_REQUIRE_EQUAL(points, 103);
+
+  ChunkedLoader<double> rangeLoader("test_range.h5", "dataset", 30, 25);
+  arma::mat rangeChunk;
+  points = 0;
+  while (rangeLoader.Next(rangeChunk, 7))
+  {
+    for (size_t i = 0; i < rangeChunk.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(rangeChunk[i], matrix[5 * (30 + points) + i], 1e-10);
+    points += rangeChunk.n_cols;
+  }
+  BOOST_REQUIRE_EQUAL(points, 25);
+
+  BOOST_REQUIRE_THROW(ChunkedLoader<double>("test_range.h5", "dataset", 90,
+      20), std::runtime_error);
+
+  remove("test_range.h5");
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,7 @@
 // Note: We don't use BOOST_REQUIRE_CLOSE in the code below because we need
 // to use FPC_WEAK, and it's not at all intuitive how to do that.
 #include <mlpack/methods/local_coordinate_coding/lcc.hpp>
+#include <mlpack/methods/local_coordinate_coding/lcc_encoder.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -161,4 +162,82 @@ BOOST_AUTO_TEST_CASE(SerializationTest)
   BOOST_REQUIRE_EQUAL(lcc.MaxIterations(), lccBinary.MaxIterations());
 }
 
+/**
+ * Make sure that coding the points in parallel gives the same codes as coding
+ * them with one thread.
+ */
+BOOST_AUTO_TEST_CASE(LocalCoordinateCodingParallelEncodeTest)
+{
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  LocalCoordinateCoding lcc(X, 25, 0.1);
+
+  mat serialZ, parallelZ;
+  ThreadPool::SetThreads(1);
+  lcc.Encode(X, serialZ);
+  ThreadPool::SetThreads(0);
+  lcc.Encode(X, parallelZ);
+
+  BOOST_REQUIRE_EQUAL(serialZ.n_rows, parallelZ.n_rows);
+  BOOST_REQUIRE_EQUAL(serialZ.n_cols, parallelZ.n_cols);
+  for (size_t i = 0; i < serialZ.n_elem; ++i)
+  {
+    if (std::abs(serialZ[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(parallelZ[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(serialZ[i], parallelZ[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that an LCCEncoder gives the same codes as
+ * LocalCoordinateCoding::Encode() when it is reused for several batches (and
+ * several numbers of threads), and that it bounds the number of nonzero
+ * coefficients.
+ */
+BOOST_AUTO_TEST_CASE(LCCEncoderTest)
+{
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  LocalCoordinateCoding lcc(X, 25, 0.1);
+
+  mat expectedZ;
+  lcc.Encode(X, expectedZ);
+
+  LCCEncoder encoder(lcc);
+  mat firstZ, secondZ;
+  ThreadPool::SetThreads(1);
+  encoder.Encode(X.cols(0, 99), firstZ);
+  ThreadPool::SetThreads(0);
+  encoder.Encode(X.cols(100, X.n_cols - 1), secondZ);
+
+  const mat Z = join_rows(firstZ, secondZ);
+  BOOST_REQUIRE_EQUAL(Z.n_rows, expectedZ.n_rows);
+  BOOST_REQUIRE_EQUAL(Z.n_cols, expectedZ.n_cols);
+  for (size_t i = 0; i < Z.n_elem; ++i)
+  {
+    if (std::abs(expectedZ[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(Z[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(expectedZ[i], Z[i], 1e-5);
+  }
+
+  // With a bounded active set, no code has more nonzero coefficients.
+  LCCEncoder boundedEncoder(lcc.Dictionary(), 0.001, 2);
+  mat boundedZ;
+  boundedEncoder.Encode(X, boundedZ);
+  for (size_t i = 0; i < boundedZ.n_cols; ++i)
+    BOOST_REQUIRE_LE(accu(boundedZ.col(i) != 0.0), 2);
+
+  mat wrongZ;
+  BOOST_REQUIRE_THROW(encoder.Encode(X.rows(1, X.n_rows - 1), wrongZ),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -957,4 +957,290 @@ BOOST_AUTO_TEST_CASE(ClassifyProbabilitiesTest)
   }
 }
 
+/**
+ * Make sure that the batch objective and gradient are the sums of the
+ * separable objectives and gradients of the points of the batch.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionBatchTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 50);
+  arma::Row<size_t> responses(50);
+  for (size_t i = 0; i < 50; ++i)
+    responses[i] = (arma::accu(data.col(i)) > 2.5) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.5);
+  const arma::mat parameters = arma::randn<arma::mat>(6, 1);
+
+  for (size_t begin = 0; begin < 50; begin += 10)
+  {
+    const size_t batchSize = (begin == 40) ? 10 : 7;
+
+    double objective = 0.0;
+    arma::mat gradient = arma::zeros<arma::mat>(6, 1), pointGradient;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      objective += lrf.Evaluate(parameters, i);
+      lrf.Gradient(parameters, i, pointGradient);
+      gradient += pointGradient;
+    }
+
+    arma::mat batchGradient;
+    lrf.Gradient(parameters, begin, batchGradient, batchSize);
+
+    BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters, begin, batchSize, true),
+        objective, 1e-8);
+    BOOST_REQUIRE_EQUAL(batchGradient.n_elem, 6);
+    for (size_t i = 0; i < 6; ++i)
+      BOOST_REQUIRE_CLOSE(batchGradient[i], gradient[i], 1e-8);
+  }
+}
+
+/**
+ * Make sure the sparse gradient of a sparse point is the same as the dense
+ * gradient, and that SGD with lazy weight decay on sparse gradients gives the
+ * same result as SGD with dense gradients.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionSparseGradientTest)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(20, 300, 0.1);
+  arma::mat denseDataset(dataset);
+  arma::Row<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  LogisticRegressionFunction<arma::sp_mat> lrfSparse(dataset, labels, 0.0);
+  LogisticRegressionFunction<> lrf(denseDataset, labels, 0.0);
+
+  const arma::mat parameters = arma::randn<arma::mat>(21, 1);
+  for (size_t i = 0; i < 300; i += 10)
+  {
+    arma::sp_mat sparseGradient;
+    arma::mat gradient;
+    lrfSparse.Gradient(parameters, i, sparseGradient);
+    lrf.Gradient(parameters, i, gradient);
+
+    // Only the intercept and the nonzero dimensions of the point are set, and
+    // they are all in the support.
+    BOOST_REQUIRE_LE(sparseGradient.n_nonzero,
+        dataset.col_ptrs[i + 1] - dataset.col_ptrs[i] + 1);
+    BOOST_REQUIRE_EQUAL(sparseGradient.n_elem, 21);
+    arma::uvec support;
+    lrfSparse.GradientSupport(i, support);
+    BOOST_REQUIRE_EQUAL(support.n_elem,
+        dataset.col_ptrs[i + 1] - dataset.col_ptrs[i] + 1);
+    for (arma::sp_mat::const_iterator it = sparseGradient.begin();
+        it != sparseGradient.end(); ++it)
+      BOOST_REQUIRE_EQUAL(arma::accu(support == it.row()), 1);
+    for (size_t j = 0; j < 21; ++j)
+    {
+      if (std::abs(gradient[j]) < 1e-10)
+        BOOST_REQUIRE_SMALL((double) sparseGradient(j), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE((double) sparseGradient(j), gradient[j], 1e-8);
+    }
+  }
+
+  // The decay is applied eagerly with dense gradients and lazily with sparse
+  // gradients; the results should be the same.
+  SGD<LogisticRegressionFunction<>> sgd(lrf, 0.01, 3000, 1e-10, false, 0.01);
+  SGD<LogisticRegressionFunction<arma::sp_mat>> sgdSparse(lrfSparse, 0.01,
+      3000, 1e-10, false, 0.01);
+
+  arma::mat denseParameters = lrf.GetInitialPoint();
+  arma::mat sparseParameters = lrfSparse.GetInitialPoint();
+  denseParameters.fill(0.5);
+  sparseParameters.fill(0.5);
+  sgd.Optimize(denseParameters);
+  sgdSparse.Optimize(sparseParameters);
+
+  for (size_t i = 0; i < denseParameters.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(sparseParameters[i] - denseParameters[i], 1e-8);
+}
+
+/**
+ * A sparse logistic regression function which counts the sparse gradients it
+ * computes.
+ */
+class CountingSparseFunction
+{
+ public:
+  CountingSparseFunction(LogisticRegressionFunction<arma::sp_mat>& function) :
+      function(function), gradients(0) { }
+
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  double Evaluate(const arma::mat& parameters, const size_t i) const
+  {
+    return function.Evaluate(parameters, i);
+  }
+
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::sp_mat& gradient)
+  {
+    ++gradients;
+    function.Gradient(parameters, i, gradient);
+  }
+
+  void GradientSupport(const size_t i, arma::uvec& support) const
+  {
+    function.GradientSupport(i, support);
+  }
+
+  size_t Gradients() const { return gradients; }
+
+ private:
+  LogisticRegressionFunction<arma::sp_mat>& function;
+  size_t gradients;
+};
+
+/**
+ * Make sure that SGD with lazy weight decay computes one sparse gradient per
+ * step when the function gives the support of its gradients.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionSparseDecayGradientCountTest)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(20, 100, 0.1);
+  arma::Row<size_t> labels(100);
+  for (size_t i = 0; i < 100; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  LogisticRegressionFunction<arma::sp_mat> lrf(dataset, labels, 0.0);
+  CountingSparseFunction function(lrf);
+  SGD<CountingSparseFunction> sgd(function, 0.01, 250, 0.0, false, 0.01);
+
+  arma::mat parameters(21, 1);
+  parameters.fill(0.5);
+  sgd.Optimize(parameters);
+
+  // Each of the 249 steps computes one gradient.
+  BOOST_REQUIRE_EQUAL(function.Gradients(), 249);
+}
+
+/**
+ * Make sure that the objective function, the classifications, the
+ * probabilities and the error of a model are the same on sparse and dense
+ * data.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionSparsePredictionTest)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(15, 500, 0.2);
+  arma::mat denseDataset(dataset);
+  arma::Row<size_t> labels(500);
+  for (size_t i = 0; i < 500; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  arma::vec parameters = arma::randn<arma::vec>(16);
+  LogisticRegressionFunction<> lrf(denseDataset, labels, 0.4);
+  LogisticRegressionFunction<arma::sp_mat> lrfSparse(dataset, labels, 0.4);
+  BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters),
+      lrfSparse.Evaluate(parameters), 1e-8);
+
+  LogisticRegression<> lr(denseDataset, labels, 0.4);
+  LogisticRegression<arma::sp_mat> lrSparse(15, 0.4);
+  lrSparse.Parameters() = lr.Parameters();
+
+  arma::Row<size_t> predictions, sparsePredictions;
+  lr.Classify(denseDataset, predictions);
+  lrSparse.Classify(dataset, sparsePredictions);
+  BOOST_REQUIRE_EQUAL(predictions.n_elem, sparsePredictions.n_elem);
+  for (size_t i = 0; i < predictions.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(predictions[i], sparsePredictions[i]);
+
+  arma::mat probabilities, sparseProbabilities;
+  lr.Classify(denseDataset, probabilities);
+  lrSparse.Classify(dataset, sparseProbabilities);
+  BOOST_REQUIRE_EQUAL(sparseProbabilities.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(sparseProbabilities.n_cols, 500);
+  for (size_t i = 0; i < probabilities.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(probabilities[i] - sparseProbabilities[i], 1e-10);
+
+  BOOST_REQUIRE_CLOSE(lr.ComputeError(denseDataset, labels),
+      lrSparse.ComputeError(dataset, labels), 1e-8);
+  BOOST_REQUIRE_CLOSE(lr.ComputeAccuracy(denseDataset, labels),
+      lrSparse.ComputeAccuracy(dataset, labels), 1e-8);
+}
+
+/**
+ * Make sure that the fused scoring path gives the same probabilities and labels
+ * as Classify(), for dense and sparse points of doubles and floats, and that
+ * preallocated buffers are reused.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionScoreTest)
+{
+  arma::sp_mat sparseData;
+  sparseData.sprandn(12, 3000, 0.3);
+  const arma::mat data(sparseData);
+  const arma::fmat floatData = arma::conv_to<arma::fmat>::from(data);
+  const arma::sp_fmat sparseFloatData(floatData);
+
+  LogisticRegression<> lr(12, 0.0);
+  lr.Parameters() = arma::randn<arma::vec>(13);
+
+  arma::mat expectedProbabilities;
+  lr.Classify(data, expectedProbabilities);
+
+  for (size_t b = 0; b < 3; ++b)
+  {
+    const double boundary = 0.25 * (b + 1);
+
+    arma::Row<size_t> expectedLabels(3000);
+    for (size_t i = 0; i < 3000; ++i)
+      expectedLabels[i] = (expectedProbabilities(1, i) >= boundary) ? 1 : 0;
+
+    // Preallocated buffers keep their memory.
+    arma::rowvec probabilities(3000);
+    arma::Row<size_t> labels(3000);
+    const double* probabilitiesMem = probabilities.memptr();
+    lr.Score(data, probabilities, labels, boundary);
+    BOOST_REQUIRE_EQUAL(probabilities.memptr(), probabilitiesMem);
+
+    arma::rowvec sparseProbabilities;
+    arma::Row<size_t> sparseLabels, labelsOnly, sparseLabelsOnly;
+    lr.Score(sparseData, sparseProbabilities, sparseLabels, boundary);
+    lr.Score(data, labelsOnly, boundary);
+    lr.Score(sparseData, sparseLabelsOnly, boundary);
+
+    arma::frowvec floatProbabilities, sparseFloatProbabilities;
+    arma::Row<size_t> floatLabels, sparseFloatLabels;
+    lr.Score(floatData, floatProbabilities, floatLabels, boundary);
+    lr.Score(sparseFloatData, sparseFloatProbabilities, sparseFloatLabels,
+        boundary);
+
+    for (size_t i = 0; i < 3000; ++i)
+    {
+      BOOST_REQUIRE_SMALL(probabilities[i] - expectedProbabilities(1, i),
+          1e-12);
+      BOOST_REQUIRE_SMALL(sparseProbabilities[i] - expectedProbabilities(1, i),
+          1e-12);
+      BOOST_REQUIRE_SMALL(floatProbabilities[i] - expectedProbabilities(1, i),
+          1e-4);
+      BOOST_REQUIRE_SMALL(sparseFloatProbabilities[i] -
+          expectedProbabilities(1, i), 1e-4);
+
+      // Points too close to the boundary may be classified differently.
+      if (std::abs(expectedProbabilities(1, i) - boundary) > 1e-10)
+      {
+        BOOST_REQUIRE_EQUAL(labels[i], expectedLabels[i]);
+        BOOST_REQUIRE_EQUAL(sparseLabels[i], expectedLabels[i]);
+        BOOST_REQUIRE_EQUAL(labelsOnly[i], expectedLabels[i]);
+        BOOST_REQUIRE_EQUAL(sparseLabelsOnly[i], expectedLabels[i]);
+      }
+      if (std::abs(expectedProbabilities(1, i) - boundary) > 1e-3)
+      {
+        BOOST_REQUIRE_EQUAL(floatLabels[i], expectedLabels[i]);
+        BOOST_REQUIRE_EQUAL(sparseFloatLabels[i], expectedLabels[i]);
+      }
+    }
+  }
+
+  // Points of the wrong dimensionality are rejected.
+  arma::Row<size_t> labels;
+  BOOST_REQUIRE_THROW(lr.Score(arma::mat(11, 10, arma::fill::randu), labels),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
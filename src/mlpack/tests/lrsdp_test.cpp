@@ -309,4 +309,100 @@ BOOST_AUTO_TEST_CASE(Keller4LovaszThetaSDP)
   }
 }*/
 
+/**
+ * Make sure the constraints of an LRSDPFunction are evaluated correctly without
+ * forming R R^T, for both sparse and dense constraint matrices.
+ */
+BOOST_AUTO_TEST_CASE(LRSDPFunctionConstraintTest)
+{
+  SDP<arma::sp_mat> sdp(10, 3, 2);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    sdp.SparseA()[i].sprandu(10, 10, 0.2);
+    sdp.SparseA()[i] += sdp.SparseA()[i].t();
+    sdp.SparseB()[i] = (double) i;
+  }
+  for (size_t i = 0; i < 2; ++i)
+  {
+    sdp.DenseA()[i] = arma::randu<arma::mat>(10, 10);
+    sdp.DenseB()[i] = -1.0;
+  }
+
+  const arma::mat coordinates = arma::randn<arma::mat>(10, 3);
+  LRSDPFunction<SDP<arma::sp_mat>> function(sdp, coordinates);
+
+  const arma::mat rrt = coordinates * coordinates.t();
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(function.EvaluateConstraint(i, coordinates),
+        arma::accu(arma::mat(sdp.SparseA()[i]) % rrt) - i, 1e-8);
+  for (size_t i = 0; i < 2; ++i)
+    BOOST_REQUIRE_CLOSE(function.EvaluateConstraint(3 + i, coordinates),
+        arma::accu(sdp.DenseA()[i] % rrt) + 1.0, 1e-8);
+}
+
+/**
+ * Make sure that the augmented Lagrangian objective and gradient of an
+ * LRSDPFunction with many sparse constraints (split into several ranges) are
+ * the same as when R R^T and S are formed, with the constraint matrices and
+ * with the flat list of their elements.
+ */
+BOOST_AUTO_TEST_CASE(LRSDPFunctionFlatConstraintsTest)
+{
+  const size_t n = 30;
+  const size_t numSparse = 3000;
+  SDP<arma::sp_mat> sdp(n, numSparse, 1);
+  sdp.C().sprandu(n, n, 0.1);
+  sdp.C() += sdp.C().t();
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    const size_t j = i % n;
+    const size_t k = (i / n) % n;
+    sdp.SparseA()[i](j, k) += 1.0;
+    sdp.SparseA()[i](k, j) += 1.0;
+    sdp.SparseB()[i] = 0.5;
+  }
+  sdp.DenseA()[0] = arma::symmatu(arma::randu<arma::mat>(n, n));
+  sdp.DenseB()[0] = 2.0;
+
+  const arma::mat coordinates = arma::randn<arma::mat>(n, 4);
+  LRSDPFunction<SDP<arma::sp_mat>> function(sdp, coordinates);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> augFunction(
+      function);
+  augFunction.Lambda() = arma::randu<arma::vec>(numSparse + 1);
+  augFunction.Sigma() = 3.0;
+
+  // Compute the objective and the gradient by forming R R^T and S.
+  const arma::mat rrt = coordinates * coordinates.t();
+  double objective = arma::accu(arma::mat(sdp.C()) % rrt);
+  arma::mat s(sdp.C());
+  for (size_t i = 0; i <= numSparse; ++i)
+  {
+    const arma::mat a = (i < numSparse) ? arma::mat(sdp.SparseA()[i]) :
+        sdp.DenseA()[0];
+    const double b = (i < numSparse) ? sdp.SparseB()[i] : sdp.DenseB()[0];
+    const double constraint = arma::accu(a % rrt) - b;
+    objective += -augFunction.Lambda()[i] * constraint +
+        (augFunction.Sigma() / 2.) * constraint * constraint;
+    s -= (augFunction.Lambda()[i] - augFunction.Sigma() * constraint) * a;
+  }
+  const arma::mat gradient = 2 * s * coordinates;
+
+  for (size_t flat = 0; flat < 2; ++flat)
+  {
+    if (flat == 1)
+      function.FlattenSparseConstraints();
+    BOOST_REQUIRE_EQUAL(function.SparseConstraintsFlattened(), flat == 1);
+
+    BOOST_REQUIRE_CLOSE(augFunction.Evaluate(coordinates), objective, 1e-5);
+    arma::mat augGradient;
+    augFunction.Gradient(coordinates, augGradient);
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(augGradient[i], gradient[i], 1e-5);
+
+    for (size_t i = 0; i < numSparse; i += 97)
+      BOOST_REQUIRE_CLOSE(function.EvaluateConstraint(i, coordinates),
+          arma::accu(arma::mat(sdp.SparseA()[i]) % rrt) - 0.5, 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -354,6 +354,53 @@ BOOST_AUTO_TEST_CASE(RecallTest)
   BOOST_REQUIRE_LE(recallChp, recallThreshChp);
 }
 
+/**
+ * Test: with the same LSH model (few tables, so that recall without probing is
+ * mediocre), multi-probe search must find at least as many true neighbors as
+ * plain LSH search, because the probed buckets always include the bucket of
+ * the query in each table.  More probes must never decrease recall.
+ */
+BOOST_AUTO_TEST_CASE(MultiprobeTest)
+{
+  const int k = 4;
+  const int secondHashSize = 99901;
+  const int bucketSize = 500;
+
+  const string trainSet = "iris_train.csv";
+  const string testSet = "iris_test.csv";
+  arma::mat rdata;
+  arma::mat qdata;
+  data::Load(trainSet, rdata, true);
+  data::Load(testSet, qdata, true);
+
+  KNN knn(rdata);
+  arma::Mat<size_t> groundTruth;
+  arma::mat groundDistances;
+  knn.Search(qdata, k, groundTruth, groundDistances);
+
+  // A few tables with a narrow hash width.
+  const int hashWidth = 1;
+  const int numProj = 3;
+  const int numTables = 2;
+
+  LSHSearch<> lshTest(rdata, numProj, numTables, hashWidth, secondHashSize,
+      bucketSize);
+
+  double lastRecall = 0.0;
+  const size_t probes[] = { 0, 1, 5, 20 };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    arma::Mat<size_t> lshNeighbors;
+    arma::mat lshDistances;
+    lshTest.Search(qdata, k, lshNeighbors, lshDistances, 0, probes[i]);
+
+    const double recall = LSHSearch<>::ComputeRecall(lshNeighbors,
+        groundTruth);
+    BOOST_REQUIRE_GE(recall, lastRecall);
+    lastRecall = recall;
+  }
+}
+
 /**
  * Test: This is a deterministic test that projects 2-dpoints to a known line
  * (axis 2). The reference set contains 4 well-separated clusters that will
@@ -490,6 +537,156 @@ BOOST_AUTO_TEST_CASE(LSHTrainTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+/**
+ * Test: the buckets of the second hash table hold every point of every table
+ * exactly once when there is no maximum bucket size, and at most bucketSize
+ * points when there is one.
+ */
+BOOST_AUTO_TEST_CASE(BucketStoreTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 300);
+  const size_t numTables = 4;
+  const size_t secondHashSize = 101;
+
+  // A large hash width puts many points in the same bucket.
+  LSHSearch<> lsh(referenceData, 2, numTables, 10.0, secondHashSize, 0);
+
+  const arma::Col<size_t>& offsets = lsh.BucketOffsets();
+  const arma::Col<size_t>& contents = lsh.BucketContents();
+  BOOST_REQUIRE_EQUAL(offsets.n_elem, secondHashSize + 1);
+  BOOST_REQUIRE_EQUAL(offsets[0], 0);
+  BOOST_REQUIRE_EQUAL(offsets[secondHashSize], numTables * 300);
+  BOOST_REQUIRE_EQUAL(contents.n_elem, numTables * 300);
+
+  arma::Col<size_t> counts(300, arma::fill::zeros);
+  for (size_t i = 0; i < contents.n_elem; ++i)
+    counts[contents[i]]++;
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], numTables);
+
+  // Now cap the buckets.
+  const size_t bucketSize = 5;
+  lsh.Train(referenceData, 2, numTables, 10.0, secondHashSize, bucketSize);
+  BOOST_REQUIRE_EQUAL(lsh.BucketOffsets().n_elem, secondHashSize + 1);
+  BOOST_REQUIRE_LT(lsh.BucketContents().n_elem, numTables * 300);
+  for (size_t i = 0; i < secondHashSize; ++i)
+    BOOST_REQUIRE_LE(lsh.BucketOffsets()[i + 1] - lsh.BucketOffsets()[i],
+        bucketSize);
+}
+
+/**
+ * Test: the hash tables and the results of a search don't depend on the number
+ * of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(5, 700);
+
+  math::RandomSeed(42);
+  LSHSearch<> lsh(referenceData, 4, 6, 0.5);
+
+  arma::Mat<size_t> neighbors1, neighbors2;
+  arma::mat distances1, distances2;
+  lsh.Search(queryData, 3, neighbors1, distances1, 0, 2);
+
+  BOOST_REQUIRE_EQUAL(neighbors1.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(neighbors1.n_cols, 700);
+
+#ifdef _OPENMP
+  // Build the same tables and search again with one thread.
+  const int oldThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  math::RandomSeed(42);
+  LSHSearch<> serialLsh(referenceData, 4, 6, 0.5);
+  serialLsh.Search(queryData, 3, neighbors2, distances2, 0, 2);
+  omp_set_num_threads(oldThreads);
+
+  BOOST_REQUIRE_EQUAL(arma::accu(lsh.BucketOffsets() !=
+      serialLsh.BucketOffsets()), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(lsh.BucketContents() !=
+      serialLsh.BucketContents()), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(neighbors1 != neighbors2), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(distances1 != distances2), 0);
+#endif
+}
+
+/**
+ * Test: a model trained on part of a dataset with the rest of the points
+ * inserted afterwards gives the same results as a model (with the same random
+ * tables) trained on the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(InsertTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 600);
+  arma::mat queryData = arma::randu<arma::mat>(4, 100);
+
+  math::RandomSeed(42);
+  LSHSearch<> lsh(referenceData, 3, 5, 0.5);
+
+  // LSHSearch keeps a reference to the data it is trained on.
+  const arma::mat firstPoints = referenceData.cols(0, 399);
+  math::RandomSeed(42);
+  LSHSearch<> insertLsh(firstPoints, 3, 5, 0.5);
+  insertLsh.Insert(referenceData.cols(400, 499));
+  insertLsh.Insert(referenceData.cols(500, 599));
+
+  BOOST_REQUIRE_EQUAL(insertLsh.ReferenceSet().n_cols, 600);
+  BOOST_REQUIRE_EQUAL(arma::accu(lsh.BucketOffsets() !=
+      insertLsh.BucketOffsets()), 0);
+  BOOST_REQUIRE_EQUAL(insertLsh.BucketContents().n_elem, 5 * 600);
+
+  arma::Mat<size_t> neighbors, insertNeighbors;
+  arma::mat distances, insertDistances;
+  lsh.Search(queryData, 3, neighbors, distances);
+  insertLsh.Search(queryData, 3, insertNeighbors, insertDistances);
+
+  BOOST_REQUIRE_EQUAL(arma::accu(neighbors != insertNeighbors), 0);
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(distances[i], insertDistances[i], 1e-5);
+
+  // Inserting points of the wrong dimensionality is an error.
+  BOOST_REQUIRE_THROW(insertLsh.Insert(arma::randu<arma::mat>(3, 10)),
+      std::invalid_argument);
+}
+
+/**
+ * Test: removed points are not returned by a search anymore.
+ */
+BOOST_AUTO_TEST_CASE(RemoveTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 600);
+
+  LSHSearch<> lsh(referenceData, 3, 5, 0.5);
+
+  // Remove every even point.
+  arma::uvec indices(300);
+  for (size_t i = 0; i < 300; ++i)
+    indices[i] = 2 * i;
+  lsh.Remove(indices);
+
+  BOOST_REQUIRE_EQUAL(lsh.BucketContents().n_elem, 5 * 300);
+  BOOST_REQUIRE_EQUAL(lsh.BucketOffsets()[lsh.BucketOffsets().n_elem - 1],
+      5 * 300);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(referenceData, 3, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    // Either no neighbor was found, or it is an odd point.
+    if (neighbors[i] != referenceData.n_cols)
+      BOOST_REQUIRE_EQUAL(neighbors[i] % 2, 1);
+  }
+
+  // The indices of removed points are not reused.
+  lsh.Insert(referenceData.cols(0, 9));
+  BOOST_REQUIRE_EQUAL(lsh.ReferenceSet().n_cols, 610);
+  BOOST_REQUIRE_EQUAL(lsh.BucketContents().n_elem, 5 * 310);
+
+  BOOST_REQUIRE_THROW(lsh.Remove(arma::uvec("610")), std::invalid_argument);
+}
+
 /**
  * Test: this verifies ComputeRecall works correctly by providing two identical
  * vectors and requiring that Recall is equal to 1.
@@ -608,4 +805,117 @@ BOOST_AUTO_TEST_CASE(EmptyConstructorTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+/**
+ * Make sure that an LSH model on a shared reference set uses it without a copy,
+ * keeps it alive, and gives the same results as a model on the matrix.
+ */
+BOOST_AUTO_TEST_CASE(SharedReferenceSetTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 200);
+  std::shared_ptr<const arma::mat> shared(new arma::mat(dataset));
+  const arma::mat* sharedSet = shared.get();
+
+  math::RandomSeed(10);
+  LSHSearch<> lsh(dataset, 4, 3, 3.0, 12, 4);
+  math::RandomSeed(10);
+  LSHSearch<> sharedLSH(shared, 4, 3, 3.0, 12, 4);
+
+  BOOST_REQUIRE_EQUAL(&sharedLSH.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(shared.use_count(), 2);
+  shared.reset();
+
+  arma::Mat<size_t> neighbors, sharedNeighbors;
+  arma::mat distances, sharedDistances;
+  lsh.Search(dataset, 3, neighbors, distances);
+  sharedLSH.Search(dataset, 3, sharedNeighbors, sharedDistances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(sharedNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(sharedDistances[i], distances[i], 1e-5);
+  }
+}
+
+/**
+ * Test: with SimHash, each query (a scaled and slightly rotated copy of a
+ * reference point) finds the reference point it was made from, and the
+ * distances are the Hamming distances between the words of the points.
+ */
+BOOST_AUTO_TEST_CASE(SimHashTest)
+{
+  arma::mat referenceData = arma::randn<arma::mat>(20, 500);
+  arma::mat queryData = 3.0 * referenceData +
+      0.05 * arma::randn<arma::mat>(20, 500);
+
+  math::RandomSeed(3);
+  LSHSearch<NearestNeighborSort, SimHash> lsh(referenceData, 16, 10);
+
+  BOOST_REQUIRE_EQUAL(lsh.Hash().Codes().n_rows, 10);
+  BOOST_REQUIRE_EQUAL(lsh.Hash().Codes().n_cols, 500);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(queryData, 2, neighbors, distances);
+
+  size_t found = 0;
+  for (size_t i = 0; i < queryData.n_cols; ++i)
+  {
+    if (neighbors(0, i) == i)
+      ++found;
+
+    for (size_t j = 0; j < 2; ++j)
+    {
+      if (neighbors(j, i) == referenceData.n_cols)
+        continue;
+
+      BOOST_REQUIRE_EQUAL(distances(j, i), std::floor(distances(j, i)));
+      BOOST_REQUIRE_LE(distances(j, i), 16 * 10);
+    }
+  }
+  BOOST_REQUIRE_GE(found, 495);
+
+  // The bits only depend on the direction of the points.
+  math::RandomSeed(3);
+  LSHSearch<NearestNeighborSort, SimHash> scaledLsh(4.0 * referenceData, 16,
+      10);
+  BOOST_REQUIRE_EQUAL(arma::accu(lsh.Hash().Codes() !=
+      scaledLsh.Hash().Codes()), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(lsh.BucketContents() !=
+      scaledLsh.BucketContents()), 0);
+
+  // The bits of a table must fit in one word.
+  typedef LSHSearch<NearestNeighborSort, SimHash> SimHashLSH;
+  BOOST_REQUIRE_THROW(SimHashLSH(referenceData, 65, 2), std::invalid_argument);
+}
+
+/**
+ * Test: multi-probe search with SimHash looks into more buckets, and the points
+ * inserted after training get their words too.
+ */
+BOOST_AUTO_TEST_CASE(SimHashMultiprobeTest)
+{
+  arma::mat referenceData = arma::randn<arma::mat>(10, 500);
+  arma::mat queryData = referenceData + 0.3 * arma::randn<arma::mat>(10, 500);
+
+  LSHSearch<NearestNeighborSort, SimHash> lsh(referenceData.cols(0, 399), 8,
+      2);
+  lsh.Insert(referenceData.cols(400, 499));
+  BOOST_REQUIRE_EQUAL(lsh.Hash().Codes().n_cols, 500);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(queryData, 1, neighbors, distances);
+  const size_t evaluations = lsh.DistanceEvaluations();
+
+  lsh.DistanceEvaluations() = 0;
+  arma::Mat<size_t> probeNeighbors;
+  arma::mat probeDistances;
+  lsh.Search(queryData, 1, probeNeighbors, probeDistances, 0, 20);
+  BOOST_REQUIRE_GT(lsh.DistanceEvaluations(), evaluations);
+
+  // The extra candidates can only make the best Hamming distances smaller.
+  for (size_t i = 0; i < queryData.n_cols; ++i)
+    BOOST_REQUIRE_LE(probeDistances[i], distances[i]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
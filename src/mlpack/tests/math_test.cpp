@@ -5,6 +5,7 @@
  * Tests for everything in the math:: namespace.
  */
 #include <mlpack/core/math/clamp.hpp>
+#include <mlpack/core/math/presort.hpp>
 #include <mlpack/core/math/random.hpp>
 #include <mlpack/core/math/range.hpp>
 #include <boost/test/unit_test.hpp>
@@ -578,4 +579,181 @@ BOOST_AUTO_TEST_CASE(RangeContainsRange)
   BOOST_REQUIRE_EQUAL(b.Contains(a), true);
 }
 
+/**
+ * Make sure that random numbers drawn in parallel regions are the same for the
+ * same seed (and number of threads).
+ */
+BOOST_AUTO_TEST_CASE(ParallelRandomReproducibleTest)
+{
+  arma::mat draws[2];
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    RandomSeed(17);
+    draws[trial].set_size(3, 1000);
+
+    // Each thread draws a fixed set of columns.
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t i = 0; i < 1000; ++i)
+    {
+      draws[trial](0, i) = Random();
+      draws[trial](1, i) = RandNormal();
+      draws[trial](2, i) = RandInt(1000);
+    }
+  }
+
+  for (size_t i = 0; i < draws[0].n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(draws[0][i], draws[1][i]);
+
+  // The draws are still uniform.
+  BOOST_REQUIRE_GE(arma::min(draws[0].row(0)), 0.0);
+  BOOST_REQUIRE_LT(arma::max(draws[0].row(0)), 1.0);
+  BOOST_REQUIRE_CLOSE(arma::mean(draws[0].row(0)), 0.5, 10.0);
+}
+
+/**
+ * Make sure that random streams depend only on the seed and their index.
+ */
+BOOST_AUTO_TEST_CASE(RandomStreamsTest)
+{
+  RandomSeed(23);
+  const RandomStreams streams1;
+  RandomSeed(23);
+  const RandomStreams streams2;
+
+  arma::Mat<uint32_t> draws(2, 100);
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < 100; ++i)
+  {
+    std::mt19937 generator1 = streams1.Stream(i);
+    std::mt19937 generator2 = streams2.Stream(99 - i);
+    draws(0, i) = generator1();
+    draws(1, 99 - i) = generator2();
+  }
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_REQUIRE_EQUAL(draws(0, i), draws(1, i));
+
+  // Different streams give different numbers.
+  BOOST_REQUIRE_NE(draws(0, 0), draws(0, 1));
+}
+
+/**
+ * Make sure that the random functions draw from the generator of a
+ * RandomGeneratorScope while it is alive, and that the generator of the thread
+ * is left as it was.
+ */
+BOOST_AUTO_TEST_CASE(RandomGeneratorScopeTest)
+{
+  RandomSeed(31);
+  const double expected = Random();
+
+  std::mt19937 expectedGenerator(7);
+  std::uniform_real_distribution<> uniform;
+  const double expectedScoped = uniform(expectedGenerator);
+
+  RandomSeed(31);
+  std::mt19937 generator(7);
+  {
+    const RandomGeneratorScope scope(generator);
+    BOOST_REQUIRE_EQUAL(Random(), expectedScoped);
+  }
+  BOOST_REQUIRE_EQUAL(Random(), expected);
+
+  // The generator of the scope holds the state it was left in.
+  BOOST_REQUIRE(generator == expectedGenerator);
+
+  // The same holds on the threads of a parallel region.
+  arma::Col<uint32_t> scopedDraws(8);
+  arma::uvec restored(8);
+  #pragma omp parallel for
+  for (omp_size_t i = 0; i < 8; ++i)
+  {
+    const std::mt19937 threadGenerator = RandomGenerator();
+    {
+      std::mt19937 taskGenerator(i);
+      const RandomGeneratorScope scope(taskGenerator);
+      scopedDraws[i] = RandomGenerator()();
+    }
+    restored[i] = (RandomGenerator() == threadGenerator);
+  }
+
+  for (size_t i = 0; i < 8; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(scopedDraws[i], std::mt19937(i)());
+    BOOST_REQUIRE_EQUAL(restored[i], 1);
+  }
+}
+
+/**
+ * Make sure that random masks hold only zeros and the given value, with about
+ * the given ratio of zeros, and that they depend only on the seed.
+ */
+BOOST_AUTO_TEST_CASE(RandomMaskTest)
+{
+  // An odd length checks the last element, which is drawn alone.
+  RandomSeed(17);
+  arma::mat mask(100001, 1);
+  RandomMask(mask.memptr(), mask.n_elem, 0.3, 2.5);
+
+  size_t zeros = 0;
+  for (size_t i = 0; i < mask.n_elem; ++i)
+  {
+    BOOST_REQUIRE(mask[i] == 0.0 || mask[i] == 2.5);
+    if (mask[i] == 0.0)
+      ++zeros;
+  }
+  BOOST_REQUIRE_CLOSE((double) zeros / mask.n_elem, 0.3, 2.0);
+
+  RandomSeed(17);
+  arma::mat mask2(100001, 1);
+  RandomMask(mask2.memptr(), mask2.n_elem, 0.3, 2.5);
+  for (size_t i = 0; i < mask.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(mask[i], mask2[i]);
+
+  // The ratio is clamped to [0, 1].
+  arma::fmat floatMask(3, 3);
+  RandomMask(floatMask.memptr(), floatMask.n_elem, 0.0, 1.0);
+  BOOST_REQUIRE_EQUAL(arma::accu(floatMask), 9.0f);
+  RandomMask(floatMask.memptr(), floatMask.n_elem, 1.5, 1.0);
+  BOOST_REQUIRE_EQUAL(arma::accu(floatMask), 0.0f);
+}
+
+/**
+ * Make sure that presorted indices are stably sorted along each dimension, and
+ * stay sorted when they are partitioned.
+ */
+BOOST_AUTO_TEST_CASE(PresortTest)
+{
+  arma::mat data("3 1 2 1 5;"
+                 "0 0 -1 4 2");
+  arma::Mat<size_t> sortedIndices;
+  Presort(data, sortedIndices);
+
+  BOOST_REQUIRE_EQUAL(sortedIndices.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(sortedIndices.n_cols, 2);
+
+  // Ties keep the order of the points.
+  const size_t sorted0[] = { 1, 3, 2, 0, 4 };
+  const size_t sorted1[] = { 2, 0, 1, 4, 3 };
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(sortedIndices(i, 0), sorted0[i]);
+    BOOST_REQUIRE_EQUAL(sortedIndices(i, 1), sorted1[i]);
+  }
+
+  // Partition all but the first row: points 0 and 2 go first.
+  std::vector<char> goesLeft(5, 0);
+  goesLeft[0] = 1;
+  goesLeft[2] = 1;
+  PartitionPresorted(sortedIndices, 1, 5, goesLeft);
+
+  const size_t partitioned0[] = { 1, 2, 0, 3, 4 };
+  const size_t partitioned1[] = { 2, 0, 1, 4, 3 };
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(sortedIndices(i, 0), partitioned0[i]);
+    BOOST_REQUIRE_EQUAL(sortedIndices(i, 1), partitioned1[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
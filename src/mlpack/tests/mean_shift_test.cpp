@@ -143,4 +143,39 @@ BOOST_AUTO_TEST_CASE(GaussianClustering)
       BOOST_REQUIRE_NE(minIndices[i], minIndices[j]);
 }
 
+/**
+ * Make sure that mean shift finds the same clusters with one thread and with
+ * all the threads.
+ */
+BOOST_AUTO_TEST_CASE(MeanShiftParallelTest)
+{
+  GaussianDistribution g1("0.0 0.0", arma::eye<arma::mat>(2, 2));
+  GaussianDistribution g2("8.0 8.0", arma::eye<arma::mat>(2, 2));
+
+  arma::mat dataset(2, 2000);
+  for (size_t i = 0; i < 1000; ++i)
+    dataset.col(i) = g1.Random();
+  for (size_t i = 1000; i < 2000; ++i)
+    dataset.col(i) = g2.Random();
+
+  MeanShift<> meanShift(2.0);
+
+  ThreadPool::SetThreads(1);
+  arma::Col<size_t> assignments;
+  arma::mat centroids;
+  meanShift.Cluster(dataset, assignments, centroids);
+
+  ThreadPool::SetThreads(0);
+  arma::Col<size_t> parallelAssignments;
+  arma::mat parallelCentroids;
+  meanShift.Cluster(dataset, parallelAssignments, parallelCentroids);
+
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(parallelCentroids.n_cols, centroids.n_cols);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(parallelCentroids[i], centroids[i], 1e-8);
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(parallelAssignments[i], assignments[i]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -82,4 +82,133 @@ BOOST_AUTO_TEST_CASE(LINFMetricTest)
                       lMetric.Evaluate(a2, b2), 1e-5);
 }
 
+/**
+ * Make sure the LMetric gives the same results on dense columns (computed with
+ * the blocked loop) as the Armadillo expressions do, for lengths that are and
+ * are not multiples of the block size.
+ */
+template<int Power, typename eT>
+void CheckLMetric(const size_t dim)
+{
+  arma::Mat<eT> data(dim, 2);
+  data.randn();
+  const arma::Col<eT> a = data.col(0);
+  const arma::Col<eT> b = data.col(1);
+
+  eT expected;
+  if (Power == 1)
+    expected = arma::accu(arma::abs(a - b));
+  else if (Power == 2)
+    expected = arma::accu(arma::square(a - b));
+  else if (Power == INT_MAX)
+    expected = arma::as_scalar(arma::max(arma::abs(a - b)));
+  else
+    expected = arma::accu(arma::pow(arma::abs(a - b), (eT) Power));
+
+  const double tolerance = (sizeof(eT) == sizeof(float)) ? 1e-3 : 1e-7;
+  BOOST_REQUIRE_CLOSE((double) LMetric<Power, false>::Evaluate(a, b),
+      (double) expected, tolerance);
+  BOOST_REQUIRE_CLOSE((double) LMetric<Power, false>::Evaluate(data.col(0),
+      data.col(1)), (double) expected, tolerance);
+
+  const eT root = (Power == INT_MAX) ? expected :
+      std::pow(expected, eT(1.0 / Power));
+  BOOST_REQUIRE_CLOSE((double) LMetric<Power, true>::Evaluate(a, b),
+      (double) root, tolerance);
+
+  // With a bound above the distance, the distance is returned.
+  BOOST_REQUIRE_CLOSE((double) LMetric<Power, true>::EvaluateBounded(a, b,
+      2 * root), (double) root, tolerance);
+  BOOST_REQUIRE_CLOSE((double) LMetric<Power, false>::EvaluateBounded(a, b,
+      2 * expected), (double) expected, tolerance);
+
+  // With a bound below the distance, the result may be partial, but it must not
+  // be below the bound or above the distance.
+  const eT bounded = LMetric<Power, true>::EvaluateBounded(a, b, root / 4);
+  BOOST_REQUIRE_GE(bounded, root / 4);
+  BOOST_REQUIRE_LE(bounded, root * (1 + tolerance));
+}
+
+BOOST_AUTO_TEST_CASE(LMetricBlockedEvaluateTest)
+{
+  const size_t dims[] = { 3, 16, 37, 200 };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    CheckLMetric<1, double>(dims[i]);
+    CheckLMetric<2, double>(dims[i]);
+    CheckLMetric<3, double>(dims[i]);
+    CheckLMetric<INT_MAX, double>(dims[i]);
+    CheckLMetric<1, float>(dims[i]);
+    CheckLMetric<2, float>(dims[i]);
+    CheckLMetric<3, float>(dims[i]);
+    CheckLMetric<INT_MAX, float>(dims[i]);
+  }
+}
+
+/**
+ * Make sure a partial distance is returned once the bound is exceeded in a
+ * high-dimensional space.
+ */
+BOOST_AUTO_TEST_CASE(LMetricEarlyExitTest)
+{
+  arma::vec a(1000, arma::fill::zeros);
+  arma::vec b(1000, arma::fill::ones);
+
+  // Each block of 16 dimensions adds 16 to the squared distance.
+  BOOST_REQUIRE_CLOSE(SquaredEuclideanDistance::EvaluateBounded(a, b, 20.0),
+      32.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(EuclideanDistance::EvaluateBounded(a, b, 4.0),
+      std::sqrt(32.0), 1e-5);
+  BOOST_REQUIRE_CLOSE(SquaredEuclideanDistance::EvaluateBounded(a, b, 2000.0),
+      1000.0, 1e-5);
+}
+
+/**
+ * Make sure the distances between sparse columns, computed by merging their
+ * nonzero elements, are the same as the distances between the dense columns.
+ */
+template<int Power>
+void CheckSparseLMetric()
+{
+  arma::sp_mat data;
+  data.sprandu(1000, 4, 0.05);
+  // An empty column.
+  data.col(3).zeros();
+  const arma::mat dense(data);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t j = 0; j < data.n_cols; ++j)
+    {
+      const double expected = LMetric<Power, true>::Evaluate(dense.col(i),
+          dense.col(j));
+      BOOST_REQUIRE_CLOSE(LMetric<Power, true>::Evaluate(data.col(i),
+          data.col(j)) + 1.0, expected + 1.0, 1e-7);
+
+      const arma::sp_vec a(data.col(i));
+      const arma::sp_vec b(data.col(j));
+      BOOST_REQUIRE_CLOSE(LMetric<Power, true>::Evaluate(a, b) + 1.0,
+          expected + 1.0, 1e-7);
+
+      // With a bound below the distance, the result may be partial, but it
+      // must not be below the bound or above the distance.
+      if (expected > 0.0)
+      {
+        const double bounded = LMetric<Power, true>::EvaluateBounded(a, b,
+            expected / 4);
+        BOOST_REQUIRE_GE(bounded, expected / 4);
+        BOOST_REQUIRE_LE(bounded, expected * (1 + 1e-7));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LMetricSparseEvaluateTest)
+{
+  CheckSparseLMetric<1>();
+  CheckSparseLMetric<2>();
+  CheckSparseLMetric<3>();
+  CheckSparseLMetric<INT_MAX>();
+}
+
 BOOST_AUTO_TEST_SUITE_END();
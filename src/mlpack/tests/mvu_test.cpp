@@ -0,0 +1,80 @@
+/**
+ * @file mvu_test.cpp
+ *
+ * Tests for maximum variance unfolding.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/mvu/mvu.hpp>
+#include <mlpack/core/optimizers/sdp/lrsdp.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+using namespace mlpack;
+using namespace mlpack::mvu;
+
+BOOST_AUTO_TEST_SUITE(MVUTest);
+
+/**
+ * Unfold points on a line in three dimensions.  The distances between
+ * consecutive points are held, and the variance is largest when the points are
+ * on a line again, so the unfolded points should be centered and their
+ * distances should be the ones of the original points.
+ */
+BOOST_AUTO_TEST_CASE(MVULineTest)
+{
+  const size_t n = 12;
+  arma::vec direction("1 2 2");
+  direction /= 3.0;
+
+  arma::mat data(3, n);
+  for (size_t i = 0; i < n; ++i)
+    data.col(i) = i * direction;
+
+  MVU mvu(data);
+  arma::mat output;
+  mvu.Unfold(2, 2, output);
+
+  BOOST_REQUIRE_EQUAL(output.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(output.n_cols, n);
+
+  // The unfolded points should be centered.
+  BOOST_REQUIRE_SMALL(arma::norm(arma::mean(output, 1), 2), 0.05);
+
+  // Consecutive points should still be at distance 1, and the points should
+  // be on a line, so that the ends are at distance n - 1.
+  for (size_t i = 0; i + 1 < n; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(arma::norm(output.col(i + 1) - output.col(i), 2), 1.0,
+        2.0);
+  }
+  BOOST_REQUIRE_CLOSE(arma::norm(output.col(n - 1) - output.col(0), 2),
+      (double) (n - 1), 5.0);
+}
+
+/**
+ * Make sure that a rank-one dense constraint given by its factor gives the
+ * same constraint value as the same constraint given as a matrix.
+ */
+BOOST_AUTO_TEST_CASE(LRSDPFactoredDenseConstraintTest)
+{
+  arma::mat coordinates(20, 3, arma::fill::randu);
+  arma::vec factor(20, arma::fill::randn);
+
+  optimization::LRSDPFunction<optimization::SDP<arma::sp_mat>> dense(0, 1,
+      coordinates);
+  dense.SDP().DenseA()[0] = factor * factor.t();
+  dense.SDP().DenseB()[0] = 2.0;
+
+  optimization::LRSDPFunction<optimization::SDP<arma::sp_mat>> factored(0, 0,
+      coordinates);
+  factored.SDP().DenseB().set_size(1);
+  factored.SDP().DenseB()[0] = 2.0;
+  factored.DenseFactors() = factor;
+
+  BOOST_REQUIRE(factored.DenseConstraintsFactored());
+  BOOST_REQUIRE_CLOSE(factored.EvaluateConstraint(0, coordinates),
+      dense.EvaluateConstraint(0, coordinates), 1e-5);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -285,4 +285,95 @@ BOOST_AUTO_TEST_CASE(SeparateTrainIndividualIncrementalTest)
   }
 }
 
+// Train in mini-batches with the incremental algorithm, and make sure the model
+// is the same as when training on the whole dataset at once.
+BOOST_AUTO_TEST_CASE(SeparateTrainMiniBatchIncrementalTest)
+{
+  const char* trainFilename = "trainSet.csv";
+  size_t classes = 2;
+
+  arma::mat trainData;
+  data::Load(trainFilename, trainData, true);
+
+  // Get the labels out.
+  arma::Row<size_t> labels(trainData.n_cols);
+  for (size_t i = 0; i < trainData.n_cols; ++i)
+    labels[i] = trainData(trainData.n_rows - 1, i);
+  trainData.shed_row(trainData.n_rows - 1);
+
+  NaiveBayesClassifier<> nbc(trainData, labels, classes, false);
+  NaiveBayesClassifier<> nbcTrain(trainData.n_rows, classes);
+  for (size_t i = 0; i < trainData.n_cols; i += 7)
+  {
+    const size_t end = std::min((size_t) trainData.n_cols, i + 7) - 1;
+    nbcTrain.Train(trainData.cols(i, end), labels.subvec(i, end), true);
+  }
+
+  for (size_t i = 0; i < nbc.Means().n_elem; ++i)
+  {
+    if (std::abs(nbc.Means()[i]) < 1e-5)
+      BOOST_REQUIRE_SMALL(nbcTrain.Means()[i], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(nbc.Means()[i], nbcTrain.Means()[i], 1e-5);
+  }
+
+  for (size_t i = 0; i < nbc.Variances().n_elem; ++i)
+  {
+    if (std::abs(nbc.Variances()[i]) < 1e-5)
+      BOOST_REQUIRE_SMALL(nbcTrain.Variances()[i], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(nbc.Variances()[i], nbcTrain.Variances()[i], 1e-5);
+  }
+
+  for (size_t i = 0; i < nbc.Probabilities().n_elem; ++i)
+  {
+    if (std::abs(nbc.Probabilities()[i]) < 1e-5)
+      BOOST_REQUIRE_SMALL(nbcTrain.Probabilities()[i], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(nbc.Probabilities()[i], nbcTrain.Probabilities()[i],
+          1e-5);
+  }
+}
+
+// Make sure the classification of many points (in several blocks) gives the
+// class with the largest log-likelihood.
+BOOST_AUTO_TEST_CASE(ClassifyLogLikelihoodTest)
+{
+  const size_t classes = 4;
+  arma::mat data(6, 2000);
+  data.randn();
+  arma::Row<size_t> labels(2000);
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    labels[i] = i % classes;
+    data.col(i) += 2.0 * labels[i];
+  }
+
+  NaiveBayesClassifier<> nbc(data, labels, classes);
+
+  arma::mat testData(6, 3000);
+  testData.randn();
+  testData *= 4.0;
+
+  arma::Row<size_t> results;
+  nbc.Classify(testData, results);
+  BOOST_REQUIRE_EQUAL(results.n_elem, testData.n_cols);
+
+  for (size_t j = 0; j < testData.n_cols; ++j)
+  {
+    arma::vec logLikelihoods(classes);
+    for (size_t c = 0; c < classes; ++c)
+    {
+      logLikelihoods[c] = std::log(nbc.Probabilities()[c]) -
+          0.5 * arma::accu(arma::log(nbc.Variances().col(c))) -
+          0.5 * arma::accu(arma::square(testData.col(j) - nbc.Means().col(c)) /
+          nbc.Variances().col(c));
+    }
+
+    arma::uword maxIndex;
+    logLikelihoods.max(maxIndex);
+    BOOST_REQUIRE_EQUAL(results[j], (size_t) maxIndex);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
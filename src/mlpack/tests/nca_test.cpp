@@ -318,4 +318,134 @@ BOOST_AUTO_TEST_CASE(NCALBFGSSimpleDataset)
 
 }
 
+/**
+ * Make sure that the batch objective and gradient are the sums of the
+ * separable objectives and gradients of the points of the batch.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxBatchObjectiveAndGradient)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 40);
+  arma::Row<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+    labels[i] = (data(0, i) > 0.5) ? 1 : 0;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  const arma::mat coordinates = arma::randu<arma::mat>(3, 3);
+
+  for (size_t begin = 0; begin < 40; begin += 15)
+  {
+    const size_t batchSize = std::min((size_t) 15, 40 - begin);
+
+    double objective = 0.0;
+    arma::mat gradient = arma::zeros<arma::mat>(3, 3), pointGradient;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      objective += sef.Evaluate(coordinates, i);
+      sef.Gradient(coordinates, i, pointGradient);
+      gradient += pointGradient;
+    }
+
+    arma::mat batchGradient;
+    sef.Gradient(coordinates, begin, batchGradient, batchSize);
+
+    BOOST_REQUIRE_CLOSE(sef.Evaluate(coordinates, begin, batchSize, true),
+        objective, 1e-8);
+    for (size_t i = 0; i < 9; ++i)
+    {
+      if (std::abs(gradient[i]) < 1e-10)
+        BOOST_REQUIRE_SMALL(batchGradient[i], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(batchGradient[i], gradient[i], 1e-6);
+    }
+  }
+}
+
+/**
+ * When every other point is a neighbor, the truncated objective and gradient
+ * should be the same as the full ones.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxTruncatedAllNeighbors)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 40);
+  arma::Row<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+    labels[i] = (data(0, i) > 0.5) ? 1 : 0;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  SoftmaxErrorFunction<SquaredEuclideanDistance> truncated(data, labels, 39);
+  const arma::mat coordinates = arma::randu<arma::mat>(3, 3);
+
+  BOOST_REQUIRE_CLOSE(truncated.Evaluate(coordinates),
+      sef.Evaluate(coordinates), 1e-8);
+  for (size_t i = 0; i < 40; i += 7)
+  {
+    BOOST_REQUIRE_CLOSE(truncated.Evaluate(coordinates, i),
+        sef.Evaluate(coordinates, i), 1e-8);
+  }
+
+  arma::mat gradient, truncatedGradient;
+  sef.Gradient(coordinates, gradient);
+  truncated.Gradient(coordinates, truncatedGradient);
+  for (size_t i = 0; i < 9; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(truncatedGradient[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(truncatedGradient[i], gradient[i], 1e-6);
+  }
+}
+
+/**
+ * Make sure that the truncated gradient is the sum of the truncated separable
+ * gradients, and that it matches finite differences of the truncated objective
+ * while the neighborhoods are not refreshed.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxTruncatedGradient)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 300);
+  arma::Row<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+    labels[i] = (data(0, i) > 0.5) ? 1 : 0;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels, 10, 1000);
+  const arma::mat coordinates = arma::eye<arma::mat>(3, 3) +
+      0.1 * arma::randu<arma::mat>(3, 3);
+
+  arma::mat gradient;
+  sef.Gradient(coordinates, gradient);
+
+  double objective = 0.0;
+  arma::mat sum = arma::zeros<arma::mat>(3, 3), pointGradient;
+  for (size_t i = 0; i < 300; ++i)
+  {
+    objective += sef.Evaluate(coordinates, i);
+    sef.Gradient(coordinates, i, pointGradient);
+    sum += pointGradient;
+  }
+
+  BOOST_REQUIRE_CLOSE(sef.Evaluate(coordinates), objective, 1e-8);
+  for (size_t i = 0; i < 9; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sum[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(sum[i], gradient[i], 1e-6);
+  }
+
+  const double epsilon = 1e-5;
+  for (size_t i = 0; i < 9; ++i)
+  {
+    arma::mat plus = coordinates, minus = coordinates;
+    plus[i] += epsilon;
+    minus[i] -= epsilon;
+    const double numGradient = (sef.Evaluate(plus) - sef.Evaluate(minus)) /
+        (2 * epsilon);
+
+    if (std::abs(gradient[i]) < 1e-5)
+      BOOST_REQUIRE_SMALL(numGradient, 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(numGradient, gradient[i], 1e-3);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -211,4 +211,123 @@ BOOST_AUTO_TEST_CASE(SparseNMFALSTest)
       1e-5);
 }
 
+// Check that the two matrices are equal, up to rounding.
+static void CheckRelativeError(const mat& a, const mat& b)
+{
+  BOOST_REQUIRE_SMALL(arma::norm(a - b, "fro") / arma::norm(b, "fro"), 1e-10);
+}
+
+/**
+ * Make sure that the blocked update rules give the same result as the update
+ * formulas applied to the whole matrices, for matrices with several blocks of
+ * rows and columns, and for both dense and sparse input matrices.
+ */
+BOOST_AUTO_TEST_CASE(NMFBlockedUpdateTest)
+{
+  const mat v = randu<mat>(600, 300) + 0.1;
+  sp_mat sv;
+  sv.sprandu(600, 300, 0.1);
+  const mat dsv(sv);
+  const mat w = randu<mat>(600, 5) + 0.1;
+  const mat h = randu<mat>(5, 300) + 0.1;
+
+  // Distance update rules.
+  mat w2 = w, h2 = h;
+  NMFMultiplicativeDistanceUpdate::WUpdate(v, w2, h);
+  NMFMultiplicativeDistanceUpdate::HUpdate(v, w, h2);
+  CheckRelativeError(w2, (w % (v * h.t())) / (w * h * h.t()));
+  CheckRelativeError(h2, (h % (w.t() * v)) / (w.t() * w * h));
+
+  w2 = w;
+  h2 = h;
+  NMFMultiplicativeDistanceUpdate::WUpdate(sv, w2, h);
+  NMFMultiplicativeDistanceUpdate::HUpdate(sv, w, h2);
+  mat w3 = w, h3 = h;
+  NMFMultiplicativeDistanceUpdate::WUpdate(dsv, w3, h);
+  NMFMultiplicativeDistanceUpdate::HUpdate(dsv, w, h3);
+  CheckRelativeError(w2, w3);
+  CheckRelativeError(h2, h3);
+
+  // Alternating least squares update rules.
+  NMFALSUpdate::WUpdate(v, w2, h);
+  NMFALSUpdate::HUpdate(v, w, h2);
+  mat wExpected = v * h.t() * pinv(h * h.t());
+  wExpected.elem(find(wExpected < 0.0)).zeros();
+  mat hExpected = pinv(w.t() * w) * w.t() * v;
+  hExpected.elem(find(hExpected < 0.0)).zeros();
+  CheckRelativeError(w2, wExpected);
+  CheckRelativeError(h2, hExpected);
+
+  NMFALSUpdate::WUpdate(sv, w2, h);
+  NMFALSUpdate::HUpdate(sv, w, h2);
+  NMFALSUpdate::WUpdate(dsv, w3, h);
+  NMFALSUpdate::HUpdate(dsv, w, h3);
+  CheckRelativeError(w2, w3);
+  CheckRelativeError(h2, h3);
+
+  // Divergence update rules.
+  w2 = w;
+  h2 = h;
+  NMFMultiplicativeDivergenceUpdate::WUpdate(v, w2, h);
+  NMFMultiplicativeDivergenceUpdate::HUpdate(v, w, h2);
+  const mat ratio = v / (w * h);
+  wExpected = w % (ratio * h.t());
+  wExpected.each_row() /= trans(sum(h, 1));
+  hExpected = h % (w.t() * ratio);
+  hExpected.each_col() /= trans(sum(w, 0));
+  CheckRelativeError(w2, wExpected);
+  CheckRelativeError(h2, hExpected);
+}
+
+/**
+ * Make sure that the residue of SimpleResidueTermination, which is computed
+ * from the Gram matrix of W, matches the residue computed from WH, and that
+ * the residue is only checked at the given interval.
+ */
+BOOST_AUTO_TEST_CASE(SimpleResidueTerminationTest)
+{
+  mat w = randu<mat>(30, 5);
+  mat h = randu<mat>(5, 40);
+  mat h2 = randu<mat>(5, 40);
+  mat v = w * h;
+
+  double norm = 0.0, norm2 = 0.0;
+  for (size_t j = 0; j < h.n_cols; ++j)
+  {
+    norm += arma::norm(w * h.col(j), 2);
+    norm2 += arma::norm(w * h2.col(j), 2);
+  }
+
+  SimpleResidueTermination srt(1e-5, 100);
+  srt.Initialize(v);
+  srt.IsConverged(w, h);
+  BOOST_REQUIRE_EQUAL(srt.IsConverged(w, h2), false);
+  BOOST_REQUIRE_CLOSE(srt.Index(), fabs(norm - norm2) / norm, 1e-8);
+
+  // With an interval of 3, the residue is checked after iterations 3 and 6.
+  SimpleResidueTermination intervalSrt(1e-5, 100, 3);
+  intervalSrt.Initialize(v);
+  intervalSrt.IsConverged(w, h);
+  intervalSrt.IsConverged(w, h);
+  intervalSrt.IsConverged(w, h);
+  intervalSrt.IsConverged(w, h2);
+  intervalSrt.IsConverged(w, h2);
+  BOOST_REQUIRE_EQUAL(intervalSrt.IsConverged(w, h2), false);
+  BOOST_REQUIRE_CLOSE(intervalSrt.Index(), fabs(norm - norm2) / norm, 1e-8);
+  BOOST_REQUIRE_EQUAL(intervalSrt.IsConverged(w, h2), false);
+  BOOST_REQUIRE_EQUAL(intervalSrt.IsConverged(w, h2), false);
+  BOOST_REQUIRE_EQUAL(intervalSrt.IsConverged(w, h2), true);
+
+  BOOST_REQUIRE_THROW(SimpleResidueTermination(1e-5, 100, 0),
+      std::invalid_argument);
+
+  // The factorization still converges when the residue is checked rarely.
+  SimpleResidueTermination nmfSrt(1e-7, 10000, 10);
+  AMF<SimpleResidueTermination, RandomAcolInitialization<> > nmf(nmfSrt);
+  mat wOut, hOut;
+  nmf.Apply(v, 5, wOut, hOut);
+  BOOST_REQUIRE_SMALL(arma::norm(v - wOut * hOut, "fro") /
+      arma::norm(v, "fro"), 0.05);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
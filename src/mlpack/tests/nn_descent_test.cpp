@@ -0,0 +1,139 @@
+/**
+ * @file nn_descent_test.cpp
+ *
+ * Unit tests for the 'NNDescent' class.
+ */
+#include <mlpack/core.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+#include <mlpack/methods/nn_descent/nn_descent.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(NNDescentTest);
+
+//! Compute the fraction of the true neighbors that were found.
+static double Recall(const arma::Mat<size_t>& neighbors,
+                     const arma::Mat<size_t>& trueNeighbors)
+{
+  size_t found = 0;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+      for (size_t l = 0; l < trueNeighbors.n_rows; ++l)
+        if (neighbors(j, i) == trueNeighbors(l, i))
+          ++found;
+
+  return double(found) / trueNeighbors.n_elem;
+}
+
+/**
+ * Make sure that the graph has the format of the results of NeighborSearch,
+ * and that it finds almost all of the true neighbors of high-dimensional data.
+ */
+BOOST_AUTO_TEST_CASE(RecallTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(40, 1500);
+
+  NNDescent nnd;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  nnd.Build(dataset, 10, neighbors, distances);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, 1500);
+  BOOST_REQUIRE_EQUAL(distances.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(distances.n_cols, 1500);
+
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      BOOST_REQUIRE_NE(neighbors(j, i), i);
+      BOOST_REQUIRE_CLOSE(distances(j, i), arma::norm(dataset.col(i) -
+          dataset.col(neighbors(j, i))), 1e-5);
+      if (j > 0)
+        BOOST_REQUIRE_LE(distances(j - 1, i), distances(j, i));
+    }
+  }
+
+  KNN knn(dataset);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(10, trueNeighbors, trueDistances);
+
+  BOOST_REQUIRE_GE(Recall(neighbors, trueNeighbors), 0.9);
+
+  // The graph was refined with fewer distances than a linear scan.
+  BOOST_REQUIRE_LT(nnd.DistanceEvaluations(), 1500 * 1499 / 2);
+}
+
+/**
+ * Make sure that seeding the graph with LSHSearch works.
+ */
+BOOST_AUTO_TEST_CASE(LSHSeedTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(20, 1000);
+
+  NNDescent nnd(20, 0.5, 0.001, 5, 5);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  nnd.Build(dataset, 5, neighbors, distances);
+
+  KNN knn(dataset);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(5, trueNeighbors, trueDistances);
+
+  BOOST_REQUIRE_LT(neighbors.max(), 1000);
+  BOOST_REQUIRE_GE(Recall(neighbors, trueNeighbors), 0.9);
+}
+
+/**
+ * Make sure that the graph doesn't depend on the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ThreadIndependenceTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(10, 3000);
+
+  const size_t oldThreads = ThreadPool::Threads();
+  NNDescent nnd;
+  arma::Mat<size_t> neighbors, serialNeighbors;
+  arma::mat distances, serialDistances;
+
+  math::RandomSeed(10);
+  nnd.Build(dataset, 8, neighbors, distances);
+
+  ThreadPool::SetThreads(1);
+  math::RandomSeed(10);
+  nnd.Build(dataset, 8, serialNeighbors, serialDistances);
+  ThreadPool::SetThreads(oldThreads);
+
+  BOOST_REQUIRE_EQUAL(arma::accu(neighbors != serialNeighbors), 0);
+  BOOST_REQUIRE_SMALL(arma::abs(distances - serialDistances).max(), 1e-10);
+}
+
+/**
+ * Make sure that invalid parameters are rejected.
+ */
+BOOST_AUTO_TEST_CASE(InvalidParametersTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 10);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  NNDescent nnd;
+  BOOST_REQUIRE_THROW(nnd.Build(dataset, 0, neighbors, distances),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(nnd.Build(dataset, 10, neighbors, distances),
+      std::invalid_argument);
+
+  nnd.SampleRate() = 0.0;
+  BOOST_REQUIRE_THROW(nnd.Build(dataset, 3, neighbors, distances),
+      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -180,4 +180,70 @@ BOOST_AUTO_TEST_CASE(GermanTest)
   }
 }
 
+/**
+ * Make sure that the Nystroem method gives the same approximation with a kernel
+ * cache as without, and that the selected columns end up in the cache.
+ */
+BOOST_AUTO_TEST_CASE(KernelCacheTest)
+{
+  arma::mat data;
+  data.randu(5, 100);
+  GaussianKernel gk(1.5);
+
+  NystroemMethod<GaussianKernel, OrderedSelection> nm(data, gk, 20);
+  arma::mat g;
+  nm.Apply(g);
+
+  KernelCache<GaussianKernel> cache(data, gk);
+  NystroemMethod<GaussianKernel, OrderedSelection> cachedNm(cache, 20);
+  arma::mat cachedG;
+  cachedNm.Apply(cachedG);
+
+  BOOST_REQUIRE_EQUAL(cache.CachedColumns(), 20);
+  BOOST_REQUIRE_EQUAL(cachedG.n_rows, g.n_rows);
+  BOOST_REQUIRE_EQUAL(cachedG.n_cols, g.n_cols);
+  for (size_t i = 0; i < g.n_elem; ++i)
+  {
+    if (std::abs(g[i]) < 1e-5)
+      BOOST_REQUIRE_SMALL(cachedG[i], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(cachedG[i], g[i], 1e-5);
+  }
+
+  // A second run takes every column from the cache.
+  cachedNm.Apply(cachedG);
+  BOOST_REQUIRE_EQUAL(cache.Hits(), 20);
+  BOOST_REQUIRE_EQUAL(cache.Misses(), 20);
+}
+
+/**
+ * Make sure that a rank-3 linear kernel matrix is recovered exactly with the
+ * k-means landmark selections, on enough points that the kernel matrix is
+ * built in several blocks.
+ */
+BOOST_AUTO_TEST_CASE(KMeansSelectionVariantsTest)
+{
+  arma::mat data;
+  data.randn(3, 2500);
+  const arma::mat kernel = data.t() * data;
+
+  LinearKernel lk;
+  arma::mat g;
+
+  NystroemMethod<LinearKernel, OrderedSelection> nm(data, lk, 3);
+  nm.Apply(g);
+  BOOST_REQUIRE_SMALL(arma::norm(kernel - g * g.t(), "fro") /
+      arma::norm(kernel, "fro"), 1e-5);
+
+  NystroemMethod<LinearKernel, HamerlyKMeansSelection<> > hnm(data, lk, 3);
+  hnm.Apply(g);
+  BOOST_REQUIRE_SMALL(arma::norm(kernel - g * g.t(), "fro") /
+      arma::norm(kernel, "fro"), 1e-5);
+
+  NystroemMethod<LinearKernel, MiniBatchKMeansSelection<> > mnm(data, lk, 3);
+  mnm.Apply(g);
+  BOOST_REQUIRE_SMALL(arma::norm(kernel - g * g.t(), "fro") /
+      arma::norm(kernel, "fro"), 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
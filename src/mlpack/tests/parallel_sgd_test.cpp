@@ -0,0 +1,107 @@
+/**
+ * @file parallel_sgd_test.cpp
+ *
+ * Test file for ParallelSGD (lock-free parallel stochastic gradient descent).
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression_function.hpp>
+#include <mlpack/methods/regularized_svd/regularized_svd_function.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+using namespace mlpack;
+using namespace mlpack::optimization;
+using namespace mlpack::regression;
+using namespace mlpack::svd;
+
+BOOST_AUTO_TEST_SUITE(ParallelSGDTest);
+
+/**
+ * Make sure that the sparse gradient hook is detected.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSGDSparseGradientTest)
+{
+  BOOST_REQUIRE_EQUAL(HasSparseGradient<RegularizedSVDFunction>::value, true);
+  BOOST_REQUIRE_EQUAL(
+      HasSparseGradient<LogisticRegressionFunction<>>::value, false);
+}
+
+/**
+ * Train logistic regression (with dense gradients) on two well-separated
+ * Gaussians, and make sure that the points are classified correctly.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSGDLogisticRegressionTest)
+{
+  const size_t points = 1000;
+
+  arma::mat data(3, points);
+  arma::Row<size_t> responses(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    responses[i] = (i < points / 2) ? 0 : 1;
+    data.col(i) = arma::randn<arma::vec>(3) + ((responses[i] == 0) ? 1.0 :
+        6.0);
+  }
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.001);
+  ParallelSGD<LogisticRegressionFunction<>> sgd(lrf, 0.005, 100, 1e-10);
+
+  arma::mat parameters = lrf.GetInitialPoint();
+  sgd.Optimize(parameters);
+
+  const arma::rowvec sigmoids = 1 / (1 + arma::exp(-parameters[0] -
+      arma::trans(parameters.rows(1, 3)) * data));
+
+  size_t correct = 0;
+  for (size_t i = 0; i < points; ++i)
+    if ((sigmoids[i] > 0.5) == (responses[i] == 1))
+      ++correct;
+
+  BOOST_REQUIRE_GE(correct, 0.97 * points);
+}
+
+/**
+ * Learn a low-rank rating matrix with regularized SVD (with sparse gradients),
+ * and make sure that the ratings are predicted well.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSGDRegularizedSVDTest)
+{
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 100;
+  const size_t rank = 10;
+
+  // Make a random rating dataset from random parameters.
+  const arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    data(2, i) = arma::dot(parameters.col(data(0, i)),
+                           parameters.col(numUsers + data(1, i)));
+  }
+
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.01);
+  ParallelSGD<RegularizedSVDFunction> optimizer(rSVDFunc, 0.01, 30);
+
+  arma::mat optParameters = arma::randu(rank, numUsers + numItems);
+  optimizer.Optimize(optParameters);
+
+  arma::rowvec predictedData(numRatings);
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    predictedData[i] = arma::dot(optParameters.col(data(0, i)),
+                                 optParameters.col(numUsers + data(1, i)));
+  }
+
+  const double relativeError = arma::norm(data.row(2) - predictedData, "frob")
+      / arma::norm(data, "frob");
+  BOOST_REQUIRE_SMALL(relativeError, 1e-2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
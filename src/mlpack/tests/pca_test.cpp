@@ -6,9 +6,14 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/pca/pca.hpp>
+#include <mlpack/methods/pca/decomposition_policies/randomized_svd_method.hpp>
+#include <mlpack/methods/pca/decomposition_policies/quic_svd_method.hpp>
+#include <mlpack/methods/pca/decomposition_policies/exact_eig_method.hpp>
+#include <mlpack/methods/pca/incremental_pca.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
+#include "serialization.hpp"
 
 BOOST_AUTO_TEST_SUITE(PCATest);
 
@@ -198,4 +203,206 @@ BOOST_AUTO_TEST_CASE(PCAScalingTest)
 }
 
 
+/**
+ * Reducing the dimensionality of data of low rank with the randomized SVD
+ * should give the same eigenvalues and retained variance as the exact SVD.
+ */
+BOOST_AUTO_TEST_CASE(PCARandomizedSVDTest)
+{
+  // The data has 5 dimensions with a large variance and 45 with a small one.
+  mat data = randn<mat>(50, 1000);
+  data.rows(0, 4) *= 10.0;
+
+  mat exactData(data), randomizedData(data);
+  PCA exact;
+  PCAType<RandomizedSVDPolicy> randomized;
+  const double exactVar = exact.Apply(exactData, 5);
+  const double randomizedVar = randomized.Apply(randomizedData, 5);
+
+  BOOST_REQUIRE_EQUAL(randomizedData.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(randomizedData.n_cols, 1000);
+  BOOST_REQUIRE_CLOSE(randomizedVar, exactVar, 1.0);
+
+  // The projections are the same, up to the sign of each component.
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const double sign = (dot(exactData.row(i), randomizedData.row(i)) < 0) ?
+        -1.0 : 1.0;
+    BOOST_REQUIRE_SMALL(norm(exactData.row(i) - sign *
+        randomizedData.row(i)) / norm(exactData.row(i)), 0.05);
+  }
+}
+
+/**
+ * Make sure that the QUIC-SVD policy returns the largest eigenvalues in
+ * descending order.
+ */
+BOOST_AUTO_TEST_CASE(PCAQUICSVDTest)
+{
+  mat data = randn<mat>(10, 1000);
+  data.row(0) *= 10.0;
+  data.row(1) *= 5.0;
+
+  PCAType<QUICSVDPolicy> p;
+  mat transData;
+  vec eigval;
+  p.Apply(data, transData, eigval);
+
+  for (size_t i = 1; i < eigval.n_elem; ++i)
+    BOOST_REQUIRE_GE(eigval[i - 1], eigval[i]);
+  BOOST_REQUIRE_CLOSE(eigval[0], 100.0, 15.0);
+  BOOST_REQUIRE_CLOSE(eigval[1], 25.0, 15.0);
+}
+
+/**
+ * Make sure that the eigendecomposition of the covariance gives the same
+ * principal components as the SVD of the data, and that the data can be
+ * transformed in place.
+ */
+BOOST_AUTO_TEST_CASE(PCAExactEigTest)
+{
+  mat data = randn<mat>(8, 5000);
+  data.row(0) *= 10.0;
+  data.row(1) *= 5.0;
+  data.row(2) += 3.0;
+
+  PCA exact;
+  PCAType<ExactEigPolicy> eig;
+  mat exactData, eigData(data), exactCoeff, eigCoeff;
+  vec exactEigval, eigEigval;
+  exact.Apply(data, exactData, exactEigval, exactCoeff);
+  eig.Apply(eigData, eigData, eigEigval, eigCoeff);
+
+  BOOST_REQUIRE_EQUAL(eigEigval.n_elem, exactEigval.n_elem);
+  for (size_t i = 0; i < eigEigval.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(eigEigval[i], exactEigval[i], 1e-5);
+
+  // The projections are the same, up to the sign of each component.
+  for (size_t i = 0; i < data.n_rows; ++i)
+  {
+    const double sign = (dot(exactData.row(i), eigData.row(i)) < 0) ? -1.0 :
+        1.0;
+    for (size_t j = 0; j < data.n_cols; ++j)
+      BOOST_REQUIRE_SMALL(exactData(i, j) - sign * eigData(i, j), 1e-5);
+  }
+}
+
+/**
+ * Make sure that incremental PCA without truncation gives the same principal
+ * components as PCA on all of the points.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalPCAExactTest)
+{
+  mat data = randn<mat>(6, 1000);
+  data.row(0) *= 10.0;
+  data.row(1) *= 5.0;
+  data.row(2) += 3.0;
+
+  IncrementalPCA ipca;
+  for (size_t i = 0; i < 1000; i += 150)
+    ipca.Update(data.cols(i, std::min((size_t) 999, i + 149)));
+
+  BOOST_REQUIRE_EQUAL(ipca.NumPoints(), 1000);
+  const vec expectedMean = arma::mean(data, 1);
+  for (size_t i = 0; i < 6; ++i)
+    BOOST_REQUIRE_CLOSE(ipca.Mean()[i], expectedMean[i], 1e-5);
+
+  PCA exact;
+  mat exactData;
+  vec exactEigval;
+  exact.Apply(data, exactData, exactEigval);
+
+  const vec eigval = ipca.Eigenvalues();
+  BOOST_REQUIRE_EQUAL(eigval.n_elem, exactEigval.n_elem);
+  for (size_t i = 0; i < eigval.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(eigval[i], exactEigval[i], 1e-5);
+  BOOST_REQUIRE_CLOSE(ipca.VarianceRetained(), 1.0, 1e-5);
+
+  // The projections are the same, up to the sign of each component.
+  mat transformed;
+  ipca.Transform(data, transformed);
+  for (size_t i = 0; i < data.n_rows; ++i)
+  {
+    const double sign = (dot(exactData.row(i), transformed.row(i)) < 0) ?
+        -1.0 : 1.0;
+    for (size_t j = 0; j < data.n_cols; ++j)
+      BOOST_REQUIRE_SMALL(exactData(i, j) - sign * transformed(i, j), 1e-5);
+  }
+}
+
+/**
+ * Make sure that incremental PCA finds the leading components of data which
+ * lies close to a low-dimensional subspace, while keeping only those.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalPCALowRankTest)
+{
+  const mat subspace = orth(randn<mat>(20, 3));
+  mat coordinates = randn<mat>(3, 2000);
+  coordinates.row(0) *= 10.0;
+  coordinates.row(1) *= 5.0;
+  coordinates.row(2) *= 2.0;
+  const mat data = subspace * coordinates + 0.01 * randn<mat>(20, 2000);
+
+  IncrementalPCA ipca(3);
+  for (size_t i = 0; i < 2000; i += 50)
+    ipca.Update(data.cols(i, i + 49));
+
+  BOOST_REQUIRE_EQUAL(ipca.Basis().n_rows, 20);
+  BOOST_REQUIRE_EQUAL(ipca.Basis().n_cols, 3);
+  BOOST_REQUIRE_GT(ipca.VarianceRetained(), 0.999);
+
+  PCA exact;
+  mat exactData(data);
+  vec exactEigval;
+  exact.Apply(data, exactData, exactEigval);
+  const vec eigval = ipca.Eigenvalues();
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(eigval[i], exactEigval[i], 0.1);
+
+  // The basis spans the subspace.
+  const mat residual = subspace - ipca.Basis() * (ipca.Basis().t() * subspace);
+  BOOST_REQUIRE_SMALL(norm(residual, "fro"), 1e-2);
+
+  // Points of another dimensionality are rejected.
+  BOOST_REQUIRE_THROW(ipca.Update(randn<mat>(19, 10)), std::invalid_argument);
+  mat transformed;
+  BOOST_REQUIRE_THROW(ipca.Transform(randn<mat>(21, 10), transformed),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that a serialized incremental PCA model can be updated further
+ * after it is loaded.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalPCASerializationTest)
+{
+  const mat data = randn<mat>(5, 300);
+
+  IncrementalPCA ipca(4);
+  ipca.Update(data.cols(0, 199));
+
+  IncrementalPCA xmlIpca(2), textIpca, binaryIpca(1);
+  xmlIpca.Update(randn<mat>(3, 10));
+  SerializeObjectAll(ipca, xmlIpca, textIpca, binaryIpca);
+
+  BOOST_REQUIRE_EQUAL(xmlIpca.Rank(), 4);
+  BOOST_REQUIRE_EQUAL(textIpca.Rank(), 4);
+  BOOST_REQUIRE_EQUAL(binaryIpca.Rank(), 4);
+
+  ipca.Update(data.cols(200, 299));
+  xmlIpca.Update(data.cols(200, 299));
+  textIpca.Update(data.cols(200, 299));
+  binaryIpca.Update(data.cols(200, 299));
+
+  BOOST_REQUIRE_EQUAL(xmlIpca.NumPoints(), 300);
+  CheckMatrices(ipca.Basis(), xmlIpca.Basis(), textIpca.Basis(),
+      binaryIpca.Basis());
+  CheckMatrices(ipca.Mean(), xmlIpca.Mean(), textIpca.Mean(),
+      binaryIpca.Mean());
+  CheckMatrices(ipca.SingularValues(), xmlIpca.SingularValues(),
+      textIpca.SingularValues(), binaryIpca.SingularValues());
+  BOOST_REQUIRE_CLOSE(ipca.VarianceRetained(), xmlIpca.VarianceRetained(),
+      1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
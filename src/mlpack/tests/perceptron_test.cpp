@@ -166,4 +166,68 @@ BOOST_AUTO_TEST_CASE(SecondaryConstructor)
   Perceptron<> p2(p1);
 }
 
+/**
+ * Make sure that mini-batch training with batches of one point gives the same
+ * weights as training with the simple update rule.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchSizeOne)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> p(trainData, labels.row(0), 3, 1000);
+
+  Perceptron<MiniBatchWeightUpdate> mbp(3, trainData.n_rows, 1000);
+  mbp.Policy().BatchSize() = 1;
+  mbp.Train(trainData, labels.row(0));
+
+  BOOST_REQUIRE_SMALL(abs(p.Weights() - mbp.Weights()).max(), 1e-10);
+  BOOST_REQUIRE_SMALL(abs(p.Biases() - mbp.Biases()).max(), 1e-10);
+}
+
+/**
+ * Make sure that mini-batch training separates three well-separated Gaussians,
+ * and that the classification of many points (in several blocks) matches the
+ * classification of each point on its own.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchGaussians)
+{
+  const size_t points = 3000;
+  mat trainData = randn<mat>(2, points);
+  Row<size_t> labels(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    labels[i] = i % 3;
+    if (labels[i] == 1)
+      trainData(0, i) += 20.0;
+    else if (labels[i] == 2)
+      trainData(1, i) += 20.0;
+  }
+
+  Perceptron<MiniBatchWeightUpdate> p(3, 2, 1000);
+  p.Policy().BatchSize() = 100;
+  p.Train(trainData, labels);
+
+  Row<size_t> predictedLabels;
+  p.Classify(trainData, predictedLabels);
+  BOOST_REQUIRE_EQUAL(predictedLabels.n_elem, points);
+
+  size_t correct = 0;
+  for (size_t i = 0; i < points; ++i)
+  {
+    if (predictedLabels[i] == labels[i])
+      ++correct;
+
+    Row<size_t> pointLabel;
+    p.Classify(trainData.col(i), pointLabel);
+    BOOST_REQUIRE_EQUAL(pointLabel[0], predictedLabels[i]);
+  }
+
+  BOOST_REQUIRE_GE(correct, 0.99 * points);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -72,4 +72,94 @@ BOOST_AUTO_TEST_CASE(MeanPoolingTest)
   BOOST_REQUIRE_EQUAL(b, true);
 }
 
+/**
+ * Make sure that the whole-map max pooling gives the maximum of each block, and
+ * that the unpooling passes the error of each block to its maximum only.
+ */
+BOOST_AUTO_TEST_CASE(MaxPoolingMapTest)
+{
+  arma::cube input = arma::randu<arma::cube>(7, 6, 3);
+  arma::cube output, error, unpooled;
+
+  MaxPooling poolingRule;
+  poolingRule.Pooling(input, 2, output);
+
+  BOOST_REQUIRE_EQUAL(output.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(output.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(output.n_slices, 3);
+
+  error = arma::randu<arma::cube>(3, 3, 3);
+  unpooled.zeros(7, 6, 3);
+  poolingRule.Unpooling(error, 2, unpooled);
+
+  for (size_t s = 0; s < 3; ++s)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        const arma::mat block = input.slice(s)(arma::span(2 * i, 2 * i + 1),
+            arma::span(2 * j, 2 * j + 1));
+        const arma::mat unpooledBlock = unpooled.slice(s)(
+            arma::span(2 * i, 2 * i + 1), arma::span(2 * j, 2 * j + 1));
+
+        BOOST_REQUIRE_EQUAL(output(i, j, s), block.max());
+
+        arma::uword maxIndex;
+        block.max(maxIndex);
+        for (size_t k = 0; k < 4; ++k)
+        {
+          BOOST_REQUIRE_EQUAL(unpooledBlock[k],
+              (k == maxIndex) ? error(i, j, s) : 0.0);
+        }
+      }
+    }
+
+    // The last row does not fill a block.
+    BOOST_REQUIRE_EQUAL(arma::accu(unpooled.slice(s).row(6) != 0), 0);
+  }
+}
+
+/**
+ * Make sure that the whole-map mean pooling gives the mean of each block, and
+ * that the unpooling spreads the error of each block over the block.
+ */
+BOOST_AUTO_TEST_CASE(MeanPoolingMapTest)
+{
+  arma::cube input = arma::randu<arma::cube>(6, 7, 3);
+  arma::cube output, error, unpooled;
+
+  MeanPooling poolingRule;
+  poolingRule.Pooling(input, 3, output);
+
+  BOOST_REQUIRE_EQUAL(output.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(output.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(output.n_slices, 3);
+
+  error = arma::randu<arma::cube>(2, 2, 3);
+  unpooled.zeros(6, 7, 3);
+  poolingRule.Unpooling(error, 3, unpooled);
+
+  for (size_t s = 0; s < 3; ++s)
+  {
+    for (size_t j = 0; j < 2; ++j)
+    {
+      for (size_t i = 0; i < 2; ++i)
+      {
+        const arma::mat block = input.slice(s)(arma::span(3 * i, 3 * i + 2),
+            arma::span(3 * j, 3 * j + 2));
+        const arma::mat unpooledBlock = unpooled.slice(s)(
+            arma::span(3 * i, 3 * i + 2), arma::span(3 * j, 3 * j + 2));
+
+        BOOST_REQUIRE_CLOSE(output(i, j, s), arma::accu(block) / 9, 1e-5);
+        for (size_t k = 0; k < 9; ++k)
+          BOOST_REQUIRE_CLOSE(unpooledBlock[k], error(i, j, s) / 9, 1e-5);
+      }
+    }
+
+    // The last column does not fill a block.
+    BOOST_REQUIRE_EQUAL(arma::accu(unpooled.slice(s).col(6) != 0), 0);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
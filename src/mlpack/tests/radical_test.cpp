@@ -52,4 +52,34 @@ BOOST_AUTO_TEST_CASE(Radical_Test_Radical3D)
   BOOST_REQUIRE_CLOSE(valBest, valEst, 0.25);
 }
 
+/**
+ * Make sure that the result of RADICAL doesn't depend on the number of threads
+ * (the pairs of dimensions of a round are perturbed with their own random
+ * streams).
+ */
+BOOST_AUTO_TEST_CASE(Radical_Test_ThreadIndependence)
+{
+  mat matX;
+  data::Load("data_3d_mixed.txt", matX);
+
+  Radical rad(0.175, 5, 100, matX.n_rows - 1);
+  const size_t oldThreads = ThreadPool::Threads();
+
+  mat matY1, matW1;
+  ThreadPool::SetThreads(1);
+  math::RandomSeed(42);
+  rad.DoRadical(matX, matY1, matW1);
+
+  mat matY2, matW2;
+  ThreadPool::SetThreads(0);
+  math::RandomSeed(42);
+  rad.DoRadical(matX, matY2, matW2);
+  ThreadPool::SetThreads(oldThreads);
+
+  BOOST_REQUIRE_EQUAL(matY1.n_rows, matY2.n_rows);
+  BOOST_REQUIRE_EQUAL(matY1.n_cols, matY2.n_cols);
+  for (uword i = 0; i < matY1.n_elem; i++)
+    BOOST_REQUIRE_CLOSE(matY1[i], matY2[i], 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
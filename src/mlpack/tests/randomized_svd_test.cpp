@@ -0,0 +1,75 @@
+/**
+ * @file randomized_svd_test.cpp
+ *
+ * Test file for the RandomizedSVD class.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/randomized_svd/randomized_svd.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+BOOST_AUTO_TEST_SUITE(RandomizedSVDTest);
+
+using namespace mlpack;
+using namespace mlpack::svd;
+
+/**
+ * The singular values of a low-rank matrix should be the same as the ones of
+ * the exact SVD, and the reconstruction error should be small.
+ */
+BOOST_AUTO_TEST_CASE(RandomizedSVDLowRankTest)
+{
+  // A matrix of rank 10 with some noise.
+  arma::mat data = arma::randn<arma::mat>(200, 10) *
+      arma::randn<arma::mat>(10, 1000) + 1e-6 * arma::randn<arma::mat>(200,
+      1000);
+
+  arma::mat u, v;
+  arma::vec s;
+  RandomizedSVD rSVD;
+  rSVD.Apply(data, u, s, v, 10);
+
+  BOOST_REQUIRE_EQUAL(u.n_rows, 200);
+  BOOST_REQUIRE_EQUAL(u.n_cols, 10);
+  BOOST_REQUIRE_EQUAL(s.n_elem, 10);
+  BOOST_REQUIRE_EQUAL(v.n_rows, 1000);
+  BOOST_REQUIRE_EQUAL(v.n_cols, 10);
+
+  const arma::vec exactS = arma::svd(data);
+  for (size_t i = 0; i < 10; ++i)
+    BOOST_REQUIRE_CLOSE(s[i], exactS[i], 1e-5);
+
+  const double relativeError = arma::norm(data - u * arma::diagmat(s) * v.t(),
+      "fro") / arma::norm(data, "fro");
+  BOOST_REQUIRE_SMALL(relativeError, 1e-5);
+}
+
+/**
+ * With power iterations, the leading singular values of a full-rank matrix
+ * should be close to the exact ones.
+ */
+BOOST_AUTO_TEST_CASE(RandomizedSVDPowerIterationTest)
+{
+  // The singular values decay slowly.
+  arma::mat q1, q2, r;
+  arma::qr_econ(q1, r, arma::randn<arma::mat>(300, 100));
+  arma::qr_econ(q2, r, arma::randn<arma::mat>(500, 100));
+  arma::vec sigma = arma::linspace<arma::vec>(100, 1, 100);
+  const arma::mat data = q1 * arma::diagmat(sigma) * q2.t();
+
+  arma::mat u, v;
+  arma::vec s;
+  RandomizedSVD rSVD(4);
+  rSVD.Apply(data, u, s, v, 5);
+
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_REQUIRE_CLOSE(s[i], sigma[i], 1.0);
+
+  // The singular vectors are orthonormal.
+  const arma::mat identity = arma::eye<arma::mat>(5, 5);
+  BOOST_REQUIRE_SMALL(arma::norm(u.t() * u - identity, "fro"), 1e-8);
+  BOOST_REQUIRE_SMALL(arma::norm(v.t() * v - identity, "fro"), 1e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -542,6 +542,59 @@ BOOST_AUTO_TEST_CASE(DualTreeVsNaive2)
   }
 }
 
+/**
+ * Test the dual-tree range search method with the parallel dual-tree traverser
+ * against the naive method, in both the bichromatic and monochromatic case.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeVsNaive)
+{
+  arma::mat dataForTree;
+  if (!data::Load("test_data_3_1000.csv", dataForTree))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  typedef KDTree<EuclideanDistance, RangeSearchStat, arma::mat> TreeType;
+  RangeSearch<EuclideanDistance, arma::mat, KDTree,
+      TreeType::ParallelDualTreeTraverser> rs(dataForTree);
+  RangeSearch<> naive(dataForTree, true);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    vector<vector<size_t>> neighborsTree;
+    vector<vector<double>> distancesTree;
+    vector<vector<size_t>> neighborsNaive;
+    vector<vector<double>> distancesNaive;
+    if (trial == 0)
+    {
+      rs.Search(dataForTree, Range(0.25, 1.05), neighborsTree, distancesTree);
+      naive.Search(dataForTree, Range(0.25, 1.05), neighborsNaive,
+          distancesNaive);
+    }
+    else
+    {
+      rs.Search(Range(0.25, 1.05), neighborsTree, distancesTree);
+      naive.Search(Range(0.25, 1.05), neighborsNaive, distancesNaive);
+    }
+
+    vector<vector<pair<double, size_t>>> sortedTree;
+    SortResults(neighborsTree, distancesTree, sortedTree);
+    vector<vector<pair<double, size_t>>> sortedNaive;
+    SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+    BOOST_REQUIRE_EQUAL(sortedTree.size(), sortedNaive.size());
+    for (size_t i = 0; i < sortedTree.size(); i++)
+    {
+      BOOST_REQUIRE(sortedTree[i].size() == sortedNaive[i].size());
+
+      for (size_t j = 0; j < sortedTree[i].size(); j++)
+      {
+        BOOST_REQUIRE(sortedTree[i][j].second == sortedNaive[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
 /**
  * Test the single-tree range search method with the naive method.  This
  * uses only a reference dataset.
@@ -966,6 +1019,46 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest)
   }
 }
 
+/**
+ * Ensure that single-tree and dual-tree range search with vantage-point trees
+ * gives the same results as naive search.
+ */
+BOOST_AUTO_TEST_CASE(VPTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(8, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(8, 200);
+
+  RangeSearch<> naive(referenceData, true);
+  vector<vector<size_t>> naiveNeighbors;
+  vector<vector<double>> naiveDistances;
+  naive.Search(queryData, Range(0.5, 1.0), naiveNeighbors, naiveDistances);
+  vector<vector<pair<double, size_t>>> naiveSorted;
+  SortResults(naiveNeighbors, naiveDistances, naiveSorted);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    RangeSearch<EuclideanDistance, arma::mat, VPTree> vpSearch(referenceData,
+        false, (mode == 0));
+    vector<vector<size_t>> vpNeighbors;
+    vector<vector<double>> vpDistances;
+    vpSearch.Search(queryData, Range(0.5, 1.0), vpNeighbors, vpDistances);
+    vector<vector<pair<double, size_t>>> vpSorted;
+    SortResults(vpNeighbors, vpDistances, vpSorted);
+
+    BOOST_REQUIRE_EQUAL(vpSorted.size(), naiveSorted.size());
+    for (size_t i = 0; i < naiveSorted.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(vpSorted[i].size(), naiveSorted[i].size());
+      for (size_t j = 0; j < naiveSorted[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(vpSorted[i][j].second, naiveSorted[i][j].second);
+        BOOST_REQUIRE_CLOSE(vpSorted[i][j].first, naiveSorted[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
 /**
  * Ensure that dual tree range search with ball trees works when using
  * two datasets.
@@ -1382,6 +1475,250 @@ BOOST_AUTO_TEST_CASE(RSModelMonochromaticTest)
   }
 }
 
+/**
+ * Make sure that a range search model built on single-precision data gives the
+ * same results as double-precision search on the same points.
+ */
+BOOST_AUTO_TEST_CASE(RSModelFloatTest)
+{
+  typedef RSModelType<arma::fmat> FloatRSModel;
+
+  arma::fmat queryData = arma::randu<arma::fmat>(10, 50);
+  arma::fmat referenceData = arma::randu<arma::fmat>(10, 200);
+
+  // Get a baseline on the same points in double precision.
+  const arma::mat doubleQueryData = arma::conv_to<arma::mat>::from(queryData);
+  const arma::mat doubleReferenceData =
+      arma::conv_to<arma::mat>::from(referenceData);
+  RangeSearch<> rs(doubleReferenceData);
+  vector<vector<size_t>> baselineNeighbors;
+  vector<vector<double>> baselineDistances;
+  rs.Search(doubleQueryData, math::Range(0.25, 0.5), baselineNeighbors,
+      baselineDistances);
+
+  vector<vector<pair<double, size_t>>> baselineSorted;
+  SortResults(baselineNeighbors, baselineDistances, baselineSorted);
+
+  const FloatRSModel::TreeTypes treeTypes[] = { FloatRSModel::KD_TREE,
+      FloatRSModel::COVER_TREE, FloatRSModel::R_TREE,
+      FloatRSModel::R_STAR_TREE, FloatRSModel::X_TREE,
+      FloatRSModel::BALL_TREE };
+
+  for (size_t i = 0; i < 6; ++i)
+  {
+    for (size_t j = 0; j < 2; ++j)
+    {
+      FloatRSModel model(treeTypes[i]);
+      arma::fmat referenceCopy(referenceData);
+      arma::fmat queryCopy(queryData);
+      model.BuildModel(std::move(referenceCopy), 5, false, (j == 1));
+
+      vector<vector<size_t>> neighbors;
+      vector<vector<double>> distances;
+      model.Search(std::move(queryCopy), math::Range(0.25, 0.5), neighbors,
+          distances);
+
+      BOOST_REQUIRE_EQUAL(neighbors.size(), baselineNeighbors.size());
+      BOOST_REQUIRE_EQUAL(distances.size(), baselineDistances.size());
+
+      vector<vector<pair<double, size_t>>> sorted;
+      SortResults(neighbors, distances, sorted);
+
+      for (size_t k = 0; k < sorted.size(); ++k)
+      {
+        BOOST_REQUIRE_EQUAL(sorted[k].size(), baselineSorted[k].size());
+        for (size_t l = 0; l < sorted[k].size(); ++l)
+        {
+          BOOST_REQUIRE_EQUAL(sorted[k][l].second, baselineSorted[k][l].second);
+          BOOST_REQUIRE_CLOSE(sorted[k][l].first, baselineSorted[k][l].first,
+              1e-3);
+        }
+      }
+    }
+  }
+}
+
+// Check that results in compressed sparse row form are the same as results
+// with a vector for each query point, in the same order.
+void CheckFlatResults(const vector<vector<size_t>>& neighbors,
+                      const vector<vector<double>>& distances,
+                      const vector<size_t>& flatOffsets,
+                      const vector<size_t>& flatNeighbors,
+                      const vector<double>& flatDistances)
+{
+  BOOST_REQUIRE_EQUAL(flatOffsets.size(), neighbors.size() + 1);
+  BOOST_REQUIRE_EQUAL(flatOffsets[0], 0);
+  BOOST_REQUIRE_EQUAL(flatOffsets.back(), flatNeighbors.size());
+  BOOST_REQUIRE_EQUAL(flatOffsets.back(), flatDistances.size());
+
+  for (size_t i = 0; i < neighbors.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(flatOffsets[i + 1] - flatOffsets[i],
+        neighbors[i].size());
+    for (size_t j = 0; j < neighbors[i].size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(flatNeighbors[flatOffsets[i] + j], neighbors[i][j]);
+      BOOST_REQUIRE_EQUAL(flatDistances[flatOffsets[i] + j], distances[i][j]);
+    }
+  }
+}
+
+/**
+ * Make sure that the compressed sparse row overloads of Search() give the same
+ * results as the overloads with a vector for each query point, for trees that
+ * rearrange the dataset and trees that don't, in every search mode.
+ */
+BOOST_AUTO_TEST_CASE(FlatResultsTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 200);
+  const math::Range range(0.1, 0.3);
+
+  typedef RangeSearch<EuclideanDistance, arma::mat, StandardCoverTree>
+      CoverTreeRangeSearch;
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    const bool naive = (mode == 2);
+    const bool singleMode = (mode == 1);
+
+    RangeSearch<> kdrs(referenceData, naive, singleMode);
+    CoverTreeRangeSearch ctrs(referenceData, naive, singleMode);
+
+    vector<vector<size_t>> neighbors;
+    vector<vector<double>> distances;
+    vector<size_t> flatOffsets, flatNeighbors;
+    vector<double> flatDistances;
+
+    // Bichromatic search.
+    kdrs.Search(queryData, range, neighbors, distances);
+    kdrs.Search(queryData, range, flatOffsets, flatNeighbors, flatDistances);
+    CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+        flatDistances);
+
+    ctrs.Search(queryData, range, neighbors, distances);
+    ctrs.Search(queryData, range, flatOffsets, flatNeighbors, flatDistances);
+    CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+        flatDistances);
+
+    // Monochromatic search.
+    kdrs.Search(range, neighbors, distances);
+    kdrs.Search(range, flatOffsets, flatNeighbors, flatDistances);
+    CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+        flatDistances);
+
+    ctrs.Search(range, neighbors, distances);
+    ctrs.Search(range, flatOffsets, flatNeighbors, flatDistances);
+    CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+        flatDistances);
+  }
+
+  // RSModel builds its own query tree for kd-trees and ball trees, so check
+  // that too.
+  RSModel::TreeTypes treeTypes[] = { RSModel::TreeTypes::KD_TREE,
+      RSModel::TreeTypes::BALL_TREE, RSModel::TreeTypes::COVER_TREE };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    RSModel model(treeTypes[i]);
+    arma::mat referenceCopy(referenceData);
+    model.BuildModel(std::move(referenceCopy), 10, false, false);
+
+    vector<vector<size_t>> neighbors;
+    vector<vector<double>> distances;
+    vector<size_t> flatOffsets, flatNeighbors;
+    vector<double> flatDistances;
+
+    arma::mat queryCopy(queryData);
+    model.Search(std::move(queryCopy), range, neighbors, distances);
+    queryCopy = queryData;
+    model.Search(std::move(queryCopy), range, flatOffsets, flatNeighbors,
+        flatDistances);
+    CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+        flatDistances);
+
+    model.Search(range, neighbors, distances);
+    model.Search(range, flatOffsets, flatNeighbors, flatDistances);
+    CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+        flatDistances);
+  }
+}
+
+/**
+ * Make sure that searches with several threads (blocks of query points for
+ * naive and single-tree search, and the parallel dual-tree traverser for
+ * dual-tree search) give the same results as a naive search with one thread,
+ * with both output formats.
+ */
+BOOST_AUTO_TEST_CASE(ParallelFlatResultsTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 800);
+  const math::Range range(0.05, 0.2);
+
+  const size_t oldThreads = ThreadPool::Threads();
+  ThreadPool::SetThreads(1);
+  RangeSearch<> serial(referenceData, true);
+  vector<vector<size_t>> serialNeighbors;
+  vector<vector<double>> serialDistances;
+  serial.Search(queryData, range, serialNeighbors, serialDistances);
+  vector<vector<pair<double, size_t>>> sortedSerial;
+  SortResults(serialNeighbors, serialDistances, sortedSerial);
+
+  typedef KDTree<EuclideanDistance, RangeSearchStat, arma::mat> TreeType;
+  typedef RangeSearch<EuclideanDistance, arma::mat, KDTree,
+      TreeType::ParallelDualTreeTraverser> ParallelRangeSearch;
+  typedef RangeSearch<EuclideanDistance, arma::mat, StandardCoverTree>
+      CoverTreeRangeSearch;
+
+  ThreadPool::SetThreads(0);
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    const bool naive = (mode == 2);
+    const bool singleMode = (mode == 1);
+
+    ParallelRangeSearch kdrs(referenceData, naive, singleMode);
+    CoverTreeRangeSearch ctrs(referenceData, naive, singleMode);
+
+    for (size_t tree = 0; tree < 2; ++tree)
+    {
+      vector<vector<size_t>> neighbors;
+      vector<vector<double>> distances;
+      vector<size_t> flatOffsets, flatNeighbors;
+      vector<double> flatDistances;
+      if (tree == 0)
+      {
+        kdrs.Search(queryData, range, neighbors, distances);
+        kdrs.Search(queryData, range, flatOffsets, flatNeighbors,
+            flatDistances);
+      }
+      else
+      {
+        ctrs.Search(queryData, range, neighbors, distances);
+        ctrs.Search(queryData, range, flatOffsets, flatNeighbors,
+            flatDistances);
+      }
+
+      CheckFlatResults(neighbors, distances, flatOffsets, flatNeighbors,
+          flatDistances);
+
+      vector<vector<pair<double, size_t>>> sorted;
+      SortResults(neighbors, distances, sorted);
+      BOOST_REQUIRE_EQUAL(sorted.size(), sortedSerial.size());
+      for (size_t i = 0; i < sorted.size(); ++i)
+      {
+        BOOST_REQUIRE_EQUAL(sorted[i].size(), sortedSerial[i].size());
+        for (size_t j = 0; j < sorted[i].size(); ++j)
+        {
+          BOOST_REQUIRE_EQUAL(sorted[i][j].second, sortedSerial[i][j].second);
+          BOOST_REQUIRE_CLOSE(sorted[i][j].first, sortedSerial[i][j].first,
+              1e-5);
+        }
+      }
+    }
+  }
+  ThreadPool::SetThreads(oldThreads);
+}
+
 /**
  * Make sure that the neighborPtr matrix isn't accidentally deleted.
  * See issue #478.
@@ -1408,4 +1745,63 @@ BOOST_AUTO_TEST_CASE(NeighborPtrDeleteTest)
 }
 
 
+/**
+ * Make sure that a shared reference set is used without a copy (the kd-tree
+ * reads it through its permutation) and kept alive by the models.
+ */
+BOOST_AUTO_TEST_CASE(SharedReferenceSetTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 200);
+  RangeSearch<> rs(dataset);
+
+  std::shared_ptr<const arma::mat> shared(new arma::mat(dataset));
+  const arma::mat* sharedSet = shared.get();
+  RangeSearch<> sharedNaive(shared, true);
+  RangeSearch<> sharedTree(shared);
+  BOOST_REQUIRE_EQUAL(&sharedNaive.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(&sharedTree.ReferenceSet(), sharedSet);
+  BOOST_REQUIRE_EQUAL(shared.use_count(), 3);
+  shared.reset();
+
+  vector<vector<size_t>> neighbors;
+  vector<vector<double>> distances;
+  rs.Search(math::Range(0.2, 0.5), neighbors, distances);
+  vector<vector<pair<double, size_t>>> sorted;
+  SortResults(neighbors, distances, sorted);
+
+  for (size_t m = 0; m < 4; ++m)
+  {
+    vector<vector<size_t>> sharedNeighbors;
+    vector<vector<double>> sharedDistances;
+    RangeSearch<>& model = (m == 0) ? sharedNaive : sharedTree;
+    if (m < 2)
+    {
+      model.Search(math::Range(0.2, 0.5), sharedNeighbors, sharedDistances);
+    }
+    else
+    {
+      // Bichromatic search (dual-tree, then single-tree), with the points as
+      // queries (each point is at distance 0 from itself, out of the range).
+      model.SingleMode() = (m == 3);
+      model.Search(dataset, math::Range(0.2, 0.5), sharedNeighbors,
+          sharedDistances);
+    }
+
+    vector<vector<pair<double, size_t>>> sharedSorted;
+    SortResults(sharedNeighbors, sharedDistances, sharedSorted);
+
+    BOOST_REQUIRE_EQUAL(sorted.size(), sharedSorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(sorted[i].size(), sharedSorted[i].size());
+      for (size_t j = 0; j < sorted[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(sorted[i][j].second, sharedSorted[i][j].second);
+        BOOST_REQUIRE_CLOSE(sorted[i][j].first, sharedSorted[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -826,4 +826,193 @@ BOOST_AUTO_TEST_CASE(RectangleTreeMoveDatasetTest)
   BOOST_REQUIRE_EQUAL(tree.Dataset().n_cols, 1000);
 }
 
+/**
+ * Build a tree of the given type with Sort-Tile-Recursive bulk loading, check
+ * that it is a valid tree, and check that nearest neighbor search with it gives
+ * the same results as naive search.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckBulkLoad()
+{
+  typedef TreeType<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> Tree;
+
+  arma::mat dataset;
+  dataset.randu(5, 1000); // 1000 points in 5 dimensions.
+
+  arma::mat querySet;
+  querySet.randu(5, 100);
+
+  Tree tree(dataset, SortTileRecursive(), 20, 6, 5, 2);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckHierarchy(tree);
+  CheckSync(tree);
+  CheckFills(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+  BOOST_REQUIRE_EQUAL(tree.TreeDepth(), GetMinLevel(tree));
+
+  // Every leaf should be full or close to full: 1000 points in 20-point leaves.
+  BOOST_REQUIRE_EQUAL(tree.TreeDepth(), 4);
+
+  NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, arma::mat,
+      TreeType> knn1(&tree, false);
+  arma::Mat<size_t> neighbors1;
+  arma::mat distances1;
+  knn1.Search(querySet, 5, neighbors1, distances1);
+
+  KNN knn2(dataset, true, true);
+  arma::Mat<size_t> neighbors2;
+  arma::mat distances2;
+  knn2.Search(querySet, 5, neighbors2, distances2);
+
+  for (size_t i = 0; i < neighbors1.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+    BOOST_REQUIRE_CLOSE(distances1[i], distances2[i], 1e-5);
+  }
+
+  // A bulk-loaded tree should still support deleting points.
+  for (size_t i = 0; i < 50; ++i)
+    tree.DeletePoint(999 - i);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 950);
+  CheckContainment(tree);
+  CheckSync(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+}
+
+// Test Sort-Tile-Recursive bulk loading with each kind of rectangle tree.
+BOOST_AUTO_TEST_CASE(RectangleTreeBulkLoadTest)
+{
+  CheckBulkLoad<RTree>();
+  CheckBulkLoad<RStarTree>();
+  CheckBulkLoad<XTree>();
+}
+
+// Make sure that bulk loading works when all the points fit in the root, and
+// when the dataset is moved into the tree.
+BOOST_AUTO_TEST_CASE(RectangleTreeBulkLoadSmallTest)
+{
+  typedef RTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  arma::mat small = arma::randu<arma::mat>(3, 15);
+  TreeType smallTree(small, SortTileRecursive());
+  BOOST_REQUIRE(smallTree.IsLeaf());
+  BOOST_REQUIRE_EQUAL(smallTree.NumDescendants(), 15);
+  CheckExactContainment(smallTree);
+
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+  TreeType tree(std::move(dataset), SortTileRecursive());
+  BOOST_REQUIRE_EQUAL(dataset.n_elem, 0);
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000);
+  CheckExactContainment(tree);
+  CheckHierarchy(tree);
+}
+
+/**
+ * Count the nodes of the given tree.
+ */
+template<typename TreeType>
+size_t CountNodes(const TreeType& tree)
+{
+  size_t n = 1;
+  for (size_t i = 0; i < tree.NumChildren(); ++i)
+    n += CountNodes(tree.Child(i));
+  return n;
+}
+
+/**
+ * Insert a batch of points into a tree of the given type, check that it is a
+ * valid tree, check that nearest neighbor search with it gives the same
+ * results as naive search, and check that it has fewer nodes than the tree
+ * built by inserting the same points one at a time (the batch fills its leaves
+ * with Sort-Tile-Recursive packing, instead of splitting them in halves).
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckBatchInsert()
+{
+  typedef TreeType<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> Tree;
+
+  arma::mat dataset;
+  dataset.randu(5, 1500); // 1500 points in 5 dimensions.
+
+  arma::mat querySet;
+  querySet.randu(5, 100);
+
+  // Build the tree on the first 500 points, then add the other 1000 points as
+  // one batch.
+  Tree tree(dataset.cols(0, 499), 20, 6, 5, 2, 0);
+  tree.Dataset() = dataset;
+
+  std::vector<size_t> newPoints(1000);
+  for (size_t i = 0; i < newPoints.size(); ++i)
+    newPoints[i] = 500 + i;
+  tree.InsertPoints(newPoints);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1500);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckHierarchy(tree);
+  CheckSync(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+
+  Tree pointTree(dataset.cols(0, 499), 20, 6, 5, 2, 0);
+  pointTree.Dataset() = dataset;
+  for (size_t i = 0; i < newPoints.size(); ++i)
+    pointTree.InsertPoint(newPoints[i]);
+
+  BOOST_REQUIRE_EQUAL(pointTree.NumDescendants(), 1500);
+  BOOST_REQUIRE_LT(CountNodes(tree), CountNodes(pointTree));
+
+  NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, arma::mat,
+      TreeType> knn1(&tree, false);
+  arma::Mat<size_t> neighbors1;
+  arma::mat distances1;
+  knn1.Search(querySet, 5, neighbors1, distances1);
+
+  KNN knn2(dataset, true, true);
+  arma::Mat<size_t> neighbors2;
+  arma::mat distances2;
+  knn2.Search(querySet, 5, neighbors2, distances2);
+
+  for (size_t i = 0; i < neighbors1.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+    BOOST_REQUIRE_CLOSE(distances1[i], distances2[i], 1e-5);
+  }
+
+  // An empty batch should not change anything.
+  tree.InsertPoints(std::vector<size_t>());
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1500);
+
+  // A batch into a tree whose root is a leaf should make the tree grow.
+  Tree smallTree(dataset.cols(0, 9), 20, 6, 5, 2, 0);
+  smallTree.Dataset() = dataset;
+  smallTree.InsertPoints(newPoints);
+
+  BOOST_REQUIRE_EQUAL(smallTree.NumDescendants(), 1010);
+  CheckContainment(smallTree);
+  CheckExactContainment(smallTree);
+  CheckHierarchy(smallTree);
+  CheckSync(smallTree);
+  CheckFills(smallTree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(smallTree), GetMaxLevel(smallTree));
+}
+
+// Test batch insertion with each kind of rectangle tree.
+BOOST_AUTO_TEST_CASE(RectangleTreeBatchInsertTest)
+{
+  CheckBatchInsert<RTree>();
+  CheckBatchInsert<RStarTree>();
+  CheckBatchInsert<XTree>();
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -581,4 +581,223 @@ BOOST_AUTO_TEST_CASE(DistractedSequenceRecallTest)
   DistractedSequenceRecallTestNetwork(hiddenLayerLSTMPeephole);
 }
 
+/**
+ * Make sure that the forward pass of the LSTM layer with peepholes computes the
+ * gates and the state of each time step of a sequence as the usual matrix
+ * formulation does.
+ */
+BOOST_AUTO_TEST_CASE(LSTMForwardPassTest)
+{
+  const size_t outSize = 5;
+  const size_t seqLen = 4;
+
+  LSTMLayer<> lstm(outSize, true);
+  lstm.SeqLen() = seqLen;
+  lstm.Weights().randn();
+
+  const arma::mat peepholes = lstm.Weights();
+  arma::mat input = arma::randn<arma::mat>(outSize * 4, seqLen);
+
+  arma::vec state = arma::zeros<arma::vec>(outSize);
+  for (size_t t = 0; t < seqLen; ++t)
+  {
+    const arma::vec x = input.col(t);
+    arma::vec inGate = x.subvec(0, outSize - 1);
+    arma::vec forgetGate = x.subvec(outSize, 2 * outSize - 1);
+    const arma::vec cell = x.subvec(2 * outSize, 3 * outSize - 1);
+    arma::vec outGate = x.subvec(3 * outSize, 4 * outSize - 1);
+
+    if (t > 0)
+    {
+      inGate += peepholes.col(0) % state;
+      forgetGate += peepholes.col(1) % state;
+    }
+
+    const arma::vec inGateAct = 1.0 / (1.0 + arma::exp(-inGate));
+    const arma::vec forgetGateAct = 1.0 / (1.0 + arma::exp(-forgetGate));
+    arma::vec newState = inGateAct % arma::tanh(cell);
+    if (t > 0)
+      newState += forgetGateAct % state;
+    state = newState;
+
+    outGate += peepholes.col(2) % state;
+    const arma::vec outGateAct = 1.0 / (1.0 + arma::exp(-outGate));
+    const arma::vec expected = outGateAct % arma::tanh(state);
+
+    arma::mat output;
+    lstm.Forward(arma::mat(input.col(t)), output);
+
+    BOOST_REQUIRE_EQUAL(output.n_elem, outSize);
+    for (size_t i = 0; i < outSize; ++i)
+      BOOST_REQUIRE_CLOSE(output[i], expected[i], 1e-6);
+  }
+}
+
+/**
+ * Make sure that a batch of sequences propagated together gives the sum of the
+ * errors and gradients of its sequences, with and without truncated BPTT, and
+ * that truncated BPTT over the whole sequence is the usual gradient.
+ */
+BOOST_AUTO_TEST_CASE(BatchTruncatedBPTTTest)
+{
+  arma::mat input, labels;
+  GenerateNoisySines(input, labels, 10, 6);
+
+  LinearLayer<> linearLayer0(1, 4);
+  RecurrentLayer<> recurrentLayer0(4);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer(4, 2);
+  BaseLayer<LogisticFunction> hiddenBaseLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(linearLayer0, recurrentLayer0, inputBaseLayer,
+                          hiddenLayer, hiddenBaseLayer);
+
+  RNN<decltype(modules), BinaryClassificationLayer, RandomInitialization,
+      MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+  // With a single iteration, this mostly stores the data in the network.
+  SGD<decltype(net)> opt(net, 0.01, 1, -100);
+  net.Train(input, labels, opt);
+
+  arma::mat fullGradient;
+  net.Gradient(net.Parameters(), 0, fullGradient, input.n_cols);
+
+  const size_t bpttSteps[] = { 0, 3, 10 };
+  for (size_t b = 0; b < 3; ++b)
+  {
+    net.BPTTSteps() = bpttSteps[b];
+
+    double error = 0;
+    arma::mat gradient, sequenceGradient;
+    gradient.zeros(net.Parameters().n_rows, net.Parameters().n_cols);
+    for (size_t i = 0; i < input.n_cols; ++i)
+    {
+      error += net.Evaluate(net.Parameters(), i, false);
+      net.Gradient(net.Parameters(), i, sequenceGradient);
+      gradient += sequenceGradient;
+    }
+
+    arma::mat batchGradient;
+    net.Gradient(net.Parameters(), 0, batchGradient, input.n_cols);
+
+    BOOST_REQUIRE_CLOSE(net.Evaluate(net.Parameters(), 0, input.n_cols, false),
+        error, 1e-8);
+    BOOST_REQUIRE_EQUAL(batchGradient.n_elem, gradient.n_elem);
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+      BOOST_REQUIRE_SMALL(batchGradient[i] - gradient[i], 1e-8);
+
+    // A window as long as the sequence is the whole sequence.
+    if (bpttSteps[b] != 3)
+    {
+      for (size_t i = 0; i < gradient.n_elem; ++i)
+        BOOST_REQUIRE_SMALL(batchGradient[i] - fullGradient[i], 1e-8);
+    }
+  }
+}
+
+/**
+ * Compare the gradient of a network with an output at each step with central
+ * differences of its error.  Truncated BPTT drops the error that the state
+ * carried into a window propagates back into the earlier windows, so it only
+ * matches the differences everywhere when that error is zero: with the
+ * recurrent weights set to zero, the carried state doesn't change the later
+ * outputs, but the gradient of the recurrent weights still depends on it.
+ * Otherwise, only the gradient of the layers after the recurrent state (which
+ * don't change the state) must match.
+ */
+BOOST_AUTO_TEST_CASE(TruncatedBPTTGradientTest)
+{
+  arma::mat input, labels;
+  GenerateNoisySines(input, labels, 10, 1);
+
+  // The label of each sequence is the target of every step.
+  const arma::mat seqLabels = arma::repmat(labels, 10, 1);
+
+  LinearLayer<> linearLayer0(1, 4);
+  RecurrentLayer<> recurrentLayer0(4);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer(4, 2);
+  BaseLayer<LogisticFunction> hiddenBaseLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(linearLayer0, recurrentLayer0, inputBaseLayer,
+                          hiddenLayer, hiddenBaseLayer);
+
+  RNN<decltype(modules), BinaryClassificationLayer, RandomInitialization,
+      MeanSquaredErrorFunction> net(modules, classOutputLayer);
+
+  // With a single iteration, this mostly stores the data in the network.
+  SGD<decltype(net)> opt(net, 0.01, 1, -100);
+  net.Train(input, seqLabels, opt);
+
+  // The weights of the layers are aliases of the parameters.
+  arma::mat& parameters = net.Parameters();
+  const size_t recurrentBegin = recurrentLayer0.Weights().memptr() -
+      parameters.memptr();
+  const size_t recurrentEnd = recurrentBegin +
+      recurrentLayer0.Weights().n_elem;
+  const size_t hiddenBegin = hiddenLayer.Weights().memptr() -
+      parameters.memptr();
+  const size_t hiddenEnd = hiddenBegin + hiddenLayer.Weights().n_elem;
+
+  const double eps = 1e-6;
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    if (trial == 1)
+      parameters.rows(recurrentBegin, recurrentEnd - 1).zeros();
+
+    arma::mat numerical(parameters.n_rows, parameters.n_cols);
+    for (size_t i = 0; i < parameters.n_elem; ++i)
+    {
+      const double original = parameters[i];
+      parameters[i] = original + eps;
+      const double plus = net.Evaluate(parameters, 0, false);
+      parameters[i] = original - eps;
+      const double minus = net.Evaluate(parameters, 0, false);
+      parameters[i] = original;
+
+      numerical[i] = (plus - minus) / (2 * eps);
+    }
+
+    const size_t bpttSteps[] = { 0, 3, 4 };
+    for (size_t b = 0; b < 3; ++b)
+    {
+      net.BPTTSteps() = bpttSteps[b];
+
+      arma::mat gradient;
+      net.Gradient(parameters, 0, gradient);
+      BOOST_REQUIRE_EQUAL(gradient.n_elem, numerical.n_elem);
+
+      double recurrentDifference = 0;
+      for (size_t i = 0; i < gradient.n_elem; ++i)
+      {
+        if (i >= recurrentBegin && i < recurrentEnd)
+        {
+          recurrentDifference = std::max(recurrentDifference,
+              std::abs(gradient[i] - numerical[i]));
+        }
+
+        if (bpttSteps[b] != 0 && trial == 0 &&
+            (i < hiddenBegin || i >= hiddenEnd))
+          continue;
+
+        // The round-off error of the differences is about 1e-9.
+        if (std::abs(numerical[i]) < 1e-4)
+          BOOST_REQUIRE_SMALL(gradient[i] - numerical[i], 1e-7);
+        else
+          BOOST_REQUIRE_CLOSE(gradient[i], numerical[i], 1e-2);
+      }
+
+      // With the trained recurrent weights, the truncation is visible.
+      if (bpttSteps[b] != 0 && trial == 0)
+        BOOST_REQUIRE_GT(recurrentDifference, 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -189,6 +189,49 @@ BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionGradient)
   }
 }
 
+/**
+ * Make sure that the sparse gradients of the single examples add up to the
+ * full gradient.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionSparseGradient)
+{
+  const size_t numUsers = 20;
+  const size_t numItems = 30;
+  const size_t numRatings = 100;
+  const size_t rank = 5;
+
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.1);
+  const arma::mat parameters = arma::randu(rank, numUsers + numItems);
+
+  arma::mat gradient;
+  rSVDFunc.Gradient(parameters, gradient);
+
+  arma::mat sum = arma::zeros(rank, numUsers + numItems);
+  for (size_t i = 0; i < numRatings; ++i)
+  {
+    arma::sp_mat sparseGradient;
+    rSVDFunc.Gradient(parameters, i, sparseGradient);
+
+    // Only the user and the item columns are nonzero.
+    BOOST_REQUIRE_LE(sparseGradient.n_nonzero, 2 * rank);
+    sum += sparseGradient;
+  }
+
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-8)
+      BOOST_REQUIRE_SMALL(sum[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(sum[i], gradient[i], 1e-8);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionOptimize)
 {
   // Define useful constants.
@@ -244,4 +287,103 @@ BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionOptimize)
   BOOST_REQUIRE_SMALL(relativeError, 1e-2);
 }
 
+/**
+ * Make sure that the nonzero columns of the gradient for each rating match the
+ * sparse gradient, and that they are the support of the gradient.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionColumnGradient)
+{
+  const size_t numUsers = 20;
+  const size_t numItems = 30;
+  const size_t numRatings = 100;
+  const size_t rank = 5;
+
+  BOOST_REQUIRE_EQUAL(
+      optimization::HasColumnGradient<RegularizedSVDFunction>::value, true);
+  BOOST_REQUIRE_EQUAL(
+      optimization::HasGradientSupport<RegularizedSVDFunction>::value, true);
+
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.1);
+  const arma::mat parameters = arma::randu(rank, numUsers + numItems);
+
+  for (size_t i = 0; i < numRatings; ++i)
+  {
+    arma::sp_mat sparseGradient;
+    rSVDFunc.Gradient(parameters, i, sparseGradient);
+
+    optimization::ColumnGradient columnGradient;
+    rSVDFunc.Gradient(parameters, i, columnGradient);
+
+    BOOST_REQUIRE_EQUAL(columnGradient.Columns().n_elem, 2);
+    BOOST_REQUIRE_EQUAL(columnGradient.Values().n_rows, rank);
+    BOOST_REQUIRE_EQUAL(columnGradient.Values().n_cols, 2);
+    BOOST_REQUIRE_EQUAL(columnGradient.Columns()[0], (size_t) data(0, i));
+    BOOST_REQUIRE_EQUAL(columnGradient.Columns()[1],
+        (size_t) data(1, i) + numUsers);
+
+    // The support gives the same columns.
+    arma::uvec support;
+    rSVDFunc.GradientSupport(i, support);
+    BOOST_REQUIRE_EQUAL(support.n_elem, 2);
+    BOOST_REQUIRE_EQUAL(support[0], columnGradient.Columns()[0]);
+    BOOST_REQUIRE_EQUAL(support[1], columnGradient.Columns()[1]);
+
+    for (size_t c = 0; c < 2; ++c)
+    {
+      for (size_t k = 0; k < rank; ++k)
+      {
+        const double value = sparseGradient(k, columnGradient.Columns()[c]);
+        if (std::abs(value) < 1e-8)
+          BOOST_REQUIRE_SMALL(columnGradient.Values()(k, c), 1e-8);
+        else
+          BOOST_REQUIRE_CLOSE(columnGradient.Values()(k, c), value, 1e-8);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that RegularizedSVD with the ParallelSGD optimizer recovers a
+ * low-rank rating matrix.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDParallelSGDTest)
+{
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 100;
+  const size_t rank = 10;
+
+  // Make a random rating dataset from random parameters.
+  const arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    data(2, i) = arma::dot(parameters.col(data(0, i)),
+                           parameters.col(numUsers + data(1, i)));
+  }
+
+  RegularizedSVD<optimization::ParallelSGD> rSVD(30, 0.01, 0.01);
+  arma::mat u, v;
+  rSVD.Apply(data, rank, u, v);
+
+  // u holds the item factors and v the user factors.
+  arma::rowvec predictedData(numRatings);
+  for (size_t i = 0; i < numRatings; i++)
+    predictedData[i] = arma::dot(v.col(data(0, i)), u.row(data(1, i)).t());
+
+  const double relativeError = arma::norm(data.row(2) - predictedData, "frob")
+      / arma::norm(data, "frob");
+  BOOST_REQUIRE_SMALL(relativeError, 1e-2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
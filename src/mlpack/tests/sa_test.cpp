@@ -124,4 +124,61 @@ BOOST_AUTO_TEST_CASE(RastrigrinFunctionTest)
   BOOST_REQUIRE_GE(successes, 1);
 }
 
+/**
+ * Run several chains in parallel on the Rastrigrin function; the exchanges of
+ * states between the chains should let them escape from local minima as well.
+ */
+BOOST_AUTO_TEST_CASE(RastrigrinFunctionChainsTest)
+{
+  size_t successes = 0;
+
+  for (size_t trial = 0; trial < 3; ++trial)
+  {
+    RastrigrinFunction f;
+    ExponentialSchedule schedule(3e-6);
+    SA<RastrigrinFunction> sa(f, schedule, 20000000, 100, 50, 1000, 1e-12, 2,
+        0.2, 0.01, 0.1, 4, 1000, 0.5);
+    arma::mat coordinates = f.GetInitialPoint();
+
+    const double result = sa.Optimize(coordinates);
+
+    // The best state of the chains is returned.
+    BOOST_REQUIRE_SMALL(result - f.Evaluate(coordinates), 1e-10);
+    BOOST_REQUIRE_LE(result, f.Evaluate(f.GetInitialPoint()));
+
+    if ((std::abs(result) < 1e-3) &&
+        (std::abs(coordinates[0]) < 1e-3) &&
+        (std::abs(coordinates[1]) < 1e-3))
+      ++successes;
+  }
+
+  BOOST_REQUIRE_GE(successes, 1);
+}
+
+/**
+ * The chains draw from streams derived from the random seed, so two runs with
+ * the same seed must give the same result.
+ */
+BOOST_AUTO_TEST_CASE(ChainsSeedTest)
+{
+  arma::mat coordinates[2];
+  double results[2];
+  for (size_t run = 0; run < 2; ++run)
+  {
+    math::RandomSeed(42);
+
+    RastrigrinFunction f;
+    ExponentialSchedule schedule(3e-6);
+    SA<RastrigrinFunction> sa(f, schedule, 20000, 100, 50, 1000, 1e-12, 2,
+        0.2, 0.01, 0.1, 4, 1000, 0.5);
+    coordinates[run] = f.GetInitialPoint();
+    results[run] = sa.Optimize(coordinates[run]);
+  }
+
+  BOOST_REQUIRE_EQUAL(results[0], results[1]);
+  BOOST_REQUIRE_EQUAL(coordinates[0].n_elem, coordinates[1].n_elem);
+  for (size_t i = 0; i < coordinates[0].n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(coordinates[0][i], coordinates[1][i]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
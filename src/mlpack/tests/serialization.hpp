@@ -93,6 +93,8 @@ void TestAllArmadilloSerialization(arma::Cube<CubeType>& x)
       boost::archive::text_oarchive>(x);
   TestArmadilloSerialization<CubeType, boost::archive::binary_iarchive,
       boost::archive::binary_oarchive>(x);
+  TestArmadilloSerialization<CubeType, data::AlignedBinaryIArchive,
+      data::AlignedBinaryOArchive>(x);
 }
 
 // Test function for loading and saving Armadillo objects.
@@ -159,6 +161,8 @@ void TestAllArmadilloSerialization(MatType& x)
       boost::archive::text_oarchive>(x);
   TestArmadilloSerialization<MatType, boost::archive::binary_iarchive,
       boost::archive::binary_oarchive>(x);
+  TestArmadilloSerialization<MatType, data::AlignedBinaryIArchive,
+      data::AlignedBinaryOArchive>(x);
 }
 
 // Save and load an mlpack object.
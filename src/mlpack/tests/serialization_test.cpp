@@ -27,6 +27,7 @@
 #include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
 #include <mlpack/methods/rann/ra_search.hpp>
 #include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/ivf_pq/ivf_pq_search.hpp>
 #include <mlpack/methods/decision_stump/decision_stump.hpp>
 #include <mlpack/methods/lars/lars.hpp>
 
@@ -144,6 +145,45 @@ BOOST_AUTO_TEST_CASE(EmptySparseMatrixSerializeTest)
   TestAllArmadilloSerialization(m);
 }
 
+/**
+ * Make sure that AlignedBinaryOArchive stores matrix memory as one raw block
+ * aligned to 64 bytes.
+ */
+BOOST_AUTO_TEST_CASE(AlignedBinaryArchiveAlignmentTest)
+{
+  arma::mat m;
+  m.randu(30, 40);
+  std::vector<size_t> v(7, 3); // Make sure not everything is aligned already.
+
+  std::ostringstream oss;
+  {
+    data::AlignedBinaryOArchive o(oss);
+    o << BOOST_SERIALIZATION_NVP(v);
+    o << BOOST_SERIALIZATION_NVP(m);
+  }
+
+  const std::string s = oss.str();
+  const std::string block((const char*) m.memptr(), sizeof(double) * m.n_elem);
+  const size_t position = s.find(block);
+  BOOST_REQUIRE(position != std::string::npos);
+  BOOST_REQUIRE_EQUAL(position % data::rawBlockAlignment, 0);
+
+  std::istringstream iss(s);
+  std::vector<size_t> newV;
+  arma::mat newM;
+  {
+    data::AlignedBinaryIArchive i(iss);
+    i >> make_nvp("v", newV);
+    i >> make_nvp("m", newM);
+  }
+
+  BOOST_REQUIRE_EQUAL(newV.size(), v.size());
+  BOOST_REQUIRE_EQUAL(newM.n_rows, m.n_rows);
+  BOOST_REQUIRE_EQUAL(newM.n_cols, m.n_cols);
+  for (size_t i = 0; i < m.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(newM[i], m[i]);
+}
+
 // Now, test mlpack objects.
 BOOST_AUTO_TEST_CASE(DiscreteDistributionTest)
 {
@@ -1225,16 +1265,52 @@ BOOST_AUTO_TEST_CASE(LSHTest)
   BOOST_REQUIRE_EQUAL(lsh.BucketSize(), textLsh.BucketSize());
   BOOST_REQUIRE_EQUAL(lsh.BucketSize(), binaryLsh.BucketSize());
 
-  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
-      xmlLsh.SecondHashTable().size());
-  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
-      textLsh.SecondHashTable().size());
-  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
-      binaryLsh.SecondHashTable().size());
+  CheckMatrices(lsh.BucketOffsets(), xmlLsh.BucketOffsets(),
+      textLsh.BucketOffsets(), binaryLsh.BucketOffsets());
+  CheckMatrices(lsh.BucketContents(), xmlLsh.BucketContents(),
+      textLsh.BucketContents(), binaryLsh.BucketContents());
+}
+
+/**
+ * Test that an IVF-PQ index can be serialized and deserialized, and gives the
+ * same results afterwards.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(6, 300);
+  arma::mat queryData = arma::randu<arma::mat>(6, 20);
+
+  IVFPQSearch pq(referenceData, 4, 3, 16);
+
+  IVFPQSearch xmlPq;
+  arma::mat otherData = arma::randu<arma::mat>(4, 100);
+  IVFPQSearch textPq(otherData, 2, 2, 8);
+  IVFPQSearch binaryPq(otherData, 3, 4, 4);
+
+  SerializeObjectAll(pq, xmlPq, textPq, binaryPq);
+
+  CheckMatrices(pq.CoarseCentroids(), xmlPq.CoarseCentroids(),
+      textPq.CoarseCentroids(), binaryPq.CoarseCentroids());
+  BOOST_REQUIRE_EQUAL(xmlPq.NumSubspaces(), 3);
+  BOOST_REQUIRE_EQUAL(textPq.NumSubspaces(), 3);
+  BOOST_REQUIRE_EQUAL(binaryPq.NumSubspaces(), 3);
+  for (size_t i = 0; i < pq.NumSubspaces(); ++i)
+    CheckMatrices(pq.Codebook(i), xmlPq.Codebook(i), textPq.Codebook(i),
+        binaryPq.Codebook(i));
+  CheckMatrices(pq.ListOffsets(), xmlPq.ListOffsets(), textPq.ListOffsets(),
+      binaryPq.ListOffsets());
+  CheckMatrices(pq.ListIndices(), xmlPq.ListIndices(), textPq.ListIndices(),
+      binaryPq.ListIndices());
+
+  arma::Mat<size_t> neighbors, xmlNeighbors, textNeighbors, binaryNeighbors;
+  arma::mat distances, xmlDistances, textDistances, binaryDistances;
+  pq.Search(queryData, 3, neighbors, distances, 2);
+  xmlPq.Search(queryData, 3, xmlNeighbors, xmlDistances, 2);
+  textPq.Search(queryData, 3, textNeighbors, textDistances, 2);
+  binaryPq.Search(queryData, 3, binaryNeighbors, binaryDistances, 2);
 
-  for (size_t i = 0; i < lsh.SecondHashTable().size(); ++i)
-  CheckMatrices(lsh.SecondHashTable()[i], xmlLsh.SecondHashTable()[i],
-      textLsh.SecondHashTable()[i], binaryLsh.SecondHashTable()[i]);
+  CheckMatrices(neighbors, xmlNeighbors, textNeighbors, binaryNeighbors);
+  CheckMatrices(distances, xmlDistances, textDistances, binaryDistances);
 }
 
 // Make sure serialization works for the decision stump.
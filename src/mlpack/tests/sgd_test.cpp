@@ -8,6 +8,10 @@
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
 #include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
 #include <mlpack/core/optimizers/sgd/test_function.hpp>
+#include <mlpack/core/optimizers/callbacks/csv_callback.hpp>
+#include <mlpack/core/optimizers/callbacks/timer_callback.hpp>
+
+#include <thread>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -53,4 +57,103 @@ BOOST_AUTO_TEST_CASE(GeneralizedRosenbrockTest)
   }
 }
 
+/**
+ * Make sure the callback is called once per pass, with the progress of SGD,
+ * and that SGD stops when the callback asks it to.
+ */
+BOOST_AUTO_TEST_CASE(SGDCallbackTest)
+{
+  SGDTestFunction f;
+  SGD<SGDTestFunction> s(f, 0.0003, 5000000, 1e-9, true);
+
+  std::vector<OptimizerStatus> statuses;
+  s.Callback() = [&statuses](const OptimizerStatus& status)
+  {
+    statuses.push_back(status);
+    return (statuses.size() == 5);
+  };
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = s.Optimize(coordinates);
+
+  // SGDTestFunction has three functions, so there is one pass every three
+  // iterations.
+  BOOST_REQUIRE_EQUAL(statuses.size(), 5);
+  for (size_t i = 0; i < statuses.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(statuses[i].iteration, 3 * i + 1);
+    BOOST_REQUIRE_CLOSE(statuses[i].stepSize, 0.0003, 1e-5);
+    BOOST_REQUIRE_GE(statuses[i].elapsed, 0.0);
+    if (i > 0)
+    {
+      BOOST_REQUIRE_GE(statuses[i].elapsed, statuses[i - 1].elapsed);
+      BOOST_REQUIRE(!std::isnan(statuses[i].gradientNorm));
+    }
+  }
+
+  // No gradient has been computed before the first pass.
+  BOOST_REQUIRE(std::isnan(statuses[0].gradientNorm));
+  BOOST_REQUIRE_CLOSE(result, statuses[4].objective, 1e-5);
+
+  // Now write the progress as CSV instead: a header and one line per pass.
+  std::ostringstream stream;
+  s.Callback() = CSVCallback(stream);
+  s.MaxIterations() = 30;
+  coordinates = f.GetInitialPoint();
+  s.Optimize(coordinates);
+
+  std::istringstream lines(stream.str());
+  std::string line;
+  std::getline(lines, line);
+  BOOST_REQUIRE_EQUAL(line,
+      "iteration,objective,gradient_norm,step_size,elapsed");
+  size_t count = 0;
+  while (std::getline(lines, line))
+    ++count;
+  BOOST_REQUIRE_EQUAL(count, 10);
+}
+
+/**
+ * Make sure that TimerCallback records the time between the statuses, and
+ * stops the optimizer at the time limit or at the target objective.
+ */
+BOOST_AUTO_TEST_CASE(TimerCallbackTest)
+{
+  TimerCallback callback("timer_callback_test", 10.0, -0.5);
+
+  OptimizerStatus status;
+  status.iteration = 0;
+  status.objective = 1.0;
+  status.gradientNorm = 1.0;
+  status.stepSize = 0.1;
+  status.elapsed = 1.0;
+  BOOST_REQUIRE(!callback(status));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  status.iteration = 1;
+  status.elapsed = 10.0;
+  BOOST_REQUIRE(callback(status));
+  status.iteration = 2;
+  status.elapsed = 1.0;
+  status.objective = -0.5;
+  BOOST_REQUIRE(callback(status));
+
+  // The timer runs from the first status to the last one, and is left running.
+  Timer::Stop("timer_callback_test");
+  BOOST_REQUIRE_GE(Timer::Get("timer_callback_test").count(), 10000);
+
+  // SGD stops at the first pass whose objective reaches the target, long
+  // before the optimum (whose objective is -1).
+  SGDTestFunction f;
+  SGD<SGDTestFunction> s(f, 0.0003, 5000000, 1e-9, true);
+  s.Callback() = TimerCallback("timer_callback_sgd_test", 0.0, -0.5);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = s.Optimize(coordinates);
+  Timer::Stop("timer_callback_sgd_test");
+
+  BOOST_REQUIRE_LE(result, -0.5);
+  BOOST_REQUIRE_GT(result, -0.9);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/softmax_regression/softmax_regression.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -408,4 +409,170 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionOptimizerTrainTest)
   }
 }
 
+/**
+ * Make sure that the batch objectives and gradients add up to the full
+ * objective and gradient.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionBatchTest)
+{
+  const size_t points = 100;
+  arma::mat data = arma::randu<arma::mat>(4, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; ++i)
+    labels[i] = i % 3;
+
+  for (size_t intercept = 0; intercept < 2; ++intercept)
+  {
+    SoftmaxRegressionFunction srf(data, labels, 3, 0.1, (intercept == 1));
+    const arma::mat parameters = srf.GetInitialPoint();
+    BOOST_REQUIRE_EQUAL(srf.NumFunctions(), points);
+
+    double objective = 0.0;
+    arma::mat gradient = arma::zeros<arma::mat>(parameters.n_rows,
+        parameters.n_cols);
+    for (size_t begin = 0; begin < points; begin += 30)
+    {
+      const size_t batchSize = std::min((size_t) 30, points - begin);
+      objective += srf.Evaluate(parameters, begin, batchSize, true);
+
+      arma::mat batchGradient;
+      srf.Gradient(parameters, begin, batchGradient, batchSize);
+      gradient += batchGradient;
+    }
+
+    arma::mat fullGradient;
+    srf.Gradient(parameters, fullGradient);
+
+    BOOST_REQUIRE_CLOSE(objective, srf.Evaluate(parameters), 1e-8);
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(gradient[i], fullGradient[i], 1e-6);
+  }
+}
+
+/**
+ * Make sure that the full objective and gradient, which are computed in blocks
+ * of training examples, match the objective and gradient computed from the
+ * class probabilities of all the training examples at once.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionBlockedTest)
+{
+  // Use enough points for several blocks, and a last block which isn't full.
+  const size_t points = 3500;
+  arma::mat data = arma::randu<arma::mat>(6, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; ++i)
+    labels[i] = math::RandInt(0, 4);
+
+  arma::mat groundTruth = arma::zeros<arma::mat>(4, points);
+  for (size_t i = 0; i < points; ++i)
+    groundTruth(labels[i], i) = 1.0;
+
+  SoftmaxRegressionFunction srf(data, labels, 4, 0.2, false);
+  const arma::mat parameters = arma::randn<arma::mat>(4, 6);
+
+  arma::mat probabilities;
+  srf.GetProbabilitiesMatrix(parameters, probabilities);
+  BOOST_REQUIRE_EQUAL(probabilities.n_cols, points);
+
+  const double objective = -arma::accu(groundTruth %
+      arma::log(probabilities)) / points + 0.1 * arma::accu(parameters %
+      parameters);
+  const arma::mat gradient = (probabilities - groundTruth) * data.t() /
+      points + 0.2 * parameters;
+
+  BOOST_REQUIRE_CLOSE(srf.Evaluate(parameters), objective, 1e-8);
+
+  arma::mat blockedGradient;
+  srf.Gradient(parameters, blockedGradient);
+  BOOST_REQUIRE_EQUAL(blockedGradient.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(blockedGradient.n_cols, 6);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(blockedGradient[i], gradient[i], 1e-6);
+}
+
+/**
+ * Train softmax regression with mini-batch SGD on well-separated classes, and
+ * make sure the classes are learned.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionMiniBatchSGDTest)
+{
+  const size_t points = 1500;
+  arma::mat data(2, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    labels[i] = i % 3;
+    data.col(i) = 0.3 * arma::randn<arma::vec>(2);
+    data(labels[i] == 2 ? 1 : 0, i) += (labels[i] == 0) ? -3.0 : 3.0;
+  }
+
+  SoftmaxRegressionFunction srf(data, labels, 3, 0.0001, true);
+  MiniBatchSGD<SoftmaxRegressionFunction> mbsgd(srf, 50, 0.1, 10000, 1e-8);
+  SoftmaxRegression<MiniBatchSGD> sr(mbsgd);
+
+  BOOST_REQUIRE_GT(sr.ComputeAccuracy(data, labels), 97.0);
+}
+
+/**
+ * Make sure that the fused scoring path gives the softmax of the linear
+ * functions and their largest class, for dense and sparse points of doubles
+ * and floats, with and without the intercept.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionScoreTest)
+{
+  arma::sp_mat sparseData;
+  sparseData.sprandn(8, 2000, 0.4);
+  const arma::mat data(sparseData);
+  const arma::fmat floatData = arma::conv_to<arma::fmat>::from(data);
+  const arma::sp_fmat sparseFloatData(floatData);
+
+  for (size_t intercept = 0; intercept < 2; ++intercept)
+  {
+    SoftmaxRegression<> sr(8, 4, intercept == 1);
+    sr.Parameters() = 3.0 * arma::randn<arma::mat>(4, 8 + intercept);
+
+    // Compute the expected probabilities directly.
+    arma::mat scores = sr.Parameters().cols(intercept, 7 + intercept) * data;
+    if (intercept == 1)
+      scores.each_col() += sr.Parameters().col(0);
+    arma::mat expected = arma::exp(scores);
+    expected.each_row() /= arma::sum(expected, 0);
+
+    arma::mat probabilities;
+    arma::fmat floatProbabilities, sparseFloatProbabilities;
+    arma::Row<size_t> labels, predictions, floatLabels, sparseLabels,
+        sparseFloatLabels;
+    sr.Score(data, probabilities, labels);
+    sr.Predict(data, predictions);
+    sr.Score(floatData, floatProbabilities, floatLabels);
+    sr.Score(sparseData, sparseLabels);
+    sr.Score(sparseFloatData, sparseFloatProbabilities, sparseFloatLabels);
+
+    BOOST_REQUIRE_EQUAL(probabilities.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(probabilities.n_cols, 2000);
+    for (size_t i = 0; i < 2000; ++i)
+    {
+      arma::uword best;
+      expected.col(i).max(best);
+      BOOST_REQUIRE_EQUAL(labels[i], best);
+      BOOST_REQUIRE_EQUAL(predictions[i], best);
+      BOOST_REQUIRE_EQUAL(sparseLabels[i], best);
+
+      for (size_t j = 0; j < 4; ++j)
+      {
+        BOOST_REQUIRE_SMALL(probabilities(j, i) - expected(j, i), 1e-10);
+        BOOST_REQUIRE_SMALL(floatProbabilities(j, i) - expected(j, i), 1e-4);
+        BOOST_REQUIRE_SMALL(sparseFloatProbabilities(j, i) - expected(j, i),
+            1e-4);
+      }
+    }
+  }
+
+  // Points of the wrong dimensionality are rejected.
+  SoftmaxRegression<> sr(8, 4);
+  arma::Row<size_t> labels;
+  BOOST_REQUIRE_THROW(sr.Score(arma::mat(7, 10, arma::fill::randu), labels),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
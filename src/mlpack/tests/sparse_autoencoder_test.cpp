@@ -263,4 +263,59 @@ BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionGradient)
   }
 }
 
+/**
+ * Make sure that the mini-batch objectives and gradients add up to the full
+ * objective and gradient (which are computed in several blocks here) when the
+ * running estimate of the average activations is the exact one.
+ */
+BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionMiniBatch)
+{
+  const size_t points = 2500;
+  const size_t vSize = 8;
+  const size_t hSize = 5;
+  const size_t l1 = hSize;
+  const size_t l2 = vSize;
+  const size_t l3 = 2 * hSize;
+
+  arma::mat data;
+  data.randu(vSize, points);
+
+  SparseAutoencoderFunction saf(data, vSize, hSize, 0.5, 2);
+  const arma::mat parameters = saf.GetInitialPoint();
+
+  // Compute the exact average activations of the hidden layer.
+  arma::mat hiddenLayer;
+  saf.Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
+      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, points),
+      hiddenLayer);
+  saf.AverageActivations() = arma::sum(hiddenLayer, 1) / points;
+  saf.ActivationMomentum() = 1.0;
+
+  const double objective = saf.Evaluate(parameters);
+  arma::mat gradient;
+  saf.Gradient(parameters, gradient);
+
+  const size_t batchSize = 300;
+  double batchObjective = 0.0;
+  arma::mat batchGradient, sumGradient;
+  sumGradient.zeros(l3 + 1, l2 + 1);
+  for (size_t i = 0; i < points; i += batchSize)
+  {
+    const size_t size = std::min(batchSize, points - i);
+    batchObjective += saf.Evaluate(parameters, i, size, true);
+    saf.Gradient(parameters, i, batchGradient, size);
+    sumGradient += batchGradient;
+  }
+
+  BOOST_REQUIRE_EQUAL(saf.NumFunctions(), points);
+  BOOST_REQUIRE_CLOSE(batchObjective, objective, 1e-5);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    if (std::abs(gradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sumGradient[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(sumGradient[i], gradient[i], 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
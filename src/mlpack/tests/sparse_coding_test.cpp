@@ -9,6 +9,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/sparse_coding/sparse_coding.hpp>
+#include <mlpack/methods/sparse_coding/sparse_coding_encoder.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -184,4 +185,95 @@ BOOST_AUTO_TEST_CASE(SerializationTest)
 }
 
 
+/**
+ * Make sure that coding the points in parallel gives the same codes as coding
+ * them with one thread.
+ */
+BOOST_AUTO_TEST_CASE(SparseCodingParallelEncodeTest)
+{
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  SparseCoding sc(25, 0.1, 0.2);
+  DataDependentRandomInitializer::Initialize(X, 25, sc.Dictionary());
+
+  mat serialZ, parallelZ;
+  ThreadPool::SetThreads(1);
+  sc.Encode(X, serialZ);
+  ThreadPool::SetThreads(0);
+  sc.Encode(X, parallelZ);
+
+  BOOST_REQUIRE_EQUAL(serialZ.n_rows, parallelZ.n_rows);
+  BOOST_REQUIRE_EQUAL(serialZ.n_cols, parallelZ.n_cols);
+  for (size_t i = 0; i < serialZ.n_elem; ++i)
+  {
+    if (std::abs(serialZ[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(parallelZ[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(serialZ[i], parallelZ[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that a SparseCodingEncoder gives the same codes as
+ * SparseCoding::Encode() when it is reused for several batches (and several
+ * numbers of threads), and that it bounds the number of nonzero coefficients.
+ */
+BOOST_AUTO_TEST_CASE(SparseCodingEncoderTest)
+{
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  SparseCoding sc(25, 0.1, 0.2);
+  DataDependentRandomInitializer::Initialize(X, 25, sc.Dictionary());
+
+  mat expectedZ;
+  sc.Encode(X, expectedZ);
+
+  SparseCodingEncoder encoder(sc);
+  BOOST_REQUIRE_EQUAL(encoder.Gram().n_rows, 25);
+  mat firstZ, secondZ;
+  ThreadPool::SetThreads(1);
+  encoder.Encode(X.cols(0, 99), firstZ);
+  ThreadPool::SetThreads(0);
+  encoder.Encode(X.cols(100, X.n_cols - 1), secondZ);
+
+  // A copy encodes the same way.
+  SparseCodingEncoder copy(encoder);
+  mat copyZ;
+  copy.Encode(X, copyZ);
+
+  const mat Z = join_rows(firstZ, secondZ);
+  BOOST_REQUIRE_EQUAL(Z.n_rows, expectedZ.n_rows);
+  BOOST_REQUIRE_EQUAL(Z.n_cols, expectedZ.n_cols);
+  for (size_t i = 0; i < Z.n_elem; ++i)
+  {
+    if (std::abs(expectedZ[i]) < 1e-10)
+    {
+      BOOST_REQUIRE_SMALL(Z[i], 1e-10);
+      BOOST_REQUIRE_SMALL(copyZ[i], 1e-10);
+    }
+    else
+    {
+      BOOST_REQUIRE_CLOSE(expectedZ[i], Z[i], 1e-5);
+      BOOST_REQUIRE_CLOSE(expectedZ[i], copyZ[i], 1e-5);
+    }
+  }
+
+  // With a bounded active set, no code has more nonzero coefficients.
+  SparseCodingEncoder boundedEncoder(sc.Dictionary(), 0.01, 0.0, 3);
+  mat boundedZ;
+  boundedEncoder.Encode(X, boundedZ);
+  for (size_t i = 0; i < boundedZ.n_cols; ++i)
+    BOOST_REQUIRE_LE(accu(boundedZ.col(i) != 0.0), 3);
+
+  mat wrongZ;
+  BOOST_REQUIRE_THROW(encoder.Encode(X.rows(1, X.n_rows - 1), wrongZ),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/data/split_data.hpp>
+#include <mlpack/core/data/split_files.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -165,4 +166,125 @@ BOOST_AUTO_TEST_CASE(SplitLabeledDataLargerTest)
   CheckDuplication(std::get<2>(value), std::get<3>(value));
 }
 
+/**
+ * Make sure SplitIndices() gives a partition of the indices of the points.
+ */
+BOOST_AUTO_TEST_CASE(SplitIndicesTest)
+{
+  arma::uvec trainIndices, testIndices;
+  SplitIndices(497, 0.3, trainIndices, testIndices);
+  BOOST_REQUIRE_EQUAL(trainIndices.n_elem, 497 - size_t(0.3 * 497));
+  BOOST_REQUIRE_EQUAL(testIndices.n_elem, size_t(0.3 * 497));
+
+  CheckDuplication(arma::conv_to<Row<size_t>>::from(trainIndices),
+      arma::conv_to<Row<size_t>>::from(testIndices));
+
+  // With the same seed, Split() splits the data along the same indices.
+  mat input(3, 497);
+  input.randu();
+  math::RandomSeed(7);
+  SplitIndices(input.n_cols, 0.3, trainIndices, testIndices);
+  math::RandomSeed(7);
+  const auto value = Split(input, 0.3);
+  CheckMatEqual(input.cols(trainIndices), std::get<0>(value));
+  CheckMatEqual(input.cols(testIndices), std::get<1>(value));
+}
+
+/**
+ * Make sure SplitInPlace() permutes the points and labels together, without
+ * losing or duplicating any.
+ */
+BOOST_AUTO_TEST_CASE(SplitInPlaceTest)
+{
+  const mat original = arma::randu<mat>(10, 497);
+  mat input(original);
+
+  // Set the labels to the column ID, as in the tests above.
+  Row<size_t> labels = arma::linspace<Row<size_t>>(0, input.n_cols - 1,
+      input.n_cols);
+
+  const size_t trainSize = SplitInPlace(input, labels, 0.3);
+  BOOST_REQUIRE_EQUAL(trainSize, 497 - size_t(0.3 * 497));
+  BOOST_REQUIRE_EQUAL(input.n_cols, 497);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 497);
+
+  CompareData(original, input, labels);
+  CheckDuplication(labels.cols(0, trainSize - 1),
+      labels.cols(trainSize, labels.n_elem - 1));
+
+  // Without labels, the points are permuted too.
+  mat unlabeled(original);
+  BOOST_REQUIRE_EQUAL(SplitInPlace(unlabeled, 0.3), trainSize);
+  CheckMatEqual(original, unlabeled);
+}
+
+/**
+ * Split a dataset file and its labels as they are read, with an external
+ * shuffle of the training set in several runs, and make sure every point ends
+ * up in exactly one of the sets, with its label.
+ */
+BOOST_AUTO_TEST_CASE(SplitFilesTest)
+{
+  // The first dimension and the label of each point are its index.
+  mat dataset = arma::randu<mat>(4, 1000);
+  dataset.row(0) = arma::linspace<rowvec>(0, 999, 1000);
+  const rowvec labels = dataset.row(0);
+  data::Save("split_files_data.csv", dataset);
+  data::Save("split_files_labels.csv", labels);
+
+  const std::pair<size_t, size_t> sizes = SplitFiles("split_files_data.csv",
+      "split_files_labels.csv", "split_files_train.mlbin",
+      "split_files_test.csv", "split_files_train_labels.csv",
+      "split_files_test_labels.csv", 0.3, 97, 100);
+  BOOST_REQUIRE_EQUAL(sizes.first + sizes.second, 1000);
+  BOOST_REQUIRE_GT(sizes.second, 200);
+  BOOST_REQUIRE_LT(sizes.second, 400);
+
+  mat train, test, trainLabels, testLabels;
+  data::Load("split_files_train.mlbin", train, true);
+  data::Load("split_files_test.csv", test, true);
+  data::Load("split_files_train_labels.csv", trainLabels, true);
+  data::Load("split_files_test_labels.csv", testLabels, true);
+  BOOST_REQUIRE_EQUAL(train.n_cols, sizes.first);
+  BOOST_REQUIRE_EQUAL(test.n_cols, sizes.second);
+  BOOST_REQUIRE_EQUAL(trainLabels.n_elem, sizes.first);
+  BOOST_REQUIRE_EQUAL(testLabels.n_elem, sizes.second);
+
+  std::vector<size_t> seen(1000, 0);
+  bool sorted = true;
+  for (size_t i = 0; i < train.n_cols; ++i)
+  {
+    const size_t index = (size_t) train(0, i);
+    ++seen[index];
+    BOOST_REQUIRE_EQUAL(trainLabels[i], train(0, i));
+    for (size_t d = 1; d < 4; ++d)
+      BOOST_REQUIRE_CLOSE(train(d, i), dataset(d, index), 1e-5);
+    if (i > 0 && train(0, i) < train(0, i - 1))
+      sorted = false;
+  }
+
+  // The test set keeps the order of the dataset.
+  for (size_t i = 0; i < test.n_cols; ++i)
+  {
+    ++seen[(size_t) test(0, i)];
+    BOOST_REQUIRE_EQUAL(testLabels[i], test(0, i));
+    if (i > 0)
+      BOOST_REQUIRE_GT(test(0, i), test(0, i - 1));
+  }
+
+  for (size_t i = 0; i < 1000; ++i)
+    BOOST_REQUIRE_EQUAL(seen[i], 1);
+  BOOST_REQUIRE(!sorted);
+
+  // The temporary runs are removed.
+  BOOST_REQUIRE(!std::ifstream("split_files_train.mlbin.run0.mlbin").good());
+
+  remove("split_files_data.csv");
+  remove("split_files_labels.csv");
+  remove("split_files_train.mlbin");
+  remove("split_files_test.csv");
+  remove("split_files_train_labels.csv");
+  remove("split_files_test_labels.csv");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
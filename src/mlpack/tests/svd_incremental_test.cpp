@@ -2,11 +2,13 @@
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/update_rules/svd_incomplete_incremental_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_complete_incremental_learning.hpp>
+#include <mlpack/methods/amf/update_rules/svd_parallel_incremental_learning.hpp>
 #include <mlpack/methods/amf/init_rules/random_init.hpp>
 #include <mlpack/methods/amf/termination_policies/incomplete_incremental_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/complete_incremental_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/simple_tolerance_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/validation_RMSE_termination.hpp>
+#include <mlpack/methods/amf/termination_policies/max_iteration_termination.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -134,4 +136,56 @@ BOOST_AUTO_TEST_CASE(SVDIncompleteIncrementalRegularizationTest)
   BOOST_REQUIRE_LT(regularizedRMSE, regularRMSE + 0.075);
 }
 
+/**
+ * Make sure that parallel incremental learning recovers a low-rank matrix from
+ * some of its elements, and that the result does not depend on the number of
+ * threads.
+ */
+BOOST_AUTO_TEST_CASE(SVDParallelIncrementalTest)
+{
+  // Take about half of the elements of a random rank 3 matrix.
+  mat w = randu<mat>(60, 3);
+  mat h = randu<mat>(3, 50);
+  mat masked = w * h;
+  masked.elem(find(randu<mat>(60, 50) >= 0.5)).zeros();
+  const sp_mat data(masked);
+
+  typedef AMF<MaxIterationTermination, RandomInitialization,
+      SVDParallelIncrementalLearning> FactorizerType;
+
+  mat w1, h1;
+  math::RandomSeed(10);
+  FactorizerType amf(MaxIterationTermination(500), RandomInitialization(),
+      SVDParallelIncrementalLearning(0.02, 0, 0, 8));
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  amf.Apply(data, 3, w1, h1);
+
+  mat w2, h2;
+  math::RandomSeed(10);
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  amf.Apply(data, 3, w2, h2);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  for (size_t i = 0; i < w1.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(w1[i], w2[i]);
+  for (size_t i = 0; i < h1.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(h1[i], h2[i]);
+
+  // The observed elements should be well fitted.
+  const mat reconstructed = w1 * h1;
+  double error = 0.0;
+  for (sp_mat::const_iterator it = data.begin(); it != data.end(); ++it)
+    error += std::pow(*it - reconstructed(it.row(), it.col()), 2.0);
+  error = std::sqrt(error / data.n_nonzero);
+
+  BOOST_REQUIRE_LT(error, 0.05);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
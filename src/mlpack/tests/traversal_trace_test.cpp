@@ -0,0 +1,179 @@
+/**
+ * @file traversal_trace_test.cpp
+ *
+ * Tests for the TraversalTrace and TracedRules classes, which count the node
+ * pairs and base cases of a traversal at each depth of the tree.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_trace.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "test_tools.hpp"
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+BOOST_AUTO_TEST_SUITE(TraversalTraceTest);
+
+/**
+ * Rules that visit every reference node, except (if a threshold is given) the
+ * nodes whose points are all at least the threshold.
+ */
+class CountingRules
+{
+ public:
+  CountingRules(const double threshold = DBL_MAX) : threshold(threshold) { }
+
+  double BaseCase(const size_t /* queryIndex */,
+                  const size_t /* referenceIndex */)
+  {
+    return 0.0;
+  }
+
+  template<typename TreeType>
+  double Score(const size_t /* queryIndex */, TreeType& referenceNode)
+  {
+    return (referenceNode.Bound()[0].Lo() >= threshold) ? DBL_MAX : 0.0;
+  }
+
+  template<typename TreeType>
+  double Rescore(const size_t /* queryIndex */,
+                 TreeType& /* referenceNode */,
+                 const double oldScore)
+  {
+    return oldScore;
+  }
+
+ private:
+  double threshold;
+};
+
+/**
+ * Build a kd-tree on the points 0, 1, ..., 7 with one point per leaf, so that
+ * the tree is balanced and the leaves have depth 3.
+ */
+static KDTree<metric::EuclideanDistance, EmptyStatistic, arma::mat>*
+    BuildTree()
+{
+  arma::mat data(1, 8);
+  for (size_t i = 0; i < 8; ++i)
+    data(0, i) = i;
+
+  return new KDTree<metric::EuclideanDistance, EmptyStatistic, arma::mat>(
+      std::move(data), 1);
+}
+
+/**
+ * Make sure that the scores, rescores and base cases of a single-tree traversal
+ * that visits every node are counted at the right depths.
+ */
+BOOST_AUTO_TEST_CASE(TraversalTraceDepthTest)
+{
+  typedef KDTree<metric::EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType* tree = BuildTree();
+
+  CountingRules rules;
+  TracedRules<CountingRules> tracedRules(rules);
+  TreeType::SingleTreeTraverser<TracedRules<CountingRules>>
+      traverser(tracedRules);
+
+  const size_t queries = 3;
+  for (size_t q = 0; q < queries; ++q)
+    traverser.Traverse(q, *tree);
+
+  const TraversalTrace& trace = tracedRules.Trace();
+  BOOST_REQUIRE_EQUAL(trace.Depths(), 4);
+
+  // The root itself is never scored.
+  BOOST_REQUIRE_EQUAL(trace.Get(0, TraversalTrace::Scores), 0);
+  for (size_t d = 1; d < 4; ++d)
+  {
+    // Both children of each node are scored, and the second one is rescored.
+    BOOST_REQUIRE_EQUAL(trace.Get(d, TraversalTrace::Scores),
+        queries * (1 << d));
+    BOOST_REQUIRE_EQUAL(trace.Get(d, TraversalTrace::Rescores),
+        queries * (1 << (d - 1)));
+    BOOST_REQUIRE_EQUAL(trace.Get(d, TraversalTrace::Prunes), 0);
+    BOOST_REQUIRE_EQUAL(trace.Get(d, TraversalTrace::RescorePrunes), 0);
+  }
+
+  // Every base case is attributed to a pair of leaves.
+  BOOST_REQUIRE_EQUAL(trace.Get(1, TraversalTrace::BaseCases), 0);
+  BOOST_REQUIRE_EQUAL(trace.Get(2, TraversalTrace::BaseCases), 0);
+  BOOST_REQUIRE_EQUAL(trace.Get(3, TraversalTrace::BaseCases), queries * 8);
+
+  // Nothing is counted past the leaves.
+  BOOST_REQUIRE_EQUAL(trace.Get(4, TraversalTrace::Scores), 0);
+
+  delete tree;
+}
+
+/**
+ * Make sure that prunes are counted at the depth of the pruned node, and that
+ * nothing below a pruned node is counted.
+ */
+BOOST_AUTO_TEST_CASE(TraversalTracePruneTest)
+{
+  typedef KDTree<metric::EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType* tree = BuildTree();
+
+  // The right child of the root holds the points 4, ..., 7, so it is pruned.
+  CountingRules rules(4.0);
+  TracedRules<CountingRules> tracedRules(rules);
+  TreeType::SingleTreeTraverser<TracedRules<CountingRules>>
+      traverser(tracedRules);
+  traverser.Traverse(0, *tree);
+
+  const TraversalTrace& trace = tracedRules.Trace();
+  BOOST_REQUIRE_EQUAL(trace.Get(1, TraversalTrace::Scores), 2);
+  BOOST_REQUIRE_EQUAL(trace.Get(1, TraversalTrace::Prunes), 1);
+  BOOST_REQUIRE_EQUAL(trace.Get(2, TraversalTrace::Scores), 2);
+  BOOST_REQUIRE_EQUAL(trace.Get(2, TraversalTrace::Prunes), 0);
+  BOOST_REQUIRE_EQUAL(trace.Get(3, TraversalTrace::Scores), 4);
+  BOOST_REQUIRE_EQUAL(trace.Get(3, TraversalTrace::BaseCases), 4);
+
+  delete tree;
+}
+
+/**
+ * Make sure that merging traces adds their statistics, and that the merged
+ * statistics are only added to the counters once.
+ */
+BOOST_AUTO_TEST_CASE(TraversalTraceMergeTest)
+{
+  // Other tests may have added to the counters already.
+  const uint64_t scores = Counter::Get("traversal/depth_1/scores");
+  const uint64_t baseCases = Counter::Get("traversal/depth_2/base_cases");
+
+  int a = 0, b = 0;
+  {
+    TraversalTrace trace, other;
+    trace.Score(1, &a, 0.0);
+    trace.BaseCase();
+    other.Score(1, &b, DBL_MAX);
+    other.Score(2, &b, 0.0);
+    other.BaseCase();
+    other.BaseCase();
+
+    trace.Merge(other);
+
+    BOOST_REQUIRE_EQUAL(other.Depths(), 0);
+    BOOST_REQUIRE_EQUAL(trace.Depths(), 3);
+    BOOST_REQUIRE_EQUAL(trace.Get(1, TraversalTrace::Scores), 2);
+    BOOST_REQUIRE_EQUAL(trace.Get(1, TraversalTrace::Prunes), 1);
+    BOOST_REQUIRE_EQUAL(trace.Get(1, TraversalTrace::BaseCases), 1);
+    BOOST_REQUIRE_EQUAL(trace.Get(2, TraversalTrace::Scores), 1);
+    BOOST_REQUIRE_EQUAL(trace.Get(2, TraversalTrace::BaseCases), 2);
+    BOOST_REQUIRE_EQUAL(trace.Get(2, TraversalTrace::BaseCasePairs), 1);
+  }
+
+  // Both traces were destroyed; the statistics were only counted once.
+  BOOST_REQUIRE_EQUAL(Counter::Get("traversal/depth_1/scores") - scores, 2);
+  BOOST_REQUIRE_EQUAL(Counter::Get("traversal/depth_2/base_cases") -
+      baseCases, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
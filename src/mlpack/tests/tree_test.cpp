@@ -1036,6 +1036,159 @@ BOOST_AUTO_TEST_CASE(HRectBoundDiameter)
   BOOST_REQUIRE_SMALL(d.Diameter(), 1e-5);
 }
 
+/**
+ * Compare the HRectBound distance calculations for the given metric against
+ * distances to the closest and furthest points of the bounds, computed with the
+ * metric itself.
+ */
+template<typename MetricType>
+void CheckHRectBoundDistances()
+{
+  const size_t dim = 7;
+  for (size_t trial = 0; trial < 20; ++trial)
+  {
+    HRectBound<MetricType> a(dim), b(dim);
+    arma::vec point = 3.0 * arma::randu<arma::vec>(dim) - 1.0;
+    arma::vec closestA(dim), furthestA(dim), closestB(dim), furthestB(dim);
+    for (size_t d = 0; d < dim; ++d)
+    {
+      const double loA = math::Random(), loB = math::Random();
+      a[d] = Range(loA, loA + math::Random());
+      b[d] = Range(loB, loB + math::Random());
+
+      closestA[d] = std::min(std::max(point[d], a[d].Lo()), a[d].Hi());
+      furthestA[d] = (std::abs(point[d] - a[d].Lo()) >
+          std::abs(point[d] - a[d].Hi())) ? a[d].Lo() : a[d].Hi();
+
+      // The closest points of two ranges are at the same spot if they overlap.
+      closestB[d] = (b[d].Lo() > a[d].Hi()) ? b[d].Lo() - a[d].Hi() :
+          ((a[d].Lo() > b[d].Hi()) ? a[d].Lo() - b[d].Hi() : 0.0);
+      furthestB[d] = std::max(b[d].Hi() - a[d].Lo(), a[d].Hi() - b[d].Lo());
+    }
+
+    const arma::vec zero(dim, arma::fill::zeros);
+    BOOST_REQUIRE_CLOSE(a.MinDistance(point) + 1.0,
+        MetricType::Evaluate(point, closestA) + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(a.MaxDistance(point),
+        MetricType::Evaluate(point, furthestA), 1e-5);
+    BOOST_REQUIRE_CLOSE(a.MinDistance(b) + 1.0,
+        MetricType::Evaluate(zero, closestB) + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(a.MaxDistance(b),
+        MetricType::Evaluate(zero, furthestB), 1e-5);
+
+    const Range pointRange = a.RangeDistance(point);
+    BOOST_REQUIRE_CLOSE(pointRange.Lo() + 1.0, a.MinDistance(point) + 1.0,
+        1e-5);
+    BOOST_REQUIRE_CLOSE(pointRange.Hi(), a.MaxDistance(point), 1e-5);
+
+    const Range boundRange = a.RangeDistance(b);
+    BOOST_REQUIRE_CLOSE(boundRange.Lo() + 1.0, a.MinDistance(b) + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(boundRange.Hi(), a.MaxDistance(b), 1e-5);
+  }
+}
+
+/**
+ * Make sure the HRectBound distance calculations are right for the metrics with
+ * specialized implementations and for a generic one.
+ */
+BOOST_AUTO_TEST_CASE(HRectBoundMetricDistancesTest)
+{
+  CheckHRectBoundDistances<ManhattanDistance>();
+  CheckHRectBoundDistances<EuclideanDistance>();
+  CheckHRectBoundDistances<SquaredEuclideanDistance>();
+  CheckHRectBoundDistances<LMetric<3, true>>();
+  CheckHRectBoundDistances<LMetric<3, false>>();
+}
+
+/**
+ * Make sure that the distances between an HRectBound and sparse points are the
+ * same as the distances to the dense points, and that Contains() works with
+ * sparse points.
+ */
+BOOST_AUTO_TEST_CASE(HRectBoundSparsePointTest)
+{
+  arma::sp_mat points;
+  points.sprandu(200, 20, 0.05);
+  const arma::mat densePoints(points);
+
+  HRectBound<EuclideanDistance> bound(200);
+  bound |= arma::sp_mat(points.cols(0, 9));
+
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const arma::sp_vec point(points.col(i));
+    const arma::vec densePoint = densePoints.col(i);
+
+    BOOST_REQUIRE_CLOSE(bound.MinDistance(point) + 1.0,
+        bound.MinDistance(densePoint) + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(bound.MaxDistance(point),
+        bound.MaxDistance(densePoint), 1e-5);
+
+    const Range r = bound.RangeDistance(point);
+    const Range denseR = bound.RangeDistance(densePoint);
+    BOOST_REQUIRE_CLOSE(r.Lo() + 1.0, denseR.Lo() + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(r.Hi(), denseR.Hi(), 1e-5);
+
+    BOOST_REQUIRE_EQUAL(bound.Contains(point), bound.Contains(densePoint));
+    BOOST_REQUIRE_EQUAL(bound.Contains(points.col(i)),
+        bound.Contains(densePoint));
+    if (i < 10)
+      BOOST_REQUIRE(bound.Contains(point));
+  }
+}
+
+/**
+ * Make sure that MinDistance() to several bounds at once gives the same results
+ * as calling MinDistance() for each bound, for HRectBound and BallBound.
+ */
+BOOST_AUTO_TEST_CASE(MultipleBoundMinDistanceTest)
+{
+  const size_t dim = 5;
+  HRectBound<EuclideanDistance> query(dim);
+  const arma::mat queryPoints = arma::randu<arma::mat>(dim, 10);
+  query |= queryPoints;
+
+  std::vector<HRectBound<EuclideanDistance>> rects(8,
+      HRectBound<EuclideanDistance>(dim));
+  std::vector<const HRectBound<EuclideanDistance>*> rectPointers;
+  for (size_t i = 0; i < rects.size(); ++i)
+  {
+    const arma::mat points = arma::randu<arma::mat>(dim, 10) + (double) i / 4.0;
+    rects[i] |= points;
+    rectPointers.push_back(&rects[i]);
+  }
+
+  arma::vec distances;
+  query.MinDistance(rectPointers, distances);
+  BOOST_REQUIRE_EQUAL(distances.n_elem, rects.size());
+  for (size_t i = 0; i < rects.size(); ++i)
+    BOOST_REQUIRE_CLOSE(distances[i] + 1.0, query.MinDistance(rects[i]) + 1.0,
+        1e-5);
+
+  BallBound<> ball(dim);
+  ball |= queryPoints;
+
+  std::vector<BallBound<>> balls(8, BallBound<>(dim));
+  std::vector<const BallBound<>*> ballPointers;
+  for (size_t i = 0; i < balls.size(); ++i)
+  {
+    const arma::mat points = arma::randu<arma::mat>(dim, 10) + (double) i / 4.0;
+    balls[i] |= points;
+    ballPointers.push_back(&balls[i]);
+  }
+
+  ball.MinDistance(ballPointers, distances);
+  BOOST_REQUIRE_EQUAL(distances.n_elem, balls.size());
+  for (size_t i = 0; i < balls.size(); ++i)
+    BOOST_REQUIRE_CLOSE(distances[i] + 1.0, ball.MinDistance(balls[i]) + 1.0,
+        1e-5);
+
+  // No bounds at all.
+  query.MinDistance(std::vector<const HRectBound<EuclideanDistance>*>(),
+      distances);
+  BOOST_REQUIRE_EQUAL(distances.n_elem, 0);
+}
+
 /**
  * It seems as though Bill has stumbled across a bug where
  * BinarySpaceTree<>::count() returns something different than
@@ -1430,6 +1583,128 @@ BOOST_AUTO_TEST_CASE(BallTreeTest)
   }
 }
 
+/**
+ * Check that the children of each node of a vantage-point tree hold the same
+ * number of points, give or take one.
+ */
+template<typename TreeType>
+void CheckVPTreeBalance(const TreeType& node)
+{
+  if (node.IsLeaf())
+    return;
+
+  BOOST_REQUIRE_EQUAL(node.Left()->Count(), node.Count() / 2);
+  BOOST_REQUIRE_EQUAL(node.Right()->Count(), node.Count() - node.Count() / 2);
+  CheckVPTreeBalance(*node.Left());
+  CheckVPTreeBalance(*node.Right());
+}
+
+/**
+ * Build vantage-point trees, check the mappings and bounds, and check that the
+ * tree is balanced.
+ */
+BOOST_AUTO_TEST_CASE(VPTreeTest)
+{
+  typedef VPTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  for (size_t run = 0; run < 5; ++run)
+  {
+    const size_t dimensions = 2 + 5 * run;
+    const size_t size = 1000 * (run + 1);
+    arma::mat dataset = arma::randu<arma::mat>(dimensions, size);
+
+    std::vector<size_t> newToOld, oldToNew;
+    TreeType root(dataset, newToOld, oldToNew);
+    const arma::mat& treeset = root.Dataset();
+
+    BOOST_REQUIRE_EQUAL(root.NumDescendants(), size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      for (size_t j = 0; j < dimensions; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(treeset(j, i), dataset(j, newToOld[i]));
+        BOOST_REQUIRE_EQUAL(treeset(j, oldToNew[i]), dataset(j, i));
+      }
+    }
+
+    CheckPointBounds(root);
+    CheckVPTreeBalance(root);
+  }
+
+  // A node of identical points cannot be split.
+  arma::mat same(3, 100);
+  same.fill(1.5);
+  TreeType sameRoot(same);
+  BOOST_REQUIRE(sameRoot.IsLeaf());
+  BOOST_REQUIRE_EQUAL(sameRoot.NumDescendants(), 100);
+}
+
+/**
+ * Check that every leaf of the given tree holds at most the given number of
+ * points.
+ */
+template<typename TreeType>
+void CheckLeafSize(const TreeType& node, const size_t maxLeafSize)
+{
+  if (node.IsLeaf())
+  {
+    BOOST_REQUIRE_LE(node.Count(), maxLeafSize);
+    return;
+  }
+
+  BOOST_REQUIRE_GT(node.Left()->Count(), 0);
+  BOOST_REQUIRE_GT(node.Right()->Count(), 0);
+  CheckLeafSize(*node.Left(), maxLeafSize);
+  CheckLeafSize(*node.Right(), maxLeafSize);
+}
+
+/**
+ * Build random projection trees with both split rules, and check the mappings,
+ * the bounds and the leaves; the mean split rule also gives balanced trees.
+ */
+BOOST_AUTO_TEST_CASE(RPTreeTest)
+{
+  typedef RPTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  typedef MaxRPTree<EuclideanDistance, EmptyStatistic, arma::mat> MaxTreeType;
+
+  for (size_t run = 0; run < 5; ++run)
+  {
+    const size_t dimensions = 2 + 5 * run;
+    const size_t size = 1000 * (run + 1);
+    arma::mat dataset = arma::randu<arma::mat>(dimensions, size);
+
+    std::vector<size_t> newToOld, oldToNew;
+    TreeType root(dataset, newToOld, oldToNew);
+    MaxTreeType maxRoot(dataset);
+
+    BOOST_REQUIRE_EQUAL(root.NumDescendants(), size);
+    BOOST_REQUIRE_EQUAL(maxRoot.NumDescendants(), size);
+    const arma::mat& treeset = root.Dataset();
+    for (size_t i = 0; i < size; ++i)
+    {
+      for (size_t j = 0; j < dimensions; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(treeset(j, i), dataset(j, newToOld[i]));
+        BOOST_REQUIRE_EQUAL(treeset(j, oldToNew[i]), dataset(j, i));
+      }
+    }
+
+    CheckPointBounds(root);
+    CheckPointBounds(maxRoot);
+    CheckVPTreeBalance(root);
+    CheckLeafSize(root, 20);
+    CheckLeafSize(maxRoot, 20);
+  }
+
+  // A node of identical points cannot be split.
+  arma::mat same(3, 100);
+  same.fill(1.5);
+  TreeType sameRoot(same);
+  MaxTreeType sameMaxRoot(same);
+  BOOST_REQUIRE(sameRoot.IsLeaf());
+  BOOST_REQUIRE(sameMaxRoot.IsLeaf());
+}
+
 template<typename MetricType>
 bool DoBoundsIntersect(HRectBound<MetricType>& a,
                        HRectBound<MetricType>& b)
@@ -1567,6 +1842,228 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeMoveConstructorTest)
   BOOST_REQUIRE_EQUAL(tree2.NumChildren(), 2);
 }
 
+//! Check that two binary space trees have exactly the same structure.
+template<typename TreeType>
+void CheckSameTree(const TreeType& a, const TreeType& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Begin(), b.Begin());
+  BOOST_REQUIRE_EQUAL(a.Count(), b.Count());
+  BOOST_REQUIRE_EQUAL(a.NumChildren(), b.NumChildren());
+  BOOST_REQUIRE_EQUAL(a.ParentDistance(), b.ParentDistance());
+  BOOST_REQUIRE_EQUAL(a.FurthestDescendantDistance(),
+      b.FurthestDescendantDistance());
+
+  for (size_t i = 0; i < a.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(a.Child(i).Parent(), &a);
+    BOOST_REQUIRE_EQUAL(b.Child(i).Parent(), &b);
+    CheckSameTree(a.Child(i), b.Child(i));
+  }
+}
+
+/**
+ * Make sure that building a tree with multiple threads gives exactly the same
+ * tree and mapping as building it with one thread.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeParallelBuildTest)
+{
+  // This must be large enough that the parallel construction is used.
+  arma::mat dataset(3, 150000);
+  dataset.randu();
+
+  #ifdef _OPENMP
+    const int numThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+  #endif
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  std::vector<size_t> oldFromNewSerial;
+  TreeType serialTree(dataset, oldFromNewSerial, 10);
+
+  typedef MeanSplitBallTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      BallTreeType;
+  BallTreeType serialBallTree(dataset);
+
+  #ifdef _OPENMP
+    omp_set_num_threads(numThreads);
+  #endif
+
+  std::vector<size_t> oldFromNewParallel;
+  TreeType parallelTree(dataset, oldFromNewParallel, 10);
+  BallTreeType parallelBallTree(dataset);
+
+  BOOST_REQUIRE_EQUAL(oldFromNewSerial.size(), oldFromNewParallel.size());
+  for (size_t i = 0; i < oldFromNewSerial.size(); ++i)
+    BOOST_REQUIRE_EQUAL(oldFromNewSerial[i], oldFromNewParallel[i]);
+
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(serialTree.Dataset()[i], parallelTree.Dataset()[i]);
+    BOOST_REQUIRE_EQUAL(serialBallTree.Dataset()[i],
+        parallelBallTree.Dataset()[i]);
+  }
+
+  CheckSameTree(serialTree, parallelTree);
+  CheckSameTree(serialBallTree, parallelBallTree);
+}
+
+/**
+ * Save a tree to a flat file and make sure that the memory-mapped tree is the
+ * same as the original.
+ */
+BOOST_AUTO_TEST_CASE(MappedTreeTest)
+{
+  arma::mat dataset(4, 2000);
+  dataset.randu();
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 15);
+
+  MappedTree<TreeType>::Save(tree, oldFromNew, "mapped_tree_test.bin");
+  {
+    MappedTree<TreeType> mapped("mapped_tree_test.bin");
+    const TreeType& mappedTree = mapped.Tree();
+
+    BOOST_REQUIRE_EQUAL(mapped.HasMapping(), true);
+    for (size_t i = 0; i < oldFromNew.size(); ++i)
+      BOOST_REQUIRE_EQUAL(mapped.OldFromNew(i), oldFromNew[i]);
+
+    BOOST_REQUIRE_EQUAL(mappedTree.Dataset().n_rows, dataset.n_rows);
+    BOOST_REQUIRE_EQUAL(mappedTree.Dataset().n_cols, dataset.n_cols);
+    for (size_t i = 0; i < dataset.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mappedTree.Dataset()[i], tree.Dataset()[i]);
+
+    CheckSameTree(tree, mappedTree);
+
+    // Check the bounds too.
+    std::stack<const TreeType*> nodes, mappedNodes;
+    nodes.push(&tree);
+    mappedNodes.push(&mappedTree);
+    while (!nodes.empty())
+    {
+      const TreeType* node = nodes.top();
+      const TreeType* mappedNode = mappedNodes.top();
+      nodes.pop();
+      mappedNodes.pop();
+
+      BOOST_REQUIRE_EQUAL(&mappedNode->Dataset(), &mappedTree.Dataset());
+      BOOST_REQUIRE_EQUAL(node->Bound().MinWidth(),
+          mappedNode->Bound().MinWidth());
+      for (size_t d = 0; d < dataset.n_rows; ++d)
+      {
+        BOOST_REQUIRE_EQUAL(node->Bound()[d].Lo(),
+            mappedNode->Bound()[d].Lo());
+        BOOST_REQUIRE_EQUAL(node->Bound()[d].Hi(),
+            mappedNode->Bound()[d].Hi());
+      }
+
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+      {
+        nodes.push(&node->Child(i));
+        mappedNodes.push(&mappedNode->Child(i));
+      }
+    }
+  }
+
+  // Without a mapping, OldFromNew() is the identity.
+  MappedTree<TreeType>::Save(tree, std::vector<size_t>(),
+      "mapped_tree_test.bin");
+  {
+    MappedTree<TreeType> mapped("mapped_tree_test.bin");
+    BOOST_REQUIRE_EQUAL(mapped.HasMapping(), false);
+    BOOST_REQUIRE_EQUAL(mapped.OldFromNew(10), 10);
+    CheckSameTree(tree, mapped.Tree());
+  }
+
+  // A truncated file must be rejected.
+  {
+    std::ofstream truncated("mapped_tree_test.bin",
+        std::ios::out | std::ios::binary);
+    truncated << "not a tree";
+  }
+  BOOST_REQUIRE_THROW(MappedTree<TreeType>("mapped_tree_test.bin"),
+      std::runtime_error);
+  BOOST_REQUIRE_THROW(MappedTree<TreeType>("nonexistent_tree_file.bin"),
+      std::runtime_error);
+
+  remove("mapped_tree_test.bin");
+}
+
+/**
+ * Make sure that compacting a tree stores the descendants contiguously in
+ * depth-first order, without changing the structure of the tree.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeCompactTest)
+{
+  arma::mat dataset(5, 1000);
+  dataset.randu();
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  TreeType tree(dataset, 10);
+  TreeType compactTree(tree);
+  compactTree.Compact();
+
+  BOOST_REQUIRE_EQUAL(tree.IsCompact(), false);
+  BOOST_REQUIRE_EQUAL(compactTree.IsCompact(), true);
+
+  // Walk both trees in depth-first order at the same time.
+  std::stack<TreeType*> nodes, compactNodes;
+  nodes.push(&tree);
+  compactNodes.push(&compactTree);
+  TreeType* lastNode = NULL;
+  size_t numNodes = 0;
+  while (!nodes.empty())
+  {
+    TreeType* node = nodes.top();
+    TreeType* compactNode = compactNodes.top();
+    nodes.pop();
+    compactNodes.pop();
+    ++numNodes;
+
+    BOOST_REQUIRE_EQUAL(node->Begin(), compactNode->Begin());
+    BOOST_REQUIRE_EQUAL(node->Count(), compactNode->Count());
+    BOOST_REQUIRE_EQUAL(node->NumChildren(), compactNode->NumChildren());
+    BOOST_REQUIRE_EQUAL(&compactNode->Dataset(), &compactTree.Dataset());
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+    {
+      BOOST_REQUIRE_EQUAL(node->Bound()[d].Lo(), compactNode->Bound()[d].Lo());
+      BOOST_REQUIRE_EQUAL(node->Bound()[d].Hi(), compactNode->Bound()[d].Hi());
+    }
+
+    // Every descendant must directly follow the node visited before it.
+    if (compactNode != &compactTree)
+    {
+      if (lastNode != NULL)
+        BOOST_REQUIRE_EQUAL(compactNode, lastNode + 1);
+      lastNode = compactNode;
+
+      TreeType* parent = compactNode->Parent();
+      BOOST_REQUIRE(parent->Left() == compactNode ||
+                    parent->Right() == compactNode);
+    }
+
+    for (size_t i = node->NumChildren(); i > 0; --i)
+    {
+      nodes.push(&node->Child(i - 1));
+      compactNodes.push(&compactNode->Child(i - 1));
+    }
+  }
+
+  BOOST_REQUIRE_GT(numNodes, 1);
+
+  // Compacting a second time should do nothing, and compacting a non-root
+  // node is not allowed.
+  compactTree.Compact();
+  BOOST_REQUIRE_EQUAL(compactTree.Left()->Parent(), &compactTree);
+  BOOST_REQUIRE_THROW(compactTree.Left()->Compact(), std::invalid_argument);
+
+  // A copy of a compacted tree is an ordinary tree.
+  TreeType copy(compactTree);
+  BOOST_REQUIRE_EQUAL(copy.IsCompact(), false);
+  BOOST_REQUIRE_EQUAL(copy.NumDescendants(), compactTree.NumDescendants());
+}
+
 template<typename TreeType>
 void RecurseTreeCountLeaves(const TreeType& node, arma::vec& counts)
 {
@@ -1771,6 +2268,33 @@ BOOST_AUTO_TEST_CASE(CoverTreeConstructionTest)
   CheckSeparation<TreeType, LMetric<2, true> >(tree, tree);
 }
 
+/**
+ * Create a cover tree that is large enough that the distances near the top of
+ * the tree are computed in parallel, and make sure it's accurate.
+ */
+BOOST_AUTO_TEST_CASE(LargeCoverTreeConstructionTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 20000);
+
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType tree(dataset);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 20000);
+
+  // Ensure each leaf is only created once.
+  arma::vec counts;
+  counts.zeros(20000);
+  RecurseTreeCountLeaves(tree, counts);
+
+  for (size_t i = 0; i < 20000; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  CheckSelfChild<TreeType>(tree);
+  CheckCovering<TreeType, LMetric<2, true> >(tree);
+}
+
 /**
  * Create a cover tree on sparse data and make sure it's accurate.
  */
@@ -1977,6 +2501,42 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeCopyConstructor)
   BOOST_REQUIRE_EQUAL(b.Right()->Right(), c.Right()->Right());
 }
 
+//! Make sure that the bound of every node is the bounding box of its points.
+template<typename TreeType>
+void CheckRefitBounds(TreeType& node)
+{
+  const arma::mat points = node.Dataset().cols(node.Begin(),
+      node.Begin() + node.Count() - 1);
+  for (size_t d = 0; d < points.n_rows; ++d)
+  {
+    BOOST_REQUIRE_CLOSE(node.Bound()[d].Lo(), arma::min(points.row(d)), 1e-5);
+    BOOST_REQUIRE_CLOSE(node.Bound()[d].Hi(), arma::max(points.row(d)), 1e-5);
+  }
+
+  BOOST_REQUIRE_CLOSE(node.FurthestDescendantDistance(),
+      0.5 * node.Bound().Diameter(), 1e-5);
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    CheckRefitBounds(node.Child(i));
+}
+
+/**
+ * Move the points of a kd-tree, refit its bounds, and make sure the bounds
+ * hold the moved points.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeRefitBoundsTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  TreeType tree(dataset);
+
+  // Move every point a little.
+  tree.Dataset() += 0.05 * arma::randn<arma::mat>(3, 1000);
+  tree.RefitBounds();
+
+  CheckRefitBounds(tree);
+}
+
 //! Count the number of leaves under this node.
 template<typename TreeType>
 size_t NumLeaves(TreeType* node)
@@ -2093,4 +2653,190 @@ BOOST_AUTO_TEST_CASE(CoverTreeDescendantTest)
   CheckDescendants(&tree);
 }
 
+/**
+ * Make sure that compacting a cover tree stores the children of each node next
+ * to each other, without changing the structure of the tree.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeCompactTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType tree(dataset);
+  TreeType compactTree(tree);
+  compactTree.Compact();
+
+  BOOST_REQUIRE_EQUAL(tree.IsCompact(), false);
+  BOOST_REQUIRE_EQUAL(compactTree.IsCompact(), true);
+
+  // Walk both trees at the same time.
+  std::stack<TreeType*> nodes, compactNodes;
+  nodes.push(&tree);
+  compactNodes.push(&compactTree);
+  size_t numNodes = 0;
+  while (!nodes.empty())
+  {
+    TreeType* node = nodes.top();
+    TreeType* compactNode = compactNodes.top();
+    nodes.pop();
+    compactNodes.pop();
+    ++numNodes;
+
+    BOOST_REQUIRE_EQUAL(node->Point(), compactNode->Point());
+    BOOST_REQUIRE_EQUAL(node->Scale(), compactNode->Scale());
+    BOOST_REQUIRE_EQUAL(node->NumDescendants(), compactNode->NumDescendants());
+    BOOST_REQUIRE_EQUAL(node->NumChildren(), compactNode->NumChildren());
+    BOOST_REQUIRE_CLOSE(node->FurthestDescendantDistance(),
+        compactNode->FurthestDescendantDistance(), 1e-5);
+    BOOST_REQUIRE_EQUAL(&compactNode->Dataset(), &compactTree.Dataset());
+
+    // No implicit nodes are stored, and the children are adjacent.
+    BOOST_REQUIRE_NE(compactNode->NumChildren(), 1);
+    for (size_t i = 0; i < compactNode->NumChildren(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(&compactNode->Child(i), &compactNode->Child(0) + i);
+      BOOST_REQUIRE_EQUAL(compactNode->Child(i).Parent(), compactNode);
+    }
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+    {
+      nodes.push(&node->Child(i));
+      compactNodes.push(&compactNode->Child(i));
+    }
+  }
+
+  BOOST_REQUIRE_GT(numNodes, 1);
+  CheckDescendants(&compactTree);
+
+  // Compacting a second time should do nothing, and compacting a non-root
+  // node is not allowed.
+  compactTree.Compact();
+  BOOST_REQUIRE_EQUAL(compactTree.Child(0).Parent(), &compactTree);
+  BOOST_REQUIRE_THROW(compactTree.Child(0).Compact(), std::invalid_argument);
+
+  // A copy of a compacted tree is an ordinary tree, and a moved tree stays
+  // compact.
+  TreeType copy(compactTree);
+  BOOST_REQUIRE_EQUAL(copy.IsCompact(), false);
+  BOOST_REQUIRE_EQUAL(copy.NumDescendants(), compactTree.NumDescendants());
+
+  TreeType moved(std::move(compactTree));
+  BOOST_REQUIRE_EQUAL(moved.IsCompact(), true);
+  BOOST_REQUIRE_EQUAL(compactTree.IsCompact(), false);
+  BOOST_REQUIRE_EQUAL(moved.Child(0).Parent(), &moved);
+  CheckDescendants(&moved);
+}
+
+//! Count the nodes of the given tree.
+template<typename TreeType>
+size_t CountNodes(TreeType& node)
+{
+  size_t numNodes = 1;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    numNodes += CountNodes(node.Child(i));
+  return numNodes;
+}
+
+/**
+ * Make sure that trees built in a NodeArenaScope take their nodes from the
+ * arena, are the same as the trees built without one, and release the arena
+ * when they are destroyed.
+ */
+BOOST_AUTO_TEST_CASE(NodeArenaTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> KDTreeType;
+  KDTreeType tree(dataset, 10);
+
+  NodeArena arena(4096);
+  KDTreeType* arenaTree;
+  {
+    NodeArenaScope scope(arena);
+    BOOST_REQUIRE_EQUAL(NodeArena::Current(), &arena);
+    arenaTree = new KDTreeType(dataset, 10);
+  }
+  BOOST_REQUIRE(NodeArena::Current() == NULL);
+
+  // Every node, including the root, and the bounds of every node come from
+  // the arena.
+  const size_t numNodes = CountNodes(*arenaTree);
+  BOOST_REQUIRE_GT(numNodes, 1);
+  BOOST_REQUIRE_EQUAL(arena.Nodes(), 2 * numNodes);
+  BOOST_REQUIRE_GT(arena.Blocks(), 1);
+  BOOST_REQUIRE_GE(arena.Bytes(), numNodes * (sizeof(KDTreeType) +
+      3 * sizeof(math::Range)));
+
+  // The trees must be the same.
+  std::stack<KDTreeType*> nodes, arenaNodes;
+  nodes.push(&tree);
+  arenaNodes.push(arenaTree);
+  while (!nodes.empty())
+  {
+    KDTreeType* node = nodes.top();
+    KDTreeType* arenaNode = arenaNodes.top();
+    nodes.pop();
+    arenaNodes.pop();
+
+    BOOST_REQUIRE_EQUAL(node->Begin(), arenaNode->Begin());
+    BOOST_REQUIRE_EQUAL(node->Count(), arenaNode->Count());
+    BOOST_REQUIRE_EQUAL(node->NumChildren(), arenaNode->NumChildren());
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+    {
+      nodes.push(&node->Child(i));
+      arenaNodes.push(&arenaNode->Child(i));
+    }
+  }
+
+  // Compacting the tree in the scope replaces the descendants with one array
+  // from the arena; their bounds are moved into the array.
+  {
+    NodeArenaScope scope(arena);
+    arenaTree->Compact();
+  }
+  BOOST_REQUIRE_EQUAL(arenaTree->IsCompact(), true);
+  BOOST_REQUIRE_EQUAL(arena.Nodes(), numNodes + 2);
+
+  delete arenaTree;
+  BOOST_REQUIRE_EQUAL(arena.Nodes(), 0);
+
+  // The arena may be destroyed before the trees built with it.
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      CoverTreeType;
+  CoverTreeType* coverTree;
+  {
+    NodeArena coverArena;
+    NodeArenaScope scope(coverArena);
+    coverTree = new CoverTreeType(dataset);
+    BOOST_REQUIRE_EQUAL(coverArena.Nodes(), CountNodes(*coverTree));
+  }
+  CheckDescendants(coverTree);
+  delete coverTree;
+
+  // Nodes created outside of the scope come from the heap, so an R tree built
+  // in an arena can still grow.
+  typedef RTree<EuclideanDistance, EmptyStatistic, arma::mat> RTreeType;
+  NodeArena rArena;
+  RTreeType* rTree;
+  {
+    NodeArenaScope scope(rArena);
+    rTree = new RTreeType(dataset, 20, 6, 5, 2, 0);
+  }
+  const size_t rNodes = rArena.Nodes();
+  BOOST_REQUIRE_EQUAL(rNodes, 2 * CountNodes(*rTree));
+
+  rTree->Dataset().resize(3, 1500);
+  rTree->Dataset().cols(1000, 1499).randu();
+  for (size_t i = 1000; i < 1500; ++i)
+    rTree->InsertPoint(i);
+  BOOST_REQUIRE_EQUAL(rTree->NumDescendants(), 1500);
+  BOOST_REQUIRE_LE(rArena.Nodes(), rNodes);
+
+  delete rTree;
+  BOOST_REQUIRE_EQUAL(rArena.Nodes(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -46,4 +46,31 @@ BOOST_AUTO_TEST_CASE(TestUnion)
   BOOST_REQUIRE(testUnionFind_.Find(6) == testUnionFind_.Find(3));
 }
 
+BOOST_AUTO_TEST_CASE(TestConcurrentUnion)
+{
+  // Join the elements into chains of ten elements in parallel, with each link
+  // of a chain added twice.
+  static const size_t testSize = 10000;
+  ConcurrentUnionFind unionFind(testSize);
+
+  std::vector<char> merged(testSize, 0);
+  ThreadPool::ParallelFor(0, 2 * testSize, [&](const size_t i)
+  {
+    const size_t element = i % testSize;
+    if (element % 10 != 9 && unionFind.Union(element, element + 1))
+      merged[element] = 1;
+  });
+
+  // Only one of the two unions of each link merges two components.
+  for (size_t i = 0; i < testSize; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(unionFind.Find(i), i - (i % 10));
+    BOOST_REQUIRE_EQUAL((bool) merged[i], i % 10 != 9);
+  }
+
+  BOOST_REQUIRE(!unionFind.Union(0, 9));
+  BOOST_REQUIRE(unionFind.Union(19, 5));
+  BOOST_REQUIRE_EQUAL(unionFind.Find(15), (size_t) 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();